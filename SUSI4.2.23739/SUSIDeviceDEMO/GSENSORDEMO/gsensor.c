@@ -1,5 +1,8 @@
 #include "common.h"
 #include "ADXL345.h"
+#include "gsnr_acq.h"
+#include "gsnr_fft.h"
+#include "gsnr_detect.h"
 
 #define SUSIDEV_GSENSOR_AXIS_X	0x00
 #define SUSIDEV_GSENSOR_AXIS_Y	0x01
@@ -39,6 +42,10 @@ enum funcRank{
 	funcOfsSetZ,	
 	funcRate,
 	funcRange,
+	funcAcquire,
+	funcVibration,
+	funcBench,
+	funcDetect,
 	NumFunc,
 };
 static int8_t functions[NumFunc + 1];
@@ -114,36 +121,50 @@ static void gsnr_set_config(struct GSensorInfo config)
 		printf("Set g-range failed. (0x%08X)\n", status);
 }
 
-static uint8_t gsnr_get_data()
+static void gsnr_print_value(uint8_t valid, int32_t value)
 {
-	SusiStatus_t status;
-	uint32_t tmp_u32;
-
 	printf("  ");
 
-	status = SusiDeviceGetValue(ADXL345_ID_DATA_X, &tmp_u32);
-	if (status == SUSI_STATUS_SUCCESS)
-		printf("% 2.3f", (int)tmp_u32 / (float)10000);
+	if (valid)
+		printf("% 2.3f", value / (float)10000);
 	else
 		printf(" (N/A)");
+}
 
-	printf("  ");
+static uint8_t gsnr_get_data()
+{
+	struct GSensorReading reading;
 
-	status = SusiDeviceGetValue(ADXL345_ID_DATA_Y, &tmp_u32);
-	if (status == SUSI_STATUS_SUCCESS)
-		printf("% 2.3f", (int)tmp_u32 / (float)10000);
-	else
-		printf(" (N/A)");
+	/* All three axes first, printing only afterwards */
+	gsnr_read_xyz(&reading);
 
-	printf("  ");
+	gsnr_print_value(reading.valid & GSNR_VALID_X, reading.xyz.x);
+	gsnr_print_value(reading.valid & GSNR_VALID_Y, reading.xyz.y);
+	gsnr_print_value(reading.valid & GSNR_VALID_Z, reading.xyz.z);
+	printf("  (%u us)  ", reading.skew_nsec / 1000);
 
-	status = SusiDeviceGetValue(ADXL345_ID_DATA_Z, &tmp_u32);
-	if (status == SUSI_STATUS_SUCCESS)
-		printf("% 2.3f", (int)tmp_u32 / (float)10000);
-	else
-		printf(" (N/A)");
+	return SUSIDEMO_PRINT_SUCCESS;
+}
 
-	printf("  ");
+static uint8_t gsnr_benchmark(struct GSensorInfo config)
+{
+	struct GSensorBench bench;
+
+	gsnr_set_config(config);
+
+	printf("\nReading X/Y/Z back to back for 2 seconds...\n");
+	if (gsnr_bench(2000, &bench))
+	{
+		printf("Benchmark failed.\n");
+		return SUSIDEMO_PRINT_ERROR;
+	}
+
+	printf("\n");
+	printf("Combined reads:       %u (%u failed)\n", bench.reads, bench.errors);
+	printf("Achievable rate:      %u samples/s\n", bench.samples_per_sec);
+	printf("Per combined read:    min %.1f / avg %.1f / max %.1f us\n",
+		bench.min_nsec / 1000.0f, bench.avg_nsec / 1000.0f, bench.max_nsec / 1000.0f);
+	printf("Per driver call:      avg %.1f us\n", bench.avg_nsec / 3000.0f);
 
 	return SUSIDEMO_PRINT_SUCCESS;
 }
@@ -165,6 +186,163 @@ static uint8_t gsnr_scan(struct GSensorInfo config)
 	return SUSIDEMO_PRINT_NONE;
 }
 
+static void gsnr_print_axis(const char *label, const struct GSensorAxisStats *pstats)
+{
+	printf("  %s  % 2.4f  % 2.4f  % 2.4f  % 2.4f\n", label,
+		pstats->mean / (float)10000, pstats->min / (float)10000,
+		pstats->max / (float)10000, pstats->rms / (float)10000);
+}
+
+static uint8_t gsnr_acquire(struct GSensorInfo config)
+{
+	struct GSensorSample samples[64];
+	struct GSensorStats stats;
+	struct GSensorAcqCounters counters;
+	uint32_t cursor, dropped = 0, streamed = 0, n, window;
+	int c = '\n';
+
+	gsnr_set_config(config);
+
+	/* One second of samples, at least one */
+	window = (uint32_t)(1000000000ULL / gsnr_rate_period_nsec(config.Rate));
+	if (window == 0)
+		window = 1;
+	if (window > GSNR_ACQ_RING_SIZE)
+		window = GSNR_ACQ_RING_SIZE;
+
+	if (gsnr_acq_start(config.Rate))
+	{
+		printf("Start acquisition failed.\n");
+		return SUSIDEMO_PRINT_ERROR;
+	}
+	cursor = gsnr_acq_cursor();
+
+	printf("\nSampling in the background. Press 'Enter' for the latest %u samples. Enter 'q' to stop.\n", window);
+
+	do {
+		if (c != '\n' && c != EOF)
+			continue;
+
+		/* Stream everything since the last press, as a logger would */
+		while ((n = gsnr_acq_read(&cursor, samples, NELEMS(samples), &dropped)) > 0)
+			streamed += n;
+
+		gsnr_acq_counters(&counters);
+		printf("\nSamples: %u  Streamed: %u  Dropped: %u  Read errors: %u  Late ticks: %u\n",
+			counters.samples, streamed, dropped, counters.errors, counters.late);
+
+		if (gsnr_acq_window(window, &stats))
+		{
+			printf("  (no sample yet)\n");
+			continue;
+		}
+		printf("  Window: %u samples (g)\n", stats.count);
+		printf("        Mean     Min      Max      RMS\n");
+		gsnr_print_axis("X", &stats.x);
+		gsnr_print_axis("Y", &stats.y);
+		gsnr_print_axis("Z", &stats.z);
+	} while ((c = getchar()) != 'Q' && c != 'q');
+
+	gsnr_acq_stop();
+
+	return SUSIDEMO_PRINT_NONE;
+}
+
+static void gsnr_print_spectrum(const char *label, const struct GSensorAxisSpectrum *pspec)
+{
+	uint32_t band;
+
+	printf("  %s  %7.1f  %6.4f  %6.4f ", label, pspec->peak_hz, pspec->peak_g, pspec->rms_g);
+	for (band = 0; band < GSNR_FFT_BANDS; band++)
+		printf(" %6.4f", pspec->band_rms_g[band]);
+	printf("\n");
+}
+
+static uint8_t gsnr_vibration(struct GSensorInfo config)
+{
+	struct GSensorVibration vib;
+	uint32_t band;
+	int c = '\n';
+
+	gsnr_set_config(config);
+	gsnr_fft_init();
+
+	if (gsnr_acq_start(config.Rate))
+	{
+		printf("Start acquisition failed.\n");
+		return SUSIDEMO_PRINT_ERROR;
+	}
+
+	printf("\nSampling in the background. Press 'Enter' to analyse the latest %u samples. Enter 'q' to stop.\n",
+		GSNR_FFT_SIZE);
+
+	do {
+		if (c != '\n' && c != EOF)
+			continue;
+
+		if (gsnr_fft_analyze(config.Rate, &vib))
+		{
+			printf("\n  Collecting (%u/%u samples)\n", gsnr_acq_available(), GSNR_FFT_SIZE);
+			continue;
+		}
+
+		printf("\n  %.1f Hz, %.2f Hz per bin. Band RMS (g) per octave up to (Hz):\n", vib.rate_hz, vib.resolution_hz);
+		printf("     Peak Hz  Peak g  RMS g  ");
+		for (band = 1; band <= GSNR_FFT_BANDS; band++)
+			printf(" %6.0f", vib.band_edge_hz[band]);
+		printf("\n");
+		gsnr_print_spectrum("X", &vib.x);
+		gsnr_print_spectrum("Y", &vib.y);
+		gsnr_print_spectrum("Z", &vib.z);
+	} while ((c = getchar()) != 'Q' && c != 'q');
+
+	gsnr_acq_stop();
+
+	return SUSIDEMO_PRINT_NONE;
+}
+
+static void gsnr_print_event(const struct GSensorEvent *pevent, void *pctx)
+{
+	(void)pctx;
+
+	printf("  %s: %u ms, %s %.2f g (sample %u)\n",
+		pevent->type == GSNR_EVENT_FREEFALL ? "Free fall" : "Shock",
+		pevent->duration_ms, pevent->type == GSNR_EVENT_FREEFALL ? "lowest" : "peak",
+		pevent->magnitude / (float)10000, pevent->cursor);
+}
+
+static uint8_t gsnr_detect(struct GSensorInfo config)
+{
+	struct GSensorDetectConfig detect;
+	int c;
+
+	gsnr_set_config(config);
+	gsnr_detect_defaults(&detect);
+
+	if (gsnr_acq_start(config.Rate))
+	{
+		printf("Start acquisition failed.\n");
+		return SUSIDEMO_PRINT_ERROR;
+	}
+	if (gsnr_detect_start(&detect, config.Rate, gsnr_print_event, NULL))
+	{
+		gsnr_acq_stop();
+		printf("Start detection failed.\n");
+		return SUSIDEMO_PRINT_ERROR;
+	}
+
+	printf("\nFree fall below %.2f g for %u ms, shock above %.2f g. Enter 'q' to stop.\n\n",
+		detect.freefall_g / (float)10000, detect.freefall_ms, detect.shock_g / (float)10000);
+
+	while ((c = getchar()) != 'Q' && c != 'q' && c != EOF)
+		;
+
+	gsnr_detect_stop();
+	gsnr_acq_stop();
+
+	return SUSIDEMO_PRINT_NONE;
+}
+
 static uint8_t gsnr_get_offset(struct GSensorInfo *config)
 {
 	SusiStatus_t status;
@@ -341,6 +519,18 @@ static void menu(struct GSensorInfo config)
 
 	printf("%u) Start to Scan\n", fnc);
 	functions[fnc++] = funcData;
+
+	printf("%u) Continuous Acquisition\n", fnc);
+	functions[fnc++] = funcAcquire;
+
+	printf("%u) Vibration Analysis\n", fnc);
+	functions[fnc++] = funcVibration;
+
+	printf("%u) Read Benchmark\n", fnc);
+	functions[fnc++] = funcBench;
+
+	printf("%u) Drop/Shock Detection\n", fnc);
+	functions[fnc++] = funcDetect;
 	
 	printf("\nEnter your choice: ");
 }
@@ -373,6 +563,25 @@ void gsnr_main(void)
 				goto pause;
 			continue;
 
+		case funcAcquire:
+			if (gsnr_acquire(config))
+				goto pause;
+			continue;
+
+		case funcVibration:
+			if (gsnr_vibration(config))
+				goto pause;
+			continue;
+
+		case funcDetect:
+			if (gsnr_detect(config))
+				goto pause;
+			continue;
+
+		case funcBench:
+			gsnr_benchmark(config);
+			goto pause;
+
 		case funcOfsSetX:
 			if (gsnr_set_an_axis_offset(SUSIDEV_GSENSOR_AXIS_X))
 				goto pause;
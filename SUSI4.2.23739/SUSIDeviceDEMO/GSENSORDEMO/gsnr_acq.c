@@ -0,0 +1,321 @@
+#include <string.h>
+#include "gsnr_acq.h"
+#include "ADXL345.h"
+
+#define RING_MASK	(GSNR_ACQ_RING_SIZE - 1)
+#define READ_CHUNK	256
+
+static struct GSensorSample ring[GSNR_ACQ_RING_SIZE];
+static uint32_t write_index;		/* Next slot; published after the slot is written */
+static uint32_t filled;				/* Samples in the ring, up to GSNR_ACQ_RING_SIZE */
+static struct GSensorAcqCounters counters;
+
+static THREAD_T acq_thread;
+static uint64_t acq_period_nsec;
+static uint32_t acq_stop;
+static int acq_running;
+
+uint64_t gsnr_rate_period_nsec(uint32_t rate)
+{
+	/* 3200 Hz halves with every step down, to 0.098 Hz */
+	if (rate > SUSIDEV_GSENSOR_RATE_3200)
+		return 0;
+
+	return 312500ULL << (SUSIDEV_GSENSOR_RATE_3200 - rate);
+}
+
+int gsnr_read_xyz(struct GSensorReading *preading)
+{
+	uint32_t x, y, z;
+	uint64_t start, end;
+	uint8_t valid = 0;
+
+	/* Clock reads bracket the driver calls only; decoding comes after */
+	start = monotonic_nsec();
+	if (SusiDeviceGetValue(ADXL345_ID_DATA_X, &x) == SUSI_STATUS_SUCCESS)
+		valid |= GSNR_VALID_X;
+	if (SusiDeviceGetValue(ADXL345_ID_DATA_Y, &y) == SUSI_STATUS_SUCCESS)
+		valid |= GSNR_VALID_Y;
+	if (SusiDeviceGetValue(ADXL345_ID_DATA_Z, &z) == SUSI_STATUS_SUCCESS)
+		valid |= GSNR_VALID_Z;
+	end = monotonic_nsec();
+
+	preading->xyz.x = (valid & GSNR_VALID_X) ? (int32_t)x : 0;
+	preading->xyz.y = (valid & GSNR_VALID_Y) ? (int32_t)y : 0;
+	preading->xyz.z = (valid & GSNR_VALID_Z) ? (int32_t)z : 0;
+	preading->time_nsec = start + (end - start) / 2;
+	preading->skew_nsec = (uint32_t)(end - start);
+	preading->valid = valid;
+
+	return valid == GSNR_VALID_ALL ? 0 : -1;
+}
+
+int gsnr_bench(uint32_t duration_ms, struct GSensorBench *pbench)
+{
+	struct GSensorReading reading;
+	uint64_t start, deadline, total = 0, now;
+
+	if (acq_running || duration_ms == 0)
+		return -1;
+
+	memset(pbench, 0, sizeof(*pbench));
+	pbench->min_nsec = UINT32_MAX;
+
+	start = monotonic_nsec();
+	deadline = start + (uint64_t)duration_ms * 1000000ULL;
+	do {
+		if (gsnr_read_xyz(&reading))
+			pbench->errors++;
+		pbench->reads++;
+		total += reading.skew_nsec;
+		if (reading.skew_nsec < pbench->min_nsec)
+			pbench->min_nsec = reading.skew_nsec;
+		if (reading.skew_nsec > pbench->max_nsec)
+			pbench->max_nsec = reading.skew_nsec;
+		now = monotonic_nsec();
+	} while (now < deadline);
+
+	pbench->elapsed_nsec = now - start;
+	pbench->avg_nsec = (uint32_t)(total / pbench->reads);
+	pbench->samples_per_sec = (uint32_t)((uint64_t)pbench->reads * 1000000000ULL / pbench->elapsed_nsec);
+	return 0;
+}
+
+static void gsnr_ring_push(const struct GSensorSample *psample)
+{
+	uint32_t w = ATOMIC_LOAD_RELAXED(&write_index);
+	struct GSensorSample *pslot = &ring[w & RING_MASK];
+
+	ATOMIC_STORE_RELAXED(&pslot->x, psample->x);
+	ATOMIC_STORE_RELAXED(&pslot->y, psample->y);
+	ATOMIC_STORE_RELAXED(&pslot->z, psample->z);
+	ATOMIC_STORE(&write_index, w + 1);
+
+	if (filled < GSNR_ACQ_RING_SIZE)
+		ATOMIC_STORE(&filled, filled + 1);
+	ATOMIC_STORE(&counters.samples, counters.samples + 1);
+}
+
+static THREAD_PROC(gsnr_acq_proc)
+{
+	uint64_t period = acq_period_nsec;
+	uint64_t next = monotonic_nsec();
+	uint64_t now, missed;
+	struct GSensorReading reading;
+
+	(void)parg;
+
+	while (!ATOMIC_LOAD(&acq_stop))
+	{
+		if (gsnr_read_xyz(&reading) == 0)
+			gsnr_ring_push(&reading.xyz);
+		else
+			ATOMIC_STORE(&counters.errors, counters.errors + 1);
+
+		/* Ticks the reads ran into are skipped, not made up in a burst */
+		next += period;
+		now = monotonic_nsec();
+		if (now > next)
+		{
+			missed = (now - next) / period;
+			next += missed * period;
+			ATOMIC_STORE(&counters.late, counters.late + (uint32_t)missed);
+		}
+		sleep_until_nsec(next);
+	}
+
+	THREAD_PROC_RETURN;
+}
+
+int gsnr_acq_start(uint32_t rate)
+{
+	if (acq_running)
+		return -1;
+
+	acq_period_nsec = gsnr_rate_period_nsec(rate);
+	if (acq_period_nsec == 0)
+		return -1;
+
+	ATOMIC_STORE(&write_index, 0);
+	ATOMIC_STORE(&filled, 0);
+	ATOMIC_STORE(&counters.samples, 0);
+	ATOMIC_STORE(&counters.errors, 0);
+	ATOMIC_STORE(&counters.late, 0);
+	ATOMIC_STORE(&acq_stop, 0);
+
+	if (THREAD_CREATE(&acq_thread, gsnr_acq_proc, NULL))
+		return -1;
+
+	acq_running = 1;
+	return 0;
+}
+
+void gsnr_acq_stop(void)
+{
+	if (!acq_running)
+		return;
+
+	ATOMIC_STORE(&acq_stop, 1);
+	THREAD_JOIN(acq_thread);
+	acq_running = 0;
+}
+
+int gsnr_acq_running(void)
+{
+	return acq_running;
+}
+
+uint32_t gsnr_acq_cursor(void)
+{
+	return ATOMIC_LOAD(&write_index);
+}
+
+uint32_t gsnr_acq_available(void)
+{
+	return ATOMIC_LOAD(&filled);
+}
+
+uint32_t gsnr_acq_read(uint32_t *pcursor, struct GSensorSample *pbuf, uint32_t max, uint32_t *pdropped)
+{
+	uint32_t w = ATOMIC_LOAD(&write_index);
+	uint32_t cursor = *pcursor;
+	uint32_t count, lost, i;
+
+	if (w - cursor > GSNR_ACQ_RING_SIZE)
+	{
+		if (pdropped)
+			*pdropped += w - cursor - GSNR_ACQ_RING_SIZE;
+		cursor = w - GSNR_ACQ_RING_SIZE;
+	}
+
+	count = w - cursor;
+	if (count > max)
+		count = max;
+
+	for (i = 0; i < count; i++)
+	{
+		const struct GSensorSample *pslot = &ring[(cursor + i) & RING_MASK];
+
+		pbuf[i].x = ATOMIC_LOAD_RELAXED(&pslot->x);
+		pbuf[i].y = ATOMIC_LOAD_RELAXED(&pslot->y);
+		pbuf[i].z = ATOMIC_LOAD_RELAXED(&pslot->z);
+	}
+
+	/* The producer may have lapped the oldest copies meanwhile; the slot
+	   of index w is being rewritten while w is still the published index */
+	w = ATOMIC_LOAD(&write_index);
+	lost = w - cursor >= GSNR_ACQ_RING_SIZE ? w - cursor - GSNR_ACQ_RING_SIZE + 1 : 0;
+	if (lost > count)
+		lost = count;
+	if (lost > 0)
+	{
+		memmove(pbuf, pbuf + lost, (count - lost) * sizeof(*pbuf));
+		if (pdropped)
+			*pdropped += lost;
+	}
+
+	*pcursor = cursor + count;
+	return count - lost;
+}
+
+uint32_t gsnr_isqrt64(uint64_t value)
+{
+	uint64_t root = 0, bit = 1ULL << 62;
+
+	while (bit > value)
+		bit >>= 2;
+
+	while (bit != 0)
+	{
+		if (value >= root + bit)
+		{
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+		{
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return (uint32_t)root;
+}
+
+struct AxisSums {
+	int64_t sum;
+	int64_t sumsq;
+	int32_t min;
+	int32_t max;
+};
+
+static void axis_add(struct AxisSums *psums, int32_t value)
+{
+	psums->sum += value;
+	psums->sumsq += (int64_t)value * value;
+	if (value < psums->min)
+		psums->min = value;
+	if (value > psums->max)
+		psums->max = value;
+}
+
+static void axis_stats(const struct AxisSums *psums, uint32_t n, struct GSensorAxisStats *pstats)
+{
+	int64_t variance = ((int64_t)n * psums->sumsq - psums->sum * psums->sum) / ((int64_t)n * n);
+
+	pstats->min = psums->min;
+	pstats->max = psums->max;
+	pstats->mean = (int32_t)(psums->sum / (int64_t)n);
+	pstats->rms = (int32_t)gsnr_isqrt64(variance > 0 ? (uint64_t)variance : 0);
+}
+
+int gsnr_acq_window(uint32_t count, struct GSensorStats *pstats)
+{
+	struct GSensorSample chunk[READ_CHUNK];
+	struct AxisSums sums[3];
+	uint32_t available = gsnr_acq_available();
+	uint32_t cursor, total, n, i, k;
+
+	if (count > available)
+		count = available;
+	if (count == 0)
+		return -1;
+
+	for (k = 0; k < 3; k++)
+	{
+		sums[k].sum = 0;
+		sums[k].sumsq = 0;
+		sums[k].min = INT32_MAX;
+		sums[k].max = INT32_MIN;
+	}
+
+	cursor = gsnr_acq_cursor() - count;
+	total = 0;
+	while (count > 0 && (n = gsnr_acq_read(&cursor, chunk, count < READ_CHUNK ? count : READ_CHUNK, NULL)) > 0)
+	{
+		for (i = 0; i < n; i++)
+		{
+			axis_add(&sums[0], chunk[i].x);
+			axis_add(&sums[1], chunk[i].y);
+			axis_add(&sums[2], chunk[i].z);
+		}
+		total += n;
+		count -= n;
+	}
+
+	if (total == 0)
+		return -1;
+
+	pstats->count = total;
+	axis_stats(&sums[0], total, &pstats->x);
+	axis_stats(&sums[1], total, &pstats->y);
+	axis_stats(&sums[2], total, &pstats->z);
+	return 0;
+}
+
+void gsnr_acq_counters(struct GSensorAcqCounters *pcounters)
+{
+	pcounters->samples = ATOMIC_LOAD(&counters.samples);
+	pcounters->errors = ATOMIC_LOAD(&counters.errors);
+	pcounters->late = ATOMIC_LOAD(&counters.late);
+}
@@ -0,0 +1,98 @@
+#ifndef _GSNR_ACQ_H_
+#define _GSNR_ACQ_H_
+
+#include "common.h"
+
+/* Continuous acquisition: a dedicated thread reads X/Y/Z at the output
+   data rate configured with ADXL345_ID_DATARATE_NORMAL and appends them to
+   a ring that the producer never waits on. Readers keep their own cursor;
+   a reader that falls more than GSNR_ACQ_RING_SIZE samples behind loses
+   the oldest ones and is told how many. */
+
+#define GSNR_ACQ_RING_SIZE		4096	/* Samples, power of two */
+
+/* Fixed point, 1/10000 g, as returned by SusiDeviceGetValue */
+struct GSensorSample {
+	int32_t x;
+	int32_t y;
+	int32_t z;
+};
+
+#define GSNR_VALID_X	0x01
+#define GSNR_VALID_Y	0x02
+#define GSNR_VALID_Z	0x04
+#define GSNR_VALID_ALL	(GSNR_VALID_X | GSNR_VALID_Y | GSNR_VALID_Z)
+
+/* One combined read: the three axes back to back, one timestamp */
+struct GSensorReading {
+	struct GSensorSample xyz;
+	uint64_t time_nsec;				/* Monotonic, midway through the three reads */
+	uint32_t skew_nsec;				/* From the start of the X read to the end of the Z read */
+	uint8_t valid;					/* GSNR_VALID_* of the axes that were read */
+};
+
+struct GSensorBench {
+	uint32_t reads;					/* Combined reads completed */
+	uint32_t errors;				/* Reads with an axis missing */
+	uint64_t elapsed_nsec;
+	uint32_t min_nsec;				/* Per combined read */
+	uint32_t avg_nsec;
+	uint32_t max_nsec;
+	uint32_t samples_per_sec;		/* Sustained combined reads per second */
+};
+
+struct GSensorAxisStats {
+	int32_t min;
+	int32_t max;
+	int32_t mean;
+	int32_t rms;					/* AC part: deviation from the mean */
+};
+
+struct GSensorStats {
+	uint32_t count;
+	struct GSensorAxisStats x;
+	struct GSensorAxisStats y;
+	struct GSensorAxisStats z;
+};
+
+struct GSensorAcqCounters {
+	uint32_t samples;				/* Written to the ring */
+	uint32_t errors;				/* Ticks lost to a failed read */
+	uint32_t late;					/* Ticks missed because reads overran the period */
+};
+
+/* Read X, Y and Z with nothing in between. Returns 0 if all three were read. */
+int gsnr_read_xyz(struct GSensorReading *preading);
+
+/* Combined reads back to back for duration_ms, to find the rate the driver
+   can sustain on this board. -1 while acquisition is running. */
+int gsnr_bench(uint32_t duration_ms, struct GSensorBench *pbench);
+
+/* Period of a SUSIDEV_GSENSOR_RATE_* code, 0 for an unknown code */
+uint64_t gsnr_rate_period_nsec(uint32_t rate);
+
+/* 0 on success, -1 if already running or the thread cannot start */
+int gsnr_acq_start(uint32_t rate);
+void gsnr_acq_stop(void);
+int gsnr_acq_running(void);
+
+/* Cursor of the next sample to be written; a new reader starts here */
+uint32_t gsnr_acq_cursor(void);
+/* Samples still in the ring, up to GSNR_ACQ_RING_SIZE */
+uint32_t gsnr_acq_available(void);
+
+/* Copy up to max samples from *pcursor on and advance it. Samples
+   overwritten before they were read are skipped and added to *pdropped.
+   Returns the number copied. */
+uint32_t gsnr_acq_read(uint32_t *pcursor, struct GSensorSample *pbuf, uint32_t max, uint32_t *pdropped);
+
+/* Statistics over the latest count samples (fewer if not yet written).
+   Returns -1 if there is no sample. */
+int gsnr_acq_window(uint32_t count, struct GSensorStats *pstats);
+
+void gsnr_acq_counters(struct GSensorAcqCounters *pcounters);
+
+/* Integer square root, rounded down */
+uint32_t gsnr_isqrt64(uint64_t value);
+
+#endif /* _GSNR_ACQ_H_ */
@@ -0,0 +1,162 @@
+#include "gsnr_detect.h"
+
+#define READ_CHUNK	256
+
+/* One run detector; free fall looks for runs below the limit, shock above */
+struct Run {
+	enum GSensorEventType type;
+	uint64_t limit2;				/* Squared threshold */
+	uint32_t need;					/* Samples the run must last */
+	uint32_t length;
+	uint32_t start;
+	uint64_t extreme2;
+	uint32_t holdoff;				/* Samples before the next event may fire */
+};
+
+static struct Run runs[2];
+static uint32_t holdoff_samples;
+static uint64_t period_nsec;
+static GSensorEventSink event_sink;
+static void *event_ctx;
+static uint32_t dropped;
+
+static THREAD_T detect_thread;
+static uint32_t detect_stop;
+static int detect_running;
+
+void gsnr_detect_defaults(struct GSensorDetectConfig *pconfig)
+{
+	pconfig->freefall_g = GSNR_DETECT_DEFAULT_FREEFALL_G;
+	pconfig->freefall_ms = GSNR_DETECT_DEFAULT_FREEFALL_MS;
+	pconfig->shock_g = GSNR_DETECT_DEFAULT_SHOCK_G;
+	pconfig->shock_ms = GSNR_DETECT_DEFAULT_SHOCK_MS;
+	pconfig->holdoff_ms = GSNR_DETECT_DEFAULT_HOLDOFF_MS;
+}
+
+static uint32_t ms_to_samples(uint32_t ms)
+{
+	uint64_t samples = (uint64_t)ms * 1000000ULL / period_nsec;
+
+	return samples > 0 ? (uint32_t)samples : 1;
+}
+
+static void run_init(struct Run *prun, enum GSensorEventType type, int32_t limit, uint32_t ms)
+{
+	prun->type = type;
+	prun->limit2 = (uint64_t)((int64_t)limit * limit);
+	prun->need = ms_to_samples(ms);
+	prun->length = 0;
+	prun->start = 0;
+	prun->extreme2 = 0;
+	prun->holdoff = 0;
+}
+
+static void run_end(struct Run *prun)
+{
+	struct GSensorEvent event;
+
+	if (prun->length < prun->need || prun->holdoff != 0)
+		return;
+
+	event.type = prun->type;
+	event.cursor = prun->start;
+	event.duration_ms = (uint32_t)((uint64_t)prun->length * period_nsec / 1000000ULL);
+	event.magnitude = (int32_t)gsnr_isqrt64(prun->extreme2);
+	event.dropped = dropped;
+	prun->holdoff = holdoff_samples;
+
+	event_sink(&event, event_ctx);
+}
+
+/* Per sample: one compare, masks for the run and a select for the extreme */
+static void run_step(struct Run *prun, uint64_t mag2, uint32_t cursor)
+{
+	uint32_t inside = prun->type == GSNR_EVENT_FREEFALL ? mag2 < prun->limit2 : mag2 > prun->limit2;
+	uint32_t fresh = prun->length == 0;
+	uint64_t extreme = fresh ? mag2 : prun->extreme2;
+
+	if (prun->length != 0 && !inside)
+		run_end(prun);
+
+	prun->start = fresh ? cursor : prun->start;
+	prun->extreme2 = prun->type == GSNR_EVENT_FREEFALL ? (mag2 < extreme ? mag2 : extreme)
+		: (mag2 > extreme ? mag2 : extreme);
+	prun->length = (prun->length + 1) & (0U - inside);
+	prun->holdoff -= prun->holdoff != 0;
+}
+
+static void gsnr_detect_samples(const struct GSensorSample *psamples, uint32_t count, uint32_t first)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		int64_t x = psamples[i].x, y = psamples[i].y, z = psamples[i].z;
+		uint64_t mag2 = (uint64_t)(x * x + y * y + z * z);
+
+		run_step(&runs[0], mag2, first + i);
+		run_step(&runs[1], mag2, first + i);
+	}
+}
+
+static THREAD_PROC(gsnr_detect_proc)
+{
+	struct GSensorSample chunk[READ_CHUNK];
+	uint32_t cursor = gsnr_acq_cursor();
+	uint32_t n, lost;
+
+	(void)parg;
+
+	while (!ATOMIC_LOAD(&detect_stop))
+	{
+		lost = dropped;
+		while ((n = gsnr_acq_read(&cursor, chunk, READ_CHUNK, &dropped)) > 0)
+		{
+			/* A gap breaks any run in progress */
+			if (dropped != lost)
+			{
+				runs[0].length = 0;
+				runs[1].length = 0;
+				lost = dropped;
+			}
+			gsnr_detect_samples(chunk, n, cursor - n);
+		}
+		SLEEP_USEC(GSNR_DETECT_POLL_MS);
+	}
+
+	THREAD_PROC_RETURN;
+}
+
+int gsnr_detect_start(const struct GSensorDetectConfig *pconfig, uint32_t rate, GSensorEventSink sink, void *pctx)
+{
+	if (detect_running || sink == NULL)
+		return -1;
+
+	period_nsec = gsnr_rate_period_nsec(rate);
+	if (period_nsec == 0)
+		return -1;
+
+	run_init(&runs[0], GSNR_EVENT_FREEFALL, pconfig->freefall_g, pconfig->freefall_ms);
+	run_init(&runs[1], GSNR_EVENT_SHOCK, pconfig->shock_g, pconfig->shock_ms);
+	holdoff_samples = ms_to_samples(pconfig->holdoff_ms);
+	event_sink = sink;
+	event_ctx = pctx;
+	dropped = 0;
+
+	ATOMIC_STORE(&detect_stop, 0);
+	if (THREAD_CREATE(&detect_thread, gsnr_detect_proc, NULL))
+		return -1;
+
+	detect_running = 1;
+	return 0;
+}
+
+void gsnr_detect_stop(void)
+{
+	if (!detect_running)
+		return;
+
+	ATOMIC_STORE(&detect_stop, 1);
+	THREAD_JOIN(detect_thread);
+	detect_running = 0;
+}
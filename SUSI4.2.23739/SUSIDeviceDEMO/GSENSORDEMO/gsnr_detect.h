@@ -0,0 +1,56 @@
+#ifndef _GSNR_DETECT_H_
+#define _GSNR_DETECT_H_
+
+#include "gsnr_acq.h"
+
+/* Drop and impact detection on the acquisition ring. Every sample's squared
+   magnitude is compared with squared thresholds, so no root is taken per
+   sample, and the run lengths are updated with masks instead of branches. A
+   free fall is a run below the free-fall threshold that lasts at least
+   freefall_ms; a shock is a run above the shock threshold that lasts at
+   least shock_ms. Either is reported when its run ends, with its duration
+   and extreme magnitude, and not again for holdoff_ms. A thread drains the
+   ring every GSNR_DETECT_POLL_MS, so the cost is a few operations per
+   sample plus one wakeup per poll. */
+
+#define GSNR_DETECT_POLL_MS				50
+
+#define GSNR_DETECT_DEFAULT_FREEFALL_G	4000	/* 0.4 g */
+#define GSNR_DETECT_DEFAULT_FREEFALL_MS	100		/* About a 5 cm drop */
+#define GSNR_DETECT_DEFAULT_SHOCK_G		30000	/* 3 g */
+#define GSNR_DETECT_DEFAULT_SHOCK_MS	0		/* One sample above is enough */
+#define GSNR_DETECT_DEFAULT_HOLDOFF_MS	500
+
+enum GSensorEventType {
+	GSNR_EVENT_FREEFALL,
+	GSNR_EVENT_SHOCK,
+};
+
+struct GSensorEvent {
+	enum GSensorEventType type;
+	uint32_t cursor;				/* Ring cursor of the run's first sample */
+	uint32_t duration_ms;
+	int32_t magnitude;				/* Lowest (free fall) or highest (shock), 1/10000 g */
+	uint32_t dropped;				/* Samples lost to ring overruns so far */
+};
+
+typedef void (*GSensorEventSink)(const struct GSensorEvent *pevent, void *pctx);
+
+/* Thresholds in 1/10000 g, like the samples */
+struct GSensorDetectConfig {
+	int32_t freefall_g;
+	uint32_t freefall_ms;
+	int32_t shock_g;
+	uint32_t shock_ms;
+	uint32_t holdoff_ms;
+};
+
+void gsnr_detect_defaults(struct GSensorDetectConfig *pconfig);
+
+/* Start detecting on the samples acquisition writes from now on, at the
+   SUSIDEV_GSENSOR_RATE_* code rate it runs at. The sink is called on the
+   detector thread. 0 on success. */
+int gsnr_detect_start(const struct GSensorDetectConfig *pconfig, uint32_t rate, GSensorEventSink sink, void *pctx);
+void gsnr_detect_stop(void);
+
+#endif /* _GSNR_DETECT_H_ */
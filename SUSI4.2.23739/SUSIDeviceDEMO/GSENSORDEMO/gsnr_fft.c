@@ -0,0 +1,237 @@
+#include <math.h>
+#include "gsnr_fft.h"
+
+#define HALF_SIZE	(GSNR_FFT_SIZE / 2)
+#define READ_CHUNK	256
+
+#ifndef M_PI
+#define M_PI		3.14159265358979323846
+#endif
+
+/* Built once by gsnr_fft_init() */
+static uint16_t bitrev[HALF_SIZE];
+static float tw_re[HALF_SIZE / 2];		/* exp(-2 pi i j / HALF_SIZE) */
+static float tw_im[HALF_SIZE / 2];
+static float split_re[HALF_SIZE];		/* exp(-2 pi i k / GSNR_FFT_SIZE) */
+static float split_im[HALF_SIZE];
+static float window[GSNR_FFT_SIZE];
+static float window_sum;
+static float window_sq_sum;
+static int fft_ready;
+
+/* Working set, one array per axis */
+static float axis_buf[3][GSNR_FFT_SIZE];
+static float z_re[HALF_SIZE];
+static float z_im[HALF_SIZE];
+static float power[HALF_SIZE + 1];
+
+void gsnr_fft_init(void)
+{
+	uint32_t i, bits = 0, r, b;
+
+	if (fft_ready)
+		return;
+
+	while ((1U << bits) < HALF_SIZE)
+		bits++;
+
+	for (i = 0; i < HALF_SIZE; i++)
+	{
+		for (r = 0, b = 0; b < bits; b++)
+			r |= ((i >> b) & 1U) << (bits - 1 - b);
+		bitrev[i] = (uint16_t)r;
+	}
+
+	for (i = 0; i < HALF_SIZE / 2; i++)
+	{
+		tw_re[i] = (float)cos(2.0 * M_PI * i / HALF_SIZE);
+		tw_im[i] = (float)-sin(2.0 * M_PI * i / HALF_SIZE);
+	}
+
+	for (i = 0; i < HALF_SIZE; i++)
+	{
+		split_re[i] = (float)cos(2.0 * M_PI * i / GSNR_FFT_SIZE);
+		split_im[i] = (float)-sin(2.0 * M_PI * i / GSNR_FFT_SIZE);
+	}
+
+	window_sum = 0;
+	window_sq_sum = 0;
+	for (i = 0; i < GSNR_FFT_SIZE; i++)
+	{
+		window[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * i / GSNR_FFT_SIZE));
+		window_sum += window[i];
+		window_sq_sum += window[i] * window[i];
+	}
+
+	fft_ready = 1;
+}
+
+/* Latest full window into axis_buf, in g */
+static int gsnr_fft_fill(void)
+{
+	struct GSensorSample chunk[READ_CHUNK];
+	uint32_t cursor, total = 0, n, i;
+	uint32_t dropped = 0;
+
+	if (gsnr_acq_available() < GSNR_FFT_SIZE)
+		return -1;
+
+	cursor = gsnr_acq_cursor() - GSNR_FFT_SIZE;
+	while (total < GSNR_FFT_SIZE)
+	{
+		n = GSNR_FFT_SIZE - total;
+		n = gsnr_acq_read(&cursor, chunk, n < READ_CHUNK ? n : READ_CHUNK, &dropped);
+		if (n == 0 || dropped != 0)
+			return -1;	/* lapped while copying; the next call gets a fresh window */
+
+		for (i = 0; i < n; i++)
+		{
+			axis_buf[0][total + i] = chunk[i].x / 10000.0f;
+			axis_buf[1][total + i] = chunk[i].y / 10000.0f;
+			axis_buf[2][total + i] = chunk[i].z / 10000.0f;
+		}
+		total += n;
+	}
+
+	return 0;
+}
+
+/* In place radix-2 FFT of z_re/z_im, input already in bit-reversed order */
+static void fft_complex(void)
+{
+	uint32_t size, half, step, start, j;
+
+	for (size = 2; size <= HALF_SIZE; size <<= 1)
+	{
+		half = size / 2;
+		step = HALF_SIZE / size;
+		for (start = 0; start < HALF_SIZE; start += size)
+		{
+			float *__restrict a_re = z_re + start;
+			float *__restrict a_im = z_im + start;
+			float *__restrict b_re = z_re + start + half;
+			float *__restrict b_im = z_im + start + half;
+
+			for (j = 0; j < half; j++)
+			{
+				float wr = tw_re[j * step];
+				float wi = tw_im[j * step];
+				float tr = b_re[j] * wr - b_im[j] * wi;
+				float ti = b_re[j] * wi + b_im[j] * wr;
+
+				b_re[j] = a_re[j] - tr;
+				b_im[j] = a_im[j] - ti;
+				a_re[j] += tr;
+				a_im[j] += ti;
+			}
+		}
+	}
+}
+
+/* One-sided power spectrum of a windowed real signal into power[] */
+static void fft_real_power(const float *signal)
+{
+	uint32_t k;
+
+	for (k = 0; k < HALF_SIZE; k++)
+	{
+		z_re[bitrev[k]] = signal[2 * k];
+		z_im[bitrev[k]] = signal[2 * k + 1];
+	}
+
+	fft_complex();
+
+	/* Even and odd halves of the real sequence from Z[k] and conj(Z[M-k]) */
+	power[0] = (z_re[0] + z_im[0]) * (z_re[0] + z_im[0]);
+	power[HALF_SIZE] = (z_re[0] - z_im[0]) * (z_re[0] - z_im[0]);
+	for (k = 1; k < HALF_SIZE; k++)
+	{
+		float ar = z_re[k], ai = z_im[k];
+		float cr = z_re[HALF_SIZE - k], ci = z_im[HALF_SIZE - k];
+		float er = 0.5f * (ar + cr), ei = 0.5f * (ai - ci);
+		float or_ = 0.5f * (ai + ci), oi = -0.5f * (ar - cr);
+		float xr = er + split_re[k] * or_ - split_im[k] * oi;
+		float xi = ei + split_re[k] * oi + split_im[k] * or_;
+
+		power[k] = xr * xr + xi * xi;
+	}
+}
+
+static void gsnr_fft_axis(float *__restrict signal, const struct GSensorVibration *pvib, struct GSensorAxisSpectrum *pspec)
+{
+	float mean = 0, ms = 0, scale, best = 0, left, right, denom, delta;
+	uint32_t i, k, peak = 1, band;
+
+	for (i = 0; i < GSNR_FFT_SIZE; i++)
+		mean += signal[i];
+	mean /= GSNR_FFT_SIZE;
+
+	/* Gravity and sensor offset are DC; only the AC part is vibration */
+	for (i = 0; i < GSNR_FFT_SIZE; i++)
+	{
+		signal[i] -= mean;
+		ms += signal[i] * signal[i];
+		signal[i] *= window[i];
+	}
+	pspec->rms_g = sqrtf(ms / GSNR_FFT_SIZE);
+
+	fft_real_power(signal);
+
+	/* Mean square per bin, one-sided, corrected for the window's noise bandwidth */
+	scale = 2.0f / (GSNR_FFT_SIZE * window_sq_sum);
+	for (band = 0; band < GSNR_FFT_BANDS; band++)
+		pspec->band_rms_g[band] = 0;
+
+	for (k = 1, band = 0; k <= HALF_SIZE; k++)
+	{
+		float hz = k * pvib->resolution_hz;
+
+		while (band + 1 < GSNR_FFT_BANDS && hz >= pvib->band_edge_hz[band + 1])
+			band++;
+		pspec->band_rms_g[band] += power[k] * scale;
+
+		if (k < HALF_SIZE && power[k] > best)
+		{
+			best = power[k];
+			peak = k;
+		}
+	}
+	for (band = 0; band < GSNR_FFT_BANDS; band++)
+		pspec->band_rms_g[band] = sqrtf(pspec->band_rms_g[band]);
+
+	/* Parabolic fit over the magnitudes around the peak bin */
+	delta = 0;
+	if (peak > 1)
+	{
+		left = sqrtf(power[peak - 1]);
+		right = sqrtf(power[peak + 1]);
+		denom = left - 2 * sqrtf(best) + right;
+		if (denom != 0)
+			delta = 0.5f * (left - right) / denom;
+	}
+	pspec->peak_hz = (peak + delta) * pvib->resolution_hz;
+	pspec->peak_g = 2 * sqrtf(best) / window_sum;
+}
+
+int gsnr_fft_analyze(uint32_t rate, struct GSensorVibration *pvib)
+{
+	uint64_t period = gsnr_rate_period_nsec(rate);
+	uint32_t band;
+
+	if (period == 0 || !fft_ready)
+		return -1;
+
+	if (gsnr_fft_fill())
+		return -1;
+
+	pvib->rate_hz = (float)(1e9 / (double)period);
+	pvib->resolution_hz = pvib->rate_hz / GSNR_FFT_SIZE;
+	pvib->band_edge_hz[0] = 0;
+	for (band = 1; band <= GSNR_FFT_BANDS; band++)
+		pvib->band_edge_hz[band] = pvib->rate_hz / 2 / (float)(1U << (GSNR_FFT_BANDS - band));
+
+	gsnr_fft_axis(axis_buf[0], pvib, &pvib->x);
+	gsnr_fft_axis(axis_buf[1], pvib, &pvib->y);
+	gsnr_fft_axis(axis_buf[2], pvib, &pvib->z);
+	return 0;
+}
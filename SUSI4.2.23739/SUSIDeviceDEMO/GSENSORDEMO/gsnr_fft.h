@@ -0,0 +1,39 @@
+#ifndef _GSNR_FFT_H_
+#define _GSNR_FFT_H_
+
+#include "gsnr_acq.h"
+
+/* Vibration spectrum of the latest GSNR_FFT_SIZE acquired samples. The
+   three axes are de-meaned, Hann windowed and transformed with a real FFT
+   (a half-size complex FFT plus a split pass) over separate per-axis
+   arrays, with the twiddles and bit-reversal table computed once by
+   gsnr_fft_init(). Only the per-axis summaries leave this module: the
+   dominant peak, the overall AC RMS and the RMS in each octave band below
+   Nyquist. */
+
+#define GSNR_FFT_SIZE		1024	/* Samples per window, power of two, at most GSNR_ACQ_RING_SIZE */
+#define GSNR_FFT_BANDS		6		/* Octaves, the top one ending at Nyquist */
+
+struct GSensorAxisSpectrum {
+	float peak_hz;					/* Dominant frequency, interpolated between bins */
+	float peak_g;					/* Amplitude of that component */
+	float rms_g;					/* AC RMS of the window */
+	float band_rms_g[GSNR_FFT_BANDS];
+};
+
+struct GSensorVibration {
+	float rate_hz;
+	float resolution_hz;			/* Bin width */
+	float band_edge_hz[GSNR_FFT_BANDS + 1];
+	struct GSensorAxisSpectrum x;
+	struct GSensorAxisSpectrum y;
+	struct GSensorAxisSpectrum z;
+};
+
+void gsnr_fft_init(void);
+
+/* Analyse the latest window of samples acquired at the SUSIDEV_GSENSOR_RATE_*
+   code rate. Returns -1 until a full window has been acquired. */
+int gsnr_fft_analyze(uint32_t rate, struct GSensorVibration *pvib);
+
+#endif /* _GSNR_FFT_H_ */
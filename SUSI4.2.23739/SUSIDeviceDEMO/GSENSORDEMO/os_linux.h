@@ -18,5 +18,37 @@
 #include <unistd.h>
 #define SLEEP_USEC(ms)				usleep(1000 * (unsigned long)ms)
 
+#include <pthread.h>
+typedef pthread_t THREAD_T;
+#define THREAD_PROC(name)			void *name(void *parg)
+#define THREAD_PROC_RETURN			return NULL
+#define THREAD_CREATE(pthread, proc, parg)	(pthread_create(pthread, NULL, proc, parg) == 0 ? 0 : -1)
+#define THREAD_JOIN(thread)			pthread_join(thread, NULL)
+
+/* Single-writer shared variables */
+#define ATOMIC_LOAD(pvar)			__atomic_load_n(pvar, __ATOMIC_ACQUIRE)
+#define ATOMIC_STORE(pvar, val)		__atomic_store_n(pvar, val, __ATOMIC_RELEASE)
+#define ATOMIC_LOAD_RELAXED(pvar)	__atomic_load_n(pvar, __ATOMIC_RELAXED)
+#define ATOMIC_STORE_RELAXED(pvar, val)	__atomic_store_n(pvar, val, __ATOMIC_RELAXED)
+
+#include <time.h>
+static inline uint64_t monotonic_nsec(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+static inline void sleep_until_nsec(uint64_t deadline)
+{
+	struct timespec ts;
+
+	ts.tv_sec = (time_t)(deadline / 1000000000ULL);
+	ts.tv_nsec = (long)(deadline % 1000000000ULL);
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) != 0)
+		;
+}
+
 #endif /* Linux */
 #endif /* _OS_LINUX_H_ */
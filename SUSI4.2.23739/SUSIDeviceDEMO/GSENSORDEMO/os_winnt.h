@@ -26,6 +26,37 @@
 
 #include <conio.h>
 
+typedef HANDLE THREAD_T;
+#define THREAD_PROC(name)			DWORD WINAPI name(LPVOID parg)
+#define THREAD_PROC_RETURN			return 0
+#define THREAD_CREATE(pthread, proc, parg)	((*(pthread) = CreateThread(NULL, 0, proc, parg, 0, NULL)) != NULL ? 0 : -1)
+#define THREAD_JOIN(thread)			(WaitForSingleObject(thread, INFINITE), CloseHandle(thread))
+
+/* Single-writer shared variables; aligned 32-bit accesses are atomic and
+   volatile ones are acquire/release under the default /volatile:ms */
+#define ATOMIC_LOAD(pvar)			(*(volatile uint32_t *)(pvar))
+#define ATOMIC_STORE(pvar, val)		(*(volatile uint32_t *)(pvar) = (val))
+#define ATOMIC_LOAD_RELAXED(pvar)	(*(volatile int32_t *)(pvar))
+#define ATOMIC_STORE_RELAXED(pvar, val)	(*(volatile int32_t *)(pvar) = (val))
+
+static __inline uint64_t monotonic_nsec(void)
+{
+	LARGE_INTEGER count, freq;
+
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&freq);
+	return (uint64_t)(count.QuadPart / freq.QuadPart) * 1000000000ULL +
+		(uint64_t)(count.QuadPart % freq.QuadPart) * 1000000000ULL / (uint64_t)freq.QuadPart;
+}
+
+static __inline void sleep_until_nsec(uint64_t deadline)
+{
+	uint64_t now;
+
+	while ((now = monotonic_nsec()) < deadline)
+		Sleep((DWORD)((deadline - now) / 1000000ULL));
+}
+
 #endif /* WIN32 or _WIN64 */
 
 #endif /* _OS_WINDOWS_H_ */
@@ -361,57 +361,98 @@ void PIC::page_set_up()
 	
 }
 
-void PIC::page_real_time_status()
+#define RT_FIRST_ROW		6	/* Below the title and the page heading */
+#define RT_VALUE_COLUMN		56
+
+enum rt_format {
+	RT_ON_OFF,
+	RT_VOLTS,
+	RT_SECONDS,
+	RT_TIMES,
+};
+
+static const struct {
+	SusiId_t id;
+	const char *label;
+	enum rt_format format;
+} rt_items[] = {
+	{PIC_ID_FW_V48_STATUS,				"48V output:",										RT_ON_OFF},
+	{PIC_ID_FW_IGN_LEVEL,				"Current IGN status:",								RT_ON_OFF},
+	{PIC_ID_FW_BAT_VOLT,				"Current power input:",								RT_VOLTS},
+	{PIC_ID_TIMER_TMR_HARD_OFF,			"Current hard off timer:",							RT_SECONDS},
+	{PIC_ID_TIMER_TMR_DELAY_OFF,		"Current Ignition off timer:",						RT_SECONDS},
+	{PIC_ID_TIMER_TMR_BL_DELAY_OFF,		"Current low battery detection timer:",				RT_SECONDS},
+	{PIC_ID_TIMER_PWR_OFF_RETRIES,		"Current retry times Press power button for power off:",	RT_TIMES},
+	{PIC_ID_TIMER_PWR_OFF_INTERVAL,		"Current retry timer Press power button for power off:",	RT_SECONDS},
+};
+#define RT_ITEMS (sizeof(rt_items) / sizeof(rt_items[0]))
+
+static void rt_move_to(int row, int column)
 {
-	uint32_t data = 0;
-	uint32_t status = 0;
-
-	while(1)
-	{
-		int ret = system(CLRSCR);
-		if (ret != 0)
-		{
-		}
-
-		Title();
-		printf("Real-time status\n\n");
-
-		status = SusiDeviceGetValue(PIC_ID_FW_V48_STATUS, &data);
-		if (data == 0)
-            printf("48V output:\t off \n");
-        else
-            printf("48V output:\t on \n");
-
-		status = SusiDeviceGetValue(PIC_ID_FW_IGN_LEVEL, &data);
-		if (data == 0)
-			printf("Current IGN status:\t off \n");
-		else
-			printf("Current IGN status:\t on \n");		
-
-		status = SusiDeviceGetValue(PIC_ID_FW_BAT_VOLT, &data);
-		printf("Current power input:\t %.1f \n", (double) data * 0.1);
-
-		status = SusiDeviceGetValue(PIC_ID_TIMER_TMR_HARD_OFF, &data);
-		printf("Current hard off timer:\t\t %d sec \n", data);
+#if defined(_LINUX) && !defined(_KERNEL)
+	gotoxy(column, row);
+#else
+	COORD position = {(SHORT)(column - 1), (SHORT)(row - 1)};
+	SetConsoleCursorPosition(GetStdHandle(STD_OUTPUT_HANDLE), position);
+#endif /* Linux */
+}
 
-		status = SusiDeviceGetValue(PIC_ID_TIMER_TMR_DELAY_OFF, &data);
-		printf("Current Ignition off timer:\t %d sec \n", data);
+static void rt_print_value(uint32_t i, uint32_t status, uint32_t data)
+{
+	char text[32];
+
+	if (status != SUSI_STATUS_SUCCESS)
+		snprintf(text, sizeof(text), "N/A");
+	else if (rt_items[i].format == RT_ON_OFF)
+		snprintf(text, sizeof(text), "%s", data == 0 ? "off" : "on");
+	else if (rt_items[i].format == RT_VOLTS)
+		snprintf(text, sizeof(text), "%.1f V", (double) data * 0.1);
+	else if (rt_items[i].format == RT_SECONDS)
+		snprintf(text, sizeof(text), "%u sec", data);
+	else
+		snprintf(text, sizeof(text), "%u times", data);
 
-		status = SusiDeviceGetValue(PIC_ID_TIMER_TMR_BL_DELAY_OFF, &data);
-		printf("Current low battery detection timer:\t %d sec \n", data);
+	/* Pad over whatever longer text was there before */
+	rt_move_to(RT_FIRST_ROW + (int)i, RT_VALUE_COLUMN);
+	printf("%-12s", text);
+}
 
-		status = SusiDeviceGetValue(PIC_ID_TIMER_PWR_OFF_RETRIES, &data);
-		printf("Current retry times Press power button for power off:\t %d times\n", data);
+void PIC::page_real_time_status()
+{
+	uint32_t data[RT_ITEMS], status[RT_ITEMS];
+	uint32_t i, value, result;
 
-		status = SusiDeviceGetValue(PIC_ID_TIMER_PWR_OFF_INTERVAL, &data);
-		printf("Current retry timer Press power button for power off:\t %d sec \n", data);		
+	/* The page is drawn once; afterwards only values that changed are rewritten */
+#if defined(_LINUX) && !defined(_KERNEL)
+	clrscr();
+#else
+	int ret = system(CLRSCR);
+	if (ret != 0)
+	{
+	}
+#endif /* Linux */
+	Title();
+	printf("Real-time status\n\n");
+	for (i = 0; i < RT_ITEMS; i++)
+		printf("%s\n", rt_items[i].label);
+	printf("\nPress [r] return to menu\n");
 
-		printf("\nPress [r] return to menu\n");
+	for (i = 0; i < RT_ITEMS; i++)
+	{
+		status[i] = SusiDeviceGetValue(rt_items[i].id, &data[i]);
+		rt_print_value(i, status[i], data[i]);
+	}
+	rt_move_to(RT_FIRST_ROW + (int)RT_ITEMS + 2, 1);
+	fflush(stdout);
 
+	while (1)
+	{
 		int time = 0;
 		while (time < 10)
 		{
 			isKBhit();
+			if (Returnmean)
+				break;
 			SLEEP_USEC(100);
 			time++;
 		}
@@ -420,9 +461,19 @@ void PIC::page_real_time_status()
 			Returnmean = false;
 			break;
 		}
-		if (status != 0)
+
+		for (i = 0; i < RT_ITEMS; i++)
 		{
+			result = SusiDeviceGetValue(rt_items[i].id, &value);
+			if (result == status[i] && (result != SUSI_STATUS_SUCCESS || value == data[i]))
+				continue;
+
+			status[i] = result;
+			data[i] = value;
+			rt_print_value(i, result, value);
 		}
+		rt_move_to(RT_FIRST_ROW + (int)RT_ITEMS + 2, 1);
+		fflush(stdout);
 	}
 }
 
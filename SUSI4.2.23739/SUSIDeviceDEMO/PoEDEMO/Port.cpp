@@ -2,12 +2,12 @@
 #include "os_winnt.h"
 #include "os_linux.h"
 
-std::string detectStatus[] = {
+static const char *detectStatus[] = {
 	"Unknown", "PD Error", "PD Error", "PD Error", "Detected Good", "PD Error", "Detect Open",
 	"PD Error",
 };
 
-std::string classStatus[] = {
+static const char *classStatus[] = {
 	"Class Unknown", "Class 1", "Class 2", "Class 3", "Class 4", "Error", "Class 0", "OverCurrent",
 };
 
@@ -113,19 +113,42 @@ uint32_t Port::getPortNum()
 	return _portNum;
 }
 
-std::string Port::getPowerString()
+const char *Port::detectionName(uint32_t detect)
+{
+	return detect < sizeof(detectStatus) / sizeof(detectStatus[0]) ? detectStatus[detect] : "Unknown";
+}
+
+const char *Port::className(uint32_t classification)
+{
+	return classification < sizeof(classStatus) / sizeof(classStatus[0]) ? classStatus[classification] : "Class Unknown";
+}
+
+const char *Port::getPowerName()
 {
 	return _portPower == 0 ? "Off" : "On";
 }
 
+const char *Port::getDetectionName()
+{
+	return detectionName(getDetection());
+}
+
+const char *Port::getClassName()
+{
+	return className(getClassification());
+}
+
+std::string Port::getPowerString()
+{
+	return getPowerName();
+}
+
 std::string Port::getDetectionString()
 {
-	uint32_t detect = getDetection();
-	return detectStatus[detect];
+	return getDetectionName();
 }
 
 std::string Port::getClassString()
 {
-	uint32_t classification = getClassification();
-	return classStatus[classification];
+	return getClassName();
 }
\ No newline at end of file
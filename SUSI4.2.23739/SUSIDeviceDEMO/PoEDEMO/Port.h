@@ -64,6 +64,13 @@ public:
 	double getVoltage();
 	double getCurrent();
 	uint32_t getPortNum();
+
+	// Names from static tables, no allocation; the std::string versions wrap them
+	static const char *detectionName(uint32_t detect);
+	static const char *className(uint32_t classification);
+	const char *getPowerName();
+	const char *getDetectionName();
+	const char *getClassName();
 	std::string getPowerString();
 	std::string getDetectionString();
 	std::string getClassString();
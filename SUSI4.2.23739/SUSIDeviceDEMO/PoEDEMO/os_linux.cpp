@@ -123,19 +123,19 @@ int main()
 			for (int i = 0; i < GROUP_MAX_PORT; i++)
 			{
 				ports[base + i].getPower();
-				printf("%-15s", ports[base + i].getPowerString().c_str());
+				printf("%-15s", ports[base + i].getPowerName());
 			}
 
 			printf("\n%-10s", "Detect:");
 			for (int i = 0; i < GROUP_MAX_PORT; i++)
 			{
-				printf("%-15s", ports[base + i].getDetectionString().c_str());
+				printf("%-15s", ports[base + i].getDetectionName());
 			}
 
 			printf("\n%-10s", "Class:");
 			for (int i = 0; i < GROUP_MAX_PORT; i++)
 			{
-				printf("%-15s", ports[base + i].getClassString().c_str());
+				printf("%-15s", ports[base + i].getClassName());
 			}
 
 			printf("\n%-10s", "Voltage:");
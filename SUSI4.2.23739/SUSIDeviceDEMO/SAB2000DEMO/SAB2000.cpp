@@ -58,36 +58,35 @@ bool isAvailable()
 	return tmp > 0 ? true : false;
 }
 
-void GetStatusStr(uint32_t Value)
+const char *GetStatusName(uint32_t Value)
 {
 	switch (Value & 0x07)
-    {
-   		case 0:
-      		printf("Dark\n");
-			break;
-			
+	{
+		case 0:
+			return "Dark";
+
 		case 1:
-			printf("Green\n");
-			break;
+			return "Green";
 
 		case 2:
-			printf("Red\n");
-			break;
+			return "Red";
 
 		case 5:
-			printf("Green Blink\n");
-			break;
+			return "Green Blink";
 
 		case 6:
-			printf("Red Blink\n");
-			break;
-		
+			return "Red Blink";
+
 		default:
-			printf("Unknown\n");
-			break;
+			return "Unknown";
 	}
 }
 
+void GetStatusStr(uint32_t Value)
+{
+	printf("%s\n", GetStatusName(Value));
+}
+
 void printInformation()
 {
 	uint32_t u32tmp;
@@ -294,14 +293,8 @@ int printAlert()
 			break;
 
 		case 3:
-			while(true)
-			{	
-				clr_screen();
-				title(); 
-
-				if(printAlert()== -1)			
-				  return -1;							
-			}
+			/* The caller's loop redraws the status; calling printAlert() again
+			   here grew the stack on every refresh */
 			break;
 EXIT:
 		default:
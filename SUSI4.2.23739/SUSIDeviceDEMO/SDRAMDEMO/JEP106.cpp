@@ -2,1443 +2,1479 @@
 #include "os_winnt.h"
 #include "os_linux.h"
 
-std::string SPD::GetManufacture(uint32_t dev)
+/* JEP106 codes as SPD returns them: the ID in the high byte and the bank's
+   continuation count in the low byte, each with its parity bit. The table
+   is in bank and ID order, which is ascending once the parity bits are
+   dropped, so a lookup is a binary search. The compiler checks the order. */
+struct JEP106_map {
+	uint32_t index;
+	const char *Name;
+};
+
+static constexpr JEP106_map JEP106_Table[] = {
+	{ 0x0180, "AMD" },
+	{ 0x0280, "AMI" },
+	{ 0x8380, "Fairchild" },
+	{ 0x0480, "Fujitsu" },
+	{ 0x8580, "GTE" },
+	{ 0x8680, "Harris" },
+	{ 0x0780, "Hitachi" },
+	{ 0x0880, "Inmos" },
+	{ 0x8980, "Inte" },
+	{ 0x8A80, "I.T.T." },
+	{ 0x0B80, "Intersi" },
+	{ 0x8C80, "Monolithic Memories" },
+	{ 0x0D80, "Mostek" },
+	{ 0x0E80, "Freescale (Motorola)" },
+	{ 0x8F80, "Nationa" },
+	{ 0x1080, "NEC" },
+	{ 0x9180, "RCA" },
+	{ 0x9280, "Raytheon" },
+	{ 0x1380, "Conexant (Rockwell)" },
+	{ 0x9480, "Seeq" },
+	{ 0x1580, "NXP (Philips)" },
+	{ 0x1680, "Synertek" },
+	{ 0x9780, "Texas Instruments" },
+	{ 0x9880, "Toshiba" },
+	{ 0x1980, "Xicor" },
+	{ 0x1A80, "Zilog" },
+	{ 0x9B80, "Eurotechnique" },
+	{ 0x1C80, "Mitsubishi" },
+	{ 0x9D80, "Lucent (AT&T)" },
+	{ 0x9E80, "Exe" },
+	{ 0x1F80, "Atme" },
+	{ 0x2080, "STMicroelectronics" },
+	{ 0xA180, "Lattice Semi." },
+	{ 0xA280, "NCR" },
+	{ 0x2380, "Wafer Scale Integration" },
+	{ 0xA480, "IBM" },
+	{ 0x2580, "Tristar" },
+	{ 0x2680, "Visic" },
+	{ 0xA780, "Intl. CMOS Technology" },
+	{ 0xA880, "SSSI" },
+	{ 0x2980, "MicrochipTechnology" },
+	{ 0x2A80, "Ricoh Ltd" },
+	{ 0xAB80, "VLSI" },
+	{ 0x2C80, "Micron Technology" },
+	{ 0xAD80, "SK Hynix" },
+	{ 0xAE80, "OKI Semiconductor" },
+	{ 0x2F80, "ACTE" },
+	{ 0xB080, "Sharp" },
+	{ 0x3180, "Catalyst" },
+	{ 0x3280, "Panasonic" },
+	{ 0xB380, "IDT" },
+	{ 0x3480, "Cypress" },
+	{ 0xB580, "DEC" },
+	{ 0xB680, "LSI Logic" },
+	{ 0x3780, "Zarlink (Plessey)" },
+	{ 0x3880, "UTMC" },
+	{ 0xB980, "Thinking Machine" },
+	{ 0xBA80, "Thomson CSF" },
+	{ 0x3B80, "Integrated CMOS (Vertex)" },
+	{ 0xBC80, "Honeywel" },
+	{ 0x3D80, "Tektronix" },
+	{ 0x3E80, "Oracle Corporation" },
+	{ 0xBF80, "Silicon Storage Technology" },
+	{ 0x4080, "ProMos/Mosel Vitelic" },
+	{ 0xC180, "Infineon (Siemens)" },
+	{ 0xC280, "Macronix" },
+	{ 0x4380, "Xerox" },
+	{ 0xC480, "Plus Logic" },
+	{ 0x4580, "Western Digital Technologies Inc" },
+	{ 0x4680, "Elan Circuit Tech." },
+	{ 0xC780, "European Silicon Str." },
+	{ 0xC880, "Apple Computer" },
+	{ 0x4980, "Xilinx" },
+	{ 0x4A80, "Compaq" },
+	{ 0xCB80, "Protocol Engines" },
+	{ 0x4C80, "SCI" },
+	{ 0xCD80, "Seiko Instruments" },
+	{ 0xCE80, "Samsung" },
+	{ 0x4F80, "I3 Design System" },
+	{ 0xD080, "Klic" },
+	{ 0x5180, "Crosspoint Solutions" },
+	{ 0x5280, "Alliance Semiconductor" },
+	{ 0xD380, "Tandem" },
+	{ 0x5480, "Hewlett-Packard" },
+	{ 0xD580, "Integrated Silicon Solutions" },
+	{ 0xD680, "Brooktree" },
+	{ 0x5780, "New Media" },
+	{ 0x5880, "MHS Electronic" },
+	{ 0xD980, "Performance Semi." },
+	{ 0xDA80, "Winbond Electronic" },
+	{ 0x5B80, "Kawasaki Stee" },
+	{ 0xDC80, "Bright Micro" },
+	{ 0x5D80, "TECMAR" },
+	{ 0x5E80, "Exar" },
+	{ 0xDF80, "PCMCIA" },
+	{ 0xE080, "LG Semi (Goldstar)" },
+	{ 0x6180, "Northern Telecom" },
+	{ 0x6280, "Sanyo" },
+	{ 0xE380, "Array Microsystems" },
+	{ 0x6480, "Crystal Semiconductor" },
+	{ 0xE580, "Analog Devices" },
+	{ 0xE680, "PMC-Sierra" },
+	{ 0x6780, "Asparix" },
+	{ 0x6880, "Convex Computer" },
+	{ 0xE980, "Quality Semiconductor" },
+	{ 0xEA80, "Nimbus Technology" },
+	{ 0x6B80, "Transwitch" },
+	{ 0xEC80, "Micronas (ITT Intermetall)" },
+	{ 0x6D80, "Cannon" },
+	{ 0x6E80, "Altera" },
+	{ 0xEF80, "NEXCOM" },
+	{ 0x7080, "Qualcomm" },
+	{ 0xF180, "Sony" },
+	{ 0xF280, "Cray Research" },
+	{ 0x7380, "AMS(Austria Micro)" },
+	{ 0xF480, "Vitesse" },
+	{ 0x7580, "Aster Electronics" },
+	{ 0x7680, "Bay Networks (Synoptic)" },
+	{ 0xF780, "Zentrum/ZMD" },
+	{ 0xF880, "TRW" },
+	{ 0x7980, "Thesys" },
+	{ 0x7A80, "Solbourne Computer" },
+	{ 0xFB80, "Allied-Signa" },
+	{ 0x7C80, "Dialog Semiconductor" },
+	{ 0xFD80, "Media Vision" },
+	{ 0xFE80, "Numonyx Corporation" },
+	//The following numbers are all in bank two:								
+	{ 0x0101, "Cirrus Logic" },
+	{ 0x0201, "National Instruments" },
+	{ 0x8301, "ILC Data Device" },
+	{ 0x0401, "Alcatel Mietec" },
+	{ 0x8501, "Micro Linear" },
+	{ 0x8601, "Univ. of NC" },
+	{ 0x0701, "JTAG Technologies" },
+	{ 0x0801, "BAE Systems (Loral)" },
+	{ 0x8901, "Nchip" },
+	{ 0x8A01, "Galileo Tech" },
+	{ 0x0B01, "Bestlink Systems" },
+	{ 0x8C01, "Graychip" },
+	{ 0x0D01, "GENNUM" },
+	{ 0x0E01, "VideoLogic" },
+	{ 0x8F01, "Robert Bosch" },
+	{ 0x1001, "Chip Express" },
+	{ 0x9101, "DATARAM" },
+	{ 0x9201, "United Microelectronics Corp" },
+	{ 0x1301, "TCSI" },
+	{ 0x9401, "Smart Modular" },
+	{ 0x1501, "Hughes Aircraft" },
+	{ 0x1601, "Lanstar Semiconductor" },
+	{ 0x9701, "Qlogic" },
+	{ 0x9801, "Kingston" },
+	{ 0x1901, "Music Semi" },
+	{ 0x1A01, "Ericsson Components" },
+	{ 0x9B01, "SpaSE" },
+	{ 0x1C01, "Eon Silicon Devices" },
+	{ 0x9D01, "Integrated Silicon Solution (ISSI)" },
+	{ 0x9E01, "DoD" },
+	{ 0x1F01, "Integ. Memories Tech." },
+	{ 0x2001, "Corollary Inc" },
+	{ 0xA101, "Dallas Semiconductor" },
+	{ 0xA201, "Omnivision" },
+	{ 0x2301, "EIV(Switzerland)" },
+	{ 0xA401, "Novatel Wireless" },
+	{ 0x2501, "Zarlink (Mitel)" },
+	{ 0x2601, "Clearpoint" },
+	{ 0xA701, "Cabletron" },
+	{ 0xA801, "STEC (Silicon Tech)" },
+	{ 0x2901, "Vanguard" },
+	{ 0x2A01, "Hagiwara Sys-Com" },
+	{ 0xAB01, "Vantis" },
+	{ 0x2C01, "Celestica" },
+	{ 0xAD01, "Century" },
+	{ 0xAE01, "Hal Computers" },
+	{ 0x2F01, "Rohm Company Ltd" },
+	{ 0xB001, "Juniper Networks" },
+	{ 0x3101, "Libit Signal Processing" },
+	{ 0x3201, "Mushkin Enhanced Memory" },
+	{ 0xB301, "Tundra Semiconductor" },
+	{ 0x3401, "Adaptec Inc" },
+	{ 0xB501, "LightSpeed Semi." },
+	{ 0xB601, "ZSP Corp" },
+	{ 0x3701, "AMIC Technology" },
+	{ 0x3801, "Adobe Systems" },
+	{ 0xB901, "Dynachip" },
+	{ 0xBA01, "PNY Technologies Inc" },
+	{ 0x3B01, "Newport Digita" },
+	{ 0xBC01, "MMC Networks" },
+	{ 0x3D01, "T Square" },
+	{ 0x3E01, "Seiko Epson" },
+	{ 0xBF01, "Broadcom" },
+	{ 0x4001, "Viking Components" },
+	{ 0xC101, "V3 Semiconductor" },
+	{ 0xC201, "Flextronics (Orbit Semiconductor)" },
+	{ 0x4301, "Suwa Electronics" },
+	{ 0xC401, "Transmeta" },
+	{ 0x4501, "Micron CMS" },
+	{ 0x4601, "American Computer & Digital Components Inc" },
+	{ 0xC701, "Enhance 3000 Inc" },
+	{ 0xC801, "Tower Semiconductor" },
+	{ 0x4901, "CPU Design" },
+	{ 0x4A01, "Price Point" },
+	{ 0xCB01, "Maxim Integrated Product" },
+	{ 0x4C01, "Tellabs" },
+	{ 0xCD01, "Centaur Technology" },
+	{ 0xCE01, "Unigen Corporation" },
+	{ 0x4F01, "Transcend Information" },
+	{ 0xD001, "Memory Card Technology" },
+	{ 0x5101, "CKD Corporation Ltd" },
+	{ 0x5201, "Capital Instruments" },
+	{ 0xD301, "Aica Kogyo Ltd" },
+	{ 0x5401, "Linvex Technology" },
+	{ 0xD501, "MSC Vertriebs GmbH" },
+	{ 0xD601, "AKM Company Ltd" },
+	{ 0x5701, "Dynamem Inc" },
+	{ 0x5801, "NERA ASA" },
+	{ 0xD901, "GSI Technology" },
+	{ 0xDA01, "Dane-Elec (C Memory)" },
+	{ 0x5B01, "Acorn Computers" },
+	{ 0xDC01, "Lara Technology" },
+	{ 0x5D01, "Oak Technology Inc" },
+	{ 0x5E01, "Itec Memory" },
+	{ 0xDF01, "Tanisys Technology" },
+	{ 0xE001, "Truevision" },
+	{ 0x6101, "Wintec Industries" },
+	{ 0x6201, "Super PC Memory" },
+	{ 0xE301, "MGV Memory" },
+	{ 0x6401, "Galvantech" },
+	{ 0xE501, "Gadzoox Networks" },
+	{ 0xE601, "Multi Dimensional Cons." },
+	{ 0x6701, "GateField" },
+	{ 0x6801, "Integrated Memory System" },
+	{ 0xE901, "Triscend" },
+	{ 0xEA01, "XaQti" },
+	{ 0x6B01, "Goldenram" },
+	{ 0xEC01, "Clear Logic" },
+	{ 0x6D01, "Cimaron Communications" },
+	{ 0x6E01, "Nippon Steel Semi. Corp" },
+	{ 0xEF01, "Advantage Memory" },
+	{ 0x7001, "AMCC" },
+	{ 0xF101, "LeCroy" },
+	{ 0xF201, "Yamaha Corporation" },
+	{ 0x7301, "Digital Microwave" },
+	{ 0xF401, "NetLogic Microsystems" },
+	{ 0x7501, "MIMOS Semiconductor" },
+	{ 0x7601, "Advanced Fibre" },
+	{ 0xF701, "BF Goodrich Data." },
+	{ 0xF801, "Epigram" },
+	{ 0x7901, "Acbel Polytech Inc" },
+	{ 0x7A01, "Apacer Technology" },
+	{ 0xFB01, "Admor Memory" },
+	{ 0x7C01, "FOXCONN" },
+	{ 0xFD01, "Quadratics Superconductor" },
+	{ 0xFE01, "3COM" },
+	//The following numbers are all in bank three:								
+	{ 0x0102, "Camintonn Corporation" },
+	{ 0x0202, "ISOA Incorporated" },
+	{ 0x8302, "Agate Semiconductor" },
+	{ 0x0402, "ADMtek Incorporated" },
+	{ 0x8502, "HYPERTEC" },
+	{ 0x8602, "Adhoc Technologies" },
+	{ 0x0702, "MOSAID Technologies" },
+	{ 0x0802, "Ardent Technologies" },
+	{ 0x8902, "Switchcore" },
+	{ 0x8A02, "Cisco Systems Inc" },
+	{ 0x0B02, "Allayer Technologies" },
+	{ 0x8C02, "WorkX AG (Wichman)" },
+	{ 0x0D02, "Oasis Semiconductor" },
+	{ 0x0E02, "Novanet Semiconductor" },
+	{ 0x8F02, "E-M Solutions" },
+	{ 0x1002, "Power Genera" },
+	{ 0x9102, "Advanced Hardware Arch." },
+	{ 0x9202, "Inova Semiconductors GmbH" },
+	{ 0x1302, "Telocity" },
+	{ 0x9402, "Delkin Devices" },
+	{ 0x1502, "Symagery Microsystems" },
+	{ 0x1602, "C-Port Corporation" },
+	{ 0x9702, "SiberCore Technologies" },
+	{ 0x9802, "Southland Microsystems" },
+	{ 0x1902, "Malleable Technologies" },
+	{ 0x1A02, "Kendin Communications" },
+	{ 0x9B02, "Great Technology Microcomputer" },
+	{ 0x1C02, "Sanmina Corporation" },
+	{ 0x9D02, "HADCO Corporation" },
+	{ 0x9E02, "Corsair" },
+	{ 0x1F02, "Actrans System Inc" },
+	{ 0x2002, "ALPHA Technologies" },
+	{ 0xA102, "Silicon Laboratories Inc (Cygnal)" },
+	{ 0xA202, "Artesyn Technologies" },
+	{ 0x2302, "Align Manufacturing" },
+	{ 0xA402, "Peregrine Semiconductor" },
+	{ 0x2502, "Chameleon Systems" },
+	{ 0x2602, "Aplus Flash Technology" },
+	{ 0xA702, "MIPS Technologies" },
+	{ 0xA802, "Chrysalis ITS" },
+	{ 0x2902, "ADTEC Corporation" },
+	{ 0x2A02, "Kentron Technologies" },
+	{ 0xAB02, "Win Technologies" },
+	{ 0x2C02, "Tezzaron Semiconductor" },
+	{ 0xAD02, "Extreme Packet Devices" },
+	{ 0xAE02, "RF Micro Devices" },
+	{ 0x2F02, "Siemens AG" },
+	{ 0xB002, "Sarnoff Corporation" },
+	{ 0x3102, "Itautec SA" },
+	{ 0x3202, "Radiata Inc" },
+	{ 0xB302, "Benchmark Elect. (AVEX)" },
+	{ 0x3402, "Legend" },
+	{ 0xB502, "SpecTek Incorporated" },
+	{ 0xB602, "Hi/fn" },
+	{ 0x3702, "Enikia Incorporated" },
+	{ 0x3802, "SwitchOn Networks" },
+	{ 0xB902, "AANetcom Incorporated" },
+	{ 0xBA02, "Micro Memory Bank" },
+	{ 0x3B02, "ESS Technology" },
+	{ 0xBC02, "Virata Corporation" },
+	{ 0x3D02, "Excess Bandwidth" },
+	{ 0x3E02, "West Bay Semiconductor" },
+	{ 0xBF02, "DSP Group" },
+	{ 0x4002, "Newport Communications" },
+	{ 0xC102, "Chip2Chip Incorporated" },
+	{ 0xC202, "Phobos Corporation" },
+	{ 0x4302, "Intellitech Corporation" },
+	{ 0xC402, "Nordic VLSI ASA" },
+	{ 0x4502, "Ishoni Networks" },
+	{ 0x4602, "Silicon Spice" },
+	{ 0xC702, "Alchemy Semiconductor" },
+	{ 0xC802, "Agilent Technologies" },
+	{ 0x4902, "Centillium Communications" },
+	{ 0x4A02, "W.L. Gore" },
+	{ 0xCB02, "HanBit Electronics" },
+	{ 0x4C02, "GlobeSpan" },
+	{ 0xCD02, "Element" },
+	{ 0xCE02, "Pycon" },
+	{ 0x4F02, "Saifun Semiconductors" },
+	{ 0xD002, "Sibyte Incorporated" },
+	{ 0x5102, "MetaLink Technologies" },
+	{ 0x5202, "Feiya Technology" },
+	{ 0xD302, "I & C Technology" },
+	{ 0x5402, "Shikatronics" },
+	{ 0xD502, "Elektrobit" },
+	{ 0xD602, "Megic" },
+	{ 0x5702, "Com-Tier" },
+	{ 0x5802, "Malaysia Micro Solutions" },
+	{ 0xD902, "Hyperchip" },
+	{ 0xDA02, "Gemstone Communications" },
+	{ 0x5B02, "Anadigm (Anadyne)" },
+	{ 0xDC02, "3ParData" },
+	{ 0x5D02, "Mellanox Technologies" },
+	{ 0x5E02, "Tenx Technologies" },
+	{ 0xDF02, "Helix AG" },
+	{ 0xE002, "Domosys" },
+	{ 0x6102, "Skyup Technology" },
+	{ 0x6202, "HiNT Corporation" },
+	{ 0xE302, "Chiaro" },
+	{ 0x6402, "MDT Technologies GmbH" },
+	{ 0xE502, "Exbit Technology A/S" },
+	{ 0xE602, "Integrated Technology Express" },
+	{ 0x6702, "AVED Memory" },
+	{ 0x6802, "Legerity" },
+	{ 0xE902, "Jasmine Networks" },
+	{ 0xEA02, "Caspian Networks" },
+	{ 0x6B02, "nCUBE" },
+	{ 0xEC02, "Silicon Access Networks" },
+	{ 0x6D02, "FDK Corporation" },
+	{ 0x6E02, "High Bandwidth Access" },
+	{ 0xEF02, "MultiLink Technology" },
+	{ 0x7002, "BRECIS" },
+	{ 0xF102, "World Wide Packets" },
+	{ 0xF202, "APW" },
+	{ 0x7302, "Chicory Systems" },
+	{ 0xF402, "Xstream Logic" },
+	{ 0x7502, "Fast-Chip" },
+	{ 0x7602, "Zucotto Wireless" },
+	{ 0xF702, "Realchip" },
+	{ 0xF802, "Galaxy Power" },
+	{ 0x7902, "eSilicon" },
+	{ 0x7A02, "Morphics Technology" },
+	{ 0xFB02, "Accelerant Networks" },
+	{ 0x7C02, "Silicon Wave" },
+	{ 0xFD02, "SandCraft" },
+	{ 0xFE02, "Elpida" },
+	//The following numbers are all in bank four:								
+	{ 0x0183, "Solectron" },
+	{ 0x0283, "Optosys Technologies" },
+	{ 0x8383, "Buffalo (Formerly Melco)" },
+	{ 0x0483, "TriMedia Technologies" },
+	{ 0x8583, "Cyan Technologies" },
+	{ 0x8683, "Global Locate" },
+	{ 0x0783, "Optillion" },
+	{ 0x0883, "Terago Communications" },
+	{ 0x8983, "Ikanos Communications" },
+	{ 0x8A83, "Princeton Technology" },
+	{ 0x0B83, "Nanya Technology" },
+	{ 0x8C83, "Elite Flash Storage" },
+	{ 0x0D83, "Mysticom" },
+	{ 0x0E83, "LightSand Communications" },
+	{ 0x8F83, "ATI Technologies" },
+	{ 0x1083, "Agere Systems" },
+	{ 0x9183, "NeoMagic" },
+	{ 0x9283, "AuroraNetics" },
+	{ 0x1383, "Golden Empire" },
+	{ 0x9483, "Mushkin" },
+	{ 0x1583, "Tioga Technologies" },
+	{ 0x1683, "Netlist" },
+	{ 0x9783, "TeraLogic" },
+	{ 0x9883, "Cicada Semiconductor" },
+	{ 0x1983, "Centon Electronics" },
+	{ 0x1A83, "Tyco Electronics" },
+	{ 0x9B83, "Magis Works" },
+	{ 0x1C83, "Zettacom" },
+	{ 0x9D83, "Cogency Semiconductor" },
+	{ 0x9E83, "Chipcon AS" },
+	{ 0x1F83, "Aspex Technology" },
+	{ 0x2083, "F5 Networks" },
+	{ 0xA183, "Programmable Silicon Solutions" },
+	{ 0xA283, "ChipWrights" },
+	{ 0x2383, "Acorn Networks" },
+	{ 0xA483, "Quicklogic" },
+	{ 0x2583, "Kingmax Semiconductor" },
+	{ 0x2683, "BOPS" },
+	{ 0xA783, "Flasys" },
+	{ 0xA883, "BitBlitz Communications" },
+	{ 0x2983, "eMemory Technology" },
+	{ 0x2A83, "Procket Networks" },
+	{ 0xAB83, "Purple Ray" },
+	{ 0x2C83, "Trebia Networks" },
+	{ 0xAD83, "Delta Electronics" },
+	{ 0xAE83, "Onex Communications" },
+	{ 0x2F83, "Ample Communications" },
+	{ 0xB083, "Memory Experts Int" },
+	{ 0x3183, "Astute Networks" },
+	{ 0x3283, "Azanda Network Devices" },
+	{ 0xB383, "Dibcom" },
+	{ 0x3483, "Tekmos" },
+	{ 0xB583, "API NetWorks" },
+	{ 0xB683, "Bay Microsystems" },
+	{ 0x3783, "Firecron Ltd" },
+	{ 0x3883, "Resonext Communications" },
+	{ 0xB983, "Tachys Technologies" },
+	{ 0xBA83, "Equator Technology" },
+	{ 0x3B83, "Concept Computer" },
+	{ 0xBC83, "SILCOM" },
+	{ 0x3D83, "3Dlabs" },
+	{ 0x3E83, "c't Magazine" },
+	{ 0xBF83, "Sanera Systems" },
+	{ 0x4083, "Silicon Packets" },
+	{ 0xC183, "Viasystems Group" },
+	{ 0xC283, "Simtek" },
+	{ 0x4383, "Semicon Devices Singapore" },
+	{ 0xC483, "Satron Handelsges" },
+	{ 0x4583, "Improv Systems" },
+	{ 0x4683, "INDUSYS GmbH" },
+	{ 0xC783, "Corrent" },
+	{ 0xC883, "Infrant Technologies" },
+	{ 0x4983, "Ritek Corp" },
+	{ 0x4A83, "empowerTel Networks" },
+	{ 0xCB83, "Hypertec" },
+	{ 0x4C83, "Cavium Networks" },
+	{ 0xCD83, "PLX Technology" },
+	{ 0xCE83, "Massana Design" },
+	{ 0x4F83, "Intrinsity" },
+	{ 0xD083, "Valence Semiconductor" },
+	{ 0x5183, "Terawave Communications" },
+	{ 0x5283, "IceFyre Semiconductor" },
+	{ 0xD383, "Primarion" },
+	{ 0x5483, "Picochip Designs Ltd" },
+	{ 0xD583, "Silverback Systems" },
+	{ 0xD683, "Jade Star Technologies" },
+	{ 0x5783, "Pijnenburg Securealink" },
+	{ 0x5883, "takeMS - Ultron AG" },
+	{ 0xD983, "Cambridge Silicon Radio" },
+	{ 0xDA83, "Swissbit" },
+	{ 0x5B83, "Nazomi Communications" },
+	{ 0xDC83, "eWave System" },
+	{ 0x5D83, "Rockwell Collins" },
+	{ 0x5E83, "Picocel Co Ltd (Paion)" },
+	{ 0xDF83, "Alphamosaic Ltd" },
+	{ 0xE083, "Sandburst" },
+	{ 0x6183, "SiCon Video" },
+	{ 0x6283, "NanoAmp Solutions" },
+	{ 0xE383, "Ericsson Technology" },
+	{ 0x6483, "PrairieComm" },
+	{ 0xE583, "Mitac Internationa" },
+	{ 0xE683, "Layer N Networks" },
+	{ 0x6783, "MtekVision (Atsana)" },
+	{ 0x6883, "Allegro Networks" },
+	{ 0xE983, "Marvell Semiconductors" },
+	{ 0xEA83, "Netergy Microelectronic" },
+	{ 0x6B83, "NVIDIA" },
+	{ 0xEC83, "Internet Machines" },
+	{ 0x6D83, "Memorysolution GmbH" },
+	{ 0x6E83, "Litchfield Communication" },
+	{ 0xEF83, "Accton Technology" },
+	{ 0x7083, "Teradiant Networks" },
+	{ 0xF183, "Scaleo Chip" },
+	{ 0xF283, "Cortina Systems" },
+	{ 0x7383, "RAM Components" },
+	{ 0xF483, "Raqia Networks" },
+	{ 0x7583, "ClearSpeed" },
+	{ 0x7683, "Matsushita Battery" },
+	{ 0xF783, "Xelerated" },
+	{ 0xF883, "SimpleTech" },
+	{ 0x7983, "Utron Technology" },
+	{ 0x7A83, "Astec Internationa" },
+	{ 0xFB83, "AVM gmbH" },
+	{ 0x7C83, "Redux Communications" },
+	{ 0xFD83, "Dot Hill Systems" },
+	{ 0xFE83, "TeraChip" },
+	//The following numbers are all in bank five:								
+	{ 0x0104, "T-RAM Incorporated" },
+	{ 0x0204, "Innovics Wireless" },
+	{ 0x8304, "Teknovus" },
+	{ 0x0404, "KeyEye Communications" },
+	{ 0x8504, "Runcom Technologies" },
+	{ 0x8604, "RedSwitch" },
+	{ 0x0704, "Dotcast" },
+	{ 0x0804, "Silicon Mountain Memory" },
+	{ 0x8904, "Signia Technologies" },
+	{ 0x8A04, "Pixim" },
+	{ 0x0B04, "Galazar Networks" },
+	{ 0x8C04, "White Electronic Designs" },
+	{ 0x0D04, "Patriot Scientific" },
+	{ 0x0E04, "Neoaxiom Corporation" },
+	{ 0x8F04, "3Y Power Technology" },
+	{ 0x1004, "Scaleo Chip" },
+	{ 0x9104, "Potentia Power Systems" },
+	{ 0x9204, "C-guys Incorporated" },
+	{ 0x1304, "Digital Communications Technology Inc" },
+	{ 0x9404, "Silicon-Based Technology" },
+	{ 0x1504, "Fulcrum Microsystems" },
+	{ 0x1604, "Positivo Informatica Ltd" },
+	{ 0x9704, "XIOtech Corporation" },
+	{ 0x9804, "PortalPlayer" },
+	{ 0x1904, "Zhiying Software" },
+	{ 0x1A04, "ParkerVision Inc" },
+	{ 0x9B04, "Phonex Broadband" },
+	{ 0x1C04, "Skyworks Solutions" },
+	{ 0x9D04, "Entropic Communications" },
+	{ 0x9E04, "I'M Intelligent Memory Ltd" },
+	{ 0x1F04, "Zensys A/S" },
+	{ 0x2004, "Legend Silicon Corp" },
+	{ 0xA104, "Sci-worx GmbH" },
+	{ 0xA204, "SMSC (Standard Microsystems)" },
+	{ 0x2304, "Renesas Electronics" },
+	{ 0xA404, "Raza Microelectronics" },
+	{ 0x2504, "Phyworks" },
+	{ 0x2604, "MediaTek" },
+	{ 0xA704, "Non-cents Productions" },
+	{ 0xA804, "US Modular" },
+	{ 0x2904, "Wintegra Ltd" },
+	{ 0x2A04, "Mathstar" },
+	{ 0xAB04, "StarCore" },
+	{ 0x2C04, "Oplus Technologies" },
+	{ 0xAD04, "Mindspeed" },
+	{ 0xAE04, "Just Young Computer" },
+	{ 0x2F04, "Radia Communications" },
+	{ 0xB004, "OCZ" },
+	{ 0x3104, "Emuzed" },
+	{ 0x3204, "LOGIC Devices" },
+	{ 0xB304, "Inphi Corporation" },
+	{ 0x3404, "Quake Technologies" },
+	{ 0xB504, "Vixe" },
+	{ 0xB604, "SolusTek" },
+	{ 0x3704, "Kongsberg Maritime" },
+	{ 0x3804, "Faraday Technology" },
+	{ 0xB904, "Altium Ltd" },
+	{ 0xBA04, "Insyte" },
+	{ 0x3B04, "ARM Ltd" },
+	{ 0xBC04, "DigiVision" },
+	{ 0x3D04, "Vativ Technologies" },
+	{ 0x3E04, "Endicott Interconnect Technologies" },
+	{ 0xBF04, "Pericom" },
+	{ 0x4004, "Bandspeed" },
+	{ 0xC104, "LeWiz Communications" },
+	{ 0xC204, "CPU Technology" },
+	{ 0x4304, "Ramaxel Technology" },
+	{ 0xC404, "DSP Group" },
+	{ 0x4504, "Axis Communications" },
+	{ 0x4604, "Legacy Electronics" },
+	{ 0xC704, "Chronte" },
+	{ 0xC804, "Powerchip Semiconductor" },
+	{ 0x4904, "MobilEye Technologies" },
+	{ 0x4A04, "Excel Semiconductor" },
+	{ 0xCB04, "A-DATA Technology" },
+	{ 0x4C04, "VirtualDigm" },
+	{ 0xCD04, "G Skill Int" },
+	{ 0xCE04, "Quanta Computer" },
+	{ 0x4F04, "Yield Microelectronics" },
+	{ 0xD004, "Afa Technologies" },
+	{ 0x5104, "KINGBOX Technology Co Ltd" },
+	{ 0x5204, "Ceva" },
+	{ 0xD304, "iStor Networks" },
+	{ 0x5404, "Advance Modules" },
+	{ 0xD504, "Microsoft" },
+	{ 0xD604, "Open-Silicon" },
+	{ 0x5704, "Goal Semiconductor" },
+	{ 0x5804, "ARC Internationa" },
+	{ 0xD904, "Simmtec" },
+	{ 0xDA04, "Metanoia" },
+	{ 0x5B04, "Key Stream" },
+	{ 0xDC04, "Lowrance Electronics" },
+	{ 0x5D04, "Adimos" },
+	{ 0x5E04, "SiGe Semiconductor" },
+	{ 0xDF04, "Fodus Communications" },
+	{ 0xE004, "Credence Systems Corp" },
+	{ 0x6104, "Genesis Microchip Inc" },
+	{ 0x6204, "Vihana Inc" },
+	{ 0xE304, "WIS Technologies" },
+	{ 0x6404, "GateChange Technologies" },
+	{ 0xE504, "High Density Devices AS" },
+	{ 0xE604, "Synopsys" },
+	{ 0x6704, "Gigaram" },
+	{ 0x6804, "Enigma Semiconductor Inc" },
+	{ 0xE904, "Century Micro Inc" },
+	{ 0xEA04, "Icera Semiconductor" },
+	{ 0x6B04, "Mediaworks Integrated Systems" },
+	{ 0xEC04, "O'Neil Product Development" },
+	{ 0x6D04, "Supreme Top Technology Ltd" },
+	{ 0x6E04, "MicroDisplay Corporation" },
+	{ 0xEF04, "Team Group Inc" },
+	{ 0x7004, "Sinett Corporation" },
+	{ 0xF104, "Toshiba Corporation" },
+	{ 0xF204, "Tensilica" },
+	{ 0x7304, "SiRF Technology" },
+	{ 0xF404, "Bacoc Inc" },
+	{ 0x7504, "SMaL Camera Technologies" },
+	{ 0x7604, "Thomson" },
+	{ 0xF704, "Airgo Networks" },
+	{ 0xF804, "Wisair Ltd" },
+	{ 0x7904, "SigmaTe" },
+	{ 0x7A04, "Arkados" },
+	{ 0xFB04, "Compete IT gmbH Co KG" },
+	{ 0x7C04, "Eudar Technology Inc" },
+	{ 0xFD04, "Focus Enhancements" },
+	{ 0xFE04, "Xyratex" },
+	//The following numbers are all in bank six:								
+	{ 0x0185, "Specular Networks" },
+	{ 0x0285, "Patriot Memory (PDP Systems)" },
+	{ 0x8385, "U-Chip Technology Corp" },
+	{ 0x0485, "Silicon Optix" },
+	{ 0x8585, "Greenfield Networks" },
+	{ 0x8685, "CompuRAM GmbH" },
+	{ 0x0785, "Stargen Inc" },
+	{ 0x0885, "NetCell Corporation" },
+	{ 0x8985, "Excalibrus Technologies Ltd" },
+	{ 0x8A85, "SCM Microsystems" },
+	{ 0x0B85, "Xsigo Systems Inc" },
+	{ 0x8C85, "CHIPS & Systems Inc" },
+	{ 0x0D85, "Tier 1 Multichip Solutions" },
+	{ 0x0E85, "CWRL Labs" },
+	{ 0x8F85, "Teradici" },
+	{ 0x1085, "Gigaram Inc" },
+	{ 0x9185, "g2 Microsystems" },
+	{ 0x9285, "PowerFlash Semiconductor" },
+	{ 0x1385, "P.A. Semi Inc" },
+	{ 0x9485, "NovaTech Solutions S.A." },
+	{ 0x1585, "c2 Microsystems Inc" },
+	{ 0x1685, "Level5 Networks" },
+	{ 0x9785, "COS Memory AG" },
+	{ 0x9885, "Innovasic Semiconductor" },
+	{ 0x1985, "02IC Co Ltd" },
+	{ 0x1A85, "Tabula Inc" },
+	{ 0x9B85, "Crucial Technology" },
+	{ 0x1C85, "Chelsio Communications" },
+	{ 0x9D85, "Solarflare Communications" },
+	{ 0x9E85, "Xambala Inc" },
+	{ 0x1F85, "EADS Astrium" },
+	{ 0x2085, "Terra Semiconductor Inc" },
+	{ 0xA185, "Imaging Works Inc" },
+	{ 0xA285, "Astute Networks Inc" },
+	{ 0x2385, "Tzero" },
+	{ 0xA485, "Emulex" },
+	{ 0x2585, "Power-One" },
+	{ 0x2685, "Pulse~LINK Inc" },
+	{ 0xA785, "Hon Hai Precision Industry" },
+	{ 0xA885, "White Rock Networks Inc" },
+	{ 0x2985, "Telegent Systems USA Inc" },
+	{ 0x2A85, "Atrua Technologies Inc" },
+	{ 0xAB85, "Acbel Polytech Inc" },
+	{ 0x2C85, "eRide Inc" },
+	{ 0xAD85, "ULi Electronics Inc" },
+	{ 0xAE85, "Magnum Semiconductor Inc" },
+	{ 0x2F85, "neoOne Technology Inc" },
+	{ 0xB085, "Connex Technology Inc" },
+	{ 0x3185, "Stream Processors Inc" },
+	{ 0x3285, "Focus Enhancements" },
+	{ 0xB385, "Telecis Wireless Inc" },
+	{ 0x3485, "uNav Microelectronics" },
+	{ 0xB585, "Tarari Inc" },
+	{ 0xB685, "Ambric Inc" },
+	{ 0x3785, "Newport Media Inc" },
+	{ 0x3885, "VMTS" },
+	{ 0xB985, "Enuclia Semiconductor Inc" },
+	{ 0xBA85, "Virtium Technology Inc" },
+	{ 0x3B85, "Solid State System Co Ltd" },
+	{ 0xBC85, "Kian Tech LLC" },
+	{ 0x3D85, "Artimi" },
+	{ 0x3E85, "Power Quotient Internationa" },
+	{ 0xBF85, "Avago Technologies" },
+	{ 0x4085, "ADTechnology" },
+	{ 0xC185, "Sigma Designs" },
+	{ 0xC285, "SiCortex Inc" },
+	{ 0x4385, "Ventura Technology Group" },
+	{ 0xC485, "eASIC" },
+	{ 0x4585, "M.H.S. SAS" },
+	{ 0x4685, "Micro Star Internationa" },
+	{ 0xC785, "Rapport Inc" },
+	{ 0xC885, "Makway Internationa" },
+	{ 0x4985, "Broad Reach Engineering Co" },
+	{ 0x4A85, "Semiconductor Mfg Intl Corp" },
+	{ 0xCB85, "SiConnect" },
+	{ 0x4C85, "FCI USA Inc" },
+	{ 0xCD85, "Validity Sensors" },
+	{ 0xCE85, "Coney Technology Co Ltd" },
+	{ 0x4F85, "Spans Logic" },
+	{ 0xD085, "Neterion Inc" },
+	{ 0x5185, "Qimonda" },
+	{ 0x5285, "New Japan Radio Co Ltd" },
+	{ 0xD385, "Velogix" },
+	{ 0x5485, "Montalvo Systems" },
+	{ 0xD585, "iVivity Inc" },
+	{ 0xD685, "Walton Chaintech" },
+	{ 0x5785, "AENEON" },
+	{ 0x5885, "Lorom Industrial Co Ltd" },
+	{ 0xD985, "Radiospire Networks" },
+	{ 0xDA85, "Sensio Technologies Inc" },
+	{ 0x5B85, "Nethra Imaging" },
+	{ 0xDC85, "Hexon Technology Pte Ltd" },
+	{ 0x5D85, "CompuStocx (CSX)" },
+	{ 0x5E85, "Methode Electronics Inc" },
+	{ 0xDF85, "Connect One Ltd" },
+	{ 0xE085, "Opulan Technologies" },
+	{ 0x6185, "Septentrio NV" },
+	{ 0x6285, "Goldenmars Technology Inc" },
+	{ 0xE385, "Kreton Corporation" },
+	{ 0x6485, "Cochlear Ltd" },
+	{ 0xE585, "Altair Semiconductor" },
+	{ 0xE685, "NetEffect Inc" },
+	{ 0x6785, "Spansion Inc" },
+	{ 0x6885, "Taiwan Semiconductor Mfg" },
+	{ 0xE985, "Emphany Systems Inc" },
+	{ 0xEA85, "ApaceWave Technologies" },
+	{ 0x6B85, "Mobilygen Corporation" },
+	{ 0xEC85, "Tego" },
+	{ 0x6D85, "Cswitch Corporation" },
+	{ 0x6E85, "Haier (Beijing) IC Design Co" },
+	{ 0xEF85, "MetaRAM" },
+	{ 0x7085, "Axel Electronics Co Ltd" },
+	{ 0xF185, "Tilera Corporation" },
+	{ 0xF285, "Aquantia" },
+	{ 0x7385, "Vivace Semiconductor" },
+	{ 0xF485, "Redpine Signals" },
+	{ 0x7585, "Octalica" },
+	{ 0x7685, "InterDigital Communications" },
+	{ 0xF785, "Avant Technology" },
+	{ 0xF885, "Asrock Inc" },
+	{ 0x7985, "Availink" },
+	{ 0x7A85, "Quartics Inc" },
+	{ 0xFB85, "Element CXI" },
+	{ 0x7C85, "Innovaciones Microelectronicas" },
+	{ 0xFD85, "VeriSilicon Microelectronics" },
+	{ 0xFE85, "W5 Networks" },
+	//The following numbers are all in bank seven:								
+	{ 0x0186, "MOVEKING" },
+	{ 0x0286, "Mavrix Technology Inc" },
+	{ 0x8386, "CellGuide Ltd" },
+	{ 0x0486, "Faraday Technology" },
+	{ 0x8586, "Diablo Technologies Inc" },
+	{ 0x8686, "Jennic" },
+	{ 0x0786, "Octasic" },
+	{ 0x0886, "Molex Incorporated" },
+	{ 0x8986, "3Leaf Networks" },
+	{ 0x8A86, "Bright Micron Technology" },
+	{ 0x0B86, "Netxen" },
+	{ 0x8C86, "NextWave Broadband Inc" },
+	{ 0x0D86, "DisplayLink" },
+	{ 0x0E86, "ZMOS Technology" },
+	{ 0x8F86, "Tec-Hil" },
+	{ 0x1086, "Multigig Inc" },
+	{ 0x9186, "Amimon" },
+	{ 0x9286, "Euphonic Technologies Inc" },
+	{ 0x1386, "BRN Phoenix" },
+	{ 0x9486, "InSilica" },
+	{ 0x1586, "Ember Corporation" },
+	{ 0x1686, "Avexir Technologies Corporation" },
+	{ 0x9786, "Echelon Corporation" },
+	{ 0x9886, "Edgewater Computer Systems" },
+	{ 0x1986, "XMOS Semiconductor Ltd" },
+	{ 0x1A86, "GENUSION Inc" },
+	{ 0x9B86, "Memory Corp NV" },
+	{ 0x1C86, "SiliconBlue Technologies" },
+	{ 0x9D86, "Rambus Inc" },
+	{ 0x9E86, "Andes Technology Corporation" },
+	{ 0x1F86, "Coronis Systems" },
+	{ 0x2086, "Achronix Semiconductor" },
+	{ 0xA186, "Siano Mobile Silicon Ltd" },
+	{ 0xA286, "Semtech Corporation" },
+	{ 0x2386, "Pixelworks Inc" },
+	{ 0xA486, "Gaisler Research" },
+	{ 0x2586, "Teranetics" },
+	{ 0x2686, "Toppan Printing Co Ltd" },
+	{ 0xA786, "Kingxcon" },
+	{ 0xA886, "Silicon Integrated Systems" },
+	{ 0x2986, "I-O Data Device Inc" },
+	{ 0x2A86, "NDS Americas Inc" },
+	{ 0xAB86, "Solomon Systech Limited" },
+	{ 0x2C86, "On Demand Microelectronics" },
+	{ 0xAD86, "Amicus Wireless Inc" },
+	{ 0xAE86, "SMARDTV SNC" },
+	{ 0x2F86, "Comsys Communication Ltd" },
+	{ 0xB086, "Movidia Ltd" },
+	{ 0x3186, "Javad GNSS Inc" },
+	{ 0x3286, "Montage Technology Group" },
+	{ 0xB386, "Trident Microsystems" },
+	{ 0x3486, "Super Talent" },
+	{ 0xB586, "Optichron Inc" },
+	{ 0xB686, "Future Waves UK Ltd" },
+	{ 0x3786, "SiBEAM Inc" },
+	{ 0x3886, "InicoreInc" },
+	{ 0xB986, "Virident Systems" },
+	{ 0xBA86, "M2000 Inc" },
+	{ 0x3B86, "ZeroG Wireless Inc" },
+	{ 0xBC86, "Gingle Technology Co Ltd" },
+	{ 0x3D86, "Space Micro Inc" },
+	{ 0x3E86, "Wilocity" },
+	{ 0xBF86, "Novafora Inc" },
+	{ 0x4086, "iKoa Corporation" },
+	{ 0xC186, "ASint Technology" },
+	{ 0xC286, "Ramtron" },
+	{ 0x4386, "Plato Networks Inc" },
+	{ 0xC486, "IPtronics AS" },
+	{ 0x4586, "Infinite-Memories" },
+	{ 0x4686, "Parade Technologies Inc" },
+	{ 0xC786, "Dune Networks" },
+	{ 0xC886, "GigaDevice Semiconductor" },
+	{ 0x4986, "Modu Ltd" },
+	{ 0x4A86, "CEITEC" },
+	{ 0xCB86, "Northrop Grumman" },
+	{ 0x4C86, "XRONET Corporation" },
+	{ 0xCD86, "Sicon Semiconductor AB" },
+	{ 0xCE86, "Atla Electronics Co Ltd" },
+	{ 0x4F86, "TOPRAM Technology" },
+	{ 0xD086, "Silego Technology Inc" },
+	{ 0x5186, "Kinglife" },
+	{ 0x5286, "Ability Industries Ltd" },
+	{ 0xD386, "Silicon Power Computer & Communications" },
+	{ 0x5486, "Augusta Technology Inc" },
+	{ 0xD586, "Nantronics Semiconductors" },
+	{ 0xD686, "Hilscher Gesellschaft" },
+	{ 0x5786, "Quixant Ltd" },
+	{ 0x5886, "Percello Ltd" },
+	{ 0xD986, "NextIO Inc" },
+	{ 0xDA86, "Scanimetrics Inc" },
+	{ 0x5B86, "FS-Semi Company Ltd" },
+	{ 0xDC86, "Infinera Corporation" },
+	{ 0x5D86, "SandForce Inc" },
+	{ 0x5E86, "Lexar Media" },
+	{ 0xDF86, "Teradyne Inc" },
+	{ 0xE086, "Memory Exchange Corp" },
+	{ 0x6186, "Suzhou Smartek Electronics" },
+	{ 0x6286, "Avantium Corporation" },
+	{ 0xE386, "ATP Electronics Inc" },
+	{ 0x6486, "Valens Semiconductor Ltd" },
+	{ 0xE586, "Agate Logic Inc" },
+	{ 0xE686, "Netronome" },
+	{ 0x6786, "Zenverge Inc" },
+	{ 0x6886, "N-trig Ltd" },
+	{ 0xE986, "SanMax Technologies Inc" },
+	{ 0xEA86, "Contour Semiconductor Inc" },
+	{ 0x6B86, "TwinMOS" },
+	{ 0xEC86, "Silicon Systems Inc" },
+	{ 0x6D86, "V-Color Technology Inc" },
+	{ 0x6E86, "Certicom Corporation" },
+	{ 0xEF86, "JSC ICC Milandr" },
+	{ 0x7086, "PhotoFast Global Inc" },
+	{ 0xF186, "InnoDisk Corporation" },
+	{ 0xF286, "Muscle Power" },
+	{ 0x7386, "Energy Micro" },
+	{ 0xF486, "Innofidei" },
+	{ 0x7586, "CopperGate Communications" },
+	{ 0x7686, "Holtek Semiconductor Inc" },
+	{ 0xF786, "Myson Century Inc" },
+	{ 0xF886, "FIDELIX" },
+	{ 0x7986, "Red Digital Cinema" },
+	{ 0x7A86, "Densbits Technology" },
+	{ 0xFB86, "Zempro" },
+	{ 0x7C86, "MoSys" },
+	{ 0xFD86, "Provigent" },
+	{ 0xFE86, "Triad Semiconductor Inc" },
+	//The following numbers are all in bank eight:								
+	{ 0x0107, "Siklu Communication Ltd" },
+	{ 0x0207, "A Force Manufacturing Ltd" },
+	{ 0x8307, "Strontium" },
+	{ 0x0407, "ALi Corp (Abilis Systems)" },
+	{ 0x8507, "Siglead Inc" },
+	{ 0x8607, "Ubicom Inc" },
+	{ 0x0707, "Unifosa Corporation" },
+	{ 0x0807, "Stretch Inc" },
+	{ 0x8907, "Lantiq Deutschland GmbH" },
+	{ 0x8A07, "Visipro." },
+	{ 0x0B07, "EKMemory" },
+	{ 0x8C07, "Microelectronics Institute ZTE" },
+	{ 0x0D07, "u-blox AG" },
+	{ 0x0E07, "Carry Technology Co Ltd" },
+	{ 0x8F07, "Nokia" },
+	{ 0x1007, "King Tiger Technology" },
+	{ 0x9107, "Sierra Wireless" },
+	{ 0x9207, "HT Micron" },
+	{ 0x1307, "Albatron Technology Co Ltd" },
+	{ 0x9407, "Leica Geosystems AG" },
+	{ 0x1507, "BroadLight" },
+	{ 0x1607, "AEXEA" },
+	{ 0x9707, "ClariPhy Communications Inc" },
+	{ 0x9807, "Green Plug" },
+	{ 0x1907, "Design Art Networks" },
+	{ 0x1A07, "Mach Xtreme Technology Ltd" },
+	{ 0x9B07, "ATO Solutions Co Ltd" },
+	{ 0x1C07, "Ramsta" },
+	{ 0x9D07, "Greenliant Systems Ltd" },
+	{ 0x9E07, "Teikon" },
+	{ 0x1F07, "Antec Hadron" },
+	{ 0x2007, "NavCom Technology Inc" },
+	{ 0xA107, "Shanghai Fudan Microelectronics" },
+	{ 0xA207, "Calxeda Inc" },
+	{ 0x2307, "JSC EDC Electronics" },
+	{ 0xA407, "Kandit Technology Co Ltd" },
+	{ 0x2507, "Ramos Technology" },
+	{ 0x2607, "Goldenmars Technology" },
+	{ 0xA707, "XeL Technology Inc" },
+	{ 0xA807, "Newzone Corporation" },
+	{ 0x2907, "ShenZhen MercyPower Tech" },
+	{ 0x2A07, "Nanjing Yihuo Technology" },
+	{ 0xAB07, "Nethra Imaging Inc" },
+	{ 0x2C07, "SiTel Semiconductor BV" },
+	{ 0xAD07, "SolidGear Corporation" },
+	{ 0xAE07, "Topower Computer Ind Co Ltd" },
+	{ 0x2F07, "Wilocity" },
+	{ 0xB007, "Profichip GmbH" },
+	{ 0x3107, "Gerad Technologies" },
+	{ 0x3207, "Ritek Corporation" },
+	{ 0xB307, "Gomos Technology Limited" },
+	{ 0x3407, "Memoright Corporation" },
+	{ 0xB507, "D-Broad Inc" },
+	{ 0xB607, "HiSilicon Technologies" },
+	{ 0x3707, "Syndiant Inc." },
+	{ 0x3807, "Enverv Inc" },
+	{ 0xB907, "Cognex" },
+	{ 0xBA07, "Xinnova Technology Inc" },
+	{ 0x3B07, "Ultron AG" },
+	{ 0xBC07, "Concord Idea Corporation" },
+	{ 0x3D07, "AIM Corporation" },
+	{ 0x3E07, "Lifetime Memory Products" },
+	{ 0xBF07, "Ramsway" },
+	{ 0x4007, "Recore Systems B.V." },
+	{ 0xC107, "Haotian Jinshibo Science Tech" },
+	{ 0xC207, "Being Advanced Memory" },
+	{ 0x4307, "Adesto Technologies" },
+	{ 0xC407, "Giantec Semiconductor Inc" },
+	{ 0x4507, "HMD Electronics AG" },
+	{ 0x4607, "Gloway International (HK)" },
+	{ 0xC707, "Kingcore" },
+	{ 0xC807, "Anucell Technology Holding" },
+	{ 0x4907, "Accord Software & Systems Pvt. Ltd" },
+	{ 0x4A07, "Active-Semi Inc" },
+	{ 0xCB07, "Denso Corporation" },
+	{ 0x4C07, "TLSI Inc" },
+	{ 0xCD07, "Qidan" },
+	{ 0xCE07, "Mustang" },
+	{ 0x4F07, "Orca Systems" },
+	{ 0xD007, "Passif Semiconductor" },
+	{ 0x5107, "GigaDevice Semiconductor (Beijing) Inc" },
+	{ 0x5207, "Memphis Electronic" },
+	{ 0xD307, "Beckhoff Automation GmbH" },
+	{ 0x5407, "Harmony Semiconductor Corp" },
+	{ 0xD507, "Air Computers SR" },
+	{ 0xD607, "TMT Memory" },
+	{ 0x5707, "Eorex Corporation" },
+	{ 0x5807, "Xingtera" },
+	{ 0xD907, "Netso" },
+	{ 0xDA07, "Bestdon Technology Co Ltd" },
+	{ 0x5B07, "Baysand Inc" },
+	{ 0xDC07, "Uroad Technology Co Ltd" },
+	{ 0x5D07, "Wilk Elektronik S.A." },
+	{ 0x5E07, "AAI" },
+	{ 0xDF07, "Harman" },
+	{ 0xE007, "Berg Microelectronics Inc" },
+	{ 0x6107, "ASSIA Inc" },
+	{ 0x6207, "Visiontek Products LLC" },
+	{ 0xE307, "OCMEMORY" },
+	{ 0x6407, "Welink Solution Inc" },
+	{ 0xE507, "Shark Gaming" },
+	{ 0xE607, "Avalanche Technology" },
+	{ 0x6707, "R&D Center ELVEES OJSC" },
+	{ 0x6807, "KingboMars Technology Co Ltd" },
+	{ 0xE907, "High Bridge Solutions Industria	Eletronica" },
+	{ 0xEA07, "Transcend Technology Co Ltd" },
+	{ 0x6B07, "Everspin Technologies" },
+	{ 0xEC07, "Hon-Hai Precision" },
+	{ 0x6D07, "Smart Storage Systems" },
+	{ 0x6E07, "Toumaz Group" },
+	{ 0xEF07, "Zentel Electronics Corporation" },
+	{ 0x7007, "Panram International Corporation" },
+	{ 0xF107, "Silicon Space Technology" },
+	{ 0xF207, "LITE-ON IT Corporation" },
+	{ 0x7307, "Inuitive" },
+	{ 0xF407, "HMicro" },
+	{ 0x7507, "BittWare Inc" },
+	{ 0x7607, "GLOBALFOUNDRIES" },
+	{ 0xF707, "ACPI Digital Co Ltd" },
+	{ 0xF807, "Annapurna Labs" },
+	{ 0x7907, "AcSiP Technology Corporation" },
+	{ 0x7A07, "Idea! Electronic Systems" },
+	{ 0xFB07, "Gowe Technology Co Ltd" },
+	{ 0x7C07, "Hermes Testing Solutions Inc" },
+	{ 0xFD07, "Positivo BGH" },
+	{ 0xFE07, "Intelligence Silicon Technology" },
+	//The following numbers are all in bank nine:								
+	{ 0x0108, "3D PLUS" },
+	{ 0x0208, "Diehl Aerospace" },
+	{ 0x8308, "Fairchild" },
+	{ 0x0408, "Mercury Systems" },
+	{ 0x8508, "Sonics Inc" },
+	{ 0x8608, "ICC Intelligent Platforms GmbH" },
+	{ 0x0708, "Shenzhen Jinge Information Co Ltd" },
+	{ 0x0808, "SCWW" },
+	{ 0x8908, "Silicon Motion Inc" },
+	{ 0x8A08, "Anurag" },
+	{ 0x0B08, "King Kong" },
+	{ 0x8C08, "FROM30 Co Ltd" },
+	{ 0x0D08, "Gowin Semiconductor Corp" },
+	{ 0x0E08, "Fremont Micro Devices Ltd" },
+	{ 0x8F08, "Ericsson Modems" },
+	{ 0x1008, "Exelis" },
+	{ 0x9108, "Satixfy Ltd" },
+	{ 0x9208, "Galaxy Microsystems Ltd" },
+	{ 0x1308, "Gloway International Co Ltd" },
+	{ 0x9408, "Lab" },
+	{ 0x1508, "Smart Energy Instruments" },
+	{ 0x1608, "Approved Memory Corporation" },
+	{ 0x9708, "Axell Corporation" },
+	{ 0x9808, "Essencore Limited" },
+	{ 0x1908, "Phytium" },
+	{ 0x1A08, "Xi'an UniIC Semiconductors Co Ltd" },
+	{ 0x9B08, "Ambiq Micro" },
+	{ 0x1C08, "eveRAM Technology Inc" },
+	{ 0x9D08, "Infomax" },
+	{ 0x9E08, "Butterfly Network Inc" },
+	{ 0x1F08, "Shenzhen City Gcai Electronics" },
+	{ 0x2008, "Stack Devices Corporation" },
+	{ 0xA108, "ADK Media Group" },
+	{ 0xA208, "TSP Global Co Ltd" },
+	{ 0x2308, "HighX" },
+	{ 0xA408, "Shenzhen Elicks Technology" },
+	{ 0x2508, "ISSI/Chingis" },
+	{ 0x2608, "Google Inc" },
+	{ 0xA708, "Dasima International Development" },
+	{ 0xA808, "Leahkinn Technology Limited" },
+	{ 0x2908, "HIMA Paul Hildebrandt GmbH Co KG" },
+	{ 0x2A08, "Keysight Technologies" },
+	{ 0xAB08, "Techcomp International (Fastable)" },
+	{ 0x2C08, "Ancore Technology Corporation" },
+	{ 0xAD08, "Nuvoton" },
+	{ 0xAE08, "Korea Uhbele International Group Ltd" },
+	{ 0x2F08, "Ikegami Tsushinki Co Ltd" },
+	{ 0xB008, "RelChip Inc" },
+	{ 0x3108, "Baikal Electronics" },
+	{ 0x3208, "Nemostech Inc" },
+	{ 0xB308, "Memorysolution GmbH" },
+	{ 0x3408, "Silicon Integrated Systems Corporation" },
+	{ 0xB508, "Xiede" },
+	{ 0xB608, "BRC" },
+	{ 0x3708, "Flash Chi" },
+	{ 0x3808, "Jone" },
+	{ 0xB908, "GCT Semiconductor Inc" },
+	{ 0xBA08, "Hong Kong Zetta Device Technology" },
+	{ 0x3B08, "Unimemory Technology(s) Pte Ltd" },
+	{ 0xBC08, "Cuso" },
+	{ 0x3D08, "Kuso" },
+	{ 0x3E08, "Uniquify Inc" },
+	{ 0xBF08, "Skymedi Corporation" },
+	{ 0x4008, "Core Chance Co Ltd" },
+	{ 0xC108, "Tekism Co Ltd" },
+	{ 0xC208, "Seagate Technology PLC" },
+	{ 0x4308, "Hong Kong Gaia Group Co Limited" },
+	{ 0xC408, "Gigacom Semiconductor LLC" },
+	{ 0x4508, "V2 Technologies" },
+	{ 0x4608, "TLi" },
+	{ 0xC708, "Neotion" },
+	{ 0xC808, "Lenovo" },
+	{ 0x4908, "Shenzhen Zhongteng Electronic Corp Ltd" },
+	{ 0x4A08, "Compound Photonics" },
+	{ 0xCB08, "in2H2 inc" },
+	{ 0x4C08, "Shenzhen Pango Microsystems Co Ltd" },
+	{ 0xCD08, "Vasekey" },
+	{ 0xCE08, "Cal-Comp Industria de	Semicondutores" },
+	{ 0x4F08, "Eyenix Co Ltd" },
+	{ 0xD008, "Heoriady" },
+	{ 0x5108, "Accelerated Memory Production Inc" },
+	{ 0x5208, "INVECAS Inc" },
+	{ 0xD308, "AP Memory" },
+	{ 0x5408, "Douqi Technology" },
+	{ 0xD508, "Etron Technology Inc" },
+	{ 0xD608, "Indie Semiconductor" },
+	{ 0x5708, "Socionext Inc" },
+	{ 0x5808, "HGST" },
+	{ 0xD908, "EVGA" },
+	{ 0xDA08, "Audience Inc" },
+	{ 0x5B08, "EpicGear" },
+	{ 0xDC08, "Vitesse Enterprise Co" },
+	{ 0x5D08, "Foxtronn International Corporation" },
+	{ 0x5E08, "Bretelon Inc" },
+	{ 0xDF08, "Graphcore" },
+	{ 0xE008, "Eoplex Inc" },
+	{ 0x6108, "MaxLinear Inc" },
+	{ 0x6208, "ETA Devices" },
+	{ 0xE308, "LOKI" },
+	{ 0x6408, "IMS Electronics Co Ltd" },
+	{ 0xE508, "Dosilicon Co Ltd" },
+	{ 0xE608, "Dolphin Integration" },
+	{ 0x6708, "Shenzhen Mic Electronics Technolog" },
+	{ 0x6808, "Boya Microelectronics Inc" },
+	{ 0xE908, "Geniachip (Roche)" },
+	{ 0xEA08, "Axign" },
+	{ 0x6B08, "Kingred Electronic Technology Ltd" },
+	{ 0xEC08, "Chao Yue Zhuo Computer Business Dept." },
+	{ 0x6D08, "Guangzhou Si Nuo Electronic	Technology." },
+	{ 0x6E08, "Crocus Technology Inc" },
+	{ 0xEF08, "Creative Chips GmbH" },
+	{ 0x7008, "GE Aviation Systems LLC." },
+	{ 0xF108, "Asgard" },
+	{ 0xF208, "Good Wealth Technology Ltd" },
+	{ 0x7308, "TriCor Technologies" },
+	{ 0xF408, "Nova-Systems GmbH" },
+	{ 0x7508, "JUHOR" },
+	{ 0x7608, "Zhuhai Douke Commerce Co Ltd" },
+	{ 0xF708, "DSL Memory" },
+	{ 0xF808, "Anvo-Systems Dresden GmbH" },
+	{ 0x7908, "Realtek" },
+	{ 0x7A08, "AltoBeam" },
+	{ 0xFB08, "Wave Computing" },
+	{ 0x7C08, "Beijing TrustNet Technology Co Ltd" },
+	{ 0xFD08, "Innovium Inc" },
+	{ 0xFE08, "Starsway Technology Limited" },
+	//The following numbers are all in bank 10:									
+	{ 0x0189, "Weltronics Co LTD" },
+	{ 0x0289, "VMware Inc" },
+	{ 0x8389, "Hewlett Packard Enterprise" },
+	{ 0x0489, "INTENSO" },
+	{ 0x8589, "Puya Semiconductor" },
+	{ 0x8689, "MEMORFI" },
+	{ 0x0789, "MSC Technologies GmbH" },
+	{ 0x0889, "Txrui" },
+	{ 0x8989, "SiFive Inc" },
+	{ 0x8A89, "Spreadtrum Communications" },
+	{ 0x0B89, "XTX Technology Limited" },
+	{ 0x8C89, "UMAX Technology" },
+	{ 0x0D89, "Shenzhen Yong Sheng Technology" },
+	{ 0x0E89, "SNOAMOO (Shenzhen Kai Zhuo Yue)" },
+	{ 0x8F89, "Daten Tecnologia LTDA" },
+	{ 0x1089, "Shenzhen XinRuiYan Electronics" },
+	{ 0x9189, "Eta Compute" },
+	{ 0x9289, "Energous" },
+	{ 0x1389, "Raspberry Pi Trading Ltd" },
+	{ 0x9489, "Shenzhen Chixingzhe Tech Co Ltd" },
+	{ 0x1589, "Silicon Mobility" },
+	{ 0x1689, "IQ-Analog Corporation" },
+	{ 0x9789, "Uhnder Inc" },
+	{ 0x9889, "Impinj" },
+	{ 0x1989, "DEPO Computers" },
+	{ 0x1A89, "Nespeed Sysems" },
+	{ 0x9B89, "Yangtze Memory Technologies Co Ltd" },
+	{ 0x1C89, "MemxPro Inc" },
+	{ 0x9D89, "Tammuz Co Ltd" },
+	{ 0x9E89, "Allwinner Technology" },
+	{ 0x1F89, "Shenzhen City Futian District Qing Xuan Tong Computer Trading Firm" },
+	{ 0x2089, "XMC" },
+	{ 0xA189, "Teclast" },
+	{ 0xA289, "Maxsun" },
+	{ 0x2389, "Haiguang Integrated Circuit Design" },
+	{ 0xA489, "RamCENTER Technology" },
+	{ 0x2589, "Phison Electronics Corporation" },
+	{ 0x2689, "Guizhou Huaxintong Semi-Conductor" },
+	{ 0xA789, "Network Intelligence" },
+	{ 0xA889, "Continental Technology (Holdings)" },
+	{ 0x2989, "Guangzhou Huayan Suning Electronic" },
+	{ 0x2A89, "Guangzhou Zhouji Electronic Co Ltd" },
+	{ 0xAB89, "Shenzhen Giant Hui Kang Tech Co Ltd" },
+	{ 0x2C89, "Shenzhen Yilong Innovative Co Ltd" },
+	{ 0xAD89, "Neo Forza" },
+	{ 0xAE89, "Lyontek Inc" },
+	{ 0x2F89, "Shanghai Kuxin Microelectronics Ltd" },
+	{ 0xB089, "Shenzhen Larix Technology Co Ltd" },
+	{ 0x3189, "Qbit Semiconductor Ltd" },
+	{ 0x3289, "Insignis Technology Corporation" },
+	{ 0xB389, "Lanson Memory Co Ltd" },
+	{ 0x3489, "Shenzhen Superway Electronics Co Ltd" },
+	{ 0xB589, "Canaan-Creative Co Ltd" },
+	{ 0xB689, "Black Diamond Memory" },
+	{ 0x3789, "Shenzhen City Parker Baking Electronics" },
+	{ 0x3889, "Shenzhen Baihong Technology Co Ltd" },
+	{ 0xB989, "GEO Semiconductors" },
+	{ 0xBA89, "OCPC" },
+	{ 0x3B89, "Artery Technology Co Ltd" },
+	{ 0xBC89, "Jinyu" },
+	{ 0x3D89, "ShenzhenYing Chi Technology Development" },
+	{ 0x3E89, "Shenzhen Pengcheng Xin Technology" },
+	{ 0xBF89, "Pegasus Semiconductor (Shanghai) Co" },
+	{ 0x4089, "Mythic Inc" },
+	{ 0xC189, "Elmos Semiconductor AG" },
+	{ 0xC289, "Kllisre" },
+	{ 0x4389, "Shenzhen Winconway Technology" },
+	{ 0xC489, "Shenzhen Xingmem Technology Corp" },
+	{ 0x4589, "Gold Key Technology Co Ltd" },
+	{ 0x4689, "Habana Labs Ltd" },
+	{ 0xC789, "Hoodisk Electronics Co Ltd" },
+	{ 0xC889, "SemsoTai (SZ) Technology Co Ltd" },
+	{ 0x4989, "OM Nanotech Pvt. Ltd" },
+	{ 0x4A89, "Shenzhen Zhifeng Weiye Technology" },
+	{ 0xCB89, "Xinshirui (Shenzhen) Electronics Co" },
+	{ 0x4C89, "Guangzhou Zhong Hao Tian Electronic" },
+	{ 0xCD89, "Shenzhen Longsys Electronics Co Ltd" },
+	{ 0xCE89, "Deciso B.V." },
+	{ 0x4F89, "Puya Semiconductor (Shenzhen)" },
+	{ 0xD089, "Shenzhen Veineda Technology Co Ltd" },
+	{ 0x5189, "Antec Memory" },
+	{ 0x5289, "Cortus SAS" },
+	{ 0xD389, "Dust Leopard" },
+	{ 0x5489, "MyWo AS" },
+	{ 0xD589, "J&A Information Inc" },
+	{ 0xD689, "Shenzhen JIEPEI Technology Co Ltd" },
+	{ 0x5789, "Heidelberg University" },
+	{ 0x5889, "Flexxon PTE Ltd" },
+	{ 0xD989, "Wiliot" },
+	{ 0xDA89, "Raysun Electronics International Ltd" },
+	{ 0x5B89, "Aquarius Production Company LLC" },
+	{ 0xDC89, "MACNICA DHW LTDA" },
+	{ 0x5D89, "Intelimem" },
+	{ 0x5E89, "Zbit Semiconductor Inc" },
+	{ 0xDF89, "Shenzhen Technology Co Ltd" },
+	{ 0xE089, "Signalchip" },
+	{ 0x6189, "Shenzen Recadata Storage Technology" },
+	{ 0x6289, "Hyundai Technology" },
+	{ 0xE389, "Shanghai Fudi Investment Development" },
+	{ 0x6489, "Aixi Technology" },
+	{ 0xE589, "Tecon MT" },
+	{ 0xE689, "Onda Electric Co Ltd" },
+	{ 0x6789, "Jinshen" },
+	{ 0x6889, "Kimtigo Semiconductor (HK) Limited" },
+	{ 0xE989, "IIT Madras" },
+	{ 0xEA89, "Shenshan (Shenzhen) Electronic" },
+	{ 0x6B89, "Hefei Core Storage Electronic Limited" },
+	{ 0xEC89, "Colorful Technology Ltd" },
+	{ 0x6D89, "Visenta (Xiamen) Technology Co Ltd" },
+	{ 0x6E89, "Roa Logic BV" },
+	{ 0xEF89, "NSITEXE Inc" },
+	{ 0x7089, "Hong Kong Hyunion Electronics" },
+	{ 0xF189, "ASK Technology Group Limited" },
+	{ 0xF289, "GIGA-BYTE Technology Co Ltd" },
+	{ 0x7389, "Terabyte Co Ltd" },
+	{ 0xF489, "Hyundai Inc" },
+	{ 0x7589, "EXCELERAM" },
+	{ 0x7689, "PsiKick" },
+	{ 0xF789, "Netac Technology Co Ltd" },
+	{ 0xF889, "PCCOOLER" },
+	{ 0x7989, "Jiangsu Huacun Electronic Technology" },
+	{ 0x7A89, "Shenzhen Micro Innovation Industry" },
+	{ 0xFB89, "Beijing Tongfang Microelectronics Co" },
+	{ 0x7C89, "XZN Storage Technology" },
+	{ 0xFD89, "ChipCraft Sp. z.o.o." },
+	{ 0xFE89, "ALLFLASH Technology Limited" },
+	//The following numbers are all in bank 11:									
+	{ 0x018A, "Foerd Technology Co Ltd" },
+	{ 0x028A, "KingSpec" },
+	{ 0x838A, "Codasip GmbH" },
+	{ 0x048A, "SL Link Co Ltd" },
+	{ 0x858A, "Shenzhen Kefu Technology Co Limited" },
+	{ 0x868A, "Shenzhen ZST Electronics Technology" },
+	{ 0x078A, "Kyokuto Electronic Inc" },
+	{ 0x088A, "Warrior Technology" },
+	{ 0x898A, "TRINAMIC Motion Control GmbH & Co" },
+	{ 0x8A8A, "PixelDisplay Inc" },
+	{ 0x0B8A, "Shenzhen Futian District Bo Yueda Elec" },
+	{ 0x8C8A, "Richtek Power" },
+	{ 0x0D8A, "Shenzhen LianTeng Electronics Co Ltd" },
+	{ 0x0E8A, "AITC Memory" },
+	{ 0x8F8A, "UNIC Memory Technology Co Ltd" },
+	{ 0x108A, "Shenzhen Huafeng Science Technology" },
+	{ 0x918A, "ChangXin Memory Technologies Inc" },
+	{ 0x928A, "Guangzhou Xinyi Heng Computer Trading Firm" },
+	{ 0x138A, "SambaNova Systems" },
+	{ 0x948A, "V-GEN" },
+	{ 0x158A, "Jump Trading" },
+	{ 0x168A, "Ampere Computing" },
+	{ 0x978A, "Shenzhen Zhongshi Technology Co Ltd" },
+	{ 0x988A, "Shenzhen Zhongtian Bozhong Technology" },
+	{ 0x198A, "Tri-Tech Internationa" },
+	{ 0x1A8A, "Silicon Intergrated Systems Corporation" },
+	{ 0x9B8A, "Shenzhen HongDingChen Information" },
+	{ 0x1C8A, "Plexton Holdings Limited" },
+	{ 0x9D8A, "AMS (Jiangsu Advanced Memory Semi)" },
+	{ 0x9E8A, "Wuhan Jing Tian Interconnected Tech Co" },
+	{ 0x1F8A, "Axia Memory Technology" },
+	{ 0x208A, "Chipset Technology Holding Limited" },
+	{ 0xA18A, "Shenzhen Xinshida Technology Co Ltd" },
+	{ 0xA28A, "Shenzhen Chuangshifeida Technology" },
+	{ 0x238A, "Guangzhou MiaoYuanJi Technology" },
+	{ 0xA48A, "ADVAN Inc" },
+	{ 0x258A, "Shenzhen Qianhai Weishengda Electronic Commerce Company Ltd" },
+	{ 0x268A, "Guangzhou Guang Xie Cheng Trading" },
+	{ 0xA78A, "StarRam International Co Ltd" },
+	{ 0xA88A, "Shen Zhen XinShenHua Tech Co Ltd" },
+	{ 0x298A, "UltraMemory Inc" },
+	{ 0x2A8A, "New Coastline Global Tech Industry Co" },
+	{ 0xAB8A, "Sinker" },
+	{ 0x2C8A, "Diamond" },
+	{ 0xAD8A, "PUSKIL" },
+	{ 0xAE8A, "Guangzhou Hao Jia Ye Technology Co" },
+	{ 0x2F8A, "Ming Xin Limited" },
+	{ 0xB08A, "Barefoot Networks" },
+	{ 0x318A, "Biwin Semiconductor (HK) Co Ltd" },
+	{ 0x328A, "UD INFO Corporation" },
+	{ 0xB38A, "Trek Technology (S) PTE Ltd" },
+	{ 0x348A, "Xiamen Kingblaze Technology Co Ltd" },
+	{ 0xB58A, "Shenzhen Lomica Technology Co Ltd" },
+	{ 0xB68A, "Nuclei System Technology Co Ltd" },
+	{ 0x378A, "Wuhan Xun Zhan Electronic Technology" },
+	{ 0x388A, "Shenzhen Ingacom Semiconductor Ltd" },
+	{ 0xB98A, "Zotac Technology Ltd" },
+	{ 0xBA8A, "Foxline" },
+	{ 0x3B8A, "Shenzhen Farasia Science Technology" },
+	{ 0xBC8A, "Efinix Inc" },
+	{ 0x3D8A, "Hua Nan San Xian Technology Co Ltd" },
+	{ 0x3E8A, "Goldtech Electronics Co Ltd" },
+	{ 0xBF8A, "Shanghai Han Rong Microelectronics Co" },
+	{ 0x408A, "Shenzhen Zhongguang Yunhe Trading" },
+	{ 0xC18A, "Smart Shine(QingDao) Microelectronics" },
+	{ 0xC28A, "Thermaltake Technology Co Ltd" },
+	{ 0x438A, "Shenzhen O'Yang Maile Technology Ltd" },
+	{ 0xC48A, "UPMEM" },
+	{ 0x458A, "Chun Well Technology Holding Limited" },
+	{ 0x468A, "Astera Labs Inc" },
+	{ 0xC78A, "VMEMORY Co Ltd" },
+	{ 0xC88A, "Advantech Co Ltd" },
+	{ 0x498A, "Chengdu Fengcai Electronic Technology" },
+	{ 0x4A8A, "The Boeing Company" },
+	{ 0xCB8A, "ThinCI Inc" },
+	{ 0x4C8A, "Ramonster Technology Co Ltd" },
+	{ 0xCD8A, "Wuhan Naonongmai Technology Co Ltd" },
+	{ 0xCE8A, "Shenzhen Hui ShingTong Technology" },
+	{ 0x4F8A, "Yourlyon" },
+	{ 0xD08A, "Fabu Technology" },
+	{ 0x518A, "Shenzhen Yikesheng Technology Co Ltd" },
+	{ 0x528A, "NOR-MEM" },
+	{ 0xD38A, "Cervoz Co Ltd" },
+	{ 0x548A, "Bitmain Technologies Inc." },
+	{ 0xD58A, "Facebook Inc" },
+	{ 0xD68A, "Shenzhen Longsys Electronics Co Ltd" },
+	{ 0x578A, "Guangzhou Siye Electronic Technology" },
+	{ 0x588A, "Silergy" },
+	{ 0xD98A, "Adamway" },
+	{ 0xDA8A, "PZG" },
+	{ 0x5B8A, "Shenzhen King Power Electronics" },
+	{ 0xDC8A, "Guangzhou ZiaoFu Tranding Co Ltd" },
+	{ 0x5D8A, "Shenzhen SKIHOTAR Semiconductor" },
+	{ 0x5E8A, "PulseRain Technology" },
+	{ 0xDF8A, "Seeker Technology Limited" },
+	{ 0xE08A, "Shenzhen OSCOO Tech Co Ltd" },
+	{ 0x618A, "Shenzhen Yze Technology Co Ltd" },
+	{ 0x628A, "Shenzhen Jieshuo Electronic Commerce" },
+	{ 0xE38A, "Gazda" },
+	{ 0x648A, "Hua Wei Technology Co Ltd" },
+	{ 0xE58A, "Esperanto Technologies" },
+	{ 0xE68A, "JinSheng Electronic (Shenzhen) Co Ltd" },
+	{ 0x678A, "Shenzhen Shi Bolunshuai Technology" },
+	{ 0x688A, "Shanghai Rei Zuan Information Tech" },
+	{ 0xE98A, "Fraunhofer IIS" },
+	{ 0xEA8A, "Kandou Bus SA" },
+	{ 0x6B8A, "Acer" },
+	{ 0xEC8A, "Artmem Technology Co Ltd" },
+	{ 0x6D8A, "Gstar Semiconductor Co Ltd" },
+	{ 0x6E8A, "ShineDisk" },
+	{ 0xEF8A, "Shenzhen CHN Technology Co Ltd" },
+	{ 0x708A, "UnionChip Semiconductor Co Ltd" },
+	{ 0xF18A, "Tanbassh" },
+	{ 0xF28A, "Shenzhen Tianyu Jieyun Intl Logistics" },
+	{ 0x738A, "MCLogic Inc" },
+	{ 0xF48A, "Eorex Corporation" },
+	{ 0x758A, "Arm Technology (China) Co Ltd" },
+	{ 0x768A, "Lexar Co Limited" },
+	{ 0xF78A, "QinetiQ Group plc" },
+	{ 0xF88A, "Exascend" },
+	{ 0x798A, "Hong Kong Hyunion Electronics Co Ltd" },
+	{ 0x7A8A, "Shenzhen Banghong Electronics Co Ltd" },
+	{ 0xFB8A, "MBit Wireless Inc" },
+	{ 0x7C8A, "Hex Five Security Inc" },
+	{ 0xFD8A, "ShenZhen Juhor Precision Tech Co Ltd" },
+	{ 0xFE8A, "Shenzhen Reeinno Technology Co Ltd" },
+	// The following numbers are all in bank 12:									
+	{ 0x010B, "ABIT Electronics (Shenzhen) Co Ltd" },
+	{ 0x020B, "Semidrive" },
+	{ 0x830B, "MyTek Electronics Corp" },
+	{ 0x040B, "Wxilicon Technology Co Ltd" },
+	{ 0x850B, "Shenzhen Meixin Electronics Ltd" },
+	{ 0x860B, "Ghost Wolf" },
+	{ 0x070B, "LiSion Technologies Inc" },
+	{ 0x080B, "Power Active Co Ltd" },
+	{ 0x890B, "Pioneer High Fidelity Taiwan Co. Ltd" },
+	{ 0x8A0B, "LuoSilk" },
+	{ 0x0B0B, "Shenzhen Chuangshifeida Technology" },
+	{ 0x8C0B, "Black Sesame Technologies Inc" },
+	{ 0x0D0B, "Jiangsu Xinsheng Intelligent Technology" },
+	{ 0x0E0B, "MLOONG" },
+	{ 0x8F0B, "Quadratica LLC" },
+	{ 0x100B, "Anpec Electronics" },
+	{ 0x910B, "Xi'an Morebeck Semiconductor Tech Co" },
+	{ 0x920B, "Kingbank Technology Co Ltd" },
+	{ 0x130B, "ITRenew Inc" },
+	{ 0x940B, "Shenzhen Eaget Innovation Tech Ltd" },
+	{ 0x150B, "Jazer" },
+	{ 0x160B, "Xiamen Semiconductor Investment Group" },
+	{ 0x970B, "Guangzhou Longdao Network Tech Co" }
+};
+
+#define JEP106_COUNT	(sizeof(JEP106_Table) / sizeof(JEP106_Table[0]))
+
+/* Bank, then ID, without the parity bits */
+static constexpr uint32_t JEP106_Key(uint32_t code)
 {
-	typedef struct _JEP106_map {
-		uint32_t index;
-		std::string Name;
-	} JEP106_map;
+	return ((code & 0x7F) << 7) | ((code >> 8) & 0x7F);
+}
+
+/* Halves recursively, so the depth stays within the constexpr limit */
+static constexpr bool JEP106_Sorted(size_t lo, size_t hi)
+{
+	return hi - lo < 2 ||
+		(JEP106_Key(JEP106_Table[lo + (hi - lo) / 2 - 1].index) < JEP106_Key(JEP106_Table[lo + (hi - lo) / 2].index)
+		&& JEP106_Sorted(lo, lo + (hi - lo) / 2) && JEP106_Sorted(lo + (hi - lo) / 2, hi));
+}
+
+static_assert(JEP106_Sorted(0, JEP106_COUNT), "JEP106_Table must stay in bank and ID order");
 
-	const JEP106_map JEP106_Table[] = {
-		{ 0x0180, "AMD" },
-		{ 0x0280, "AMI" },
-		{ 0x8380, "Fairchild" },
-		{ 0x0480, "Fujitsu" },
-		{ 0x8580, "GTE" },
-		{ 0x8680, "Harris" },
-		{ 0x0780, "Hitachi" },
-		{ 0x0880, "Inmos" },
-		{ 0x8980, "Inte" },
-		{ 0x8A80, "I.T.T." },
-		{ 0x0B80, "Intersi" },
-		{ 0x8C80, "Monolithic Memories" },
-		{ 0x0D80, "Mostek" },
-		{ 0x0E80, "Freescale (Motorola)" },
-		{ 0x8F80, "Nationa" },
-		{ 0x1080, "NEC" },
-		{ 0x9180, "RCA" },
-		{ 0x9280, "Raytheon" },
-		{ 0x1380, "Conexant (Rockwell)" },
-		{ 0x9480, "Seeq" },
-		{ 0x1580, "NXP (Philips)" },
-		{ 0x1680, "Synertek" },
-		{ 0x9780, "Texas Instruments" },
-		{ 0x9880, "Toshiba" },
-		{ 0x1980, "Xicor" },
-		{ 0x1A80, "Zilog" },
-		{ 0x9B80, "Eurotechnique" },
-		{ 0x1C80, "Mitsubishi" },
-		{ 0x9D80, "Lucent (AT&T)" },
-		{ 0x9E80, "Exe" },
-		{ 0x1F80, "Atme" },
-		{ 0x2080, "STMicroelectronics" },
-		{ 0xA180, "Lattice Semi." },
-		{ 0xA280, "NCR" },
-		{ 0x2380, "Wafer Scale Integration" },
-		{ 0xA480, "IBM" },
-		{ 0x2580, "Tristar" },
-		{ 0x2680, "Visic" },
-		{ 0xA780, "Intl. CMOS Technology" },
-		{ 0xA880, "SSSI" },
-		{ 0x2980, "MicrochipTechnology" },
-		{ 0x2A80, "Ricoh Ltd" },
-		{ 0xAB80, "VLSI" },
-		{ 0x2C80, "Micron Technology" },
-		{ 0xAD80, "SK Hynix" },
-		{ 0xAE80, "OKI Semiconductor" },
-		{ 0x2F80, "ACTE" },
-		{ 0xB080, "Sharp" },
-		{ 0x3180, "Catalyst" },
-		{ 0x3280, "Panasonic" },
-		{ 0xB380, "IDT" },
-		{ 0x3480, "Cypress" },
-		{ 0xB580, "DEC" },
-		{ 0xB680, "LSI Logic" },
-		{ 0x3780, "Zarlink (Plessey)" },
-		{ 0x3880, "UTMC" },
-		{ 0xB980, "Thinking Machine" },
-		{ 0xBA80, "Thomson CSF" },
-		{ 0x3B80, "Integrated CMOS (Vertex)" },
-		{ 0xBC80, "Honeywel" },
-		{ 0x3D80, "Tektronix" },
-		{ 0x3E80, "Oracle Corporation" },
-		{ 0xBF80, "Silicon Storage Technology" },
-		{ 0x4080, "ProMos/Mosel Vitelic" },
-		{ 0xC180, "Infineon (Siemens)" },
-		{ 0xC280, "Macronix" },
-		{ 0x4380, "Xerox" },
-		{ 0xC480, "Plus Logic" },
-		{ 0x4580, "Western Digital Technologies Inc" },
-		{ 0x4680, "Elan Circuit Tech." },
-		{ 0xC780, "European Silicon Str." },
-		{ 0xC880, "Apple Computer" },
-		{ 0x4980, "Xilinx" },
-		{ 0x4A80, "Compaq" },
-		{ 0xCB80, "Protocol Engines" },
-		{ 0x4C80, "SCI" },
-		{ 0xCD80, "Seiko Instruments" },
-		{ 0xCE80, "Samsung" },
-		{ 0x4F80, "I3 Design System" },
-		{ 0xD080, "Klic" },
-		{ 0x5180, "Crosspoint Solutions" },
-		{ 0x5280, "Alliance Semiconductor" },
-		{ 0xD380, "Tandem" },
-		{ 0x5480, "Hewlett-Packard" },
-		{ 0xD580, "Integrated Silicon Solutions" },
-		{ 0xD680, "Brooktree" },
-		{ 0x5780, "New Media" },
-		{ 0x5880, "MHS Electronic" },
-		{ 0xD980, "Performance Semi." },
-		{ 0xDA80, "Winbond Electronic" },
-		{ 0x5B80, "Kawasaki Stee" },
-		{ 0xDC80, "Bright Micro" },
-		{ 0x5D80, "TECMAR" },
-		{ 0x5E80, "Exar" },
-		{ 0xDF80, "PCMCIA" },
-		{ 0xE080, "LG Semi (Goldstar)" },
-		{ 0x6180, "Northern Telecom" },
-		{ 0x6280, "Sanyo" },
-		{ 0xE380, "Array Microsystems" },
-		{ 0x6480, "Crystal Semiconductor" },
-		{ 0xE580, "Analog Devices" },
-		{ 0xE680, "PMC-Sierra" },
-		{ 0x6780, "Asparix" },
-		{ 0x6880, "Convex Computer" },
-		{ 0xE980, "Quality Semiconductor" },
-		{ 0xEA80, "Nimbus Technology" },
-		{ 0x6B80, "Transwitch" },
-		{ 0xEC80, "Micronas (ITT Intermetall)" },
-		{ 0x6D80, "Cannon" },
-		{ 0x6E80, "Altera" },
-		{ 0xEF80, "NEXCOM" },
-		{ 0x7080, "Qualcomm" },
-		{ 0xF180, "Sony" },
-		{ 0xF280, "Cray Research" },
-		{ 0x7380, "AMS(Austria Micro)" },
-		{ 0xF480, "Vitesse" },
-		{ 0x7580, "Aster Electronics" },
-		{ 0x7680, "Bay Networks (Synoptic)" },
-		{ 0xF780, "Zentrum/ZMD" },
-		{ 0xF880, "TRW" },
-		{ 0x7980, "Thesys" },
-		{ 0x7A80, "Solbourne Computer" },
-		{ 0xFB80, "Allied-Signa" },
-		{ 0x7C80, "Dialog Semiconductor" },
-		{ 0xFD80, "Media Vision" },
-		{ 0xFE80, "Numonyx Corporation" },
-		//The following numbers are all in bank two:								
-		{ 0x0101, "Cirrus Logic" },
-		{ 0x0201, "National Instruments" },
-		{ 0x8301, "ILC Data Device" },
-		{ 0x0401, "Alcatel Mietec" },
-		{ 0x8501, "Micro Linear" },
-		{ 0x8601, "Univ. of NC" },
-		{ 0x0701, "JTAG Technologies" },
-		{ 0x0801, "BAE Systems (Loral)" },
-		{ 0x8901, "Nchip" },
-		{ 0x8A01, "Galileo Tech" },
-		{ 0x0B01, "Bestlink Systems" },
-		{ 0x8C01, "Graychip" },
-		{ 0x0D01, "GENNUM" },
-		{ 0x0E01, "VideoLogic" },
-		{ 0x8F01, "Robert Bosch" },
-		{ 0x1001, "Chip Express" },
-		{ 0x9101, "DATARAM" },
-		{ 0x9201, "United Microelectronics Corp" },
-		{ 0x1301, "TCSI" },
-		{ 0x9401, "Smart Modular" },
-		{ 0x1501, "Hughes Aircraft" },
-		{ 0x1601, "Lanstar Semiconductor" },
-		{ 0x9701, "Qlogic" },
-		{ 0x9801, "Kingston" },
-		{ 0x1901, "Music Semi" },
-		{ 0x1A01, "Ericsson Components" },
-		{ 0x9B01, "SpaSE" },
-		{ 0x1C01, "Eon Silicon Devices" },
-		{ 0x9D01, "Integrated Silicon Solution (ISSI)" },
-		{ 0x9E01, "DoD" },
-		{ 0x1F01, "Integ. Memories Tech." },
-		{ 0x2001, "Corollary Inc" },
-		{ 0xA101, "Dallas Semiconductor" },
-		{ 0xA201, "Omnivision" },
-		{ 0x2301, "EIV(Switzerland)" },
-		{ 0xA401, "Novatel Wireless" },
-		{ 0x2501, "Zarlink (Mitel)" },
-		{ 0x2601, "Clearpoint" },
-		{ 0xA701, "Cabletron" },
-		{ 0xA801, "STEC (Silicon Tech)" },
-		{ 0x2901, "Vanguard" },
-		{ 0x2A01, "Hagiwara Sys-Com" },
-		{ 0xAB01, "Vantis" },
-		{ 0x2C01, "Celestica" },
-		{ 0xAD01, "Century" },
-		{ 0xAE01, "Hal Computers" },
-		{ 0x2F01, "Rohm Company Ltd" },
-		{ 0xB001, "Juniper Networks" },
-		{ 0x3101, "Libit Signal Processing" },
-		{ 0x3201, "Mushkin Enhanced Memory" },
-		{ 0xB301, "Tundra Semiconductor" },
-		{ 0x3401, "Adaptec Inc" },
-		{ 0xB501, "LightSpeed Semi." },
-		{ 0xB601, "ZSP Corp" },
-		{ 0x3701, "AMIC Technology" },
-		{ 0x3801, "Adobe Systems" },
-		{ 0xB901, "Dynachip" },
-		{ 0xBA01, "PNY Technologies Inc" },
-		{ 0x3B01, "Newport Digita" },
-		{ 0xBC01, "MMC Networks" },
-		{ 0x3D01, "T Square" },
-		{ 0x3E01, "Seiko Epson" },
-		{ 0xBF01, "Broadcom" },
-		{ 0x4001, "Viking Components" },
-		{ 0xC101, "V3 Semiconductor" },
-		{ 0xC201, "Flextronics (Orbit Semiconductor)" },
-		{ 0x4301, "Suwa Electronics" },
-		{ 0xC401, "Transmeta" },
-		{ 0x4501, "Micron CMS" },
-		{ 0x4601, "American Computer & Digital Components Inc" },
-		{ 0xC701, "Enhance 3000 Inc" },
-		{ 0xC801, "Tower Semiconductor" },
-		{ 0x4901, "CPU Design" },
-		{ 0x4A01, "Price Point" },
-		{ 0xCB01, "Maxim Integrated Product" },
-		{ 0x4C01, "Tellabs" },
-		{ 0xCD01, "Centaur Technology" },
-		{ 0xCE01, "Unigen Corporation" },
-		{ 0x4F01, "Transcend Information" },
-		{ 0xD001, "Memory Card Technology" },
-		{ 0x5101, "CKD Corporation Ltd" },
-		{ 0x5201, "Capital Instruments" },
-		{ 0xD301, "Aica Kogyo Ltd" },
-		{ 0x5401, "Linvex Technology" },
-		{ 0xD501, "MSC Vertriebs GmbH" },
-		{ 0xD601, "AKM Company Ltd" },
-		{ 0x5701, "Dynamem Inc" },
-		{ 0x5801, "NERA ASA" },
-		{ 0xD901, "GSI Technology" },
-		{ 0xDA01, "Dane-Elec (C Memory)" },
-		{ 0x5B01, "Acorn Computers" },
-		{ 0xDC01, "Lara Technology" },
-		{ 0x5D01, "Oak Technology Inc" },
-		{ 0x5E01, "Itec Memory" },
-		{ 0xDF01, "Tanisys Technology" },
-		{ 0xE001, "Truevision" },
-		{ 0x6101, "Wintec Industries" },
-		{ 0x6201, "Super PC Memory" },
-		{ 0xE301, "MGV Memory" },
-		{ 0x6401, "Galvantech" },
-		{ 0xE501, "Gadzoox Networks" },
-		{ 0xE601, "Multi Dimensional Cons." },
-		{ 0x6701, "GateField" },
-		{ 0x6801, "Integrated Memory System" },
-		{ 0xE901, "Triscend" },
-		{ 0xEA01, "XaQti" },
-		{ 0x6B01, "Goldenram" },
-		{ 0xEC01, "Clear Logic" },
-		{ 0x6D01, "Cimaron Communications" },
-		{ 0x6E01, "Nippon Steel Semi. Corp" },
-		{ 0xEF01, "Advantage Memory" },
-		{ 0x7001, "AMCC" },
-		{ 0xF101, "LeCroy" },
-		{ 0xF201, "Yamaha Corporation" },
-		{ 0x7301, "Digital Microwave" },
-		{ 0xF401, "NetLogic Microsystems" },
-		{ 0x7501, "MIMOS Semiconductor" },
-		{ 0x7601, "Advanced Fibre" },
-		{ 0xF701, "BF Goodrich Data." },
-		{ 0xF801, "Epigram" },
-		{ 0x7901, "Acbel Polytech Inc" },
-		{ 0x7A01, "Apacer Technology" },
-		{ 0xFB01, "Admor Memory" },
-		{ 0x7C01, "FOXCONN" },
-		{ 0xFD01, "Quadratics Superconductor" },
-		{ 0xFE01, "3COM" },
-		//The following numbers are all in bank three:								
-		{ 0x0102, "Camintonn Corporation" },
-		{ 0x0202, "ISOA Incorporated" },
-		{ 0x8302, "Agate Semiconductor" },
-		{ 0x0402, "ADMtek Incorporated" },
-		{ 0x8502, "HYPERTEC" },
-		{ 0x8602, "Adhoc Technologies" },
-		{ 0x0702, "MOSAID Technologies" },
-		{ 0x0802, "Ardent Technologies" },
-		{ 0x8902, "Switchcore" },
-		{ 0x8A02, "Cisco Systems Inc" },
-		{ 0x0B02, "Allayer Technologies" },
-		{ 0x8C02, "WorkX AG (Wichman)" },
-		{ 0x0D02, "Oasis Semiconductor" },
-		{ 0x0E02, "Novanet Semiconductor" },
-		{ 0x8F02, "E-M Solutions" },
-		{ 0x1002, "Power Genera" },
-		{ 0x9102, "Advanced Hardware Arch." },
-		{ 0x9202, "Inova Semiconductors GmbH" },
-		{ 0x1302, "Telocity" },
-		{ 0x9402, "Delkin Devices" },
-		{ 0x1502, "Symagery Microsystems" },
-		{ 0x1602, "C-Port Corporation" },
-		{ 0x9702, "SiberCore Technologies" },
-		{ 0x9802, "Southland Microsystems" },
-		{ 0x1902, "Malleable Technologies" },
-		{ 0x1A02, "Kendin Communications" },
-		{ 0x9B02, "Great Technology Microcomputer" },
-		{ 0x1C02, "Sanmina Corporation" },
-		{ 0x9D02, "HADCO Corporation" },
-		{ 0x9E02, "Corsair" },
-		{ 0x1F02, "Actrans System Inc" },
-		{ 0x2002, "ALPHA Technologies" },
-		{ 0xA102, "Silicon Laboratories Inc (Cygnal)" },
-		{ 0xA202, "Artesyn Technologies" },
-		{ 0x2302, "Align Manufacturing" },
-		{ 0xA402, "Peregrine Semiconductor" },
-		{ 0x2502, "Chameleon Systems" },
-		{ 0x2602, "Aplus Flash Technology" },
-		{ 0xA702, "MIPS Technologies" },
-		{ 0xA802, "Chrysalis ITS" },
-		{ 0x2902, "ADTEC Corporation" },
-		{ 0x2A02, "Kentron Technologies" },
-		{ 0xAB02, "Win Technologies" },
-		{ 0x2C02, "Tezzaron Semiconductor" },
-		{ 0xAD02, "Extreme Packet Devices" },
-		{ 0xAE02, "RF Micro Devices" },
-		{ 0x2F02, "Siemens AG" },
-		{ 0xB002, "Sarnoff Corporation" },
-		{ 0x3102, "Itautec SA" },
-		{ 0x3202, "Radiata Inc" },
-		{ 0xB302, "Benchmark Elect. (AVEX)" },
-		{ 0x3402, "Legend" },
-		{ 0xB502, "SpecTek Incorporated" },
-		{ 0xB602, "Hi/fn" },
-		{ 0x3702, "Enikia Incorporated" },
-		{ 0x3802, "SwitchOn Networks" },
-		{ 0xB902, "AANetcom Incorporated" },
-		{ 0xBA02, "Micro Memory Bank" },
-		{ 0x3B02, "ESS Technology" },
-		{ 0xBC02, "Virata Corporation" },
-		{ 0x3D02, "Excess Bandwidth" },
-		{ 0x3E02, "West Bay Semiconductor" },
-		{ 0xBF02, "DSP Group" },
-		{ 0x4002, "Newport Communications" },
-		{ 0xC102, "Chip2Chip Incorporated" },
-		{ 0xC202, "Phobos Corporation" },
-		{ 0x4302, "Intellitech Corporation" },
-		{ 0xC402, "Nordic VLSI ASA" },
-		{ 0x4502, "Ishoni Networks" },
-		{ 0x4602, "Silicon Spice" },
-		{ 0xC702, "Alchemy Semiconductor" },
-		{ 0xC802, "Agilent Technologies" },
-		{ 0x4902, "Centillium Communications" },
-		{ 0x4A02, "W.L. Gore" },
-		{ 0xCB02, "HanBit Electronics" },
-		{ 0x4C02, "GlobeSpan" },
-		{ 0xCD02, "Element" },
-		{ 0xCE02, "Pycon" },
-		{ 0x4F02, "Saifun Semiconductors" },
-		{ 0xD002, "Sibyte Incorporated" },
-		{ 0x5102, "MetaLink Technologies" },
-		{ 0x5202, "Feiya Technology" },
-		{ 0xD302, "I & C Technology" },
-		{ 0x5402, "Shikatronics" },
-		{ 0xD502, "Elektrobit" },
-		{ 0xD602, "Megic" },
-		{ 0x5702, "Com-Tier" },
-		{ 0x5802, "Malaysia Micro Solutions" },
-		{ 0xD902, "Hyperchip" },
-		{ 0xDA02, "Gemstone Communications" },
-		{ 0x5B02, "Anadigm (Anadyne)" },
-		{ 0xDC02, "3ParData" },
-		{ 0x5D02, "Mellanox Technologies" },
-		{ 0x5E02, "Tenx Technologies" },
-		{ 0xDF02, "Helix AG" },
-		{ 0xE002, "Domosys" },
-		{ 0x6102, "Skyup Technology" },
-		{ 0x6202, "HiNT Corporation" },
-		{ 0xE302, "Chiaro" },
-		{ 0x6402, "MDT Technologies GmbH" },
-		{ 0xE502, "Exbit Technology A/S" },
-		{ 0xE602, "Integrated Technology Express" },
-		{ 0x6702, "AVED Memory" },
-		{ 0x6802, "Legerity" },
-		{ 0xE902, "Jasmine Networks" },
-		{ 0xEA02, "Caspian Networks" },
-		{ 0x6B02, "nCUBE" },
-		{ 0xEC02, "Silicon Access Networks" },
-		{ 0x6D02, "FDK Corporation" },
-		{ 0x6E02, "High Bandwidth Access" },
-		{ 0xEF02, "MultiLink Technology" },
-		{ 0x7002, "BRECIS" },
-		{ 0xF102, "World Wide Packets" },
-		{ 0xF202, "APW" },
-		{ 0x7302, "Chicory Systems" },
-		{ 0xF402, "Xstream Logic" },
-		{ 0x7502, "Fast-Chip" },
-		{ 0x7602, "Zucotto Wireless" },
-		{ 0xF702, "Realchip" },
-		{ 0xF802, "Galaxy Power" },
-		{ 0x7902, "eSilicon" },
-		{ 0x7A02, "Morphics Technology" },
-		{ 0xFB02, "Accelerant Networks" },
-		{ 0x7C02, "Silicon Wave" },
-		{ 0xFD02, "SandCraft" },
-		{ 0xFE02, "Elpida" },
-		//The following numbers are all in bank four:								
-		{ 0x0183, "Solectron" },
-		{ 0x0283, "Optosys Technologies" },
-		{ 0x8383, "Buffalo (Formerly Melco)" },
-		{ 0x0483, "TriMedia Technologies" },
-		{ 0x8583, "Cyan Technologies" },
-		{ 0x8683, "Global Locate" },
-		{ 0x0783, "Optillion" },
-		{ 0x0883, "Terago Communications" },
-		{ 0x8983, "Ikanos Communications" },
-		{ 0x8A83, "Princeton Technology" },
-		{ 0x0B83, "Nanya Technology" },
-		{ 0x8C83, "Elite Flash Storage" },
-		{ 0x0D83, "Mysticom" },
-		{ 0x0E83, "LightSand Communications" },
-		{ 0x8F83, "ATI Technologies" },
-		{ 0x1083, "Agere Systems" },
-		{ 0x9183, "NeoMagic" },
-		{ 0x9283, "AuroraNetics" },
-		{ 0x1383, "Golden Empire" },
-		{ 0x9483, "Mushkin" },
-		{ 0x1583, "Tioga Technologies" },
-		{ 0x1683, "Netlist" },
-		{ 0x9783, "TeraLogic" },
-		{ 0x9883, "Cicada Semiconductor" },
-		{ 0x1983, "Centon Electronics" },
-		{ 0x1A83, "Tyco Electronics" },
-		{ 0x9B83, "Magis Works" },
-		{ 0x1C83, "Zettacom" },
-		{ 0x9D83, "Cogency Semiconductor" },
-		{ 0x9E83, "Chipcon AS" },
-		{ 0x1F83, "Aspex Technology" },
-		{ 0x2083, "F5 Networks" },
-		{ 0xA183, "Programmable Silicon Solutions" },
-		{ 0xA283, "ChipWrights" },
-		{ 0x2383, "Acorn Networks" },
-		{ 0xA483, "Quicklogic" },
-		{ 0x2583, "Kingmax Semiconductor" },
-		{ 0x2683, "BOPS" },
-		{ 0xA783, "Flasys" },
-		{ 0xA883, "BitBlitz Communications" },
-		{ 0x2983, "eMemory Technology" },
-		{ 0x2A83, "Procket Networks" },
-		{ 0xAB83, "Purple Ray" },
-		{ 0x2C83, "Trebia Networks" },
-		{ 0xAD83, "Delta Electronics" },
-		{ 0xAE83, "Onex Communications" },
-		{ 0x2F83, "Ample Communications" },
-		{ 0xB083, "Memory Experts Int" },
-		{ 0x3183, "Astute Networks" },
-		{ 0x3283, "Azanda Network Devices" },
-		{ 0xB383, "Dibcom" },
-		{ 0x3483, "Tekmos" },
-		{ 0xB583, "API NetWorks" },
-		{ 0xB683, "Bay Microsystems" },
-		{ 0x3783, "Firecron Ltd" },
-		{ 0x3883, "Resonext Communications" },
-		{ 0xB983, "Tachys Technologies" },
-		{ 0xBA83, "Equator Technology" },
-		{ 0x3B83, "Concept Computer" },
-		{ 0xBC83, "SILCOM" },
-		{ 0x3D83, "3Dlabs" },
-		{ 0x3E83, "c't Magazine" },
-		{ 0xBF83, "Sanera Systems" },
-		{ 0x4083, "Silicon Packets" },
-		{ 0xC183, "Viasystems Group" },
-		{ 0xC283, "Simtek" },
-		{ 0x4383, "Semicon Devices Singapore" },
-		{ 0xC483, "Satron Handelsges" },
-		{ 0x4583, "Improv Systems" },
-		{ 0x4683, "INDUSYS GmbH" },
-		{ 0xC783, "Corrent" },
-		{ 0xC883, "Infrant Technologies" },
-		{ 0x4983, "Ritek Corp" },
-		{ 0x4A83, "empowerTel Networks" },
-		{ 0xCB83, "Hypertec" },
-		{ 0x4C83, "Cavium Networks" },
-		{ 0xCD83, "PLX Technology" },
-		{ 0xCE83, "Massana Design" },
-		{ 0x4F83, "Intrinsity" },
-		{ 0xD083, "Valence Semiconductor" },
-		{ 0x5183, "Terawave Communications" },
-		{ 0x5283, "IceFyre Semiconductor" },
-		{ 0xD383, "Primarion" },
-		{ 0x5483, "Picochip Designs Ltd" },
-		{ 0xD583, "Silverback Systems" },
-		{ 0xD683, "Jade Star Technologies" },
-		{ 0x5783, "Pijnenburg Securealink" },
-		{ 0x5883, "takeMS - Ultron AG" },
-		{ 0xD983, "Cambridge Silicon Radio" },
-		{ 0xDA83, "Swissbit" },
-		{ 0x5B83, "Nazomi Communications" },
-		{ 0xDC83, "eWave System" },
-		{ 0x5D83, "Rockwell Collins" },
-		{ 0x5E83, "Picocel Co Ltd (Paion)" },
-		{ 0xDF83, "Alphamosaic Ltd" },
-		{ 0xE083, "Sandburst" },
-		{ 0x6183, "SiCon Video" },
-		{ 0x6283, "NanoAmp Solutions" },
-		{ 0xE383, "Ericsson Technology" },
-		{ 0x6483, "PrairieComm" },
-		{ 0xE583, "Mitac Internationa" },
-		{ 0xE683, "Layer N Networks" },
-		{ 0x6783, "MtekVision (Atsana)" },
-		{ 0x6883, "Allegro Networks" },
-		{ 0xE983, "Marvell Semiconductors" },
-		{ 0xEA83, "Netergy Microelectronic" },
-		{ 0x6B83, "NVIDIA" },
-		{ 0xEC83, "Internet Machines" },
-		{ 0x6D83, "Memorysolution GmbH" },
-		{ 0x6E83, "Litchfield Communication" },
-		{ 0xEF83, "Accton Technology" },
-		{ 0x7083, "Teradiant Networks" },
-		{ 0xF183, "Scaleo Chip" },
-		{ 0xF283, "Cortina Systems" },
-		{ 0x7383, "RAM Components" },
-		{ 0xF483, "Raqia Networks" },
-		{ 0x7583, "ClearSpeed" },
-		{ 0x7683, "Matsushita Battery" },
-		{ 0xF783, "Xelerated" },
-		{ 0xF883, "SimpleTech" },
-		{ 0x7983, "Utron Technology" },
-		{ 0x7A83, "Astec Internationa" },
-		{ 0xFB83, "AVM gmbH" },
-		{ 0x7C83, "Redux Communications" },
-		{ 0xFD83, "Dot Hill Systems" },
-		{ 0xFE83, "TeraChip" },
-		//The following numbers are all in bank five:								
-		{ 0x0104, "T-RAM Incorporated" },
-		{ 0x0204, "Innovics Wireless" },
-		{ 0x8304, "Teknovus" },
-		{ 0x0404, "KeyEye Communications" },
-		{ 0x8504, "Runcom Technologies" },
-		{ 0x8604, "RedSwitch" },
-		{ 0x0704, "Dotcast" },
-		{ 0x0804, "Silicon Mountain Memory" },
-		{ 0x8904, "Signia Technologies" },
-		{ 0x8A04, "Pixim" },
-		{ 0x0B04, "Galazar Networks" },
-		{ 0x8C04, "White Electronic Designs" },
-		{ 0x0D04, "Patriot Scientific" },
-		{ 0x0E04, "Neoaxiom Corporation" },
-		{ 0x8F04, "3Y Power Technology" },
-		{ 0x1004, "Scaleo Chip" },
-		{ 0x9104, "Potentia Power Systems" },
-		{ 0x9204, "C-guys Incorporated" },
-		{ 0x1304, "Digital Communications Technology Inc" },
-		{ 0x9404, "Silicon-Based Technology" },
-		{ 0x1504, "Fulcrum Microsystems" },
-		{ 0x1604, "Positivo Informatica Ltd" },
-		{ 0x9704, "XIOtech Corporation" },
-		{ 0x9804, "PortalPlayer" },
-		{ 0x1904, "Zhiying Software" },
-		{ 0x1A04, "ParkerVision Inc" },
-		{ 0x9B04, "Phonex Broadband" },
-		{ 0x1C04, "Skyworks Solutions" },
-		{ 0x9D04, "Entropic Communications" },
-		{ 0x9E04, "I'M Intelligent Memory Ltd" },
-		{ 0x1F04, "Zensys A/S" },
-		{ 0x2004, "Legend Silicon Corp" },
-		{ 0xA104, "Sci-worx GmbH" },
-		{ 0xA204, "SMSC (Standard Microsystems)" },
-		{ 0x2304, "Renesas Electronics" },
-		{ 0xA404, "Raza Microelectronics" },
-		{ 0x2504, "Phyworks" },
-		{ 0x2604, "MediaTek" },
-		{ 0xA704, "Non-cents Productions" },
-		{ 0xA804, "US Modular" },
-		{ 0x2904, "Wintegra Ltd" },
-		{ 0x2A04, "Mathstar" },
-		{ 0xAB04, "StarCore" },
-		{ 0x2C04, "Oplus Technologies" },
-		{ 0xAD04, "Mindspeed" },
-		{ 0xAE04, "Just Young Computer" },
-		{ 0x2F04, "Radia Communications" },
-		{ 0xB004, "OCZ" },
-		{ 0x3104, "Emuzed" },
-		{ 0x3204, "LOGIC Devices" },
-		{ 0xB304, "Inphi Corporation" },
-		{ 0x3404, "Quake Technologies" },
-		{ 0xB504, "Vixe" },
-		{ 0xB604, "SolusTek" },
-		{ 0x3704, "Kongsberg Maritime" },
-		{ 0x3804, "Faraday Technology" },
-		{ 0xB904, "Altium Ltd" },
-		{ 0xBA04, "Insyte" },
-		{ 0x3B04, "ARM Ltd" },
-		{ 0xBC04, "DigiVision" },
-		{ 0x3D04, "Vativ Technologies" },
-		{ 0x3E04, "Endicott Interconnect Technologies" },
-		{ 0xBF04, "Pericom" },
-		{ 0x4004, "Bandspeed" },
-		{ 0xC104, "LeWiz Communications" },
-		{ 0xC204, "CPU Technology" },
-		{ 0x4304, "Ramaxel Technology" },
-		{ 0xC404, "DSP Group" },
-		{ 0x4504, "Axis Communications" },
-		{ 0x4604, "Legacy Electronics" },
-		{ 0xC704, "Chronte" },
-		{ 0xC804, "Powerchip Semiconductor" },
-		{ 0x4904, "MobilEye Technologies" },
-		{ 0x4A04, "Excel Semiconductor" },
-		{ 0xCB04, "A-DATA Technology" },
-		{ 0x4C04, "VirtualDigm" },
-		{ 0xCD04, "G Skill Int" },
-		{ 0xCE04, "Quanta Computer" },
-		{ 0x4F04, "Yield Microelectronics" },
-		{ 0xD004, "Afa Technologies" },
-		{ 0x5104, "KINGBOX Technology Co Ltd" },
-		{ 0x5204, "Ceva" },
-		{ 0xD304, "iStor Networks" },
-		{ 0x5404, "Advance Modules" },
-		{ 0xD504, "Microsoft" },
-		{ 0xD604, "Open-Silicon" },
-		{ 0x5704, "Goal Semiconductor" },
-		{ 0x5804, "ARC Internationa" },
-		{ 0xD904, "Simmtec" },
-		{ 0xDA04, "Metanoia" },
-		{ 0x5B04, "Key Stream" },
-		{ 0xDC04, "Lowrance Electronics" },
-		{ 0x5D04, "Adimos" },
-		{ 0x5E04, "SiGe Semiconductor" },
-		{ 0xDF04, "Fodus Communications" },
-		{ 0xE004, "Credence Systems Corp" },
-		{ 0x6104, "Genesis Microchip Inc" },
-		{ 0x6204, "Vihana Inc" },
-		{ 0xE304, "WIS Technologies" },
-		{ 0x6404, "GateChange Technologies" },
-		{ 0xE504, "High Density Devices AS" },
-		{ 0xE604, "Synopsys" },
-		{ 0x6704, "Gigaram" },
-		{ 0x6804, "Enigma Semiconductor Inc" },
-		{ 0xE904, "Century Micro Inc" },
-		{ 0xEA04, "Icera Semiconductor" },
-		{ 0x6B04, "Mediaworks Integrated Systems" },
-		{ 0xEC04, "O'Neil Product Development" },
-		{ 0x6D04, "Supreme Top Technology Ltd" },
-		{ 0x6E04, "MicroDisplay Corporation" },
-		{ 0xEF04, "Team Group Inc" },
-		{ 0x7004, "Sinett Corporation" },
-		{ 0xF104, "Toshiba Corporation" },
-		{ 0xF204, "Tensilica" },
-		{ 0x7304, "SiRF Technology" },
-		{ 0xF404, "Bacoc Inc" },
-		{ 0x7504, "SMaL Camera Technologies" },
-		{ 0x7604, "Thomson" },
-		{ 0xF704, "Airgo Networks" },
-		{ 0xF804, "Wisair Ltd" },
-		{ 0x7904, "SigmaTe" },
-		{ 0x7A04, "Arkados" },
-		{ 0xFB04, "Compete IT gmbH Co KG" },
-		{ 0x7C04, "Eudar Technology Inc" },
-		{ 0xFD04, "Focus Enhancements" },
-		{ 0xFE04, "Xyratex" },
-		//The following numbers are all in bank six:								
-		{ 0x0185, "Specular Networks" },
-		{ 0x0285, "Patriot Memory (PDP Systems)" },
-		{ 0x8385, "U-Chip Technology Corp" },
-		{ 0x0485, "Silicon Optix" },
-		{ 0x8585, "Greenfield Networks" },
-		{ 0x8685, "CompuRAM GmbH" },
-		{ 0x0785, "Stargen Inc" },
-		{ 0x0885, "NetCell Corporation" },
-		{ 0x8985, "Excalibrus Technologies Ltd" },
-		{ 0x8A85, "SCM Microsystems" },
-		{ 0x0B85, "Xsigo Systems Inc" },
-		{ 0x8C85, "CHIPS & Systems Inc" },
-		{ 0x0D85, "Tier 1 Multichip Solutions" },
-		{ 0x0E85, "CWRL Labs" },
-		{ 0x8F85, "Teradici" },
-		{ 0x1085, "Gigaram Inc" },
-		{ 0x9185, "g2 Microsystems" },
-		{ 0x9285, "PowerFlash Semiconductor" },
-		{ 0x1385, "P.A. Semi Inc" },
-		{ 0x9485, "NovaTech Solutions S.A." },
-		{ 0x1585, "c2 Microsystems Inc" },
-		{ 0x1685, "Level5 Networks" },
-		{ 0x9785, "COS Memory AG" },
-		{ 0x9885, "Innovasic Semiconductor" },
-		{ 0x1985, "02IC Co Ltd" },
-		{ 0x1A85, "Tabula Inc" },
-		{ 0x9B85, "Crucial Technology" },
-		{ 0x1C85, "Chelsio Communications" },
-		{ 0x9D85, "Solarflare Communications" },
-		{ 0x9E85, "Xambala Inc" },
-		{ 0x1F85, "EADS Astrium" },
-		{ 0x2085, "Terra Semiconductor Inc" },
-		{ 0xA185, "Imaging Works Inc" },
-		{ 0xA285, "Astute Networks Inc" },
-		{ 0x2385, "Tzero" },
-		{ 0xA485, "Emulex" },
-		{ 0x2585, "Power-One" },
-		{ 0x2685, "Pulse~LINK Inc" },
-		{ 0xA785, "Hon Hai Precision Industry" },
-		{ 0xA885, "White Rock Networks Inc" },
-		{ 0x2985, "Telegent Systems USA Inc" },
-		{ 0x2A85, "Atrua Technologies Inc" },
-		{ 0xAB85, "Acbel Polytech Inc" },
-		{ 0x2C85, "eRide Inc" },
-		{ 0xAD85, "ULi Electronics Inc" },
-		{ 0xAE85, "Magnum Semiconductor Inc" },
-		{ 0x2F85, "neoOne Technology Inc" },
-		{ 0xB085, "Connex Technology Inc" },
-		{ 0x3185, "Stream Processors Inc" },
-		{ 0x3285, "Focus Enhancements" },
-		{ 0xB385, "Telecis Wireless Inc" },
-		{ 0x3485, "uNav Microelectronics" },
-		{ 0xB585, "Tarari Inc" },
-		{ 0xB685, "Ambric Inc" },
-		{ 0x3785, "Newport Media Inc" },
-		{ 0x3885, "VMTS" },
-		{ 0xB985, "Enuclia Semiconductor Inc" },
-		{ 0xBA85, "Virtium Technology Inc" },
-		{ 0x3B85, "Solid State System Co Ltd" },
-		{ 0xBC85, "Kian Tech LLC" },
-		{ 0x3D85, "Artimi" },
-		{ 0x3E85, "Power Quotient Internationa" },
-		{ 0xBF85, "Avago Technologies" },
-		{ 0x4085, "ADTechnology" },
-		{ 0xC185, "Sigma Designs" },
-		{ 0xC285, "SiCortex Inc" },
-		{ 0x4385, "Ventura Technology Group" },
-		{ 0xC485, "eASIC" },
-		{ 0x4585, "M.H.S. SAS" },
-		{ 0x4685, "Micro Star Internationa" },
-		{ 0xC785, "Rapport Inc" },
-		{ 0xC885, "Makway Internationa" },
-		{ 0x4985, "Broad Reach Engineering Co" },
-		{ 0x4A85, "Semiconductor Mfg Intl Corp" },
-		{ 0xCB85, "SiConnect" },
-		{ 0x4C85, "FCI USA Inc" },
-		{ 0xCD85, "Validity Sensors" },
-		{ 0xCE85, "Coney Technology Co Ltd" },
-		{ 0x4F85, "Spans Logic" },
-		{ 0xD085, "Neterion Inc" },
-		{ 0x5185, "Qimonda" },
-		{ 0x5285, "New Japan Radio Co Ltd" },
-		{ 0xD385, "Velogix" },
-		{ 0x5485, "Montalvo Systems" },
-		{ 0xD585, "iVivity Inc" },
-		{ 0xD685, "Walton Chaintech" },
-		{ 0x5785, "AENEON" },
-		{ 0x5885, "Lorom Industrial Co Ltd" },
-		{ 0xD985, "Radiospire Networks" },
-		{ 0xDA85, "Sensio Technologies Inc" },
-		{ 0x5B85, "Nethra Imaging" },
-		{ 0xDC85, "Hexon Technology Pte Ltd" },
-		{ 0x5D85, "CompuStocx (CSX)" },
-		{ 0x5E85, "Methode Electronics Inc" },
-		{ 0xDF85, "Connect One Ltd" },
-		{ 0xE085, "Opulan Technologies" },
-		{ 0x6185, "Septentrio NV" },
-		{ 0x6285, "Goldenmars Technology Inc" },
-		{ 0xE385, "Kreton Corporation" },
-		{ 0x6485, "Cochlear Ltd" },
-		{ 0xE585, "Altair Semiconductor" },
-		{ 0xE685, "NetEffect Inc" },
-		{ 0x6785, "Spansion Inc" },
-		{ 0x6885, "Taiwan Semiconductor Mfg" },
-		{ 0xE985, "Emphany Systems Inc" },
-		{ 0xEA85, "ApaceWave Technologies" },
-		{ 0x6B85, "Mobilygen Corporation" },
-		{ 0xEC85, "Tego" },
-		{ 0x6D85, "Cswitch Corporation" },
-		{ 0x6E85, "Haier (Beijing) IC Design Co" },
-		{ 0xEF85, "MetaRAM" },
-		{ 0x7085, "Axel Electronics Co Ltd" },
-		{ 0xF185, "Tilera Corporation" },
-		{ 0xF285, "Aquantia" },
-		{ 0x7385, "Vivace Semiconductor" },
-		{ 0xF485, "Redpine Signals" },
-		{ 0x7585, "Octalica" },
-		{ 0x7685, "InterDigital Communications" },
-		{ 0xF785, "Avant Technology" },
-		{ 0xF885, "Asrock Inc" },
-		{ 0x7985, "Availink" },
-		{ 0x7A85, "Quartics Inc" },
-		{ 0xFB85, "Element CXI" },
-		{ 0x7C85, "Innovaciones Microelectronicas" },
-		{ 0xFD85, "VeriSilicon Microelectronics" },
-		{ 0xFE85, "W5 Networks" },
-		//The following numbers are all in bank seven:								
-		{ 0x0186, "MOVEKING" },
-		{ 0x0286, "Mavrix Technology Inc" },
-		{ 0x8386, "CellGuide Ltd" },
-		{ 0x0486, "Faraday Technology" },
-		{ 0x8586, "Diablo Technologies Inc" },
-		{ 0x8686, "Jennic" },
-		{ 0x0786, "Octasic" },
-		{ 0x0886, "Molex Incorporated" },
-		{ 0x8986, "3Leaf Networks" },
-		{ 0x8A86, "Bright Micron Technology" },
-		{ 0x0B86, "Netxen" },
-		{ 0x8C86, "NextWave Broadband Inc" },
-		{ 0x0D86, "DisplayLink" },
-		{ 0x0E86, "ZMOS Technology" },
-		{ 0x8F86, "Tec-Hil" },
-		{ 0x1086, "Multigig Inc" },
-		{ 0x9186, "Amimon" },
-		{ 0x9286, "Euphonic Technologies Inc" },
-		{ 0x1386, "BRN Phoenix" },
-		{ 0x9486, "InSilica" },
-		{ 0x1586, "Ember Corporation" },
-		{ 0x1686, "Avexir Technologies Corporation" },
-		{ 0x9786, "Echelon Corporation" },
-		{ 0x9886, "Edgewater Computer Systems" },
-		{ 0x1986, "XMOS Semiconductor Ltd" },
-		{ 0x1A86, "GENUSION Inc" },
-		{ 0x9B86, "Memory Corp NV" },
-		{ 0x1C86, "SiliconBlue Technologies" },
-		{ 0x9D86, "Rambus Inc" },
-		{ 0x9E86, "Andes Technology Corporation" },
-		{ 0x1F86, "Coronis Systems" },
-		{ 0x2086, "Achronix Semiconductor" },
-		{ 0xA186, "Siano Mobile Silicon Ltd" },
-		{ 0xA286, "Semtech Corporation" },
-		{ 0x2386, "Pixelworks Inc" },
-		{ 0xA486, "Gaisler Research" },
-		{ 0x2586, "Teranetics" },
-		{ 0x2686, "Toppan Printing Co Ltd" },
-		{ 0xA786, "Kingxcon" },
-		{ 0xA886, "Silicon Integrated Systems" },
-		{ 0x2986, "I-O Data Device Inc" },
-		{ 0x2A86, "NDS Americas Inc" },
-		{ 0xAB86, "Solomon Systech Limited" },
-		{ 0x2C86, "On Demand Microelectronics" },
-		{ 0xAD86, "Amicus Wireless Inc" },
-		{ 0xAE86, "SMARDTV SNC" },
-		{ 0x2F86, "Comsys Communication Ltd" },
-		{ 0xB086, "Movidia Ltd" },
-		{ 0x3186, "Javad GNSS Inc" },
-		{ 0x3286, "Montage Technology Group" },
-		{ 0xB386, "Trident Microsystems" },
-		{ 0x3486, "Super Talent" },
-		{ 0xB586, "Optichron Inc" },
-		{ 0xB686, "Future Waves UK Ltd" },
-		{ 0x3786, "SiBEAM Inc" },
-		{ 0x3886, "InicoreInc" },
-		{ 0xB986, "Virident Systems" },
-		{ 0xBA86, "M2000 Inc" },
-		{ 0x3B86, "ZeroG Wireless Inc" },
-		{ 0xBC86, "Gingle Technology Co Ltd" },
-		{ 0x3D86, "Space Micro Inc" },
-		{ 0x3E86, "Wilocity" },
-		{ 0xBF86, "Novafora Inc" },
-		{ 0x4086, "iKoa Corporation" },
-		{ 0xC186, "ASint Technology" },
-		{ 0xC286, "Ramtron" },
-		{ 0x4386, "Plato Networks Inc" },
-		{ 0xC486, "IPtronics AS" },
-		{ 0x4586, "Infinite-Memories" },
-		{ 0x4686, "Parade Technologies Inc" },
-		{ 0xC786, "Dune Networks" },
-		{ 0xC886, "GigaDevice Semiconductor" },
-		{ 0x4986, "Modu Ltd" },
-		{ 0x4A86, "CEITEC" },
-		{ 0xCB86, "Northrop Grumman" },
-		{ 0x4C86, "XRONET Corporation" },
-		{ 0xCD86, "Sicon Semiconductor AB" },
-		{ 0xCE86, "Atla Electronics Co Ltd" },
-		{ 0x4F86, "TOPRAM Technology" },
-		{ 0xD086, "Silego Technology Inc" },
-		{ 0x5186, "Kinglife" },
-		{ 0x5286, "Ability Industries Ltd" },
-		{ 0xD386, "Silicon Power Computer & Communications" },
-		{ 0x5486, "Augusta Technology Inc" },
-		{ 0xD586, "Nantronics Semiconductors" },
-		{ 0xD686, "Hilscher Gesellschaft" },
-		{ 0x5786, "Quixant Ltd" },
-		{ 0x5886, "Percello Ltd" },
-		{ 0xD986, "NextIO Inc" },
-		{ 0xDA86, "Scanimetrics Inc" },
-		{ 0x5B86, "FS-Semi Company Ltd" },
-		{ 0xDC86, "Infinera Corporation" },
-		{ 0x5D86, "SandForce Inc" },
-		{ 0x5E86, "Lexar Media" },
-		{ 0xDF86, "Teradyne Inc" },
-		{ 0xE086, "Memory Exchange Corp" },
-		{ 0x6186, "Suzhou Smartek Electronics" },
-		{ 0x6286, "Avantium Corporation" },
-		{ 0xE386, "ATP Electronics Inc" },
-		{ 0x6486, "Valens Semiconductor Ltd" },
-		{ 0xE586, "Agate Logic Inc" },
-		{ 0xE686, "Netronome" },
-		{ 0x6786, "Zenverge Inc" },
-		{ 0x6886, "N-trig Ltd" },
-		{ 0xE986, "SanMax Technologies Inc" },
-		{ 0xEA86, "Contour Semiconductor Inc" },
-		{ 0x6B86, "TwinMOS" },
-		{ 0xEC86, "Silicon Systems Inc" },
-		{ 0x6D86, "V-Color Technology Inc" },
-		{ 0x6E86, "Certicom Corporation" },
-		{ 0xEF86, "JSC ICC Milandr" },
-		{ 0x7086, "PhotoFast Global Inc" },
-		{ 0xF186, "InnoDisk Corporation" },
-		{ 0xF286, "Muscle Power" },
-		{ 0x7386, "Energy Micro" },
-		{ 0xF486, "Innofidei" },
-		{ 0x7586, "CopperGate Communications" },
-		{ 0x7686, "Holtek Semiconductor Inc" },
-		{ 0xF786, "Myson Century Inc" },
-		{ 0xF886, "FIDELIX" },
-		{ 0x7986, "Red Digital Cinema" },
-		{ 0x7A86, "Densbits Technology" },
-		{ 0xFB86, "Zempro" },
-		{ 0x7C86, "MoSys" },
-		{ 0xFD86, "Provigent" },
-		{ 0xFE86, "Triad Semiconductor Inc" },
-		//The following numbers are all in bank eight:								
-		{ 0x0107, "Siklu Communication Ltd" },
-		{ 0x0207, "A Force Manufacturing Ltd" },
-		{ 0x8307, "Strontium" },
-		{ 0x0407, "ALi Corp (Abilis Systems)" },
-		{ 0x8507, "Siglead Inc" },
-		{ 0x8607, "Ubicom Inc" },
-		{ 0x0707, "Unifosa Corporation" },
-		{ 0x0807, "Stretch Inc" },
-		{ 0x8907, "Lantiq Deutschland GmbH" },
-		{ 0x8A07, "Visipro." },
-		{ 0x0B07, "EKMemory" },
-		{ 0x8C07, "Microelectronics Institute ZTE" },
-		{ 0x0D07, "u-blox AG" },
-		{ 0x0E07, "Carry Technology Co Ltd" },
-		{ 0x8F07, "Nokia" },
-		{ 0x1007, "King Tiger Technology" },
-		{ 0x9107, "Sierra Wireless" },
-		{ 0x9207, "HT Micron" },
-		{ 0x1307, "Albatron Technology Co Ltd" },
-		{ 0x9407, "Leica Geosystems AG" },
-		{ 0x1507, "BroadLight" },
-		{ 0x1607, "AEXEA" },
-		{ 0x9707, "ClariPhy Communications Inc" },
-		{ 0x9807, "Green Plug" },
-		{ 0x1907, "Design Art Networks" },
-		{ 0x1A07, "Mach Xtreme Technology Ltd" },
-		{ 0x9B07, "ATO Solutions Co Ltd" },
-		{ 0x1C07, "Ramsta" },
-		{ 0x9D07, "Greenliant Systems Ltd" },
-		{ 0x9E07, "Teikon" },
-		{ 0x1F07, "Antec Hadron" },
-		{ 0x2007, "NavCom Technology Inc" },
-		{ 0xA107, "Shanghai Fudan Microelectronics" },
-		{ 0xA207, "Calxeda Inc" },
-		{ 0x2307, "JSC EDC Electronics" },
-		{ 0xA407, "Kandit Technology Co Ltd" },
-		{ 0x2507, "Ramos Technology" },
-		{ 0x2607, "Goldenmars Technology" },
-		{ 0xA707, "XeL Technology Inc" },
-		{ 0xA807, "Newzone Corporation" },
-		{ 0x2907, "ShenZhen MercyPower Tech" },
-		{ 0x2A07, "Nanjing Yihuo Technology" },
-		{ 0xAB07, "Nethra Imaging Inc" },
-		{ 0x2C07, "SiTel Semiconductor BV" },
-		{ 0xAD07, "SolidGear Corporation" },
-		{ 0xAE07, "Topower Computer Ind Co Ltd" },
-		{ 0x2F07, "Wilocity" },
-		{ 0xB007, "Profichip GmbH" },
-		{ 0x3107, "Gerad Technologies" },
-		{ 0x3207, "Ritek Corporation" },
-		{ 0xB307, "Gomos Technology Limited" },
-		{ 0x3407, "Memoright Corporation" },
-		{ 0xB507, "D-Broad Inc" },
-		{ 0xB607, "HiSilicon Technologies" },
-		{ 0x3707, "Syndiant Inc." },
-		{ 0x3807, "Enverv Inc" },
-		{ 0xB907, "Cognex" },
-		{ 0xBA07, "Xinnova Technology Inc" },
-		{ 0x3B07, "Ultron AG" },
-		{ 0xBC07, "Concord Idea Corporation" },
-		{ 0x3D07, "AIM Corporation" },
-		{ 0x3E07, "Lifetime Memory Products" },
-		{ 0xBF07, "Ramsway" },
-		{ 0x4007, "Recore Systems B.V." },
-		{ 0xC107, "Haotian Jinshibo Science Tech" },
-		{ 0xC207, "Being Advanced Memory" },
-		{ 0x4307, "Adesto Technologies" },
-		{ 0xC407, "Giantec Semiconductor Inc" },
-		{ 0x4507, "HMD Electronics AG" },
-		{ 0x4607, "Gloway International (HK)" },
-		{ 0xC707, "Kingcore" },
-		{ 0xC807, "Anucell Technology Holding" },
-		{ 0x4907, "Accord Software & Systems Pvt. Ltd" },
-		{ 0x4A07, "Active-Semi Inc" },
-		{ 0xCB07, "Denso Corporation" },
-		{ 0x4C07, "TLSI Inc" },
-		{ 0xCD07, "Qidan" },
-		{ 0xCE07, "Mustang" },
-		{ 0x4F07, "Orca Systems" },
-		{ 0xD007, "Passif Semiconductor" },
-		{ 0x5107, "GigaDevice Semiconductor (Beijing) Inc" },
-		{ 0x5207, "Memphis Electronic" },
-		{ 0xD307, "Beckhoff Automation GmbH" },
-		{ 0x5407, "Harmony Semiconductor Corp" },
-		{ 0xD507, "Air Computers SR" },
-		{ 0xD607, "TMT Memory" },
-		{ 0x5707, "Eorex Corporation" },
-		{ 0x5807, "Xingtera" },
-		{ 0xD907, "Netso" },
-		{ 0xDA07, "Bestdon Technology Co Ltd" },
-		{ 0x5B07, "Baysand Inc" },
-		{ 0xDC07, "Uroad Technology Co Ltd" },
-		{ 0x5D07, "Wilk Elektronik S.A." },
-		{ 0x5E07, "AAI" },
-		{ 0xDF07, "Harman" },
-		{ 0xE007, "Berg Microelectronics Inc" },
-		{ 0x6107, "ASSIA Inc" },
-		{ 0x6207, "Visiontek Products LLC" },
-		{ 0xE307, "OCMEMORY" },
-		{ 0x6407, "Welink Solution Inc" },
-		{ 0xE507, "Shark Gaming" },
-		{ 0xE607, "Avalanche Technology" },
-		{ 0x6707, "R&D Center ELVEES OJSC" },
-		{ 0x6807, "KingboMars Technology Co Ltd" },
-		{ 0xE907, "High Bridge Solutions Industria	Eletronica" },
-		{ 0xEA07, "Transcend Technology Co Ltd" },
-		{ 0x6B07, "Everspin Technologies" },
-		{ 0xEC07, "Hon-Hai Precision" },
-		{ 0x6D07, "Smart Storage Systems" },
-		{ 0x6E07, "Toumaz Group" },
-		{ 0xEF07, "Zentel Electronics Corporation" },
-		{ 0x7007, "Panram International Corporation" },
-		{ 0xF107, "Silicon Space Technology" },
-		{ 0xF207, "LITE-ON IT Corporation" },
-		{ 0x7307, "Inuitive" },
-		{ 0xF407, "HMicro" },
-		{ 0x7507, "BittWare Inc" },
-		{ 0x7607, "GLOBALFOUNDRIES" },
-		{ 0xF707, "ACPI Digital Co Ltd" },
-		{ 0xF807, "Annapurna Labs" },
-		{ 0x7907, "AcSiP Technology Corporation" },
-		{ 0x7A07, "Idea! Electronic Systems" },
-		{ 0xFB07, "Gowe Technology Co Ltd" },
-		{ 0x7C07, "Hermes Testing Solutions Inc" },
-		{ 0xFD07, "Positivo BGH" },
-		{ 0xFE07, "Intelligence Silicon Technology" },
-		//The following numbers are all in bank nine:								
-		{ 0x0108, "3D PLUS" },
-		{ 0x0208, "Diehl Aerospace" },
-		{ 0x8308, "Fairchild" },
-		{ 0x0408, "Mercury Systems" },
-		{ 0x8508, "Sonics Inc" },
-		{ 0x8608, "ICC Intelligent Platforms GmbH" },
-		{ 0x0708, "Shenzhen Jinge Information Co Ltd" },
-		{ 0x0808, "SCWW" },
-		{ 0x8908, "Silicon Motion Inc" },
-		{ 0x8A08, "Anurag" },
-		{ 0x0B08, "King Kong" },
-		{ 0x8C08, "FROM30 Co Ltd" },
-		{ 0x0D08, "Gowin Semiconductor Corp" },
-		{ 0x0E08, "Fremont Micro Devices Ltd" },
-		{ 0x8F08, "Ericsson Modems" },
-		{ 0x1008, "Exelis" },
-		{ 0x9108, "Satixfy Ltd" },
-		{ 0x9208, "Galaxy Microsystems Ltd" },
-		{ 0x1308, "Gloway International Co Ltd" },
-		{ 0x9408, "Lab" },
-		{ 0x1508, "Smart Energy Instruments" },
-		{ 0x1608, "Approved Memory Corporation" },
-		{ 0x9708, "Axell Corporation" },
-		{ 0x9808, "Essencore Limited" },
-		{ 0x1908, "Phytium" },
-		{ 0x1A08, "Xi'an UniIC Semiconductors Co Ltd" },
-		{ 0x9B08, "Ambiq Micro" },
-		{ 0x1C08, "eveRAM Technology Inc" },
-		{ 0x9D08, "Infomax" },
-		{ 0x9E08, "Butterfly Network Inc" },
-		{ 0x1F08, "Shenzhen City Gcai Electronics" },
-		{ 0x2008, "Stack Devices Corporation" },
-		{ 0xA108, "ADK Media Group" },
-		{ 0xA208, "TSP Global Co Ltd" },
-		{ 0x2308, "HighX" },
-		{ 0xA408, "Shenzhen Elicks Technology" },
-		{ 0x2508, "ISSI/Chingis" },
-		{ 0x2608, "Google Inc" },
-		{ 0xA708, "Dasima International Development" },
-		{ 0xA808, "Leahkinn Technology Limited" },
-		{ 0x2908, "HIMA Paul Hildebrandt GmbH Co KG" },
-		{ 0x2A08, "Keysight Technologies" },
-		{ 0xAB08, "Techcomp International (Fastable)" },
-		{ 0x2C08, "Ancore Technology Corporation" },
-		{ 0xAD08, "Nuvoton" },
-		{ 0xAE08, "Korea Uhbele International Group Ltd" },
-		{ 0x2F08, "Ikegami Tsushinki Co Ltd" },
-		{ 0xB008, "RelChip Inc" },
-		{ 0x3108, "Baikal Electronics" },
-		{ 0x3208, "Nemostech Inc" },
-		{ 0xB308, "Memorysolution GmbH" },
-		{ 0x3408, "Silicon Integrated Systems Corporation" },
-		{ 0xB508, "Xiede" },
-		{ 0xB608, "BRC" },
-		{ 0x3708, "Flash Chi" },
-		{ 0x3808, "Jone" },
-		{ 0xB908, "GCT Semiconductor Inc" },
-		{ 0xBA08, "Hong Kong Zetta Device Technology" },
-		{ 0x3B08, "Unimemory Technology(s) Pte Ltd" },
-		{ 0xBC08, "Cuso" },
-		{ 0x3D08, "Kuso" },
-		{ 0x3E08, "Uniquify Inc" },
-		{ 0xBF08, "Skymedi Corporation" },
-		{ 0x4008, "Core Chance Co Ltd" },
-		{ 0xC108, "Tekism Co Ltd" },
-		{ 0xC208, "Seagate Technology PLC" },
-		{ 0x4308, "Hong Kong Gaia Group Co Limited" },
-		{ 0xC408, "Gigacom Semiconductor LLC" },
-		{ 0x4508, "V2 Technologies" },
-		{ 0x4608, "TLi" },
-		{ 0xC708, "Neotion" },
-		{ 0xC808, "Lenovo" },
-		{ 0x4908, "Shenzhen Zhongteng Electronic Corp Ltd" },
-		{ 0x4A08, "Compound Photonics" },
-		{ 0xCB08, "in2H2 inc" },
-		{ 0x4C08, "Shenzhen Pango Microsystems Co Ltd" },
-		{ 0xCD08, "Vasekey" },
-		{ 0xCE08, "Cal-Comp Industria de	Semicondutores" },
-		{ 0x4F08, "Eyenix Co Ltd" },
-		{ 0xD008, "Heoriady" },
-		{ 0x5108, "Accelerated Memory Production Inc" },
-		{ 0x5208, "INVECAS Inc" },
-		{ 0xD308, "AP Memory" },
-		{ 0x5408, "Douqi Technology" },
-		{ 0xD508, "Etron Technology Inc" },
-		{ 0xD608, "Indie Semiconductor" },
-		{ 0x5708, "Socionext Inc" },
-		{ 0x5808, "HGST" },
-		{ 0xD908, "EVGA" },
-		{ 0xDA08, "Audience Inc" },
-		{ 0x5B08, "EpicGear" },
-		{ 0xDC08, "Vitesse Enterprise Co" },
-		{ 0x5D08, "Foxtronn International Corporation" },
-		{ 0x5E08, "Bretelon Inc" },
-		{ 0xDF08, "Graphcore" },
-		{ 0xE008, "Eoplex Inc" },
-		{ 0x6108, "MaxLinear Inc" },
-		{ 0x6208, "ETA Devices" },
-		{ 0xE308, "LOKI" },
-		{ 0x6408, "IMS Electronics Co Ltd" },
-		{ 0xE508, "Dosilicon Co Ltd" },
-		{ 0xE608, "Dolphin Integration" },
-		{ 0x6708, "Shenzhen Mic Electronics Technolog" },
-		{ 0x6808, "Boya Microelectronics Inc" },
-		{ 0xE908, "Geniachip (Roche)" },
-		{ 0xEA08, "Axign" },
-		{ 0x6B08, "Kingred Electronic Technology Ltd" },
-		{ 0xEC08, "Chao Yue Zhuo Computer Business Dept." },
-		{ 0x6D08, "Guangzhou Si Nuo Electronic	Technology." },
-		{ 0x6E08, "Crocus Technology Inc" },
-		{ 0xEF08, "Creative Chips GmbH" },
-		{ 0x7008, "GE Aviation Systems LLC." },
-		{ 0xF108, "Asgard" },
-		{ 0xF208, "Good Wealth Technology Ltd" },
-		{ 0x7308, "TriCor Technologies" },
-		{ 0xF408, "Nova-Systems GmbH" },
-		{ 0x7508, "JUHOR" },
-		{ 0x7608, "Zhuhai Douke Commerce Co Ltd" },
-		{ 0xF708, "DSL Memory" },
-		{ 0xF808, "Anvo-Systems Dresden GmbH" },
-		{ 0x7908, "Realtek" },
-		{ 0x7A08, "AltoBeam" },
-		{ 0xFB08, "Wave Computing" },
-		{ 0x7C08, "Beijing TrustNet Technology Co Ltd" },
-		{ 0xFD08, "Innovium Inc" },
-		{ 0xFE08, "Starsway Technology Limited" },
-		//The following numbers are all in bank 10:									
-		{ 0x0189, "Weltronics Co LTD" },
-		{ 0x0289, "VMware Inc" },
-		{ 0x8389, "Hewlett Packard Enterprise" },
-		{ 0x0489, "INTENSO" },
-		{ 0x8589, "Puya Semiconductor" },
-		{ 0x8689, "MEMORFI" },
-		{ 0x0789, "MSC Technologies GmbH" },
-		{ 0x0889, "Txrui" },
-		{ 0x8989, "SiFive Inc" },
-		{ 0x8A89, "Spreadtrum Communications" },
-		{ 0x0B89, "XTX Technology Limited" },
-		{ 0x8C89, "UMAX Technology" },
-		{ 0x0D89, "Shenzhen Yong Sheng Technology" },
-		{ 0x0E89, "SNOAMOO (Shenzhen Kai Zhuo Yue)" },
-		{ 0x8F89, "Daten Tecnologia LTDA" },
-		{ 0x1089, "Shenzhen XinRuiYan Electronics" },
-		{ 0x9189, "Eta Compute" },
-		{ 0x9289, "Energous" },
-		{ 0x1389, "Raspberry Pi Trading Ltd" },
-		{ 0x9489, "Shenzhen Chixingzhe Tech Co Ltd" },
-		{ 0x1589, "Silicon Mobility" },
-		{ 0x1689, "IQ-Analog Corporation" },
-		{ 0x9789, "Uhnder Inc" },
-		{ 0x9889, "Impinj" },
-		{ 0x1989, "DEPO Computers" },
-		{ 0x1A89, "Nespeed Sysems" },
-		{ 0x9B89, "Yangtze Memory Technologies Co Ltd" },
-		{ 0x1C89, "MemxPro Inc" },
-		{ 0x9D89, "Tammuz Co Ltd" },
-		{ 0x9E89, "Allwinner Technology" },
-		{ 0x1F89, "Shenzhen City Futian District Qing Xuan Tong Computer Trading Firm" },
-		{ 0x2089, "XMC" },
-		{ 0xA189, "Teclast" },
-		{ 0xA289, "Maxsun" },
-		{ 0x2389, "Haiguang Integrated Circuit Design" },
-		{ 0xA489, "RamCENTER Technology" },
-		{ 0x2589, "Phison Electronics Corporation" },
-		{ 0x2689, "Guizhou Huaxintong Semi-Conductor" },
-		{ 0xA789, "Network Intelligence" },
-		{ 0xA889, "Continental Technology (Holdings)" },
-		{ 0x2989, "Guangzhou Huayan Suning Electronic" },
-		{ 0x2A89, "Guangzhou Zhouji Electronic Co Ltd" },
-		{ 0xAB89, "Shenzhen Giant Hui Kang Tech Co Ltd" },
-		{ 0x2C89, "Shenzhen Yilong Innovative Co Ltd" },
-		{ 0xAD89, "Neo Forza" },
-		{ 0xAE89, "Lyontek Inc" },
-		{ 0x2F89, "Shanghai Kuxin Microelectronics Ltd" },
-		{ 0xB089, "Shenzhen Larix Technology Co Ltd" },
-		{ 0x3189, "Qbit Semiconductor Ltd" },
-		{ 0x3289, "Insignis Technology Corporation" },
-		{ 0xB389, "Lanson Memory Co Ltd" },
-		{ 0x3489, "Shenzhen Superway Electronics Co Ltd" },
-		{ 0xB589, "Canaan-Creative Co Ltd" },
-		{ 0xB689, "Black Diamond Memory" },
-		{ 0x3789, "Shenzhen City Parker Baking Electronics" },
-		{ 0x3889, "Shenzhen Baihong Technology Co Ltd" },
-		{ 0xB989, "GEO Semiconductors" },
-		{ 0xBA89, "OCPC" },
-		{ 0x3B89, "Artery Technology Co Ltd" },
-		{ 0xBC89, "Jinyu" },
-		{ 0x3D89, "ShenzhenYing Chi Technology Development" },
-		{ 0x3E89, "Shenzhen Pengcheng Xin Technology" },
-		{ 0xBF89, "Pegasus Semiconductor (Shanghai) Co" },
-		{ 0x4089, "Mythic Inc" },
-		{ 0xC189, "Elmos Semiconductor AG" },
-		{ 0xC289, "Kllisre" },
-		{ 0x4389, "Shenzhen Winconway Technology" },
-		{ 0xC489, "Shenzhen Xingmem Technology Corp" },
-		{ 0x4589, "Gold Key Technology Co Ltd" },
-		{ 0x4689, "Habana Labs Ltd" },
-		{ 0xC789, "Hoodisk Electronics Co Ltd" },
-		{ 0xC889, "SemsoTai (SZ) Technology Co Ltd" },
-		{ 0x4989, "OM Nanotech Pvt. Ltd" },
-		{ 0x4A89, "Shenzhen Zhifeng Weiye Technology" },
-		{ 0xCB89, "Xinshirui (Shenzhen) Electronics Co" },
-		{ 0x4C89, "Guangzhou Zhong Hao Tian Electronic" },
-		{ 0xCD89, "Shenzhen Longsys Electronics Co Ltd" },
-		{ 0xCE89, "Deciso B.V." },
-		{ 0x4F89, "Puya Semiconductor (Shenzhen)" },
-		{ 0xD089, "Shenzhen Veineda Technology Co Ltd" },
-		{ 0x5189, "Antec Memory" },
-		{ 0x5289, "Cortus SAS" },
-		{ 0xD389, "Dust Leopard" },
-		{ 0x5489, "MyWo AS" },
-		{ 0xD589, "J&A Information Inc" },
-		{ 0xD689, "Shenzhen JIEPEI Technology Co Ltd" },
-		{ 0x5789, "Heidelberg University" },
-		{ 0x5889, "Flexxon PTE Ltd" },
-		{ 0xD989, "Wiliot" },
-		{ 0xDA89, "Raysun Electronics International Ltd" },
-		{ 0x5B89, "Aquarius Production Company LLC" },
-		{ 0xDC89, "MACNICA DHW LTDA" },
-		{ 0x5D89, "Intelimem" },
-		{ 0x5E89, "Zbit Semiconductor Inc" },
-		{ 0xDF89, "Shenzhen Technology Co Ltd" },
-		{ 0xE089, "Signalchip" },
-		{ 0x6189, "Shenzen Recadata Storage Technology" },
-		{ 0x6289, "Hyundai Technology" },
-		{ 0xE389, "Shanghai Fudi Investment Development" },
-		{ 0x6489, "Aixi Technology" },
-		{ 0xE589, "Tecon MT" },
-		{ 0xE689, "Onda Electric Co Ltd" },
-		{ 0x6789, "Jinshen" },
-		{ 0x6889, "Kimtigo Semiconductor (HK) Limited" },
-		{ 0xE989, "IIT Madras" },
-		{ 0xEA89, "Shenshan (Shenzhen) Electronic" },
-		{ 0x6B89, "Hefei Core Storage Electronic Limited" },
-		{ 0xEC89, "Colorful Technology Ltd" },
-		{ 0x6D89, "Visenta (Xiamen) Technology Co Ltd" },
-		{ 0x6E89, "Roa Logic BV" },
-		{ 0xEF89, "NSITEXE Inc" },
-		{ 0x7089, "Hong Kong Hyunion Electronics" },
-		{ 0xF189, "ASK Technology Group Limited" },
-		{ 0xF289, "GIGA-BYTE Technology Co Ltd" },
-		{ 0x7389, "Terabyte Co Ltd" },
-		{ 0xF489, "Hyundai Inc" },
-		{ 0x7589, "EXCELERAM" },
-		{ 0x7689, "PsiKick" },
-		{ 0xF789, "Netac Technology Co Ltd" },
-		{ 0xF889, "PCCOOLER" },
-		{ 0x7989, "Jiangsu Huacun Electronic Technology" },
-		{ 0x7A89, "Shenzhen Micro Innovation Industry" },
-		{ 0xFB89, "Beijing Tongfang Microelectronics Co" },
-		{ 0x7C89, "XZN Storage Technology" },
-		{ 0xFD89, "ChipCraft Sp. z.o.o." },
-		{ 0xFE89, "ALLFLASH Technology Limited" },
-		//The following numbers are all in bank 11:									
-		{ 0x018A, "Foerd Technology Co Ltd" },
-		{ 0x028A, "KingSpec" },
-		{ 0x838A, "Codasip GmbH" },
-		{ 0x048A, "SL Link Co Ltd" },
-		{ 0x858A, "Shenzhen Kefu Technology Co Limited" },
-		{ 0x868A, "Shenzhen ZST Electronics Technology" },
-		{ 0x078A, "Kyokuto Electronic Inc" },
-		{ 0x088A, "Warrior Technology" },
-		{ 0x898A, "TRINAMIC Motion Control GmbH & Co" },
-		{ 0x8A8A, "PixelDisplay Inc" },
-		{ 0x0B8A, "Shenzhen Futian District Bo Yueda Elec" },
-		{ 0x8C8A, "Richtek Power" },
-		{ 0x0D8A, "Shenzhen LianTeng Electronics Co Ltd" },
-		{ 0x0E8A, "AITC Memory" },
-		{ 0x8F8A, "UNIC Memory Technology Co Ltd" },
-		{ 0x108A, "Shenzhen Huafeng Science Technology" },
-		{ 0x918A, "ChangXin Memory Technologies Inc" },
-		{ 0x928A, "Guangzhou Xinyi Heng Computer Trading Firm" },
-		{ 0x138A, "SambaNova Systems" },
-		{ 0x948A, "V-GEN" },
-		{ 0x158A, "Jump Trading" },
-		{ 0x168A, "Ampere Computing" },
-		{ 0x978A, "Shenzhen Zhongshi Technology Co Ltd" },
-		{ 0x988A, "Shenzhen Zhongtian Bozhong Technology" },
-		{ 0x198A, "Tri-Tech Internationa" },
-		{ 0x1A8A, "Silicon Intergrated Systems Corporation" },
-		{ 0x9B8A, "Shenzhen HongDingChen Information" },
-		{ 0x1C8A, "Plexton Holdings Limited" },
-		{ 0x9D8A, "AMS (Jiangsu Advanced Memory Semi)" },
-		{ 0x9E8A, "Wuhan Jing Tian Interconnected Tech Co" },
-		{ 0x1F8A, "Axia Memory Technology" },
-		{ 0x208A, "Chipset Technology Holding Limited" },
-		{ 0xA18A, "Shenzhen Xinshida Technology Co Ltd" },
-		{ 0xA28A, "Shenzhen Chuangshifeida Technology" },
-		{ 0x238A, "Guangzhou MiaoYuanJi Technology" },
-		{ 0xA48A, "ADVAN Inc" },
-		{ 0x258A, "Shenzhen Qianhai Weishengda Electronic Commerce Company Ltd" },
-		{ 0x268A, "Guangzhou Guang Xie Cheng Trading" },
-		{ 0xA78A, "StarRam International Co Ltd" },
-		{ 0xA88A, "Shen Zhen XinShenHua Tech Co Ltd" },
-		{ 0x298A, "UltraMemory Inc" },
-		{ 0x2A8A, "New Coastline Global Tech Industry Co" },
-		{ 0xAB8A, "Sinker" },
-		{ 0x2C8A, "Diamond" },
-		{ 0xAD8A, "PUSKIL" },
-		{ 0xAE8A, "Guangzhou Hao Jia Ye Technology Co" },
-		{ 0x2F8A, "Ming Xin Limited" },
-		{ 0xB08A, "Barefoot Networks" },
-		{ 0x318A, "Biwin Semiconductor (HK) Co Ltd" },
-		{ 0x328A, "UD INFO Corporation" },
-		{ 0xB38A, "Trek Technology (S) PTE Ltd" },
-		{ 0x348A, "Xiamen Kingblaze Technology Co Ltd" },
-		{ 0xB58A, "Shenzhen Lomica Technology Co Ltd" },
-		{ 0xB68A, "Nuclei System Technology Co Ltd" },
-		{ 0x378A, "Wuhan Xun Zhan Electronic Technology" },
-		{ 0x388A, "Shenzhen Ingacom Semiconductor Ltd" },
-		{ 0xB98A, "Zotac Technology Ltd" },
-		{ 0xBA8A, "Foxline" },
-		{ 0x3B8A, "Shenzhen Farasia Science Technology" },
-		{ 0xBC8A, "Efinix Inc" },
-		{ 0x3D8A, "Hua Nan San Xian Technology Co Ltd" },
-		{ 0x3E8A, "Goldtech Electronics Co Ltd" },
-		{ 0xBF8A, "Shanghai Han Rong Microelectronics Co" },
-		{ 0x408A, "Shenzhen Zhongguang Yunhe Trading" },
-		{ 0xC18A, "Smart Shine(QingDao) Microelectronics" },
-		{ 0xC28A, "Thermaltake Technology Co Ltd" },
-		{ 0x438A, "Shenzhen O'Yang Maile Technology Ltd" },
-		{ 0xC48A, "UPMEM" },
-		{ 0x458A, "Chun Well Technology Holding Limited" },
-		{ 0x468A, "Astera Labs Inc" },
-		{ 0xC78A, "VMEMORY Co Ltd" },
-		{ 0xC88A, "Advantech Co Ltd" },
-		{ 0x498A, "Chengdu Fengcai Electronic Technology" },
-		{ 0x4A8A, "The Boeing Company" },
-		{ 0xCB8A, "ThinCI Inc" },
-		{ 0x4C8A, "Ramonster Technology Co Ltd" },
-		{ 0xCD8A, "Wuhan Naonongmai Technology Co Ltd" },
-		{ 0xCE8A, "Shenzhen Hui ShingTong Technology" },
-		{ 0x4F8A, "Yourlyon" },
-		{ 0xD08A, "Fabu Technology" },
-		{ 0x518A, "Shenzhen Yikesheng Technology Co Ltd" },
-		{ 0x528A, "NOR-MEM" },
-		{ 0xD38A, "Cervoz Co Ltd" },
-		{ 0x548A, "Bitmain Technologies Inc." },
-		{ 0xD58A, "Facebook Inc" },
-		{ 0xD68A, "Shenzhen Longsys Electronics Co Ltd" },
-		{ 0x578A, "Guangzhou Siye Electronic Technology" },
-		{ 0x588A, "Silergy" },
-		{ 0xD98A, "Adamway" },
-		{ 0xDA8A, "PZG" },
-		{ 0x5B8A, "Shenzhen King Power Electronics" },
-		{ 0xDC8A, "Guangzhou ZiaoFu Tranding Co Ltd" },
-		{ 0x5D8A, "Shenzhen SKIHOTAR Semiconductor" },
-		{ 0x5E8A, "PulseRain Technology" },
-		{ 0xDF8A, "Seeker Technology Limited" },
-		{ 0xE08A, "Shenzhen OSCOO Tech Co Ltd" },
-		{ 0x618A, "Shenzhen Yze Technology Co Ltd" },
-		{ 0x628A, "Shenzhen Jieshuo Electronic Commerce" },
-		{ 0xE38A, "Gazda" },
-		{ 0x648A, "Hua Wei Technology Co Ltd" },
-		{ 0xE58A, "Esperanto Technologies" },
-		{ 0xE68A, "JinSheng Electronic (Shenzhen) Co Ltd" },
-		{ 0x678A, "Shenzhen Shi Bolunshuai Technology" },
-		{ 0x688A, "Shanghai Rei Zuan Information Tech" },
-		{ 0xE98A, "Fraunhofer IIS" },
-		{ 0xEA8A, "Kandou Bus SA" },
-		{ 0x6B8A, "Acer" },
-		{ 0xEC8A, "Artmem Technology Co Ltd" },
-		{ 0x6D8A, "Gstar Semiconductor Co Ltd" },
-		{ 0x6E8A, "ShineDisk" },
-		{ 0xEF8A, "Shenzhen CHN Technology Co Ltd" },
-		{ 0x708A, "UnionChip Semiconductor Co Ltd" },
-		{ 0xF18A, "Tanbassh" },
-		{ 0xF28A, "Shenzhen Tianyu Jieyun Intl Logistics" },
-		{ 0x738A, "MCLogic Inc" },
-		{ 0xF48A, "Eorex Corporation" },
-		{ 0x758A, "Arm Technology (China) Co Ltd" },
-		{ 0x768A, "Lexar Co Limited" },
-		{ 0xF78A, "QinetiQ Group plc" },
-		{ 0xF88A, "Exascend" },
-		{ 0x798A, "Hong Kong Hyunion Electronics Co Ltd" },
-		{ 0x7A8A, "Shenzhen Banghong Electronics Co Ltd" },
-		{ 0xFB8A, "MBit Wireless Inc" },
-		{ 0x7C8A, "Hex Five Security Inc" },
-		{ 0xFD8A, "ShenZhen Juhor Precision Tech Co Ltd" },
-		{ 0xFE8A, "Shenzhen Reeinno Technology Co Ltd" },
-		// The following numbers are all in bank 12:									
-		{ 0x010B, "ABIT Electronics (Shenzhen) Co Ltd" },
-		{ 0x020B, "Semidrive" },
-		{ 0x830B, "MyTek Electronics Corp" },
-		{ 0x040B, "Wxilicon Technology Co Ltd" },
-		{ 0x850B, "Shenzhen Meixin Electronics Ltd" },
-		{ 0x860B, "Ghost Wolf" },
-		{ 0x070B, "LiSion Technologies Inc" },
-		{ 0x080B, "Power Active Co Ltd" },
-		{ 0x890B, "Pioneer High Fidelity Taiwan Co. Ltd" },
-		{ 0x8A0B, "LuoSilk" },
-		{ 0x0B0B, "Shenzhen Chuangshifeida Technology" },
-		{ 0x8C0B, "Black Sesame Technologies Inc" },
-		{ 0x0D0B, "Jiangsu Xinsheng Intelligent Technology" },
-		{ 0x0E0B, "MLOONG" },
-		{ 0x8F0B, "Quadratica LLC" },
-		{ 0x100B, "Anpec Electronics" },
-		{ 0x910B, "Xi'an Morebeck Semiconductor Tech Co" },
-		{ 0x920B, "Kingbank Technology Co Ltd" },
-		{ 0x130B, "ITRenew Inc" },
-		{ 0x940B, "Shenzhen Eaget Innovation Tech Ltd" },
-		{ 0x150B, "Jazer" },
-		{ 0x160B, "Xiamen Semiconductor Investment Group" },
-		{ 0x970B, "Guangzhou Longdao Network Tech Co" },
-		{ 0x0000, "Unknown" }
-	};
+const char *SPD::GetManufactureName(uint32_t dev)
+{
+	uint32_t key = JEP106_Key(dev);
+	size_t lo = 0, hi = JEP106_COUNT;
 
-	for (int i = 0; i < 1410; i++)
+	while (lo < hi)
 	{
-		if (JEP106_Table[i].index == dev)
-		{
-			return JEP106_Table[i].Name;
-		}
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (JEP106_Key(JEP106_Table[mid].index) < key)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
+
+	/* The key ignores parity and the upper bits, the stored code does not */
+	if (lo < JEP106_COUNT && JEP106_Table[lo].index == dev)
+		return JEP106_Table[lo].Name;
+
 	return "Unknown";
+}
+
+std::string SPD::GetManufacture(uint32_t dev)
+{
+	return GetManufactureName(dev);
 }
\ No newline at end of file
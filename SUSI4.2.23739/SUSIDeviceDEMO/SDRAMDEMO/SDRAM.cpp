@@ -11,14 +11,14 @@ void printTitle()
 		"******************************************************************\n");
 }
 
-std::string SPD::MemoryType(uint8_t dev)
+const char *SPD::MemoryTypeName(uint8_t dev)
 {
 	typedef struct _MemoryTypeInfo {
 		uint8_t index;
-		std::string Name;
+		const char *Name;
 	} MemoryTypeInfo;
 	
-	const MemoryTypeInfo MemoryTypeInfoTable[] = {
+	static const MemoryTypeInfo MemoryTypeInfoTable[] = {
 		{ 0x00,"Reserved" },
 		{ 0x01,"Standard FPM DRAM" },
 		{ 0x02,"EDO" },
@@ -35,7 +35,7 @@ std::string SPD::MemoryType(uint8_t dev)
 		{ 0x12,"DDR5 SDRAM" }
 	};
 
-	for (int i =0; i < 14 ; i++)
+	for (size_t i = 0; i < sizeof(MemoryTypeInfoTable) / sizeof(MemoryTypeInfoTable[0]); i++)
 	{
 		if (MemoryTypeInfoTable[i].index == dev)
 		{
@@ -45,14 +45,19 @@ std::string SPD::MemoryType(uint8_t dev)
 	return "Unknown";
 }
 
-std::string SPD::DDR3ModuleType(uint8_t dev)
+std::string SPD::MemoryType(uint8_t dev)
+{
+	return MemoryTypeName(dev);
+}
+
+const char *SPD::DDR3ModuleTypeName(uint8_t dev)
 {
 	typedef struct _ModuleTypeInfo {
 		uint8_t index;
-		std::string Name;
+		const char *Name;
 	} ModuleTypeInfo;
 
-	const ModuleTypeInfo ModuleTypeInfoTable[] = {
+	static const ModuleTypeInfo ModuleTypeInfoTable[] = {
 		{ 0x00,"Undefined" },
 		{ 0x01,"RDIMM" },
 		{ 0x02,"UDIMM" },
@@ -67,7 +72,7 @@ std::string SPD::DDR3ModuleType(uint8_t dev)
 		{ 0x0B,"LRDIMM" }
 	};
 
-	for (int i = 0; i < 12; i++)
+	for (size_t i = 0; i < sizeof(ModuleTypeInfoTable) / sizeof(ModuleTypeInfoTable[0]); i++)
 	{
 		if (ModuleTypeInfoTable[i].index == dev)
 		{
@@ -77,14 +82,19 @@ std::string SPD::DDR3ModuleType(uint8_t dev)
 	return "Unknown";
 }
 
-std::string SPD::DDR4ModuleType(uint8_t dev)
+std::string SPD::DDR3ModuleType(uint8_t dev)
+{
+	return DDR3ModuleTypeName(dev);
+}
+
+const char *SPD::DDR4ModuleTypeName(uint8_t dev)
 {
 	typedef struct _ModuleTypeInfo {
 		uint8_t index;
-		std::string Name;
+		const char *Name;
 	} ModuleTypeInfo;
 
-	const ModuleTypeInfo ModuleTypeInfoTable[] = {
+	static const ModuleTypeInfo ModuleTypeInfoTable[] = {
 		{ 0x00,"Undefined" },
 		{ 0x01,"RDIMM" },
 		{ 0x02,"UDIMM" },
@@ -103,7 +113,7 @@ std::string SPD::DDR4ModuleType(uint8_t dev)
 		{ 0x0F,"Reserved" }
 	};
 
-	for (int i = 0; i < 16; i++)
+	for (size_t i = 0; i < sizeof(ModuleTypeInfoTable) / sizeof(ModuleTypeInfoTable[0]); i++)
 	{
 		if (ModuleTypeInfoTable[i].index == dev)
 		{
@@ -113,14 +123,19 @@ std::string SPD::DDR4ModuleType(uint8_t dev)
 	return "Unknown";
 }
 
-std::string SPD::DDR5ModuleType(uint8_t dev)
+std::string SPD::DDR4ModuleType(uint8_t dev)
+{
+	return DDR4ModuleTypeName(dev);
+}
+
+const char *SPD::DDR5ModuleTypeName(uint8_t dev)
 {
 	typedef struct _ModuleTypeInfo {
 		uint8_t index;
-		std::string Name;
+		const char *Name;
 	} ModuleTypeInfo;
 
-	const ModuleTypeInfo ModuleTypeInfoTable[] = {
+	static const ModuleTypeInfo ModuleTypeInfoTable[] = {
 		{ 0x00,"Undefined" },
 		{ 0x01,"RDIMM" },
 		{ 0x02,"UDIMM" },
@@ -139,7 +154,7 @@ std::string SPD::DDR5ModuleType(uint8_t dev)
 		{ 0x0F,"Reserved" }
 	};
 
-	for (int i = 0; i < 16; i++)
+	for (size_t i = 0; i < sizeof(ModuleTypeInfoTable) / sizeof(ModuleTypeInfoTable[0]); i++)
 	{
 		if (ModuleTypeInfoTable[i].index == dev)
 		{
@@ -149,6 +164,11 @@ std::string SPD::DDR5ModuleType(uint8_t dev)
 	return "Unknown";
 }
 
+std::string SPD::DDR5ModuleType(uint8_t dev)
+{
+	return DDR5ModuleTypeName(dev);
+}
+
 bool SPD::isAvailable()
 {
 	uint32_t tmp;
@@ -171,7 +191,6 @@ void SPD::DRAM_Info(uint8_t socket)
 	//double temperature = 0.0;
 	uint32_t DRAMTYPE = 0;
 	uint32_t status = 0;
-	std::string temp;
 
 
 	status = SusiDeviceGetValue(SPD_ID_DRAM_PARTNUMBER1(socket), &data);
@@ -206,8 +225,7 @@ void SPD::DRAM_Info(uint8_t socket)
 	status = SusiDeviceGetValue(SPD_ID_DRAM_TYPE(socket), &DRAMTYPE);
 	if (status == SUSI_STATUS_SUCCESS)
 	{
-		temp = MemoryType(DRAMTYPE);
-		printf("Memory Type:\t\t %s \n", temp.c_str());
+		printf("Memory Type:\t\t %s \n", MemoryTypeName(DRAMTYPE));
 	}
 	else if (status == SUSI_STATUS_READ_ERROR) 
 	{
@@ -225,13 +243,11 @@ void SPD::DRAM_Info(uint8_t socket)
 	status = SusiDeviceGetValue(SPD_ID_DRAM_MODULETYPE(socket), &data);
 	if (DRAMTYPE == 12)
 	{
-		temp = DDR4ModuleType(data);
-		printf("Module Type:\t\t %s \n", temp.c_str());
+		printf("Module Type:\t\t %s \n", DDR4ModuleTypeName(data));
 	}
 	else if (DRAMTYPE == 11)
 	{
-		temp = DDR3ModuleType(data);
-		printf("Module Type:\t\t %s \n", temp.c_str());
+		printf("Module Type:\t\t %s \n", DDR3ModuleTypeName(data));
 	}
 	else if (DRAMTYPE == 0x12) 
 	{
@@ -241,8 +257,7 @@ void SPD::DRAM_Info(uint8_t socket)
 		}
 		else
 		{
-			temp = DDR5ModuleType(data);
-			printf("Module Type:\t\t %s \n", temp.c_str());
+			printf("Module Type:\t\t %s \n", DDR5ModuleTypeName(data));
 		}
 	}
 	else
@@ -343,8 +358,7 @@ void SPD::DRAM_Info(uint8_t socket)
 	status = SusiDeviceGetValue(SPD_ID_DRAM_MANUFACTURE(socket), &data);
 	if (status == SUSI_STATUS_SUCCESS)
 	{
-		temp = SPD::GetManufacture(data);
-		printf("Module Manufacture:\t %s \n", temp.c_str());
+		printf("Module Manufacture:\t %s \n", SPD::GetManufactureName(data));
 	}
 	else if (status == SUSI_STATUS_READ_ERROR)
 	{
@@ -355,8 +369,7 @@ void SPD::DRAM_Info(uint8_t socket)
 	status = SusiDeviceGetValue(SPD_ID_DRAM_DRAMIC(socket), &data);
 	if (status == SUSI_STATUS_SUCCESS)
 	{
-		temp = SPD::GetManufacture(data);
-		printf("DRAM Manufacture:\t %s \n", temp.c_str());
+		printf("DRAM Manufacture:\t %s \n", SPD::GetManufactureName(data));
 	}
 	else if (status == SUSI_STATUS_READ_ERROR)
 	{
@@ -178,6 +178,13 @@ private:
 	
 
 public:
+	/* Names from static tables, no allocation; the std::string
+	   versions wrap them */
+	static const char *MemoryTypeName(uint8_t dev);
+	static const char *DDR3ModuleTypeName(uint8_t dev);
+	static const char *DDR4ModuleTypeName(uint8_t dev);
+	static const char *DDR5ModuleTypeName(uint8_t dev);
+	static const char *GetManufactureName(uint32_t dev);
 	static std::string MemoryType(uint8_t dev);
 	static std::string DDR3ModuleType(uint8_t dev);
 	static std::string DDR4ModuleType(uint8_t dev);
@@ -1,12 +1,51 @@
 #include "IoTJsonLibrary.h"
+#include <stdlib.h>
+#include <string.h>
 
 #define JSON_OBJECT_EMPTY  0xFFFFF8FE
 #define JSON_UPDATE_FAIL   0xFFFFF8FD
 #define JSON_COPY_FAIL     0xFFFFF8FC
 #define JSON_KEY_NOT_FOUND 0xFFFFF8FB
 
+#define CBOR_UINT          0x00
+#define CBOR_NEGINT        0x20
+#define CBOR_TEXT          0x60
+#define CBOR_ARRAY         0x80
+#define CBOR_MAP           0xA0
+#define CBOR_MAP_INDEFINITE 0xBF
+#define CBOR_FALSE         0xF4
+#define CBOR_TRUE          0xF5
+#define CBOR_NULL          0xF6
+#define CBOR_FLOAT32       0xFA
+#define CBOR_FLOAT64       0xFB
+#define CBOR_BREAK         0xFF
+
+#define ARENA_CHUNK_SIZE   65536
+#define ARENA_ALIGN        16
+
 static int error_code = 0x00000000;
 
+typedef struct ArenaChunk
+{
+	struct ArenaChunk* next;
+	size_t size;
+	size_t used;
+} ArenaChunk;
+
+struct IoTArena
+{
+	ArenaChunk* chunks;
+	struct IoTArena* next;
+};
+
+/* Chunk data starts after the header, rounded up to the alignment */
+#define ARENA_HEADER ((sizeof(ArenaChunk) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+static IoTArena* arenaCurrent = NULL;
+static IoTArena* arenaLive = NULL;
+static json_malloc_t baseMalloc = NULL;
+static json_free_t baseFree = NULL;
+
 json_t* SUSI_IOT_API createIoTArrayElementInt(const char* name, const int value, const int id)
 {
 	json_t* ret = json_pack("{s:s, s:i, s:i}", "n", name, "v", value, "id", id);
@@ -195,6 +234,417 @@ json_t* SUSI_IOT_API createIoTJsonCapability(json_t* jsonObjects[], int size)
 	return ret;
 }
 
+static void appendText(char* buffer, size_t bufferSize, size_t* length, const char* text, size_t size)
+{
+	if (*length < bufferSize)
+	{
+		size_t room = bufferSize - *length;
+		memcpy(buffer + *length, text, size < room ? size : room);
+	}
+	*length += size;
+}
+
+static void appendKey(char* buffer, size_t bufferSize, size_t* length, const char* key)
+{
+	static const char hex[] = "0123456789abcdef";
+	const unsigned char* c;
+	char escape[6] = { '\\', 'u', '0', '0', 0, 0 };
+
+	appendText(buffer, bufferSize, length, "\"", 1);
+	for (c = (const unsigned char*)key; *c; c++)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			escape[1] = (char)*c;
+			appendText(buffer, bufferSize, length, escape, 2);
+			escape[1] = 'u';
+		}
+		else if (*c < 0x20)
+		{
+			escape[4] = hex[*c >> 4];
+			escape[5] = hex[*c & 0x0F];
+			appendText(buffer, bufferSize, length, escape, 6);
+		}
+		else
+		{
+			appendText(buffer, bufferSize, length, (const char*)c, 1);
+		}
+	}
+	appendText(buffer, bufferSize, length, "\":", 2);
+}
+
+size_t SUSI_IOT_API dumpIoTJsonCapability(json_t* jsonObjects[], int size, char* buffer, size_t bufferSize, size_t flags)
+{
+	int i = 0, j;
+	size_t length = 0;
+	int first = 1;
+
+	flags = (flags & ~(size_t)JSON_MAX_INDENT) | JSON_COMPACT | JSON_ENCODE_ANY;
+	if (buffer == NULL)
+	{
+		bufferSize = 0;
+	}
+
+	appendText(buffer, bufferSize, &length, "{", 1);
+	for (; i < size; i++)
+	{
+		const char* key;
+		json_t* value;
+
+		if (!json_is_object(jsonObjects[i]))
+		{
+			continue;
+		}
+
+		json_object_foreach(jsonObjects[i], key, value)
+		{
+			/* createIoTJsonCapability keeps the first package's key */
+			for (j = 0; j < i; j++)
+			{
+				if (json_is_object(jsonObjects[j]) && json_object_get(jsonObjects[j], key))
+				{
+					break;
+				}
+			}
+			if (j < i)
+			{
+				continue;
+			}
+
+			if (!first)
+			{
+				appendText(buffer, bufferSize, &length, ",", 1);
+			}
+			first = 0;
+			appendKey(buffer, bufferSize, &length, key);
+			length += json_dumpb(value, length < bufferSize ? buffer + length : NULL,
+				length < bufferSize ? bufferSize - length : 0, flags);
+		}
+	}
+	appendText(buffer, bufferSize, &length, "}", 1);
+
+	if (length < bufferSize)
+	{
+		buffer[length] = '\0';
+	}
+	else if (bufferSize > 0)
+	{
+		buffer[bufferSize - 1] = '\0';
+	}
+
+	return length;
+}
+
+/* Major type and argument in the shortest form */
+static void appendCborHead(char* buffer, size_t bufferSize, size_t* length, unsigned char major, unsigned long long value)
+{
+	unsigned char head[9];
+	size_t size, i;
+
+	if (value < 24)
+	{
+		head[0] = (unsigned char)(major | value);
+		size = 1;
+	}
+	else
+	{
+		size = value <= 0xFF ? 2 : value <= 0xFFFF ? 3 : value <= 0xFFFFFFFFULL ? 5 : 9;
+		head[0] = (unsigned char)(major | (size == 2 ? 24 : size == 3 ? 25 : size == 5 ? 26 : 27));
+		for (i = size - 1; i > 0; i--)
+		{
+			head[i] = (unsigned char)value;
+			value >>= 8;
+		}
+	}
+	appendText(buffer, bufferSize, length, (const char*)head, size);
+}
+
+static void appendCborString(char* buffer, size_t bufferSize, size_t* length, const char* text, size_t size)
+{
+	appendCborHead(buffer, bufferSize, length, CBOR_TEXT, size);
+	appendText(buffer, bufferSize, length, text, size);
+}
+
+static void appendCborReal(char* buffer, size_t bufferSize, size_t* length, double value)
+{
+	unsigned char bytes[9];
+	float narrow = (float)value;
+	int i;
+
+	if ((double)narrow == value)
+	{
+		unsigned int bits;
+		memcpy(&bits, &narrow, sizeof(bits));
+		bytes[0] = CBOR_FLOAT32;
+		for (i = 0; i < 4; i++)
+		{
+			bytes[4 - i] = (unsigned char)(bits >> (8 * i));
+		}
+		appendText(buffer, bufferSize, length, (const char*)bytes, 5);
+	}
+	else
+	{
+		unsigned long long bits;
+		memcpy(&bits, &value, sizeof(bits));
+		bytes[0] = CBOR_FLOAT64;
+		for (i = 0; i < 8; i++)
+		{
+			bytes[8 - i] = (unsigned char)(bits >> (8 * i));
+		}
+		appendText(buffer, bufferSize, length, (const char*)bytes, 9);
+	}
+}
+
+static void appendCbor(char* buffer, size_t bufferSize, size_t* length, json_t* value)
+{
+	unsigned char simple;
+	const char* key;
+	json_t* item;
+	size_t index;
+
+	switch (json_typeof(value))
+	{
+	case JSON_OBJECT:
+		appendCborHead(buffer, bufferSize, length, CBOR_MAP, json_object_size(value));
+		json_object_foreach(value, key, item)
+		{
+			appendCborString(buffer, bufferSize, length, key, strlen(key));
+			appendCbor(buffer, bufferSize, length, item);
+		}
+		break;
+	case JSON_ARRAY:
+		appendCborHead(buffer, bufferSize, length, CBOR_ARRAY, json_array_size(value));
+		json_array_foreach(value, index, item)
+		{
+			appendCbor(buffer, bufferSize, length, item);
+		}
+		break;
+	case JSON_STRING:
+		appendCborString(buffer, bufferSize, length, json_string_value(value), json_string_length(value));
+		break;
+	case JSON_INTEGER:
+		if (json_integer_value(value) < 0)
+		{
+			appendCborHead(buffer, bufferSize, length, CBOR_NEGINT, (unsigned long long)(-1 - json_integer_value(value)));
+		}
+		else
+		{
+			appendCborHead(buffer, bufferSize, length, CBOR_UINT, (unsigned long long)json_integer_value(value));
+		}
+		break;
+	case JSON_REAL:
+		appendCborReal(buffer, bufferSize, length, json_real_value(value));
+		break;
+	default:
+		simple = json_is_true(value) ? CBOR_TRUE : json_is_false(value) ? CBOR_FALSE : CBOR_NULL;
+		appendText(buffer, bufferSize, length, (const char*)&simple, 1);
+		break;
+	}
+}
+
+size_t SUSI_IOT_API dumpIoTCbor(json_t* value, char* buffer, size_t bufferSize)
+{
+	size_t length = 0;
+
+	if (value == NULL)
+	{
+		return 0;
+	}
+	if (buffer == NULL)
+	{
+		bufferSize = 0;
+	}
+	appendCbor(buffer, bufferSize, &length, value);
+	return length;
+}
+
+size_t SUSI_IOT_API dumpIoTCborCapability(json_t* jsonObjects[], int size, char* buffer, size_t bufferSize)
+{
+	static const char start = (char)CBOR_MAP_INDEFINITE, end = (char)CBOR_BREAK;
+	int i = 0, j;
+	size_t length = 0;
+
+	if (buffer == NULL)
+	{
+		bufferSize = 0;
+	}
+
+	appendText(buffer, bufferSize, &length, &start, 1);
+	for (; i < size; i++)
+	{
+		const char* key;
+		json_t* value;
+
+		if (!json_is_object(jsonObjects[i]))
+		{
+			continue;
+		}
+
+		json_object_foreach(jsonObjects[i], key, value)
+		{
+			/* First package's key wins, as in dumpIoTJsonCapability */
+			for (j = 0; j < i; j++)
+			{
+				if (json_is_object(jsonObjects[j]) && json_object_get(jsonObjects[j], key))
+				{
+					break;
+				}
+			}
+			if (j < i)
+			{
+				continue;
+			}
+			appendCborString(buffer, bufferSize, &length, key, strlen(key));
+			appendCbor(buffer, bufferSize, &length, value);
+		}
+	}
+	appendText(buffer, bufferSize, &length, &end, 1);
+
+	return length;
+}
+
+static void* arenaMalloc(size_t size)
+{
+	ArenaChunk* chunk;
+	size_t need;
+
+	if (arenaCurrent == NULL)
+	{
+		return baseMalloc(size);
+	}
+
+	need = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+	chunk = arenaCurrent->chunks;
+	if (chunk == NULL || chunk->size - chunk->used < need)
+	{
+		size_t chunkSize = need > ARENA_CHUNK_SIZE / 4 ? need : ARENA_CHUNK_SIZE;
+
+		chunk = (ArenaChunk*)baseMalloc(ARENA_HEADER + chunkSize);
+		if (chunk == NULL)
+		{
+			return NULL;
+		}
+		chunk->size = chunkSize;
+		chunk->used = 0;
+
+		/* A large block gets a chunk of its own behind the current one */
+		if (chunkSize != ARENA_CHUNK_SIZE && arenaCurrent->chunks != NULL)
+		{
+			chunk->next = arenaCurrent->chunks->next;
+			arenaCurrent->chunks->next = chunk;
+		}
+		else
+		{
+			chunk->next = arenaCurrent->chunks;
+			arenaCurrent->chunks = chunk;
+		}
+	}
+
+	chunk->used += need;
+	return (char*)chunk + ARENA_HEADER + chunk->used - need;
+}
+
+static void arenaFree(void* ptr)
+{
+	IoTArena* arena;
+	ArenaChunk* chunk;
+
+	if (ptr == NULL)
+	{
+		return;
+	}
+
+	for (arena = arenaLive; arena != NULL; arena = arena->next)
+	{
+		for (chunk = arena->chunks; chunk != NULL; chunk = chunk->next)
+		{
+			char* data = (char*)chunk + ARENA_HEADER;
+			if ((char*)ptr >= data && (char*)ptr < data + chunk->size)
+			{
+				return;
+			}
+		}
+	}
+
+	baseFree(ptr);
+}
+
+IoTArena* SUSI_IOT_API createIoTArena(void)
+{
+	IoTArena* arena;
+
+	if (arenaLive == NULL)
+	{
+		json_get_alloc_funcs(&baseMalloc, &baseFree);
+	}
+
+	arena = (IoTArena*)baseMalloc(sizeof(IoTArena));
+	if (arena == NULL)
+	{
+		return NULL;
+	}
+	arena->chunks = NULL;
+	arena->next = arenaLive;
+
+	/* The free hook stays until the last arena goes, so arena memory
+	   reached through a late json_decref is never passed to free() */
+	if (arenaLive == NULL)
+	{
+		json_set_alloc_funcs(arenaMalloc, arenaFree);
+	}
+	arenaLive = arena;
+
+	return arena;
+}
+
+void SUSI_IOT_API beginIoTArena(IoTArena* arena)
+{
+	arenaCurrent = arena;
+}
+
+void SUSI_IOT_API endIoTArena(void)
+{
+	arenaCurrent = NULL;
+}
+
+void SUSI_IOT_API freeIoTArena(IoTArena **arena)
+{
+	IoTArena** link = &arenaLive;
+	ArenaChunk* chunk;
+
+	if (arena == NULL || *arena == NULL)
+	{
+		return;
+	}
+
+	while (*link != NULL && *link != *arena)
+	{
+		link = &(*link)->next;
+	}
+	if (*link != NULL)
+	{
+		*link = (*arena)->next;
+	}
+	if (arenaCurrent == *arena)
+	{
+		arenaCurrent = NULL;
+	}
+
+	while ((*arena)->chunks != NULL)
+	{
+		chunk = (*arena)->chunks;
+		(*arena)->chunks = chunk->next;
+		baseFree(chunk);
+	}
+	baseFree(*arena);
+	*arena = NULL;
+
+	if (arenaLive == NULL)
+	{
+		json_set_alloc_funcs(baseMalloc, baseFree);
+	}
+}
+
 void SUSI_IOT_API freeJsonObject(json_t **jsonObject)
 {
 	json_object_clear(*jsonObject);
@@ -1,6 +1,7 @@
 #ifndef _IOT_JSON_LIBRARY_H_
 #define _IOT_JSON_LIBRARY_H_
 
+#include <stddef.h>
 #include <jansson.h>
 
 #ifndef NULL
@@ -59,6 +60,41 @@ json_t* SUSI_IOT_API createIoTFuncPackageEx(json_t* jsonIPSOObjects[], int size,
 /* Create JSON Package */
 json_t* SUSI_IOT_API createIoTJsonCapability(json_t* jsonObjects[], int size);
 
+/* Serialize the capability createIoTJsonCapability() would build from the same
+   objects straight into buffer, without building the merged tree. Output is
+   compact (value flags such as JSON_PRESERVE_ORDER and JSON_REAL_PRECISION
+   apply, JSON_INDENT does not). Like snprintf, returns the length needed
+   without the terminator and writes at most bufferSize bytes, terminated when
+   they fit; call once with a NULL buffer to size a single allocation. */
+size_t SUSI_IOT_API dumpIoTJsonCapability(json_t* jsonObjects[], int size, char* buffer, size_t bufferSize, size_t flags);
+
+/* The same data as CBOR (RFC 8949), for links where bytes cost money. Values
+   are encoded while the tree is walked, with no text or copy in between:
+   integers in their shortest form, reals as float32 when that is exact and
+   float64 otherwise, objects and arrays with their sizes. The capability
+   is one indefinite-length map, as duplicate keys are only found while
+   walking. Returns the length needed; the output is binary and never
+   terminated. */
+size_t SUSI_IOT_API dumpIoTCbor(json_t* value, char* buffer, size_t bufferSize);
+size_t SUSI_IOT_API dumpIoTCborCapability(json_t* jsonObjects[], int size, char* buffer, size_t bufferSize);
+
+/* Arena Builder
+   Between beginIoTArena() and endIoTArena() every jansson allocation is
+   bumped out of the arena's chunks, so a whole package tree costs a few
+   large allocations, and freeIoTArena() releases it in one step instead of
+   walking it. Frees of arena memory are ignored while the arena lives; other
+   jansson memory is freed as usual. Anything still referencing arena values,
+   including objects that took them through json_object_update, must be gone
+   (or hold a json_deep_copy made outside the arena) before freeIoTArena().
+   The allocator is process wide: build on one thread and do not mix with
+   other json_set_alloc_funcs users. */
+typedef struct IoTArena IoTArena;
+
+IoTArena* SUSI_IOT_API createIoTArena(void);
+void SUSI_IOT_API beginIoTArena(IoTArena* arena);
+void SUSI_IOT_API endIoTArena(void);
+void SUSI_IOT_API freeIoTArena(IoTArena **arena);
+
 /* General Function */
 void SUSI_IOT_API freeJsonObject(json_t **jsonObject);
 
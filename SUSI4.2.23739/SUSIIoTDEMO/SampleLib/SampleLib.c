@@ -1,9 +1,25 @@
 #include "SampleLib.h"
 #include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #define ARRAYSIZE(x) ((sizeof(x)/sizeof(0[x])) / ((size_t)(!(sizeof(x) % sizeof(0[x])))))
-#define DATA_MAX 100
+#define DATA_INITIAL 64		/* Records; the index has twice as many slots */
+#define INDEX_EMPTY -1
+#define EVENT_POOL_SIZE 8
+#define EVENT_PAYLOAD_MAX 256
+
+#if defined(_MSC_VER)
+#include <windows.h>
+#define EVENT_CAS(p, old, val) (InterlockedCompareExchange((volatile LONG*)(p), (val), (old)) == (old))
+#define EVENT_ADD(p, v) (InterlockedExchangeAdd((volatile LONG*)(p), (v)) + (v))
+#else
+#define EVENT_CAS(p, old, val) __sync_bool_compare_and_swap((p), (old), (val))
+#define EVENT_ADD(p, v) __sync_add_and_fetch((p), (v))
+#endif
+
 SUSI_IOT_EVENT_CALLBACK IoT_callback = NULL; 
 
 typedef enum DATATYPE_T 
@@ -25,55 +41,309 @@ typedef struct DataRecord_t
 		char stringValue[20];
 		json_t* objectValue;
 	} data;
+	uint32_t version;	/* dataVersion when the value last changed */
+	int older;			/* Neighbours in version order */
+	int newer;
 } DataRecord;
 
 static json_t* jsonCapabilityPackage;
+
+/* Event payloads are written into a fixed pool instead of json_dumps(), so
+   the event rate has no effect on memory. A buffer is lent to the callback
+   with one reference, which is dropped when the callback returns; a
+   consumer that needs it longer takes its own with SusiIoTHoldMDEvent(). */
+typedef struct EventBuffer_t
+{
+	volatile long refs;
+	char payload[EVENT_PAYLOAD_MAX];
+} EventBuffer;
+
+static EventBuffer eventPool[EVENT_POOL_SIZE];
+static volatile long eventsDropped = 0;
+
+/* Records live in a growable array; an open-addressing index keyed by IoT ID
+   maps to them, so lookups do not depend on how many IDs a module has. The
+   index is a power of two and kept at most half full, and both double
+   together when the records run out. */
+static DataRecord* dataRecord = NULL;
 static int count = 0;
-static DataRecord dataRecord[DATA_MAX];
+static int capacity = 0;
+static int* dataIndex = NULL;
+static unsigned int indexMask = 0;
+
+/* Change feed: every value change takes the next version and moves its
+   record to the newest end of a list kept in version order, so the changes
+   since a cursor are read from that end without visiting the rest. A
+   cursor carries the epoch of the module instance that issued it in its
+   high half, the version in its low half. */
+static uint32_t dataVersion = 0;
+static uint32_t dataEpoch = 0;
+static int oldestRecord = INDEX_EMPTY;
+static int newestRecord = INDEX_EMPTY;
+
+static unsigned int hashId(int iotId)
+{
+	/* IDs share their high bytes, so mix the low bits up before masking */
+	unsigned int h = (unsigned int)iotId * 0x9E3779B1u;
+	return h ^ (h >> 16);
+}
+
+/* Slot holding iotId, or the empty slot where it belongs */
+static unsigned int findSlot(int iotId)
+{
+	unsigned int slot = hashId(iotId) & indexMask;
+
+	while (dataIndex[slot] != INDEX_EMPTY && dataRecord[dataIndex[slot]].id != iotId)
+	{
+		slot = (slot + 1) & indexMask;
+	}
+	return slot;
+}
 
 static int findIndex(int iotId)
 {
-	int i = 0;
-	for (; i < DATA_MAX; i++)
+	if (dataIndex == NULL)
+	{
+		return -1;
+	}
+	return dataIndex[findSlot(iotId)];
+}
+
+static int growDataRecord(void)
+{
+	int newCapacity = capacity ? capacity * 2 : DATA_INITIAL;
+	unsigned int slots = (unsigned int)newCapacity * 2;
+	DataRecord* records;
+	int* index;
+	int i;
+
+	records = (DataRecord*)realloc(dataRecord, sizeof(DataRecord) * newCapacity);
+	if (records == NULL)
+	{
+		return -1;
+	}
+	dataRecord = records;
+
+	index = (int*)malloc(sizeof(int) * slots);
+	if (index == NULL)
 	{
-		if (dataRecord[i].id == iotId)
+		return -1;
+	}
+	free(dataIndex);
+	dataIndex = index;
+	indexMask = slots - 1;
+	capacity = newCapacity;
+
+	for (i = 0; i < (int)slots; i++)
+	{
+		dataIndex[i] = INDEX_EMPTY;
+	}
+	for (i = 0; i < count; i++)
+	{
+		dataIndex[findSlot(dataRecord[i].id)] = i;
+	}
+	return 0;
+}
+
+static void touchDataRecord(int index)
+{
+	DataRecord* record = &dataRecord[index];
+
+	if (record->version != 0)
+	{
+		if (newestRecord == index)
+		{
+			record->version = ++dataVersion;
+			return;
+		}
+		if (record->older != INDEX_EMPTY)
+		{
+			dataRecord[record->older].newer = record->newer;
+		}
+		else
 		{
-			return i;
+			oldestRecord = record->newer;
 		}
+		dataRecord[record->newer].older = record->older;
 	}
-	return -1;
+
+	record->version = ++dataVersion;
+	record->older = newestRecord;
+	record->newer = INDEX_EMPTY;
+	if (newestRecord != INDEX_EMPTY)
+	{
+		dataRecord[newestRecord].newer = index;
+	}
+	else
+	{
+		oldestRecord = index;
+	}
+	newestRecord = index;
+}
+
+static void freeDataRecord(void)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		if (dataRecord[i].dataType == OBJECT)
+		{
+			json_decref(dataRecord[i].data.objectValue);
+		}
+	}
+	free(dataRecord);
+	free(dataIndex);
+	dataRecord = NULL;
+	dataIndex = NULL;
+	count = 0;
+	capacity = 0;
+	indexMask = 0;
+	oldestRecord = INDEX_EMPTY;
+	newestRecord = INDEX_EMPTY;
 }
 
+/* Add a record, or replace the value of one already registered for id */
 static void setDataRecord(DATATYPE type, int id, json_t* data)
 {
-	dataRecord[count].dataType = type;
-	dataRecord[count].id = id;
+	DataRecord* record;
+	union dataValue before;
+	int index = findIndex(id);
+
+	if (index == -1)
+	{
+		if (count == capacity && growDataRecord())
+		{
+			printf("SampleLib setDataRecord out of memory\n");
+			return;
+		}
+		index = count++;
+		dataIndex[findSlot(id)] = index;
+		dataRecord[index].id = id;
+		dataRecord[index].dataType = type;
+		dataRecord[index].version = 0;
+		memset(&dataRecord[index].data, 0, sizeof(dataRecord[index].data));
+		if (type == OBJECT)
+		{
+			dataRecord[index].data.objectValue = json_object();
+		}
+	}
+	else if (dataRecord[index].dataType != type)
+	{
+		printf("SampleLib setDataRecord type mismatch for 0x%08X\n", (unsigned int)id);
+		return;
+	}
+	record = &dataRecord[index];
+	before = record->data;
 
 	switch (type)
 	{
 		case INT:
 		{
-			dataRecord[count++].data.intValue = (int)json_integer_value(data);
+			record->data.intValue = (int)json_integer_value(data);
 			break;
 		}
 		case REAL:
 		{
-			dataRecord[count++].data.realValue = json_real_value(data);
+			record->data.realValue = json_real_value(data);
 			break;
 		}
 		case STRING:
 		{
-			SCPY(dataRecord[count++].data.stringValue, json_string_value(data));
+			SCPY(record->data.stringValue, json_string_value(data));
 			break;
 		}
 		case OBJECT:
 		{
-			json_object_update(dataRecord[count++].data.objectValue, data);
+			json_object_update(record->data.objectValue, data);
 			break;
 		}
 		default:
 			return;
 	}
+
+	if (record->version == 0 || type == OBJECT || memcmp(&before, &record->data, sizeof(before)) != 0)
+	{
+		touchDataRecord(index);
+	}
+}
+
+static EventBuffer* acquireEvent(void)
+{
+	int i = 0;
+
+	for (; i < EVENT_POOL_SIZE; i++)
+	{
+		if (eventPool[i].refs == 0 && EVENT_CAS(&eventPool[i].refs, 0, 1))
+		{
+			return &eventPool[i];
+		}
+	}
+	return NULL;
+}
+
+static EventBuffer* eventFromPayload(const char* jsonstr)
+{
+	const char* base = (const char*)eventPool;
+	size_t offset;
+
+	if (jsonstr < base || jsonstr >= base + sizeof(eventPool))
+	{
+		return NULL;
+	}
+	offset = (size_t)(jsonstr - base);
+	if (offset % sizeof(EventBuffer) != offsetof(EventBuffer, payload))
+	{
+		return NULL;
+	}
+	return &eventPool[offset / sizeof(EventBuffer)];
+}
+
+/* {"n":name,"v":value,"id":id,"msg":msg} without touching the heap */
+static int formatEvent(char* payload, const char* name, json_t* value, SusiIoTId_t id, const char* msg)
+{
+	size_t length = (size_t)snprintf(payload, EVENT_PAYLOAD_MAX, "{\"n\":\"%s\",\"v\":", name);
+	size_t n;
+
+	if (length >= EVENT_PAYLOAD_MAX)
+	{
+		return -1;
+	}
+	n = json_dumpb(value, payload + length, EVENT_PAYLOAD_MAX - length, JSON_ENCODE_ANY|JSON_COMPACT|JSON_REAL_PRECISION(5));
+	if (n == 0 || n >= EVENT_PAYLOAD_MAX - length)
+	{
+		return -1;
+	}
+	length += n;
+	n = (size_t)snprintf(payload + length, EVENT_PAYLOAD_MAX - length, ",\"id\":%u,\"msg\":\"%s\"}", (unsigned int)id, msg);
+	return n < EVENT_PAYLOAD_MAX - length ? 0 : -1;
+}
+
+static void sendEvent(const char* name, json_t* value, SusiIoTId_t id, const char* msg)
+{
+	EventBuffer* event;
+
+	if (IoT_callback == NULL)
+	{
+		return;
+	}
+
+	/* Pool empty or payload too long: drop rather than allocate */
+	event = acquireEvent();
+	if (event == NULL)
+	{
+		EVENT_ADD(&eventsDropped, 1);
+		return;
+	}
+	if (formatEvent(event->payload, name, value, id, msg) == 0)
+	{
+		IoT_callback(id, event->payload);
+	}
+	else
+	{
+		EVENT_ADD(&eventsDropped, 1);
+	}
+	SusiIoTReleaseMDEvent(event->payload);
 }
 
 static json_t* createInfo()
@@ -206,9 +476,28 @@ static json_t* createOEM()
 	return createIoTFuncPackageEx(ipsoPacks, ARRAYSIZE(ipsoPacks), "OEM Function 0", 0x81000F00);
 }
 
+/* Non-zero, so cursor 0 never matches, and kept to 31 bits, so a cursor
+   stays a positive JSON integer. The clock and a stack address (with ASLR)
+   tell apart two starts within the same second. */
+static uint32_t newEpoch(void)
+{
+	uint32_t local;
+	uint32_t epoch = (uint32_t)time(NULL) * 0x9E3779B1u;
+
+	epoch ^= (uint32_t)clock() ^ (uint32_t)((size_t)&local >> 4);
+	epoch = (epoch ^ (epoch >> 16)) & 0x7FFFFFFFu;
+	if (epoch == dataEpoch || epoch == 0)
+	{
+		epoch = dataEpoch % 0x7FFFFFFFu + 1;
+	}
+	return epoch;
+}
+
 SusiIoTStatus_t SUSI_IOT_API SusiIoTInitialize(void)
 {
 	json_t* funcPacks[5] = {0};
+
+	dataEpoch = newEpoch();
 	funcPacks[0] = createInfo();
 	funcPacks[1] = createHWM();
 	funcPacks[2] = createGPIO();
@@ -223,6 +512,7 @@ SusiIoTStatus_t SUSI_IOT_API SusiIoTInitialize(void)
 SusiIoTStatus_t SUSI_IOT_API SusiIoTUninitialize(void)
 {
 	freeJsonObject(&jsonCapabilityPackage);
+	freeDataRecord();
 	return SUSIIOT_STATUS_SUCCESS;
 }
 
@@ -281,6 +571,7 @@ SusiIoTStatus_t SUSI_IOT_API SusiIoTGetMDValue(SusiIoTId_t id, json_t *jValue)
 
 SusiIoTStatus_t SUSI_IOT_API SusiIoTSetMDValue(SusiIoTId_t id, json_t *jValue)
 {
+	union dataValue before;
 	int index = findIndex(id);
 
 	if (index == -1)
@@ -289,6 +580,7 @@ SusiIoTStatus_t SUSI_IOT_API SusiIoTSetMDValue(SusiIoTId_t id, json_t *jValue)
 		return SUSIIOT_STATUS_UNSUPPORTED;
 	}
 
+	before = dataRecord[index].data;
 	if (json_is_integer(jValue))
 	{
 		dataRecord[index].data.intValue = (int)json_integer_value(jValue);
@@ -311,12 +603,68 @@ SusiIoTStatus_t SUSI_IOT_API SusiIoTSetMDValue(SusiIoTId_t id, json_t *jValue)
 		return SUSIIOT_STATUS_ERROR;
 	}
 
+	if (json_is_object(jValue) || memcmp(&before, &dataRecord[index].data, sizeof(before)) != 0)
+	{
+		touchDataRecord(index);
+	}
+
 	if(id == 0x81000F01 && (int)json_integer_value(jValue) > 100)
 	{
-		json_t* temp = json_pack("{s:s, s:o, s:i, s:s}", "n", "OEM item 0", "v", jValue, "id", id, "msg", "Warning");
-		if(IoT_callback)
-			IoT_callback(0x81000F01, json_dumps(temp, JSON_PRESERVE_ORDER|JSON_REAL_PRECISION(5)));
+		sendEvent("OEM item 0", jValue, 0x81000F01, "Warning");
+	}
+
+	return SUSIIOT_STATUS_SUCCESS;
+}
+
+static json_t* packChange(const DataRecord* record)
+{
+	switch (record->dataType)
+	{
+		case INT:
+			return json_pack("{s:i, s:i, s:i}", "id", record->id, "v", record->data.intValue, "ver", (int)record->version);
+		case REAL:
+			return json_pack("{s:i, s:f, s:i}", "id", record->id, "v", record->data.realValue, "ver", (int)record->version);
+		case STRING:
+			return json_pack("{s:i, s:s, s:i}", "id", record->id, "sv", record->data.stringValue, "ver", (int)record->version);
+		case OBJECT:
+			return json_pack("{s:i, s:O, s:i}", "id", record->id, "v", record->data.objectValue, "ver", (int)record->version);
+		default:
+			return NULL;
+	}
+}
+
+SusiIoTStatus_t SUSI_IOT_API SusiIoTGetMDChanges(uint64_t cursor, json_t *changes)
+{
+	json_t* e;
+	int index = newestRecord;
+	uint32_t version = (uint32_t)cursor;
+
+	if (!json_is_object(changes))
+	{
+		return SUSIIOT_STATUS_INVALID_PARAMETER;
+	}
+
+	/* A cursor issued before a restart, or before the module was
+	   initialized again, counts versions that mean nothing now: everything */
+	if ((uint32_t)(cursor >> 32) != dataEpoch)
+	{
+		version = 0;
+	}
+
+	while (index != INDEX_EMPTY && dataRecord[index].version > version)
+	{
+		index = dataRecord[index].older;
 	}
+	index = index == INDEX_EMPTY ? oldestRecord : dataRecord[index].newer;
+
+	e = json_array();
+	for (; index != INDEX_EMPTY; index = dataRecord[index].newer)
+	{
+		json_array_append_new(e, packChange(&dataRecord[index]));
+	}
+
+	json_object_set_new(changes, "cursor", json_integer((json_int_t)(((uint64_t)dataEpoch << 32) | dataVersion)));
+	json_object_set_new(changes, "e", e);
 
 	return SUSIIOT_STATUS_SUCCESS;
 }
@@ -327,6 +675,33 @@ SusiIoTStatus_t SUSI_IOT_API SusiIoTSetMDEventHandler(SUSI_IOT_EVENT_CALLBACK ev
 	return SUSIIOT_STATUS_SUCCESS;
 }
 
+int SUSI_IOT_API SusiIoTHoldMDEvent(const char* jsonstr)
+{
+	EventBuffer* event = eventFromPayload(jsonstr);
+
+	if (event == NULL || event->refs <= 0)
+	{
+		return -1;
+	}
+	EVENT_ADD(&event->refs, 1);
+	return 0;
+}
+
+void SUSI_IOT_API SusiIoTReleaseMDEvent(const char* jsonstr)
+{
+	EventBuffer* event = eventFromPayload(jsonstr);
+
+	if (event != NULL && event->refs > 0)
+	{
+		EVENT_ADD(&event->refs, -1);
+	}
+}
+
+uint32_t SUSI_IOT_API SusiIoTGetMDEventDropped(void)
+{
+	return (uint32_t)eventsDropped;
+}
+
 uint8_t SUSI_IOT_API SusiIoTGetModuleID()
 {
 	return 0x81;
@@ -39,8 +39,23 @@ SusiIoTStatus_t SUSI_IOT_API SusiIoTGetMDCapability(json_t *capability);
 SusiIoTStatus_t SUSI_IOT_API SusiIoTGetMDValue(SusiIoTId_t id, json_t *jValue);
 SusiIoTStatus_t SUSI_IOT_API SusiIoTSetMDValue(SusiIoTId_t id, json_t *jValue);
 
+/* Items whose value changed after cursor, oldest first, as
+   {"cursor": n, "e": [{"id", "v" or "sv", "ver"}, ...]}. Each subscriber
+   keeps its own cursor: 0 the first time, then the "cursor" returned. A
+   cursor is only valid for the module instance that returned it; any
+   other gets every item again. */
+SusiIoTStatus_t SUSI_IOT_API SusiIoTGetMDChanges(uint64_t cursor, json_t *changes);
+
 SusiIoTStatus_t SUSI_IOT_API SusiIoTSetMDEventHandler(SUSI_IOT_EVENT_CALLBACK eventCallbackFun);
 
+/* The jsonstr given to the event callback belongs to the module's event
+   pool and goes back to it when the callback returns. To keep it longer,
+   hold it inside the callback and release it when done. Events that find
+   the pool empty are dropped and counted. */
+int SUSI_IOT_API SusiIoTHoldMDEvent(const char* jsonstr);
+void SUSI_IOT_API SusiIoTReleaseMDEvent(const char* jsonstr);
+uint32_t SUSI_IOT_API SusiIoTGetMDEventDropped(void);
+
 uint8_t SUSI_IOT_API SusiIoTGetModuleID();
 
 #ifdef __cplusplus
@@ -0,0 +1,327 @@
+#include "iot_cache.h"
+#include <string.h>
+
+#ifdef _MSC_VER
+    #define CACHE_LOCK_T CRITICAL_SECTION
+    #define CACHE_LOCK_INIT(l) InitializeCriticalSection(l)
+    #define CACHE_LOCK_FREE(l) DeleteCriticalSection(l)
+    #define CACHE_LOCK(l) EnterCriticalSection(l)
+    #define CACHE_UNLOCK(l) LeaveCriticalSection(l)
+#else
+    #include <pthread.h>
+    #include <time.h>
+    #define CACHE_LOCK_T pthread_mutex_t
+    #define CACHE_LOCK_INIT(l) pthread_mutex_init(l, NULL)
+    #define CACHE_LOCK_FREE(l) pthread_mutex_destroy(l)
+    #define CACHE_LOCK(l) pthread_mutex_lock(l)
+    #define CACHE_UNLOCK(l) pthread_mutex_unlock(l)
+#endif
+
+#define CACHE_INITIAL_SLOTS 64
+
+struct CacheEntry {
+    SusiIoTId_t id;
+    IoTCacheString *string;     /* NULL: empty slot */
+    uint64_t fetchedMs;
+};
+
+static CACHE_LOCK_T cacheLock;
+static bool cacheReady = false;
+static uint32_t maxAgeMs = 0;
+static uint32_t dataGeneration = 1;
+static uint32_t capabilityGeneration = 1;
+static IoTCacheString *capability = NULL;
+static CacheEntry *entries = NULL;
+static uint32_t slotMask = 0;
+static uint32_t used = 0;
+static uint32_t hits = 0;
+static uint32_t misses = 0;
+
+static uint64_t monotonicMs(void)
+{
+#ifdef _MSC_VER
+    return GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+#endif
+}
+
+/* Called with the lock held */
+static void releaseLocked(IoTCacheString *string)
+{
+    if (string != NULL && --string->refs == 0)
+    {
+        SusiIoTMemFree((void *)string->text);
+        free(string);
+    }
+}
+
+static IoTCacheString *wrap(const char *text, uint32_t generation)
+{
+    IoTCacheString *string;
+
+    if (text == NULL)
+    {
+        return NULL;
+    }
+
+    string = (IoTCacheString *)malloc(sizeof(IoTCacheString));
+    if (string == NULL)
+    {
+        SusiIoTMemFree((void *)text);
+        return NULL;
+    }
+    string->text = text;
+    string->generation = generation;
+    string->refs = 1;
+    return string;
+}
+
+static uint32_t hashId(SusiIoTId_t id)
+{
+    uint32_t h = id * 0x9E3779B1u;
+    return h ^ (h >> 16);
+}
+
+/* Slot holding id, or the empty slot where it belongs */
+static CacheEntry *findSlot(CacheEntry *table, uint32_t mask, SusiIoTId_t id)
+{
+    uint32_t slot = hashId(id) & mask;
+
+    while (table[slot].string != NULL && table[slot].id != id)
+    {
+        slot = (slot + 1) & mask;
+    }
+    return &table[slot];
+}
+
+/* Grow once half full so probes stay short; false when out of memory */
+static bool reserveLocked(void)
+{
+    uint32_t slots = slotMask ? (slotMask + 1) * 2 : CACHE_INITIAL_SLOTS;
+    CacheEntry *table;
+    uint32_t i;
+
+    if (entries != NULL && (used + 1) * 2 <= slotMask + 1)
+    {
+        return true;
+    }
+
+    table = (CacheEntry *)calloc(slots, sizeof(CacheEntry));
+    if (table == NULL)
+    {
+        return false;
+    }
+    for (i = 0; entries != NULL && i <= slotMask; i++)
+    {
+        if (entries[i].string != NULL)
+        {
+            *findSlot(table, slots - 1, entries[i].id) = entries[i];
+        }
+    }
+    free(entries);
+    entries = table;
+    slotMask = slots - 1;
+    return true;
+}
+
+void iotCacheInit(uint32_t dataMaxAgeMs)
+{
+    if (cacheReady)
+    {
+        return;
+    }
+    CACHE_LOCK_INIT(&cacheLock);
+    maxAgeMs = dataMaxAgeMs;
+    cacheReady = true;
+}
+
+void iotCacheUninit(void)
+{
+    uint32_t i;
+
+    if (!cacheReady)
+    {
+        return;
+    }
+
+    CACHE_LOCK(&cacheLock);
+    releaseLocked(capability);
+    capability = NULL;
+    for (i = 0; entries != NULL && i <= slotMask; i++)
+    {
+        releaseLocked(entries[i].string);
+    }
+    free(entries);
+    entries = NULL;
+    slotMask = 0;
+    used = 0;
+    CACHE_UNLOCK(&cacheLock);
+
+    CACHE_LOCK_FREE(&cacheLock);
+    cacheReady = false;
+}
+
+const IoTCacheString *iotCacheCapability(void)
+{
+    IoTCacheString *string;
+    uint32_t generation;
+
+    if (!cacheReady)
+    {
+        return NULL;
+    }
+
+    CACHE_LOCK(&cacheLock);
+    if (capability != NULL && capability->generation == capabilityGeneration)
+    {
+        capability->refs++;
+        hits++;
+        CACHE_UNLOCK(&cacheLock);
+        return capability;
+    }
+    generation = capabilityGeneration;
+    misses++;
+    CACHE_UNLOCK(&cacheLock);
+
+    /* Serialize without the lock; readers of other IDs are not held up */
+    string = wrap(SusiIoTGetPFCapabilityString(), generation);
+    if (string == NULL)
+    {
+        return NULL;
+    }
+
+    CACHE_LOCK(&cacheLock);
+    if (capability == NULL || capability->generation != capabilityGeneration)
+    {
+        releaseLocked(capability);
+        capability = string;
+        string->refs++;
+    }
+    CACHE_UNLOCK(&cacheLock);
+
+    return string;
+}
+
+const IoTCacheString *iotCacheData(SusiIoTId_t id)
+{
+    IoTCacheString *string;
+    CacheEntry *entry;
+    uint32_t generation;
+    uint64_t now;
+
+    if (!cacheReady)
+    {
+        return NULL;
+    }
+
+    CACHE_LOCK(&cacheLock);
+    now = monotonicMs();
+    if (entries != NULL)
+    {
+        entry = findSlot(entries, slotMask, id);
+        if (entry->string != NULL && entry->string->generation == dataGeneration
+            && (maxAgeMs == 0 || now - entry->fetchedMs < maxAgeMs))
+        {
+            entry->string->refs++;
+            hits++;
+            string = entry->string;
+            CACHE_UNLOCK(&cacheLock);
+            return string;
+        }
+    }
+    /* A write while fetching leaves this string already stale */
+    generation = dataGeneration;
+    misses++;
+    CACHE_UNLOCK(&cacheLock);
+
+    string = wrap(SusiIoTGetPFDataString(id), generation);
+    if (string == NULL)
+    {
+        return NULL;
+    }
+
+    CACHE_LOCK(&cacheLock);
+    if (reserveLocked())
+    {
+        entry = findSlot(entries, slotMask, id);
+        if (entry->string == NULL)
+        {
+            used++;
+        }
+        releaseLocked(entry->string);
+        entry->id = id;
+        entry->string = string;
+        entry->fetchedMs = now;
+        string->refs++;
+    }
+    CACHE_UNLOCK(&cacheLock);
+
+    return string;
+}
+
+void iotCacheRelease(const IoTCacheString *string)
+{
+    if (string == NULL)
+    {
+        return;
+    }
+    CACHE_LOCK(&cacheLock);
+    releaseLocked((IoTCacheString *)string);
+    CACHE_UNLOCK(&cacheLock);
+}
+
+void iotCacheInvalidate(bool capabilityToo)
+{
+    if (!cacheReady)
+    {
+        return;
+    }
+    CACHE_LOCK(&cacheLock);
+    dataGeneration++;
+    if (capabilityToo)
+    {
+        capabilityGeneration++;
+    }
+    CACHE_UNLOCK(&cacheLock);
+}
+
+SusiIoTStatus_t iotCacheSetPFData(json_t *data)
+{
+    SusiIoTStatus_t status = SusiIoTSetPFData(data);
+    iotCacheInvalidate(false);
+    return status;
+}
+
+SusiIoTStatus_t iotCacheSetPFDataString(const char *jsonString)
+{
+    SusiIoTStatus_t status = SusiIoTSetPFDataString(jsonString);
+    iotCacheInvalidate(false);
+    return status;
+}
+
+/* A value also shows in the data strings of every group above it, so any
+ * write moves the whole data generation on */
+SusiIoTStatus_t iotCacheSetValue(SusiIoTId_t id, json_t *jValue)
+{
+    SusiIoTStatus_t status = SusiIoTSetValue(id, jValue);
+    iotCacheInvalidate(false);
+    return status;
+}
+
+void iotCacheGetStats(IoTCacheStats *stats)
+{
+    if (!cacheReady)
+    {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    CACHE_LOCK(&cacheLock);
+    stats->hits = hits;
+    stats->misses = misses;
+    stats->dataGeneration = dataGeneration;
+    stats->capabilityGeneration = capabilityGeneration;
+    CACHE_UNLOCK(&cacheLock);
+}
@@ -0,0 +1,53 @@
+#ifndef _IOT_CACHE_H_
+#define _IOT_CACHE_H_
+
+#include "common.h"
+
+/* Cache of the SusiIoT string getters. SusiIoTGetPFCapabilityString() and
+ * SusiIoTGetPFDataString() serialize the whole tree on every call; here the
+ * result is kept and handed to every caller as one shared, refcounted
+ * string until its generation moves on. The capability generation only
+ * moves on iotCacheInvalidate(true) (a module was added or reloaded). The
+ * data generation moves on every write made through the iotCacheSet*
+ * wrappers and on iotCacheInvalidate(false), which the event handler calls.
+ * Sensor values also change on their own, so data strings older than the
+ * maximum age are fetched again; an age of 0 trusts the generation alone.
+ *
+ * Every string returned must be given back with iotCacheRelease(); it stays
+ * valid until then even if the cache has moved on.
+ */
+
+typedef struct IoTCacheString {
+    const char *text;
+    uint32_t generation;
+    uint32_t refs;          /* Owned by the cache */
+} IoTCacheString;
+
+typedef struct IoTCacheStats {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t dataGeneration;
+    uint32_t capabilityGeneration;
+} IoTCacheStats;
+
+#define IOT_CACHE_DEFAULT_MAX_AGE_MS 1000
+
+/* After SusiIoTInitialize() */
+void iotCacheInit(uint32_t dataMaxAgeMs);
+/* Before SusiIoTUninitialize(), once every string has been released */
+void iotCacheUninit(void);
+
+const IoTCacheString *iotCacheCapability(void);
+const IoTCacheString *iotCacheData(SusiIoTId_t id);
+void iotCacheRelease(const IoTCacheString *string);
+
+void iotCacheInvalidate(bool capabilityToo);
+
+/* The SusiIoT setters, moving the data generation on */
+SusiIoTStatus_t iotCacheSetPFData(json_t *data);
+SusiIoTStatus_t iotCacheSetPFDataString(const char *jsonString);
+SusiIoTStatus_t iotCacheSetValue(SusiIoTId_t id, json_t *jValue);
+
+void iotCacheGetStats(IoTCacheStats *stats);
+
+#endif /* _IOT_CACHE_H_ */
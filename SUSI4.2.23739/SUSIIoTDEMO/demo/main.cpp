@@ -1,5 +1,7 @@
 #define _CRT_SECURE_NO_DEPRECATE
 #include "common.h"
+#include "iot_cache.h"
+#include "uri_index.h"
 
 enum MENU_OPTIONS {
     OPT_EXIT                   = 0,
@@ -159,6 +161,14 @@ static void testfunction()
     json_decref(susi_iot);
     ret = PAUSE();
 
+    printf("Test SusiIoTGetPFCapabilityString (cached)\r\n");
+    for(int i = 0; i < count; i++)
+    {
+        printf("\r%.2f %%", i * (100 / (float)count));
+        iotCacheRelease(iotCacheCapability());
+    }
+    ret = PAUSE();
+
     printf("Test SusiIoTGetPFData\r\n");
     json_t *jtmp = json_object();
     for(int i = 0; i < count; i++)
@@ -182,7 +192,7 @@ static void testfunction()
         {
             //printf("SusiIoTGetPFData failed. \n");
         }
-        if(SusiIoTSetPFData(jtmp) != 0)
+        if(iotCacheSetPFData(jtmp) != 0)
         {
             //printf("SusiIoTSetPFData failed. \n");
         }
@@ -210,7 +220,7 @@ static void testfunction()
     for(int i = 0; i < count; i++)
     {
         printf("\r%.2f %%", i * (100 / (float)count));
-        if(SusiIoTSetValue(131072, jsonSet) != 0)
+        if(iotCacheSetValue(131072, jsonSet) != 0)
         {
             //printf("SusiIoTSetValue failed. \n");
         }
@@ -266,8 +276,9 @@ static SusiIoTStatus_t exec_by_menu()
         }
         else if(op == OPT_CAPABILITY_STRING)
         {
-            buffer = SusiIoTGetPFCapabilityString();
-            printf("%s\n", buffer);
+            const IoTCacheString *cached = iotCacheCapability();
+            printf("%s\n", cached != NULL ? cached->text : "(null)");
+            iotCacheRelease(cached);
         }
         else if(op == OPT_GET_DATA_OBJECT)
         {
@@ -293,8 +304,9 @@ static SusiIoTStatus_t exec_by_menu()
         {
             printf("id: ");
             SCANF("%d", &id);
-            buffer = SusiIoTGetPFDataString(id);
-            printf("%s\n", buffer);
+            const IoTCacheString *cached = iotCacheData(id);
+            printf("%s\n", cached != NULL ? cached->text : "(null)");
+            iotCacheRelease(cached);
         }
         else if(op == OPT_GET_DATA_OBJECT_BY_URI)
         {
@@ -304,7 +316,7 @@ static SusiIoTStatus_t exec_by_menu()
             getchar();  // clear scanf input buffer
             SCANF("%[^\n]", uri);
 
-            if(SusiIoTGetPFDataByUri(uri, jtmp) != 0)
+            if(uriIndexGetData(uri, jtmp) != 0)
             {
                 printf("SusiIoTGetPFData failed. \n");
             }
@@ -322,8 +334,17 @@ static SusiIoTStatus_t exec_by_menu()
             printf("uri: ");
             getchar();  // clear scanf input buffer
             scanf("%[^\n]", uri);
-            buffer = SusiIoTGetPFDataStringByUri(uri);
-            printf("%s\n", buffer);
+            const IoTCacheString *cached;
+            const char *text = uriIndexGetDataString(uri, &cached);
+            printf("%s\n", text != NULL ? text : "(null)");
+            if (cached != NULL)
+            {
+                iotCacheRelease(cached);
+            }
+            else
+            {
+                buffer = text;
+            }
         }
         else if(op == OPT_GET_DATA_VALUE)
         {
@@ -356,7 +377,7 @@ static SusiIoTStatus_t exec_by_menu()
             }
             printf("SusiIoTGetPFData\n");
             PAUSE();
-            if(SusiIoTSetPFData(jtmp) != 0)
+            if(iotCacheSetPFData(jtmp) != 0)
             {
                 printf("SusiIoTSetPFData failed. \n");
             }
@@ -378,7 +399,7 @@ static SusiIoTStatus_t exec_by_menu()
 
             buffer = json_dumps(jtmp, 0);
             printf("%s\n", buffer);
-            if(SusiIoTSetPFDataString(buffer) != 0)
+            if(iotCacheSetPFDataString(buffer) != 0)
             {
                 printf("SusiIoTSetPFData failed. \n");
             }
@@ -391,7 +412,7 @@ static SusiIoTStatus_t exec_by_menu()
             uint32_t id = 0;
             json_t *jsonObject = setDataJson(id);
 
-            if(SusiIoTSetValue(id, jsonObject) != 0)
+            if(iotCacheSetValue(id, jsonObject) != 0)
             {
                 printf("SusiIoTSetValue Failed. \n");
             }
@@ -585,6 +606,7 @@ static SusiIoTStatus_t exec_by_args(const int argc, char **argv)
 void SUSI_IOT_API EventCallBack(SusiIoTId_t id, char *jsonstr)
 {
     printf("EventCallBack\nId:0x%d\nData:%s\n", id, jsonstr);
+    iotCacheInvalidate(false);
 }
 
 int main(int argc, char **argv)
@@ -599,6 +621,15 @@ int main(int argc, char **argv)
         return status;
     }
 
+    iotCacheInit(IOT_CACHE_DEFAULT_MAX_AGE_MS);
+
+    json_t *capability = json_object();
+    if (SusiIoTGetPFCapability(capability) != SUSIIOT_STATUS_SUCCESS || !uriIndexBuild(capability))
+    {
+        printf("URI index unavailable, URIs resolve through SusiIoT\n");
+    }
+    json_decref(capability);
+
     SusiIoTSetPFEventHandler(EventCallBack);
 
     if ( argc > 1 )
@@ -610,6 +641,8 @@ int main(int argc, char **argv)
         status = exec_by_menu();
     }
 
+    uriIndexFree();
+    iotCacheUninit();
     SusiIoTUninitialize();
 
     return status;
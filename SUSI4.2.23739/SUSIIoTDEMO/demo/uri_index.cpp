@@ -0,0 +1,260 @@
+#include "uri_index.h"
+#include <string.h>
+
+#define URI_NO_NODE -1
+
+/* Children of a node are a sibling list; capability levels are narrow */
+struct UriNode {
+    uint32_t name;          /* Offset of the segment in names */
+    uint32_t length;
+    int32_t child;
+    int32_t sibling;
+    SusiIoTId_t id;
+    bool hasId;
+};
+
+static UriNode *nodes = NULL;
+static uint32_t nodeCount = 0;
+static uint32_t nodeCapacity = 0;
+static char *names = NULL;
+static uint32_t namesUsed = 0;
+static uint32_t namesCapacity = 0;
+static uint32_t idCount = 0;
+static bool buildFailed = false;
+
+static int32_t findChild(int32_t parent, const char *segment, uint32_t length)
+{
+    int32_t node = nodes[parent].child;
+
+    while (node != URI_NO_NODE
+        && (nodes[node].length != length || memcmp(names + nodes[node].name, segment, length) != 0))
+    {
+        node = nodes[node].sibling;
+    }
+    return node;
+}
+
+static int32_t newNode(const char *segment, uint32_t length)
+{
+    UriNode *node;
+
+    if (nodeCount == nodeCapacity)
+    {
+        uint32_t capacity = nodeCapacity ? nodeCapacity * 2 : 64;
+        UriNode *grown = (UriNode *)realloc(nodes, capacity * sizeof(UriNode));
+        if (grown == NULL)
+        {
+            return URI_NO_NODE;
+        }
+        nodes = grown;
+        nodeCapacity = capacity;
+    }
+    if (namesUsed + length > namesCapacity)
+    {
+        uint32_t capacity = namesCapacity ? namesCapacity : 1024;
+        char *grown;
+
+        while (capacity < namesUsed + length)
+        {
+            capacity *= 2;
+        }
+        grown = (char *)realloc(names, capacity);
+        if (grown == NULL)
+        {
+            return URI_NO_NODE;
+        }
+        names = grown;
+        namesCapacity = capacity;
+    }
+
+    node = &nodes[nodeCount];
+    node->name = namesUsed;
+    node->length = length;
+    node->child = URI_NO_NODE;
+    node->sibling = URI_NO_NODE;
+    node->id = 0;
+    node->hasId = false;
+    memcpy(names + namesUsed, segment, length);
+    namesUsed += length;
+    return (int32_t)nodeCount++;
+}
+
+static int32_t addChild(int32_t parent, const char *segment)
+{
+    uint32_t length = (uint32_t)strlen(segment);
+    int32_t node = findChild(parent, segment, length);
+
+    if (node != URI_NO_NODE)
+    {
+        return node;
+    }
+    node = newNode(segment, length);
+    if (node == URI_NO_NODE)
+    {
+        buildFailed = true;
+        return URI_NO_NODE;
+    }
+    nodes[node].sibling = nodes[parent].child;
+    nodes[parent].child = node;
+    return node;
+}
+
+static void setId(int32_t node, json_t *object)
+{
+    json_t *id = json_object_get(object, "id");
+
+    if (json_is_integer(id) && !nodes[node].hasId)
+    {
+        nodes[node].id = (SusiIoTId_t)json_integer_value(id);
+        nodes[node].hasId = true;
+        idCount++;
+    }
+}
+
+static void addObject(int32_t parent, json_t *object)
+{
+    const char *key;
+    json_t *value;
+    size_t i;
+
+    json_object_foreach(object, key, value)
+    {
+        if (buildFailed)
+        {
+            return;
+        }
+
+        if (json_is_object(value))
+        {
+            int32_t node = addChild(parent, key);
+            if (node != URI_NO_NODE)
+            {
+                setId(node, value);
+                addObject(node, value);
+            }
+        }
+        else if (json_is_array(value) && strcmp(key, "e") == 0)
+        {
+            for (i = 0; i < json_array_size(value); i++)
+            {
+                json_t *element = json_array_get(value, i);
+                json_t *name = json_object_get(element, "n");
+                int32_t node;
+
+                if (!json_is_object(element) || !json_is_string(name))
+                {
+                    continue;
+                }
+                node = addChild(parent, json_string_value(name));
+                if (node != URI_NO_NODE)
+                {
+                    setId(node, element);
+                }
+            }
+        }
+    }
+}
+
+void uriIndexFree(void)
+{
+    free(nodes);
+    free(names);
+    nodes = NULL;
+    names = NULL;
+    nodeCount = nodeCapacity = 0;
+    namesUsed = namesCapacity = 0;
+    idCount = 0;
+}
+
+bool uriIndexBuild(json_t *capability)
+{
+    uriIndexFree();
+    buildFailed = false;
+
+    if (!json_is_object(capability) || newNode("", 0) == URI_NO_NODE)
+    {
+        uriIndexFree();
+        return false;
+    }
+    addObject(0, capability);
+
+    if (buildFailed)
+    {
+        uriIndexFree();
+        return false;
+    }
+    return true;
+}
+
+bool uriIndexLookup(const char *uri, SusiIoTId_t *id)
+{
+    int32_t node = 0;
+    const char *end;
+
+    if (nodes == NULL || uri == NULL)
+    {
+        return false;
+    }
+
+    for (;;)
+    {
+        while (*uri == '/')
+        {
+            uri++;
+        }
+        if (*uri == '\0')
+        {
+            break;
+        }
+        end = strchr(uri, '/');
+        if (end == NULL)
+        {
+            end = uri + strlen(uri);
+        }
+        node = findChild(node, uri, (uint32_t)(end - uri));
+        if (node == URI_NO_NODE)
+        {
+            return false;
+        }
+        uri = end;
+    }
+
+    if (node == 0 || !nodes[node].hasId)
+    {
+        return false;
+    }
+    *id = nodes[node].id;
+    return true;
+}
+
+uint32_t uriIndexCount(void)
+{
+    return idCount;
+}
+
+SusiIoTStatus_t uriIndexGetData(const char *uri, json_t *data)
+{
+    SusiIoTId_t id;
+
+    if (uriIndexLookup(uri, &id))
+    {
+        return SusiIoTGetPFData(id, data);
+    }
+    return SusiIoTGetPFDataByUri(uri, data);
+}
+
+const char *uriIndexGetDataString(const char *uri, const IoTCacheString **cached)
+{
+    SusiIoTId_t id;
+
+    *cached = NULL;
+    if (uriIndexLookup(uri, &id))
+    {
+        *cached = iotCacheData(id);
+        if (*cached != NULL)
+        {
+            return (*cached)->text;
+        }
+    }
+    return SusiIoTGetPFDataStringByUri(uri);
+}
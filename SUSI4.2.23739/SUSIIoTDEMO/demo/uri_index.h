@@ -0,0 +1,30 @@
+#ifndef _URI_INDEX_H_
+#define _URI_INDEX_H_
+
+#include "common.h"
+#include "iot_cache.h"
+
+/* URI index over the capability document. A URI is the path of object keys
+ * from the top of the capability, with the elements of an "e" array named
+ * by their "n", e.g. "Hardware Monitor/Temperature/CPU"; a leading or
+ * trailing '/' is ignored. Every path with an "id" is put in a trie once, at
+ * build time, so resolving one is a walk over its segments with no JSON and
+ * no allocation. URIs the index does not know go to the SusiIoT resolver.
+ */
+
+/* From the document SusiIoTGetPFCapability() fills; again after a module
+ * reload. False when out of memory, leaving the index empty. */
+bool uriIndexBuild(json_t *capability);
+void uriIndexFree(void);
+
+bool uriIndexLookup(const char *uri, SusiIoTId_t *id);
+uint32_t uriIndexCount(void);
+
+/* SusiIoTGetPFDataByUri through the index */
+SusiIoTStatus_t uriIndexGetData(const char *uri, json_t *data);
+/* SusiIoTGetPFDataStringByUri through the index and the string cache. The
+ * text goes back with iotCacheRelease(*cached), or with SusiIoTMemFree()
+ * when *cached comes back NULL. */
+const char *uriIndexGetDataString(const char *uri, const IoTCacheString **cached);
+
+#endif /* _URI_INDEX_H_ */
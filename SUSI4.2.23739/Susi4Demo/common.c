@@ -1,5 +1,9 @@
 #include "common.h"
 
+#if defined(_LINUX) || defined(__QNX__)
+#include <time.h>
+#endif
+
 void get_susi4_id_name(SusiId_t mapped_id, char *pname)
 {
 	/* the length of *pname must be NAME_MAXIMUM_LENGTH */
@@ -117,3 +121,17 @@ int clr_screen(void)
 {
 	return system(CLRSCR);
 }
+
+uint64_t get_tick_usec(void)
+{
+#if defined(_LINUX) || defined(__QNX__)
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+#elif defined(WIN32) || defined(_WIN64) || defined(WINCE)
+	return (uint64_t)GetTickCount() * 1000;
+#else
+	return 0;	/* no tick source */
+#endif
+}
@@ -59,5 +59,6 @@ int input_uint(uint32_t *psetVal, uint8_t base, uint32_t maxVal, uint32_t minVal
 int input_byte_sequence(uint8_t *pbuffer, uint32_t length, uint8_t base, uint8_t maxVal, uint8_t minVal);
 int wait_enter(void);
 int clr_screen(void);
+uint64_t get_tick_usec(void);	/* monotonic, for elapsed times only */
 
 #endif /*_SUSI_COMMON_H_*/
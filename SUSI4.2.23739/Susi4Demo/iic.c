@@ -65,9 +65,25 @@ enum funcFrequencyRank{
 	funcFrequencySet100,
 	funcFrequencySet400,
 	funcFrequencyGet,
+	funcFrequencyBenchmark,
 	NumFuncFrequency,
 };
 
+/* Frequencies swept by the benchmark (kHz); the driver rejects the ones the
+   host does not support */
+static const uint32_t benchFrequencies[] = {10, 50, 100, 400, 1000};
+
+#define BENCH_MAX_LENGTH	32
+
+struct I2CBenchResult{
+	uint32_t freq;		/* requested */
+	uint32_t actual;	/* read back from the driver */
+	SusiStatus_t status;	/* SusiI2CSetFrequency() */
+	uint32_t rounds;
+	uint32_t errors;	/* failed transfers and data mismatches */
+	uint64_t busUsec;	/* time spent in transfers, delays excluded */
+};
+
 uint8_t iic_init(void)
 {
 	SusiStatus_t status;
@@ -624,6 +640,168 @@ pause:
 	}
 }
 
+static void bench_pattern(uint8_t *data, uint32_t len, uint32_t round, uint32_t freq)
+{
+	uint32_t seed = round * 0x9E3779B1u ^ freq;
+	uint32_t i;
+
+	/* Alternate inverted bytes so both levels are driven on every bit */
+	for (i = 0; i < len; i++)
+	{
+		seed = seed * 1103515245u + 12345u;
+		data[i] = (uint8_t)(seed >> 16);
+		if (i & 1)
+			data[i] = (uint8_t)~data[i - 1];
+	}
+}
+
+static void bench_run(SusiId_t id, uint32_t addr, uint32_t cmd, uint32_t len, uint32_t delay,
+	struct I2CBenchResult *result)
+{
+	uint8_t wdata[BENCH_MAX_LENGTH], rdata[BENCH_MAX_LENGTH];
+	SusiStatus_t status;
+	uint64_t start;
+	uint32_t r;
+
+	for (r = 0; r < result->rounds; r++)
+	{
+		bench_pattern(wdata, len, r, result->freq);
+
+		start = get_tick_usec();
+		status = SusiI2CWriteTransfer(id, addr, cmd, wdata, len);
+		result->busUsec += get_tick_usec() - start;
+		if (status != SUSI_STATUS_SUCCESS)
+		{
+			result->errors++;
+			continue;
+		}
+
+		if (delay)
+			SLEEP_USEC(delay);
+
+		start = get_tick_usec();
+		status = SusiI2CReadTransfer(id, addr, cmd, rdata, len);
+		result->busUsec += get_tick_usec() - start;
+		if (status != SUSI_STATUS_SUCCESS || memcmp(wdata, rdata, len) != 0)
+			result->errors++;
+	}
+}
+
+static uint8_t iic_frequency_benchmark(uint8_t iDevice)
+{
+	SusiId_t id = devids[iDevice];
+	SusiStatus_t status;
+	struct I2CBenchResult results[NELEMS(benchFrequencies)];
+	uint8_t backup[BENCH_MAX_LENGTH];
+	uint32_t addr, cmd, len, rounds, delay, keep;
+	uint32_t original, best, i;
+
+	printf(
+		"The benchmark writes test patterns to the device and reads them back\n"
+		"at every frequency. Use a scratch register range; its contents are\n"
+		"restored afterwards.\n\n");
+
+	printf("7-bit Slave Address: 0x");
+	if (input_uint(&addr, 16, 0xFF, 0x00))
+		goto invalid;
+
+	printf("Byte Command (register): 0x");
+	if (input_uint(&cmd, 16, 0xFF, 0x00))
+		goto invalid;
+
+	printf("Pattern Length (%u to %u): ", 1, BENCH_MAX_LENGTH);
+	if (input_uint(&len, 10, BENCH_MAX_LENGTH, 1))
+		goto invalid;
+
+	printf("Rounds per frequency (%u to %u): ", 1, 10000);
+	if (input_uint(&rounds, 10, 10000, 1))
+		goto invalid;
+
+	printf("Delay after each write in ms, e.g. 5 for an EEPROM (%u to %u): ", 0, 100);
+	if (input_uint(&delay, 10, 100, 0))
+		goto invalid;
+
+	printf("Keep the fastest reliable frequency? (0: No, 1: Yes): ");
+	if (input_uint(&keep, 10, 1, 0))
+		goto invalid;
+
+	status = SusiI2CGetFrequency(id, &original);
+	if (status != SUSI_STATUS_SUCCESS)
+	{
+		printf("Get no frequency. (0x%08X)\n", status);
+		return SUSIDEMO_PRINT_ERROR;
+	}
+
+	status = SusiI2CReadTransfer(id, addr, cmd, backup, len);
+	if (status != SUSI_STATUS_SUCCESS)
+	{
+		printf("Device does not respond at %u kHz. (0x%08X)\n", original, status);
+		return SUSIDEMO_PRINT_ERROR;
+	}
+
+	printf("\n%9s %9s %7s %7s %8s %12s\n", "Set(kHz)", "Got(kHz)", "Rounds", "Errors", "Error%", "Bytes/s");
+	for (i = 0; i < NELEMS(benchFrequencies); i++)
+	{
+		struct I2CBenchResult *result = &results[i];
+
+		memset(result, 0, sizeof(*result));
+		result->freq = benchFrequencies[i];
+		result->rounds = rounds;
+		result->status = SusiI2CSetFrequency(id, result->freq);
+		if (result->status != SUSI_STATUS_SUCCESS)
+		{
+			printf("%9u %9s (unsupported, 0x%08X)\n", result->freq, "-", result->status);
+			continue;
+		}
+		if (SusiI2CGetFrequency(id, &result->actual) != SUSI_STATUS_SUCCESS)
+			result->actual = result->freq;
+
+		bench_run(id, addr, cmd, len, delay, result);
+
+		printf("%9u %9u %7u %7u %7.2f%% ", result->freq, result->actual, result->rounds, result->errors,
+			100.0 * result->errors / result->rounds);
+		if (result->busUsec)
+			printf("%12.0f\n", 2.0 * len * (result->rounds - result->errors) * 1000000.0 / result->busUsec);
+		else
+			printf("%12s\n", "-");
+	}
+
+	/* Put the data back at the frequency the bus came up with */
+	SusiI2CSetFrequency(id, original);
+	status = SusiI2CWriteTransfer(id, addr, cmd, backup, len);
+	if (status != SUSI_STATUS_SUCCESS)
+		printf("\nRestoring the register contents failed. (0x%08X)\n", status);
+
+	best = NELEMS(benchFrequencies);
+	for (i = 0; i < NELEMS(benchFrequencies); i++)
+	{
+		if (results[i].status != SUSI_STATUS_SUCCESS || results[i].errors)
+			continue;
+		if (best == NELEMS(benchFrequencies) || results[i].actual > results[best].actual)
+			best = i;
+	}
+
+	if (best == NELEMS(benchFrequencies))
+	{
+		printf("\nNo frequency passed without errors; staying at %u kHz.\n", original);
+		return SUSIDEMO_PRINT_ERROR;
+	}
+
+	printf("\nFastest reliable frequency: %u kHz", results[best].actual);
+	if (!keep)
+	{
+		printf(" (bus left at %u kHz)\n", original);
+		return SUSIDEMO_PRINT_SUCCESS;
+	}
+	printf("\n");
+
+	return set_frequency(iDevice, results[best].freq);
+
+invalid:
+	printf("Invalid input\n");
+	return SUSIDEMO_PRINT_ERROR;
+}
+
 static void menu_frequency(int8_t *manuItem, uint8_t numManuItem, uint32_t freq)
 {
 	if (freq)
@@ -636,6 +814,7 @@ static void menu_frequency(int8_t *manuItem, uint8_t numManuItem, uint32_t freq)
 		"1) Set 1 to 100 kHz\n"
 		"2) Set 400 kHz\n"
 		"3) Get/Refresh\n"
+		"4) Benchmark\n"
 		"\nEnter your choice: ");
 	fflush(stdout);
 }
@@ -687,6 +866,11 @@ static uint8_t iic_frequency_loop(uint8_t iDevice, const char *devName)
 			if (get_frequency(iDevice, &freq))
 				goto pause;
 			continue;
+
+		case funcFrequencyBenchmark:
+			iic_frequency_benchmark(iDevice);
+			get_frequency(iDevice, &freq);
+			goto pause;
 		}
 unknown:
 		printf("Unknown choice!\n");
@@ -1,25 +1,76 @@
 #include "common.h"
 
+#if defined(_LINUX) || defined(__QNX__)
+#include <pthread.h>
+#define MAIN_INIT_THREADS
+#endif
+
+/* Subsystem probes run concurrently on this many threads (1 = one after another) */
+#define MAIN_INIT_WORKERS	4
+
+enum {
+	pageWdog = 0,
+	pageHwm,
+	pageSfan,
+	pageGpio,
+	pageVga,
+	pageSmb,
+	pageIic,
+	pageStorage,
+	pageThmprot,
+	pageSet,
+	pageInfo,
+	pageCount
+};
+
+#define PAGE_BIT(_page)	(1u << (_page))
+
 struct SusiPage {
 	const char *name;
 	uint8_t (*pfuncinit) (void);	/* returns 0 if device is not available */
 	void (*pfuncmain) (void);
+	uint32_t after;					/* PAGE_BITs of the pages whose init must finish first */
 };
 
+/*
+ * Every init only fills its own module's state, so the probes are
+ * independent apart from the bus they share: I2C and SMBus go through the
+ * same EC host controller on most boards, so the I2C probe waits for the
+ * SMBus one. Pages that others depend on come first in the table.
+ */
 static struct SusiPage page_tbl[] = {
-	{"Watch Dog",			wdog_init,		wdog_main},
-	{"HWM",					hwm_init,		hwm_main},
-	{"Smart Fan",			sfan_init,		sfan_main},
-	{"GPIO",				gpio_init,		gpio_main},
-	{"VGA",					vga_init,		vga_main},
-	{"SMBus",				smb_init,		smb_main},
-	{"I2C",					iic_init,		iic_main},
-	{"Storage",				storage_init,	storage_main},
-	{"Thermal Protection",	thmprot_init,	thmprot_main},
-	{"Intel Set Function",	set_init,		set_main},
-	{"Information",			info_init,		info_main},
+	[pageWdog]		= {"Watch Dog",				wdog_init,		wdog_main,		0},
+	[pageHwm]		= {"HWM",					hwm_init,		hwm_main,		0},
+	[pageSfan]		= {"Smart Fan",				sfan_init,		sfan_main,		0},
+	[pageGpio]		= {"GPIO",					gpio_init,		gpio_main,		0},
+	[pageVga]		= {"VGA",					vga_init,		vga_main,		0},
+	[pageSmb]		= {"SMBus",					smb_init,		smb_main,		0},
+	[pageIic]		= {"I2C",					iic_init,		iic_main,		PAGE_BIT(pageSmb)},
+	[pageStorage]	= {"Storage",				storage_init,	storage_main,	0},
+	[pageThmprot]	= {"Thermal Protection",	thmprot_init,	thmprot_main,	0},
+	[pageSet]		= {"Intel Set Function",	set_init,		set_main,		0},
+	[pageInfo]		= {"Information",			info_init,		info_main,		0},
+};
+
+/* Outcome and duration of each page's init */
+struct PageInit {
+	uint8_t available;
+	uint64_t startUsec;
+	uint64_t endUsec;
 };
 
+static struct PageInit page_init[NELEMS(page_tbl)];
+static uint32_t init_started, init_done;	/* PAGE_BITs */
+static uint8_t init_workers;
+static uint64_t start_usec;		/* main() entered */
+static uint64_t lib_usec;		/* SusiLibInitialize() returned */
+static uint64_t ready_usec;		/* every probe finished */
+
+#ifdef MAIN_INIT_THREADS
+static pthread_mutex_t init_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t init_cond = PTHREAD_COND_INITIALIZER;
+#endif
+
 static int8_t options2pages[NELEMS(page_tbl) + 1];	/* page_num + exit */
 static const uint8_t maxpageoption = NELEMS(options2pages);
 
@@ -36,15 +87,104 @@ static void main_title(void)
 #define SUSIDEMO_MAIN_PAGES_EXIT		SUSIDEMO_FUNCTIONS_GOBACK
 #define SUSIDEMO_MAIN_PAGES_UNDEFINED	SUSIDEMO_FUNCTIONS_UNDEFINED
 
+/* Next page whose dependencies are done, -1 if none is ready yet */
+static int8_t init_next(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < NELEMS(page_tbl); i++)
+	{
+		if ((init_started & PAGE_BIT(i)) == 0 && (page_tbl[i].after & ~init_done) == 0)
+			return (int8_t)i;
+	}
+
+	return -1;
+}
+
+static void init_page(uint8_t i)
+{
+	page_init[i].startUsec = get_tick_usec();
+	page_init[i].available = page_tbl[i].pfuncinit();
+	page_init[i].endUsec = get_tick_usec();
+}
+
+#ifdef MAIN_INIT_THREADS
+static void *init_worker(void *arg)
+{
+	const uint32_t all = PAGE_BIT(NELEMS(page_tbl)) - 1;
+	int8_t i;
+
+	(void)arg;
+	pthread_mutex_lock(&init_lock);
+	while (init_started != all)
+	{
+		i = init_next();
+		if (i < 0)
+		{
+			pthread_cond_wait(&init_cond, &init_lock);
+			continue;
+		}
+
+		init_started |= PAGE_BIT(i);
+		pthread_mutex_unlock(&init_lock);
+		init_page((uint8_t)i);
+		pthread_mutex_lock(&init_lock);
+		init_done |= PAGE_BIT(i);
+		pthread_cond_broadcast(&init_cond);
+	}
+	pthread_mutex_unlock(&init_lock);
+
+	return NULL;
+}
+#endif
+
+static void init_pages(void)
+{
+#ifdef MAIN_INIT_THREADS
+	pthread_t threads[MAIN_INIT_WORKERS];
+	uint8_t i, created = 0;
+
+	/* The calling thread is one of the workers */
+	for (i = 1; i < MAIN_INIT_WORKERS && i < NELEMS(page_tbl); i++)
+	{
+		if (pthread_create(&threads[created], NULL, init_worker, NULL) != 0)
+			break;
+		created++;
+	}
+
+	init_worker(NULL);
+
+	for (i = 0; i < created; i++)
+		pthread_join(threads[i], NULL);
+
+	init_workers = created + 1;
+#else
+	int8_t i;
+
+	/* The table lists dependencies first, so its order satisfies them */
+	while ((i = init_next()) >= 0)
+	{
+		init_started |= PAGE_BIT(i);
+		init_page((uint8_t)i);
+		init_done |= PAGE_BIT(i);
+	}
+
+	init_workers = 1;
+#endif
+}
+
 static int8_t main_init(void)
 {
 	uint8_t op = 0, i;
 
 	options2pages[op++] = SUSIDEMO_MAIN_PAGES_EXIT;
 
+	init_pages();
+	ready_usec = get_tick_usec();
+
 	for (i = 0; i < NELEMS(page_tbl); i++)
 	{
-		if (page_tbl[i].pfuncinit())
+		if (page_init[i].available)
 		{
 			options2pages[op++] = i;
 		}
@@ -61,6 +201,43 @@ static int8_t main_init(void)
 	return SUSIDEMO_DEVICE_AVAILALBE;
 }
 
+static void print_msec(const char *label, uint64_t usec)
+{
+	printf("%s%u.%03u ms", label, (unsigned int)(usec / 1000), (unsigned int)(usec % 1000));
+}
+
+/* Where the startup time went: library, probes, and the probes one by one */
+static void startup_summary(void)
+{
+	uint64_t sum = 0;
+	uint8_t i, missing = 0;
+
+	for (i = 0; i < NELEMS(page_tbl); i++)
+		sum += page_init[i].endUsec - page_init[i].startUsec;
+
+	print_msec("Ready in ", ready_usec - start_usec);
+	print_msec(" (SusiLibInitialize ", lib_usec - start_usec);
+	print_msec(", probes ", ready_usec - lib_usec);
+	printf(" on %u thread(s)", init_workers);
+	print_msec(", ", sum);
+	printf(" one after another)\n");
+
+	for (i = 0; i < NELEMS(page_tbl); i++)
+	{
+		if (page_init[i].available)
+			continue;
+
+		printf(missing++ ? ", " : "Not available: ");
+		printf("%s", page_tbl[i].name);
+		print_msec(" ", page_init[i].endUsec - page_init[i].startUsec);
+	}
+
+	if (missing)
+		printf("\n");
+
+	printf("\n");
+}
+
 static void menu(void)
 {
 	uint8_t i;
@@ -73,7 +250,11 @@ static void menu(void)
 		}
 		else
 		{
-			printf("%u) %s\n", i, page_tbl[options2pages[i]].name);
+			struct PageInit *init = &page_init[options2pages[i]];
+
+			printf("%u) %-20s", i, page_tbl[options2pages[i]].name);
+			print_msec(" probe ", init->endUsec - init->startUsec);
+			printf("\n");
 		}
 	}
 
@@ -87,7 +268,9 @@ int main(void)
 	uint32_t op; 
 	int ret = 0;
 
+	start_usec = get_tick_usec();
 	status = SusiLibInitialize();
+	lib_usec = get_tick_usec();
 
 	if (status == SUSI_STATUS_ERROR)
 	{
@@ -115,6 +298,7 @@ int main(void)
 	{
 		clr_screen();
 		main_title();
+		startup_summary();
 		menu();
 
 		if (input_uint(&op, 10, maxpageoption, 0))
@@ -1,5 +1,11 @@
 #include "common.h"
 
+#ifdef _LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 typedef struct {
 	uint32_t totalSize;
 	uint32_t blockSize;
@@ -10,12 +16,14 @@ typedef struct {
 static StorageInfo info[SUSI_ID_STORAGE_MAX];
 static int8_t storage[SUSI_ID_STORAGE_MAX];
 
-#define SUSIDEMO_STORAGE_FUNCTION_MAX 6
+#define SUSIDEMO_STORAGE_FUNCTION_MAX 8
 static int8_t func[SUSIDEMO_STORAGE_FUNCTION_MAX];
 enum funcRank{
 	funcDevice,
 	funcRead,
 	funcWrite,
+	funcDump,
+	funcRestore,
 	funcStatus,
 	funcLock,
 	funcUnlock
@@ -106,10 +114,22 @@ static uint8_t select_storage(uint8_t *piStorage)
 	return 0;
 }
 
-static uint8_t read_data(uint32_t storage_id, uint32_t totalSize)
+/* Bytes per SusiStorageAreaRead() call, rounded down to whole blocks */
+#define STORAGE_READ_CHUNK 256
+
+static uint32_t chunk_size(uint32_t blockSize)
+{
+	if (blockSize == 0)
+		blockSize = 1;
+	return blockSize >= STORAGE_READ_CHUNK ? blockSize : STORAGE_READ_CHUNK / blockSize * blockSize;
+}
+
+static uint8_t read_data(uint32_t storage_id, uint32_t totalSize, uint32_t blockSize)
 {
-	uint32_t status, offset, length, maxLength;
-	uint8_t *pdataBuffer, i;
+	uint32_t status, offset, length, maxLength, chunkSize, pos, end, count, i;
+	uint32_t chunks;
+	uint64_t start, elapsed;
+	uint8_t *pdataBuffer;
 
 	printf("\nRead:\n");
 
@@ -132,25 +152,53 @@ static uint8_t read_data(uint32_t storage_id, uint32_t totalSize)
 	} while (input_uint(&length, 10, maxLength, 1) != 0);
 #endif
 
-	pdataBuffer = (uint8_t*)malloc(length * sizeof(uint8_t));
-	status = SusiStorageAreaRead(storage_id, offset, pdataBuffer, length);
-	if (status != SUSI_STATUS_SUCCESS)
+	/* Read in block-aligned chunks: one buffer of a chunk, whatever the length */
+	chunkSize = chunk_size(blockSize);
+	pdataBuffer = (uint8_t*)malloc(chunkSize * sizeof(uint8_t));
+	if (pdataBuffer == NULL)
 	{
-		free(pdataBuffer);
-		printf("SusiStorageAreaRead() failed. (0x%08X)\n", status);
+		printf("Out of memory.\n");
 		return 1;
 	}
 
 	printf("Result: (HEX)\n");
-	for (i = 0; i < length; i++)
+	end = offset + length;
+	chunks = 0;
+	elapsed = 0;
+	for (pos = offset; pos < end; pos += count)
 	{
-		if (i == length - 1)
-			printf("%02X\n", pdataBuffer[i]);
-		else
-			printf("%02X ", pdataBuffer[i]);
-	}
+		count = chunkSize - pos % chunkSize;
+		if (count > end - pos)
+			count = end - pos;
+
+		start = get_tick_usec();
+		status = SusiStorageAreaRead(storage_id, pos, pdataBuffer, count);
+		elapsed += get_tick_usec() - start;
+		if (status != SUSI_STATUS_SUCCESS)
+		{
+			free(pdataBuffer);
+			printf("\nSusiStorageAreaRead() failed at 0x%04X. (0x%08X)\n", pos, status);
+			printf("Read %u of %u bytes.\n", pos - offset, length);
+			return 1;
+		}
+		chunks++;
 
+		for (i = 0; i < count; i++)
+		{
+			if ((pos + i - offset) % 16 == 0)
+				printf("%s%04X:", pos + i == offset ? "" : "\n", pos + i);
+			printf(" %02X", pdataBuffer[i]);
+		}
+	}
+	printf("\n");
 	free(pdataBuffer);
+
+	printf("\nRead %u bytes in %u chunk(s) of up to %u bytes, %u.%03u ms", length, chunks, chunkSize,
+		(uint32_t)(elapsed / 1000), (uint32_t)(elapsed % 1000));
+	if (elapsed > 0)
+		printf(", %u Bytes/s", (uint32_t)((uint64_t)length * 1000000 / elapsed));
+	printf("\n");
+
 	return 0;
 }
 
@@ -177,8 +225,8 @@ static uint8_t write_data(uint32_t storage_id, uint32_t totalSize, uint32_t bloc
 	end = strchr((char*)pdataBuffer, '\n');
 	if (end != NULL) *end = '\0';
 #else
-	uint32_t status, offset, length;
-	uint8_t *pdataBuffer, i;
+	uint32_t status, offset, length, i;
+	uint8_t *pdataBuffer;
 
 	printf("\nWrite:\n");
 
@@ -228,6 +276,273 @@ static uint8_t write_data(uint32_t storage_id, uint32_t totalSize, uint32_t bloc
 	return 0;
 }
 
+/* An image file, mapped where the OS allows it and read into memory elsewhere */
+typedef struct {
+	uint8_t *data;
+	uint32_t size;
+} ImageFile;
+
+static uint8_t image_open(const char *path, ImageFile *pimage)
+{
+#ifdef _LINUX
+	struct stat st;
+	void *map;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return 1;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0 || st.st_size > 0xFFFFFFFF)
+	{
+		close(fd);
+		return 1;
+	}
+	map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return 1;
+
+	pimage->data = (uint8_t*)map;
+	pimage->size = (uint32_t)st.st_size;
+#else
+	FILE *file;
+	long size;
+
+	file = fopen(path, "rb");
+	if (file == NULL)
+		return 1;
+	if (fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) <= 0 || fseek(file, 0, SEEK_SET) != 0)
+	{
+		fclose(file);
+		return 1;
+	}
+	pimage->data = (uint8_t*)malloc((size_t)size);
+	if (pimage->data == NULL || fread(pimage->data, 1, (size_t)size, file) != (size_t)size)
+	{
+		free(pimage->data);
+		fclose(file);
+		return 1;
+	}
+	fclose(file);
+	pimage->size = (uint32_t)size;
+#endif
+	return 0;
+}
+
+static void image_close(ImageFile *pimage)
+{
+#ifdef _LINUX
+	munmap(pimage->data, pimage->size);
+#else
+	free(pimage->data);
+#endif
+	pimage->data = NULL;
+}
+
+static uint8_t input_path(char *path)
+{
+	printf("File: ");
+	if (SCANF2_IN("%s", path) <= 0)
+	{
+		wait_enter();
+		printf("Error: input invalid value.\n");
+		return 1;
+	}
+	wait_enter();
+
+	return 0;
+}
+
+static uint8_t dump_image(uint32_t storage_id, uint32_t totalSize, uint32_t blockSize)
+{
+	uint32_t status, chunkSize, pos, count;
+	uint64_t start, elapsed;
+	uint8_t *pdataBuffer;
+	char path[STRING_MAXIMUM_LENGTH] = {0};
+	FILE *file;
+
+	printf("\nDump image:\n\n");
+	if (input_path(path) != 0)
+		return 1;
+
+	chunkSize = chunk_size(blockSize);
+	pdataBuffer = (uint8_t*)malloc(chunkSize * sizeof(uint8_t));
+	if (pdataBuffer == NULL)
+	{
+		printf("Out of memory.\n");
+		return 1;
+	}
+	file = fopen(path, "wb");
+	if (file == NULL)
+	{
+		free(pdataBuffer);
+		printf("Error: cannot create %s.\n", path);
+		return 1;
+	}
+
+	start = get_tick_usec();
+	for (pos = 0; pos < totalSize; pos += count)
+	{
+		count = totalSize - pos < chunkSize ? totalSize - pos : chunkSize;
+		status = SusiStorageAreaRead(storage_id, pos, pdataBuffer, count);
+		if (status != SUSI_STATUS_SUCCESS)
+		{
+			printf("SusiStorageAreaRead() failed at 0x%04X. (0x%08X)\n", pos, status);
+			break;
+		}
+		if (fwrite(pdataBuffer, 1, count, file) != count)
+		{
+			printf("Error: cannot write %s.\n", path);
+			break;
+		}
+	}
+	elapsed = get_tick_usec() - start;
+	free(pdataBuffer);
+	if (fclose(file) != 0 || pos < totalSize)
+		return 1;
+
+	printf("Saved %u bytes to %s in %u.%03u ms.\n", totalSize, path,
+		(uint32_t)(elapsed / 1000), (uint32_t)(elapsed % 1000));
+
+	return 0;
+}
+
+static uint32_t write_run(uint32_t storage_id, uint32_t offset, uint8_t *pdata, uint32_t length, uint32_t *pwrites)
+{
+	uint32_t status;
+
+	status = SusiStorageAreaWrite(storage_id, offset, pdata, length);
+	if (status != SUSI_STATUS_SUCCESS)
+		printf("SusiStorageAreaWrite() failed at 0x%04X. (0x%08X)\n", offset, status);
+	else
+		(*pwrites)++;
+
+	return status;
+}
+
+/* Write the blocks of the image that differ from the device. Each chunk is
+   read back and compared block by block; runs of changed blocks are written
+   with one call each. A locked area is unlocked once for the whole session
+   and locked again with the same password afterwards. */
+static uint8_t restore_image(uint32_t storage_id, uint32_t totalSize, uint32_t blockSize, uint32_t maxKeySize)
+{
+	uint32_t status, lockStatus, chunkSize, pos, count, block, run, length;
+	uint32_t blocks, changed, writes;
+	uint64_t start, elapsed;
+	uint8_t *pdataBuffer, locked;
+	uint8_t passwd[STRING_MAXIMUM_LENGTH] = {0};
+	char path[STRING_MAXIMUM_LENGTH] = {0};
+	ImageFile image;
+
+	printf("\nRestore image:\n\n");
+	if (input_path(path) != 0)
+		return 1;
+
+	if (image_open(path, &image) != 0)
+	{
+		printf("Error: cannot open %s.\n", path);
+		return 1;
+	}
+	if (image.size > totalSize)
+	{
+		image_close(&image);
+		printf("Error: the image (%u bytes) is larger than the storage (%u bytes).\n", image.size, totalSize);
+		return 1;
+	}
+
+	if (blockSize == 0)
+		blockSize = 1;
+	chunkSize = chunk_size(blockSize);
+	pdataBuffer = (uint8_t*)malloc(chunkSize * sizeof(uint8_t));
+	if (pdataBuffer == NULL)
+	{
+		image_close(&image);
+		printf("Out of memory.\n");
+		return 1;
+	}
+
+	locked = 0;
+	if (maxKeySize > 0 && SusiStorageGetCaps(storage_id, SUSI_ID_STORAGE_LOCK_STATUS, &lockStatus) == SUSI_STATUS_SUCCESS &&
+		lockStatus == SUSI_STORAGE_STATUS_LOCK)
+	{
+		printf("The storage is locked. Type password: ");
+		if (SCANF2_IN("%s", passwd) <= 0)
+		{
+			wait_enter();
+			free(pdataBuffer);
+			image_close(&image);
+			printf("Error: input invalid value.\n");
+			return 1;
+		}
+		wait_enter();
+
+		status = SusiStorageAreaSetUnlock(storage_id, passwd, (uint32_t)strlen((char *)passwd));
+		if (status != SUSI_STATUS_SUCCESS)
+		{
+			free(pdataBuffer);
+			image_close(&image);
+			printf("SusiStorageAreaSetUnlock() failed. (0x%08X)\n", status);
+			return 1;
+		}
+		locked = 1;
+	}
+
+	blocks = 0;
+	changed = 0;
+	writes = 0;
+	status = SUSI_STATUS_SUCCESS;
+	start = get_tick_usec();
+	for (pos = 0; pos < image.size && status == SUSI_STATUS_SUCCESS; pos += count)
+	{
+		count = image.size - pos < chunkSize ? image.size - pos : chunkSize;
+		status = SusiStorageAreaRead(storage_id, pos, pdataBuffer, count);
+		if (status != SUSI_STATUS_SUCCESS)
+		{
+			printf("SusiStorageAreaRead() failed at 0x%04X. (0x%08X)\n", pos, status);
+			break;
+		}
+
+		/* run: first changed block not yet written, count when there is none */
+		run = count;
+		for (block = 0; block < count && status == SUSI_STATUS_SUCCESS; block += length)
+		{
+			length = count - block < blockSize ? count - block : blockSize;
+			blocks++;
+			if (memcmp(pdataBuffer + block, image.data + pos + block, length) != 0)
+			{
+				if (run == count)
+					run = block;
+				changed++;
+			}
+			else if (run < count)
+			{
+				status = write_run(storage_id, pos + run, image.data + pos + run, block - run, &writes);
+				run = count;
+			}
+		}
+		if (run < count && status == SUSI_STATUS_SUCCESS)
+			status = write_run(storage_id, pos + run, image.data + pos + run, count - run, &writes);
+	}
+	elapsed = get_tick_usec() - start;
+
+	if (locked)
+	{
+		uint32_t lockResult = SusiStorageAreaSetLock(storage_id, passwd, (uint32_t)strlen((char *)passwd));
+
+		if (lockResult != SUSI_STATUS_SUCCESS)
+			printf("Warning: SusiStorageAreaSetLock() failed, the storage is left unlocked. (0x%08X)\n", lockResult);
+	}
+	free(pdataBuffer);
+	image_close(&image);
+	if (status != SUSI_STATUS_SUCCESS)
+		return 1;
+
+	printf("Compared %u block(s) of %u bytes: %u changed, written in %u call(s), %u.%03u ms.\n",
+		blocks, blockSize, changed, writes, (uint32_t)(elapsed / 1000), (uint32_t)(elapsed % 1000));
+
+	return 0;
+}
+
 static uint8_t get_status(uint32_t storage_id, uint32_t *pwtprot_status)
 {
 	uint32_t status, value;
@@ -337,8 +652,12 @@ static uint8_t show_menu(uint8_t iStorage, uint32_t wtprot_status)
 	func[1] = funcRead;
 	printf("3) Write data\n");
 	func[2] = funcWrite;
+	printf("4) Dump image to file\n");
+	func[3] = funcDump;
+	printf("5) Restore image from file (changed blocks only)\n");
+	func[4] = funcRestore;
 
-	i = 3;
+	i = 5;
 	if (info[iStorage].maxKeySize > 0)
 	{
 		if (wtprot_status == SUSI_STORAGE_STATUS_LOCK)
@@ -431,13 +750,22 @@ void storage_main(void)
 			break;
 
 		case funcRead:
-			result = read_data(storage_id, info[iStorage].totalSize);
+			result = read_data(storage_id, info[iStorage].totalSize, info[iStorage].blockSize);
 			break;
 
 		case funcWrite:
 			result = write_data(storage_id, info[iStorage].totalSize, info[iStorage].blockSize);
 			break;
 
+		case funcDump:
+			result = dump_image(storage_id, info[iStorage].totalSize, info[iStorage].blockSize);
+			break;
+
+		case funcRestore:
+			result = restore_image(storage_id, info[iStorage].totalSize, info[iStorage].blockSize,
+				info[iStorage].maxKeySize);
+			break;
+
 		case funcStatus:
 			result = get_status(storage_id, &info[iStorage].wpStatus);
 			break;
@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include "access_log.h"
+#include "metrics.h"
+
+#define ENTRY_METHOD_SIZE 8
+#define ENTRY_TEXT_SIZE 160
+
+typedef enum {
+    ENTRY_REQUEST,
+    ENTRY_MESSAGE
+} EntryKind;
+
+// Fixed-size ring slot. The sequence number implements a bounded
+// multi-producer queue: producers claim slots with a CAS on the head and
+// publish by advancing the slot sequence, so no lock is ever taken.
+typedef struct {
+    uint64_t sequence;
+    EntryKind kind;
+    LogLevel level;
+    struct timespec timestamp;
+    char method[ENTRY_METHOD_SIZE];
+    char text[ENTRY_TEXT_SIZE];     // URL or message
+    int family;                     // Client address family, 0 if unknown
+    unsigned char address[16];
+} __attribute__((aligned(64))) LogEntry;
+
+static LogEntry ring[ACCESS_LOG_CAPACITY];
+static uint64_t ringHead = 0;       // Next slot to claim (producers)
+static uint64_t ringTail = 0;       // Next slot to drain (consumer only)
+static uint64_t droppedCount = 0;     // Since startup, never reset
+static uint64_t droppedReported = 0;  // Consumer only: already in the log
+static uint64_t requestCounter = 0;
+
+static AccessLogConfig logConfig = { LOG_LEVEL_INFO, LOG_FORMAT_TEXT, 1 };
+static pthread_t drainThread;
+static bool drainRunning = false;
+
+static const char *levelNames[] = { "off", "error", "warn", "info", "debug" };
+
+bool parseLogLevel(const char *name, LogLevel *level) {
+    for (int i = LOG_LEVEL_OFF; i <= LOG_LEVEL_DEBUG; i++) {
+        if (strcmp(name, levelNames[i]) == 0) {
+            *level = (LogLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseLogFormat(const char *name, LogFormat *format) {
+    if (strcmp(name, "text") == 0) {
+        *format = LOG_FORMAT_TEXT;
+    } else if (strcmp(name, "json") == 0) {
+        *format = LOG_FORMAT_JSON;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Claim a ring slot, or return NULL if the ring is full
+static LogEntry* ringClaim(void) {
+    uint64_t pos = __atomic_load_n(&ringHead, __ATOMIC_RELAXED);
+    
+    for (;;) {
+        LogEntry *entry = &ring[pos & (ACCESS_LOG_CAPACITY - 1)];
+        uint64_t seq = __atomic_load_n(&entry->sequence, __ATOMIC_ACQUIRE);
+        int64_t diff = (int64_t)seq - (int64_t)pos;
+        
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ringHead, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                return entry;
+            }
+        } else if (diff < 0) {
+            __atomic_fetch_add(&droppedCount, 1, __ATOMIC_RELAXED);
+            return NULL;
+        } else {
+            pos = __atomic_load_n(&ringHead, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static void ringPublish(LogEntry *entry) {
+    uint64_t pos = __atomic_load_n(&entry->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&entry->sequence, pos + 1, __ATOMIC_RELEASE);
+}
+
+static void copyText(char *dest, size_t size, const char *src) {
+    size_t length = strlen(src);
+    if (length >= size) {
+        length = size - 1;
+    }
+    memcpy(dest, src, length);
+    dest[length] = '\0';
+}
+
+void accessLogRequest(const char *method, const char *url, const struct sockaddr *client) {
+    LogEntry *entry;
+    uint64_t n;
+    uint32_t sampleRate;
+    
+    if (__atomic_load_n(&logConfig.level, __ATOMIC_RELAXED) < LOG_LEVEL_INFO) {
+        return;
+    }
+    n = __atomic_fetch_add(&requestCounter, 1, __ATOMIC_RELAXED);
+    sampleRate = __atomic_load_n(&logConfig.sampleRate, __ATOMIC_RELAXED);
+    if (sampleRate > 1 && (n % sampleRate) != 0) {
+        return;
+    }
+    
+    entry = ringClaim();
+    if (entry == NULL) {
+        return;
+    }
+    entry->kind = ENTRY_REQUEST;
+    entry->level = LOG_LEVEL_INFO;
+    clock_gettime(CLOCK_REALTIME, &entry->timestamp);
+    copyText(entry->method, sizeof(entry->method), method);
+    copyText(entry->text, sizeof(entry->text), url);
+    entry->family = 0;
+    if (client && client->sa_family == AF_INET) {
+        entry->family = AF_INET;
+        memcpy(entry->address, &((const struct sockaddr_in *)client)->sin_addr, 4);
+    } else if (client && client->sa_family == AF_INET6) {
+        entry->family = AF_INET6;
+        memcpy(entry->address, &((const struct sockaddr_in6 *)client)->sin6_addr, 16);
+    }
+    ringPublish(entry);
+}
+
+void accessLogMessage(LogLevel level, const char *format, ...) {
+    LogEntry *entry;
+    va_list args;
+    
+    if (level == LOG_LEVEL_OFF || level > __atomic_load_n(&logConfig.level, __ATOMIC_RELAXED)) {
+        return;
+    }
+    entry = ringClaim();
+    if (entry == NULL) {
+        return;
+    }
+    entry->kind = ENTRY_MESSAGE;
+    entry->level = level;
+    clock_gettime(CLOCK_REALTIME, &entry->timestamp);
+    entry->method[0] = '\0';
+    entry->family = 0;
+    va_start(args, format);
+    vsnprintf(entry->text, sizeof(entry->text), format, args);
+    va_end(args);
+    ringPublish(entry);
+}
+
+uint64_t accessLogDropped(void) {
+    return __atomic_load_n(&droppedCount, __ATOMIC_RELAXED);
+}
+
+uint32_t accessLogRingUsed(void) {
+    uint64_t tail = __atomic_load_n(&ringTail, __ATOMIC_RELAXED);
+    uint64_t head = __atomic_load_n(&ringHead, __ATOMIC_RELAXED);
+
+    return head > tail ? (uint32_t)(head - tail) : 0;
+}
+
+// Write a string as a JSON string literal
+static void writeJsonString(FILE *out, const char *text) {
+    fputc('"', out);
+    for (const unsigned char *p = (const unsigned char *)text; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fputc('\\', out);
+            fputc(*p, out);
+        } else if (*p < 0x20) {
+            fprintf(out, "\\u%04x", *p);
+        } else {
+            fputc(*p, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static void writeEntry(FILE *out, const LogEntry *entry) {
+    char timeText[32];
+    char client[INET6_ADDRSTRLEN] = "-";
+    struct tm tm;
+    
+    gmtime_r(&entry->timestamp.tv_sec, &tm);
+    strftime(timeText, sizeof(timeText), "%Y-%m-%dT%H:%M:%S", &tm);
+    if (entry->family) {
+        inet_ntop(entry->family, entry->address, client, sizeof(client));
+    }
+    
+    if (logConfig.format == LOG_FORMAT_JSON) {
+        fprintf(out, "{\"ts\":\"%s.%03ldZ\",\"level\":\"%s\"", timeText,
+                entry->timestamp.tv_nsec / 1000000L, levelNames[entry->level]);
+        if (entry->kind == ENTRY_REQUEST) {
+            fputs(",\"method\":", out);
+            writeJsonString(out, entry->method);
+            fputs(",\"url\":", out);
+            writeJsonString(out, entry->text);
+            fprintf(out, ",\"client\":\"%s\"}\n", client);
+        } else {
+            fputs(",\"msg\":", out);
+            writeJsonString(out, entry->text);
+            fputs("}\n", out);
+        }
+    } else if (entry->kind == ENTRY_REQUEST) {
+        fprintf(out, "%s.%03ldZ %s %s %s\n", timeText, entry->timestamp.tv_nsec / 1000000L,
+                client, entry->method, entry->text);
+    } else {
+        fprintf(out, "%s.%03ldZ [%s] %s\n", timeText, entry->timestamp.tv_nsec / 1000000L,
+                levelNames[entry->level], entry->text);
+    }
+}
+
+// Write out everything published so far with a single flush at the end
+static void drainRing(void) {
+    uint64_t dropped;
+    bool wrote = false;
+    
+    for (;;) {
+        LogEntry *entry = &ring[ringTail & (ACCESS_LOG_CAPACITY - 1)];
+        uint64_t seq = __atomic_load_n(&entry->sequence, __ATOMIC_ACQUIRE);
+        
+        if (seq != ringTail + 1) {
+            break;
+        }
+        writeEntry(stdout, entry);
+        wrote = true;
+        // Hand the slot back to producers for the next lap
+        __atomic_store_n(&entry->sequence, ringTail + ACCESS_LOG_CAPACITY, __ATOMIC_RELEASE);
+        ringTail++;
+    }
+    
+    dropped = __atomic_load_n(&droppedCount, __ATOMIC_RELAXED);
+    if (dropped != droppedReported) {
+        fprintf(stdout, "access log: %llu entries dropped (ring full)\n",
+                (unsigned long long)(dropped - droppedReported));
+        droppedReported = dropped;
+        wrote = true;
+    }
+    if (wrote) {
+        fflush(stdout);
+    }
+}
+
+static void* drainThreadMain(void *arg) {
+    struct timespec interval = { 0, ACCESS_LOG_FLUSH_INTERVAL_MS * 1000000L };
+    (void)arg;
+    
+    pthread_setname_np(pthread_self(), "access-log");
+    while (__atomic_load_n(&drainRunning, __ATOMIC_ACQUIRE)) {
+        drainRing();
+        nanosleep(&interval, NULL);
+    }
+    drainRing();
+    return NULL;
+}
+
+bool accessLogStart(const AccessLogConfig *config) {
+    logConfig = *config;
+    if (logConfig.sampleRate == 0) {
+        logConfig.sampleRate = 1;
+    }
+    for (uint64_t i = 0; i < ACCESS_LOG_CAPACITY; i++) {
+        ring[i].sequence = i;
+    }
+    ringHead = 0;
+    ringTail = 0;
+    
+    __atomic_store_n(&drainRunning, true, __ATOMIC_RELEASE);
+    if (pthread_create(&drainThread, NULL, drainThreadMain, NULL) != 0) {
+        drainRunning = false;
+        return false;
+    }
+    return true;
+}
+
+void accessLogSetLevel(LogLevel level, uint32_t sampleRate) {
+    __atomic_store_n(&logConfig.sampleRate, sampleRate > 0 ? sampleRate : 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&logConfig.level, level, __ATOMIC_RELAXED);
+}
+
+void accessLogStop(void) {
+    if (!__atomic_load_n(&drainRunning, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    __atomic_store_n(&drainRunning, false, __ATOMIC_RELEASE);
+    pthread_join(drainThread, NULL);
+}
+
+// Metrics collector for the logger itself
+void accessLogCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+    metricsHeader(out, "watchdog_access_log_requests_total", "counter", "Requests seen by the access logger");
+    strbufAppendf(out, "watchdog_access_log_requests_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&requestCounter, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_access_log_dropped_total", "counter", "Entries dropped because the ring was full");
+    strbufAppendf(out, "watchdog_access_log_dropped_total %llu\n", (unsigned long long)accessLogDropped());
+}
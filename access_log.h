@@ -0,0 +1,55 @@
+#ifndef ACCESS_LOG_H
+#define ACCESS_LOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include "strbuf.h"
+#include "build_profile.h"
+
+#ifndef ACCESS_LOG_CAPACITY
+#define ACCESS_LOG_CAPACITY 1024        // Ring slots, must be a power of two
+#endif
+#define ACCESS_LOG_FLUSH_INTERVAL_MS 50 // How often the drain thread wakes up
+
+typedef enum {
+    LOG_LEVEL_OFF,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_DEBUG
+} LogLevel;
+
+typedef enum {
+    LOG_FORMAT_TEXT,
+    LOG_FORMAT_JSON     // One JSON object per line
+} LogFormat;
+
+typedef struct {
+    LogLevel level;
+    LogFormat format;
+    uint32_t sampleRate;    // Log 1 in N requests at info level, 1 = all
+} AccessLogConfig;
+
+bool accessLogStart(const AccessLogConfig *config);
+void accessLogStop(void);
+// Change the level and sampling at runtime; the format stays fixed
+void accessLogSetLevel(LogLevel level, uint32_t sampleRate);
+
+bool parseLogLevel(const char *name, LogLevel *level);
+bool parseLogFormat(const char *name, LogFormat *format);
+
+// Record a request. Never blocks: the entry is copied into the ring and
+// written out by the drain thread; if the ring is full it is dropped.
+void accessLogRequest(const char *method, const char *url, const struct sockaddr *client);
+
+// Record a free-form message at the given level
+void accessLogMessage(LogLevel level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+// Entries dropped because the ring was full, since startup
+uint64_t accessLogDropped(void);
+// Entries waiting for the writer, of ACCESS_LOG_CAPACITY
+uint32_t accessLogRingUsed(void);
+void accessLogCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // ACCESS_LOG_H
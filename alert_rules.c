@@ -0,0 +1,543 @@
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "alert_rules.h"
+#include "events.h"
+#include "hwm_kernel.h"
+#include "hwm_sampler.h"
+#include "json_writer.h"
+#include "metrics.h"
+#include "response_pool.h"
+#include "timeutil.h"
+#include "webhook.h"
+
+typedef enum {
+    ALERT_GT,
+    ALERT_GE,
+    ALERT_LT,
+    ALERT_LE,
+    ALERT_EQ,
+    ALERT_NE
+} AlertOp;
+
+// A comparison as parsed, before the sensors are known
+typedef struct {
+    char sensor[HWM_NAME_MAX];
+    AlertOp op;
+    double threshold;
+    uint32_t holdMs;
+    bool groupEnd;                   // Last of an "and" group
+} AlertSource;
+
+// A comparison as evaluated: true while the raw value is within
+// [low, low + span], or outside it when negated
+typedef struct {
+    int32_t low;
+    uint32_t span;
+    uint32_t holdMs;
+    uint8_t slot;
+    uint8_t negate;
+    uint8_t groupEnd;
+} AlertComparison;
+
+typedef struct {
+    char name[ALERT_NAME_MAX];
+    char text[ALERT_TEXT_MAX];       // The expression as written
+    uint16_t first;                  // Its sources, then its comparisons
+    uint16_t count;
+    // Written on the sampler task only
+    uint32_t active;
+    uint64_t changedMs;              // Wall clock of the last change, 0 before the first
+    uint64_t raisedAtMs;             // Monotonic
+    uint64_t raised;
+} AlertRule;
+
+static AlertSource sources[ALERT_MAX_COMPARISONS];
+static AlertComparison comparisons[ALERT_MAX_COMPARISONS];
+static uint64_t heldSinceMs[ALERT_MAX_COMPARISONS];  // Monotonic, 0 while false
+static AlertRule rules[ALERT_MAX_RULES];
+static int ruleCount;
+static int comparisonCount;
+static bool rulesRunning;
+
+// Newest raw value of every slot; a sweep only reads the sensors that are due
+static int32_t latest[HWM_SENSOR_SLOTS];
+static uint64_t knownMask;
+
+static uint64_t evaluations;
+static uint64_t evaluationNs;
+
+static bool isWordChar(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '.' || c == '+' || c == '-';
+}
+
+static void skipSpace(const char **p) {
+    while (**p == ' ' || **p == '\t') {
+        (*p)++;
+    }
+}
+
+// A keyword (case-insensitive, whole words only) or a symbol
+static bool takeKeyword(const char **p, const char *keyword) {
+    size_t length = strlen(keyword);
+
+    skipSpace(p);
+    if (strncasecmp(*p, keyword, length) != 0 || (isalpha((unsigned char)keyword[0]) && isWordChar((*p)[length]))) {
+        return false;
+    }
+    *p += length;
+    return true;
+}
+
+// A sensor reference: a bare word or a quoted label
+static bool takeSensor(const char **p, char *sensor, size_t size) {
+    size_t length = 0;
+
+    skipSpace(p);
+    if (**p == '"') {
+        for ((*p)++; **p != '"'; (*p)++) {
+            if (**p == '\0' || length + 1 >= size) {
+                return false;
+            }
+            sensor[length++] = **p;
+        }
+        (*p)++;
+    } else {
+        for (; isWordChar(**p); (*p)++) {
+            if (length + 1 >= size) {
+                return false;
+            }
+            sensor[length++] = **p;
+        }
+    }
+    sensor[length] = '\0';
+    return length > 0;
+}
+
+static bool takeOp(const char **p, AlertOp *op) {
+    static const struct {
+        const char *symbol;
+        AlertOp op;
+    } ops[] = {
+        { ">=", ALERT_GE }, { "<=", ALERT_LE }, { "==", ALERT_EQ }, { "!=", ALERT_NE },
+        { ">", ALERT_GT }, { "<", ALERT_LT },
+    };
+
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (takeKeyword(p, ops[i].symbol)) {
+            *op = ops[i].op;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool takeNumber(const char **p, double *value) {
+    char *end;
+
+    skipSpace(p);
+    errno = 0;
+    *value = strtod(*p, &end);
+    if (end == *p || errno != 0 || !isfinite(*value)) {
+        return false;
+    }
+    *p = end;
+    return true;
+}
+
+static bool takeDuration(const char **p, uint32_t *ms) {
+    double value, scale = 1000;
+
+    if (!takeNumber(p, &value) || value < 0) {
+        return false;
+    }
+    if (takeKeyword(p, "ms")) {
+        scale = 1;
+    } else if (takeKeyword(p, "s")) {
+        scale = 1000;
+    } else if (takeKeyword(p, "m")) {
+        scale = 60000;
+    } else if (takeKeyword(p, "h")) {
+        scale = 3600000;
+    }
+    value *= scale;
+    if (value > ALERT_MAX_HOLD_MS) {
+        return false;
+    }
+    *ms = (uint32_t)value;
+    return true;
+}
+
+// Parse the comparisons of an expression into parsed[]; how many, 0 on an error
+static int parseExpression(const char *text, AlertSource *parsed, int max) {
+    const char *p = text;
+    int count = 0;
+
+    for (;;) {
+        AlertSource *source = &parsed[count];
+
+        if (count == max) {
+            return 0;
+        }
+        memset(source, 0, sizeof(*source));
+        if (!takeSensor(&p, source->sensor, sizeof(source->sensor)) || !takeOp(&p, &source->op) ||
+            !takeNumber(&p, &source->threshold)) {
+            return 0;
+        }
+        if (takeKeyword(&p, "for") && !takeDuration(&p, &source->holdMs)) {
+            return 0;
+        }
+        count++;
+        if (takeKeyword(&p, "and") || takeKeyword(&p, "&&")) {
+            continue;
+        }
+        source->groupEnd = true;
+        if (takeKeyword(&p, "or") || takeKeyword(&p, "||")) {
+            continue;
+        }
+        skipSpace(&p);
+        return *p == '\0' ? count : 0;
+    }
+}
+
+bool alertRulesAdd(const char *spec) {
+    const char *colon = strchr(spec, ':');
+    const char *text;
+    size_t nameLength, textLength;
+    AlertRule *rule;
+    int count;
+
+    if (rulesRunning || ruleCount >= ALERT_MAX_RULES || colon == NULL) {
+        return false;
+    }
+    nameLength = (size_t)(colon - spec);
+    while (nameLength > 0 && (spec[nameLength - 1] == ' ' || spec[nameLength - 1] == '\t')) {
+        nameLength--;
+    }
+    if (nameLength == 0 || nameLength >= ALERT_NAME_MAX) {
+        return false;
+    }
+    // Names end up in metric labels, so no quoting is ever needed
+    for (size_t i = 0; i < nameLength; i++) {
+        if (!isalnum((unsigned char)spec[i]) && spec[i] != '_' && spec[i] != '-' && spec[i] != '.') {
+            return false;
+        }
+    }
+    for (int i = 0; i < ruleCount; i++) {
+        if (strlen(rules[i].name) == nameLength && strncmp(rules[i].name, spec, nameLength) == 0) {
+            return false;
+        }
+    }
+    text = colon + 1;
+    skipSpace(&text);
+    textLength = strlen(text);
+    while (textLength > 0 && (text[textLength - 1] == ' ' || text[textLength - 1] == '\t')) {
+        textLength--;
+    }
+    if (textLength == 0 || textLength >= ALERT_TEXT_MAX) {
+        return false;
+    }
+
+    rule = &rules[ruleCount];
+    memset(rule, 0, sizeof(*rule));
+    memcpy(rule->name, spec, nameLength);
+    memcpy(rule->text, text, textLength);
+    count = parseExpression(rule->text, &sources[comparisonCount], ALERT_MAX_COMPARISONS - comparisonCount);
+    if (count == 0) {
+        return false;
+    }
+    rule->first = (uint16_t)comparisonCount;
+    rule->count = (uint16_t)count;
+    comparisonCount += count;
+    ruleCount++;
+    return true;
+}
+
+bool alertRulesLoad(const char *path) {
+    char line[ALERT_NAME_MAX + ALERT_TEXT_MAX + 8];
+    int number = 0;
+    FILE *file = fopen(path, "r");
+
+    if (file == NULL) {
+        printf("alert rules: cannot open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char *spec = line + strspn(line, " \t");
+
+        number++;
+        if (strchr(line, '\n') == NULL && !feof(file)) {
+            printf("alert rules: %s:%d: line too long\n", path, number);
+            fclose(file);
+            return false;
+        }
+        spec[strcspn(spec, "#\r\n")] = '\0';
+        if (spec[0] != '\0' && !alertRulesAdd(spec)) {
+            printf("alert rules: %s:%d: invalid or duplicate rule '%s'\n", path, number, spec);
+            fclose(file);
+            return false;
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+int alertRulesCount(void) {
+    return ruleCount;
+}
+
+// The EC's label as /api/hwm shows it, else KIND+INDEX; -1 if neither
+static int resolveSensor(const char *reference) {
+    const HwmCapabilities *caps = hwmCapabilities();
+    char kindName[HWM_NAME_MAX];
+    size_t length = strlen(reference);
+    size_t digits = length;
+    HwmKind kind;
+
+    for (int i = 0; i < caps->count; i++) {
+        if (strcasecmp(hwmSensor(caps->slots[i])->name, reference) == 0) {
+            return caps->slots[i];
+        }
+    }
+    while (digits > 0 && isdigit((unsigned char)reference[digits - 1])) {
+        digits--;
+    }
+    if (digits == 0 || digits == length || length - digits > 3) {
+        return -1;
+    }
+    memcpy(kindName, reference, digits);
+    kindName[digits] = '\0';
+    if (!hwmKindFromName(kindName, &kind)) {
+        return -1;
+    }
+    return hwmSlot(kind, atoi(reference + digits));
+}
+
+// Move the threshold into the sensor's raw unit and the operator into a
+// raw range, so that evaluating never converts a reading
+static void compileComparison(AlertComparison *comparison, const AlertSource *source, int slot) {
+    HwmLinear linear = hwmKindLinear(hwmSensor(slot)->kind);
+    // Every kind's scale is positive, so the conversion keeps the order
+    double raw = (source->threshold - linear.offset) / linear.scale;
+    double low = INT32_MIN, high = INT32_MAX;
+
+    // 90 C is 3631 raw, not 3630.9999999999995
+    if (fabs(raw - nearbyint(raw)) < 1e-6) {
+        raw = nearbyint(raw);
+    }
+    switch (source->op) {
+    case ALERT_GT: low = floor(raw) + 1; break;
+    case ALERT_GE: low = ceil(raw); break;
+    case ALERT_LT: high = ceil(raw) - 1; break;
+    case ALERT_LE: high = floor(raw); break;
+    case ALERT_EQ:
+    case ALERT_NE: low = high = floor(raw + 0.5); break;
+    }
+    low = fmax(low, INT32_MIN);
+    high = fmin(high, INT32_MAX);
+
+    comparison->slot = (uint8_t)slot;
+    comparison->holdMs = source->holdMs;
+    comparison->groupEnd = source->groupEnd;
+    comparison->negate = source->op == ALERT_NE;
+    if (low > high) {
+        // Nothing raw is in range: the negation of everything
+        comparison->low = INT32_MIN;
+        comparison->span = UINT32_MAX;
+        comparison->negate = !comparison->negate;
+    } else {
+        comparison->low = (int32_t)low;
+        comparison->span = (uint32_t)((int64_t)high - (int64_t)low);
+    }
+}
+
+static void announce(const AlertRule *rule, uint32_t index, uint64_t activeMs) {
+    char body[WEBHOOK_BODY_MAX];
+    StrBuf out;
+    JsonWriter writer;
+
+    eventPublish(EVENT_ALERT, EVENT_NO_WATCHDOG, index, rule->active,
+                 activeMs < UINT32_MAX ? (uint32_t)activeMs : UINT32_MAX, (uint32_t)rule->raised);
+
+    strbufInit(&out, body, sizeof(body));
+    jsonWriterInit(&writer, &out);
+    jsonBeginObject(&writer);
+    jsonFieldString(&writer, "event", "alert");
+    jsonFieldString(&writer, "rule", rule->name);
+    jsonFieldString(&writer, "state", rule->active ? "raised" : "cleared");
+    if (!rule->active) {
+        jsonFieldUint(&writer, "active_ms", activeMs);
+    }
+    jsonFieldUint(&writer, "raised", rule->raised);
+    jsonFieldUint(&writer, "timestamp_ms", rule->changedMs);
+    jsonEndObject(&writer);
+    if (!out.overflow) {
+        webhookPost(out.data, out.length);
+    }
+}
+
+// One pass over every comparison of every rule, in array order
+static void onSweep(const HwmReading *reading, void *ctx) {
+    uint64_t startNs = monotonicNowNs();
+    uint64_t nowMs = startNs / 1000000;
+    uint64_t valid = reading->validMask;
+    int c = 0;
+    (void)ctx;
+
+    while (valid != 0) {
+        int slot = __builtin_ctzll(valid);
+
+        latest[slot] = reading->values[slot];
+        valid &= valid - 1;
+    }
+    knownMask |= reading->validMask;
+
+    for (int r = 0; r < ruleCount; r++) {
+        AlertRule *rule = &rules[r];
+        bool any = false, all = true;
+
+        for (int end = c + rule->count; c < end; c++) {
+            const AlertComparison *comparison = &comparisons[c];
+            bool inRange = (uint32_t)latest[comparison->slot] - (uint32_t)comparison->low <= comparison->span;
+            bool match = inRange != (comparison->negate != 0) && ((knownMask >> comparison->slot) & 1);
+
+            if (!match) {
+                heldSinceMs[c] = 0;
+            } else if (heldSinceMs[c] == 0) {
+                heldSinceMs[c] = nowMs;
+            }
+            all = all && match && nowMs - heldSinceMs[c] >= comparison->holdMs;
+            if (comparison->groupEnd) {
+                any = any || all;
+                all = true;
+            }
+        }
+        if (any == (rule->active != 0)) {
+            continue;
+        }
+        __atomic_store_n(&rule->active, any ? 1u : 0u, __ATOMIC_RELAXED);
+        __atomic_store_n(&rule->changedMs, reading->timestampMs, __ATOMIC_RELAXED);
+        if (any) {
+            rule->raisedAtMs = nowMs;
+            __atomic_store_n(&rule->raised, rule->raised + 1, __ATOMIC_RELAXED);
+        }
+        announce(rule, (uint32_t)r, any ? 0 : nowMs - rule->raisedAtMs);
+    }
+    __atomic_store_n(&evaluationNs, evaluationNs + (monotonicNowNs() - startNs), __ATOMIC_RELAXED);
+    __atomic_store_n(&evaluations, evaluations + 1, __ATOMIC_RELAXED);
+}
+
+bool alertRulesStart(void) {
+    const HwmCapabilities *caps = hwmCapabilities();
+    int kept = 0, compiled = 0;
+
+    if (rulesRunning || ruleCount == 0 || caps == NULL) {
+        return false;
+    }
+    for (int r = 0; r < ruleCount; r++) {
+        AlertRule *rule = &rules[r];
+        int first = compiled;
+
+        for (int i = rule->first; i < rule->first + rule->count; i++) {
+            int slot = resolveSensor(sources[i].sensor);
+
+            if (slot < 0 || !(caps->mask & (1ull << slot))) {
+                printf("Alert rule %s: sensor '%s' is not sampled\n", rule->name, sources[i].sensor);
+                break;
+            }
+            compileComparison(&comparisons[compiled++], &sources[i], slot);
+        }
+        if (compiled - first != rule->count) {
+            compiled = first;
+            continue;
+        }
+        rules[kept] = *rule;
+        rules[kept].first = (uint16_t)first;
+        kept++;
+    }
+    ruleCount = kept;
+    comparisonCount = compiled;
+    if (ruleCount == 0) {
+        return false;
+    }
+    printf("Alert rules: %d rules, %d comparisons per sweep\n", ruleCount, comparisonCount);
+    rulesRunning = true;
+    if (!hwmAddListener(onSweep, NULL)) {
+        rulesRunning = false;
+        return false;
+    }
+    return true;
+}
+
+const char* alertRuleName(uint32_t index) {
+    return index < (uint32_t)ruleCount ? rules[index].name : NULL;
+}
+
+enum MHD_Result alertRulesQueueResponse(struct MHD_Connection *connection) {
+    ResponseBuffer body;
+    JsonWriter writer;
+    uint64_t count = __atomic_load_n(&evaluations, __ATOMIC_RELAXED);
+
+    if (!rulesRunning ||
+        !responseBufferAcquireSize(&body, 512 + (size_t)ruleCount * (2 * ALERT_TEXT_MAX + ALERT_NAME_MAX + 128))) {
+        return MHD_NO;
+    }
+    responseWriterInit(&writer, &body, connection);
+    jsonBeginObject(&writer);
+    jsonFieldUint(&writer, "comparisons", (uint64_t)comparisonCount);
+    jsonFieldUint(&writer, "evaluations", count);
+    jsonFieldDouble(&writer, "evaluation_us",
+                    count ? (double)__atomic_load_n(&evaluationNs, __ATOMIC_RELAXED) / (double)count / 1000.0 : 0.0, 2);
+    jsonKey(&writer, "rules");
+    jsonBeginArray(&writer);
+    for (int r = 0; r < ruleCount; r++) {
+        const AlertRule *rule = &rules[r];
+        uint64_t changedMs = __atomic_load_n(&rule->changedMs, __ATOMIC_RELAXED);
+
+        jsonBeginObject(&writer);
+        jsonFieldString(&writer, "name", rule->name);
+        jsonFieldString(&writer, "expression", rule->text);
+        jsonFieldBool(&writer, "active", __atomic_load_n(&rule->active, __ATOMIC_RELAXED) != 0);
+        jsonKey(&writer, "changed_ms");
+        if (changedMs == 0) {
+            jsonNull(&writer);
+        } else {
+            jsonUint(&writer, changedMs);
+        }
+        jsonFieldUint(&writer, "raised", __atomic_load_n(&rule->raised, __ATOMIC_RELAXED));
+        jsonEndObject(&writer);
+    }
+    jsonEndArray(&writer);
+    jsonEndObject(&writer);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+void alertRulesCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (!rulesRunning) {
+        return;
+    }
+    metricsHeader(out, "watchdog_alert_active", "gauge", "Alert rule currently true");
+    for (int r = 0; r < ruleCount; r++) {
+        strbufAppendf(out, "watchdog_alert_active{rule=\"%s\"} %u\n", rules[r].name,
+                      __atomic_load_n(&rules[r].active, __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_alert_raised_total", "counter", "Times an alert rule became true");
+    for (int r = 0; r < ruleCount; r++) {
+        strbufAppendf(out, "watchdog_alert_raised_total{rule=\"%s\"} %llu\n", rules[r].name,
+                      (unsigned long long)__atomic_load_n(&rules[r].raised, __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_alert_comparisons", "gauge", "Compiled comparisons evaluated after every sweep");
+    strbufAppendf(out, "watchdog_alert_comparisons %d\n", comparisonCount);
+    metricsHeader(out, "watchdog_alert_evaluations_total", "counter", "Sweeps the alert rules were evaluated on");
+    strbufAppendf(out, "watchdog_alert_evaluations_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&evaluations, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_alert_evaluation_seconds_total", "counter", "Time spent evaluating the alert rules");
+    strbufAppendf(out, "watchdog_alert_evaluation_seconds_total %.6f\n",
+                  (double)__atomic_load_n(&evaluationNs, __ATOMIC_RELAXED) / 1e9);
+}
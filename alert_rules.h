@@ -0,0 +1,61 @@
+#ifndef ALERT_RULES_H
+#define ALERT_RULES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <microhttpd.h>
+#include "strbuf.h"
+#include "build_profile.h"
+
+#ifndef ALERT_MAX_RULES
+#define ALERT_MAX_RULES 256
+#endif
+#ifndef ALERT_MAX_COMPARISONS
+#define ALERT_MAX_COMPARISONS 1024           // Across all rules
+#endif
+#define ALERT_NAME_MAX 32
+#define ALERT_TEXT_MAX 256                   // A rule as written, name included
+#define ALERT_MAX_HOLD_MS (24u * 3600 * 1000)
+
+// On-box alerting over the HWM sweeps. A rule is
+//
+//   NAME: SENSOR OP VALUE [for DURATION] [and|or ...]
+//
+// SENSOR is a sensor as /api/hwm names it, by the EC's label or as
+// KIND+INDEX (temperature0, voltage2, fan1, current0, case_open0), OP one
+// of > >= < <= == !=, VALUE in the sensor's unit (Celsius, volts, RPM,
+// amperes, 0/1) and DURATION a number with ms, s, m or h (seconds if
+// bare): the comparison must have held that long. "and" binds tighter
+// than "or"; there are no parentheses.
+//
+// Rules are parsed when added and compiled by alertRulesStart(), once
+// the sensors are known, into one flat array of comparisons against raw
+// values: the threshold is converted to the sensor's raw unit up front
+// and every operator becomes an inclusive raw range, so a comparison is
+// one subtraction and one unsigned compare with no conversion and no
+// branching on the operator. After every sweep the whole array is walked
+// once, in order, updating each comparison's hold time; nothing
+// short-circuits, so a sweep costs the same whatever the readings are. A
+// rule that becomes true or false is published as EVENT_ALERT and posted
+// to the webhooks.
+
+// Before alertRulesStart(): add one rule, or the rules in a file, one per
+// line ('#' starts a comment). False on a syntax error, a duplicate name
+// or when the tables are full.
+bool alertRulesAdd(const char *spec);
+bool alertRulesLoad(const char *path);
+int alertRulesCount(void);
+
+// After hwmInit(): compile the rules and listen to the sampler. A rule
+// naming a sensor that is not sampled is left out; false when none is left.
+bool alertRulesStart(void);
+
+// For event formatting; NULL for an unknown index
+const char* alertRuleName(uint32_t index);
+
+// GET /api/alerts: every rule, its state and when it last changed
+enum MHD_Result alertRulesQueueResponse(struct MHD_Connection *connection);
+
+void alertRulesCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // ALERT_RULES_H
@@ -0,0 +1,315 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "backlight.h"
+#include "hw_actor.h"
+#include "metrics.h"
+#include "susi_caps.h"
+#include "susi_timing.h"
+#include "timeutil.h"
+
+typedef struct {
+    BacklightStatus status;
+    bool present;
+    uint32_t from;                   // Ramp start level
+    uint64_t rampStartNs;
+    uint64_t rampEndNs;              // 0 for a step to the target
+    bool pending;                    // Target not yet written
+} Panel;
+
+// One brightness write on the hardware thread
+typedef struct {
+    SusiId_t id;
+    uint32_t brightness;
+    uint64_t request;                // Panel's request count when the write was chosen
+    SusiStatus_t status;
+} BacklightWrite;
+
+static Panel panels[SUSI_ID_BACKLIGHT_MAX];
+static int panelCount;
+static uint32_t rateHz = BACKLIGHT_DEFAULT_RATE_HZ;
+static pthread_t rampThread;
+static bool rampRunning;
+static bool stopping;
+static pthread_mutex_t panelLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t panelWake;
+
+void backlightSetRate(uint32_t hz) {
+    rateHz = hz > BACKLIGHT_MAX_RATE_HZ ? BACKLIGHT_MAX_RATE_HZ : hz;
+}
+
+static void hwProbePanels(void *arg) {
+    (void)arg;
+
+    panelCount = 0;
+    for (SusiId_t id = 0; id < SUSI_ID_BACKLIGHT_MAX; id++) {
+        Panel *panel = &panels[id];
+        uint64_t start = monotonicNowNs();
+        SusiStatus_t status = SusiVgaGetBacklightBrightness(id, &panel->status.brightness);
+
+        susiTimingRecord(SUSI_CALL_VGA_GET_BACKLIGHT_BRIGHTNESS, start, status);
+        if (status != SUSI_STATUS_SUCCESS) {
+            continue;
+        }
+        status = susiCapsGet(SUSI_CAPS_VGA, id, SUSI_ID_VGA_BRIGHTNESS_MAXIMUM, &panel->status.maximum);
+        if (status != SUSI_STATUS_SUCCESS) {
+            continue;
+        }
+        status = susiCapsGet(SUSI_CAPS_VGA, id, SUSI_ID_VGA_BRIGHTNESS_MINIMUM, &panel->status.minimum);
+        if (status != SUSI_STATUS_SUCCESS) {
+            panel->status.minimum = 0;
+        }
+        panel->status.id = id;
+        panel->status.target = panel->status.brightness;
+        panel->status.lastStatus = SUSI_STATUS_SUCCESS;
+        panel->present = true;
+        panelCount++;
+    }
+}
+
+static void hwSetBrightness(void *arg) {
+    BacklightWrite *write = arg;
+    uint64_t start = monotonicNowNs();
+
+    write->status = SusiVgaSetBacklightBrightness(write->id, write->brightness);
+    susiTimingRecord(SUSI_CALL_VGA_SET_BACKLIGHT_BRIGHTNESS, start, write->status);
+}
+
+// Ramp position at nowNs, rounded toward the start level
+static uint32_t rampLevel(const Panel *panel, uint64_t nowNs) {
+    int64_t span;
+    int64_t elapsed;
+
+    if (nowNs >= panel->rampEndNs) {
+        return panel->status.target;
+    }
+    span = (int64_t)(panel->rampEndNs - panel->rampStartNs);
+    elapsed = (int64_t)(nowNs - panel->rampStartNs);
+    span = span > 0 ? span : 1;
+    return (uint32_t)((int64_t)panel->from +
+                      ((int64_t)panel->status.target - (int64_t)panel->from) * elapsed / span);
+}
+
+static void* rampThreadMain(void *arg) {
+    uint64_t tickNs = 1000000000ull / rateHz;
+    uint64_t nextTickNs = 0;
+    (void)arg;
+
+    pthread_setname_np(pthread_self(), "backlight");
+    pthread_mutex_lock(&panelLock);
+    while (!stopping) {
+        BacklightWrite writes[SUSI_ID_BACKLIGHT_MAX];
+        int count = 0;
+        uint64_t now = monotonicNowNs();
+
+        if (now < nextTickNs) {
+            struct timespec deadline = { (time_t)(nextTickNs / 1000000000ull), (long)(nextTickNs % 1000000000ull) };
+
+            pthread_cond_timedwait(&panelWake, &panelLock, &deadline);
+            continue;
+        }
+        for (SusiId_t id = 0; id < SUSI_ID_BACKLIGHT_MAX; id++) {
+            Panel *panel = &panels[id];
+            uint32_t level;
+
+            if (!panel->pending) {
+                continue;
+            }
+            level = rampLevel(panel, now);
+            if (level != panel->status.brightness) {
+                writes[count].id = id;
+                writes[count].brightness = level;
+                writes[count].request = panel->status.requests;
+                count++;
+            } else if (now >= panel->rampEndNs) {
+                panel->pending = false;
+            }
+        }
+        if (count == 0) {
+            bool ramping = false;
+
+            for (int i = 0; i < SUSI_ID_BACKLIGHT_MAX; i++) {
+                ramping |= panels[i].pending;
+            }
+            // A slow ramp may not move by a whole level every tick
+            if (ramping) {
+                nextTickNs = now + tickNs;
+            } else {
+                pthread_cond_wait(&panelWake, &panelLock);
+            }
+            continue;
+        }
+        nextTickNs = now + tickNs;
+
+        // Requests keep arriving while the EC is busy; they are picked up
+        // on the next tick
+        pthread_mutex_unlock(&panelLock);
+        for (int i = 0; i < count; i++) {
+            if (!hwActorCall(HW_LANE_USER, hwSetBrightness, &writes[i])) {
+                writes[i].status = SUSI_STATUS_LOCKFAIL;
+            }
+        }
+        pthread_mutex_lock(&panelLock);
+
+        for (int i = 0; i < count; i++) {
+            Panel *panel = &panels[writes[i].id];
+
+            panel->status.lastStatus = writes[i].status;
+            if (writes[i].status == SUSI_STATUS_SUCCESS) {
+                panel->status.brightness = writes[i].brightness;
+                panel->status.writes++;
+                if (writes[i].brightness == panel->status.target && now >= panel->rampEndNs) {
+                    panel->pending = false;
+                }
+            } else {
+                panel->status.errors++;
+                if (panel->status.requests != writes[i].request) {
+                    continue;
+                }
+                // Give up on the target rather than retry every tick
+                panel->status.target = panel->status.brightness;
+                panel->rampEndNs = 0;
+                panel->pending = false;
+            }
+        }
+    }
+    pthread_mutex_unlock(&panelLock);
+    return NULL;
+}
+
+bool backlightStart(void) {
+    pthread_condattr_t attr;
+
+    if (rateHz == 0 || rampRunning || !hwActorCall(HW_LANE_READ, hwProbePanels, NULL)) {
+        return false;
+    }
+    if (panelCount == 0) {
+        return false;
+    }
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&panelWake, &attr);
+    pthread_condattr_destroy(&attr);
+    stopping = false;
+    if (pthread_create(&rampThread, NULL, rampThreadMain, NULL) != 0) {
+        pthread_cond_destroy(&panelWake);
+        return false;
+    }
+    rampRunning = true;
+    printf("Backlight: %d panel(s), at most %u brightness writes per second each\n", panelCount, rateHz);
+    return true;
+}
+
+void backlightStop(void) {
+    if (!rampRunning) {
+        return;
+    }
+    pthread_mutex_lock(&panelLock);
+    stopping = true;
+    pthread_cond_signal(&panelWake);
+    pthread_mutex_unlock(&panelLock);
+    pthread_join(rampThread, NULL);
+    pthread_cond_destroy(&panelWake);
+    rampRunning = false;
+}
+
+const char* backlightRequest(SusiId_t id, uint32_t brightness, uint32_t rampMs) {
+    Panel *panel;
+    uint64_t now;
+
+    if (!rampRunning) {
+        return "Backlight control is not running";
+    }
+    if (id >= SUSI_ID_BACKLIGHT_MAX || !panels[id].present) {
+        return "Unknown backlight";
+    }
+    panel = &panels[id];
+    if (brightness < panel->status.minimum || brightness > panel->status.maximum) {
+        return "Brightness outside the panel's range";
+    }
+    if (rampMs > BACKLIGHT_MAX_RAMP_MS) {
+        return "Ramp time too long";
+    }
+    pthread_mutex_lock(&panelLock);
+    now = monotonicNowNs();
+    if (panel->pending) {
+        panel->status.coalesced++;
+    }
+    panel->from = panel->pending ? rampLevel(panel, now) : panel->status.brightness;
+    panel->status.target = brightness;
+    panel->rampStartNs = now;
+    panel->rampEndNs = rampMs > 0 ? now + (uint64_t)rampMs * 1000000ull : 0;
+    panel->pending = true;
+    panel->status.requests++;
+    pthread_cond_signal(&panelWake);
+    pthread_mutex_unlock(&panelLock);
+    return NULL;
+}
+
+void backlightChanged(SusiId_t id, uint32_t brightness) {
+    if (id >= SUSI_ID_BACKLIGHT_MAX || !panels[id].present) {
+        return;
+    }
+    pthread_mutex_lock(&panelLock);
+    panels[id].status.brightness = brightness;
+    panels[id].status.target = brightness;
+    panels[id].rampEndNs = 0;
+    panels[id].pending = false;
+    pthread_mutex_unlock(&panelLock);
+}
+
+int backlightStatus(BacklightStatus *status, int max) {
+    uint64_t now = monotonicNowNs();
+    int count = 0;
+
+    pthread_mutex_lock(&panelLock);
+    for (int i = 0; i < SUSI_ID_BACKLIGHT_MAX && count < max; i++) {
+        if (!panels[i].present) {
+            continue;
+        }
+        status[count] = panels[i].status;
+        status[count].rampRemainingMs = panels[i].pending && panels[i].rampEndNs > now ?
+                                        (uint32_t)((panels[i].rampEndNs - now) / 1000000ull) : 0;
+        count++;
+    }
+    pthread_mutex_unlock(&panelLock);
+    return count;
+}
+
+void backlightCollectMetrics(StrBuf *out, void *ctx) {
+    BacklightStatus status[SUSI_ID_BACKLIGHT_MAX];
+    int count = backlightStatus(status, SUSI_ID_BACKLIGHT_MAX);
+    (void)ctx;
+
+    if (count == 0) {
+        return;
+    }
+    metricsHeader(out, "watchdog_backlight_brightness", "gauge", "Brightness the EC last accepted");
+    for (int i = 0; i < count; i++) {
+        strbufAppendf(out, "watchdog_backlight_brightness{panel=\"%u\"} %u\n", status[i].id, status[i].brightness);
+    }
+    metricsHeader(out, "watchdog_backlight_target", "gauge", "Brightness the panel is ramping to");
+    for (int i = 0; i < count; i++) {
+        strbufAppendf(out, "watchdog_backlight_target{panel=\"%u\"} %u\n", status[i].id, status[i].target);
+    }
+    metricsHeader(out, "watchdog_backlight_requests_total", "counter", "Brightness requests");
+    for (int i = 0; i < count; i++) {
+        strbufAppendf(out, "watchdog_backlight_requests_total{panel=\"%u\"} %llu\n", status[i].id,
+                      (unsigned long long)status[i].requests);
+    }
+    metricsHeader(out, "watchdog_backlight_coalesced_total", "counter", "Requests replaced by a newer one before they were reached");
+    for (int i = 0; i < count; i++) {
+        strbufAppendf(out, "watchdog_backlight_coalesced_total{panel=\"%u\"} %llu\n", status[i].id,
+                      (unsigned long long)status[i].coalesced);
+    }
+    metricsHeader(out, "watchdog_backlight_writes_total", "counter", "Brightness writes the EC accepted");
+    for (int i = 0; i < count; i++) {
+        strbufAppendf(out, "watchdog_backlight_writes_total{panel=\"%u\"} %llu\n", status[i].id,
+                      (unsigned long long)status[i].writes);
+    }
+    metricsHeader(out, "watchdog_backlight_errors_total", "counter", "Brightness writes that failed");
+    for (int i = 0; i < count; i++) {
+        strbufAppendf(out, "watchdog_backlight_errors_total{panel=\"%u\"} %llu\n", status[i].id,
+                      (unsigned long long)status[i].errors);
+    }
+}
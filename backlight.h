@@ -0,0 +1,54 @@
+#ifndef BACKLIGHT_H
+#define BACKLIGHT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "Susi4.h"
+#include "strbuf.h"
+
+#define BACKLIGHT_DEFAULT_RATE_HZ 20         // Most brightness writes per panel per second
+#define BACKLIGHT_MAX_RATE_HZ 200
+#define BACKLIGHT_MAX_RAMP_MS 600000
+
+// Brightness ramps. Clients only set a panel's target, optionally reached
+// over a ramp time, and return at once; a new target replaces the old one
+// and a ramp in progress continues from where it is. A ramp thread wakes
+// once per tick (1 / rate) while a panel is off its target and writes each
+// such panel's current ramp position with one SusiVgaSetBacklightBrightness
+// on the user lane, so a burst of requests between two ticks costs one
+// write, and no ramp, however long or steep, writes faster than the rate.
+
+// Before backlightStart(); 0 disables the engine
+void backlightSetRate(uint32_t hz);
+// Probe the panels through the hardware thread and start the ramp thread;
+// false without a panel or with a rate of 0
+bool backlightStart(void);
+void backlightStop(void);
+
+// Move a panel to brightness over rampMs (0 = on the next tick). Returns
+// NULL, or why the request was refused. Never waits for the EC.
+const char* backlightRequest(SusiId_t id, uint32_t brightness, uint32_t rampMs);
+// Another path wrote the panel's brightness (hardware thread): any ramp is
+// dropped and the new level becomes the target
+void backlightChanged(SusiId_t id, uint32_t brightness);
+
+typedef struct {
+    SusiId_t id;
+    uint32_t minimum;                // Brightness range reported by the EC
+    uint32_t maximum;
+    uint32_t brightness;             // Last level the EC accepted
+    uint32_t target;
+    uint32_t rampRemainingMs;        // 0 once the ramp has reached its target
+    uint64_t requests;
+    uint64_t coalesced;              // Requests replaced before they were reached
+    uint64_t writes;
+    uint64_t errors;
+    SusiStatus_t lastStatus;
+} BacklightStatus;
+
+// Copy the state of up to max panels; returns how many were copied
+int backlightStatus(BacklightStatus *status, int max);
+
+void backlightCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // BACKLIGHT_H
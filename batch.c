@@ -0,0 +1,326 @@
+#include <stdlib.h>
+#include <string.h>
+#include "batch.h"
+#include "histogram.h"
+#include "hw_actor.h"
+#include "metrics.h"
+#include "susi_breaker.h"
+#include "timeutil.h"
+#include "watchdog.h"
+
+#define GPIO_PINS_PER_BANK 32
+
+static const char *kindNames[BATCH_OP_KIND_COUNT] = {
+    [BATCH_OP_VALUE]       = "value",
+    [BATCH_OP_GPIO]        = "gpio",
+    [BATCH_OP_BOARD]       = "board",
+    [BATCH_OP_WDT_STATUS]  = "wdt_status",
+    [BATCH_OP_WDT_TRIGGER] = "wdt_trigger",
+    [BATCH_OP_WDT_START]   = "wdt_start",
+    [BATCH_OP_WDT_STOP]    = "wdt_stop",
+};
+
+static uint64_t batches = 0;
+static uint64_t opCounts[BATCH_OP_KIND_COUNT];
+static uint64_t failedOps = 0;
+static uint64_t driverReads = 0;
+static Histogram batchLatency;
+
+// The token up to the next ':' or ',' equals word
+static bool tokenIs(const char *spec, const char *word) {
+    size_t length = strlen(word);
+
+    return strncmp(spec, word, length) == 0 && (spec[length] == ':' || spec[length] == ',' || spec[length] == '\0');
+}
+
+static const char* parseOp(const char **cursor, BatchOp *op) {
+    const char *spec = *cursor;
+    unsigned long value;
+    char *end;
+
+    memset(op, 0, sizeof(*op));
+    if (tokenIs(spec, "board")) {
+        op->kind = BATCH_OP_BOARD;
+        *cursor = spec + 5;
+        return NULL;
+    }
+    if (tokenIs(spec, "value") || tokenIs(spec, "gpio")) {
+        bool gpio = spec[0] == 'g';
+
+        spec += gpio ? 4 : 5;
+        if (*spec != ':') {
+            return gpio ? "gpio needs a pin (gpio:PIN)" : "value needs an ID (value:ID)";
+        }
+        value = strtoul(spec + 1, &end, 0);
+        if (end == spec + 1 || value > UINT32_MAX || (gpio && value >= GPIO_BANK_MAX * GPIO_PINS_PER_BANK)) {
+            return gpio ? "Invalid GPIO pin" : "Invalid value ID";
+        }
+        op->kind = gpio ? BATCH_OP_GPIO : BATCH_OP_VALUE;
+        op->id = (uint32_t)value;
+        *cursor = end;
+        return NULL;
+    }
+    if (tokenIs(spec, "wdt")) {
+        WatchdogDevice *device;
+
+        value = strtoul(spec + 4, &end, 10);
+        if (spec[3] != ':' || end == spec + 4 || *end != ':') {
+            return "wdt needs a timer and an action (wdt:N:ACTION)";
+        }
+        device = watchdogDevice((SusiId_t)value);
+        if (device == NULL || !device->present) {
+            return "Unknown watchdog";
+        }
+        op->id = (uint32_t)value;
+        spec = end + 1;
+        if (tokenIs(spec, "status")) {
+            op->kind = BATCH_OP_WDT_STATUS;
+        } else if (tokenIs(spec, "trigger")) {
+            op->kind = BATCH_OP_WDT_TRIGGER;
+        } else if (tokenIs(spec, "start")) {
+            op->kind = BATCH_OP_WDT_START;
+        } else if (tokenIs(spec, "stop")) {
+            op->kind = BATCH_OP_WDT_STOP;
+        } else {
+            return "Unknown watchdog action (expected status, trigger, start or stop)";
+        }
+        *cursor = spec + strcspn(spec, ",");
+        return NULL;
+    }
+    return "Unknown operation (expected value, gpio, board or wdt)";
+}
+
+const char* batchParse(const char *spec, Batch *batch) {
+    memset(batch, 0, sizeof(*batch));
+    while (*spec != '\0') {
+        const char *error;
+
+        if (batch->count == BATCH_MAX_OPS) {
+            return "Too many operations (at most 64)";
+        }
+        if ((error = parseOp(&spec, &batch->ops[batch->count])) != NULL) {
+            return error;
+        }
+        if (*spec != ',' && *spec != '\0') {
+            return "Operations are separated by commas";
+        }
+        batch->count++;
+        spec += *spec == ',';
+    }
+    return batch->count > 0 ? NULL : "No operations";
+}
+
+// The read pass, one hardware command. A value or bank asked for twice is
+// read once.
+static void hwRead(void *arg) {
+    Batch *batch = (Batch *)arg;
+    GpioBankState banks[GPIO_BANK_MAX];
+    GpioBankResult bankResults[GPIO_BANK_MAX];
+    uint32_t banksRead = 0;
+    bool board = false;
+
+    for (int i = 0; i < batch->count; i++) {
+        BatchOp *op = &batch->ops[i];
+        int earlier = -1;
+
+        if (op->kind != BATCH_OP_VALUE) {
+            board = board || op->kind == BATCH_OP_BOARD;
+            continue;
+        }
+        for (int j = 0; j < i && earlier < 0; j++) {
+            if (batch->ops[j].kind == BATCH_OP_VALUE && batch->ops[j].id == op->id) {
+                earlier = j;
+            }
+        }
+        if (earlier >= 0) {
+            *op = batch->ops[earlier];
+            continue;
+        }
+        op->status = susiBreakerBoardGetValue(op->id, &op->value, &op->stale);
+        batch->reads++;
+    }
+
+    for (int i = 0; i < batch->count; i++) {
+        BatchOp *op = &batch->ops[i];
+        uint32_t bank = op->id / GPIO_PINS_PER_BANK;
+        uint32_t bit = 1u << (op->id % GPIO_PINS_PER_BANK);
+
+        if (op->kind != BATCH_OP_GPIO) {
+            continue;
+        }
+        if (!(banksRead & (1u << bank))) {
+            bankResults[bank] = hwGpioBankRead(bank, &banks[bank]);
+            banksRead |= 1u << bank;
+            batch->reads += bankResults[bank] != GPIO_BANK_UNKNOWN;
+        }
+        if (bankResults[bank] == GPIO_BANK_UNKNOWN || !((banks[bank].inputs | banks[bank].outputs) & bit)) {
+            op->status = SUSI_STATUS_UNSUPPORTED;
+            continue;
+        }
+        op->status = banks[bank].status;
+        op->value = (banks[bank].level & bit) != 0;
+        op->input = (banks[bank].direction & bit) != 0;
+    }
+
+    if (board) {
+        hwBoardInfoReadCounters(&batch->counters);
+        batch->reads += 2;
+    }
+}
+
+static void runAction(BatchOp *op) {
+    WatchdogCommand cmd;
+    HwCommandFn fn;
+    HwLane lane = HW_LANE_CONFIG;
+
+    switch (op->kind) {
+    case BATCH_OP_WDT_TRIGGER:
+        fn = hwWatchdogTrigger;
+        lane = HW_LANE_FEED;
+        break;
+    case BATCH_OP_WDT_START:
+        fn = hwWatchdogStart;
+        break;
+    case BATCH_OP_WDT_STOP:
+        fn = hwWatchdogStop;
+        break;
+    default:
+        return;
+    }
+    watchdogCommandInit(&cmd, watchdogDevice((SusiId_t)op->id));
+    if (!watchdogExecute(lane, fn, &cmd)) {
+        op->error = cmd.error != NULL ? cmd.error : "Watchdog command failed";
+    }
+}
+
+bool batchRun(Batch *batch) {
+    uint64_t start = monotonicNowNs();
+    bool reads = false;
+
+    for (int i = 0; i < batch->count; i++) {
+        runAction(&batch->ops[i]);
+        reads = reads || batch->ops[i].kind == BATCH_OP_VALUE || batch->ops[i].kind == BATCH_OP_GPIO ||
+                batch->ops[i].kind == BATCH_OP_BOARD;
+    }
+    if (reads && !hwActorCall(HW_LANE_READ, hwRead, batch)) {
+        return false;
+    }
+    for (int i = 0; i < batch->count; i++) {
+        BatchOp *op = &batch->ops[i];
+
+        if ((op->kind == BATCH_OP_VALUE || op->kind == BATCH_OP_GPIO) && op->status != SUSI_STATUS_SUCCESS) {
+            op->error = op->status == SUSI_STATUS_UNSUPPORTED ? "Not supported" : "Read failed";
+        }
+        batch->failed += op->error != NULL;
+        __atomic_fetch_add(&opCounts[op->kind], 1, __ATOMIC_RELAXED);
+    }
+    batch->durationNs = monotonicNowNs() - start;
+
+    __atomic_fetch_add(&batches, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&failedOps, (uint64_t)batch->failed, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&driverReads, (uint64_t)batch->reads, __ATOMIC_RELAXED);
+    histogramRecord(&batchLatency, batch->durationNs);
+    return true;
+}
+
+size_t batchResponseSize(const Batch *batch) {
+    size_t size = 128;
+
+    for (int i = 0; i < batch->count; i++) {
+        switch (batch->ops[i].kind) {
+        case BATCH_OP_BOARD:
+            size += BOARD_INFO_SNAPSHOT_CAPACITY;
+            break;
+        case BATCH_OP_WDT_STATUS:
+            size += 768;
+            break;
+        default:
+            size += 160;
+            break;
+        }
+    }
+    return size;
+}
+
+void batchWrite(JsonWriter *writer, const Batch *batch) {
+    jsonBeginObject(writer);
+    jsonFieldInt(writer, "failed", batch->failed);
+    jsonFieldInt(writer, "reads", batch->reads);
+    jsonFieldUint(writer, "duration_us", batch->durationNs / 1000);
+    jsonKey(writer, "ops");
+    jsonBeginArray(writer);
+    for (int i = 0; i < batch->count; i++) {
+        const BatchOp *op = &batch->ops[i];
+
+        jsonBeginObject(writer);
+        switch (op->kind) {
+        case BATCH_OP_VALUE:
+            jsonFieldString(writer, "op", "value");
+            jsonFieldUint(writer, "id", op->id);
+            jsonFieldUint(writer, "status", op->status);
+            if (op->status == SUSI_STATUS_SUCCESS) {
+                jsonFieldUint(writer, "value", op->value);
+                if (op->stale) {
+                    jsonFieldBool(writer, "stale", true);
+                }
+            }
+            break;
+        case BATCH_OP_GPIO:
+            jsonFieldString(writer, "op", "gpio");
+            jsonFieldUint(writer, "pin", op->id);
+            jsonFieldUint(writer, "status", op->status);
+            if (op->status == SUSI_STATUS_SUCCESS) {
+                jsonFieldUint(writer, "level", op->value);
+                jsonFieldBool(writer, "input", op->input);
+            }
+            break;
+        case BATCH_OP_BOARD:
+            jsonFieldString(writer, "op", "board");
+            jsonKey(writer, "board");
+            boardInfoWrite(writer, &batch->counters);
+            break;
+        case BATCH_OP_WDT_STATUS:
+            jsonFieldString(writer, "op", "wdt");
+            jsonFieldString(writer, "action", "status");
+            watchdogWriteStatus(writer, watchdogDevice((SusiId_t)op->id));
+            break;
+        default:
+            jsonFieldString(writer, "op", "wdt");
+            jsonFieldString(writer, "action", kindNames[op->kind] + 4);
+            jsonFieldUint(writer, "watchdog_id", op->id);
+            jsonFieldBool(writer, "ok", op->error == NULL);
+            break;
+        }
+        if (op->error != NULL) {
+            jsonFieldString(writer, "error", op->error);
+        }
+        jsonEndObject(writer);
+    }
+    jsonEndArray(writer);
+    jsonEndObject(writer);
+}
+
+void batchCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (__atomic_load_n(&batches, __ATOMIC_RELAXED) == 0) {
+        return;
+    }
+    metricsHeader(out, "watchdog_http_batches_total", "counter", "POST /api/batch requests run");
+    strbufAppendf(out, "watchdog_http_batches_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&batches, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_http_batch_ops_total", "counter", "Operations run by batches, by kind");
+    for (int kind = 0; kind < BATCH_OP_KIND_COUNT; kind++) {
+        strbufAppendf(out, "watchdog_http_batch_ops_total{op=\"%s\"} %llu\n", kindNames[kind],
+                      (unsigned long long)__atomic_load_n(&opCounts[kind], __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_http_batch_ops_failed_total", "counter", "Batch operations that returned an error");
+    strbufAppendf(out, "watchdog_http_batch_ops_failed_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&failedOps, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_http_batch_driver_reads_total", "counter",
+                  "Driver reads made by batch read passes, after merging repeated values and pins of one bank");
+    strbufAppendf(out, "watchdog_http_batch_driver_reads_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&driverReads, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_http_batch_seconds", "summary", "Time to run one batch, actions and read pass together");
+    histogramWriteSummary(out, "watchdog_http_batch_seconds", NULL, &batchLatency);
+}
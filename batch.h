@@ -0,0 +1,64 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "Susi4.h"
+#include "board_info.h"
+#include "gpio_bank.h"
+#include "json_writer.h"
+#include "strbuf.h"
+
+#define BATCH_MAX_OPS 64
+
+// Mixed operations of one POST /api/batch, so a polling agent makes one
+// round trip per cycle instead of one per value. Watchdog actions run
+// first, in the order given, each on its own lane (a trigger still goes
+// through the feed lane and never waits behind reads). Every read then
+// runs in a single command on the read lane, grouped by subsystem: the
+// board values, one level read per GPIO bank however many of its pins
+// were asked for, and the board counters. Results come back in request
+// order.
+
+typedef enum {
+    BATCH_OP_VALUE,                  // SusiBoardGetValue, through the breaker
+    BATCH_OP_GPIO,                   // Level of one pin
+    BATCH_OP_BOARD,                  // The /api/board object, counters read now
+    BATCH_OP_WDT_STATUS,
+    BATCH_OP_WDT_TRIGGER,
+    BATCH_OP_WDT_START,              // With the timer's configured timings
+    BATCH_OP_WDT_STOP,
+    BATCH_OP_KIND_COUNT
+} BatchOpKind;
+
+typedef struct {
+    BatchOpKind kind;
+    uint32_t id;                     // SusiId_t, pin number or watchdog ID
+    SusiStatus_t status;             // Value and GPIO reads
+    uint32_t value;                  // Value; GPIO: 1 = high
+    bool stale;                      // Value served by an open breaker
+    bool input;                      // GPIO pin is an input
+    const char *error;               // Set when the operation failed
+} BatchOp;
+
+typedef struct {
+    BatchOp ops[BATCH_MAX_OPS];
+    int count;
+    int failed;
+    int reads;                       // Driver calls made by the read pass
+    uint64_t durationNs;             // Whole batch, actions included
+    BoardCounters counters;          // For BATCH_OP_BOARD
+} Batch;
+
+// OP[,OP...] with OP one of value:ID, gpio:PIN, board and
+// wdt:N:status|trigger|start|stop; NULL, or what is wrong with spec
+const char* batchParse(const char *spec, Batch *batch);
+// Run a parsed batch; false if the read pass could not be queued
+bool batchRun(Batch *batch);
+// Upper bound of what batchWrite() produces, for sizing the response
+size_t batchResponseSize(const Batch *batch);
+void batchWrite(JsonWriter *writer, const Batch *batch);
+
+void batchCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // BATCH_H
@@ -0,0 +1,459 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "battery_monitor.h"
+#include "Susi4.h"
+#include "events.h"
+#include "hw_actor.h"
+#include "json_writer.h"
+#include "metrics.h"
+#include "scheduler.h"
+#include "susi_device.h"
+#include "timeutil.h"
+#include "webhook.h"
+
+// From SUSIDeviceDEMO/SmartBatteryDEMO/SmartBattery.h
+#define SBS_ID_BASE                     0x00B00000
+
+static const struct {
+    SusiId_t id;
+    const char *name;
+    BatteryTier tier;
+    bool isSigned;                   // 16-bit two's complement
+} registers[BATTERY_REG_COUNT] = {
+    [BATTERY_REG_UNIT]                     = { SBS_ID_BASE + 0x00, "unit", BATTERY_TIER_STATIC, false },
+    [BATTERY_REG_DESIGN_CAPACITY]          = { SBS_ID_BASE + 0x18, "design_capacity", BATTERY_TIER_STATIC, false },
+    [BATTERY_REG_DESIGN_VOLTAGE]           = { SBS_ID_BASE + 0x19, "design_voltage", BATTERY_TIER_STATIC, false },
+    [BATTERY_REG_SPECIFICATION_INFO]       = { SBS_ID_BASE + 0x1A, "specification_info", BATTERY_TIER_STATIC, false },
+    [BATTERY_REG_MANUFACTURE_DATE]         = { SBS_ID_BASE + 0x1B, "manufacture_date", BATTERY_TIER_STATIC, false },
+    [BATTERY_REG_SERIAL_NUMBER]            = { SBS_ID_BASE + 0x1C, "serial_number", BATTERY_TIER_STATIC, false },
+    [BATTERY_REG_NAME_1]                   = { SBS_ID_BASE + 0x24, "manufacturer_name_1", BATTERY_TIER_STATIC, false },
+    [BATTERY_REG_NAME_2]                   = { SBS_ID_BASE + 0x25, "manufacturer_name_2", BATTERY_TIER_STATIC, false },
+    [BATTERY_REG_NAME_3]                   = { SBS_ID_BASE + 0x26, "manufacturer_name_3", BATTERY_TIER_STATIC, false },
+    [BATTERY_REG_NAME_4]                   = { SBS_ID_BASE + 0x27, "manufacturer_name_4", BATTERY_TIER_STATIC, false },
+    [BATTERY_REG_NAME_5]                   = { SBS_ID_BASE + 0x28, "manufacturer_name_5", BATTERY_TIER_STATIC, false },
+    [BATTERY_REG_REMAINING_CAPACITY_ALARM] = { SBS_ID_BASE + 0x01, "remaining_capacity_alarm", BATTERY_TIER_SLOW, false },
+    [BATTERY_REG_REMAINING_TIME_ALARM]     = { SBS_ID_BASE + 0x02, "remaining_time_alarm", BATTERY_TIER_SLOW, false },
+    [BATTERY_REG_BATTERY_MODE]             = { SBS_ID_BASE + 0x03, "battery_mode", BATTERY_TIER_SLOW, false },
+    [BATTERY_REG_MAX_ERROR]                = { SBS_ID_BASE + 0x0C, "max_error", BATTERY_TIER_SLOW, false },
+    [BATTERY_REG_FULL_CHARGE_CAPACITY]     = { SBS_ID_BASE + 0x10, "full_charge_capacity", BATTERY_TIER_SLOW, false },
+    [BATTERY_REG_CHARGING_CURRENT]         = { SBS_ID_BASE + 0x14, "charging_current", BATTERY_TIER_SLOW, false },
+    [BATTERY_REG_CHARGING_VOLTAGE]         = { SBS_ID_BASE + 0x15, "charging_voltage", BATTERY_TIER_SLOW, false },
+    [BATTERY_REG_CYCLE_COUNT]              = { SBS_ID_BASE + 0x17, "cycle_count", BATTERY_TIER_SLOW, false },
+    [BATTERY_REG_SOH]                      = { SBS_ID_BASE + 0x4F, "soh", BATTERY_TIER_SLOW, false },
+    [BATTERY_REG_TEMPERATURE]              = { SBS_ID_BASE + 0x08, "temperature", BATTERY_TIER_SLOW, false },
+    [BATTERY_REG_VOLTAGE]                  = { SBS_ID_BASE + 0x09, "voltage", BATTERY_TIER_FAST, false },
+    [BATTERY_REG_CURRENT]                  = { SBS_ID_BASE + 0x0A, "current", BATTERY_TIER_FAST, true },
+    [BATTERY_REG_AVERAGE_CURRENT]          = { SBS_ID_BASE + 0x0B, "average_current", BATTERY_TIER_FAST, true },
+    [BATTERY_REG_RELATIVE_CHARGE]          = { SBS_ID_BASE + 0x0D, "relative_state_of_charge", BATTERY_TIER_FAST, false },
+    [BATTERY_REG_ABSOLUTE_CHARGE]          = { SBS_ID_BASE + 0x0E, "absolute_state_of_charge", BATTERY_TIER_FAST, false },
+    [BATTERY_REG_REMAINING_CAPACITY]       = { SBS_ID_BASE + 0x0F, "remaining_capacity", BATTERY_TIER_FAST, false },
+    [BATTERY_REG_RUN_TIME_TO_EMPTY]        = { SBS_ID_BASE + 0x11, "run_time_to_empty", BATTERY_TIER_FAST, false },
+    [BATTERY_REG_AVERAGE_TIME_TO_EMPTY]    = { SBS_ID_BASE + 0x12, "average_time_to_empty", BATTERY_TIER_FAST, false },
+    [BATTERY_REG_AVERAGE_TIME_TO_FULL]     = { SBS_ID_BASE + 0x13, "average_time_to_full", BATTERY_TIER_FAST, false },
+    [BATTERY_REG_BATTERY_STATUS]           = { SBS_ID_BASE + 0x16, "battery_status", BATTERY_TIER_FAST, false },
+};
+
+static const char *alarmNames[] = { "none", "low", "critical" };
+
+static const char *tierNames[BATTERY_TIER_COUNT] = {
+    [BATTERY_TIER_STATIC] = "static",
+    [BATTERY_TIER_SLOW]   = "slow",
+    [BATTERY_TIER_FAST]   = "fast",
+};
+
+// One pass over the registers of the tiers set in tierMask
+typedef struct {
+    uint32_t tierMask;
+    uint64_t skip;                   // Registers of those tiers not to read
+    uint32_t values[BATTERY_REG_COUNT];
+    uint64_t read;                   // Bit per register read in this pass
+    uint64_t failed;                 // Bit per register that failed
+} BatteryRead;
+
+static uint32_t fastMs = BATTERY_DEFAULT_FAST_MS;
+static uint32_t slowMs = BATTERY_DEFAULT_SLOW_MS;
+static uint32_t slowEvery;           // Fast passes per slow pass
+static uint64_t staticMask;          // Bit per static register
+static uint32_t smoothingS = BATTERY_DEFAULT_SMOOTHING_S;
+static uint32_t lowMinutes = BATTERY_DEFAULT_LOW_MIN;
+static uint32_t criticalMinutes = BATTERY_DEFAULT_CRITICAL_MIN;
+
+static pthread_mutex_t batteryLock = PTHREAD_MUTEX_INITIALIZER;
+static int batteryTask = -1;
+static bool batteryRunning;
+static uint32_t fastPasses;          // Only touched by the task
+static BatterySnapshot latest;       // Under batteryLock
+static uint64_t registerReads[BATTERY_TIER_COUNT];
+static uint64_t readErrors[BATTERY_TIER_COUNT];
+static uint64_t alarmsRaised[BATTERY_ALARM_CRITICAL + 1];
+
+// Smoothing state, under batteryLock
+static double drainPerHour;          // Capacity units per hour, positive while discharging
+static uint64_t seededNs;
+static uint64_t smoothedNs;
+
+static uint64_t wallClockMs(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000ull + (uint64_t)now.tv_nsec / 1000000ull;
+}
+
+void batteryMonitorSetIntervals(uint32_t fast, uint32_t slow) {
+    fastMs = fast;
+    slowMs = slow;
+}
+
+void batteryMonitorSetSmoothing(uint32_t seconds) {
+    smoothingS = seconds;
+}
+
+void batteryMonitorSetAlarm(uint32_t low, uint32_t critical) {
+    lowMinutes = low;
+    criticalMinutes = critical < low ? critical : low;
+}
+
+const char* batteryAlarmName(BatteryAlarm alarm) {
+    return alarm <= BATTERY_ALARM_CRITICAL ? alarmNames[alarm] : "unknown";
+}
+
+const char* batteryRegisterName(BatteryRegister reg) {
+    return reg < BATTERY_REG_COUNT ? registers[reg].name : "unknown";
+}
+
+BatteryTier batteryRegisterTier(BatteryRegister reg) {
+    return reg < BATTERY_REG_COUNT ? registers[reg].tier : BATTERY_TIER_STATIC;
+}
+
+const char* batteryTierName(BatteryTier tier) {
+    return tier < BATTERY_TIER_COUNT ? tierNames[tier] : "unknown";
+}
+
+int32_t batteryRegisterValue(const BatterySnapshot *snapshot, BatteryRegister reg) {
+    uint32_t value = reg < BATTERY_REG_COUNT ? snapshot->values[reg] : 0;
+
+    return reg < BATTERY_REG_COUNT && registers[reg].isSigned ? (int32_t)(int16_t)(value & 0xffff) : (int32_t)value;
+}
+
+bool batteryRegisterValid(const BatterySnapshot *snapshot, BatteryRegister reg) {
+    return reg < BATTERY_REG_COUNT && (snapshot->valid & (1ull << reg)) != 0;
+}
+
+void batteryManufacturer(const BatterySnapshot *snapshot, char *name, size_t size) {
+    size_t length = 0;
+
+    if (size == 0) {
+        return;
+    }
+    for (int reg = BATTERY_REG_NAME_1; reg <= BATTERY_REG_NAME_5 && batteryRegisterValid(snapshot, (BatteryRegister)reg); reg++) {
+        for (int shift = 24; shift >= 0 && length + 1 < size; shift -= 8) {
+            char c = (char)(snapshot->values[reg] >> shift);
+
+            if (c >= 0x20 && c < 0x7f) {
+                name[length++] = c;
+            }
+        }
+    }
+    while (length > 0 && name[length - 1] == ' ') {
+        length--;
+    }
+    name[length] = '\0';
+}
+
+static void hwProbe(void *arg) {
+    uint32_t value = 0;
+
+    *(bool*)arg = susiDeviceGetValue(SBS_ID_BASE, &value) == SUSI_STATUS_SUCCESS;
+}
+
+static void hwRead(void *arg) {
+    BatteryRead *read = arg;
+
+    for (int i = 0; i < BATTERY_REG_COUNT; i++) {
+        if (!(read->tierMask & (1u << registers[i].tier)) || (read->skip & (1ull << i))) {
+            continue;
+        }
+        if (susiDeviceGetValue(registers[i].id, &read->values[i]) == SUSI_STATUS_SUCCESS) {
+            read->read |= 1ull << i;
+        } else {
+            read->failed |= 1ull << i;
+        }
+    }
+}
+
+// Fold the fast registers of this pass into the averages and move the
+// alarm; under batteryLock. True when the alarm changed.
+static bool smooth(uint64_t nowNs) {
+    BatterySnapshot *snap = &latest;
+    double current, drain, alpha, thresholdS;
+    BatteryAlarm alarm = BATTERY_ALARM_NONE;
+
+    if (!batteryRegisterValid(snap, BATTERY_REG_CURRENT) || !batteryRegisterValid(snap, BATTERY_REG_RELATIVE_CHARGE)) {
+        return false;
+    }
+    current = batteryRegisterValue(snap, BATTERY_REG_CURRENT);
+    drain = -current;
+    // 10 mWh capacity: the drain is power, V * I, in 10 mW
+    if (batteryRegisterValue(snap, BATTERY_REG_UNIT) != 0 && batteryRegisterValid(snap, BATTERY_REG_VOLTAGE)) {
+        drain = -current * batteryRegisterValue(snap, BATTERY_REG_VOLTAGE) / 10000.0;
+    }
+    if (!snap->smoothed) {
+        snap->currentMa = current;
+        snap->chargePercent = batteryRegisterValue(snap, BATTERY_REG_RELATIVE_CHARGE);
+        drainPerHour = drain;
+        seededNs = nowNs;
+        snap->smoothed = true;
+    } else {
+        alpha = smoothingS > 0 ? 1.0 - exp(-(double)(nowNs - smoothedNs) / (smoothingS * 1e9)) : 1.0;
+        snap->currentMa += alpha * (current - snap->currentMa);
+        snap->chargePercent += alpha * (batteryRegisterValue(snap, BATTERY_REG_RELATIVE_CHARGE) - snap->chargePercent);
+        drainPerHour += alpha * (drain - drainPerHour);
+    }
+    smoothedNs = nowNs;
+
+    snap->secondsToEmpty = BATTERY_NO_ESTIMATE;
+    // Under one capacity unit an hour is no drain worth forecasting
+    if (nowNs - seededNs >= (uint64_t)smoothingS * 1000000000ull && drainPerHour >= 1.0 &&
+        batteryRegisterValid(snap, BATTERY_REG_REMAINING_CAPACITY)) {
+        double seconds = batteryRegisterValue(snap, BATTERY_REG_REMAINING_CAPACITY) / drainPerHour * 3600.0;
+
+        snap->secondsToEmpty = seconds < (double)BATTERY_NO_ESTIMATE ? (uint32_t)seconds : BATTERY_NO_ESTIMATE - 1;
+    }
+
+    if (lowMinutes == 0) {
+        return false;
+    }
+    if (snap->secondsToEmpty != BATTERY_NO_ESTIMATE) {
+        // Step down only once clear of a threshold by 25%
+        thresholdS = criticalMinutes * 60.0;
+        if (snap->secondsToEmpty <= thresholdS ||
+            (snap->alarm == BATTERY_ALARM_CRITICAL && snap->secondsToEmpty <= thresholdS * 1.25)) {
+            alarm = BATTERY_ALARM_CRITICAL;
+        } else {
+            thresholdS = lowMinutes * 60.0;
+            if (snap->secondsToEmpty <= thresholdS ||
+                (snap->alarm != BATTERY_ALARM_NONE && snap->secondsToEmpty <= thresholdS * 1.25)) {
+                alarm = BATTERY_ALARM_LOW;
+            }
+        }
+    }
+    if (alarm == snap->alarm) {
+        return false;
+    }
+    if (alarm > snap->alarm) {
+        alarmsRaised[alarm]++;
+    }
+    snap->alarm = alarm;
+    return true;
+}
+
+static void announce(const BatterySnapshot *snap) {
+    char body[WEBHOOK_BODY_MAX];
+    StrBuf out;
+    JsonWriter writer;
+
+    eventPublish(EVENT_BATTERY, EVENT_NO_WATCHDOG, snap->alarm, snap->secondsToEmpty,
+                 (uint32_t)(int32_t)lround(snap->currentMa), (uint32_t)lround(snap->chargePercent));
+
+    strbufInit(&out, body, sizeof(body));
+    jsonWriterInit(&writer, &out);
+    jsonBeginObject(&writer);
+    jsonFieldString(&writer, "event", "battery");
+    jsonFieldString(&writer, "alarm", batteryAlarmName(snap->alarm));
+    jsonKey(&writer, "seconds_to_empty");
+    if (snap->secondsToEmpty == BATTERY_NO_ESTIMATE) {
+        jsonNull(&writer);
+    } else {
+        jsonUint(&writer, snap->secondsToEmpty);
+    }
+    jsonFieldDouble(&writer, "current_ma", snap->currentMa, 1);
+    jsonFieldDouble(&writer, "charge_percent", snap->chargePercent, 1);
+    jsonFieldUint(&writer, "timestamp_ms", snap->tiers[BATTERY_TIER_FAST].updatedMs);
+    jsonEndObject(&writer);
+    if (!out.overflow) {
+        webhookPost(out.data, out.length);
+    }
+}
+
+static void pass(uint32_t tierMask) {
+    BatteryRead read;
+    BatterySnapshot changed;
+    uint64_t nowMs;
+    bool alarmChanged;
+
+    memset(&read, 0, sizeof(read));
+    read.tierMask = tierMask;
+    // Static registers that were read once are never read again
+    pthread_mutex_lock(&batteryLock);
+    read.skip = latest.valid & staticMask;
+    pthread_mutex_unlock(&batteryLock);
+    if (!hwActorCall(HW_LANE_READ, hwRead, &read)) {
+        return;
+    }
+    nowMs = wallClockMs();
+
+    pthread_mutex_lock(&batteryLock);
+    for (int i = 0; i < BATTERY_REG_COUNT; i++) {
+        BatteryTier tier = registers[i].tier;
+
+        // A failed read leaves the previous value standing
+        if (read.failed & (1ull << i)) {
+            readErrors[tier]++;
+        } else if (read.read & (1ull << i)) {
+            latest.values[i] = read.values[i];
+            latest.valid |= 1ull << i;
+            registerReads[tier]++;
+        }
+    }
+    for (int tier = 0; tier < BATTERY_TIER_COUNT; tier++) {
+        if (tierMask & (1u << tier)) {
+            latest.tiers[tier].reads++;
+            latest.tiers[tier].updatedMs = nowMs;
+        }
+    }
+    alarmChanged = (tierMask & (1u << BATTERY_TIER_FAST)) && smooth(monotonicNowNs());
+    changed = latest;
+    pthread_mutex_unlock(&batteryLock);
+
+    if (alarmChanged) {
+        announce(&changed);
+    }
+}
+
+static bool staticMissing(void) {
+    bool missing;
+
+    pthread_mutex_lock(&batteryLock);
+    missing = (latest.valid & staticMask) != staticMask;
+    pthread_mutex_unlock(&batteryLock);
+    return missing;
+}
+
+static void batteryTick(void *arg) {
+    uint32_t tierMask = 1u << BATTERY_TIER_FAST;
+    (void)arg;
+
+    // The first pass reads every tier; static registers are retried
+    // with the slow tier until each has answered
+    if (fastPasses % slowEvery == 0) {
+        tierMask |= 1u << BATTERY_TIER_SLOW;
+        if (fastPasses == 0 || staticMissing()) {
+            tierMask |= 1u << BATTERY_TIER_STATIC;
+        }
+    }
+    pass(tierMask);
+    fastPasses++;
+}
+
+bool batteryMonitorStart(void) {
+    bool present = false;
+
+    if (fastMs == 0 || batteryRunning || !susiDeviceOpen()) {
+        return false;
+    }
+    if (!hwActorCall(HW_LANE_READ, hwProbe, &present) || !present) {
+        susiDeviceClose();
+        return false;
+    }
+    staticMask = 0;
+    for (int i = 0; i < BATTERY_REG_COUNT; i++) {
+        if (registers[i].tier == BATTERY_TIER_STATIC) {
+            staticMask |= 1ull << i;
+        }
+    }
+    slowEvery = slowMs > fastMs ? (slowMs + fastMs - 1) / fastMs : 1;
+    memset(&latest, 0, sizeof(latest));
+    latest.secondsToEmpty = BATTERY_NO_ESTIMATE;
+    latest.tiers[BATTERY_TIER_SLOW].intervalMs = slowEvery * fastMs;
+    latest.tiers[BATTERY_TIER_FAST].intervalMs = fastMs;
+    fastPasses = 0;
+    batteryTask = schedulerAdd("battery", SCHEDULER_PRIORITY_NORMAL, fastMs, 0, batteryTick, NULL);
+    if (batteryTask < 0) {
+        susiDeviceClose();
+        return false;
+    }
+    batteryRunning = true;
+    printf("Battery monitor: fast registers every %u ms, slow every %u ms", fastMs, slowEvery * fastMs);
+    if (lowMinutes != 0) {
+        printf(", alarm at %u and %u minutes to empty", lowMinutes, criticalMinutes);
+    }
+    printf("\n");
+    return true;
+}
+
+void batteryMonitorStop(void) {
+    if (!batteryRunning) {
+        return;
+    }
+    schedulerRemove(batteryTask);
+    batteryTask = -1;
+    batteryRunning = false;
+    susiDeviceClose();
+}
+
+bool batteryMonitorSnapshot(BatterySnapshot *out) {
+    if (!batteryRunning) {
+        return false;
+    }
+    pthread_mutex_lock(&batteryLock);
+    *out = latest;
+    pthread_mutex_unlock(&batteryLock);
+    return true;
+}
+
+void batteryMonitorCollectMetrics(StrBuf *out, void *ctx) {
+    BatterySnapshot snapshot;
+    uint64_t reads[BATTERY_TIER_COUNT], errors[BATTERY_TIER_COUNT], raised[BATTERY_ALARM_CRITICAL + 1];
+    (void)ctx;
+
+    if (!batteryMonitorSnapshot(&snapshot)) {
+        return;
+    }
+    pthread_mutex_lock(&batteryLock);
+    memcpy(reads, registerReads, sizeof(reads));
+    memcpy(errors, readErrors, sizeof(errors));
+    memcpy(raised, alarmsRaised, sizeof(raised));
+    pthread_mutex_unlock(&batteryLock);
+
+    if (snapshot.smoothed) {
+        metricsHeader(out, "watchdog_battery_smoothed_current_milliamps", "gauge",
+                      "Battery current averaged over the smoothing time constant, negative while discharging");
+        strbufAppendf(out, "watchdog_battery_smoothed_current_milliamps %.1f\n", snapshot.currentMa);
+        metricsHeader(out, "watchdog_battery_smoothed_charge_percent", "gauge", "Relative state of charge, averaged");
+        strbufAppendf(out, "watchdog_battery_smoothed_charge_percent %.1f\n", snapshot.chargePercent);
+    }
+    if (snapshot.secondsToEmpty != BATTERY_NO_ESTIMATE) {
+        metricsHeader(out, "watchdog_battery_seconds_to_empty", "gauge", "Remaining capacity over the smoothed drain");
+        strbufAppendf(out, "watchdog_battery_seconds_to_empty %u\n", snapshot.secondsToEmpty);
+    }
+    if (lowMinutes != 0) {
+        metricsHeader(out, "watchdog_battery_alarm", "gauge", "Battery alarm, 0 none, 1 low, 2 critical");
+        strbufAppendf(out, "watchdog_battery_alarm %d\n", (int)snapshot.alarm);
+        metricsHeader(out, "watchdog_battery_alarms_total", "counter", "Battery alarms raised by level");
+        for (int alarm = BATTERY_ALARM_LOW; alarm <= BATTERY_ALARM_CRITICAL; alarm++) {
+            strbufAppendf(out, "watchdog_battery_alarms_total{level=\"%s\"} %llu\n", alarmNames[alarm],
+                          (unsigned long long)raised[alarm]);
+        }
+    }
+
+    metricsHeader(out, "watchdog_battery_register", "gauge",
+                  "Smart Battery register as read (mV, mA, %, minutes, 0.1 K), slow and fast tiers");
+    for (int i = 0; i < BATTERY_REG_COUNT; i++) {
+        if (registers[i].tier != BATTERY_TIER_STATIC && batteryRegisterValid(&snapshot, (BatteryRegister)i)) {
+            strbufAppendf(out, "watchdog_battery_register{register=\"%s\"} %d\n", registers[i].name,
+                          batteryRegisterValue(&snapshot, (BatteryRegister)i));
+        }
+    }
+    metricsHeader(out, "watchdog_battery_register_reads_total", "counter", "Smart Battery register reads by tier");
+    for (int tier = 0; tier < BATTERY_TIER_COUNT; tier++) {
+        strbufAppendf(out, "watchdog_battery_register_reads_total{tier=\"%s\"} %llu\n", tierNames[tier],
+                      (unsigned long long)reads[tier]);
+    }
+    metricsHeader(out, "watchdog_battery_read_errors_total", "counter", "Smart Battery register reads that failed by tier");
+    for (int tier = 0; tier < BATTERY_TIER_COUNT; tier++) {
+        strbufAppendf(out, "watchdog_battery_read_errors_total{tier=\"%s\"} %llu\n", tierNames[tier],
+                      (unsigned long long)errors[tier]);
+    }
+}
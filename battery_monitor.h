@@ -0,0 +1,126 @@
+#ifndef BATTERY_MONITOR_H
+#define BATTERY_MONITOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "strbuf.h"
+
+#define BATTERY_DEFAULT_FAST_MS 1000
+#define BATTERY_DEFAULT_SLOW_MS 30000
+#define BATTERY_DEFAULT_SMOOTHING_S 30       // EWMA time constant
+#define BATTERY_DEFAULT_LOW_MIN 15
+#define BATTERY_DEFAULT_CRITICAL_MIN 5
+#define BATTERY_NO_ESTIMATE 0xffffffffu      // secondsToEmpty when not discharging or still warming up
+
+// Smart Battery (SBS) registers for /api/battery, through the optional
+// SUSI device library (susi_device.h). The registers fall into three
+// tiers by how often they change. Static ones (design figures, serial
+// number, manufacturer) are read once at start, and again only while a
+// read has failed. Slow ones (cycle count, full charge capacity, health)
+// are read every slow interval and fast ones (voltage, current, charge)
+// every fast interval, by a task of the shared scheduler (scheduler.h).
+// Each tier is one hardware-thread command, and all tiers merge into one
+// BatterySnapshot, which readers copy whole.
+//
+// The gauge's own RunTimeToEmpty is noisy and lags, so every fast pass
+// also feeds exponentially weighted averages of the current, the drain
+// (capacity units per hour) and the relative charge. The time constant is
+// in seconds, so the smoothing does not depend on the interval. Time to
+// empty is the remaining capacity over the smoothed drain, once the
+// averages have run for one time constant. Falling to the low or critical
+// minutes moves the alarm up, and rising 25% above a threshold, or no
+// longer discharging, moves it back down. Every alarm change is published
+// as EVENT_BATTERY and posted to the webhooks.
+
+typedef enum {
+    BATTERY_TIER_STATIC,
+    BATTERY_TIER_SLOW,
+    BATTERY_TIER_FAST,
+    BATTERY_TIER_COUNT
+} BatteryTier;
+
+typedef enum {
+    BATTERY_REG_UNIT,                // 0 mA/mAh, 1 10 mW/10 mWh
+    BATTERY_REG_DESIGN_CAPACITY,
+    BATTERY_REG_DESIGN_VOLTAGE,      // mV
+    BATTERY_REG_SPECIFICATION_INFO,
+    BATTERY_REG_MANUFACTURE_DATE,    // Day + Month * 32 + (Year - 1980) * 512
+    BATTERY_REG_SERIAL_NUMBER,
+    BATTERY_REG_NAME_1,              // Manufacturer name, 4 characters each, MSB first
+    BATTERY_REG_NAME_2,
+    BATTERY_REG_NAME_3,
+    BATTERY_REG_NAME_4,
+    BATTERY_REG_NAME_5,
+    BATTERY_REG_REMAINING_CAPACITY_ALARM,
+    BATTERY_REG_REMAINING_TIME_ALARM, // Minutes
+    BATTERY_REG_BATTERY_MODE,
+    BATTERY_REG_MAX_ERROR,           // %
+    BATTERY_REG_FULL_CHARGE_CAPACITY,
+    BATTERY_REG_CHARGING_CURRENT,    // mA
+    BATTERY_REG_CHARGING_VOLTAGE,    // mV
+    BATTERY_REG_CYCLE_COUNT,
+    BATTERY_REG_SOH,                 // %
+    BATTERY_REG_TEMPERATURE,         // 0.1 K
+    BATTERY_REG_VOLTAGE,             // mV
+    BATTERY_REG_CURRENT,             // mA, signed, negative while discharging
+    BATTERY_REG_AVERAGE_CURRENT,     // mA, signed
+    BATTERY_REG_RELATIVE_CHARGE,     // %
+    BATTERY_REG_ABSOLUTE_CHARGE,     // %
+    BATTERY_REG_REMAINING_CAPACITY,
+    BATTERY_REG_RUN_TIME_TO_EMPTY,   // Minutes, 65535 = not discharging
+    BATTERY_REG_AVERAGE_TIME_TO_EMPTY,
+    BATTERY_REG_AVERAGE_TIME_TO_FULL,
+    BATTERY_REG_BATTERY_STATUS,
+    BATTERY_REG_COUNT
+} BatteryRegister;
+
+typedef enum {
+    BATTERY_ALARM_NONE,
+    BATTERY_ALARM_LOW,               // Time to empty below the low minutes
+    BATTERY_ALARM_CRITICAL           // Below the critical minutes
+} BatteryAlarm;
+
+typedef struct {
+    uint32_t intervalMs;             // 0 for the static tier
+    uint64_t reads;                  // Passes over the tier
+    uint64_t updatedMs;              // Wall clock of the last pass, 0 before the first
+} BatteryTierState;
+
+typedef struct {
+    uint32_t values[BATTERY_REG_COUNT];
+    uint64_t valid;                  // Bit per register holding a read value
+    BatteryTierState tiers[BATTERY_TIER_COUNT];
+    bool smoothed;                   // The averages below have a sample
+    double currentMa;                // Smoothed, negative while discharging
+    double chargePercent;            // Smoothed relative state of charge
+    uint32_t secondsToEmpty;         // BATTERY_NO_ESTIMATE when there is none
+    BatteryAlarm alarm;
+} BatterySnapshot;
+
+// Before batteryMonitorStart(); a fast interval of 0 disables the module.
+// The slow interval is rounded up to a multiple of the fast one.
+void batteryMonitorSetIntervals(uint32_t fastMs, uint32_t slowMs);
+// Before batteryMonitorStart(); a low of 0 disables the alarm
+void batteryMonitorSetSmoothing(uint32_t seconds);
+void batteryMonitorSetAlarm(uint32_t lowMinutes, uint32_t criticalMinutes);
+// False when there is no battery or the module is off (after hwActorStart)
+bool batteryMonitorStart(void);
+void batteryMonitorStop(void);
+
+// Copy of the merged registers; false when not running
+bool batteryMonitorSnapshot(BatterySnapshot *out);
+
+const char* batteryRegisterName(BatteryRegister reg);
+BatteryTier batteryRegisterTier(BatteryRegister reg);
+const char* batteryTierName(BatteryTier tier);
+const char* batteryAlarmName(BatteryAlarm alarm);
+// Register value, sign-extended where the register is signed
+int32_t batteryRegisterValue(const BatterySnapshot *snapshot, BatteryRegister reg);
+bool batteryRegisterValid(const BatterySnapshot *snapshot, BatteryRegister reg);
+// Manufacturer name from the five name registers, NUL-terminated
+void batteryManufacturer(const BatterySnapshot *snapshot, char *name, size_t size);
+
+void batteryMonitorCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // BATTERY_MONITOR_H
@@ -0,0 +1,326 @@
+#include <stdio.h>
+#include <string.h>
+#include "board_info.h"
+#include "hw_actor.h"
+#include "json_writer.h"
+#include "metrics.h"
+#include "scheduler.h"
+#include "snapshot.h"
+#include "susi_breaker.h"
+#include "susi_timing.h"
+#include "timeutil.h"
+
+typedef struct {
+    SusiId_t id;
+    const char *key;
+} BoardItem;
+
+static const BoardItem boardStrings[] = {
+    { SUSI_ID_BOARD_MANUFACTURER_STR, "manufacturer" },
+    { SUSI_ID_BOARD_NAME_STR, "name" },
+    { SUSI_ID_BOARD_REVISION_STR, "revision" },
+    { SUSI_ID_BOARD_SERIAL_STR, "serial" },
+    { SUSI_ID_BOARD_BIOS_REVISION_STR, "bios_revision" },
+    { SUSI_ID_BOARD_HW_REVISION_STR, "hardware_revision" },
+    { SUSI_ID_BOARD_PLATFORM_TYPE_STR, "platform_type" },
+    { SUSI_ID_BOARD_EC_FW_STR, "firmware_name" },
+    { SUSI_ID_BOARD_BIOS_FW_STR, "bios_name" },
+};
+#define BOARD_STRING_COUNT (sizeof(boardStrings) / sizeof(boardStrings[0]))
+
+// How a value is shown
+typedef enum {
+    BOARD_VALUE_NUMBER,
+    BOARD_VALUE_MAJOR_MINOR,         // Bits 31-24 and 23-16
+    BOARD_VALUE_VERSION,             // Major.minor.build from bits 31-24, 23-16, 15-0
+    BOARD_VALUE_DOCUMENT,            // Bytes 0, 1 and 2
+    BOARD_VALUE_PNP_ID
+} BoardValueFormat;
+
+static const struct {
+    SusiId_t id;
+    const char *key;
+    BoardValueFormat format;
+} boardValues[] = {
+    { SUSI_ID_GET_SPEC_VERSION, "spec_version", BOARD_VALUE_MAJOR_MINOR },
+    { SUSI_ID_BOARD_PLATFORM_REV_VAL, "platform_revision", BOARD_VALUE_MAJOR_MINOR },
+    { SUSI_ID_BOARD_PNPID_VAL, "pnp_id", BOARD_VALUE_PNP_ID },
+    { SUSI_ID_BOARD_DRIVER_VERSION_VAL, "driver_version", BOARD_VALUE_VERSION },
+    { SUSI_ID_BOARD_LIB_VERSION_VAL, "library_version", BOARD_VALUE_VERSION },
+    { SUSI_ID_BOARD_FIRMWARE_VERSION_VAL, "firmware_version", BOARD_VALUE_VERSION },
+    { SUSI_ID_BOARD_DOCUMENT_VERSION_VAL, "document_version", BOARD_VALUE_DOCUMENT },
+    { SUSI_ID_BOARD_LAST_SHUTDOWN_STATUS_VAL, "last_shutdown_status", BOARD_VALUE_NUMBER },
+    { SUSI_ID_BOARD_LAST_SHUTDOWN_EVENT_VAL, "last_shutdown_event", BOARD_VALUE_NUMBER },
+};
+#define BOARD_VALUE_COUNT (sizeof(boardValues) / sizeof(boardValues[0]))
+
+// Written once by boardInfoInit() and only read afterwards
+typedef struct {
+    bool stringValid[BOARD_STRING_COUNT];
+    char strings[BOARD_STRING_COUNT][BOARD_INFO_STRING_MAX];
+    int oemCount;
+    char oemNames[BOARD_INFO_OEM_MAX][BOARD_INFO_STRING_MAX];
+    char oemValues[BOARD_INFO_OEM_MAX][BOARD_INFO_STRING_MAX];
+    bool valueValid[BOARD_VALUE_COUNT];
+    uint32_t values[BOARD_VALUE_COUNT];
+} BoardStatic;
+
+static BoardStatic board;
+static BoardCounters counters;       // Sampler thread only, after init
+static uint64_t countersChangedMs;
+static Snapshot boardSnapshot;
+static bool snapshotLive;
+static uint64_t refreshes;
+
+static int refreshTask = -1;
+static bool refreshRunning;
+
+static uint64_t wallClockMs(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000ull + (uint64_t)now.tv_nsec / 1000000ull;
+}
+
+static bool readString(SusiId_t id, char *out) {
+    uint32_t length = BOARD_INFO_STRING_MAX;
+    uint64_t start = monotonicNowNs();
+    SusiStatus_t status = SusiBoardGetStringA(id, out, &length);
+
+    susiTimingRecord(SUSI_CALL_BOARD_GET_STRING, start, status);
+    out[BOARD_INFO_STRING_MAX - 1] = '\0';
+    return status == SUSI_STATUS_SUCCESS;
+}
+
+// While a counter's breaker is open its last good value stands in
+static bool readValue(SusiId_t id, uint32_t *value) {
+    bool stale;
+
+    return susiBreakerBoardGetValue(id, value, &stale) == SUSI_STATUS_SUCCESS;
+}
+
+void hwBoardInfoReadCounters(void *arg) {
+    BoardCounters *next = arg;
+
+    next->bootValid = readValue(SUSI_ID_BOARD_BOOT_COUNTER_VAL, &next->bootCount);
+    next->runningValid = readValue(SUSI_ID_BOARD_RUNNING_TIME_METER_VAL, &next->runningMinutes);
+}
+
+static void hwReadStatic(void *arg) {
+    (void)arg;
+
+    for (size_t i = 0; i < BOARD_STRING_COUNT; i++) {
+        board.stringValid[i] = readString(boardStrings[i].id, board.strings[i]);
+    }
+    for (SusiId_t id = SUSI_ID_BOARD_OEM0_STR; id <= SUSI_ID_BOARD_OEM2_STR; id++) {
+        int n = board.oemCount;
+
+        if (!readString(id, board.oemValues[n])) {
+            continue;
+        }
+        if (!readString(SUSI_ID_MAPPING_GET_NAME_INFO(id), board.oemNames[n])) {
+            snprintf(board.oemNames[n], sizeof(board.oemNames[n]), "oem%u", id - SUSI_ID_BOARD_OEM0_STR);
+        }
+        board.oemCount++;
+    }
+    for (size_t i = 0; i < BOARD_VALUE_COUNT; i++) {
+        board.valueValid[i] = readValue(boardValues[i].id, &board.values[i]);
+    }
+    hwBoardInfoReadCounters(&counters);
+}
+
+// Compressed EISA ID: three 5-bit letters and a 12-bit product number
+static void writePnpId(JsonWriter *writer, uint32_t value) {
+    uint16_t letters = (uint16_t)(value >> 12);
+    uint16_t swapped = (uint16_t)((letters << 8) | (letters >> 8));
+    char vendor[4] = {
+        (char)('@' + ((swapped >> 10) & 0x1f)),
+        (char)('@' + ((swapped >> 5) & 0x1f)),
+        (char)('@' + (swapped & 0x1f)),
+        '\0'
+    };
+
+    jsonBeginObject(writer);
+    jsonFieldString(writer, "vendor", vendor);
+    jsonFieldUint(writer, "product", value & 0xfff);
+    jsonEndObject(writer);
+}
+
+static void writeValue(JsonWriter *writer, size_t i) {
+    uint32_t value = board.values[i];
+    char text[32];
+
+    jsonKey(writer, boardValues[i].key);
+    switch (boardValues[i].format) {
+    case BOARD_VALUE_MAJOR_MINOR:
+        snprintf(text, sizeof(text), "%u.%u", value >> 24, (value >> 16) & 0xff);
+        jsonString(writer, text);
+        break;
+    case BOARD_VALUE_VERSION:
+        snprintf(text, sizeof(text), "%u.%u.%u", value >> 24, (value >> 16) & 0xff, value & 0xffff);
+        jsonString(writer, text);
+        break;
+    case BOARD_VALUE_DOCUMENT:
+        snprintf(text, sizeof(text), "%u.%u.%u", value & 0xff, (value >> 8) & 0xff, (value >> 16) & 0xff);
+        jsonString(writer, text);
+        break;
+    case BOARD_VALUE_PNP_ID:
+        writePnpId(writer, value);
+        break;
+    default:
+        jsonUint(writer, value);
+        break;
+    }
+}
+
+// changed_ms is left out when 0
+static void writeBoard(JsonWriter *writer, const BoardCounters *current, uint64_t changedMs) {
+    jsonBeginObject(writer);
+    for (size_t i = 0; i < BOARD_STRING_COUNT; i++) {
+        if (board.stringValid[i]) {
+            jsonFieldString(writer, boardStrings[i].key, board.strings[i]);
+        }
+    }
+    for (size_t i = 0; i < BOARD_VALUE_COUNT; i++) {
+        if (board.valueValid[i]) {
+            writeValue(writer, i);
+        }
+    }
+    jsonKey(writer, "oem");
+    jsonBeginObject(writer);
+    for (int i = 0; i < board.oemCount; i++) {
+        jsonFieldString(writer, board.oemNames[i], board.oemValues[i]);
+    }
+    jsonEndObject(writer);
+    jsonKey(writer, "counters");
+    jsonBeginObject(writer);
+    if (current->bootValid) {
+        jsonFieldUint(writer, "boot_count", current->bootCount);
+    }
+    if (current->runningValid) {
+        jsonFieldUint(writer, "running_minutes", current->runningMinutes);
+    }
+    if (changedMs != 0) {
+        jsonFieldUint(writer, "changed_ms", changedMs);
+    }
+    jsonEndObject(writer);
+    jsonEndObject(writer);
+}
+
+// The static record is never written after boardInfoInit(), so any thread may render it
+void boardInfoWrite(JsonWriter *writer, const BoardCounters *current) {
+    writeBoard(writer, current, 0);
+}
+
+static void renderBoard(StrBuf *out) {
+    JsonWriter writer;
+
+    jsonWriterInit(&writer, out);
+    writeBoard(&writer, &counters, countersChangedMs);
+    strbufAppendChar(out, '\n');
+}
+
+static void publishBoard(void) {
+    StrBuf out;
+    size_t capacity;
+    char *data = snapshotBegin(&boardSnapshot, &capacity);
+
+    if (data == NULL) {
+        return;
+    }
+    for (;;) {
+        strbufInit(&out, data, capacity);
+        renderBoard(&out);
+        if (!out.overflow) {
+            break;
+        }
+        if (!snapshotGrow(&boardSnapshot, capacity * 2)) {
+            snapshotAbort(&boardSnapshot);
+            return;
+        }
+        data = snapshotBegin(&boardSnapshot, &capacity);
+        if (data == NULL) {
+            return;
+        }
+    }
+    snapshotPublish(&boardSnapshot, out.length);
+}
+
+bool boardInfoInit(void) {
+    if (!snapshotInit(&boardSnapshot, BOARD_INFO_SNAPSHOT_CAPACITY, "application/json", "board")) {
+        return false;
+    }
+    if (!hwActorCall(HW_LANE_READ, hwReadStatic, NULL)) {
+        snapshotDestroy(&boardSnapshot);
+        return false;
+    }
+    countersChangedMs = wallClockMs();
+    snapshotLive = true;
+    publishBoard();
+    return true;
+}
+
+static void refresh(void *arg) {
+    BoardCounters next;
+    (void)arg;
+
+    // A busy read lane only delays the counters to the next interval
+    if (hwActorCall(HW_LANE_READ, hwBoardInfoReadCounters, &next)) {
+        __atomic_fetch_add(&refreshes, 1, __ATOMIC_RELAXED);
+        if (memcmp(&next, &counters, sizeof(next)) != 0) {
+            counters = next;
+            countersChangedMs = wallClockMs();
+            publishBoard();
+        }
+    }
+}
+
+bool boardInfoStart(uint32_t refreshSeconds) {
+    if (!snapshotLive || refreshRunning || refreshSeconds == 0) {
+        return false;
+    }
+    refreshTask = schedulerAdd("board", SCHEDULER_PRIORITY_NORMAL, refreshSeconds * 1000u, refreshSeconds * 1000u,
+                               refresh, NULL);
+    if (refreshTask < 0) {
+        return false;
+    }
+    refreshRunning = true;
+    return true;
+}
+
+void boardInfoStop(void) {
+    if (!refreshRunning) {
+        return;
+    }
+    schedulerRemove(refreshTask);
+    refreshTask = -1;
+    refreshRunning = false;
+}
+
+void boardInfoDestroy(void) {
+    if (snapshotLive) {
+        snapshotLive = false;
+        snapshotDestroy(&boardSnapshot);
+    }
+}
+
+enum MHD_Result boardInfoQueueResponse(struct MHD_Connection *connection) {
+    if (!snapshotLive) {
+        return MHD_NO;
+    }
+    return snapshotQueue(&boardSnapshot, connection);
+}
+
+void boardInfoCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (!snapshotLive) {
+        return;
+    }
+    metricsHeader(out, "watchdog_board_refreshes_total", "counter", "Reads of the board's boot counter and running time meter");
+    strbufAppendf(out, "watchdog_board_refreshes_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&refreshes, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_board_publishes_total", "counter", "Times the /api/board body was rendered");
+    strbufAppendf(out, "watchdog_board_publishes_total %llu\n",
+                  (unsigned long long)snapshotGeneration(&boardSnapshot));
+}
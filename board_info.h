@@ -0,0 +1,47 @@
+#ifndef BOARD_INFO_H
+#define BOARD_INFO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <microhttpd.h>
+#include "json_writer.h"
+#include "strbuf.h"
+
+#define BOARD_INFO_DEFAULT_REFRESH_S 60      // The running time meter counts minutes
+#define BOARD_INFO_STRING_MAX 64
+#define BOARD_INFO_OEM_MAX 3                 // SUSI_ID_BOARD_OEM0_STR..OEM2_STR
+#define BOARD_INFO_SNAPSHOT_CAPACITY 2048
+
+// Board inventory for /api/board. Names, serial, versions, the PnP ID and
+// the last shutdown cause cannot change while the service runs, so they
+// are read once through the hardware thread into a record that is never
+// written again. Only the boot counter and running time meter are read
+// again, every refresh interval by a task of the shared scheduler
+// (scheduler.h), and the body is re-rendered only when one
+// of them moved, so pollers get the same ETag (and a 304) in between.
+
+// Read every item and publish the first body (after hwActorStart())
+bool boardInfoInit(void);
+// Re-read the counters every refreshSeconds; false for 0
+bool boardInfoStart(uint32_t refreshSeconds);
+void boardInfoStop(void);
+// Release the snapshot once no response can reference it (after MHD stopped)
+void boardInfoDestroy(void);
+
+enum MHD_Result boardInfoQueueResponse(struct MHD_Connection *connection);
+
+// The two counters that change, for callers that want them fresh
+typedef struct {
+    bool bootValid;
+    bool runningValid;
+    uint32_t bootCount;
+    uint32_t runningMinutes;
+} BoardCounters;
+
+// Hardware-thread command body filling a BoardCounters
+void hwBoardInfoReadCounters(void *arg);
+// The /api/board object with the given counters instead of the sampled ones
+void boardInfoWrite(JsonWriter *writer, const BoardCounters *counters);
+void boardInfoCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // BOARD_INFO_H
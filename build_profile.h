@@ -0,0 +1,45 @@
+#ifndef BUILD_PROFILE_H
+#define BUILD_PROFILE_H
+
+// Compile-time sizing. Without a profile every module keeps the defaults in
+// its own header. The small profile (make -f Makefile.watchdog_http small,
+// -DWATCHDOG_SMALL) is for boards with little RAM: the rings and pools below
+// shrink, connections are served by one epoll thread instead of a thread
+// each, thread stacks and malloc arenas are bounded, and WATCHDOG_NO_HEAP
+// takes every buffer the service needs while running from storage sized
+// here or reserved at startup (see mem_pool.h).
+#ifdef WATCHDOG_SMALL
+#define WATCHDOG_NO_HEAP 1
+#define WATCHDOG_THREAD_STACK (256 * 1024)   // Default for every thread, MHD's included
+#define WATCHDOG_MALLOC_ARENAS 1             // One arena instead of one per thread
+#define WATCHDOG_NO_COMPRESSION 1            // Compressed variants would live on the heap
+
+#define DEFAULT_SERVER_MODE SERVER_MODE_EPOLL
+#define DEFAULT_SERVER_THREADS 1
+#define DEFAULT_MAX_CONNECTIONS 16
+#define DEFAULT_CONNECTION_MEMORY 8192
+
+#define ACCESS_LOG_CAPACITY 128
+#define EVENT_RING_SIZE 128
+#define EVENT_MAX_CLIENTS 8
+#define GPIO_EVENT_RING 128
+#define LEASE_MAX 64
+#define WEBHOOK_QUEUE 32
+#define METRICS_INITIAL_CAPACITY (64 * 1024)
+
+// Blocks of the fixed pools that replace per-request allocations
+#define REQUEST_STATE_POOL 16                // One per connection with a body
+#define STORAGE_STREAM_POOL 4                // Storage downloads in flight
+#define STORAGE_CHUNK_POOL 8                 // Two per upload, one per checksum
+#define STORAGE_CHUNK_MAX 4096               // Areas with larger blocks cannot be streamed
+#define RESPONSE_LARGE_POOL 4                // Responses over RESPONSE_BUFFER_SIZE
+#define RESPONSE_LARGE_SIZE (32 * 1024)
+#define DIAG_STREAM_POOL 1                   // PCI/MSR dumps in flight, 9 KiB each
+#define SPAN_MAX_THREADS 12                  // Span rings, 10 KiB each
+#define SPAN_RING_EVENTS 256
+#define SPAN_STREAM_POOL 1                   // Trace dumps in flight, 16 KiB each
+#define ALERT_MAX_RULES 32
+#define ALERT_MAX_COMPARISONS 128
+#endif
+
+#endif // BUILD_PROFILE_H
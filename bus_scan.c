@@ -0,0 +1,461 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "bus_scan.h"
+#include "Susi4.h"
+#include "hw_actor.h"
+#include "json_writer.h"
+#include "metrics.h"
+#include "snapshot.h"
+#include "susi_caps.h"
+#include "susi_timing.h"
+#include "timeutil.h"
+
+typedef enum {
+    BUS_SMBUS,
+    BUS_I2C
+} BusType;
+
+typedef struct {
+    BusType type;
+    SusiId_t id;
+    char name[32];
+    // Written by the scanner thread, read by /metrics
+    uint64_t devices[2];             // Bit per 7-bit address that answered
+    uint32_t deviceCount;
+    uint64_t scanNs;                 // Duration of the last complete scan
+    uint64_t errors;                 // Probes that failed other than with NOACK
+    bool scanned;
+} Bus;
+
+// One hardware command: probe count addresses of one bus
+typedef struct {
+    const Bus *bus;
+    uint32_t first;
+    uint32_t count;
+    uint64_t found[2];
+    uint32_t errors;
+} ProbeChunk;
+
+static Bus buses[BUS_SCAN_MAX_BUSES];
+static int busCount = 0;
+
+static Snapshot busSnapshot;
+static bool snapshotLive = false;
+static pthread_t scannerThread;
+static bool scannerActive = false;
+static bool stopping = false;
+static int stopFd = -1;
+static int requestFd = -1;
+static uint32_t ttlSeconds = BUS_SCAN_DEFAULT_TTL_S;
+
+static bool scanning = false;
+static uint64_t scans = 0;
+static uint64_t scansAborted = 0;        // The read lane refused a whole round
+static uint64_t scannedMs = 0;           // Wall clock of the last complete scan
+static uint64_t scannedMonotonicNs = 0;
+static uint64_t lastScanNs = 0;
+
+static const char* busTypeName(BusType type) {
+    return type == BUS_SMBUS ? "smbus" : "i2c";
+}
+
+static void sanitizeName(char *name) {
+    for (char *p = name; *p; p++) {
+        if ((unsigned char)*p < 0x20 || *p == '"' || *p == '\\' || (unsigned char)*p >= 0x7f) {
+            *p = '_';
+        }
+    }
+}
+
+static void addBuses(BusType type, SusiId_t supportedId, int maxDevice) {
+    uint32_t supported = 0;
+    SusiStatus_t status = susiCapsGet(SUSI_CAPS_BOARD, supportedId, 0, &supported);
+
+    if (status != SUSI_STATUS_SUCCESS) {
+        return;
+    }
+    for (int i = 0; i < maxDevice && busCount < BUS_SCAN_MAX_BUSES; i++) {
+        Bus *bus = &buses[busCount];
+        uint32_t length = sizeof(bus->name);
+        SusiId_t nameId;
+        uint64_t start;
+
+        if (!(supported & (1u << i))) {
+            continue;
+        }
+        memset(bus, 0, sizeof(*bus));
+        bus->type = type;
+        bus->id = (SusiId_t)i;
+        nameId = type == BUS_SMBUS ? SUSI_ID_MAPPING_GET_NAME_SMB(bus->id) : SUSI_ID_MAPPING_GET_NAME_I2C(bus->id);
+        start = monotonicNowNs();
+        status = SusiBoardGetStringA(nameId, bus->name, &length);
+        susiTimingRecord(SUSI_CALL_BOARD_GET_STRING, start, status);
+        if (status != SUSI_STATUS_SUCCESS || bus->name[0] == '\0') {
+            snprintf(bus->name, sizeof(bus->name), "%s%d", busTypeName(type), i);
+        }
+        bus->name[sizeof(bus->name) - 1] = '\0';
+        sanitizeName(bus->name);
+        busCount++;
+    }
+}
+
+static void hwDiscover(void *arg) {
+    (void)arg;
+
+    busCount = 0;
+    addBuses(BUS_SMBUS, SUSI_ID_SMBUS_SUPPORTED, SUSI_SMBUS_MAX_DEVICE);
+    addBuses(BUS_I2C, SUSI_ID_I2C_SUPPORTED, SUSI_I2C_MAX_DEVICE);
+}
+
+bool busScanInit(void) {
+    if (!hwActorCall(HW_LANE_READ, hwDiscover, NULL)) {
+        return false;
+    }
+    for (int i = 0; i < busCount; i++) {
+        printf("%s %u: %s\n", buses[i].type == BUS_SMBUS ? "SMBus" : "I2C", buses[i].id, buses[i].name);
+    }
+    return true;
+}
+
+// Quick writes can latch the write-protect of some EEPROMs and confuse
+// 24RF08s, so those ranges are probed with a byte read (as i2cdetect does)
+static SusiStatus_t probeSmbus(SusiId_t id, uint32_t address, uint64_t *startNs, SusiCall *call) {
+    uint8_t data;
+
+    *startNs = monotonicNowNs();
+    if ((address >= 0x30 && address <= 0x37) || (address >= 0x50 && address <= 0x5f)) {
+        *call = SUSI_CALL_SMB_RECEIVE_BYTE;
+        return SusiSMBReceiveByte(id, (uint8_t)(address << 1), &data);
+    }
+    *call = SUSI_CALL_SMB_WRITE_QUICK;
+    return SusiSMBWriteQuick(id, (uint8_t)(address << 1));
+}
+
+static void hwProbeChunk(void *arg) {
+    ProbeChunk *chunk = (ProbeChunk *)arg;
+
+    for (uint32_t address = chunk->first; address < chunk->first + chunk->count; address++) {
+        uint64_t start;
+        SusiCall call;
+        SusiStatus_t status;
+
+        if (chunk->bus->type == BUS_SMBUS) {
+            status = probeSmbus(chunk->bus->id, address, &start, &call);
+        } else {
+            call = SUSI_CALL_I2C_PROBE_DEVICE;
+            start = monotonicNowNs();
+            status = SusiI2CProbeDevice(chunk->bus->id, SUSI_I2C_ENC_7BIT_ADDR(address));
+        }
+        // An unanswered address is a result, not a driver error
+        susiTimingRecord(call, start, status == SUSI_STATUS_NOACK ? SUSI_STATUS_SUCCESS : status);
+        if (status == SUSI_STATUS_SUCCESS) {
+            chunk->found[address / 64] |= 1ull << (address % 64);
+        } else if (status != SUSI_STATUS_NOACK) {
+            chunk->errors++;
+        }
+    }
+}
+
+static void renderMap(StrBuf *out) {
+    JsonWriter writer;
+
+    jsonWriterInit(&writer, out);
+    jsonBeginObject(&writer);
+    jsonFieldUint(&writer, "ttl_s", ttlSeconds);
+    jsonFieldBool(&writer, "scanning", scanning);
+    jsonFieldUint(&writer, "scans", scans);
+    if (scans > 0) {
+        jsonFieldUint(&writer, "scanned_ms", scannedMs);
+        jsonFieldUint(&writer, "expires_ms", scannedMs + (uint64_t)ttlSeconds * 1000ull);
+        jsonFieldUint(&writer, "scan_ms", lastScanNs / 1000000ull);
+    }
+    jsonKey(&writer, "buses");
+    jsonBeginArray(&writer);
+    for (int i = 0; i < busCount; i++) {
+        const Bus *bus = &buses[i];
+
+        jsonBeginObject(&writer);
+        jsonFieldString(&writer, "type", busTypeName(bus->type));
+        jsonFieldUint(&writer, "id", bus->id);
+        jsonFieldString(&writer, "name", bus->name);
+        jsonKey(&writer, "devices");
+        if (bus->scanned) {
+            jsonBeginArray(&writer);
+            for (uint32_t address = BUS_SCAN_FIRST_ADDRESS; address <= BUS_SCAN_LAST_ADDRESS; address++) {
+                if (bus->devices[address / 64] & (1ull << (address % 64))) {
+                    jsonUint(&writer, address);
+                }
+            }
+            jsonEndArray(&writer);
+            jsonFieldUint(&writer, "scan_ms", bus->scanNs / 1000000ull);
+        } else {
+            jsonNull(&writer);
+        }
+        jsonFieldUint(&writer, "errors", __atomic_load_n(&bus->errors, __ATOMIC_RELAXED));
+        jsonEndObject(&writer);
+    }
+    jsonEndArray(&writer);
+    jsonEndObject(&writer);
+    strbufAppendChar(out, '\n');
+}
+
+static void publishMap(void) {
+    StrBuf out;
+    size_t capacity;
+    char *data = snapshotBegin(&busSnapshot, &capacity);
+
+    if (data == NULL) {
+        return;
+    }
+    for (;;) {
+        strbufInit(&out, data, capacity);
+        renderMap(&out);
+        if (!out.overflow) {
+            break;
+        }
+        if (!snapshotGrow(&busSnapshot, capacity * 2)) {
+            snapshotAbort(&busSnapshot);
+            return;
+        }
+        data = snapshotBegin(&busSnapshot, &capacity);
+        if (data == NULL) {
+            return;
+        }
+    }
+    snapshotPublish(&busSnapshot, out.length);
+}
+
+static uint64_t wallClockMs(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000ull + (uint64_t)now.tv_nsec / 1000000ull;
+}
+
+// Every bus advances one chunk per round, so the buses are scanned side by
+// side. The new map replaces a bus's old one only once that bus is complete.
+// Returns false if the scan stopped early: on shutdown, or after a round in
+// which the read lane refused every chunk.
+static bool scanAll(void) {
+    uint32_t cursor[BUS_SCAN_MAX_BUSES];
+    uint64_t found[BUS_SCAN_MAX_BUSES][2];
+    uint64_t started = monotonicNowNs();
+    int remaining = busCount;
+
+    scanning = true;
+    publishMap();
+    memset(found, 0, sizeof(found));
+    for (int i = 0; i < busCount; i++) {
+        cursor[i] = BUS_SCAN_FIRST_ADDRESS;
+    }
+    while (remaining > 0 && !__atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) {
+        bool progress = false;
+
+        for (int i = 0; i < busCount; i++) {
+            Bus *bus = &buses[i];
+            ProbeChunk chunk;
+            uint32_t count;
+
+            if (cursor[i] > BUS_SCAN_LAST_ADDRESS) {
+                continue;
+            }
+            count = BUS_SCAN_LAST_ADDRESS + 1 - cursor[i];
+            memset(&chunk, 0, sizeof(chunk));
+            chunk.bus = bus;
+            chunk.first = cursor[i];
+            chunk.count = count < BUS_SCAN_CHUNK ? count : BUS_SCAN_CHUNK;
+            // A full read lane only delays this chunk to the next round
+            if (!hwActorCall(HW_LANE_USER, hwProbeChunk, &chunk)) {
+                continue;
+            }
+            progress = true;
+            found[i][0] |= chunk.found[0];
+            found[i][1] |= chunk.found[1];
+            __atomic_fetch_add(&bus->errors, chunk.errors, __ATOMIC_RELAXED);
+            cursor[i] += chunk.count;
+            if (cursor[i] <= BUS_SCAN_LAST_ADDRESS) {
+                continue;
+            }
+            bus->devices[0] = found[i][0];
+            bus->devices[1] = found[i][1];
+            __atomic_store_n(&bus->deviceCount,
+                             (uint32_t)(__builtin_popcountll(found[i][0]) + __builtin_popcountll(found[i][1])),
+                             __ATOMIC_RELAXED);
+            __atomic_store_n(&bus->scanNs, monotonicNowNs() - started, __ATOMIC_RELAXED);
+            bus->scanned = true;
+            remaining--;
+        }
+        if (!progress) {
+            __atomic_fetch_add(&scansAborted, 1, __ATOMIC_RELAXED);
+            break;
+        }
+    }
+    scanning = false;
+    if (remaining == 0) {
+        lastScanNs = monotonicNowNs() - started;
+        scannedMs = wallClockMs();
+        __atomic_store_n(&scannedMonotonicNs, monotonicNowNs(), __ATOMIC_RELAXED);
+        __atomic_fetch_add(&scans, 1, __ATOMIC_RELAXED);
+    }
+    publishMap();
+    return remaining == 0;
+}
+
+static void* scannerThreadMain(void *arg) {
+    struct pollfd fds[2];
+    uint64_t value;
+    uint64_t dueNs = 0;
+    (void)arg;
+
+    pthread_setname_np(pthread_self(), "bus-scan");
+    fds[0].fd = stopFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = requestFd;
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        uint64_t now = monotonicNowNs();
+        uint64_t waitMs = dueNs > now ? (dueNs - now + 999999ull) / 1000000ull : 0;
+
+        if (waitMs == 0) {
+            // An interrupted scan is retried sooner than the TTL
+            uint64_t retryS = scanAll() ? ttlSeconds : (ttlSeconds < BUS_SCAN_RETRY_S ? ttlSeconds : BUS_SCAN_RETRY_S);
+
+            dueNs = monotonicNowNs() + retryS * 1000000000ull;
+            continue;
+        }
+        if (poll(fds, 2, waitMs > 60000 ? 60000 : (int)waitMs) < 0) {
+            continue;
+        }
+        if (fds[0].revents & POLLIN) {
+            break;
+        }
+        if ((fds[1].revents & POLLIN) && read(requestFd, &value, sizeof(value)) == sizeof(value)) {
+            dueNs = 0;
+        }
+    }
+    return NULL;
+}
+
+static void closeAll(void) {
+    if (stopFd >= 0) {
+        close(stopFd);
+        stopFd = -1;
+    }
+    if (requestFd >= 0) {
+        close(requestFd);
+        requestFd = -1;
+    }
+}
+
+bool busScanStart(uint32_t ttl) {
+    if (scannerActive || busCount == 0 || ttl == 0) {
+        return false;
+    }
+    if (!snapshotInit(&busSnapshot, BUS_SCAN_SNAPSHOT_CAPACITY, "application/json", "bus")) {
+        return false;
+    }
+    stopFd = eventfd(0, EFD_CLOEXEC);
+    requestFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (stopFd < 0 || requestFd < 0) {
+        perror("bus: eventfd");
+        closeAll();
+        snapshotDestroy(&busSnapshot);
+        return false;
+    }
+    ttlSeconds = ttl;
+    stopping = false;
+    snapshotLive = true;
+    // The map is served from the first request on; devices stay null until
+    // each bus has been scanned
+    publishMap();
+    if (pthread_create(&scannerThread, NULL, scannerThreadMain, NULL) != 0) {
+        closeAll();
+        snapshotLive = false;
+        snapshotDestroy(&busSnapshot);
+        return false;
+    }
+    scannerActive = true;
+    printf("Scanning %d bus(es), rescanned every %u s\n", busCount, ttl);
+    return true;
+}
+
+void busScanStop(void) {
+    uint64_t one = 1;
+
+    if (!scannerActive) {
+        return;
+    }
+    // A running scan gives up after its current chunk
+    __atomic_store_n(&stopping, true, __ATOMIC_RELEASE);
+    if (write(stopFd, &one, sizeof(one)) != sizeof(one)) {
+        perror("bus: stop");
+    }
+    pthread_join(scannerThread, NULL);
+    scannerActive = false;
+    closeAll();
+}
+
+void busScanDestroy(void) {
+    if (snapshotLive) {
+        snapshotLive = false;
+        snapshotDestroy(&busSnapshot);
+    }
+}
+
+bool busScanRequest(void) {
+    uint64_t one = 1;
+
+    if (!scannerActive) {
+        return false;
+    }
+    // Requests made during a scan collapse into one follow-up scan
+    return write(requestFd, &one, sizeof(one)) == sizeof(one);
+}
+
+enum MHD_Result busScanQueueResponse(struct MHD_Connection *connection) {
+    if (!snapshotLive) {
+        return MHD_NO;
+    }
+    return snapshotQueue(&busSnapshot, connection);
+}
+
+void busScanCollectMetrics(StrBuf *out, void *ctx) {
+    uint64_t completed = __atomic_load_n(&scans, __ATOMIC_RELAXED);
+    (void)ctx;
+
+    if (busCount == 0 || !scannerActive) {
+        return;
+    }
+    metricsHeader(out, "watchdog_bus_devices", "gauge", "Addresses that answered the last scan");
+    for (int i = 0; i < busCount; i++) {
+        strbufAppendf(out, "watchdog_bus_devices{type=\"%s\",bus=\"%u\"} %u\n", busTypeName(buses[i].type),
+                      buses[i].id, __atomic_load_n(&buses[i].deviceCount, __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_bus_scan_seconds", "gauge", "Duration of the last complete scan of each bus");
+    for (int i = 0; i < busCount; i++) {
+        strbufAppendf(out, "watchdog_bus_scan_seconds{type=\"%s\",bus=\"%u\"} %.6f\n", busTypeName(buses[i].type),
+                      buses[i].id, (double)__atomic_load_n(&buses[i].scanNs, __ATOMIC_RELAXED) / 1e9);
+    }
+    metricsHeader(out, "watchdog_bus_probe_errors_total", "counter", "Probes that failed for a reason other than no ACK");
+    for (int i = 0; i < busCount; i++) {
+        strbufAppendf(out, "watchdog_bus_probe_errors_total{type=\"%s\",bus=\"%u\"} %llu\n",
+                      busTypeName(buses[i].type), buses[i].id,
+                      (unsigned long long)__atomic_load_n(&buses[i].errors, __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_bus_scans_total", "counter", "Complete scans of every bus");
+    strbufAppendf(out, "watchdog_bus_scans_total %llu\n", (unsigned long long)completed);
+    metricsHeader(out, "watchdog_bus_scans_aborted_total", "counter", "Scans given up because the read lane was full");
+    strbufAppendf(out, "watchdog_bus_scans_aborted_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&scansAborted, __ATOMIC_RELAXED));
+    if (completed > 0) {
+        metricsHeader(out, "watchdog_bus_scan_age_seconds", "gauge", "Age of the cached address map");
+        strbufAppendf(out, "watchdog_bus_scan_age_seconds %.3f\n",
+                      (double)(monotonicNowNs() - __atomic_load_n(&scannedMonotonicNs, __ATOMIC_RELAXED)) / 1e9);
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef BUS_SCAN_H
+#define BUS_SCAN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <microhttpd.h>
+#include "strbuf.h"
+
+#define BUS_SCAN_MAX_BUSES 12            // SUSI_SMBUS_MAX_DEVICE + SUSI_I2C_MAX_DEVICE
+#define BUS_SCAN_FIRST_ADDRESS 0x03      // 7-bit range probed, as i2cdetect does
+#define BUS_SCAN_LAST_ADDRESS 0x77
+#define BUS_SCAN_CHUNK 8                 // Addresses probed per hardware command
+#define BUS_SCAN_DEFAULT_TTL_S 300
+#define BUS_SCAN_RETRY_S 10              // Delay before an interrupted scan is retried
+#define BUS_SCAN_SNAPSHOT_CAPACITY 4096
+
+// Background inventory of the devices on every SMBus and I2C host. A
+// scanner thread walks all buses side by side, one BUS_SCAN_CHUNK of
+// addresses per bus in turn, as commands on the hardware thread's user
+// lane, so telemetry keeps its share. The driver is still entered from
+// one thread, so a watchdog feed
+// never waits behind more than one chunk of probes. The address map is
+// cached as a pre-rendered /api/bus body and is only rescanned once it is
+// older than the TTL (or on request), so inventory queries never touch
+// the bus.
+
+// Find the supported hosts through the hardware thread
+bool busScanInit(void);
+// Scan now and then whenever the map's age reaches ttlSeconds; false
+// without buses or with a TTL of 0
+bool busScanStart(uint32_t ttlSeconds);
+void busScanStop(void);
+// Release the snapshot once no response can reference it (after MHD stopped)
+void busScanDestroy(void);
+
+// Start a new scan without waiting for the TTL; false if none can start
+bool busScanRequest(void);
+
+enum MHD_Result busScanQueueResponse(struct MHD_Connection *connection);
+void busScanCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // BUS_SCAN_H
@@ -0,0 +1,379 @@
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "config_body.h"
+
+#define POST_BUFFER_SIZE 512
+
+static const char *fieldNames[CONFIG_FIELD_COUNT] = {
+    [CONFIG_FIELD_DELAY] = "delay",
+    [CONFIG_FIELD_EVENT] = "event",
+    [CONFIG_FIELD_RESET] = "reset",
+    [CONFIG_FIELD_TYPE]  = "type",
+};
+
+static const char *invalidValue[CONFIG_FIELD_COUNT] = {
+    [CONFIG_FIELD_DELAY] = "Invalid value for delay",
+    [CONFIG_FIELD_EVENT] = "Invalid value for event",
+    [CONFIG_FIELD_RESET] = "Invalid value for reset",
+    [CONFIG_FIELD_TYPE]  = "Invalid value for type",
+};
+
+typedef enum {
+    JSON_OBJECT,       // Before the opening brace
+    JSON_KEY_OR_END,   // After "{"
+    JSON_KEY_START,    // After ","
+    JSON_KEY,          // Inside a key string
+    JSON_COLON,
+    JSON_VALUE,
+    JSON_NUMBER,
+    JSON_NEXT,         // After a value: "," or "}"
+    JSON_DONE,
+    JSON_ERROR
+} JsonState;
+
+static void fail(ConfigBody *body, const char *message) {
+    if (body->error == NULL) {
+        body->error = message;
+    }
+}
+
+static int findField(const char *key) {
+    for (int i = 0; i < CONFIG_FIELD_COUNT; i++) {
+        if (strcmp(key, fieldNames[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool parseValue(const char *text, size_t length, uint32_t *value) {
+    uint64_t result = 0;
+
+    if (length == 0 || length > 10) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        result = result * 10 + (uint64_t)(text[i] - '0');
+    }
+    if (result > UINT32_MAX) {
+        return false;
+    }
+    *value = (uint32_t)result;
+    return true;
+}
+
+// Hand a complete (or, for form data, growing) value to the body's sink
+static bool sinkValue(ConfigBody *body, const char *key, uint64_t value) {
+    const char *error;
+
+    if (value > UINT32_MAX) {
+        fail(body, "Configuration value out of range");
+        return false;
+    }
+    if ((error = body->sink(body->sinkCtx, key, (uint32_t)value)) != NULL) {
+        fail(body, error);
+        return false;
+    }
+    return true;
+}
+
+// Store one key/value pair; unknown keys are errors in a body but are
+// ignored in the query string, which also carries unrelated parameters
+static void setField(ConfigBody *body, const char *key, const char *text, size_t length, bool strict) {
+    int field = findField(key);
+
+    if (field < 0) {
+        if (strict) {
+            fail(body, "Unknown configuration field");
+        }
+        return;
+    }
+    if (!parseValue(text, length, &body->values[field])) {
+        fail(body, invalidValue[field]);
+        return;
+    }
+    body->presentMask |= 1u << field;
+}
+
+static enum MHD_Result queryIterator(void *cls, enum MHD_ValueKind kind, const char *key, const char *value) {
+    ConfigBody *body = cls;
+    (void)kind;
+
+    if (key != NULL && findField(key) >= 0) {
+        setField(body, key, value ? value : "", value ? strlen(value) : 0, false);
+    }
+    return MHD_YES;
+}
+
+void configReadQuery(ConfigBody *body, struct MHD_Connection *connection) {
+    MHD_get_connection_values(connection, MHD_GET_ARGUMENT_KIND, queryIterator, body);
+}
+
+// Form values can arrive split across several calls as the body streams
+// in; off is the position of this piece within the value, so digits are
+// accumulated in body->number until the value ends.
+static enum MHD_Result postIterator(void *cls, enum MHD_ValueKind kind, const char *key, const char *filename,
+                                    const char *contentType, const char *transferEncoding,
+                                    const char *data, uint64_t off, size_t size) {
+    ConfigBody *body = cls;
+    int field = -1;
+    const char *invalid = "Invalid configuration value";
+    (void)kind;
+    (void)filename;
+    (void)contentType;
+    (void)transferEncoding;
+
+    if (body->sink == NULL) {
+        field = findField(key);
+        if (field < 0) {
+            fail(body, "Unknown configuration field");
+            return MHD_NO;
+        }
+        invalid = invalidValue[field];
+    }
+    if (off == 0) {
+        if (size == 0) {
+            fail(body, invalid);
+            return MHD_NO;
+        }
+        body->number = 0;
+    }
+    for (size_t i = 0; i < size; i++) {
+        if (data[i] < '0' || data[i] > '9') {
+            fail(body, invalid);
+            return MHD_NO;
+        }
+        body->number = body->number * 10 + (uint64_t)(data[i] - '0');
+        if (body->number > UINT32_MAX) {
+            fail(body, invalid);
+            return MHD_NO;
+        }
+    }
+    if (body->sink != NULL) {
+        return sinkValue(body, key, body->number) ? MHD_YES : MHD_NO;
+    }
+    body->values[field] = (uint32_t)body->number;
+    body->presentMask |= 1u << field;
+    return MHD_YES;
+}
+
+bool configBodyInit(ConfigBody *body, struct MHD_Connection *connection) {
+    const char *type = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, "Content-Type");
+
+    memset(body, 0, sizeof(*body));
+    body->jsonState = JSON_OBJECT;
+    if (type == NULL || *type == '\0') {
+        body->kind = CONFIG_BODY_NONE;
+        return true;
+    }
+    if (strncasecmp(type, "application/json", 16) == 0) {
+        body->kind = CONFIG_BODY_JSON;
+        return true;
+    }
+    if (strncasecmp(type, "application/x-www-form-urlencoded", 33) == 0 ||
+        strncasecmp(type, "multipart/form-data", 19) == 0) {
+        body->post = MHD_create_post_processor(connection, POST_BUFFER_SIZE, postIterator, body);
+        if (body->post == NULL) {
+            return false;
+        }
+        body->kind = CONFIG_BODY_FORM;
+        return true;
+    }
+    return false;
+}
+
+bool configBodyInitSink(ConfigBody *body, struct MHD_Connection *connection, ConfigFieldSink sink, void *ctx) {
+    bool ok = configBodyInit(body, connection);
+
+    // The post-processor holds the body pointer, so the sink can be set after
+    body->sink = sink;
+    body->sinkCtx = ctx;
+    return ok;
+}
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static void jsonEndNumber(ConfigBody *body) {
+    int field;
+
+    if (body->sink != NULL) {
+        sinkValue(body, body->key, body->number);
+        return;
+    }
+    field = findField(body->key);
+    if (field < 0) {
+        fail(body, "Unknown configuration field");
+    } else if (body->number > UINT32_MAX) {
+        fail(body, invalidValue[field]);
+    } else {
+        body->values[field] = (uint32_t)body->number;
+        body->presentMask |= 1u << field;
+    }
+}
+
+// A value that is not a non-negative integer
+static void failValue(ConfigBody *body) {
+    int field;
+
+    if (body->sink != NULL) {
+        fail(body, "Invalid configuration value");
+        return;
+    }
+    field = findField(body->key);
+    fail(body, field < 0 ? "Unknown configuration field" : invalidValue[field]);
+}
+
+static void feedJson(ConfigBody *body, const char *data, size_t size) {
+    for (size_t i = 0; i < size && body->error == NULL; i++) {
+        char c = data[i];
+
+        switch (body->jsonState) {
+        case JSON_OBJECT:
+            if (c == '{') {
+                body->jsonState = JSON_KEY_OR_END;
+            } else if (!isSpace(c)) {
+                fail(body, "Request body must be a JSON object");
+            }
+            break;
+        case JSON_KEY_OR_END:
+        case JSON_KEY_START:
+            if (c == '"') {
+                body->keyLength = 0;
+                body->jsonState = JSON_KEY;
+            } else if (c == '}' && body->jsonState == JSON_KEY_OR_END) {
+                body->jsonState = JSON_DONE;
+            } else if (!isSpace(c)) {
+                fail(body, "Malformed JSON body");
+            }
+            break;
+        case JSON_KEY:
+            if (c == '"') {
+                body->key[body->keyLength] = '\0';
+                body->jsonState = JSON_COLON;
+            } else if (c == '\\' || body->keyLength == CONFIG_KEY_MAX) {
+                fail(body, "Unknown configuration field");
+            } else {
+                body->key[body->keyLength++] = c;
+            }
+            break;
+        case JSON_COLON:
+            if (c == ':') {
+                body->jsonState = JSON_VALUE;
+            } else if (!isSpace(c)) {
+                fail(body, "Malformed JSON body");
+            }
+            break;
+        case JSON_VALUE:
+            if (c >= '0' && c <= '9') {
+                body->number = (uint64_t)(c - '0');
+                body->jsonState = JSON_NUMBER;
+            } else if (!isSpace(c)) {
+                failValue(body);
+            }
+            break;
+        case JSON_NUMBER:
+            if (c >= '0' && c <= '9') {
+                body->number = body->number * 10 + (uint64_t)(c - '0');
+                if (body->number > UINT32_MAX) {
+                    jsonEndNumber(body);
+                }
+                break;
+            }
+            jsonEndNumber(body);
+            if (c == ',') {
+                body->jsonState = JSON_KEY_START;
+            } else if (c == '}') {
+                body->jsonState = JSON_DONE;
+            } else if (isSpace(c)) {
+                body->jsonState = JSON_NEXT;
+            } else {
+                failValue(body);
+            }
+            break;
+        case JSON_NEXT:
+            if (c == ',') {
+                body->jsonState = JSON_KEY_START;
+            } else if (c == '}') {
+                body->jsonState = JSON_DONE;
+            } else if (!isSpace(c)) {
+                fail(body, "Malformed JSON body");
+            }
+            break;
+        case JSON_DONE:
+            if (!isSpace(c)) {
+                fail(body, "Unexpected data after JSON object");
+            }
+            break;
+        }
+    }
+    if (body->error != NULL) {
+        body->jsonState = JSON_ERROR;
+    }
+}
+
+void configBodyFeed(ConfigBody *body, const char *data, size_t size) {
+    if (body->error != NULL) {
+        return;
+    }
+    body->received += size;
+    if (body->received > CONFIG_BODY_MAX) {
+        fail(body, "Request body too large");
+        return;
+    }
+    switch (body->kind) {
+    case CONFIG_BODY_JSON:
+        feedJson(body, data, size);
+        break;
+    case CONFIG_BODY_FORM:
+        if (MHD_post_process(body->post, data, size) != MHD_YES) {
+            fail(body, "Malformed form body");
+        }
+        break;
+    case CONFIG_BODY_NONE:
+        fail(body, "Missing Content-Type for request body");
+        break;
+    }
+}
+
+void configBodyFinish(ConfigBody *body) {
+    // Destroying the post-processor flushes the last urlencoded value
+    if (body->post != NULL) {
+        if (MHD_destroy_post_processor(body->post) != MHD_YES) {
+            fail(body, "Malformed form body");
+        }
+        body->post = NULL;
+    }
+    // An empty body is the same as "{}"
+    if (body->kind == CONFIG_BODY_JSON && body->error == NULL && body->received > 0 &&
+        body->jsonState != JSON_DONE) {
+        fail(body, "Truncated JSON body");
+    }
+}
+
+void configBodyDestroy(ConfigBody *body) {
+    if (body->post != NULL) {
+        MHD_destroy_post_processor(body->post);
+        body->post = NULL;
+    }
+}
+
+void configApply(const ConfigBody *body, WatchdogCommand *cmd) {
+    uint32_t *targets[CONFIG_FIELD_COUNT] = {
+        [CONFIG_FIELD_DELAY] = &cmd->delayTime,
+        [CONFIG_FIELD_EVENT] = &cmd->eventTime,
+        [CONFIG_FIELD_RESET] = &cmd->resetTime,
+        [CONFIG_FIELD_TYPE]  = &cmd->eventType,
+    };
+
+    for (int i = 0; i < CONFIG_FIELD_COUNT; i++) {
+        if (body->presentMask & (1u << i)) {
+            *targets[i] = body->values[i];
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef CONFIG_BODY_H
+#define CONFIG_BODY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <microhttpd.h>
+#include "watchdog.h"
+
+#define CONFIG_BODY_MAX 4096         // Largest accepted start/configure body
+#define CONFIG_KEY_MAX 24
+
+// Timing fields accepted by /start and /configure, as query parameters or in
+// the request body
+typedef enum {
+    CONFIG_FIELD_DELAY,
+    CONFIG_FIELD_EVENT,
+    CONFIG_FIELD_RESET,
+    CONFIG_FIELD_TYPE,
+    CONFIG_FIELD_COUNT
+} ConfigField;
+
+typedef enum {
+    CONFIG_BODY_NONE,
+    CONFIG_BODY_FORM,                // application/x-www-form-urlencoded or multipart/form-data
+    CONFIG_BODY_JSON                 // A flat object of non-negative integers
+} ConfigBodyKind;
+
+// Takes every key/value pair of a body parsed with configBodyInitSink
+// instead of the timing fields. Returns NULL, or the error to fail the body
+// with. A form value that arrives in pieces is passed again as it grows, so
+// a sink must let a later call for the same key replace an earlier one.
+typedef const char* (*ConfigFieldSink)(void *ctx, const char *key, uint32_t value);
+
+// Per-request parser state. The body is consumed chunk by chunk as
+// libmicrohttpd delivers it and never buffered whole: form bodies go through
+// an MHD post-processor, JSON through a small state machine that only holds
+// the current key and number.
+typedef struct {
+    ConfigBodyKind kind;
+    struct MHD_PostProcessor *post;
+    size_t received;
+    uint32_t values[CONFIG_FIELD_COUNT];
+    uint32_t presentMask;            // Bit per ConfigField that was supplied
+    const char *error;               // First problem found, NULL if none
+    int jsonState;
+    char key[CONFIG_KEY_MAX + 1];
+    size_t keyLength;
+    uint64_t number;
+    ConfigFieldSink sink;            // NULL for the timing fields
+    void *sinkCtx;
+} ConfigBody;
+
+// Set up a parser for the connection's Content-Type. Returns false if the
+// body type is not supported; a request without a body gets CONFIG_BODY_NONE.
+bool configBodyInit(ConfigBody *body, struct MHD_Connection *connection);
+// The same, for a body of arbitrary fields handed to sink
+bool configBodyInitSink(ConfigBody *body, struct MHD_Connection *connection, ConfigFieldSink sink, void *ctx);
+void configBodyFeed(ConfigBody *body, const char *data, size_t size);
+// Call once the upload is complete; checks that a JSON object was closed
+void configBodyFinish(ConfigBody *body);
+void configBodyDestroy(ConfigBody *body);
+
+// Read query-parameter timings in one pass over the arguments. The body, if
+// any, is applied on top of them.
+void configReadQuery(ConfigBody *body, struct MHD_Connection *connection);
+void configApply(const ConfigBody *body, WatchdogCommand *cmd);
+
+#endif // CONFIG_BODY_H
@@ -0,0 +1,528 @@
+#include <stdio.h>
+#include <string.h>
+#include "config_txn.h"
+#include "backlight.h"
+#include "fan_control.h"
+#include "hw_actor.h"
+#include "metrics.h"
+#include "susi_timing.h"
+#include "thermal_monitor.h"
+#include "timeutil.h"
+#include "watchdog.h"
+
+enum { THERMAL_SOURCE, THERMAL_TYPE, THERMAL_TRIP, THERMAL_CLEAR, THERMAL_FIELDS };
+enum {
+    FAN_MODE, FAN_PWM, FAN_SOURCE, FAN_OP_MODE, FAN_LOW_STOP, FAN_LOW, FAN_HIGH,
+    FAN_MIN_PWM, FAN_MAX_PWM, FAN_MIN_RPM, FAN_MAX_RPM, FAN_FIELDS
+};
+enum { BACKLIGHT_ENABLE, BACKLIGHT_BRIGHTNESS, BACKLIGHT_FIELDS };
+enum { WDT_RUNNING, WDT_DELAY, WDT_EVENT, WDT_RESET, WDT_TYPE, WDT_FIELDS };
+
+static const char *const thermalFields[] = { "source", "type", "trip", "clear" };
+static const char *const fanFields[] = {
+    "mode", "pwm", "source", "op_mode", "low_stop", "low", "high",
+    "min_pwm", "max_pwm", "min_rpm", "max_rpm"
+};
+static const char *const backlightFields[] = { "enable", "brightness" };
+static const char *const wdtFields[] = { "running", "delay", "event", "reset", "type" };
+
+// Reads one device into a full ConfigItem; writes move a device from one
+// full state to another, touching only what differs between the two
+typedef SusiStatus_t (*ConfigReadFn)(int item, ConfigItem *out);
+typedef const char* (*ConfigWriteFn)(int item, const ConfigItem *from, const ConfigItem *to, SusiStatus_t *status);
+
+typedef struct {
+    const char *name;
+    int items;
+    int fields;
+    const char *const *fieldNames;
+    ConfigReadFn read;
+    ConfigWriteFn write;
+    bool live;                       // Read on every command instead of cached
+} ConfigClassOps;
+
+static SusiStatus_t readThermal(int item, ConfigItem *out);
+static const char* writeThermal(int item, const ConfigItem *from, const ConfigItem *to, SusiStatus_t *status);
+static SusiStatus_t readFan(int item, ConfigItem *out);
+static const char* writeFan(int item, const ConfigItem *from, const ConfigItem *to, SusiStatus_t *status);
+static SusiStatus_t readBacklight(int item, ConfigItem *out);
+static const char* writeBacklight(int item, const ConfigItem *from, const ConfigItem *to, SusiStatus_t *status);
+static SusiStatus_t readWatchdog(int item, ConfigItem *out);
+static const char* writeWatchdog(int item, const ConfigItem *from, const ConfigItem *to, SusiStatus_t *status);
+
+static const ConfigClassOps classes[CONFIG_CLASS_COUNT] = {
+    [CONFIG_CLASS_THERMAL] = { "thermal", SUSI_ID_THERMAL_MAX, THERMAL_FIELDS, thermalFields, readThermal, writeThermal, false },
+    [CONFIG_CLASS_FAN] = { "fan", SUSI_ID_HWM_FAN_MAX, FAN_FIELDS, fanFields, readFan, writeFan, false },
+    [CONFIG_CLASS_BACKLIGHT] = { "backlight", SUSI_ID_BACKLIGHT_MAX, BACKLIGHT_FIELDS, backlightFields, readBacklight, writeBacklight, true },
+    [CONFIG_CLASS_WDT] = { "wdt", WATCHDOG_MAX_DEVICES, WDT_FIELDS, wdtFields, readWatchdog, writeWatchdog, true },
+};
+
+static const char *resultNames[] = {
+    [CONFIG_TXN_APPLIED] = "applied",
+    [CONFIG_TXN_UNCHANGED] = "unchanged",
+    [CONFIG_TXN_ROLLED_BACK] = "rolled_back",
+    [CONFIG_TXN_FAILED] = "failed",
+};
+
+// Only touched on the hardware thread
+static ConfigClassState cache[CONFIG_CLASS_COUNT];
+static bool cacheLoaded;
+
+static uint64_t resultCounts[sizeof(resultNames) / sizeof(resultNames[0])];
+static uint64_t writeCount;
+static uint64_t rollbackCount;
+
+const char* configClassName(ConfigClass deviceClass) {
+    return classes[deviceClass].name;
+}
+
+int configClassFields(ConfigClass deviceClass) {
+    return classes[deviceClass].fields;
+}
+
+const char* configFieldName(ConfigClass deviceClass, int field) {
+    return classes[deviceClass].fieldNames[field];
+}
+
+const char* configTxnResultName(ConfigTxnResult result) {
+    return resultNames[result];
+}
+
+void configTxnInit(ConfigTxn *txn) {
+    memset(txn, 0, sizeof(*txn));
+    txn->failed = -1;
+}
+
+// "<class><n>.<field>"
+const char* configTxnSetField(void *ctx, const char *key, uint32_t value) {
+    ConfigTxn *txn = ctx;
+
+    for (int c = 0; c < CONFIG_CLASS_COUNT; c++) {
+        const ConfigClassOps *ops = &classes[c];
+        size_t length = strlen(ops->name);
+        const char *p = key + length;
+        int item = 0;
+
+        if (strncmp(key, ops->name, length) != 0 || *p < '0' || *p > '9') {
+            continue;
+        }
+        while (*p >= '0' && *p <= '9' && item < ops->items) {
+            item = item * 10 + (*p++ - '0');
+        }
+        if (item >= ops->items || *p != '.') {
+            return "Unknown configuration device";
+        }
+        p++;
+        for (int f = 0; f < ops->fields; f++) {
+            if (strcmp(p, ops->fieldNames[f]) == 0) {
+                txn->desired[c][item].values[f] = value;
+                txn->desired[c][item].mask |= 1u << f;
+                return NULL;
+            }
+        }
+        return "Unknown configuration field";
+    }
+    return "Unknown configuration device";
+}
+
+static bool has(const ConfigItem *item, int field) {
+    return (item->mask >> field) & 1;
+}
+
+const char* configTxnValidate(const ConfigTxn *txn) {
+    for (int i = 0; i < CONFIG_TXN_MAX_ITEMS; i++) {
+        const ConfigItem *thermal = &txn->desired[CONFIG_CLASS_THERMAL][i];
+        const ConfigItem *fan = &txn->desired[CONFIG_CLASS_FAN][i];
+        const ConfigItem *backlight = &txn->desired[CONFIG_CLASS_BACKLIGHT][i];
+        const ConfigItem *wdt = &txn->desired[CONFIG_CLASS_WDT][i];
+
+        if (has(thermal, THERMAL_TYPE) && thermal->values[THERMAL_TYPE] > SUSI_THERMAL_EVENT_POWEROFF &&
+            thermal->values[THERMAL_TYPE] != SUSI_THERMAL_EVENT_NONE) {
+            return "Unknown thermal protection type";
+        }
+        if (fan->mask != 0 && fanControlOwns(SUSI_ID_HWM_FAN_BASE + (SusiId_t)i)) {
+            return "Fan is driven by a --fan-loop";
+        }
+        if (has(fan, FAN_MODE) && fan->values[FAN_MODE] > SUSI_FAN_CTRL_MODE_AUTO) {
+            return "Unknown fan mode";
+        }
+        if (has(fan, FAN_PWM) && fan->values[FAN_PWM] > 100) {
+            return "Fan PWM must be 0-100";
+        }
+        if (has(fan, FAN_OP_MODE) && fan->values[FAN_OP_MODE] > SUSI_FAN_AUTO_CTRL_OPMODE_RPM) {
+            return "Unknown fan operating mode";
+        }
+        if (has(backlight, BACKLIGHT_ENABLE) && backlight->values[BACKLIGHT_ENABLE] > 1) {
+            return "Backlight enable must be 0 or 1";
+        }
+        if (has(wdt, WDT_RUNNING) && wdt->values[WDT_RUNNING] > 1) {
+            return "Watchdog running must be 0 or 1";
+        }
+        if (has(wdt, WDT_TYPE) && wdt->values[WDT_TYPE] > SUSI_WDT_EVENT_TYPE_PIN) {
+            return "Unknown event type";
+        }
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Per-class hardware access (hardware thread)
+// ---------------------------------------------------------------------------
+
+static SusiStatus_t readThermal(int item, ConfigItem *out) {
+    SusiThermalProtect config;
+    uint64_t start = monotonicNowNs();
+    SusiStatus_t status = SusiThermalProtectionGetConfig((SusiId_t)item, &config);
+
+    susiTimingRecord(SUSI_CALL_THERMAL_GET_CONFIG, start, status);
+    if (status == SUSI_STATUS_SUCCESS) {
+        out->values[THERMAL_SOURCE] = config.SourceId;
+        out->values[THERMAL_TYPE] = config.EventType;
+        out->values[THERMAL_TRIP] = config.SendEventTemperature;
+        out->values[THERMAL_CLEAR] = config.ClearEventTemperature;
+    }
+    return status;
+}
+
+static const char* writeThermal(int item, const ConfigItem *from, const ConfigItem *to, SusiStatus_t *status) {
+    SusiThermalProtect config = {
+        .SourceId = to->values[THERMAL_SOURCE],
+        .EventType = to->values[THERMAL_TYPE],
+        .SendEventTemperature = to->values[THERMAL_TRIP],
+        .ClearEventTemperature = to->values[THERMAL_CLEAR],
+    };
+    uint64_t start = monotonicNowNs();
+    (void)from;
+
+    *status = SusiThermalProtectionSetConfig((SusiId_t)item, &config);
+    susiTimingRecord(SUSI_CALL_THERMAL_SET_CONFIG, start, *status);
+    if (*status != SUSI_STATUS_SUCCESS) {
+        return "Failed to set thermal protection";
+    }
+    thermalMonitorConfigChanged((SusiId_t)item, &config);
+    return NULL;
+}
+
+static SusiStatus_t readFan(int item, ConfigItem *out) {
+    SusiFanControl config;
+    uint64_t start = monotonicNowNs();
+    SusiStatus_t status;
+
+    memset(&config, 0, sizeof(config));
+    status = SusiFanControlGetConfig(SUSI_ID_HWM_FAN_BASE + (SusiId_t)item, &config);
+    susiTimingRecord(SUSI_CALL_FAN_GET_CONFIG, start, status);
+    if (status == SUSI_STATUS_SUCCESS) {
+        out->values[FAN_MODE] = config.Mode;
+        out->values[FAN_PWM] = config.PWM;
+        out->values[FAN_SOURCE] = config.AutoControl.TmlSource;
+        out->values[FAN_OP_MODE] = config.AutoControl.OpMode;
+        out->values[FAN_LOW_STOP] = config.AutoControl.LowStopLimit;
+        out->values[FAN_LOW] = config.AutoControl.LowLimit;
+        out->values[FAN_HIGH] = config.AutoControl.HighLimit;
+        out->values[FAN_MIN_PWM] = config.AutoControl.MinPWM;
+        out->values[FAN_MAX_PWM] = config.AutoControl.MaxPWM;
+        out->values[FAN_MIN_RPM] = config.AutoControl.MinRPM;
+        out->values[FAN_MAX_RPM] = config.AutoControl.MaxRPM;
+    }
+    return status;
+}
+
+static const char* writeFan(int item, const ConfigItem *from, const ConfigItem *to, SusiStatus_t *status) {
+    SusiFanControl config = {
+        .Mode = to->values[FAN_MODE],
+        .PWM = to->values[FAN_PWM],
+        .AutoControl = {
+            .TmlSource = to->values[FAN_SOURCE],
+            .OpMode = to->values[FAN_OP_MODE],
+            .LowStopLimit = to->values[FAN_LOW_STOP],
+            .LowLimit = to->values[FAN_LOW],
+            .HighLimit = to->values[FAN_HIGH],
+            .MinPWM = to->values[FAN_MIN_PWM],
+            .MaxPWM = to->values[FAN_MAX_PWM],
+            .MinRPM = to->values[FAN_MIN_RPM],
+            .MaxRPM = to->values[FAN_MAX_RPM],
+        },
+    };
+    uint64_t start = monotonicNowNs();
+    (void)from;
+
+    *status = SusiFanControlSetConfig(SUSI_ID_HWM_FAN_BASE + (SusiId_t)item, &config);
+    susiTimingRecord(SUSI_CALL_FAN_SET_CONFIG, start, *status);
+    return *status == SUSI_STATUS_SUCCESS ? NULL : "Failed to set fan configuration";
+}
+
+static SusiStatus_t readBacklight(int item, ConfigItem *out) {
+    uint64_t start = monotonicNowNs();
+    SusiStatus_t status = SusiVgaGetBacklightEnable((SusiId_t)item, &out->values[BACKLIGHT_ENABLE]);
+
+    susiTimingRecord(SUSI_CALL_VGA_GET_BACKLIGHT_ENABLE, start, status);
+    if (status != SUSI_STATUS_SUCCESS) {
+        return status;
+    }
+    start = monotonicNowNs();
+    status = SusiVgaGetBacklightBrightness((SusiId_t)item, &out->values[BACKLIGHT_BRIGHTNESS]);
+    susiTimingRecord(SUSI_CALL_VGA_GET_BACKLIGHT_BRIGHTNESS, start, status);
+    return status;
+}
+
+// A panel being switched on gets its new brightness before it lights up,
+// one being switched off only after it is dark
+static const char* writeBacklight(int item, const ConfigItem *from, const ConfigItem *to, SusiStatus_t *status) {
+    uint64_t start;
+
+    *status = SUSI_STATUS_SUCCESS;
+    if (to->values[BACKLIGHT_BRIGHTNESS] != from->values[BACKLIGHT_BRIGHTNESS] && to->values[BACKLIGHT_ENABLE] != 0) {
+        start = monotonicNowNs();
+        *status = SusiVgaSetBacklightBrightness((SusiId_t)item, to->values[BACKLIGHT_BRIGHTNESS]);
+        susiTimingRecord(SUSI_CALL_VGA_SET_BACKLIGHT_BRIGHTNESS, start, *status);
+        if (*status != SUSI_STATUS_SUCCESS) {
+            return "Failed to set backlight brightness";
+        }
+    }
+    if (to->values[BACKLIGHT_ENABLE] != from->values[BACKLIGHT_ENABLE]) {
+        start = monotonicNowNs();
+        *status = SusiVgaSetBacklightEnable((SusiId_t)item, to->values[BACKLIGHT_ENABLE]);
+        susiTimingRecord(SUSI_CALL_VGA_SET_BACKLIGHT_ENABLE, start, *status);
+        if (*status != SUSI_STATUS_SUCCESS) {
+            return "Failed to switch backlight";
+        }
+    }
+    if (to->values[BACKLIGHT_BRIGHTNESS] != from->values[BACKLIGHT_BRIGHTNESS] && to->values[BACKLIGHT_ENABLE] == 0) {
+        start = monotonicNowNs();
+        *status = SusiVgaSetBacklightBrightness((SusiId_t)item, to->values[BACKLIGHT_BRIGHTNESS]);
+        susiTimingRecord(SUSI_CALL_VGA_SET_BACKLIGHT_BRIGHTNESS, start, *status);
+        if (*status != SUSI_STATUS_SUCCESS) {
+            return "Failed to set backlight brightness";
+        }
+    }
+    if (to->values[BACKLIGHT_BRIGHTNESS] != from->values[BACKLIGHT_BRIGHTNESS]) {
+        backlightChanged((SusiId_t)item, to->values[BACKLIGHT_BRIGHTNESS]);
+    }
+    return NULL;
+}
+
+// The timings are the ones the next start would use
+static SusiStatus_t readWatchdog(int item, ConfigItem *out) {
+    WatchdogDevice *device = watchdogDevice((SusiId_t)item);
+    WatchdogCommand cmd;
+
+    if (device == NULL || !device->present) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    watchdogCommandInit(&cmd, device);
+    out->values[WDT_RUNNING] = device->running ? 1 : 0;
+    out->values[WDT_DELAY] = cmd.delayTime;
+    out->values[WDT_EVENT] = cmd.eventTime;
+    out->values[WDT_RESET] = cmd.resetTime;
+    out->values[WDT_TYPE] = cmd.eventType;
+    return SUSI_STATUS_SUCCESS;
+}
+
+// A running timer only takes new timings by being restarted
+static const char* writeWatchdog(int item, const ConfigItem *from, const ConfigItem *to, SusiStatus_t *status) {
+    WatchdogCommand cmd;
+    bool retimed = false;
+
+    watchdogCommandInit(&cmd, watchdogDevice((SusiId_t)item));
+    cmd.delayTime = to->values[WDT_DELAY];
+    cmd.eventTime = to->values[WDT_EVENT];
+    cmd.resetTime = to->values[WDT_RESET];
+    cmd.eventType = to->values[WDT_TYPE];
+    for (int f = WDT_DELAY; f <= WDT_TYPE; f++) {
+        retimed |= from->values[f] != to->values[f];
+    }
+    *status = SUSI_STATUS_SUCCESS;
+    if (from->values[WDT_RUNNING] && (!to->values[WDT_RUNNING] || retimed)) {
+        hwWatchdogStop(&cmd);
+        if (!cmd.ok) {
+            *status = SUSI_STATUS_ERROR;
+            return cmd.error;
+        }
+    }
+    if (to->values[WDT_RUNNING] && (!from->values[WDT_RUNNING] || retimed)) {
+        hwWatchdogStart(&cmd);
+    } else if (!to->values[WDT_RUNNING] && retimed) {
+        hwWatchdogConfigure(&cmd);
+    } else {
+        return NULL;
+    }
+    if (!cmd.ok) {
+        *status = SUSI_STATUS_ERROR;
+        return cmd.error;
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Transactions (hardware thread)
+// ---------------------------------------------------------------------------
+
+static void readClass(int c) {
+    const ConfigClassOps *ops = &classes[c];
+
+    cache[c].present = 0;
+    for (int i = 0; i < ops->items; i++) {
+        memset(&cache[c].items[i], 0, sizeof(cache[c].items[i]));
+        if (ops->read(i, &cache[c].items[i]) == SUSI_STATUS_SUCCESS) {
+            cache[c].items[i].mask = (1u << ops->fields) - 1;
+            cache[c].present |= 1u << i;
+        }
+    }
+}
+
+static void loadCache(bool refresh) {
+    for (int c = 0; c < CONFIG_CLASS_COUNT; c++) {
+        if (refresh || !cacheLoaded || classes[c].live) {
+            readClass(c);
+        }
+    }
+    cacheLoaded = true;
+}
+
+typedef struct {
+    ConfigClassState *state;
+    bool refresh;
+} CurrentRead;
+
+static void hwReadCurrent(void *arg) {
+    CurrentRead *read = arg;
+
+    loadCache(read->refresh);
+    memcpy(read->state, cache, sizeof(cache));
+}
+
+bool configTxnCurrent(ConfigClassState state[CONFIG_CLASS_COUNT], bool refresh) {
+    CurrentRead read = { state, refresh };
+
+    return hwActorCallShared(HW_LANE_READ, refresh, hwReadCurrent, &read, state,
+                             CONFIG_CLASS_COUNT * sizeof(ConfigClassState));
+}
+
+static bool sameState(int c, const ConfigItem *a, const ConfigItem *b) {
+    return memcmp(a->values, b->values, sizeof(a->values[0]) * (size_t)classes[c].fields) == 0;
+}
+
+static void merge(int c, const ConfigItem *current, const ConfigItem *desired, ConfigItem *out) {
+    *out = *current;
+    for (int f = 0; f < classes[c].fields; f++) {
+        if (has(desired, f)) {
+            out->values[f] = desired->values[f];
+        }
+    }
+}
+
+// Checks that need the current state: the device exists, and a timer's
+// merged timings are within its capabilities
+static const char* checkMerged(int c, int item, const ConfigItem *merged) {
+    if (!((cache[c].present >> item) & 1)) {
+        return "Configuration names a device the EC does not report";
+    }
+    if (c == CONFIG_CLASS_WDT) {
+        WatchdogCommand cmd;
+
+        watchdogCommandInit(&cmd, watchdogDevice((SusiId_t)item));
+        cmd.delayTime = merged->values[WDT_DELAY];
+        cmd.eventTime = merged->values[WDT_EVENT];
+        cmd.resetTime = merged->values[WDT_RESET];
+        cmd.eventType = merged->values[WDT_TYPE];
+        return watchdogCheckTimings(cmd.device, &cmd);
+    }
+    return NULL;
+}
+
+// Put a device back to before, from wherever a failed or undone write left it
+static bool restore(int c, int item, const ConfigItem *before) {
+    const ConfigClassOps *ops = &classes[c];
+    ConfigItem actual;
+    SusiStatus_t status;
+
+    memset(&actual, 0, sizeof(actual));
+    if (ops->read(item, &actual) != SUSI_STATUS_SUCCESS) {
+        return false;
+    }
+    if (!sameState(c, &actual, before) && ops->write(item, &actual, before, &status) != NULL) {
+        cache[c].items[item] = actual;
+        return false;
+    }
+    cache[c].items[item] = *before;
+    return true;
+}
+
+static void hwApply(void *arg) {
+    ConfigTxn *txn = arg;
+    ConfigItem previous[CONFIG_TXN_MAX_CHANGES];
+    ConfigItem target[CONFIG_TXN_MAX_CHANGES];
+
+    loadCache(txn->refresh);
+    // Everything is checked before the first write
+    txn->changes = 0;
+    txn->unchanged = 0;
+    for (int c = 0; c < CONFIG_CLASS_COUNT; c++) {
+        for (int i = 0; i < classes[c].items; i++) {
+            const ConfigItem *desired = &txn->desired[c][i];
+            ConfigItem merged;
+
+            if (desired->mask == 0) {
+                continue;
+            }
+            merge(c, &cache[c].items[i], desired, &merged);
+            if ((txn->error = checkMerged(c, i, &merged)) != NULL) {
+                return;
+            }
+            if (sameState(c, &merged, &cache[c].items[i])) {
+                txn->unchanged++;
+                continue;
+            }
+            previous[txn->changes] = cache[c].items[i];
+            target[txn->changes] = merged;
+            txn->changed[txn->changes].deviceClass = (uint8_t)c;
+            txn->changed[txn->changes].item = (uint8_t)i;
+            txn->changes++;
+        }
+    }
+    txn->result = txn->changes == 0 ? CONFIG_TXN_UNCHANGED : CONFIG_TXN_APPLIED;
+
+    for (int n = 0; n < txn->changes; n++) {
+        int c = txn->changed[n].deviceClass;
+        int i = txn->changed[n].item;
+
+        txn->failure = classes[c].write(i, &previous[n], &target[n], &txn->failedStatus);
+        if (txn->failure == NULL) {
+            cache[c].items[i] = target[n];
+            __atomic_fetch_add(&writeCount, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+        // Undo, newest first, including whatever part of the failed write landed
+        txn->failed = n;
+        txn->result = CONFIG_TXN_ROLLED_BACK;
+        for (int m = n; m >= 0; m--) {
+            if (!restore(txn->changed[m].deviceClass, txn->changed[m].item, &previous[m])) {
+                txn->rollbackErrors++;
+                txn->result = CONFIG_TXN_FAILED;
+            }
+        }
+        __atomic_fetch_add(&rollbackCount, 1, __ATOMIC_RELAXED);
+        break;
+    }
+    __atomic_fetch_add(&resultCounts[txn->result], 1, __ATOMIC_RELAXED);
+}
+
+bool configTxnApply(ConfigTxn *txn) {
+    return hwActorCall(HW_LANE_CONFIG, hwApply, txn);
+}
+
+void configTxnCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    metricsHeader(out, "watchdog_config_transactions_total", "counter", "PUT /api/config transactions by outcome");
+    for (size_t i = 0; i < sizeof(resultNames) / sizeof(resultNames[0]); i++) {
+        strbufAppendf(out, "watchdog_config_transactions_total{result=\"%s\"} %llu\n", resultNames[i],
+                      (unsigned long long)__atomic_load_n(&resultCounts[i], __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_config_writes_total", "counter", "Devices written by configuration transactions");
+    strbufAppendf(out, "watchdog_config_writes_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&writeCount, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_config_rollbacks_total", "counter", "Configuration transactions undone after a failed write");
+    strbufAppendf(out, "watchdog_config_rollbacks_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&rollbackCount, __ATOMIC_RELAXED));
+}
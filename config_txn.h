@@ -0,0 +1,97 @@
+#ifndef CONFIG_TXN_H
+#define CONFIG_TXN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "Susi4.h"
+#include "strbuf.h"
+
+#define CONFIG_TXN_MAX_ITEMS 16              // Devices per class; fans have the most (SUSI_ID_HWM_FAN_MAX)
+#define CONFIG_TXN_MAX_FIELDS 11             // Fields per device; fans have the most
+#define CONFIG_TXN_MAX_CHANGES (CONFIG_TXN_MAX_ITEMS * 4)
+
+// Desired-state configuration of the board in one request. A PUT
+// /api/config body is a flat object of "<class><n>.<field>" keys, e.g.
+// {"fan0.mode":2,"fan0.pwm":60,"wdt0.running":1}. Each device named by the
+// body is overlaid on the cached current state of that device, and only
+// devices whose merged state differs are written. The writes run back to
+// back in one config lane command, so nothing else reaches the EC between
+// them, in dependency order: thermal protection first, so the trip points
+// already cover what follows, then fans, backlights and the watchdog timers
+// last, so a timer is never armed by a transaction that goes on to fail.
+// When a write fails, the devices already written get their previous state
+// back, newest first.
+//
+// The cache is read from the EC on first use, or again on request, and is
+// kept up to date by the transaction's own writes. Watchdog state always
+// comes from the timer's cached state in watchdog.c, and backlights are
+// read on every transaction because backlight.c ramps them.
+
+// In dependency order
+typedef enum {
+    CONFIG_CLASS_THERMAL,            // thermalN: SUSI_ID_THERMAL_PROTECT_*
+    CONFIG_CLASS_FAN,                // fanN: SUSI_ID_HWM_FAN_BASE + n
+    CONFIG_CLASS_BACKLIGHT,          // backlightN: SUSI_ID_BACKLIGHT_*
+    CONFIG_CLASS_WDT,                // wdtN: watchdog timer n
+    CONFIG_CLASS_COUNT
+} ConfigClass;
+
+typedef struct {
+    uint32_t mask;                   // Bit per field that is set
+    uint32_t values[CONFIG_TXN_MAX_FIELDS];
+} ConfigItem;
+
+typedef enum {
+    CONFIG_TXN_APPLIED,              // Every changed device was written
+    CONFIG_TXN_UNCHANGED,            // Nothing differed from the current state
+    CONFIG_TXN_ROLLED_BACK,          // A write failed; the earlier ones were undone
+    CONFIG_TXN_FAILED                // A write and its rollback failed; the board is in between
+} ConfigTxnResult;
+
+typedef struct {
+    uint8_t deviceClass;
+    uint8_t item;
+} ConfigChange;
+
+typedef struct {
+    ConfigItem desired[CONFIG_CLASS_COUNT][CONFIG_TXN_MAX_ITEMS];
+    bool refresh;                    // Re-read the current state before the diff
+    const char *error;               // Why it was refused before any write
+    // Outcome, filled in by configTxnApply()
+    ConfigTxnResult result;
+    int changes;                     // Devices that differed, in write order
+    ConfigChange changed[CONFIG_TXN_MAX_CHANGES];
+    int unchanged;                   // Devices named whose state already matched
+    int failed;                      // Index into changed of the write that failed, or -1
+    const char *failure;             // Why it failed
+    SusiStatus_t failedStatus;
+    int rollbackErrors;              // Devices whose previous state could not be restored
+} ConfigTxn;
+
+void configTxnInit(ConfigTxn *txn);
+// ConfigFieldSink for configBodyInitSink(); ctx is the ConfigTxn
+const char* configTxnSetField(void *ctx, const char *key, uint32_t value);
+// Range checks that need no hardware, before configTxnApply()
+const char* configTxnValidate(const ConfigTxn *txn);
+// Diff and write through the hardware thread. False only when the command
+// could not be queued; the outcome is in txn otherwise.
+bool configTxnApply(ConfigTxn *txn);
+
+typedef struct {
+    uint32_t present;                // Bit per device the EC reported
+    ConfigItem items[CONFIG_TXN_MAX_ITEMS];
+} ConfigClassState;
+
+// Copy the cached current state of every class, reading the EC first when
+// refresh is set or the cache is empty. False when the hardware thread
+// could not be reached.
+bool configTxnCurrent(ConfigClassState state[CONFIG_CLASS_COUNT], bool refresh);
+
+const char* configClassName(ConfigClass deviceClass);
+int configClassFields(ConfigClass deviceClass);
+const char* configFieldName(ConfigClass deviceClass, int field);
+const char* configTxnResultName(ConfigTxnResult result);
+
+void configTxnCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // CONFIG_TXN_H
@@ -0,0 +1,274 @@
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "content_encoding.h"
+#include "metrics.h"
+#include "timeutil.h"
+#ifndef WATCHDOG_NO_COMPRESSION
+#include <zlib.h>
+#ifdef WATCHDOG_ZSTD
+#include <zstd.h>
+#endif
+#endif
+
+typedef struct {
+    uint64_t runs;
+    uint64_t inputBytes;
+    uint64_t outputBytes;
+    uint64_t elapsedNs;
+    uint64_t served;
+} EncodingStats;
+
+static int level = CONTENT_ENCODING_DEFAULT_LEVEL;
+static EncodingStats stats[CONTENT_ENCODING_COUNT];
+
+static const char *encodingNames[CONTENT_ENCODING_COUNT] = { "identity", "gzip", "deflate", "zstd" };
+
+bool contentEncodingConfigure(int newLevel) {
+    if (newLevel < 0 || newLevel > 9) {
+        return false;
+    }
+    level = newLevel;
+    return true;
+}
+
+bool contentEncodingEnabled(void) {
+#ifdef WATCHDOG_NO_COMPRESSION
+    return false;
+#else
+    return level > 0;
+#endif
+}
+
+const char* contentEncodingName(ContentEncoding encoding) {
+    return encoding < CONTENT_ENCODING_COUNT ? encodingNames[encoding] : "identity";
+}
+
+static bool encodingBuiltIn(ContentEncoding encoding) {
+#ifdef WATCHDOG_ZSTD
+    return encoding != CONTENT_ENCODING_IDENTITY;
+#else
+    return encoding == CONTENT_ENCODING_GZIP || encoding == CONTENT_ENCODING_DEFLATE;
+#endif
+}
+
+// Accept-Encoding is a comma separated list of codings, each with an
+// optional ;q= weight; "*" stands for every coding not listed
+ContentEncoding contentEncodingNegotiate(struct MHD_Connection *connection) {
+    static const ContentEncoding preference[] = { CONTENT_ENCODING_ZSTD, CONTENT_ENCODING_GZIP, CONTENT_ENCODING_DEFLATE };
+    double weights[CONTENT_ENCODING_COUNT];
+    bool listed[CONTENT_ENCODING_COUNT] = { false };
+    double wildcard = 0;
+    const char *header;
+    const char *p;
+    ContentEncoding best = CONTENT_ENCODING_IDENTITY;
+    double bestWeight = 0;
+
+    if (!contentEncodingEnabled()) {
+        return CONTENT_ENCODING_IDENTITY;
+    }
+    header = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, "Accept-Encoding");
+    if (header == NULL) {
+        return CONTENT_ENCODING_IDENTITY;
+    }
+
+    p = header;
+    while (*p) {
+        const char *token;
+        size_t length;
+        double weight = 1;
+        int encoding = -1;
+
+        while (*p == ' ' || *p == '\t' || *p == ',') {
+            p++;
+        }
+        token = p;
+        while (*p && *p != ',' && *p != ';' && *p != ' ' && *p != '\t') {
+            p++;
+        }
+        length = (size_t)(p - token);
+        // Parameters up to the next element; only q is meaningful
+        while (*p && *p != ',') {
+            if (*p == ';') {
+                const char *param = p + 1;
+
+                while (*param == ' ' || *param == '\t') {
+                    param++;
+                }
+                if ((param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+                    weight = strtod(param + 2, NULL);
+                }
+            }
+            p++;
+        }
+        if (length == 0) {
+            continue;
+        }
+        if (length == 1 && token[0] == '*') {
+            wildcard = weight;
+            continue;
+        }
+        if ((length == 4 && strncasecmp(token, "gzip", 4) == 0) || (length == 6 && strncasecmp(token, "x-gzip", 6) == 0)) {
+            encoding = CONTENT_ENCODING_GZIP;
+        } else if (length == 7 && strncasecmp(token, "deflate", 7) == 0) {
+            encoding = CONTENT_ENCODING_DEFLATE;
+        } else if (length == 4 && strncasecmp(token, "zstd", 4) == 0) {
+            encoding = CONTENT_ENCODING_ZSTD;
+        }
+        if (encoding >= 0) {
+            weights[encoding] = weight;
+            listed[encoding] = true;
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(preference) / sizeof(preference[0]); i++) {
+        ContentEncoding encoding = preference[i];
+        double weight = listed[encoding] ? weights[encoding] : wildcard;
+
+        if (encodingBuiltIn(encoding) && weight > bestWeight) {
+            best = encoding;
+            bestWeight = weight;
+        }
+    }
+    return best;
+}
+
+#ifndef WATCHDOG_NO_COMPRESSION
+// gzip and deflate differ only in the wrapper zlib puts around the stream
+static bool zlibCompress(bool gzip, const void *data, size_t length, void **compressed, size_t *compressedLength) {
+    z_stream stream;
+    unsigned char *out;
+    size_t capacity;
+    int result;
+
+    memset(&stream, 0, sizeof(stream));
+    if (deflateInit2(&stream, level, Z_DEFLATED, gzip ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+    capacity = deflateBound(&stream, (uLong)length);
+    out = malloc(capacity);
+    if (out == NULL) {
+        deflateEnd(&stream);
+        return false;
+    }
+    stream.next_in = (Bytef *)data;
+    stream.avail_in = (uInt)length;
+    stream.next_out = out;
+    stream.avail_out = (uInt)capacity;
+    result = deflate(&stream, Z_FINISH);
+    *compressedLength = stream.total_out;
+    deflateEnd(&stream);
+    if (result != Z_STREAM_END) {
+        free(out);
+        return false;
+    }
+    *compressed = out;
+    return true;
+}
+#endif
+
+#ifdef WATCHDOG_ZSTD
+static bool zstdCompress(const void *data, size_t length, void **compressed, size_t *compressedLength) {
+    size_t capacity = ZSTD_compressBound(length);
+    void *out = malloc(capacity);
+    size_t result;
+
+    if (out == NULL) {
+        return false;
+    }
+    result = ZSTD_compress(out, capacity, data, length, level);
+    if (ZSTD_isError(result)) {
+        free(out);
+        return false;
+    }
+    *compressed = out;
+    *compressedLength = result;
+    return true;
+}
+#endif
+
+bool contentEncodingCompress(ContentEncoding encoding, const void *data, size_t length,
+                             void **compressed, size_t *compressedLength) {
+    bool ok = false;
+#ifndef WATCHDOG_NO_COMPRESSION
+    uint64_t start = monotonicNowNs();
+
+    if (encoding == CONTENT_ENCODING_GZIP || encoding == CONTENT_ENCODING_DEFLATE) {
+        ok = zlibCompress(encoding == CONTENT_ENCODING_GZIP, data, length, compressed, compressedLength);
+    }
+#ifdef WATCHDOG_ZSTD
+    if (encoding == CONTENT_ENCODING_ZSTD) {
+        ok = zstdCompress(data, length, compressed, compressedLength);
+    }
+#endif
+    if (!ok) {
+        return false;
+    }
+    __atomic_fetch_add(&stats[encoding].runs, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats[encoding].inputBytes, length, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats[encoding].outputBytes, *compressedLength, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats[encoding].elapsedNs, monotonicNowNs() - start, __ATOMIC_RELAXED);
+    if (*compressedLength >= length) {
+        free(*compressed);
+        *compressed = NULL;
+        return false;
+    }
+#else
+    (void)encoding;
+    (void)data;
+    (void)length;
+    (void)compressed;
+    (void)compressedLength;
+#endif
+    return ok;
+}
+
+void contentEncodingRecordServed(ContentEncoding encoding) {
+    if (encoding < CONTENT_ENCODING_COUNT) {
+        __atomic_fetch_add(&stats[encoding].served, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void contentEncodingCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (!contentEncodingEnabled()) {
+        return;
+    }
+    metricsHeader(out, "watchdog_http_compressions_total", "counter",
+                  "Response bodies compressed, once per snapshot generation and encoding");
+    for (int encoding = CONTENT_ENCODING_GZIP; encoding < CONTENT_ENCODING_COUNT; encoding++) {
+        if (encodingBuiltIn((ContentEncoding)encoding)) {
+            strbufAppendf(out, "watchdog_http_compressions_total{encoding=\"%s\"} %llu\n", encodingNames[encoding],
+                          (unsigned long long)__atomic_load_n(&stats[encoding].runs, __ATOMIC_RELAXED));
+        }
+    }
+    metricsHeader(out, "watchdog_http_compression_input_bytes_total", "counter", "Bytes handed to the compressor");
+    for (int encoding = CONTENT_ENCODING_GZIP; encoding < CONTENT_ENCODING_COUNT; encoding++) {
+        if (encodingBuiltIn((ContentEncoding)encoding)) {
+            strbufAppendf(out, "watchdog_http_compression_input_bytes_total{encoding=\"%s\"} %llu\n", encodingNames[encoding],
+                          (unsigned long long)__atomic_load_n(&stats[encoding].inputBytes, __ATOMIC_RELAXED));
+        }
+    }
+    metricsHeader(out, "watchdog_http_compression_output_bytes_total", "counter", "Bytes the compressor produced");
+    for (int encoding = CONTENT_ENCODING_GZIP; encoding < CONTENT_ENCODING_COUNT; encoding++) {
+        if (encodingBuiltIn((ContentEncoding)encoding)) {
+            strbufAppendf(out, "watchdog_http_compression_output_bytes_total{encoding=\"%s\"} %llu\n", encodingNames[encoding],
+                          (unsigned long long)__atomic_load_n(&stats[encoding].outputBytes, __ATOMIC_RELAXED));
+        }
+    }
+    metricsHeader(out, "watchdog_http_compression_seconds_total", "counter", "Time spent compressing");
+    for (int encoding = CONTENT_ENCODING_GZIP; encoding < CONTENT_ENCODING_COUNT; encoding++) {
+        if (encodingBuiltIn((ContentEncoding)encoding)) {
+            strbufAppendf(out, "watchdog_http_compression_seconds_total{encoding=\"%s\"} %.6f\n", encodingNames[encoding],
+                          __atomic_load_n(&stats[encoding].elapsedNs, __ATOMIC_RELAXED) / 1e9);
+        }
+    }
+    metricsHeader(out, "watchdog_http_compressed_responses_total", "counter", "Responses sent with a Content-Encoding");
+    for (int encoding = CONTENT_ENCODING_GZIP; encoding < CONTENT_ENCODING_COUNT; encoding++) {
+        if (encodingBuiltIn((ContentEncoding)encoding)) {
+            strbufAppendf(out, "watchdog_http_compressed_responses_total{encoding=\"%s\"} %llu\n", encodingNames[encoding],
+                          (unsigned long long)__atomic_load_n(&stats[encoding].served, __ATOMIC_RELAXED));
+        }
+    }
+}
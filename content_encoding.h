@@ -0,0 +1,46 @@
+#ifndef CONTENT_ENCODING_H
+#define CONTENT_ENCODING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <microhttpd.h>
+#include "build_profile.h"
+#include "strbuf.h"
+
+#define CONTENT_ENCODING_DEFAULT_LEVEL 6
+#define CONTENT_ENCODING_MIN_SIZE 1024       // Smaller bodies are always sent as they are
+
+// Content-Encoding negotiation for the snapshot-backed responses. gzip and
+// deflate come from zlib; zstd is added by building with ZSTD=1. The small
+// profile sets WATCHDOG_NO_COMPRESSION: every request then negotiates
+// identity and zlib is not linked.
+
+typedef enum {
+    CONTENT_ENCODING_IDENTITY,
+    CONTENT_ENCODING_GZIP,
+    CONTENT_ENCODING_DEFLATE,
+    CONTENT_ENCODING_ZSTD,
+    CONTENT_ENCODING_COUNT
+} ContentEncoding;
+
+// Before the server starts; level 0 turns compression off, else 1-9
+bool contentEncodingConfigure(int level);
+bool contentEncodingEnabled(void);
+
+// The encoding the request's Accept-Encoding prefers among the ones built
+// in: the highest q-value wins, ties go to zstd, then gzip, then deflate
+ContentEncoding contentEncodingNegotiate(struct MHD_Connection *connection);
+const char* contentEncodingName(ContentEncoding encoding);
+
+// Compress length bytes into a malloc()ed buffer. False if the encoding is
+// not available or the result would not be smaller than the input.
+bool contentEncodingCompress(ContentEncoding encoding, const void *data, size_t length,
+                             void **compressed, size_t *compressedLength);
+
+// A compressed variant was sent instead of the identity body
+void contentEncodingRecordServed(ContentEncoding encoding);
+
+void contentEncodingCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // CONTENT_ENCODING_H
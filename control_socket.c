@@ -0,0 +1,375 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "control_socket.h"
+#include "watchdog.h"
+#include "metrics.h"
+#include "timeutil.h"
+
+static pthread_t controlThread;
+static bool controlActive = false;
+static int listenFd = -1;
+static int epollFd = -1;
+static int stopFd = -1;
+static char socketPath[sizeof(((struct sockaddr_un *)0)->sun_path)];
+
+static int clientCount = 0;
+static uint64_t requestCounts[CONTROL_OP_SUBSCRIBE + 1];
+// Written by the control thread, read by the pre-timeout notifier. A client
+// is removed under the lock before its descriptor is closed, so a
+// notification never goes to a recycled fd.
+static pthread_mutex_t subscriberLock = PTHREAD_MUTEX_INITIALIZER;
+static int subscribers[CONTROL_MAX_CLIENTS];
+static int subscriberCount = 0;
+static uint64_t notificationsSent = 0;
+static uint64_t notificationsDropped = 0;
+static uint64_t badRequests = 0;
+static uint64_t failedRequests = 0;
+
+static WatchdogDevice* resolveDevice(uint8_t index) {
+    WatchdogDevice *device;
+    
+    if (index == CONTROL_DEVICE_DEFAULT) {
+        return watchdogDefaultDevice();
+    }
+    device = watchdogDevice(index);
+    return (device && device->present) ? device : NULL;
+}
+
+static void fillStatus(ControlResponse *response, WatchdogDevice *device) {
+    uint64_t elapsedNs = 0;
+    WatchdogCommand timings;
+    
+    watchdogCommandInit(&timings, device);
+    response->running = device->running;
+    response->delayTime = timings.delayTime;
+    response->eventTime = timings.eventTime;
+    response->resetTime = timings.resetTime;
+    response->eventType = timings.eventType;
+    response->remainingToResetMs = watchdogResetDeadlineNs(device, monotonicNowNs(), &elapsedNs);
+    if (response->remainingToResetMs != INT64_MAX) {
+        response->remainingToResetMs /= 1000000;
+    }
+    response->elapsedSinceFeedMs = elapsedNs / 1000000;
+    response->feedCount = __atomic_load_n(&device->tracker.feedCount, __ATOMIC_RELAXED);
+}
+
+static void closeClient(int fd) {
+    pthread_mutex_lock(&subscriberLock);
+    for (int i = 0; i < subscriberCount; i++) {
+        if (subscribers[i] == fd) {
+            subscribers[i] = subscribers[--subscriberCount];
+            break;
+        }
+    }
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+    close(fd);
+    pthread_mutex_unlock(&subscriberLock);
+    clientCount--;
+}
+
+static void subscribe(int fd) {
+    pthread_mutex_lock(&subscriberLock);
+    for (int i = 0; i < subscriberCount; i++) {
+        if (subscribers[i] == fd) {
+            pthread_mutex_unlock(&subscriberLock);
+            return;
+        }
+    }
+    // clientCount never exceeds CONTROL_MAX_CLIENTS, so there is room
+    subscribers[subscriberCount++] = fd;
+    pthread_mutex_unlock(&subscriberLock);
+}
+
+// Run one request through the same hardware-thread commands as the HTTP API
+static void handleRequest(int fd, const ControlRequest *request, ControlResponse *response) {
+    WatchdogDevice *device;
+    WatchdogCommand cmd;
+    bool ok = true;
+    
+    response->status = CONTROL_STATUS_OK;
+    
+    device = resolveDevice(request->watchdog);
+    if (device == NULL) {
+        response->status = CONTROL_STATUS_NO_DEVICE;
+        return;
+    }
+    response->watchdog = (uint8_t)device->id;
+    watchdogCommandInit(&cmd, device);
+    
+    switch (request->op) {
+        case CONTROL_OP_FEED:
+            ok = watchdogExecute(HW_LANE_FEED, hwWatchdogTrigger, &cmd);
+            break;
+        case CONTROL_OP_STATUS:
+            break;
+        case CONTROL_OP_START:
+            if (request->delayTime) cmd.delayTime = request->delayTime;
+            if (request->eventTime) cmd.eventTime = request->eventTime;
+            if (request->resetTime) cmd.resetTime = request->resetTime;
+            if (request->eventType) cmd.eventType = request->eventType;
+            ok = watchdogExecute(HW_LANE_CONFIG, hwWatchdogStart, &cmd);
+            break;
+        case CONTROL_OP_STOP:
+            ok = watchdogExecute(HW_LANE_CONFIG, hwWatchdogStop, &cmd);
+            break;
+        case CONTROL_OP_SUBSCRIBE:
+            subscribe(fd);
+            break;
+    }
+    
+    if (!ok) {
+        response->status = (cmd.error == watchdogQueueFull) ? CONTROL_STATUS_BUSY : CONTROL_STATUS_FAILED;
+        __atomic_fetch_add(&failedRequests, 1, __ATOMIC_RELAXED);
+    }
+    fillStatus(response, device);
+}
+
+static void serveClient(int fd) {
+    ControlRequest request;
+    ControlResponse response;
+    ssize_t length;
+    
+    length = recv(fd, &request, sizeof(request), MSG_DONTWAIT);
+    if (length < 0 && (errno == EAGAIN || errno == EINTR)) {
+        return;
+    }
+    if (length <= 0) {
+        // Orderly close or a broken peer
+        closeClient(fd);
+        return;
+    }
+    
+    memset(&response, 0, sizeof(response));
+    response.magic = CONTROL_MAGIC;
+    response.version = CONTROL_VERSION;
+    
+    if ((size_t)length != sizeof(request) || request.magic != CONTROL_MAGIC ||
+        request.version != CONTROL_VERSION || request.op < CONTROL_OP_FEED || request.op > CONTROL_OP_SUBSCRIBE) {
+        response.status = CONTROL_STATUS_BAD_REQUEST;
+        if ((size_t)length >= offsetof(ControlRequest, delayTime)) {
+            response.sequence = request.sequence;
+        }
+        __atomic_fetch_add(&badRequests, 1, __ATOMIC_RELAXED);
+    } else {
+        response.op = request.op;
+        response.sequence = request.sequence;
+        __atomic_fetch_add(&requestCounts[request.op], 1, __ATOMIC_RELAXED);
+        handleRequest(fd, &request, &response);
+    }
+    
+    if (send(fd, &response, sizeof(response), MSG_NOSIGNAL | MSG_DONTWAIT) < 0 && errno != EAGAIN) {
+        closeClient(fd);
+    }
+}
+
+static void acceptClient(void) {
+    struct epoll_event event;
+    int fd = accept4(listenFd, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+    
+    if (fd < 0) {
+        return;
+    }
+    if (clientCount >= CONTROL_MAX_CLIENTS) {
+        close(fd);
+        return;
+    }
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        close(fd);
+        return;
+    }
+    clientCount++;
+}
+
+// One thread serves every client: requests are tiny and the hardware
+// thread serializes the SUSI calls anyway
+static void* controlThreadMain(void *arg) {
+    struct epoll_event events[16];
+    (void)arg;
+    
+    pthread_setname_np(pthread_self(), "control");
+    for (;;) {
+        int count = epoll_wait(epollFd, events, 16, -1);
+        
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            
+            if (fd == stopFd) {
+                return NULL;
+            }
+            if (fd == listenFd) {
+                acceptClient();
+            } else {
+                serveClient(fd);
+            }
+        }
+    }
+}
+
+static void closeAll(void) {
+    if (epollFd >= 0) {
+        close(epollFd);
+        epollFd = -1;
+    }
+    if (stopFd >= 0) {
+        close(stopFd);
+        stopFd = -1;
+    }
+    if (listenFd >= 0) {
+        close(listenFd);
+        listenFd = -1;
+        unlink(socketPath);
+    }
+}
+
+bool controlSocketStart(const char *path, unsigned int mode) {
+    struct sockaddr_un address;
+    struct epoll_event event;
+    
+    if (controlActive || strlen(path) >= sizeof(address.sun_path)) {
+        return false;
+    }
+    
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    strcpy(socketPath, path);
+    
+    listenFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (listenFd < 0) {
+        perror("control: socket");
+        return false;
+    }
+    // A stale socket file from a previous run would make bind fail
+    unlink(path);
+    if (bind(listenFd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        chmod(path, mode) != 0 || listen(listenFd, 16) != 0) {
+        perror("control: bind");
+        closeAll();
+        return false;
+    }
+    
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    stopFd = eventfd(0, EFD_CLOEXEC);
+    if (epollFd < 0 || stopFd < 0) {
+        perror("control: epoll/eventfd");
+        closeAll();
+        return false;
+    }
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+    event.data.fd = stopFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, stopFd, &event);
+    
+    if (pthread_create(&controlThread, NULL, controlThreadMain, NULL) != 0) {
+        closeAll();
+        return false;
+    }
+    __atomic_store_n(&controlActive, true, __ATOMIC_RELEASE);
+    printf("Control socket listening on %s\n", path);
+    return true;
+}
+
+void controlSocketStop(void) {
+    uint64_t one = 1;
+    
+    if (!controlActive) {
+        return;
+    }
+    if (write(stopFd, &one, sizeof(one)) != sizeof(one)) {
+        perror("control: stop");
+    }
+    pthread_join(controlThread, NULL);
+    __atomic_store_n(&controlActive, false, __ATOMIC_RELEASE);
+    pthread_mutex_lock(&subscriberLock);
+    subscriberCount = 0;
+    pthread_mutex_unlock(&subscriberLock);
+    // Client sockets are closed with the process; only the listener is ours
+    closeAll();
+}
+
+// Send one unsolicited message to every subscriber; never blocks on a slow one
+static void notifySubscribers(const ControlResponse *message) {
+    pthread_mutex_lock(&subscriberLock);
+    for (int i = 0; i < subscriberCount; i++) {
+        if (send(subscribers[i], message, sizeof(*message), MSG_NOSIGNAL | MSG_DONTWAIT) == sizeof(*message)) {
+            __atomic_fetch_add(&notificationsSent, 1, __ATOMIC_RELAXED);
+        } else {
+            __atomic_fetch_add(&notificationsDropped, 1, __ATOMIC_RELAXED);
+        }
+    }
+    pthread_mutex_unlock(&subscriberLock);
+}
+
+void controlSocketNotifyPretimeout(uint8_t watchdog, uint32_t count) {
+    ControlResponse message;
+    WatchdogDevice *device = watchdogDevice(watchdog);
+    
+    if (device == NULL || !__atomic_load_n(&controlActive, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    memset(&message, 0, sizeof(message));
+    message.magic = CONTROL_MAGIC;
+    message.version = CONTROL_VERSION;
+    message.op = CONTROL_OP_PRETIMEOUT;
+    message.watchdog = watchdog;
+    message.status = CONTROL_STATUS_OK;
+    message.sequence = count;
+    fillStatus(&message, device);
+    notifySubscribers(&message);
+}
+
+void controlSocketNotifyGpio(uint32_t gpio, uint32_t sequence, uint64_t timestampMs) {
+    ControlResponse message;
+
+    if (!__atomic_load_n(&controlActive, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    memset(&message, 0, sizeof(message));
+    message.magic = CONTROL_MAGIC;
+    message.version = CONTROL_VERSION;
+    message.op = CONTROL_OP_GPIO;
+    message.watchdog = CONTROL_DEVICE_DEFAULT;
+    message.status = CONTROL_STATUS_OK;
+    message.sequence = sequence;
+    message.delayTime = gpio;
+    message.remainingToResetMs = INT64_MAX;
+    message.elapsedSinceFeedMs = timestampMs;
+    notifySubscribers(&message);
+}
+
+void controlSocketCollectMetrics(StrBuf *out, void *ctx) {
+    static const char *opNames[] = { NULL, "feed", "status", "start", "stop", "subscribe" };
+    (void)ctx;
+    
+    metricsHeader(out, "watchdog_control_requests_total", "counter", "Control socket requests by operation");
+    for (int op = CONTROL_OP_FEED; op <= CONTROL_OP_SUBSCRIBE; op++) {
+        strbufAppendf(out, "watchdog_control_requests_total{op=\"%s\"} %llu\n", opNames[op],
+                      (unsigned long long)__atomic_load_n(&requestCounts[op], __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_control_bad_requests_total", "counter", "Malformed control socket messages");
+    strbufAppendf(out, "watchdog_control_bad_requests_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&badRequests, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_control_failed_requests_total", "counter", "Control requests the watchdog rejected");
+    strbufAppendf(out, "watchdog_control_failed_requests_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&failedRequests, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_control_notifications_total", "counter", "Pre-timeout notifications by delivery result");
+    strbufAppendf(out, "watchdog_control_notifications_total{result=\"sent\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&notificationsSent, __ATOMIC_RELAXED));
+    strbufAppendf(out, "watchdog_control_notifications_total{result=\"dropped\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&notificationsDropped, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_control_clients", "gauge", "Connected control socket clients");
+    strbufAppendf(out, "watchdog_control_clients %d\n", __atomic_load_n(&clientCount, __ATOMIC_RELAXED));
+}
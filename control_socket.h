@@ -0,0 +1,86 @@
+#ifndef CONTROL_SOCKET_H
+#define CONTROL_SOCKET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "strbuf.h"
+
+// Binary control protocol over an AF_UNIX SOCK_SEQPACKET socket.
+// Every datagram is exactly one fixed-size little-endian (host order)
+// message; the service answers each request with one response carrying the
+// same sequence number. This header is self-contained so feeder daemons can
+// include it directly.
+
+#define CONTROL_MAGIC 0x57444f47u   // "WDOG"
+#define CONTROL_VERSION 1
+#define CONTROL_MAX_CLIENTS 64
+
+typedef enum {
+    CONTROL_OP_FEED = 1,
+    CONTROL_OP_STATUS = 2,
+    CONTROL_OP_START = 3,
+    CONTROL_OP_STOP = 4,
+    CONTROL_OP_SUBSCRIBE = 5,        // Receive CONTROL_OP_PRETIMEOUT notifications on this socket
+    CONTROL_OP_PRETIMEOUT = 6,       // Unsolicited: the timer reached its event stage
+    CONTROL_OP_GPIO = 7              // Unsolicited: a GPIO interrupt fired
+} ControlOp;
+
+typedef enum {
+    CONTROL_STATUS_OK = 0,
+    CONTROL_STATUS_FAILED = 1,       // The watchdog rejected the operation
+    CONTROL_STATUS_BUSY = 2,         // Hardware queue is full, retry
+    CONTROL_STATUS_BAD_REQUEST = 3,  // Wrong size, magic, version or op
+    CONTROL_STATUS_NO_DEVICE = 4     // Unknown watchdog index
+} ControlStatus;
+
+#define CONTROL_DEVICE_DEFAULT 0xff  // Use the service's default watchdog
+
+typedef struct {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t op;          // ControlOp
+    uint8_t watchdog;    // Watchdog index or CONTROL_DEVICE_DEFAULT
+    uint8_t reserved;
+    uint32_t sequence;   // Echoed in the response
+    // CONTROL_OP_START only; 0 keeps the configured value
+    uint32_t delayTime;
+    uint32_t eventTime;
+    uint32_t resetTime;
+    uint32_t eventType;
+} ControlRequest;
+
+typedef struct {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t op;
+    uint8_t watchdog;    // Index the request resolved to
+    uint8_t status;      // ControlStatus
+    uint32_t sequence;   // For CONTROL_OP_PRETIMEOUT: pre-timeouts seen on the timer
+                         // For CONTROL_OP_GPIO: GPIO event number; delayTime holds the
+                         // GPIO id and elapsedSinceFeedMs the wall clock of the edge (ms)
+    uint8_t running;
+    uint8_t reserved[3];
+    uint32_t delayTime;
+    uint32_t eventTime;
+    uint32_t resetTime;
+    uint32_t eventType;
+    int64_t remainingToResetMs;   // INT64_MAX when not running
+    uint64_t elapsedSinceFeedMs;
+    uint64_t feedCount;
+} ControlResponse;
+
+// Listen on path (an existing socket file is replaced). mode is applied with
+// chmod so access can be limited to the feeder's group.
+bool controlSocketStart(const char *path, unsigned int mode);
+void controlSocketStop(void);
+
+// Send a CONTROL_OP_PRETIMEOUT message to every subscribed client without
+// blocking; clients with a full socket buffer miss it
+void controlSocketNotifyPretimeout(uint8_t watchdog, uint32_t count);
+
+// Send a CONTROL_OP_GPIO message to every subscribed client, the same way
+void controlSocketNotifyGpio(uint32_t gpio, uint32_t sequence, uint64_t timestampMs);
+
+void controlSocketCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // CONTROL_SOCKET_H
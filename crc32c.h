@@ -0,0 +1,18 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-32C (Castagnoli), as used by iSCSI and ext4. Start with 0 and pass
+// the previous result to continue over more data:
+// crc32c(crc32c(0, a, n), b, m) == crc32c(0, ab, n + m)
+//
+// Uses the SSE4.2 or ARMv8 CRC instructions when the CPU has them, a
+// table otherwise; the choice is made at run time, so one binary serves
+// every machine.
+uint32_t crc32c(uint32_t crc, const void *data, size_t length);
+// "sse4.2", "armv8" or "table"
+const char* crc32cImplementation(void);
+
+#endif // CRC32C_H
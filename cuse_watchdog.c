@@ -0,0 +1,488 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <linux/fuse.h>
+#include <linux/watchdog.h>
+#include "cuse_watchdog.h"
+#include "metrics.h"
+#include "timeutil.h"
+#include "watchdog.h"
+
+#define CUSE_DEVICE "/dev/cuse"
+#define CUSE_MAX_WRITE 4096
+#define CUSE_BUFFER_BYTES (CUSE_MAX_WRITE + 4096)   // Request header, write header and payload
+#define CUSE_IDENTITY "SUSI watchdog"
+
+typedef enum {
+    CUSE_OP_OPEN,
+    CUSE_OP_RELEASE,
+    CUSE_OP_WRITE,
+    CUSE_OP_KEEPALIVE,
+    CUSE_OP_SET_TIMEOUT,
+    CUSE_OP_GET_TIMEOUT,
+    CUSE_OP_GET_TIME_LEFT,
+    CUSE_OP_SET_OPTIONS,
+    CUSE_OP_INFO,               // GETSUPPORT, GETSTATUS, GETBOOTSTATUS
+    CUSE_OP_OTHER,
+    CUSE_OP_COUNT
+} CuseOp;
+
+static const char *opNames[CUSE_OP_COUNT] = {
+    "open", "release", "write", "keepalive", "settimeout", "gettimeout", "gettimeleft", "setoptions", "info", "other"
+};
+
+static char deviceName[CUSE_WATCHDOG_NAME_MAX];
+static int cuseFd = -1;
+static int stopFd = -1;
+static pthread_t cuseThread;
+static bool cuseActive = false;
+static unsigned char request[CUSE_BUFFER_BYTES];
+
+// Only the CUSE thread changes these
+static uint64_t openHandle = 0;        // fh of the one opener, 0 when closed
+static uint64_t nextHandle = 1;
+static bool expectClose = false;       // The opener wrote the magic 'V'
+
+static bool deviceOpen = false;
+static uint64_t requests[CUSE_OP_COUNT];
+static uint64_t failedRequests = 0;
+static uint64_t unexpectedCloses = 0;
+
+bool cuseWatchdogSetName(const char *name) {
+    if (name[0] == '\0' || strchr(name, '/') != NULL || strlen(name) >= sizeof(deviceName)) {
+        return false;
+    }
+    snprintf(deviceName, sizeof(deviceName), "%s", name);
+    return true;
+}
+
+static void reply(uint64_t unique, int error, const void *body, size_t length) {
+    struct fuse_out_header header;
+    unsigned char out[sizeof(header) + sizeof(struct cuse_init_out) + 128];
+
+    if (length > sizeof(out) - sizeof(header)) {
+        return;
+    }
+    header.len = (uint32_t)(sizeof(header) + length);
+    header.error = error;
+    header.unique = unique;
+    memcpy(out, &header, sizeof(header));
+    if (length > 0) {
+        memcpy(out + sizeof(header), body, length);
+    }
+    // ENOENT means the request was interrupted and is gone
+    if (write(cuseFd, out, header.len) != (ssize_t)header.len && errno != ENOENT) {
+        perror("cuse: reply");
+    }
+}
+
+static void count(CuseOp op, bool ok) {
+    __atomic_fetch_add(&requests[op], 1, __ATOMIC_RELAXED);
+    if (!ok) {
+        __atomic_fetch_add(&failedRequests, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Linux timeout: seconds a keepalive buys. That is event + reset here; the
+// event stage keeps its share when an event is configured and fits.
+static uint32_t timeoutSeconds(const WatchdogCommand *cmd) {
+    return (cmd->eventTime + cmd->resetTime + 999) / 1000;
+}
+
+static void setTimeoutSeconds(WatchdogCommand *cmd, uint32_t seconds) {
+    uint32_t totalMs = seconds * 1000;
+
+    if (cmd->eventType == SUSI_WDT_EVENT_TYPE_NONE || cmd->eventTime >= totalMs) {
+        cmd->eventTime = 0;
+    }
+    cmd->resetTime = totalMs - cmd->eventTime;
+    // Every window is the same length, the first one included
+    cmd->delayTime = 0;
+}
+
+// Stop and start in one hardware-thread command, so no feed or status
+// request sees the timer stopped in between. Timings are checked first
+// so a rejected timeout leaves the timer running.
+static void hwWatchdogRestart(void *arg) {
+    WatchdogCommand *cmd = (WatchdogCommand *)arg;
+    WatchdogCommand stop = *cmd;
+
+    cmd->ok = false;
+    if ((cmd->error = watchdogCheckTimings(cmd->device, cmd)) != NULL) {
+        return;
+    }
+    if (cmd->device->running) {
+        hwWatchdogStop(&stop);
+        if (!stop.ok) {
+            cmd->error = stop.error;
+            return;
+        }
+    }
+    hwWatchdogStart(cmd);
+}
+
+static void handleOpen(uint64_t unique) {
+    struct fuse_open_out out;
+    WatchdogDevice *device = watchdogDefaultDevice();
+    WatchdogCommand cmd;
+
+    if (device == NULL) {
+        count(CUSE_OP_OPEN, false);
+        reply(unique, -ENODEV, NULL, 0);
+        return;
+    }
+    if (openHandle != 0) {
+        count(CUSE_OP_OPEN, false);
+        reply(unique, -EBUSY, NULL, 0);
+        return;
+    }
+    // Opening the device starts the timer, as with the kernel drivers
+    watchdogCommandInit(&cmd, device);
+    if (!device->running && !watchdogExecute(HW_LANE_CONFIG, hwWatchdogStart, &cmd)) {
+        printf("cuse: cannot start watchdog %u: %s\n", device->id, cmd.error ? cmd.error : "unknown error");
+        count(CUSE_OP_OPEN, false);
+        reply(unique, cmd.error == watchdogQueueFull ? -EBUSY : -EIO, NULL, 0);
+        return;
+    }
+    memset(&out, 0, sizeof(out));
+    out.fh = openHandle = nextHandle++;
+    out.open_flags = FOPEN_DIRECT_IO | FOPEN_NONSEEKABLE;
+    expectClose = false;
+    __atomic_store_n(&deviceOpen, true, __ATOMIC_RELAXED);
+    count(CUSE_OP_OPEN, true);
+    reply(unique, 0, &out, sizeof(out));
+}
+
+static void handleRelease(uint64_t unique, const struct fuse_release_in *in) {
+    WatchdogDevice *device = watchdogDefaultDevice();
+
+    if (in->fh == openHandle) {
+        if (expectClose && device != NULL && device->running) {
+            WatchdogCommand cmd;
+
+            watchdogCommandInit(&cmd, device);
+            if (!watchdogExecute(HW_LANE_CONFIG, hwWatchdogStop, &cmd)) {
+                printf("cuse: cannot stop watchdog %u: %s\n", device->id, cmd.error ? cmd.error : "unknown error");
+            }
+        } else if (!expectClose) {
+            printf("cuse: /dev/%s closed without 'V', watchdog keeps running\n", deviceName);
+            __atomic_fetch_add(&unexpectedCloses, 1, __ATOMIC_RELAXED);
+        }
+        openHandle = 0;
+        expectClose = false;
+        __atomic_store_n(&deviceOpen, false, __ATOMIC_RELAXED);
+    }
+    count(CUSE_OP_RELEASE, true);
+    reply(unique, 0, NULL, 0);
+}
+
+static bool feed(void) {
+    WatchdogDevice *device = watchdogDefaultDevice();
+    WatchdogCommand cmd;
+
+    if (device == NULL) {
+        return false;
+    }
+    watchdogCommandInit(&cmd, device);
+    return watchdogExecute(HW_LANE_FEED, hwWatchdogTrigger, &cmd);
+}
+
+// Any write feeds; a 'V' anywhere in it arms the magic close
+static void handleWrite(uint64_t unique, const struct fuse_write_in *in, const unsigned char *data, size_t available) {
+    struct fuse_write_out out;
+    size_t length = in->size < available ? in->size : available;
+    bool ok;
+
+    expectClose = memchr(data, 'V', length) != NULL;
+    ok = feed();
+    count(CUSE_OP_WRITE, ok);
+    if (!ok) {
+        reply(unique, -EIO, NULL, 0);
+        return;
+    }
+    memset(&out, 0, sizeof(out));
+    out.size = in->size;
+    reply(unique, 0, &out, sizeof(out));
+}
+
+static void replyIoctl(uint64_t unique, int result, const void *data, size_t length) {
+    unsigned char out[sizeof(struct fuse_ioctl_out) + sizeof(struct watchdog_info)];
+    struct fuse_ioctl_out header;
+
+    memset(&header, 0, sizeof(header));
+    header.result = result;
+    memcpy(out, &header, sizeof(header));
+    if (length > 0) {
+        memcpy(out + sizeof(header), data, length);
+    }
+    reply(unique, 0, out, sizeof(header) + length);
+}
+
+// Restricted CUSE ioctls: the kernel sizes the argument from the command
+// number, passes _IOW data after the header and copies back ours for _IOR
+static void handleIoctl(uint64_t unique, const struct fuse_ioctl_in *in, const unsigned char *data, size_t available) {
+    WatchdogDevice *device = watchdogDefaultDevice();
+    WatchdogCommand cmd;
+    int value = 0;
+    bool ok = true;
+
+    if (device == NULL) {
+        count(CUSE_OP_OTHER, false);
+        reply(unique, -ENODEV, NULL, 0);
+        return;
+    }
+    if (in->in_size >= sizeof(int) && available >= sizeof(int)) {
+        memcpy(&value, data, sizeof(int));
+    }
+    watchdogCommandInit(&cmd, device);
+
+    switch (in->cmd) {
+        case WDIOC_GETSUPPORT: {
+            struct watchdog_info info;
+
+            memset(&info, 0, sizeof(info));
+            info.options = WDIOF_SETTIMEOUT | WDIOF_KEEPALIVEPING | WDIOF_MAGICCLOSE;
+            snprintf((char *)info.identity, sizeof(info.identity), "%s %u", CUSE_IDENTITY, device->id);
+            count(CUSE_OP_INFO, true);
+            replyIoctl(unique, 0, &info, sizeof(info));
+            return;
+        }
+        case WDIOC_GETSTATUS:
+        case WDIOC_GETBOOTSTATUS:
+            value = 0;
+            count(CUSE_OP_INFO, true);
+            replyIoctl(unique, 0, &value, sizeof(value));
+            return;
+        case WDIOC_KEEPALIVE:
+            ok = feed();
+            count(CUSE_OP_KEEPALIVE, ok);
+            value = 0;
+            break;
+        case WDIOC_SETTIMEOUT:
+            if (value <= 0 || value > 65535) {
+                count(CUSE_OP_SET_TIMEOUT, false);
+                reply(unique, -EINVAL, NULL, 0);
+                return;
+            }
+            setTimeoutSeconds(&cmd, (uint32_t)value);
+            if (watchdogCheckTimings(device, &cmd) != NULL) {
+                count(CUSE_OP_SET_TIMEOUT, false);
+                reply(unique, -EINVAL, NULL, 0);
+                return;
+            }
+            ok = watchdogExecute(HW_LANE_CONFIG, hwWatchdogRestart, &cmd);
+            count(CUSE_OP_SET_TIMEOUT, ok);
+            value = (int)timeoutSeconds(&cmd);
+            break;
+        case WDIOC_GETTIMEOUT:
+            value = (int)timeoutSeconds(&cmd);
+            count(CUSE_OP_GET_TIMEOUT, true);
+            break;
+        case WDIOC_GETTIMELEFT: {
+            int64_t remainingNs = watchdogResetDeadlineNs(device, monotonicNowNs(), NULL);
+
+            if (!device->running) {
+                count(CUSE_OP_GET_TIME_LEFT, false);
+                reply(unique, -EINVAL, NULL, 0);
+                return;
+            }
+            value = remainingNs > 0 ? (int)(remainingNs / 1000000000) : 0;
+            count(CUSE_OP_GET_TIME_LEFT, true);
+            break;
+        }
+        case WDIOC_SETOPTIONS:
+            if (value & WDIOS_DISABLECARD) {
+                ok = !device->running || watchdogExecute(HW_LANE_CONFIG, hwWatchdogStop, &cmd);
+            } else if (value & WDIOS_ENABLECARD) {
+                ok = device->running || watchdogExecute(HW_LANE_CONFIG, hwWatchdogStart, &cmd);
+            }
+            count(CUSE_OP_SET_OPTIONS, ok);
+            value = 0;
+            break;
+        default:
+            count(CUSE_OP_OTHER, false);
+            reply(unique, -ENOTTY, NULL, 0);
+            return;
+    }
+    if (!ok) {
+        reply(unique, cmd.error == watchdogQueueFull ? -EBUSY : -EIO, NULL, 0);
+        return;
+    }
+    replyIoctl(unique, 0, &value, in->out_size >= sizeof(int) ? sizeof(int) : 0);
+}
+
+static void handleInit(uint64_t unique, const struct cuse_init_in *in) {
+    unsigned char out[sizeof(struct cuse_init_out) + sizeof("DEVNAME=") + CUSE_WATCHDOG_NAME_MAX];
+    struct cuse_init_out init;
+    int length;
+
+    if (in->major != FUSE_KERNEL_VERSION) {
+        printf("cuse: kernel speaks FUSE %u, not %u\n", in->major, FUSE_KERNEL_VERSION);
+        reply(unique, -EPROTO, NULL, 0);
+        return;
+    }
+    memset(&init, 0, sizeof(init));
+    init.major = FUSE_KERNEL_VERSION;
+    init.minor = FUSE_KERNEL_MINOR_VERSION;
+    init.max_read = CUSE_MAX_WRITE;
+    init.max_write = CUSE_MAX_WRITE;
+    memcpy(out, &init, sizeof(init));
+    // Device info: NUL-separated KEY=VALUE strings
+    length = snprintf((char *)out + sizeof(init), sizeof(out) - sizeof(init), "DEVNAME=%s", deviceName);
+    reply(unique, 0, out, sizeof(init) + (size_t)length + 1);
+    printf("cuse: /dev/%s serves watchdog %u\n", deviceName,
+           watchdogDefaultDevice() ? watchdogDefaultDevice()->id : 0);
+}
+
+static void handleRequest(size_t length) {
+    const struct fuse_in_header *header = (const struct fuse_in_header *)request;
+    const unsigned char *body = request + sizeof(*header);
+    size_t bodyLength = length - sizeof(*header);
+
+    switch (header->opcode) {
+        case CUSE_INIT:
+            if (bodyLength >= sizeof(struct cuse_init_in)) {
+                handleInit(header->unique, (const struct cuse_init_in *)body);
+            }
+            break;
+        case FUSE_OPEN:
+            handleOpen(header->unique);
+            break;
+        case FUSE_RELEASE:
+            if (bodyLength >= sizeof(struct fuse_release_in)) {
+                handleRelease(header->unique, (const struct fuse_release_in *)body);
+            }
+            break;
+        case FUSE_WRITE:
+            if (bodyLength >= sizeof(struct fuse_write_in)) {
+                handleWrite(header->unique, (const struct fuse_write_in *)body, body + sizeof(struct fuse_write_in),
+                            bodyLength - sizeof(struct fuse_write_in));
+            }
+            break;
+        case FUSE_IOCTL:
+            if (bodyLength >= sizeof(struct fuse_ioctl_in)) {
+                handleIoctl(header->unique, (const struct fuse_ioctl_in *)body, body + sizeof(struct fuse_ioctl_in),
+                            bodyLength - sizeof(struct fuse_ioctl_in));
+            }
+            break;
+        case FUSE_READ:
+            // Reads return nothing, like the kernel drivers
+            reply(header->unique, 0, NULL, 0);
+            break;
+        case FUSE_FLUSH:
+        case FUSE_FSYNC:
+            reply(header->unique, 0, NULL, 0);
+            break;
+        case FUSE_INTERRUPT:
+        case FUSE_FORGET:
+            // Never answered
+            break;
+        default:
+            count(CUSE_OP_OTHER, false);
+            reply(header->unique, -ENOSYS, NULL, 0);
+            break;
+    }
+}
+
+static void* cuseThreadMain(void *arg) {
+    struct pollfd fds[2];
+    (void)arg;
+
+    pthread_setname_np(pthread_self(), "cuse");
+    fds[0].fd = cuseFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = stopFd;
+    fds[1].events = POLLIN;
+    for (;;) {
+        ssize_t length;
+
+        if (poll(fds, 2, -1) < 0) {
+            continue;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+        length = read(cuseFd, request, sizeof(request));
+        if (length < 0) {
+            // ENOENT: interrupted before we read it; ENODEV: unregistered
+            if (errno == ENODEV) {
+                printf("cuse: /dev/%s was removed\n", deviceName);
+                break;
+            }
+            continue;
+        }
+        if ((size_t)length >= sizeof(struct fuse_in_header)) {
+            handleRequest((size_t)length);
+        }
+    }
+    return NULL;
+}
+
+bool cuseWatchdogStart(void) {
+    if (cuseActive || deviceName[0] == '\0') {
+        return true;
+    }
+    cuseFd = open(CUSE_DEVICE, O_RDWR | O_CLOEXEC);
+    if (cuseFd < 0) {
+        printf("cuse: cannot open %s: %s\n", CUSE_DEVICE, strerror(errno));
+        return false;
+    }
+    stopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (stopFd < 0 || pthread_create(&cuseThread, NULL, cuseThreadMain, NULL) != 0) {
+        if (stopFd >= 0) {
+            close(stopFd);
+            stopFd = -1;
+        }
+        close(cuseFd);
+        cuseFd = -1;
+        return false;
+    }
+    cuseActive = true;
+    return true;
+}
+
+void cuseWatchdogStop(void) {
+    uint64_t one = 1;
+
+    if (!cuseActive) {
+        return;
+    }
+    if (write(stopFd, &one, sizeof(one)) != sizeof(one)) {
+        perror("cuse: stop");
+    }
+    pthread_join(cuseThread, NULL);
+    cuseActive = false;
+    // Closing the channel removes the device node
+    close(cuseFd);
+    cuseFd = -1;
+    close(stopFd);
+    stopFd = -1;
+}
+
+void cuseWatchdogCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (deviceName[0] == '\0') {
+        return;
+    }
+    metricsHeader(out, "watchdog_cuse_requests_total", "counter", "Requests on the CUSE watchdog device by operation");
+    for (int op = 0; op < CUSE_OP_COUNT; op++) {
+        strbufAppendf(out, "watchdog_cuse_requests_total{op=\"%s\"} %llu\n", opNames[op],
+                      (unsigned long long)__atomic_load_n(&requests[op], __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_cuse_failed_requests_total", "counter", "CUSE watchdog requests that failed");
+    strbufAppendf(out, "watchdog_cuse_failed_requests_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&failedRequests, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_cuse_unexpected_closes_total", "counter",
+                  "Closes of the CUSE watchdog device without the magic 'V'");
+    strbufAppendf(out, "watchdog_cuse_unexpected_closes_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&unexpectedCloses, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_cuse_open", "gauge", "1 while a process holds the CUSE watchdog device open");
+    strbufAppendf(out, "watchdog_cuse_open %d\n", __atomic_load_n(&deviceOpen, __ATOMIC_RELAXED) ? 1 : 0);
+}
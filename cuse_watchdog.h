@@ -0,0 +1,33 @@
+#ifndef CUSE_WATCHDOG_H
+#define CUSE_WATCHDOG_H
+
+#include <stdbool.h>
+#include "strbuf.h"
+
+#define CUSE_WATCHDOG_NAME_MAX 64
+
+// A /dev/<name> character device, created through CUSE (/dev/cuse, so
+// root or CAP_SYS_ADMIN), that speaks the Linux watchdog API for the timer
+// behind /api/*. The `watchdog` daemon, kubelet hooks and anything else that
+// knows /dev/watchdog feed the SUSI timer without HTTP:
+// - open starts the timer with its configured timings if it is stopped;
+//   one opener at a time, others get EBUSY
+// - any write and WDIOC_KEEPALIVE trigger it
+// - WDIOC_SETTIMEOUT restarts it so a feed buys that many seconds,
+//   WDIOC_GETTIMEOUT and WDIOC_GETTIMELEFT report the current window
+// - WDIOC_SETOPTIONS stops and starts it
+// - closing after writing the magic 'V' stops it, any other close leaves it
+//   running, as the kernel drivers do without nowayout
+// Requests are served on one thread straight from the kernel's queue and
+// run through the same hardware-thread commands as the HTTP API.
+
+// The device name under /dev; false if empty or not a plain name
+bool cuseWatchdogSetName(const char *name);
+// Register the device; does nothing and returns true without a name
+bool cuseWatchdogStart(void);
+// Remove the device; a timer left running keeps running
+void cuseWatchdogStop(void);
+
+void cuseWatchdogCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // CUSE_WATCHDOG_H
@@ -0,0 +1,779 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "diag_dump.h"
+#include "Susi4.h"
+#include "hw_actor.h"
+#include "json_writer.h"
+#include "mem_pool.h"
+#include "metrics.h"
+#include "snapshot.h"
+#include "susi_timing.h"
+#include "timeutil.h"
+
+#define DIAG_LINE_MAX (2 * DIAG_EXTENDED_SIZE + 512)
+#define PCI_CAP_ID_EXPRESS 0x10
+#define PCI_CAP_MAX 48                   // Capability chain entries followed
+
+typedef struct {
+    uint8_t bus;
+    uint8_t device;
+    uint8_t function;
+    bool express;                    // Has a PCI Express capability: 4 KiB of config space
+    uint8_t header[DIAG_HEADER_SIZE];
+} DiagFunction;
+
+// One hardware command of the enumeration: every function of one slot
+typedef struct {
+    uint8_t bus;
+    uint8_t device;
+    SusiStatus_t status;             // Of the first read, to tell "no device" from "no access"
+    uint8_t secondary[8];            // Buses behind the slot's bridges
+    int secondaryCount;
+    uint32_t reads;
+} SlotProbe;
+
+// One hardware command of a dump: up to DIAG_DWORDS_PER_COMMAND dwords
+typedef struct {
+    const DiagFunction *function;
+    uint32_t offsets[DIAG_DWORDS_PER_COMMAND];
+    int count;
+    uint8_t *image;                  // Config-space image, indexed by offset
+    uint32_t errors;
+} ConfigBatch;
+
+typedef struct {
+    uint32_t index;
+    const char *name;
+    bool immutable;                  // Describes the processor, not its state: read once
+} DiagMsrInfo;
+
+typedef struct {
+    uint32_t index[DIAG_MSR_PER_COMMAND];
+    int known[DIAG_MSR_PER_COMMAND]; // Position in msrTable, -1 if not listed there
+    uint64_t value[DIAG_MSR_PER_COMMAND];
+    SusiStatus_t status[DIAG_MSR_PER_COMMAND];
+    bool cached[DIAG_MSR_PER_COMMAND];
+    int count;
+    uint32_t reads;
+} MsrBatch;
+
+typedef enum {
+    DIAG_STREAM_PCI,
+    DIAG_STREAM_MSR,
+    DIAG_STREAM_KIND_COUNT
+} DiagStreamKind;
+
+// A dump in flight, released by MHD with the response
+typedef struct {
+    DiagStreamKind kind;
+    bool extended;
+    bool finished;                   // Summary line rendered
+    int next;                        // Function or MSR of the next line
+    int end;
+    uint32_t msrs[DIAG_MSR_MAX];
+    uint64_t startedNs;
+    uint64_t reads;
+    uint64_t cached;
+    uint64_t errors;
+    uint32_t lines;
+    size_t length;                   // Of the pending text
+    size_t sent;
+    char text[DIAG_LINE_MAX];
+} DiagStream;
+
+static const DiagMsrInfo msrTable[] = {
+    { 0x00000010, "IA32_TIME_STAMP_COUNTER", false },
+    { 0x00000017, "IA32_PLATFORM_ID", true },
+    { 0x0000001b, "IA32_APIC_BASE", true },
+    { 0x0000003a, "IA32_FEATURE_CONTROL", true },     // Locked by the firmware
+    { 0x0000008b, "IA32_BIOS_SIGN_ID", false },       // Microcode can be loaded late
+    { 0x000000ce, "MSR_PLATFORM_INFO", true },
+    { 0x000000fe, "IA32_MTRRCAP", true },
+    { 0x00000198, "IA32_PERF_STATUS", false },
+    { 0x00000199, "IA32_PERF_CTL", false },
+    { 0x0000019c, "IA32_THERM_STATUS", false },
+    { 0x000001a0, "IA32_MISC_ENABLE", false },
+    { 0x000001a2, "MSR_TEMPERATURE_TARGET", true },
+    { 0x000001b1, "IA32_PACKAGE_THERM_STATUS", false },
+    { 0x00000277, "IA32_PAT", false },
+    { 0x000002ff, "IA32_MTRR_DEF_TYPE", false },
+    { 0x00000606, "MSR_RAPL_POWER_UNIT", true },
+    { 0x00000610, "MSR_PKG_POWER_LIMIT", false },
+    { 0x00000611, "MSR_PKG_ENERGY_STATUS", false },
+};
+#define MSR_TABLE_COUNT ((int)(sizeof(msrTable) / sizeof(msrTable[0])))
+
+static DiagFunction functions[DIAG_MAX_FUNCTIONS];
+static int functionCount = 0;
+static uint64_t enumerateNs = 0;
+static uint32_t enumerateReads = 0;
+static bool truncated = false;           // More functions or buses than the tables hold
+
+// Immutable MSRs, filled on the hardware thread the first time they are read
+static uint64_t msrValues[MSR_TABLE_COUNT];
+static bool msrCached[MSR_TABLE_COUNT];
+
+static Snapshot deviceSnapshot;
+static bool snapshotLive = false;
+
+static uint64_t dumps[DIAG_STREAM_KIND_COUNT];
+static uint64_t dwordsRead = 0;
+static uint64_t dwordsCached = 0;        // Served from the enumeration's header
+static uint64_t msrsRead = 0;
+static uint64_t msrsCached = 0;
+static uint64_t readErrors = 0;
+static uint64_t commandsRefused = 0;
+
+// Dumps in flight; a DiagStream holds a whole extended config-space line
+MEM_POOL_DEFINE(diagStreamPool, "diag_stream", sizeof(DiagStream), DIAG_STREAM_POOL);
+
+static SusiStatus_t readConfig(uint8_t bus, uint8_t device, uint8_t function, uint32_t offset, uint8_t *out) {
+    uint64_t start = monotonicNowNs();
+    SusiStatus_t status = SusiBoardReadPCI(bus, device, function, offset, out, 4);
+
+    susiTimingRecord(SUSI_CALL_BOARD_READ_PCI, start, status);
+    return status;
+}
+
+static uint16_t read16(const uint8_t *data, uint32_t offset) {
+    return (uint16_t)(data[offset] | data[offset + 1] << 8);
+}
+
+static bool isBridge(const DiagFunction *function) {
+    return (function->header[0x0e] & 0x7f) == 1;
+}
+
+// The capability structure is fixed by the hardware; only its registers move
+static bool hasExpressCapability(DiagFunction *function, uint32_t *reads) {
+    uint8_t pointer;
+
+    if (!(read16(function->header, 0x06) & 0x10)) {
+        return false;
+    }
+    pointer = function->header[0x34] & 0xfc;
+    for (int i = 0; i < PCI_CAP_MAX && pointer >= DIAG_HEADER_SIZE; i++) {
+        uint8_t entry[4];
+
+        (*reads)++;
+        if (readConfig(function->bus, function->device, function->function, pointer, entry) != SUSI_STATUS_SUCCESS) {
+            return false;
+        }
+        if (entry[0] == PCI_CAP_ID_EXPRESS) {
+            return true;
+        }
+        pointer = entry[1] & 0xfc;
+    }
+    return false;
+}
+
+static void hwProbeSlot(void *arg) {
+    SlotProbe *probe = (SlotProbe *)arg;
+
+    for (uint8_t fn = 0; fn < 8; fn++) {
+        DiagFunction *function;
+        uint8_t id[4];
+        SusiStatus_t status;
+        uint16_t vendor;
+
+        probe->reads++;
+        status = readConfig(probe->bus, probe->device, fn, 0, id);
+        if (fn == 0) {
+            probe->status = status;
+        }
+        vendor = read16(id, 0);
+        if (status != SUSI_STATUS_SUCCESS || vendor == 0xffff || vendor == 0x0000) {
+            if (fn == 0) {
+                return;
+            }
+            continue;
+        }
+        if (functionCount >= DIAG_MAX_FUNCTIONS) {
+            truncated = true;
+            return;
+        }
+        function = &functions[functionCount];
+        memset(function, 0, sizeof(*function));
+        function->bus = probe->bus;
+        function->device = probe->device;
+        function->function = fn;
+        memcpy(function->header, id, sizeof(id));
+        for (uint32_t offset = 4; offset < DIAG_HEADER_SIZE; offset += 4) {
+            probe->reads++;
+            if (readConfig(probe->bus, probe->device, fn, offset, function->header + offset) != SUSI_STATUS_SUCCESS) {
+                memset(function->header + offset, 0xff, 4);
+            }
+        }
+        function->express = hasExpressCapability(function, &probe->reads);
+        functionCount++;
+        if (isBridge(function) && probe->secondaryCount < (int)sizeof(probe->secondary)) {
+            probe->secondary[probe->secondaryCount++] = function->header[0x19];
+        }
+        // Functions 1-7 only exist on multi-function devices
+        if (fn == 0 && !(function->header[0x0e] & 0x80)) {
+            return;
+        }
+    }
+}
+
+static void formatBdf(char *out, size_t size, const DiagFunction *function) {
+    snprintf(out, size, "%02x:%02x.%u", function->bus, function->device, function->function);
+}
+
+static void writeIdentity(JsonWriter *writer, const DiagFunction *function) {
+    char text[16];
+
+    formatBdf(text, sizeof(text), function);
+    jsonFieldString(writer, "bdf", text);
+    snprintf(text, sizeof(text), "%04x", read16(function->header, 0x00));
+    jsonFieldString(writer, "vendor", text);
+    snprintf(text, sizeof(text), "%04x", read16(function->header, 0x02));
+    jsonFieldString(writer, "device", text);
+    snprintf(text, sizeof(text), "%02x%02x%02x", function->header[0x0b], function->header[0x0a], function->header[0x09]);
+    jsonFieldString(writer, "class", text);
+    jsonFieldUint(writer, "revision", function->header[0x08]);
+    jsonFieldUint(writer, "header_type", function->header[0x0e] & 0x7f);
+    jsonFieldBool(writer, "express", function->express);
+}
+
+static void renderDevices(StrBuf *out) {
+    JsonWriter writer;
+    char text[8];
+
+    jsonWriterInit(&writer, out);
+    jsonBeginObject(&writer);
+    jsonFieldUint(&writer, "enumerate_us", enumerateNs / 1000);
+    jsonFieldUint(&writer, "reads", enumerateReads);
+    jsonFieldBool(&writer, "truncated", truncated);
+    jsonKey(&writer, "functions");
+    jsonBeginArray(&writer);
+    for (int i = 0; i < functionCount; i++) {
+        const DiagFunction *function = &functions[i];
+
+        jsonBeginObject(&writer);
+        writeIdentity(&writer, function);
+        if (isBridge(function)) {
+            jsonFieldUint(&writer, "secondary_bus", function->header[0x19]);
+        } else {
+            snprintf(text, sizeof(text), "%04x", read16(function->header, 0x2c));
+            jsonFieldString(&writer, "subsystem_vendor", text);
+            snprintf(text, sizeof(text), "%04x", read16(function->header, 0x2e));
+            jsonFieldString(&writer, "subsystem", text);
+        }
+        jsonEndObject(&writer);
+    }
+    jsonEndArray(&writer);
+    jsonEndObject(&writer);
+    strbufAppendChar(out, '\n');
+}
+
+static bool publishDevices(void) {
+    StrBuf out;
+    size_t capacity;
+    char *data = snapshotBegin(&deviceSnapshot, &capacity);
+
+    if (data == NULL) {
+        return false;
+    }
+    for (;;) {
+        strbufInit(&out, data, capacity);
+        renderDevices(&out);
+        if (!out.overflow) {
+            break;
+        }
+        if (!snapshotGrow(&deviceSnapshot, capacity * 2)) {
+            snapshotAbort(&deviceSnapshot);
+            return false;
+        }
+        data = snapshotBegin(&deviceSnapshot, &capacity);
+        if (data == NULL) {
+            return false;
+        }
+    }
+    return snapshotPublish(&deviceSnapshot, out.length);
+}
+
+// Bus 0 first, then the buses behind each bridge as they are found, one
+// slot per user-lane command
+bool diagDumpInit(void) {
+    uint8_t queue[DIAG_MAX_BUSES];
+    uint64_t visited[4] = { 0 };
+    uint64_t started = monotonicNowNs();
+    int queued = 1;
+    bool readable = false;
+
+    queue[0] = 0;
+    visited[0] = 1;
+    for (int i = 0; i < queued; i++) {
+        for (uint8_t device = 0; device < 32; device++) {
+            SlotProbe probe;
+
+            memset(&probe, 0, sizeof(probe));
+            probe.bus = queue[i];
+            probe.device = device;
+            if (!hwActorCall(HW_LANE_USER, hwProbeSlot, &probe)) {
+                printf("PCI enumeration: hardware queue full\n");
+                return false;
+            }
+            enumerateReads += probe.reads;
+            readable = readable || probe.status == SUSI_STATUS_SUCCESS;
+            for (int j = 0; j < probe.secondaryCount; j++) {
+                uint8_t bus = probe.secondary[j];
+
+                if (visited[bus / 64] & (1ull << (bus % 64))) {
+                    continue;
+                }
+                if (queued >= DIAG_MAX_BUSES) {
+                    truncated = true;
+                    continue;
+                }
+                visited[bus / 64] |= 1ull << (bus % 64);
+                queue[queued++] = bus;
+            }
+        }
+        // Without access on bus 0 the driver cannot read config space at all
+        if (!readable) {
+            return false;
+        }
+    }
+    enumerateNs = monotonicNowNs() - started;
+    if (!snapshotInit(&deviceSnapshot, DIAG_SNAPSHOT_CAPACITY, "application/json", "diag")) {
+        return false;
+    }
+    snapshotLive = true;
+    if (!publishDevices()) {
+        diagDumpDestroy();
+        return false;
+    }
+    printf("PCI: %d function(s) on %d bus(es), enumerated in %llu ms\n", functionCount, queued,
+           (unsigned long long)(enumerateNs / 1000000ull));
+    return true;
+}
+
+void diagDumpDestroy(void) {
+    if (snapshotLive) {
+        snapshotLive = false;
+        snapshotDestroy(&deviceSnapshot);
+    }
+}
+
+enum MHD_Result diagDumpQueueDevices(struct MHD_Connection *connection) {
+    if (!snapshotLive) {
+        return MHD_NO;
+    }
+    return snapshotQueue(&deviceSnapshot, connection);
+}
+
+static void hwReadBatch(void *arg) {
+    ConfigBatch *batch = (ConfigBatch *)arg;
+    const DiagFunction *function = batch->function;
+
+    for (int i = 0; i < batch->count; i++) {
+        uint8_t *out = batch->image + batch->offsets[i];
+
+        if (readConfig(function->bus, function->device, function->function, batch->offsets[i], out) !=
+            SUSI_STATUS_SUCCESS) {
+            memset(out, 0xff, 4);
+            batch->errors++;
+        }
+    }
+}
+
+// Send a filled batch through the user lane; false if it was refused
+static bool flushBatch(DiagStream *stream, ConfigBatch *batch) {
+    if (batch->count == 0) {
+        return true;
+    }
+    if (!hwActorCall(HW_LANE_USER, hwReadBatch, batch)) {
+        __atomic_fetch_add(&commandsRefused, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    stream->reads += (uint64_t)batch->count;
+    stream->errors += batch->errors;
+    __atomic_fetch_add(&dwordsRead, (uint64_t)batch->count, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&readErrors, batch->errors, __ATOMIC_RELAXED);
+    batch->count = 0;
+    batch->errors = 0;
+    return true;
+}
+
+static bool queueOffset(DiagStream *stream, ConfigBatch *batch, uint32_t offset) {
+    batch->offsets[batch->count++] = offset;
+    return batch->count < DIAG_DWORDS_PER_COMMAND || flushBatch(stream, batch);
+}
+
+// The cached header with its live dwords read again, then the rest of the
+// function's config space
+static bool readFunction(DiagStream *stream, const DiagFunction *function, uint8_t *image, uint32_t size) {
+    ConfigBatch batch;
+    uint32_t live = 1;
+
+    memcpy(image, function->header, DIAG_HEADER_SIZE);
+    memset(&batch, 0, sizeof(batch));
+    batch.function = function;
+    batch.image = image;
+    if (!queueOffset(stream, &batch, 0x04)) {
+        return false;
+    }
+    // Secondary status and bridge control
+    if (isBridge(function)) {
+        live += 2;
+        if (!queueOffset(stream, &batch, 0x1c) || !queueOffset(stream, &batch, 0x3c)) {
+            return false;
+        }
+    }
+    for (uint32_t offset = DIAG_HEADER_SIZE; offset < size; offset += 4) {
+        if (!queueOffset(stream, &batch, offset)) {
+            return false;
+        }
+    }
+    if (!flushBatch(stream, &batch)) {
+        return false;
+    }
+    stream->cached += DIAG_HEADER_SIZE / 4 - live;
+    __atomic_fetch_add(&dwordsCached, DIAG_HEADER_SIZE / 4 - live, __ATOMIC_RELAXED);
+    return true;
+}
+
+static void hexEncode(char *out, const uint8_t *data, uint32_t length) {
+    static const char hex[] = "0123456789abcdef";
+
+    for (uint32_t i = 0; i < length; i++) {
+        out[2 * i] = hex[data[i] >> 4];
+        out[2 * i + 1] = hex[data[i] & 0x0f];
+    }
+    out[2 * length] = '\0';
+}
+
+static void renderFunction(DiagStream *stream, StrBuf *out) {
+    const DiagFunction *function = &functions[stream->next];
+    uint32_t size = stream->extended && function->express ? DIAG_EXTENDED_SIZE : DIAG_CONFIG_SIZE;
+    uint8_t image[DIAG_EXTENDED_SIZE];
+    char hexData[2 * DIAG_EXTENDED_SIZE + 1];
+    uint64_t errors = stream->errors;
+    uint64_t started = monotonicNowNs();
+    JsonWriter writer;
+
+    jsonWriterInit(&writer, out);
+    jsonBeginObject(&writer);
+    writeIdentity(&writer, function);
+    if (readFunction(stream, function, image, size)) {
+        jsonFieldUint(&writer, "size", size);
+        hexEncode(hexData, image, size);
+        jsonFieldString(&writer, "config", hexData);
+        jsonFieldUint(&writer, "errors", stream->errors - errors);
+    } else {
+        stream->errors++;
+        jsonFieldString(&writer, "error", "Hardware queue full");
+    }
+    jsonFieldUint(&writer, "read_us", (monotonicNowNs() - started) / 1000);
+    jsonEndObject(&writer);
+    strbufAppendChar(out, '\n');
+    stream->next++;
+    stream->lines++;
+}
+
+static int msrTableFind(uint32_t index) {
+    for (int i = 0; i < MSR_TABLE_COUNT; i++) {
+        if (msrTable[i].index == index) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void hwReadMsrs(void *arg) {
+    MsrBatch *batch = (MsrBatch *)arg;
+
+    for (int i = 0; i < batch->count; i++) {
+        int known = batch->known[i];
+        uint32_t eax = 0, edx = 0;
+        uint64_t start;
+
+        if (known >= 0 && __atomic_load_n(&msrCached[known], __ATOMIC_ACQUIRE)) {
+            batch->value[i] = msrValues[known];
+            batch->status[i] = SUSI_STATUS_SUCCESS;
+            batch->cached[i] = true;
+            continue;
+        }
+        start = monotonicNowNs();
+        batch->status[i] = SusiBoardReadMSR(batch->index[i], &eax, &edx);
+        susiTimingRecord(SUSI_CALL_BOARD_READ_MSR, start, batch->status[i]);
+        batch->reads++;
+        batch->value[i] = (uint64_t)edx << 32 | eax;
+        if (batch->status[i] == SUSI_STATUS_SUCCESS && known >= 0 && msrTable[known].immutable) {
+            msrValues[known] = batch->value[i];
+            __atomic_store_n(&msrCached[known], true, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+// Up to DIAG_MSR_PER_COMMAND MSRs, one line each, in one command; a batch
+// of cached MSRs only does not queue one at all
+static void renderMsrs(DiagStream *stream, StrBuf *out) {
+    MsrBatch batch;
+    bool allCached = true;
+    bool ok = true;
+    JsonWriter writer;
+    char text[24];
+
+    memset(&batch, 0, sizeof(batch));
+    while (batch.count < DIAG_MSR_PER_COMMAND && stream->next + batch.count < stream->end) {
+        int i = batch.count++;
+
+        batch.index[i] = stream->msrs[stream->next + i];
+        batch.known[i] = msrTableFind(batch.index[i]);
+        allCached = allCached && batch.known[i] >= 0 && __atomic_load_n(&msrCached[batch.known[i]], __ATOMIC_ACQUIRE);
+    }
+    if (allCached) {
+        hwReadMsrs(&batch);
+    } else if (!hwActorCall(HW_LANE_USER, hwReadMsrs, &batch)) {
+        __atomic_fetch_add(&commandsRefused, 1, __ATOMIC_RELAXED);
+        ok = false;
+    }
+    for (int i = 0; i < batch.count; i++) {
+        jsonWriterInit(&writer, out);
+        jsonBeginObject(&writer);
+        snprintf(text, sizeof(text), "0x%08x", batch.index[i]);
+        jsonFieldString(&writer, "index", text);
+        if (batch.known[i] >= 0) {
+            jsonFieldString(&writer, "name", msrTable[batch.known[i]].name);
+        }
+        if (!ok) {
+            stream->errors++;
+            jsonFieldString(&writer, "error", "Hardware queue full");
+        } else if (batch.status[i] != SUSI_STATUS_SUCCESS) {
+            stream->errors++;
+            jsonFieldUint(&writer, "status", batch.status[i]);
+        } else {
+            snprintf(text, sizeof(text), "0x%016llx", (unsigned long long)batch.value[i]);
+            jsonFieldString(&writer, "value", text);
+            jsonFieldBool(&writer, "cached", batch.cached[i]);
+            if (batch.cached[i]) {
+                stream->cached++;
+            }
+        }
+        jsonEndObject(&writer);
+        strbufAppendChar(out, '\n');
+        stream->lines++;
+    }
+    stream->reads += batch.reads;
+    __atomic_fetch_add(&msrsRead, batch.reads, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&msrsCached, (uint64_t)batch.count - batch.reads, __ATOMIC_RELAXED);
+    stream->next += batch.count;
+}
+
+static void renderSummary(DiagStream *stream, StrBuf *out) {
+    JsonWriter writer;
+
+    jsonWriterInit(&writer, out);
+    jsonBeginObject(&writer);
+    jsonKey(&writer, "summary");
+    jsonBeginObject(&writer);
+    jsonFieldUint(&writer, "lines", stream->lines);
+    jsonFieldUint(&writer, "reads", stream->reads);
+    jsonFieldUint(&writer, "cached", stream->cached);
+    jsonFieldUint(&writer, "errors", stream->errors);
+    jsonFieldUint(&writer, "duration_us", (monotonicNowNs() - stream->startedNs) / 1000);
+    jsonEndObject(&writer);
+    jsonEndObject(&writer);
+    strbufAppendChar(out, '\n');
+    stream->finished = true;
+}
+
+// Each call reads the next function (or MSR batch) and sends its line; the
+// hardware is only touched once MHD has room for more
+static ssize_t diagReader(void *cls, uint64_t pos, char *buf, size_t max) {
+    DiagStream *stream = cls;
+    size_t length;
+    (void)pos;
+
+    if (stream->sent == stream->length) {
+        StrBuf out;
+
+        if (stream->finished) {
+            return MHD_CONTENT_READER_END_OF_STREAM;
+        }
+        strbufInit(&out, stream->text, sizeof(stream->text));
+        if (stream->next >= stream->end) {
+            renderSummary(stream, &out);
+        } else if (stream->kind == DIAG_STREAM_PCI) {
+            renderFunction(stream, &out);
+        } else {
+            renderMsrs(stream, &out);
+        }
+        if (out.overflow) {
+            return MHD_CONTENT_READER_END_WITH_ERROR;
+        }
+        stream->length = out.length;
+        stream->sent = 0;
+    }
+    length = stream->length - stream->sent;
+    if (length > max) {
+        length = max;
+    }
+    memcpy(buf, stream->text + stream->sent, length);
+    stream->sent += length;
+    return (ssize_t)length;
+}
+
+static void diagReaderFree(void *cls) {
+    memPoolFree(&diagStreamPool, cls);
+}
+
+static DiagStream* streamAlloc(DiagStreamKind kind) {
+    DiagStream *stream = memPoolAlloc(&diagStreamPool, sizeof(DiagStream));
+
+    if (stream == NULL) {
+        return NULL;
+    }
+    // The text buffer is written before it is read
+    memset(stream, 0, offsetof(DiagStream, text));
+    stream->kind = kind;
+    stream->startedNs = monotonicNowNs();
+    return stream;
+}
+
+static enum MHD_Result queueStream(struct MHD_Connection *connection, DiagStream *stream) {
+    struct MHD_Response *response;
+    enum MHD_Result ret;
+
+    response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, DIAG_HTTP_BLOCK, diagReader, stream,
+                                                 diagReaderFree);
+    if (response == NULL) {
+        diagReaderFree(stream);
+        return MHD_NO;
+    }
+    MHD_add_response_header(response, "Content-Type", "application/x-ndjson");
+    MHD_add_response_header(response, "Cache-Control", "no-cache");
+    __atomic_fetch_add(&dumps[stream->kind], 1, __ATOMIC_RELAXED);
+    ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
+    MHD_destroy_response(response);
+    return ret;
+}
+
+static const char* arg(struct MHD_Connection *connection, const char *name) {
+    return MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, name);
+}
+
+enum MHD_Result diagDumpQueuePci(struct MHD_Connection *connection, const char **error) {
+    const char *deviceText = arg(connection, "device");
+    const char *extendedText = arg(connection, "extended");
+    int first = 0, end = functionCount;
+    DiagStream *stream;
+
+    *error = NULL;
+    if (!snapshotLive) {
+        *error = "PCI diagnostics not available";
+        return MHD_NO;
+    }
+    if (deviceText != NULL) {
+        unsigned int bus, device, function;
+        int consumed = 0;
+
+        if (sscanf(deviceText, "%2x:%2x.%1u%n", &bus, &device, &function, &consumed) != 3 ||
+            deviceText[consumed] != '\0') {
+            *error = "Invalid device (expected BB:DD.F)";
+            return MHD_NO;
+        }
+        for (first = 0; first < functionCount; first++) {
+            if (functions[first].bus == bus && functions[first].device == device &&
+                functions[first].function == function) {
+                break;
+            }
+        }
+        if (first == functionCount) {
+            *error = "Unknown PCI function";
+            return MHD_NO;
+        }
+        end = first + 1;
+    }
+    stream = streamAlloc(DIAG_STREAM_PCI);
+    if (stream == NULL) {
+        return MHD_NO;
+    }
+    stream->extended = extendedText != NULL && (strcmp(extendedText, "1") == 0 || strcmp(extendedText, "true") == 0);
+    stream->next = first;
+    stream->end = end;
+    return queueStream(connection, stream);
+}
+
+enum MHD_Result diagDumpQueueMsr(struct MHD_Connection *connection, const char **error) {
+    const char *indexText = arg(connection, "index");
+    uint32_t msrs[DIAG_MSR_MAX];
+    int count = 0;
+    DiagStream *stream;
+
+    *error = NULL;
+    if (indexText == NULL) {
+        for (int i = 0; i < MSR_TABLE_COUNT; i++) {
+            msrs[count++] = msrTable[i].index;
+        }
+    } else {
+        const char *p = indexText;
+
+        while (*p) {
+            unsigned long index;
+            char *end;
+
+            index = strtoul(p, &end, 0);
+            if (end == p || index > UINT32_MAX || (*end != ',' && *end != '\0')) {
+                *error = "Invalid index (expected I[,I...])";
+                return MHD_NO;
+            }
+            if (count >= DIAG_MSR_MAX) {
+                *error = "Too many MSRs";
+                return MHD_NO;
+            }
+            msrs[count++] = (uint32_t)index;
+            p = *end == ',' ? end + 1 : end;
+        }
+        if (count == 0) {
+            *error = "Invalid index (expected I[,I...])";
+            return MHD_NO;
+        }
+    }
+    stream = streamAlloc(DIAG_STREAM_MSR);
+    if (stream == NULL) {
+        return MHD_NO;
+    }
+    memcpy(stream->msrs, msrs, (size_t)count * sizeof(msrs[0]));
+    stream->end = count;
+    return queueStream(connection, stream);
+}
+
+void diagDumpCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (!snapshotLive) {
+        return;
+    }
+    metricsHeader(out, "watchdog_diag_pci_functions", "gauge", "PCI functions found by the enumeration");
+    strbufAppendf(out, "watchdog_diag_pci_functions %d\n", functionCount);
+    metricsHeader(out, "watchdog_diag_dumps_total", "counter", "Diagnostic dumps streamed");
+    strbufAppendf(out, "watchdog_diag_dumps_total{kind=\"pci\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&dumps[DIAG_STREAM_PCI], __ATOMIC_RELAXED));
+    strbufAppendf(out, "watchdog_diag_dumps_total{kind=\"msr\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&dumps[DIAG_STREAM_MSR], __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_diag_pci_dwords_read_total", "counter", "Config-space dwords read by dumps");
+    strbufAppendf(out, "watchdog_diag_pci_dwords_read_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&dwordsRead, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_diag_pci_dwords_cached_total", "counter",
+                  "Config-space dwords answered from the enumeration's headers");
+    strbufAppendf(out, "watchdog_diag_pci_dwords_cached_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&dwordsCached, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_diag_msrs_read_total", "counter", "MSRs read by dumps");
+    strbufAppendf(out, "watchdog_diag_msrs_read_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&msrsRead, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_diag_msrs_cached_total", "counter", "MSRs answered from memory");
+    strbufAppendf(out, "watchdog_diag_msrs_cached_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&msrsCached, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_diag_read_errors_total", "counter", "Config-space reads the driver failed");
+    strbufAppendf(out, "watchdog_diag_read_errors_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&readErrors, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_diag_commands_refused_total", "counter",
+                  "Dump batches refused because the user lane was full");
+    strbufAppendf(out, "watchdog_diag_commands_refused_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&commandsRefused, __ATOMIC_RELAXED));
+}
@@ -0,0 +1,51 @@
+#ifndef DIAG_DUMP_H
+#define DIAG_DUMP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <microhttpd.h>
+#include "build_profile.h"
+#include "strbuf.h"
+
+#define DIAG_MAX_FUNCTIONS 128           // PCI functions kept from the enumeration
+#define DIAG_MAX_BUSES 32                // Buses walked, bus 0 and those behind bridges
+#define DIAG_HEADER_SIZE 64              // Standard header, cached
+#define DIAG_CONFIG_SIZE 256
+#define DIAG_EXTENDED_SIZE 4096          // PCI Express devices with extended=1
+#define DIAG_DWORDS_PER_COMMAND 16       // Config-space reads per hardware command
+#define DIAG_MSR_PER_COMMAND 16
+#define DIAG_MSR_MAX 32                  // Indexes one ?index= list may name
+#define DIAG_HTTP_BLOCK 16384            // Response buffer for the streamed dumps
+#define DIAG_SNAPSHOT_CAPACITY 8192
+
+// Bulk PCI configuration space and MSR dumps for field diagnostics. The
+// PCI tree is enumerated once at startup, bus 0 and every bus behind a
+// bridge, one slot per hardware command, and each function's 64-byte
+// header is kept: identity, class, BARs and the capability chain do not
+// change while the machine is up. A dump then only reads what can change
+// (command/status, the bridge status and control dwords and everything past
+// the header), DIAG_DWORDS_PER_COMMAND dwords per command on the user lane,
+// so a full dump yields to telemetry and never holds the hardware thread
+// for longer than one batch. Results are streamed as newline-delimited
+// JSON, one function or MSR per line, each sent as soon as it is read.
+// MSRs that describe the processor rather than its state are read once and
+// then answered from memory.
+
+// Enumerate the PCI tree through the hardware thread and publish the
+// device list (after hwActorStart). False when config space is not readable.
+bool diagDumpInit(void);
+// Release the snapshot once no response can reference it (after MHD stopped)
+void diagDumpDestroy(void);
+
+// GET /api/diag - The enumerated functions, from the cache
+enum MHD_Result diagDumpQueueDevices(struct MHD_Connection *connection);
+// GET /api/diag/pci[?device=BB:DD.F][&extended=1] - Config space, streamed
+// GET /api/diag/msr[?index=I[,I...]] - MSRs, the default set without index
+// Both return MHD_NO with *error set when the request names something that
+// is not there, and with *error NULL when no stream could be set up.
+enum MHD_Result diagDumpQueuePci(struct MHD_Connection *connection, const char **error);
+enum MHD_Result diagDumpQueueMsr(struct MHD_Connection *connection, const char **error);
+
+void diagDumpCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // DIAG_DUMP_H
@@ -0,0 +1,661 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include "events.h"
+#include "alert_rules.h"
+#include "battery_monitor.h"
+#include "hwm_sampler.h"
+#include "json_writer.h"
+#include "mem_pool.h"
+#include "metrics.h"
+#include "pic_telemetry.h"
+#include "sab2000_alerts.h"
+#include "thermal_monitor.h"
+#include "watchdog.h"
+
+#define EVENT_FRAME_MAX 384
+#define EVENT_BLOCK_SIZE 4096
+
+static const char *eventNames[EVENT_TYPE_COUNT] = {
+    [EVENT_START]           = "start",
+    [EVENT_STOP]            = "stop",
+    [EVENT_TRIGGER]         = "trigger",
+    [EVENT_MISSED_DEADLINE] = "missed_deadline",
+    [EVENT_CONFIGURE]       = "configure",
+    [EVENT_LEASE_EXPIRED]   = "lease_expired",
+    [EVENT_CONFIG_RELOADED] = "config_reloaded",
+    [EVENT_PRETIMEOUT]      = "pretimeout",
+    [EVENT_HWM]             = "hwm",
+    [EVENT_GPIO]            = "gpio",
+    [EVENT_THERMAL]         = "thermal",
+    [EVENT_PIC]             = "pic",
+    [EVENT_IGNITION]        = "ignition",
+    [EVENT_POE]             = "poe",
+    [EVENT_BATTERY]         = "battery",
+    [EVENT_SAB2000]         = "sab2000",
+    [EVENT_IOT]             = "iot",
+    [EVENT_ALERT]           = "alert",
+};
+
+// Seqlock slot: seq holds the event sequence once the record is complete and
+// 0 while it is being rewritten, so readers can detect both torn reads and
+// being lapped by the writer
+typedef struct {
+    uint64_t seq;
+    Event event;
+} EventSlot;
+
+typedef struct {
+    struct MHD_Connection *connection;
+    uint64_t next;                 // Sequence of the next event to send
+    uint64_t heartbeat;            // Heartbeat generation last sent
+    bool greeted;                  // retry: and the initial state were sent
+    bool suspended;                // Parked with MHD_suspend_connection()
+    int index;                     // Position in clients[]
+} EventClient;
+
+static EventSlot ring[EVENT_RING_SIZE];
+static uint64_t head = 0;          // Last published sequence, 0 before the first event
+static pthread_mutex_t publishLock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_mutex_t clientLock = PTHREAD_MUTEX_INITIALIZER;
+static EventClient *clients[EVENT_MAX_CLIENTS];
+MEM_POOL_DEFINE(clientPool, "event_client", sizeof(EventClient), EVENT_MAX_CLIENTS);
+static int clientCount = 0;
+static pthread_cond_t clientWake = PTHREAD_COND_INITIALIZER;
+static int parkedCount = 0;        // Suspended plus blocked subscribers
+static bool blockingReaders = false;
+static bool closing = false;
+
+static pthread_t heartbeatThread;
+static bool heartbeatActive = false;
+static int timerFd = -1;
+static int stopFd = -1;
+static uint64_t heartbeatGeneration = 0;
+
+static uint64_t published[EVENT_TYPE_COUNT];
+static uint64_t lagged = 0;        // Subscribers that fell a full ring behind
+static uint64_t rejected = 0;      // Subscriptions refused because all slots were taken
+
+static uint64_t wallClockMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+// Resume every parked subscriber so it picks up new events or shuts down
+static void wakeClients(void) {
+    pthread_mutex_lock(&clientLock);
+    for (int i = 0; i < clientCount; i++) {
+        if (clients[i]->suspended) {
+            clients[i]->suspended = false;
+            __atomic_sub_fetch(&parkedCount, 1, __ATOMIC_SEQ_CST);
+            MHD_resume_connection(clients[i]->connection);
+        }
+    }
+    pthread_cond_broadcast(&clientWake);
+    pthread_mutex_unlock(&clientLock);
+}
+
+void eventPublish(EventType type, uint32_t watchdogId, uint32_t v0, uint32_t v1, uint32_t v2, uint32_t v3) {
+    EventSlot *slot;
+    uint64_t seq;
+
+    pthread_mutex_lock(&publishLock);
+    seq = head + 1;
+    slot = &ring[seq & (EVENT_RING_SIZE - 1)];
+    __atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&slot->event.type, (uint32_t)type, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->event.watchdogId, watchdogId, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->event.timestampMs, wallClockMs(), __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->event.values[0], v0, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->event.values[1], v1, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->event.values[2], v2, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->event.values[3], v3, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->seq, seq, __ATOMIC_RELEASE);
+    __atomic_store_n(&head, seq, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&publishLock);
+
+    __atomic_fetch_add(&published[type], 1, __ATOMIC_RELAXED);
+    // Pairs with the increment in eventReader: either the reader sees the new
+    // head before parking or we see it parked
+    if (__atomic_load_n(&parkedCount, __ATOMIC_SEQ_CST) > 0) {
+        wakeClients();
+    }
+}
+
+// Copy event seq out of the ring; false if it was overwritten
+static bool readEvent(uint64_t seq, Event *event) {
+    EventSlot *slot = &ring[seq & (EVENT_RING_SIZE - 1)];
+
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != seq) {
+        return false;
+    }
+    event->type = __atomic_load_n(&slot->event.type, __ATOMIC_RELAXED);
+    event->watchdogId = __atomic_load_n(&slot->event.watchdogId, __ATOMIC_RELAXED);
+    event->timestampMs = __atomic_load_n(&slot->event.timestampMs, __ATOMIC_RELAXED);
+    for (int i = 0; i < 4; i++) {
+        event->values[i] = __atomic_load_n(&slot->event.values[i], __ATOMIC_RELAXED);
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq && event->type < EVENT_TYPE_COUNT;
+}
+
+static void writeTimings(JsonWriter *writer, const Event *event) {
+    jsonFieldUint(writer, "delay", event->values[0]);
+    jsonFieldUint(writer, "event", event->values[1]);
+    jsonFieldUint(writer, "reset", event->values[2]);
+    jsonFieldUint(writer, "type", event->values[3]);
+}
+
+static void writeHwmChange(JsonWriter *writer, const Event *event) {
+    static const char *reasons[] = { "first", "moved", "refresh" };
+    const HwmSensor *sensor = hwmSensor((int)event->values[0]);
+
+    if (sensor == NULL) {
+        return;
+    }
+    jsonFieldUint(writer, "sensor", sensor->id);
+    jsonFieldString(writer, "name", sensor->name);
+    jsonFieldString(writer, "kind", hwmKindName(sensor->kind));
+    jsonFieldDouble(writer, "value", hwmScale(sensor->kind, (int32_t)event->values[1]), 3);
+    jsonFieldInt(writer, "raw", (int32_t)event->values[1]);
+    jsonFieldUint(writer, "since_ms", event->values[2]);
+    jsonFieldString(writer, "reason", event->values[3] <= HWM_CHANGE_REFRESH ? reasons[event->values[3]] : "unknown");
+}
+
+static void writeThermalChange(JsonWriter *writer, const Event *event) {
+    const ThermalZone *zone = thermalMonitorZone((SusiId_t)event->values[0]);
+
+    jsonFieldUint(writer, "zone", event->values[0]);
+    jsonFieldString(writer, "state", thermalStateName((ThermalState)event->values[3]));
+    jsonFieldDouble(writer, "temperature", hwmScale(HWM_KIND_TEMPERATURE, (int32_t)event->values[1]), 1);
+    if (zone != NULL) {
+        jsonFieldString(writer, "action", thermalActionName(zone->eventType));
+        jsonFieldDouble(writer, "trip", hwmScale(HWM_KIND_TEMPERATURE, zone->tripRaw), 1);
+    }
+    jsonKey(writer, "seconds_to_trip");
+    if (event->values[2] == THERMAL_NO_FORECAST) {
+        jsonNull(writer);
+    } else {
+        jsonUint(writer, event->values[2]);
+    }
+}
+
+static void writeAlertChange(JsonWriter *writer, const Event *event) {
+    const char *name = alertRuleName(event->values[0]);
+
+    if (name != NULL) {
+        jsonFieldString(writer, "rule", name);
+    } else {
+        jsonFieldUint(writer, "rule_index", event->values[0]);
+    }
+    jsonFieldString(writer, "state", event->values[1] ? "raised" : "cleared");
+    if (!event->values[1]) {
+        jsonFieldUint(writer, "active_ms", event->values[2]);
+    }
+    jsonFieldUint(writer, "raised", event->values[3]);
+}
+
+static void writeSab2000Field(JsonWriter *writer, Sab2000Field field, uint32_t state) {
+    uint32_t value = sab2000FieldValue(state, field);
+
+    if (sab2000FieldIsLed(field)) {
+        jsonString(writer, sab2000LedName(value));
+    } else {
+        jsonBool(writer, value != 0);
+    }
+}
+
+static void writeSab2000Change(JsonWriter *writer, const Event *event) {
+    for (int i = 0; i < SAB2000_FIELD_COUNT; i++) {
+        jsonKey(writer, sab2000FieldName((Sab2000Field)i));
+        writeSab2000Field(writer, (Sab2000Field)i, event->values[0]);
+    }
+    jsonKey(writer, "changed");
+    jsonBeginObject(writer);
+    for (int i = 0; i < SAB2000_FIELD_COUNT; i++) {
+        if (event->values[2] & (1u << i)) {
+            jsonKey(writer, sab2000FieldName((Sab2000Field)i));
+            writeSab2000Field(writer, (Sab2000Field)i, event->values[1]);
+        }
+    }
+    jsonEndObject(writer);
+}
+
+const char* eventName(uint32_t type) {
+    return type < EVENT_TYPE_COUNT ? eventNames[type] : "unknown";
+}
+
+void eventWriteFields(JsonWriter *writer, const Event *event) {
+    if (event->watchdogId != EVENT_NO_WATCHDOG) {
+        jsonFieldUint(writer, "watchdog_id", event->watchdogId);
+    }
+    jsonFieldUint(writer, "timestamp_ms", event->timestampMs);
+    switch (event->type) {
+    case EVENT_START:
+    case EVENT_CONFIGURE:
+        writeTimings(writer, event);
+        break;
+    case EVENT_TRIGGER:
+        jsonFieldUint(writer, "feed_count", event->values[0]);
+        jsonFieldInt(writer, "slack_ms", (int32_t)event->values[1]);
+        break;
+    case EVENT_MISSED_DEADLINE:
+        jsonFieldUint(writer, "late_ms", event->values[0]);
+        break;
+    case EVENT_LEASE_EXPIRED:
+        jsonFieldUint(writer, "lease_id", event->values[0]);
+        break;
+    case EVENT_CONFIG_RELOADED:
+        jsonFieldUint(writer, "generation", event->values[0]);
+        break;
+    case EVENT_PRETIMEOUT:
+        jsonFieldUint(writer, "pretimeout_count", event->values[0]);
+        jsonFieldInt(writer, "remaining_to_reset_ms", (int32_t)event->values[1]);
+        jsonFieldUint(writer, "latency_us", event->values[2]);
+        jsonFieldUint(writer, "bounces", event->values[3]);
+        break;
+    case EVENT_HWM:
+        writeHwmChange(writer, event);
+        break;
+    case EVENT_GPIO:
+        jsonFieldUint(writer, "gpio", event->values[0]);
+        jsonFieldUint(writer, "sequence", event->values[1]);
+        jsonFieldUint(writer, "latency_us", event->values[2]);
+        jsonFieldUint(writer, "bounces", event->values[3]);
+        break;
+    case EVENT_THERMAL:
+        writeThermalChange(writer, event);
+        break;
+    case EVENT_PIC:
+        jsonFieldString(writer, "field", picFieldName((PicField)event->values[0]));
+        jsonFieldDouble(writer, "value", picFieldScale((PicField)event->values[0], event->values[1]), 1);
+        jsonKey(writer, "previous");
+        if (event->values[3]) {
+            jsonDouble(writer, picFieldScale((PicField)event->values[0], event->values[2]), 1);
+        } else {
+            jsonNull(writer);
+        }
+        break;
+    case EVENT_IGNITION:
+        jsonFieldUint(writer, "level", event->values[0]);
+        jsonFieldUint(writer, "latency_us", event->values[1]);
+        jsonFieldUint(writer, "bounces", event->values[2]);
+        jsonFieldBool(writer, "shutdown", event->values[3] != 0);
+        break;
+    case EVENT_POE:
+        jsonFieldDouble(writer, "total_watts", (double)event->values[0] / 1000.0, 3);
+        jsonFieldDouble(writer, "budget_watts", (double)event->values[1] / 1000.0, 3);
+        jsonFieldBool(writer, "over_budget", event->values[2] != 0);
+        jsonFieldUint(writer, "ports", event->values[3]);
+        break;
+    case EVENT_BATTERY:
+        jsonFieldString(writer, "alarm", batteryAlarmName((BatteryAlarm)event->values[0]));
+        jsonKey(writer, "seconds_to_empty");
+        if (event->values[1] == BATTERY_NO_ESTIMATE) {
+            jsonNull(writer);
+        } else {
+            jsonUint(writer, event->values[1]);
+        }
+        jsonFieldInt(writer, "current_ma", (int32_t)event->values[2]);
+        jsonFieldUint(writer, "charge_percent", event->values[3]);
+        break;
+    case EVENT_SAB2000:
+        writeSab2000Change(writer, event);
+        break;
+    case EVENT_IOT:
+        jsonFieldUint(writer, "id", event->values[0]);
+        break;
+    case EVENT_ALERT:
+        writeAlertChange(writer, event);
+        break;
+    }
+}
+
+static void formatEvent(StrBuf *out, uint64_t seq, const Event *event) {
+    JsonWriter writer;
+
+    strbufAppendf(out, "id: %llu\nevent: %s\ndata: ", (unsigned long long)seq, eventNames[event->type]);
+    jsonWriterInit(&writer, out);
+    jsonBeginObject(&writer);
+    eventWriteFields(&writer, event);
+    jsonEndObject(&writer);
+    strbufAppend(out, "\n\n");
+}
+
+// First frames of a stream: the reconnect delay and the current state of
+// every timer, so a dashboard needs no extra /api/status request
+static void formatGreeting(StrBuf *out) {
+    JsonWriter writer;
+
+    strbufAppendf(out, "retry: %d\n\n", EVENT_RETRY_MS);
+    for (SusiId_t id = 0; id < WATCHDOG_MAX_DEVICES; id++) {
+        WatchdogDevice *device = watchdogDevice(id);
+
+        if (!device->present) {
+            continue;
+        }
+        strbufAppend(out, "event: state\ndata: ");
+        jsonWriterInit(&writer, out);
+        jsonBeginObject(&writer);
+        watchdogWriteStatus(&writer, device);
+        jsonEndObject(&writer);
+        strbufAppend(out, "\n\n");
+    }
+}
+
+static bool appendFrame(char *buf, size_t max, size_t *used, const StrBuf *frame) {
+    if (frame->overflow || *used + frame->length > max) {
+        return false;
+    }
+    memcpy(buf + *used, frame->data, frame->length);
+    *used += frame->length;
+    return true;
+}
+
+// True once there is something to send: call with clientLock held and the
+// caller counted in parkedCount
+static bool clientHasWork(const EventClient *client, uint64_t beat) {
+    return client->next <= __atomic_load_n(&head, __ATOMIC_SEQ_CST) ||
+           beat != __atomic_load_n(&heartbeatGeneration, __ATOMIC_RELAXED) ||
+           __atomic_load_n(&closing, __ATOMIC_ACQUIRE);
+}
+
+// Wait for work. With one thread per connection the reader simply blocks;
+// in the polling modes the connection is suspended and MHD calls the reader
+// again once it is resumed. Returns true if the reader should run again now.
+static bool parkClient(EventClient *client, uint64_t beat) {
+    bool again = true;
+
+    pthread_mutex_lock(&clientLock);
+    __atomic_add_fetch(&parkedCount, 1, __ATOMIC_SEQ_CST);
+    if (blockingReaders) {
+        while (!clientHasWork(client, beat)) {
+            pthread_cond_wait(&clientWake, &clientLock);
+        }
+        __atomic_sub_fetch(&parkedCount, 1, __ATOMIC_SEQ_CST);
+    } else if (clientHasWork(client, beat)) {
+        __atomic_sub_fetch(&parkedCount, 1, __ATOMIC_SEQ_CST);
+    } else {
+        client->suspended = true;
+        MHD_suspend_connection(client->connection);
+        again = false;
+    }
+    pthread_mutex_unlock(&clientLock);
+    return again;
+}
+
+static ssize_t eventReader(void *cls, uint64_t pos, char *buf, size_t max) {
+    EventClient *client = cls;
+    char frameData[EVENT_FRAME_MAX];
+    char greeting[EVENT_BLOCK_SIZE];
+    StrBuf frame;
+    size_t used = 0;
+    uint64_t beat;
+    Event event;
+    (void)pos;
+
+retry:
+    if (__atomic_load_n(&closing, __ATOMIC_ACQUIRE)) {
+        return MHD_CONTENT_READER_END_OF_STREAM;
+    }
+    if (!client->greeted) {
+        strbufInit(&frame, greeting, sizeof(greeting));
+        formatGreeting(&frame);
+        if (!appendFrame(buf, max, &used, &frame)) {
+            return 0;
+        }
+        client->greeted = true;
+    }
+
+    beat = __atomic_load_n(&heartbeatGeneration, __ATOMIC_RELAXED);
+    if (beat != client->heartbeat && used + 2 <= max) {
+        memcpy(buf + used, ":\n", 2);
+        used += 2;
+        client->heartbeat = beat;
+    }
+
+    while (client->next <= __atomic_load_n(&head, __ATOMIC_ACQUIRE)) {
+        strbufInit(&frame, frameData, sizeof(frameData));
+        if (!readEvent(client->next, &event)) {
+            // Lapped by the writer: tell the client and skip to the oldest
+            // event still in the ring
+            uint64_t now = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+            uint64_t oldest = now >= EVENT_RING_SIZE ? now - EVENT_RING_SIZE + 2 : 1;
+
+            strbufAppendf(&frame, "event: lagged\ndata: {\"missed\":%llu}\n\n",
+                          (unsigned long long)(oldest - client->next));
+            if (!appendFrame(buf, max, &used, &frame)) {
+                break;
+            }
+            __atomic_fetch_add(&lagged, 1, __ATOMIC_RELAXED);
+            client->next = oldest;
+            continue;
+        }
+        formatEvent(&frame, client->next, &event);
+        if (!appendFrame(buf, max, &used, &frame)) {
+            break;
+        }
+        client->next++;
+    }
+    if (used > 0) {
+        return (ssize_t)used;
+    }
+
+    // Nothing to send: park the connection until the next publish
+    if (parkClient(client, beat)) {
+        goto retry;
+    }
+    return 0;
+}
+
+uint64_t eventsNext(void) {
+    return __atomic_load_n(&head, __ATOMIC_ACQUIRE) + 1;
+}
+
+uint32_t eventsRingUsed(void) {
+    uint64_t published = __atomic_load_n(&head, __ATOMIC_RELAXED);
+
+    return published < EVENT_RING_SIZE ? (uint32_t)published : EVENT_RING_SIZE;
+}
+
+int eventsSubscribers(void) {
+    int subscribers;
+
+    pthread_mutex_lock(&clientLock);
+    subscribers = clientCount;
+    pthread_mutex_unlock(&clientLock);
+    return subscribers;
+}
+
+bool eventsRead(uint64_t *next, Event *event, uint64_t *missed) {
+    while (*next <= __atomic_load_n(&head, __ATOMIC_ACQUIRE)) {
+        uint64_t now, oldest;
+
+        if (readEvent(*next, event)) {
+            (*next)++;
+            return true;
+        }
+        // Lapped, as in eventReader
+        now = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+        oldest = now >= EVENT_RING_SIZE ? now - EVENT_RING_SIZE + 2 : 1;
+        if (oldest <= *next) {
+            oldest = *next + 1;
+        }
+        *missed += oldest - *next;
+        *next = oldest;
+    }
+    return false;
+}
+
+static void eventClientFree(void *cls) {
+    EventClient *client = cls;
+
+    pthread_mutex_lock(&clientLock);
+    clientCount--;
+    clients[client->index] = clients[clientCount];
+    clients[client->index]->index = client->index;
+    if (client->suspended) {
+        __atomic_sub_fetch(&parkedCount, 1, __ATOMIC_SEQ_CST);
+    }
+    pthread_mutex_unlock(&clientLock);
+    memPoolFree(&clientPool, client);
+}
+
+enum MHD_Result eventsQueueStream(struct MHD_Connection *connection) {
+    const char *lastId = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, "Last-Event-ID");
+    uint64_t current = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    struct MHD_Response *response;
+    EventClient *client;
+    enum MHD_Result ret;
+
+    // An empty pool (no-heap builds) is answered like a full client table
+    client = memPoolAlloc(&clientPool, sizeof(*client));
+    if (client != NULL) {
+        memset(client, 0, sizeof(*client));
+        client->connection = connection;
+        client->heartbeat = __atomic_load_n(&heartbeatGeneration, __ATOMIC_RELAXED);
+        client->next = current + 1;
+        // Resume after the last event the browser saw if it is still buffered
+        if (lastId != NULL) {
+            uint64_t seen = strtoull(lastId, NULL, 10);
+
+            if (seen <= current && current - seen < EVENT_RING_SIZE) {
+                client->next = seen + 1;
+            }
+        }
+    }
+
+    pthread_mutex_lock(&clientLock);
+    if (client == NULL || closing || clientCount >= EVENT_MAX_CLIENTS) {
+        pthread_mutex_unlock(&clientLock);
+        memPoolFree(&clientPool, client);
+        __atomic_fetch_add(&rejected, 1, __ATOMIC_RELAXED);
+        response = MHD_create_response_from_buffer(0, NULL, MHD_RESPMEM_PERSISTENT);
+        if (response == NULL) {
+            return MHD_NO;
+        }
+        MHD_add_response_header(response, "Retry-After", "5");
+        ret = MHD_queue_response(connection, MHD_HTTP_SERVICE_UNAVAILABLE, response);
+        MHD_destroy_response(response);
+        return ret;
+    }
+    client->index = clientCount;
+    clients[clientCount++] = client;
+    pthread_mutex_unlock(&clientLock);
+
+    response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, EVENT_BLOCK_SIZE, eventReader, client,
+                                                 eventClientFree);
+    if (response == NULL) {
+        eventClientFree(client);
+        return MHD_NO;
+    }
+    MHD_add_response_header(response, "Content-Type", "text/event-stream");
+    MHD_add_response_header(response, "Cache-Control", "no-cache");
+    MHD_add_response_header(response, "X-Accel-Buffering", "no");
+    ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
+    MHD_destroy_response(response);
+    return ret;
+}
+
+static void* heartbeatThreadMain(void *arg) {
+    struct pollfd fds[2];
+    uint64_t expirations;
+    (void)arg;
+
+    pthread_setname_np(pthread_self(), "events");
+    fds[0].fd = timerFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = stopFd;
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            continue;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+        if ((fds[0].revents & POLLIN) && read(timerFd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+            __atomic_fetch_add(&heartbeatGeneration, 1, __ATOMIC_RELAXED);
+            wakeClients();
+        }
+    }
+    return NULL;
+}
+
+bool eventsStart(bool blocking) {
+    struct itimerspec spec;
+    
+    blockingReaders = blocking;
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    stopFd = eventfd(0, EFD_CLOEXEC);
+    if (timerFd < 0 || stopFd < 0) {
+        perror("events: timerfd/eventfd");
+        eventsStop();
+        return false;
+    }
+    memset(&spec, 0, sizeof(spec));
+    spec.it_interval.tv_sec = EVENT_HEARTBEAT_MS / 1000;
+    spec.it_interval.tv_nsec = (long)(EVENT_HEARTBEAT_MS % 1000) * 1000000L;
+    spec.it_value = spec.it_interval;
+    if (timerfd_settime(timerFd, 0, &spec, NULL) != 0 ||
+        pthread_create(&heartbeatThread, NULL, heartbeatThreadMain, NULL) != 0) {
+        perror("events: heartbeat");
+        eventsStop();
+        return false;
+    }
+    heartbeatActive = true;
+    return true;
+}
+
+void eventsStop(void) {
+    uint64_t one = 1;
+
+    __atomic_store_n(&closing, true, __ATOMIC_RELEASE);
+    wakeClients();
+    if (heartbeatActive) {
+        if (write(stopFd, &one, sizeof(one)) != sizeof(one)) {
+            perror("events: stop");
+        }
+        pthread_join(heartbeatThread, NULL);
+        heartbeatActive = false;
+    }
+    if (timerFd >= 0) {
+        close(timerFd);
+        timerFd = -1;
+    }
+    if (stopFd >= 0) {
+        close(stopFd);
+        stopFd = -1;
+    }
+}
+
+void eventsCollectMetrics(StrBuf *out, void *ctx) {
+    int subscribers = eventsSubscribers();
+    (void)ctx;
+
+    metricsHeader(out, "watchdog_events_published_total", "counter", "Events published to /api/events");
+    for (int i = 0; i < EVENT_TYPE_COUNT; i++) {
+        strbufAppendf(out, "watchdog_events_published_total{type=\"%s\"} %llu\n", eventNames[i],
+                      (unsigned long long)__atomic_load_n(&published[i], __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_event_subscribers", "gauge", "Open /api/events streams");
+    strbufAppendf(out, "watchdog_event_subscribers %d\n", subscribers);
+    metricsHeader(out, "watchdog_event_subscribers_lagged_total", "counter",
+                  "Times a subscriber fell a full ring behind and skipped events");
+    strbufAppendf(out, "watchdog_event_subscribers_lagged_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&lagged, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_event_subscribers_rejected_total", "counter",
+                  "Subscriptions refused because the subscriber limit was reached");
+    strbufAppendf(out, "watchdog_event_subscribers_rejected_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&rejected, __ATOMIC_RELAXED));
+}
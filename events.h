@@ -0,0 +1,86 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <microhttpd.h>
+#include "json_writer.h"
+#include "strbuf.h"
+#include "build_profile.h"
+
+#ifndef EVENT_RING_SIZE
+#define EVENT_RING_SIZE 1024         // Must be a power of two
+#endif
+#ifndef EVENT_MAX_CLIENTS
+#define EVENT_MAX_CLIENTS 64
+#endif
+#define EVENT_HEARTBEAT_MS 15000     // Comment line that keeps idle proxies open
+#define EVENT_RETRY_MS 3000          // Reconnect delay suggested to browsers
+#define EVENT_NO_WATCHDOG 0xffffffffu
+
+// State changes pushed to GET /api/events (text/event-stream). Publishers
+// write fixed-size records into one ring; every subscriber keeps its own
+// cursor and formats frames itself, so publishing costs the same with one
+// dashboard or fifty. Idle subscribers are MHD-suspended and resumed on the
+// next publish, so they use no CPU between events.
+
+typedef enum {
+    EVENT_START,             // values: delay, event, reset, type
+    EVENT_STOP,
+    EVENT_TRIGGER,           // values: feed count (low 32 bits), slack ms
+    EVENT_MISSED_DEADLINE,   // values: ms late
+    EVENT_CONFIGURE,         // values: delay, event, reset, type
+    EVENT_LEASE_EXPIRED,     // values: lease id
+    EVENT_CONFIG_RELOADED,   // values: configuration generation
+    EVENT_PRETIMEOUT,        // values: count, ms left to reset, dispatch latency us
+    EVENT_HWM,               // values: sensor slot, raw value, ms since its last event, HwmChangeReason
+    EVENT_GPIO,              // values: GPIO id, event number, interrupt to publish latency us
+    EVENT_THERMAL,           // values: thermal zone, raw temperature, seconds to trip, ThermalState
+    EVENT_PIC,               // values: PicField, raw value, previous raw value, 1 if there was a previous value
+    EVENT_IGNITION,          // values: new level, us since the last read of the old level, bounces, 1 if shutting down
+    EVENT_POE,               // values: total mW, budget mW, 1 if over budget, port count
+    EVENT_BATTERY,           // values: BatteryAlarm, seconds to empty (BATTERY_NO_ESTIMATE if none), smoothed mA (int32), charge %
+    EVENT_SAB2000,           // values: packed state, previous state, mask of changed Sab2000Field
+    EVENT_IOT,               // values: IoT ID that changed
+    EVENT_ALERT,             // values: rule index, 1 if raised, ms it was raised for (on clearing), times raised
+    EVENT_TYPE_COUNT
+} EventType;
+
+typedef struct {
+    uint32_t type;
+    uint32_t watchdogId;     // EVENT_NO_WATCHDOG for events not tied to a timer
+    uint64_t timestampMs;    // Wall clock, filled in by eventPublish()
+    uint32_t values[4];
+} Event;
+
+// Thread-safe; never blocks on subscribers
+void eventPublish(EventType type, uint32_t watchdogId, uint32_t v0, uint32_t v1, uint32_t v2, uint32_t v3);
+
+// blocking selects how idle streams wait: true for one thread per
+// connection, false to suspend connections in the polling modes (the daemon
+// then needs MHD_ALLOW_SUSPEND_RESUME)
+bool eventsStart(bool blocking);
+// Ends every stream and stops the heartbeat; call before MHD_stop_daemon()
+void eventsStop(void);
+
+// Handle GET /api/events; honours Last-Event-ID while it is still in the ring
+enum MHD_Result eventsQueueStream(struct MHD_Connection *connection);
+
+// In-process readers such as the MQTT bridge keep their own cursor, the
+// sequence of the next event to read, starting at eventsNext(). eventsRead()
+// copies that event out and advances; false once caught up. Events the ring
+// overwrote before the reader got to them are skipped and added to *missed.
+uint64_t eventsNext(void);
+bool eventsRead(uint64_t *next, Event *event, uint64_t *missed);
+
+const char* eventName(uint32_t type);
+// The fields of the event's data: object, into an object the caller opened
+void eventWriteFields(JsonWriter *writer, const Event *event);
+
+// Ring slots holding an event, of EVENT_RING_SIZE, and open streams
+uint32_t eventsRingUsed(void);
+int eventsSubscribers(void);
+
+void eventsCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // EVENTS_H
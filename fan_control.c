@@ -0,0 +1,501 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fan_control.h"
+#include "hw_actor.h"
+#include "hwm_sampler.h"
+#include "metrics.h"
+#include "susi_caps.h"
+#include "susi_timing.h"
+#include "timeutil.h"
+
+#define FAN_SPEC_FIELDS 9
+#define FAN_MAX_DT_S 60.0                // Longer gaps (sampler backed off, reads failed) count as this
+#define FAN_CURVE_FRACTION_BITS 8        // Table duties are percent in Q8.8
+#define FAN_RAW_ZERO_CELSIUS 2731        // Raw temperature (0.1 K) of 0 degrees, as hwmScale() converts it
+
+// A compiled curve: entry i is the duty at baseRaw + 10 * i
+typedef struct {
+    int32_t baseRaw;
+    int32_t entries;
+    uint16_t duty[FAN_CURVE_MAX_SPAN + 1];
+} FanCurve;
+
+typedef struct {
+    FanLoopStatus status;
+    SusiFanControl saved;            // Configuration before the loop took over
+    bool restore;
+    bool hysteresisHigh;
+    double lastTemperature;
+    uint64_t lastSampleMs;           // 0 until the first reading
+    FanCurve curve;
+} FanLoop;
+
+// One SusiFanControlSetConfig, run on the hardware thread
+typedef struct {
+    SusiId_t fan;
+    SusiFanControl *config;
+    SusiStatus_t status;
+} FanCommand;
+
+// Checks one fan before its loop starts
+typedef struct {
+    SusiId_t fan;
+    uint32_t controlFlags;
+    SusiFanControl config;
+    SusiStatus_t status;
+} FanProbe;
+
+static FanLoop loops[FAN_CONTROL_MAX_LOOPS];
+static int loopCount;
+static bool controlRunning;
+// Held across a loop's update and write, so fanControlStop() cannot restore
+// a fan between the two
+static pthread_mutex_t loopLock = PTHREAD_MUTEX_INITIALIZER;
+
+static bool parseNumber(const char *text, double *value) {
+    char *end;
+
+    if (text == NULL || *text == '\0') {
+        return false;
+    }
+    *value = strtod(text, &end);
+    return *end == '\0' && isfinite(*value);
+}
+
+static bool parseIndex(const char *text, int limit, int *value) {
+    double number;
+
+    if (!parseNumber(text, &number) || number < 0 || number >= limit || number != floor(number)) {
+        return false;
+    }
+    *value = (int)number;
+    return true;
+}
+
+static bool parseDuty(const char *text, uint32_t *value) {
+    double number;
+
+    if (!parseNumber(text, &number) || number < 0 || number > 100 || number != floor(number)) {
+        return false;
+    }
+    *value = (uint32_t)number;
+    return true;
+}
+
+// "DEG=DUTY,DEG=DUTY,...": whole degrees, strictly ascending
+static bool parseCurve(char *text, FanLoopConfig *config) {
+    char *save = NULL, *point;
+    double temperature;
+    uint32_t duty;
+
+    config->points = 0;
+    config->minDuty = 100;
+    config->maxDuty = 0;
+    for (point = strtok_r(text, ",", &save); point != NULL; point = strtok_r(NULL, ",", &save)) {
+        char *equals = strchr(point, '=');
+
+        if (equals == NULL || config->points == FAN_CURVE_MAX_POINTS) {
+            return false;
+        }
+        *equals = '\0';
+        if (!parseNumber(point, &temperature) || temperature != floor(temperature) ||
+            temperature < -FAN_CURVE_MAX_SPAN || temperature > FAN_CURVE_MAX_SPAN || !parseDuty(equals + 1, &duty)) {
+            return false;
+        }
+        if (config->points > 0 && temperature <= config->pointTemperature[config->points - 1]) {
+            return false;
+        }
+        config->pointTemperature[config->points] = (int16_t)temperature;
+        config->pointDuty[config->points] = (uint8_t)duty;
+        config->points++;
+        if (duty < config->minDuty) {
+            config->minDuty = duty;
+        }
+        if (duty > config->maxDuty) {
+            config->maxDuty = duty;
+        }
+    }
+    return config->points >= 2 &&
+           config->pointTemperature[config->points - 1] - config->pointTemperature[0] <= FAN_CURVE_MAX_SPAN;
+}
+
+// One table entry per whole degree from the first point to the last
+static void compileCurve(const FanLoopConfig *config, FanCurve *curve) {
+    int segment = 0;
+
+    curve->baseRaw = FAN_RAW_ZERO_CELSIUS + 10 * config->pointTemperature[0];
+    curve->entries = config->pointTemperature[config->points - 1] - config->pointTemperature[0] + 1;
+    for (int i = 0; i < curve->entries; i++) {
+        int temperature = config->pointTemperature[0] + i;
+        int32_t t0, t1, d0, d1;
+
+        while (temperature > config->pointTemperature[segment + 1]) {
+            segment++;
+        }
+        t0 = config->pointTemperature[segment];
+        t1 = config->pointTemperature[segment + 1];
+        d0 = (int32_t)config->pointDuty[segment] << FAN_CURVE_FRACTION_BITS;
+        d1 = (int32_t)config->pointDuty[segment + 1] << FAN_CURVE_FRACTION_BITS;
+        curve->duty[i] = (uint16_t)(d0 + ((d1 - d0) * (temperature - t0) + (t1 - t0) / 2) / (t1 - t0));
+    }
+}
+
+// Duty for a raw reading: one lookup, interpolated by the tenths of a degree
+static uint32_t curveLookup(const FanCurve *curve, int32_t raw) {
+    int32_t offset = raw - curve->baseRaw;
+    int32_t index = offset / 10, duty;
+
+    if (offset <= 0) {
+        duty = curve->duty[0];
+    } else if (index >= curve->entries - 1) {
+        duty = curve->duty[curve->entries - 1];
+    } else {
+        duty = curve->duty[index] + ((curve->duty[index + 1] - curve->duty[index]) * (offset % 10)) / 10;
+    }
+    return (uint32_t)((duty + (1 << (FAN_CURVE_FRACTION_BITS - 1))) >> FAN_CURVE_FRACTION_BITS);
+}
+
+bool fanControlAddSpec(const char *spec) {
+    char copy[128];
+    char *fields[FAN_SPEC_FIELDS];
+    char *save = NULL, *field;
+    int count = 0, fan, sensor;
+    FanLoopConfig config;
+
+    if (controlRunning || loopCount >= FAN_CONTROL_MAX_LOOPS || strlen(spec) >= sizeof(copy)) {
+        return false;
+    }
+    strcpy(copy, spec);
+    for (field = strtok_r(copy, ":", &save); field != NULL; field = strtok_r(NULL, ":", &save)) {
+        if (count == FAN_SPEC_FIELDS) {
+            return false;
+        }
+        fields[count++] = field;
+    }
+    if (count < 4 || !parseIndex(fields[0], SUSI_ID_HWM_FAN_MAX, &fan) ||
+        !parseIndex(fields[1], SUSI_ID_HWM_TEMP_MAX, &sensor)) {
+        return false;
+    }
+
+    memset(&config, 0, sizeof(config));
+    config.fan = (SusiId_t)(SUSI_ID_HWM_FAN_BASE + fan);
+    config.sensorSlot = sensor;
+    if (strcmp(fields[2], "pid") == 0) {
+        config.kind = FAN_LOOP_PID;
+        config.kp = FAN_CONTROL_DEFAULT_KP;
+        config.ki = FAN_CONTROL_DEFAULT_KI;
+        config.kd = FAN_CONTROL_DEFAULT_KD;
+        config.minDuty = FAN_CONTROL_DEFAULT_MIN_DUTY;
+        config.maxDuty = FAN_CONTROL_DEFAULT_MAX_DUTY;
+        if ((count != 4 && count != 7 && count != 9) || !parseNumber(fields[3], &config.setpoint)) {
+            return false;
+        }
+        if (count >= 7 && (!parseNumber(fields[4], &config.kp) || !parseNumber(fields[5], &config.ki) ||
+                           !parseNumber(fields[6], &config.kd) || config.kp < 0 || config.ki < 0 || config.kd < 0)) {
+            return false;
+        }
+        if (count == 9 && (!parseDuty(fields[7], &config.minDuty) || !parseDuty(fields[8], &config.maxDuty))) {
+            return false;
+        }
+        if (config.minDuty > config.maxDuty) {
+            return false;
+        }
+    } else if (strcmp(fields[2], "hyst") == 0) {
+        config.kind = FAN_LOOP_HYSTERESIS;
+        if (count != 7 || !parseNumber(fields[3], &config.low) || !parseNumber(fields[4], &config.high) ||
+            !parseDuty(fields[5], &config.lowDuty) || !parseDuty(fields[6], &config.highDuty) ||
+            config.low >= config.high) {
+            return false;
+        }
+    } else if (strcmp(fields[2], "curve") == 0) {
+        config.kind = FAN_LOOP_CURVE;
+        if (count != 4 || !parseCurve(fields[3], &config)) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    // One loop per fan; two would fight over its duty
+    for (int i = 0; i < loopCount; i++) {
+        if (loops[i].status.config.fan == config.fan) {
+            return false;
+        }
+    }
+    memset(&loops[loopCount], 0, sizeof(loops[loopCount]));
+    loops[loopCount].status.config = config;
+    loops[loopCount].status.temperature = NAN;
+    loops[loopCount].status.duty = -1;
+    if (config.kind == FAN_LOOP_CURVE) {
+        compileCurve(&config, &loops[loopCount].curve);
+    }
+    loopCount++;
+    return true;
+}
+
+int fanControlLoopCount(void) {
+    return loopCount;
+}
+
+bool fanControlOwns(SusiId_t fan) {
+    bool owned = false;
+
+    pthread_mutex_lock(&loopLock);
+    for (int i = 0; i < loopCount; i++) {
+        owned |= loops[i].status.running && loops[i].status.config.fan == fan;
+    }
+    pthread_mutex_unlock(&loopLock);
+    return owned;
+}
+
+static void hwProbeFan(void *arg) {
+    FanProbe *probe = arg;
+    uint64_t start;
+
+    probe->status = susiCapsGet(SUSI_CAPS_FAN, probe->fan, SUSI_ID_FC_CONTROL_SUPPORT_FLAGS, &probe->controlFlags);
+    if (probe->status != SUSI_STATUS_SUCCESS) {
+        return;
+    }
+    start = monotonicNowNs();
+    probe->status = SusiFanControlGetConfig(probe->fan, &probe->config);
+    susiTimingRecord(SUSI_CALL_FAN_GET_CONFIG, start, probe->status);
+}
+
+static void hwSetFan(void *arg) {
+    FanCommand *command = arg;
+    uint64_t start = monotonicNowNs();
+
+    command->status = SusiFanControlSetConfig(command->fan, command->config);
+    susiTimingRecord(SUSI_CALL_FAN_SET_CONFIG, start, command->status);
+}
+
+static SusiStatus_t setFan(SusiId_t fan, SusiFanControl *config) {
+    FanCommand command = { .fan = fan, .config = config };
+
+    if (!hwActorCall(HW_LANE_CONFIG, hwSetFan, &command)) {
+        return SUSI_STATUS_LOCKFAIL;
+    }
+    return command.status;
+}
+
+// Duty for one reading; dt is 0 for the first
+static uint32_t computeDuty(FanLoop *loop, int32_t raw, double temperature, double dt) {
+    const FanLoopConfig *config = &loop->status.config;
+    double error, output, derivative = 0;
+
+    if (config->kind == FAN_LOOP_CURVE) {
+        return curveLookup(&loop->curve, raw);
+    }
+    if (config->kind == FAN_LOOP_HYSTERESIS) {
+        if (temperature >= config->high) {
+            loop->hysteresisHigh = true;
+        } else if (temperature <= config->low) {
+            loop->hysteresisHigh = false;
+        }
+        return loop->hysteresisHigh ? config->highDuty : config->lowDuty;
+    }
+
+    // Derivative of the measurement, not the error: same for a fixed
+    // setpoint, and it cannot kick
+    error = temperature - config->setpoint;
+    if (dt > 0) {
+        derivative = (temperature - loop->lastTemperature) / dt;
+    }
+    output = config->kp * error + loop->status.integral + config->kd * derivative;
+    // Conditional integration: no wind-up while saturated in the direction
+    // the error pushes
+    if (dt > 0 && !(output >= config->maxDuty && error > 0) && !(output <= config->minDuty && error < 0)) {
+        loop->status.integral += config->ki * error * dt;
+        if (loop->status.integral > config->maxDuty) {
+            loop->status.integral = config->maxDuty;
+        } else if (loop->status.integral < -(double)config->maxDuty) {
+            loop->status.integral = -(double)config->maxDuty;
+        }
+        output = config->kp * error + loop->status.integral + config->kd * derivative;
+    }
+    if (output < config->minDuty) {
+        return config->minDuty;
+    }
+    if (output > config->maxDuty) {
+        return config->maxDuty;
+    }
+    return (uint32_t)lround(output);
+}
+
+static void onSweep(const HwmReading *reading, void *ctx) {
+    (void)ctx;
+
+    pthread_mutex_lock(&loopLock);
+    for (int i = 0; i < loopCount && controlRunning; i++) {
+        FanLoop *loop = &loops[i];
+        int slot = loop->status.config.sensorSlot;
+        double temperature, dt = 0;
+        uint32_t duty;
+        SusiFanControl config;
+        SusiStatus_t status;
+
+        if (!loop->status.running || !(reading->validMask & (1ull << slot))) {
+            continue;
+        }
+        temperature = hwmScale(HWM_KIND_TEMPERATURE, reading->values[slot]);
+        if (loop->lastSampleMs != 0) {
+            if (reading->sampledMs[slot] <= loop->lastSampleMs) {
+                continue;
+            }
+            dt = (double)(reading->sampledMs[slot] - loop->lastSampleMs) / 1000.0;
+            if (dt > FAN_MAX_DT_S) {
+                dt = FAN_MAX_DT_S;
+            }
+        }
+        duty = computeDuty(loop, reading->values[slot], temperature, dt);
+        loop->lastTemperature = temperature;
+        loop->lastSampleMs = reading->sampledMs[slot];
+        loop->status.temperature = temperature;
+        loop->status.updatedMs = reading->sampledMs[slot];
+        loop->status.updates++;
+        if ((int32_t)duty == loop->status.duty) {
+            loop->status.skipped++;
+            continue;
+        }
+
+        // The saved auto settings ride along, so the EC keeps them
+        config = loop->saved;
+        config.Mode = SUSI_FAN_CTRL_MODE_MANUAL;
+        config.PWM = duty;
+        status = setFan(loop->status.config.fan, &config);
+        loop->status.lastStatus = status;
+        if (status == SUSI_STATUS_SUCCESS) {
+            loop->status.duty = (int32_t)duty;
+            loop->status.writes++;
+        } else {
+            // duty stays stale, so the next reading tries again
+            loop->status.errors++;
+        }
+    }
+    pthread_mutex_unlock(&loopLock);
+}
+
+bool fanControlStart(void) {
+    const HwmCapabilities *caps = hwmCapabilities();
+    int started = 0;
+
+    for (int i = 0; i < loopCount; i++) {
+        FanLoop *loop = &loops[i];
+        const FanLoopConfig *config = &loop->status.config;
+        FanProbe probe = { .fan = config->fan };
+
+        if (caps == NULL || !(caps->mask & (1ull << config->sensorSlot))) {
+            printf("Fan loop %u: temperature %d is not sampled\n", config->fan - SUSI_ID_HWM_FAN_BASE,
+                   config->sensorSlot);
+            continue;
+        }
+        if (!hwActorCall(HW_LANE_CONFIG, hwProbeFan, &probe)) {
+            probe.status = SUSI_STATUS_LOCKFAIL;
+        }
+        if (probe.status != SUSI_STATUS_SUCCESS || !(probe.controlFlags & SUSI_FC_FLAG_SUPPORT_MANUAL_MODE)) {
+            printf("Fan loop %u: no manual fan control (0x%08X)\n", config->fan - SUSI_ID_HWM_FAN_BASE,
+                   probe.status);
+            continue;
+        }
+        // A curve is fixed, so it is checked against the fan once, here
+        if (config->kind == FAN_LOOP_CURVE && config->minDuty == 0 &&
+            !(probe.controlFlags & SUSI_FC_FLAG_SUPPORT_OFF_MODE)) {
+            printf("Fan loop %u: the curve stops the fan, which does not support off mode\n",
+                   config->fan - SUSI_ID_HWM_FAN_BASE);
+            continue;
+        }
+        loop->saved = probe.config;
+        loop->restore = true;
+        loop->status.running = true;
+        printf("Fan loop %u: %s from %s\n", config->fan - SUSI_ID_HWM_FAN_BASE,
+               config->kind == FAN_LOOP_PID ? "PID" : config->kind == FAN_LOOP_CURVE ? "curve" : "hysteresis",
+               hwmSensor(config->sensorSlot)->name);
+        started++;
+    }
+    if (started == 0) {
+        return false;
+    }
+    controlRunning = true;
+    if (!hwmAddListener(onSweep, NULL)) {
+        controlRunning = false;
+        return false;
+    }
+    return true;
+}
+
+void fanControlStop(void) {
+    pthread_mutex_lock(&loopLock);
+    controlRunning = false;
+    for (int i = 0; i < loopCount; i++) {
+        FanLoop *loop = &loops[i];
+        SusiStatus_t status;
+
+        if (!loop->restore) {
+            continue;
+        }
+        loop->status.running = false;
+        loop->restore = false;
+        status = setFan(loop->status.config.fan, &loop->saved);
+        if (status != SUSI_STATUS_SUCCESS) {
+            printf("Fan loop %u: failed to restore the fan configuration (0x%08X)\n",
+                   loop->status.config.fan - SUSI_ID_HWM_FAN_BASE, status);
+        }
+    }
+    pthread_mutex_unlock(&loopLock);
+}
+
+int fanControlStatus(FanLoopStatus *status, int max) {
+    int count = loopCount < max ? loopCount : max;
+
+    pthread_mutex_lock(&loopLock);
+    for (int i = 0; i < count; i++) {
+        status[i] = loops[i].status;
+    }
+    pthread_mutex_unlock(&loopLock);
+    return count;
+}
+
+void fanControlCollectMetrics(StrBuf *out, void *ctx) {
+    FanLoopStatus status[FAN_CONTROL_MAX_LOOPS];
+    int count = fanControlStatus(status, FAN_CONTROL_MAX_LOOPS);
+    (void)ctx;
+
+    if (count == 0) {
+        return;
+    }
+    metricsHeader(out, "watchdog_fan_loop_duty_percent", "gauge", "Duty the fan loop last set, -1 before the first write");
+    for (int i = 0; i < count; i++) {
+        strbufAppendf(out, "watchdog_fan_loop_duty_percent{fan=\"%u\"} %d\n",
+                      status[i].config.fan - SUSI_ID_HWM_FAN_BASE, status[i].duty);
+    }
+    metricsHeader(out, "watchdog_fan_loop_temperature_celsius", "gauge", "Temperature behind the fan loop's last update");
+    for (int i = 0; i < count; i++) {
+        if (!isnan(status[i].temperature)) {
+            strbufAppendf(out, "watchdog_fan_loop_temperature_celsius{fan=\"%u\"} %.1f\n",
+                          status[i].config.fan - SUSI_ID_HWM_FAN_BASE, status[i].temperature);
+        }
+    }
+    metricsHeader(out, "watchdog_fan_loop_updates_total", "counter", "Temperature readings the fan loop acted on");
+    for (int i = 0; i < count; i++) {
+        strbufAppendf(out, "watchdog_fan_loop_updates_total{fan=\"%u\"} %llu\n",
+                      status[i].config.fan - SUSI_ID_HWM_FAN_BASE, (unsigned long long)status[i].updates);
+    }
+    metricsHeader(out, "watchdog_fan_loop_writes_total", "counter", "Duty changes written to the fan");
+    for (int i = 0; i < count; i++) {
+        strbufAppendf(out, "watchdog_fan_loop_writes_total{fan=\"%u\"} %llu\n",
+                      status[i].config.fan - SUSI_ID_HWM_FAN_BASE, (unsigned long long)status[i].writes);
+    }
+    metricsHeader(out, "watchdog_fan_loop_skipped_total", "counter", "Readings that left the duty unchanged, so nothing was written");
+    for (int i = 0; i < count; i++) {
+        strbufAppendf(out, "watchdog_fan_loop_skipped_total{fan=\"%u\"} %llu\n",
+                      status[i].config.fan - SUSI_ID_HWM_FAN_BASE, (unsigned long long)status[i].skipped);
+    }
+    metricsHeader(out, "watchdog_fan_loop_errors_total", "counter", "Duty writes that failed");
+    for (int i = 0; i < count; i++) {
+        strbufAppendf(out, "watchdog_fan_loop_errors_total{fan=\"%u\"} %llu\n",
+                      status[i].config.fan - SUSI_ID_HWM_FAN_BASE, (unsigned long long)status[i].errors);
+    }
+}
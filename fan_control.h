@@ -0,0 +1,94 @@
+#ifndef FAN_CONTROL_H
+#define FAN_CONTROL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "Susi4.h"
+#include "strbuf.h"
+
+#define FAN_CONTROL_MAX_LOOPS SUSI_ID_HWM_FAN_MAX
+#define FAN_CONTROL_DEFAULT_KP 5.0           // Duty percent per degree above the setpoint
+#define FAN_CONTROL_DEFAULT_KI 0.1           // Duty percent per degree-second
+#define FAN_CONTROL_DEFAULT_KD 0.0
+#define FAN_CONTROL_DEFAULT_MIN_DUTY 20
+#define FAN_CONTROL_DEFAULT_MAX_DUTY 100
+#define FAN_CURVE_MAX_POINTS 16
+#define FAN_CURVE_MAX_SPAN 200               // Degrees from the first to the last curve point
+
+// Software fan control. Each loop drives one fan in manual (PWM) mode from
+// one HWM temperature, computing the duty on the sampler task after
+// every sweep that read that sensor:
+//
+//   pid:  duty = Kp * e + Ki * integral(e) + Kd * de/dt, e = T - setpoint,
+//         clamped to [min, max]; the integral stops winding up while the
+//         output is saturated
+//   hyst: high duty from T >= high until T <= low, low duty below that
+//   curve: piecewise linear through (degrees, duty) points, flat outside
+//         them. The curve is compiled once, when the spec is parsed, into
+//         a table with one fixed-point duty per whole degree; a reading is
+//         converted with one lookup and an integer interpolation between
+//         two neighbouring entries, straight from its raw 0.1 K value.
+//
+// The duty is rounded to whole percent and SusiFanControlSetConfig is only
+// called, on the config lane, when that differs from the last value the
+// EC accepted, so a steady temperature costs no bus traffic at all. Each
+// fan's original configuration is restored by fanControlStop().
+
+typedef enum {
+    FAN_LOOP_PID,
+    FAN_LOOP_HYSTERESIS,
+    FAN_LOOP_CURVE
+} FanLoopKind;
+
+typedef struct {
+    SusiId_t fan;                    // SUSI_ID_HWM_FAN_BASE + n
+    int sensorSlot;                  // HWM slot of the temperature (SUSI_ID_HWM_TEMP_BASE + slot)
+    FanLoopKind kind;
+    double setpoint;                 // pid: Celsius
+    double kp, ki, kd;
+    double low, high;                // hyst: Celsius
+    uint32_t lowDuty, highDuty;      // hyst: percent
+    uint32_t minDuty, maxDuty;       // pid: percent; curve: lowest and highest point
+    int points;                      // curve: ascending whole degrees and their duty
+    int16_t pointTemperature[FAN_CURVE_MAX_POINTS];
+    uint8_t pointDuty[FAN_CURVE_MAX_POINTS];
+} FanLoopConfig;
+
+// "FAN:TEMP:pid:SETPOINT[:KP:KI:KD[:MIN:MAX]]",
+// "FAN:TEMP:hyst:LOW:HIGH:LOW_DUTY:HIGH_DUTY" or
+// "FAN:TEMP:curve:DEG=DUTY,DEG=DUTY[,...]", FAN and TEMP being the index of
+// the fan and the temperature sensor (0 = CPU). Before fanControlStart();
+// false for a bad spec or a full table.
+bool fanControlAddSpec(const char *spec);
+int fanControlLoopCount(void);
+// Whether a running loop drives this fan, so nothing else may configure it
+bool fanControlOwns(SusiId_t fan);
+
+// Check every loop's fan and sensor, save the fans' configurations and
+// start listening to the sampler (after hwmInit). A fan must support
+// manual mode, and a curve that reaches 0% also off mode. False if no loop
+// could be started; loops that cannot run are dropped with a message.
+bool fanControlStart(void);
+// Hand every fan back its saved configuration (before hwActorStop)
+void fanControlStop(void);
+
+typedef struct {
+    FanLoopConfig config;
+    bool running;
+    double temperature;              // Celsius, NAN before the first reading
+    int32_t duty;                    // Last duty the EC accepted, -1 before the first write
+    double integral;                 // pid: integral term, in duty percent
+    uint64_t updatedMs;              // Wall clock of the reading behind duty
+    uint64_t updates;                // Readings the loop acted on
+    uint64_t writes;                 // SusiFanControlSetConfig calls that succeeded
+    uint64_t skipped;                // Readings that left the duty unchanged
+    uint64_t errors;
+    SusiStatus_t lastStatus;
+} FanLoopStatus;
+
+// Copy the state of up to max loops; returns how many were copied
+int fanControlStatus(FanLoopStatus *status, int max);
+
+void fanControlCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // FAN_CONTROL_H
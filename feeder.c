@@ -0,0 +1,486 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include "feeder.h"
+#include "histogram.h"
+#include "metrics.h"
+#include "realtime.h"
+#include "timeutil.h"
+
+#define FEEDER_MAX_HEARTBEATS 4
+
+typedef struct {
+    const char *name;
+    FeederCondition condition;
+    void *ctx;
+    uint64_t failures;          // Times this condition blocked a feed
+} FeederConditionEntry;
+
+typedef struct {
+    char path[256];
+    uint32_t maxAgeMs;
+} HeartbeatFile;
+
+typedef enum {
+    CHECK_OK,
+    CHECK_FAILED,
+    CHECK_TIMEOUT,          // Still running past its own timeout
+    CHECK_STALE,            // Cut short by the slack; the previous answer counted
+    CHECK_RESULT_COUNT
+} CheckResult;
+
+static const char *checkResultNames[CHECK_RESULT_COUNT] = { "ok", "failed", "timeout", "stale" };
+
+typedef struct {
+    char name[96];
+    FeederCheck check;
+    void *ctx;
+    uint32_t timeoutMs;
+    pthread_t thread;
+    bool threadStarted;
+    // Under checkLock
+    bool pending;           // Woken for a round it has not picked up yet
+    bool running;
+    uint64_t round;         // Round of the current or last run
+    uint64_t answeredRound;
+    uint64_t startedNs;
+    uint64_t durationNs;    // Of the last answer
+    bool answer;
+    bool answered;          // Has answered at least once
+    // Statistics
+    uint64_t results[CHECK_RESULT_COUNT];
+    Histogram duration;
+} FeederCheckEntry;
+
+static FeederConditionEntry conditions[FEEDER_MAX_CONDITIONS];
+static int conditionCount = 0;
+static FeederCheckEntry checks[FEEDER_MAX_CHECKS];
+static int checkCount = 0;
+static pthread_mutex_t checkLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t checkWake = PTHREAD_COND_INITIALIZER;    // Workers: a round started or stopping
+static pthread_cond_t checkDone;    // Feeder: a check answered
+static bool checksStopping = false;
+static uint64_t checkRound = 0;
+static FeederSlackFn slackFn = NULL;
+static void *slackCtx = NULL;
+static uint64_t lastBudgetNs = 0;
+static uint64_t slackLimited = 0;   // Rounds whose wait the slack cut below the check timeouts
+static HeartbeatFile heartbeats[FEEDER_MAX_HEARTBEATS];
+static int heartbeatCount = 0;
+
+static pthread_t feederThread;
+static bool feederActive = false;
+static int timerFd = -1;
+static int stopFd = -1;
+static uint32_t feedIntervalMs = 0;
+static FeederFeedFn feedFn = NULL;
+static void *feedCtx = NULL;
+
+static uint64_t feedsOk = 0;
+static uint64_t feedsFailed = 0;
+static uint64_t feedsSkipped = 0;   // Blocked by a health condition
+static uint64_t timerOverruns = 0;  // Expirations missed because the thread ran late
+
+// Conditions must be added before feederStart()
+bool feederAddCondition(const char *name, FeederCondition condition, void *ctx) {
+    if (conditionCount >= FEEDER_MAX_CONDITIONS) {
+        return false;
+    }
+    conditions[conditionCount].name = name;
+    conditions[conditionCount].condition = condition;
+    conditions[conditionCount].ctx = ctx;
+    conditions[conditionCount].failures = 0;
+    conditionCount++;
+    return true;
+}
+
+static bool heartbeatFresh(void *ctx) {
+    HeartbeatFile *heartbeat = (HeartbeatFile *)ctx;
+    struct stat st;
+    struct timespec now;
+    int64_t ageMs;
+    
+    if (stat(heartbeat->path, &st) != 0) {
+        return false;
+    }
+    clock_gettime(CLOCK_REALTIME, &now);
+    ageMs = (int64_t)(now.tv_sec - st.st_mtim.tv_sec) * 1000 +
+            (now.tv_nsec - st.st_mtim.tv_nsec) / 1000000;
+    return ageMs <= (int64_t)heartbeat->maxAgeMs;
+}
+
+bool feederAddCheck(const char *name, FeederCheck check, void *ctx, uint32_t timeoutMs) {
+    FeederCheckEntry *entry;
+    
+    if (checkCount >= FEEDER_MAX_CHECKS || feederActive) {
+        return false;
+    }
+    entry = &checks[checkCount];
+    snprintf(entry->name, sizeof(entry->name), "%s", name);
+    entry->check = check;
+    entry->ctx = ctx;
+    entry->timeoutMs = timeoutMs ? timeoutMs : FEEDER_DEFAULT_CHECK_TIMEOUT_MS;
+    memset(&entry->duration, 0, sizeof(entry->duration));
+    checkCount++;
+    return true;
+}
+
+void feederSetSlack(FeederSlackFn slack, void *ctx) {
+    slackFn = slack;
+    slackCtx = ctx;
+}
+
+bool feederAddHeartbeatFile(const char *path, uint32_t maxAgeMs) {
+    HeartbeatFile *heartbeat;
+    
+    if (heartbeatCount >= FEEDER_MAX_HEARTBEATS || strlen(path) >= sizeof(heartbeats[0].path)) {
+        return false;
+    }
+    heartbeat = &heartbeats[heartbeatCount];
+    strcpy(heartbeat->path, path);
+    heartbeat->maxAgeMs = maxAgeMs;
+    if (!feederAddCondition(heartbeat->path, heartbeatFresh, heartbeat)) {
+        return false;
+    }
+    heartbeatCount++;
+    return true;
+}
+
+static void* checkThreadMain(void *arg) {
+    FeederCheckEntry *entry = (FeederCheckEntry *)arg;
+    
+    pthread_setname_np(pthread_self(), "feed-check");
+    pthread_mutex_lock(&checkLock);
+    while (!checksStopping) {
+        uint64_t start;
+        bool answer;
+        
+        if (!entry->pending) {
+            pthread_cond_wait(&checkWake, &checkLock);
+            continue;
+        }
+        entry->pending = false;
+        pthread_mutex_unlock(&checkLock);
+        
+        start = monotonicNowNs();
+        answer = entry->check(entry->ctx, entry->timeoutMs);
+        
+        pthread_mutex_lock(&checkLock);
+        entry->durationNs = monotonicNowNs() - start;
+        // A late answer is not one a stale round may fall back on
+        entry->answer = answer && entry->durationNs <= (uint64_t)entry->timeoutMs * 1000000ull;
+        entry->answered = true;
+        entry->answeredRound = entry->round;
+        entry->running = false;
+        histogramRecord(&entry->duration, entry->durationNs);
+        pthread_cond_broadcast(&checkDone);
+    }
+    pthread_mutex_unlock(&checkLock);
+    return NULL;
+}
+
+// How long this round may wait for the checks
+static uint64_t checkBudgetNs(void) {
+    uint64_t budget = (uint64_t)feedIntervalMs * 1000000ull;
+    uint64_t longest = 0;
+    
+    for (int i = 0; i < checkCount; i++) {
+        if ((uint64_t)checks[i].timeoutMs * 1000000ull > longest) {
+            longest = (uint64_t)checks[i].timeoutMs * 1000000ull;
+        }
+    }
+    if (longest < budget) {
+        budget = longest;
+    }
+    if (slackFn) {
+        int64_t slack = slackFn(slackCtx) - (int64_t)FEEDER_FEED_MARGIN_MS * 1000000;
+        
+        if (slack < (int64_t)budget) {
+            budget = slack > 0 ? (uint64_t)slack : 0;
+            if (budget < longest) {
+                __atomic_fetch_add(&slackLimited, 1, __ATOMIC_RELAXED);
+            }
+        }
+    }
+    return budget;
+}
+
+static bool roundAnswered(uint64_t round) {
+    for (int i = 0; i < checkCount; i++) {
+        if (checks[i].round == round && checks[i].answeredRound != round) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Start every idle check, wait within the budget and judge each one
+static bool runChecks(void) {
+    uint64_t now = monotonicNowNs();
+    uint64_t budget = checkBudgetNs();
+    uint64_t deadlineNs = now + budget;
+    struct timespec deadline;
+    bool healthy = true;
+    uint64_t round;
+    
+    __atomic_store_n(&lastBudgetNs, budget, __ATOMIC_RELAXED);
+    deadline.tv_sec = (time_t)(deadlineNs / 1000000000ull);
+    deadline.tv_nsec = (long)(deadlineNs % 1000000000ull);
+    
+    pthread_mutex_lock(&checkLock);
+    round = ++checkRound;
+    for (int i = 0; i < checkCount; i++) {
+        if (!checks[i].running) {
+            checks[i].running = true;
+            checks[i].pending = true;
+            checks[i].round = round;
+            checks[i].startedNs = now;
+        }
+    }
+    pthread_cond_broadcast(&checkWake);
+    while (!roundAnswered(round) && pthread_cond_timedwait(&checkDone, &checkLock, &deadline) == 0) {
+    }
+    
+    now = monotonicNowNs();
+    for (int i = 0; i < checkCount; i++) {
+        FeederCheckEntry *entry = &checks[i];
+        uint64_t timeoutNs = (uint64_t)entry->timeoutMs * 1000000ull;
+        CheckResult result;
+        
+        if (entry->answeredRound == round && entry->durationNs <= timeoutNs) {
+            result = entry->answer ? CHECK_OK : CHECK_FAILED;
+        } else if (entry->answeredRound == round || now - entry->startedNs >= timeoutNs) {
+            result = CHECK_TIMEOUT;
+        } else {
+            result = CHECK_STALE;
+        }
+        entry->results[result]++;
+        if (result == CHECK_FAILED || result == CHECK_TIMEOUT || (result == CHECK_STALE && !(entry->answered && entry->answer))) {
+            healthy = false;
+        }
+    }
+    pthread_mutex_unlock(&checkLock);
+    return healthy;
+}
+
+// Evaluate all conditions and checks; every one must pass
+static bool feederHealthy(void) {
+    bool healthy = true;
+    
+    for (int i = 0; i < conditionCount; i++) {
+        if (!conditions[i].condition(conditions[i].ctx)) {
+            __atomic_fetch_add(&conditions[i].failures, 1, __ATOMIC_RELAXED);
+            healthy = false;
+        }
+    }
+    if (checkCount > 0 && !runChecks()) {
+        healthy = false;
+    }
+    return healthy;
+}
+
+static void* feederThreadMain(void *arg) {
+    struct pollfd fds[2];
+    uint64_t expirations;
+    (void)arg;
+    
+    pthread_setname_np(pthread_self(), "feeder");
+    realtimeEnterThread(REALTIME_THREAD_FEEDER);
+    fds[0].fd = timerFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = stopFd;
+    fds[1].events = POLLIN;
+    
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            continue;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+        if (!(fds[0].revents & POLLIN) || read(timerFd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+            continue;
+        }
+        if (expirations > 1) {
+            __atomic_fetch_add(&timerOverruns, expirations - 1, __ATOMIC_RELAXED);
+        }
+        
+        if (!feederHealthy()) {
+            __atomic_fetch_add(&feedsSkipped, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+        if (feedFn(feedCtx)) {
+            __atomic_fetch_add(&feedsOk, 1, __ATOMIC_RELAXED);
+        } else {
+            __atomic_fetch_add(&feedsFailed, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return NULL;
+}
+
+static bool startChecks(void) {
+    pthread_condattr_t attr;
+    
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&checkDone, &attr);
+    pthread_condattr_destroy(&attr);
+    checksStopping = false;
+    for (int i = 0; i < checkCount; i++) {
+        if (pthread_create(&checks[i].thread, NULL, checkThreadMain, &checks[i]) != 0) {
+            return false;
+        }
+        checks[i].threadStarted = true;
+    }
+    return true;
+}
+
+// A check stuck in the kernel (dead NFS mount, unanswered connect) cannot
+// be interrupted, so its thread is left behind instead of joined
+static void stopChecks(void) {
+    pthread_mutex_lock(&checkLock);
+    checksStopping = true;
+    pthread_cond_broadcast(&checkWake);
+    pthread_mutex_unlock(&checkLock);
+    for (int i = 0; i < checkCount; i++) {
+        if (!checks[i].threadStarted) {
+            continue;
+        }
+        pthread_mutex_lock(&checkLock);
+        bool running = checks[i].running && !checks[i].pending;
+        pthread_mutex_unlock(&checkLock);
+        if (running) {
+            pthread_detach(checks[i].thread);
+        } else {
+            pthread_join(checks[i].thread, NULL);
+        }
+        checks[i].threadStarted = false;
+    }
+}
+
+bool feederStart(uint32_t intervalMs, FeederFeedFn feed, void *ctx) {
+    struct itimerspec spec;
+    
+    if (feederActive || intervalMs == 0 || feed == NULL) {
+        return false;
+    }
+    
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    stopFd = eventfd(0, EFD_CLOEXEC);
+    if (timerFd < 0 || stopFd < 0) {
+        perror("feeder: timerfd/eventfd");
+        feederStop();
+        return false;
+    }
+    
+    memset(&spec, 0, sizeof(spec));
+    spec.it_interval.tv_sec = intervalMs / 1000;
+    spec.it_interval.tv_nsec = (long)(intervalMs % 1000) * 1000000L;
+    spec.it_value = spec.it_interval;
+    if (timerfd_settime(timerFd, 0, &spec, NULL) != 0) {
+        perror("feeder: timerfd_settime");
+        feederStop();
+        return false;
+    }
+    
+    feedIntervalMs = intervalMs;
+    feedFn = feed;
+    feedCtx = ctx;
+    if (!startChecks()) {
+        feederStop();
+        return false;
+    }
+    if (pthread_create(&feederThread, NULL, feederThreadMain, NULL) != 0) {
+        feederStop();
+        return false;
+    }
+    feederActive = true;
+    printf("Auto-feeder started: interval %u ms, %d health condition(s), %d concurrent check(s)\n",
+           intervalMs, conditionCount, checkCount);
+    return true;
+}
+
+void feederStop(void) {
+    uint64_t one = 1;
+    
+    if (feederActive) {
+        if (write(stopFd, &one, sizeof(one)) != sizeof(one)) {
+            perror("feeder: stop");
+        }
+        pthread_join(feederThread, NULL);
+        feederActive = false;
+    }
+    stopChecks();
+    if (timerFd >= 0) {
+        close(timerFd);
+        timerFd = -1;
+    }
+    if (stopFd >= 0) {
+        close(stopFd);
+        stopFd = -1;
+    }
+}
+
+bool feederRunning(void) {
+    return feederActive;
+}
+
+void feederCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+    
+    if (!feederActive) {
+        return;
+    }
+    metricsHeader(out, "watchdog_autofeed_interval_seconds", "gauge", "Configured auto-feed interval");
+    strbufAppendf(out, "watchdog_autofeed_interval_seconds %.3f\n", (double)feedIntervalMs / 1e3);
+    metricsHeader(out, "watchdog_autofeed_total", "counter", "Auto-feed attempts by result");
+    strbufAppendf(out, "watchdog_autofeed_total{result=\"ok\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&feedsOk, __ATOMIC_RELAXED));
+    strbufAppendf(out, "watchdog_autofeed_total{result=\"failed\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&feedsFailed, __ATOMIC_RELAXED));
+    strbufAppendf(out, "watchdog_autofeed_total{result=\"unhealthy\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&feedsSkipped, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_autofeed_timer_overruns_total", "counter", "Feed ticks missed because the feeder ran late");
+    strbufAppendf(out, "watchdog_autofeed_timer_overruns_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&timerOverruns, __ATOMIC_RELAXED));
+    if (checkCount > 0) {
+        metricsHeader(out, "watchdog_autofeed_checks_total", "counter", "Health check verdicts by result");
+        pthread_mutex_lock(&checkLock);
+        for (int i = 0; i < checkCount; i++) {
+            for (int r = 0; r < CHECK_RESULT_COUNT; r++) {
+                strbufAppendf(out, "watchdog_autofeed_checks_total{check=\"%s\",result=\"%s\"} %llu\n",
+                              checks[i].name, checkResultNames[r], (unsigned long long)checks[i].results[r]);
+            }
+        }
+        pthread_mutex_unlock(&checkLock);
+        metricsHeader(out, "watchdog_autofeed_check_seconds", "summary", "Time health checks took to answer");
+        for (int i = 0; i < checkCount; i++) {
+            char labels[sizeof(checks[i].name) + 16];
+            
+            snprintf(labels, sizeof(labels), "check=\"%.*s\"", (int)sizeof(checks[i].name) - 1, checks[i].name);
+            histogramWriteSummary(out, "watchdog_autofeed_check_seconds", labels, &checks[i].duration);
+        }
+        metricsHeader(out, "watchdog_autofeed_check_budget_seconds", "gauge", "How long the last feed tick could wait for its checks");
+        strbufAppendf(out, "watchdog_autofeed_check_budget_seconds %.3f\n",
+                      (double)__atomic_load_n(&lastBudgetNs, __ATOMIC_RELAXED) / 1e9);
+        metricsHeader(out, "watchdog_autofeed_check_slack_limited_total", "counter",
+                      "Feed ticks whose check wait the watchdog slack cut short");
+        strbufAppendf(out, "watchdog_autofeed_check_slack_limited_total %llu\n",
+                      (unsigned long long)__atomic_load_n(&slackLimited, __ATOMIC_RELAXED));
+    }
+    if (conditionCount > 0) {
+        metricsHeader(out, "watchdog_autofeed_condition_failures_total", "counter", "Times a health condition blocked a feed");
+        for (int i = 0; i < conditionCount; i++) {
+            strbufAppendf(out, "watchdog_autofeed_condition_failures_total{condition=\"%s\"} %llu\n",
+                          conditions[i].name,
+                          (unsigned long long)__atomic_load_n(&conditions[i].failures, __ATOMIC_RELAXED));
+        }
+    }
+}
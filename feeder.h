@@ -0,0 +1,51 @@
+#ifndef FEEDER_H
+#define FEEDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "strbuf.h"
+
+#define FEEDER_MAX_CONDITIONS 16
+#define FEEDER_MAX_CHECKS 8
+#define FEEDER_DEFAULT_CHECK_TIMEOUT_MS 500
+#define FEEDER_FEED_MARGIN_MS 20         // Left to the feed itself before the reset deadline
+
+// A health condition returns true when it is safe to feed the watchdog.
+// Conditions run on the feeder thread and must return quickly.
+typedef bool (*FeederCondition)(void *ctx);
+
+// Performs the actual feed; returns false if the feed failed or was not
+// possible (e.g. the watchdog is not running).
+typedef bool (*FeederFeedFn)(void *ctx);
+
+// A health check may block (file system, network, /proc). Checks run
+// concurrently, each on its own thread, at every feed tick. The feeder
+// waits for them until the longest check timeout, the feed interval or the
+// slack the watchdog has left before it resets (minus FEEDER_FEED_MARGIN_MS)
+// runs out, whichever comes first, and decides with what it has:
+// - a check that answered within its timeout counts with its answer
+// - a check still running past its own timeout fails
+// - a check cut short by the slack counts with its previous answer, and
+//   fails if it never answered
+// A check that is still running at the next tick is not started twice.
+typedef bool (*FeederCheck)(void *ctx, uint32_t timeoutMs);
+
+// Returns the time left before the watchdog resets, INT64_MAX if unknown
+typedef int64_t (*FeederSlackFn)(void *ctx);
+
+bool feederAddCondition(const char *name, FeederCondition condition, void *ctx);
+// Before feederStart(); name is copied, timeoutMs 0 is the default
+bool feederAddCheck(const char *name, FeederCheck check, void *ctx, uint32_t timeoutMs);
+void feederSetSlack(FeederSlackFn slack, void *ctx);
+
+// Built-in condition: a file whose mtime must be younger than maxAgeMs
+bool feederAddHeartbeatFile(const char *path, uint32_t maxAgeMs);
+
+// Start the timerfd-driven feeder thread. intervalMs is the feed period.
+bool feederStart(uint32_t intervalMs, FeederFeedFn feed, void *ctx);
+void feederStop(void);
+bool feederRunning(void);
+
+void feederCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // FEEDER_H
@@ -0,0 +1,947 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <jansson.h>
+#include "fleet.h"
+#include "json_writer.h"
+#include "metrics.h"
+#include "response_pool.h"
+#include "snapshot.h"
+#include "timeutil.h"
+
+#define FLEET_SNAPSHOT_CAPACITY (64 * 1024)
+#define FLEET_BUFFER_INITIAL (16 * 1024)
+#define FLEET_STOP_EVENT UINT64_MAX
+
+typedef enum {
+    REQUEST_STATUS,
+    REQUEST_HWM,
+    REQUEST_COUNT
+} FleetRequest;
+
+static const char *requestPaths[REQUEST_COUNT] = { "/api/status", "/api/hwm" };
+
+typedef enum {
+    CONN_CLOSED,
+    CONN_CONNECTING,
+    CONN_READING,               // Request sent, response being read
+    CONN_IDLE,                  // Kept alive between rounds
+} ConnState;
+
+typedef struct {
+    char name[32];
+    char kind[16];
+    char unit[8];
+    double value;
+    bool valid;                 // value was not null
+    bool stale;
+} FleetSensor;
+
+// What one round learned about a board
+typedef struct {
+    uint32_t watchdogId;
+    bool running;
+    bool susiInitialized;
+    bool hasRemaining;          // Only running timers report a deadline
+    bool hasMinSlack;
+    int64_t remainingMs;
+    int64_t minSlackMs;
+    uint64_t feedCount;
+    int sensorCount;
+    FleetSensor sensors[FLEET_MAX_SENSORS];
+} FleetResult;
+
+typedef struct {
+    // Set by fleetAddBoard
+    char name[64];
+    char host[128];
+    char port[8];
+
+    // Scraper thread only
+    struct sockaddr_storage address;
+    socklen_t addressLength;    // 0 until resolved
+    int fd;
+    uint32_t connection;        // Bumped for every connection opened
+    ConnState conn;
+    FleetRequest request;
+    bool busy;                  // Part of the current round
+    bool reused;                // This round's first request went over a kept connection
+    uint64_t deadlineNs;
+    char *in;
+    size_t inLength;
+    size_t inCapacity;
+    FleetResult pending;
+
+    // Guarded by fleetLock
+    bool up;
+    bool scraped;               // result holds at least one good round
+    uint64_t scrapedMs;         // Wall clock of result
+    uint64_t scrapedNs;         // Monotonic, to count remaining time down
+    char error[64];
+    FleetResult result;
+    uint64_t scrapesOk;
+    uint64_t scrapesFailed;
+} FleetBoard;
+
+static FleetBoard *boards = NULL;
+static int boardCount = 0;
+
+static pthread_mutex_t fleetLock = PTHREAD_MUTEX_INITIALIZER;
+static Snapshot fleetSnapshot;
+static pthread_t scraperThread;
+static bool fleetActive = false;
+static int epollFd = -1;
+static int stopFd = -1;
+static uint32_t roundIntervalMs = FLEET_DEFAULT_INTERVAL_MS;
+static uint64_t timeoutNs = FLEET_TIMEOUT_MS * 1000000ull;
+
+static uint64_t rounds = 0;
+static uint64_t lastRoundNs = 0;
+static uint64_t connectionsOpened = 0;
+static uint64_t requestsSent = 0;
+static uint64_t viewsSkipped = 0;
+
+static uint64_t wallNowMs(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000ull + (uint64_t)now.tv_nsec / 1000000ull;
+}
+
+// Names end up in metric labels and JSON; keep them plain
+static bool plainName(const char *name) {
+    size_t length = strlen(name);
+
+    return length > 0 && strspn(name, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789._:-") == length;
+}
+
+bool fleetAddBoard(const char *spec) {
+    const char *equals = strchr(spec, '=');
+    const char *target = equals != NULL ? equals + 1 : spec;
+    const char *colon = strrchr(target, ':');
+    size_t hostLength = colon != NULL ? (size_t)(colon - target) : strlen(target);
+    FleetBoard *board;
+    FleetBoard *grown;
+
+    if (fleetActive || boardCount >= FLEET_MAX_BOARDS || hostLength == 0 || hostLength >= sizeof(board->host)) {
+        return false;
+    }
+    if (colon != NULL && (colon[1] == '\0' || strlen(colon + 1) >= sizeof(board->port) ||
+                          strspn(colon + 1, "0123456789") != strlen(colon + 1))) {
+        return false;
+    }
+    grown = realloc(boards, (size_t)(boardCount + 1) * sizeof(*boards));
+    if (grown == NULL) {
+        return false;
+    }
+    boards = grown;
+    board = &boards[boardCount];
+    memset(board, 0, sizeof(*board));
+    memcpy(board->host, target, hostLength);
+    board->host[hostLength] = '\0';
+    if (colon != NULL) {
+        strcpy(board->port, colon + 1);
+    } else {
+        snprintf(board->port, sizeof(board->port), "%d", FLEET_DEFAULT_PORT);
+    }
+    if (equals != NULL) {
+        if ((size_t)(equals - spec) >= sizeof(board->name)) {
+            return false;
+        }
+        memcpy(board->name, spec, (size_t)(equals - spec));
+    } else if (strlen(target) < sizeof(board->name)) {
+        strcpy(board->name, target);
+    } else {
+        return false;
+    }
+    if (!plainName(board->name) || strpbrk(board->host, " \"\\\r\n") != NULL) {
+        return false;
+    }
+    for (int i = 0; i < boardCount; i++) {
+        if (strcmp(boards[i].name, board->name) == 0) {
+            return false;
+        }
+    }
+    board->fd = -1;
+    boardCount++;
+    return true;
+}
+
+bool fleetLoadBoards(const char *path) {
+    char line[256];
+    int number = 0;
+    FILE *file = fopen(path, "r");
+
+    if (file == NULL) {
+        printf("fleet: cannot open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char *spec = line + strspn(line, " \t");
+
+        number++;
+        spec[strcspn(spec, "#\r\n")] = '\0';
+        for (size_t end = strlen(spec); end > 0 && (spec[end - 1] == ' ' || spec[end - 1] == '\t'); end--) {
+            spec[end - 1] = '\0';
+        }
+        if (spec[0] != '\0' && !fleetAddBoard(spec)) {
+            printf("fleet: %s:%d: invalid or duplicate board '%s'\n", path, number, spec);
+            fclose(file);
+            return false;
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+int fleetBoardCount(void) {
+    return boardCount;
+}
+
+// Blocking, but names resolve once and numeric hosts never hit the network
+static bool resolveBoard(FleetBoard *board) {
+    struct addrinfo hints;
+    struct addrinfo *addresses;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICSERV;
+    if (getaddrinfo(board->host, board->port, &hints, &addresses) != 0) {
+        return false;
+    }
+    memcpy(&board->address, addresses->ai_addr, addresses->ai_addrlen);
+    board->addressLength = addresses->ai_addrlen;
+    freeaddrinfo(addresses);
+    return true;
+}
+
+static void closeConnection(FleetBoard *board) {
+    if (board->fd >= 0) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, board->fd, NULL);
+        close(board->fd);
+        board->fd = -1;
+    }
+    board->conn = CONN_CLOSED;
+}
+
+// Board index and connection number, so that an event left over from a
+// connection closed earlier in the same batch is not taken for its successor
+static uint64_t eventKey(const FleetBoard *board) {
+    return (uint64_t)board->connection << 32 | (uint32_t)(board - boards);
+}
+
+static void watchConnection(FleetBoard *board, uint32_t events) {
+    struct epoll_event event;
+
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.u64 = eventKey(board);
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, board->fd, &event);
+}
+
+// Close the board's part in the round; the table only changes here
+static void finishBoard(FleetBoard *board, const char *error) {
+    board->busy = false;
+    pthread_mutex_lock(&fleetLock);
+    if (error == NULL) {
+        board->up = true;
+        board->scraped = true;
+        board->scrapedMs = wallNowMs();
+        board->scrapedNs = monotonicNowNs();
+        board->result = board->pending;
+        board->error[0] = '\0';
+        board->scrapesOk++;
+    } else {
+        board->up = false;
+        snprintf(board->error, sizeof(board->error), "%s", error);
+        board->scrapesFailed++;
+    }
+    pthread_mutex_unlock(&fleetLock);
+    if (error != NULL) {
+        closeConnection(board);
+    }
+}
+
+static bool sendRequest(FleetBoard *board) {
+    char request[256];
+    int length = snprintf(request, sizeof(request),
+                          "GET %s HTTP/1.1\r\nHost: %s\r\nAccept: application/json\r\n"
+                          "User-Agent: watchdog-http-fleet\r\n\r\n",
+                          requestPaths[board->request], board->host);
+
+    // A request is far smaller than any socket buffer
+    if (send(board->fd, request, (size_t)length, MSG_NOSIGNAL | MSG_DONTWAIT) != length) {
+        return false;
+    }
+    __atomic_fetch_add(&requestsSent, 1, __ATOMIC_RELAXED);
+    board->inLength = 0;
+    board->conn = CONN_READING;
+    watchConnection(board, EPOLLIN | EPOLLRDHUP);
+    return true;
+}
+
+static bool openConnection(FleetBoard *board) {
+    struct epoll_event event;
+
+    if (board->addressLength == 0 && !resolveBoard(board)) {
+        return false;
+    }
+    board->connection++;
+    board->fd = socket(board->address.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (board->fd < 0) {
+        return false;
+    }
+    if (connect(board->fd, (struct sockaddr *)&board->address, board->addressLength) != 0 && errno != EINPROGRESS) {
+        close(board->fd);
+        board->fd = -1;
+        return false;
+    }
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLOUT;
+    event.data.u64 = eventKey(board);
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, board->fd, &event) != 0) {
+        close(board->fd);
+        board->fd = -1;
+        return false;
+    }
+    __atomic_fetch_add(&connectionsOpened, 1, __ATOMIC_RELAXED);
+    board->conn = CONN_CONNECTING;
+    return true;
+}
+
+static void startBoard(FleetBoard *board) {
+    board->busy = true;
+    board->deadlineNs = monotonicNowNs() + timeoutNs;
+    board->request = REQUEST_STATUS;
+    memset(&board->pending, 0, sizeof(board->pending));
+    board->reused = board->conn == CONN_IDLE;
+    if (board->reused) {
+        if (!sendRequest(board)) {
+            closeConnection(board);
+            board->reused = false;
+        } else {
+            return;
+        }
+    }
+    if (!openConnection(board)) {
+        finishBoard(board, board->addressLength == 0 ? "cannot resolve host" : "connect failed");
+    }
+}
+
+static void parseStatus(FleetResult *result, json_t *root) {
+    json_t *value;
+
+    result->watchdogId = (uint32_t)json_integer_value(json_object_get(root, "watchdog_id"));
+    result->running = json_is_true(json_object_get(root, "running"));
+    result->susiInitialized = json_is_true(json_object_get(root, "susi_initialized"));
+    result->feedCount = (uint64_t)json_integer_value(json_object_get(root, "feed_count"));
+    value = json_object_get(root, "remaining_to_reset_ms");
+    result->hasRemaining = json_is_integer(value);
+    result->remainingMs = json_integer_value(value);
+    value = json_object_get(root, "min_slack_ms");
+    result->hasMinSlack = json_is_integer(value);
+    result->minSlackMs = json_integer_value(value);
+}
+
+static void copyString(char *out, size_t size, json_t *value) {
+    snprintf(out, size, "%s", json_is_string(value) ? json_string_value(value) : "");
+}
+
+static void parseSensors(FleetResult *result, json_t *root) {
+    json_t *sensor;
+    size_t index;
+
+    json_array_foreach(json_object_get(root, "sensors"), index, sensor) {
+        FleetSensor *out;
+        json_t *value = json_object_get(sensor, "value");
+
+        if (result->sensorCount >= FLEET_MAX_SENSORS) {
+            break;
+        }
+        out = &result->sensors[result->sensorCount++];
+        copyString(out->name, sizeof(out->name), json_object_get(sensor, "name"));
+        copyString(out->kind, sizeof(out->kind), json_object_get(sensor, "kind"));
+        copyString(out->unit, sizeof(out->unit), json_object_get(sensor, "unit"));
+        out->valid = json_is_number(value);
+        out->value = json_number_value(value);
+        out->stale = json_is_true(json_object_get(sensor, "stale"));
+    }
+}
+
+// Length of a complete response in the buffer, 0 while more is needed,
+// -1 if it cannot be read. Bodies carry Content-Length: services answer
+// from fixed buffers and snapshots, never chunked.
+static long responseLength(const FleetBoard *board, int *status, size_t *bodyOffset, bool *keepAlive) {
+    const char *headerEnd = memmem(board->in, board->inLength, "\r\n\r\n", 4);
+    long contentLength = -1;
+
+    if (headerEnd == NULL) {
+        return 0;
+    }
+    if (sscanf(board->in, "HTTP/1.%*d %d", status) != 1) {
+        return -1;
+    }
+    *keepAlive = true;
+    for (const char *line = strstr(board->in, "\r\n"); line != NULL && line < headerEnd; line = strstr(line + 2, "\r\n")) {
+        const char *name = line + 2;
+
+        if (strncasecmp(name, "Content-Length:", 15) == 0) {
+            contentLength = strtol(name + 15, NULL, 10);
+        } else if (strncasecmp(name, "Connection:", 11) == 0 && strncasecmp(name + 11 + strspn(name + 11, " "), "close", 5) == 0) {
+            *keepAlive = false;
+        }
+    }
+    if (contentLength < 0) {
+        return -1;
+    }
+    *bodyOffset = (size_t)(headerEnd + 4 - board->in);
+    return board->inLength >= *bodyOffset + (size_t)contentLength ? (long)(*bodyOffset + (size_t)contentLength) : 0;
+}
+
+// Returns an error, or NULL once the response is handled
+static const char* handleResponse(FleetBoard *board, int status, const char *body, size_t length) {
+    json_error_t error;
+    json_t *root;
+
+    if (status != 200) {
+        // Boards without a hardware monitor still count as up
+        return board->request == REQUEST_STATUS ? "status request failed" : NULL;
+    }
+    root = json_loadb(body, length, 0, &error);
+    if (!json_is_object(root)) {
+        json_decref(root);
+        return board->request == REQUEST_STATUS ? "unreadable status" : NULL;
+    }
+    if (board->request == REQUEST_STATUS) {
+        parseStatus(&board->pending, root);
+    } else {
+        parseSensors(&board->pending, root);
+    }
+    json_decref(root);
+    return NULL;
+}
+
+static void readBoard(FleetBoard *board) {
+    for (;;) {
+        ssize_t got;
+        long complete;
+        int status = 0;
+        size_t bodyOffset = 0;
+        bool keepAlive = true;
+        const char *error;
+
+        if (board->inLength + 1 >= board->inCapacity) {
+            char *grown;
+
+            if (board->inCapacity >= FLEET_RESPONSE_MAX) {
+                finishBoard(board, "response too large");
+                return;
+            }
+            grown = realloc(board->in, board->inCapacity * 2);
+            if (grown == NULL) {
+                finishBoard(board, "out of memory");
+                return;
+            }
+            board->in = grown;
+            board->inCapacity *= 2;
+        }
+        got = recv(board->fd, board->in + board->inLength, board->inCapacity - board->inLength - 1, 0);
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        if (got <= 0) {
+            // A kept connection the board dropped between rounds: retry once
+            if (board->reused && board->request == REQUEST_STATUS && board->inLength == 0) {
+                closeConnection(board);
+                board->reused = false;
+                if (!openConnection(board)) {
+                    finishBoard(board, "connect failed");
+                }
+            } else {
+                finishBoard(board, "connection closed");
+            }
+            return;
+        }
+        board->inLength += (size_t)got;
+        board->in[board->inLength] = '\0';
+        complete = responseLength(board, &status, &bodyOffset, &keepAlive);
+        if (complete < 0) {
+            finishBoard(board, "malformed response");
+            return;
+        }
+        if (complete == 0) {
+            continue;
+        }
+        error = handleResponse(board, status, board->in + bodyOffset, (size_t)complete - bodyOffset);
+        if (error != NULL) {
+            finishBoard(board, error);
+            return;
+        }
+        if (board->request + 1 < REQUEST_COUNT) {
+            board->request++;
+            if (!keepAlive) {
+                closeConnection(board);
+                if (!openConnection(board)) {
+                    finishBoard(board, "connect failed");
+                }
+            } else if (!sendRequest(board)) {
+                finishBoard(board, "send failed");
+            }
+            return;
+        }
+        finishBoard(board, NULL);
+        if (keepAlive) {
+            board->conn = CONN_IDLE;
+            watchConnection(board, EPOLLRDHUP);
+        } else {
+            closeConnection(board);
+        }
+        return;
+    }
+}
+
+static void handleEvent(FleetBoard *board, uint32_t events) {
+    int error = 0;
+    socklen_t length = sizeof(error);
+
+    switch (board->conn) {
+    case CONN_CONNECTING:
+        if (getsockopt(board->fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+            finishBoard(board, "connect failed");
+        } else if (!sendRequest(board)) {
+            finishBoard(board, "send failed");
+        }
+        break;
+    case CONN_READING:
+        readBoard(board);
+        break;
+    case CONN_IDLE:
+        // Nothing is expected between rounds; the board is closing
+        (void)events;
+        closeConnection(board);
+        break;
+    default:
+        break;
+    }
+}
+
+static void writeResult(JsonWriter *writer, const FleetBoard *board, uint64_t nowNs, bool countDown) {
+    const FleetResult *result = &board->result;
+
+    jsonKey(writer, "status");
+    jsonBeginObject(writer);
+    jsonFieldUint(writer, "watchdog_id", result->watchdogId);
+    jsonFieldBool(writer, "running", result->running);
+    jsonFieldBool(writer, "susi_initialized", result->susiInitialized);
+    jsonFieldUint(writer, "feed_count", result->feedCount);
+    if (result->hasRemaining) {
+        // The cached view shows the answer as given at scraped_ms
+        int64_t sinceMs = countDown ? (int64_t)((nowNs - board->scrapedNs) / 1000000) : 0;
+
+        jsonFieldInt(writer, "remaining_to_reset_ms", result->remainingMs - sinceMs);
+    }
+    if (result->hasMinSlack) {
+        jsonFieldInt(writer, "min_slack_ms", result->minSlackMs);
+    }
+    jsonEndObject(writer);
+    jsonKey(writer, "sensors");
+    jsonBeginArray(writer);
+    for (int i = 0; i < result->sensorCount; i++) {
+        const FleetSensor *sensor = &result->sensors[i];
+
+        jsonBeginObject(writer);
+        jsonFieldString(writer, "name", sensor->name);
+        jsonFieldString(writer, "kind", sensor->kind);
+        jsonFieldString(writer, "unit", sensor->unit);
+        jsonKey(writer, "value");
+        if (sensor->valid) {
+            jsonDouble(writer, sensor->value, 3);
+        } else {
+            jsonNull(writer);
+        }
+        if (sensor->stale) {
+            jsonFieldBool(writer, "stale", true);
+        }
+        jsonEndObject(writer);
+    }
+    jsonEndArray(writer);
+}
+
+typedef struct {
+    int state;                  // -1 any, 0 down, 1 up
+    int running;                // -1 any
+    bool hasSlack;
+    int64_t slackBelowMs;
+    const char *sensor;
+    bool hasAbove;
+    bool hasBelow;
+    double above;
+    double below;
+} FleetFilter;
+
+static bool boardMatches(const FleetBoard *board, const FleetFilter *filter, uint64_t nowNs) {
+    const FleetResult *result = &board->result;
+
+    if (filter->state >= 0 && board->up != (filter->state == 1)) {
+        return false;
+    }
+    if (filter->running >= 0 && (!board->scraped || result->running != (filter->running == 1))) {
+        return false;
+    }
+    if (filter->hasSlack &&
+        (!board->scraped || !result->hasRemaining ||
+         result->remainingMs - (int64_t)((nowNs - board->scrapedNs) / 1000000) >= filter->slackBelowMs)) {
+        return false;
+    }
+    if (filter->sensor != NULL) {
+        bool found = false;
+
+        for (int i = 0; board->scraped && i < result->sensorCount && !found; i++) {
+            const FleetSensor *sensor = &result->sensors[i];
+
+            found = strcmp(sensor->name, filter->sensor) == 0 && sensor->valid &&
+                    (!filter->hasAbove || sensor->value > filter->above) &&
+                    (!filter->hasBelow || sensor->value < filter->below);
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Called with fleetLock held
+static void renderView(JsonWriter *writer, const FleetFilter *filter, bool countDown) {
+    uint64_t nowNs = monotonicNowNs();
+    char address[sizeof(boards[0].host) + sizeof(boards[0].port)];
+    int up = 0;
+
+    for (int i = 0; i < boardCount; i++) {
+        up += boards[i].up;
+    }
+    jsonBeginObject(writer);
+    jsonFieldUint(writer, "timestamp_ms", wallNowMs());
+    jsonFieldUint(writer, "round", __atomic_load_n(&rounds, __ATOMIC_RELAXED));
+    jsonFieldUint(writer, "interval_ms", roundIntervalMs);
+    jsonFieldUint(writer, "boards_total", (uint64_t)boardCount);
+    jsonFieldUint(writer, "boards_up", (uint64_t)up);
+    jsonKey(writer, "boards");
+    jsonBeginArray(writer);
+    for (int i = 0; i < boardCount; i++) {
+        const FleetBoard *board = &boards[i];
+
+        if (filter != NULL && !boardMatches(board, filter, nowNs)) {
+            continue;
+        }
+        jsonBeginObject(writer);
+        jsonFieldString(writer, "name", board->name);
+        snprintf(address, sizeof(address), "%s:%s", board->host, board->port);
+        jsonFieldString(writer, "address", address);
+        jsonFieldBool(writer, "up", board->up);
+        if (!board->up && board->error[0] != '\0') {
+            jsonFieldString(writer, "error", board->error);
+        }
+        if (board->scraped) {
+            jsonFieldUint(writer, "scraped_ms", board->scrapedMs);
+            writeResult(writer, board, nowNs, countDown);
+        }
+        jsonEndObject(writer);
+    }
+    jsonEndArray(writer);
+    jsonEndObject(writer);
+}
+
+static void publishView(void) {
+    StrBuf out;
+    JsonWriter writer;
+    size_t capacity;
+    char *data = snapshotBegin(&fleetSnapshot, &capacity);
+
+    if (data == NULL) {
+        __atomic_fetch_add(&viewsSkipped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    for (;;) {
+        strbufInit(&out, data, capacity);
+        jsonWriterInit(&writer, &out);
+        pthread_mutex_lock(&fleetLock);
+        renderView(&writer, NULL, false);
+        pthread_mutex_unlock(&fleetLock);
+        strbufAppendChar(&out, '\n');
+        if (!out.overflow) {
+            break;
+        }
+        if (!snapshotGrow(&fleetSnapshot, capacity * 2)) {
+            snapshotAbort(&fleetSnapshot);
+            return;
+        }
+        data = snapshotBegin(&fleetSnapshot, &capacity);
+        if (data == NULL) {
+            return;
+        }
+    }
+    snapshotPublish(&fleetSnapshot, out.length);
+}
+
+static void* scraperMain(void *arg) {
+    struct epoll_event events[64];
+    uint64_t nextRoundNs = monotonicNowNs();
+    uint64_t roundStartNs = 0;
+    bool inRound = false;
+    (void)arg;
+
+    pthread_setname_np(pthread_self(), "fleet");
+    for (;;) {
+        uint64_t now = monotonicNowNs();
+        uint64_t wakeNs = inRound ? UINT64_MAX : nextRoundNs;
+        int timeoutMs;
+        int count;
+        bool busy = false;
+
+        if (!inRound && now >= nextRoundNs) {
+            inRound = true;
+            roundStartNs = now;
+            nextRoundNs += roundIntervalMs * 1000000ull;
+            if (nextRoundNs <= now) {
+                nextRoundNs = now + roundIntervalMs * 1000000ull;
+            }
+            for (int i = 0; i < boardCount; i++) {
+                startBoard(&boards[i]);
+            }
+        }
+        for (int i = 0; i < boardCount; i++) {
+            if (boards[i].busy && now >= boards[i].deadlineNs) {
+                finishBoard(&boards[i], "timeout");
+            }
+            if (boards[i].busy) {
+                busy = true;
+                wakeNs = boards[i].deadlineNs < wakeNs ? boards[i].deadlineNs : wakeNs;
+            }
+        }
+        if (inRound && !busy) {
+            inRound = false;
+            __atomic_store_n(&lastRoundNs, monotonicNowNs() - roundStartNs, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&rounds, 1, __ATOMIC_RELAXED);
+            publishView();
+            wakeNs = nextRoundNs;
+        }
+
+        now = monotonicNowNs();
+        timeoutMs = wakeNs <= now ? 0 : (int)((wakeNs - now + 999999) / 1000000);
+        count = epoll_wait(epollFd, events, 64, timeoutMs);
+        for (int i = 0; i < count; i++) {
+            FleetBoard *board;
+
+            if (events[i].data.u64 == FLEET_STOP_EVENT) {
+                return NULL;
+            }
+            board = &boards[(uint32_t)events[i].data.u64];
+            if (board->fd >= 0 && eventKey(board) == events[i].data.u64) {
+                handleEvent(board, events[i].events);
+            }
+        }
+    }
+}
+
+bool fleetStart(uint32_t intervalMs) {
+    struct epoll_event event;
+
+    if (boardCount == 0) {
+        return true;
+    }
+    roundIntervalMs = intervalMs > 0 ? intervalMs : FLEET_DEFAULT_INTERVAL_MS;
+    timeoutNs = (roundIntervalMs < FLEET_TIMEOUT_MS ? roundIntervalMs : FLEET_TIMEOUT_MS) * 1000000ull;
+    for (int i = 0; i < boardCount; i++) {
+        boards[i].in = malloc(FLEET_BUFFER_INITIAL);
+        boards[i].inCapacity = FLEET_BUFFER_INITIAL;
+        if (boards[i].in == NULL) {
+            return false;
+        }
+        if (!resolveBoard(&boards[i])) {
+            printf("fleet: cannot resolve %s, retrying every round\n", boards[i].host);
+        }
+    }
+    if (!snapshotInit(&fleetSnapshot, FLEET_SNAPSHOT_CAPACITY, "application/json", "fleet")) {
+        return false;
+    }
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    stopFd = eventfd(0, EFD_CLOEXEC);
+    if (epollFd < 0 || stopFd < 0) {
+        perror("fleet: epoll/eventfd");
+        return false;
+    }
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = FLEET_STOP_EVENT;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, stopFd, &event) != 0 ||
+        pthread_create(&scraperThread, NULL, scraperMain, NULL) != 0) {
+        perror("fleet: start");
+        return false;
+    }
+    fleetActive = true;
+    printf("Fleet: scraping %d boards every %u ms\n", boardCount, roundIntervalMs);
+    return true;
+}
+
+void fleetStop(void) {
+    uint64_t one = 1;
+
+    if (!fleetActive) {
+        return;
+    }
+    if (write(stopFd, &one, sizeof(one)) != sizeof(one)) {
+        perror("fleet: stop");
+    }
+    pthread_join(scraperThread, NULL);
+    fleetActive = false;
+    for (int i = 0; i < boardCount; i++) {
+        closeConnection(&boards[i]);
+    }
+    close(epollFd);
+    close(stopFd);
+}
+
+static enum MHD_Result queueFleetError(struct MHD_Connection *connection, const char *message) {
+    ResponseBuffer body;
+    JsonWriter writer;
+
+    if (!responseBufferAcquire(&body)) {
+        return MHD_NO;
+    }
+    responseWriterInit(&writer, &body, connection);
+    jsonBeginObject(&writer);
+    jsonFieldString(&writer, "error", message);
+    jsonEndObject(&writer);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+static bool parseNumber(const char *text, double *value) {
+    char *end;
+
+    if (text == NULL) {
+        return false;
+    }
+    *value = strtod(text, &end);
+    return end != text && *end == '\0';
+}
+
+enum MHD_Result fleetQueueResponse(struct MHD_Connection *connection) {
+    FleetFilter filter = { -1, -1, false, 0, NULL, false, false, 0, 0 };
+    const char *state = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "state");
+    const char *running = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "running");
+    const char *slack = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "slack_below_ms");
+    const char *above = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "above");
+    const char *below = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "below");
+    ResponseBuffer body;
+    JsonWriter writer;
+    size_t capacity = 1024;
+    double number;
+
+    if (!fleetActive) {
+        return queueFleetError(connection, "No fleet boards configured");
+    }
+    filter.sensor = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "sensor");
+    if (state == NULL && running == NULL && slack == NULL && filter.sensor == NULL) {
+        if (snapshotQueue(&fleetSnapshot, connection) == MHD_YES) {
+            return MHD_YES;
+        }
+        return queueFleetError(connection, "No round has completed yet");
+    }
+    if (state != NULL) {
+        if (strcmp(state, "up") != 0 && strcmp(state, "down") != 0) {
+            return queueFleetError(connection, "state must be up or down");
+        }
+        filter.state = strcmp(state, "up") == 0;
+    }
+    if (running != NULL) {
+        if (strcmp(running, "0") != 0 && strcmp(running, "1") != 0) {
+            return queueFleetError(connection, "running must be 0 or 1");
+        }
+        filter.running = running[0] == '1';
+    }
+    if (slack != NULL) {
+        if (!parseNumber(slack, &number)) {
+            return queueFleetError(connection, "Invalid slack_below_ms");
+        }
+        filter.hasSlack = true;
+        filter.slackBelowMs = (int64_t)number;
+    }
+    if ((above != NULL || below != NULL) && filter.sensor == NULL) {
+        return queueFleetError(connection, "above and below need a sensor");
+    }
+    if ((above != NULL && !parseNumber(above, &filter.above)) || (below != NULL && !parseNumber(below, &filter.below))) {
+        return queueFleetError(connection, "Invalid above or below");
+    }
+    filter.hasAbove = above != NULL;
+    filter.hasBelow = below != NULL;
+
+    // Sized for every board with every sensor, under the same lock as the render
+    pthread_mutex_lock(&fleetLock);
+    for (int i = 0; i < boardCount; i++) {
+        capacity += 384 + (size_t)boards[i].result.sensorCount * 128;
+    }
+    if (!responseBufferAcquireSize(&body, capacity)) {
+        pthread_mutex_unlock(&fleetLock);
+        return MHD_NO;
+    }
+    responseWriterInit(&writer, &body, connection);
+    renderView(&writer, &filter, true);
+    pthread_mutex_unlock(&fleetLock);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+void fleetCollectMetrics(StrBuf *out, void *ctx) {
+    uint64_t ok = 0;
+    uint64_t failed = 0;
+    int up = 0;
+    (void)ctx;
+
+    if (!fleetActive) {
+        return;
+    }
+    pthread_mutex_lock(&fleetLock);
+    metricsHeader(out, "watchdog_fleet_board_up", "gauge", "Whether the board answered in the last round");
+    for (int i = 0; i < boardCount; i++) {
+        strbufAppendf(out, "watchdog_fleet_board_up{board=\"%s\"} %d\n", boards[i].name, boards[i].up ? 1 : 0);
+        up += boards[i].up;
+        ok += boards[i].scrapesOk;
+        failed += boards[i].scrapesFailed;
+    }
+    metricsHeader(out, "watchdog_fleet_board_remaining_to_reset_seconds", "gauge",
+                  "Time the board's default timer had left before reset when last scraped");
+    for (int i = 0; i < boardCount; i++) {
+        if (boards[i].scraped && boards[i].result.hasRemaining) {
+            strbufAppendf(out, "watchdog_fleet_board_remaining_to_reset_seconds{board=\"%s\"} %.3f\n", boards[i].name,
+                          boards[i].result.remainingMs / 1000.0);
+        }
+    }
+    pthread_mutex_unlock(&fleetLock);
+    metricsHeader(out, "watchdog_fleet_boards", "gauge", "Fleet boards by the outcome of their last round");
+    strbufAppendf(out, "watchdog_fleet_boards{state=\"up\"} %d\n", up);
+    strbufAppendf(out, "watchdog_fleet_boards{state=\"down\"} %d\n", boardCount - up);
+    metricsHeader(out, "watchdog_fleet_scrapes_total", "counter", "Board scrapes by outcome");
+    strbufAppendf(out, "watchdog_fleet_scrapes_total{result=\"ok\"} %llu\n", (unsigned long long)ok);
+    strbufAppendf(out, "watchdog_fleet_scrapes_total{result=\"failed\"} %llu\n", (unsigned long long)failed);
+    metricsHeader(out, "watchdog_fleet_rounds_total", "counter", "Completed scrape rounds");
+    strbufAppendf(out, "watchdog_fleet_rounds_total %llu\n", (unsigned long long)__atomic_load_n(&rounds, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_fleet_round_seconds", "gauge", "Duration of the last round, set by its slowest board");
+    strbufAppendf(out, "watchdog_fleet_round_seconds %.6f\n", __atomic_load_n(&lastRoundNs, __ATOMIC_RELAXED) / 1e9);
+    metricsHeader(out, "watchdog_fleet_connections_opened_total", "counter",
+                  "Connections opened to boards; far below requests while keep-alive holds");
+    strbufAppendf(out, "watchdog_fleet_connections_opened_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&connectionsOpened, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_fleet_requests_total", "counter", "Requests sent to boards");
+    strbufAppendf(out, "watchdog_fleet_requests_total %llu\n", (unsigned long long)__atomic_load_n(&requestsSent, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_fleet_views_skipped_total", "counter", "Rounds whose view was not published because readers held both buffers");
+    strbufAppendf(out, "watchdog_fleet_views_skipped_total %llu\n", (unsigned long long)__atomic_load_n(&viewsSkipped, __ATOMIC_RELAXED));
+}
@@ -0,0 +1,47 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <microhttpd.h>
+#include "strbuf.h"
+
+#define FLEET_MAX_BOARDS 1024
+#define FLEET_MAX_SENSORS 48             // Per board; further sensors are not kept
+#define FLEET_DEFAULT_PORT 9101
+#define FLEET_DEFAULT_INTERVAL_MS 5000
+#define FLEET_TIMEOUT_MS 2000            // Per board and round: connect plus both requests
+#define FLEET_RESPONSE_MAX (256 * 1024)
+
+// The gateway side of a fleet: other boards' watchdog_http_service
+// instances scraped in rounds. One thread drives every board through
+// non-blocking sockets and epoll, so a round takes as long as the slowest
+// board rather than the sum of them. Each board keeps one HTTP/1.1
+// keep-alive connection over which GET /api/status and GET /api/hwm are
+// sent in turn; it is only reopened after the board closes it or misses
+// FLEET_TIMEOUT_MS. The results are merged into one table: GET /api/fleet
+// serves a view rendered once per round, and filtered queries are answered
+// from the table, so no request ever reaches a board.
+
+// [NAME=]HOST[:PORT] before fleetStart(); the name defaults to HOST[:PORT]
+bool fleetAddBoard(const char *spec);
+// One spec per line; blank lines and # comments are skipped
+bool fleetLoadBoards(const char *path);
+int fleetBoardCount(void);
+
+// Start scraping every intervalMs; does nothing and returns true without boards
+bool fleetStart(uint32_t intervalMs);
+void fleetStop(void);
+
+// GET /api/fleet. Without a query the cached view; with one, the boards that
+// match every given filter, rendered from the table:
+//   state=up|down        board answered in its last round or not
+//   running=0|1          default timer running
+//   slack_below_ms=N     running timer with less than N ms left before reset,
+//                        counted down from its last answer
+//   sensor=NAME&above=X|below=X  sensor value beyond X in its own unit
+enum MHD_Result fleetQueueResponse(struct MHD_Connection *connection);
+
+void fleetCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // FLEET_H
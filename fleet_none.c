@@ -0,0 +1,49 @@
+#include <stdio.h>
+#include "fleet.h"
+#include "json_writer.h"
+#include "response_pool.h"
+
+// Fleet API for builds without jansson (the small profile): a board that
+// is scraped needs none of it, so no boards can be added and /api/fleet
+// answers as on a board without any.
+
+bool fleetAddBoard(const char *spec) {
+    (void)spec;
+    printf("Fleet gateway not available in this build\n");
+    return false;
+}
+
+bool fleetLoadBoards(const char *path) {
+    return fleetAddBoard(path);
+}
+
+int fleetBoardCount(void) {
+    return 0;
+}
+
+bool fleetStart(uint32_t intervalMs) {
+    (void)intervalMs;
+    return true;
+}
+
+void fleetStop(void) {
+}
+
+enum MHD_Result fleetQueueResponse(struct MHD_Connection *connection) {
+    ResponseBuffer body;
+    JsonWriter writer;
+
+    if (!responseBufferAcquire(&body)) {
+        return MHD_NO;
+    }
+    responseWriterInit(&writer, &body, connection);
+    jsonBeginObject(&writer);
+    jsonFieldString(&writer, "error", "No fleet boards configured");
+    jsonEndObject(&writer);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+void fleetCollectMetrics(StrBuf *out, void *ctx) {
+    (void)out;
+    (void)ctx;
+}
@@ -0,0 +1,190 @@
+#include <stdio.h>
+#include <string.h>
+#include "gpio_bank.h"
+#include "hw_actor.h"
+#include "susi_caps.h"
+#include "susi_timing.h"
+#include "timeutil.h"
+
+// Only touched on the hardware thread after gpioBankInit()
+static GpioBankState banks[GPIO_BANK_MAX];
+static int bankCount = 0;
+
+static const char *resultTexts[GPIO_BANK_RESULT_COUNT] = {
+    [GPIO_BANK_OK]            = "OK",
+    [GPIO_BANK_UNKNOWN]       = "Unknown GPIO bank",
+    [GPIO_BANK_BAD_MASK]      = "Mask selects no pins or pins the bank does not have",
+    [GPIO_BANK_BAD_DIRECTION] = "Direction not supported by the selected pins",
+    [GPIO_BANK_NOT_OUTPUT]    = "Level written to pins that are not outputs",
+    [GPIO_BANK_HARDWARE]      = "GPIO driver call failed",
+};
+
+const char* gpioBankResultText(GpioBankResult result) {
+    return result < GPIO_BANK_RESULT_COUNT ? resultTexts[result] : "Unknown error";
+}
+
+static SusiStatus_t getCaps(SusiId_t id, uint32_t item, uint32_t *mask) {
+    return susiCapsGet(SUSI_CAPS_GPIO, id, item, mask);
+}
+
+static void hwProbe(void *arg) {
+    uint64_t start;
+    (void)arg;
+
+    for (uint32_t bank = 0; bank < GPIO_BANK_MAX; bank++) {
+        SusiId_t id = SUSI_ID_GPIO_BANK(bank);
+        GpioBankState *state = &banks[bankCount];
+        uint32_t pins;
+
+        memset(state, 0, sizeof(*state));
+        state->bank = bank;
+        getCaps(id, SUSI_ID_GPIO_INPUT_SUPPORT, &state->inputs);
+        getCaps(id, SUSI_ID_GPIO_OUTPUT_SUPPORT, &state->outputs);
+        getCaps(id, SUSI_ID_GPIO_INTERRUPT_SUPPORT, &state->interrupts);
+        pins = state->inputs | state->outputs;
+        if (pins == 0) {
+            continue;
+        }
+        start = monotonicNowNs();
+        state->status = SusiGPIOGetDirection(id, pins, &state->direction);
+        susiTimingRecord(SUSI_CALL_GPIO_GET_DIRECTION, start, state->status);
+        if (state->status != SUSI_STATUS_SUCCESS) {
+            printf("Warning: GPIO bank %u direction unknown (status 0x%x)\n", bank, (unsigned int)state->status);
+            state->direction = 0;
+        }
+        bankCount++;
+    }
+}
+
+bool gpioBankInit(void) {
+    bankCount = 0;
+    if (!hwActorCall(HW_LANE_READ, hwProbe, NULL)) {
+        return false;
+    }
+    for (int i = 0; i < bankCount; i++) {
+        printf("GPIO bank %u: inputs 0x%08x outputs 0x%08x interrupts 0x%08x\n", banks[i].bank,
+               banks[i].inputs, banks[i].outputs, banks[i].interrupts);
+    }
+    return true;
+}
+
+int gpioBankCount(void) {
+    return bankCount;
+}
+
+// Levels under the bank's full pin mask, one driver call
+static void readLevel(GpioBankState *state) {
+    uint64_t start = monotonicNowNs();
+
+    state->status = SusiGPIOGetLevel(SUSI_ID_GPIO_BANK(state->bank), state->inputs | state->outputs, &state->level);
+    susiTimingRecord(SUSI_CALL_GPIO_GET_LEVEL, start, state->status);
+    if (state->status != SUSI_STATUS_SUCCESS) {
+        state->level = 0;
+    }
+}
+
+static void hwReadAll(void *arg) {
+    GpioBankState *states = (GpioBankState *)arg;
+
+    for (int i = 0; i < bankCount; i++) {
+        readLevel(&banks[i]);
+        states[i] = banks[i];
+    }
+}
+
+int gpioBankRead(GpioBankState *states) {
+    // Concurrent scrapes of /api/gpio share one pass over the banks
+    if (bankCount == 0 ||
+        !hwActorCallShared(HW_LANE_READ, 0, hwReadAll, states, states, (size_t)bankCount * sizeof(GpioBankState))) {
+        return 0;
+    }
+    return bankCount;
+}
+
+GpioBankResult hwGpioBankRead(uint32_t bank, GpioBankState *state) {
+    for (int i = 0; i < bankCount; i++) {
+        if (banks[i].bank == bank) {
+            readLevel(&banks[i]);
+            *state = banks[i];
+            return banks[i].status == SUSI_STATUS_SUCCESS ? GPIO_BANK_OK : GPIO_BANK_HARDWARE;
+        }
+    }
+    return GPIO_BANK_UNKNOWN;
+}
+
+typedef struct {
+    uint32_t bank;
+    uint32_t mask;
+    bool setDirection;
+    uint32_t direction;
+    bool writeLevel;
+    uint32_t level;
+    GpioBankState *state;
+    GpioBankResult result;
+} GpioBankWrite;
+
+static void hwWrite(void *arg) {
+    GpioBankWrite *request = (GpioBankWrite *)arg;
+    GpioBankState *state = NULL;
+    uint32_t inputs;
+    uint64_t start;
+    SusiStatus_t status;
+
+    for (int i = 0; i < bankCount; i++) {
+        if (banks[i].bank == request->bank) {
+            state = &banks[i];
+        }
+    }
+    if (state == NULL) {
+        request->result = GPIO_BANK_UNKNOWN;
+        return;
+    }
+    if (request->mask == 0 || (request->mask & ~(state->inputs | state->outputs)) != 0) {
+        request->result = GPIO_BANK_BAD_MASK;
+        return;
+    }
+    inputs = request->setDirection ? request->direction & request->mask : state->direction & request->mask;
+    if (request->setDirection &&
+        ((inputs & ~state->inputs) != 0 || (request->mask & ~inputs & ~state->outputs) != 0)) {
+        request->result = GPIO_BANK_BAD_DIRECTION;
+        return;
+    }
+    if (request->writeLevel && inputs != 0) {
+        request->result = GPIO_BANK_NOT_OUTPUT;
+        return;
+    }
+
+    request->result = GPIO_BANK_OK;
+    if (request->setDirection) {
+        start = monotonicNowNs();
+        status = SusiGPIOSetDirection(SUSI_ID_GPIO_BANK(state->bank), request->mask, request->direction);
+        susiTimingRecord(SUSI_CALL_GPIO_SET_DIRECTION, start, status);
+        if (status != SUSI_STATUS_SUCCESS) {
+            request->result = GPIO_BANK_HARDWARE;
+        } else {
+            state->direction = (state->direction & ~request->mask) | inputs;
+        }
+    }
+    if (request->result == GPIO_BANK_OK && request->writeLevel) {
+        start = monotonicNowNs();
+        status = SusiGPIOSetLevel(SUSI_ID_GPIO_BANK(state->bank), request->mask, request->level);
+        susiTimingRecord(SUSI_CALL_GPIO_SET_LEVEL, start, status);
+        if (status != SUSI_STATUS_SUCCESS) {
+            request->result = GPIO_BANK_HARDWARE;
+        }
+    }
+    readLevel(state);
+    if (request->state != NULL) {
+        *request->state = *state;
+    }
+}
+
+GpioBankResult gpioBankWrite(uint32_t bank, uint32_t mask, bool setDirection, uint32_t direction,
+                             bool writeLevel, uint32_t level, GpioBankState *state) {
+    GpioBankWrite request = { bank, mask, setDirection, direction, writeLevel, level, state, GPIO_BANK_UNKNOWN };
+
+    if (!hwActorCall(HW_LANE_CONFIG, hwWrite, &request)) {
+        return GPIO_BANK_HARDWARE;
+    }
+    return request.result;
+}
@@ -0,0 +1,56 @@
+#ifndef GPIO_BANK_H
+#define GPIO_BANK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "Susi4.h"
+
+#define GPIO_BANK_MAX 4                  // Banks probed at startup, 32 GPIOs each
+
+// Bank-wide GPIO access for /api/gpio. Every operation addresses a whole
+// bank (SUSI_ID_GPIO_BANK) with a bitmask, so reading all levels costs one
+// driver call per bank instead of a level and a direction call per pin.
+// Capabilities are probed once; directions only change through this module
+// (all SUSI access goes through the hardware thread), so they are cached and
+// a read is a single SusiGPIOGetLevel per bank.
+
+typedef struct {
+    uint32_t bank;
+    uint32_t inputs;                 // Pins that support input
+    uint32_t outputs;                // Pins that support output
+    uint32_t interrupts;             // Pins that can raise interrupts
+    uint32_t direction;              // Bit set = input (SUSI_GPIO_INPUT)
+    uint32_t level;                  // Bit set = high, as of the last read
+    SusiStatus_t status;             // Result of the last read
+} GpioBankState;
+
+typedef enum {
+    GPIO_BANK_OK,
+    GPIO_BANK_UNKNOWN,               // Not a bank found at startup
+    GPIO_BANK_BAD_MASK,              // Empty mask or pins the bank does not have
+    GPIO_BANK_BAD_DIRECTION,         // Direction the pins do not support
+    GPIO_BANK_NOT_OUTPUT,            // Level written to an input pin
+    GPIO_BANK_HARDWARE,              // The driver call failed
+    GPIO_BANK_RESULT_COUNT
+} GpioBankResult;
+
+// Probe banks 0..GPIO_BANK_MAX-1 through the hardware thread
+bool gpioBankInit(void);
+int gpioBankCount(void);
+
+// Read the levels of every bank in one hardware command; fills up to
+// GPIO_BANK_MAX states and returns how many
+int gpioBankRead(GpioBankState *states);
+// Read one bank's levels from a command already on the hardware thread;
+// GPIO_BANK_UNKNOWN for a bank not found at startup
+GpioBankResult hwGpioBankRead(uint32_t bank, GpioBankState *state);
+
+// Within mask of bank: set the direction first if setDirection, then drive
+// level if writeLevel (every pin of mask must be an output by then). One
+// hardware command; state receives the bank as it is afterwards.
+GpioBankResult gpioBankWrite(uint32_t bank, uint32_t mask, bool setDirection, uint32_t direction,
+                             bool writeLevel, uint32_t level, GpioBankState *state);
+
+const char* gpioBankResultText(GpioBankResult result);
+
+#endif // GPIO_BANK_H
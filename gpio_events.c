@@ -0,0 +1,337 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "gpio_events.h"
+#include "control_socket.h"
+#include "events.h"
+#include "hw_actor.h"
+#include "histogram.h"
+#include "json_writer.h"
+#include "metrics.h"
+#include "susi_timing.h"
+#include "timeutil.h"
+#include "webhook.h"
+
+typedef struct {
+    uint32_t pin;
+    uint32_t bounces;                // Edges suppressed on this pin since the previous one
+    uint64_t sequence;
+    uint64_t rawNs;                  // CLOCK_MONOTONIC_RAW of the accepted edge
+    uint64_t realtimeMs;
+} GpioEdgeRecord;
+
+typedef struct {
+    uint32_t pin;
+    GpioEdge edge;
+    uint64_t debounceNs;
+    bool armed;
+    // Only touched by the callback
+    uint64_t lastAcceptedNs;
+    uint64_t bouncesReported;
+    // Counters for /metrics
+    uint64_t bounces;                // Suppressed by the debounce window
+    uint64_t edges;                  // Dispatched, only written by the dispatcher
+} GpioPin;
+
+// The callback owns tail, the dispatcher owns head; each on its own line
+static GpioEdgeRecord ring[GPIO_EVENT_RING];
+static uint64_t ringTail __attribute__((aligned(64))) = 0;
+static uint64_t ringHead __attribute__((aligned(64))) = 0;
+static uint64_t overflows __attribute__((aligned(64))) = 0;
+static uint64_t sequence = 0;        // Accepted edges, numbered by the callback
+
+static GpioPin pins[GPIO_EVENT_MAX_PINS];
+static int pinCount = 0;
+static uint64_t unknownEdges = 0;    // Interrupts for a pin that was not armed here
+
+static pthread_t dispatcherThread;
+static bool gpioActive = false;
+static bool callbackRegistered = false;
+static int wakeFd = -1;
+static int stopFd = -1;
+static Histogram dispatchLatency;    // Interrupt to fan-out complete
+
+// The pin table is fixed once the callback is registered
+static GpioPin* findPin(uint32_t pin) {
+    for (int i = 0; i < pinCount; i++) {
+        if (pins[i].pin == pin) {
+            return &pins[i];
+        }
+    }
+    return NULL;
+}
+
+// Runs in the driver's interrupt thread. An edge inside the pin's debounce
+// window (measured from the last accepted edge) is only counted and never
+// wakes the dispatcher. Accepted edges are numbered before the ring check,
+// so a gap in the sequence tells consumers an edge was lost to a full ring.
+static void SUSI_API gpioCallback(void *context) {
+    uint64_t now = monotonicRawNowNs();
+    GpioPin *pin = findPin((uint32_t)(uintptr_t)context);
+    uint64_t tail = __atomic_load_n(&ringTail, __ATOMIC_RELAXED);
+    uint64_t bounces;
+    GpioEdgeRecord *record;
+    struct timespec wall;
+    uint64_t one = 1;
+    ssize_t written;
+
+    if (pin == NULL) {
+        __atomic_fetch_add(&unknownEdges, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    if (pin->lastAcceptedNs != 0 && now - pin->lastAcceptedNs < pin->debounceNs) {
+        __atomic_fetch_add(&pin->bounces, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    pin->lastAcceptedNs = now;
+    bounces = __atomic_load_n(&pin->bounces, __ATOMIC_RELAXED);
+    sequence++;
+
+    if (tail - __atomic_load_n(&ringHead, __ATOMIC_ACQUIRE) >= GPIO_EVENT_RING) {
+        __atomic_fetch_add(&overflows, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    record = &ring[tail & (GPIO_EVENT_RING - 1)];
+    record->pin = pin->pin;
+    record->bounces = (uint32_t)(bounces - pin->bouncesReported);
+    record->sequence = sequence;
+    record->rawNs = now;
+    clock_gettime(CLOCK_REALTIME, &wall);
+    record->realtimeMs = (uint64_t)wall.tv_sec * 1000ull + (uint64_t)wall.tv_nsec / 1000000ull;
+    pin->bouncesReported = bounces;
+    __atomic_store_n(&ringTail, tail + 1, __ATOMIC_RELEASE);
+    written = write(wakeFd, &one, sizeof(one));
+    (void)written;
+}
+
+bool gpioEventsAddPin(uint32_t pin, GpioEdge edge, uint32_t debounceUs) {
+    GpioPin *entry = findPin(pin);
+
+    if (gpioActive || (entry == NULL && pinCount >= GPIO_EVENT_MAX_PINS)) {
+        return false;
+    }
+    if (entry == NULL) {
+        entry = &pins[pinCount++];
+        memset(entry, 0, sizeof(*entry));
+        entry->pin = pin;
+    }
+    entry->edge = edge;
+    entry->debounceNs = (uint64_t)debounceUs * 1000ull;
+    return true;
+}
+
+static void hwArm(void *arg) {
+    bool *ok = (bool *)arg;
+    uint64_t start;
+    SusiStatus_t status;
+
+    for (int i = 0; i < pinCount; i++) {
+        SusiId_t id = SUSI_ID_GPIO(pins[i].pin);
+
+        start = monotonicNowNs();
+        status = SusiGPIOIntSetEdge(id, 1, pins[i].edge);
+        susiTimingRecord(SUSI_CALL_GPIO_INT_SET_EDGE, start, status);
+        if (status == SUSI_STATUS_SUCCESS) {
+            start = monotonicNowNs();
+            status = SusiGPIOIntSetPin(id, 1, 1);
+            susiTimingRecord(SUSI_CALL_GPIO_INT_SET_PIN, start, status);
+        }
+        pins[i].armed = status == SUSI_STATUS_SUCCESS;
+        if (!pins[i].armed) {
+            printf("Warning: GPIO %u cannot raise interrupts (status 0x%x)\n", pins[i].pin, (unsigned int)status);
+        }
+    }
+    start = monotonicNowNs();
+    status = SusiGPIOIntRegister(gpioCallback);
+    susiTimingRecord(SUSI_CALL_GPIO_INT_REGISTER, start, status);
+    callbackRegistered = status == SUSI_STATUS_SUCCESS;
+    if (!callbackRegistered) {
+        printf("Warning: GPIO interrupt callback not available (status 0x%x)\n", (unsigned int)status);
+    }
+    *ok = callbackRegistered;
+}
+
+static void hwDisarm(void *arg) {
+    uint64_t start;
+    SusiStatus_t status;
+    (void)arg;
+
+    if (callbackRegistered) {
+        start = monotonicNowNs();
+        status = SusiGPIOIntUnRegister();
+        susiTimingRecord(SUSI_CALL_GPIO_INT_UNREGISTER, start, status);
+        callbackRegistered = false;
+    }
+    for (int i = 0; i < pinCount; i++) {
+        if (pins[i].armed) {
+            start = monotonicNowNs();
+            status = SusiGPIOIntSetPin(SUSI_ID_GPIO(pins[i].pin), 1, 0);
+            susiTimingRecord(SUSI_CALL_GPIO_INT_SET_PIN, start, status);
+            pins[i].armed = false;
+        }
+    }
+}
+
+static void dispatch(const GpioEdgeRecord *record) {
+    char body[WEBHOOK_BODY_MAX];
+    StrBuf out;
+    JsonWriter writer;
+    GpioPin *pin = findPin(record->pin);
+    uint64_t latencyUs = (monotonicRawNowNs() - record->rawNs) / 1000;
+
+    __atomic_fetch_add(&pin->edges, 1, __ATOMIC_RELAXED);
+    eventPublish(EVENT_GPIO, EVENT_NO_WATCHDOG, record->pin, (uint32_t)record->sequence, (uint32_t)latencyUs,
+                 record->bounces);
+    controlSocketNotifyGpio(record->pin, (uint32_t)record->sequence, record->realtimeMs);
+
+    strbufInit(&out, body, sizeof(body));
+    jsonWriterInit(&writer, &out);
+    jsonBeginObject(&writer);
+    jsonFieldString(&writer, "event", "gpio");
+    jsonFieldUint(&writer, "gpio", record->pin);
+    jsonFieldUint(&writer, "sequence", record->sequence);
+    jsonFieldUint(&writer, "timestamp_ms", record->realtimeMs);
+    jsonFieldUint(&writer, "monotonic_raw_ns", record->rawNs);
+    jsonFieldUint(&writer, "bounces", record->bounces);
+    jsonEndObject(&writer);
+    if (!out.overflow) {
+        webhookPost(out.data, out.length);
+    }
+    histogramRecord(&dispatchLatency, monotonicRawNowNs() - record->rawNs);
+}
+
+static void* dispatcherThreadMain(void *arg) {
+    struct pollfd fds[2];
+    uint64_t value;
+    (void)arg;
+
+    pthread_setname_np(pthread_self(), "gpio-events");
+    fds[0].fd = wakeFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = stopFd;
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        uint64_t head;
+        uint64_t tail;
+
+        if (poll(fds, 2, -1) < 0) {
+            continue;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+        if (!(fds[0].revents & POLLIN) || read(wakeFd, &value, sizeof(value)) != sizeof(value)) {
+            continue;
+        }
+        // One wake-up may cover many edges; the slot is copied out before
+        // head moves past it
+        head = __atomic_load_n(&ringHead, __ATOMIC_RELAXED);
+        tail = __atomic_load_n(&ringTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            GpioEdgeRecord record = ring[head & (GPIO_EVENT_RING - 1)];
+
+            __atomic_store_n(&ringHead, head + 1, __ATOMIC_RELEASE);
+            dispatch(&record);
+        }
+    }
+    return NULL;
+}
+
+static void closeAll(void) {
+    if (wakeFd >= 0) {
+        close(wakeFd);
+        wakeFd = -1;
+    }
+    if (stopFd >= 0) {
+        close(stopFd);
+        stopFd = -1;
+    }
+}
+
+bool gpioEventsStart(void) {
+    bool ok = false;
+
+    if (gpioActive || pinCount == 0) {
+        return true;
+    }
+    // Non-blocking so the callback can never stall the driver's thread
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    stopFd = eventfd(0, EFD_CLOEXEC);
+    if (wakeFd < 0 || stopFd < 0) {
+        perror("gpio: eventfd");
+        closeAll();
+        return false;
+    }
+    if (pthread_create(&dispatcherThread, NULL, dispatcherThreadMain, NULL) != 0) {
+        closeAll();
+        return false;
+    }
+    gpioActive = true;
+    if (!hwActorCall(HW_LANE_CONFIG, hwArm, &ok) || !ok) {
+        gpioEventsStop();
+        return false;
+    }
+    printf("GPIO interrupts armed on %d pin(s)\n", pinCount);
+    for (int i = 0; i < pinCount; i++) {
+        if (pins[i].debounceNs > 0) {
+            printf("GPIO %u: %llu us debounce\n", pins[i].pin, (unsigned long long)(pins[i].debounceNs / 1000));
+        }
+    }
+    return true;
+}
+
+void gpioEventsStop(void) {
+    uint64_t one = 1;
+
+    if (!gpioActive) {
+        return;
+    }
+    // The driver must not call into us once the thread and fds are gone
+    hwActorCall(HW_LANE_CONFIG, hwDisarm, NULL);
+    if (write(stopFd, &one, sizeof(one)) != sizeof(one)) {
+        perror("gpio: stop");
+    }
+    pthread_join(dispatcherThread, NULL);
+    gpioActive = false;
+    closeAll();
+}
+
+uint32_t gpioEventsRingUsed(void) {
+    uint64_t head = __atomic_load_n(&ringHead, __ATOMIC_RELAXED);
+    uint64_t tail = __atomic_load_n(&ringTail, __ATOMIC_RELAXED);
+
+    return tail > head ? (uint32_t)(tail - head) : 0;
+}
+
+void gpioEventsCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (pinCount == 0) {
+        return;
+    }
+    metricsHeader(out, "watchdog_gpio_edges_total", "counter", "GPIO interrupts dispatched by pin");
+    for (int i = 0; i < pinCount; i++) {
+        strbufAppendf(out, "watchdog_gpio_edges_total{gpio=\"%u\",edge=\"%s\"} %llu\n", pins[i].pin,
+                      pins[i].edge == GPIO_EDGE_RISING ? "rising" : "falling",
+                      (unsigned long long)__atomic_load_n(&pins[i].edges, __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_gpio_bounces_total", "counter", "GPIO interrupts suppressed by the debounce window");
+    for (int i = 0; i < pinCount; i++) {
+        strbufAppendf(out, "watchdog_gpio_bounces_total{gpio=\"%u\"} %llu\n", pins[i].pin,
+                      (unsigned long long)__atomic_load_n(&pins[i].bounces, __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_gpio_unknown_edges_total", "counter", "GPIO interrupts for pins not armed by the service");
+    strbufAppendf(out, "watchdog_gpio_unknown_edges_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&unknownEdges, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_gpio_overflows_total", "counter", "GPIO interrupts dropped because the ring was full");
+    strbufAppendf(out, "watchdog_gpio_overflows_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&overflows, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_gpio_dispatch_seconds", "summary",
+                  "Time from the interrupt until events, control socket and webhook queue were served");
+    histogramWriteSummary(out, "watchdog_gpio_dispatch_seconds", NULL, &dispatchLatency);
+}
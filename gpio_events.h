@@ -0,0 +1,42 @@
+#ifndef GPIO_EVENTS_H
+#define GPIO_EVENTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "strbuf.h"
+#include "build_profile.h"
+
+#ifndef GPIO_EVENT_RING
+#define GPIO_EVENT_RING 1024             // Edges buffered between interrupt and dispatcher, power of two
+#endif
+#define GPIO_EVENT_MAX_PINS 32
+
+// GPIO interrupts, for door and ignition contacts. The SUSI callback drops
+// edges inside the pin's debounce window, stamps accepted ones with
+// CLOCK_MONOTONIC_RAW and a sequence number and pushes them into a
+// single-producer single-consumer ring (no locks, no allocation, then an
+// eventfd write), so contact bounce never wakes the dispatcher. A dispatcher
+// thread drains the ring and fans every edge out to /api/events ("gpio"), control
+// socket subscribers (CONTROL_OP_GPIO) and the webhooks, in that order.
+// The driver delivers interrupts from one thread, which is what makes the
+// ring single-producer.
+
+typedef enum {
+    GPIO_EDGE_FALLING = 0,           // SusiGPIOIntSetEdge values
+    GPIO_EDGE_RISING = 1
+} GpioEdge;
+
+// Arm pin (a SUSI_ID_GPIO number) for interrupts; before gpioEventsStart().
+// Edges less than debounceUs after the last accepted one are suppressed.
+bool gpioEventsAddPin(uint32_t pin, GpioEdge edge, uint32_t debounceUs);
+// Configure the pins and register the callback through the hardware
+// thread; returns true without pins
+bool gpioEventsStart(void);
+// Unregister the callback; call before the hardware thread stops
+void gpioEventsStop(void);
+
+// Edges waiting for the dispatcher, of GPIO_EVENT_RING
+uint32_t gpioEventsRingUsed(void);
+void gpioEventsCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // GPIO_EVENTS_H
@@ -0,0 +1,236 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <netdb.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include "health_checks.h"
+#include "feeder.h"
+
+#define HEALTH_CHECK_TARGET_MAX 256
+
+typedef struct {
+    char target[HEALTH_CHECK_TARGET_MAX];   // Process name, pid file or directory
+    char port[8];
+} HealthCheck;
+
+static HealthCheck healthChecks[FEEDER_MAX_CHECKS];
+static int healthCheckCount = 0;
+
+// Split an optional ":MS" suffix off spec into target; 0 means the default
+static bool parseSpec(const char *spec, char *target, size_t size, uint32_t *timeoutMs, bool hasPort) {
+    const char *colon = strrchr(spec, ':');
+    size_t length = strlen(spec);
+    
+    *timeoutMs = 0;
+    // HOST:PORT only carries a timeout when a second colon follows the port
+    if (colon != NULL && (!hasPort || memchr(spec, ':', (size_t)(colon - spec)) != NULL)) {
+        char *end;
+        long value = strtol(colon + 1, &end, 10);
+        
+        if (*end != '\0' || value <= 0 || value > 60000) {
+            return false;
+        }
+        *timeoutMs = (uint32_t)value;
+        length = (size_t)(colon - spec);
+    }
+    if (length == 0 || length >= size) {
+        return false;
+    }
+    memcpy(target, spec, length);
+    target[length] = '\0';
+    return true;
+}
+
+static HealthCheck* nextCheck(void) {
+    if (healthCheckCount >= FEEDER_MAX_CHECKS) {
+        return NULL;
+    }
+    memset(&healthChecks[healthCheckCount], 0, sizeof(healthChecks[healthCheckCount]));
+    return &healthChecks[healthCheckCount];
+}
+
+static bool registerCheck(const char *kind, FeederCheck check, HealthCheck *entry, uint32_t timeoutMs) {
+    char name[HEALTH_CHECK_TARGET_MAX + 16];
+    
+    if (entry->port[0] != '\0') {
+        snprintf(name, sizeof(name), "%s:%s:%s", kind, entry->target, entry->port);
+    } else {
+        snprintf(name, sizeof(name), "%s:%s", kind, entry->target);
+    }
+    if (!feederAddCheck(name, check, entry, timeoutMs)) {
+        return false;
+    }
+    healthCheckCount++;
+    return true;
+}
+
+// kill(pid, 0) fails with EPERM for live processes of other users
+static bool pidAlive(pid_t pid) {
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+static bool pidFileAlive(const char *path) {
+    char line[32];
+    ssize_t length;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    
+    if (fd < 0) {
+        return false;
+    }
+    length = read(fd, line, sizeof(line) - 1);
+    close(fd);
+    if (length <= 0) {
+        return false;
+    }
+    line[length] = '\0';
+    return pidAlive((pid_t)strtol(line, NULL, 10));
+}
+
+// The kernel keeps the first 15 characters of a command name
+static bool processNamed(const char *name) {
+    DIR *proc = opendir("/proc");
+    struct dirent *entry;
+    bool found = false;
+    
+    if (proc == NULL) {
+        return false;
+    }
+    while (!found && (entry = readdir(proc)) != NULL) {
+        char path[sizeof(entry->d_name) + 16];
+        char comm[32];
+        ssize_t length;
+        int fd;
+        
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') {
+            continue;
+        }
+        snprintf(path, sizeof(path), "/proc/%s/comm", entry->d_name);
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        length = read(fd, comm, sizeof(comm) - 1);
+        close(fd);
+        if (length <= 0) {
+            continue;
+        }
+        comm[length] = '\0';
+        comm[strcspn(comm, "\n")] = '\0';
+        found = strncmp(comm, name, 15) == 0;
+    }
+    closedir(proc);
+    return found;
+}
+
+static bool processCheck(void *ctx, uint32_t timeoutMs) {
+    HealthCheck *check = (HealthCheck *)ctx;
+    (void)timeoutMs;
+    
+    return check->target[0] == '/' ? pidFileAlive(check->target) : processNamed(check->target);
+}
+
+bool healthCheckAddProcess(const char *spec) {
+    HealthCheck *check = nextCheck();
+    uint32_t timeoutMs;
+    
+    if (check == NULL || !parseSpec(spec, check->target, sizeof(check->target), &timeoutMs, false)) {
+        return false;
+    }
+    return registerCheck("process", processCheck, check, timeoutMs);
+}
+
+// A read-only or full file system, or one that hangs on sync, fails here
+static bool diskCheck(void *ctx, uint32_t timeoutMs) {
+    HealthCheck *check = (HealthCheck *)ctx;
+    static const char probe[] = "watchdog health check\n";
+    char path[HEALTH_CHECK_TARGET_MAX + 48];
+    bool ok;
+    int fd;
+    (void)timeoutMs;
+    
+    snprintf(path, sizeof(path), "%s/.watchdog-health-%ld", check->target, (long)getpid());
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    ok = write(fd, probe, sizeof(probe) - 1) == (ssize_t)(sizeof(probe) - 1) && fdatasync(fd) == 0;
+    close(fd);
+    if (unlink(path) != 0) {
+        ok = false;
+    }
+    return ok;
+}
+
+bool healthCheckAddDisk(const char *spec) {
+    HealthCheck *check = nextCheck();
+    uint32_t timeoutMs;
+    
+    if (check == NULL || !parseSpec(spec, check->target, sizeof(check->target), &timeoutMs, false)) {
+        return false;
+    }
+    return registerCheck("disk", diskCheck, check, timeoutMs);
+}
+
+// Non-blocking connect bounded by the check's own timeout; name resolution
+// is not, which the feeder's timeout covers instead
+static bool tcpCheck(void *ctx, uint32_t timeoutMs) {
+    HealthCheck *check = (HealthCheck *)ctx;
+    struct addrinfo hints;
+    struct addrinfo *result;
+    struct addrinfo *ai;
+    bool ok = false;
+    
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(check->target, check->port, &hints, &result) != 0) {
+        return false;
+    }
+    for (ai = result; ai != NULL && !ok; ai = ai->ai_next) {
+        struct pollfd pfd;
+        int error = 0;
+        socklen_t length = sizeof(error);
+        int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        
+        if (fd < 0) {
+            continue;
+        }
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            ok = true;
+        } else if (errno == EINPROGRESS) {
+            pfd.fd = fd;
+            pfd.events = POLLOUT;
+            if (poll(&pfd, 1, (int)timeoutMs) == 1 &&
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0) {
+                ok = true;
+            }
+        }
+        close(fd);
+    }
+    freeaddrinfo(result);
+    return ok;
+}
+
+bool healthCheckAddTcp(const char *spec) {
+    HealthCheck *check = nextCheck();
+    uint32_t timeoutMs;
+    char *colon;
+    
+    if (check == NULL || !parseSpec(spec, check->target, sizeof(check->target), &timeoutMs, true)) {
+        return false;
+    }
+    colon = strrchr(check->target, ':');
+    if (colon == NULL || colon == check->target || colon[1] == '\0' || strlen(colon + 1) >= sizeof(check->port)) {
+        return false;
+    }
+    snprintf(check->port, sizeof(check->port), "%s", colon + 1);
+    *colon = '\0';
+    return registerCheck("tcp", tcpCheck, check, timeoutMs);
+}
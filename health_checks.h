@@ -0,0 +1,20 @@
+#ifndef HEALTH_CHECKS_H
+#define HEALTH_CHECKS_H
+
+#include <stdbool.h>
+
+// Built-in feeder health checks (see feederAddCheck). Each takes a command
+// line spec with an optional ":MS" timeout suffix and registers one check;
+// false when the spec is malformed or the feeder has no room left.
+
+// NAME[:MS]      a process whose /proc/PID/comm is NAME is running
+// /PIDFILE[:MS]  the pid in PIDFILE is alive
+bool healthCheckAddProcess(const char *spec);
+
+// DIR[:MS]       a small file can be written, synced and removed in DIR
+bool healthCheckAddDisk(const char *spec);
+
+// HOST:PORT[:MS] a TCP connection to HOST:PORT is accepted
+bool healthCheckAddTcp(const char *spec);
+
+#endif // HEALTH_CHECKS_H
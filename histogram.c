@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include "histogram.h"
+
+static int bucketIndex(uint64_t value) {
+    int exponent;
+    
+    // Values below 16 ns map one-to-one
+    if (value < HISTOGRAM_SUB_BUCKETS) {
+        return (int)value;
+    }
+    exponent = 63 - __builtin_clzll(value);
+    if (exponent > HISTOGRAM_MAX_EXPONENT) {
+        return HISTOGRAM_BUCKETS - 1;
+    }
+    return (exponent - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS +
+           (int)((value >> (exponent - HISTOGRAM_SUB_BITS)) & (HISTOGRAM_SUB_BUCKETS - 1));
+}
+
+static uint64_t bucketMidpoint(int index) {
+    int shift;
+    uint64_t lower;
+    
+    if (index < HISTOGRAM_SUB_BUCKETS) {
+        return (uint64_t)index;
+    }
+    shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+    lower = (uint64_t)(HISTOGRAM_SUB_BUCKETS + index % HISTOGRAM_SUB_BUCKETS) << shift;
+    return lower + ((1ull << shift) >> 1);
+}
+
+void histogramRecord(Histogram *histogram, uint64_t valueNs) {
+    uint64_t max = __atomic_load_n(&histogram->maxNs, __ATOMIC_RELAXED);
+    
+    __atomic_fetch_add(&histogram->buckets[bucketIndex(valueNs)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->sumNs, valueNs, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->count, 1, __ATOMIC_RELAXED);
+    while (valueNs > max &&
+           !__atomic_compare_exchange_n(&histogram->maxNs, &max, valueNs, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void histogramMerge(Histogram *dst, const Histogram *src) {
+    uint64_t max = __atomic_load_n(&src->maxNs, __ATOMIC_RELAXED);
+    uint64_t current = __atomic_load_n(&dst->maxNs, __ATOMIC_RELAXED);
+    
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        __atomic_fetch_add(&dst->buckets[i], __atomic_load_n(&src->buckets[i], __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&dst->sumNs, __atomic_load_n(&src->sumNs, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    __atomic_fetch_add(&dst->count, __atomic_load_n(&src->count, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    while (max > current &&
+           !__atomic_compare_exchange_n(&dst->maxNs, &current, max, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+uint64_t histogramQuantile(const Histogram *histogram, double q) {
+    uint64_t total = 0;
+    uint64_t rank;
+    uint64_t seen = 0;
+    
+    // Sum the buckets rather than trusting count, which may run ahead
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        total += __atomic_load_n(&histogram->buckets[i], __ATOMIC_RELAXED);
+    }
+    if (total == 0) {
+        return 0;
+    }
+    rank = (uint64_t)(q * (double)total + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += __atomic_load_n(&histogram->buckets[i], __ATOMIC_RELAXED);
+        if (seen >= rank) {
+            // The top bucket's midpoint may lie above the largest sample
+            uint64_t max = __atomic_load_n(&histogram->maxNs, __ATOMIC_RELAXED);
+            uint64_t value = bucketMidpoint(i);
+            return (max && value > max) ? max : value;
+        }
+    }
+    return __atomic_load_n(&histogram->maxNs, __ATOMIC_RELAXED);
+}
+
+void histogramWriteSummary(StrBuf *out, const char *name, const char *labels, const Histogram *histogram) {
+    static const struct {
+        double q;
+        const char *label;
+    } quantiles[] = { { 0.5, "0.5" }, { 0.99, "0.99" }, { 0.999, "0.999" } };
+    char braced[128];
+    
+    // Label block for the non-quantile series, "" when unlabelled
+    if (labels && *labels) {
+        snprintf(braced, sizeof(braced), "{%s}", labels);
+    } else {
+        braced[0] = '\0';
+        labels = NULL;
+    }
+    for (unsigned i = 0; i < sizeof(quantiles) / sizeof(quantiles[0]); i++) {
+        strbufAppendf(out, "%s{%s%squantile=\"%s\"} %.9f\n", name, labels ? labels : "", labels ? "," : "",
+                      quantiles[i].label, (double)histogramQuantile(histogram, quantiles[i].q) / 1e9);
+    }
+    strbufAppendf(out, "%s_sum%s %.9f\n", name, braced,
+                  (double)__atomic_load_n(&histogram->sumNs, __ATOMIC_RELAXED) / 1e9);
+    strbufAppendf(out, "%s_count%s %llu\n", name, braced,
+                  (unsigned long long)__atomic_load_n(&histogram->count, __ATOMIC_RELAXED));
+}
@@ -0,0 +1,37 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+#include "strbuf.h"
+
+// Log-linear (HDR-style) latency histogram over nanoseconds. Each power of
+// two is split into 16 linear sub-buckets, so any recorded value is within
+// about 3% of its bucket midpoint. Values up to 2^40 ns (~18 min) are kept
+// apart, larger ones land in the last bucket.
+#define HISTOGRAM_SUB_BITS 4
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_MAX_EXPONENT 39
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_EXPONENT - HISTOGRAM_SUB_BITS + 2) * HISTOGRAM_SUB_BUCKETS)
+
+// Recording is lock-free (relaxed atomic increments) and can run on any
+// thread; readers see a slightly inconsistent but monotonic snapshot.
+typedef struct {
+    uint64_t count;
+    uint64_t sumNs;
+    uint64_t maxNs;
+    uint64_t buckets[HISTOGRAM_BUCKETS];
+} __attribute__((aligned(64))) Histogram;
+
+void histogramRecord(Histogram *histogram, uint64_t valueNs);
+// Add every sample of src to dst (e.g. merging per-thread histograms)
+void histogramMerge(Histogram *dst, const Histogram *src);
+
+// Value at quantile q (0..1), as the midpoint of the containing bucket
+uint64_t histogramQuantile(const Histogram *histogram, double q);
+
+// Write p50/p99/p999 as a Prometheus summary in seconds, plus _sum and
+// _count. labels is the inner label list (e.g. "route=\"status\"") or NULL.
+// The caller writes the HELP/TYPE header once per metric family.
+void histogramWriteSummary(StrBuf *out, const char *name, const char *labels, const Histogram *histogram);
+
+#endif // HISTOGRAM_H
@@ -0,0 +1,515 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include "hw_actor.h"
+#include "histogram.h"
+#include "metrics.h"
+#include "realtime.h"
+#include "span_trace.h"
+
+typedef struct HwCommand {
+    HwCommandFn fn;
+    void *arg;
+    sem_t *done;                // NULL for posted commands
+    uint64_t enqueuedNs;
+    uint64_t deadlineNs;        // 0 without a deadline
+    uint64_t traceRequest;      // Request that queued it, 0 if none
+} HwCommand;
+
+// Bounded multi-producer single-consumer ring; producers claim slots with a
+// CAS and publish through the per-slot sequence like the access log ring.
+typedef struct {
+    uint64_t sequence;
+    HwCommand command;
+} HwSlot;
+
+typedef struct {
+    HwSlot slots[HW_ACTOR_LANE_CAPACITY];
+    uint64_t head __attribute__((aligned(64)));   // Producers
+    uint64_t tail __attribute__((aligned(64)));   // Hardware thread only
+    // Fair lanes only, hardware thread only
+    uint32_t weight;
+    uint64_t virtualNs;         // Busy time served, scaled by 1/weight
+    // Statistics
+    uint64_t executed;
+    uint64_t rejected;
+    uint64_t waitNsTotal;
+    uint64_t waitNsMax;
+    uint64_t busyNs;
+    uint64_t deadlineMisses;
+    Histogram waitLatency;
+} HwLaneQueue;
+
+static HwLaneQueue lanes[HW_LANE_COUNT];
+static uint32_t laneWeights[HW_LANE_COUNT] = {
+    [HW_LANE_READ] = HW_ACTOR_DEFAULT_READ_WEIGHT,
+    [HW_LANE_USER] = HW_ACTOR_DEFAULT_USER_WEIGHT,
+};
+static uint64_t systemVirtualNs;    // Virtual time of the last fair command
+static sem_t pendingSem;        // Counts queued commands across all lanes
+static pthread_t hwThread;
+static bool hwRunning = false;
+static bool hwStopping = false;
+
+// A shared read between queuing and the last copy of its result. Slots are
+// free while fn is NULL; all fields are under flightLock.
+typedef struct {
+    HwCommandFn fn;
+    void *arg;
+    uint64_t key;
+    const void *result;         // The leader's buffer
+    size_t size;
+    bool started;               // Closed to new followers
+    bool done;
+    bool ok;
+    uint32_t followers;         // Waiting for or copying the result
+} HwFlight;
+
+static HwFlight flights[HW_ACTOR_MAX_FLIGHTS];
+static pthread_mutex_t flightLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t flightChanged = PTHREAD_COND_INITIALIZER;
+static uint64_t sharedLed;          // Calls that went to the driver
+static uint64_t sharedJoined;       // Calls answered by another's result
+static uint64_t sharedUnshared;     // Calls that found the flight table full
+
+static const char *laneNames[HW_LANE_COUNT] = { "feed", "config", "read", "user" };
+
+const char* hwLaneName(HwLane lane) {
+    return (lane < HW_LANE_COUNT) ? laneNames[lane] : "unknown";
+}
+
+uint32_t hwActorQueued(HwLane lane) {
+    uint64_t tail, head;
+
+    if (lane >= HW_LANE_COUNT) {
+        return 0;
+    }
+    // Tail first: a command taken in between can only make the count low
+    tail = __atomic_load_n(&lanes[lane].tail, __ATOMIC_ACQUIRE);
+    head = __atomic_load_n(&lanes[lane].head, __ATOMIC_ACQUIRE);
+    return head > tail ? (uint32_t)(head - tail) : 0;
+}
+
+static uint64_t nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+bool hwActorIsHardwareThread(void) {
+    return hwRunning && pthread_equal(pthread_self(), hwThread);
+}
+
+static bool laneEnqueue(HwLaneQueue *queue, const HwCommand *command) {
+    uint64_t pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    
+    for (;;) {
+        HwSlot *slot = &queue->slots[pos & (HW_ACTOR_LANE_CAPACITY - 1)];
+        uint64_t seq = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        int64_t diff = (int64_t)seq - (int64_t)pos;
+        
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&queue->head, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                slot->command = *command;
+                __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+        } else if (diff < 0) {
+            __atomic_fetch_add(&queue->rejected, 1, __ATOMIC_RELAXED);
+            return false;
+        } else {
+            pos = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static bool isFairLane(int lane) {
+    return lane == HW_LANE_READ || lane == HW_LANE_USER;
+}
+
+// Next command of the lane without taking it, NULL if the lane is empty
+static const HwCommand *laneHead(HwLaneQueue *queue) {
+    HwSlot *slot = &queue->slots[queue->tail & (HW_ACTOR_LANE_CAPACITY - 1)];
+
+    if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != queue->tail + 1) {
+        return NULL;
+    }
+    return &slot->command;
+}
+
+static bool laneDequeue(HwLaneQueue *queue, HwCommand *command) {
+    HwSlot *slot = &queue->slots[queue->tail & (HW_ACTOR_LANE_CAPACITY - 1)];
+    uint64_t seq = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+    
+    if (seq != queue->tail + 1) {
+        return false;
+    }
+    *command = slot->command;
+    __atomic_store_n(&slot->sequence, queue->tail + HW_ACTOR_LANE_CAPACITY, __ATOMIC_RELEASE);
+    queue->tail++;
+    return true;
+}
+
+static void runCommand(HwLaneQueue *queue, HwCommand *command) {
+    const char *lane = hwLaneName((HwLane)(queue - lanes));
+    uint64_t start = nowNs();
+    uint64_t waited = start - command->enqueuedNs;
+    uint64_t end;
+    uint64_t busy;
+    
+    __atomic_fetch_add(&queue->waitNsTotal, waited, __ATOMIC_RELAXED);
+    if (waited > __atomic_load_n(&queue->waitNsMax, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&queue->waitNsMax, waited, __ATOMIC_RELAXED);
+    }
+    histogramRecord(&queue->waitLatency, waited);
+    if (command->deadlineNs != 0 && start > command->deadlineNs) {
+        __atomic_fetch_add(&queue->deadlineMisses, 1, __ATOMIC_RELAXED);
+    }
+    
+    spanTraceRecordAsync(SPAN_HW_QUEUE, lane, command->enqueuedNs, start, command->traceRequest);
+    // SUSI calls made by the command are tagged with its request
+    spanTraceSetRequest(command->traceRequest);
+    command->fn(command->arg);
+    end = nowNs();
+    spanTraceRecord(SPAN_HW, lane, start, end);
+    spanTraceSetRequest(0);
+    busy = end - start;
+    __atomic_fetch_add(&queue->busyNs, busy, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&queue->executed, 1, __ATOMIC_RELAXED);
+    if (command->done) {
+        sem_post(command->done);
+    }
+    // Charge at least a microsecond so a lane of no-ops still yields
+    queue->virtualNs += (busy > 1000 ? busy : 1000) / queue->weight;
+}
+
+// Choose between the fair lanes: the earliest deadline that is due within
+// the slack, otherwise the backlogged lane with the least virtual time. A
+// lane that was idle resumes at the current virtual time instead of
+// redeeming the time it did not use.
+static int pickFairLane(void) {
+    uint64_t now = nowNs();
+    uint64_t earliest = UINT64_MAX;
+    int best = -1;
+    
+    for (int lane = 0; lane < HW_LANE_COUNT; lane++) {
+        const HwCommand *head = isFairLane(lane) ? laneHead(&lanes[lane]) : NULL;
+        
+        if (head != NULL && head->deadlineNs != 0 && head->deadlineNs <= now + HW_ACTOR_DEADLINE_SLACK_NS &&
+            head->deadlineNs < earliest) {
+            earliest = head->deadlineNs;
+            best = lane;
+        }
+    }
+    if (best >= 0) {
+        return best;
+    }
+    for (int lane = 0; lane < HW_LANE_COUNT; lane++) {
+        if (!isFairLane(lane) || laneHead(&lanes[lane]) == NULL) {
+            continue;
+        }
+        if (lanes[lane].virtualNs < systemVirtualNs) {
+            lanes[lane].virtualNs = systemVirtualNs;
+        }
+        if (best < 0 || lanes[lane].virtualNs < lanes[best].virtualNs) {
+            best = lane;
+        }
+    }
+    if (best >= 0) {
+        systemVirtualNs = lanes[best].virtualNs;
+    }
+    return best;
+}
+
+// Run the next command: the strict lanes go first, so a feed queued
+// behind a read storm runs next; then one fair command. False when every
+// lane is empty or its head slot is claimed but not yet published.
+static bool runNext(void) {
+    HwCommand command;
+    int lane;
+
+    for (lane = 0; lane < HW_LANE_COUNT; lane++) {
+        if (!isFairLane(lane) && laneDequeue(&lanes[lane], &command)) {
+            runCommand(&lanes[lane], &command);
+            return true;
+        }
+    }
+    lane = pickFairLane();
+    if (lane >= 0 && laneDequeue(&lanes[lane], &command)) {
+        runCommand(&lanes[lane], &command);
+        return true;
+    }
+    return false;
+}
+
+// No slot claimed on any lane, published or not
+static bool lanesIdle(void) {
+    for (int lane = 0; lane < HW_LANE_COUNT; lane++) {
+        if (__atomic_load_n(&lanes[lane].head, __ATOMIC_ACQUIRE) != lanes[lane].tail) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void* hwThreadMain(void *arg) {
+    (void)arg;
+    
+    pthread_setname_np(pthread_self(), "hw-actor");
+    realtimeEnterThread(REALTIME_THREAD_HW);
+    for (;;) {
+        while (sem_wait(&pendingSem) != 0 && errno == EINTR) {
+        }
+        
+        // Tokens and commands do not pair up: a producer can publish behind
+        // a slot another one has claimed but not filled, and its token then
+        // finds nothing runnable. So every wake-up drains all lanes, and
+        // the slower producer's post, which follows its publish, wakes the
+        // thread again for both commands. A wake-up that finds its command
+        // already run costs one empty pass.
+        while (runNext()) {
+        }
+        
+        if (__atomic_load_n(&hwStopping, __ATOMIC_ACQUIRE) && lanesIdle()) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+bool hwActorSetWeight(HwLane lane, uint32_t weight) {
+    if (!isFairLane(lane) || weight == 0 || hwRunning) {
+        return false;
+    }
+    laneWeights[lane] = weight;
+    return true;
+}
+
+bool hwActorStart(void) {
+    memset(lanes, 0, sizeof(lanes));
+    for (int lane = 0; lane < HW_LANE_COUNT; lane++) {
+        for (uint64_t i = 0; i < HW_ACTOR_LANE_CAPACITY; i++) {
+            lanes[lane].slots[i].sequence = i;
+        }
+        lanes[lane].weight = laneWeights[lane] ? laneWeights[lane] : 1;
+    }
+    systemVirtualNs = 0;
+    if (sem_init(&pendingSem, 0, 0) != 0) {
+        return false;
+    }
+    hwStopping = false;
+    if (pthread_create(&hwThread, NULL, hwThreadMain, NULL) != 0) {
+        sem_destroy(&pendingSem);
+        return false;
+    }
+    hwRunning = true;
+    return true;
+}
+
+// Drains all queued commands, then joins the hardware thread
+void hwActorStop(void) {
+    if (!hwRunning) {
+        return;
+    }
+    __atomic_store_n(&hwStopping, true, __ATOMIC_RELEASE);
+    sem_post(&pendingSem);
+    pthread_join(hwThread, NULL);
+    hwRunning = false;
+    sem_destroy(&pendingSem);
+}
+
+static bool submit(HwLane lane, HwCommandFn fn, void *arg, sem_t *done, uint64_t maxWaitNs) {
+    HwCommand command;
+    
+    if (lane >= HW_LANE_COUNT || !hwRunning || __atomic_load_n(&hwStopping, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    command.fn = fn;
+    command.arg = arg;
+    command.done = done;
+    command.enqueuedNs = nowNs();
+    command.deadlineNs = maxWaitNs ? command.enqueuedNs + maxWaitNs : 0;
+    command.traceRequest = spanTraceCurrentRequest();
+    if (!laneEnqueue(&lanes[lane], &command)) {
+        return false;
+    }
+    sem_post(&pendingSem);
+    return true;
+}
+
+static bool call(HwLane lane, uint64_t maxWaitNs, HwCommandFn fn, void *arg) {
+    sem_t done;
+    
+    if (hwActorIsHardwareThread()) {
+        fn(arg);
+        return true;
+    }
+    if (sem_init(&done, 0, 0) != 0) {
+        return false;
+    }
+    if (!submit(lane, fn, arg, &done, maxWaitNs)) {
+        sem_destroy(&done);
+        return false;
+    }
+    while (sem_wait(&done) != 0 && errno == EINTR) {
+    }
+    sem_destroy(&done);
+    return true;
+}
+
+bool hwActorCall(HwLane lane, HwCommandFn fn, void *arg) {
+    return call(lane, 0, fn, arg);
+}
+
+bool hwActorCallWithin(HwLane lane, uint64_t maxWaitNs, HwCommandFn fn, void *arg) {
+    if (!isFairLane(lane)) {
+        return false;
+    }
+    return call(lane, maxWaitNs, fn, arg);
+}
+
+// Runs on the hardware thread in place of the flight's fn
+static void runFlight(void *arg) {
+    HwFlight *flight = arg;
+    
+    pthread_mutex_lock(&flightLock);
+    flight->started = true;
+    pthread_mutex_unlock(&flightLock);
+    flight->fn(flight->arg);
+}
+
+bool hwActorCallShared(HwLane lane, uint64_t key, HwCommandFn fn, void *arg, void *result, size_t size) {
+    HwFlight *flight = NULL;
+    HwFlight *slot = NULL;
+    bool ok;
+    
+    if (hwActorIsHardwareThread()) {
+        fn(arg);
+        return true;
+    }
+    pthread_mutex_lock(&flightLock);
+    for (int i = 0; i < HW_ACTOR_MAX_FLIGHTS && flight == NULL; i++) {
+        if (flights[i].fn == fn && flights[i].key == key && flights[i].size == size && !flights[i].started) {
+            flight = &flights[i];
+        } else if (flights[i].fn == NULL && slot == NULL) {
+            slot = &flights[i];
+        }
+    }
+    if (flight) {
+        flight->followers++;
+        while (!flight->done) {
+            pthread_cond_wait(&flightChanged, &flightLock);
+        }
+        ok = flight->ok;
+        if (ok) {
+            memcpy(result, flight->result, size);
+        }
+        if (--flight->followers == 0) {
+            pthread_cond_broadcast(&flightChanged);
+        }
+        pthread_mutex_unlock(&flightLock);
+        __atomic_add_fetch(&sharedJoined, 1, __ATOMIC_RELAXED);
+        return ok;
+    }
+    if (slot == NULL) {
+        pthread_mutex_unlock(&flightLock);
+        __atomic_add_fetch(&sharedUnshared, 1, __ATOMIC_RELAXED);
+        return call(lane, 0, fn, arg);
+    }
+    slot->fn = fn;
+    slot->arg = arg;
+    slot->key = key;
+    slot->result = result;
+    slot->size = size;
+    slot->started = false;
+    slot->done = false;
+    slot->followers = 0;
+    pthread_mutex_unlock(&flightLock);
+    
+    ok = call(lane, 0, runFlight, slot);
+    
+    // Followers copy out of result, so it has to outlive them
+    pthread_mutex_lock(&flightLock);
+    slot->started = true;
+    slot->ok = ok;
+    slot->done = true;
+    pthread_cond_broadcast(&flightChanged);
+    while (slot->followers > 0) {
+        pthread_cond_wait(&flightChanged, &flightLock);
+    }
+    slot->fn = NULL;
+    pthread_mutex_unlock(&flightLock);
+    __atomic_add_fetch(&sharedLed, 1, __ATOMIC_RELAXED);
+    return ok;
+}
+
+bool hwActorPost(HwLane lane, HwCommandFn fn, void *arg) {
+    return submit(lane, fn, arg, NULL, 0);
+}
+
+void hwActorCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+    
+    metricsHeader(out, "watchdog_hw_commands_total", "counter", "Hardware commands executed per lane");
+    for (int lane = 0; lane < HW_LANE_COUNT; lane++) {
+        strbufAppendf(out, "watchdog_hw_commands_total{lane=\"%s\"} %llu\n", laneNames[lane],
+                      (unsigned long long)__atomic_load_n(&lanes[lane].executed, __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_hw_commands_rejected_total", "counter", "Hardware commands rejected because the lane was full");
+    for (int lane = 0; lane < HW_LANE_COUNT; lane++) {
+        strbufAppendf(out, "watchdog_hw_commands_rejected_total{lane=\"%s\"} %llu\n", laneNames[lane],
+                      (unsigned long long)__atomic_load_n(&lanes[lane].rejected, __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_hw_queue_depth", "gauge", "Commands queued per lane, not yet taken");
+    for (int lane = 0; lane < HW_LANE_COUNT; lane++) {
+        strbufAppendf(out, "watchdog_hw_queue_depth{lane=\"%s\"} %u\n", laneNames[lane], hwActorQueued((HwLane)lane));
+    }
+    metricsHeader(out, "watchdog_hw_queue_wait_seconds_total", "counter", "Total time commands spent queued per lane");
+    for (int lane = 0; lane < HW_LANE_COUNT; lane++) {
+        strbufAppendf(out, "watchdog_hw_queue_wait_seconds_total{lane=\"%s\"} %.6f\n", laneNames[lane],
+                      (double)__atomic_load_n(&lanes[lane].waitNsTotal, __ATOMIC_RELAXED) / 1e9);
+    }
+    metricsHeader(out, "watchdog_hw_queue_wait_max_seconds", "gauge", "Longest time a command spent queued per lane");
+    for (int lane = 0; lane < HW_LANE_COUNT; lane++) {
+        strbufAppendf(out, "watchdog_hw_queue_wait_max_seconds{lane=\"%s\"} %.6f\n", laneNames[lane],
+                      (double)__atomic_load_n(&lanes[lane].waitNsMax, __ATOMIC_RELAXED) / 1e9);
+    }
+    metricsHeader(out, "watchdog_hw_queue_wait_seconds", "summary", "Time commands spent queued per lane");
+    for (int lane = 0; lane < HW_LANE_COUNT; lane++) {
+        char labels[32];
+
+        snprintf(labels, sizeof(labels), "lane=\"%s\"", laneNames[lane]);
+        histogramWriteSummary(out, "watchdog_hw_queue_wait_seconds", labels, &lanes[lane].waitLatency);
+    }
+    metricsHeader(out, "watchdog_hw_busy_seconds_total", "counter", "Time the hardware thread spent running each lane's commands");
+    for (int lane = 0; lane < HW_LANE_COUNT; lane++) {
+        strbufAppendf(out, "watchdog_hw_busy_seconds_total{lane=\"%s\"} %.6f\n", laneNames[lane],
+                      (double)__atomic_load_n(&lanes[lane].busyNs, __ATOMIC_RELAXED) / 1e9);
+    }
+    metricsHeader(out, "watchdog_hw_lane_weight", "gauge", "Fair-queuing weight of the read and user lanes");
+    for (int lane = 0; lane < HW_LANE_COUNT; lane++) {
+        if (isFairLane(lane)) {
+            strbufAppendf(out, "watchdog_hw_lane_weight{lane=\"%s\"} %u\n", laneNames[lane], laneWeights[lane]);
+        }
+    }
+    metricsHeader(out, "watchdog_hw_shared_calls_total", "counter",
+                  "Shared reads that went to the driver, joined one already queued, or found no free flight");
+    strbufAppendf(out, "watchdog_hw_shared_calls_total{result=\"led\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&sharedLed, __ATOMIC_RELAXED));
+    strbufAppendf(out, "watchdog_hw_shared_calls_total{result=\"joined\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&sharedJoined, __ATOMIC_RELAXED));
+    strbufAppendf(out, "watchdog_hw_shared_calls_total{result=\"unshared\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&sharedUnshared, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_hw_deadline_misses_total", "counter", "Commands that started after their deadline");
+    for (int lane = 0; lane < HW_LANE_COUNT; lane++) {
+        if (isFairLane(lane)) {
+            strbufAppendf(out, "watchdog_hw_deadline_misses_total{lane=\"%s\"} %llu\n", laneNames[lane],
+                          (unsigned long long)__atomic_load_n(&lanes[lane].deadlineMisses, __ATOMIC_RELAXED));
+        }
+    }
+}
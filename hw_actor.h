@@ -0,0 +1,67 @@
+#ifndef HW_ACTOR_H
+#define HW_ACTOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "strbuf.h"
+
+#define HW_ACTOR_LANE_CAPACITY 64   // Slots per lane, must be a power of two
+#define HW_ACTOR_DEFAULT_READ_WEIGHT 4
+#define HW_ACTOR_DEFAULT_USER_WEIGHT 1
+#define HW_ACTOR_DEADLINE_SLACK_NS 2000000ull   // Serve a deadline this early
+#define HW_ACTOR_MAX_FLIGHTS 16     // Distinct shared reads queued at once
+
+// Priority lanes. Feed and config are served strictly in this order. The
+// read and user lanes share what is left by weighted fair queuing on the
+// time their commands keep the hardware thread busy, so a stream of long
+// user block transfers cannot starve telemetry and a telemetry sweep
+// cannot starve users. A command queued with a latency deadline on either
+// fair lane overtakes the fair order once the deadline is near.
+typedef enum {
+    HW_LANE_FEED,       // Watchdog triggers: must never wait behind anything else
+    HW_LANE_CONFIG,     // Start/stop/configure and other writes
+    HW_LANE_READ,       // Service reads: telemetry, status, discovery
+    HW_LANE_USER,       // SMBus/I2C and storage traffic issued on behalf of clients
+    HW_LANE_COUNT
+} HwLane;
+
+// Work executed on the hardware thread. All SUSI access in the service goes
+// through here, so these functions never race with each other.
+typedef void (*HwCommandFn)(void *arg);
+
+bool hwActorStart(void);
+void hwActorStop(void);
+
+// Run fn(arg) on the hardware thread and wait for it to finish.
+// Only the calling thread blocks; returns false if the lane is full or the
+// actor is not running. Calls made from the hardware thread run inline.
+bool hwActorCall(HwLane lane, HwCommandFn fn, void *arg);
+
+// hwActorCall() for a fair lane that must start within maxWaitNs of being
+// queued; the deadline only moves the command ahead, it never drops it
+bool hwActorCallWithin(HwLane lane, uint64_t maxWaitNs, HwCommandFn fn, void *arg);
+
+// hwActorCall() for idempotent reads. While a call of the same fn and key
+// is still queued, another caller waits for it instead of queuing its own
+// and gets a copy of its size bytes at result (the buffer fn fills through
+// arg; the same key must mean the same arguments). Only calls that have not
+// started are joined, so the result is never older than the caller's
+// request. With 20 clients asking at once the driver is read once.
+bool hwActorCallShared(HwLane lane, uint64_t key, HwCommandFn fn, void *arg, void *result, size_t size);
+
+// Queue fn(arg) without waiting. arg must stay valid until fn has run.
+bool hwActorPost(HwLane lane, HwCommandFn fn, void *arg);
+
+// Share of the fair lanes' time (HW_LANE_READ and HW_LANE_USER); set
+// before hwActorStart(). False for a strict lane or a weight of 0.
+bool hwActorSetWeight(HwLane lane, uint32_t weight);
+
+bool hwActorIsHardwareThread(void);
+
+const char* hwLaneName(HwLane lane);
+// Commands queued on a lane and not yet taken, of HW_ACTOR_LANE_CAPACITY
+uint32_t hwActorQueued(HwLane lane);
+void hwActorCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // HW_ACTOR_H
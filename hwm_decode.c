@@ -0,0 +1,245 @@
+// Decoder for the compressed HWM export of GET /api/hwm/export (format in
+// hwm_gorilla.h). Prints CSV, a row per sweep or bucket: the timestamp and
+// every sensor column converted to its unit, empty where there was no value.
+//
+//   curl -s http://board:8080/api/hwm/export?res=1m | hwm_decode
+//   hwm_decode export.bin          from a file
+//   hwm_decode -r export.bin       raw units (0.1 K, mV, RPM, mA) instead
+//   hwm_decode -i export.bin       the header and per-column sizes only
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "hwm_gorilla.h"
+
+#define MAX_SENSORS 1024
+#define MAX_POINTS (16 * 1024 * 1024)
+
+typedef struct {
+    uint32_t id;
+    uint8_t kind;
+    char name[256];
+    char unit[256];
+    double scale;
+    double offset;
+    uint32_t columnBytes[HWM_GORILLA_ROLLUP_COLUMNS];
+} Sensor;
+
+static const char *const rollupColumns[HWM_GORILLA_ROLLUP_COLUMNS] = { "min", "max", "avg", "count" };
+
+static uint8_t* readAll(FILE *file, size_t *length) {
+    size_t capacity = 65536;
+    uint8_t *data = malloc(capacity);
+
+    *length = 0;
+    while (data != NULL) {
+        size_t n = fread(data + *length, 1, capacity - *length, file);
+
+        *length += n;
+        if (n == 0) {
+            break;
+        }
+        if (*length == capacity) {
+            uint8_t *grown = realloc(data, capacity * 2);
+
+            if (grown == NULL) {
+                free(data);
+                return NULL;
+            }
+            data = grown;
+            capacity *= 2;
+        }
+    }
+    return data;
+}
+
+static void printValue(double value) {
+    if (isnan(value)) {
+        return;
+    }
+    if (value == floor(value) && fabs(value) < 1e15) {
+        printf("%.0f", value);
+    } else {
+        printf("%.6g", value);
+    }
+}
+
+static int decode(const uint8_t *data, size_t length, bool rawUnits, bool infoOnly) {
+    GorillaReader reader;
+    GorillaReader block;
+    GorillaTimes times = { 0 };
+    char resolution[256];
+    uint8_t version, columns;
+    uint16_t sensorCount;
+    uint32_t points, stepMs;
+    uint64_t *timestamps;
+    double *values;
+    Sensor *sensors;
+
+    gorillaReaderInit(&reader, data, length);
+    if (length < 4 || memcmp(data, HWM_GORILLA_MAGIC, 4) != 0) {
+        fprintf(stderr, "Not an HWM export (no %s header)\n", HWM_GORILLA_MAGIC);
+        return 1;
+    }
+    reader.bit = 32;
+    version = gorillaGetU8(&reader);
+    columns = gorillaGetU8(&reader);
+    sensorCount = gorillaGetU16(&reader);
+    points = gorillaGetU32(&reader);
+    stepMs = gorillaGetU32(&reader);
+    gorillaGetString(&reader, resolution, sizeof(resolution));
+    if (reader.overflow || version != HWM_GORILLA_VERSION ||
+        (columns != HWM_GORILLA_RAW_COLUMNS && columns != HWM_GORILLA_ROLLUP_COLUMNS) ||
+        sensorCount > MAX_SENSORS || points > MAX_POINTS) {
+        fprintf(stderr, "Unsupported HWM export (version %u, %u columns, %u sensors, %u points)\n",
+                version, columns, sensorCount, points);
+        return 1;
+    }
+
+    timestamps = malloc(sizeof(*timestamps) * (points ? points : 1));
+    values = malloc(sizeof(*values) * (size_t)(points ? points : 1) * columns * (sensorCount ? sensorCount : 1));
+    sensors = calloc(sensorCount ? sensorCount : 1, sizeof(*sensors));
+    if (timestamps == NULL || values == NULL || sensors == NULL) {
+        fprintf(stderr, "Out of memory for %u points\n", points);
+        free(timestamps);
+        free(values);
+        free(sensors);
+        return 1;
+    }
+
+    block = gorillaGetBlock(&reader);
+    for (uint32_t n = 0; n < points; n++) {
+        timestamps[n] = gorillaGetTime(&block, &times);
+    }
+    if (block.overflow) {
+        reader.overflow = true;
+    }
+    for (uint16_t i = 0; i < sensorCount && !reader.overflow; i++) {
+        Sensor *sensor = &sensors[i];
+
+        sensor->id = gorillaGetU32(&reader);
+        sensor->kind = gorillaGetU8(&reader);
+        gorillaGetString(&reader, sensor->name, sizeof(sensor->name));
+        gorillaGetString(&reader, sensor->unit, sizeof(sensor->unit));
+        sensor->scale = gorillaGetF64(&reader);
+        sensor->offset = gorillaGetF64(&reader);
+        for (int c = 0; c < columns; c++) {
+            double *column = values + ((size_t)i * columns + c) * points;
+            GorillaValues state = { 0 };
+
+            block = gorillaGetBlock(&reader);
+            sensor->columnBytes[c] = (uint32_t)block.bytes;
+            for (uint32_t n = 0; n < points; n++) {
+                column[n] = gorillaGetValue(&block, &state);
+            }
+            if (block.overflow) {
+                reader.overflow = true;
+            }
+        }
+    }
+    if (reader.overflow) {
+        fprintf(stderr, "Truncated or corrupt HWM export\n");
+        free(timestamps);
+        free(values);
+        free(sensors);
+        return 1;
+    }
+
+    if (infoOnly) {
+        printf("resolution %s, step %u ms, %u points, %u sensors, %zu bytes (%.2f bits per value)\n",
+               resolution, stepMs, points, sensorCount, length,
+               points ? 8.0 * length / ((double)points * (columns * sensorCount + 1)) : 0.0);
+        for (uint16_t i = 0; i < sensorCount; i++) {
+            printf("  0x%08x %-24s %-4s", sensors[i].id, sensors[i].name, sensors[i].unit);
+            for (int c = 0; c < columns; c++) {
+                printf(" %s=%u", columns == 1 ? "value" : rollupColumns[c], sensors[i].columnBytes[c]);
+            }
+            printf("\n");
+        }
+    } else {
+        printf("timestamp_ms");
+        for (uint16_t i = 0; i < sensorCount; i++) {
+            for (int c = 0; c < columns; c++) {
+                if (columns == 1) {
+                    printf(",%s", sensors[i].name);
+                } else {
+                    printf(",%s:%s", sensors[i].name, rollupColumns[c]);
+                }
+            }
+        }
+        printf("\n");
+        for (uint32_t n = 0; n < points; n++) {
+            printf("%llu", (unsigned long long)timestamps[n]);
+            for (uint16_t i = 0; i < sensorCount; i++) {
+                for (int c = 0; c < columns; c++) {
+                    double value = values[((size_t)i * columns + c) * points + n];
+                    bool isCount = columns == HWM_GORILLA_ROLLUP_COLUMNS && c == HWM_GORILLA_ROLLUP_COLUMNS - 1;
+
+                    printf(",");
+                    printValue(rawUnits || isCount ? value : value * sensors[i].scale + sensors[i].offset);
+                }
+            }
+            printf("\n");
+        }
+    }
+    free(timestamps);
+    free(values);
+    free(sensors);
+    return 0;
+}
+
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [-r] [-i] [FILE]\n", program);
+    fprintf(stderr, "  Decode a GET /api/hwm/export body from FILE or stdin to CSV\n");
+    fprintf(stderr, "  -r  Print raw units (0.1 K, mV, RPM, mA) instead of C, V, RPM, A\n");
+    fprintf(stderr, "  -i  Print the header and the bytes of every column instead\n");
+}
+
+int main(int argc, char *argv[]) {
+    bool rawUnits = false;
+    bool infoOnly = false;
+    FILE *file = stdin;
+    uint8_t *data;
+    size_t length;
+    int option;
+    int result;
+
+    while ((option = getopt(argc, argv, "rih")) != -1) {
+        switch (option) {
+        case 'r':
+            rawUnits = true;
+            break;
+        case 'i':
+            infoOnly = true;
+            break;
+        default:
+            usage(argv[0]);
+            return option == 'h' ? 0 : 2;
+        }
+    }
+    if (argc - optind > 1) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (optind < argc && strcmp(argv[optind], "-") != 0) {
+        file = fopen(argv[optind], "rb");
+        if (file == NULL) {
+            perror(argv[optind]);
+            return 1;
+        }
+    }
+    data = readAll(file, &length);
+    if (file != stdin) {
+        fclose(file);
+    }
+    if (data == NULL) {
+        fprintf(stderr, "Out of memory reading the export\n");
+        return 1;
+    }
+    result = decode(data, length, rawUnits, infoOnly);
+    free(data);
+    return result;
+}
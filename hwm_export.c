@@ -0,0 +1,272 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "hwm_export.h"
+#include "hwm_gorilla.h"
+#include "hwm_history.h"
+#include "hwm_kernel.h"
+#include "hwm_sampler.h"
+#include "metrics.h"
+#include "snapshot.h"
+
+#define HWM_EXPORT_RAW 0                 // exports[0]; rollup r is at r + 1
+#define HWM_EXPORT_COUNT (1 + HWM_HISTORY_RESOLUTIONS)
+
+typedef struct {
+    const char *name;
+    Snapshot snapshot;
+    bool live;
+    uint64_t renderedOpenMs;         // Rollups: head bucket when last rendered
+    // Of the published export, for the compression ratio
+    uint64_t bytes;
+    uint64_t values;
+    uint64_t renders;
+    uint64_t renderFailures;
+} HwmExport;
+
+static HwmExport exports[HWM_EXPORT_COUNT];
+static bool exportActive = false;
+
+static void putHeader(GorillaWriter *writer, int columns, uint32_t points, uint64_t stepMs, const char *name) {
+    for (int i = 0; i < 4; i++) {
+        gorillaPutU8(writer, (uint8_t)HWM_GORILLA_MAGIC[i]);
+    }
+    gorillaPutU8(writer, HWM_GORILLA_VERSION);
+    gorillaPutU8(writer, (uint8_t)columns);
+    gorillaPutU16(writer, (uint16_t)hwmCapabilities()->count);
+    gorillaPutU32(writer, points);
+    gorillaPutU32(writer, (uint32_t)stepMs);
+    gorillaPutString(writer, name);
+}
+
+static void putSensor(GorillaWriter *writer, const HwmSensor *sensor) {
+    HwmLinear linear = hwmKindLinear(sensor->kind);
+
+    gorillaPutU32(writer, sensor->id);
+    gorillaPutU8(writer, (uint8_t)sensor->kind);
+    gorillaPutString(writer, sensor->name);
+    gorillaPutString(writer, hwmKindUnit(sensor->kind));
+    gorillaPutF64(writer, linear.scale);
+    gorillaPutF64(writer, linear.offset);
+}
+
+// The sample ring, oldest sweep first; one pass over each sensor's run
+static uint64_t encodeRaw(GorillaWriter *writer) {
+    const HwmCapabilities *caps = hwmCapabilities();
+    const HwmRingStore *ringStore = hwmRing();
+    const HwmRing *ring = &ringStore->ring;
+    uint32_t points = ringStore->sweepCount < HWM_HISTORY ? (uint32_t)ringStore->sweepCount : HWM_HISTORY;
+    uint32_t oldest = ringStore->sweepCount < HWM_HISTORY ? 0 : (uint32_t)(ringStore->sweepCount & (HWM_HISTORY - 1));
+    GorillaTimes times = { 0 };
+    size_t block;
+
+    putHeader(writer, HWM_GORILLA_RAW_COLUMNS, points, 0, exports[HWM_EXPORT_RAW].name);
+    block = gorillaBeginBlock(writer);
+    for (uint32_t n = 0; n < points; n++) {
+        gorillaPutTime(writer, &times, ring->timestampMs[(oldest + n) & (HWM_HISTORY - 1)]);
+    }
+    gorillaEndBlock(writer, block);
+    for (int i = 0; i < caps->count; i++) {
+        int slot = caps->slots[i];
+        const int32_t *values = ring->values[slot];
+        GorillaValues column = { 0 };
+
+        putSensor(writer, hwmSensor(slot));
+        block = gorillaBeginBlock(writer);
+        for (uint32_t n = 0; n < points; n++) {
+            uint32_t index = (oldest + n) & (HWM_HISTORY - 1);
+
+            gorillaPutValue(writer, &column,
+                            (ring->validMask[index] & (1ull << slot)) ? (double)values[index] : NAN);
+        }
+        gorillaEndBlock(writer, block);
+    }
+    return (uint64_t)points * (uint64_t)(caps->count + 1);
+}
+
+// The closed buckets of a resolution: min, max, avg and count columns
+static uint64_t encodeRollup(GorillaWriter *writer, const HwmRollupView *view) {
+    const HwmCapabilities *caps = hwmCapabilities();
+    GorillaTimes times = { 0 };
+    size_t block;
+
+    putHeader(writer, HWM_GORILLA_ROLLUP_COLUMNS, view->buckets, view->stepMs, view->name);
+    block = gorillaBeginBlock(writer);
+    for (uint32_t n = 0; n < view->buckets; n++) {
+        gorillaPutTime(writer, &times, view->startMs + n * view->stepMs);
+    }
+    gorillaEndBlock(writer, block);
+    for (int i = 0; i < caps->count; i++) {
+        size_t base = (size_t)i * view->capacity;
+
+        putSensor(writer, hwmSensor(caps->slots[i]));
+        for (int field = 0; field < HWM_GORILLA_ROLLUP_COLUMNS; field++) {
+            GorillaValues column = { 0 };
+
+            block = gorillaBeginBlock(writer);
+            for (uint32_t n = 0; n < view->buckets; n++) {
+                size_t index = base + (view->first + n) % view->capacity;
+                uint32_t count = view->count[index];
+                double value;
+
+                switch (field) {
+                case 0:  value = count ? (double)view->minimum[index] : NAN; break;
+                case 1:  value = count ? (double)view->maximum[index] : NAN; break;
+                case 2:  value = count ? (double)view->sum[index] / count : NAN; break;
+                default: value = (double)count; break;
+                }
+                gorillaPutValue(writer, &column, value);
+            }
+            gorillaEndBlock(writer, block);
+        }
+    }
+    return (uint64_t)view->buckets * (uint64_t)(HWM_GORILLA_ROLLUP_COLUMNS * caps->count + 1);
+}
+
+static void publishExport(HwmExport *export, const HwmRollupView *view) {
+    GorillaWriter writer;
+    size_t capacity;
+    uint64_t values;
+    char *data = snapshotBegin(&export->snapshot, &capacity);
+
+    if (data == NULL) {
+        __atomic_fetch_add(&export->renderFailures, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    for (;;) {
+        gorillaWriterInit(&writer, (uint8_t *)data, capacity);
+        values = view != NULL ? encodeRollup(&writer, view) : encodeRaw(&writer);
+        if (!writer.overflow) {
+            break;
+        }
+        if (capacity * 2 > HWM_HISTORY_MAX_CAPACITY || !snapshotGrow(&export->snapshot, capacity * 2)) {
+            printf("HWM %s export exceeds %zu bytes, snapshot not updated\n", export->name, capacity);
+            snapshotAbort(&export->snapshot);
+            __atomic_fetch_add(&export->renderFailures, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        data = snapshotBegin(&export->snapshot, &capacity);
+        if (data == NULL) {
+            __atomic_fetch_add(&export->renderFailures, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+    if (snapshotPublish(&export->snapshot, writer.bytes)) {
+        __atomic_store_n(&export->bytes, (uint64_t)writer.bytes, __ATOMIC_RELAXED);
+        __atomic_store_n(&export->values, values, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&export->renders, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Runs after the history listener, so closed buckets are already in place
+static void onSweep(const HwmReading *reading, void *ctx) {
+    (void)reading;
+    (void)ctx;
+
+    publishExport(&exports[HWM_EXPORT_RAW], NULL);
+    for (int res = 0; res < HWM_HISTORY_RESOLUTIONS; res++) {
+        HwmExport *export = &exports[res + 1];
+        HwmRollupView view;
+
+        if (export->live && hwmHistoryView(res, &view) && view.openStartMs != export->renderedOpenMs) {
+            export->renderedOpenMs = view.openStartMs;
+            publishExport(export, &view);
+        }
+    }
+}
+
+bool hwmExportStart(void) {
+    if (exportActive || hwmCapabilities()->count == 0) {
+        return false;
+    }
+    exports[HWM_EXPORT_RAW].name = "raw";
+    for (int i = 0; i < HWM_EXPORT_COUNT; i++) {
+        HwmExport *export = &exports[i];
+        HwmRollupView view;
+
+        if (i > 0) {
+            if (!hwmHistoryView(i - 1, &view)) {
+                continue;
+            }
+            export->name = view.name;
+            export->renderedOpenMs = view.openStartMs;
+        }
+        if (!snapshotInit(&export->snapshot, HWM_EXPORT_INITIAL_CAPACITY, "application/octet-stream", "hwm-export")) {
+            continue;
+        }
+        export->live = true;
+        // What the store kept, or an empty export, until the next sweep
+        publishExport(export, i > 0 ? &view : NULL);
+    }
+    if (!exports[HWM_EXPORT_RAW].live) {
+        hwmExportDestroy();
+        return false;
+    }
+    exportActive = true;
+    if (!hwmAddListener(onSweep, NULL)) {
+        hwmExportDestroy();
+        return false;
+    }
+    return true;
+}
+
+void hwmExportDestroy(void) {
+    exportActive = false;
+    for (int i = 0; i < HWM_EXPORT_COUNT; i++) {
+        if (exports[i].live) {
+            exports[i].live = false;
+            snapshotDestroy(&exports[i].snapshot);
+        }
+    }
+}
+
+enum MHD_Result hwmExportQueueResponse(struct MHD_Connection *connection, const char *resolution) {
+    if (!exportActive) {
+        return MHD_NO;
+    }
+    if (resolution == NULL) {
+        resolution = "1m";
+    }
+    for (int i = 0; i < HWM_EXPORT_COUNT; i++) {
+        if (exports[i].live && strcmp(resolution, exports[i].name) == 0) {
+            return snapshotQueue(&exports[i].snapshot, connection);
+        }
+    }
+    return MHD_NO;
+}
+
+void hwmExportCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (!exportActive) {
+        return;
+    }
+    metricsHeader(out, "watchdog_hwm_export_bytes", "gauge", "Size of the published compressed HWM export");
+    for (int i = 0; i < HWM_EXPORT_COUNT; i++) {
+        if (exports[i].live) {
+            strbufAppendf(out, "watchdog_hwm_export_bytes{resolution=\"%s\"} %llu\n", exports[i].name,
+                          (unsigned long long)__atomic_load_n(&exports[i].bytes, __ATOMIC_RELAXED));
+        }
+    }
+    metricsHeader(out, "watchdog_hwm_export_bits_per_value", "gauge",
+                  "Bits per timestamp or value in the compressed HWM export, headers included");
+    for (int i = 0; i < HWM_EXPORT_COUNT; i++) {
+        uint64_t values = __atomic_load_n(&exports[i].values, __ATOMIC_RELAXED);
+
+        if (exports[i].live && values > 0) {
+            strbufAppendf(out, "watchdog_hwm_export_bits_per_value{resolution=\"%s\"} %.2f\n", exports[i].name,
+                          8.0 * (double)__atomic_load_n(&exports[i].bytes, __ATOMIC_RELAXED) / (double)values);
+        }
+    }
+    metricsHeader(out, "watchdog_hwm_export_renders_total", "counter", "Compressed HWM exports rendered by resolution");
+    for (int i = 0; i < HWM_EXPORT_COUNT; i++) {
+        if (!exports[i].live) {
+            continue;
+        }
+        strbufAppendf(out, "watchdog_hwm_export_renders_total{resolution=\"%s\",result=\"ok\"} %llu\n",
+                      exports[i].name, (unsigned long long)__atomic_load_n(&exports[i].renders, __ATOMIC_RELAXED));
+        strbufAppendf(out, "watchdog_hwm_export_renders_total{resolution=\"%s\",result=\"error\"} %llu\n",
+                      exports[i].name,
+                      (unsigned long long)__atomic_load_n(&exports[i].renderFailures, __ATOMIC_RELAXED));
+    }
+}
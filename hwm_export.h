@@ -0,0 +1,31 @@
+#ifndef HWM_EXPORT_H
+#define HWM_EXPORT_H
+
+#include <stdbool.h>
+#include <microhttpd.h>
+#include "strbuf.h"
+
+#define HWM_EXPORT_INITIAL_CAPACITY 16384
+
+// GET /api/hwm/export: the sample ring (res=raw) and the rollups in the
+// compressed format of hwm_gorilla.h, for uploading history over thin
+// links. Each column is encoded straight from its contiguous run in the
+// ring or rollup arrays on the sampler task, right after the sweep that
+// changed it: the raw export after every sweep, a resolution's export
+// when one of its buckets closes. As with the JSON history, a request
+// only queues the published snapshot. hwm_decode turns a file back into
+// CSV.
+
+// Add the sweep listener; after hwmHistoryStart() and before hwmStart().
+// Without history only res=raw is served.
+bool hwmExportStart(void);
+// Once the sampler is stopped and MHD no longer holds responses
+void hwmExportDestroy(void);
+
+// GET /api/hwm/export?res=raw|10s|1m|15m (default 1m); MHD_NO for an
+// unknown resolution or one that is not available
+enum MHD_Result hwmExportQueueResponse(struct MHD_Connection *connection, const char *resolution);
+
+void hwmExportCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // HWM_EXPORT_H
@@ -0,0 +1,297 @@
+#include <string.h>
+#include "hwm_gorilla.h"
+
+#define GORILLA_NO_WINDOW 64             // Leading zeros before the first window: never reused
+
+static void putByte(GorillaWriter *writer, uint8_t value) {
+    if (writer->bytes < writer->capacity) {
+        writer->data[writer->bytes++] = value;
+    } else {
+        writer->overflow = true;
+    }
+}
+
+// The low count bits of value, most significant first
+static void putBits(GorillaWriter *writer, uint64_t value, int count) {
+    while (count > 0) {
+        int take = count < 8 - writer->pending ? count : 8 - writer->pending;
+
+        writer->bits = (writer->bits << take) | ((value >> (count - take)) & ((1ull << take) - 1));
+        writer->pending += take;
+        count -= take;
+        if (writer->pending == 8) {
+            putByte(writer, (uint8_t)writer->bits);
+            writer->bits = 0;
+            writer->pending = 0;
+        }
+    }
+}
+
+void gorillaWriterInit(GorillaWriter *writer, uint8_t *data, size_t capacity) {
+    memset(writer, 0, sizeof(*writer));
+    writer->data = data;
+    writer->capacity = capacity;
+}
+
+void gorillaPutU8(GorillaWriter *writer, uint8_t value) {
+    putByte(writer, value);
+}
+
+void gorillaPutU16(GorillaWriter *writer, uint16_t value) {
+    putByte(writer, (uint8_t)value);
+    putByte(writer, (uint8_t)(value >> 8));
+}
+
+void gorillaPutU32(GorillaWriter *writer, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        putByte(writer, (uint8_t)(value >> (8 * i)));
+    }
+}
+
+void gorillaPutF64(GorillaWriter *writer, double value) {
+    uint64_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    for (int i = 0; i < 8; i++) {
+        putByte(writer, (uint8_t)(bits >> (8 * i)));
+    }
+}
+
+void gorillaPutString(GorillaWriter *writer, const char *text) {
+    size_t length = strlen(text);
+
+    if (length > 255) {
+        length = 255;
+    }
+    putByte(writer, (uint8_t)length);
+    for (size_t i = 0; i < length; i++) {
+        putByte(writer, (uint8_t)text[i]);
+    }
+}
+
+size_t gorillaBeginBlock(GorillaWriter *writer) {
+    size_t block = writer->bytes;
+
+    gorillaPutU32(writer, 0);
+    return block;
+}
+
+void gorillaEndBlock(GorillaWriter *writer, size_t block) {
+    uint32_t length;
+
+    if (writer->pending > 0) {
+        putBits(writer, 0, 8 - writer->pending);
+    }
+    if (writer->overflow) {
+        return;
+    }
+    length = (uint32_t)(writer->bytes - block - 4);
+    for (int i = 0; i < 4; i++) {
+        writer->data[block + i] = (uint8_t)(length >> (8 * i));
+    }
+}
+
+void gorillaPutTime(GorillaWriter *writer, GorillaTimes *times, uint64_t timestampMs) {
+    if (times->count == 0) {
+        putBits(writer, timestampMs, 64);
+    } else {
+        int64_t delta = (int64_t)(timestampMs - times->last);
+        int64_t change = delta - times->lastDelta;
+
+        if (change == 0) {
+            putBits(writer, 0, 1);
+        } else if (change >= -64 && change <= 63) {
+            putBits(writer, 0x2, 2);
+            putBits(writer, (uint64_t)change, 7);
+        } else if (change >= -256 && change <= 255) {
+            putBits(writer, 0x6, 3);
+            putBits(writer, (uint64_t)change, 9);
+        } else if (change >= -2048 && change <= 2047) {
+            putBits(writer, 0xe, 4);
+            putBits(writer, (uint64_t)change, 12);
+        } else {
+            putBits(writer, 0xf, 4);
+            putBits(writer, (uint64_t)change, 64);
+        }
+        times->lastDelta = delta;
+    }
+    times->last = timestampMs;
+    times->count++;
+}
+
+void gorillaPutValue(GorillaWriter *writer, GorillaValues *values, double value) {
+    uint64_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    if (values->count == 0) {
+        putBits(writer, bits, 64);
+        values->leading = GORILLA_NO_WINDOW;
+    } else {
+        uint64_t xor = bits ^ values->last;
+
+        if (xor == 0) {
+            putBits(writer, 0, 1);
+        } else {
+            int leading = __builtin_clzll(xor);
+            int trailing = __builtin_ctzll(xor);
+
+            if (leading > 31) {
+                leading = 31;
+            }
+            if (leading >= values->leading && trailing >= values->trailing) {
+                putBits(writer, 0x2, 2);
+                putBits(writer, xor >> values->trailing, 64 - values->leading - values->trailing);
+            } else {
+                int length = 64 - leading - trailing;
+
+                putBits(writer, 0x3, 2);
+                putBits(writer, (uint64_t)leading, 5);
+                putBits(writer, (uint64_t)(length & 63), 6);
+                putBits(writer, xor >> trailing, length);
+                values->leading = leading;
+                values->trailing = trailing;
+            }
+        }
+    }
+    values->last = bits;
+    values->count++;
+}
+
+static uint64_t getBits(GorillaReader *reader, int count) {
+    uint64_t value = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (reader->bit >= (uint64_t)reader->bytes * 8) {
+            reader->overflow = true;
+            return 0;
+        }
+        value = (value << 1) | ((reader->data[reader->bit >> 3] >> (7 - (reader->bit & 7))) & 1);
+        reader->bit++;
+    }
+    return value;
+}
+
+static int64_t signExtend(uint64_t value, int bits) {
+    uint64_t sign = 1ull << (bits - 1);
+
+    return (int64_t)((value ^ sign) - sign);
+}
+
+void gorillaReaderInit(GorillaReader *reader, const uint8_t *data, size_t bytes) {
+    reader->data = data;
+    reader->bytes = bytes;
+    reader->bit = 0;
+    reader->overflow = false;
+}
+
+uint8_t gorillaGetU8(GorillaReader *reader) {
+    return (uint8_t)getBits(reader, 8);
+}
+
+uint16_t gorillaGetU16(GorillaReader *reader) {
+    uint16_t low = gorillaGetU8(reader);
+
+    return (uint16_t)(low | (uint16_t)gorillaGetU8(reader) << 8);
+}
+
+uint32_t gorillaGetU32(GorillaReader *reader) {
+    uint32_t value = 0;
+
+    for (int i = 0; i < 4; i++) {
+        value |= (uint32_t)gorillaGetU8(reader) << (8 * i);
+    }
+    return value;
+}
+
+double gorillaGetF64(GorillaReader *reader) {
+    uint64_t bits = 0;
+    double value;
+
+    for (int i = 0; i < 8; i++) {
+        bits |= (uint64_t)gorillaGetU8(reader) << (8 * i);
+    }
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void gorillaGetString(GorillaReader *reader, char *text, size_t size) {
+    size_t length = gorillaGetU8(reader);
+
+    for (size_t i = 0; i < length; i++) {
+        char c = (char)gorillaGetU8(reader);
+
+        if (i + 1 < size) {
+            text[i] = c;
+        }
+    }
+    text[length < size ? length : size - 1] = '\0';
+}
+
+GorillaReader gorillaGetBlock(GorillaReader *reader) {
+    GorillaReader block;
+    uint32_t length = gorillaGetU32(reader);
+    size_t offset = (size_t)(reader->bit >> 3);
+
+    if (reader->overflow || length > reader->bytes - offset) {
+        reader->overflow = true;
+        gorillaReaderInit(&block, reader->data, 0);
+        block.overflow = true;
+        return block;
+    }
+    gorillaReaderInit(&block, reader->data + offset, length);
+    reader->bit += (uint64_t)length * 8;
+    return block;
+}
+
+uint64_t gorillaGetTime(GorillaReader *reader, GorillaTimes *times) {
+    if (times->count == 0) {
+        times->last = getBits(reader, 64);
+    } else {
+        int64_t change;
+
+        if (getBits(reader, 1) == 0) {
+            change = 0;
+        } else if (getBits(reader, 1) == 0) {
+            change = signExtend(getBits(reader, 7), 7);
+        } else if (getBits(reader, 1) == 0) {
+            change = signExtend(getBits(reader, 9), 9);
+        } else if (getBits(reader, 1) == 0) {
+            change = signExtend(getBits(reader, 12), 12);
+        } else {
+            change = (int64_t)getBits(reader, 64);
+        }
+        times->lastDelta += change;
+        times->last += (uint64_t)times->lastDelta;
+    }
+    times->count++;
+    return times->last;
+}
+
+double gorillaGetValue(GorillaReader *reader, GorillaValues *values) {
+    double value;
+
+    if (values->count == 0) {
+        values->last = getBits(reader, 64);
+    } else if (getBits(reader, 1) != 0) {
+        if (getBits(reader, 1) == 0) {
+            values->last ^= getBits(reader, 64 - values->leading - values->trailing) << values->trailing;
+        } else {
+            int leading = (int)getBits(reader, 5);
+            int length = (int)getBits(reader, 6);
+
+            if (length == 0) {
+                length = 64;
+            }
+            values->leading = leading;
+            values->trailing = 64 - leading - length;
+            if (values->trailing < 0) {
+                reader->overflow = true;
+                values->trailing = 0;
+            }
+            values->last ^= getBits(reader, length) << values->trailing;
+        }
+    }
+    values->count++;
+    memcpy(&value, &values->last, sizeof(value));
+    return value;
+}
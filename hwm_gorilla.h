@@ -0,0 +1,99 @@
+#ifndef HWM_GORILLA_H
+#define HWM_GORILLA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Compressed export of the HWM sample ring and rollups, written by the
+// service (hwm_export.c) and read by hwm_decode. Timestamps are stored as
+// delta-of-delta and every value column as the XOR of consecutive doubles,
+// the encoding of Facebook's Gorilla: regular sweeps and buckets cost one
+// bit per timestamp, and a sensor that did not move one bit per value.
+// Values are in the sensor's raw unit (0.1 K, mV, RPM, mA), which as
+// doubles have few significant bits; each sensor carries the scale and
+// offset that convert them. Missing values (a sweep that skipped the
+// sensor, an empty bucket) are NaN.
+//
+// Layout, integers little-endian:
+//   "HWMG", u8 version, u8 columns per sensor, u16 sensors, u32 points,
+//   u32 step_ms (0 for raw sweeps), u8 length + resolution name
+//   block: timestamps in ms
+//   per sensor: u32 SUSI id, u8 kind, u8 length + name, u8 length + unit,
+//   f64 scale, f64 offset, then one block per column
+// A block is a u32 byte length and that many bytes of bits, most
+// significant first, padded to a byte. Raw sweeps have one column
+// (value), rollups four (min, max, avg, count).
+//
+// Timestamps: the first in 64 bits, then the change of the delta: '0'
+// for none, '10' + 7 bits, '110' + 9 bits, '1110' + 12 bits (two's
+// complement) or '1111' + 64 bits. The first delta counts from 0.
+// Values: the first in 64 bits, then '0' when equal to the previous one,
+// '10' + the meaningful bits when the XOR fits in the previous window,
+// or '11' + 5 bits of leading zeros (at most 31) + 6 bits of length (0
+// for 64) + the meaningful bits.
+
+#define HWM_GORILLA_MAGIC "HWMG"
+#define HWM_GORILLA_VERSION 1
+#define HWM_GORILLA_RAW_COLUMNS 1
+#define HWM_GORILLA_ROLLUP_COLUMNS 4
+
+typedef struct {
+    uint8_t *data;
+    size_t capacity;
+    size_t bytes;                    // Complete bytes written
+    uint64_t bits;                   // Pending bits, fewer than 8
+    int pending;
+    bool overflow;
+} GorillaWriter;
+
+typedef struct {
+    const uint8_t *data;
+    size_t bytes;
+    uint64_t bit;                    // Next bit to read
+    bool overflow;                   // Read past the end
+} GorillaReader;
+
+// Encoder or decoder state of one timestamp column
+typedef struct {
+    uint64_t count;
+    uint64_t last;
+    int64_t lastDelta;
+} GorillaTimes;
+
+// Encoder or decoder state of one value column
+typedef struct {
+    uint64_t count;
+    uint64_t last;                   // Bits of the previous double
+    int leading;
+    int trailing;
+} GorillaValues;
+
+void gorillaWriterInit(GorillaWriter *writer, uint8_t *data, size_t capacity);
+void gorillaPutU8(GorillaWriter *writer, uint8_t value);
+void gorillaPutU16(GorillaWriter *writer, uint16_t value);
+void gorillaPutU32(GorillaWriter *writer, uint32_t value);
+void gorillaPutF64(GorillaWriter *writer, double value);
+// u8 length and up to 255 bytes of text
+void gorillaPutString(GorillaWriter *writer, const char *text);
+
+// A block: begin returns its offset, end pads the bits and fills in
+// the length
+size_t gorillaBeginBlock(GorillaWriter *writer);
+void gorillaEndBlock(GorillaWriter *writer, size_t block);
+void gorillaPutTime(GorillaWriter *writer, GorillaTimes *times, uint64_t timestampMs);
+void gorillaPutValue(GorillaWriter *writer, GorillaValues *values, double value);
+
+void gorillaReaderInit(GorillaReader *reader, const uint8_t *data, size_t bytes);
+uint8_t gorillaGetU8(GorillaReader *reader);
+uint16_t gorillaGetU16(GorillaReader *reader);
+uint32_t gorillaGetU32(GorillaReader *reader);
+double gorillaGetF64(GorillaReader *reader);
+// Into text, which holds size bytes
+void gorillaGetString(GorillaReader *reader, char *text, size_t size);
+// A reader over the block's bits; the outer reader moves past it
+GorillaReader gorillaGetBlock(GorillaReader *reader);
+uint64_t gorillaGetTime(GorillaReader *reader, GorillaTimes *times);
+double gorillaGetValue(GorillaReader *reader, GorillaValues *values);
+
+#endif // HWM_GORILLA_H
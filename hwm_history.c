@@ -0,0 +1,382 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hwm_history.h"
+#include "hwm_kernel.h"
+#include "hwm_sampler.h"
+#include "snapshot.h"
+#include "json_writer.h"
+#include "metrics.h"
+
+typedef enum {
+    HWM_RES_10S,
+    HWM_RES_1M,
+    HWM_RES_15M,
+    HWM_RES_COUNT
+} HwmResolution;
+
+typedef char HwmResolutionsMatch[HWM_RES_COUNT == HWM_HISTORY_RESOLUTIONS ? 1 : -1];
+
+// Ring position of one resolution. It is stored in front of the buckets, so
+// a store-backed history resumes where the previous run stopped.
+typedef struct {
+    uint32_t head;                   // Bucket still being filled, never rendered
+    uint32_t closed;                 // Complete buckets behind head
+    uint64_t openStartMs;            // Start of the head bucket, 0 before the first sweep
+} HwmRollupState;
+
+// One resolution. Bucket b of compact sensor i lives at [i * capacity + b].
+typedef struct {
+    const char *name;
+    uint64_t stepMs;
+    uint32_t capacity;
+    HwmRollupState *state;
+    int64_t *sum;
+    int32_t *minimum;
+    int32_t *maximum;
+    uint32_t *count;
+    Snapshot snapshot;
+    uint64_t renders;
+    uint64_t renderFailures;
+} HwmRollup;
+
+// One extra bucket each for the head, so exactly 1 h / 24 h / 24 h are closed
+#define HWM_ROLLUP_MAX_BUCKETS (1440 + 1)
+static HwmRollup rollups[HWM_RES_COUNT] = {
+    [HWM_RES_10S] = { .name = "10s", .stepMs = 10000,  .capacity = 360 + 1 },
+    [HWM_RES_1M]  = { .name = "1m",  .stepMs = 60000,  .capacity = HWM_ROLLUP_MAX_BUCKETS },
+    [HWM_RES_15M] = { .name = "15m", .stepMs = 900000, .capacity = 96 + 1 },
+};
+
+// State block, then all sums, then min/max/count (keeps every array aligned)
+#define HWM_HISTORY_STATE_BYTES 64
+typedef char HwmRollupStateFits[sizeof(HwmRollupState) * HWM_RES_COUNT <= HWM_HISTORY_STATE_BYTES ? 1 : -1];
+
+static void *storage = NULL;
+static bool ownsStorage = false;
+static size_t storageBytes = 0;
+static int sensorCount = 0;
+static bool historyActive = false;
+
+static int kindDecimals(HwmKind kind) {
+    switch (kind) {
+        case HWM_KIND_TEMPERATURE: return 2;
+        case HWM_KIND_FAN:         return 0;
+        default:                   return 3;
+    }
+}
+
+static void clearBucket(HwmRollup *rollup, uint32_t bucket) {
+    for (int i = 0; i < sensorCount; i++) {
+        rollup->count[(size_t)i * rollup->capacity + bucket] = 0;
+    }
+}
+
+// Converted min/max/avg of one sensor, oldest bucket first. Only the thread
+// that publishes rollups touches it.
+static double columns[3][HWM_ROLLUP_MAX_BUCKETS];
+
+// Convert buckets [first, first + n) of a sensor's run to columns[*][at...]
+static void convertSegment(const HwmRollup *rollup, HwmKind kind, size_t base, uint32_t first, uint32_t n, uint32_t at) {
+    const uint32_t *count = rollup->count + base + first;
+
+    hwmKernelConvert(kind, rollup->minimum + base + first, columns[0] + at, n);
+    hwmKernelConvert(kind, rollup->maximum + base + first, columns[1] + at, n);
+    hwmKernelMeans(kind, rollup->sum + base + first, count, columns[2] + at, n);
+    // Extremes of an emptied bucket are stale; the means are already NaN
+    for (uint32_t i = 0; i < n; i++) {
+        columns[0][at + i] = count[i] != 0 ? columns[0][at + i] : NAN;
+        columns[1][at + i] = count[i] != 0 ? columns[1][at + i] : NAN;
+    }
+}
+
+static void renderRollup(StrBuf *out, const HwmRollup *rollup) {
+    const HwmCapabilities *caps = hwmCapabilities();
+    uint32_t first = (rollup->state->head + rollup->capacity - rollup->state->closed) % rollup->capacity;
+    static const char *fields[] = { "min", "max", "avg", "count" };
+    JsonWriter writer;
+
+    jsonWriterInit(&writer, out);
+    jsonBeginObject(&writer);
+    jsonFieldString(&writer, "resolution", rollup->name);
+    jsonFieldUint(&writer, "step_ms", rollup->stepMs);
+    jsonFieldUint(&writer, "start_ms", rollup->state->closed > 0 ? rollup->state->openStartMs - rollup->state->closed * rollup->stepMs : 0);
+    jsonFieldUint(&writer, "buckets", rollup->state->closed);
+    jsonKey(&writer, "sensors");
+    jsonBeginArray(&writer);
+    for (int i = 0; i < sensorCount; i++) {
+        const HwmSensor *sensor = hwmSensor(caps->slots[i]);
+        size_t base = (size_t)i * rollup->capacity;
+        int decimals = kindDecimals(sensor->kind);
+        uint32_t tail = rollup->capacity - first < rollup->state->closed ? rollup->capacity - first : rollup->state->closed;
+
+        // The closed buckets wrap at most once, so two contiguous runs
+        convertSegment(rollup, sensor->kind, base, first, tail, 0);
+        convertSegment(rollup, sensor->kind, base, 0, rollup->state->closed - tail, tail);
+
+        jsonBeginObject(&writer);
+        jsonFieldUint(&writer, "id", sensor->id);
+        jsonFieldString(&writer, "name", sensor->name);
+        jsonFieldString(&writer, "kind", hwmKindName(sensor->kind));
+        jsonFieldString(&writer, "unit", hwmKindUnit(sensor->kind));
+        // Column per statistic, oldest bucket first; empty buckets are null
+        for (int field = 0; field < 4; field++) {
+            jsonKey(&writer, fields[field]);
+            jsonBeginArray(&writer);
+            for (uint32_t n = 0; n < rollup->state->closed; n++) {
+                if (field == 3) {
+                    jsonUint(&writer, rollup->count[base + (first + n) % rollup->capacity]);
+                } else {
+                    jsonDouble(&writer, columns[field][n], decimals);
+                }
+            }
+            jsonEndArray(&writer);
+        }
+        jsonEndObject(&writer);
+    }
+    jsonEndArray(&writer);
+    jsonEndObject(&writer);
+    strbufAppendChar(out, '\n');
+}
+
+static void publishRollup(HwmRollup *rollup) {
+    StrBuf out;
+    size_t capacity;
+    char *data = snapshotBegin(&rollup->snapshot, &capacity);
+
+    if (data == NULL) {
+        __atomic_fetch_add(&rollup->renderFailures, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    for (;;) {
+        strbufInit(&out, data, capacity);
+        renderRollup(&out, rollup);
+        if (!out.overflow) {
+            break;
+        }
+        if (capacity * 2 > HWM_HISTORY_MAX_CAPACITY || !snapshotGrow(&rollup->snapshot, capacity * 2)) {
+            printf("HWM %s history exceeds %zu bytes, snapshot not updated\n", rollup->name, capacity);
+            snapshotAbort(&rollup->snapshot);
+            __atomic_fetch_add(&rollup->renderFailures, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        data = snapshotBegin(&rollup->snapshot, &capacity);
+        if (data == NULL) {
+            __atomic_fetch_add(&rollup->renderFailures, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+    if (snapshotPublish(&rollup->snapshot, out.length)) {
+        __atomic_fetch_add(&rollup->renders, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Close buckets until the head covers bucketStart. A jump longer than the
+// ring just empties it; a clock stepping backwards keeps filling the head.
+static bool advance(HwmRollup *rollup, uint64_t bucketStart) {
+    uint64_t steps;
+
+    if (rollup->state->openStartMs == 0) {
+        rollup->state->openStartMs = bucketStart;
+        return false;
+    }
+    if (bucketStart <= rollup->state->openStartMs) {
+        return false;
+    }
+    steps = (bucketStart - rollup->state->openStartMs) / rollup->stepMs;
+    if (steps > rollup->capacity) {
+        steps = rollup->capacity;
+    }
+    for (uint64_t n = 0; n < steps; n++) {
+        rollup->state->head = (rollup->state->head + 1) % rollup->capacity;
+        clearBucket(rollup, rollup->state->head);
+        if (rollup->state->closed < rollup->capacity - 1) {
+            rollup->state->closed++;
+        }
+    }
+    rollup->state->openStartMs = bucketStart;
+    return true;
+}
+
+static void onSweep(const HwmReading *reading, void *ctx) {
+    const HwmCapabilities *caps = hwmCapabilities();
+    (void)ctx;
+
+    for (int res = 0; res < HWM_RES_COUNT; res++) {
+        HwmRollup *rollup = &rollups[res];
+        bool closed = advance(rollup, reading->timestampMs - reading->timestampMs % rollup->stepMs);
+
+        for (int i = 0; i < sensorCount; i++) {
+            int slot = caps->slots[i];
+            size_t index = (size_t)i * rollup->capacity + rollup->state->head;
+            int32_t value = reading->values[slot];
+
+            if (!(reading->validMask & (1ull << slot))) {
+                continue;
+            }
+            if (rollup->count[index] == 0) {
+                rollup->minimum[index] = value;
+                rollup->maximum[index] = value;
+                rollup->sum[index] = 0;
+            } else if (value < rollup->minimum[index]) {
+                rollup->minimum[index] = value;
+            } else if (value > rollup->maximum[index]) {
+                rollup->maximum[index] = value;
+            }
+            rollup->sum[index] += value;
+            rollup->count[index]++;
+        }
+        if (closed) {
+            publishRollup(rollup);
+        }
+    }
+}
+
+size_t hwmHistoryStorageBytes(void) {
+    size_t bytes = HWM_HISTORY_STATE_BYTES;
+
+    for (int res = 0; res < HWM_RES_COUNT; res++) {
+        bytes += (size_t)hwmCapabilities()->count * rollups[res].capacity *
+                 (sizeof(int64_t) + 2 * sizeof(int32_t) + sizeof(uint32_t));
+    }
+    return bytes;
+}
+
+bool hwmHistoryStart(void *block) {
+    HwmRollupState *states;
+    size_t offset = HWM_HISTORY_STATE_BYTES;
+    bool resumed = block != NULL;
+
+    if (historyActive) {
+        return false;
+    }
+    sensorCount = hwmCapabilities()->count;
+    if (sensorCount == 0) {
+        return false;
+    }
+    storageBytes = hwmHistoryStorageBytes();
+    ownsStorage = block == NULL;
+    storage = ownsStorage ? calloc(1, storageBytes) : block;
+    if (storage == NULL) {
+        return false;
+    }
+
+    states = (HwmRollupState *)storage;
+    for (int res = 0; res < HWM_RES_COUNT; res++) {
+        size_t cells = (size_t)sensorCount * rollups[res].capacity;
+
+        rollups[res].state = &states[res];
+        rollups[res].sum = (int64_t *)((char *)storage + offset);
+        offset += cells * sizeof(int64_t);
+    }
+    for (int res = 0; res < HWM_RES_COUNT; res++) {
+        HwmRollup *rollup = &rollups[res];
+        size_t cells = (size_t)sensorCount * rollup->capacity;
+
+        rollup->minimum = (int32_t *)((char *)storage + offset);
+        offset += cells * sizeof(int32_t);
+        rollup->maximum = (int32_t *)((char *)storage + offset);
+        offset += cells * sizeof(int32_t);
+        rollup->count = (uint32_t *)((char *)storage + offset);
+        offset += cells * sizeof(uint32_t);
+
+        // A damaged ring position would index outside the buckets
+        if (rollup->state->head >= rollup->capacity || rollup->state->closed >= rollup->capacity) {
+            memset(rollup->state, 0, sizeof(*rollup->state));
+            memset(rollup->count, 0, cells * sizeof(uint32_t));
+        }
+    }
+
+    for (int res = 0; res < HWM_RES_COUNT; res++) {
+        if (!snapshotInit(&rollups[res].snapshot, HWM_HISTORY_INITIAL_CAPACITY, "application/json", "hwm-history")) {
+            while (--res >= 0) {
+                snapshotDestroy(&rollups[res].snapshot);
+            }
+            if (ownsStorage) {
+                free(storage);
+            }
+            storage = NULL;
+            return false;
+        }
+        // Served until the next bucket closes: empty, or what the store kept
+        publishRollup(&rollups[res]);
+    }
+
+    historyActive = true;
+    if (!hwmAddListener(onSweep, NULL)) {
+        hwmHistoryDestroy();
+        return false;
+    }
+    printf("HWM history: %zu KiB for %d sensor(s)%s\n", storageBytes / 1024, sensorCount,
+           resumed && rollups[HWM_RES_10S].state->closed > 0 ? ", resumed from the store" : "");
+    return true;
+}
+
+void hwmHistoryDestroy(void) {
+    if (!historyActive) {
+        return;
+    }
+    historyActive = false;
+    for (int res = 0; res < HWM_RES_COUNT; res++) {
+        snapshotDestroy(&rollups[res].snapshot);
+    }
+    if (ownsStorage) {
+        free(storage);
+    }
+    storage = NULL;
+}
+
+enum MHD_Result hwmHistoryQueueResponse(struct MHD_Connection *connection, const char *resolution) {
+    if (!historyActive) {
+        return MHD_NO;
+    }
+    if (resolution == NULL) {
+        resolution = rollups[HWM_RES_1M].name;
+    }
+    for (int res = 0; res < HWM_RES_COUNT; res++) {
+        if (strcmp(resolution, rollups[res].name) == 0) {
+            return snapshotQueue(&rollups[res].snapshot, connection);
+        }
+    }
+    return MHD_NO;
+}
+
+bool hwmHistoryView(int resolution, HwmRollupView *view) {
+    const HwmRollup *rollup;
+
+    if (!historyActive || resolution < 0 || resolution >= HWM_RES_COUNT) {
+        return false;
+    }
+    rollup = &rollups[resolution];
+    view->name = rollup->name;
+    view->stepMs = rollup->stepMs;
+    view->buckets = rollup->state->closed;
+    view->startMs = view->buckets > 0 ? rollup->state->openStartMs - view->buckets * rollup->stepMs : 0;
+    view->openStartMs = rollup->state->openStartMs;
+    view->first = (rollup->state->head + rollup->capacity - rollup->state->closed) % rollup->capacity;
+    view->capacity = rollup->capacity;
+    view->sum = rollup->sum;
+    view->minimum = rollup->minimum;
+    view->maximum = rollup->maximum;
+    view->count = rollup->count;
+    return true;
+}
+
+void hwmHistoryCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (!historyActive) {
+        return;
+    }
+    metricsHeader(out, "watchdog_hwm_history_bytes", "gauge", "Memory preallocated for HWM rollups");
+    strbufAppendf(out, "watchdog_hwm_history_bytes %zu\n", storageBytes);
+    metricsHeader(out, "watchdog_hwm_history_renders_total", "counter", "HWM history snapshots rendered by resolution");
+    for (int res = 0; res < HWM_RES_COUNT; res++) {
+        strbufAppendf(out, "watchdog_hwm_history_renders_total{resolution=\"%s\",result=\"ok\"} %llu\n",
+                      rollups[res].name, (unsigned long long)__atomic_load_n(&rollups[res].renders, __ATOMIC_RELAXED));
+        strbufAppendf(out, "watchdog_hwm_history_renders_total{resolution=\"%s\",result=\"error\"} %llu\n",
+                      rollups[res].name,
+                      (unsigned long long)__atomic_load_n(&rollups[res].renderFailures, __ATOMIC_RELAXED));
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef HWM_HISTORY_H
+#define HWM_HISTORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <microhttpd.h>
+#include "strbuf.h"
+
+#define HWM_HISTORY_INITIAL_CAPACITY 65536
+#define HWM_HISTORY_MAX_CAPACITY (16 * 1024 * 1024)
+#define HWM_HISTORY_RESOLUTIONS 3        // 10s, 1m, 15m
+
+// The closed buckets of one resolution, oldest first: bucket n of compact
+// sensor i is at [i * capacity + (first + n) % capacity] of each array
+typedef struct {
+    const char *name;
+    uint64_t stepMs;
+    uint64_t startMs;                // Start of the oldest closed bucket
+    uint64_t openStartMs;            // Changes whenever a bucket closes
+    uint32_t buckets;
+    uint32_t first;
+    uint32_t capacity;
+    const int64_t *sum;
+    const int32_t *minimum;
+    const int32_t *maximum;
+    const uint32_t *count;
+} HwmRollupView;
+
+// Min/max/avg/count rollups of the HWM sweeps at 10 s (1 h kept), 1 min
+// (24 h) and 15 min (24 h). Every resolution is a preallocated ring with
+// one contiguous run of buckets per sensor, updated in place as sweeps
+// arrive; the JSON for a resolution is re-rendered only when one of its
+// buckets closes, so a query just queues the published snapshot.
+
+// Bytes needed for the rings of the discovered sensors (after hwmInit())
+size_t hwmHistoryStorageBytes(void);
+// Subscribe to the sampler; call before hwmStart(). storage is either NULL
+// to allocate the rings, or hwmHistoryStorageBytes() of memory that is
+// zeroed or holds the rings of an earlier run with the same sensors.
+bool hwmHistoryStart(void *storage);
+// Drop the snapshots (and allocated rings) once the sampler is stopped and
+// MHD no longer holds responses
+void hwmHistoryDestroy(void);
+
+// GET /api/hwm/history?res=10s|1m|15m (default 1m); MHD_NO for an unknown
+// resolution or when history is not running
+enum MHD_Result hwmHistoryQueueResponse(struct MHD_Connection *connection, const char *resolution);
+
+// For sweep listeners added after hwmHistoryStart(), which see the buckets
+// as this sweep left them; false when history is not running
+bool hwmHistoryView(int resolution, HwmRollupView *view);
+
+void hwmHistoryCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // HWM_HISTORY_H
@@ -0,0 +1,86 @@
+#include <math.h>
+#include "hwm_kernel.h"
+
+static const HwmLinear linears[HWM_KIND_COUNT] = {
+    [HWM_KIND_TEMPERATURE] = { 0.1, -273.1 },    // 0.1 Kelvin
+    [HWM_KIND_VOLTAGE]     = { 0.001, 0 },       // Millivolts
+    [HWM_KIND_FAN]         = { 1, 0 },
+    [HWM_KIND_CURRENT]     = { 0.001, 0 },       // Milliamperes
+    [HWM_KIND_CASE_OPEN]   = { 1, 0 },
+};
+
+HwmLinear hwmKindLinear(HwmKind kind) {
+    static const HwmLinear identity = { 1, 0 };
+
+    return kind < HWM_KIND_COUNT ? linears[kind] : identity;
+}
+
+void hwmKernelConvert(HwmKind kind, const int32_t *restrict raw, double *restrict out, size_t n) {
+    HwmLinear linear = hwmKindLinear(kind);
+
+    for (size_t i = 0; i < n; i++) {
+        out[i] = raw[i] * linear.scale + linear.offset;
+    }
+}
+
+void hwmKernelMeans(HwmKind kind, const int64_t *restrict sum, const uint32_t *restrict count,
+                    double *restrict out, size_t n) {
+    HwmLinear linear = hwmKindLinear(kind);
+
+    // 0/0 is NaN, which is exactly what an empty bucket should read as
+    for (size_t i = 0; i < n; i++) {
+        out[i] = (double)sum[i] / (double)count[i] * linear.scale + linear.offset;
+    }
+}
+
+HwmStats hwmKernelStats(HwmKind kind, const int32_t *restrict raw, const uint64_t *restrict validMask, int slot, size_t n) {
+    HwmLinear linear = hwmKindLinear(kind);
+    HwmStats stats;
+    int64_t sum = 0;
+    int64_t squares = 0;             // Exact: |raw| < 2^17 and n is a ring length
+    int64_t count = 0;
+    int32_t minimum = INT32_MAX;
+    int32_t maximum = INT32_MIN;
+
+    // 32-bit lanes with an all-ones/all-zeros keep mask; only the square is
+    // widened, which SSE4.1 and NEON do in one instruction
+    for (size_t i = 0; i < n; i++) {
+        int32_t valid = (int32_t)(validMask[i] >> slot) & 1;
+        int32_t keep = -valid;
+        int32_t value = raw[i] & keep;
+        int32_t low = value | (~keep & INT32_MAX);
+        int32_t high = value | (~keep & INT32_MIN);
+
+        sum += value;
+        squares += (int64_t)value * value;
+        count += valid;
+        minimum = low < minimum ? low : minimum;
+        maximum = high > maximum ? high : maximum;
+    }
+
+    stats.count = (uint32_t)count;
+    if (count == 0) {
+        stats.minimum = stats.maximum = stats.mean = stats.stddev = NAN;
+        return stats;
+    }
+    stats.mean = (double)sum / count;
+    // Integer sums keep the subtraction exact before it is scaled
+    stats.stddev = sqrt((double)(squares * count - sum * sum)) / count * fabs(linear.scale);
+    stats.mean = stats.mean * linear.scale + linear.offset;
+    stats.minimum = (linear.scale >= 0 ? minimum : maximum) * linear.scale + linear.offset;
+    stats.maximum = (linear.scale >= 0 ? maximum : minimum) * linear.scale + linear.offset;
+    return stats;
+}
+
+double hwmKernelEwma(const int32_t *raw, const uint64_t *validMask, int slot, size_t n, double alpha, double state) {
+    // Each step depends on the previous one, so this stays scalar; the
+    // select keeps it free of data-dependent branches
+    for (size_t i = 0; i < n; i++) {
+        double valid = (double)((validMask[i] >> slot) & 1);
+        double seeded = isnan(state) ? raw[i] : state;
+        double next = seeded + alpha * (raw[i] - seeded);
+
+        state = valid != 0 ? next : state;
+    }
+    return state;
+}
@@ -0,0 +1,45 @@
+#ifndef HWM_KERNEL_H
+#define HWM_KERNEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hwm_sampler.h"
+
+// Batch conversion and statistics over the sampler's per-sensor columns.
+// Every loop is branch-free over contiguous arrays (validity is a mask
+// select, not a jump) so the compiler can vectorize them at -O3 or with
+// -fvect-cost-model=cheap; callers convert a whole column at once instead
+// of calling hwmScale() per sample.
+
+// unit = raw * scale + offset
+typedef struct {
+    double scale;
+    double offset;
+} HwmLinear;
+
+// Statistics of one column, in the kind's unit; mean, stddev and the
+// extremes are NaN when count is 0
+typedef struct {
+    uint32_t count;
+    double minimum;
+    double maximum;
+    double mean;
+    double stddev;                   // Population standard deviation
+} HwmStats;
+
+HwmLinear hwmKindLinear(HwmKind kind);
+
+// out[i] = raw[i] in the kind's unit
+void hwmKernelConvert(HwmKind kind, const int32_t *raw, double *out, size_t n);
+// out[i] = sum[i] / count[i] in the kind's unit, NaN where count[i] is 0
+void hwmKernelMeans(HwmKind kind, const int64_t *sum, const uint32_t *count, double *out, size_t n);
+
+// Statistics of raw[i] over the entries whose validMask[i] has bit slot set
+// (the HwmRing layout: one mask per sweep, one column per sensor)
+HwmStats hwmKernelStats(HwmKind kind, const int32_t *raw, const uint64_t *validMask, int slot, size_t n);
+// Exponentially weighted mean of the valid entries, oldest first, starting
+// from state (NaN to seed it with the first valid entry); returns the new
+// state in raw units so a wrapped ring can be fed in two calls
+double hwmKernelEwma(const int32_t *raw, const uint64_t *validMask, int slot, size_t n, double alpha, double state);
+
+#endif // HWM_KERNEL_H
@@ -0,0 +1,853 @@
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "hwm_sampler.h"
+#include "hwm_kernel.h"
+#include "events.h"
+#include "hw_actor.h"
+#include "snapshot.h"
+#include "json_writer.h"
+#include "response_pool.h"
+#include "histogram.h"
+#include "metrics.h"
+#include "scheduler.h"
+#include "susi_breaker.h"
+#include "susi_timing.h"
+#include "timeutil.h"
+
+// The valid mask has one bit per slot
+typedef char HwmSlotsFitMask[HWM_SENSOR_SLOTS <= 64 ? 1 : -1];
+
+typedef struct {
+    SusiId_t base;
+    int count;
+    const char *name;                // JSON kind and fallback sensor name
+    const char *unit;
+    const char *metric;
+    const char *help;
+    double rate;                     // Raw units per second that count as a fast change
+    double noise;                    // Standard deviation, in raw units, that counts as noisy
+} HwmKindInfo;
+
+static const HwmKindInfo kinds[HWM_KIND_COUNT] = {
+    [HWM_KIND_TEMPERATURE] = { SUSI_ID_HWM_TEMP_BASE, SUSI_ID_HWM_TEMP_MAX, "temperature", "celsius",
+                               "watchdog_hwm_temperature_celsius", "Board temperature sensors", 5, 5 },
+    [HWM_KIND_VOLTAGE]     = { SUSI_ID_HWM_VOLTAGE_BASE, SUSI_ID_HWM_VOLTAGE_MAX, "voltage", "volts",
+                               "watchdog_hwm_voltage_volts", "Board voltage rails", 50, 20 },
+    [HWM_KIND_FAN]         = { SUSI_ID_HWM_FAN_BASE, SUSI_ID_HWM_FAN_MAX, "fan", "rpm",
+                               "watchdog_hwm_fan_rpm", "Fan speeds", 200, 100 },
+    [HWM_KIND_CURRENT]     = { SUSI_ID_HWM_CURRENT_BASE, SUSI_ID_HWM_CURRENT_MAX, "current", "amperes",
+                               "watchdog_hwm_current_amperes", "Board currents", 100, 50 },
+    [HWM_KIND_CASE_OPEN]   = { SUSI_ID_HWM_CASEOPEN_BASE, SUSI_ID_HWM_CASEOPEN_MAX, "case_open", "",
+                               "watchdog_hwm_case_open", "Chassis intrusion switches, 1 = opened", 1e-3, 0.5 },
+};
+
+static HwmDeadband deadbands[HWM_KIND_COUNT] = {
+    [HWM_KIND_TEMPERATURE] = { 0.5, 0, HWM_DEFAULT_SILENCE_MS },
+    [HWM_KIND_VOLTAGE]     = { 0.05, 0.01, HWM_DEFAULT_SILENCE_MS },
+    [HWM_KIND_FAN]         = { 100, 0.05, HWM_DEFAULT_SILENCE_MS },
+    [HWM_KIND_CURRENT]     = { 0.05, 0.02, HWM_DEFAULT_SILENCE_MS },
+    [HWM_KIND_CASE_OPEN]   = { 0, 0, HWM_DEFAULT_SILENCE_MS },
+};
+
+// Last value each sensor pushed into the event fan-out; sampler task only
+typedef struct {
+    int32_t value;
+    uint64_t publishedMs;            // Monotonic
+    bool published;
+} HwmChangeFilter;
+
+// Per-sensor schedule, only touched by the sampler task (intervalMs is
+// also read by the metrics collector)
+typedef struct {
+    uint32_t intervalMs;
+    uint64_t dueMs;                  // Monotonic time of the next read
+    uint64_t lastReadMs;
+    int32_t lastValue;
+    double mean;                     // Exponentially weighted, alpha 1/8
+    double variance;
+    uint32_t stableReads;
+    bool primed;                     // At least one successful read
+} HwmSchedule;
+
+// Newest value of every sensor, published under a sequence lock
+typedef struct {
+    uint32_t lock;                   // Odd while the sampler is writing
+    HwmReading reading;
+} HwmLatest;
+
+static HwmSensor sensors[HWM_SENSOR_SLOTS];
+static HwmCapabilities caps;         // Written once by discovery, read-only afterwards
+
+// The ring lives in memory unless hwmAttachStore() moved it into a mapped file
+static HwmRingStore localStore;
+static HwmRingStore *store = &localStore;
+
+static Snapshot previousSnapshot;    // Ring contents found in the store at startup
+static bool previousLive = false;
+
+static Snapshot hwmSnapshot;
+static Snapshot hwmCborSnapshot;     // Same sweep in CBOR, rendered once a client asked for it
+static bool cborWanted = false;
+static bool snapshotLive = false;
+static int samplerTask = -1;
+static bool samplerActive = false;
+static uint32_t sampleIntervalMs = 0;
+static uint32_t tickMs = 0;
+static uint32_t minIntervalMs = 0;
+static uint32_t maxIntervalMs = 0;
+static HwmChangeFilter changeFilters[HWM_SENSOR_SLOTS];
+static HwmSchedule schedules[HWM_SENSOR_SLOTS];
+static HwmLatest latest;
+
+// Token bucket for the read budget, refilled per tick, holding at most one second
+static uint32_t readBudget = 0;
+static double budgetTokens = 0;
+static uint64_t budgetRefillMs = 0;
+
+typedef struct {
+    HwmSweepListener listener;
+    void *ctx;
+} HwmListenerEntry;
+
+static HwmListenerEntry listeners[HWM_MAX_LISTENERS];
+static int listenerCount = 0;        // Published with release once the entry is filled
+
+static Histogram sweepLatency;
+static uint64_t sweepsDone = 0;      // By this process; the ring sequence may carry on from a store
+static uint64_t readErrors = 0;
+static uint64_t readsDone = 0;
+static uint64_t readsDeferred = 0;
+static uint64_t changesPublished = 0;
+static uint64_t changesSuppressed = 0;   // Due reads postponed by the budget
+static uint64_t sweepsSkipped = 0;   // Read lane full or snapshot busy
+
+static uint64_t realtimeNowMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000ull + (uint64_t)ts.tv_nsec / 1000000ull;
+}
+
+// EC labels end up in JSON and metric labels; keep them printable and quote-free
+static void sanitizeName(char *name) {
+    for (char *p = name; *p; p++) {
+        if ((unsigned char)*p < 0x20 || *p == '"' || *p == '\\' || (unsigned char)*p >= 0x7f) {
+            *p = '_';
+        }
+    }
+}
+
+// Probe every HWM item once; runs on the hardware thread
+static void hwDiscover(void *arg) {
+    int slot = 0;
+    (void)arg;
+
+    memset(&caps, 0, sizeof(caps));
+    for (int kind = 0; kind < HWM_KIND_COUNT; kind++) {
+        for (int i = 0; i < kinds[kind].count; i++, slot++) {
+            HwmSensor *sensor = &sensors[slot];
+            uint32_t value;
+            uint32_t length = sizeof(sensor->name);
+            uint64_t start;
+            SusiStatus_t status;
+
+            sensor->id = kinds[kind].base + (SusiId_t)i;
+            sensor->kind = (HwmKind)kind;
+            start = monotonicNowNs();
+            status = SusiBoardGetValue(sensor->id, &value);
+            susiTimingRecord(SUSI_CALL_BOARD_GET_VALUE, start, status);
+            if (status != SUSI_STATUS_SUCCESS) {
+                continue;
+            }
+            caps.mask |= 1ull << slot;
+            caps.slots[caps.count++] = (uint8_t)slot;
+
+            start = monotonicNowNs();
+            status = SusiBoardGetStringA(SUSI_ID_MAPPING_GET_NAME_HWM(sensor->id), sensor->name, &length);
+            susiTimingRecord(SUSI_CALL_BOARD_GET_STRING, start, status);
+            if (status != SUSI_STATUS_SUCCESS || sensor->name[0] == '\0') {
+                snprintf(sensor->name, sizeof(sensor->name), "%s%d", kinds[kind].name, i);
+            }
+            sensor->name[sizeof(sensor->name) - 1] = '\0';
+            sanitizeName(sensor->name);
+        }
+    }
+}
+
+// The sensors one sweep reads, most overdue first
+typedef struct {
+    HwmReading *reading;
+    uint8_t slots[HWM_SENSOR_SLOTS];
+    int count;
+} HwmSweepPlan;
+
+// Read the planned sensors; runs on the hardware thread
+static void hwSweep(void *arg) {
+    HwmSweepPlan *plan = (HwmSweepPlan *)arg;
+    HwmReading *reading = plan->reading;
+
+    reading->validMask = 0;
+    for (int i = 0; i < plan->count; i++) {
+        int slot = plan->slots[i];
+        uint32_t value;
+        uint64_t start;
+        SusiStatus_t status;
+
+        // A sensor whose breaker is open keeps its last value in the latest table
+        if (!susiBreakerAllow(SUSI_CALL_BOARD_GET_VALUE, sensors[slot].id)) {
+            continue;
+        }
+        start = monotonicNowNs();
+        status = SusiBoardGetValue(sensors[slot].id, &value);
+        susiTimingRecord(SUSI_CALL_BOARD_GET_VALUE, start, status);
+        susiBreakerRecord(SUSI_CALL_BOARD_GET_VALUE, sensors[slot].id, status, NULL, 0);
+        if (status == SUSI_STATUS_SUCCESS) {
+            // Case open is stored as 0/1 so that averages read as a fraction
+            reading->values[slot] = sensors[slot].kind == HWM_KIND_CASE_OPEN ? value != 0 : (int32_t)value;
+            reading->sampledMs[slot] = reading->timestampMs;
+            reading->validMask |= 1ull << slot;
+        } else {
+            __atomic_fetch_add(&readErrors, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+double hwmScale(HwmKind kind, double raw) {
+    HwmLinear linear = hwmKindLinear(kind);
+
+    return raw * linear.scale + linear.offset;
+}
+
+static void ringAppend(const HwmReading *reading) {
+    HwmRing *ring = &store->ring;
+    uint64_t sequence = store->sweepCount + 1;
+    uint32_t index = (uint32_t)((sequence - 1) & (HWM_HISTORY - 1));
+
+    ring->timestampMs[index] = reading->timestampMs;
+    ring->validMask[index] = reading->validMask;
+    for (int i = 0; i < caps.count; i++) {
+        ring->values[caps.slots[i]][index] = reading->values[caps.slots[i]];
+    }
+    __atomic_store_n(&store->sweepCount, sequence, __ATOMIC_RELEASE);
+}
+
+// Merge a sweep into the newest-value table
+static void latestUpdate(const HwmReading *sweep) {
+    HwmReading *reading = &latest.reading;
+
+    __atomic_store_n(&latest.lock, latest.lock + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    reading->sequence = sweep->sequence;
+    reading->timestampMs = sweep->timestampMs;
+    reading->validMask |= sweep->validMask;
+    for (int i = 0; i < caps.count; i++) {
+        int slot = caps.slots[i];
+
+        if (sweep->validMask & (1ull << slot)) {
+            reading->values[slot] = sweep->values[slot];
+            reading->sampledMs[slot] = sweep->sampledMs[slot];
+        }
+    }
+    __atomic_store_n(&latest.lock, latest.lock + 1, __ATOMIC_RELEASE);
+}
+
+const HwmRingStore* hwmRing(void) {
+    return store;
+}
+
+bool hwmLatest(HwmReading *reading) {
+    for (;;) {
+        uint32_t lock = __atomic_load_n(&latest.lock, __ATOMIC_ACQUIRE);
+
+        if (lock & 1) {
+            continue;
+        }
+        memcpy(reading, &latest.reading, sizeof(*reading));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&latest.lock, __ATOMIC_RELAXED) == lock) {
+            return reading->sequence > 0;
+        }
+    }
+}
+
+// Statistics of one sensor over the sweeps in the ring, oldest first for
+// the EWMA; sampler task only
+static void writeWindow(JsonWriter *writer, int slot) {
+    const HwmRing *ring = &store->ring;
+    uint64_t sweeps = store->sweepCount < HWM_HISTORY ? store->sweepCount : HWM_HISTORY;
+    uint32_t oldest = store->sweepCount < HWM_HISTORY ? 0 : (uint32_t)(store->sweepCount & (HWM_HISTORY - 1));
+    HwmKind kind = sensors[slot].kind;
+    HwmStats stats = hwmKernelStats(kind, ring->values[slot], ring->validMask, slot, sweeps);
+    double ewma = hwmKernelEwma(ring->values[slot] + oldest, ring->validMask + oldest, slot, sweeps - oldest,
+                                HWM_EWMA_ALPHA, NAN);
+
+    ewma = hwmKernelEwma(ring->values[slot], ring->validMask, slot, oldest, HWM_EWMA_ALPHA, ewma);
+
+    jsonKey(writer, "window");
+    jsonBeginObject(writer);
+    jsonFieldUint(writer, "count", stats.count);
+    jsonFieldDouble(writer, "min", stats.minimum, 3);
+    jsonFieldDouble(writer, "max", stats.maximum, 3);
+    jsonFieldDouble(writer, "mean", stats.mean, 3);
+    jsonFieldDouble(writer, "stddev", stats.stddev, 3);
+    jsonFieldDouble(writer, "ewma", hwmScale(kind, ewma), 3);
+    jsonEndObject(writer);
+}
+
+static void renderReading(StrBuf *out, const HwmReading *reading, bool cbor) {
+    JsonWriter writer;
+
+    if (cbor) {
+        jsonWriterInitCbor(&writer, out);
+    } else {
+        jsonWriterInit(&writer, out);
+    }
+    jsonBeginObject(&writer);
+    jsonFieldUint(&writer, "timestamp_ms", reading->timestampMs);
+    jsonFieldUint(&writer, "sequence", reading->sequence);
+    jsonFieldUint(&writer, "interval_ms", sampleIntervalMs);
+    jsonFieldUint(&writer, "budget", readBudget);
+    jsonKey(&writer, "sensors");
+    jsonBeginArray(&writer);
+    for (int i = 0; i < caps.count; i++) {
+        int slot = caps.slots[i];
+        const HwmSensor *sensor = &sensors[slot];
+
+        jsonBeginObject(&writer);
+        jsonFieldUint(&writer, "id", sensor->id);
+        jsonFieldString(&writer, "name", sensor->name);
+        jsonFieldString(&writer, "kind", kinds[sensor->kind].name);
+        jsonFieldString(&writer, "unit", kinds[sensor->kind].unit);
+        if (reading->validMask & (1ull << slot)) {
+            jsonFieldDouble(&writer, "value", hwmScale(sensor->kind, reading->values[slot]), 3);
+            jsonFieldInt(&writer, "raw", reading->values[slot]);
+            jsonFieldUint(&writer, "sampled_ms", reading->sampledMs[slot]);
+            if (susiBreakerIsOpen(SUSI_CALL_BOARD_GET_VALUE, sensor->id)) {
+                jsonFieldBool(&writer, "stale", true);
+            }
+        } else {
+            jsonKey(&writer, "value");
+            jsonNull(&writer);
+        }
+        jsonFieldUint(&writer, "interval_ms", schedules[slot].intervalMs);
+        writeWindow(&writer, slot);
+        jsonEndObject(&writer);
+    }
+    jsonEndArray(&writer);
+    jsonEndObject(&writer);
+    if (!cbor) {
+        strbufAppendChar(out, '\n');
+    }
+}
+
+static void publishSnapshot(Snapshot *snapshot, const HwmReading *reading, bool cbor) {
+    StrBuf out;
+    size_t capacity;
+    char *data = snapshotBegin(snapshot, &capacity);
+
+    if (data == NULL) {
+        __atomic_fetch_add(&sweepsSkipped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    for (;;) {
+        strbufInit(&out, data, capacity);
+        renderReading(&out, reading, cbor);
+        if (!out.overflow) {
+            break;
+        }
+        if (!snapshotGrow(snapshot, capacity * 2)) {
+            snapshotAbort(snapshot);
+            return;
+        }
+        data = snapshotBegin(snapshot, &capacity);
+        if (data == NULL) {
+            return;
+        }
+    }
+    snapshotPublish(snapshot, out.length);
+}
+
+static void publishReading(const HwmReading *reading) {
+    publishSnapshot(&hwmSnapshot, reading, false);
+    if (__atomic_load_n(&cborWanted, __ATOMIC_RELAXED)) {
+        publishSnapshot(&hwmCborSnapshot, reading, true);
+    }
+}
+
+// Pick the due sensors, most overdue first, as far as the budget allows
+static void planSweep(HwmSweepPlan *plan, uint64_t nowMs) {
+    int due = 0;
+
+    for (int i = 0; i < caps.count; i++) {
+        int slot = caps.slots[i];
+        int at = due++;
+
+        // Anything due within half a tick is read now rather than a tick late
+        if (schedules[slot].dueMs > nowMs + tickMs / 2) {
+            due--;
+            continue;
+        }
+        while (at > 0 && schedules[plan->slots[at - 1]].dueMs > schedules[slot].dueMs) {
+            plan->slots[at] = plan->slots[at - 1];
+            at--;
+        }
+        plan->slots[at] = (uint8_t)slot;
+    }
+    plan->count = due;
+
+    if (readBudget > 0) {
+        budgetTokens += (double)readBudget * (double)(nowMs - budgetRefillMs) / 1000.0;
+        if (budgetTokens > readBudget) {
+            budgetTokens = readBudget;
+        }
+        budgetRefillMs = nowMs;
+        if (plan->count > (int)budgetTokens) {
+            __atomic_fetch_add(&readsDeferred, (uint64_t)(plan->count - (int)budgetTokens), __ATOMIC_RELAXED);
+            plan->count = (int)budgetTokens;
+        }
+        budgetTokens -= plan->count;
+    }
+}
+
+// Adapt a sensor's interval to how its value behaves. A fast change snaps
+// to the fastest interval, noise halves it, and a run of stable readings
+// doubles it.
+static void reschedule(int slot, bool ok, int32_t value, uint64_t nowMs) {
+    HwmSchedule *schedule = &schedules[slot];
+    const HwmKindInfo *kind = &kinds[sensors[slot].kind];
+    uint32_t interval = schedule->intervalMs;
+
+    if (ok && schedule->primed) {
+        double seconds = (double)(nowMs - schedule->lastReadMs) / 1000.0;
+        double change = fabs((double)value - schedule->lastValue);
+        double rate = change / (seconds > 0 ? seconds : tickMs / 1000.0);
+        double deviation = value - schedule->mean;
+
+        schedule->mean += deviation / 8;
+        schedule->variance += (deviation * deviation - schedule->variance) / 8;
+        // A step within the noise floor is not movement, however short dt was
+        if (change > kind->noise && rate >= kind->rate) {
+            interval = minIntervalMs;
+            schedule->stableReads = 0;
+        } else if (schedule->variance >= kind->noise * kind->noise) {
+            interval = interval / 2 > minIntervalMs ? interval / 2 : minIntervalMs;
+            schedule->stableReads = 0;
+        } else if (++schedule->stableReads >= HWM_STABLE_READS) {
+            interval = interval * 2 < maxIntervalMs ? interval * 2 : maxIntervalMs;
+            schedule->stableReads = 0;
+        }
+    } else if (ok) {
+        schedule->mean = value;
+        schedule->variance = 0;
+        schedule->primed = true;
+    }
+    if (ok) {
+        schedule->lastValue = value;
+        schedule->lastReadMs = nowMs;
+    }
+    __atomic_store_n(&schedule->intervalMs, interval, __ATOMIC_RELAXED);
+    schedule->dueMs = nowMs + interval;
+}
+
+// Push a successful read into the event fan-out unless it is inside the
+// sensor's deadband
+static void filterChange(int slot, int32_t value, uint64_t nowMs) {
+    HwmChangeFilter *filter = &changeFilters[slot];
+    HwmKind kind = sensors[slot].kind;
+    const HwmDeadband *deadband = &deadbands[kind];
+    HwmChangeReason reason;
+    uint32_t silentMs = 0;
+
+    if (!filter->published) {
+        reason = HWM_CHANGE_FIRST;
+    } else {
+        double last = hwmScale(kind, filter->value);
+        double threshold = deadband->relative * fabs(last);
+
+        if (threshold < deadband->absolute) {
+            threshold = deadband->absolute;
+        }
+        silentMs = (uint32_t)(nowMs - filter->publishedMs);
+        if (value != filter->value && fabs(hwmScale(kind, value) - last) > threshold) {
+            reason = HWM_CHANGE_MOVED;
+        } else if (deadband->maxSilenceMs > 0 && silentMs >= deadband->maxSilenceMs) {
+            reason = HWM_CHANGE_REFRESH;
+        } else {
+            __atomic_fetch_add(&changesSuppressed, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+    filter->value = value;
+    filter->publishedMs = nowMs;
+    filter->published = true;
+    __atomic_fetch_add(&changesPublished, 1, __ATOMIC_RELAXED);
+    eventPublish(EVENT_HWM, EVENT_NO_WATCHDOG, (uint32_t)slot, (uint32_t)value, silentMs, reason);
+}
+
+static void sampleOnce(void) {
+    HwmReading reading;
+    HwmSweepPlan plan;
+    uint64_t start = monotonicNowNs();
+    uint64_t nowMs = start / 1000000ull;
+    int count;
+
+    memset(&reading, 0, sizeof(reading));
+    plan.reading = &reading;
+    planSweep(&plan, nowMs);
+    if (plan.count == 0) {
+        return;
+    }
+    reading.timestampMs = realtimeNowMs();
+    if (!hwActorCallWithin(HW_LANE_READ, HWM_SWEEP_DEADLINE_MS * 1000000ull, hwSweep, &plan)) {
+        __atomic_fetch_add(&sweepsSkipped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    histogramRecord(&sweepLatency, monotonicNowNs() - start);
+    __atomic_fetch_add(&readsDone, (uint64_t)plan.count, __ATOMIC_RELAXED);
+    for (int i = 0; i < plan.count; i++) {
+        int slot = plan.slots[i];
+        bool ok = (reading.validMask & (1ull << slot)) != 0;
+
+        reschedule(slot, ok, ok ? reading.values[slot] : 0, nowMs);
+        if (ok) {
+            filterChange(slot, reading.values[slot], nowMs);
+        }
+    }
+
+    ringAppend(&reading);
+    __atomic_fetch_add(&sweepsDone, 1, __ATOMIC_RELAXED);
+    reading.sequence = store->sweepCount;
+    latestUpdate(&reading);
+    publishReading(&latest.reading);
+
+    count = __atomic_load_n(&listenerCount, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < count; i++) {
+        listeners[i].listener(&reading, listeners[i].ctx);
+    }
+}
+
+static void samplerTick(void *arg) {
+    (void)arg;
+    sampleOnce();
+}
+
+bool hwmInit(void) {
+    if (!hwActorCall(HW_LANE_READ, hwDiscover, NULL)) {
+        return false;
+    }
+    if (caps.count == 0) {
+        printf("No hardware monitor sensors reported by the EC\n");
+        return false;
+    }
+    return true;
+}
+
+// Every restored sweep, oldest first, as one column per sensor
+static void renderPrevious(StrBuf *out) {
+    const HwmRing *ring = &store->ring;
+    uint64_t last = store->sweepCount;
+    uint64_t first = last > HWM_HISTORY ? last - HWM_HISTORY + 1 : 1;
+    static double column[HWM_HISTORY];   // Only rendered from hwmAttachStore()
+    JsonWriter writer;
+
+    jsonWriterInit(&writer, out);
+    jsonBeginObject(&writer);
+    jsonFieldUint(&writer, "first_sequence", first);
+    jsonFieldUint(&writer, "sweeps", last - first + 1);
+    jsonKey(&writer, "timestamp_ms");
+    jsonBeginArray(&writer);
+    for (uint64_t n = first; n <= last; n++) {
+        jsonUint(&writer, ring->timestampMs[(n - 1) & (HWM_HISTORY - 1)]);
+    }
+    jsonEndArray(&writer);
+    jsonKey(&writer, "sensors");
+    jsonBeginArray(&writer);
+    for (int i = 0; i < caps.count; i++) {
+        int slot = caps.slots[i];
+        const HwmSensor *sensor = &sensors[slot];
+
+        jsonBeginObject(&writer);
+        jsonFieldUint(&writer, "id", sensor->id);
+        jsonFieldString(&writer, "name", sensor->name);
+        jsonFieldString(&writer, "kind", kinds[sensor->kind].name);
+        jsonFieldString(&writer, "unit", kinds[sensor->kind].unit);
+        hwmKernelConvert(sensor->kind, ring->values[slot], column, last - first + 1);
+        jsonKey(&writer, "values");
+        jsonBeginArray(&writer);
+        for (uint64_t n = first; n <= last; n++) {
+            uint32_t index = (uint32_t)((n - 1) & (HWM_HISTORY - 1));
+
+            if (ring->validMask[index] & (1ull << slot)) {
+                jsonDouble(&writer, column[index], 3);
+            } else {
+                jsonNull(&writer);
+            }
+        }
+        jsonEndArray(&writer);
+        jsonEndObject(&writer);
+    }
+    jsonEndArray(&writer);
+    jsonEndObject(&writer);
+    strbufAppendChar(out, '\n');
+}
+
+static bool publishPrevious(void) {
+    StrBuf out;
+    size_t capacity;
+    char *data;
+
+    if (!snapshotInit(&previousSnapshot, HWM_SNAPSHOT_CAPACITY * 4, "application/json", "hwm-previous")) {
+        return false;
+    }
+    data = snapshotBegin(&previousSnapshot, &capacity);
+    while (data != NULL) {
+        strbufInit(&out, data, capacity);
+        renderPrevious(&out);
+        if (!out.overflow) {
+            snapshotPublish(&previousSnapshot, out.length);
+            return true;
+        }
+        if (!snapshotGrow(&previousSnapshot, capacity * 2)) {
+            snapshotAbort(&previousSnapshot);
+            break;
+        }
+        data = snapshotBegin(&previousSnapshot, &capacity);
+    }
+    snapshotDestroy(&previousSnapshot);
+    return false;
+}
+
+void hwmAttachStore(HwmRingStore *ringStore, bool restored) {
+    store = ringStore;
+    if (!restored) {
+        return;
+    }
+    if (store->sweepCount > 0 && publishPrevious()) {
+        previousLive = true;
+    }
+}
+
+bool hwmStart(uint32_t intervalMs, uint32_t budget) {
+    uint64_t nowMs;
+
+    if (samplerActive || intervalMs == 0 || caps.count == 0) {
+        return false;
+    }
+    if (!snapshotInit(&hwmSnapshot, HWM_SNAPSHOT_CAPACITY, "application/json", "hwm")) {
+        return false;
+    }
+
+    // Tick fast enough for the fastest interval a sensor can adapt to
+    tickMs = intervalMs / HWM_SPEEDUP > HWM_MIN_TICK_MS ? intervalMs / HWM_SPEEDUP : HWM_MIN_TICK_MS;
+    if (tickMs > intervalMs) {
+        tickMs = intervalMs;
+    }
+    minIntervalMs = tickMs;
+    maxIntervalMs = intervalMs * HWM_BACKOFF;
+    sampleIntervalMs = intervalMs;
+    nowMs = monotonicNowNs() / 1000000ull;
+    memset(changeFilters, 0, sizeof(changeFilters));
+    for (int i = 0; i < caps.count; i++) {
+        memset(&schedules[caps.slots[i]], 0, sizeof(schedules[0]));
+        schedules[caps.slots[i]].intervalMs = intervalMs;
+        schedules[caps.slots[i]].dueMs = nowMs;
+    }
+    readBudget = budget;
+    budgetTokens = budget;
+    budgetRefillMs = nowMs;
+    if (!snapshotInit(&hwmCborSnapshot, HWM_SNAPSHOT_CAPACITY, "application/cbor", "hwm-cbor")) {
+        snapshotDestroy(&hwmSnapshot);
+        return false;
+    }
+
+    // Sample once synchronously so /api/hwm has data as soon as HTTP is up
+    sampleOnce();
+
+    samplerTask = schedulerAdd("hwm", SCHEDULER_PRIORITY_NORMAL, tickMs, tickMs, samplerTick, NULL);
+    if (samplerTask < 0) {
+        snapshotDestroy(&hwmSnapshot);
+        snapshotDestroy(&hwmCborSnapshot);
+        return false;
+    }
+    samplerActive = true;
+    snapshotLive = true;
+    if (budget > 0) {
+        printf("Hardware monitor sampling %d sensor(s) every %u-%u ms, at most %u reads/s\n",
+               caps.count, minIntervalMs, maxIntervalMs, budget);
+    } else {
+        printf("Hardware monitor sampling %d sensor(s) every %u-%u ms\n", caps.count, minIntervalMs, maxIntervalMs);
+    }
+    return true;
+}
+
+void hwmStop(void) {
+    if (!samplerActive) {
+        return;
+    }
+    schedulerRemove(samplerTask);
+    samplerTask = -1;
+    samplerActive = false;
+}
+
+void hwmDestroy(void) {
+    if (snapshotLive) {
+        snapshotLive = false;
+        snapshotDestroy(&hwmSnapshot);
+        snapshotDestroy(&hwmCborSnapshot);
+    }
+    if (previousLive) {
+        previousLive = false;
+        snapshotDestroy(&previousSnapshot);
+    }
+}
+
+void hwmSetDeadband(HwmKind kind, const HwmDeadband *deadband) {
+    if (kind < HWM_KIND_COUNT) {
+        deadbands[kind] = *deadband;
+    }
+}
+
+bool hwmKindFromName(const char *name, HwmKind *kind) {
+    for (int i = 0; i < HWM_KIND_COUNT; i++) {
+        if (strcmp(name, kinds[i].name) == 0) {
+            *kind = (HwmKind)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+int hwmSlot(HwmKind kind, int index) {
+    int slot = 0;
+
+    if (kind >= HWM_KIND_COUNT || index < 0 || index >= kinds[kind].count) {
+        return -1;
+    }
+    for (int i = 0; i < (int)kind; i++) {
+        slot += kinds[i].count;
+    }
+    return slot + index;
+}
+
+const HwmSensor* hwmSensor(int slot) {
+    if (slot < 0 || slot >= HWM_SENSOR_SLOTS) {
+        return NULL;
+    }
+    return &sensors[slot];
+}
+
+const HwmCapabilities* hwmCapabilities(void) {
+    return &caps;
+}
+
+const char* hwmKindName(HwmKind kind) {
+    return kind < HWM_KIND_COUNT ? kinds[kind].name : "unknown";
+}
+
+const char* hwmKindUnit(HwmKind kind) {
+    return kind < HWM_KIND_COUNT ? kinds[kind].unit : "";
+}
+
+bool hwmAddListener(HwmSweepListener listener, void *ctx) {
+    static pthread_mutex_t listenerLock = PTHREAD_MUTEX_INITIALIZER;
+    bool added = false;
+
+    pthread_mutex_lock(&listenerLock);
+    if (listenerCount < HWM_MAX_LISTENERS) {
+        listeners[listenerCount].listener = listener;
+        listeners[listenerCount].ctx = ctx;
+        __atomic_store_n(&listenerCount, listenerCount + 1, __ATOMIC_RELEASE);
+        added = true;
+    }
+    pthread_mutex_unlock(&listenerLock);
+    return added;
+}
+
+enum MHD_Result hwmQueueResponse(struct MHD_Connection *connection) {
+    if (!snapshotLive) {
+        return MHD_NO;
+    }
+    // The first CBOR request turns the CBOR rendering on; until the next
+    // sweep has produced it, the client gets JSON
+    if (responseWantsCbor(connection)) {
+        __atomic_store_n(&cborWanted, true, __ATOMIC_RELAXED);
+        if (snapshotQueue(&hwmCborSnapshot, connection) == MHD_YES) {
+            return MHD_YES;
+        }
+    }
+    return snapshotQueue(&hwmSnapshot, connection);
+}
+
+enum MHD_Result hwmQueuePrevious(struct MHD_Connection *connection) {
+    if (!previousLive) {
+        return MHD_NO;
+    }
+    return snapshotQueue(&previousSnapshot, connection);
+}
+
+void hwmCollectMetrics(StrBuf *out, void *ctx) {
+    HwmReading reading;
+    HwmKind lastKind = HWM_KIND_COUNT;
+    (void)ctx;
+
+    metricsHeader(out, "watchdog_hwm_sweeps_total", "counter", "Hardware monitor sweeps completed");
+    strbufAppendf(out, "watchdog_hwm_sweeps_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&sweepsDone, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_hwm_sweeps_skipped_total", "counter",
+                  "Sweeps dropped because the read lane or the snapshot buffers were busy");
+    strbufAppendf(out, "watchdog_hwm_sweeps_skipped_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&sweepsSkipped, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_hwm_read_errors_total", "counter", "Sensor reads that failed during a sweep");
+    strbufAppendf(out, "watchdog_hwm_read_errors_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&readErrors, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_hwm_sweep_seconds", "summary", "Time to read the sensors due in one sweep");
+    histogramWriteSummary(out, "watchdog_hwm_sweep_seconds", NULL, &sweepLatency);
+
+    metricsHeader(out, "watchdog_hwm_reads_total", "counter", "Sensor reads issued by the hardware monitor");
+    strbufAppendf(out, "watchdog_hwm_reads_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&readsDone, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_hwm_reads_deferred_total", "counter", "Due sensor reads postponed by the read budget");
+    strbufAppendf(out, "watchdog_hwm_reads_deferred_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&readsDeferred, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_hwm_read_budget", "gauge", "Sensor reads per second the monitor may issue, 0 for unlimited");
+    strbufAppendf(out, "watchdog_hwm_read_budget %u\n", readBudget);
+
+    metricsHeader(out, "watchdog_hwm_changes_published_total", "counter", "Sensor readings pushed to the event stream");
+    strbufAppendf(out, "watchdog_hwm_changes_published_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&changesPublished, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_hwm_changes_suppressed_total", "counter", "Sensor readings dropped inside their deadband");
+    strbufAppendf(out, "watchdog_hwm_changes_suppressed_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&changesSuppressed, __ATOMIC_RELAXED));
+
+    metricsHeader(out, "watchdog_hwm_sensors", "gauge", "Hardware monitor sensors found at discovery");
+    strbufAppendf(out, "watchdog_hwm_sensors %d\n", caps.count);
+    metricsHeader(out, "watchdog_hwm_sensor_interval_seconds", "gauge", "Current adaptive sampling interval of each sensor");
+    for (int i = 0; i < caps.count; i++) {
+        int slot = caps.slots[i];
+
+        strbufAppendf(out, "watchdog_hwm_sensor_interval_seconds{kind=\"%s\",sensor=\"%s\"} %.3f\n",
+                      kinds[sensors[slot].kind].name, sensors[slot].name,
+                      __atomic_load_n(&schedules[slot].intervalMs, __ATOMIC_RELAXED) / 1000.0);
+    }
+
+    if (!hwmLatest(&reading)) {
+        return;
+    }
+    // Slots are grouped by kind, so each family's header is written once
+    for (int i = 0; i < caps.count; i++) {
+        int slot = caps.slots[i];
+        HwmKind kind = sensors[slot].kind;
+
+        if (!(reading.validMask & (1ull << slot))) {
+            continue;
+        }
+        if (kind != lastKind) {
+            metricsHeader(out, kinds[kind].metric, "gauge", kinds[kind].help);
+            lastKind = kind;
+        }
+        strbufAppendf(out, "%s{sensor=\"%s\"} %.3f\n", kinds[kind].metric, sensors[slot].name,
+                      hwmScale(kind, reading.values[slot]));
+    }
+}
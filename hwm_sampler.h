@@ -0,0 +1,149 @@
+#ifndef HWM_SAMPLER_H
+#define HWM_SAMPLER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <microhttpd.h>
+#include "Susi4.h"
+#include "strbuf.h"
+
+#define HWM_HISTORY 256                  // Sweeps kept per sensor, must be a power of two
+#define HWM_NAME_MAX 32
+#define HWM_DEFAULT_INTERVAL_MS 1000
+#define HWM_DEFAULT_BUDGET 50            // SUSI reads per second, 0 = unlimited
+#define HWM_SPEEDUP 4                    // Fastest interval is the base interval divided by this
+#define HWM_BACKOFF 16                   // Slowest interval is the base interval times this
+#define HWM_MIN_TICK_MS 50
+#define HWM_SWEEP_DEADLINE_MS 10         // A sweep overtakes queued user bus traffic after this wait
+#define HWM_STABLE_READS 4               // Stable readings in a row before the interval doubles
+#define HWM_SNAPSHOT_CAPACITY 8192
+#define HWM_MAX_LISTENERS 8
+#define HWM_EWMA_ALPHA 0.125             // Weight of the newest sweep in /api/hwm's window EWMA
+#define HWM_DEFAULT_SILENCE_MS 60000     // Longest a sensor stays off the event stream
+
+// Every SUSI_ID_HWM_* item has a fixed slot, kind by kind in this order
+typedef enum {
+    HWM_KIND_TEMPERATURE,            // 0.1 Kelvin
+    HWM_KIND_VOLTAGE,                // Millivolts
+    HWM_KIND_FAN,                    // RPM
+    HWM_KIND_CURRENT,                // Milliamperes
+    HWM_KIND_CASE_OPEN,              // 0 = closed, 1 = opened
+    HWM_KIND_COUNT
+} HwmKind;
+
+#define HWM_SENSOR_SLOTS (SUSI_ID_HWM_TEMP_MAX + SUSI_ID_HWM_VOLTAGE_MAX + SUSI_ID_HWM_FAN_MAX + \
+                          SUSI_ID_HWM_CURRENT_MAX + SUSI_ID_HWM_CASEOPEN_MAX)
+
+typedef struct {
+    SusiId_t id;
+    HwmKind kind;
+    char name[HWM_NAME_MAX];         // Label reported by the EC
+} HwmSensor;
+
+// Sensors that answered SusiBoardGetValue at discovery. Built once; sweeps
+// walk the compact list so unsupported IDs, whose failed driver calls are
+// the slowest, are never read again.
+typedef struct {
+    uint64_t mask;                   // Bit per supported slot
+    uint8_t slots[HWM_SENSOR_SLOTS]; // Supported slots in ascending order
+    int count;
+} HwmCapabilities;
+
+// Sample history as a structure of arrays: the raw values of one sensor
+// are contiguous, so scanning a sensor's history touches one cache line per
+// 16 sweeps instead of one per sweep. The sampler task is the only writer;
+// sweep n lives at index n % HWM_HISTORY and is published by bumping the
+// sweep counter.
+typedef struct {
+    uint64_t timestampMs[HWM_HISTORY];           // Wall clock of each sweep
+    uint64_t validMask[HWM_HISTORY];             // Bit per slot read successfully
+    int32_t values[HWM_SENSOR_SLOTS][HWM_HISTORY];
+} HwmRing;
+
+// The ring and its publication counter, as kept in memory or in a store.
+// The layout is part of the store file format.
+typedef struct {
+    uint64_t sweepCount;             // Sweeps published; the newest is at (sweepCount - 1) % HWM_HISTORY
+    uint64_t reserved[7];
+    HwmRing ring;
+} HwmRingStore;
+
+// One sweep, or the newest value of every sensor (hwmLatest). A sweep only
+// reads the sensors that are due, so validMask is a subset of the
+// capability mask.
+typedef struct {
+    uint64_t sequence;               // Sweep number, starting at 1
+    uint64_t timestampMs;
+    uint64_t validMask;
+    int32_t values[HWM_SENSOR_SLOTS];
+    uint64_t sampledMs[HWM_SENSOR_SLOTS]; // Wall clock of each value
+} HwmReading;
+
+// Change filter in front of the event fan-out (EVENT_HWM). A reading is
+// published when it moved by more than max(absolute, relative * |last
+// published|), in the sensor's unit, or when the sensor has been silent for
+// maxSilenceMs (0 = never); identical readings are never pushed.
+typedef struct {
+    double absolute;
+    double relative;
+    uint32_t maxSilenceMs;
+} HwmDeadband;
+
+// Why an EVENT_HWM was published
+typedef enum {
+    HWM_CHANGE_FIRST,                // First successful read
+    HWM_CHANGE_MOVED,                // Left the deadband
+    HWM_CHANGE_REFRESH               // Unchanged, but silent for maxSilenceMs
+} HwmChangeReason;
+
+// Called on the sampler task after every sweep, once the ring holds it
+typedef void (*HwmSweepListener)(const HwmReading *reading, void *ctx);
+
+// Discover the sensors through the hardware thread; false if there are
+// none. Must be called after hwActorStart() and before anything else here.
+bool hwmInit(void);
+// Keep the ring in caller-provided memory (a mapped file) instead. With
+// restored set, the sweeps already in it are published once as the
+// previous-run window and sampling carries on behind them.
+void hwmAttachStore(HwmRingStore *ringStore, bool restored);
+// Every sensor starts at intervalMs and adapts between intervalMs /
+// HWM_SPEEDUP and intervalMs * HWM_BACKOFF: it is read faster while its
+// value moves quickly or is noisy, and backs off while it is stable. At
+// most budget reads per second are issued; sensors that are most overdue
+// go first.
+bool hwmStart(uint32_t intervalMs, uint32_t budget);
+void hwmStop(void);
+// Replace a kind's deadband; before hwmStart()
+void hwmSetDeadband(HwmKind kind, const HwmDeadband *deadband);
+bool hwmKindFromName(const char *name, HwmKind *kind);
+// Release the snapshot once no response can reference it (after MHD stopped)
+void hwmDestroy(void);
+
+const HwmSensor* hwmSensor(int slot);
+// Slot of the index-th item of a kind (temperature1 is SUSI_ID_HWM_TEMP_BASE
+// + 1); -1 past the kind's last ID
+int hwmSlot(HwmKind kind, int index);
+const HwmCapabilities* hwmCapabilities(void);
+const char* hwmKindName(HwmKind kind);
+const char* hwmKindUnit(HwmKind kind);
+
+// Listeners may be added while sampling runs and are never removed
+bool hwmAddListener(HwmSweepListener listener, void *ctx);
+// Copy the newest value of every sensor; false before the first sweep
+bool hwmLatest(HwmReading *reading);
+// The sample ring, for sweep listeners: it only changes between their calls
+const HwmRingStore* hwmRing(void);
+
+// Convert a raw reading, or an average of them, to its unit (Celsius,
+// volts, RPM, amperes, 0/1). The conversion is linear for every kind.
+double hwmScale(HwmKind kind, double raw);
+
+// Serve GET /api/hwm from the snapshot rendered after every sweep; a CBOR
+// twin is rendered as well once a client has asked for CBOR
+enum MHD_Result hwmQueueResponse(struct MHD_Connection *connection);
+// Serve GET /api/hwm/previous, the raw sweeps restored from the store
+enum MHD_Result hwmQueuePrevious(struct MHD_Connection *connection);
+
+void hwmCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // HWM_SAMPLER_H
@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "hwm_store.h"
+#include "histogram.h"
+#include "metrics.h"
+#include "timeutil.h"
+
+typedef char HwmStoreHeaderFits[sizeof(HwmStoreHeader) <= HWM_STORE_HEADER_BYTES ? 1 : -1];
+
+static pthread_mutex_t storeLock = PTHREAD_MUTEX_INITIALIZER;
+static HwmStoreHeader *header = NULL;  // Start of the mapping
+static size_t mappedBytes = 0;
+static int storeFd = -1;
+static bool restoredRun = false;
+static bool previousClean = false;
+static Histogram syncLatency;
+static uint64_t syncErrors = 0;
+
+static size_t pageAlign(size_t bytes) {
+    return (bytes + HWM_STORE_HEADER_BYTES - 1) & ~(size_t)(HWM_STORE_HEADER_BYTES - 1);
+}
+
+static uint64_t realtimeNowMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000ull + (uint64_t)ts.tv_nsec / 1000000ull;
+}
+
+// True if the file was written by this layout for these sensors
+static bool headerMatches(const HwmStoreHeader *existing, const HwmStoreHeader *expected, off_t fileBytes) {
+    if (existing->magic != expected->magic || existing->version != expected->version ||
+        existing->sensorMask != expected->sensorMask || existing->regionCount != expected->regionCount ||
+        existing->fileBytes != expected->fileBytes || (uint64_t)fileBytes != expected->fileBytes) {
+        return false;
+    }
+    for (uint32_t i = 0; i < expected->regionCount; i++) {
+        if (existing->regionBytes[i] != expected->regionBytes[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool hwmStoreOpen(const char *path, uint64_t sensorMask, HwmStoreRegion *regions, int count, bool *restored) {
+    HwmStoreHeader expected;
+    HwmStoreHeader existing;
+    struct stat st;
+    size_t offset = HWM_STORE_HEADER_BYTES;
+    void *map;
+    int fd;
+    int err;
+
+    *restored = false;
+    if (header != NULL || count <= 0 || count > HWM_STORE_MAX_REGIONS) {
+        return false;
+    }
+    memset(&expected, 0, sizeof(expected));
+    expected.magic = HWM_STORE_MAGIC;
+    expected.version = HWM_STORE_VERSION;
+    expected.regionCount = (uint32_t)count;
+    expected.sensorMask = sensorMask;
+    for (int i = 0; i < count; i++) {
+        expected.regionBytes[i] = regions[i].bytes;
+        offset += pageAlign(regions[i].bytes);
+    }
+    expected.fileBytes = offset;
+
+    fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror("hwm store: open");
+        if (fd >= 0) {
+            close(fd);
+        }
+        return false;
+    }
+    memset(&existing, 0, sizeof(existing));
+    if (st.st_size >= HWM_STORE_HEADER_BYTES &&
+        pread(fd, &existing, sizeof(existing), 0) == (ssize_t)sizeof(existing) &&
+        headerMatches(&existing, &expected, st.st_size)) {
+        *restored = true;
+    } else {
+        // Start over: truncating first zeroes every region
+        printf("HWM store %s: %s, starting a new history\n", path,
+               st.st_size == 0 ? "new file" : "layout or sensors changed");
+        if (ftruncate(fd, 0) != 0 || ftruncate(fd, (off_t)expected.fileBytes) != 0) {
+            perror("hwm store: ftruncate");
+            close(fd);
+            return false;
+        }
+    }
+    // Reserve the blocks now; a full disk must not turn into SIGBUS on a store
+    err = posix_fallocate(fd, 0, (off_t)expected.fileBytes);
+    if (err != 0) {
+        fprintf(stderr, "hwm store: posix_fallocate: %s\n", strerror(err));
+        close(fd);
+        return false;
+    }
+
+    map = mmap(NULL, expected.fileBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        perror("hwm store: mmap");
+        close(fd);
+        return false;
+    }
+
+    pthread_mutex_lock(&storeLock);
+    header = map;
+    mappedBytes = expected.fileBytes;
+    storeFd = fd;
+    restoredRun = *restored;
+    previousClean = *restored && header->clean != 0;
+    if (!*restored) {
+        *header = expected;
+    }
+    header->opens++;
+    header->clean = 0;
+    pthread_mutex_unlock(&storeLock);
+
+    offset = HWM_STORE_HEADER_BYTES;
+    for (int i = 0; i < count; i++) {
+        regions[i].base = (char *)map + offset;
+        offset += pageAlign(regions[i].bytes);
+    }
+    if (*restored) {
+        printf("HWM store %s: resumed history from run %llu (%s shutdown)\n", path,
+               (unsigned long long)(header->opens - 1), previousClean ? "clean" : "unclean");
+    }
+    return true;
+}
+
+void hwmStoreSync(void) {
+    uint64_t start = monotonicNowNs();
+
+    pthread_mutex_lock(&storeLock);
+    if (header == NULL) {
+        pthread_mutex_unlock(&storeLock);
+        return;
+    }
+    header->lastSyncMs = realtimeNowMs();
+    header->syncs++;
+    if (msync(header, mappedBytes, MS_SYNC) != 0) {
+        __atomic_fetch_add(&syncErrors, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&storeLock);
+    histogramRecord(&syncLatency, monotonicNowNs() - start);
+}
+
+void hwmStoreClose(void) {
+    pthread_mutex_lock(&storeLock);
+    if (header == NULL) {
+        pthread_mutex_unlock(&storeLock);
+        return;
+    }
+    header->clean = 1;
+    header->lastSyncMs = realtimeNowMs();
+    header->syncs++;
+    if (msync(header, mappedBytes, MS_SYNC) != 0) {
+        perror("hwm store: msync");
+    }
+    munmap(header, mappedBytes);
+    close(storeFd);
+    header = NULL;
+    mappedBytes = 0;
+    storeFd = -1;
+    pthread_mutex_unlock(&storeLock);
+}
+
+void hwmStoreCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (__atomic_load_n(&mappedBytes, __ATOMIC_RELAXED) == 0) {
+        return;
+    }
+    metricsHeader(out, "watchdog_hwm_store_bytes", "gauge", "Size of the mapped HWM history file");
+    strbufAppendf(out, "watchdog_hwm_store_bytes %zu\n", __atomic_load_n(&mappedBytes, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_hwm_store_restored", "gauge", "1 if history from an earlier run was resumed");
+    strbufAppendf(out, "watchdog_hwm_store_restored %d\n", restoredRun ? 1 : 0);
+    metricsHeader(out, "watchdog_hwm_store_previous_clean", "gauge", "1 if the run that wrote the resumed history shut down cleanly");
+    strbufAppendf(out, "watchdog_hwm_store_previous_clean %d\n", previousClean ? 1 : 0);
+    metricsHeader(out, "watchdog_hwm_store_sync_seconds", "summary", "Time to msync the HWM history file");
+    histogramWriteSummary(out, "watchdog_hwm_store_sync_seconds", NULL, &syncLatency);
+    metricsHeader(out, "watchdog_hwm_store_sync_errors_total", "counter", "msync calls on the HWM history file that failed");
+    strbufAppendf(out, "watchdog_hwm_store_sync_errors_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&syncErrors, __ATOMIC_RELAXED));
+}
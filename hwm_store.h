@@ -0,0 +1,53 @@
+#ifndef HWM_STORE_H
+#define HWM_STORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "strbuf.h"
+
+#define HWM_STORE_MAGIC 0x3154534d57484b41ull  // "AKHWMST1"
+#define HWM_STORE_VERSION 1
+#define HWM_STORE_HEADER_BYTES 4096            // Regions start on the next page
+#define HWM_STORE_MAX_REGIONS 8
+
+// File-backed HWM rings. The file is a fixed header followed by the
+// regions in order, each page aligned, and is mapped MAP_SHARED: the
+// sampler and the rollups write samples with plain stores and the page
+// cache carries them to disk, so nothing costs a syscall per sample. The
+// mapping is msynced on pre-timeout and at shutdown, which is what makes
+// the last minutes before a watchdog reset survive it.
+//
+// A file is only reused if magic, version, sensor mask and every region
+// size match; anything else (other board, other build) starts it over.
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t regionCount;
+    uint64_t sensorMask;                       // HwmCapabilities.mask at creation
+    uint64_t regionBytes[HWM_STORE_MAX_REGIONS];
+    uint64_t fileBytes;
+    uint64_t opens;                            // Runs that attached the file, this one included
+    uint64_t syncs;
+    uint64_t lastSyncMs;                       // Wall clock of the latest msync
+    uint32_t clean;                            // 1 after a clean shutdown, 0 while attached
+    uint32_t reserved;
+} HwmStoreHeader;
+
+typedef struct {
+    const char *name;
+    size_t bytes;
+    void *base;                                // Set by hwmStoreOpen
+} HwmStoreRegion;
+
+// Map path, creating or resetting it as needed. restored tells whether the
+// regions hold data from an earlier run.
+bool hwmStoreOpen(const char *path, uint64_t sensorMask, HwmStoreRegion *regions, int count, bool *restored);
+// Write every dirty page and wait for it; safe to call from any thread
+void hwmStoreSync(void);
+// Mark the file clean, sync and unmap; after everything using it stopped
+void hwmStoreClose(void);
+
+void hwmStoreCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // HWM_STORE_H
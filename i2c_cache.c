@@ -0,0 +1,262 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "i2c_cache.h"
+#include "hw_actor.h"
+#include "metrics.h"
+#include "susi_timing.h"
+#include "timeutil.h"
+
+typedef struct {
+    SusiId_t bus;
+    uint8_t address;                                 // 7-bit
+    uint8_t cacheable[I2C_CACHE_REGISTERS / 8];      // Non-volatile map, fixed after startup
+    uint8_t valid[I2C_CACHE_REGISTERS / 8];
+    uint8_t values[I2C_CACHE_REGISTERS];
+    uint32_t generation;                             // Bumped by every invalidation
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t writes;
+    uint64_t invalidations;
+} I2cCacheDevice;
+
+// One transfer, run on the hardware thread
+typedef struct {
+    SusiId_t bus;
+    uint8_t address;
+    uint8_t reg;
+    uint8_t *data;
+    uint32_t length;
+    I2cCacheDevice *device;          // NULL for devices without a map
+    SusiStatus_t status;
+} I2cCacheTransfer;
+
+// valid and values are shared between the hardware thread (fills and
+// write-through) and callers (hits and invalidation)
+static pthread_mutex_t cacheLock = PTHREAD_MUTEX_INITIALIZER;
+static I2cCacheDevice devices[I2C_CACHE_MAX_DEVICES];
+static int deviceCount;
+
+#define BIT_TEST(map, bit) (((map)[(bit) / 8] >> ((bit) % 8)) & 1)
+#define BIT_SET(map, bit) ((map)[(bit) / 8] |= (uint8_t)(1u << ((bit) % 8)))
+#define BIT_CLEAR(map, bit) ((map)[(bit) / 8] &= (uint8_t)~(1u << ((bit) % 8)))
+
+bool i2cCacheAddSpec(const char *spec) {
+    I2cCacheDevice *device;
+    unsigned long bus, address;
+    char *end;
+
+    if (deviceCount >= I2C_CACHE_MAX_DEVICES) {
+        return false;
+    }
+    bus = strtoul(spec, &end, 10);
+    if (end == spec || *end != ':' || bus >= SUSI_I2C_MAX_DEVICE) {
+        return false;
+    }
+    spec = end + 1;
+    address = strtoul(spec, &end, 0);
+    if (end == spec || *end != ':' || address > 0x7f) {
+        return false;
+    }
+    device = &devices[deviceCount];
+    memset(device, 0, sizeof(*device));
+    device->bus = (SusiId_t)bus;
+    device->address = (uint8_t)address;
+
+    do {
+        unsigned long first, last;
+
+        spec = end + 1;
+        first = last = strtoul(spec, &end, 0);
+        if (end != spec && *end == '-') {
+            spec = end + 1;
+            last = strtoul(spec, &end, 0);
+        }
+        if (end == spec || first > last || last >= I2C_CACHE_REGISTERS) {
+            return false;
+        }
+        for (unsigned long reg = first; reg <= last; reg++) {
+            BIT_SET(device->cacheable, reg);
+        }
+    } while (*end == ',');
+    if (*end != '\0') {
+        return false;
+    }
+    deviceCount++;
+    return true;
+}
+
+static I2cCacheDevice *findDevice(SusiId_t bus, uint8_t address) {
+    for (int i = 0; i < deviceCount; i++) {
+        if (devices[i].bus == bus && devices[i].address == address) {
+            return &devices[i];
+        }
+    }
+    return NULL;
+}
+
+static void hwRead(void *arg) {
+    I2cCacheTransfer *t = (I2cCacheTransfer *)arg;
+    uint32_t generation = 0;
+    uint64_t start;
+
+    if (t->device != NULL) {
+        generation = __atomic_load_n(&t->device->generation, __ATOMIC_ACQUIRE);
+    }
+    start = monotonicNowNs();
+    t->status = SusiI2CReadTransfer(t->bus, SUSI_I2C_ENC_7BIT_ADDR(t->address), t->reg, t->data, t->length);
+    susiTimingRecord(SUSI_CALL_I2C_READ_TRANSFER, start, t->status);
+    if (t->device == NULL || t->status != SUSI_STATUS_SUCCESS) {
+        return;
+    }
+
+    pthread_mutex_lock(&cacheLock);
+    // An invalidation during the transfer may describe a change the read
+    // missed; leave the values for the next read to fetch
+    if (t->device->generation == generation) {
+        for (uint32_t i = 0; i < t->length; i++) {
+            uint32_t reg = t->reg + i;
+
+            if (BIT_TEST(t->device->cacheable, reg)) {
+                t->device->values[reg] = t->data[i];
+                BIT_SET(t->device->valid, reg);
+            }
+        }
+    }
+    pthread_mutex_unlock(&cacheLock);
+}
+
+static void hwWrite(void *arg) {
+    I2cCacheTransfer *t = (I2cCacheTransfer *)arg;
+    uint64_t start = monotonicNowNs();
+
+    t->status = SusiI2CWriteTransfer(t->bus, SUSI_I2C_ENC_7BIT_ADDR(t->address), t->reg, t->data, t->length);
+    susiTimingRecord(SUSI_CALL_I2C_WRITE_TRANSFER, start, t->status);
+    if (t->device == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&cacheLock);
+    for (uint32_t i = 0; i < t->length; i++) {
+        uint32_t reg = t->reg + i;
+
+        if (!BIT_TEST(t->device->cacheable, reg)) {
+            continue;
+        }
+        if (t->status == SUSI_STATUS_SUCCESS) {
+            t->device->values[reg] = t->data[i];
+            BIT_SET(t->device->valid, reg);
+        } else {
+            BIT_CLEAR(t->device->valid, reg);
+        }
+    }
+    pthread_mutex_unlock(&cacheLock);
+}
+
+SusiStatus_t i2cCacheRead(SusiId_t bus, uint8_t address, uint8_t reg, uint8_t *data, uint32_t length,
+                          bool *hit) {
+    I2cCacheTransfer t;
+    I2cCacheDevice *device;
+
+    *hit = false;
+    if (length == 0 || reg + length > I2C_CACHE_REGISTERS || address > 0x7f) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    device = findDevice(bus, address);
+    if (device != NULL) {
+        pthread_mutex_lock(&cacheLock);
+        *hit = true;
+        for (uint32_t i = 0; i < length && *hit; i++) {
+            *hit = BIT_TEST(device->cacheable, reg + i) && BIT_TEST(device->valid, reg + i);
+        }
+        if (*hit) {
+            memcpy(data, &device->values[reg], length);
+        }
+        pthread_mutex_unlock(&cacheLock);
+        __atomic_fetch_add(*hit ? &device->hits : &device->misses, 1, __ATOMIC_RELAXED);
+        if (*hit) {
+            return SUSI_STATUS_SUCCESS;
+        }
+    }
+
+    t.bus = bus;
+    t.address = address;
+    t.reg = reg;
+    t.data = data;
+    t.length = length;
+    t.device = device;
+    if (!hwActorCall(HW_LANE_USER, hwRead, &t)) {
+        return SUSI_STATUS_LOCKFAIL;
+    }
+    return t.status;
+}
+
+SusiStatus_t i2cCacheWrite(SusiId_t bus, uint8_t address, uint8_t reg, const uint8_t *data, uint32_t length) {
+    I2cCacheTransfer t;
+
+    if (length == 0 || reg + length > I2C_CACHE_REGISTERS || address > 0x7f) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    t.bus = bus;
+    t.address = address;
+    t.reg = reg;
+    t.data = (uint8_t *)data;        // SusiI2CWriteTransfer only reads it
+    t.length = length;
+    t.device = findDevice(bus, address);
+    if (t.device != NULL) {
+        __atomic_fetch_add(&t.device->writes, 1, __ATOMIC_RELAXED);
+    }
+    if (!hwActorCall(HW_LANE_USER, hwWrite, &t)) {
+        return SUSI_STATUS_LOCKFAIL;
+    }
+    return t.status;
+}
+
+bool i2cCacheInvalidate(SusiId_t bus, uint8_t address, uint8_t reg, uint32_t count) {
+    I2cCacheDevice *device = findDevice(bus, address);
+
+    if (device == NULL) {
+        return false;
+    }
+    if (count == 0 || reg + count > I2C_CACHE_REGISTERS) {
+        reg = 0;
+        count = I2C_CACHE_REGISTERS;
+    }
+    pthread_mutex_lock(&cacheLock);
+    for (uint32_t i = reg; i < reg + count; i++) {
+        BIT_CLEAR(device->valid, i);
+    }
+    __atomic_add_fetch(&device->generation, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&cacheLock);
+    __atomic_fetch_add(&device->invalidations, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+void i2cCacheCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (deviceCount == 0) {
+        return;
+    }
+    metricsHeader(out, "watchdog_i2c_cache_reads_total", "counter", "Register cache reads per device and result");
+    for (int i = 0; i < deviceCount; i++) {
+        strbufAppendf(out, "watchdog_i2c_cache_reads_total{bus=\"%u\",address=\"0x%02x\",result=\"hit\"} %llu\n",
+                      devices[i].bus, devices[i].address,
+                      (unsigned long long)__atomic_load_n(&devices[i].hits, __ATOMIC_RELAXED));
+        strbufAppendf(out, "watchdog_i2c_cache_reads_total{bus=\"%u\",address=\"0x%02x\",result=\"miss\"} %llu\n",
+                      devices[i].bus, devices[i].address,
+                      (unsigned long long)__atomic_load_n(&devices[i].misses, __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_i2c_cache_writes_total", "counter", "Writes passed through the register cache");
+    for (int i = 0; i < deviceCount; i++) {
+        strbufAppendf(out, "watchdog_i2c_cache_writes_total{bus=\"%u\",address=\"0x%02x\"} %llu\n",
+                      devices[i].bus, devices[i].address,
+                      (unsigned long long)__atomic_load_n(&devices[i].writes, __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_i2c_cache_invalidations_total", "counter", "Explicit register cache invalidations");
+    for (int i = 0; i < deviceCount; i++) {
+        strbufAppendf(out, "watchdog_i2c_cache_invalidations_total{bus=\"%u\",address=\"0x%02x\"} %llu\n",
+                      devices[i].bus, devices[i].address,
+                      (unsigned long long)__atomic_load_n(&devices[i].invalidations, __ATOMIC_RELAXED));
+    }
+}
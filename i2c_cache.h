@@ -0,0 +1,38 @@
+#ifndef I2C_CACHE_H
+#define I2C_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "Susi4.h"
+#include "strbuf.h"
+
+#define I2C_CACHE_MAX_DEVICES 16
+#define I2C_CACHE_REGISTERS 256          // Byte-command register space
+
+// Write-through register cache in front of SusiI2CReadTransfer and
+// SusiI2CWriteTransfer. Each declared device has a map of non-volatile
+// registers (configuration that only changes when written); reads that
+// only touch valid non-volatile registers are answered from memory,
+// everything else goes to the device on the hardware thread. Writes
+// always go to the device and update the cache once they succeed; a
+// failed write invalidates the registers it covered, since their state
+// is then unknown. Devices without a map pass straight through.
+
+// Declare a device before the service starts:
+// "BUS:ADDR:FIRST[-LAST][,FIRST[-LAST]...]" lists the non-volatile
+// registers, e.g. "0:0x48:0x01-0x03" for a temperature sensor's config
+// and limit registers. False for a bad spec or a full table.
+bool i2cCacheAddSpec(const char *spec);
+
+// Read length registers from reg of address (7-bit); *hit tells whether the
+// device was touched. Returns the SUSI status of the transfer.
+SusiStatus_t i2cCacheRead(SusiId_t bus, uint8_t address, uint8_t reg, uint8_t *data, uint32_t length,
+                          bool *hit);
+SusiStatus_t i2cCacheWrite(SusiId_t bus, uint8_t address, uint8_t reg, const uint8_t *data, uint32_t length);
+// Forget count registers from reg, or all of them for count 0, e.g. after
+// another tool wrote the device; false if the device has no map
+bool i2cCacheInvalidate(SusiId_t bus, uint8_t address, uint8_t reg, uint32_t count);
+
+void i2cCacheCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // I2C_CACHE_H
@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include "i2c_txn.h"
+#include "histogram.h"
+#include "hw_actor.h"
+#include "metrics.h"
+#include "susi_timing.h"
+#include "timeutil.h"
+
+// Written on the hardware thread only, read by /metrics
+typedef struct {
+    uint64_t batches;
+    uint64_t ops;
+    uint64_t failedOps;
+    uint64_t bytesWritten;
+    uint64_t bytesRead;
+    uint64_t busyNs;                 // Time spent running batches
+    Histogram batchLatency;          // Submission to completion
+} I2cBusStats;
+
+static I2cBusStats busStats[I2C_TXN_MAX_BUSES];
+
+static void runBatch(I2cBatch *batch) {
+    I2cBusStats *stats = &busStats[batch->bus];
+    uint64_t written = 0;
+    uint64_t read = 0;
+    uint64_t start = monotonicNowNs();
+
+    batch->completed = 0;
+    batch->failed = 0;
+    for (int i = 0; i < batch->count; i++) {
+        I2cOp *op = &batch->ops[i];
+        uint64_t callStart = monotonicNowNs();
+
+        op->status = SusiI2CWriteReadCombine(batch->bus, (uint8_t)SUSI_I2C_ENC_7BIT_ADDR(op->address),
+                                             (uint8_t *)op->write, op->writeLength, op->read, op->readLength);
+        susiTimingRecord(SUSI_CALL_I2C_WRITE_READ, callStart, op->status);
+        batch->completed++;
+        if (op->status != SUSI_STATUS_SUCCESS) {
+            batch->failed++;
+            if (batch->stopOnError) {
+                break;
+            }
+            continue;
+        }
+        written += op->writeLength;
+        read += op->readLength;
+    }
+    batch->durationNs = monotonicNowNs() - start;
+
+    __atomic_fetch_add(&stats->batches, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->ops, (uint64_t)batch->completed, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->failedOps, (uint64_t)batch->failed, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->bytesWritten, written, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->bytesRead, read, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->busyNs, batch->durationNs, __ATOMIC_RELAXED);
+    histogramRecord(&stats->batchLatency, monotonicNowNs() - batch->submittedNs);
+}
+
+static void hwTransact(void *arg) {
+    runBatch((I2cBatch *)arg);
+}
+
+static void hwSubmitted(void *arg) {
+    I2cBatch *batch = (I2cBatch *)arg;
+
+    runBatch(batch);
+    batch->completion(batch, batch->ctx);
+}
+
+bool i2cSubmit(I2cBatch *batch) {
+    if (batch->bus >= I2C_TXN_MAX_BUSES || batch->count <= 0 || batch->completion == NULL) {
+        return false;
+    }
+    batch->submittedNs = monotonicNowNs();
+    return hwActorPost(HW_LANE_USER, hwSubmitted, batch);
+}
+
+bool i2cTransact(I2cBatch *batch) {
+    if (batch->bus >= I2C_TXN_MAX_BUSES || batch->count <= 0) {
+        return false;
+    }
+    batch->submittedNs = monotonicNowNs();
+    return hwActorCall(HW_LANE_USER, hwTransact, batch);
+}
+
+void i2cTxnCollectMetrics(StrBuf *out, void *ctx) {
+    char labels[32];
+    bool used = false;
+    (void)ctx;
+
+    for (int bus = 0; bus < I2C_TXN_MAX_BUSES; bus++) {
+        used = used || __atomic_load_n(&busStats[bus].batches, __ATOMIC_RELAXED) > 0;
+    }
+    if (!used) {
+        return;
+    }
+    metricsHeader(out, "watchdog_i2c_batches_total", "counter", "I2C transaction batches run per bus");
+    for (int bus = 0; bus < I2C_TXN_MAX_BUSES; bus++) {
+        if (busStats[bus].batches > 0) {
+            strbufAppendf(out, "watchdog_i2c_batches_total{bus=\"%d\"} %llu\n", bus,
+                          (unsigned long long)__atomic_load_n(&busStats[bus].batches, __ATOMIC_RELAXED));
+        }
+    }
+    metricsHeader(out, "watchdog_i2c_ops_total", "counter", "I2C operations issued per bus and result");
+    for (int bus = 0; bus < I2C_TXN_MAX_BUSES; bus++) {
+        uint64_t ops = __atomic_load_n(&busStats[bus].ops, __ATOMIC_RELAXED);
+        uint64_t failed = __atomic_load_n(&busStats[bus].failedOps, __ATOMIC_RELAXED);
+
+        if (busStats[bus].batches > 0) {
+            strbufAppendf(out, "watchdog_i2c_ops_total{bus=\"%d\",result=\"ok\"} %llu\n", bus,
+                          (unsigned long long)(ops - failed));
+            strbufAppendf(out, "watchdog_i2c_ops_total{bus=\"%d\",result=\"error\"} %llu\n", bus,
+                          (unsigned long long)failed);
+        }
+    }
+    metricsHeader(out, "watchdog_i2c_bytes_total", "counter", "Bytes moved by successful I2C operations");
+    for (int bus = 0; bus < I2C_TXN_MAX_BUSES; bus++) {
+        if (busStats[bus].batches > 0) {
+            strbufAppendf(out, "watchdog_i2c_bytes_total{bus=\"%d\",direction=\"write\"} %llu\n", bus,
+                          (unsigned long long)__atomic_load_n(&busStats[bus].bytesWritten, __ATOMIC_RELAXED));
+            strbufAppendf(out, "watchdog_i2c_bytes_total{bus=\"%d\",direction=\"read\"} %llu\n", bus,
+                          (unsigned long long)__atomic_load_n(&busStats[bus].bytesRead, __ATOMIC_RELAXED));
+        }
+    }
+    metricsHeader(out, "watchdog_i2c_busy_seconds_total", "counter", "Time the hardware thread spent running I2C batches");
+    for (int bus = 0; bus < I2C_TXN_MAX_BUSES; bus++) {
+        if (busStats[bus].batches > 0) {
+            strbufAppendf(out, "watchdog_i2c_busy_seconds_total{bus=\"%d\"} %.6f\n", bus,
+                          (double)__atomic_load_n(&busStats[bus].busyNs, __ATOMIC_RELAXED) / 1e9);
+        }
+    }
+    metricsHeader(out, "watchdog_i2c_batch_seconds", "summary", "I2C batch latency from submission to completion");
+    for (int bus = 0; bus < I2C_TXN_MAX_BUSES; bus++) {
+        if (busStats[bus].batches > 0) {
+            snprintf(labels, sizeof(labels), "bus=\"%d\"", bus);
+            histogramWriteSummary(out, "watchdog_i2c_batch_seconds", labels, &busStats[bus].batchLatency);
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef I2C_TXN_H
+#define I2C_TXN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "Susi4.h"
+#include "strbuf.h"
+
+#define I2C_TXN_MAX_BUSES SUSI_I2C_MAX_DEVICE
+
+// Batched I2C transactions. A caller describes a vector of write/read
+// operations and the whole vector runs back-to-back as one command on the
+// hardware thread: one queue round trip instead of one per register, and
+// no other SUSI access can slip in between two operations of a batch.
+// Batches run on the user lane and complete in submission order (lanes
+// are FIFO).
+
+typedef struct {
+    uint8_t address;                 // 7-bit device address
+    const uint8_t *write;            // Bytes written first (e.g. the register), may be NULL
+    uint32_t writeLength;
+    uint8_t *read;                   // Filled with readLength bytes, may be NULL
+    uint32_t readLength;
+    SusiStatus_t status;             // Result of this operation
+} I2cOp;
+
+typedef struct I2cBatch I2cBatch;
+
+// Runs on the hardware thread once every operation has completed; keep it
+// short, the feed lane waits behind it
+typedef void (*I2cCompletion)(I2cBatch *batch, void *ctx);
+
+struct I2cBatch {
+    SusiId_t bus;                    // SUSI_ID_I2C_*
+    I2cOp *ops;
+    int count;
+    bool stopOnError;                // Skip the operations after a failed one
+    I2cCompletion completion;        // Only used by i2cSubmit()
+    void *ctx;
+    // Results
+    int completed;                   // Operations issued; the rest were skipped
+    int failed;                      // Issued operations that did not succeed
+    uint64_t durationNs;             // Time on the bus for the whole batch
+    uint64_t submittedNs;            // Set when the batch is queued
+};
+
+// Queue batch and return; batch and its buffers must stay valid until the
+// completion has run. False if the bus is unknown or the lane is full.
+bool i2cSubmit(I2cBatch *batch);
+// Run batch and wait for it; true once it ran, check failed for the result
+bool i2cTransact(I2cBatch *batch);
+
+void i2cTxnCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // I2C_TXN_H
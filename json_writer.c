@@ -0,0 +1,316 @@
+#include <math.h>
+#include <string.h>
+#include "json_writer.h"
+
+void jsonWriterInit(JsonWriter *writer, StrBuf *out) {
+    writer->out = out;
+    writer->depth = 0;
+    writer->hasItems = 0;
+    writer->afterKey = false;
+    writer->cbor = false;
+}
+
+void jsonWriterInitCbor(JsonWriter *writer, StrBuf *out) {
+    jsonWriterInit(writer, out);
+    writer->cbor = true;
+}
+
+#define CBOR_UINT 0x00
+#define CBOR_NEGINT 0x20
+#define CBOR_TEXT 0x60
+#define CBOR_ARRAY_INDEFINITE 0x9f
+#define CBOR_MAP_INDEFINITE 0xbf
+#define CBOR_FALSE 0xf4
+#define CBOR_TRUE 0xf5
+#define CBOR_NULL 0xf6
+#define CBOR_FLOAT32 0xfa
+#define CBOR_FLOAT64 0xfb
+#define CBOR_BREAK 0xff
+
+// Major type and argument in the shortest form
+static void cborHead(StrBuf *out, uint8_t major, uint64_t value) {
+    char head[9];
+    size_t length;
+
+    if (value < 24) {
+        head[0] = (char)(major | value);
+        length = 1;
+    } else if (value <= UINT8_MAX) {
+        head[0] = (char)(major | 24);
+        head[1] = (char)value;
+        length = 2;
+    } else if (value <= UINT16_MAX) {
+        head[0] = (char)(major | 25);
+        length = 3;
+    } else if (value <= UINT32_MAX) {
+        head[0] = (char)(major | 26);
+        length = 5;
+    } else {
+        head[0] = (char)(major | 27);
+        length = 9;
+    }
+    for (size_t i = length - 1; length > 2 && i > 0; i--) {
+        head[i] = (char)value;
+        value >>= 8;
+    }
+    strbufAppendN(out, head, length);
+}
+
+static void cborText(StrBuf *out, const char *text) {
+    size_t length = strlen(text);
+
+    cborHead(out, CBOR_TEXT, length);
+    strbufAppendN(out, text, length);
+}
+
+static void cborDouble(StrBuf *out, double value, int decimals) {
+    static const double scales[] = { 1, 10, 100, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+    double scale = scales[decimals < 0 ? 0 : decimals > 9 ? 9 : decimals];
+    double rounded = round(value * scale);
+    char bytes[9];
+    uint64_t bits;
+
+    // What "%.*f" would print, without the digits
+    if (fabs(rounded) < 9007199254740992.0 && fmod(rounded, scale) == 0) {
+        int64_t whole = (int64_t)(rounded / scale);
+        if (whole < 0) {
+            cborHead(out, CBOR_NEGINT, (uint64_t)(-1 - whole));
+        } else {
+            cborHead(out, CBOR_UINT, (uint64_t)whole);
+        }
+        return;
+    }
+    value = rounded / scale;
+    if (fabs(rounded) < 1e7) {
+        // Seven significant digits survive a float32
+        float narrow = (float)value;
+        uint32_t narrowBits;
+
+        memcpy(&narrowBits, &narrow, sizeof(narrowBits));
+        bytes[0] = (char)CBOR_FLOAT32;
+        for (int i = 0; i < 4; i++) {
+            bytes[4 - i] = (char)(narrowBits >> (8 * i));
+        }
+        strbufAppendN(out, bytes, 5);
+        return;
+    }
+    memcpy(&bits, &value, sizeof(bits));
+    bytes[0] = (char)CBOR_FLOAT64;
+    for (int i = 0; i < 8; i++) {
+        bytes[8 - i] = (char)(bits >> (8 * i));
+    }
+    strbufAppendN(out, bytes, 9);
+}
+
+// Emit the separator before a value or key at the current level
+static void beginValue(JsonWriter *writer) {
+    uint32_t bit = 1u << writer->depth;
+    
+    if (writer->afterKey) {
+        writer->afterKey = false;
+        return;
+    }
+    // CBOR items need no separator
+    if ((writer->hasItems & bit) && !writer->cbor) {
+        strbufAppendChar(writer->out, ',');
+    }
+    writer->hasItems |= bit;
+}
+
+static void openScope(JsonWriter *writer, char c) {
+    beginValue(writer);
+    if (writer->cbor) {
+        c = (char)(c == '{' ? CBOR_MAP_INDEFINITE : CBOR_ARRAY_INDEFINITE);
+    }
+    strbufAppendChar(writer->out, c);
+    if (writer->depth + 1 < JSON_WRITER_MAX_DEPTH) {
+        writer->depth++;
+    }
+    writer->hasItems &= ~(1u << writer->depth);
+}
+
+static void closeScope(JsonWriter *writer, char c) {
+    strbufAppendChar(writer->out, writer->cbor ? (char)CBOR_BREAK : c);
+    if (writer->depth > 0) {
+        writer->depth--;
+    }
+}
+
+void jsonBeginObject(JsonWriter *writer) {
+    openScope(writer, '{');
+}
+
+void jsonEndObject(JsonWriter *writer) {
+    closeScope(writer, '}');
+}
+
+void jsonBeginArray(JsonWriter *writer) {
+    openScope(writer, '[');
+}
+
+void jsonEndArray(JsonWriter *writer) {
+    closeScope(writer, ']');
+}
+
+static void appendEscaped(StrBuf *out, const char *text) {
+    static const char hex[] = "0123456789abcdef";
+    const char *run = text;
+    
+    strbufAppendChar(out, '"');
+    for (const char *p = text; *p; p++) {
+        unsigned char c = (unsigned char)*p;
+        
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        // Copy the clean run in one go, then the escape sequence
+        strbufAppendN(out, run, (size_t)(p - run));
+        run = p + 1;
+        switch (c) {
+            case '"':  strbufAppendN(out, "\\\"", 2); break;
+            case '\\': strbufAppendN(out, "\\\\", 2); break;
+            case '\n': strbufAppendN(out, "\\n", 2); break;
+            case '\r': strbufAppendN(out, "\\r", 2); break;
+            case '\t': strbufAppendN(out, "\\t", 2); break;
+            default: {
+                char escape[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf] };
+                strbufAppendN(out, escape, sizeof(escape));
+                break;
+            }
+        }
+    }
+    strbufAppend(out, run);
+    strbufAppendChar(out, '"');
+}
+
+void jsonKey(JsonWriter *writer, const char *key) {
+    beginValue(writer);
+    if (writer->cbor) {
+        cborText(writer->out, key);
+        writer->afterKey = true;
+        return;
+    }
+    appendEscaped(writer->out, key);
+    strbufAppendChar(writer->out, ':');
+    writer->afterKey = true;
+}
+
+void jsonString(JsonWriter *writer, const char *value) {
+    beginValue(writer);
+    if (writer->cbor) {
+        if (value == NULL) {
+            strbufAppendChar(writer->out, (char)CBOR_NULL);
+        } else {
+            cborText(writer->out, value);
+        }
+        return;
+    }
+    if (value == NULL) {
+        strbufAppendN(writer->out, "null", 4);
+        return;
+    }
+    appendEscaped(writer->out, value);
+}
+
+// Integers are formatted by hand: this is the hot path for every field
+static void appendUnsigned(StrBuf *out, uint64_t value) {
+    char digits[20];
+    int n = 0;
+    
+    do {
+        digits[sizeof(digits) - 1 - n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    strbufAppendN(out, digits + sizeof(digits) - n, (size_t)n);
+}
+
+void jsonInt(JsonWriter *writer, int64_t value) {
+    beginValue(writer);
+    if (writer->cbor) {
+        if (value < 0) {
+            cborHead(writer->out, CBOR_NEGINT, (uint64_t)(-1 - value));
+        } else {
+            cborHead(writer->out, CBOR_UINT, (uint64_t)value);
+        }
+        return;
+    }
+    if (value < 0) {
+        strbufAppendChar(writer->out, '-');
+        appendUnsigned(writer->out, (uint64_t)0 - (uint64_t)value);
+    } else {
+        appendUnsigned(writer->out, (uint64_t)value);
+    }
+}
+
+void jsonUint(JsonWriter *writer, uint64_t value) {
+    beginValue(writer);
+    if (writer->cbor) {
+        cborHead(writer->out, CBOR_UINT, value);
+        return;
+    }
+    appendUnsigned(writer->out, value);
+}
+
+void jsonBool(JsonWriter *writer, bool value) {
+    beginValue(writer);
+    if (writer->cbor) {
+        strbufAppendChar(writer->out, (char)(value ? CBOR_TRUE : CBOR_FALSE));
+        return;
+    }
+    if (value) {
+        strbufAppendN(writer->out, "true", 4);
+    } else {
+        strbufAppendN(writer->out, "false", 5);
+    }
+}
+
+void jsonNull(JsonWriter *writer) {
+    beginValue(writer);
+    if (writer->cbor) {
+        strbufAppendChar(writer->out, (char)CBOR_NULL);
+        return;
+    }
+    strbufAppendN(writer->out, "null", 4);
+}
+
+void jsonDouble(JsonWriter *writer, double value, int decimals) {
+    beginValue(writer);
+    if (!isfinite(value)) {
+        if (writer->cbor) {
+            strbufAppendChar(writer->out, (char)CBOR_NULL);
+        } else {
+            strbufAppendN(writer->out, "null", 4);
+        }
+        return;
+    }
+    if (writer->cbor) {
+        cborDouble(writer->out, value, decimals);
+        return;
+    }
+    strbufAppendf(writer->out, "%.*f", decimals, value);
+}
+
+void jsonFieldString(JsonWriter *writer, const char *key, const char *value) {
+    jsonKey(writer, key);
+    jsonString(writer, value);
+}
+
+void jsonFieldInt(JsonWriter *writer, const char *key, int64_t value) {
+    jsonKey(writer, key);
+    jsonInt(writer, value);
+}
+
+void jsonFieldUint(JsonWriter *writer, const char *key, uint64_t value) {
+    jsonKey(writer, key);
+    jsonUint(writer, value);
+}
+
+void jsonFieldBool(JsonWriter *writer, const char *key, bool value) {
+    jsonKey(writer, key);
+    jsonBool(writer, value);
+}
+
+void jsonFieldDouble(JsonWriter *writer, const char *key, double value, int decimals) {
+    jsonKey(writer, key);
+    jsonDouble(writer, value, decimals);
+}
@@ -0,0 +1,52 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "strbuf.h"
+
+#define JSON_WRITER_MAX_DEPTH 32
+
+// Streaming JSON writer over a StrBuf. Output is compact and never
+// allocates; commas are inserted automatically. Overflow is reported
+// through the StrBuf's overflow flag.
+//
+// The same calls can produce CBOR (RFC 8949) instead, for links where
+// bytes cost money. Objects and arrays become indefinite-length maps and
+// arrays, so nothing needs counting up front and output still streams.
+// Integers take 1 to 9 bytes, and fixed-point values are sent as integers
+// when they have no fraction, else as float32 when that holds their
+// decimals, else as float64.
+typedef struct {
+    StrBuf *out;
+    uint32_t depth;
+    uint32_t hasItems;    // Bit per nesting level: a value was already written
+    bool afterKey;        // The next value completes a "key": pair
+    bool cbor;
+} JsonWriter;
+
+void jsonWriterInit(JsonWriter *writer, StrBuf *out);
+void jsonWriterInitCbor(JsonWriter *writer, StrBuf *out);
+
+void jsonBeginObject(JsonWriter *writer);
+void jsonEndObject(JsonWriter *writer);
+void jsonBeginArray(JsonWriter *writer);
+void jsonEndArray(JsonWriter *writer);
+void jsonKey(JsonWriter *writer, const char *key);
+
+void jsonString(JsonWriter *writer, const char *value);
+void jsonInt(JsonWriter *writer, int64_t value);
+void jsonUint(JsonWriter *writer, uint64_t value);
+void jsonBool(JsonWriter *writer, bool value);
+void jsonNull(JsonWriter *writer);
+// Fixed-point with the given number of decimals; NaN and infinities become null
+void jsonDouble(JsonWriter *writer, double value, int decimals);
+
+// Shorthands for "key": value inside an object
+void jsonFieldString(JsonWriter *writer, const char *key, const char *value);
+void jsonFieldInt(JsonWriter *writer, const char *key, int64_t value);
+void jsonFieldUint(JsonWriter *writer, const char *key, uint64_t value);
+void jsonFieldBool(JsonWriter *writer, const char *key, bool value);
+void jsonFieldDouble(JsonWriter *writer, const char *key, double value, int decimals);
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,284 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "lease.h"
+#include "metrics.h"
+#include "access_log.h"
+#include "timeutil.h"
+#include "events.h"
+
+#define LEASE_NONE UINT32_MAX
+#define LEASE_INDEX_BITS 10          // log2(LEASE_MAX)
+
+// Leases are linked into their wheel bucket by slot index
+typedef struct {
+    uint32_t generation;             // Bumped on release so stale ids miss
+    bool active;
+    bool expired;
+    uint32_t timeoutMs;
+    uint64_t deadlineNs;
+    uint32_t prev;
+    uint32_t next;
+    uint64_t renewals;
+    char name[LEASE_NAME_MAX];
+} Lease;
+
+static pthread_mutex_t leaseLock = PTHREAD_MUTEX_INITIALIZER;
+static Lease leases[LEASE_MAX];
+static uint32_t wheel[LEASE_WHEEL_SLOTS];
+static bool wheelReady = false;
+static uint64_t wheelTick = 0;       // Last tick that was processed
+static uint32_t freeHint = 0;
+
+static uint32_t activeCount = 0;
+static uint32_t expiredCount = 0;
+static uint64_t renewalsTotal = 0;
+static uint64_t expirationsTotal = 0;
+
+static uint64_t tickOf(uint64_t ns) {
+    return ns / (LEASE_TICK_MS * 1000000ull);
+}
+
+// Called with the lock held
+static void wheelInit(void) {
+    if (wheelReady) {
+        return;
+    }
+    for (int i = 0; i < LEASE_WHEEL_SLOTS; i++) {
+        wheel[i] = LEASE_NONE;
+    }
+    wheelTick = tickOf(monotonicNowNs());
+    wheelReady = true;
+}
+
+static void wheelLink(uint32_t index) {
+    Lease *lease = &leases[index];
+    uint32_t *bucket = &wheel[tickOf(lease->deadlineNs) & (LEASE_WHEEL_SLOTS - 1)];
+    
+    lease->prev = LEASE_NONE;
+    lease->next = *bucket;
+    if (*bucket != LEASE_NONE) {
+        leases[*bucket].prev = index;
+    }
+    *bucket = index;
+}
+
+static void wheelUnlink(uint32_t index) {
+    Lease *lease = &leases[index];
+    
+    if (lease->prev != LEASE_NONE) {
+        leases[lease->prev].next = lease->next;
+    } else {
+        wheel[tickOf(lease->deadlineNs) & (LEASE_WHEEL_SLOTS - 1)] = lease->next;
+    }
+    if (lease->next != LEASE_NONE) {
+        leases[lease->next].prev = lease->prev;
+    }
+    lease->prev = lease->next = LEASE_NONE;
+}
+
+static uint32_t leaseId(uint32_t index) {
+    return (leases[index].generation << LEASE_INDEX_BITS) | index;
+}
+
+// Expire every lease whose bucket elapsed; leases hashed into a visited
+// bucket for a later round of the wheel stay linked. Only fully elapsed
+// ticks are processed, so a lease is never skipped for a whole round.
+static void wheelAdvance(uint64_t nowNs) {
+    uint64_t lastTick = tickOf(nowNs) - 1;
+    uint64_t ticks;
+    
+    if (lastTick <= wheelTick) {
+        return;
+    }
+    ticks = lastTick - wheelTick;
+    if (ticks > LEASE_WHEEL_SLOTS) {
+        ticks = LEASE_WHEEL_SLOTS;
+    }
+    for (uint64_t t = lastTick - ticks + 1; t <= lastTick; t++) {
+        uint32_t index = wheel[t & (LEASE_WHEEL_SLOTS - 1)];
+        
+        while (index != LEASE_NONE) {
+            Lease *lease = &leases[index];
+            uint32_t next = lease->next;
+            
+            if (lease->deadlineNs <= nowNs) {
+                wheelUnlink(index);
+                lease->expired = true;
+                expiredCount++;
+                expirationsTotal++;
+                accessLogMessage(LOG_LEVEL_WARN, "lease '%s' expired after %u ms without renewal",
+                                 lease->name, lease->timeoutMs);
+                eventPublish(EVENT_LEASE_EXPIRED, EVENT_NO_WATCHDOG, leaseId(index), 0, 0, 0);
+            }
+            index = next;
+        }
+    }
+    wheelTick = lastTick;
+}
+
+// Resolve an id to an active slot, LEASE_NONE if stale
+static uint32_t leaseLookup(uint32_t id) {
+    uint32_t index = id & (LEASE_MAX - 1);
+    
+    if (!leases[index].active || leaseId(index) != id) {
+        return LEASE_NONE;
+    }
+    return index;
+}
+
+LeaseResult leaseCreate(const char *name, uint32_t timeoutMs, uint32_t *id) {
+    uint32_t index = LEASE_NONE;
+    Lease *lease;
+    
+    if (timeoutMs < LEASE_MIN_TIMEOUT_MS || timeoutMs > LEASE_MAX_TIMEOUT_MS) {
+        return LEASE_BAD_TIMEOUT;
+    }
+    
+    pthread_mutex_lock(&leaseLock);
+    wheelInit();
+    for (uint32_t i = 0; i < LEASE_MAX; i++) {
+        uint32_t candidate = (freeHint + i) & (LEASE_MAX - 1);
+        if (!leases[candidate].active) {
+            index = candidate;
+            break;
+        }
+    }
+    if (index == LEASE_NONE) {
+        pthread_mutex_unlock(&leaseLock);
+        return LEASE_FULL;
+    }
+    freeHint = (index + 1) & (LEASE_MAX - 1);
+    
+    lease = &leases[index];
+    lease->active = true;
+    lease->expired = false;
+    lease->timeoutMs = timeoutMs;
+    lease->renewals = 0;
+    lease->deadlineNs = monotonicNowNs() + (uint64_t)timeoutMs * 1000000ull;
+    snprintf(lease->name, sizeof(lease->name), "%s", (name && *name) ? name : "unnamed");
+    wheelLink(index);
+    activeCount++;
+    *id = leaseId(index);
+    
+    pthread_mutex_unlock(&leaseLock);
+    return LEASE_OK;
+}
+
+LeaseResult leaseRenew(uint32_t id, int64_t *remainingMs) {
+    uint32_t index;
+    Lease *lease;
+    
+    pthread_mutex_lock(&leaseLock);
+    index = leaseLookup(id);
+    if (index == LEASE_NONE) {
+        pthread_mutex_unlock(&leaseLock);
+        return LEASE_UNKNOWN;
+    }
+    lease = &leases[index];
+    
+    // A renewal after expiry means the client recovered
+    if (lease->expired) {
+        lease->expired = false;
+        expiredCount--;
+    } else {
+        wheelUnlink(index);
+    }
+    lease->deadlineNs = monotonicNowNs() + (uint64_t)lease->timeoutMs * 1000000ull;
+    lease->renewals++;
+    renewalsTotal++;
+    wheelLink(index);
+    if (remainingMs) {
+        *remainingMs = lease->timeoutMs;
+    }
+    
+    pthread_mutex_unlock(&leaseLock);
+    return LEASE_OK;
+}
+
+LeaseResult leaseRelease(uint32_t id) {
+    uint32_t index;
+    Lease *lease;
+    
+    pthread_mutex_lock(&leaseLock);
+    index = leaseLookup(id);
+    if (index == LEASE_NONE) {
+        pthread_mutex_unlock(&leaseLock);
+        return LEASE_UNKNOWN;
+    }
+    lease = &leases[index];
+    if (lease->expired) {
+        expiredCount--;
+    } else {
+        wheelUnlink(index);
+    }
+    lease->active = false;
+    lease->expired = false;
+    // Keep ids unique across reuse of the slot
+    lease->generation = (lease->generation + 1) & ((1u << (32 - LEASE_INDEX_BITS)) - 1);
+    activeCount--;
+    
+    pthread_mutex_unlock(&leaseLock);
+    return LEASE_OK;
+}
+
+bool leasesHealthy(void *ctx) {
+    bool healthy;
+    (void)ctx;
+    
+    pthread_mutex_lock(&leaseLock);
+    if (wheelReady) {
+        wheelAdvance(monotonicNowNs());
+    }
+    healthy = (expiredCount == 0);
+    pthread_mutex_unlock(&leaseLock);
+    return healthy;
+}
+
+size_t leaseListSize(void) {
+    // Fixed part plus a generous bound per entry (name escaped up to 6x)
+    return 64 + (size_t)__atomic_load_n(&activeCount, __ATOMIC_RELAXED) * (128 + LEASE_NAME_MAX * 6);
+}
+
+void leaseWriteList(JsonWriter *writer) {
+    uint64_t now = monotonicNowNs();
+    
+    pthread_mutex_lock(&leaseLock);
+    jsonBeginObject(writer);
+    jsonFieldUint(writer, "expired", expiredCount);
+    jsonKey(writer, "leases");
+    jsonBeginArray(writer);
+    for (uint32_t i = 0; i < LEASE_MAX; i++) {
+        Lease *lease = &leases[i];
+        
+        if (!lease->active) {
+            continue;
+        }
+        jsonBeginObject(writer);
+        jsonFieldUint(writer, "id", leaseId(i));
+        jsonFieldString(writer, "name", lease->name);
+        jsonFieldUint(writer, "timeout_ms", lease->timeoutMs);
+        jsonFieldInt(writer, "remaining_ms", ((int64_t)lease->deadlineNs - (int64_t)now) / 1000000);
+        jsonFieldBool(writer, "expired", lease->expired);
+        jsonFieldUint(writer, "renewals", lease->renewals);
+        jsonEndObject(writer);
+    }
+    jsonEndArray(writer);
+    jsonEndObject(writer);
+    pthread_mutex_unlock(&leaseLock);
+}
+
+void leaseCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+    
+    pthread_mutex_lock(&leaseLock);
+    metricsHeader(out, "watchdog_leases", "gauge", "Active liveness leases");
+    strbufAppendf(out, "watchdog_leases %u\n", activeCount);
+    metricsHeader(out, "watchdog_leases_expired", "gauge", "Leases currently past their deadline (blocks feeding)");
+    strbufAppendf(out, "watchdog_leases_expired %u\n", expiredCount);
+    metricsHeader(out, "watchdog_lease_renewals_total", "counter", "Lease renewals");
+    strbufAppendf(out, "watchdog_lease_renewals_total %llu\n", (unsigned long long)renewalsTotal);
+    metricsHeader(out, "watchdog_lease_expirations_total", "counter", "Leases that expired");
+    strbufAppendf(out, "watchdog_lease_expirations_total %llu\n", (unsigned long long)expirationsTotal);
+    pthread_mutex_unlock(&leaseLock);
+}
@@ -0,0 +1,47 @@
+#ifndef LEASE_H
+#define LEASE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "strbuf.h"
+#include "json_writer.h"
+#include "build_profile.h"
+
+#ifndef LEASE_MAX
+#define LEASE_MAX 1024               // Lease slots, must be a power of two
+#endif
+#define LEASE_NAME_MAX 32
+#define LEASE_WHEEL_SLOTS 512        // Timer wheel buckets, must be a power of two
+#define LEASE_TICK_MS 10             // Wheel resolution
+#define LEASE_MIN_TIMEOUT_MS 100
+#define LEASE_MAX_TIMEOUT_MS 3600000
+
+// Liveness leases held by client processes. Each lease must be renewed
+// within its timeout; the auto-feeder only feeds the hardware watchdog while
+// no lease has expired, so one hung client ends in a board reset.
+// Deadlines live in a hashed timer wheel: create, renew and release are
+// O(1) and expiry only visits the buckets that elapsed since the last check.
+
+typedef enum {
+    LEASE_OK,
+    LEASE_UNKNOWN,        // No lease with that id (released or never created)
+    LEASE_FULL,           // All slots are in use
+    LEASE_BAD_TIMEOUT
+} LeaseResult;
+
+LeaseResult leaseCreate(const char *name, uint32_t timeoutMs, uint32_t *id);
+LeaseResult leaseRenew(uint32_t id, int64_t *remainingMs);
+LeaseResult leaseRelease(uint32_t id);
+
+// Feeder condition: advances the wheel and returns true while no lease
+// has expired
+bool leasesHealthy(void *ctx);
+
+// Write {"leases":[...],"expired":N} with every active lease
+void leaseWriteList(JsonWriter *writer);
+// Upper bound for the size of leaseWriteList() output
+size_t leaseListSize(void);
+
+void leaseCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // LEASE_H
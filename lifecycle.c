@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/signalfd.h>
+#include <sys/eventfd.h>
+#include "lifecycle.h"
+#include "metrics.h"
+#include "timeutil.h"
+
+typedef struct {
+    int phase;
+    const char *name;
+    LifecycleHook hook;
+    pthread_t thread;
+    uint64_t durationNs;
+} ShutdownHook;
+
+typedef struct {
+    const char *name;
+    uint64_t durationNs;
+} StartupStep;
+
+static ShutdownHook hooks[LIFECYCLE_MAX_HOOKS];
+static int hookCount = 0;
+static StartupStep steps[LIFECYCLE_MAX_STEPS];
+static int stepCount = 0;
+
+static sigset_t blockedSignals;
+static int signalFd = -1;
+static int wakeFd = -1;
+static uint64_t initNs = 0;
+static uint64_t lastStepNs = 0;
+static uint64_t startupNs = 0;
+
+bool lifecycleInit(void) {
+    sigemptyset(&blockedSignals);
+    sigaddset(&blockedSignals, SIGINT);
+    sigaddset(&blockedSignals, SIGTERM);
+    
+    if (pthread_sigmask(SIG_BLOCK, &blockedSignals, NULL) != 0) {
+        perror("lifecycle: sigmask");
+        return false;
+    }
+    signalFd = signalfd(-1, &blockedSignals, SFD_CLOEXEC);
+    if (signalFd < 0) {
+        perror("lifecycle: signalfd");
+        return false;
+    }
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wakeFd < 0) {
+        perror("lifecycle: eventfd");
+        close(signalFd);
+        signalFd = -1;
+        return false;
+    }
+    
+    initNs = monotonicNowNs();
+    lastStepNs = initNs;
+    return true;
+}
+
+void lifecycleStartupStep(const char *name) {
+    uint64_t now = monotonicNowNs();
+    
+    if (stepCount < LIFECYCLE_MAX_STEPS) {
+        steps[stepCount].name = name;
+        steps[stepCount].durationNs = now - lastStepNs;
+        stepCount++;
+    }
+    lastStepNs = now;
+}
+
+void lifecycleStartupDone(void) {
+    startupNs = monotonicNowNs() - initNs;
+    
+    for (int i = 0; i < stepCount; i++) {
+        printf("  startup %-14s %8.3f ms\n", steps[i].name, (double)steps[i].durationNs / 1e6);
+    }
+    printf("Startup completed in %.3f ms\n", (double)startupNs / 1e6);
+    fflush(stdout);
+}
+
+void lifecycleRequestShutdown(void) {
+    uint64_t one = 1;
+    
+    // write() is async-signal-safe, nothing else is touched here
+    if (write(wakeFd, &one, sizeof(one)) != sizeof(one)) {
+        // Counter already non-zero: the main loop is waking up anyway
+    }
+}
+
+int lifecycleWait(void) {
+    struct pollfd fds[2] = {
+        { .fd = signalFd, .events = POLLIN },
+        { .fd = wakeFd, .events = POLLIN },
+    };
+    struct signalfd_siginfo info;
+    uint64_t value;
+    
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            continue; // EINTR from a stop/continue signal
+        }
+        if (fds[0].revents & POLLIN) {
+            if (read(signalFd, &info, sizeof(info)) == sizeof(info)) {
+                return (int)info.ssi_signo;
+            }
+        }
+        if (fds[1].revents & POLLIN) {
+            if (read(wakeFd, &value, sizeof(value)) == sizeof(value)) {
+                return 0;
+            }
+        }
+    }
+}
+
+// Hooks must be registered before lifecycleShutdown()
+bool lifecycleAddShutdownHook(int phase, const char *name, LifecycleHook hook) {
+    if (hookCount >= LIFECYCLE_MAX_HOOKS) {
+        return false;
+    }
+    hooks[hookCount].phase = phase;
+    hooks[hookCount].name = name;
+    hooks[hookCount].hook = hook;
+    hooks[hookCount].durationNs = 0;
+    hookCount++;
+    return true;
+}
+
+static void* runHook(void *arg) {
+    ShutdownHook *entry = (ShutdownHook *)arg;
+    uint64_t start = monotonicNowNs();
+    
+    entry->hook();
+    entry->durationNs = monotonicNowNs() - start;
+    return NULL;
+}
+
+void lifecycleShutdown(void) {
+    uint64_t start = monotonicNowNs();
+    int phase = -1;
+    
+    // Signals are no longer consumed through the signalfd, so unblocking them
+    // lets a second Ctrl+C fall back to the default action and terminate
+    pthread_sigmask(SIG_UNBLOCK, &blockedSignals, NULL);
+    
+    for (;;) {
+        int next = -1;
+        
+        // Find the lowest phase above the one just completed
+        for (int i = 0; i < hookCount; i++) {
+            if (hooks[i].phase > phase && (next < 0 || hooks[i].phase < next)) {
+                next = hooks[i].phase;
+            }
+        }
+        if (next < 0) {
+            break;
+        }
+        phase = next;
+        
+        for (int i = 0; i < hookCount; i++) {
+            if (hooks[i].phase != phase) {
+                continue;
+            }
+            // Fall back to running inline if no thread can be created
+            if (pthread_create(&hooks[i].thread, NULL, runHook, &hooks[i]) != 0) {
+                hooks[i].thread = pthread_self();
+                runHook(&hooks[i]);
+            }
+        }
+        for (int i = 0; i < hookCount; i++) {
+            if (hooks[i].phase == phase && !pthread_equal(hooks[i].thread, pthread_self())) {
+                pthread_join(hooks[i].thread, NULL);
+            }
+        }
+    }
+    
+    for (int i = 0; i < hookCount; i++) {
+        printf("  shutdown %-14s phase %d %8.3f ms\n", hooks[i].name, hooks[i].phase,
+               (double)hooks[i].durationNs / 1e6);
+    }
+    printf("Shutdown completed in %.3f ms\n", (double)(monotonicNowNs() - start) / 1e6);
+    
+    close(signalFd);
+    close(wakeFd);
+    signalFd = -1;
+    wakeFd = -1;
+}
+
+// Metrics collector for the startup timings
+void lifecycleCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+    
+    metricsHeader(out, "watchdog_startup_seconds", "gauge", "Time from process start to serving requests");
+    strbufAppendf(out, "watchdog_startup_seconds %.6f\n", (double)startupNs / 1e9);
+    metricsHeader(out, "watchdog_startup_step_seconds", "gauge", "Duration of each startup step");
+    for (int i = 0; i < stepCount; i++) {
+        strbufAppendf(out, "watchdog_startup_step_seconds{step=\"%s\"} %.6f\n",
+                      steps[i].name, (double)steps[i].durationNs / 1e9);
+    }
+}
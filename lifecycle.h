@@ -0,0 +1,39 @@
+#ifndef LIFECYCLE_H
+#define LIFECYCLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "strbuf.h"
+
+#define LIFECYCLE_MAX_HOOKS 48
+#define LIFECYCLE_MAX_STEPS 48
+
+// Hooks in the same phase run concurrently; phases run in ascending order,
+// so a hook only has to be placed after the phases it depends on.
+typedef void (*LifecycleHook)(void);
+
+// Block SIGINT/SIGTERM and open the signalfd and the wake-up eventfd.
+// Must be called before any thread is created so every thread inherits the
+// blocked mask and signals are only ever consumed through the signalfd.
+bool lifecycleInit(void);
+
+// Record the end of a startup step (time since the previous step)
+void lifecycleStartupStep(const char *name);
+// Print the startup steps and total time since lifecycleInit()
+void lifecycleStartupDone(void);
+
+// Ask the main loop to shut down; async-signal-safe
+void lifecycleRequestShutdown(void);
+
+// Block until a termination signal or a shutdown request arrives.
+// Returns the signal number, or 0 for lifecycleRequestShutdown().
+int lifecycleWait(void);
+
+bool lifecycleAddShutdownHook(int phase, const char *name, LifecycleHook hook);
+// Run the registered hooks phase by phase and print per-hook timings.
+// A second termination signal during shutdown kills the process.
+void lifecycleShutdown(void);
+
+void lifecycleCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // LIFECYCLE_H
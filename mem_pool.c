@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include "mem_pool.h"
+#include "metrics.h"
+
+static MemPool *pools = NULL;
+static uint64_t refusals = 0;
+
+#ifdef WATCHDOG_NO_HEAP
+static const char profileName[] = "small";
+#else
+static const char profileName[] = "default";
+#endif
+
+static void listPool(MemPool *pool) {
+    bool expected = false;
+    MemPool *head;
+
+    if (__atomic_load_n(&pool->listed, __ATOMIC_ACQUIRE) ||
+        !__atomic_compare_exchange_n(&pool->listed, &expected, true, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    head = __atomic_load_n(&pools, __ATOMIC_RELAXED);
+    do {
+        pool->next = head;
+    } while (!__atomic_compare_exchange_n(&pools, &head, pool, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+static void countAlloc(MemPool *pool) {
+    uint64_t inUse = __atomic_add_fetch(&pool->inUse, 1, __ATOMIC_RELAXED);
+    uint64_t peak = __atomic_load_n(&pool->peak, __ATOMIC_RELAXED);
+
+    while (inUse > peak &&
+           !__atomic_compare_exchange_n(&pool->peak, &peak, inUse, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void* memPoolAlloc(MemPool *pool, size_t size) {
+    void *block = NULL;
+
+    listPool(pool);
+    if (size > pool->blockSize) {
+        // Nothing ever fits; not a shortage of blocks
+    } else if (pool->storage != NULL) {
+        uint64_t mask = __atomic_load_n(&pool->freeMask, __ATOMIC_RELAXED);
+
+        while (mask != 0) {
+            int slot = __builtin_ctzll(mask);
+
+            if (__atomic_compare_exchange_n(&pool->freeMask, &mask, mask & ~(1ull << slot), true,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                block = pool->storage + (size_t)slot * pool->blockSize;
+                break;
+            }
+        }
+    } else {
+        block = malloc(size);
+    }
+    if (block == NULL) {
+        __atomic_fetch_add(&pool->exhausted, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    countAlloc(pool);
+    return block;
+}
+
+bool memPoolOwns(const MemPool *pool, const void *block) {
+    uintptr_t start = (uintptr_t)pool->storage;
+
+    return pool->storage != NULL && (uintptr_t)block >= start &&
+           (uintptr_t)block < start + (uintptr_t)pool->blocks * pool->blockSize;
+}
+
+void memPoolFree(MemPool *pool, void *block) {
+    if (block == NULL) {
+        return;
+    }
+    __atomic_fetch_sub(&pool->inUse, 1, __ATOMIC_RELAXED);
+    if (memPoolOwns(pool, block)) {
+        int slot = (int)(((uintptr_t)block - (uintptr_t)pool->storage) / pool->blockSize);
+
+        __atomic_fetch_or(&pool->freeMask, 1ull << slot, __ATOMIC_RELEASE);
+    } else {
+        free(block);
+    }
+}
+
+void memPoolRecordRefusal(void) {
+    __atomic_fetch_add(&refusals, 1, __ATOMIC_RELAXED);
+}
+
+// Resident set from /proc/self/statm, 0 if unavailable
+uint64_t memPoolResidentBytes(void) {
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+
+    if (statm == NULL) {
+        return 0;
+    }
+    if (fscanf(statm, "%lu %lu", &size, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(statm);
+    return (uint64_t)resident * (uint64_t)sysconf(_SC_PAGESIZE);
+}
+
+const MemPool* memPoolList(void) {
+    return __atomic_load_n(&pools, __ATOMIC_ACQUIRE);
+}
+
+void memPoolCollectMetrics(StrBuf *out, void *ctx) {
+    struct rusage usage;
+    (void)ctx;
+
+    metricsHeader(out, "watchdog_build_profile", "gauge", "Build profile the service was compiled with");
+    strbufAppendf(out, "watchdog_build_profile{profile=\"%s\"} 1\n", profileName);
+    metricsHeader(out, "watchdog_memory_resident_bytes", "gauge", "Resident set size of the process");
+    strbufAppendf(out, "watchdog_memory_resident_bytes %llu\n", (unsigned long long)memPoolResidentBytes());
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        metricsHeader(out, "watchdog_memory_resident_peak_bytes", "gauge", "Largest resident set size so far");
+        strbufAppendf(out, "watchdog_memory_resident_peak_bytes %llu\n", (unsigned long long)usage.ru_maxrss * 1024ull);
+    }
+
+    metricsHeader(out, "watchdog_mem_pool_blocks", "gauge", "Blocks of each fixed pool, 0 = taken from the heap");
+    for (MemPool *pool = __atomic_load_n(&pools, __ATOMIC_ACQUIRE); pool != NULL; pool = pool->next) {
+        strbufAppendf(out, "watchdog_mem_pool_blocks{pool=\"%s\"} %u\n", pool->name, pool->storage ? pool->blocks : 0);
+    }
+    metricsHeader(out, "watchdog_mem_pool_in_use", "gauge", "Blocks currently handed out");
+    for (MemPool *pool = __atomic_load_n(&pools, __ATOMIC_ACQUIRE); pool != NULL; pool = pool->next) {
+        strbufAppendf(out, "watchdog_mem_pool_in_use{pool=\"%s\"} %llu\n", pool->name,
+                      (unsigned long long)__atomic_load_n(&pool->inUse, __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_mem_pool_peak", "gauge", "Most blocks handed out at once");
+    for (MemPool *pool = __atomic_load_n(&pools, __ATOMIC_ACQUIRE); pool != NULL; pool = pool->next) {
+        strbufAppendf(out, "watchdog_mem_pool_peak{pool=\"%s\"} %llu\n", pool->name,
+                      (unsigned long long)__atomic_load_n(&pool->peak, __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_mem_pool_exhausted_total", "counter", "Allocations refused because the pool was empty");
+    for (MemPool *pool = __atomic_load_n(&pools, __ATOMIC_ACQUIRE); pool != NULL; pool = pool->next) {
+        strbufAppendf(out, "watchdog_mem_pool_exhausted_total{pool=\"%s\"} %llu\n", pool->name,
+                      (unsigned long long)__atomic_load_n(&pool->exhausted, __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_memory_growth_refused_total", "counter",
+                  "Snapshot buffers that needed more than the space reserved at startup");
+    strbufAppendf(out, "watchdog_memory_growth_refused_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&refusals, __ATOMIC_RELAXED));
+}
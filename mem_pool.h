@@ -0,0 +1,63 @@
+#ifndef MEM_POOL_H
+#define MEM_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "build_profile.h"
+#include "strbuf.h"
+
+#define MEM_POOL_MAX_BLOCKS 64       // Free blocks are tracked in one bitmask
+
+// Fixed-size blocks for buffers a request or a stream needs while it runs.
+// With WATCHDOG_NO_HEAP the blocks are static storage handed out lock-free
+// from a bitmask, so nothing is allocated after startup and a request that
+// finds the pool empty fails instead; otherwise they come from malloc(). The
+// call sites are the same in both builds, and in both the pools report how
+// many blocks are in use.
+typedef struct MemPool {
+    const char *name;
+    size_t blockSize;
+    uint32_t blocks;
+    unsigned char *storage;          // NULL when blocks come from the heap
+    uint64_t freeMask;               // Bit per free block of storage
+    uint64_t inUse;
+    uint64_t peak;
+    uint64_t exhausted;              // Allocations refused
+    struct MemPool *next;            // Collector list, linked on first use
+    bool listed;
+} MemPool;
+
+#define MEM_POOL_BLOCK(size) (((size) + 63) & ~(size_t)63)
+#define MEM_POOL_MASK(count) ((count) >= 64 ? UINT64_MAX : (1ull << (count)) - 1)
+
+// Defines a static pool of count blocks of size bytes (count at most 64);
+// heap pools take any size and ignore both
+#ifdef WATCHDOG_NO_HEAP
+#define MEM_POOL_DEFINE(var, label, size, count) \
+    static unsigned char var##Storage[(count) * MEM_POOL_BLOCK(size)] __attribute__((aligned(64))); \
+    static MemPool var = { label, MEM_POOL_BLOCK(size), (count), var##Storage, MEM_POOL_MASK(count), 0, 0, 0, NULL, false }
+#else
+#define MEM_POOL_DEFINE(var, label, size, count) \
+    static MemPool var = { label, SIZE_MAX, 0, NULL, 0, 0, 0, 0, NULL, false }
+#endif
+
+// A block of at least size bytes (uninitialized), NULL when the pool is
+// exhausted or its blocks are smaller
+void* memPoolAlloc(MemPool *pool, size_t size);
+void memPoolFree(MemPool *pool, void *block);
+// Whether block was handed out by pool (always false for heap pools)
+bool memPoolOwns(const MemPool *pool, const void *block);
+
+// Heap growth refused by a no-heap build elsewhere (snapshots)
+void memPoolRecordRefusal(void);
+
+// Every pool that has been used, linked through next
+const MemPool* memPoolList(void);
+// Resident set of the process, from /proc/self/statm
+uint64_t memPoolResidentBytes(void);
+
+// Pool usage, the build profile and the process resident set
+void memPoolCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // MEM_POOL_H
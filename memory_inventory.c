@@ -0,0 +1,496 @@
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "memory_inventory.h"
+#include "Susi4.h"
+#include "crc32c.h"
+#include "hw_actor.h"
+#include "json_writer.h"
+#include "metrics.h"
+#include "snapshot.h"
+#include "susi_device.h"
+#include "susi_timing.h"
+#include "timeutil.h"
+
+// From SUSIDeviceDEMO/SDRAMDEMO/SPD.h
+#define SPD_ID_BASE                     0x00A00000
+#define SPD_ID_DRAM_QTY                 ((SusiId_t)(SPD_ID_BASE + 0x00))
+#define SPD_ID_DRAM(n, offset)          ((SusiId_t)(SPD_ID_BASE + (((n) << 8) & 0xF00) + (offset)))
+#define SPD_DRAM_TYPE                   0x01
+#define SPD_DRAM_MODULETYPE             0x02
+#define SPD_DRAM_SIZE                   0x03
+#define SPD_DRAM_SPEED                  0x04
+#define SPD_DRAM_RANK                   0x05
+#define SPD_DRAM_VOLTAGE                0x06
+#define SPD_DRAM_BANK                   0x07
+#define SPD_DRAM_WEEKYEAR               0x08
+#define SPD_DRAM_WRITEPROTECTION        0x0A
+#define SPD_DRAM_MANUFACTURE            0x0B
+#define SPD_DRAM_DRAMIC                 0x0C
+#define SPD_DRAM_PARTNUMBER1            0x11    // Through PARTNUMBER5
+#define SPD_DRAM_SPECIFICDATA1          0x21    // Through SPECIFICDATA8
+
+#define SPD_TYPE_DDR3                   0x0B
+#define SPD_TYPE_DDR4                   0x0C
+#define SPD_TYPE_DDR5                   0x12
+
+// Numbered registers of a module and where they go
+static const struct {
+    uint32_t offset;
+    MemoryField field;
+    size_t member;
+} spdValues[] = {
+    { SPD_DRAM_TYPE, MEMORY_FIELD_TYPE, offsetof(MemoryModule, type) },
+    { SPD_DRAM_MODULETYPE, MEMORY_FIELD_MODULE_TYPE, offsetof(MemoryModule, moduleType) },
+    { SPD_DRAM_SIZE, MEMORY_FIELD_SIZE, offsetof(MemoryModule, sizeGb) },
+    { SPD_DRAM_SPEED, MEMORY_FIELD_SPEED, offsetof(MemoryModule, speedMts) },
+    { SPD_DRAM_RANK, MEMORY_FIELD_RANK, offsetof(MemoryModule, rank) },
+    { SPD_DRAM_BANK, MEMORY_FIELD_BANK, offsetof(MemoryModule, bank) },
+    { SPD_DRAM_VOLTAGE, MEMORY_FIELD_VOLTAGE, offsetof(MemoryModule, voltageMv) },
+    { SPD_DRAM_WEEKYEAR, MEMORY_FIELD_WEEK_YEAR, offsetof(MemoryModule, weekYear) },
+    { SPD_DRAM_MANUFACTURE, MEMORY_FIELD_MANUFACTURER, offsetof(MemoryModule, manufacturer) },
+    { SPD_DRAM_DRAMIC, MEMORY_FIELD_DRAM_MANUFACTURER, offsetof(MemoryModule, dramManufacturer) },
+};
+#define SPD_VALUE_COUNT (sizeof(spdValues) / sizeof(spdValues[0]))
+
+static const struct {
+    uint32_t code;
+    const char *name;
+} typeNames[] = {
+    { 0x00, "Reserved" }, { 0x01, "Standard FPM DRAM" }, { 0x02, "EDO" }, { 0x03, "Pipelined Nibble" },
+    { 0x04, "SDRAM" }, { 0x05, "ROM" }, { 0x06, "DDR SGRAM" }, { 0x07, "DDR SDRAM" },
+    { 0x08, "DDR2 SDRAM" }, { 0x09, "DDR2 SDRAM FB-DIMM" }, { 0x0A, "DDR2 SDRAM FB-DIMM PROBE" },
+    { SPD_TYPE_DDR3, "DDR3 SDRAM" }, { SPD_TYPE_DDR4, "DDR4 SDRAM" }, { SPD_TYPE_DDR5, "DDR5 SDRAM" },
+};
+
+static const char *ddr3ModuleNames[] = {
+    "Undefined", "RDIMM", "UDIMM", "SO-DIMM", "Micro-DIMM", "Mini-RDIMM", "Mini-UDIMM", "Mini-CDIMM",
+    "72b-SO-UDIMM", "72b-SO-RDIMM", "72b-SO-CDIMM", "LRDIMM",
+};
+
+static const char *ddr4ModuleNames[] = {
+    "Undefined", "RDIMM", "UDIMM", "SO-DIMM", "LRDIMM", "Mini-RDIMM", "Mini-UDIMM", "Reserved",
+    "72b-SO-RDIMM", "72b-SO-UDIMM", "Reserved", "Reserved", "16b-SO-DIMM", "32b-SO-DIMM", "Reserved", "Reserved",
+};
+
+static const char *ddr5ModuleNames[] = {
+    "Undefined", "RDIMM", "UDIMM", "SO-DIMM", "LRDIMM", "Undefined", "Undefined", "MRDIMM",
+    "Undefined", "Undefined", "DDIMM", "Solder down", "Reserved", "Reserved", "Reserved", "Reserved",
+};
+
+// The module and DRAM makers seen on these boards, codes as in
+// SDRAMDEMO's JEP106 table; the rest are reported by code
+static const struct {
+    uint32_t code;
+    const char *name;
+} makerNames[] = {
+    { 0xC88A, "Advantech Co Ltd" }, { 0xCE80, "Samsung" }, { 0xAD80, "SK Hynix" },
+    { 0x2C80, "Micron Technology" }, { 0x0B83, "Nanya Technology" }, { 0x918A, "ChangXin Memory Technologies Inc" },
+    { 0x9801, "Kingston" }, { 0x9B85, "Crucial Technology" }, { 0x9401, "Smart Modular" },
+    { 0x4F01, "Transcend Information" }, { 0xF186, "InnoDisk Corporation" }, { 0x7A01, "Apacer Technology" },
+    { 0xDA83, "Swissbit" }, { 0x4304, "Ramaxel Technology" }, { 0xDA80, "Winbond Electronic" },
+    { 0xFE02, "Elpida" },
+};
+
+// Cache file: header, then header.count modules. The CRC covers both
+// with the crc field zero.
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t crc;
+    uint32_t reserved;
+    char boardSerial[64];
+} MemoryCacheHeader;
+
+typedef enum {
+    CACHE_UNUSED,
+    CACHE_HIT,
+    CACHE_MISS,                      // No usable file
+    CACHE_STALE                      // A key did not match
+} CacheResult;
+
+static const char *cachePath;
+static MemoryModule modules[MEMORY_MAX_SOCKETS];
+static int moduleCount;
+static char boardSerial[64];
+static uint32_t weekYears[MEMORY_MAX_SOCKETS];
+static bool weekYearValid[MEMORY_MAX_SOCKETS];
+static uint32_t spdReads;
+static uint32_t spdReadErrors;
+static CacheResult cacheResult;
+static bool cacheWriteFailed;
+static Snapshot memorySnapshot;
+static bool snapshotLive;
+
+void memoryInventorySetCache(const char *path) {
+    cachePath = path;
+}
+
+const char* memoryTypeName(uint32_t type) {
+    for (size_t i = 0; i < sizeof(typeNames) / sizeof(typeNames[0]); i++) {
+        if (typeNames[i].code == type) {
+            return typeNames[i].name;
+        }
+    }
+    return "Unknown";
+}
+
+const char* memoryModuleTypeName(uint32_t type, uint32_t moduleType) {
+    switch (type) {
+    case SPD_TYPE_DDR3:
+        return moduleType < sizeof(ddr3ModuleNames) / sizeof(ddr3ModuleNames[0]) ? ddr3ModuleNames[moduleType] : "Unknown";
+    case SPD_TYPE_DDR4:
+        return moduleType < sizeof(ddr4ModuleNames) / sizeof(ddr4ModuleNames[0]) ? ddr4ModuleNames[moduleType] : "Unknown";
+    case SPD_TYPE_DDR5:
+        return moduleType < sizeof(ddr5ModuleNames) / sizeof(ddr5ModuleNames[0]) ? ddr5ModuleNames[moduleType] : "Unknown";
+    default:
+        return "Unknown";
+    }
+}
+
+const char* memoryManufacturerName(uint32_t code) {
+    for (size_t i = 0; i < sizeof(makerNames) / sizeof(makerNames[0]); i++) {
+        if (makerNames[i].code == (code & 0xffff)) {
+            return makerNames[i].name;
+        }
+    }
+    return NULL;
+}
+
+static bool readSpd(SusiId_t id, uint32_t *value) {
+    spdReads++;
+    if (susiDeviceGetValue(id, value) != SUSI_STATUS_SUCCESS) {
+        spdReadErrors++;
+        return false;
+    }
+    return true;
+}
+
+// Registers of four characters each, most significant first
+static bool readSpdString(uint32_t socket, uint32_t firstOffset, int count, char *out) {
+    size_t length = 0;
+
+    for (int i = 0; i < count; i++) {
+        uint32_t value;
+
+        if (!readSpd(SPD_ID_DRAM(socket, firstOffset + (uint32_t)i), &value)) {
+            break;
+        }
+        for (int shift = 24; shift >= 0 && length + 1 < MEMORY_STRING_MAX; shift -= 8) {
+            char c = (char)(value >> shift);
+
+            if (c >= 0x20 && c < 0x7f) {
+                out[length++] = c;
+            }
+        }
+    }
+    while (length > 0 && out[length - 1] == ' ') {
+        length--;
+    }
+    out[length] = '\0';
+    return length > 0;
+}
+
+static void hwDecodeModule(void *arg) {
+    MemoryModule *module = arg;
+
+    for (size_t i = 0; i < SPD_VALUE_COUNT; i++) {
+        if (readSpd(SPD_ID_DRAM(module->socket, spdValues[i].offset),
+                    (uint32_t*)((char*)module + spdValues[i].member))) {
+            module->valid |= spdValues[i].field;
+        }
+    }
+    if (readSpdString(module->socket, SPD_DRAM_PARTNUMBER1, 5, module->partNumber)) {
+        module->valid |= MEMORY_FIELD_PART_NUMBER;
+    }
+    // Specific data and write protection are Advantech's, told by the part number
+    if (strncmp(module->partNumber, "SQR-", 4) != 0) {
+        return;
+    }
+    if (readSpdString(module->socket, SPD_DRAM_SPECIFICDATA1, 8, module->specificData)) {
+        module->valid |= MEMORY_FIELD_SPECIFIC_DATA;
+    }
+    if (readSpd(SPD_ID_DRAM(module->socket, SPD_DRAM_WRITEPROTECTION), &module->writeProtect)) {
+        module->writeProtect &= 0xffff;
+        module->valid |= MEMORY_FIELD_WRITE_PROTECT;
+    }
+}
+
+// The cache keys: board serial, socket count and every week-year code
+static void hwReadKeys(void *arg) {
+    uint32_t length = sizeof(boardSerial);
+    uint64_t start = monotonicNowNs();
+    SusiStatus_t status = SusiBoardGetStringA(SUSI_ID_BOARD_SERIAL_STR, boardSerial, &length);
+    uint32_t quantity = 0;
+    (void)arg;
+
+    susiTimingRecord(SUSI_CALL_BOARD_GET_STRING, start, status);
+    if (status != SUSI_STATUS_SUCCESS) {
+        boardSerial[0] = '\0';
+    }
+    boardSerial[sizeof(boardSerial) - 1] = '\0';
+
+    moduleCount = 0;
+    if (!readSpd(SPD_ID_DRAM_QTY, &quantity) || quantity == 0) {
+        return;
+    }
+    moduleCount = quantity < MEMORY_MAX_SOCKETS ? (int)quantity : MEMORY_MAX_SOCKETS;
+    for (int socket = 0; socket < moduleCount; socket++) {
+        weekYearValid[socket] = readSpd(SPD_ID_DRAM(socket, SPD_DRAM_WEEKYEAR), &weekYears[socket]);
+    }
+}
+
+static uint32_t cacheCrc(MemoryCacheHeader *header, const MemoryModule *records) {
+    uint32_t saved = header->crc, crc;
+
+    header->crc = 0;
+    crc = crc32c(0, header, sizeof(*header));
+    crc = crc32c(crc, records, sizeof(MemoryModule) * header->count);
+    header->crc = saved;
+    return crc;
+}
+
+static CacheResult loadCache(void) {
+    MemoryCacheHeader header;
+    MemoryModule records[MEMORY_MAX_SOCKETS];
+    FILE *file = fopen(cachePath, "rb");
+    bool ok;
+
+    if (file == NULL) {
+        return CACHE_MISS;
+    }
+    ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == MEMORY_CACHE_MAGIC &&
+         header.version == MEMORY_CACHE_VERSION && header.count <= MEMORY_MAX_SOCKETS &&
+         fread(records, sizeof(MemoryModule), header.count, file) == header.count &&
+         header.crc == cacheCrc(&header, records);
+    fclose(file);
+    if (!ok) {
+        return CACHE_MISS;
+    }
+    // An empty serial could be any board
+    header.boardSerial[sizeof(header.boardSerial) - 1] = '\0';
+    if (boardSerial[0] == '\0' || strcmp(header.boardSerial, boardSerial) != 0 || (int)header.count != moduleCount) {
+        return CACHE_STALE;
+    }
+    for (int i = 0; i < moduleCount; i++) {
+        if (records[i].socket != (uint32_t)i || !weekYearValid[i] || !(records[i].valid & MEMORY_FIELD_WEEK_YEAR) ||
+            records[i].weekYear != weekYears[i]) {
+            return CACHE_STALE;
+        }
+    }
+    memcpy(modules, records, sizeof(MemoryModule) * (size_t)moduleCount);
+    return CACHE_HIT;
+}
+
+static bool saveCache(void) {
+    MemoryCacheHeader header;
+    char temporary[1024];
+    FILE *file;
+    bool ok;
+
+    if (boardSerial[0] == '\0') {
+        return true;
+    }
+    memset(&header, 0, sizeof(header));
+    header.magic = MEMORY_CACHE_MAGIC;
+    header.version = MEMORY_CACHE_VERSION;
+    header.count = (uint32_t)moduleCount;
+    snprintf(header.boardSerial, sizeof(header.boardSerial), "%s", boardSerial);
+    header.crc = cacheCrc(&header, modules);
+
+    // Written aside and renamed, so a crash never leaves half a file
+    if (snprintf(temporary, sizeof(temporary), "%s.tmp", cachePath) >= (int)sizeof(temporary) ||
+        (file = fopen(temporary, "wb")) == NULL) {
+        return false;
+    }
+    ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+         fwrite(modules, sizeof(MemoryModule), (size_t)moduleCount, file) == (size_t)moduleCount;
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(temporary, cachePath) != 0) {
+        fprintf(stderr, "Memory inventory: cannot write %s: %s\n", cachePath, strerror(errno));
+        remove(temporary);
+        return false;
+    }
+    return true;
+}
+
+static void writeMaker(JsonWriter *writer, const char *key, uint32_t code) {
+    const char *name = memoryManufacturerName(code);
+    char text[8];
+
+    snprintf(text, sizeof(text), "0x%04x", code & 0xffff);
+    jsonKey(writer, key);
+    jsonBeginObject(writer);
+    jsonFieldString(writer, "code", text);
+    if (name != NULL) {
+        jsonFieldString(writer, "name", name);
+    }
+    jsonEndObject(writer);
+}
+
+static void renderMemory(StrBuf *out) {
+    static const char *sources[] = { "spd", "cache", "spd", "spd" };
+    JsonWriter writer;
+    uint32_t totalGb = 0;
+    char text[16];
+
+    jsonWriterInit(&writer, out);
+    jsonBeginObject(&writer);
+    jsonFieldString(&writer, "source", sources[cacheResult]);
+    jsonFieldUint(&writer, "sockets", (uint32_t)moduleCount);
+    jsonKey(&writer, "modules");
+    jsonBeginArray(&writer);
+    for (int i = 0; i < moduleCount; i++) {
+        const MemoryModule *module = &modules[i];
+
+        jsonBeginObject(&writer);
+        jsonFieldUint(&writer, "socket", module->socket + 1);
+        if (module->valid & MEMORY_FIELD_TYPE) {
+            jsonFieldString(&writer, "type", memoryTypeName(module->type));
+            if (module->valid & MEMORY_FIELD_MODULE_TYPE) {
+                jsonFieldString(&writer, "module_type", memoryModuleTypeName(module->type, module->moduleType));
+            }
+        }
+        if (module->valid & MEMORY_FIELD_SIZE) {
+            jsonFieldUint(&writer, "size_gb", module->sizeGb);
+            totalGb += module->sizeGb;
+        }
+        if (module->valid & MEMORY_FIELD_SPEED) {
+            jsonFieldUint(&writer, "speed_mts", module->speedMts);
+        }
+        if (module->valid & MEMORY_FIELD_RANK) {
+            jsonFieldUint(&writer, "rank", module->rank);
+        }
+        if (module->valid & MEMORY_FIELD_BANK) {
+            jsonFieldUint(&writer, "bank", module->bank);
+        }
+        if (module->valid & MEMORY_FIELD_VOLTAGE) {
+            jsonFieldDouble(&writer, "voltage", module->voltageMv / 1000.0, 3);
+        }
+        if (module->valid & MEMORY_FIELD_WEEK_YEAR) {
+            snprintf(text, sizeof(text), "%02x-%02x", (module->weekYear >> 8) & 0xff, module->weekYear & 0xff);
+            jsonFieldString(&writer, "week_year", text);
+        }
+        if (module->valid & MEMORY_FIELD_MANUFACTURER) {
+            writeMaker(&writer, "manufacturer", module->manufacturer);
+        }
+        if (module->valid & MEMORY_FIELD_DRAM_MANUFACTURER) {
+            writeMaker(&writer, "dram_manufacturer", module->dramManufacturer);
+        }
+        if (module->valid & MEMORY_FIELD_PART_NUMBER) {
+            jsonFieldString(&writer, "part_number", module->partNumber);
+        }
+        if (module->valid & MEMORY_FIELD_SPECIFIC_DATA) {
+            jsonFieldString(&writer, "specific_data", module->specificData);
+        }
+        if (module->valid & MEMORY_FIELD_WRITE_PROTECT) {
+            jsonFieldString(&writer, "write_protect", module->writeProtect == 0x5750 ? "enabled" :
+                            module->writeProtect == 0 ? "disabled" : "unknown");
+        }
+        jsonEndObject(&writer);
+    }
+    jsonEndArray(&writer);
+    jsonFieldUint(&writer, "total_gb", totalGb);
+    jsonEndObject(&writer);
+    strbufAppendChar(out, '\n');
+}
+
+static bool publishMemory(void) {
+    StrBuf out;
+    size_t capacity;
+    char *data = snapshotBegin(&memorySnapshot, &capacity);
+
+    while (data != NULL) {
+        strbufInit(&out, data, capacity);
+        renderMemory(&out);
+        if (!out.overflow) {
+            return snapshotPublish(&memorySnapshot, out.length);
+        }
+        if (!snapshotGrow(&memorySnapshot, capacity * 2)) {
+            snapshotAbort(&memorySnapshot);
+            return false;
+        }
+        data = snapshotBegin(&memorySnapshot, &capacity);
+    }
+    return false;
+}
+
+bool memoryInventoryInit(void) {
+    if (snapshotLive || !susiDeviceOpen()) {
+        return false;
+    }
+    if (!hwActorCall(HW_LANE_READ, hwReadKeys, NULL) || moduleCount == 0) {
+        susiDeviceClose();
+        return false;
+    }
+    cacheResult = cachePath != NULL ? loadCache() : CACHE_UNUSED;
+    if (cacheResult != CACHE_HIT) {
+        for (int i = 0; i < moduleCount; i++) {
+            memset(&modules[i], 0, sizeof(modules[i]));
+            modules[i].socket = (uint32_t)i;
+            // A busy read lane leaves the socket empty rather than holding up startup
+            hwActorCall(HW_LANE_READ, hwDecodeModule, &modules[i]);
+        }
+        if (cachePath != NULL) {
+            cacheWriteFailed = !saveCache();
+        }
+    }
+    // Nothing more is read from SPD
+    susiDeviceClose();
+
+    if (!snapshotInit(&memorySnapshot, MEMORY_SNAPSHOT_CAPACITY, "application/json", "memory")) {
+        return false;
+    }
+    snapshotLive = true;
+    publishMemory();
+    printf("Memory inventory: %d sockets, %u SPD reads%s\n", moduleCount, spdReads,
+           cacheResult == CACHE_HIT ? " (cached)" : "");
+    return true;
+}
+
+void memoryInventoryDestroy(void) {
+    if (snapshotLive) {
+        snapshotLive = false;
+        snapshotDestroy(&memorySnapshot);
+    }
+}
+
+int memoryInventoryModules(const MemoryModule **out) {
+    *out = modules;
+    return snapshotLive ? moduleCount : 0;
+}
+
+enum MHD_Result memoryInventoryQueueResponse(struct MHD_Connection *connection) {
+    if (!snapshotLive) {
+        return MHD_NO;
+    }
+    return snapshotQueue(&memorySnapshot, connection);
+}
+
+void memoryInventoryCollectMetrics(StrBuf *out, void *ctx) {
+    static const char *results[] = { "unused", "hit", "miss", "stale" };
+    (void)ctx;
+
+    if (!snapshotLive) {
+        return;
+    }
+    metricsHeader(out, "watchdog_memory_module_gigabytes", "gauge", "Memory module size by socket, from SPD");
+    for (int i = 0; i < moduleCount; i++) {
+        if (modules[i].valid & MEMORY_FIELD_SIZE) {
+            strbufAppendf(out, "watchdog_memory_module_gigabytes{socket=\"%u\",type=\"%s\"} %u\n", modules[i].socket + 1,
+                          memoryTypeName(modules[i].type), modules[i].sizeGb);
+        }
+    }
+    metricsHeader(out, "watchdog_memory_spd_reads_total", "counter", "SPD registers read at startup");
+    strbufAppendf(out, "watchdog_memory_spd_reads_total %u\n", spdReads);
+    metricsHeader(out, "watchdog_memory_spd_read_errors_total", "counter", "SPD registers that could not be read");
+    strbufAppendf(out, "watchdog_memory_spd_read_errors_total %u\n", spdReadErrors);
+    metricsHeader(out, "watchdog_memory_cache", "gauge", "1 for how the inventory cache was used at startup");
+    strbufAppendf(out, "watchdog_memory_cache{result=\"%s\"} 1\n", results[cacheResult]);
+    if (cachePath != NULL) {
+        metricsHeader(out, "watchdog_memory_cache_write_failed", "gauge", "1 if the inventory cache could not be written");
+        strbufAppendf(out, "watchdog_memory_cache_write_failed %d\n", cacheWriteFailed ? 1 : 0);
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef MEMORY_INVENTORY_H
+#define MEMORY_INVENTORY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <microhttpd.h>
+#include "strbuf.h"
+
+#define MEMORY_MAX_SOCKETS 8                 // SPDDEMO_SOCKET_MAX
+#define MEMORY_STRING_MAX 36                 // Part number and specific data, four characters a register
+#define MEMORY_SNAPSHOT_CAPACITY 4096
+#define MEMORY_CACHE_MAGIC 0x3141434450534b41ull  // "AKSPDCA1"
+#define MEMORY_CACHE_VERSION 1
+
+// Memory module inventory for /api/memory, from the SPD of every socket
+// through the optional SUSI device library (susi_device.h). SPD contents
+// cannot change while the machine is up, so each socket is decoded once
+// at startup into a MemoryModule and the body is rendered once into a
+// snapshot that is never written again.
+//
+// With a cache file the decoded modules also survive reboots. SPD has no
+// module serial number, so the cache is keyed by the board serial, the
+// socket count and each socket's week-year code: one board read and one
+// SPD read per socket instead of two dozen. On any mismatch every socket
+// is decoded again and the file rewritten.
+
+typedef enum {
+    MEMORY_FIELD_TYPE = 1u << 0,
+    MEMORY_FIELD_MODULE_TYPE = 1u << 1,
+    MEMORY_FIELD_SIZE = 1u << 2,
+    MEMORY_FIELD_SPEED = 1u << 3,
+    MEMORY_FIELD_RANK = 1u << 4,
+    MEMORY_FIELD_BANK = 1u << 5,
+    MEMORY_FIELD_VOLTAGE = 1u << 6,
+    MEMORY_FIELD_WEEK_YEAR = 1u << 7,
+    MEMORY_FIELD_MANUFACTURER = 1u << 8,
+    MEMORY_FIELD_DRAM_MANUFACTURER = 1u << 9,
+    MEMORY_FIELD_PART_NUMBER = 1u << 10,
+    MEMORY_FIELD_SPECIFIC_DATA = 1u << 11,   // Advantech modules only
+    MEMORY_FIELD_WRITE_PROTECT = 1u << 12    // Advantech modules only
+} MemoryField;
+
+typedef struct {
+    uint32_t socket;                 // 0-based, as in SPD_ID_DRAM_SOCKET(n)
+    uint32_t valid;                  // MemoryField bits that were read
+    uint32_t type;                   // SPD_ID_DRAM_TYPE code, see memoryTypeName()
+    uint32_t moduleType;             // Per type, see memoryModuleTypeName()
+    uint32_t sizeGb;
+    uint32_t speedMts;
+    uint32_t rank;
+    uint32_t bank;
+    uint32_t voltageMv;
+    uint32_t weekYear;               // BCD week << 8 | BCD year
+    uint32_t manufacturer;           // JEP106 code, as in SDRAMDEMO
+    uint32_t dramManufacturer;
+    uint32_t writeProtect;           // 0x5750 enabled, 0 disabled
+    char partNumber[MEMORY_STRING_MAX];
+    char specificData[MEMORY_STRING_MAX];
+} MemoryModule;
+
+// Before memoryInventoryInit(); NULL keeps nothing on disk
+void memoryInventorySetCache(const char *path);
+// Decode every socket, or take them from the cache, and publish the body
+// (after hwActorStart). False without SPD.
+bool memoryInventoryInit(void);
+// Release the snapshot once no response can reference it (after MHD stopped)
+void memoryInventoryDestroy(void);
+
+// Decoded modules, up to MEMORY_MAX_SOCKETS; 0 before init
+int memoryInventoryModules(const MemoryModule **modules);
+
+const char* memoryTypeName(uint32_t type);
+const char* memoryModuleTypeName(uint32_t type, uint32_t moduleType);
+// NULL for makers outside the short table; the code is reported instead
+const char* memoryManufacturerName(uint32_t code);
+
+enum MHD_Result memoryInventoryQueueResponse(struct MHD_Connection *connection);
+void memoryInventoryCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // MEMORY_INVENTORY_H
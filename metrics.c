@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "metrics.h"
+#include "snapshot.h"
+
+#ifndef METRICS_INITIAL_CAPACITY
+#define METRICS_INITIAL_CAPACITY 16384
+#endif
+#define METRICS_MAX_CAPACITY (1024 * 1024)
+
+typedef struct {
+    MetricsCollector collector;
+    void *ctx;
+} MetricsCollectorEntry;
+
+static MetricsCollectorEntry collectors[METRICS_MAX_COLLECTORS];
+static int collectorCount = 0;
+
+static Snapshot metricsSnapshot;
+static pthread_t metricsThread;
+static pthread_mutex_t metricsLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t metricsCond = PTHREAD_COND_INITIALIZER;
+static bool metricsRunning = false;
+static uint32_t metricsIntervalMs = DEFAULT_METRICS_INTERVAL_MS;
+static uint64_t renderCount = 0;
+static uint64_t renderSkipped = 0;
+static double lastRenderSeconds = 0.0;
+
+// Collectors must be registered before metricsStart()
+bool metricsRegisterCollector(MetricsCollector collector, void *ctx) {
+    if (collectorCount >= METRICS_MAX_COLLECTORS) {
+        return false;
+    }
+    collectors[collectorCount].collector = collector;
+    collectors[collectorCount].ctx = ctx;
+    collectorCount++;
+    return true;
+}
+
+void metricsHeader(StrBuf *out, const char *name, const char *type, const char *help) {
+    strbufAppendf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static double monotonicSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void renderSelf(StrBuf *out) {
+    metricsHeader(out, "watchdog_metrics_renders_total", "counter", "Number of /metrics snapshots rendered");
+    strbufAppendf(out, "watchdog_metrics_renders_total %llu\n", (unsigned long long)renderCount);
+    metricsHeader(out, "watchdog_metrics_renders_skipped_total", "counter", "Renders skipped because all buffers were in use");
+    strbufAppendf(out, "watchdog_metrics_renders_skipped_total %llu\n", (unsigned long long)renderSkipped);
+    metricsHeader(out, "watchdog_metrics_render_seconds", "gauge", "Time taken by the previous render");
+    strbufAppendf(out, "watchdog_metrics_render_seconds %.6f\n", lastRenderSeconds);
+}
+
+// Render all collectors into an idle snapshot buffer and publish it
+static void metricsRender(void) {
+    StrBuf out;
+    size_t capacity;
+    char *data;
+    double start = monotonicSeconds();
+    
+    data = snapshotBegin(&metricsSnapshot, &capacity);
+    if (data == NULL) {
+        renderSkipped++;
+        return;
+    }
+    
+    for (;;) {
+        strbufInit(&out, data, capacity);
+        for (int i = 0; i < collectorCount; i++) {
+            collectors[i].collector(&out, collectors[i].ctx);
+        }
+        renderSelf(&out);
+        if (!out.overflow) {
+            break;
+        }
+        // Output outgrew the buffer: enlarge it and render again
+        if (capacity * 2 > METRICS_MAX_CAPACITY || !snapshotGrow(&metricsSnapshot, capacity * 2)) {
+            printf("Metrics output exceeds %zu bytes, snapshot not updated\n", capacity);
+            snapshotAbort(&metricsSnapshot);
+            return;
+        }
+        data = snapshotBegin(&metricsSnapshot, &capacity);
+        if (data == NULL) {
+            return;
+        }
+    }
+    
+    if (snapshotPublish(&metricsSnapshot, out.length)) {
+        renderCount++;
+    }
+    lastRenderSeconds = monotonicSeconds() - start;
+}
+
+static void* metricsThreadMain(void *arg) {
+    struct timespec deadline;
+    (void)arg;
+    
+    pthread_setname_np(pthread_self(), "metrics");
+    pthread_mutex_lock(&metricsLock);
+    while (metricsRunning) {
+        pthread_mutex_unlock(&metricsLock);
+        metricsRender();
+        pthread_mutex_lock(&metricsLock);
+        
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += metricsIntervalMs / 1000;
+        deadline.tv_nsec += (long)(metricsIntervalMs % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (metricsRunning) {
+            if (pthread_cond_timedwait(&metricsCond, &metricsLock, &deadline) != 0) {
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&metricsLock);
+    return NULL;
+}
+
+bool metricsStart(uint32_t intervalMs) {
+    if (!snapshotInit(&metricsSnapshot, METRICS_INITIAL_CAPACITY,
+                      "text/plain; version=0.0.4; charset=utf-8", "metrics")) {
+        return false;
+    }
+    metricsIntervalMs = intervalMs > 0 ? intervalMs : DEFAULT_METRICS_INTERVAL_MS;
+    
+    // Render once synchronously so the first scrape already has data
+    metricsRender();
+    
+    metricsRunning = true;
+    if (pthread_create(&metricsThread, NULL, metricsThreadMain, NULL) != 0) {
+        metricsRunning = false;
+        snapshotDestroy(&metricsSnapshot);
+        return false;
+    }
+    return true;
+}
+
+void metricsStop(void) {
+    pthread_mutex_lock(&metricsLock);
+    if (!metricsRunning) {
+        pthread_mutex_unlock(&metricsLock);
+        return;
+    }
+    metricsRunning = false;
+    pthread_cond_signal(&metricsCond);
+    pthread_mutex_unlock(&metricsLock);
+    
+    pthread_join(metricsThread, NULL);
+    snapshotDestroy(&metricsSnapshot);
+}
+
+enum MHD_Result metricsQueueResponse(struct MHD_Connection *connection) {
+    return snapshotQueue(&metricsSnapshot, connection);
+}
@@ -0,0 +1,28 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <microhttpd.h>
+#include "strbuf.h"
+
+#define DEFAULT_METRICS_INTERVAL_MS 1000
+#define METRICS_MAX_COLLECTORS 64
+
+// A collector appends Prometheus text exposition lines for one subsystem.
+// Collectors run on the metrics updater thread, never on a request thread.
+typedef void (*MetricsCollector)(StrBuf *out, void *ctx);
+
+bool metricsRegisterCollector(MetricsCollector collector, void *ctx);
+
+// Start/stop the background thread that re-renders the /metrics snapshot
+bool metricsStart(uint32_t intervalMs);
+void metricsStop(void);
+
+// Serve the latest rendered snapshot
+enum MHD_Result metricsQueueResponse(struct MHD_Connection *connection);
+
+// Helpers for collectors
+void metricsHeader(StrBuf *out, const char *name, const char *type, const char *help);
+
+#endif // METRICS_H
@@ -0,0 +1,897 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include "mqtt_bridge.h"
+#include "events.h"
+#include "histogram.h"
+#include "json_writer.h"
+#include "metrics.h"
+#include "timeutil.h"
+
+#define MQTT_POLL_MS 100
+#define MQTT_TIMEOUT_MS 5000         // Connect, then CONNACK
+#define MQTT_RETRY_MIN_MS 1000
+#define MQTT_RETRY_MAX_MS 30000
+#define MQTT_STOP_GRACE_MS 1000
+#define MQTT_MIN_BATCH_BYTES 1024
+#define MQTT_BATCH_TRAILER 48        // Room kept for ],"missed":N} in either encoding
+#define MQTT_HEADER_MAX 5            // Packet type and remaining length
+
+#define MQTT_CONNECT 0x10
+#define MQTT_CONNACK 0x20
+#define MQTT_PUBLISH_QOS1 0x32
+#define MQTT_PUBLISH_DUP 0x08
+#define MQTT_PUBACK 0x40
+#define MQTT_PINGREQ 0xc0
+#define MQTT_PINGRESP 0xd0
+#define MQTT_DISCONNECT 0xe0
+
+typedef enum {
+    SLOT_QUEUED,
+    SLOT_INFLIGHT,
+    SLOT_ACKED,
+} SlotState;
+
+typedef struct {
+    char *data;
+    uint32_t length;
+    uint16_t packetId;
+    uint8_t state;
+    bool dup;                    // Already sent over a connection that was lost
+    uint64_t sentNs;
+} SpoolSlot;
+
+typedef enum {
+    LINK_DOWN,
+    LINK_CONNECTING,             // TCP connect in progress
+    LINK_HANDSHAKE,              // CONNECT sent, waiting for CONNACK
+    LINK_UP,
+} LinkState;
+
+static char brokerHost[128];
+static char brokerPort[8];
+static char topic[256];
+static uint32_t intervalMs = MQTT_DEFAULT_INTERVAL_MS;
+static uint32_t batchBytes = MQTT_DEFAULT_BATCH_BYTES;
+static uint32_t window = MQTT_DEFAULT_WINDOW;
+static bool useCbor = false;
+static char spoolPath[256];
+static char hostname[64];
+
+static pthread_t bridgeThread;
+static bool bridgeActive = false;
+static bool stopping = false;
+static int stopFd = -1;
+static uint64_t startNext = 0;
+
+// Batches in order: [spoolHead, sendNext) were sent and are in flight or
+// acknowledged, [sendNext, spoolTail) wait. Only the bridge thread touches it.
+static SpoolSlot spool[MQTT_SPOOL_BATCHES];
+static char *spoolData = NULL;
+static uint64_t spoolHead = 0;
+static uint64_t spoolTail = 0;
+static uint64_t sendNext = 0;
+static uint32_t inflight = 0;
+
+// Overflow file: length-prefixed batches newer than everything in memory,
+// read from fileRead on
+static int spoolFd = -1;
+static uint64_t fileRead = 0;
+static uint64_t fileSize = 0;
+
+static char *batchData = NULL;
+static StrBuf batch;
+static JsonWriter batchWriter;
+static uint32_t batchEvents = 0;
+static uint64_t batchMissed = 0;
+static uint64_t batchOpenedNs = 0;
+
+static int linkFd = -1;
+static LinkState linkState = LINK_DOWN;
+static uint64_t deadlineNs = 0;
+static uint64_t retryAtNs = 0;
+static uint32_t retryMs = MQTT_RETRY_MIN_MS;
+static uint64_t lastTxNs = 0;
+static uint64_t lastRxNs = 0;
+static uint16_t lastPacketId = 0;
+
+static unsigned char *tx = NULL;
+static size_t txCapacity = 0;
+static size_t txLength = 0;
+static size_t txSent = 0;
+static unsigned char rx[256];
+static size_t rxLength = 0;
+static size_t rxSkip = 0;            // Bytes left of a packet too large to keep
+
+static bool connected = false;
+static uint64_t batchesAcked = 0;
+static uint64_t batchesDropped = 0;
+static uint64_t eventsBatched = 0;
+static uint64_t eventsMissed = 0;
+static uint64_t connectsOk = 0;
+static uint64_t connectsFailed = 0;
+static uint64_t spoolDepth = 0;
+static uint64_t spoolFileBytes = 0;
+static uint32_t inflightGauge = 0;
+static Histogram ackLatency;
+
+bool mqttBridgeSetBroker(const char *spec) {
+    size_t hostLength = strcspn(spec, ":");
+    const char *port = spec + hostLength;
+    char *end;
+    unsigned long value = MQTT_DEFAULT_PORT;
+
+    if (bridgeActive || hostLength == 0 || hostLength >= sizeof(brokerHost) || strpbrk(spec, " /\"\\\r\n") != NULL) {
+        return false;
+    }
+    if (*port == ':') {
+        value = strtoul(port + 1, &end, 10);
+        if (end == port + 1 || *end != '\0' || value == 0 || value > 65535) {
+            return false;
+        }
+    }
+    memcpy(brokerHost, spec, hostLength);
+    brokerHost[hostLength] = '\0';
+    snprintf(brokerPort, sizeof(brokerPort), "%lu", value);
+    return true;
+}
+
+bool mqttBridgeSetTopic(const char *value) {
+    if (bridgeActive || value[0] == '\0' || strlen(value) >= sizeof(topic) || strpbrk(value, "+#") != NULL) {
+        return false;
+    }
+    strcpy(topic, value);
+    return true;
+}
+
+bool mqttBridgeSetBatch(uint32_t ms, uint32_t maxBytes) {
+    if (bridgeActive || ms == 0 || maxBytes < MQTT_MIN_BATCH_BYTES || maxBytes > MQTT_MAX_BATCH_BYTES) {
+        return false;
+    }
+    intervalMs = ms;
+    batchBytes = maxBytes;
+    return true;
+}
+
+bool mqttBridgeSetWindow(uint32_t value) {
+    if (bridgeActive || value == 0 || value > MQTT_MAX_WINDOW) {
+        return false;
+    }
+    window = value;
+    return true;
+}
+
+void mqttBridgeSetCbor(bool cbor) {
+    if (!bridgeActive) {
+        useCbor = cbor;
+    }
+}
+
+void mqttBridgeSetSpool(const char *path) {
+    if (!bridgeActive && strlen(path) < sizeof(spoolPath)) {
+        strcpy(spoolPath, path);
+    }
+}
+
+static void publishGauges(void) {
+    __atomic_store_n(&spoolDepth, spoolTail - spoolHead, __ATOMIC_RELAXED);
+    __atomic_store_n(&spoolFileBytes, fileSize - fileRead, __ATOMIC_RELAXED);
+    __atomic_store_n(&inflightGauge, inflight, __ATOMIC_RELAXED);
+}
+
+// Spool
+
+static bool fileAppend(const char *data, uint32_t length) {
+    unsigned char prefix[4] = { length >> 24, length >> 16, length >> 8, length };
+
+    if (spoolFd < 0 || fileSize + sizeof(prefix) + length > MQTT_SPOOL_FILE_MAX) {
+        return false;
+    }
+    if (pwrite(spoolFd, prefix, sizeof(prefix), (off_t)fileSize) != (ssize_t)sizeof(prefix) ||
+        pwrite(spoolFd, data, length, (off_t)(fileSize + sizeof(prefix))) != (ssize_t)length) {
+        // A partial record past fileSize is overwritten by the next append
+        return false;
+    }
+    fileSize += sizeof(prefix) + length;
+    return true;
+}
+
+static void spoolPushSlot(const char *data, uint32_t length) {
+    SpoolSlot *slot = &spool[spoolTail & (MQTT_SPOOL_BATCHES - 1)];
+
+    memcpy(slot->data, data, length);
+    slot->length = length;
+    slot->state = SLOT_QUEUED;
+    slot->dup = false;
+    spoolTail++;
+}
+
+// Keep the order: once anything is in the file, new batches go after it
+static void spoolPush(const char *data, uint32_t length) {
+    if (fileRead == fileSize && spoolTail - spoolHead < MQTT_SPOOL_BATCHES) {
+        spoolPushSlot(data, length);
+    } else if (!fileAppend(data, length)) {
+        __atomic_fetch_add(&batchesDropped, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Move batches from the file into memory as room frees up
+static void spoolRefill(void) {
+    while (fileRead < fileSize && spoolTail - spoolHead < MQTT_SPOOL_BATCHES) {
+        SpoolSlot *slot = &spool[spoolTail & (MQTT_SPOOL_BATCHES - 1)];
+        unsigned char prefix[4];
+        uint32_t length;
+
+        if (pread(spoolFd, prefix, sizeof(prefix), (off_t)fileRead) != (ssize_t)sizeof(prefix)) {
+            break;
+        }
+        length = ((uint32_t)prefix[0] << 24) | ((uint32_t)prefix[1] << 16) | ((uint32_t)prefix[2] << 8) | prefix[3];
+        if (length == 0 || length > batchBytes || fileRead + sizeof(prefix) + length > fileSize ||
+            pread(spoolFd, slot->data, length, (off_t)(fileRead + sizeof(prefix))) != (ssize_t)length) {
+            // Torn tail or a batch larger than this run allows: the rest is lost
+            __atomic_fetch_add(&batchesDropped, 1, __ATOMIC_RELAXED);
+            fileRead = fileSize;
+            break;
+        }
+        slot->length = length;
+        slot->state = SLOT_QUEUED;
+        slot->dup = false;
+        spoolTail++;
+        fileRead += sizeof(prefix) + length;
+    }
+    if (spoolFd >= 0 && fileRead == fileSize && fileSize > 0) {
+        if (ftruncate(spoolFd, 0) == 0) {
+            fileRead = 0;
+            fileSize = 0;
+        }
+    }
+}
+
+// Write everything not yet acknowledged back to the file, oldest first
+static void spoolSave(void) {
+    char path[sizeof(spoolPath) + 4];
+    uint64_t saved = 0;
+    off_t size;
+    bool ok = true;
+    int fd;
+
+    if (spoolFd < 0) {
+        for (uint64_t seq = spoolHead; seq < spoolTail; seq++) {
+            if (spool[seq & (MQTT_SPOOL_BATCHES - 1)].state != SLOT_ACKED) {
+                __atomic_fetch_add(&batchesDropped, 1, __ATOMIC_RELAXED);
+            }
+        }
+        return;
+    }
+
+    snprintf(path, sizeof(path), "%s.tmp", spoolPath);
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        printf("MQTT: cannot write %s: %s\n", path, strerror(errno));
+        return;
+    }
+    for (uint64_t seq = spoolHead; ok && seq < spoolTail; seq++) {
+        SpoolSlot *slot = &spool[seq & (MQTT_SPOOL_BATCHES - 1)];
+        unsigned char prefix[4] = { slot->length >> 24, slot->length >> 16, slot->length >> 8, slot->length };
+
+        if (slot->state == SLOT_ACKED) {
+            continue;
+        }
+        ok = write(fd, prefix, sizeof(prefix)) == (ssize_t)sizeof(prefix) &&
+             write(fd, slot->data, slot->length) == (ssize_t)slot->length;
+    }
+    // Then the part of the old file not yet read back
+    while (ok && fileRead < fileSize) {
+        char chunk[4096];
+        size_t want = fileSize - fileRead < sizeof(chunk) ? fileSize - fileRead : sizeof(chunk);
+        ssize_t got = pread(spoolFd, chunk, want, (off_t)fileRead);
+
+        ok = got > 0 && write(fd, chunk, (size_t)got) == got;
+        fileRead += got > 0 ? (uint64_t)got : 0;
+    }
+    size = lseek(fd, 0, SEEK_CUR);
+    saved = size > 0 ? (uint64_t)size : 0;
+    ok = fsync(fd) == 0 && ok;
+    close(fd);
+    if (!ok || rename(path, spoolPath) != 0) {
+        printf("MQTT: failed to save the spool to %s\n", spoolPath);
+        unlink(path);
+        return;
+    }
+    if (saved > 0) {
+        printf("MQTT: %llu bytes of unsent batches saved to %s\n", (unsigned long long)saved, spoolPath);
+    }
+}
+
+// Batching
+
+static void openBatch(void) {
+    strbufInit(&batch, batchData, batchBytes);
+    if (useCbor) {
+        jsonWriterInitCbor(&batchWriter, &batch);
+    } else {
+        jsonWriterInit(&batchWriter, &batch);
+    }
+    jsonBeginObject(&batchWriter);
+    jsonFieldString(&batchWriter, "host", hostname);
+    jsonKey(&batchWriter, "events");
+    jsonBeginArray(&batchWriter);
+    batchEvents = 0;
+    batchMissed = 0;
+}
+
+static void closeBatch(void) {
+    if (batchEvents == 0 && batchMissed == 0) {
+        return;
+    }
+    jsonEndArray(&batchWriter);
+    jsonFieldUint(&batchWriter, "missed", batchMissed);
+    jsonEndObject(&batchWriter);
+    if (!batch.overflow) {
+        spoolPush(batch.data, (uint32_t)batch.length);
+    }
+    openBatch();
+}
+
+// Append one event; a batch that cannot take it is closed first
+static void batchAdd(uint64_t seq, const Event *event) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        JsonWriter saved = batchWriter;
+        size_t length = batch.length;
+
+        jsonBeginObject(&batchWriter);
+        jsonFieldUint(&batchWriter, "seq", seq);
+        jsonFieldString(&batchWriter, "event", eventName(event->type));
+        eventWriteFields(&batchWriter, event);
+        jsonEndObject(&batchWriter);
+        if (!batch.overflow && batch.length + MQTT_BATCH_TRAILER <= batch.capacity) {
+            if (batchEvents++ == 0) {
+                batchOpenedNs = monotonicNowNs();
+            }
+            __atomic_fetch_add(&eventsBatched, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        batchWriter = saved;
+        batch.length = length;
+        batch.overflow = false;
+        if (batchEvents == 0) {
+            break;
+        }
+        closeBatch();
+    }
+    batchMissed++;
+    __atomic_fetch_add(&eventsMissed, 1, __ATOMIC_RELAXED);
+}
+
+static void drainEvents(uint64_t *next) {
+    uint64_t missed = 0;
+    Event event;
+
+    while (eventsRead(next, &event, &missed)) {
+        // eventsRead advanced past any lost events and then this one
+        batchAdd(*next - 1, &event);
+    }
+    if (missed > 0) {
+        if (batchEvents == 0) {
+            batchOpenedNs = monotonicNowNs();
+        }
+        batchMissed += missed;
+        __atomic_fetch_add(&eventsMissed, missed, __ATOMIC_RELAXED);
+    }
+}
+
+// Packets
+
+static size_t putLength(unsigned char *p, uint32_t length) {
+    size_t n = 0;
+
+    do {
+        unsigned char byte = length & 0x7f;
+        length >>= 7;
+        p[n++] = byte | (length > 0 ? 0x80 : 0);
+    } while (length > 0);
+    return n;
+}
+
+static size_t putString(unsigned char *p, const char *text, size_t length) {
+    p[0] = (unsigned char)(length >> 8);
+    p[1] = (unsigned char)length;
+    memcpy(p + 2, text, length);
+    return 2 + length;
+}
+
+static void queueConnect(void) {
+    char clientId[24];
+    size_t idLength = (size_t)snprintf(clientId, sizeof(clientId), "wd-%s", hostname);
+    uint32_t remaining;
+    unsigned char *p = tx;
+
+    // MQTT 3.1.1 servers need only accept 23 character client IDs
+    if (idLength >= sizeof(clientId)) {
+        idLength = sizeof(clientId) - 1;
+    }
+    remaining = 10 + 2 + (uint32_t)idLength;
+    *p++ = MQTT_CONNECT;
+    p += putLength(p, remaining);
+    p += putString(p, "MQTT", 4);
+    *p++ = 4;                             // Protocol level 3.1.1
+    *p++ = 0x02;                          // Clean session
+    *p++ = MQTT_KEEPALIVE_S >> 8;
+    *p++ = MQTT_KEEPALIVE_S & 0xff;
+    p += putString(p, clientId, idLength);
+    txLength = (size_t)(p - tx);
+    txSent = 0;
+}
+
+static void queuePublish(SpoolSlot *slot) {
+    size_t topicLength = strlen(topic);
+    uint32_t remaining = 2 + (uint32_t)topicLength + 2 + slot->length;
+    unsigned char *p = tx;
+
+    *p++ = MQTT_PUBLISH_QOS1 | (slot->dup ? MQTT_PUBLISH_DUP : 0);
+    p += putLength(p, remaining);
+    p += putString(p, topic, topicLength);
+    *p++ = slot->packetId >> 8;
+    *p++ = slot->packetId & 0xff;
+    memcpy(p, slot->data, slot->length);
+    txLength = (size_t)(p + slot->length - tx);
+    txSent = 0;
+}
+
+static void queueSimple(unsigned char type) {
+    tx[0] = type;
+    tx[1] = 0;
+    txLength = 2;
+    txSent = 0;
+}
+
+// Link
+
+static void linkDown(const char *reason) {
+    if (linkFd >= 0) {
+        close(linkFd);
+        linkFd = -1;
+    }
+    if (linkState == LINK_UP) {
+        printf("MQTT: connection to %s:%s lost (%s)\n", brokerHost, brokerPort, reason);
+    } else {
+        __atomic_fetch_add(&connectsFailed, 1, __ATOMIC_RELAXED);
+    }
+    // Unacknowledged batches go out again, flagged as possible duplicates
+    for (uint64_t seq = spoolHead; seq < sendNext; seq++) {
+        SpoolSlot *slot = &spool[seq & (MQTT_SPOOL_BATCHES - 1)];
+
+        if (slot->state == SLOT_INFLIGHT) {
+            slot->state = SLOT_QUEUED;
+            slot->dup = true;
+        }
+    }
+    sendNext = spoolHead;
+    inflight = 0;
+    txLength = txSent = 0;
+    rxLength = rxSkip = 0;
+    linkState = LINK_DOWN;
+    __atomic_store_n(&connected, false, __ATOMIC_RELAXED);
+    retryAtNs = monotonicNowNs() + (uint64_t)retryMs * 1000000ull;
+    retryMs = retryMs * 2 > MQTT_RETRY_MAX_MS ? MQTT_RETRY_MAX_MS : retryMs * 2;
+}
+
+static void linkStart(uint64_t now) {
+    struct addrinfo hints;
+    struct addrinfo *addresses;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(brokerHost, brokerPort, &hints, &addresses) != 0) {
+        linkDown("resolve");
+        return;
+    }
+    linkFd = socket(addresses->ai_family, addresses->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK, addresses->ai_protocol);
+    if (linkFd < 0) {
+        freeaddrinfo(addresses);
+        linkDown("socket");
+        return;
+    }
+    linkState = LINK_CONNECTING;
+    deadlineNs = now + MQTT_TIMEOUT_MS * 1000000ull;
+    if (connect(linkFd, addresses->ai_addr, addresses->ai_addrlen) == 0) {
+        linkState = LINK_HANDSHAKE;
+        queueConnect();
+    } else if (errno != EINPROGRESS) {
+        freeaddrinfo(addresses);
+        linkDown("connect");
+        return;
+    }
+    freeaddrinfo(addresses);
+}
+
+static void ackPacket(uint16_t packetId, uint64_t now) {
+    for (uint64_t seq = spoolHead; seq < sendNext; seq++) {
+        SpoolSlot *slot = &spool[seq & (MQTT_SPOOL_BATCHES - 1)];
+
+        if (slot->state == SLOT_INFLIGHT && slot->packetId == packetId) {
+            slot->state = SLOT_ACKED;
+            inflight--;
+            histogramRecord(&ackLatency, now - slot->sentNs);
+            __atomic_fetch_add(&batchesAcked, 1, __ATOMIC_RELAXED);
+            break;
+        }
+    }
+    while (spoolHead < sendNext && spool[spoolHead & (MQTT_SPOOL_BATCHES - 1)].state == SLOT_ACKED) {
+        spoolHead++;
+    }
+}
+
+static void handlePacket(unsigned char type, const unsigned char *body, uint32_t length, uint64_t now) {
+    switch (type & 0xf0) {
+    case MQTT_CONNACK:
+        if (linkState != LINK_HANDSHAKE) {
+            break;
+        }
+        if (length < 2 || body[1] != 0) {
+            printf("MQTT: broker refused the connection (code %d)\n", length >= 2 ? body[1] : -1);
+            linkDown("refused");
+            return;
+        }
+        linkState = LINK_UP;
+        retryMs = MQTT_RETRY_MIN_MS;
+        __atomic_store_n(&connected, true, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&connectsOk, 1, __ATOMIC_RELAXED);
+        printf("MQTT: connected to %s:%s, publishing to %s\n", brokerHost, brokerPort, topic);
+        break;
+    case MQTT_PUBACK:
+        if (length >= 2) {
+            ackPacket((uint16_t)(body[0] << 8 | body[1]), now);
+        }
+        break;
+    default:
+        // PINGRESP only refreshes lastRxNs
+        break;
+    }
+}
+
+static void readLink(uint64_t now) {
+    ssize_t received = recv(linkFd, rx + rxLength, sizeof(rx) - rxLength, MSG_DONTWAIT);
+
+    if (received == 0 || (received < 0 && errno != EAGAIN && errno != EINTR)) {
+        linkDown(received == 0 ? "closed by broker" : strerror(errno));
+        return;
+    }
+    if (received < 0) {
+        return;
+    }
+    lastRxNs = now;
+    rxLength += (size_t)received;
+    if (rxSkip > 0) {
+        size_t skip = rxSkip < rxLength ? rxSkip : rxLength;
+        memmove(rx, rx + skip, rxLength - skip);
+        rxLength -= skip;
+        rxSkip -= skip;
+    }
+
+    while (rxLength >= 2 && linkState != LINK_DOWN) {
+        uint32_t length = 0;
+        size_t header = 1;
+        size_t total;
+
+        for (int shift = 0; header < rxLength && header <= 4; shift += 7) {
+            length |= (uint32_t)(rx[header] & 0x7f) << shift;
+            if ((rx[header++] & 0x80) == 0) {
+                break;
+            }
+            if (header > 4) {
+                linkDown("malformed packet");
+                return;
+            }
+        }
+        if (rx[header - 1] & 0x80) {
+            break;                            // Length still incomplete
+        }
+        total = header + length;
+        if (total > sizeof(rx)) {
+            // Nothing the bridge asked for is this large; skip it
+            rxSkip = total - rxLength;
+            rxLength = 0;
+            break;
+        }
+        if (rxLength < total) {
+            break;
+        }
+        handlePacket(rx[0], rx + header, length, now);
+        memmove(rx, rx + total, rxLength - total);
+        rxLength -= total;
+    }
+}
+
+static bool flushTx(uint64_t now) {
+    while (txSent < txLength) {
+        ssize_t sent = send(linkFd, tx + txSent, txLength - txSent, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                return true;
+            }
+            linkDown(strerror(errno));
+            return false;
+        }
+        txSent += (size_t)sent;
+        lastTxNs = now;
+    }
+    txLength = txSent = 0;
+    return true;
+}
+
+static uint16_t nextPacketId(void) {
+    if (++lastPacketId == 0) {
+        lastPacketId = 1;
+    }
+    return lastPacketId;
+}
+
+// One round of connection upkeep and sending
+static void serviceLink(uint64_t now, short revents) {
+    if (linkState == LINK_DOWN) {
+        if (now >= retryAtNs && spoolHead < spoolTail) {
+            linkStart(now);
+        }
+        return;
+    }
+
+    if (linkState == LINK_CONNECTING) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+
+        if (revents & (POLLOUT | POLLERR | POLLHUP)) {
+            if (getsockopt(linkFd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+                linkDown(strerror(error ? error : errno));
+                return;
+            }
+            linkState = LINK_HANDSHAKE;
+            lastRxNs = now;
+            queueConnect();
+        } else if (now >= deadlineNs) {
+            linkDown("connect timeout");
+            return;
+        }
+    }
+
+    if (revents & POLLIN) {
+        readLink(now);
+        if (linkState == LINK_DOWN) {
+            return;
+        }
+    }
+
+    if (linkState == LINK_HANDSHAKE && now >= deadlineNs) {
+        linkDown("no CONNACK");
+        return;
+    }
+    if (linkState == LINK_UP) {
+        if (now - lastRxNs > MQTT_KEEPALIVE_S * 1500000000ull) {
+            linkDown("keepalive timeout");
+            return;
+        }
+        if (txSent == txLength && inflight < window && sendNext < spoolTail) {
+            SpoolSlot *slot = &spool[sendNext & (MQTT_SPOOL_BATCHES - 1)];
+
+            slot->packetId = nextPacketId();
+            slot->state = SLOT_INFLIGHT;
+            slot->sentNs = now;
+            queuePublish(slot);
+            inflight++;
+            sendNext++;
+        } else if (txSent == txLength && now - lastTxNs >= MQTT_KEEPALIVE_S * 500000000ull) {
+            queueSimple(MQTT_PINGREQ);
+        }
+    }
+    flushTx(now);
+}
+
+// One turn of the bridge loop: collect events, close a due batch, refill
+// from the file, keep the link going and wait for the socket or a tick
+static void bridgeTurn(uint64_t *next, bool collect) {
+    struct pollfd fds[2];
+    uint64_t now = monotonicNowNs();
+    int count = 1;
+
+    if (collect) {
+        drainEvents(next);
+        if ((batchEvents > 0 || batchMissed > 0) && now - batchOpenedNs >= (uint64_t)intervalMs * 1000000ull) {
+            closeBatch();
+        }
+    }
+    spoolRefill();
+    serviceLink(now, 0);
+    // Keep sending while the window has room and the socket takes it
+    while (linkState == LINK_UP && txSent == txLength && inflight < window && sendNext < spoolTail) {
+        serviceLink(now, 0);
+    }
+    publishGauges();
+
+    fds[0].fd = stopFd;
+    fds[0].events = POLLIN;
+    if (linkFd >= 0) {
+        fds[1].fd = linkFd;
+        fds[1].events = linkState == LINK_CONNECTING ? POLLOUT : POLLIN | (txSent < txLength ? POLLOUT : 0);
+        count = 2;
+    }
+    if (poll(fds, count, MQTT_POLL_MS) <= 0) {
+        return;
+    }
+    if (fds[0].revents & POLLIN) {
+        uint64_t value;
+        if (read(stopFd, &value, sizeof(value)) < 0) {
+            // Woken either way
+        }
+    }
+    if (count == 2 && fds[1].revents != 0) {
+        serviceLink(monotonicNowNs(), fds[1].revents);
+    }
+}
+
+static void* bridgeThreadMain(void *arg) {
+    uint64_t next = startNext;
+    uint64_t graceEnd;
+    (void)arg;
+
+    pthread_setname_np(pthread_self(), "mqtt");
+    openBatch();
+    while (!__atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) {
+        bridgeTurn(&next, true);
+    }
+
+    // Last events from the producers that stopped before us
+    drainEvents(&next);
+    closeBatch();
+    graceEnd = monotonicNowNs() + MQTT_STOP_GRACE_MS * 1000000ull;
+    while (linkState == LINK_UP && spoolHead < spoolTail && monotonicNowNs() < graceEnd) {
+        bridgeTurn(&next, false);
+    }
+    if (linkState == LINK_UP && txSent == txLength) {
+        queueSimple(MQTT_DISCONNECT);
+        flushTx(monotonicNowNs());
+    }
+    if (linkFd >= 0) {
+        close(linkFd);
+        linkFd = -1;
+    }
+    linkState = LINK_DOWN;
+    __atomic_store_n(&connected, false, __ATOMIC_RELAXED);
+    spoolSave();
+    return NULL;
+}
+
+bool mqttBridgeStart(void) {
+    if (bridgeActive || brokerHost[0] == '\0') {
+        return true;
+    }
+
+    if (gethostname(hostname, sizeof(hostname)) != 0) {
+        strcpy(hostname, "unknown");
+    }
+    hostname[sizeof(hostname) - 1] = '\0';
+    if (topic[0] == '\0') {
+        snprintf(topic, sizeof(topic), "watchdog/%s/events", hostname);
+    }
+
+    txCapacity = MQTT_HEADER_MAX + 2 + strlen(topic) + 2 + batchBytes;
+    tx = malloc(txCapacity);
+    batchData = malloc(batchBytes);
+    spoolData = malloc((size_t)MQTT_SPOOL_BATCHES * batchBytes);
+    stopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (tx == NULL || batchData == NULL || spoolData == NULL || stopFd < 0) {
+        printf("MQTT: out of memory\n");
+        goto fail;
+    }
+    for (int i = 0; i < MQTT_SPOOL_BATCHES; i++) {
+        spool[i].data = spoolData + (size_t)i * batchBytes;
+    }
+
+    // Batches left by the previous run are sent first
+    if (spoolPath[0] != '\0') {
+        spoolFd = open(spoolPath, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (spoolFd < 0) {
+            printf("MQTT: cannot open spool %s: %s\n", spoolPath, strerror(errno));
+        } else {
+            off_t size = lseek(spoolFd, 0, SEEK_END);
+            fileSize = size > 0 ? (uint64_t)size : 0;
+            fileRead = 0;
+        }
+    }
+
+    // Events from here on, including those published before the thread runs
+    startNext = eventsNext();
+    stopping = false;
+    if (pthread_create(&bridgeThread, NULL, bridgeThreadMain, NULL) != 0) {
+        goto fail;
+    }
+    bridgeActive = true;
+    printf("MQTT: bridging events to %s:%s every %u ms or %u bytes\n", brokerHost, brokerPort, intervalMs, batchBytes);
+    return true;
+
+fail:
+    if (stopFd >= 0) {
+        close(stopFd);
+        stopFd = -1;
+    }
+    if (spoolFd >= 0) {
+        close(spoolFd);
+        spoolFd = -1;
+    }
+    free(tx);
+    free(batchData);
+    free(spoolData);
+    tx = NULL;
+    batchData = spoolData = NULL;
+    return false;
+}
+
+void mqttBridgeStop(void) {
+    uint64_t one = 1;
+
+    if (!bridgeActive) {
+        return;
+    }
+    __atomic_store_n(&stopping, true, __ATOMIC_RELEASE);
+    if (write(stopFd, &one, sizeof(one)) < 0) {
+        // The thread still sees stopping within MQTT_POLL_MS
+    }
+    pthread_join(bridgeThread, NULL);
+    bridgeActive = false;
+
+    close(stopFd);
+    stopFd = -1;
+    if (spoolFd >= 0) {
+        close(spoolFd);
+        spoolFd = -1;
+    }
+    free(tx);
+    free(batchData);
+    free(spoolData);
+    tx = NULL;
+    batchData = spoolData = NULL;
+}
+
+void mqttBridgeCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (brokerHost[0] == '\0') {
+        return;
+    }
+    metricsHeader(out, "watchdog_mqtt_connected", "gauge", "1 while the MQTT broker connection is up");
+    strbufAppendf(out, "watchdog_mqtt_connected %d\n", __atomic_load_n(&connected, __ATOMIC_RELAXED) ? 1 : 0);
+    metricsHeader(out, "watchdog_mqtt_connects_total", "counter", "MQTT connection attempts by result");
+    strbufAppendf(out, "watchdog_mqtt_connects_total{result=\"ok\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&connectsOk, __ATOMIC_RELAXED));
+    strbufAppendf(out, "watchdog_mqtt_connects_total{result=\"error\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&connectsFailed, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_mqtt_events_total", "counter", "Events put into MQTT batches, or missed");
+    strbufAppendf(out, "watchdog_mqtt_events_total{result=\"batched\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&eventsBatched, __ATOMIC_RELAXED));
+    strbufAppendf(out, "watchdog_mqtt_events_total{result=\"missed\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&eventsMissed, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_mqtt_batches_total", "counter", "MQTT batches acknowledged by the broker, or dropped");
+    strbufAppendf(out, "watchdog_mqtt_batches_total{result=\"acked\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&batchesAcked, __ATOMIC_RELAXED));
+    strbufAppendf(out, "watchdog_mqtt_batches_total{result=\"dropped\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&batchesDropped, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_mqtt_inflight", "gauge", "MQTT batches sent and not yet acknowledged");
+    strbufAppendf(out, "watchdog_mqtt_inflight %u\n", __atomic_load_n(&inflightGauge, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_mqtt_spool_batches", "gauge", "MQTT batches held in memory, in flight included");
+    strbufAppendf(out, "watchdog_mqtt_spool_batches %llu\n",
+                  (unsigned long long)__atomic_load_n(&spoolDepth, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_mqtt_spool_file_bytes", "gauge", "Batches waiting in the --mqtt-spool file");
+    strbufAppendf(out, "watchdog_mqtt_spool_file_bytes %llu\n",
+                  (unsigned long long)__atomic_load_n(&spoolFileBytes, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_mqtt_ack_seconds", "summary", "Time from PUBLISH to PUBACK");
+    histogramWriteSummary(out, "watchdog_mqtt_ack_seconds", NULL, &ackLatency);
+}
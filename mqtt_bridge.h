@@ -0,0 +1,54 @@
+#ifndef MQTT_BRIDGE_H
+#define MQTT_BRIDGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "strbuf.h"
+
+#define MQTT_DEFAULT_PORT 1883
+#define MQTT_DEFAULT_INTERVAL_MS 1000
+#define MQTT_DEFAULT_BATCH_BYTES 4096
+#define MQTT_MAX_BATCH_BYTES 65536
+#define MQTT_DEFAULT_WINDOW 8
+#define MQTT_MAX_WINDOW 64
+#define MQTT_SPOOL_BATCHES 64            // Batches held in memory, must be a power of two
+#define MQTT_SPOOL_FILE_MAX (16u << 20)  // Bytes --mqtt-spool may grow to
+#define MQTT_KEEPALIVE_S 30
+
+// Publishes the service's events to an MQTT 3.1.1 broker. The bridge reads
+// the /api/events ring with its own cursor, so HWM changes, GPIO edges and
+// every other monitor's events reach it without a subscriber of their own.
+// Events are batched into one JSON message per interval, or sooner once a
+// message reaches the size limit, as
+//   {"host": ..., "events": [{"seq", "event", fields as in /api/events}...], "missed": N}
+//
+// Messages go out at QoS 1 from one thread that never blocks a publisher.
+// At most the window's worth await PUBACK; more wait in a spool of
+// MQTT_SPOOL_BATCHES. While the broker is unreachable the spool fills, and
+// with --mqtt-spool the overflow, and anything unacknowledged at shutdown,
+// goes to a file that is replayed first, in order, on the next connection.
+// Without the file, batches that find the spool full are dropped and
+// counted. Lost connections are retried with backoff up to 30 s, and
+// unacknowledged messages are resent with DUP set.
+
+// All before mqttBridgeStart(). HOST[:PORT]; false if malformed
+bool mqttBridgeSetBroker(const char *spec);
+// Default watchdog/<hostname>/events; false if empty, too long or a wildcard
+bool mqttBridgeSetTopic(const char *topic);
+// Close a batch after intervalMs or at maxBytes, whichever comes first
+bool mqttBridgeSetBatch(uint32_t intervalMs, uint32_t maxBytes);
+// Unacknowledged messages at a time, 1 to MQTT_MAX_WINDOW
+bool mqttBridgeSetWindow(uint32_t window);
+// Encode batches as CBOR (same structure) instead of JSON
+void mqttBridgeSetCbor(bool cbor);
+void mqttBridgeSetSpool(const char *path);
+
+// Start the bridge thread; does nothing and returns true without a broker
+bool mqttBridgeStart(void);
+// Close the open batch, give the broker a moment to acknowledge, then
+// spool what is left (with --mqtt-spool) and disconnect
+void mqttBridgeStop(void);
+
+void mqttBridgeCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // MQTT_BRIDGE_H
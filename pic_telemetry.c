@@ -0,0 +1,342 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "pic_telemetry.h"
+#include "Susi4.h"
+#include "events.h"
+#include "histogram.h"
+#include "hw_actor.h"
+#include "lifecycle.h"
+#include "metrics.h"
+#include "scheduler.h"
+#include "susi_device.h"
+#include "timeutil.h"
+
+// From SUSIDeviceDEMO/PICDEMO/PIC.h
+#define PIC_ID_BASE                     0x00600000
+#define PIC_ID_INFO_AVAILABLE           ((SusiId_t)(PIC_ID_BASE + 8))
+#define PIC_ID_FW_BASE                  (PIC_ID_BASE | 0x20000)
+#define PIC_ID_TIMER_BASE               (PIC_ID_BASE | 0xA0000)
+#define PIC_ID_FW_IGN_LEVEL             ((SusiId_t)(PIC_ID_FW_BASE + 10))
+
+static const struct {
+    SusiId_t id;
+    const char *name;
+} picFields[PIC_FIELD_COUNT] = {
+    [PIC_FIELD_V48_OUTPUT]         = { PIC_ID_FW_BASE + 12, "v48_output" },
+    [PIC_FIELD_IGNITION]           = { PIC_ID_FW_IGN_LEVEL, "ignition" },
+    [PIC_FIELD_INPUT_VOLTAGE]      = { PIC_ID_FW_BASE + 5, "input_voltage" },
+    [PIC_FIELD_HARD_OFF_TIMER]     = { PIC_ID_TIMER_BASE + 6, "hard_off_timer" },
+    [PIC_FIELD_IGNITION_OFF_TIMER] = { PIC_ID_TIMER_BASE + 5, "ignition_off_timer" },
+    [PIC_FIELD_LOW_BATTERY_TIMER]  = { PIC_ID_TIMER_BASE + 7, "low_battery_timer" },
+    [PIC_FIELD_POWER_OFF_RETRIES]  = { PIC_ID_TIMER_BASE + 3, "power_off_retries" },
+    [PIC_FIELD_POWER_OFF_INTERVAL] = { PIC_ID_TIMER_BASE + 4, "power_off_interval" },
+};
+
+typedef struct {
+    uint32_t valid;                  // Bit per field read successfully
+    uint32_t values[PIC_FIELD_COUNT];
+} PicReading;
+
+typedef struct {
+    bool ok;
+    uint32_t level;                  // 0 off, 1 on
+    uint64_t readNs;
+} IgnitionRead;
+
+// Debounce state, owned by the ignition thread
+typedef struct {
+    bool known;
+    bool changing;                   // Reads disagree with level since changeNs
+    uint32_t level;                  // Accepted level
+    uint64_t steadyNs;               // Last read that still showed level
+    uint64_t changeNs;               // First read of the new level
+    uint32_t bounces;                // Excursions dropped since the last edge
+} IgnitionState;
+
+static bool deviceOpen;
+static uint32_t intervalMs = PIC_DEFAULT_INTERVAL_MS;
+
+static pthread_mutex_t picLock = PTHREAD_MUTEX_INITIALIZER;
+static int picTask = -1;
+static bool picRunning;
+static PicReading current;           // Under picLock
+static uint64_t reads;
+static uint64_t readErrors;           // Field reads that failed
+static uint64_t changes[PIC_FIELD_COUNT];
+
+static uint32_t ignitionPollMs;
+static uint32_t ignitionDebounceMs = PIC_IGNITION_DEFAULT_DEBOUNCE_MS;
+static bool ignitionShutdown;
+static int ignitionTask = -1;
+static bool ignitionRunning;
+static IgnitionState ignitionState;  // Only touched by the ignition task
+static uint32_t ignitionLevel;       // Accepted level, once ignitionKnown
+static bool ignitionKnown;
+static uint64_t ignitionReads;
+static uint64_t ignitionReadErrors;
+static uint64_t ignitionEdges[2];    // Per new level
+static uint64_t ignitionBounces;
+static Histogram ignitionLatency;    // Last read of the old level to the edge being acted on
+
+void picTelemetrySetInterval(uint32_t ms) {
+    intervalMs = ms;
+}
+
+void picIgnitionWatch(uint32_t pollMs, uint32_t debounceMs, bool shutdown) {
+    ignitionPollMs = pollMs;
+    ignitionDebounceMs = debounceMs;
+    ignitionShutdown = shutdown;
+}
+
+const char* picFieldName(PicField field) {
+    return field < PIC_FIELD_COUNT ? picFields[field].name : "unknown";
+}
+
+double picFieldScale(PicField field, uint32_t raw) {
+    return field == PIC_FIELD_INPUT_VOLTAGE ? raw * 0.1 : (double)raw;
+}
+
+static void hwProbePic(void *arg) {
+    uint32_t available = 0;
+
+    *(bool*)arg = susiDeviceGetValue(PIC_ID_INFO_AVAILABLE, &available) == SUSI_STATUS_SUCCESS && available != 0;
+}
+
+static void hwReadPic(void *arg) {
+    PicReading *reading = arg;
+
+    reading->valid = 0;
+    for (int i = 0; i < PIC_FIELD_COUNT; i++) {
+        if (susiDeviceGetValue(picFields[i].id, &reading->values[i]) == SUSI_STATUS_SUCCESS) {
+            reading->valid |= 1u << i;
+        }
+    }
+}
+
+static void hwReadIgnition(void *arg) {
+    IgnitionRead *read = arg;
+
+    read->ok = susiDeviceGetValue(PIC_ID_FW_IGN_LEVEL, &read->level) == SUSI_STATUS_SUCCESS;
+    read->level = read->level != 0;
+    read->readNs = monotonicNowNs();
+}
+
+// A field is published when it is first read, and after that whenever it differs
+static void publishChanges(const PicReading *next) {
+    PicReading previous;
+
+    pthread_mutex_lock(&picLock);
+    previous = current;
+    current = *next;
+    reads++;
+    readErrors += PIC_FIELD_COUNT - (uint64_t)__builtin_popcount(next->valid);
+    pthread_mutex_unlock(&picLock);
+
+    for (int i = 0; i < PIC_FIELD_COUNT; i++) {
+        uint32_t bit = 1u << i;
+
+        if (!(next->valid & bit)) {
+            continue;
+        }
+        if ((previous.valid & bit) && previous.values[i] == next->values[i]) {
+            continue;
+        }
+        __atomic_fetch_add(&changes[i], 1, __ATOMIC_RELAXED);
+        eventPublish(EVENT_PIC, EVENT_NO_WATCHDOG, (uint32_t)i, next->values[i],
+                     (previous.valid & bit) ? previous.values[i] : next->values[i], (previous.valid & bit) != 0);
+    }
+}
+
+static void picTick(void *arg) {
+    PicReading next;
+    (void)arg;
+
+    // A busy read lane only delays this read
+    if (hwActorCall(HW_LANE_READ, hwReadPic, &next)) {
+        publishChanges(&next);
+    }
+}
+
+static void ignitionAccept(IgnitionState *state, const IgnitionRead *read) {
+    uint64_t latencyNs = monotonicNowNs() - state->steadyNs;
+    bool shutdown = ignitionShutdown && read->level == 0;
+
+    state->level = read->level;
+    state->changing = false;
+    state->steadyNs = read->readNs;
+    __atomic_store_n(&ignitionLevel, read->level, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&ignitionEdges[read->level], 1, __ATOMIC_RELAXED);
+
+    // Start the hooks first; publishing and logging can wait behind them
+    if (shutdown) {
+        lifecycleRequestShutdown();
+    }
+    histogramRecord(&ignitionLatency, latencyNs);
+    eventPublish(EVENT_IGNITION, EVENT_NO_WATCHDOG, read->level, (uint32_t)(latencyNs / 1000), state->bounces, shutdown);
+    if (shutdown) {
+        printf("Ignition off: shutting down, %.1f ms after the last on read\n", (double)latencyNs / 1e6);
+    }
+    state->bounces = 0;
+}
+
+static void ignitionStep(IgnitionState *state, const IgnitionRead *read) {
+    if (!state->known) {
+        // The level at startup is not an edge
+        state->known = true;
+        state->level = read->level;
+        state->steadyNs = read->readNs;
+        __atomic_store_n(&ignitionLevel, read->level, __ATOMIC_RELAXED);
+        __atomic_store_n(&ignitionKnown, true, __ATOMIC_RELEASE);
+        return;
+    }
+    if (read->level == state->level) {
+        if (state->changing) {
+            state->changing = false;
+            state->bounces++;
+            __atomic_fetch_add(&ignitionBounces, 1, __ATOMIC_RELAXED);
+        }
+        state->steadyNs = read->readNs;
+        return;
+    }
+    if (!state->changing) {
+        state->changing = true;
+        state->changeNs = read->readNs;
+    }
+    if (read->readNs - state->changeNs >= (uint64_t)ignitionDebounceMs * 1000000ull) {
+        ignitionAccept(state, read);
+    }
+}
+
+static void ignitionTick(void *arg) {
+    IgnitionRead read;
+    (void)arg;
+
+    // The deadline keeps a telemetry sweep on the read lane from
+    // stretching the poll beyond one period
+    if (hwActorCallWithin(HW_LANE_READ, (uint64_t)ignitionPollMs * 1000000ull, hwReadIgnition, &read) && read.ok) {
+        __atomic_fetch_add(&ignitionReads, 1, __ATOMIC_RELAXED);
+        ignitionStep(&ignitionState, &read);
+    } else {
+        __atomic_fetch_add(&ignitionReadErrors, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void closeDevice(void) {
+    susiDeviceClose();
+    deviceOpen = false;
+}
+
+bool picTelemetryStart(void) {
+    bool present = false;
+
+    if ((intervalMs == 0 && ignitionPollMs == 0) || deviceOpen) {
+        return false;
+    }
+    if (!susiDeviceOpen()) {
+        return false;
+    }
+    if (!hwActorCall(HW_LANE_READ, hwProbePic, &present) || !present) {
+        susiDeviceClose();
+        return false;
+    }
+    deviceOpen = true;
+    if (intervalMs != 0) {
+        picTask = schedulerAdd("pic", SCHEDULER_PRIORITY_NORMAL, intervalMs, 0, picTick, NULL);
+        picRunning = picTask >= 0;
+        if (picRunning) {
+            printf("PIC telemetry: every %u ms\n", intervalMs);
+        }
+    }
+    if (ignitionPollMs != 0) {
+        // An off edge may have to shut the service down in time: never
+        // queued behind the telemetry pollers
+        memset(&ignitionState, 0, sizeof(ignitionState));
+        ignitionTask = schedulerAdd("ignition", SCHEDULER_PRIORITY_HIGH, ignitionPollMs, 0, ignitionTick, NULL);
+        ignitionRunning = ignitionTask >= 0;
+        if (ignitionRunning) {
+            printf("PIC ignition watch: every %u ms, debounce %u ms, off edge seen within %u ms%s\n",
+                   ignitionPollMs, ignitionDebounceMs, ignitionDebounceMs + 2 * ignitionPollMs,
+                   ignitionShutdown ? ", shuts the service down" : "");
+        }
+    }
+    if (!picRunning && !ignitionRunning) {
+        closeDevice();
+        return false;
+    }
+    return true;
+}
+
+void picTelemetryStop(void) {
+    if (!deviceOpen) {
+        return;
+    }
+    if (picRunning) {
+        schedulerRemove(picTask);
+        picTask = -1;
+        picRunning = false;
+    }
+    if (ignitionRunning) {
+        schedulerRemove(ignitionTask);
+        ignitionTask = -1;
+        ignitionRunning = false;
+    }
+    // No PIC read is in flight: the tasks are done and hwActorCall only
+    // returns once its command ran
+    closeDevice();
+}
+
+void picTelemetryCollectMetrics(StrBuf *out, void *ctx) {
+    PicReading reading;
+    uint64_t readCount, errorCount;
+    (void)ctx;
+
+    if (ignitionRunning) {
+        metricsHeader(out, "watchdog_ignition_level", "gauge", "Debounced ignition level, 0 off, 1 on");
+        if (__atomic_load_n(&ignitionKnown, __ATOMIC_ACQUIRE)) {
+            strbufAppendf(out, "watchdog_ignition_level %u\n", __atomic_load_n(&ignitionLevel, __ATOMIC_RELAXED));
+        }
+        metricsHeader(out, "watchdog_ignition_edges_total", "counter", "Debounced ignition changes by new level");
+        strbufAppendf(out, "watchdog_ignition_edges_total{level=\"off\"} %llu\n",
+                      (unsigned long long)__atomic_load_n(&ignitionEdges[0], __ATOMIC_RELAXED));
+        strbufAppendf(out, "watchdog_ignition_edges_total{level=\"on\"} %llu\n",
+                      (unsigned long long)__atomic_load_n(&ignitionEdges[1], __ATOMIC_RELAXED));
+        metricsHeader(out, "watchdog_ignition_bounces_total", "counter", "Ignition changes shorter than the debounce time");
+        strbufAppendf(out, "watchdog_ignition_bounces_total %llu\n",
+                      (unsigned long long)__atomic_load_n(&ignitionBounces, __ATOMIC_RELAXED));
+        metricsHeader(out, "watchdog_ignition_reads_total", "counter", "Ignition level reads");
+        strbufAppendf(out, "watchdog_ignition_reads_total %llu\n",
+                      (unsigned long long)__atomic_load_n(&ignitionReads, __ATOMIC_RELAXED));
+        metricsHeader(out, "watchdog_ignition_read_errors_total", "counter", "Ignition level reads that failed or missed the lane");
+        strbufAppendf(out, "watchdog_ignition_read_errors_total %llu\n",
+                      (unsigned long long)__atomic_load_n(&ignitionReadErrors, __ATOMIC_RELAXED));
+        metricsHeader(out, "watchdog_ignition_latency_seconds", "summary",
+                      "Last read of the old ignition level to the edge being acted on");
+        histogramWriteSummary(out, "watchdog_ignition_latency_seconds", NULL, &ignitionLatency);
+    }
+    if (!picRunning) {
+        return;
+    }
+    pthread_mutex_lock(&picLock);
+    reading = current;
+    readCount = reads;
+    errorCount = readErrors;
+    pthread_mutex_unlock(&picLock);
+
+    metricsHeader(out, "watchdog_pic_value", "gauge", "Latest PIC reading (input_voltage in volts, timers in seconds)");
+    for (int i = 0; i < PIC_FIELD_COUNT; i++) {
+        if (reading.valid & (1u << i)) {
+            strbufAppendf(out, "watchdog_pic_value{field=\"%s\"} %g\n", picFields[i].name,
+                          picFieldScale((PicField)i, reading.values[i]));
+        }
+    }
+    metricsHeader(out, "watchdog_pic_changes_total", "counter", "PIC values published as events: the first read and every change");
+    for (int i = 0; i < PIC_FIELD_COUNT; i++) {
+        strbufAppendf(out, "watchdog_pic_changes_total{field=\"%s\"} %llu\n", picFields[i].name,
+                      (unsigned long long)__atomic_load_n(&changes[i], __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_pic_reads_total", "counter", "PIC reads");
+    strbufAppendf(out, "watchdog_pic_reads_total %llu\n", (unsigned long long)readCount);
+    metricsHeader(out, "watchdog_pic_read_errors_total", "counter", "PIC values that could not be read");
+    strbufAppendf(out, "watchdog_pic_read_errors_total %llu\n", (unsigned long long)errorCount);
+}
@@ -0,0 +1,57 @@
+#ifndef PIC_TELEMETRY_H
+#define PIC_TELEMETRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "strbuf.h"
+
+#define PIC_DEFAULT_INTERVAL_MS 1000
+#define PIC_IGNITION_DEFAULT_DEBOUNCE_MS 100
+
+// Vehicle power controller (PIC) telemetry. The PIC is reached through
+// SusiDeviceGetValue in the optional SUSI device library (susi_device.h). A
+// task on the shared scheduler (scheduler.h) reads the 48 V output,
+// ignition level, input voltage and the shutdown timers through the
+// hardware thread every interval. Only values that differ from the
+// previous read are published, as EVENT_PIC, and /metrics shows the latest
+// read.
+//
+// The ignition watcher is a second, faster task over the ignition level
+// alone, at high priority so it never waits behind the telemetry pollers.
+// The PIC raises no interrupt through the device library, so it polls. A
+// new level is accepted once every read for the debounce time agreed; shorter excursions count as bounces. An accepted edge is
+// published as EVENT_IGNITION with how long ago the line last read the old
+// level, which bounds the edge-to-action latency, and with shutdown
+// enabled an off edge runs the service's shutdown hooks. Worst case the
+// edge is seen debounce + 2 polls after it happened.
+
+typedef enum {
+    PIC_FIELD_V48_OUTPUT,            // 0 off, 1 on
+    PIC_FIELD_IGNITION,              // 0 off, 1 on
+    PIC_FIELD_INPUT_VOLTAGE,         // 0.1 V
+    PIC_FIELD_HARD_OFF_TIMER,        // Seconds
+    PIC_FIELD_IGNITION_OFF_TIMER,    // Seconds
+    PIC_FIELD_LOW_BATTERY_TIMER,     // Seconds
+    PIC_FIELD_POWER_OFF_RETRIES,     // Power button presses left
+    PIC_FIELD_POWER_OFF_INTERVAL,    // Seconds
+    PIC_FIELD_COUNT
+} PicField;
+
+// Before picTelemetryStart(); 0 disables the module
+void picTelemetrySetInterval(uint32_t ms);
+// Before picTelemetryStart(): read the ignition level every pollMs (0 = off)
+// and ask the service to shut down on an off edge if shutdown is set
+void picIgnitionWatch(uint32_t pollMs, uint32_t debounceMs, bool shutdown);
+// Load the device library, check that a PIC answers and start sampling
+// and the ignition watcher (after hwActorStart). False when there is no PIC
+// or both are off.
+bool picTelemetryStart(void);
+void picTelemetryStop(void);
+
+const char* picFieldName(PicField field);
+// Value in the field's unit for display (volts for the input voltage)
+double picFieldScale(PicField field, uint32_t raw);
+
+void picTelemetryCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // PIC_TELEMETRY_H
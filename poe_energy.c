@@ -0,0 +1,286 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "poe_energy.h"
+#include "hw_actor.h"
+#include "metrics.h"
+#include "poe_monitor.h"
+#include "storage_kv.h"
+#include "susi_device.h"
+#include "timeutil.h"
+
+// From SUSIDeviceDEMO/PoEDEMO/Port.h
+#define POE_ID_BASE                     0x00200000
+#define POE_ID_CURRENT_PORT(x)          ((SusiId_t)((POE_ID_BASE | 0x40000) + (x) - 1))
+#define POE_ID_VOLTAGE_PORT(x)          ((SusiId_t)((POE_ID_BASE | 0x50000) + (x) - 1))
+
+#define FEMTOJOULES_PER_MICROJOULE 1000000000ull
+
+// One sample of every port, filled on the hardware thread
+typedef struct {
+    uint64_t readNs;
+    uint32_t valid;                  // Bit per port read successfully
+    uint32_t powerUw[POE_MAX_PORTS];
+} EnergySample;
+
+static uint32_t rateHz = POE_ENERGY_DEFAULT_RATE_HZ;
+static uint32_t persistS = POE_ENERGY_DEFAULT_PERSIST_S;
+static uint32_t portNumbers[POE_MAX_PORTS];
+static int portCount;
+
+// Integrator state, owned by the sampling thread
+static EnergySample previous;
+static uint64_t residualFj[POE_MAX_PORTS];
+static uint64_t persistedUj[POE_MAX_PORTS];
+
+static pthread_mutex_t energyLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t energyWake;
+static pthread_t energyThread;
+static bool energyRunning;
+static bool stopping;
+static uint64_t energyUj[POE_MAX_PORTS];  // Under energyLock
+static uint64_t samples;
+static uint64_t readErrors;
+static uint64_t gaps;
+static uint64_t persistWrites;
+static uint64_t persistErrors;
+
+void poeEnergySetRate(uint32_t hz) {
+    rateHz = hz > POE_ENERGY_MAX_RATE_HZ ? POE_ENERGY_MAX_RATE_HZ : hz;
+}
+
+void poeEnergySetPersist(uint32_t seconds) {
+    persistS = seconds;
+}
+
+static void hwSample(void *arg) {
+    EnergySample *sample = arg;
+
+    sample->valid = 0;
+    for (int i = 0; i < portCount; i++) {
+        uint32_t millivolts = 0, microamps = 0;
+
+        sample->powerUw[i] = 0;
+        if (susiDeviceGetValue(POE_ID_VOLTAGE_PORT(portNumbers[i]), &millivolts) == SUSI_STATUS_SUCCESS &&
+            susiDeviceGetValue(POE_ID_CURRENT_PORT(portNumbers[i]), &microamps) == SUSI_STATUS_SUCCESS) {
+            sample->powerUw[i] = (uint32_t)((uint64_t)millivolts * microamps / 1000ull);
+            sample->valid |= 1u << i;
+        }
+    }
+    sample->readNs = monotonicNowNs();
+}
+
+// Trapezoid between the previous and this sample: uW * ns is femtojoules
+static void integrate(const EnergySample *sample) {
+    uint64_t periodNs = 1000000000ull / rateHz;
+    uint64_t dtNs = sample->readNs - previous.readNs;
+    uint32_t both = sample->valid & previous.valid;
+    uint64_t addUj[POE_MAX_PORTS];
+
+    if (previous.readNs == 0 || dtNs > POE_ENERGY_MAX_GAP_SAMPLES * periodNs) {
+        if (previous.readNs != 0) {
+            __atomic_fetch_add(&gaps, 1, __ATOMIC_RELAXED);
+        }
+        previous = *sample;
+        return;
+    }
+    for (int i = 0; i < portCount; i++) {
+        uint64_t fj = ((uint64_t)previous.powerUw[i] + sample->powerUw[i]) * dtNs / 2;
+
+        // A port that failed either read adds nothing for this interval
+        fj &= 0ull - ((both >> i) & 1u);
+        residualFj[i] += fj;
+        addUj[i] = residualFj[i] / FEMTOJOULES_PER_MICROJOULE;
+        residualFj[i] -= addUj[i] * FEMTOJOULES_PER_MICROJOULE;
+    }
+    pthread_mutex_lock(&energyLock);
+    for (int i = 0; i < portCount; i++) {
+        energyUj[i] += addUj[i];
+    }
+    pthread_mutex_unlock(&energyLock);
+    previous = *sample;
+}
+
+static void keyFor(uint32_t port, char *key, size_t size) {
+    snprintf(key, size, POE_ENERGY_KEY_PREFIX "%u", port);
+}
+
+static void restore(void) {
+    for (int i = 0; i < portCount; i++) {
+        char key[STORAGE_KV_KEY_MAX + 1];
+        uint8_t value[STORAGE_KV_VALUE_MAX];
+        uint32_t length = 0;
+        uint64_t uj = 0;
+
+        keyFor(portNumbers[i], key, sizeof(key));
+        if (storageKvEnabled() && storageKvGet(key, value, &length) && length == 8) {
+            for (int b = 7; b >= 0; b--) {
+                uj = (uj << 8) | value[b];
+            }
+        }
+        energyUj[i] = uj;
+        persistedUj[i] = uj;
+    }
+}
+
+// Write the counters that moved since their last write
+static void persist(void) {
+    uint64_t current[POE_MAX_PORTS];
+
+    if (!storageKvEnabled()) {
+        return;
+    }
+    pthread_mutex_lock(&energyLock);
+    memcpy(current, energyUj, sizeof(current));
+    pthread_mutex_unlock(&energyLock);
+
+    for (int i = 0; i < portCount; i++) {
+        char key[STORAGE_KV_KEY_MAX + 1];
+        uint8_t value[8];
+
+        if (current[i] == persistedUj[i]) {
+            continue;
+        }
+        keyFor(portNumbers[i], key, sizeof(key));
+        for (int b = 0; b < 8; b++) {
+            value[b] = (uint8_t)(current[i] >> (8 * b));
+        }
+        if (storageKvSet(key, value, sizeof(value)) == SUSI_STATUS_SUCCESS) {
+            persistedUj[i] = current[i];
+            __atomic_fetch_add(&persistWrites, 1, __ATOMIC_RELAXED);
+        } else {
+            __atomic_fetch_add(&persistErrors, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static void* energyThreadMain(void *arg) {
+    uint64_t periodNs = 1000000000ull / rateHz;
+    uint64_t persistNs = (uint64_t)persistS * 1000000000ull;
+    uint64_t dueNs = monotonicNowNs();
+    uint64_t persistDueNs = dueNs + persistNs;
+    (void)arg;
+
+    pthread_setname_np(pthread_self(), "poe-energy");
+    pthread_mutex_lock(&energyLock);
+    while (!stopping) {
+        struct timespec deadline;
+        EnergySample sample;
+
+        pthread_mutex_unlock(&energyLock);
+        // The deadline keeps the sample spacing even behind a telemetry sweep
+        if (hwActorCallWithin(HW_LANE_READ, periodNs, hwSample, &sample)) {
+            __atomic_fetch_add(&samples, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&readErrors, (uint64_t)(portCount - __builtin_popcount(sample.valid)), __ATOMIC_RELAXED);
+            integrate(&sample);
+        }
+        if (persistNs != 0 && monotonicNowNs() >= persistDueNs) {
+            persist();
+            persistDueNs += persistNs;
+        }
+        pthread_mutex_lock(&energyLock);
+
+        dueNs += periodNs;
+        if (dueNs < monotonicNowNs()) {
+            dueNs = monotonicNowNs();
+        }
+        deadline.tv_sec = (time_t)(dueNs / 1000000000ull);
+        deadline.tv_nsec = (long)(dueNs % 1000000000ull);
+        while (!stopping && pthread_cond_timedwait(&energyWake, &energyLock, &deadline) == 0) {
+        }
+    }
+    pthread_mutex_unlock(&energyLock);
+    return NULL;
+}
+
+bool poeEnergyStart(void) {
+    pthread_condattr_t attr;
+
+    if (rateHz == 0 || energyRunning) {
+        return false;
+    }
+    portCount = poeMonitorPorts(portNumbers);
+    // Our own reference: the monitor may stop first at shutdown
+    if (portCount == 0 || !susiDeviceOpen()) {
+        return false;
+    }
+    restore();
+    memset(&previous, 0, sizeof(previous));
+    memset(residualFj, 0, sizeof(residualFj));
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&energyWake, &attr);
+    pthread_condattr_destroy(&attr);
+    stopping = false;
+    if (pthread_create(&energyThread, NULL, energyThreadMain, NULL) != 0) {
+        pthread_cond_destroy(&energyWake);
+        susiDeviceClose();
+        return false;
+    }
+    energyRunning = true;
+    printf("PoE energy: %d ports at %u Hz%s\n", portCount, rateHz,
+           storageKvEnabled() ? ", kept in the key-value store" : "");
+    return true;
+}
+
+void poeEnergyStop(void) {
+    if (!energyRunning) {
+        return;
+    }
+    pthread_mutex_lock(&energyLock);
+    stopping = true;
+    pthread_cond_signal(&energyWake);
+    pthread_mutex_unlock(&energyLock);
+    pthread_join(energyThread, NULL);
+    pthread_cond_destroy(&energyWake);
+    persist();
+    susiDeviceClose();
+    energyRunning = false;
+}
+
+bool poeEnergyGet(uint32_t port, uint64_t *microjoules) {
+    if (!energyRunning) {
+        return false;
+    }
+    for (int i = 0; i < portCount; i++) {
+        if (portNumbers[i] == port) {
+            pthread_mutex_lock(&energyLock);
+            *microjoules = energyUj[i];
+            pthread_mutex_unlock(&energyLock);
+            return true;
+        }
+    }
+    return false;
+}
+
+void poeEnergyCollectMetrics(StrBuf *out, void *ctx) {
+    uint64_t current[POE_MAX_PORTS];
+    (void)ctx;
+
+    if (!energyRunning) {
+        return;
+    }
+    pthread_mutex_lock(&energyLock);
+    memcpy(current, energyUj, sizeof(current));
+    pthread_mutex_unlock(&energyLock);
+
+    metricsHeader(out, "watchdog_poe_energy_joules_total", "counter", "Energy drawn by a PoE port, kept across restarts");
+    for (int i = 0; i < portCount; i++) {
+        strbufAppendf(out, "watchdog_poe_energy_joules_total{port=\"%u\"} %llu.%06llu\n", portNumbers[i],
+                      (unsigned long long)(current[i] / 1000000ull), (unsigned long long)(current[i] % 1000000ull));
+    }
+    metricsHeader(out, "watchdog_poe_energy_samples_total", "counter", "V*I samples of all PoE ports");
+    strbufAppendf(out, "watchdog_poe_energy_samples_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&samples, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_poe_energy_read_errors_total", "counter", "Port samples that could not be read");
+    strbufAppendf(out, "watchdog_poe_energy_read_errors_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&readErrors, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_poe_energy_gaps_total", "counter", "Sample gaps too long to integrate over");
+    strbufAppendf(out, "watchdog_poe_energy_gaps_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&gaps, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_poe_energy_persist_total", "counter", "Energy counter writes to the key-value store by result");
+    strbufAppendf(out, "watchdog_poe_energy_persist_total{result=\"ok\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&persistWrites, __ATOMIC_RELAXED));
+    strbufAppendf(out, "watchdog_poe_energy_persist_total{result=\"error\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&persistErrors, __ATOMIC_RELAXED));
+}
@@ -0,0 +1,41 @@
+#ifndef POE_ENERGY_H
+#define POE_ENERGY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "strbuf.h"
+
+#define POE_ENERGY_DEFAULT_RATE_HZ 10
+#define POE_ENERGY_MAX_RATE_HZ 100
+#define POE_ENERGY_DEFAULT_PERSIST_S 300
+#define POE_ENERGY_MAX_GAP_SAMPLES 10        // Longer gaps are not integrated
+#define POE_ENERGY_KEY_PREFIX "poe.energy."
+
+// Energy drawn per PoE port, for billing and capacity planning. A thread
+// reads the voltage and current of every port at the sample rate, all
+// ports in one hardware-thread command, and adds the trapezoid between
+// consecutive V*I samples to a 64-bit counter in microjoules. The
+// remainder below a microjoule is carried, so rounding never accumulates.
+// A sample costs one hardware command whatever the port count, and the
+// integrator a few operations per port over fixed arrays. A gap
+// longer than POE_ENERGY_MAX_GAP_SAMPLES periods (a stalled hardware
+// thread) restarts the integration instead of guessing what was drawn.
+//
+// With the key-value store enabled, each counter is kept under
+// "poe.energy.<port>" (8 bytes, little endian), restored at start and
+// written back every persist interval and at shutdown, so the totals
+// survive restarts minus at most one interval.
+
+// Before poeEnergyStart(); a rate of 0 disables the module
+void poeEnergySetRate(uint32_t hz);
+void poeEnergySetPersist(uint32_t seconds);
+// After poeMonitorStart() and storageKvInit()
+bool poeEnergyStart(void);
+void poeEnergyStop(void);
+
+// Energy port has drawn so far, in microjoules; false for an unknown port
+bool poeEnergyGet(uint32_t port, uint64_t *microjoules);
+
+void poeEnergyCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // POE_ENERGY_H
@@ -0,0 +1,293 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "poe_monitor.h"
+#include "events.h"
+#include "hw_actor.h"
+#include "metrics.h"
+#include "scheduler.h"
+#include "susi_device.h"
+
+// From SUSIDeviceDEMO/PoEDEMO/Port.h
+#define POE_ID_BASE                     0x00200000
+#define POE_ID_INFO_AVAILABLE           ((SusiId_t)(POE_ID_BASE + 0))
+#define POE_ID_DETECT_PORT(x)           ((SusiId_t)((POE_ID_BASE | 0x20000) + (x) - 1))
+#define POE_ID_CLASS_PORT(x)            ((SusiId_t)((POE_ID_BASE | 0x30000) + (x) - 1))
+#define POE_ID_CURRENT_PORT(x)          ((SusiId_t)((POE_ID_BASE | 0x40000) + (x) - 1))
+#define POE_ID_VOLTAGE_PORT(x)          ((SusiId_t)((POE_ID_BASE | 0x50000) + (x) - 1))
+#define POE_ID_CAP_PORT(x)              ((SusiId_t)((POE_ID_BASE | 0x60000) + (x) - 1))
+#define POE_ID_PORT_POWER_PORT(x)       ((SusiId_t)((POE_ID_BASE | 0x70000) + (x) - 1))
+
+static const char *detectionNames[] = {
+    "unknown", "pd_error", "pd_error", "pd_error", "detected_good", "pd_error", "detect_open", "pd_error",
+};
+
+static const char *classNames[] = {
+    "unknown", "class_1", "class_2", "class_3", "class_4", "error", "class_0", "overcurrent",
+};
+
+typedef struct {
+    uint32_t port;
+    bool on;
+    SusiStatus_t status;
+} PowerCommand;
+
+static uint32_t intervalMs = POE_DEFAULT_INTERVAL_MS;
+static uint32_t budgetMw;
+static uint32_t portNumbers[POE_MAX_PORTS];
+static int portCount;
+
+static pthread_mutex_t poeLock = PTHREAD_MUTEX_INITIALIZER;
+static int poeTask = -1;
+static bool poeRunning;
+static PoeSnapshot latest;           // Under poeLock, once latest.ticks > 0
+static uint64_t readErrors;
+static uint64_t powerChanges;
+static uint64_t powerChangeErrors;
+static uint64_t budgetCrossings;
+
+static uint64_t wallClockMs(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000ull + (uint64_t)now.tv_nsec / 1000000ull;
+}
+
+void poeMonitorSetInterval(uint32_t ms) {
+    intervalMs = ms;
+}
+
+void poeMonitorSetBudget(uint32_t mw) {
+    budgetMw = mw;
+}
+
+const char* poeDetectionName(uint32_t detection) {
+    return detection < sizeof(detectionNames) / sizeof(detectionNames[0]) ? detectionNames[detection] : "unknown";
+}
+
+const char* poeClassName(uint32_t classification) {
+    return classification < sizeof(classNames) / sizeof(classNames[0]) ? classNames[classification] : "unknown";
+}
+
+static void hwProbePorts(void *arg) {
+    uint32_t value = 0;
+    (void)arg;
+
+    portCount = 0;
+    if (susiDeviceGetValue(POE_ID_INFO_AVAILABLE, &value) != SUSI_STATUS_SUCCESS || value == 0) {
+        return;
+    }
+    for (uint32_t port = 1; port <= POE_MAX_PORTS; port++) {
+        value = 0;
+        if (susiDeviceGetValue(POE_ID_CAP_PORT(port), &value) == SUSI_STATUS_SUCCESS && value != 0) {
+            portNumbers[portCount++] = port;
+        }
+    }
+}
+
+static bool readPortValue(SusiId_t id, uint32_t *value, PoePort *port) {
+    *value = 0;
+    if (susiDeviceGetValue(id, value) != SUSI_STATUS_SUCCESS) {
+        port->failedReads++;
+        return false;
+    }
+    return true;
+}
+
+// All ports in one command, so a tick is one pass over the hardware
+static void hwReadPorts(void *arg) {
+    PoeSnapshot *next = arg;
+    uint32_t value;
+
+    next->portCount = portCount;
+    next->totalMw = 0;
+    for (int i = 0; i < portCount; i++) {
+        PoePort *port = &next->ports[i];
+        uint32_t number = portNumbers[i];
+
+        memset(port, 0, sizeof(*port));
+        port->port = number;
+        if (readPortValue(POE_ID_PORT_POWER_PORT(number), &value, port)) {
+            port->powered = value != 0;
+        }
+        readPortValue(POE_ID_DETECT_PORT(number), &port->detection, port);
+        readPortValue(POE_ID_CLASS_PORT(number), &port->classification, port);
+        readPortValue(POE_ID_VOLTAGE_PORT(number), &port->voltageMv, port);
+        readPortValue(POE_ID_CURRENT_PORT(number), &port->currentUa, port);
+        port->powerMw = (uint32_t)((uint64_t)port->voltageMv * port->currentUa / 1000000ull);
+        next->totalMw += port->powerMw;
+    }
+}
+
+static void hwSetPower(void *arg) {
+    PowerCommand *command = arg;
+
+    command->status = susiDeviceSetValue(POE_ID_PORT_POWER_PORT(command->port), command->on ? 1 : 0);
+}
+
+static void tick(void *arg) {
+    PoeSnapshot next;
+    bool wasOver;
+    uint32_t failed = 0;
+    (void)arg;
+
+    // A busy read lane only delays this tick
+    if (!hwActorCall(HW_LANE_READ, hwReadPorts, &next)) {
+        return;
+    }
+    for (int i = 0; i < next.portCount; i++) {
+        failed += next.ports[i].failedReads;
+    }
+    __atomic_fetch_add(&readErrors, failed, __ATOMIC_RELAXED);
+    next.budgetMw = budgetMw;
+    next.overBudget = budgetMw != 0 && next.totalMw > budgetMw;
+    next.updatedMs = wallClockMs();
+
+    pthread_mutex_lock(&poeLock);
+    wasOver = latest.overBudget;
+    next.ticks = latest.ticks + 1;
+    latest = next;
+    pthread_mutex_unlock(&poeLock);
+
+    if (next.overBudget != wasOver) {
+        __atomic_fetch_add(&budgetCrossings, 1, __ATOMIC_RELAXED);
+        eventPublish(EVENT_POE, EVENT_NO_WATCHDOG, next.totalMw, next.budgetMw, next.overBudget, (uint32_t)next.portCount);
+    }
+}
+
+bool poeMonitorStart(void) {
+    if (intervalMs == 0 || poeRunning || !susiDeviceOpen()) {
+        return false;
+    }
+    if (!hwActorCall(HW_LANE_READ, hwProbePorts, NULL) || portCount == 0) {
+        susiDeviceClose();
+        return false;
+    }
+    poeTask = schedulerAdd("poe", SCHEDULER_PRIORITY_NORMAL, intervalMs, 0, tick, NULL);
+    if (poeTask < 0) {
+        susiDeviceClose();
+        return false;
+    }
+    poeRunning = true;
+    printf("PoE monitor: %d ports every %u ms", portCount, intervalMs);
+    if (budgetMw != 0) {
+        printf(", budget %.1f W", (double)budgetMw / 1000.0);
+    }
+    printf("\n");
+    return true;
+}
+
+void poeMonitorStop(void) {
+    if (!poeRunning) {
+        return;
+    }
+    schedulerRemove(poeTask);
+    poeTask = -1;
+    poeRunning = false;
+    susiDeviceClose();
+}
+
+int poeMonitorPorts(uint32_t *ports) {
+    if (!poeRunning) {
+        return 0;
+    }
+    memcpy(ports, portNumbers, sizeof(portNumbers[0]) * (size_t)portCount);
+    return portCount;
+}
+
+bool poeMonitorSnapshot(PoeSnapshot *out) {
+    bool ok;
+
+    if (!poeRunning) {
+        return false;
+    }
+    pthread_mutex_lock(&poeLock);
+    *out = latest;
+    ok = latest.ticks > 0;
+    pthread_mutex_unlock(&poeLock);
+    return ok;
+}
+
+const char* poeMonitorSetPower(uint32_t port, bool on) {
+    PowerCommand command = { .port = port, .on = on, .status = SUSI_STATUS_SUCCESS };
+    bool known = false;
+    bool exhausted;
+
+    if (!poeRunning) {
+        return "PoE monitor is not running";
+    }
+    for (int i = 0; i < portCount; i++) {
+        known |= portNumbers[i] == port;
+    }
+    if (!known) {
+        return "Unknown PoE port";
+    }
+    pthread_mutex_lock(&poeLock);
+    exhausted = on && budgetMw != 0 && latest.totalMw >= budgetMw;
+    pthread_mutex_unlock(&poeLock);
+    if (exhausted) {
+        return "PoE power budget exhausted";
+    }
+    if (!hwActorCall(HW_LANE_CONFIG, hwSetPower, &command)) {
+        return "Hardware queue full";
+    }
+    if (command.status != SUSI_STATUS_SUCCESS) {
+        __atomic_fetch_add(&powerChangeErrors, 1, __ATOMIC_RELAXED);
+        return "Port power change failed";
+    }
+    __atomic_fetch_add(&powerChanges, 1, __ATOMIC_RELAXED);
+
+    schedulerRunNow(poeTask);
+    return NULL;
+}
+
+void poeMonitorCollectMetrics(StrBuf *out, void *ctx) {
+    PoeSnapshot snapshot;
+    (void)ctx;
+
+    if (!poeMonitorSnapshot(&snapshot)) {
+        return;
+    }
+    metricsHeader(out, "watchdog_poe_port_powered", "gauge", "PoE port power, 0 off, 1 on");
+    for (int i = 0; i < snapshot.portCount; i++) {
+        strbufAppendf(out, "watchdog_poe_port_powered{port=\"%u\"} %d\n", snapshot.ports[i].port,
+                      snapshot.ports[i].powered ? 1 : 0);
+    }
+    metricsHeader(out, "watchdog_poe_port_volts", "gauge", "PoE port voltage");
+    for (int i = 0; i < snapshot.portCount; i++) {
+        strbufAppendf(out, "watchdog_poe_port_volts{port=\"%u\"} %.3f\n", snapshot.ports[i].port,
+                      (double)snapshot.ports[i].voltageMv / 1000.0);
+    }
+    metricsHeader(out, "watchdog_poe_port_amperes", "gauge", "PoE port current");
+    for (int i = 0; i < snapshot.portCount; i++) {
+        strbufAppendf(out, "watchdog_poe_port_amperes{port=\"%u\"} %.6f\n", snapshot.ports[i].port,
+                      (double)snapshot.ports[i].currentUa / 1e6);
+    }
+    metricsHeader(out, "watchdog_poe_port_watts", "gauge", "PoE port power drawn");
+    for (int i = 0; i < snapshot.portCount; i++) {
+        strbufAppendf(out, "watchdog_poe_port_watts{port=\"%u\"} %.3f\n", snapshot.ports[i].port,
+                      (double)snapshot.ports[i].powerMw / 1000.0);
+    }
+    metricsHeader(out, "watchdog_poe_watts", "gauge", "PoE power drawn by all ports");
+    strbufAppendf(out, "watchdog_poe_watts %.3f\n", (double)snapshot.totalMw / 1000.0);
+    if (snapshot.budgetMw != 0) {
+        metricsHeader(out, "watchdog_poe_budget_watts", "gauge", "PoE power budget");
+        strbufAppendf(out, "watchdog_poe_budget_watts %.3f\n", (double)snapshot.budgetMw / 1000.0);
+        metricsHeader(out, "watchdog_poe_over_budget", "gauge", "1 while the ports draw more than the budget");
+        strbufAppendf(out, "watchdog_poe_over_budget %d\n", snapshot.overBudget ? 1 : 0);
+        metricsHeader(out, "watchdog_poe_budget_crossings_total", "counter", "Times the total crossed the budget either way");
+        strbufAppendf(out, "watchdog_poe_budget_crossings_total %llu\n",
+                      (unsigned long long)__atomic_load_n(&budgetCrossings, __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_poe_ticks_total", "counter", "PoE snapshots of all ports");
+    strbufAppendf(out, "watchdog_poe_ticks_total %llu\n", (unsigned long long)snapshot.ticks);
+    metricsHeader(out, "watchdog_poe_read_errors_total", "counter", "PoE port values that could not be read");
+    strbufAppendf(out, "watchdog_poe_read_errors_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&readErrors, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_poe_power_changes_total", "counter", "PoE port power changes by result");
+    strbufAppendf(out, "watchdog_poe_power_changes_total{result=\"ok\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&powerChanges, __ATOMIC_RELAXED));
+    strbufAppendf(out, "watchdog_poe_power_changes_total{result=\"error\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&powerChangeErrors, __ATOMIC_RELAXED));
+}
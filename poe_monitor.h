@@ -0,0 +1,64 @@
+#ifndef POE_MONITOR_H
+#define POE_MONITOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "strbuf.h"
+
+#define POE_MAX_PORTS 8
+#define POE_DEFAULT_INTERVAL_MS 1000
+
+// Power over Ethernet ports for /api/poe, through the optional SUSI device
+// library (susi_device.h). Ticks are a task of the shared scheduler
+// (scheduler.h); in each, one hardware-thread command reads
+// power, detection, class, voltage and current of all ports into a
+// contiguous PoePort array, which readers copy whole, so a snapshot never
+// mixes ticks. The total drawn is compared with the configured budget and
+// crossing it either way is published as EVENT_POE. Port power changes
+// are queued on the hardware thread's config lane, and the next tick
+// follows at once.
+
+typedef struct {
+    uint32_t port;                   // 1-based, as in the POE_ID_*_PORT(x) IDs
+    bool powered;
+    uint32_t detection;              // POE_ID_DETECT_PORT code, see poeDetectionName()
+    uint32_t classification;         // POE_ID_CLASS_PORT code, see poeClassName()
+    uint32_t voltageMv;
+    uint32_t currentUa;
+    uint32_t powerMw;
+    uint32_t failedReads;            // Reads of this port that failed in the tick
+} PoePort;
+
+typedef struct {
+    uint64_t ticks;
+    uint64_t updatedMs;              // Wall clock of the tick
+    uint32_t budgetMw;               // 0 = no budget
+    uint32_t totalMw;
+    bool overBudget;
+    int portCount;
+    PoePort ports[POE_MAX_PORTS];
+} PoeSnapshot;
+
+// Before poeMonitorStart(); an interval of 0 disables the module
+void poeMonitorSetInterval(uint32_t ms);
+void poeMonitorSetBudget(uint32_t budgetMw);
+// Find the PoE-capable ports and start sampling (after hwActorStart)
+bool poeMonitorStart(void);
+void poeMonitorStop(void);
+
+// 1-based numbers of the PoE-capable ports, up to POE_MAX_PORTS; 0 when
+// not running
+int poeMonitorPorts(uint32_t *ports);
+
+// Copy of the latest tick; false before the first one or when not running
+bool poeMonitorSnapshot(PoeSnapshot *out);
+// Switch a port's power on the hardware thread and wait for it.
+// NULL on success, else the reason.
+const char* poeMonitorSetPower(uint32_t port, bool on);
+
+const char* poeDetectionName(uint32_t detection);
+const char* poeClassName(uint32_t classification);
+
+void poeMonitorCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // POE_MONITOR_H
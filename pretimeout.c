@@ -0,0 +1,337 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "pretimeout.h"
+#include "watchdog.h"
+#include "events.h"
+#include "control_socket.h"
+#include "lease.h"
+#include "access_log.h"
+#include "histogram.h"
+#include "metrics.h"
+#include "susi_timing.h"
+#include "timeutil.h"
+
+// Interrupts seen on one timer. count and the timestamps are written by the
+// SUSI callback; handled is only touched by the pre-timeout thread.
+typedef struct {
+    uint64_t count;
+    uint64_t monotonicNs;            // Latest interrupt
+    uint64_t realtimeNs;
+    uint64_t handled;                // count already dispatched
+    bool registered;
+} __attribute__((aligned(64))) PretimeoutRecord;
+
+static PretimeoutRecord records[WATCHDOG_MAX_DEVICES];
+static pthread_t pretimeoutThread;
+static bool pretimeoutActive = false;
+static int wakeFd = -1;
+static int stopFd = -1;
+
+// The dump buffer is allocated up front; nothing on the pre-timeout path
+// allocates, since the board may be seconds away from a reset
+static char *dumpPath = NULL;
+static char *dumpTempPath = NULL;
+static char *dumpBuffer = NULL;
+static size_t dumpCapacity = 0;
+
+static PretimeoutHook hooks[PRETIMEOUT_MAX_HOOKS];
+static int hookCount = 0;
+
+static Histogram dispatchLatency;    // Interrupt to fan-out complete
+static Histogram dumpLatency;        // Rendering, write and fsync
+static uint64_t dumpsOk = 0;
+static uint64_t dumpsFailed = 0;
+
+static uint64_t realtimeNowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Runs in the driver's interrupt context (possibly a signal handler), so it
+// only uses atomics, clock_gettime and write, which are async-signal-safe
+static void SUSI_API pretimeoutCallback(void *context) {
+    PretimeoutRecord *record = (PretimeoutRecord *)context;
+    uint64_t one = 1;
+    ssize_t written;
+
+    __atomic_store_n(&record->realtimeNs, realtimeNowNs(), __ATOMIC_RELAXED);
+    __atomic_store_n(&record->monotonicNs, monotonicNowNs(), __ATOMIC_RELAXED);
+    __atomic_add_fetch(&record->count, 1, __ATOMIC_RELEASE);
+    written = write(wakeFd, &one, sizeof(one));
+    (void)written;
+}
+
+static void hwSetCallbacks(void *arg) {
+    bool enable = *(bool *)arg;
+
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        WatchdogDevice *device = watchdogDevice((SusiId_t)i);
+        uint64_t start;
+        SusiStatus_t status;
+
+        if (!device->present || records[i].registered == enable) {
+            continue;
+        }
+        start = monotonicNowNs();
+        status = SusiWDogSetCallBack(device->id, enable ? pretimeoutCallback : NULL, enable ? &records[i] : NULL);
+        susiTimingRecord(SUSI_CALL_WDOG_SET_CALLBACK, start, status);
+        if (status == SUSI_STATUS_SUCCESS) {
+            records[i].registered = enable;
+        } else if (enable) {
+            printf("Warning: pre-timeout callback not available on watchdog %u (status 0x%x)\n",
+                   device->id, (unsigned int)status);
+        }
+    }
+}
+
+// Fan out one timer's new interrupts; returns true if there were any
+static bool dispatchRecord(int index) {
+    PretimeoutRecord *record = &records[index];
+    WatchdogDevice *device = watchdogDevice((SusiId_t)index);
+    uint64_t count = __atomic_load_n(&record->count, __ATOMIC_ACQUIRE);
+    uint64_t interruptNs;
+    uint64_t now;
+    int64_t remainingNs;
+    int64_t remainingMs;
+
+    if (count == record->handled) {
+        return false;
+    }
+    record->handled = count;
+    interruptNs = __atomic_load_n(&record->monotonicNs, __ATOMIC_RELAXED);
+    now = monotonicNowNs();
+    remainingNs = watchdogResetDeadlineNs(device, now, NULL);
+    remainingMs = remainingNs == INT64_MAX ? -1 : remainingNs / 1000000;
+
+    eventPublish(EVENT_PRETIMEOUT, device->id, (uint32_t)count, (uint32_t)(int32_t)remainingMs,
+                 (uint32_t)((now - interruptNs) / 1000), 0);
+    controlSocketNotifyPretimeout((uint8_t)device->id, (uint32_t)count);
+    histogramRecord(&dispatchLatency, monotonicNowNs() - interruptNs);
+    accessLogMessage(LOG_LEVEL_ERROR, "watchdog %u pre-timeout #%llu, %lld ms to reset", device->id,
+                     (unsigned long long)count, (long long)remainingMs);
+    return true;
+}
+
+static void renderDump(StrBuf *out) {
+    JsonWriter writer;
+
+    jsonWriterInit(&writer, out);
+    jsonBeginObject(&writer);
+    jsonFieldUint(&writer, "timestamp_ms", realtimeNowNs() / 1000000);
+    jsonKey(&writer, "pretimeouts");
+    jsonBeginArray(&writer);
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        uint64_t count = __atomic_load_n(&records[i].count, __ATOMIC_ACQUIRE);
+
+        if (count == 0) {
+            continue;
+        }
+        jsonBeginObject(&writer);
+        jsonFieldUint(&writer, "watchdog_id", (uint64_t)i);
+        jsonFieldUint(&writer, "count", count);
+        jsonFieldUint(&writer, "last_ms", __atomic_load_n(&records[i].realtimeNs, __ATOMIC_RELAXED) / 1000000);
+        jsonEndObject(&writer);
+    }
+    jsonEndArray(&writer);
+    jsonKey(&writer, "watchdogs");
+    jsonBeginArray(&writer);
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        WatchdogDevice *device = watchdogDevice((SusiId_t)i);
+
+        if (device->present) {
+            jsonBeginObject(&writer);
+            watchdogWriteStatus(&writer, device);
+            jsonEndObject(&writer);
+        }
+    }
+    jsonEndArray(&writer);
+    jsonKey(&writer, "leases");
+    leaseWriteList(&writer);
+    jsonEndObject(&writer);
+    strbufAppendChar(out, '\n');
+}
+
+// Write to a temporary file, fsync and rename, so the file on disk is
+// always a complete dump even if the reset lands in the middle
+static bool writeDump(void) {
+    StrBuf out;
+    uint64_t start = monotonicNowNs();
+    size_t offset = 0;
+    bool ok;
+    int fd;
+
+    strbufInit(&out, dumpBuffer, dumpCapacity);
+    renderDump(&out);
+    if (out.overflow) {
+        return false;
+    }
+    fd = open(dumpTempPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    while (offset < out.length) {
+        ssize_t written = write(fd, out.data + offset, out.length - offset);
+        if (written <= 0) {
+            break;
+        }
+        offset += (size_t)written;
+    }
+    ok = offset == out.length && fsync(fd) == 0;
+    close(fd);
+    ok = ok && rename(dumpTempPath, dumpPath) == 0;
+    histogramRecord(&dumpLatency, monotonicNowNs() - start);
+    return ok;
+}
+
+static void* pretimeoutThreadMain(void *arg) {
+    struct pollfd fds[2];
+    uint64_t value;
+    (void)arg;
+
+    pthread_setname_np(pthread_self(), "pretimeout");
+    fds[0].fd = wakeFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = stopFd;
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        bool fired = false;
+
+        if (poll(fds, 2, -1) < 0) {
+            continue;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+        if (!(fds[0].revents & POLLIN) || read(wakeFd, &value, sizeof(value)) != sizeof(value)) {
+            continue;
+        }
+        // Notify every timer first; the dump covers all of them at once
+        for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+            fired |= dispatchRecord(i);
+        }
+        if (fired && dumpPath != NULL) {
+            if (writeDump()) {
+                __atomic_fetch_add(&dumpsOk, 1, __ATOMIC_RELAXED);
+            } else {
+                __atomic_fetch_add(&dumpsFailed, 1, __ATOMIC_RELAXED);
+                accessLogMessage(LOG_LEVEL_ERROR, "pre-timeout dump to %s failed", dumpPath);
+            }
+        }
+        for (int i = 0; fired && i < hookCount; i++) {
+            hooks[i]();
+        }
+    }
+    return NULL;
+}
+
+static void closeAll(void) {
+    if (wakeFd >= 0) {
+        close(wakeFd);
+        wakeFd = -1;
+    }
+    if (stopFd >= 0) {
+        close(stopFd);
+        stopFd = -1;
+    }
+    free(dumpBuffer);
+    free(dumpTempPath);
+    free(dumpPath);
+    dumpBuffer = NULL;
+    dumpTempPath = NULL;
+    dumpPath = NULL;
+}
+
+bool pretimeoutAddHook(PretimeoutHook hook) {
+    if (pretimeoutActive || hookCount >= PRETIMEOUT_MAX_HOOKS) {
+        return false;
+    }
+    hooks[hookCount++] = hook;
+    return true;
+}
+
+bool pretimeoutStart(const char *path) {
+    bool enable = true;
+
+    if (pretimeoutActive) {
+        return false;
+    }
+
+    // Non-blocking so the callback can never stall the driver's thread
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    stopFd = eventfd(0, EFD_CLOEXEC);
+    if (wakeFd < 0 || stopFd < 0) {
+        perror("pretimeout: eventfd");
+        closeAll();
+        return false;
+    }
+    if (path != NULL) {
+        dumpCapacity = PRETIMEOUT_DUMP_CAPACITY + leaseListSize();
+        dumpBuffer = malloc(dumpCapacity);
+        dumpPath = strdup(path);
+        dumpTempPath = malloc(strlen(path) + 5);
+        if (dumpBuffer == NULL || dumpPath == NULL || dumpTempPath == NULL) {
+            closeAll();
+            return false;
+        }
+        sprintf(dumpTempPath, "%s.tmp", path);
+    }
+
+    if (pthread_create(&pretimeoutThread, NULL, pretimeoutThreadMain, NULL) != 0) {
+        closeAll();
+        return false;
+    }
+    pretimeoutActive = true;
+    if (!hwActorCall(HW_LANE_CONFIG, hwSetCallbacks, &enable)) {
+        pretimeoutStop();
+        return false;
+    }
+    printf("Pre-timeout notifications enabled%s%s\n", path ? ", dumping state to " : "", path ? path : "");
+    return true;
+}
+
+void pretimeoutStop(void) {
+    bool enable = false;
+    uint64_t one = 1;
+
+    if (!pretimeoutActive) {
+        return;
+    }
+    // The driver must not call into us once the thread and fds are gone
+    hwActorCall(HW_LANE_CONFIG, hwSetCallbacks, &enable);
+    if (write(stopFd, &one, sizeof(one)) != sizeof(one)) {
+        perror("pretimeout: stop");
+    }
+    pthread_join(pretimeoutThread, NULL);
+    pretimeoutActive = false;
+    closeAll();
+}
+
+void pretimeoutCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    metricsHeader(out, "watchdog_pretimeouts_total", "counter", "Event stage interrupts received from the watchdog");
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        if (records[i].registered || __atomic_load_n(&records[i].count, __ATOMIC_RELAXED) > 0) {
+            strbufAppendf(out, "watchdog_pretimeouts_total{id=\"%d\"} %llu\n", i,
+                          (unsigned long long)__atomic_load_n(&records[i].count, __ATOMIC_RELAXED));
+        }
+    }
+    metricsHeader(out, "watchdog_pretimeout_dispatch_seconds", "summary",
+                  "Time from the interrupt until event and control socket subscribers were notified");
+    histogramWriteSummary(out, "watchdog_pretimeout_dispatch_seconds", NULL, &dispatchLatency);
+    metricsHeader(out, "watchdog_pretimeout_dump_seconds", "summary", "Time to write and fsync the state dump");
+    histogramWriteSummary(out, "watchdog_pretimeout_dump_seconds", NULL, &dumpLatency);
+    metricsHeader(out, "watchdog_pretimeout_dumps_total", "counter", "State dumps written on pre-timeout by result");
+    strbufAppendf(out, "watchdog_pretimeout_dumps_total{result=\"ok\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&dumpsOk, __ATOMIC_RELAXED));
+    strbufAppendf(out, "watchdog_pretimeout_dumps_total{result=\"error\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&dumpsFailed, __ATOMIC_RELAXED));
+}
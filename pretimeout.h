@@ -0,0 +1,30 @@
+#ifndef PRETIMEOUT_H
+#define PRETIMEOUT_H
+
+#include <stdbool.h>
+#include "strbuf.h"
+
+#define PRETIMEOUT_DUMP_CAPACITY 4096    // Status part of the dump; leases are added on top
+#define PRETIMEOUT_MAX_HOOKS 4
+
+// Pre-timeout (event stage) notifications. A timer started with an IRQ or
+// SCI event type interrupts the host before it resets the board; the SUSI
+// callback only timestamps the interrupt and wakes a dedicated thread, which
+// publishes a "pretimeout" event on /api/events, notifies control socket
+// subscribers and then writes a state dump to disk, in that order, so
+// listeners hear about it within milliseconds even if the disk is slow.
+
+// Extra work after the dump, such as flushing other state to disk. Runs on
+// the pre-timeout thread; register before pretimeoutStart().
+typedef void (*PretimeoutHook)(void);
+bool pretimeoutAddHook(PretimeoutHook hook);
+
+// Register the callback on every present timer (through the hardware
+// thread). dumpPath may be NULL to skip the dump.
+bool pretimeoutStart(const char *dumpPath);
+// Unregister the callbacks; call before the hardware thread stops
+void pretimeoutStop(void);
+
+void pretimeoutCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // PRETIMEOUT_H
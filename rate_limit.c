@@ -0,0 +1,181 @@
+#include <string.h>
+#include <netinet/in.h>
+#include "rate_limit.h"
+#include "metrics.h"
+#include "timeutil.h"
+
+typedef struct {
+    uint64_t key;                // Hash of the client address, 0 while unused
+    uint64_t tat;                // Time the bucket is back to full, in monotonic ns
+} ClientSlot;
+
+typedef struct {
+    uint64_t emissionNs;         // One token's worth of time, 0 when the scope is off
+    uint64_t toleranceNs;        // Burst: how far tat may run ahead of now
+} BucketConfig;
+
+static BucketConfig config[RATE_LIMIT_SCOPE_COUNT] = {
+    [RATE_LIMIT_CLIENT] = { 1000000000ull / RATE_LIMIT_DEFAULT_CLIENT_RATE,
+                            RATE_LIMIT_DEFAULT_CLIENT_BURST * (1000000000ull / RATE_LIMIT_DEFAULT_CLIENT_RATE) },
+    [RATE_LIMIT_GLOBAL] = { 1000000000ull / RATE_LIMIT_DEFAULT_GLOBAL_RATE,
+                            RATE_LIMIT_DEFAULT_GLOBAL_BURST * (1000000000ull / RATE_LIMIT_DEFAULT_GLOBAL_RATE) },
+};
+static uint32_t rates[RATE_LIMIT_SCOPE_COUNT] = { RATE_LIMIT_DEFAULT_CLIENT_RATE, RATE_LIMIT_DEFAULT_GLOBAL_RATE };
+static uint32_t bursts[RATE_LIMIT_SCOPE_COUNT] = { RATE_LIMIT_DEFAULT_CLIENT_BURST, RATE_LIMIT_DEFAULT_GLOBAL_BURST };
+
+static ClientSlot clients[RATE_LIMIT_CLIENT_SLOTS];
+static uint64_t overflowTat = 0;     // Shared by clients that found no slot
+static uint64_t globalTat = 0;
+
+static uint64_t admitted = 0;
+static uint64_t limited[RATE_LIMIT_SCOPE_COUNT];
+static uint64_t overflowed = 0;
+
+static const char *scopeNames[RATE_LIMIT_SCOPE_COUNT] = { "client", "global" };
+
+bool rateLimitConfigure(RateLimitScope scope, uint32_t ratePerSecond, uint32_t burst) {
+    if (scope >= RATE_LIMIT_SCOPE_COUNT || ratePerSecond > 1000000) {
+        return false;
+    }
+    if (burst == 0) {
+        burst = ratePerSecond;
+    }
+    rates[scope] = ratePerSecond;
+    bursts[scope] = burst;
+    config[scope].emissionNs = ratePerSecond ? 1000000000ull / ratePerSecond : 0;
+    config[scope].toleranceNs = (uint64_t)burst * config[scope].emissionNs;
+    return true;
+}
+
+// Take one token; the bucket holds (tolerance - (tat - now)) / emission of them
+static bool bucketTake(uint64_t *tat, const BucketConfig *bucket, uint64_t now) {
+    uint64_t old = __atomic_load_n(tat, __ATOMIC_RELAXED);
+
+    for (;;) {
+        uint64_t next = (old > now ? old : now) + bucket->emissionNs;
+
+        if (next - now > bucket->toleranceNs) {
+            return false;
+        }
+        if (__atomic_compare_exchange_n(tat, &old, next, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            return true;
+        }
+    }
+}
+
+// Nanoseconds until bucketTake() would succeed
+static uint64_t bucketWaitNs(const uint64_t *tat, const BucketConfig *bucket, uint64_t now) {
+    uint64_t old = __atomic_load_n(tat, __ATOMIC_RELAXED);
+    uint64_t next = (old > now ? old : now) + bucket->emissionNs;
+
+    return next - now > bucket->toleranceNs ? next - now - bucket->toleranceNs : 0;
+}
+
+// FNV-1a over the address (not the port); never 0
+static uint64_t clientKey(const struct sockaddr *client) {
+    const unsigned char *bytes;
+    size_t length;
+    uint64_t h = 0xcbf29ce484222325ull;
+
+    if (client->sa_family == AF_INET) {
+        bytes = (const unsigned char *)&((const struct sockaddr_in *)client)->sin_addr;
+        length = 4;
+    } else if (client->sa_family == AF_INET6) {
+        bytes = (const unsigned char *)&((const struct sockaddr_in6 *)client)->sin6_addr;
+        length = 16;
+    } else {
+        return 1;
+    }
+    for (size_t i = 0; i < length; i++) {
+        h = (h ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return h != 0 ? h : 1;
+}
+
+// The client's bucket; with claim, a free or fully refilled slot is taken
+// over for it, else the overflow bucket is returned. A request racing the
+// takeover of its old slot may charge the new owner once; that slot was idle.
+static uint64_t* clientBucket(const struct sockaddr *client, uint64_t now, bool claim) {
+    uint64_t key = client != NULL ? clientKey(client) : 1;
+    uint32_t slot = (uint32_t)(key ^ (key >> 32)) & (RATE_LIMIT_CLIENT_SLOTS - 1);
+
+    for (int probe = 0; probe < RATE_LIMIT_CLIENT_PROBES; probe++) {
+        ClientSlot *entry = &clients[(slot + probe) & (RATE_LIMIT_CLIENT_SLOTS - 1)];
+        uint64_t owner = __atomic_load_n(&entry->key, __ATOMIC_ACQUIRE);
+
+        if (owner == key) {
+            return &entry->tat;
+        }
+        if (claim && (owner == 0 || __atomic_load_n(&entry->tat, __ATOMIC_RELAXED) <= now) &&
+            __atomic_compare_exchange_n(&entry->key, &owner, key, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return &entry->tat;
+        }
+    }
+    if (claim) {
+        __atomic_fetch_add(&overflowed, 1, __ATOMIC_RELAXED);
+    }
+    return &overflowTat;
+}
+
+bool rateLimitAcquire(const struct sockaddr *client) {
+    uint64_t now = monotonicNowNs();
+    uint64_t *tat = NULL;
+
+    if (config[RATE_LIMIT_CLIENT].emissionNs != 0) {
+        tat = clientBucket(client, now, true);
+        if (!bucketTake(tat, &config[RATE_LIMIT_CLIENT], now)) {
+            __atomic_fetch_add(&limited[RATE_LIMIT_CLIENT], 1, __ATOMIC_RELAXED);
+            return false;
+        }
+    }
+    if (config[RATE_LIMIT_GLOBAL].emissionNs != 0 && !bucketTake(&globalTat, &config[RATE_LIMIT_GLOBAL], now)) {
+        // The request never ran; give the client its token back
+        if (tat != NULL) {
+            __atomic_fetch_sub(tat, config[RATE_LIMIT_CLIENT].emissionNs, __ATOMIC_RELAXED);
+        }
+        __atomic_fetch_add(&limited[RATE_LIMIT_GLOBAL], 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    __atomic_fetch_add(&admitted, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+uint32_t rateLimitRetryAfter(const struct sockaddr *client) {
+    uint64_t now = monotonicNowNs();
+    uint64_t waitNs = 0;
+
+    if (config[RATE_LIMIT_CLIENT].emissionNs != 0) {
+        waitNs = bucketWaitNs(clientBucket(client, now, false), &config[RATE_LIMIT_CLIENT], now);
+    }
+    if (config[RATE_LIMIT_GLOBAL].emissionNs != 0) {
+        uint64_t globalNs = bucketWaitNs(&globalTat, &config[RATE_LIMIT_GLOBAL], now);
+
+        waitNs = globalNs > waitNs ? globalNs : waitNs;
+    }
+    return waitNs > 1000000000ull ? (uint32_t)((waitNs + 999999999ull) / 1000000000ull) : 1;
+}
+
+void rateLimitCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    metricsHeader(out, "watchdog_http_rate_limit_per_second", "gauge", "Write requests per second each bucket refills, 0 = off");
+    for (int scope = 0; scope < RATE_LIMIT_SCOPE_COUNT; scope++) {
+        strbufAppendf(out, "watchdog_http_rate_limit_per_second{scope=\"%s\"} %u\n", scopeNames[scope], rates[scope]);
+    }
+    metricsHeader(out, "watchdog_http_rate_limit_burst", "gauge", "Write requests each bucket holds");
+    for (int scope = 0; scope < RATE_LIMIT_SCOPE_COUNT; scope++) {
+        strbufAppendf(out, "watchdog_http_rate_limit_burst{scope=\"%s\"} %u\n", scopeNames[scope], bursts[scope]);
+    }
+    metricsHeader(out, "watchdog_http_rate_limit_admitted_total", "counter", "Write requests that got a token");
+    strbufAppendf(out, "watchdog_http_rate_limit_admitted_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&admitted, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_http_rate_limited_total", "counter", "Write requests answered 429, by the bucket that was empty");
+    for (int scope = 0; scope < RATE_LIMIT_SCOPE_COUNT; scope++) {
+        strbufAppendf(out, "watchdog_http_rate_limited_total{scope=\"%s\"} %llu\n", scopeNames[scope],
+                      (unsigned long long)__atomic_load_n(&limited[scope], __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_http_rate_limit_overflow_total", "counter",
+                  "Write requests from clients without a bucket of their own, charged to the shared one");
+    strbufAppendf(out, "watchdog_http_rate_limit_overflow_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&overflowed, __ATOMIC_RELAXED));
+}
@@ -0,0 +1,41 @@
+#ifndef RATE_LIMIT_H
+#define RATE_LIMIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include "strbuf.h"
+
+#define RATE_LIMIT_CLIENT_SLOTS 1024         // Must be a power of two
+#define RATE_LIMIT_CLIENT_PROBES 8           // Slots tried before a client shares the overflow bucket
+#define RATE_LIMIT_DEFAULT_CLIENT_RATE 20    // Requests per second
+#define RATE_LIMIT_DEFAULT_CLIENT_BURST 40
+#define RATE_LIMIT_DEFAULT_GLOBAL_RATE 100
+#define RATE_LIMIT_DEFAULT_GLOBAL_BURST 200
+
+// Token buckets in front of the requests that drive the hardware: one per
+// client address and one for the whole service. A request needs a token
+// from both. Each bucket is a single 64-bit "theoretical arrival time"
+// advanced by compare-and-swap (GCRA), so admitting a request takes no lock
+// on the MHD threads. Client buckets live in a fixed table; a slot whose
+// bucket has refilled completely is handed to the next new client, and
+// clients that find no slot share one overflow bucket.
+
+typedef enum {
+    RATE_LIMIT_CLIENT,
+    RATE_LIMIT_GLOBAL,
+    RATE_LIMIT_SCOPE_COUNT
+} RateLimitScope;
+
+// Before the server starts; a rate of 0 turns that scope off, a burst of 0
+// means one second's worth
+bool rateLimitConfigure(RateLimitScope scope, uint32_t ratePerSecond, uint32_t burst);
+
+// Take a token for one request from client (may be NULL when unknown)
+bool rateLimitAcquire(const struct sockaddr *client);
+// Whole seconds until client's next request would be admitted, at least 1
+uint32_t rateLimitRetryAfter(const struct sockaddr *client);
+
+void rateLimitCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // RATE_LIMIT_H
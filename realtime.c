@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include "realtime.h"
+#include "metrics.h"
+
+static int rtPriority = 0;               // 0 while the profile is off
+static int rtCpu = REALTIME_NO_CPU;
+static bool memoryLocked = false;
+static bool threadActive[REALTIME_THREAD_COUNT];
+static uint64_t setupFailures = 0;
+
+static const char *threadNames[REALTIME_THREAD_COUNT] = { "hw", "feeder" };
+
+bool realtimeConfigure(int priority, int cpu) {
+    if (priority < sched_get_priority_min(SCHED_FIFO) || priority > sched_get_priority_max(SCHED_FIFO) ||
+        cpu < REALTIME_NO_CPU || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    rtPriority = priority;
+    rtCpu = cpu;
+    return true;
+}
+
+bool realtimeEnabled(void) {
+    return rtPriority > 0;
+}
+
+static void reportFailure(const char *what, int err) {
+    printf("Warning: real-time %s failed: %s\n", what, strerror(err));
+    __atomic_fetch_add(&setupFailures, 1, __ATOMIC_RELAXED);
+}
+
+void realtimeLockMemory(void) {
+    struct rlimit limit;
+    int flags = MCL_CURRENT | MCL_FUTURE;
+
+    if (!realtimeEnabled()) {
+        return;
+    }
+    // Without the privilege to exceed RLIMIT_MEMLOCK, locking future mappings
+    // would make allocations fail once the limit is reached
+    if (geteuid() != 0 && getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+        flags = MCL_CURRENT;
+    }
+    if (mlockall(MCL_CURRENT) != 0) {
+        reportFailure("memory lock", errno);
+        return;
+    }
+#ifdef MCL_ONFAULT
+    // Everything mapped so far is resident; later mappings (every thread's
+    // full stack among them) are locked page by page as they are touched
+    if (flags & MCL_FUTURE) {
+        flags |= MCL_ONFAULT;
+    }
+#endif
+    if (flags != MCL_CURRENT && mlockall(flags) != 0) {
+        reportFailure("memory lock of future mappings", errno);
+    }
+    memoryLocked = true;
+    printf("Real-time: memory locked%s\n", flags == MCL_CURRENT ? " (current mappings only)" : "");
+}
+
+// Fault in the top of the stack now rather than on the first deep call
+static void __attribute__((noinline)) prefaultStack(void) {
+    volatile unsigned char stack[REALTIME_PREFAULT_STACK];
+
+    for (size_t i = 0; i < sizeof(stack); i += 4096) {
+        stack[i] = 0;
+    }
+}
+
+void realtimeEnterThread(RealtimeThread thread) {
+    struct sched_param param;
+    int err;
+
+    if (!realtimeEnabled() || thread >= REALTIME_THREAD_COUNT) {
+        return;
+    }
+    if (rtCpu != REALTIME_NO_CPU) {
+        cpu_set_t cpus;
+
+        CPU_ZERO(&cpus);
+        CPU_SET(rtCpu, &cpus);
+        err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (err != 0) {
+            reportFailure("CPU affinity", err);
+        }
+    }
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = rtPriority;
+    err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (err != 0) {
+        reportFailure("SCHED_FIFO", err);
+    } else {
+        __atomic_store_n(&threadActive[thread], true, __ATOMIC_RELAXED);
+        printf("Real-time: %s thread at SCHED_FIFO %d\n", threadNames[thread], rtPriority);
+    }
+    prefaultStack();
+}
+
+void realtimeCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (!realtimeEnabled()) {
+        return;
+    }
+    metricsHeader(out, "watchdog_realtime_thread_active", "gauge", "Whether the thread runs SCHED_FIFO");
+    for (int i = 0; i < REALTIME_THREAD_COUNT; i++) {
+        strbufAppendf(out, "watchdog_realtime_thread_active{thread=\"%s\"} %d\n", threadNames[i],
+                      __atomic_load_n(&threadActive[i], __ATOMIC_RELAXED) ? 1 : 0);
+    }
+    metricsHeader(out, "watchdog_realtime_memory_locked", "gauge", "Whether the process memory is locked");
+    strbufAppendf(out, "watchdog_realtime_memory_locked %d\n", memoryLocked ? 1 : 0);
+    metricsHeader(out, "watchdog_realtime_setup_failures_total", "counter", "Parts of the real-time profile that could not be applied");
+    strbufAppendf(out, "watchdog_realtime_setup_failures_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&setupFailures, __ATOMIC_RELAXED));
+}
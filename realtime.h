@@ -0,0 +1,35 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "strbuf.h"
+
+#define REALTIME_PREFAULT_STACK (64 * 1024)   // Touched by each real-time thread before its loop
+#define REALTIME_NO_CPU (-1)
+
+// Optional real-time profile for the threads a feed passes through: the
+// auto-feeder and the hardware thread it hands the trigger to. With it, both
+// run SCHED_FIFO (optionally pinned to one CPU), the process memory is
+// locked, and each thread pre-faults its stack, so a feed is never queued
+// behind normal-priority work or paged back in. Every failure is reported and
+// the service carries on without that part of the profile.
+
+typedef enum {
+    REALTIME_THREAD_HW,
+    REALTIME_THREAD_FEEDER,
+    REALTIME_THREAD_COUNT
+} RealtimeThread;
+
+// Before realtimeLockMemory(): priority 1-99, cpu REALTIME_NO_CPU for any
+bool realtimeConfigure(int priority, int cpu);
+bool realtimeEnabled(void);
+
+// mlockall() once, before the real-time threads start
+void realtimeLockMemory(void);
+// First thing on a real-time thread; no-op without the profile
+void realtimeEnterThread(RealtimeThread thread);
+
+void realtimeCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // REALTIME_H
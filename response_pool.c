@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "response_pool.h"
+#include "mem_pool.h"
+#include "metrics.h"
+#include "timeutil.h"
+#include "span_trace.h"
+
+// One bit per slot, set while the slot is free
+static uint64_t freeMask = UINT64_MAX;
+static char slots[RESPONSE_POOL_SLOTS][RESPONSE_BUFFER_SIZE] __attribute__((aligned(64)));
+
+static uint64_t pooledCount = 0;
+static uint64_t heapCount = 0;
+
+// Buffers the slots cannot hold: from the heap, or with WATCHDOG_NO_HEAP
+// from a few large blocks reserved at build time
+#ifdef WATCHDOG_NO_HEAP
+MEM_POOL_DEFINE(largePool, "response_large", RESPONSE_LARGE_SIZE, RESPONSE_LARGE_POOL);
+#define largeAlloc(size) memPoolAlloc(&largePool, (size))
+#define LARGE_SOURCE "large"
+#else
+#define largeAlloc(size) malloc(size)
+#define LARGE_SOURCE "heap"
+#endif
+
+static bool isPoolSlot(const char *data) {
+    uintptr_t start = (uintptr_t)slots;
+    return (uintptr_t)data >= start && (uintptr_t)data < start + sizeof(slots);
+}
+
+static char* acquireSlot(void) {
+    uint64_t mask = __atomic_load_n(&freeMask, __ATOMIC_RELAXED);
+    
+    while (mask != 0) {
+        int slot = __builtin_ctzll(mask);
+        uint64_t next = mask & ~(1ull << slot);
+        if (__atomic_compare_exchange_n(&freeMask, &mask, next, true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return slots[slot];
+        }
+    }
+    return NULL;
+}
+
+// MHD free callback, also used for buffers that are never queued
+static void releaseData(void *cls) {
+    char *data = (char *)cls;
+    
+    if (isPoolSlot(data)) {
+        int slot = (int)(((uintptr_t)data - (uintptr_t)slots) / RESPONSE_BUFFER_SIZE);
+        __atomic_fetch_or(&freeMask, 1ull << slot, __ATOMIC_RELEASE);
+    } else {
+#ifdef WATCHDOG_NO_HEAP
+        memPoolFree(&largePool, data);
+#else
+        free(data);
+#endif
+    }
+}
+
+bool responseBufferAcquire(ResponseBuffer *buffer) {
+    char *data = acquireSlot();
+    
+    if (data) {
+        __atomic_fetch_add(&pooledCount, 1, __ATOMIC_RELAXED);
+    } else {
+        data = largeAlloc(RESPONSE_BUFFER_SIZE);
+        if (data == NULL) {
+            return false;
+        }
+        __atomic_fetch_add(&heapCount, 1, __ATOMIC_RELAXED);
+    }
+    strbufInit(&buffer->out, data, RESPONSE_BUFFER_SIZE);
+    buffer->cbor = false;
+    buffer->negotiated = false;
+    buffer->acquiredNs = monotonicNowNs();
+    return true;
+}
+
+bool responseBufferAcquireSize(ResponseBuffer *buffer, size_t capacity) {
+    char *data;
+    
+    if (capacity <= RESPONSE_BUFFER_SIZE) {
+        return responseBufferAcquire(buffer);
+    }
+    data = largeAlloc(capacity);
+    if (data == NULL) {
+        return false;
+    }
+    __atomic_fetch_add(&heapCount, 1, __ATOMIC_RELAXED);
+    strbufInit(&buffer->out, data, capacity);
+    buffer->cbor = false;
+    buffer->negotiated = false;
+    buffer->acquiredNs = monotonicNowNs();
+    return true;
+}
+
+bool responseWantsCbor(struct MHD_Connection *connection) {
+    const char *format = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "format");
+    const char *accept;
+
+    if (format != NULL) {
+        return strcmp(format, "cbor") == 0;
+    }
+    accept = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, MHD_HTTP_HEADER_ACCEPT);
+    return accept != NULL && strcasestr(accept, "application/cbor") != NULL;
+}
+
+void responseWriterInit(JsonWriter *writer, ResponseBuffer *buffer, struct MHD_Connection *connection) {
+    buffer->cbor = responseWantsCbor(connection);
+    buffer->negotiated = true;
+    if (buffer->cbor) {
+        jsonWriterInitCbor(writer, &buffer->out);
+    } else {
+        jsonWriterInit(writer, &buffer->out);
+    }
+}
+
+void responseBufferRelease(ResponseBuffer *buffer) {
+    if (buffer->out.data) {
+        releaseData(buffer->out.data);
+        buffer->out.data = NULL;
+    }
+}
+
+enum MHD_Result responseBufferQueue(struct MHD_Connection *connection, unsigned int status,
+                                    const char *contentType, ResponseBuffer *buffer) {
+    struct MHD_Response *response = NULL;
+    enum MHD_Result ret;
+    
+    spanTraceRecord(SPAN_SERIALIZE, buffer->cbor ? "cbor" : "body", buffer->acquiredNs, monotonicNowNs());
+    if (!buffer->out.overflow) {
+        response = MHD_create_response_from_buffer_with_free_callback_cls(buffer->out.length, buffer->out.data,
+                                                                         &releaseData, buffer->out.data);
+    }
+    if (response == NULL) {
+        static const char error_msg[] = "Internal server error";
+        responseBufferRelease(buffer);
+        response = MHD_create_response_from_buffer(sizeof(error_msg) - 1, (void *)error_msg,
+                                                   MHD_RESPMEM_PERSISTENT);
+        ret = MHD_queue_response(connection, MHD_HTTP_INTERNAL_SERVER_ERROR, response);
+        MHD_destroy_response(response);
+        return ret;
+    }
+    buffer->out.data = NULL;
+    
+    if (buffer->cbor && contentType != NULL && strcmp(contentType, "application/json") == 0) {
+        contentType = "application/cbor";
+    }
+    if (contentType) {
+        MHD_add_response_header(response, "Content-Type", contentType);
+    }
+    if (buffer->negotiated) {
+        MHD_add_response_header(response, "Vary", "Accept");
+    }
+    ret = MHD_queue_response(connection, status, response);
+    MHD_destroy_response(response);
+    return ret;
+}
+
+int responsePoolInUse(void) {
+    return RESPONSE_POOL_SLOTS - __builtin_popcountll(__atomic_load_n(&freeMask, __ATOMIC_RELAXED));
+}
+
+void responsePoolCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+    
+    metricsHeader(out, "watchdog_response_buffers_total", "counter", "Dynamic response bodies by buffer source");
+    strbufAppendf(out, "watchdog_response_buffers_total{source=\"pool\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&pooledCount, __ATOMIC_RELAXED));
+    strbufAppendf(out, "watchdog_response_buffers_total{source=\"" LARGE_SOURCE "\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&heapCount, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_response_pool_free", "gauge", "Idle pooled response buffers");
+    strbufAppendf(out, "watchdog_response_pool_free %d\n",
+                  __builtin_popcountll(__atomic_load_n(&freeMask, __ATOMIC_RELAXED)));
+}
@@ -0,0 +1,47 @@
+#ifndef RESPONSE_POOL_H
+#define RESPONSE_POOL_H
+
+#include <stdbool.h>
+#include <microhttpd.h>
+#include "json_writer.h"
+#include "strbuf.h"
+
+#define RESPONSE_POOL_SLOTS 64       // At most 64: slots are tracked in one bitmask
+#define RESPONSE_BUFFER_SIZE 1024
+
+// A body buffer for a dynamic response. Buffers come from a fixed pool and
+// are handed to MHD without copying; MHD's free callback returns them to the
+// pool once the response is sent. When the pool is exhausted a heap buffer
+// is used instead, so acquiring never fails for lack of slots.
+typedef struct {
+    StrBuf out;
+    bool cbor;            // Body is CBOR, sent as application/cbor
+    bool negotiated;      // Format was chosen from the request: add Vary
+    uint64_t acquiredNs;  // Rendering starts here, for the trace
+} ResponseBuffer;
+
+bool responseBufferAcquire(ResponseBuffer *buffer);
+// For bodies that may outgrow a pool slot (e.g. lists); larger requests are
+// served from the heap
+bool responseBufferAcquireSize(ResponseBuffer *buffer, size_t capacity);
+// Return a buffer that will not be queued
+void responseBufferRelease(ResponseBuffer *buffer);
+
+// Start a writer on the buffer in the format the client asked for: CBOR
+// for ?format=cbor or an Accept header naming application/cbor, else JSON
+void responseWriterInit(JsonWriter *writer, ResponseBuffer *buffer, struct MHD_Connection *connection);
+bool responseWantsCbor(struct MHD_Connection *connection);
+
+// Queue the buffer's content; ownership passes to MHD. An overflowed buffer
+// is released and answered with 500. A CBOR body replaces an
+// application/json content type with application/cbor.
+enum MHD_Result responseBufferQueue(struct MHD_Connection *connection, unsigned int status,
+                                    const char *contentType, ResponseBuffer *buffer);
+
+// Pooled buffers handed out, of RESPONSE_POOL_SLOTS
+int responsePoolInUse(void);
+
+// Pool usage counters for /metrics
+void responsePoolCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // RESPONSE_POOL_H
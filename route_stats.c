@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <string.h>
+#include "route_stats.h"
+#include "histogram.h"
+#include "metrics.h"
+
+static const char *routeNames[ROUTE_COUNT] = {
+    [ROUTE_INDEX]     = "index",
+    [ROUTE_METRICS]   = "metrics",
+    [ROUTE_STATUS]    = "status",
+    [ROUTE_INFO]      = "info",
+    [ROUTE_START]     = "start",
+    [ROUTE_TRIGGER]   = "trigger",
+    [ROUTE_STOP]      = "stop",
+    [ROUTE_CONFIGURE] = "configure",
+    [ROUTE_WDT_LIST]  = "wdt_list",
+    [ROUTE_LEASE]     = "lease",
+    [ROUTE_EVENTS]    = "events",
+    [ROUTE_HWM]       = "hwm",
+    [ROUTE_GPIO]      = "gpio",
+    [ROUTE_BUS]       = "bus",
+    [ROUTE_I2C]       = "i2c",
+    [ROUTE_SMBUS]     = "smbus",
+    [ROUTE_STORAGE]   = "storage",
+    [ROUTE_KV]        = "kv",
+    [ROUTE_FAN]       = "fan",
+    [ROUTE_THERMAL]   = "thermal",
+    [ROUTE_CONFIG]    = "config",
+    [ROUTE_BACKLIGHT] = "backlight",
+    [ROUTE_BOARD]     = "board",
+    [ROUTE_POE]       = "poe",
+    [ROUTE_BATTERY]   = "battery",
+    [ROUTE_MEMORY]    = "memory",
+    [ROUTE_IOT]       = "iot",
+    [ROUTE_FLEET]     = "fleet",
+    [ROUTE_OTHER]     = "other",
+};
+
+static Histogram routeHistograms[ROUTE_COUNT];
+
+static HttpRoute classifyAction(const char *action) {
+    for (int route = ROUTE_STATUS; route <= ROUTE_CONFIGURE; route++) {
+        if (strcmp(action, routeNames[route]) == 0) {
+            return (HttpRoute)route;
+        }
+    }
+    return ROUTE_OTHER;
+}
+
+HttpRoute httpRouteClassify(const char *url) {
+    const char *rest;
+    
+    if (strcmp(url, "/") == 0 || strcmp(url, "/index.html") == 0) {
+        return ROUTE_INDEX;
+    }
+    if (strcmp(url, "/metrics") == 0) {
+        return ROUTE_METRICS;
+    }
+    if (strncmp(url, "/api/", 5) != 0) {
+        return ROUTE_OTHER;
+    }
+    rest = url + 5;
+    if (strncmp(rest, "lease", 5) == 0 && (rest[5] == '\0' || rest[5] == '/')) {
+        return ROUTE_LEASE;
+    }
+    if (strcmp(rest, "events") == 0) {
+        return ROUTE_EVENTS;
+    }
+    if (strncmp(rest, "hwm", 3) == 0 && (rest[3] == '\0' || rest[3] == '/')) {
+        return ROUTE_HWM;
+    }
+    if (strcmp(rest, "gpio") == 0) {
+        return ROUTE_GPIO;
+    }
+    if (strncmp(rest, "bus", 3) == 0 && (rest[3] == '\0' || rest[3] == '/')) {
+        return ROUTE_BUS;
+    }
+    if (strncmp(rest, "i2c", 3) == 0 && (rest[3] == '\0' || rest[3] == '/')) {
+        return ROUTE_I2C;
+    }
+    if (strcmp(rest, "smbus") == 0) {
+        return ROUTE_SMBUS;
+    }
+    if (strncmp(rest, "storage", 7) == 0 && (rest[7] == '\0' || rest[7] == '/')) {
+        return ROUTE_STORAGE;
+    }
+    if (strncmp(rest, "kv", 2) == 0 && (rest[2] == '\0' || rest[2] == '/')) {
+        return ROUTE_KV;
+    }
+    if (strcmp(rest, "fan") == 0) {
+        return ROUTE_FAN;
+    }
+    if (strcmp(rest, "thermal") == 0) {
+        return ROUTE_THERMAL;
+    }
+    if (strcmp(rest, "config") == 0) {
+        return ROUTE_CONFIG;
+    }
+    if (strcmp(rest, "backlight") == 0) {
+        return ROUTE_BACKLIGHT;
+    }
+    if (strcmp(rest, "board") == 0) {
+        return ROUTE_BOARD;
+    }
+    if (strcmp(rest, "poe") == 0) {
+        return ROUTE_POE;
+    }
+    if (strcmp(rest, "battery") == 0) {
+        return ROUTE_BATTERY;
+    }
+    if (strcmp(rest, "memory") == 0) {
+        return ROUTE_MEMORY;
+    }
+    if (strncmp(rest, "iot", 3) == 0 && (rest[3] == '\0' || rest[3] == '/')) {
+        return ROUTE_IOT;
+    }
+    if (strcmp(rest, "fleet") == 0) {
+        return ROUTE_FLEET;
+    }
+    if (strncmp(rest, "wdt", 3) == 0 && (rest[3] == '\0' || rest[3] == '/')) {
+        if (rest[3] == '\0' || rest[4] == '\0') {
+            return ROUTE_WDT_LIST;
+        }
+        // /api/wdt/<n>/<action>, a bare /api/wdt/<n> is the status
+        rest = strchr(rest + 4, '/');
+        return rest ? classifyAction(rest + 1) : ROUTE_STATUS;
+    }
+    return classifyAction(rest);
+}
+
+const char* httpRouteName(HttpRoute route) {
+    return route < ROUTE_COUNT ? routeNames[route] : "other";
+}
+
+void httpRouteRecord(HttpRoute route, uint64_t durationNs) {
+    histogramRecord(&routeHistograms[route], durationNs);
+}
+
+void httpRouteCollectMetrics(StrBuf *out, void *ctx) {
+    char labels[32];
+    (void)ctx;
+    
+    metricsHeader(out, "watchdog_http_request_seconds", "summary", "Time spent in the request handler by route");
+    for (int i = 0; i < ROUTE_COUNT; i++) {
+        if (__atomic_load_n(&routeHistograms[i].count, __ATOMIC_RELAXED) == 0) {
+            continue;
+        }
+        snprintf(labels, sizeof(labels), "route=\"%s\"", routeNames[i]);
+        histogramWriteSummary(out, "watchdog_http_request_seconds", labels, &routeHistograms[i]);
+    }
+}
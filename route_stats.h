@@ -0,0 +1,52 @@
+#ifndef ROUTE_STATS_H
+#define ROUTE_STATS_H
+
+#include <stdint.h>
+#include "strbuf.h"
+
+// Route labels for the request latency histograms
+typedef enum {
+    ROUTE_INDEX,
+    ROUTE_METRICS,
+    ROUTE_STATUS,
+    ROUTE_INFO,
+    ROUTE_START,
+    ROUTE_TRIGGER,
+    ROUTE_STOP,
+    ROUTE_CONFIGURE,
+    ROUTE_WDT_LIST,
+    ROUTE_LEASE,
+    ROUTE_EVENTS,
+    ROUTE_HWM,
+    ROUTE_GPIO,
+    ROUTE_BUS,
+    ROUTE_I2C,
+    ROUTE_SMBUS,
+    ROUTE_STORAGE,
+    ROUTE_KV,
+    ROUTE_FAN,
+    ROUTE_THERMAL,
+    ROUTE_CONFIG,
+    ROUTE_BACKLIGHT,
+    ROUTE_BOARD,
+    ROUTE_POE,
+    ROUTE_BATTERY,
+    ROUTE_MEMORY,
+    ROUTE_IOT,
+    ROUTE_FLEET,
+    ROUTE_OTHER,
+    ROUTE_COUNT
+} HttpRoute;
+
+// Map a request onto its route label; /api/<action> and
+// /api/wdt/<n>/<action> share the label of the action
+HttpRoute httpRouteClassify(const char *url);
+// Label of a route, e.g. "status"
+const char* httpRouteName(HttpRoute route);
+
+// Record the time spent in the request handler for one request
+void httpRouteRecord(HttpRoute route, uint64_t durationNs);
+
+void httpRouteCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // ROUTE_STATS_H
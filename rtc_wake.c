@@ -0,0 +1,282 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rtc_wake.h"
+#include "hw_actor.h"
+#include "metrics.h"
+#include "susi_timing.h"
+#include "timeutil.h"
+
+typedef struct {
+    uint32_t value;
+    SusiStatus_t status;
+} WakeValue;
+
+typedef struct {
+    uint32_t value;
+    SusiStatus_t status;
+    uint32_t readBack;
+    SusiStatus_t readStatus;
+} WakeWrite;
+
+static bool supported = false;
+static uint32_t defaultWindow = RTC_WAKE_DEFAULT_WINDOW_S;
+static char identity[RTC_WAKE_IDENTITY_MAX];
+static const char *identitySource = "none";
+static double identityFraction = 0;      // Position of this board in any window, [0, 1)
+
+static uint64_t schedules = 0;
+static uint64_t schedulesFailed = 0;
+static uint32_t lastOffset = 0;
+
+static uint32_t encode(const RtcWakeTime *time) {
+    return (uint32_t)time->day << 24 | (uint32_t)time->hour << 16 | (uint32_t)time->minute << 8 | time->second;
+}
+
+static void decode(uint32_t value, RtcWakeTime *time) {
+    time->day = (uint8_t)(value >> 24);
+    time->hour = (uint8_t)(value >> 16);
+    time->minute = (uint8_t)(value >> 8);
+    time->second = (uint8_t)value;
+}
+
+static void formatTime(char *out, size_t size, const RtcWakeTime *time) {
+    snprintf(out, size, "%02u:%02u:%02u", time->hour, time->minute, time->second);
+}
+
+static void hwReadWake(void *arg) {
+    WakeValue *wake = arg;
+    uint64_t start = monotonicNowNs();
+
+    wake->status = SusiBoardGetValue(SUSI_ID_BOARD_RTC_S5_WAKE_VAL, &wake->value);
+    susiTimingRecord(SUSI_CALL_BOARD_GET_VALUE, start, wake->status);
+}
+
+static void hwWriteWake(void *arg) {
+    WakeWrite *wake = arg;
+    uint64_t start = monotonicNowNs();
+
+    wake->status = SusiBoardSetValue(SUSI_ID_BOARD_RTC_S5_WAKE_VAL, wake->value);
+    susiTimingRecord(SUSI_CALL_BOARD_SET_VALUE, start, wake->status);
+    if (wake->status != SUSI_STATUS_SUCCESS) {
+        return;
+    }
+    start = monotonicNowNs();
+    wake->readStatus = SusiBoardGetValue(SUSI_ID_BOARD_RTC_S5_WAKE_VAL, &wake->readBack);
+    susiTimingRecord(SUSI_CALL_BOARD_GET_VALUE, start, wake->readStatus);
+}
+
+static void hwReadSerial(void *arg) {
+    uint32_t length = sizeof(identity);
+    uint64_t start = monotonicNowNs();
+    SusiStatus_t status = SusiBoardGetStringA(SUSI_ID_BOARD_SERIAL_STR, identity, &length);
+    (void)arg;
+
+    susiTimingRecord(SUSI_CALL_BOARD_GET_STRING, start, status);
+    if (status != SUSI_STATUS_SUCCESS) {
+        identity[0] = '\0';
+    }
+    identity[sizeof(identity) - 1] = '\0';
+}
+
+static void readMachineId(void) {
+    FILE *file = fopen(RTC_WAKE_MACHINE_ID, "r");
+
+    identity[0] = '\0';
+    if (file == NULL) {
+        return;
+    }
+    if (fgets(identity, sizeof(identity), file) == NULL) {
+        identity[0] = '\0';
+    }
+    fclose(file);
+    identity[strcspn(identity, "\r\n")] = '\0';
+}
+
+// FNV-1a, then the splitmix64 finalizer: serials of one batch often differ
+// in their last digit only, and FNV alone leaves that in the low bits
+static uint64_t hashIdentity(const char *text) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    for (const unsigned char *p = (const unsigned char *)text; *p; p++) {
+        hash ^= *p;
+        hash *= 0x100000001b3ull;
+    }
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebull;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+bool rtcWakeInit(uint32_t windowSeconds) {
+    WakeValue wake;
+
+    defaultWindow = windowSeconds;
+    if (!hwActorCall(HW_LANE_READ, hwReadWake, &wake) || wake.status != SUSI_STATUS_SUCCESS) {
+        return false;
+    }
+    if (!hwActorCall(HW_LANE_READ, hwReadSerial, NULL)) {
+        return false;
+    }
+    if (identity[0] != '\0') {
+        identitySource = "serial";
+    } else {
+        readMachineId();
+        identitySource = identity[0] != '\0' ? "machine-id" : "none";
+    }
+    // The top 53 bits as a fraction, so a wider window only stretches the spacing
+    identityFraction = identity[0] != '\0' ? (double)(hashIdentity(identity) >> 11) / 9007199254740992.0 : 0;
+    supported = true;
+    if (identity[0] == '\0') {
+        printf("Warning: no board serial or machine ID, RTC wake is not staggered\n");
+    }
+    return true;
+}
+
+uint32_t rtcWakeDefaultWindow(void) {
+    return defaultWindow;
+}
+
+bool rtcWakeParseTime(const char *text, RtcWakeTime *time) {
+    unsigned int hour, minute, second = 0;
+    int consumed = 0;
+
+    if (sscanf(text, "%2u:%2u%n", &hour, &minute, &consumed) != 2) {
+        return false;
+    }
+    if (text[consumed] == ':') {
+        const char *rest = text + consumed + 1;
+
+        consumed = 0;
+        if (sscanf(rest, "%2u%n", &second, &consumed) != 1 || rest[consumed] != '\0') {
+            return false;
+        }
+    } else if (text[consumed] != '\0') {
+        return false;
+    }
+    if (hour > 23 || minute > 59 || second > 59) {
+        return false;
+    }
+    time->hour = (uint8_t)hour;
+    time->minute = (uint8_t)minute;
+    time->second = (uint8_t)second;
+    return true;
+}
+
+uint32_t rtcWakeOffset(uint32_t windowSeconds) {
+    return (uint32_t)(identityFraction * windowSeconds);
+}
+
+const char* rtcWakeSchedule(RtcWakeSchedule *schedule) {
+    WakeWrite wake;
+    uint32_t seconds;
+
+    if (!supported) {
+        return "RTC wake not available";
+    }
+    if (schedule->requested.day > 31) {
+        return "Invalid day (expected 0-31, 0 = every day)";
+    }
+    if (schedule->windowSeconds > RTC_WAKE_MAX_WINDOW_S) {
+        return "Invalid window (expected at most 43200 s)";
+    }
+    schedule->offsetSeconds = rtcWakeOffset(schedule->windowSeconds);
+    seconds = schedule->requested.hour * 3600u + schedule->requested.minute * 60u + schedule->requested.second +
+              schedule->offsetSeconds;
+    // A daily wake simply moves to the next morning; a day of the month
+    // cannot, months differ in length
+    if (seconds >= 86400) {
+        if (schedule->requested.day != 0) {
+            return "Window runs past midnight of the given day";
+        }
+        seconds -= 86400;
+    }
+    schedule->programmed.day = schedule->requested.day;
+    schedule->programmed.hour = (uint8_t)(seconds / 3600);
+    schedule->programmed.minute = (uint8_t)(seconds / 60 % 60);
+    schedule->programmed.second = (uint8_t)(seconds % 60);
+
+    memset(&wake, 0, sizeof(wake));
+    wake.value = encode(&schedule->programmed);
+    if (!hwActorCall(HW_LANE_CONFIG, hwWriteWake, &wake)) {
+        return "Hardware queue full";
+    }
+    schedule->status = wake.status;
+    schedule->verified = wake.status == SUSI_STATUS_SUCCESS && wake.readStatus == SUSI_STATUS_SUCCESS &&
+                         wake.readBack == wake.value;
+    __atomic_fetch_add(schedule->verified ? &schedules : &schedulesFailed, 1, __ATOMIC_RELAXED);
+    if (schedule->verified) {
+        __atomic_store_n(&lastOffset, schedule->offsetSeconds, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+SusiStatus_t rtcWakeRead(RtcWakeTime *time) {
+    WakeValue wake;
+
+    if (!supported) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    if (!hwActorCall(HW_LANE_READ, hwReadWake, &wake)) {
+        return SUSI_STATUS_ERROR;
+    }
+    if (wake.status == SUSI_STATUS_SUCCESS) {
+        decode(wake.value, time);
+    }
+    return wake.status;
+}
+
+static void writeIdentity(JsonWriter *writer) {
+    jsonFieldString(writer, "identity", identitySource);
+    jsonFieldUint(writer, "default_window_s", defaultWindow);
+    jsonFieldUint(writer, "default_offset_s", rtcWakeOffset(defaultWindow));
+}
+
+void rtcWakeWrite(JsonWriter *writer, SusiStatus_t status, const RtcWakeTime *current) {
+    char text[16];
+
+    jsonBeginObject(writer);
+    jsonFieldUint(writer, "status", status);
+    if (status == SUSI_STATUS_SUCCESS) {
+        jsonFieldUint(writer, "day", current->day);
+        formatTime(text, sizeof(text), current);
+        jsonFieldString(writer, "time", text);
+    }
+    writeIdentity(writer);
+    jsonEndObject(writer);
+}
+
+void rtcWakeWriteSchedule(JsonWriter *writer, const RtcWakeSchedule *schedule) {
+    char text[16];
+
+    jsonBeginObject(writer);
+    jsonFieldUint(writer, "status", schedule->status);
+    jsonFieldBool(writer, "verified", schedule->verified);
+    jsonFieldUint(writer, "day", schedule->requested.day);
+    formatTime(text, sizeof(text), &schedule->requested);
+    jsonFieldString(writer, "requested", text);
+    formatTime(text, sizeof(text), &schedule->programmed);
+    jsonFieldString(writer, "programmed", text);
+    jsonFieldUint(writer, "window_s", schedule->windowSeconds);
+    jsonFieldUint(writer, "offset_s", schedule->offsetSeconds);
+    writeIdentity(writer);
+    jsonEndObject(writer);
+}
+
+void rtcWakeCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (!supported) {
+        return;
+    }
+    metricsHeader(out, "watchdog_rtc_wake_schedules_total", "counter", "RTC wake times programmed from /api/wake");
+    strbufAppendf(out, "watchdog_rtc_wake_schedules_total{result=\"ok\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&schedules, __ATOMIC_RELAXED));
+    strbufAppendf(out, "watchdog_rtc_wake_schedules_total{result=\"failed\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&schedulesFailed, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_rtc_wake_offset_seconds", "gauge",
+                  "This board's offset within the window of the last wake programmed");
+    strbufAppendf(out, "watchdog_rtc_wake_offset_seconds %u\n", __atomic_load_n(&lastOffset, __ATOMIC_RELAXED));
+}
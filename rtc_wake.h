@@ -0,0 +1,63 @@
+#ifndef RTC_WAKE_H
+#define RTC_WAKE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "Susi4.h"
+#include "json_writer.h"
+#include "strbuf.h"
+
+#define RTC_WAKE_DEFAULT_WINDOW_S 600
+#define RTC_WAKE_MAX_WINDOW_S 43200          // Half a day
+#define RTC_WAKE_IDENTITY_MAX 64
+#define RTC_WAKE_MACHINE_ID "/etc/machine-id"
+
+// Staggered RTC wake from S5 (SUSI_ID_BOARD_RTC_S5_WAKE_VAL). When a fleet
+// is told to power on at the same time, every board would boot in the same
+// second. Instead each board adds its own offset within a window to the
+// requested time, so the boots are spread evenly over the window. The
+// offset is derived from the board serial (the machine ID when the EC has
+// none), so it is the same on every request and every restart, and the
+// boards keep their relative order whatever window is asked for.
+
+// One wake time: day of the month (0 = every day) and time of day
+typedef struct {
+    uint8_t day;
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+} RtcWakeTime;
+
+typedef struct {
+    RtcWakeTime requested;
+    uint32_t windowSeconds;
+    // Outcome, filled in by rtcWakeSchedule()
+    uint32_t offsetSeconds;
+    RtcWakeTime programmed;
+    SusiStatus_t status;
+    bool verified;                   // Read back as programmed
+} RtcWakeSchedule;
+
+// Read the identity and the current wake time (after hwActorStart);
+// false if the board has no RTC wake
+bool rtcWakeInit(uint32_t defaultWindowSeconds);
+uint32_t rtcWakeDefaultWindow(void);
+
+// "HH:MM" or "HH:MM:SS"; false if it is not a time of day
+bool rtcWakeParseTime(const char *text, RtcWakeTime *time);
+// This board's offset within a window of windowSeconds
+uint32_t rtcWakeOffset(uint32_t windowSeconds);
+
+// Program requested plus this board's offset and read it back, on the
+// config lane. NULL, or what is wrong with the request.
+const char* rtcWakeSchedule(RtcWakeSchedule *schedule);
+// The currently programmed wake time, on the read lane
+SusiStatus_t rtcWakeRead(RtcWakeTime *time);
+
+// The GET /api/wake body, and the PUT result's
+void rtcWakeWrite(JsonWriter *writer, SusiStatus_t status, const RtcWakeTime *current);
+void rtcWakeWriteSchedule(JsonWriter *writer, const RtcWakeSchedule *schedule);
+
+void rtcWakeCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // RTC_WAKE_H
@@ -0,0 +1,204 @@
+#include <pthread.h>
+#include <stdio.h>
+#include "sab2000_alerts.h"
+#include "Susi4.h"
+#include "events.h"
+#include "hw_actor.h"
+#include "metrics.h"
+#include "scheduler.h"
+#include "susi_device.h"
+
+// From SUSIDeviceDEMO/SAB2000DEMO/SAB2000.h
+#define SAB2000_ID_BASE                 0x00800000
+#define SAB2000_ID_DEVICE_AVAILABLE     ((SusiId_t)(SAB2000_ID_BASE + 0))
+#define SAB2000_ID_CASEOPEN             ((SusiId_t)(SAB2000_ID_BASE + 0x10))
+#define SAB2000_ID_CTRL_ALERT           ((SusiId_t)((SAB2000_ID_BASE | 0x10000) + 0))
+#define SAB2000_ID_LED_BASE             (SAB2000_ID_BASE | 0x31000)
+
+static const struct {
+    SusiId_t id;
+    const char *name;
+    uint32_t shift;
+    uint32_t mask;                   // Of the register value
+} fields[SAB2000_FIELD_COUNT] = {
+    [SAB2000_FIELD_ALERT]     = { SAB2000_ID_CTRL_ALERT, "alert", 0, 0x1 },
+    [SAB2000_FIELD_CASE_OPEN] = { SAB2000_ID_CASEOPEN, "case_open", 1, 0x1 },
+    [SAB2000_FIELD_POWER_LED] = { SAB2000_ID_LED_BASE + 0, "power_led", 2, 0x7 },
+    [SAB2000_FIELD_TEMP_LED]  = { SAB2000_ID_LED_BASE + 1, "temp_led", 5, 0x7 },
+    [SAB2000_FIELD_FAN_LED]   = { SAB2000_ID_LED_BASE + 2, "fan_led", 8, 0x7 },
+};
+
+typedef struct {
+    uint32_t state;
+    uint32_t valid;                  // Bit per field read successfully
+} Sab2000Read;
+
+static uint32_t intervalMs = SAB2000_DEFAULT_INTERVAL_MS;
+
+static pthread_mutex_t sabLock = PTHREAD_MUTEX_INITIALIZER;
+static int sabTask = -1;
+static bool sabRunning;
+static uint32_t currentState;        // Under sabLock, once stateKnown
+static bool stateKnown;
+static uint64_t polls;
+static uint64_t readErrors;
+static uint64_t transitions[SAB2000_FIELD_COUNT];
+
+void sab2000AlertsSetInterval(uint32_t ms) {
+    intervalMs = ms;
+}
+
+const char* sab2000FieldName(Sab2000Field field) {
+    return field < SAB2000_FIELD_COUNT ? fields[field].name : "unknown";
+}
+
+uint32_t sab2000FieldValue(uint32_t state, Sab2000Field field) {
+    return field < SAB2000_FIELD_COUNT ? (state >> fields[field].shift) & fields[field].mask : 0;
+}
+
+bool sab2000FieldIsLed(Sab2000Field field) {
+    return field >= SAB2000_FIELD_POWER_LED && field < SAB2000_FIELD_COUNT;
+}
+
+const char* sab2000LedName(uint32_t led) {
+    switch (led) {
+    case SAB2000_LED_DARK:
+        return "dark";
+    case SAB2000_LED_GREEN:
+        return "green";
+    case SAB2000_LED_RED:
+        return "red";
+    case SAB2000_LED_GREEN_BLINK:
+        return "green_blink";
+    case SAB2000_LED_RED_BLINK:
+        return "red_blink";
+    default:
+        return "unknown";
+    }
+}
+
+static void hwProbe(void *arg) {
+    uint32_t available = 0;
+
+    *(bool*)arg = susiDeviceGetValue(SAB2000_ID_DEVICE_AVAILABLE, &available) == SUSI_STATUS_SUCCESS && available != 0;
+}
+
+static void hwRead(void *arg) {
+    Sab2000Read *read = arg;
+
+    read->state = 0;
+    read->valid = 0;
+    for (int i = 0; i < SAB2000_FIELD_COUNT; i++) {
+        uint32_t value = 0;
+
+        if (susiDeviceGetValue(fields[i].id, &value) == SUSI_STATUS_SUCCESS) {
+            read->state |= (value & fields[i].mask) << fields[i].shift;
+            read->valid |= 1u << i;
+        }
+    }
+}
+
+static void poll(void *arg) {
+    Sab2000Read read;
+    uint32_t previous, next, changed = 0;
+    bool known;
+    (void)arg;
+
+    // A busy read lane only delays the poll
+    if (!hwActorCall(HW_LANE_READ, hwRead, &read)) {
+        return;
+    }
+    __atomic_fetch_add(&polls, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&readErrors, (uint64_t)(SAB2000_FIELD_COUNT - __builtin_popcount(read.valid)), __ATOMIC_RELAXED);
+
+    pthread_mutex_lock(&sabLock);
+    previous = currentState;
+    known = stateKnown;
+    next = read.state;
+    for (int i = 0; i < SAB2000_FIELD_COUNT; i++) {
+        uint32_t bits = fields[i].mask << fields[i].shift;
+
+        if (!(read.valid & (1u << i))) {
+            next = (next & ~bits) | (previous & bits);
+        } else if (known && ((next ^ previous) & bits)) {
+            changed |= 1u << i;
+        }
+    }
+    currentState = next;
+    stateKnown = known || read.valid != 0;
+    pthread_mutex_unlock(&sabLock);
+
+    // The first read sets the baseline; after that only transitions go out
+    if (changed != 0) {
+        for (int i = 0; i < SAB2000_FIELD_COUNT; i++) {
+            if (changed & (1u << i)) {
+                __atomic_fetch_add(&transitions[i], 1, __ATOMIC_RELAXED);
+            }
+        }
+        eventPublish(EVENT_SAB2000, EVENT_NO_WATCHDOG, next, previous, changed, 0);
+    }
+}
+
+bool sab2000AlertsStart(void) {
+    bool present = false;
+
+    if (intervalMs == 0 || sabRunning || !susiDeviceOpen()) {
+        return false;
+    }
+    if (!hwActorCall(HW_LANE_READ, hwProbe, &present) || !present) {
+        susiDeviceClose();
+        return false;
+    }
+    sabTask = schedulerAdd("sab2000", SCHEDULER_PRIORITY_NORMAL, intervalMs, 0, poll, NULL);
+    if (sabTask < 0) {
+        susiDeviceClose();
+        return false;
+    }
+    sabRunning = true;
+    printf("SAB2000 alerts: every %u ms\n", intervalMs);
+    return true;
+}
+
+void sab2000AlertsStop(void) {
+    if (!sabRunning) {
+        return;
+    }
+    schedulerRemove(sabTask);
+    sabTask = -1;
+    sabRunning = false;
+    susiDeviceClose();
+}
+
+void sab2000AlertsCollectMetrics(StrBuf *out, void *ctx) {
+    uint32_t state;
+    bool known;
+    (void)ctx;
+
+    if (!sabRunning) {
+        return;
+    }
+    pthread_mutex_lock(&sabLock);
+    state = currentState;
+    known = stateKnown;
+    pthread_mutex_unlock(&sabLock);
+
+    if (known) {
+        metricsHeader(out, "watchdog_sab2000_state", "gauge",
+                      "SAB2000 alert and case-open inputs (0 or 1), LEDs as codes (1 green, 2 red, 5/6 blinking)");
+        for (int i = 0; i < SAB2000_FIELD_COUNT; i++) {
+            strbufAppendf(out, "watchdog_sab2000_state{field=\"%s\"} %u\n", fields[i].name,
+                          sab2000FieldValue(state, (Sab2000Field)i));
+        }
+    }
+    metricsHeader(out, "watchdog_sab2000_transitions_total", "counter", "SAB2000 field changes published as events");
+    for (int i = 0; i < SAB2000_FIELD_COUNT; i++) {
+        strbufAppendf(out, "watchdog_sab2000_transitions_total{field=\"%s\"} %llu\n", fields[i].name,
+                      (unsigned long long)__atomic_load_n(&transitions[i], __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_sab2000_polls_total", "counter", "SAB2000 status polls");
+    strbufAppendf(out, "watchdog_sab2000_polls_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&polls, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_sab2000_read_errors_total", "counter", "SAB2000 fields that could not be read");
+    strbufAppendf(out, "watchdog_sab2000_read_errors_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&readErrors, __ATOMIC_RELAXED));
+}
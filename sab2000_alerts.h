@@ -0,0 +1,52 @@
+#ifndef SAB2000_ALERTS_H
+#define SAB2000_ALERTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "strbuf.h"
+
+#define SAB2000_DEFAULT_INTERVAL_MS 1000
+
+// SAB2000 alert board monitoring, through the optional SUSI device library
+// (susi_device.h). A task on the shared scheduler (scheduler.h) reads the
+// alert switch, the case-open input and the power, temperature and fan LEDs
+// every interval and packs them into one state word, each field at its own
+// shift. When the word differs from
+// the previous one it is published as EVENT_SAB2000 with the mask of the
+// fields that changed; steady states cost nothing but the reads. A field
+// that fails to read keeps its last value rather than raising a false
+// transition.
+
+typedef enum {
+    SAB2000_FIELD_ALERT,             // Alert output enabled, 0 or 1
+    SAB2000_FIELD_CASE_OPEN,         // 0 or 1
+    SAB2000_FIELD_POWER_LED,         // Sab2000Led
+    SAB2000_FIELD_TEMP_LED,
+    SAB2000_FIELD_FAN_LED,
+    SAB2000_FIELD_COUNT
+} Sab2000Field;
+
+// LED codes, bits [2:0] of SAB2000_ID_LED_* (GetStatusStr in SAB2000DEMO)
+typedef enum {
+    SAB2000_LED_DARK = 0,
+    SAB2000_LED_GREEN = 1,
+    SAB2000_LED_RED = 2,
+    SAB2000_LED_GREEN_BLINK = 5,
+    SAB2000_LED_RED_BLINK = 6
+} Sab2000Led;
+
+// Before sab2000AlertsStart(); 0 disables the module
+void sab2000AlertsSetInterval(uint32_t ms);
+// False when there is no SAB2000 or the interval is 0 (after hwActorStart)
+bool sab2000AlertsStart(void);
+void sab2000AlertsStop(void);
+
+const char* sab2000FieldName(Sab2000Field field);
+// Value of field in a packed state word
+uint32_t sab2000FieldValue(uint32_t state, Sab2000Field field);
+bool sab2000FieldIsLed(Sab2000Field field);
+const char* sab2000LedName(uint32_t led);
+
+void sab2000AlertsCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // SAB2000_ALERTS_H
@@ -0,0 +1,560 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "scheduler.h"
+#include "histogram.h"
+#include "metrics.h"
+#include "timeutil.h"
+
+#define LEVEL0_BITS 8
+#define LEVEL_BITS 6
+#define LEVEL0_SLOTS (1 << LEVEL0_BITS)
+#define LEVEL_SLOTS (1 << LEVEL_BITS)
+#define WHEEL_SPAN (1ull << (LEVEL0_BITS + LEVEL_BITS * (SCHEDULER_WHEEL_LEVELS - 1)))
+// Wheel slots first, then one ready queue per priority
+#define WHEEL_LISTS (LEVEL0_SLOTS + LEVEL_SLOTS * (SCHEDULER_WHEEL_LEVELS - 1))
+#define READY_LIST(priority) (WHEEL_LISTS + (priority))
+#define LIST_COUNT (WHEEL_LISTS + SCHEDULER_PRIORITY_COUNT)
+#define NO_TASK (-1)
+#define NO_TICK UINT64_MAX
+
+typedef enum {
+    TASK_FREE,
+    TASK_WAITING,                    // In a wheel slot
+    TASK_READY,                      // In a ready queue
+    TASK_RUNNING,
+    TASK_REMOVED                     // Ran out while being removed; freed by schedulerRemove()
+} TaskState;
+
+typedef struct {
+    const char *name;
+    SchedulerTaskFn fn;
+    void *arg;
+    SchedulerPriority priority;
+    TaskState state;
+    bool runAgain;                   // schedulerRunNow() while running
+    bool removing;
+    uint64_t periodNs;
+    uint64_t dueNs;                  // Deadline of the pending run
+    uint64_t expiresTick;
+    int list;                        // Wheel slot or ready queue, while WAITING or READY
+    int next;
+    int prev;
+    // Under schedulerLock
+    uint64_t runs;
+    uint64_t misses;                 // Deadlines passed without a run
+    uint64_t maxLatencyNs;
+    uint64_t runNs;
+} Task;
+
+static const char *priorityNames[SCHEDULER_PRIORITY_COUNT] = { "high", "normal" };
+
+static pthread_mutex_t schedulerLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t timerWake;
+static pthread_cond_t workAvailable;
+static pthread_cond_t taskDone;
+static pthread_t timerThread;
+static pthread_t workerThreads[SCHEDULER_MAX_WORKERS];
+static int workerCount = SCHEDULER_DEFAULT_WORKERS;
+static int workersStarted;
+static bool running;
+static bool stopping;
+
+static Task tasks[SCHEDULER_MAX_TASKS];
+static int listHead[LIST_COUNT];
+static int listTail[LIST_COUNT];
+static int waitingCount;
+static int normalRunning;
+static uint64_t baseNs;              // Time of tick 0
+static uint64_t currentTick;         // Last tick processed
+static uint64_t plannedTick;         // Tick the timer thread sleeps until, NO_TICK without one
+
+static uint64_t timerWakeups;
+static uint64_t cascades;
+static Histogram latency[SCHEDULER_PRIORITY_COUNT];   // Deadline to the start of the run
+
+static void listAppend(int list, int id) {
+    Task *task = &tasks[id];
+
+    task->list = list;
+    task->next = NO_TASK;
+    task->prev = listTail[list];
+    if (listTail[list] != NO_TASK) {
+        tasks[listTail[list]].next = id;
+    } else {
+        listHead[list] = id;
+    }
+    listTail[list] = id;
+}
+
+static void listUnlink(int id) {
+    Task *task = &tasks[id];
+
+    if (task->prev != NO_TASK) {
+        tasks[task->prev].next = task->next;
+    } else {
+        listHead[task->list] = task->next;
+    }
+    if (task->next != NO_TASK) {
+        tasks[task->next].prev = task->prev;
+    } else {
+        listTail[task->list] = task->prev;
+    }
+    task->next = task->prev = NO_TASK;
+}
+
+// Slot for a tick: level 0 holds the next 256 ticks one per slot, every
+// further level 64 times the span of the one below. Deadlines beyond the
+// wheel sit in its farthest slot and are placed again when it cascades.
+static int wheelList(uint64_t expires) {
+    uint64_t delta = expires - currentTick;
+
+    if (delta >= WHEEL_SPAN) {
+        expires = currentTick + WHEEL_SPAN - 1;
+        delta = WHEEL_SPAN - 1;
+    }
+    if (delta < LEVEL0_SLOTS) {
+        return (int)(expires & (LEVEL0_SLOTS - 1));
+    }
+    for (int level = 1; level < SCHEDULER_WHEEL_LEVELS - 1; level++) {
+        if (delta < 1ull << (LEVEL0_BITS + LEVEL_BITS * level)) {
+            return LEVEL0_SLOTS + LEVEL_SLOTS * (level - 1) +
+                   (int)((expires >> (LEVEL0_BITS + LEVEL_BITS * (level - 1))) & (LEVEL_SLOTS - 1));
+        }
+    }
+    return LEVEL0_SLOTS + LEVEL_SLOTS * (SCHEDULER_WHEEL_LEVELS - 2) +
+           (int)((expires >> (LEVEL0_BITS + LEVEL_BITS * (SCHEDULER_WHEEL_LEVELS - 2))) & (LEVEL_SLOTS - 1));
+}
+
+static void makeReady(int id) {
+    Task *task = &tasks[id];
+
+    task->state = TASK_READY;
+    listAppend(READY_LIST(task->priority), id);
+    pthread_cond_signal(&workAvailable);
+}
+
+// Put a task with its dueNs set into the wheel, or straight into its ready
+// queue when that tick has passed
+static void schedule(int id) {
+    Task *task = &tasks[id];
+    uint64_t expires = task->dueNs > baseNs ? (task->dueNs - baseNs + SCHEDULER_TICK_NS - 1) / SCHEDULER_TICK_NS : 0;
+
+    if (expires <= currentTick) {
+        makeReady(id);
+        return;
+    }
+    task->state = TASK_WAITING;
+    task->expiresTick = expires;
+    listAppend(wheelList(expires), id);
+    waitingCount++;
+    if (plannedTick == NO_TICK || expires < plannedTick) {
+        pthread_cond_signal(&timerWake);
+    }
+}
+
+static void unschedule(int id) {
+    if (tasks[id].state == TASK_WAITING) {
+        waitingCount--;
+    }
+    listUnlink(id);
+}
+
+static void cascade(int level) {
+    int shift = LEVEL0_BITS + LEVEL_BITS * (level - 1);
+    int list = LEVEL0_SLOTS + LEVEL_SLOTS * (level - 1) + (int)((currentTick >> shift) & (LEVEL_SLOTS - 1));
+    int id = listHead[list];
+
+    listHead[list] = listTail[list] = NO_TASK;
+    while (id != NO_TASK) {
+        int next = tasks[id].next;
+
+        tasks[id].next = tasks[id].prev = NO_TASK;
+        listAppend(wheelList(tasks[id].expiresTick), id);
+        id = next;
+    }
+    cascades++;
+}
+
+// Process tick currentTick + 1: refill the lower levels on their
+// boundaries, then release the slot's tasks
+static void advance(void) {
+    int list;
+    int id;
+
+    currentTick++;
+    for (int level = SCHEDULER_WHEEL_LEVELS - 1; level >= 1; level--) {
+        if ((currentTick & ((1ull << (LEVEL0_BITS + LEVEL_BITS * (level - 1))) - 1)) == 0) {
+            cascade(level);
+        }
+    }
+    list = (int)(currentTick & (LEVEL0_SLOTS - 1));
+    id = listHead[list];
+    while (id != NO_TASK) {
+        int next = tasks[id].next;
+
+        if (tasks[id].expiresTick <= currentTick) {
+            unschedule(id);
+            makeReady(id);
+        }
+        id = next;
+    }
+}
+
+// The next tick with work: an occupied level-0 slot, or the next cascade
+static uint64_t nextEventTick(void) {
+    uint64_t boundary = (currentTick | (LEVEL0_SLOTS - 1)) + 1;
+
+    for (uint64_t tick = currentTick + 1; tick < boundary; tick++) {
+        if (listHead[tick & (LEVEL0_SLOTS - 1)] != NO_TASK) {
+            return tick;
+        }
+    }
+    return boundary;
+}
+
+static void* timerThreadMain(void *arg) {
+    (void)arg;
+
+    pthread_setname_np(pthread_self(), "sched-timer");
+    pthread_mutex_lock(&schedulerLock);
+    while (!stopping) {
+        uint64_t nowTick = (monotonicNowNs() - baseNs) / SCHEDULER_TICK_NS;
+        struct timespec deadline;
+        uint64_t dueNs;
+
+        // Empty stretches are skipped in one step
+        while (currentTick < nowTick) {
+            uint64_t next = nextEventTick();
+
+            if (next > nowTick) {
+                currentTick = nowTick;
+                break;
+            }
+            currentTick = next - 1;
+            advance();
+        }
+        if (waitingCount == 0) {
+            plannedTick = NO_TICK;
+            pthread_cond_wait(&timerWake, &schedulerLock);
+        } else {
+            plannedTick = nextEventTick();
+            dueNs = baseNs + plannedTick * SCHEDULER_TICK_NS;
+            deadline.tv_sec = (time_t)(dueNs / 1000000000ull);
+            deadline.tv_nsec = (long)(dueNs % 1000000000ull);
+            pthread_cond_timedwait(&timerWake, &schedulerLock, &deadline);
+        }
+        timerWakeups++;
+    }
+    pthread_mutex_unlock(&schedulerLock);
+    return NULL;
+}
+
+// High priority first; with several workers normal tasks leave one free
+static int takeReady(void) {
+    int id = listHead[READY_LIST(SCHEDULER_PRIORITY_HIGH)];
+
+    if (id == NO_TASK && (workerCount == 1 || normalRunning < workerCount - 1)) {
+        id = listHead[READY_LIST(SCHEDULER_PRIORITY_NORMAL)];
+    }
+    if (id != NO_TASK) {
+        listUnlink(id);
+    }
+    return id;
+}
+
+// A run ended: the next deadline, skipping those that have passed
+static void finish(int id, uint64_t nowNs) {
+    Task *task = &tasks[id];
+    uint64_t next = task->dueNs + task->periodNs;
+
+    if (task->removing) {
+        task->state = TASK_REMOVED;
+        pthread_cond_broadcast(&taskDone);
+        return;
+    }
+    if (task->runAgain) {
+        task->runAgain = false;
+        task->dueNs = nowNs;
+        makeReady(id);
+        return;
+    }
+    if (next <= nowNs) {
+        uint64_t missed = (nowNs - next) / task->periodNs + 1;
+
+        task->misses += missed;
+        next += missed * task->periodNs;
+    }
+    task->dueNs = next;
+    schedule(id);
+}
+
+static void* workerThreadMain(void *arg) {
+    (void)arg;
+
+    pthread_setname_np(pthread_self(), "sched-worker");
+    pthread_mutex_lock(&schedulerLock);
+    for (;;) {
+        int id = takeReady();
+        Task *task;
+        uint64_t startNs, endNs, waitedNs;
+
+        if (id == NO_TASK) {
+            if (stopping) {
+                break;
+            }
+            pthread_cond_wait(&workAvailable, &schedulerLock);
+            continue;
+        }
+        task = &tasks[id];
+        task->state = TASK_RUNNING;
+        if (task->priority == SCHEDULER_PRIORITY_NORMAL) {
+            normalRunning++;
+        }
+        startNs = monotonicNowNs();
+        waitedNs = startNs > task->dueNs ? startNs - task->dueNs : 0;
+        pthread_mutex_unlock(&schedulerLock);
+
+        histogramRecord(&latency[task->priority], waitedNs);
+        task->fn(task->arg);
+        endNs = monotonicNowNs();
+
+        pthread_mutex_lock(&schedulerLock);
+        if (task->priority == SCHEDULER_PRIORITY_NORMAL) {
+            normalRunning--;
+        }
+        task->runs++;
+        task->runNs += endNs - startNs;
+        if (waitedNs > task->maxLatencyNs) {
+            task->maxLatencyNs = waitedNs;
+        }
+        finish(id, endNs);
+    }
+    pthread_mutex_unlock(&schedulerLock);
+    return NULL;
+}
+
+bool schedulerSetWorkers(int workers) {
+    if (workers < 1 || workers > SCHEDULER_MAX_WORKERS) {
+        return false;
+    }
+    workerCount = workers;
+    return true;
+}
+
+static void initCond(pthread_cond_t *cond) {
+    pthread_condattr_t attr;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static void joinAll(void) {
+    pthread_mutex_lock(&schedulerLock);
+    stopping = true;
+    pthread_cond_signal(&timerWake);
+    pthread_cond_broadcast(&workAvailable);
+    pthread_mutex_unlock(&schedulerLock);
+    pthread_join(timerThread, NULL);
+    for (int i = 0; i < workersStarted; i++) {
+        pthread_join(workerThreads[i], NULL);
+    }
+    workersStarted = 0;
+    pthread_cond_destroy(&timerWake);
+    pthread_cond_destroy(&workAvailable);
+    pthread_cond_destroy(&taskDone);
+}
+
+bool schedulerStart(void) {
+    if (running) {
+        return false;
+    }
+    memset(tasks, 0, sizeof(tasks));
+    for (int i = 0; i < LIST_COUNT; i++) {
+        listHead[i] = listTail[i] = NO_TASK;
+    }
+    waitingCount = 0;
+    normalRunning = 0;
+    baseNs = monotonicNowNs();
+    currentTick = 0;
+    plannedTick = NO_TICK;
+    stopping = false;
+    initCond(&timerWake);
+    initCond(&workAvailable);
+    initCond(&taskDone);
+    if (pthread_create(&timerThread, NULL, timerThreadMain, NULL) != 0) {
+        pthread_cond_destroy(&timerWake);
+        pthread_cond_destroy(&workAvailable);
+        pthread_cond_destroy(&taskDone);
+        return false;
+    }
+    for (workersStarted = 0; workersStarted < workerCount; workersStarted++) {
+        if (pthread_create(&workerThreads[workersStarted], NULL, workerThreadMain, NULL) != 0) {
+            joinAll();
+            return false;
+        }
+    }
+    running = true;
+    printf("Scheduler: %d worker(s), %llu ms ticks\n", workerCount,
+           (unsigned long long)(SCHEDULER_TICK_NS / 1000000ull));
+    return true;
+}
+
+void schedulerStop(void) {
+    if (!running) {
+        return;
+    }
+    joinAll();
+    running = false;
+}
+
+int schedulerAdd(const char *name, SchedulerPriority priority, uint32_t periodMs, uint32_t delayMs,
+                 SchedulerTaskFn fn, void *arg) {
+    int id = NO_TASK;
+
+    if (!running || periodMs == 0 || priority >= SCHEDULER_PRIORITY_COUNT) {
+        return NO_TASK;
+    }
+    pthread_mutex_lock(&schedulerLock);
+    for (int i = 0; i < SCHEDULER_MAX_TASKS && id == NO_TASK; i++) {
+        if (tasks[i].state == TASK_FREE) {
+            id = i;
+        }
+    }
+    if (id != NO_TASK) {
+        Task *task = &tasks[id];
+
+        memset(task, 0, sizeof(*task));
+        task->name = name;
+        task->fn = fn;
+        task->arg = arg;
+        task->priority = priority;
+        task->periodNs = (uint64_t)periodMs * 1000000ull;
+        task->dueNs = monotonicNowNs() + (uint64_t)delayMs * 1000000ull;
+        task->next = task->prev = NO_TASK;
+        schedule(id);
+    }
+    pthread_mutex_unlock(&schedulerLock);
+    return id;
+}
+
+void schedulerRunNow(int id) {
+    Task *task;
+
+    if (id < 0 || id >= SCHEDULER_MAX_TASKS) {
+        return;
+    }
+    task = &tasks[id];
+    pthread_mutex_lock(&schedulerLock);
+    if (task->state == TASK_WAITING) {
+        unschedule(id);
+        task->dueNs = monotonicNowNs();
+        makeReady(id);
+    } else if (task->state == TASK_RUNNING) {
+        task->runAgain = true;
+    }
+    pthread_mutex_unlock(&schedulerLock);
+}
+
+void schedulerRemove(int id) {
+    Task *task;
+
+    if (id < 0 || id >= SCHEDULER_MAX_TASKS) {
+        return;
+    }
+    task = &tasks[id];
+    pthread_mutex_lock(&schedulerLock);
+    if (task->state == TASK_WAITING || task->state == TASK_READY) {
+        unschedule(id);
+    } else if (task->state == TASK_RUNNING) {
+        task->removing = true;
+        while (task->state == TASK_RUNNING) {
+            pthread_cond_wait(&taskDone, &schedulerLock);
+        }
+    }
+    task->state = TASK_FREE;
+    pthread_mutex_unlock(&schedulerLock);
+}
+
+// Every thread of the process, scheduler or not
+static long processThreads(void) {
+    FILE *file = fopen("/proc/self/status", "r");
+    char line[128];
+    long threads = -1;
+
+    if (file == NULL) {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (sscanf(line, "Threads: %ld", &threads) == 1) {
+            break;
+        }
+    }
+    fclose(file);
+    return threads;
+}
+
+void schedulerCollectMetrics(StrBuf *out, void *ctx) {
+    Task copy[SCHEDULER_MAX_TASKS];
+    uint64_t wakeups, cascaded;
+    long threads = processThreads();
+    (void)ctx;
+
+    if (threads >= 0) {
+        metricsHeader(out, "watchdog_process_threads", "gauge", "Threads of the service process");
+        strbufAppendf(out, "watchdog_process_threads %ld\n", threads);
+    }
+    if (!running) {
+        return;
+    }
+    pthread_mutex_lock(&schedulerLock);
+    memcpy(copy, tasks, sizeof(copy));
+    wakeups = timerWakeups;
+    cascaded = cascades;
+    pthread_mutex_unlock(&schedulerLock);
+
+    metricsHeader(out, "watchdog_scheduler_threads", "gauge", "Scheduler threads, timer and workers");
+    strbufAppendf(out, "watchdog_scheduler_threads %d\n", workersStarted + 1);
+    metricsHeader(out, "watchdog_scheduler_timer_wakeups_total", "counter", "Times the timer thread woke up");
+    strbufAppendf(out, "watchdog_scheduler_timer_wakeups_total %llu\n", (unsigned long long)wakeups);
+    metricsHeader(out, "watchdog_scheduler_cascades_total", "counter", "Wheel slots moved down a level");
+    strbufAppendf(out, "watchdog_scheduler_cascades_total %llu\n", (unsigned long long)cascaded);
+    metricsHeader(out, "watchdog_scheduler_latency_seconds", "summary", "Deadline to the start of a run, per priority");
+    for (int priority = 0; priority < SCHEDULER_PRIORITY_COUNT; priority++) {
+        char labels[32];
+
+        snprintf(labels, sizeof(labels), "priority=\"%s\"", priorityNames[priority]);
+        histogramWriteSummary(out, "watchdog_scheduler_latency_seconds", labels, &latency[priority]);
+    }
+    metricsHeader(out, "watchdog_scheduler_task_runs_total", "counter", "Runs per scheduled task");
+    for (int i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        if (copy[i].state != TASK_FREE) {
+            strbufAppendf(out, "watchdog_scheduler_task_runs_total{task=\"%s\",priority=\"%s\"} %llu\n", copy[i].name,
+                          priorityNames[copy[i].priority], (unsigned long long)copy[i].runs);
+        }
+    }
+    metricsHeader(out, "watchdog_scheduler_task_deadline_misses_total", "counter",
+                  "Deadlines a task passed without a run, skipped rather than made up");
+    for (int i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        if (copy[i].state != TASK_FREE) {
+            strbufAppendf(out, "watchdog_scheduler_task_deadline_misses_total{task=\"%s\"} %llu\n", copy[i].name,
+                          (unsigned long long)copy[i].misses);
+        }
+    }
+    metricsHeader(out, "watchdog_scheduler_task_latency_max_seconds", "gauge", "Longest deadline to start of a task's runs");
+    for (int i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        if (copy[i].state != TASK_FREE) {
+            strbufAppendf(out, "watchdog_scheduler_task_latency_max_seconds{task=\"%s\"} %.6f\n", copy[i].name,
+                          (double)copy[i].maxLatencyNs / 1e9);
+        }
+    }
+    metricsHeader(out, "watchdog_scheduler_task_run_seconds_total", "counter", "Time spent running each task");
+    for (int i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        if (copy[i].state != TASK_FREE) {
+            strbufAppendf(out, "watchdog_scheduler_task_run_seconds_total{task=\"%s\"} %.6f\n", copy[i].name,
+                          (double)copy[i].runNs / 1e9);
+        }
+    }
+}
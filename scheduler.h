@@ -0,0 +1,55 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "strbuf.h"
+
+#define SCHEDULER_MAX_TASKS 24
+#define SCHEDULER_MAX_WORKERS 8
+#define SCHEDULER_DEFAULT_WORKERS 2
+#define SCHEDULER_TICK_NS 1000000ull     // Resolution of the wheel, 1 ms
+#define SCHEDULER_WHEEL_LEVELS 4         // 256 ms, 16 s, 17 min and 18 h of ticks
+
+// One hierarchical timer wheel and a small worker pool for the periodic
+// pollers (HWM, board counters, PIC and ignition, PoE, SAB2000, battery),
+// instead of a sleeping thread each. A task is one run of a poller; the
+// timer thread only sleeps until the next occupied slot, then hands what
+// is due to the workers. High priority tasks are taken first, and with
+// more than one worker one is always kept free for them, so a sweep that
+// waits on the hardware thread cannot hold up the ignition watch. A task
+// that is not done, or not started, by its next deadline misses it: the
+// run is skipped rather than made up, so an overloaded box does not fall
+// into back-to-back catch-up runs, and the miss is counted per task.
+// Pollers that must keep their own thread stay out: the feeder runs on
+// the real-time profile and blocking readers wait on file descriptors.
+
+typedef enum {
+    SCHEDULER_PRIORITY_HIGH,
+    SCHEDULER_PRIORITY_NORMAL,
+    SCHEDULER_PRIORITY_COUNT
+} SchedulerPriority;
+
+typedef void (*SchedulerTaskFn)(void *arg);
+
+// Before schedulerStart(); false outside 1..SCHEDULER_MAX_WORKERS
+bool schedulerSetWorkers(int workers);
+bool schedulerStart(void);
+// After every task has been removed
+void schedulerStop(void);
+
+// Run fn every periodMs, the first time after delayMs. The name must
+// outlive the task. The task id, or -1 when the scheduler is not running
+// or full.
+int schedulerAdd(const char *name, SchedulerPriority priority, uint32_t periodMs, uint32_t delayMs,
+                 SchedulerTaskFn fn, void *arg);
+// Run a task as soon as a worker is free; once more right after the
+// current run if it is running
+void schedulerRunNow(int id);
+// Unregister a task, waiting for a run in progress to finish. Not from
+// inside the task itself.
+void schedulerRemove(int id);
+
+void schedulerCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // SCHEDULER_H
@@ -0,0 +1,372 @@
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#include "self_stats.h"
+#include "access_log.h"
+#include "events.h"
+#include "gpio_events.h"
+#include "hw_actor.h"
+#include "json_writer.h"
+#include "mem_pool.h"
+#include "metrics.h"
+#include "response_pool.h"
+#include "timeutil.h"
+
+#define STAT_FIELD_UTIME 14              // Field numbers of /proc/<pid>/stat
+#define STAT_FIELD_STIME 15
+#define STAT_FIELD_START_BRK 47
+
+typedef struct {
+    int tid;
+    char name[16];
+    char state;
+    uint64_t userTicks;
+    uint64_t systemTicks;
+} SelfThread;
+
+typedef struct {
+    const char *name;
+    uint32_t used;
+    uint32_t capacity;
+} SelfRing;
+
+static uint64_t startNs;
+static uint64_t startMs;
+static uintptr_t heapStart;
+static unsigned int connectionLimit;
+
+static uint64_t connectionsOpened;
+static uint64_t connectionsClosed;
+static uint64_t connectionsPeak;
+
+static uint64_t wallClockMs(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000ull + (uint64_t)now.tv_nsec / 1000000ull;
+}
+
+// Fields first..last of a stat file, numbered as in proc(5); the name
+// in parentheses may hold spaces, so fields are counted from its end
+static bool readStat(const char *path, char *name, size_t nameSize, char *state, int first, int last,
+                     uint64_t *values) {
+    char line[1024];
+    FILE *file = fopen(path, "r");
+    char *open, *close, *cursor;
+    bool ok;
+
+    if (file == NULL) {
+        return false;
+    }
+    ok = fgets(line, sizeof(line), file) != NULL;
+    fclose(file);
+    if (!ok || (open = strchr(line, '(')) == NULL || (close = strrchr(line, ')')) == NULL) {
+        return false;
+    }
+    if (name != NULL) {
+        size_t length = (size_t)(close - open - 1);
+
+        if (length >= nameSize) {
+            length = nameSize - 1;
+        }
+        memcpy(name, open + 1, length);
+        name[length] = '\0';
+    }
+    cursor = close + 1;
+    for (int field = 3; field <= last; field++) {
+        char *end;
+        unsigned long long value;
+
+        while (*cursor == ' ') {
+            cursor++;
+        }
+        if (*cursor == '\0' || *cursor == '\n') {
+            return false;
+        }
+        if (field == 3 && state != NULL) {
+            *state = *cursor;
+        }
+        value = strtoull(cursor, &end, 10);
+        if (field >= first) {
+            values[field - first] = value;
+        }
+        while (*end != ' ' && *end != '\0' && *end != '\n') {
+            end++;
+        }
+        cursor = end;
+    }
+    return true;
+}
+
+void selfStatsInit(void) {
+    uint64_t startBrk = 0;
+
+    startNs = monotonicNowNs();
+    startMs = wallClockMs();
+    // The kernel knows where the heap began; older kernels lack the field
+    if (readStat("/proc/self/stat", NULL, 0, NULL, STAT_FIELD_START_BRK, STAT_FIELD_START_BRK, &startBrk) &&
+        startBrk != 0) {
+        heapStart = (uintptr_t)startBrk;
+    } else {
+        heapStart = (uintptr_t)sbrk(0);
+    }
+}
+
+void selfStatsSetConnectionLimit(unsigned int maxConnections) {
+    connectionLimit = maxConnections;
+}
+
+void selfStatsConnectionNotify(void *cls, struct MHD_Connection *connection, void **socketContext,
+                               enum MHD_ConnectionNotificationCode code) {
+    (void)cls;
+    (void)connection;
+    (void)socketContext;
+
+    if (code == MHD_CONNECTION_NOTIFY_STARTED) {
+        uint64_t open = __atomic_add_fetch(&connectionsOpened, 1, __ATOMIC_RELAXED) -
+                        __atomic_load_n(&connectionsClosed, __ATOMIC_RELAXED);
+        uint64_t peak = __atomic_load_n(&connectionsPeak, __ATOMIC_RELAXED);
+
+        while (open > peak && !__atomic_compare_exchange_n(&connectionsPeak, &peak, open, true, __ATOMIC_RELAXED,
+                                                           __ATOMIC_RELAXED)) {
+        }
+    } else if (code == MHD_CONNECTION_NOTIFY_CLOSED) {
+        __atomic_fetch_add(&connectionsClosed, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static uint64_t connectionsOpen(void) {
+    uint64_t closed = __atomic_load_n(&connectionsClosed, __ATOMIC_RELAXED);
+    uint64_t opened = __atomic_load_n(&connectionsOpened, __ATOMIC_RELAXED);
+
+    return opened > closed ? opened - closed : 0;
+}
+
+static uint64_t heapBytes(void) {
+    uintptr_t top = (uintptr_t)sbrk(0);
+
+    return top > heapStart ? (uint64_t)(top - heapStart) : 0;
+}
+
+// Data segment size (data, heap and anonymous mappings) from statm
+static uint64_t dataBytes(void) {
+    unsigned long pages[6];
+    FILE *statm = fopen("/proc/self/statm", "r");
+    bool ok;
+
+    if (statm == NULL) {
+        return 0;
+    }
+    ok = fscanf(statm, "%lu %lu %lu %lu %lu %lu", &pages[0], &pages[1], &pages[2], &pages[3], &pages[4],
+                &pages[5]) == 6;
+    fclose(statm);
+    return ok ? (uint64_t)pages[5] * (uint64_t)sysconf(_SC_PAGESIZE) : 0;
+}
+
+static int listThreads(SelfThread *threads, int max) {
+    DIR *dir = opendir("/proc/self/task");
+    struct dirent *entry;
+    int count = 0;
+
+    if (dir == NULL) {
+        return 0;
+    }
+    while (count < max && (entry = readdir(dir)) != NULL) {
+        char path[288];                  // Room for a 255 byte d_name
+        uint64_t times[2];
+        SelfThread *thread = &threads[count];
+
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') {
+            continue;
+        }
+        snprintf(path, sizeof(path), "/proc/self/task/%s/stat", entry->d_name);
+        // A thread that exited since readdir() is simply left out
+        if (!readStat(path, thread->name, sizeof(thread->name), &thread->state, STAT_FIELD_UTIME, STAT_FIELD_STIME,
+                      times)) {
+            continue;
+        }
+        thread->tid = atoi(entry->d_name);
+        thread->userTicks = times[0];
+        thread->systemTicks = times[1];
+        count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+static int listRings(SelfRing *rings) {
+    int count = 0;
+
+    rings[count++] = (SelfRing){ "events", eventsRingUsed(), EVENT_RING_SIZE };
+    rings[count++] = (SelfRing){ "access_log", accessLogRingUsed(), ACCESS_LOG_CAPACITY };
+    rings[count++] = (SelfRing){ "gpio_events", gpioEventsRingUsed(), GPIO_EVENT_RING };
+    return count;
+}
+
+static double tickSeconds(uint64_t ticks) {
+    long hz = sysconf(_SC_CLK_TCK);
+
+    return (double)ticks / (double)(hz > 0 ? hz : 100);
+}
+
+static double timevalSeconds(const struct timeval *value) {
+    return (double)value->tv_sec + (double)value->tv_usec / 1e6;
+}
+
+static void writeReport(JsonWriter *writer) {
+    SelfThread threads[SELF_MAX_THREADS];
+    SelfRing rings[3];
+    int threadCount = listThreads(threads, SELF_MAX_THREADS);
+    int ringCount = listRings(rings);
+    struct rusage usage;
+    bool haveUsage = getrusage(RUSAGE_SELF, &usage) == 0;
+
+    jsonBeginObject(writer);
+    jsonFieldDouble(writer, "uptime_s", (double)(monotonicNowNs() - startNs) / 1e9, 3);
+    jsonFieldUint(writer, "started_ms", startMs);
+
+    jsonKey(writer, "memory");
+    jsonBeginObject(writer);
+    jsonFieldUint(writer, "resident_bytes", memPoolResidentBytes());
+    if (haveUsage) {
+        jsonFieldUint(writer, "resident_peak_bytes", (uint64_t)usage.ru_maxrss * 1024ull);
+    }
+    jsonFieldUint(writer, "heap_bytes", heapBytes());
+    jsonFieldUint(writer, "data_bytes", dataBytes());
+    jsonEndObject(writer);
+
+    if (haveUsage) {
+        jsonKey(writer, "cpu");
+        jsonBeginObject(writer);
+        jsonFieldDouble(writer, "user_s", timevalSeconds(&usage.ru_utime), 3);
+        jsonFieldDouble(writer, "system_s", timevalSeconds(&usage.ru_stime), 3);
+        jsonEndObject(writer);
+    }
+
+    jsonKey(writer, "http");
+    jsonBeginObject(writer);
+    jsonFieldUint(writer, "connections", connectionsOpen());
+    jsonFieldUint(writer, "connections_peak", __atomic_load_n(&connectionsPeak, __ATOMIC_RELAXED));
+    jsonFieldUint(writer, "connections_total", __atomic_load_n(&connectionsOpened, __ATOMIC_RELAXED));
+    jsonFieldUint(writer, "connection_limit", connectionLimit);
+    jsonFieldInt(writer, "event_streams", eventsSubscribers());
+    jsonEndObject(writer);
+
+    jsonKey(writer, "hw_queue");
+    jsonBeginArray(writer);
+    for (int lane = 0; lane < HW_LANE_COUNT; lane++) {
+        jsonBeginObject(writer);
+        jsonFieldString(writer, "lane", hwLaneName((HwLane)lane));
+        jsonFieldUint(writer, "queued", hwActorQueued((HwLane)lane));
+        jsonFieldUint(writer, "capacity", HW_ACTOR_LANE_CAPACITY);
+        jsonEndObject(writer);
+    }
+    jsonEndArray(writer);
+
+    jsonKey(writer, "rings");
+    jsonBeginArray(writer);
+    for (int i = 0; i < ringCount; i++) {
+        jsonBeginObject(writer);
+        jsonFieldString(writer, "name", rings[i].name);
+        jsonFieldUint(writer, "used", rings[i].used);
+        jsonFieldUint(writer, "capacity", rings[i].capacity);
+        jsonEndObject(writer);
+    }
+    jsonEndArray(writer);
+
+    // Heap pools have no fixed block count: blocks and block_size are 0
+    jsonKey(writer, "pools");
+    jsonBeginArray(writer);
+    jsonBeginObject(writer);
+    jsonFieldString(writer, "name", "response");
+    jsonFieldUint(writer, "block_size", RESPONSE_BUFFER_SIZE);
+    jsonFieldUint(writer, "blocks", RESPONSE_POOL_SLOTS);
+    jsonFieldInt(writer, "in_use", responsePoolInUse());
+    jsonEndObject(writer);
+    for (const MemPool *pool = memPoolList(); pool != NULL; pool = pool->next) {
+        jsonBeginObject(writer);
+        jsonFieldString(writer, "name", pool->name);
+        jsonFieldUint(writer, "block_size", pool->storage ? pool->blockSize : 0);
+        jsonFieldUint(writer, "blocks", pool->storage ? pool->blocks : 0);
+        jsonFieldUint(writer, "in_use", __atomic_load_n(&pool->inUse, __ATOMIC_RELAXED));
+        jsonFieldUint(writer, "peak", __atomic_load_n(&pool->peak, __ATOMIC_RELAXED));
+        jsonFieldUint(writer, "exhausted", __atomic_load_n(&pool->exhausted, __ATOMIC_RELAXED));
+        jsonEndObject(writer);
+    }
+    jsonEndArray(writer);
+
+    jsonKey(writer, "threads");
+    jsonBeginArray(writer);
+    for (int i = 0; i < threadCount; i++) {
+        char state[2] = { threads[i].state, '\0' };
+
+        jsonBeginObject(writer);
+        jsonFieldInt(writer, "tid", threads[i].tid);
+        jsonFieldString(writer, "name", threads[i].name);
+        jsonFieldString(writer, "state", state);
+        jsonFieldDouble(writer, "user_s", tickSeconds(threads[i].userTicks), 2);
+        jsonFieldDouble(writer, "system_s", tickSeconds(threads[i].systemTicks), 2);
+        jsonEndObject(writer);
+    }
+    jsonEndArray(writer);
+    jsonEndObject(writer);
+}
+
+enum MHD_Result selfStatsQueueResponse(struct MHD_Connection *connection) {
+    ResponseBuffer body;
+    JsonWriter writer;
+
+    if (!responseBufferAcquireSize(&body, SELF_BODY_CAPACITY)) {
+        return MHD_NO;
+    }
+    responseWriterInit(&writer, &body, connection);
+    writeReport(&writer);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+void selfStatsCollectMetrics(StrBuf *out, void *ctx) {
+    SelfThread threads[SELF_MAX_THREADS];
+    SelfRing rings[3];
+    int threadCount = listThreads(threads, SELF_MAX_THREADS);
+    int ringCount = listRings(rings);
+    struct rusage usage;
+    (void)ctx;
+
+    metricsHeader(out, "watchdog_uptime_seconds", "gauge", "Time since the service started");
+    strbufAppendf(out, "watchdog_uptime_seconds %.3f\n", (double)(monotonicNowNs() - startNs) / 1e9);
+    metricsHeader(out, "watchdog_memory_heap_bytes", "gauge", "Extent of the main malloc arena (program break)");
+    strbufAppendf(out, "watchdog_memory_heap_bytes %llu\n", (unsigned long long)heapBytes());
+    metricsHeader(out, "watchdog_memory_data_bytes", "gauge", "Data segment size: data, heap and anonymous mappings");
+    strbufAppendf(out, "watchdog_memory_data_bytes %llu\n", (unsigned long long)dataBytes());
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        metricsHeader(out, "watchdog_process_cpu_seconds_total", "counter", "CPU time of the process by mode");
+        strbufAppendf(out, "watchdog_process_cpu_seconds_total{mode=\"user\"} %.3f\n", timevalSeconds(&usage.ru_utime));
+        strbufAppendf(out, "watchdog_process_cpu_seconds_total{mode=\"system\"} %.3f\n",
+                      timevalSeconds(&usage.ru_stime));
+    }
+    metricsHeader(out, "watchdog_thread_cpu_seconds_total", "counter", "CPU time per thread, user and system");
+    for (int i = 0; i < threadCount; i++) {
+        strbufAppendf(out, "watchdog_thread_cpu_seconds_total{thread=\"%s\",tid=\"%d\"} %.2f\n", threads[i].name,
+                      threads[i].tid, tickSeconds(threads[i].userTicks + threads[i].systemTicks));
+    }
+    metricsHeader(out, "watchdog_http_connections", "gauge", "Open HTTP connections");
+    strbufAppendf(out, "watchdog_http_connections %llu\n", (unsigned long long)connectionsOpen());
+    metricsHeader(out, "watchdog_http_connections_peak", "gauge", "Most HTTP connections open at once");
+    strbufAppendf(out, "watchdog_http_connections_peak %llu\n",
+                  (unsigned long long)__atomic_load_n(&connectionsPeak, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_http_connections_total", "counter", "HTTP connections accepted");
+    strbufAppendf(out, "watchdog_http_connections_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&connectionsOpened, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_ring_used", "gauge", "Slots in use per ring buffer");
+    for (int i = 0; i < ringCount; i++) {
+        strbufAppendf(out, "watchdog_ring_used{ring=\"%s\"} %u\n", rings[i].name, rings[i].used);
+    }
+    metricsHeader(out, "watchdog_ring_capacity", "gauge", "Slots per ring buffer");
+    for (int i = 0; i < ringCount; i++) {
+        strbufAppendf(out, "watchdog_ring_capacity{ring=\"%s\"} %u\n", rings[i].name, rings[i].capacity);
+    }
+}
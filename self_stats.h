@@ -0,0 +1,34 @@
+#ifndef SELF_STATS_H
+#define SELF_STATS_H
+
+#include <stdint.h>
+#include <microhttpd.h>
+#include "strbuf.h"
+
+#define SELF_MAX_THREADS 64              // Threads listed by /api/self
+#define SELF_BODY_CAPACITY 16384
+
+// What the service itself costs, for sizing pools and buffers: memory,
+// CPU per thread, the fill of the hardware command queue, the event rings
+// and the buffer pools, HTTP connections and uptime. Everything comes from
+// counters that are kept anyway (the queues' head and tail, the pools'
+// in-use counts) or that the kernel keeps (/proc/self), so a request costs
+// a few small reads and never walks the allocator. The heap figure is the
+// extent of the program break, the main malloc arena; blocks malloc maps
+// separately and other arenas show in the data segment size.
+
+// First thing in main(): the uptime and heap start are taken from here
+void selfStatsInit(void);
+// For the report; the limit the HTTP server was started with
+void selfStatsSetConnectionLimit(unsigned int maxConnections);
+
+// MHD_OPTION_NOTIFY_CONNECTION callback counting open connections
+void selfStatsConnectionNotify(void *cls, struct MHD_Connection *connection, void **socketContext,
+                               enum MHD_ConnectionNotificationCode code);
+
+// GET /api/self
+enum MHD_Result selfStatsQueueResponse(struct MHD_Connection *connection);
+
+void selfStatsCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // SELF_STATS_H
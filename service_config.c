@@ -0,0 +1,388 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include "service_config.h"
+#include "metrics.h"
+#include "events.h"
+#include "watchdog.h"
+
+#define CONFIG_DEBOUNCE_MS 50        // Editors often write a file in several steps
+#define CONFIG_ERROR_MAX 160
+
+// One published configuration and the number of readers holding it
+typedef struct {
+    ServiceConfig config;
+    uint32_t readers;
+} __attribute__((aligned(64))) ConfigSlot;
+
+static ConfigSlot slots[2];
+static int published = 0;
+static ServiceConfig baseConfig;
+static int startupPort;                 // Port the daemon is actually bound to
+static char *configPath = NULL;
+static const char *configName = NULL;   // Basename inside configDir
+static char *configDir = NULL;
+
+static pthread_t watcherThread;
+static bool watcherActive = false;
+static int inotifyFd = -1;
+static int stopFd = -1;
+static ServiceConfigCheck checkFn = NULL;
+static ServiceConfigApply applyFn = NULL;
+
+static uint64_t reloadsOk = 0;
+static uint64_t reloadsFailed = 0;
+
+const ServiceConfig* serviceConfigAcquire(void) {
+    for (;;) {
+        int index = __atomic_load_n(&published, __ATOMIC_ACQUIRE);
+
+        __atomic_add_fetch(&slots[index].readers, 1, __ATOMIC_SEQ_CST);
+        // If a reload swapped the pointer in between, the slot may be
+        // rewritten at any moment; drop it and take the new one
+        if (__atomic_load_n(&published, __ATOMIC_SEQ_CST) == index) {
+            return &slots[index].config;
+        }
+        __atomic_sub_fetch(&slots[index].readers, 1, __ATOMIC_RELEASE);
+    }
+}
+
+void serviceConfigRelease(const ServiceConfig *config) {
+    ConfigSlot *slot = (ConfigSlot *)((char *)config - offsetof(ConfigSlot, config));
+    __atomic_sub_fetch(&slot->readers, 1, __ATOMIC_RELEASE);
+}
+
+// Single writer: fill the idle slot once its last reader is gone (the grace
+// period is at most one request, since readers never hold a configuration
+// across requests) and swap the pointer
+static void publishConfig(const ServiceConfig *next) {
+    int current = __atomic_load_n(&published, __ATOMIC_RELAXED);
+    int idle = current ^ 1;
+
+    while (__atomic_load_n(&slots[idle].readers, __ATOMIC_SEQ_CST) != 0) {
+        sched_yield();
+    }
+    slots[idle].config = *next;
+    slots[idle].config.generation = slots[current].config.generation + 1;
+    __atomic_store_n(&published, idle, __ATOMIC_SEQ_CST);
+}
+
+static char* trim(char *text) {
+    char *end;
+
+    while (*text == ' ' || *text == '\t') {
+        text++;
+    }
+    end = text + strlen(text);
+    while (end > text && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n')) {
+        *--end = '\0';
+    }
+    return text;
+}
+
+static bool parseUint(const char *text, uint32_t max, uint32_t *value) {
+    char *end;
+    unsigned long long result;
+
+    if (*text < '0' || *text > '9') {
+        return false;
+    }
+    errno = 0;
+    result = strtoull(text, &end, 10);
+    if (errno != 0 || *end != '\0' || result > max) {
+        return false;
+    }
+    *value = (uint32_t)result;
+    return true;
+}
+
+static bool applyKey(ServiceConfig *config, const char *key, const char *value) {
+    uint32_t number;
+
+    if (strcmp(key, "port") == 0) {
+        if (!parseUint(value, 65535, &number) || number == 0) {
+            return false;
+        }
+        config->port = (int)number;
+    } else if (strcmp(key, "watchdog_id") == 0) {
+        if (strcmp(value, "auto") == 0) {
+            config->watchdogId = -1;
+        } else if (parseUint(value, WATCHDOG_MAX_DEVICES - 1, &number)) {
+            config->watchdogId = (int)number;
+        } else {
+            return false;
+        }
+    } else if (strcmp(key, "delay") == 0) {
+        return parseUint(value, UINT32_MAX, &config->delayTime);
+    } else if (strcmp(key, "event") == 0) {
+        return parseUint(value, UINT32_MAX, &config->eventTime);
+    } else if (strcmp(key, "reset") == 0) {
+        return parseUint(value, UINT32_MAX, &config->resetTime);
+    } else if (strcmp(key, "type") == 0) {
+        return parseUint(value, SUSI_WDT_EVENT_TYPE_PIN, &config->eventType);
+    } else if (strcmp(key, "log_level") == 0) {
+        return parseLogLevel(value, &config->logLevel);
+    } else if (strcmp(key, "log_sample") == 0) {
+        return parseUint(value, UINT32_MAX, &config->logSample) && config->logSample > 0;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Parse "key = value" lines on top of the base configuration. Blank lines
+// and lines starting with '#' are ignored.
+static bool loadConfigFile(ServiceConfig *config, char *error, size_t errorSize) {
+    char line[SERVICE_CONFIG_LINE_MAX];
+    FILE *file;
+    int lineNumber = 0;
+    bool ok = true;
+
+    *config = baseConfig;
+    file = fopen(configPath, "r");
+    if (file == NULL) {
+        snprintf(error, errorSize, "%s: %s", configPath, strerror(errno));
+        return false;
+    }
+    while (ok && fgets(line, sizeof(line), file) != NULL) {
+        char *key;
+        char *value;
+        char *equals;
+
+        lineNumber++;
+        if (strchr(line, '\n') == NULL && !feof(file)) {
+            snprintf(error, errorSize, "%s:%d: line too long", configPath, lineNumber);
+            ok = false;
+            break;
+        }
+        key = trim(line);
+        if (*key == '\0' || *key == '#') {
+            continue;
+        }
+        equals = strchr(key, '=');
+        if (equals == NULL) {
+            snprintf(error, errorSize, "%s:%d: expected key = value", configPath, lineNumber);
+            ok = false;
+            break;
+        }
+        *equals = '\0';
+        key = trim(key);
+        value = trim(equals + 1);
+        if (!applyKey(config, key, value)) {
+            snprintf(error, errorSize, "%s:%d: invalid setting '%s'", configPath, lineNumber, key);
+            ok = false;
+        }
+    }
+    if (ok && ferror(file)) {
+        snprintf(error, errorSize, "%s: read error", configPath);
+        ok = false;
+    }
+    fclose(file);
+    return ok;
+}
+
+bool serviceConfigInit(const ServiceConfig *base, const char *path) {
+    ServiceConfig config;
+    char error[CONFIG_ERROR_MAX];
+    char *slash;
+
+    baseConfig = *base;
+    baseConfig.generation = 0;
+    slots[0].config = baseConfig;
+    published = 0;
+    startupPort = baseConfig.port;
+    if (path == NULL) {
+        return true;
+    }
+
+    configPath = strdup(path);
+    configDir = strdup(path);
+    if (configPath == NULL || configDir == NULL) {
+        return false;
+    }
+    slash = strrchr(configDir, '/');
+    if (slash == NULL) {
+        free(configDir);
+        configDir = strdup(".");
+        configName = configPath;
+    } else {
+        configName = configPath + (slash - configDir) + 1;
+        if (slash == configDir) {
+            slash[1] = '\0';
+        } else {
+            *slash = '\0';
+        }
+    }
+
+    if (!loadConfigFile(&config, error, sizeof(error))) {
+        printf("Invalid configuration: %s\n", error);
+        return false;
+    }
+    publishConfig(&config);
+    startupPort = config.port;
+    printf("Configuration loaded from %s\n", configPath);
+    return true;
+}
+
+static void reloadConfig(void) {
+    ServiceConfig next;
+    const ServiceConfig *previous;
+    const char *problem;
+    char error[CONFIG_ERROR_MAX];
+
+    if (!loadConfigFile(&next, error, sizeof(error))) {
+        __atomic_fetch_add(&reloadsFailed, 1, __ATOMIC_RELAXED);
+        accessLogMessage(LOG_LEVEL_ERROR, "config reload failed, keeping generation %llu: %s",
+                         (unsigned long long)slots[published].config.generation, error);
+        return;
+    }
+    if (checkFn != NULL && (problem = checkFn(&next)) != NULL) {
+        __atomic_fetch_add(&reloadsFailed, 1, __ATOMIC_RELAXED);
+        accessLogMessage(LOG_LEVEL_ERROR, "config reload rejected: %s: %s", configPath, problem);
+        return;
+    }
+
+    // The watcher is the only writer, so the slot it just swapped out stays
+    // intact until the next reload
+    previous = &slots[published].config;
+    publishConfig(&next);
+    __atomic_fetch_add(&reloadsOk, 1, __ATOMIC_RELAXED);
+    if (previous->port != slots[published].config.port && slots[published].config.port != startupPort) {
+        accessLogMessage(LOG_LEVEL_WARN, "config: port change to %d takes effect after a restart",
+                         slots[published].config.port);
+    }
+    if (applyFn != NULL) {
+        applyFn(previous, &slots[published].config);
+    }
+    accessLogMessage(LOG_LEVEL_INFO, "config reloaded from %s (generation %llu)", configPath,
+                     (unsigned long long)slots[published].config.generation);
+    eventPublish(EVENT_CONFIG_RELOADED, EVENT_NO_WATCHDOG,
+                 (uint32_t)slots[published].config.generation, 0, 0, 0);
+}
+
+// True if the buffered inotify events name the configuration file
+static bool eventsTouchConfig(const char *buffer, ssize_t length) {
+    bool touched = false;
+
+    for (ssize_t offset = 0; offset < length; ) {
+        const struct inotify_event *event = (const struct inotify_event *)(buffer + offset);
+
+        if (event->len > 0 && strcmp(event->name, configName) == 0) {
+            touched = true;
+        }
+        offset += (ssize_t)sizeof(*event) + event->len;
+    }
+    return touched;
+}
+
+static void* watcherThreadMain(void *arg) {
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd fds[2];
+    bool pending = false;
+    (void)arg;
+
+    pthread_setname_np(pthread_self(), "config-watch");
+    fds[0].fd = inotifyFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = stopFd;
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        // Once a change is seen, wait until the file has been quiet for the
+        // debounce interval so a multi-step write is loaded once, complete
+        int ready = poll(fds, 2, pending ? CONFIG_DEBOUNCE_MS : -1);
+
+        if (ready < 0) {
+            continue;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+        if (ready == 0) {
+            pending = false;
+            reloadConfig();
+            continue;
+        }
+        if (fds[0].revents & POLLIN) {
+            ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+            if (length > 0 && eventsTouchConfig(buffer, length)) {
+                pending = true;
+            }
+        }
+    }
+    return NULL;
+}
+
+bool serviceConfigStartWatcher(ServiceConfigCheck check, ServiceConfigApply apply) {
+    if (watcherActive || configPath == NULL) {
+        return false;
+    }
+
+    // Watch the directory rather than the file: editors and config
+    // management usually replace the file with a rename, which would
+    // silently end a watch on the old inode
+    inotifyFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    stopFd = eventfd(0, EFD_CLOEXEC);
+    if (inotifyFd < 0 || stopFd < 0) {
+        perror("config: inotify/eventfd");
+        serviceConfigStopWatcher();
+        return false;
+    }
+    if (inotify_add_watch(inotifyFd, configDir, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        perror("config: inotify_add_watch");
+        serviceConfigStopWatcher();
+        return false;
+    }
+
+    checkFn = check;
+    applyFn = apply;
+    if (pthread_create(&watcherThread, NULL, watcherThreadMain, NULL) != 0) {
+        serviceConfigStopWatcher();
+        return false;
+    }
+    watcherActive = true;
+    printf("Watching %s for configuration changes\n", configPath);
+    return true;
+}
+
+void serviceConfigStopWatcher(void) {
+    uint64_t one = 1;
+
+    if (watcherActive) {
+        if (write(stopFd, &one, sizeof(one)) != sizeof(one)) {
+            perror("config: stop");
+        }
+        pthread_join(watcherThread, NULL);
+        watcherActive = false;
+    }
+    if (inotifyFd >= 0) {
+        close(inotifyFd);
+        inotifyFd = -1;
+    }
+    if (stopFd >= 0) {
+        close(stopFd);
+        stopFd = -1;
+    }
+}
+
+void serviceConfigCollectMetrics(StrBuf *out, void *ctx) {
+    const ServiceConfig *config = serviceConfigAcquire();
+    (void)ctx;
+
+    metricsHeader(out, "watchdog_config_generation", "gauge", "Configuration generation, bumped on every successful load");
+    strbufAppendf(out, "watchdog_config_generation %llu\n", (unsigned long long)config->generation);
+    serviceConfigRelease(config);
+    metricsHeader(out, "watchdog_config_reloads_total", "counter", "Configuration file reloads by result");
+    strbufAppendf(out, "watchdog_config_reloads_total{result=\"ok\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&reloadsOk, __ATOMIC_RELAXED));
+    strbufAppendf(out, "watchdog_config_reloads_total{result=\"error\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&reloadsFailed, __ATOMIC_RELAXED));
+}
@@ -0,0 +1,48 @@
+#ifndef SERVICE_CONFIG_H
+#define SERVICE_CONFIG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "access_log.h"
+#include "strbuf.h"
+
+#define SERVICE_CONFIG_LINE_MAX 256
+
+// Settings that can be changed at runtime through the --config file. The
+// command line supplies the base values; every key present in the file
+// overrides them, and a key removed from the file falls back to the base.
+typedef struct {
+    int port;                        // Only read at startup; a change needs a restart
+    int watchdogId;                  // Timer behind /api/*, -1 = first present
+    uint32_t delayTime;              // Timings for timers not configured through the API
+    uint32_t eventTime;
+    uint32_t resetTime;
+    uint32_t eventType;
+    LogLevel logLevel;
+    uint32_t logSample;
+    uint64_t generation;             // Bumped on every successful load
+} ServiceConfig;
+
+// Vet a parsed file before it is published; return NULL to accept it or an
+// error message to keep the current configuration
+typedef const char* (*ServiceConfigCheck)(const ServiceConfig *next);
+// Called on the watcher thread after a new configuration was published
+typedef void (*ServiceConfigApply)(const ServiceConfig *previous, const ServiceConfig *current);
+
+// Publish the base configuration and, if path is set, load the file on top
+// of it. Returns false if the file exists but cannot be parsed.
+bool serviceConfigInit(const ServiceConfig *base, const char *path);
+
+// Reader side. Configurations are immutable once published; a reload fills
+// the other slot and swaps the pointer, and only reuses a slot after every
+// reader has released it, so a request never sees a half-applied file.
+const ServiceConfig* serviceConfigAcquire(void);
+void serviceConfigRelease(const ServiceConfig *config);
+
+// Watch the file with inotify and reload it when it is written or replaced
+bool serviceConfigStartWatcher(ServiceConfigCheck check, ServiceConfigApply apply);
+void serviceConfigStopWatcher(void);
+
+void serviceConfigCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // SERVICE_CONFIG_H
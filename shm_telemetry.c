@@ -0,0 +1,330 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "shm_telemetry.h"
+#include "events.h"
+#include "gpio_bank.h"
+#include "hwm_sampler.h"
+#include "metrics.h"
+#include "timeutil.h"
+#include "watchdog.h"
+#include "watchdog_shm.h"
+
+typedef char ShmSensorsFit[HWM_SENSOR_SLOTS <= WATCHDOG_SHM_SENSORS ? 1 : -1];
+typedef char ShmBanksFit[GPIO_BANK_MAX <= WATCHDOG_SHM_GPIO_BANKS ? 1 : -1];
+typedef char ShmTimersFit[WATCHDOG_MAX_DEVICES <= WATCHDOG_SHM_TIMERS ? 1 : -1];
+typedef char ShmNameFits[HWM_NAME_MAX <= WATCHDOG_SHM_NAME_MAX ? 1 : -1];
+
+typedef enum {
+    SHM_SECTION_HWM,
+    SHM_SECTION_GPIO,
+    SHM_SECTION_WATCHDOG,
+    SHM_SECTION_COUNT
+} ShmSection;
+
+static const char *sectionNames[SHM_SECTION_COUNT] = { "hwm", "gpio", "watchdog" };
+
+static char segmentName[256];
+static uint32_t intervalMs = SHM_TELEMETRY_DEFAULT_INTERVAL_MS;
+
+static WatchdogShm *segment;
+// Cleared before the segment is unlinked; the sweep listener stays
+// registered and checks it
+static bool publishing;
+static bool listenerAdded;
+
+static pthread_mutex_t shmLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t shmWake;
+static pthread_t shmThread;
+static bool stopping;
+
+static uint64_t publications[SHM_SECTION_COUNT];
+static uint64_t gpioReadFailures;
+
+static uint64_t wallClockMs(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000ull + (uint64_t)now.tv_nsec / 1000000ull;
+}
+
+bool shmTelemetrySetName(const char *name) {
+    size_t length = strlen(name);
+
+    // shm_open() wants one leading slash and no others
+    if (name[0] != '/' || length < 2 || length >= sizeof(segmentName) || strchr(name + 1, '/') != NULL) {
+        return false;
+    }
+    memcpy(segmentName, name, length + 1);
+    return true;
+}
+
+bool shmTelemetrySetInterval(uint32_t interval) {
+    if (interval == 0) {
+        return false;
+    }
+    intervalMs = interval;
+    return true;
+}
+
+// Seqlock writer side; each section has a single writer thread
+static void sectionBegin(WatchdogShmSeq *seq) {
+    uint64_t sequence = __atomic_load_n(&seq->sequence, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&seq->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void sectionEnd(WatchdogShmSeq *seq, ShmSection section) {
+    seq->updates++;
+    seq->updatedMs = wallClockMs();
+    seq->updatedNs = monotonicNowNs();
+    __atomic_store_n(&seq->sequence, seq->sequence + 1, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&publications[section], 1, __ATOMIC_RELAXED);
+}
+
+// Sampler thread, after every sweep. The sweep only carries the sensors
+// that were due, so the section is rebuilt from the newest value of each.
+static void publishHwm(const HwmReading *reading, void *ctx) {
+    static HwmReading latest;
+    const HwmCapabilities *caps = hwmCapabilities();
+    WatchdogShmHwm *hwm = &segment->hwm;
+    (void)ctx;
+
+    if (!__atomic_load_n(&publishing, __ATOMIC_ACQUIRE) || !hwmLatest(&latest)) {
+        return;
+    }
+    sectionBegin(&hwm->seq);
+    hwm->sweep = reading->sequence;
+    hwm->count = (uint32_t)caps->count;
+    for (int i = 0; i < caps->count; i++) {
+        int slot = caps->slots[i];
+        const HwmSensor *sensor = hwmSensor(slot);
+        WatchdogShmSensor *out = &hwm->sensors[i];
+        bool valid = (latest.validMask & (1ull << slot)) != 0;
+
+        out->id = sensor->id;
+        out->kind = (uint32_t)sensor->kind;
+        out->raw = latest.values[slot];
+        out->valid = valid ? 1 : 0;
+        out->value = valid ? hwmScale(sensor->kind, latest.values[slot]) : 0.0;
+        out->sampledMs = latest.sampledMs[slot];
+        memcpy(out->name, sensor->name, sizeof(sensor->name));
+    }
+    sectionEnd(&hwm->seq, SHM_SECTION_HWM);
+}
+
+static void publishGpio(void) {
+    GpioBankState states[GPIO_BANK_MAX];
+    WatchdogShmGpio *gpio = &segment->gpio;
+    int count = gpioBankRead(states);
+
+    if (count <= 0 && gpioBankCount() > 0) {
+        __atomic_add_fetch(&gpioReadFailures, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    sectionBegin(&gpio->seq);
+    gpio->count = (uint32_t)count;
+    for (int i = 0; i < count; i++) {
+        WatchdogShmGpioBank *bank = &gpio->banks[i];
+
+        bank->bank = states[i].bank;
+        bank->inputs = states[i].inputs;
+        bank->outputs = states[i].outputs;
+        bank->interrupts = states[i].interrupts;
+        bank->direction = states[i].direction;
+        bank->level = states[i].level;
+        bank->status = states[i].status;
+    }
+    sectionEnd(&gpio->seq, SHM_SECTION_GPIO);
+}
+
+// Straight from the feed trackers; no hardware access
+static void publishWatchdog(uint64_t nowNs) {
+    WatchdogShmWatchdog *watchdog = &segment->watchdog;
+    uint32_t count = 0;
+
+    sectionBegin(&watchdog->seq);
+    for (SusiId_t id = 0; id < WATCHDOG_MAX_DEVICES; id++) {
+        WatchdogDevice *device = watchdogDevice(id);
+        WatchdogShmTimer *timer;
+        WatchdogCommand timings;
+        int64_t remainingNs;
+
+        if (!device->present) {
+            continue;
+        }
+        timer = &watchdog->timers[count++];
+        watchdogCommandInit(&timings, device);
+        remainingNs = watchdogResetDeadlineNs(device, nowNs, NULL);
+        timer->id = id;
+        timer->present = 1;
+        timer->running = device->running ? 1 : 0;
+        timer->delayTime = timings.delayTime;
+        timer->eventTime = timings.eventTime;
+        timer->resetTime = timings.resetTime;
+        timer->eventType = timings.eventType;
+        timer->armedNs = __atomic_load_n(&device->tracker.armedNs, __ATOMIC_ACQUIRE);
+        timer->lastFeedNs = __atomic_load_n(&device->tracker.lastFeedNs, __ATOMIC_ACQUIRE);
+        timer->feedCount = __atomic_load_n(&device->tracker.feedCount, __ATOMIC_RELAXED);
+        if (remainingNs == INT64_MAX) {
+            timer->resetAtNs = 0;
+        } else {
+            timer->resetAtNs = remainingNs > 0 ? nowNs + (uint64_t)remainingNs : nowNs;
+        }
+    }
+    watchdog->count = count;
+    watchdog->defaultId = watchdogDefaultDevice()->id;
+    sectionEnd(&watchdog->seq, SHM_SECTION_WATCHDOG);
+}
+
+// True when a GPIO event arrived since the last call
+static bool gpioChanged(uint64_t *cursor) {
+    Event event;
+    uint64_t missed = 0;
+    bool changed = false;
+
+    while (eventsRead(cursor, &event, &missed)) {
+        if (event.type == EVENT_GPIO) {
+            changed = true;
+        }
+    }
+    // Whatever was overwritten may have been GPIO
+    return changed || missed > 0;
+}
+
+static void* shmThreadMain(void *arg) {
+    uint64_t cursor = eventsNext();
+    uint64_t dueNs = monotonicNowNs();
+    uint64_t gpioDueNs = 0;
+    (void)arg;
+
+    pthread_setname_np(pthread_self(), "shm");
+    pthread_mutex_lock(&shmLock);
+    while (!stopping) {
+        struct timespec deadline;
+        uint64_t now;
+
+        pthread_mutex_unlock(&shmLock);
+        now = monotonicNowNs();
+        publishWatchdog(now);
+        if (gpioChanged(&cursor) || now >= gpioDueNs) {
+            publishGpio();
+            gpioDueNs = now + (uint64_t)SHM_TELEMETRY_GPIO_REFRESH_MS * 1000000ull;
+        }
+        __atomic_store_n(&segment->header.heartbeatMs, wallClockMs(), __ATOMIC_RELEASE);
+        pthread_mutex_lock(&shmLock);
+
+        dueNs += (uint64_t)intervalMs * 1000000ull;
+        if (dueNs < monotonicNowNs()) {
+            dueNs = monotonicNowNs();
+        }
+        deadline.tv_sec = (time_t)(dueNs / 1000000000ull);
+        deadline.tv_nsec = (long)(dueNs % 1000000000ull);
+        while (!stopping && pthread_cond_timedwait(&shmWake, &shmLock, &deadline) == 0) {
+        }
+    }
+    pthread_mutex_unlock(&shmLock);
+    return NULL;
+}
+
+bool shmTelemetryStart(void) {
+    pthread_condattr_t attr;
+    void *mapping;
+    int fd;
+
+    if (segmentName[0] == '\0') {
+        return true;
+    }
+    fd = shm_open(segmentName, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Telemetry segment %s: %s\n", segmentName, strerror(errno));
+        return false;
+    }
+    if (ftruncate(fd, sizeof(WatchdogShm)) != 0) {
+        fprintf(stderr, "Telemetry segment %s: %s\n", segmentName, strerror(errno));
+        close(fd);
+        shm_unlink(segmentName);
+        return false;
+    }
+    mapping = mmap(NULL, sizeof(WatchdogShm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "Telemetry segment %s: %s\n", segmentName, strerror(errno));
+        shm_unlink(segmentName);
+        return false;
+    }
+    segment = mapping;
+    segment->header.version = WATCHDOG_SHM_VERSION;
+    segment->header.size = sizeof(WatchdogShm);
+    segment->header.pid = (uint32_t)getpid();
+    segment->header.startedMs = wallClockMs();
+    segment->header.heartbeatMs = segment->header.startedMs;
+    segment->header.running = 1;
+    segment->header.intervalMs = intervalMs;
+    // Readers check the magic first, so it goes in once the rest is there
+    __atomic_store_n(&segment->header.magic, WATCHDOG_SHM_MAGIC, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&publishing, true, __ATOMIC_RELEASE);
+    if (!listenerAdded) {
+        listenerAdded = hwmAddListener(publishHwm, NULL);
+        if (!listenerAdded) {
+            printf("Warning: telemetry segment will not carry HWM readings\n");
+        }
+    }
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&shmWake, &attr);
+    pthread_condattr_destroy(&attr);
+    stopping = false;
+    if (pthread_create(&shmThread, NULL, shmThreadMain, NULL) != 0) {
+        __atomic_store_n(&publishing, false, __ATOMIC_RELEASE);
+        pthread_cond_destroy(&shmWake);
+        shm_unlink(segmentName);
+        segmentName[0] = '\0';
+        return false;
+    }
+    printf("Telemetry segment: /dev/shm%s, %zu bytes, watchdog and GPIO every %u ms\n",
+           segmentName, sizeof(WatchdogShm), intervalMs);
+    return true;
+}
+
+void shmTelemetryStop(void) {
+    if (segmentName[0] == '\0' || segment == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&shmLock);
+    stopping = true;
+    pthread_cond_signal(&shmWake);
+    pthread_mutex_unlock(&shmLock);
+    pthread_join(shmThread, NULL);
+    pthread_cond_destroy(&shmWake);
+
+    // The mapping stays: the sampler may be inside the listener right now,
+    // and readers that have the segment open keep the final values
+    __atomic_store_n(&publishing, false, __ATOMIC_RELEASE);
+    __atomic_store_n(&segment->header.running, 0, __ATOMIC_RELEASE);
+    shm_unlink(segmentName);
+    segmentName[0] = '\0';
+}
+
+void shmTelemetryCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (segment == NULL) {
+        return;
+    }
+    metricsHeader(out, "watchdog_shm_publications_total", "counter", "Sections written to the telemetry segment");
+    for (int i = 0; i < SHM_SECTION_COUNT; i++) {
+        strbufAppendf(out, "watchdog_shm_publications_total{section=\"%s\"} %llu\n", sectionNames[i],
+                      (unsigned long long)__atomic_load_n(&publications[i], __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_shm_gpio_read_failures_total", "counter",
+                  "GPIO refreshes of the telemetry segment that failed");
+    strbufAppendf(out, "watchdog_shm_gpio_read_failures_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&gpioReadFailures, __ATOMIC_RELAXED));
+}
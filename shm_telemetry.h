@@ -0,0 +1,33 @@
+#ifndef SHM_TELEMETRY_H
+#define SHM_TELEMETRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "strbuf.h"
+
+#define SHM_TELEMETRY_DEFAULT_INTERVAL_MS 250
+#define SHM_TELEMETRY_GPIO_REFRESH_MS 1000   // GPIO banks are re-read at least this often
+
+// Publishes the newest HWM sweep, GPIO levels and watchdog state into the
+// shared-memory segment described by watchdog_shm.h, so local agents map it
+// read-only instead of polling HTTP. The HWM section is written from the
+// sampler's sweep listener as each sweep lands. The watchdog section is
+// copied from the feed trackers every interval, which costs no SUSI call.
+// The GPIO section is refreshed with one bank read on the hardware thread
+// when a GPIO event arrived during the interval, and at least once every
+// SHM_TELEMETRY_GPIO_REFRESH_MS otherwise.
+
+// Both before shmTelemetryStart(); NAME as given to shm_open ("/name")
+bool shmTelemetrySetName(const char *name);
+bool shmTelemetrySetInterval(uint32_t intervalMs);
+
+// Create the segment and start publishing; does nothing and returns true
+// without a name. After hwmInit(), gpioBankInit() and watchdogInit().
+bool shmTelemetryStart(void);
+// Mark the segment stopped and unlink it; readers that have it mapped keep
+// the last values
+void shmTelemetryStop(void);
+
+void shmTelemetryCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // SHM_TELEMETRY_H
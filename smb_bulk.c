@@ -0,0 +1,258 @@
+#include <string.h>
+#include <unistd.h>
+#include "smb_bulk.h"
+#include "hw_actor.h"
+#include "metrics.h"
+#include "susi_timing.h"
+#include "timeutil.h"
+
+#define SMB_BULK_ADDRESSES 128
+
+enum { SMB_DIR_READ, SMB_DIR_WRITE, SMB_DIR_COUNT };
+
+// One transaction, run on the hardware thread
+typedef struct {
+    SusiId_t bus;
+    uint8_t address;                 // Encoded 8-bit address
+    uint8_t offset;
+    uint8_t *data;
+    uint32_t length;                 // At most the mode's transfer size
+    bool write;
+    SmbMode mode;
+    SusiStatus_t status;
+} SmbTransaction;
+
+static const char *modeNames[SMB_MODE_COUNT] = {
+    [SMB_MODE_I2C_BLOCK] = "i2c_block",
+    [SMB_MODE_BLOCK]     = "block",
+    [SMB_MODE_WORD]      = "word",
+    [SMB_MODE_BYTE]      = "byte",
+};
+
+static const uint32_t modeSizes[SMB_MODE_COUNT] = {
+    [SMB_MODE_I2C_BLOCK] = SMB_BULK_BLOCK_MAX,
+    [SMB_MODE_BLOCK]     = SMB_BULK_BLOCK_MAX,
+    [SMB_MODE_WORD]      = 2,
+    [SMB_MODE_BYTE]      = 1,
+};
+
+// Best mode known per direction and device; zero-initialised to
+// SMB_MODE_I2C_BLOCK so every device starts at the top
+static uint8_t deviceModes[SMB_DIR_COUNT][SUSI_SMBUS_MAX_DEVICE][SMB_BULK_ADDRESSES];
+
+static uint64_t transfers[SMB_DIR_COUNT];
+static uint64_t bytesMoved[SMB_DIR_COUNT];
+static uint64_t busyNs[SMB_DIR_COUNT];
+static uint64_t transactions[SMB_MODE_COUNT];
+static uint64_t fallbacks;
+static uint64_t lastRateMilli[SMB_DIR_COUNT];   // Bytes per second of the last transfer, x1000
+
+static void hwTransaction(void *arg) {
+    SmbTransaction *t = (SmbTransaction *)arg;
+    uint64_t start = monotonicNowNs();
+
+    switch (t->mode) {
+    case SMB_MODE_I2C_BLOCK:
+        if (t->write) {
+            t->status = SusiSMBI2CWriteBlock(t->bus, t->address, t->offset, t->data, t->length);
+            susiTimingRecord(SUSI_CALL_SMB_I2C_WRITE_BLOCK, start, t->status);
+        } else {
+            t->status = SusiSMBI2CReadBlock(t->bus, t->address, t->offset, t->data, t->length);
+            susiTimingRecord(SUSI_CALL_SMB_I2C_READ_BLOCK, start, t->status);
+        }
+        break;
+    case SMB_MODE_BLOCK: {
+        // The device sends the count and may send up to 32 bytes whatever
+        // was asked for; a memory device without block support sends its
+        // first data byte as the count, so anything but the requested
+        // length means unsupported
+        uint8_t block[SMB_BULK_BLOCK_MAX];
+        uint32_t length = t->length;
+
+        t->status = SusiSMBReadBlock(t->bus, t->address, t->offset, block, &length);
+        susiTimingRecord(SUSI_CALL_SMB_READ_BLOCK, start, t->status);
+        if (t->status == SUSI_STATUS_SUCCESS && length != t->length) {
+            t->status = SUSI_STATUS_INVALID_BLOCK_LENGTH;
+        } else if (t->status == SUSI_STATUS_SUCCESS) {
+            memcpy(t->data, block, t->length);
+        }
+        break;
+    }
+    case SMB_MODE_WORD: {
+        uint16_t word = (uint16_t)(t->write ? (t->data[0] | t->data[1] << 8) : 0);
+
+        if (t->write) {
+            t->status = SusiSMBWriteWord(t->bus, t->address, t->offset, word);
+            susiTimingRecord(SUSI_CALL_SMB_WRITE_WORD, start, t->status);
+        } else {
+            t->status = SusiSMBReadWord(t->bus, t->address, t->offset, &word);
+            susiTimingRecord(SUSI_CALL_SMB_READ_WORD, start, t->status);
+            t->data[0] = (uint8_t)(word & 0xff);
+            t->data[1] = (uint8_t)(word >> 8);
+        }
+        break;
+    }
+    default:
+        if (t->write) {
+            t->status = SusiSMBWriteByte(t->bus, t->address, t->offset, t->data[0]);
+            susiTimingRecord(SUSI_CALL_SMB_WRITE_BYTE, start, t->status);
+        } else {
+            t->status = SusiSMBReadByte(t->bus, t->address, t->offset, t->data);
+            susiTimingRecord(SUSI_CALL_SMB_READ_BYTE, start, t->status);
+        }
+        break;
+    }
+}
+
+// Errors that say "not like this" rather than "not now"; the next smaller
+// mode gets a try
+static bool modeRejected(SusiStatus_t status) {
+    return status == SUSI_STATUS_UNSUPPORTED || status == SUSI_STATUS_INVALID_PARAMETER ||
+           status == SUSI_STATUS_INVALID_BLOCK_LENGTH || status == SUSI_STATUS_INVALID_BLOCK_ALIGNMENT ||
+           status == SUSI_STATUS_MORE_DATA || status == SUSI_STATUS_READ_ERROR || status == SUSI_STATUS_ERROR;
+}
+
+static SmbMode nextMode(SmbMode mode, bool write) {
+    // An SMBus block write puts a count byte in front of the data, which a
+    // memory device would store, so writes skip that mode
+    if (mode == SMB_MODE_I2C_BLOCK && write) {
+        return SMB_MODE_WORD;
+    }
+    return (SmbMode)(mode + 1);
+}
+
+static bool transfer(SusiId_t bus, uint8_t address, uint32_t offset, uint8_t *data, uint32_t length,
+                     bool write, uint32_t pageSize, SmbBulkResult *result) {
+    int dir = write ? SMB_DIR_WRITE : SMB_DIR_READ;
+    uint8_t *cached;
+    SmbMode mode;
+    int retries = 0;
+    uint64_t start = monotonicNowNs();
+
+    memset(result, 0, sizeof(*result));
+    result->status = SUSI_STATUS_SUCCESS;
+    if (bus >= SUSI_SMBUS_MAX_DEVICE || address >= SMB_BULK_ADDRESSES || length == 0 ||
+        offset + length > SMB_BULK_SPACE) {
+        result->status = SUSI_STATUS_INVALID_PARAMETER;
+        return false;
+    }
+    cached = &deviceModes[dir][bus][address];
+    mode = (SmbMode)__atomic_load_n(cached, __ATOMIC_RELAXED);
+
+    while (result->bytes < length) {
+        uint32_t position = offset + result->bytes;
+        uint32_t remaining = length - result->bytes;
+        SmbTransaction t;
+
+        t.bus = bus;
+        t.address = (uint8_t)(address << 1);
+        t.offset = (uint8_t)position;
+        t.data = data + result->bytes;
+        t.write = write;
+        // A trailing odd byte goes as a byte without demoting the device
+        t.mode = mode == SMB_MODE_WORD && remaining == 1 ? SMB_MODE_BYTE : mode;
+        t.length = remaining < modeSizes[t.mode] ? remaining : modeSizes[t.mode];
+        if (pageSize > 0 && position % pageSize + t.length > pageSize) {
+            t.length = pageSize - position % pageSize;
+            if (t.mode == SMB_MODE_WORD && t.length == 1) {
+                t.mode = SMB_MODE_BYTE;
+            }
+        }
+        if (!hwActorCall(HW_LANE_USER, hwTransaction, &t)) {
+            result->status = SUSI_STATUS_LOCKFAIL;
+            break;
+        }
+        result->transactions++;
+        result->mode = t.mode;
+        __atomic_fetch_add(&transactions[t.mode], 1, __ATOMIC_RELAXED);
+
+        if (t.status == SUSI_STATUS_SUCCESS) {
+            result->bytes += t.length;
+            retries = 0;
+            if (t.mode == mode) {
+                __atomic_store_n(cached, (uint8_t)mode, __ATOMIC_RELAXED);
+            }
+            continue;
+        }
+        if (modeRejected(t.status) && t.mode != SMB_MODE_BYTE) {
+            mode = nextMode(t.mode, write);
+            __atomic_fetch_add(&fallbacks, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+        // An EEPROM does not acknowledge its address while it commits the
+        // previous page; wait here rather than on the hardware thread
+        if (write && result->bytes > 0 && retries < SMB_BULK_WRITE_RETRIES &&
+            (t.status == SUSI_STATUS_NOT_FOUND || t.status == SUSI_STATUS_NOACK)) {
+            retries++;
+            usleep(SMB_BULK_WRITE_RETRY_US);
+            continue;
+        }
+        result->status = t.status;
+        break;
+    }
+
+    result->durationNs = monotonicNowNs() - start;
+    if (result->durationNs > 0) {
+        result->bytesPerSecond = (double)result->bytes * 1e9 / (double)result->durationNs;
+    }
+    __atomic_fetch_add(&transfers[dir], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&bytesMoved[dir], (uint64_t)result->bytes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&busyNs[dir], result->durationNs, __ATOMIC_RELAXED);
+    if (result->bytes > 0) {
+        __atomic_store_n(&lastRateMilli[dir], (uint64_t)(result->bytesPerSecond * 1000.0), __ATOMIC_RELAXED);
+    }
+    return result->bytes == length;
+}
+
+bool smbBulkRead(SusiId_t bus, uint8_t address, uint32_t offset, uint8_t *data, uint32_t length,
+                 SmbBulkResult *result) {
+    return transfer(bus, address, offset, data, length, false, 0, result);
+}
+
+bool smbBulkWrite(SusiId_t bus, uint8_t address, uint32_t offset, const uint8_t *data, uint32_t length,
+                  uint32_t pageSize, SmbBulkResult *result) {
+    // The SUSI write calls take non-const buffers but only read them
+    return transfer(bus, address, offset, (uint8_t *)data, length, true, pageSize, result);
+}
+
+const char* smbModeName(SmbMode mode) {
+    return mode < SMB_MODE_COUNT ? modeNames[mode] : "unknown";
+}
+
+void smbBulkCollectMetrics(StrBuf *out, void *ctx) {
+    static const char *dirNames[SMB_DIR_COUNT] = { "read", "write" };
+    (void)ctx;
+
+    if (__atomic_load_n(&transfers[SMB_DIR_READ], __ATOMIC_RELAXED) == 0 &&
+        __atomic_load_n(&transfers[SMB_DIR_WRITE], __ATOMIC_RELAXED) == 0) {
+        return;
+    }
+    metricsHeader(out, "watchdog_smb_bulk_transfers_total", "counter", "SMBus bulk reads and writes");
+    for (int dir = 0; dir < SMB_DIR_COUNT; dir++) {
+        strbufAppendf(out, "watchdog_smb_bulk_transfers_total{direction=\"%s\"} %llu\n", dirNames[dir],
+                      (unsigned long long)__atomic_load_n(&transfers[dir], __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_smb_bulk_bytes_total", "counter", "Bytes moved by SMBus bulk transfers");
+    for (int dir = 0; dir < SMB_DIR_COUNT; dir++) {
+        strbufAppendf(out, "watchdog_smb_bulk_bytes_total{direction=\"%s\"} %llu\n", dirNames[dir],
+                      (unsigned long long)__atomic_load_n(&bytesMoved[dir], __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_smb_bulk_seconds_total", "counter", "Time spent in SMBus bulk transfers");
+    for (int dir = 0; dir < SMB_DIR_COUNT; dir++) {
+        strbufAppendf(out, "watchdog_smb_bulk_seconds_total{direction=\"%s\"} %.6f\n", dirNames[dir],
+                      (double)__atomic_load_n(&busyNs[dir], __ATOMIC_RELAXED) / 1e9);
+    }
+    metricsHeader(out, "watchdog_smb_bulk_bytes_per_second", "gauge", "Effective rate of the last SMBus bulk transfer");
+    for (int dir = 0; dir < SMB_DIR_COUNT; dir++) {
+        strbufAppendf(out, "watchdog_smb_bulk_bytes_per_second{direction=\"%s\"} %.3f\n", dirNames[dir],
+                      (double)__atomic_load_n(&lastRateMilli[dir], __ATOMIC_RELAXED) / 1000.0);
+    }
+    metricsHeader(out, "watchdog_smb_bulk_transactions_total", "counter", "SUSI transactions issued per transfer mode");
+    for (int mode = 0; mode < SMB_MODE_COUNT; mode++) {
+        strbufAppendf(out, "watchdog_smb_bulk_transactions_total{mode=\"%s\"} %llu\n", modeNames[mode],
+                      (unsigned long long)__atomic_load_n(&transactions[mode], __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_smb_bulk_fallbacks_total", "counter", "Transfers retried in a smaller mode");
+    strbufAppendf(out, "watchdog_smb_bulk_fallbacks_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&fallbacks, __ATOMIC_RELAXED));
+}
@@ -0,0 +1,51 @@
+#ifndef SMB_BULK_H
+#define SMB_BULK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "Susi4.h"
+#include "strbuf.h"
+
+#define SMB_BULK_BLOCK_MAX 32            // SMBus block transfers carry at most 32 bytes
+#define SMB_BULK_SPACE 256               // Offsets are the 8-bit command byte
+#define SMB_BULK_WRITE_RETRIES 10        // NACKs tolerated while an EEPROM finishes a write cycle
+#define SMB_BULK_WRITE_RETRY_US 1000
+
+// Bulk access to EEPROM-like SMBus devices. Transfers use the largest
+// transaction the device accepts: I2C block, then SMBus block (reads
+// only, and only if the device returns the requested length), then word,
+// then byte. The mode that worked is remembered per device, so the probing
+// happens once; a later failure steps down one mode and retries the same
+// chunk. Each transaction is one hardware-thread command, so a feed never
+// waits behind more than one 32-byte transfer.
+
+typedef enum {
+    SMB_MODE_I2C_BLOCK,
+    SMB_MODE_BLOCK,
+    SMB_MODE_WORD,
+    SMB_MODE_BYTE,
+    SMB_MODE_COUNT
+} SmbMode;
+
+typedef struct {
+    SusiStatus_t status;             // First error that ended the transfer
+    uint32_t bytes;                  // Transferred before it ended
+    uint32_t transactions;           // SUSI calls, including failed attempts
+    SmbMode mode;                    // Mode of the last transaction
+    uint64_t durationNs;
+    double bytesPerSecond;
+} SmbBulkResult;
+
+// Read length bytes from offset of address (7-bit) on bus; false if
+// nothing was read, see result->status
+bool smbBulkRead(SusiId_t bus, uint8_t address, uint32_t offset, uint8_t *data, uint32_t length,
+                 SmbBulkResult *result);
+// Write length bytes at offset. With pageSize, no transaction crosses a
+// page boundary (EEPROM pages wrap); 0 means the device has no pages.
+bool smbBulkWrite(SusiId_t bus, uint8_t address, uint32_t offset, const uint8_t *data, uint32_t length,
+                  uint32_t pageSize, SmbBulkResult *result);
+
+const char* smbModeName(SmbMode mode);
+void smbBulkCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // SMB_BULK_H
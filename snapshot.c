@@ -0,0 +1,394 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "snapshot.h"
+#include "mem_pool.h"
+#include "timeutil.h"
+#include "span_trace.h"
+
+#ifdef WATCHDOG_NO_HEAP
+// Buffers never grow: what a render could have asked for later is reserved
+// up front, and its pages stay out of the resident set until one reaches them
+#define SNAPSHOT_RESERVE 4
+#else
+#define SNAPSHOT_RESERVE 1
+#endif
+
+// Distinguishes generations of different process lifetimes in ETags
+static unsigned long snapshotEpoch = 0;
+
+// Called by MHD once the last connection using a published buffer is done
+static void snapshotRelease(void *cls) {
+    SnapshotBuffer *buffer = (SnapshotBuffer *)cls;
+    __atomic_store_n(&buffer->busy, false, __ATOMIC_RELEASE);
+}
+
+bool snapshotInit(Snapshot *snap, size_t capacity, const char *contentType, const char *etagPrefix) {
+    memset(snap, 0, sizeof(*snap));
+    pthread_mutex_init(&snap->lock, NULL);
+    snap->published = -1;
+    snap->writing = -1;
+    snap->contentType = contentType;
+    snap->etagPrefix = etagPrefix;
+    capacity *= SNAPSHOT_RESERVE;
+    if (snapshotEpoch == 0) {
+        snapshotEpoch = (unsigned long)time(NULL);
+    }
+    
+    for (int i = 0; i < SNAPSHOT_BUFFERS; i++) {
+        snap->buffers[i].data = malloc(capacity);
+        if (snap->buffers[i].data == NULL) {
+            snapshotDestroy(snap);
+            return false;
+        }
+        snap->buffers[i].capacity = capacity;
+    }
+    return true;
+}
+
+void snapshotDestroy(Snapshot *snap) {
+    pthread_mutex_lock(&snap->lock);
+    if (snap->response) {
+        MHD_destroy_response(snap->response);
+        snap->response = NULL;
+    }
+    if (snap->notModified) {
+        MHD_destroy_response(snap->notModified);
+        snap->notModified = NULL;
+    }
+    for (int i = 0; i < CONTENT_ENCODING_COUNT; i++) {
+        if (snap->variants[i].response) {
+            MHD_destroy_response(snap->variants[i].response);
+        }
+        if (snap->variants[i].notModified) {
+            MHD_destroy_response(snap->variants[i].notModified);
+        }
+        memset(&snap->variants[i], 0, sizeof(snap->variants[i]));
+    }
+    snap->published = -1;
+    pthread_mutex_unlock(&snap->lock);
+    
+    // Only called after the daemon is stopped, so no reader holds a buffer
+    for (int i = 0; i < SNAPSHOT_BUFFERS; i++) {
+        free(snap->buffers[i].data);
+        snap->buffers[i].data = NULL;
+    }
+    pthread_mutex_destroy(&snap->lock);
+}
+
+char* snapshotBegin(Snapshot *snap, size_t *capacity) {
+    char *data = NULL;
+    
+    pthread_mutex_lock(&snap->lock);
+    // A write an error path left open is dropped here, so it can neither
+    // block this one nor be published by a later snapshotPublish
+    snap->writing = -1;
+    for (int i = 0; i < SNAPSHOT_BUFFERS; i++) {
+        if (i != snap->published && snap->buffers[i].pins == 0 &&
+            !__atomic_load_n(&snap->buffers[i].busy, __ATOMIC_ACQUIRE)) {
+            snap->writing = i;
+            snap->beganNs = monotonicNowNs();
+            data = snap->buffers[i].data;
+            *capacity = snap->buffers[i].capacity;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&snap->lock);
+    return data;
+}
+
+// Enlarge the buffer currently being written; its contents are discarded.
+// Always refused, and counted, without a heap.
+bool snapshotGrow(Snapshot *snap, size_t capacity) {
+#ifdef WATCHDOG_NO_HEAP
+    (void)snap;
+    (void)capacity;
+    memPoolRecordRefusal();
+    return false;
+#else
+    SnapshotBuffer *buffer;
+    char *data;
+    
+    if (snap->writing < 0) {
+        return false;
+    }
+    buffer = &snap->buffers[snap->writing];
+    data = realloc(buffer->data, capacity);
+    if (data == NULL) {
+        return false;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+#endif
+}
+
+bool snapshotPublish(Snapshot *snap, size_t length) {
+    SnapshotBuffer *buffer;
+    struct MHD_Response *response;
+    struct MHD_Response *notModified;
+    struct MHD_Response *old;
+    struct MHD_Response *oldNotModified;
+    struct MHD_Response *oldVariants[2 * CONTENT_ENCODING_COUNT];
+    char etag[64];
+    
+    if (snap->writing < 0) {
+        return false;
+    }
+    spanTraceRecord(SPAN_SERIALIZE, snap->etagPrefix, snap->beganNs, monotonicNowNs());
+    buffer = &snap->buffers[snap->writing];
+    
+    // The response references the buffer directly (persistent memory);
+    // snapshotRelease tells us when MHD no longer needs it.
+    __atomic_store_n(&buffer->busy, true, __ATOMIC_RELEASE);
+    response = MHD_create_response_from_buffer_with_free_callback_cls(length, buffer->data,
+                                                                     &snapshotRelease, buffer);
+    if (response == NULL) {
+        __atomic_store_n(&buffer->busy, false, __ATOMIC_RELEASE);
+        snap->writing = -1;
+        return false;
+    }
+    if (snap->contentType) {
+        MHD_add_response_header(response, "Content-Type", snap->contentType);
+    }
+    
+    // Generation is only written by the single writer, so reading it unlocked is fine
+    snprintf(etag, sizeof(etag), "\"%s-%lx-%llu\"", snap->etagPrefix, snapshotEpoch,
+             (unsigned long long)(snap->generation + 1));
+    MHD_add_response_header(response, "ETag", etag);
+    notModified = MHD_create_response_from_buffer(0, NULL, MHD_RESPMEM_PERSISTENT);
+    if (notModified) {
+        MHD_add_response_header(notModified, "ETag", etag);
+    }
+    if (contentEncodingEnabled()) {
+        MHD_add_response_header(response, "Vary", "Accept-Encoding");
+        if (notModified) {
+            MHD_add_response_header(notModified, "Vary", "Accept-Encoding");
+        }
+    }
+    
+    pthread_mutex_lock(&snap->lock);
+    old = snap->response;
+    oldNotModified = snap->notModified;
+    snap->response = response;
+    snap->notModified = notModified;
+    snap->published = snap->writing;
+    snap->publishedLength = length;
+    snap->writing = -1;
+    snap->generation++;
+    // Compressed variants of the old body; a compression still running
+    // notices the new generation and discards its own result
+    for (int i = 0; i < CONTENT_ENCODING_COUNT; i++) {
+        oldVariants[2 * i] = snap->variants[i].response;
+        oldVariants[2 * i + 1] = snap->variants[i].notModified;
+        snap->variants[i].response = NULL;
+        snap->variants[i].notModified = NULL;
+    }
+    pthread_mutex_unlock(&snap->lock);
+    
+    // Drops our reference; connections still sending it keep theirs
+    if (old) {
+        MHD_destroy_response(old);
+    }
+    if (oldNotModified) {
+        MHD_destroy_response(oldNotModified);
+    }
+    for (int i = 0; i < 2 * CONTENT_ENCODING_COUNT; i++) {
+        if (oldVariants[i]) {
+            MHD_destroy_response(oldVariants[i]);
+        }
+    }
+    return true;
+}
+
+void snapshotAbort(Snapshot *snap) {
+    snap->writing = -1;
+}
+
+// Called with snap->lock held
+static enum MHD_Result queueTagged(struct MHD_Connection *connection, struct MHD_Response *response,
+                                   struct MHD_Response *notModified, ContentEncoding encoding) {
+    const char *etag = MHD_get_response_header(response, "ETag");
+    
+    if (notModified && etag && httpEtagMatches(connection, etag)) {
+        return MHD_queue_response(connection, MHD_HTTP_NOT_MODIFIED, notModified);
+    }
+    if (encoding != CONTENT_ENCODING_IDENTITY) {
+        contentEncodingRecordServed(encoding);
+    }
+    return MHD_queue_response(connection, MHD_HTTP_OK, response);
+}
+
+// The compressed variant of the published body, made here if this
+// generation has none yet. The buffer is pinned instead of holding the
+// lock, so neither readers nor the writer wait for the compressor.
+// False leaves the request to the identity body.
+static bool queueVariant(Snapshot *snap, struct MHD_Connection *connection, ContentEncoding encoding,
+                         enum MHD_Result *ret) {
+    SnapshotVariant *variant = &snap->variants[encoding];
+    SnapshotBuffer *buffer;
+    struct MHD_Response *response = NULL;
+    struct MHD_Response *notModified = NULL;
+    struct MHD_Response *old = NULL;
+    struct MHD_Response *oldNotModified = NULL;
+    const char *identityTag;
+    char etag[96];
+    uint64_t generation;
+    size_t length;
+    void *compressed;
+    size_t compressedLength;
+    bool queued = false;
+    uint64_t started;
+    
+    pthread_mutex_lock(&snap->lock);
+    if (snap->response == NULL || snap->publishedLength < CONTENT_ENCODING_MIN_SIZE) {
+        pthread_mutex_unlock(&snap->lock);
+        return false;
+    }
+    if (variant->generation == snap->generation || variant->compressing) {
+        if (variant->generation == snap->generation && variant->response) {
+            *ret = queueTagged(connection, variant->response, variant->notModified, encoding);
+            queued = true;
+        }
+        pthread_mutex_unlock(&snap->lock);
+        return queued;
+    }
+    variant->compressing = true;
+    buffer = &snap->buffers[snap->published];
+    buffer->pins++;
+    generation = snap->generation;
+    length = snap->publishedLength;
+    // "<prefix>-<epoch>-<generation>" becomes "<prefix>-<epoch>-<generation>-<encoding>"
+    identityTag = MHD_get_response_header(snap->response, "ETag");
+    snprintf(etag, sizeof(etag), "%.*s-%s\"", identityTag ? (int)strlen(identityTag) - 1 : 0,
+             identityTag ? identityTag : "", contentEncodingName(encoding));
+    pthread_mutex_unlock(&snap->lock);
+    
+    started = monotonicNowNs();
+    if (contentEncodingCompress(encoding, buffer->data, length, &compressed, &compressedLength)) {
+        response = MHD_create_response_from_buffer_with_free_callback(compressedLength, compressed, &free);
+        if (response == NULL) {
+            free(compressed);
+        } else {
+            if (snap->contentType) {
+                MHD_add_response_header(response, "Content-Type", snap->contentType);
+            }
+            MHD_add_response_header(response, "Content-Encoding", contentEncodingName(encoding));
+            MHD_add_response_header(response, "Vary", "Accept-Encoding");
+            MHD_add_response_header(response, "ETag", etag);
+            notModified = MHD_create_response_from_buffer(0, NULL, MHD_RESPMEM_PERSISTENT);
+            if (notModified) {
+                MHD_add_response_header(notModified, "Vary", "Accept-Encoding");
+                MHD_add_response_header(notModified, "ETag", etag);
+            }
+        }
+    }
+    
+    spanTraceRecord(SPAN_SERIALIZE, contentEncodingName(encoding), started, monotonicNowNs());
+    
+    pthread_mutex_lock(&snap->lock);
+    buffer->pins--;
+    variant->compressing = false;
+    // A publish in the meantime made this variant stale; the next request redoes it
+    if (snap->generation == generation) {
+        old = variant->response;
+        oldNotModified = variant->notModified;
+        variant->response = response;
+        variant->notModified = notModified;
+        variant->generation = generation;
+        if (response) {
+            *ret = queueTagged(connection, response, notModified, encoding);
+            queued = true;
+        }
+        response = NULL;
+        notModified = NULL;
+    }
+    pthread_mutex_unlock(&snap->lock);
+    
+    if (old) {
+        MHD_destroy_response(old);
+    }
+    if (oldNotModified) {
+        MHD_destroy_response(oldNotModified);
+    }
+    if (response) {
+        MHD_destroy_response(response);
+    }
+    if (notModified) {
+        MHD_destroy_response(notModified);
+    }
+    return queued;
+}
+
+enum MHD_Result snapshotQueue(Snapshot *snap, struct MHD_Connection *connection) {
+    enum MHD_Result ret = MHD_NO;
+    ContentEncoding encoding = contentEncodingNegotiate(connection);
+    
+    if (encoding != CONTENT_ENCODING_IDENTITY && queueVariant(snap, connection, encoding, &ret)) {
+        return ret;
+    }
+    pthread_mutex_lock(&snap->lock);
+    if (snap->response) {
+        ret = queueTagged(connection, snap->response, snap->notModified, CONTENT_ENCODING_IDENTITY);
+    }
+    pthread_mutex_unlock(&snap->lock);
+    return ret;
+}
+
+bool snapshotReady(Snapshot *snap) {
+    bool ready;
+    
+    pthread_mutex_lock(&snap->lock);
+    ready = (snap->response != NULL);
+    pthread_mutex_unlock(&snap->lock);
+    return ready;
+}
+
+uint64_t snapshotGeneration(Snapshot *snap) {
+    uint64_t generation;
+    
+    pthread_mutex_lock(&snap->lock);
+    generation = snap->generation;
+    pthread_mutex_unlock(&snap->lock);
+    return generation;
+}
+
+// If-None-Match is a comma separated list of (possibly weak) tags or "*"
+bool httpEtagMatches(struct MHD_Connection *connection, const char *etag) {
+    const char *header = MHD_lookup_connection_value(connection, MHD_HEADER_KIND, "If-None-Match");
+    size_t etagLength = strlen(etag);
+    const char *p;
+    
+    if (header == NULL) {
+        return false;
+    }
+    
+    p = header;
+    while (*p) {
+        const char *start;
+        
+        while (*p == ' ' || *p == '\t' || *p == ',') {
+            p++;
+        }
+        if (*p == '*') {
+            return true;
+        }
+        if (strncmp(p, "W/", 2) == 0) {
+            p += 2;
+        }
+        start = p;
+        while (*p && *p != ',') {
+            p++;
+        }
+        // Trim trailing whitespace of this element
+        const char *end = p;
+        while (end > start && (end[-1] == ' ' || end[-1] == '\t')) {
+            end--;
+        }
+        if ((size_t)(end - start) == etagLength && strncmp(start, etag, etagLength) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,75 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <microhttpd.h>
+#include "content_encoding.h"
+
+#define SNAPSHOT_BUFFERS 2
+
+// One rendering target. A buffer is busy while MHD still holds a response
+// that points into it; it only becomes writable again once MHD releases it.
+typedef struct {
+    char *data;
+    size_t capacity;
+    bool busy;
+    uint32_t pins;                  // Requests compressing it; under the snapshot lock
+} SnapshotBuffer;
+
+// The published body in one Content-Encoding, made on the first request
+// that asks for it and kept until the next publish
+typedef struct {
+    struct MHD_Response *response;  // NULL if compressing did not pay off
+    struct MHD_Response *notModified;
+    uint64_t generation;            // Generation it was made from, 0 if none
+    bool compressing;
+} SnapshotVariant;
+
+// A pre-rendered HTTP body published to any number of readers.
+// A single writer renders into the idle buffer and publishes it as a shared
+// persistent MHD response; readers just queue that response, so serving a
+// snapshot costs no rendering and no allocation on the request path.
+typedef struct {
+    pthread_mutex_t lock;
+    SnapshotBuffer buffers[SNAPSHOT_BUFFERS];
+    int published;                  // Index of the published buffer, -1 if none
+    int writing;                    // Index handed out by snapshotBegin, -1 if none
+    struct MHD_Response *response;  // Shared response for the published buffer
+    struct MHD_Response *notModified; // Shared 304 carrying the same ETag
+    uint64_t generation;            // Bumped on every publish
+    size_t publishedLength;
+    SnapshotVariant variants[CONTENT_ENCODING_COUNT];
+    const char *contentType;
+    const char *etagPrefix;         // ETag is "<prefix>-<epoch>-<generation>"
+    uint64_t beganNs;               // Of the render in progress, for the trace
+} Snapshot;
+
+bool snapshotInit(Snapshot *snap, size_t capacity, const char *contentType, const char *etagPrefix);
+void snapshotDestroy(Snapshot *snap);
+
+// Writer side: get an idle buffer, render into it, then publish it.
+// snapshotBegin returns NULL when every buffer is still held by slow readers.
+// Every snapshotBegin that returned a buffer ends in snapshotPublish or
+// snapshotAbort; one that did not is discarded by the next snapshotBegin.
+char* snapshotBegin(Snapshot *snap, size_t *capacity);
+bool snapshotGrow(Snapshot *snap, size_t capacity);
+bool snapshotPublish(Snapshot *snap, size_t length);
+void snapshotAbort(Snapshot *snap);
+
+// Reader side: queue the published response on a connection, or a 304 when
+// the client's If-None-Match already names the current generation. A
+// client accepting a compressed encoding gets that variant, with its own
+// ETag; it is compressed once per generation, and requests arriving while
+// that runs get the identity body. Returns MHD_NO if nothing has been
+// published yet.
+enum MHD_Result snapshotQueue(Snapshot *snap, struct MHD_Connection *connection);
+bool snapshotReady(Snapshot *snap);
+uint64_t snapshotGeneration(Snapshot *snap);
+
+// True if the request's If-None-Match header lists the given entity tag
+bool httpEtagMatches(struct MHD_Connection *connection, const char *etag);
+
+#endif // SNAPSHOT_H
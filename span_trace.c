@@ -0,0 +1,392 @@
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "span_trace.h"
+#include "mem_pool.h"
+#include "metrics.h"
+#include "timeutil.h"
+
+#define SPAN_EVENT_MAX 512               // Longest rendering of one span, async pairs included
+
+#if (SPAN_RING_EVENTS & (SPAN_RING_EVENTS - 1)) != 0
+#error "SPAN_RING_EVENTS must be a power of two"
+#endif
+
+typedef struct {
+    uint64_t beginNs;
+    uint64_t endNs;
+    const char *name;
+    uint64_t request;                // 0 outside a request
+    int32_t tid;
+    uint8_t category;
+    bool async;
+} TraceEvent;
+
+// Written by the thread that claimed it only. head counts every span ever
+// recorded in the ring and is published after the span, so readers can
+// tell which slots were overwritten while they copied them.
+typedef struct {
+    TraceEvent events[SPAN_RING_EVENTS];
+    uint64_t head __attribute__((aligned(64)));
+    uint64_t recorded[SPAN_CATEGORY_COUNT];
+    int32_t tid;
+    char threadName[16];
+    bool claimed;
+} TraceRing;
+
+typedef enum {
+    SPAN_STAGE_HEADER,
+    SPAN_STAGE_EVENTS,
+    SPAN_STAGE_FOOTER,
+    SPAN_STAGE_DONE
+} TraceStage;
+
+typedef struct {
+    uint64_t cutoffNs;               // Spans ending before are left out
+    uint64_t endNs;                  // And those ending after the dump began
+    TraceStage stage;
+    int ring;
+    uint64_t next;                   // Next span of the ring
+    uint64_t end;                    // Ring head when the ring was reached
+    bool first;                      // No event written yet, so no comma
+    size_t length;
+    size_t sent;
+    char text[SPAN_HTTP_BLOCK];
+} TraceStream;
+
+static const char *categoryNames[SPAN_CATEGORY_COUNT] = {
+    [SPAN_HTTP]      = "http",
+    [SPAN_HW_QUEUE]  = "hw_queue",
+    [SPAN_HW]        = "hw",
+    [SPAN_SUSI]      = "susi",
+    [SPAN_SERIALIZE] = "serialize",
+};
+
+static TraceRing rings[SPAN_MAX_THREADS];
+static bool traceEnabled = true;
+static pthread_once_t keyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t ringKey;
+static uint64_t nextRequest = 0;
+
+static __thread TraceRing *threadRing;
+static __thread bool threadUntraced;   // No ring was free when it first recorded
+static __thread uint64_t threadRequest;
+
+static uint64_t threadsUntraced = 0;
+static uint64_t dumps = 0;
+static uint64_t spansDumped = 0;
+static uint64_t spansOverwritten = 0;    // Lost to the writer while a dump read them
+
+MEM_POOL_DEFINE(traceStreamPool, "trace_stream", sizeof(TraceStream), SPAN_STREAM_POOL);
+
+// Thread exit: the ring goes to the next thread, its spans stay readable
+static void releaseRing(void *arg) {
+    TraceRing *ring = arg;
+
+    __atomic_store_n(&ring->claimed, false, __ATOMIC_RELEASE);
+}
+
+static void createKey(void) {
+    pthread_key_create(&ringKey, releaseRing);
+}
+
+static TraceRing* claimRing(void) {
+    pthread_once(&keyOnce, createKey);
+    for (int i = 0; i < SPAN_MAX_THREADS; i++) {
+        bool expected = false;
+
+        if (__atomic_compare_exchange_n(&rings[i].claimed, &expected, true, false, __ATOMIC_ACQUIRE,
+                                        __ATOMIC_RELAXED)) {
+            TraceRing *ring = &rings[i];
+
+            ring->threadName[0] = '\0';
+            pthread_getname_np(pthread_self(), ring->threadName, sizeof(ring->threadName));
+            __atomic_store_n(&ring->tid, (int32_t)syscall(SYS_gettid), __ATOMIC_RELEASE);
+            pthread_setspecific(ringKey, ring);
+            threadRing = ring;
+            return ring;
+        }
+    }
+    threadUntraced = true;
+    __atomic_fetch_add(&threadsUntraced, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+static void record(SpanCategory category, const char *name, uint64_t beginNs, uint64_t endNs, uint64_t request,
+                   bool async) {
+    TraceRing *ring = threadRing;
+    TraceEvent *event;
+    uint64_t head;
+
+    if (!__atomic_load_n(&traceEnabled, __ATOMIC_RELAXED) || category >= SPAN_CATEGORY_COUNT) {
+        return;
+    }
+    if (ring == NULL && (threadUntraced || (ring = claimRing()) == NULL)) {
+        return;
+    }
+    head = ring->head;
+    event = &ring->events[head & (SPAN_RING_EVENTS - 1)];
+    // Like a seqlock writer: a reader that sees any of the new fields also
+    // sees a head that marks the slot's previous span as gone
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    event->beginNs = beginNs;
+    event->endNs = endNs;
+    event->name = name;
+    event->request = request;
+    event->tid = ring->tid;
+    event->category = (uint8_t)category;
+    event->async = async;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->recorded[category], ring->recorded[category] + 1, __ATOMIC_RELAXED);
+}
+
+void spanTraceSetEnabled(bool enabled) {
+    __atomic_store_n(&traceEnabled, enabled, __ATOMIC_RELAXED);
+}
+
+void spanTraceRecord(SpanCategory category, const char *name, uint64_t beginNs, uint64_t endNs) {
+    record(category, name, beginNs, endNs, threadRequest, false);
+}
+
+void spanTraceRecordAsync(SpanCategory category, const char *name, uint64_t beginNs, uint64_t endNs, uint64_t request) {
+    record(category, name, beginNs, endNs, request, true);
+}
+
+uint64_t spanTraceRequestBegin(void) {
+    threadRequest = __atomic_add_fetch(&nextRequest, 1, __ATOMIC_RELAXED);
+    return threadRequest;
+}
+
+void spanTraceRequestEnd(void) {
+    threadRequest = 0;
+}
+
+uint64_t spanTraceCurrentRequest(void) {
+    return threadRequest;
+}
+
+void spanTraceSetRequest(uint64_t request) {
+    threadRequest = request;
+}
+
+// Copy one span out of a ring being written; false once it was overwritten
+static bool readEvent(TraceRing *ring, uint64_t index, TraceEvent *event) {
+    *event = ring->events[index & (SPAN_RING_EVENTS - 1)];
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return index + SPAN_RING_EVENTS > __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+}
+
+static double micros(uint64_t ns) {
+    return (double)ns / 1000.0;
+}
+
+static void renderEvent(TraceStream *stream, StrBuf *out, int ringIndex, uint64_t index, const TraceEvent *event) {
+    const char *category = categoryNames[event->category];
+    const char *separator = stream->first ? "" : ",";
+    int pid = (int)getpid();
+
+    stream->first = false;
+    if (event->async) {
+        // Async slices pair on category, name and id; the id only has to be
+        // unique among spans in flight, the ring slot is
+        uint64_t id = ((uint64_t)ringIndex << 32) | (index & 0xffffffffull);
+
+        strbufAppendf(out,
+                      "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"b\",\"id\":\"0x%llx\",\"ts\":%.3f,"
+                      "\"pid\":%d,\"tid\":%d,\"args\":{\"request\":%llu}}",
+                      separator, event->name, category, (unsigned long long)id, micros(event->beginNs), pid,
+                      event->tid, (unsigned long long)event->request);
+        strbufAppendf(out,
+                      ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"e\",\"id\":\"0x%llx\",\"ts\":%.3f,"
+                      "\"pid\":%d,\"tid\":%d}",
+                      event->name, category, (unsigned long long)id, micros(event->endNs), pid, event->tid);
+        return;
+    }
+    strbufAppendf(out, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d",
+                  separator, event->name, category, micros(event->beginNs), micros(event->endNs - event->beginNs),
+                  pid, event->tid);
+    if (event->request != 0) {
+        strbufAppendf(out, ",\"args\":{\"request\":%llu}", (unsigned long long)event->request);
+    }
+    strbufAppendChar(out, '}');
+}
+
+// Move on to a ring: name its thread, then start from its oldest span
+static void enterRing(TraceStream *stream, StrBuf *out) {
+    TraceRing *ring = &rings[stream->ring];
+    int32_t tid = __atomic_load_n(&ring->tid, __ATOMIC_ACQUIRE);
+
+    stream->end = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    stream->next = stream->end > SPAN_RING_EVENTS ? stream->end - SPAN_RING_EVENTS : 0;
+    if (stream->next == stream->end || tid == 0) {
+        return;
+    }
+    strbufAppendf(out,
+                  "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                  stream->first ? "" : ",", (int)getpid(), tid, ring->threadName[0] ? ring->threadName : "thread");
+    stream->first = false;
+}
+
+// Fill the text buffer with the next spans, leaving room for the largest
+static void renderEvents(TraceStream *stream, StrBuf *out) {
+    while (stream->ring < SPAN_MAX_THREADS && out->length + SPAN_EVENT_MAX < out->capacity) {
+        TraceRing *ring = &rings[stream->ring];
+        TraceEvent event;
+
+        if (stream->next >= stream->end) {
+            if (++stream->ring < SPAN_MAX_THREADS) {
+                enterRing(stream, out);
+            }
+            continue;
+        }
+        if (!readEvent(ring, stream->next, &event)) {
+            uint64_t oldest = __atomic_load_n(&ring->head, __ATOMIC_RELAXED) - SPAN_RING_EVENTS + 1;
+
+            __atomic_fetch_add(&spansOverwritten, oldest - stream->next, __ATOMIC_RELAXED);
+            stream->next = oldest;
+            continue;
+        }
+        if (event.endNs >= stream->cutoffNs && event.endNs <= stream->endNs) {
+            renderEvent(stream, out, stream->ring, stream->next, &event);
+            __atomic_fetch_add(&spansDumped, 1, __ATOMIC_RELAXED);
+        }
+        stream->next++;
+    }
+    if (stream->ring >= SPAN_MAX_THREADS) {
+        stream->stage = SPAN_STAGE_FOOTER;
+    }
+}
+
+static ssize_t traceReader(void *cls, uint64_t pos, char *buf, size_t max) {
+    TraceStream *stream = cls;
+    size_t length;
+    (void)pos;
+
+    if (stream->sent == stream->length) {
+        StrBuf out;
+
+        strbufInit(&out, stream->text, sizeof(stream->text));
+        switch (stream->stage) {
+            case SPAN_STAGE_HEADER:
+                strbufAppendf(&out,
+                              "{\"displayTimeUnit\":\"ms\",\"traceEvents\":["
+                              "\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"watchdog_http\"}}",
+                              (int)getpid());
+                stream->first = false;
+                stream->stage = SPAN_STAGE_EVENTS;
+                enterRing(stream, &out);
+                break;
+            case SPAN_STAGE_EVENTS:
+                renderEvents(stream, &out);
+                break;
+            case SPAN_STAGE_FOOTER:
+                strbufAppend(&out, "\n]}\n");
+                stream->stage = SPAN_STAGE_DONE;
+                break;
+            case SPAN_STAGE_DONE:
+                return MHD_CONTENT_READER_END_OF_STREAM;
+        }
+        if (out.overflow) {
+            return MHD_CONTENT_READER_END_WITH_ERROR;
+        }
+        stream->length = out.length;
+        stream->sent = 0;
+    }
+    length = stream->length - stream->sent;
+    if (length > max) {
+        length = max;
+    }
+    memcpy(buf, stream->text + stream->sent, length);
+    stream->sent += length;
+    return (ssize_t)length;
+}
+
+static void traceReaderFree(void *cls) {
+    memPoolFree(&traceStreamPool, cls);
+}
+
+enum MHD_Result spanTraceQueueResponse(struct MHD_Connection *connection, const char *seconds, const char **error) {
+    unsigned long window = SPAN_DEFAULT_SECONDS;
+    struct MHD_Response *response;
+    TraceStream *stream;
+    enum MHD_Result ret;
+    uint64_t now;
+
+    *error = NULL;
+    if (!__atomic_load_n(&traceEnabled, __ATOMIC_RELAXED)) {
+        *error = "Tracing is off (see --trace)";
+        return MHD_NO;
+    }
+    if (seconds != NULL) {
+        char *end;
+
+        window = strtoul(seconds, &end, 10);
+        if (*seconds == '\0' || *end != '\0' || window == 0 || window > SPAN_MAX_SECONDS) {
+            *error = "Invalid seconds (expected 1-600)";
+            return MHD_NO;
+        }
+    }
+    stream = memPoolAlloc(&traceStreamPool, sizeof(TraceStream));
+    if (stream == NULL) {
+        *error = "Too many trace dumps in flight";
+        return MHD_NO;
+    }
+    // The text buffer is written before it is read
+    memset(stream, 0, offsetof(TraceStream, text));
+    now = monotonicNowNs();
+    stream->endNs = now;
+    stream->cutoffNs = now > window * 1000000000ull ? now - window * 1000000000ull : 0;
+    stream->first = true;
+
+    response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, SPAN_HTTP_BLOCK, traceReader, stream,
+                                                 traceReaderFree);
+    if (response == NULL) {
+        traceReaderFree(stream);
+        return MHD_NO;
+    }
+    MHD_add_response_header(response, "Content-Type", "application/json");
+    MHD_add_response_header(response, "Cache-Control", "no-cache");
+    __atomic_fetch_add(&dumps, 1, __ATOMIC_RELAXED);
+    ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
+    MHD_destroy_response(response);
+    return ret;
+}
+
+void spanTraceCollectMetrics(StrBuf *out, void *ctx) {
+    uint64_t recorded[SPAN_CATEGORY_COUNT] = { 0 };
+    int claimed = 0;
+    (void)ctx;
+
+    for (int i = 0; i < SPAN_MAX_THREADS; i++) {
+        claimed += __atomic_load_n(&rings[i].claimed, __ATOMIC_RELAXED) ? 1 : 0;
+        for (int category = 0; category < SPAN_CATEGORY_COUNT; category++) {
+            recorded[category] += __atomic_load_n(&rings[i].recorded[category], __ATOMIC_RELAXED);
+        }
+    }
+    metricsHeader(out, "watchdog_trace_enabled", "gauge", "Whether spans are being recorded");
+    strbufAppendf(out, "watchdog_trace_enabled %d\n", __atomic_load_n(&traceEnabled, __ATOMIC_RELAXED) ? 1 : 0);
+    metricsHeader(out, "watchdog_trace_spans_total", "counter", "Spans recorded by category");
+    for (int i = 0; i < SPAN_CATEGORY_COUNT; i++) {
+        strbufAppendf(out, "watchdog_trace_spans_total{category=\"%s\"} %llu\n", categoryNames[i],
+                      (unsigned long long)recorded[i]);
+    }
+    metricsHeader(out, "watchdog_trace_threads", "gauge", "Threads holding a span ring");
+    strbufAppendf(out, "watchdog_trace_threads %d\n", claimed);
+    metricsHeader(out, "watchdog_trace_threads_untraced_total", "counter",
+                  "Threads that found every span ring taken and record nothing");
+    strbufAppendf(out, "watchdog_trace_threads_untraced_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&threadsUntraced, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_trace_dumps_total", "counter", "Trace dumps served");
+    strbufAppendf(out, "watchdog_trace_dumps_total %llu\n", (unsigned long long)__atomic_load_n(&dumps, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_trace_spans_dumped_total", "counter", "Spans sent by trace dumps");
+    strbufAppendf(out, "watchdog_trace_spans_dumped_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&spansDumped, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_trace_spans_overwritten_total", "counter",
+                  "Spans overwritten while a dump was reading them");
+    strbufAppendf(out, "watchdog_trace_spans_overwritten_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&spansOverwritten, __ATOMIC_RELAXED));
+}
@@ -0,0 +1,68 @@
+#ifndef SPAN_TRACE_H
+#define SPAN_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <microhttpd.h>
+#include "build_profile.h"
+#include "strbuf.h"
+
+#ifndef SPAN_MAX_THREADS
+#define SPAN_MAX_THREADS 32              // Threads recording at once; more are not traced
+#endif
+#ifndef SPAN_RING_EVENTS
+#define SPAN_RING_EVENTS 2048            // Spans kept per thread, must be a power of two
+#endif
+#ifndef SPAN_STREAM_POOL
+#define SPAN_STREAM_POOL 2               // Dumps in flight
+#endif
+#define SPAN_HTTP_BLOCK 16384            // Response buffer for the streamed dump
+#define SPAN_DEFAULT_SECONDS 10
+#define SPAN_MAX_SECONDS 600
+
+// A flight recorder of spans for finding out why something is slow: each
+// thread appends finished spans to a ring of its own, so recording is a
+// clock read and a few stores with no lock and no shared cache line, and
+// the oldest spans are overwritten. Requests, the wait of each hardware
+// command in its lane and its run on the hardware thread, every SUSI call
+// and rendering a response body or snapshot are recorded. A request gets
+// an ID that the hardware commands it queues carry along, so the queue
+// wait, the run and the SUSI calls inside it are tagged with the request
+// that caused them. GET /api/trace?seconds=N streams the spans that
+// ended in the last N seconds as Chrome trace JSON (chrome://tracing,
+// Perfetto); the rings are read while they are written, and spans
+// overwritten during the dump are left out rather than sent torn.
+
+typedef enum {
+    SPAN_HTTP,                       // Request handler, per route
+    SPAN_HW_QUEUE,                   // Hardware command waiting in its lane
+    SPAN_HW,                         // Hardware command running
+    SPAN_SUSI,                       // SUSI driver call
+    SPAN_SERIALIZE,                  // Response body or snapshot rendered
+    SPAN_CATEGORY_COUNT
+} SpanCategory;
+
+// --trace on|off, before any thread records; on by default
+void spanTraceSetEnabled(bool enabled);
+
+// A span of the calling thread, tagged with its current request. The
+// name must be a string literal or otherwise outlive the process.
+void spanTraceRecord(SpanCategory category, const char *name, uint64_t beginNs, uint64_t endNs);
+// A span that began on another thread, such as a command's wait in its
+// lane; shown as an async slice tagged with the given request
+void spanTraceRecordAsync(SpanCategory category, const char *name, uint64_t beginNs, uint64_t endNs, uint64_t request);
+
+// Request IDs: the HTTP handler takes a new one around each request, the
+// hardware thread adopts the ID a command was queued under while it runs
+uint64_t spanTraceRequestBegin(void);
+void spanTraceRequestEnd(void);
+uint64_t spanTraceCurrentRequest(void);
+void spanTraceSetRequest(uint64_t request);
+
+// GET /api/trace?seconds=N. MHD_NO with *error set for a bad argument or
+// when tracing is off.
+enum MHD_Result spanTraceQueueResponse(struct MHD_Connection *connection, const char *seconds, const char **error);
+
+void spanTraceCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // SPAN_TRACE_H
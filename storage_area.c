@@ -0,0 +1,361 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "storage_area.h"
+#include "crc32c.h"
+#include "hw_actor.h"
+#include "mem_pool.h"
+#include "metrics.h"
+#include "susi_caps.h"
+#include "susi_timing.h"
+#include "timeutil.h"
+
+// Chunk buffers of the write streams and checksum reads
+MEM_POOL_DEFINE(chunkPool, "storage_chunk", STORAGE_CHUNK_MAX, STORAGE_CHUNK_POOL);
+
+// One chunk, run on the hardware thread
+typedef struct {
+    SusiId_t id;
+    StorageMode mode;
+    uint32_t offset;
+    uint8_t *data;
+    uint32_t length;
+    uint32_t blockSize;
+    uint8_t *current;                // Read-back scratch, length bytes
+    bool verify;
+    uint32_t crc;                    // crc32c of data, for verify
+    bool mismatch;
+    uint32_t blocksCompared;
+    uint32_t blocksChanged;
+    uint32_t bytesChanged;
+    SusiStatus_t status;
+} StorageChunk;
+
+static StorageAreaInfo areas[STORAGE_AREA_MAX];
+static int areaCount;
+
+static uint64_t bytesRead;
+static uint64_t bytesWritten;
+static uint64_t bytesUnchanged;
+static uint64_t bytesVerified;
+static uint64_t verifyMismatches;
+static uint64_t chunks;
+static uint64_t failures;
+static uint64_t busyNs;
+
+static void hwDiscover(void *arg) {
+    (void)arg;
+
+    areaCount = 0;
+    for (int i = 0; i < STORAGE_AREA_MAX; i++) {
+        StorageAreaInfo *area = &areas[areaCount];
+        SusiStatus_t status = susiCapsGet(SUSI_CAPS_STORAGE, (SusiId_t)i, SUSI_ID_STORAGE_TOTAL_SIZE, &area->totalSize);
+
+        if (status != SUSI_STATUS_SUCCESS || area->totalSize == 0) {
+            continue;
+        }
+        status = susiCapsGet(SUSI_CAPS_STORAGE, (SusiId_t)i, SUSI_ID_STORAGE_BLOCK_SIZE, &area->blockSize);
+        if (status != SUSI_STATUS_SUCCESS || area->blockSize == 0) {
+            area->blockSize = 1;
+        }
+        area->id = (SusiId_t)i;
+        area->chunkSize = area->blockSize >= STORAGE_CHUNK_TARGET ? area->blockSize
+                        : STORAGE_CHUNK_TARGET / area->blockSize * area->blockSize;
+        areaCount++;
+    }
+}
+
+bool storageAreaInit(void) {
+    if (!hwActorCall(HW_LANE_READ, hwDiscover, NULL)) {
+        return false;
+    }
+    for (int i = 0; i < areaCount; i++) {
+        printf("Storage %u: %u bytes, %u-byte blocks\n", areas[i].id, areas[i].totalSize, areas[i].blockSize);
+    }
+    return areaCount > 0;
+}
+
+int storageAreaCount(void) {
+    return areaCount;
+}
+
+const StorageAreaInfo* storageAreaAt(int index) {
+    return index >= 0 && index < areaCount ? &areas[index] : NULL;
+}
+
+const StorageAreaInfo* storageAreaFind(SusiId_t id) {
+    for (int i = 0; i < areaCount; i++) {
+        if (areas[i].id == id) {
+            return &areas[i];
+        }
+    }
+    return NULL;
+}
+
+static SusiStatus_t writeRun(StorageChunk *chunk, uint32_t from, uint32_t to) {
+    uint64_t start = monotonicNowNs();
+    SusiStatus_t status = SusiStorageAreaWrite(chunk->id, chunk->offset + from, chunk->data + from, to - from);
+
+    susiTimingRecord(SUSI_CALL_STORAGE_WRITE, start, status);
+    if (status == SUSI_STATUS_SUCCESS) {
+        chunk->bytesChanged += to - from;
+    }
+    return status;
+}
+
+// Read the chunk back and write the runs of blocks that differ, one call
+// per run. Blocks are aligned to the area, not to the chunk.
+static void writeChanged(StorageChunk *chunk) {
+    uint64_t start = monotonicNowNs();
+    uint32_t run = chunk->length;    // First differing block not yet written, length if none
+    uint32_t block, length;
+
+    chunk->status = SusiStorageAreaRead(chunk->id, chunk->offset, chunk->current, chunk->length);
+    susiTimingRecord(SUSI_CALL_STORAGE_READ, start, chunk->status);
+    for (block = 0; block < chunk->length && chunk->status == SUSI_STATUS_SUCCESS; block += length) {
+        length = chunk->blockSize - (chunk->offset + block) % chunk->blockSize;
+        if (length > chunk->length - block) {
+            length = chunk->length - block;
+        }
+        chunk->blocksCompared++;
+        if (memcmp(chunk->current + block, chunk->data + block, length) != 0) {
+            chunk->blocksChanged++;
+            if (run == chunk->length) {
+                run = block;
+            }
+        } else if (run < chunk->length) {
+            chunk->status = writeRun(chunk, run, block);
+            run = chunk->length;
+        }
+    }
+    if (run < chunk->length && chunk->status == SUSI_STATUS_SUCCESS) {
+        chunk->status = writeRun(chunk, run, chunk->length);
+    }
+}
+
+// Read the chunk back and compare checksums. A mismatch fails the chunk
+// with SUSI_STATUS_WRITE_ERROR.
+static void verifyChunk(StorageChunk *chunk) {
+    uint64_t start = monotonicNowNs();
+
+    chunk->status = SusiStorageAreaRead(chunk->id, chunk->offset, chunk->current, chunk->length);
+    susiTimingRecord(SUSI_CALL_STORAGE_READ, start, chunk->status);
+    if (chunk->status == SUSI_STATUS_SUCCESS && crc32c(0, chunk->current, chunk->length) != chunk->crc) {
+        chunk->mismatch = true;
+        chunk->status = SUSI_STATUS_WRITE_ERROR;
+    }
+}
+
+static void hwTransferChunk(void *arg) {
+    StorageChunk *chunk = (StorageChunk *)arg;
+    uint64_t start = monotonicNowNs();
+
+    switch (chunk->mode) {
+    case STORAGE_READ:
+        chunk->status = SusiStorageAreaRead(chunk->id, chunk->offset, chunk->data, chunk->length);
+        susiTimingRecord(SUSI_CALL_STORAGE_READ, start, chunk->status);
+        break;
+    case STORAGE_WRITE:
+        chunk->status = SusiStorageAreaWrite(chunk->id, chunk->offset, chunk->data, chunk->length);
+        susiTimingRecord(SUSI_CALL_STORAGE_WRITE, start, chunk->status);
+        chunk->bytesChanged = chunk->status == SUSI_STATUS_SUCCESS ? chunk->length : 0;
+        break;
+    case STORAGE_WRITE_CHANGED:
+        writeChanged(chunk);
+        break;
+    }
+    // Nothing to check when the chunk already matched
+    if (chunk->verify && chunk->status == SUSI_STATUS_SUCCESS && chunk->bytesChanged > 0) {
+        verifyChunk(chunk);
+    }
+    __atomic_fetch_add(&busyNs, monotonicNowNs() - start, __ATOMIC_RELAXED);
+}
+
+static bool transferChunk(StorageStream *stream, uint8_t *data, uint32_t length) {
+    StorageChunk chunk;
+
+    memset(&chunk, 0, sizeof(chunk));
+    chunk.id = stream->area->id;
+    chunk.mode = stream->mode;
+    chunk.offset = stream->offset;
+    chunk.data = data;
+    chunk.length = length;
+    chunk.blockSize = stream->area->blockSize;
+    chunk.current = stream->current;
+    chunk.verify = stream->verify;
+    if (chunk.verify) {
+        chunk.crc = crc32c(0, data, length);
+    }
+    if (!hwActorCall(HW_LANE_USER, hwTransferChunk, &chunk)) {
+        chunk.status = SUSI_STATUS_LOCKFAIL;
+    }
+    __atomic_fetch_add(&chunks, 1, __ATOMIC_RELAXED);
+    if (stream->mode != STORAGE_READ) {
+        __atomic_fetch_add(&bytesWritten, (uint64_t)chunk.bytesChanged, __ATOMIC_RELAXED);
+    }
+    stream->blocksCompared += chunk.blocksCompared;
+    stream->blocksChanged += chunk.blocksChanged;
+    if (chunk.verify && (chunk.status == SUSI_STATUS_SUCCESS || chunk.mismatch)) {
+        __atomic_fetch_add(&bytesVerified, (uint64_t)length, __ATOMIC_RELAXED);
+    }
+    if (chunk.mismatch) {
+        __atomic_fetch_add(&verifyMismatches, 1, __ATOMIC_RELAXED);
+    }
+    if (chunk.status != SUSI_STATUS_SUCCESS) {
+        stream->status = chunk.status;
+        __atomic_fetch_add(&failures, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    stream->offset += length;
+    stream->crc = crc32c(stream->crc, data, length);
+    if (stream->mode == STORAGE_READ) {
+        __atomic_fetch_add(&bytesRead, (uint64_t)length, __ATOMIC_RELAXED);
+    } else {
+        __atomic_fetch_add(&bytesUnchanged, (uint64_t)(length - chunk.bytesChanged), __ATOMIC_RELAXED);
+    }
+    return true;
+}
+
+// Bytes from the stream's offset to the next chunk boundary of the area,
+// clipped to the end of the range
+static uint32_t chunkLength(const StorageStream *stream) {
+    uint32_t chunkSize = stream->area->chunkSize;
+    uint32_t length = chunkSize - stream->offset % chunkSize;
+
+    return length < stream->end - stream->offset ? length : stream->end - stream->offset;
+}
+
+void* storageChunkAlloc(const StorageAreaInfo *area) {
+    return memPoolAlloc(&chunkPool, area->chunkSize);
+}
+
+void storageChunkFree(void *chunk) {
+    memPoolFree(&chunkPool, chunk);
+}
+
+bool storageStreamOpen(StorageStream *stream, SusiId_t id, uint32_t offset, uint32_t length, StorageMode mode,
+                       bool verify) {
+    memset(stream, 0, sizeof(*stream));
+    stream->area = storageAreaFind(id);
+    if (stream->area == NULL) {
+        stream->status = SUSI_STATUS_UNSUPPORTED;
+        return false;
+    }
+    if (offset >= stream->area->totalSize || length > stream->area->totalSize - offset) {
+        stream->status = SUSI_STATUS_INVALID_PARAMETER;
+        return false;
+    }
+    if (mode != STORAGE_READ) {
+        stream->pending = storageChunkAlloc(stream->area);
+        stream->current = mode == STORAGE_WRITE_CHANGED || verify ? storageChunkAlloc(stream->area) : NULL;
+        if (stream->pending == NULL || ((mode == STORAGE_WRITE_CHANGED || verify) && stream->current == NULL)) {
+            storageStreamClose(stream);
+            stream->status = SUSI_STATUS_ALLOC_ERROR;
+            return false;
+        }
+    }
+    stream->mode = mode;
+    stream->verify = verify && mode != STORAGE_READ;
+    stream->start = offset;
+    stream->offset = offset;
+    stream->end = length ? offset + length : stream->area->totalSize;
+    stream->startedNs = monotonicNowNs();
+    stream->status = SUSI_STATUS_SUCCESS;
+    return true;
+}
+
+uint32_t storageStreamRead(StorageStream *stream, uint8_t *data, uint32_t capacity) {
+    uint32_t length;
+
+    if (stream->mode != STORAGE_READ || stream->status != SUSI_STATUS_SUCCESS || stream->offset >= stream->end) {
+        return 0;
+    }
+    length = chunkLength(stream);
+    if (length > capacity) {
+        length = capacity;
+    }
+    return transferChunk(stream, data, length) ? length : 0;
+}
+
+bool storageStreamWrite(StorageStream *stream, const uint8_t *data, uint32_t length) {
+    if (stream->mode == STORAGE_READ || stream->status != SUSI_STATUS_SUCCESS) {
+        return false;
+    }
+    if (length > stream->end - stream->offset - stream->pendingLength) {
+        stream->status = SUSI_STATUS_INVALID_PARAMETER;
+        return false;
+    }
+    while (length > 0) {
+        uint32_t wanted = chunkLength(stream) - stream->pendingLength;
+        uint32_t take = length < wanted ? length : wanted;
+
+        memcpy(stream->pending + stream->pendingLength, data, take);
+        stream->pendingLength += take;
+        data += take;
+        length -= take;
+        if (stream->pendingLength == chunkLength(stream)) {
+            if (!transferChunk(stream, stream->pending, stream->pendingLength)) {
+                return false;
+            }
+            stream->pendingLength = 0;
+        }
+    }
+    return true;
+}
+
+bool storageStreamFinish(StorageStream *stream) {
+    if (stream->mode != STORAGE_READ && stream->status == SUSI_STATUS_SUCCESS && stream->pendingLength > 0) {
+        if (transferChunk(stream, stream->pending, stream->pendingLength)) {
+            stream->pendingLength = 0;
+        }
+    }
+    return stream->status == SUSI_STATUS_SUCCESS;
+}
+
+void storageStreamClose(StorageStream *stream) {
+    storageChunkFree(stream->pending);
+    storageChunkFree(stream->current);
+    stream->pending = NULL;
+    stream->current = NULL;
+}
+
+void storageStreamProgress(const StorageStream *stream, StorageProgress *progress) {
+    progress->bytes = stream->offset - stream->start;
+    progress->total = stream->end - stream->start;
+    progress->elapsedNs = monotonicNowNs() - stream->startedNs;
+    progress->bytesPerSecond = progress->elapsedNs ? (double)progress->bytes * 1e9 / (double)progress->elapsedNs : 0;
+}
+
+void storageAreaCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (areaCount == 0) {
+        return;
+    }
+    metricsHeader(out, "watchdog_storage_bytes_total", "counter", "Bytes moved by storage area transfers");
+    strbufAppendf(out, "watchdog_storage_bytes_total{direction=\"read\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&bytesRead, __ATOMIC_RELAXED));
+    strbufAppendf(out, "watchdog_storage_bytes_total{direction=\"write\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&bytesWritten, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_storage_unchanged_bytes_total", "counter",
+                  "Bytes of changed-only writes that already matched and were not written");
+    strbufAppendf(out, "watchdog_storage_unchanged_bytes_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&bytesUnchanged, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_storage_verified_bytes_total", "counter", "Written bytes read back and checked by CRC32C");
+    strbufAppendf(out, "watchdog_storage_verified_bytes_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&bytesVerified, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_storage_verify_mismatches_total", "counter", "Chunks whose read-back CRC32C differed");
+    strbufAppendf(out, "watchdog_storage_verify_mismatches_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&verifyMismatches, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_crc32c_info", "gauge", "CRC32C implementation in use");
+    strbufAppendf(out, "watchdog_crc32c_info{implementation=\"%s\"} 1\n", crc32cImplementation());
+    metricsHeader(out, "watchdog_storage_chunks_total", "counter", "Storage chunks transferred, one hardware command each");
+    strbufAppendf(out, "watchdog_storage_chunks_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&chunks, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_storage_failures_total", "counter", "Storage chunks that failed");
+    strbufAppendf(out, "watchdog_storage_failures_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&failures, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_storage_busy_seconds_total", "counter", "Time the hardware thread spent in storage transfers");
+    strbufAppendf(out, "watchdog_storage_busy_seconds_total %.6f\n",
+                  (double)__atomic_load_n(&busyNs, __ATOMIC_RELAXED) / 1e9);
+}
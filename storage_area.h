@@ -0,0 +1,89 @@
+#ifndef STORAGE_AREA_H
+#define STORAGE_AREA_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "Susi4.h"
+#include "strbuf.h"
+
+#define STORAGE_AREA_MAX SUSI_ID_STORAGE_MAX
+#define STORAGE_CHUNK_TARGET 1024        // Bytes per hardware command, rounded down to whole blocks
+#define STORAGE_HTTP_BLOCK 4096          // Response buffer for streamed reads
+
+// Streaming access to the SUSI storage areas. A transfer of any length is
+// split into chunks that start and end on the area's block boundaries
+// (except where the requested range itself does not), one user-lane
+// hardware command each, so a large dump neither needs a buffer of its
+// size nor holds the hardware thread for longer than one chunk.
+// STORAGE_WRITE_CHANGED compares each chunk with the area first, in the
+// same hardware command, and writes only the runs of blocks that differ;
+// pushing an image that mostly matches costs reads instead of wear.
+// With verify, every chunk that was written is read back in the same
+// command and its CRC32C compared with the data's; a mismatch fails the
+// stream with SUSI_STATUS_WRITE_ERROR.
+
+typedef struct {
+    SusiId_t id;
+    uint32_t totalSize;
+    uint32_t blockSize;              // 1 when the driver does not report one
+    uint32_t chunkSize;              // Whole blocks, close to STORAGE_CHUNK_TARGET
+} StorageAreaInfo;
+
+typedef enum {
+    STORAGE_READ,
+    STORAGE_WRITE,
+    STORAGE_WRITE_CHANGED            // Read back each chunk, write only the blocks that differ
+} StorageMode;
+
+typedef struct {
+    const StorageAreaInfo *area;
+    StorageMode mode;
+    uint32_t start;
+    uint32_t offset;                 // Next byte to transfer
+    uint32_t end;                    // Exclusive
+    uint64_t startedNs;
+    SusiStatus_t status;             // First failure, SUCCESS until then
+    uint8_t *pending;                // Writes: bytes of the current chunk not yet written
+    uint32_t pendingLength;
+    bool verify;                     // Writes: read each chunk back and compare CRC32C
+    uint32_t crc;                    // CRC32C of the bytes transferred so far
+    uint8_t *current;                // STORAGE_WRITE_CHANGED: the chunk as read back,
+    uint32_t blocksCompared;         // how many blocks were compared
+    uint32_t blocksChanged;          // and how many of them were written
+} StorageStream;
+
+typedef struct {
+    uint64_t bytes;                  // Transferred so far
+    uint64_t total;
+    uint64_t elapsedNs;
+    double bytesPerSecond;
+} StorageProgress;
+
+// Find the areas through the hardware thread; false if there are none
+bool storageAreaInit(void);
+int storageAreaCount(void);
+const StorageAreaInfo* storageAreaAt(int index);
+const StorageAreaInfo* storageAreaFind(SusiId_t id);
+
+// Start a transfer of length bytes at offset; length 0 means up to the end
+// of the area. False (with stream->status set) for an unknown area or a
+// range outside it. Writes are queued with storageStreamWrite.
+bool storageStreamOpen(StorageStream *stream, SusiId_t id, uint32_t offset, uint32_t length, StorageMode mode,
+                       bool verify);
+// Read the next chunk, at most capacity bytes. Returns the bytes read, 0
+// at the end of the range or after a failure (see stream->status).
+uint32_t storageStreamRead(StorageStream *stream, uint8_t *data, uint32_t capacity);
+// Queue bytes for writing; whole chunks are written as they fill up. False
+// once a write failed or the data runs past the end of the range.
+bool storageStreamWrite(StorageStream *stream, const uint8_t *data, uint32_t length);
+// Write what is left of the last chunk; true if everything was written
+bool storageStreamFinish(StorageStream *stream);
+void storageStreamClose(StorageStream *stream);
+// One chunk's worth of buffer for area, NULL when none is left
+void* storageChunkAlloc(const StorageAreaInfo *area);
+void storageChunkFree(void *chunk);
+void storageStreamProgress(const StorageStream *stream, StorageProgress *progress);
+
+void storageAreaCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // STORAGE_AREA_H
@@ -0,0 +1,449 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "storage_kv.h"
+#include "build_profile.h"
+#include "crc32c.h"
+#include "hw_actor.h"
+#include "metrics.h"
+#include "storage_area.h"
+#include "susi_timing.h"
+#include "timeutil.h"
+
+#define HEADER_BYTES 12                  // magic, generation, crc32c of both
+#define RECORD_OVERHEAD 7                // keyLength, valueLength, flags, crc32c
+#define RECORD_MAX (RECORD_OVERHEAD + STORAGE_KV_KEY_MAX + STORAGE_KV_VALUE_MAX)
+#define COMPACT_WRITE_BYTES 256          // Per hardware command while compacting
+#define FLAG_DELETE 0x01
+
+typedef struct {
+    char key[STORAGE_KV_KEY_MAX + 1];
+    uint8_t value[STORAGE_KV_VALUE_MAX];
+    uint32_t valueLength;
+} KvEntry;
+
+// One write, run on the hardware thread
+typedef struct {
+    SusiId_t id;
+    uint32_t offset;
+    const uint8_t *data;
+    uint32_t length;
+    SusiStatus_t status;
+} KvWrite;
+
+// entries is read by any thread under indexLock; updates are serialised
+// by writeLock, which also owns the log position
+static pthread_mutex_t indexLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t writeLock = PTHREAD_MUTEX_INITIALIZER;
+static KvEntry entries[STORAGE_KV_MAX_KEYS];
+static int entryCount;
+static KvEntry scratch[STORAGE_KV_MAX_KEYS];   // Compaction's copy of the map, under writeLock
+
+static bool enabled;
+static SusiId_t areaId;
+static uint32_t segmentOffset[2];
+static uint32_t segmentBytes;
+static int active;
+static uint32_t generation;
+static uint32_t appendOffset;                  // Within the active segment
+
+#ifdef WATCHDOG_NO_HEAP
+// The image read at startup (both segments) stays as compaction's buffer
+static uint8_t *compactImage;
+#endif
+
+static uint64_t appends;
+static uint64_t appendBytes;
+static uint64_t compactions;
+static uint64_t failures;
+
+// Done with the startup image
+static void keepImage(uint8_t *image) {
+#ifdef WATCHDOG_NO_HEAP
+    compactImage = image;
+#else
+    free(image);
+#endif
+}
+
+// A segment-sized buffer for compact(), under writeLock
+static uint8_t* segmentImage(void) {
+#ifdef WATCHDOG_NO_HEAP
+    return compactImage;
+#else
+    return malloc(segmentBytes);
+#endif
+}
+
+static void segmentImageDone(uint8_t *image) {
+#ifdef WATCHDOG_NO_HEAP
+    (void)image;
+#else
+    free(image);
+#endif
+}
+
+static void put32(uint8_t *out, uint32_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+static uint32_t get32(const uint8_t *in) {
+    return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+static bool validKey(const char *key, size_t length) {
+    if (length == 0 || length > STORAGE_KV_KEY_MAX) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        char c = key[i];
+
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+              c == '_' || c == '.' || c == '-')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void encodeHeader(uint8_t *out, uint32_t gen) {
+    put32(out, STORAGE_KV_MAGIC);
+    put32(out + 4, gen);
+    put32(out + 8, crc32c(0, out, 8));
+}
+
+static bool decodeHeader(const uint8_t *in, uint32_t *gen) {
+    if (get32(in) != STORAGE_KV_MAGIC || get32(in + 8) != crc32c(0, in, 8)) {
+        return false;
+    }
+    *gen = get32(in + 4);
+    return true;
+}
+
+static uint32_t recordCrc(uint32_t gen, const uint8_t *record, uint32_t length) {
+    uint8_t genBytes[4];
+
+    put32(genBytes, gen);
+    return crc32c(crc32c(0, genBytes, 4), record, length);
+}
+
+// Returns the record's size
+static uint32_t encodeRecord(uint8_t *out, uint32_t gen, const char *key, const uint8_t *value,
+                             uint32_t valueLength, uint8_t flags) {
+    uint32_t keyLength = (uint32_t)strlen(key);
+    uint32_t body = 3 + keyLength + valueLength;
+
+    out[0] = (uint8_t)keyLength;
+    out[1] = (uint8_t)valueLength;
+    out[2] = flags;
+    memcpy(out + 3, key, keyLength);
+    if (valueLength > 0) {
+        memcpy(out + 3 + keyLength, value, valueLength);
+    }
+    put32(out + body, recordCrc(gen, out, body));
+    return body + 4;
+}
+
+static int findEntry(const KvEntry *table, int count, const char *key) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(table[i].key, key) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Apply one update to a table; false if a new key does not fit
+static bool applyUpdate(KvEntry *table, int *count, const char *key, const uint8_t *value, uint32_t valueLength,
+                        uint8_t flags) {
+    int index = findEntry(table, *count, key);
+
+    if (flags & FLAG_DELETE) {
+        if (index >= 0) {
+            memmove(&table[index], &table[index + 1], (size_t)(*count - index - 1) * sizeof(*table));
+            (*count)--;
+        }
+        return true;
+    }
+    if (index < 0) {
+        if (*count == STORAGE_KV_MAX_KEYS) {
+            return false;
+        }
+        index = (*count)++;
+        strcpy(table[index].key, key);
+    }
+    memcpy(table[index].value, value, valueLength);
+    table[index].valueLength = valueLength;
+    return true;
+}
+
+// Replay the records of a segment into entries; returns the offset after
+// the last valid record
+static uint32_t replaySegment(const uint8_t *segment, uint32_t gen) {
+    uint32_t pos = HEADER_BYTES;
+
+    while (pos + RECORD_OVERHEAD <= segmentBytes) {
+        uint32_t keyLength = segment[pos];
+        uint32_t valueLength = segment[pos + 1];
+        uint32_t body = 3 + keyLength + valueLength;
+        char key[STORAGE_KV_KEY_MAX + 1];
+
+        if (keyLength == 0 || keyLength > STORAGE_KV_KEY_MAX || valueLength > STORAGE_KV_VALUE_MAX ||
+            pos + body + 4 > segmentBytes || get32(segment + pos + body) != recordCrc(gen, segment + pos, body) ||
+            !validKey((const char *)segment + pos + 3, keyLength)) {
+            break;
+        }
+        memcpy(key, segment + pos + 3, keyLength);
+        key[keyLength] = '\0';
+        if (!applyUpdate(entries, &entryCount, key, segment + pos + 3 + keyLength, valueLength, segment[pos + 2])) {
+            break;
+        }
+        pos += body + 4;
+    }
+    return pos;
+}
+
+static void hwWrite(void *arg) {
+    KvWrite *write = (KvWrite *)arg;
+    uint64_t start = monotonicNowNs();
+
+    write->status = SusiStorageAreaWrite(write->id, write->offset, (uint8_t *)write->data, write->length);
+    susiTimingRecord(SUSI_CALL_STORAGE_WRITE, start, write->status);
+}
+
+static SusiStatus_t writeBytes(uint32_t offset, const uint8_t *data, uint32_t length) {
+    KvWrite write;
+
+    write.id = areaId;
+    write.offset = offset;
+    write.data = data;
+    write.length = length;
+    if (!hwActorCall(HW_LANE_USER, hwWrite, &write)) {
+        return SUSI_STATUS_LOCKFAIL;
+    }
+    return write.status;
+}
+
+bool storageKvInit(SusiId_t id, uint32_t offset, uint32_t length) {
+    const StorageAreaInfo *area = storageAreaFind(id);
+    StorageStream stream;
+    uint8_t *image, header[HEADER_BYTES];
+    uint32_t gen[2], got = 0, n;
+    bool valid[2];
+
+    if (area == NULL || length / 2 < HEADER_BYTES + 2 * RECORD_MAX || offset >= area->totalSize ||
+        length > area->totalSize - offset) {
+        return false;
+    }
+    image = malloc(length);
+    if (image == NULL) {
+        return false;
+    }
+    if (!storageStreamOpen(&stream, id, offset, length, STORAGE_READ, false)) {
+        free(image);
+        return false;
+    }
+    while ((n = storageStreamRead(&stream, image + got, length - got)) > 0) {
+        got += n;
+    }
+    storageStreamClose(&stream);
+    if (got != length) {
+        free(image);
+        return false;
+    }
+
+    areaId = id;
+    entryCount = 0;
+    segmentBytes = length / 2;
+    segmentOffset[0] = offset;
+    segmentOffset[1] = offset + segmentBytes;
+    for (int i = 0; i < 2; i++) {
+        valid[i] = decodeHeader(image + (size_t)i * segmentBytes, &gen[i]);
+    }
+    if (valid[0] || valid[1]) {
+        // Generations only move forward; compare them modulo 2^32
+        active = !valid[0] || (valid[1] && (int32_t)(gen[1] - gen[0]) > 0);
+        generation = gen[active];
+        appendOffset = replaySegment(image + (size_t)active * segmentBytes, generation);
+        keepImage(image);
+    } else {
+        keepImage(image);
+        active = 0;
+        generation = 1;
+        encodeHeader(header, generation);
+        if (writeBytes(segmentOffset[0], header, HEADER_BYTES) != SUSI_STATUS_SUCCESS) {
+            printf("Storage key-value store: cannot format storage %u (write protected?)\n", id);
+            return false;
+        }
+        appendOffset = HEADER_BYTES;
+    }
+    printf("Storage key-value store: %d keys, segment %d, generation %u, %u of %u bytes used\n",
+           entryCount, active, generation, appendOffset, segmentBytes);
+    enabled = true;
+    return true;
+}
+
+bool storageKvEnabled(void) {
+    return enabled;
+}
+
+bool storageKvGet(const char *key, uint8_t *value, uint32_t *length) {
+    int index;
+
+    pthread_mutex_lock(&indexLock);
+    index = findEntry(entries, entryCount, key);
+    if (index >= 0) {
+        memcpy(value, entries[index].value, entries[index].valueLength);
+        *length = entries[index].valueLength;
+    }
+    pthread_mutex_unlock(&indexLock);
+    return index >= 0;
+}
+
+// Rewrite the live map, with the update applied, into the other segment.
+// Records go first and the header last, so a crash part way leaves the
+// current segment in charge. Called with writeLock held.
+static SusiStatus_t compact(const char *key, const uint8_t *value, uint32_t valueLength, uint8_t flags) {
+    int target = !active, count = entryCount;
+    uint32_t gen = generation + 1, used = HEADER_BYTES;
+    SusiStatus_t status = SUSI_STATUS_SUCCESS;
+    uint8_t *image;
+
+    memcpy(scratch, entries, sizeof(entries));
+    if (!applyUpdate(scratch, &count, key, value, valueLength, flags)) {
+        return SUSI_STATUS_MORE_DATA;
+    }
+    image = segmentImage();
+    if (image == NULL) {
+        return SUSI_STATUS_ALLOC_ERROR;
+    }
+    for (int i = 0; i < count; i++) {
+        if (used + RECORD_OVERHEAD + strlen(scratch[i].key) + scratch[i].valueLength > segmentBytes) {
+            segmentImageDone(image);
+            return SUSI_STATUS_MORE_DATA;
+        }
+        used += encodeRecord(image + used, gen, scratch[i].key, scratch[i].value, scratch[i].valueLength, 0);
+    }
+
+    for (uint32_t pos = HEADER_BYTES; pos < used && status == SUSI_STATUS_SUCCESS; pos += COMPACT_WRITE_BYTES) {
+        uint32_t length = used - pos < COMPACT_WRITE_BYTES ? used - pos : COMPACT_WRITE_BYTES;
+
+        status = writeBytes(segmentOffset[target] + pos, image + pos, length);
+    }
+    if (status == SUSI_STATUS_SUCCESS) {
+        encodeHeader(image, gen);
+        status = writeBytes(segmentOffset[target], image, HEADER_BYTES);
+    }
+    segmentImageDone(image);
+    if (status != SUSI_STATUS_SUCCESS) {
+        return status;
+    }
+
+    pthread_mutex_lock(&indexLock);
+    memcpy(entries, scratch, sizeof(entries));
+    entryCount = count;
+    pthread_mutex_unlock(&indexLock);
+    active = target;
+    generation = gen;
+    appendOffset = used;
+    __atomic_fetch_add(&compactions, 1, __ATOMIC_RELAXED);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t update(const char *key, const uint8_t *value, uint32_t valueLength, uint8_t flags) {
+    uint8_t record[RECORD_MAX];
+    uint32_t size;
+    SusiStatus_t status;
+    bool fits;
+
+    if (!enabled) {
+        return SUSI_STATUS_NOT_INITIALIZED;
+    }
+    if (!validKey(key, strlen(key)) || valueLength > STORAGE_KV_VALUE_MAX) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&writeLock);
+    pthread_mutex_lock(&indexLock);
+    fits = findEntry(entries, entryCount, key) >= 0 || entryCount < STORAGE_KV_MAX_KEYS;
+    if ((flags & FLAG_DELETE) && findEntry(entries, entryCount, key) < 0) {
+        pthread_mutex_unlock(&indexLock);
+        pthread_mutex_unlock(&writeLock);
+        return SUSI_STATUS_NOT_FOUND;
+    }
+    pthread_mutex_unlock(&indexLock);
+
+    size = encodeRecord(record, generation, key, value, valueLength, flags);
+    if (!fits && !(flags & FLAG_DELETE)) {
+        status = SUSI_STATUS_MORE_DATA;
+    } else if (appendOffset + size > segmentBytes) {
+        status = compact(key, value, valueLength, flags);
+    } else {
+        status = writeBytes(segmentOffset[active] + appendOffset, record, size);
+        if (status == SUSI_STATUS_SUCCESS) {
+            appendOffset += size;
+            pthread_mutex_lock(&indexLock);
+            applyUpdate(entries, &entryCount, key, value, valueLength, flags);
+            pthread_mutex_unlock(&indexLock);
+            __atomic_fetch_add(&appends, 1, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&appendBytes, (uint64_t)size, __ATOMIC_RELAXED);
+        }
+    }
+    pthread_mutex_unlock(&writeLock);
+    if (status != SUSI_STATUS_SUCCESS) {
+        __atomic_fetch_add(&failures, 1, __ATOMIC_RELAXED);
+    }
+    return status;
+}
+
+SusiStatus_t storageKvSet(const char *key, const uint8_t *value, uint32_t length) {
+    return update(key, value, length, 0);
+}
+
+SusiStatus_t storageKvDelete(const char *key) {
+    return update(key, NULL, 0, FLAG_DELETE);
+}
+
+int storageKvForEach(StorageKvVisitor visit, void *ctx) {
+    int count;
+
+    pthread_mutex_lock(&indexLock);
+    count = entryCount;
+    for (int i = 0; i < entryCount; i++) {
+        visit(entries[i].key, entries[i].value, entries[i].valueLength, ctx);
+    }
+    pthread_mutex_unlock(&indexLock);
+    return count;
+}
+
+void storageKvCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (!enabled) {
+        return;
+    }
+    pthread_mutex_lock(&indexLock);
+    metricsHeader(out, "watchdog_kv_keys", "gauge", "Keys in the storage key-value store");
+    strbufAppendf(out, "watchdog_kv_keys %d\n", entryCount);
+    pthread_mutex_unlock(&indexLock);
+    metricsHeader(out, "watchdog_kv_segment_used_bytes", "gauge", "Bytes of the active log segment in use");
+    strbufAppendf(out, "watchdog_kv_segment_used_bytes %u\n", __atomic_load_n(&appendOffset, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_kv_segment_bytes", "gauge", "Size of each of the two log segments");
+    strbufAppendf(out, "watchdog_kv_segment_bytes %u\n", segmentBytes);
+    metricsHeader(out, "watchdog_kv_appends_total", "counter", "Records appended to the log");
+    strbufAppendf(out, "watchdog_kv_appends_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&appends, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_kv_append_bytes_total", "counter", "Bytes written by appends");
+    strbufAppendf(out, "watchdog_kv_append_bytes_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&appendBytes, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_kv_compactions_total", "counter", "Live maps rewritten into the other segment");
+    strbufAppendf(out, "watchdog_kv_compactions_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&compactions, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_kv_failures_total", "counter", "Updates that were not stored");
+    strbufAppendf(out, "watchdog_kv_failures_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&failures, __ATOMIC_RELAXED));
+}
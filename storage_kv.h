@@ -0,0 +1,54 @@
+#ifndef STORAGE_KV_H
+#define STORAGE_KV_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "Susi4.h"
+#include "strbuf.h"
+
+#define STORAGE_KV_MAGIC 0x31564b41u      // "AKV1"
+#define STORAGE_KV_MAX_KEYS 64
+#define STORAGE_KV_KEY_MAX 31
+#define STORAGE_KV_VALUE_MAX 64
+
+// Small persistent state (boot counters, last reset reason, calibration)
+// kept as an append-only log in a region of a SUSI storage area. The
+// region is split into two segments; one is active at a time and starts
+// with a header carrying a generation number. Every update appends one
+// record:
+//
+//   keyLength(1) valueLength(1) flags(1) key value crc32c(4)
+//
+// The CRC also covers the segment's generation, so records left over
+// from an older use of the segment never validate. Loading stops at the
+// first record that does not check out, which is also where a torn write
+// ends. When the active segment is full, the live keys are written to the
+// other segment and its header last, with the next generation; until
+// that header is in place the old segment still wins.
+//
+// The whole map is loaded into memory once at startup. Reads never touch
+// the hardware, and an update costs one write of a few bytes.
+
+// Use length bytes from offset of storage area id; at least two records
+// per segment must fit. Needs storageAreaInit first. False if the region
+// is outside the area or cannot be read.
+bool storageKvInit(SusiId_t id, uint32_t offset, uint32_t length);
+bool storageKvEnabled(void);
+
+// Copy the value of key; false if it is not set. *length is the value size.
+bool storageKvGet(const char *key, uint8_t *value, uint32_t *length);
+// Set or, for storageKvDelete, remove a key. Keys are 1 to 31 characters
+// of [A-Za-z0-9_.-], values up to 64 bytes. Returns the SUSI status of the
+// write, SUSI_STATUS_INVALID_PARAMETER for a bad key or value and
+// SUSI_STATUS_MORE_DATA when the live map no longer fits one segment;
+// deleting a key that is not set is SUSI_STATUS_NOT_FOUND.
+SusiStatus_t storageKvSet(const char *key, const uint8_t *value, uint32_t length);
+SusiStatus_t storageKvDelete(const char *key);
+
+// Visit every key in insertion order under the index lock; keep it short
+typedef void (*StorageKvVisitor)(const char *key, const uint8_t *value, uint32_t length, void *ctx);
+int storageKvForEach(StorageKvVisitor visit, void *ctx);
+
+void storageKvCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // STORAGE_KV_H
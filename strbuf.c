@@ -0,0 +1,63 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include "strbuf.h"
+
+void strbufInit(StrBuf *buf, char *data, size_t capacity) {
+    buf->data = data;
+    buf->capacity = capacity;
+    strbufReset(buf);
+}
+
+void strbufReset(StrBuf *buf) {
+    buf->length = 0;
+    buf->overflow = false;
+    if (buf->capacity > 0) {
+        buf->data[0] = '\0';
+    }
+}
+
+void strbufAppendN(StrBuf *buf, const char *text, size_t length) {
+    if (buf->overflow) {
+        return;
+    }
+    // Always keep room for the terminating NUL
+    if (buf->length + length >= buf->capacity) {
+        buf->overflow = true;
+        return;
+    }
+    memcpy(buf->data + buf->length, text, length);
+    buf->length += length;
+    buf->data[buf->length] = '\0';
+}
+
+void strbufAppend(StrBuf *buf, const char *text) {
+    strbufAppendN(buf, text, strlen(text));
+}
+
+void strbufAppendChar(StrBuf *buf, char c) {
+    strbufAppendN(buf, &c, 1);
+}
+
+void strbufAppendf(StrBuf *buf, const char *format, ...) {
+    va_list args;
+    int written;
+    size_t space;
+    
+    if (buf->overflow) {
+        return;
+    }
+    
+    space = buf->capacity - buf->length;
+    va_start(args, format);
+    written = vsnprintf(buf->data + buf->length, space, format, args);
+    va_end(args);
+    
+    if (written < 0 || (size_t)written >= space) {
+        // Roll back the truncated output
+        buf->data[buf->length] = '\0';
+        buf->overflow = true;
+        return;
+    }
+    buf->length += (size_t)written;
+}
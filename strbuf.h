@@ -0,0 +1,24 @@
+#ifndef STRBUF_H
+#define STRBUF_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Append-only text buffer over caller-owned memory.
+// Appends never allocate; once the buffer is full further output is dropped
+// and the overflow flag is set so the caller can retry with a larger buffer.
+typedef struct {
+    char *data;
+    size_t capacity;
+    size_t length;
+    bool overflow;
+} StrBuf;
+
+void strbufInit(StrBuf *buf, char *data, size_t capacity);
+void strbufReset(StrBuf *buf);
+void strbufAppend(StrBuf *buf, const char *text);
+void strbufAppendN(StrBuf *buf, const char *text, size_t length);
+void strbufAppendChar(StrBuf *buf, char c);
+void strbufAppendf(StrBuf *buf, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+#endif // STRBUF_H
@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "susi_breaker.h"
+#include "metrics.h"
+#include "timeutil.h"
+
+typedef enum {
+    BREAKER_CLOSED,
+    BREAKER_OPEN,               // Refusing calls until retryAtNs
+    BREAKER_PROBING,            // One call let through, outcome pending
+} BreakerState;
+
+typedef struct {
+    uint32_t id;
+    uint8_t call;
+    uint8_t state;
+    bool used;                  // Key is set; slots are never emptied, so probe chains hold
+    bool hasValue;
+    uint32_t failures;          // Consecutive transient failures
+    uint32_t backoffMs;
+    uint64_t retryAtNs;
+    SusiStatus_t lastStatus;    // Of the last failure
+    uint64_t sampledMs;         // Wall clock of the last good value
+    size_t valueSize;
+    unsigned char value[SUSI_BREAKER_VALUE_MAX];
+} BreakerEntry;
+
+static pthread_mutex_t breakerLock = PTHREAD_MUTEX_INITIALIZER;
+static BreakerEntry entries[SUSI_BREAKER_SLOTS];
+static uint32_t threshold = SUSI_BREAKER_DEFAULT_THRESHOLD;
+static uint32_t initialBackoffMs = SUSI_BREAKER_DEFAULT_BACKOFF_MS;
+
+static uint64_t trips = 0;
+static uint64_t rejected = 0;           // Calls answered without the driver
+static uint64_t probesOk = 0;
+static uint64_t probesFailed = 0;
+static uint64_t untracked = 0;          // Failures of keys the full table could not take
+
+bool susiBreakerConfigure(uint32_t failures, uint32_t backoffMs) {
+    if (failures > 0 && (backoffMs == 0 || backoffMs > SUSI_BREAKER_MAX_BACKOFF_MS)) {
+        return false;
+    }
+    threshold = failures;
+    initialBackoffMs = backoffMs;
+    return true;
+}
+
+static uint64_t wallNowMs(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000ull + (uint64_t)now.tv_nsec / 1000000ull;
+}
+
+// Failures that say nothing about the item itself and may pass
+static bool isTransient(SusiStatus_t status) {
+    return status == SUSI_STATUS_TIMEOUT || status == SUSI_STATUS_DRIVER_TIMEOUT ||
+           status == SUSI_STATUS_NORESPONSE || status == SUSI_STATUS_DEVICE_ERROR ||
+           status == SUSI_STATUS_READ_ERROR || status == SUSI_STATUS_WRITE_ERROR ||
+           status == SUSI_STATUS_LOCKFAIL || status == SUSI_STATUS_ERROR;
+}
+
+static uint32_t hashKey(SusiCall call, uint32_t id) {
+    uint32_t h = ((uint32_t)call * 0x85EBCA6Bu) ^ (id * 0x9E3779B1u);
+    return (h ^ (h >> 15)) & (SUSI_BREAKER_SLOTS - 1);
+}
+
+// Slot holding the key, else the free slot it would take (create) or NULL.
+// Called with breakerLock held.
+static BreakerEntry* findEntry(SusiCall call, uint32_t id, bool create) {
+    uint32_t slot = hashKey(call, id);
+
+    for (uint32_t probes = 0; probes < SUSI_BREAKER_SLOTS; probes++) {
+        BreakerEntry *entry = &entries[slot];
+
+        if (entry->used && entry->call == call && entry->id == id) {
+            return entry;
+        }
+        if (!entry->used) {
+            if (!create) {
+                return NULL;
+            }
+            memset(entry, 0, sizeof(*entry));
+            entry->used = true;
+            entry->call = (uint8_t)call;
+            entry->id = id;
+            return entry;
+        }
+        slot = (slot + 1) & (SUSI_BREAKER_SLOTS - 1);
+    }
+    return NULL;
+}
+
+bool susiBreakerAllow(SusiCall call, uint32_t id) {
+    BreakerEntry *entry;
+    bool allow = true;
+
+    if (threshold == 0) {
+        return true;
+    }
+    pthread_mutex_lock(&breakerLock);
+    entry = findEntry(call, id, false);
+    if (entry != NULL && entry->state != BREAKER_CLOSED) {
+        if (entry->state == BREAKER_OPEN && monotonicNowNs() >= entry->retryAtNs) {
+            entry->state = BREAKER_PROBING;
+        } else {
+            allow = false;
+            rejected++;
+        }
+    }
+    pthread_mutex_unlock(&breakerLock);
+    return allow;
+}
+
+void susiBreakerRecord(SusiCall call, uint32_t id, SusiStatus_t status, const void *value, size_t size) {
+    BreakerEntry *entry;
+    bool transient = isTransient(status);
+
+    if (threshold == 0) {
+        return;
+    }
+    pthread_mutex_lock(&breakerLock);
+    // Keys that never failed only need a slot to keep a value in
+    entry = findEntry(call, id, transient || (status == SUSI_STATUS_SUCCESS && value != NULL));
+    if (entry == NULL) {
+        if (transient) {
+            untracked++;
+        }
+        pthread_mutex_unlock(&breakerLock);
+        return;
+    }
+    if (!transient) {
+        if (entry->state == BREAKER_PROBING) {
+            probesOk++;
+            printf("SUSI: %s(0x%x) answers again\n", susiTimingCallName(call), id);
+        }
+        entry->state = BREAKER_CLOSED;
+        entry->failures = 0;
+        entry->backoffMs = 0;
+        if (status == SUSI_STATUS_SUCCESS && value != NULL && size <= sizeof(entry->value)) {
+            memcpy(entry->value, value, size);
+            entry->valueSize = size;
+            entry->hasValue = true;
+            entry->sampledMs = wallNowMs();
+        }
+        pthread_mutex_unlock(&breakerLock);
+        return;
+    }
+
+    entry->lastStatus = status;
+    entry->failures++;
+    if (entry->state == BREAKER_PROBING) {
+        probesFailed++;
+        entry->backoffMs = entry->backoffMs * 2 > SUSI_BREAKER_MAX_BACKOFF_MS ? SUSI_BREAKER_MAX_BACKOFF_MS
+                                                                            : entry->backoffMs * 2;
+        entry->state = BREAKER_OPEN;
+        entry->retryAtNs = monotonicNowNs() + entry->backoffMs * 1000000ull;
+    } else if (entry->state == BREAKER_CLOSED && entry->failures >= threshold) {
+        trips++;
+        entry->backoffMs = initialBackoffMs;
+        entry->state = BREAKER_OPEN;
+        entry->retryAtNs = monotonicNowNs() + entry->backoffMs * 1000000ull;
+        printf("SUSI: %s(0x%x) failed %u times (0x%08x), %s for %u ms\n", susiTimingCallName(call), id,
+               entry->failures, (unsigned)status, entry->hasValue ? "serving its last good value" : "refusing calls",
+               entry->backoffMs);
+    }
+    pthread_mutex_unlock(&breakerLock);
+}
+
+SusiStatus_t susiBreakerLastGood(SusiCall call, uint32_t id, void *value, size_t size, uint64_t *sampledMs) {
+    BreakerEntry *entry;
+    SusiStatus_t status = SUSI_STATUS_ERROR;
+
+    pthread_mutex_lock(&breakerLock);
+    entry = findEntry(call, id, false);
+    if (entry != NULL) {
+        if (entry->hasValue && entry->valueSize == size) {
+            memcpy(value, entry->value, size);
+            if (sampledMs != NULL) {
+                *sampledMs = entry->sampledMs;
+            }
+            status = SUSI_STATUS_SUCCESS;
+        } else {
+            status = entry->lastStatus;
+        }
+    }
+    pthread_mutex_unlock(&breakerLock);
+    return status;
+}
+
+bool susiBreakerIsOpen(SusiCall call, uint32_t id) {
+    BreakerEntry *entry;
+    bool open;
+
+    pthread_mutex_lock(&breakerLock);
+    entry = findEntry(call, id, false);
+    open = entry != NULL && entry->state != BREAKER_CLOSED;
+    pthread_mutex_unlock(&breakerLock);
+    return open;
+}
+
+SusiStatus_t susiBreakerBoardGetValue(SusiId_t id, uint32_t *value, bool *stale) {
+    uint64_t start;
+    SusiStatus_t status;
+
+    *stale = false;
+    if (!susiBreakerAllow(SUSI_CALL_BOARD_GET_VALUE, id)) {
+        status = susiBreakerLastGood(SUSI_CALL_BOARD_GET_VALUE, id, value, sizeof(*value), NULL);
+        *stale = status == SUSI_STATUS_SUCCESS;
+        return status;
+    }
+    start = monotonicNowNs();
+    status = SusiBoardGetValue(id, value);
+    susiTimingRecord(SUSI_CALL_BOARD_GET_VALUE, start, status);
+    susiBreakerRecord(SUSI_CALL_BOARD_GET_VALUE, id, status, value, sizeof(*value));
+    return status;
+}
+
+void susiBreakerCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (threshold == 0) {
+        return;
+    }
+    pthread_mutex_lock(&breakerLock);
+    metricsHeader(out, "watchdog_susi_breaker_open", "gauge", "SUSI calls whose breaker is open, by function and ID");
+    for (uint32_t i = 0; i < SUSI_BREAKER_SLOTS; i++) {
+        if (entries[i].used && entries[i].state != BREAKER_CLOSED) {
+            strbufAppendf(out, "watchdog_susi_breaker_open{function=\"%s\",id=\"0x%x\"} 1\n",
+                          susiTimingCallName((SusiCall)entries[i].call), entries[i].id);
+        }
+    }
+    metricsHeader(out, "watchdog_susi_breaker_trips_total", "counter", "Times a SUSI call breaker opened");
+    strbufAppendf(out, "watchdog_susi_breaker_trips_total %llu\n", (unsigned long long)trips);
+    metricsHeader(out, "watchdog_susi_breaker_rejected_total", "counter",
+                  "SUSI calls answered from the last good value (or refused) while their breaker was open");
+    strbufAppendf(out, "watchdog_susi_breaker_rejected_total %llu\n", (unsigned long long)rejected);
+    metricsHeader(out, "watchdog_susi_breaker_probes_total", "counter", "Calls let through an open breaker, by outcome");
+    strbufAppendf(out, "watchdog_susi_breaker_probes_total{result=\"ok\"} %llu\n", (unsigned long long)probesOk);
+    strbufAppendf(out, "watchdog_susi_breaker_probes_total{result=\"failed\"} %llu\n", (unsigned long long)probesFailed);
+    metricsHeader(out, "watchdog_susi_breaker_untracked_total", "counter", "Failures of calls the full breaker table could not follow");
+    strbufAppendf(out, "watchdog_susi_breaker_untracked_total %llu\n", (unsigned long long)untracked);
+    pthread_mutex_unlock(&breakerLock);
+}
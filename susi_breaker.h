@@ -0,0 +1,50 @@
+#ifndef SUSI_BREAKER_H
+#define SUSI_BREAKER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "Susi4.h"
+#include "strbuf.h"
+#include "susi_timing.h"
+
+#define SUSI_BREAKER_SLOTS 256                // Must be a power of two
+#define SUSI_BREAKER_VALUE_MAX 16             // Bytes of last good value kept per key
+#define SUSI_BREAKER_DEFAULT_THRESHOLD 3
+#define SUSI_BREAKER_DEFAULT_BACKOFF_MS 1000
+#define SUSI_BREAKER_MAX_BACKOFF_MS 60000
+
+// Per-(call, ID) circuit breakers for the hardware thread. Every SUSI call
+// runs there one after another, so a sensor that answers SUSI_STATUS_TIMEOUT
+// after the driver's full timeout holds up every request queued behind it.
+// After threshold consecutive transient failures (timeouts, no response,
+// device, read or write errors) the key's breaker opens: callers get the
+// last good value at once, marked stale, or the failure status when there
+// never was one. Once the backoff has passed one call is let through as a
+// probe; success closes the breaker, failure doubles the backoff up to
+// SUSI_BREAKER_MAX_BACKOFF_MS. Definite answers (unsupported, not found,
+// invalid parameter) are not failures.
+//
+// All functions are safe from any thread; the driver calls themselves are
+// the caller's business and belong on the hardware thread.
+
+// Before use; a threshold of 0 turns the breakers off
+bool susiBreakerConfigure(uint32_t threshold, uint32_t backoffMs);
+
+// True when the call should go to the driver now (closed, or due a probe).
+// Every allowed call must be followed by susiBreakerRecord().
+bool susiBreakerAllow(SusiCall call, uint32_t id);
+// Outcome of an allowed call; value (size bytes, may be NULL) is kept on success
+void susiBreakerRecord(SusiCall call, uint32_t id, SusiStatus_t status, const void *value, size_t size);
+// While a call is refused: the last good value and its CLOCK_REALTIME
+// milliseconds, or the status that opened the breaker when there is none
+SusiStatus_t susiBreakerLastGood(SusiCall call, uint32_t id, void *value, size_t size, uint64_t *sampledMs);
+bool susiBreakerIsOpen(SusiCall call, uint32_t id);
+
+// SusiBoardGetValue through a breaker, timed. *stale is set when *value is
+// the last good value of an open breaker rather than a fresh reading.
+SusiStatus_t susiBreakerBoardGetValue(SusiId_t id, uint32_t *value, bool *stale);
+
+void susiBreakerCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // SUSI_BREAKER_H
@@ -0,0 +1,158 @@
+#ifndef SUSI_CALLS_H
+#define SUSI_CALLS_H
+
+// Every entry point of Susi4.h, for the code that stands in front of or in
+// place of the driver (libsusi_trace.so, the mock's replay):
+//
+//   X(name, (parameters), (arguments), (inputs), (outputs))
+//
+// inputs lists what the driver reads from the arguments and outputs what it
+// writes back, as REC_IN_* / REC_OUT_* elements (see susi_record.h).
+// Storage passwords are not part of the inputs, only their length.
+#define SUSI_CALLS(X) \
+    X(SusiLibInitialize, (void), (), \
+      (), ()) \
+    X(SusiLibUninitialize, (void), (), \
+      (), ()) \
+    X(SusiBoardGetValue, (SusiId_t Id, uint32_t *pValue), (Id, pValue), \
+      (REC_IN_U32(Id)), (REC_OUT_P32(pValue))) \
+    X(SusiBoardSetValue, (SusiId_t Id, uint32_t pValue), (Id, pValue), \
+      (REC_IN_U32(Id) REC_IN_U32(pValue)), ()) \
+    X(SusiBoardGetStringA, (SusiId_t Id, char *pBuffer, uint32_t *pBufLen), (Id, pBuffer, pBufLen), \
+      (REC_IN_U32(Id) REC_IN_P32(pBufLen)), (REC_OUT_STR(pBuffer, pBufLen != NULL ? *pBufLen : 0) REC_OUT_P32(pBufLen))) \
+    X(SusiBoardReadIO, (uint16_t Port, uint32_t *pValue, uint32_t Length), (Port, pValue, Length), \
+      (REC_IN_U16(Port) REC_IN_U32(Length)), (REC_OUT_P32(pValue))) \
+    X(SusiBoardWriteIO, (uint16_t Port, uint32_t Value, uint32_t Length), (Port, Value, Length), \
+      (REC_IN_U16(Port) REC_IN_U32(Value) REC_IN_U32(Length)), ()) \
+    X(SusiBoardSetPWRCycle, (uint32_t Delaytime, uint8_t Eventype), (Delaytime, Eventype), \
+      (REC_IN_U32(Delaytime) REC_IN_U8(Eventype)), ()) \
+    X(SusiBoardGetPWRCycle, (uint32_t *Delaytime, uint8_t *Eventype), (Delaytime, Eventype), \
+      (), (REC_OUT_P32(Delaytime) REC_OUT_P8(Eventype))) \
+    X(SusiBoardReadPCI, (uint8_t Bus, uint8_t Device, uint8_t Function, uint32_t Offset, uint8_t *pData, uint32_t Length), (Bus, Device, Function, Offset, pData, Length), \
+      (REC_IN_U8(Bus) REC_IN_U8(Device) REC_IN_U8(Function) REC_IN_U32(Offset) REC_IN_U32(Length)), (REC_OUT_BYTES(pData, Length))) \
+    X(SusiBoardWritePCI, (uint8_t Bus, uint8_t Device, uint8_t Function, uint32_t Offset, uint8_t *pData, uint32_t Length), (Bus, Device, Function, Offset, pData, Length), \
+      (REC_IN_U8(Bus) REC_IN_U8(Device) REC_IN_U8(Function) REC_IN_U32(Offset) REC_IN_BYTES(pData, Length)), ()) \
+    X(SusiBoardReadMemory, (uint32_t Address, uint8_t *pData, uint32_t Length), (Address, pData, Length), \
+      (REC_IN_U32(Address) REC_IN_U32(Length)), (REC_OUT_BYTES(pData, Length))) \
+    X(SusiBoardWriteMemory, (uint32_t Address, uint8_t *pData, uint32_t Length), (Address, pData, Length), \
+      (REC_IN_U32(Address) REC_IN_BYTES(pData, Length)), ()) \
+    X(SusiBoardReadMSR, (uint32_t index, uint32_t *EAX_reg, uint32_t *EDX_reg), (index, EAX_reg, EDX_reg), \
+      (REC_IN_U32(index)), (REC_OUT_P32(EAX_reg) REC_OUT_P32(EDX_reg))) \
+    X(SusiBoardWriteMSR, (uint32_t index, uint32_t EAX_reg, uint32_t EDX_reg), (index, EAX_reg, EDX_reg), \
+      (REC_IN_U32(index) REC_IN_U32(EAX_reg) REC_IN_U32(EDX_reg)), ()) \
+    X(SusiSMBReadByte, (SusiId_t Id, uint8_t Addr, uint8_t Cmd, uint8_t *pBuffer), (Id, Addr, Cmd, pBuffer), \
+      (REC_IN_U32(Id) REC_IN_U8(Addr) REC_IN_U8(Cmd)), (REC_OUT_P8(pBuffer))) \
+    X(SusiSMBWriteByte, (SusiId_t Id, uint8_t Addr, uint8_t Cmd, uint8_t Data), (Id, Addr, Cmd, Data), \
+      (REC_IN_U32(Id) REC_IN_U8(Addr) REC_IN_U8(Cmd) REC_IN_U8(Data)), ()) \
+    X(SusiSMBReadWord, (SusiId_t Id, uint8_t Addr, uint8_t Cmd, uint16_t *pBuffer), (Id, Addr, Cmd, pBuffer), \
+      (REC_IN_U32(Id) REC_IN_U8(Addr) REC_IN_U8(Cmd)), (REC_OUT_P16(pBuffer))) \
+    X(SusiSMBWriteWord, (SusiId_t Id, uint8_t Addr, uint8_t Cmd, uint16_t Data), (Id, Addr, Cmd, Data), \
+      (REC_IN_U32(Id) REC_IN_U8(Addr) REC_IN_U8(Cmd) REC_IN_U16(Data)), ()) \
+    X(SusiSMBReceiveByte, (SusiId_t Id, uint8_t Addr, uint8_t *pData), (Id, Addr, pData), \
+      (REC_IN_U32(Id) REC_IN_U8(Addr)), (REC_OUT_P8(pData))) \
+    X(SusiSMBSendByte, (SusiId_t Id, uint8_t Addr, uint8_t Data), (Id, Addr, Data), \
+      (REC_IN_U32(Id) REC_IN_U8(Addr) REC_IN_U8(Data)), ()) \
+    X(SusiSMBReadQuick, (SusiId_t Id, uint8_t Addr), (Id, Addr), \
+      (REC_IN_U32(Id) REC_IN_U8(Addr)), ()) \
+    X(SusiSMBWriteQuick, (SusiId_t Id, uint8_t Addr), (Id, Addr), \
+      (REC_IN_U32(Id) REC_IN_U8(Addr)), ()) \
+    X(SusiSMBReadBlock, (SusiId_t Id, uint8_t Addr, uint8_t Cmd, uint8_t *pBuffer, uint32_t *pLength), (Id, Addr, Cmd, pBuffer, pLength), \
+      (REC_IN_U32(Id) REC_IN_U8(Addr) REC_IN_U8(Cmd) REC_IN_P32(pLength)), (REC_OUT_BYTES(pBuffer, pLength != NULL ? *pLength : 0) REC_OUT_P32(pLength))) \
+    X(SusiSMBWriteBlock, (SusiId_t Id, uint8_t Addr, uint8_t Cmd, uint8_t *pBuffer, uint32_t Length), (Id, Addr, Cmd, pBuffer, Length), \
+      (REC_IN_U32(Id) REC_IN_U8(Addr) REC_IN_U8(Cmd) REC_IN_BYTES(pBuffer, Length)), ()) \
+    X(SusiSMBI2CReadBlock, (SusiId_t Id, uint8_t Addr, uint8_t Cmd, uint8_t *pBuffer, uint32_t Length), (Id, Addr, Cmd, pBuffer, Length), \
+      (REC_IN_U32(Id) REC_IN_U8(Addr) REC_IN_U8(Cmd) REC_IN_U32(Length)), (REC_OUT_BYTES(pBuffer, Length))) \
+    X(SusiSMBI2CWriteBlock, (SusiId_t Id, uint8_t Addr, uint8_t Cmd, uint8_t *pBuffer, uint32_t Length), (Id, Addr, Cmd, pBuffer, Length), \
+      (REC_IN_U32(Id) REC_IN_U8(Addr) REC_IN_U8(Cmd) REC_IN_BYTES(pBuffer, Length)), ()) \
+    X(SusiI2CWriteReadCombine, (SusiId_t Id, uint8_t Addr, uint8_t *pWBuffer, uint32_t WriteLen, uint8_t *pRBuffer, uint32_t ReadLen), (Id, Addr, pWBuffer, WriteLen, pRBuffer, ReadLen), \
+      (REC_IN_U32(Id) REC_IN_U8(Addr) REC_IN_BYTES(pWBuffer, WriteLen) REC_IN_U32(ReadLen)), (REC_OUT_BYTES(pRBuffer, ReadLen))) \
+    X(SusiI2CReadTransfer, (SusiId_t Id, uint32_t Addr, uint32_t Cmd, uint8_t *pBuffer, uint32_t ReadLen), (Id, Addr, Cmd, pBuffer, ReadLen), \
+      (REC_IN_U32(Id) REC_IN_U32(Addr) REC_IN_U32(Cmd) REC_IN_U32(ReadLen)), (REC_OUT_BYTES(pBuffer, ReadLen))) \
+    X(SusiI2CWriteTransfer, (SusiId_t Id, uint32_t Addr, uint32_t Cmd, uint8_t *pBuffer, uint32_t ByteCnt), (Id, Addr, Cmd, pBuffer, ByteCnt), \
+      (REC_IN_U32(Id) REC_IN_U32(Addr) REC_IN_U32(Cmd) REC_IN_BYTES(pBuffer, ByteCnt)), ()) \
+    X(SusiI2CProbeDevice, (SusiId_t Id, uint32_t Addr), (Id, Addr), \
+      (REC_IN_U32(Id) REC_IN_U32(Addr)), ()) \
+    X(SusiI2CGetFrequency, (SusiId_t Id, uint32_t *pFreq), (Id, pFreq), \
+      (REC_IN_U32(Id)), (REC_OUT_P32(pFreq))) \
+    X(SusiI2CSetFrequency, (SusiId_t Id, uint32_t Freq), (Id, Freq), \
+      (REC_IN_U32(Id) REC_IN_U32(Freq)), ()) \
+    X(SusiI2CGetCaps, (SusiId_t Id, uint32_t ItemId, uint32_t *pValue), (Id, ItemId, pValue), \
+      (REC_IN_U32(Id) REC_IN_U32(ItemId)), (REC_OUT_P32(pValue))) \
+    X(SusiGPIOGetCaps, (SusiId_t Id, uint32_t ItemId, uint32_t *pValue), (Id, ItemId, pValue), \
+      (REC_IN_U32(Id) REC_IN_U32(ItemId)), (REC_OUT_P32(pValue))) \
+    X(SusiGPIOGetDirection, (SusiId_t Id, uint32_t Bitmask, uint32_t *pDirection), (Id, Bitmask, pDirection), \
+      (REC_IN_U32(Id) REC_IN_U32(Bitmask)), (REC_OUT_P32(pDirection))) \
+    X(SusiGPIOSetDirection, (SusiId_t Id, uint32_t Bitmask, uint32_t Direction), (Id, Bitmask, Direction), \
+      (REC_IN_U32(Id) REC_IN_U32(Bitmask) REC_IN_U32(Direction)), ()) \
+    X(SusiGPIOGetLevel, (SusiId_t Id, uint32_t Bitmask, uint32_t *pLevel), (Id, Bitmask, pLevel), \
+      (REC_IN_U32(Id) REC_IN_U32(Bitmask)), (REC_OUT_P32(pLevel))) \
+    X(SusiGPIOSetLevel, (SusiId_t Id, uint32_t Bitmask, uint32_t Level), (Id, Bitmask, Level), \
+      (REC_IN_U32(Id) REC_IN_U32(Bitmask) REC_IN_U32(Level)), ()) \
+    X(SusiGPIOIntGetEdge, (SusiId_t Id, uint32_t Bitmask, uint32_t *pEdge), (Id, Bitmask, pEdge), \
+      (REC_IN_U32(Id) REC_IN_U32(Bitmask)), (REC_OUT_P32(pEdge))) \
+    X(SusiGPIOIntSetEdge, (SusiId_t Id, uint32_t Bitmask, uint32_t edge), (Id, Bitmask, edge), \
+      (REC_IN_U32(Id) REC_IN_U32(Bitmask) REC_IN_U32(edge)), ()) \
+    X(SusiGPIOIntGetPin, (SusiId_t Id, uint32_t Bitmask, uint32_t *pPin), (Id, Bitmask, pPin), \
+      (REC_IN_U32(Id) REC_IN_U32(Bitmask)), (REC_OUT_P32(pPin))) \
+    X(SusiGPIOIntSetPin, (SusiId_t Id, uint32_t Bitmask, uint32_t pin), (Id, Bitmask, pin), \
+      (REC_IN_U32(Id) REC_IN_U32(Bitmask) REC_IN_U32(pin)), ()) \
+    X(SusiGPIOIntRegister, (SUSI_INT_CALLBACK pfnCallback), (pfnCallback), \
+      (REC_IN_U8(pfnCallback != NULL)), ()) \
+    X(SusiGPIOIntUnRegister, (void), (), \
+      (), ()) \
+    X(SusiVgaGetBacklightEnable, (SusiId_t Id, uint32_t *pEnable), (Id, pEnable), \
+      (REC_IN_U32(Id)), (REC_OUT_P32(pEnable))) \
+    X(SusiVgaSetBacklightEnable, (SusiId_t Id, uint32_t Enable), (Id, Enable), \
+      (REC_IN_U32(Id) REC_IN_U32(Enable)), ()) \
+    X(SusiVgaGetBacklightBrightness, (SusiId_t Id, uint32_t *pBright), (Id, pBright), \
+      (REC_IN_U32(Id)), (REC_OUT_P32(pBright))) \
+    X(SusiVgaSetBacklightBrightness, (SusiId_t Id, uint32_t Bright), (Id, Bright), \
+      (REC_IN_U32(Id) REC_IN_U32(Bright)), ()) \
+    X(SusiVgaGetBacklightLevel, (SusiId_t Id, uint32_t *pLevel), (Id, pLevel), \
+      (REC_IN_U32(Id)), (REC_OUT_P32(pLevel))) \
+    X(SusiVgaSetBacklightLevel, (SusiId_t Id, uint32_t Level), (Id, Level), \
+      (REC_IN_U32(Id) REC_IN_U32(Level)), ()) \
+    X(SusiVgaGetPolarity, (SusiId_t Id, uint32_t *pPolarity), (Id, pPolarity), \
+      (REC_IN_U32(Id)), (REC_OUT_P32(pPolarity))) \
+    X(SusiVgaSetPolarity, (SusiId_t Id, uint32_t Polarity), (Id, Polarity), \
+      (REC_IN_U32(Id) REC_IN_U32(Polarity)), ()) \
+    X(SusiVgaGetFrequency, (SusiId_t Id, uint32_t *pFrequency), (Id, pFrequency), \
+      (REC_IN_U32(Id)), (REC_OUT_P32(pFrequency))) \
+    X(SusiVgaSetFrequency, (SusiId_t Id, uint32_t Frequency), (Id, Frequency), \
+      (REC_IN_U32(Id) REC_IN_U32(Frequency)), ()) \
+    X(SusiVgaGetCaps, (SusiId_t Id, uint32_t ItemId, uint32_t *pValue), (Id, ItemId, pValue), \
+      (REC_IN_U32(Id) REC_IN_U32(ItemId)), (REC_OUT_P32(pValue))) \
+    X(SusiStorageGetCaps, (SusiId_t Id, uint32_t ItemId, uint32_t *pValue), (Id, ItemId, pValue), \
+      (REC_IN_U32(Id) REC_IN_U32(ItemId)), (REC_OUT_P32(pValue))) \
+    X(SusiStorageAreaRead, (SusiId_t Id, uint32_t Offset, uint8_t *pBuffer, uint32_t BufLen), (Id, Offset, pBuffer, BufLen), \
+      (REC_IN_U32(Id) REC_IN_U32(Offset) REC_IN_U32(BufLen)), (REC_OUT_BYTES(pBuffer, BufLen))) \
+    X(SusiStorageAreaWrite, (SusiId_t Id, uint32_t Offset, uint8_t *pBuffer, uint32_t BufLen), (Id, Offset, pBuffer, BufLen), \
+      (REC_IN_U32(Id) REC_IN_U32(Offset) REC_IN_BYTES(pBuffer, BufLen)), ()) \
+    X(SusiStorageAreaSetUnlock, (SusiId_t Id, uint8_t *pBuffer, uint32_t BufLen), (Id, pBuffer, BufLen), \
+      (REC_IN_U32(Id) REC_IN_U32(BufLen)), ()) \
+    X(SusiStorageAreaSetLock, (SusiId_t Id, uint8_t *pBuffer, uint32_t BufLen), (Id, pBuffer, BufLen), \
+      (REC_IN_U32(Id) REC_IN_U32(BufLen)), ()) \
+    X(SusiFanControlGetCaps, (SusiId_t Id, uint32_t ItemId, uint32_t *pValue), (Id, ItemId, pValue), \
+      (REC_IN_U32(Id) REC_IN_U32(ItemId)), (REC_OUT_P32(pValue))) \
+    X(SusiFanControlGetConfig, (SusiId_t Id, SusiFanControl *pConfig), (Id, pConfig), \
+      (REC_IN_U32(Id)), (REC_OUT_OBJ(pConfig))) \
+    X(SusiFanControlSetConfig, (SusiId_t Id, SusiFanControl *pConfig), (Id, pConfig), \
+      (REC_IN_U32(Id) REC_IN_OBJ(pConfig)), ()) \
+    X(SusiThermalProtectionGetCaps, (SusiId_t Id, uint32_t ItemId, uint32_t *pValue), (Id, ItemId, pValue), \
+      (REC_IN_U32(Id) REC_IN_U32(ItemId)), (REC_OUT_P32(pValue))) \
+    X(SusiThermalProtectionSetConfig, (SusiId_t Id, SusiThermalProtect *pConfig), (Id, pConfig), \
+      (REC_IN_U32(Id) REC_IN_OBJ(pConfig)), ()) \
+    X(SusiThermalProtectionGetConfig, (SusiId_t Id, SusiThermalProtect *pConfig), (Id, pConfig), \
+      (REC_IN_U32(Id)), (REC_OUT_OBJ(pConfig))) \
+    X(SusiWDogGetCaps, (SusiId_t Id, uint32_t ItemId, uint32_t *pValue), (Id, ItemId, pValue), \
+      (REC_IN_U32(Id) REC_IN_U32(ItemId)), (REC_OUT_P32(pValue))) \
+    X(SusiWDogStart, (SusiId_t Id, uint32_t DelayTime, uint32_t EventTime, uint32_t ResetTime, uint32_t EventType), (Id, DelayTime, EventTime, ResetTime, EventType), \
+      (REC_IN_U32(Id) REC_IN_U32(DelayTime) REC_IN_U32(EventTime) REC_IN_U32(ResetTime) REC_IN_U32(EventType)), ()) \
+    X(SusiWDogStop, (SusiId_t Id), (Id), \
+      (REC_IN_U32(Id)), ()) \
+    X(SusiWDogTrigger, (SusiId_t Id), (Id), \
+      (REC_IN_U32(Id)), ()) \
+    X(SusiWDogSetCallBack, (SusiId_t Id, SUSI_WDT_INT_CALLBACK pfnCallback, void *Context), (Id, pfnCallback, Context), \
+      (REC_IN_U32(Id) REC_IN_U8(pfnCallback != NULL)), ())
+
+#endif // SUSI_CALLS_H
@@ -0,0 +1,190 @@
+#include <pthread.h>
+#include "susi_caps.h"
+#include "hw_actor.h"
+#include "metrics.h"
+#include "susi_timing.h"
+
+typedef struct {
+    SusiId_t id;
+    uint32_t item;
+    uint32_t value;
+    SusiStatus_t status;
+    uint8_t cls;
+    bool used;                // Key is set; slots are never emptied, so probe chains hold
+    bool valid;               // value/status are current
+} CapsEntry;
+
+typedef struct {
+    SusiCapsClass cls;
+    SusiId_t id;
+    uint32_t item;
+    uint32_t value;
+    SusiStatus_t status;
+} CapsRead;
+
+static const char *classNames[SUSI_CAPS_CLASS_COUNT] = {
+    [SUSI_CAPS_BOARD]   = "board",
+    [SUSI_CAPS_WDOG]    = "wdog",
+    [SUSI_CAPS_GPIO]    = "gpio",
+    [SUSI_CAPS_STORAGE] = "storage",
+    [SUSI_CAPS_FAN]     = "fan",
+    [SUSI_CAPS_VGA]     = "vga",
+};
+
+static pthread_mutex_t capsLock = PTHREAD_MUTEX_INITIALIZER;
+static CapsEntry entries[SUSI_CAPS_SLOTS];
+static uint32_t entryCount = 0;
+static uint64_t hits[SUSI_CAPS_CLASS_COUNT];
+static uint64_t misses[SUSI_CAPS_CLASS_COUNT];
+static uint64_t uncached = 0;
+
+static uint32_t hashKey(SusiCapsClass cls, SusiId_t id, uint32_t item) {
+    uint32_t h = ((uint32_t)cls * 0x85EBCA6Bu) ^ (id * 0x9E3779B1u) ^ (item * 0xC2B2AE35u);
+    return (h ^ (h >> 15)) & (SUSI_CAPS_SLOTS - 1);
+}
+
+// Slot holding the key, else the free slot it would take, else NULL when full.
+// Called with capsLock held.
+static CapsEntry* findSlot(SusiCapsClass cls, SusiId_t id, uint32_t item) {
+    uint32_t slot = hashKey(cls, id, item);
+
+    for (uint32_t probes = 0; probes < SUSI_CAPS_SLOTS; probes++) {
+        CapsEntry *entry = &entries[slot];
+
+        if (!entry->used || (entry->cls == cls && entry->id == id && entry->item == item)) {
+            return entry;
+        }
+        slot = (slot + 1) & (SUSI_CAPS_SLOTS - 1);
+    }
+    return NULL;
+}
+
+static bool isDefinite(SusiStatus_t status) {
+    return status == SUSI_STATUS_SUCCESS || status == SUSI_STATUS_UNSUPPORTED ||
+           status == SUSI_STATUS_NOT_FOUND || status == SUSI_STATUS_INVALID_PARAMETER;
+}
+
+static void hwRead(void *arg) {
+    CapsRead *read = arg;
+    uint64_t start = monotonicNowNs();
+
+    switch (read->cls) {
+    case SUSI_CAPS_BOARD:
+        read->status = SusiBoardGetValue(read->id, &read->value);
+        susiTimingRecord(SUSI_CALL_BOARD_GET_VALUE, start, read->status);
+        break;
+    case SUSI_CAPS_WDOG:
+        read->status = SusiWDogGetCaps(read->id, read->item, &read->value);
+        susiTimingRecord(SUSI_CALL_WDOG_GET_CAPS, start, read->status);
+        break;
+    case SUSI_CAPS_GPIO:
+        read->status = SusiGPIOGetCaps(read->id, read->item, &read->value);
+        susiTimingRecord(SUSI_CALL_GPIO_GET_CAPS, start, read->status);
+        break;
+    case SUSI_CAPS_STORAGE:
+        read->status = SusiStorageGetCaps(read->id, read->item, &read->value);
+        susiTimingRecord(SUSI_CALL_STORAGE_GET_CAPS, start, read->status);
+        break;
+    case SUSI_CAPS_FAN:
+        read->status = SusiFanControlGetCaps(read->id, read->item, &read->value);
+        susiTimingRecord(SUSI_CALL_FAN_GET_CAPS, start, read->status);
+        break;
+    case SUSI_CAPS_VGA:
+        read->status = SusiVgaGetCaps(read->id, read->item, &read->value);
+        susiTimingRecord(SUSI_CALL_VGA_GET_CAPS, start, read->status);
+        break;
+    default:
+        read->status = SUSI_STATUS_INVALID_PARAMETER;
+        break;
+    }
+    if (read->status != SUSI_STATUS_SUCCESS) {
+        read->value = 0;
+    }
+}
+
+SusiStatus_t susiCapsGet(SusiCapsClass cls, SusiId_t id, uint32_t item, uint32_t *value) {
+    CapsRead read = { cls, id, item, 0, SUSI_STATUS_ERROR };
+    CapsEntry *entry;
+
+    // Board values have no item; keep the key independent of what callers pass
+    if (cls == SUSI_CAPS_BOARD) {
+        read.item = item = 0;
+    }
+    if (cls >= SUSI_CAPS_CLASS_COUNT) {
+        *value = 0;
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    pthread_mutex_lock(&capsLock);
+    entry = findSlot(cls, id, item);
+    if (entry != NULL && entry->used && entry->valid) {
+        *value = entry->value;
+        read.status = entry->status;
+        pthread_mutex_unlock(&capsLock);
+        __atomic_fetch_add(&hits[cls], 1, __ATOMIC_RELAXED);
+        return read.status;
+    }
+    pthread_mutex_unlock(&capsLock);
+
+    // Two callers missing the same item both read it; the answers agree
+    __atomic_fetch_add(&misses[cls], 1, __ATOMIC_RELAXED);
+    if (hwActorIsHardwareThread() || !hwActorCall(HW_LANE_READ, hwRead, &read)) {
+        // Off the hardware thread only while the actor is not running
+        hwRead(&read);
+    }
+    *value = read.value;
+    if (!isDefinite(read.status)) {
+        return read.status;
+    }
+
+    pthread_mutex_lock(&capsLock);
+    entry = findSlot(cls, id, item);
+    if (entry != NULL) {
+        if (!entry->used) {
+            entry->used = true;
+            entry->cls = (uint8_t)cls;
+            entry->id = id;
+            entry->item = item;
+            entryCount++;
+        }
+        entry->value = read.value;
+        entry->status = read.status;
+        entry->valid = true;
+    } else {
+        uncached++;
+    }
+    pthread_mutex_unlock(&capsLock);
+    return read.status;
+}
+
+void susiCapsInvalidate(SusiCapsClass cls, SusiId_t id) {
+    pthread_mutex_lock(&capsLock);
+    for (uint32_t i = 0; i < SUSI_CAPS_SLOTS; i++) {
+        if (entries[i].used && entries[i].cls == cls && entries[i].id == id) {
+            entries[i].valid = false;
+        }
+    }
+    pthread_mutex_unlock(&capsLock);
+}
+
+void susiCapsCollectMetrics(StrBuf *out, void *ctx) {
+    uint32_t count;
+    uint64_t full;
+    (void)ctx;
+
+    pthread_mutex_lock(&capsLock);
+    count = entryCount;
+    full = uncached;
+    pthread_mutex_unlock(&capsLock);
+
+    metricsHeader(out, "watchdog_susi_caps_entries", "gauge", "Capability items held in the shared cache");
+    strbufAppendf(out, "watchdog_susi_caps_entries %u\n", count);
+    metricsHeader(out, "watchdog_susi_caps_lookups_total", "counter", "Capability lookups answered from the cache or the driver");
+    for (int i = 0; i < SUSI_CAPS_CLASS_COUNT; i++) {
+        strbufAppendf(out, "watchdog_susi_caps_lookups_total{class=\"%s\",result=\"hit\"} %llu\n", classNames[i],
+                      (unsigned long long)__atomic_load_n(&hits[i], __ATOMIC_RELAXED));
+        strbufAppendf(out, "watchdog_susi_caps_lookups_total{class=\"%s\",result=\"miss\"} %llu\n", classNames[i],
+                      (unsigned long long)__atomic_load_n(&misses[i], __ATOMIC_RELAXED));
+    }
+    metricsHeader(out, "watchdog_susi_caps_uncached_total", "counter", "Definite answers not kept because the cache was full");
+    strbufAppendf(out, "watchdog_susi_caps_uncached_total %llu\n", (unsigned long long)full);
+}
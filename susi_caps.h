@@ -0,0 +1,38 @@
+#ifndef SUSI_CAPS_H
+#define SUSI_CAPS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "Susi4.h"
+#include "strbuf.h"
+
+#define SUSI_CAPS_SLOTS 512   // Must be a power of two
+
+// Which SUSI call answers a capability item
+typedef enum {
+    SUSI_CAPS_BOARD,          // SusiBoardGetValue, for constants such as SUSI_ID_SMBUS_SUPPORTED
+    SUSI_CAPS_WDOG,
+    SUSI_CAPS_GPIO,
+    SUSI_CAPS_STORAGE,
+    SUSI_CAPS_FAN,
+    SUSI_CAPS_VGA,
+    SUSI_CAPS_CLASS_COUNT
+} SusiCapsClass;
+
+// One process-wide cache of capability items, keyed by class, SusiId_t and
+// item, so every module that probes the EC shares the answers and each item
+// costs one driver call for the life of the service. Definite answers
+// (success, unsupported, not found, invalid parameter) are kept; transient
+// failures are not, and the next lookup asks again.
+//
+// Lookups are safe from any thread. A miss is read on the hardware thread:
+// directly when the caller is already on it, else through hwActorCall().
+
+// The item's value, or the status SUSI gave for it (*value is then 0)
+SusiStatus_t susiCapsGet(SusiCapsClass cls, SusiId_t id, uint32_t item, uint32_t *value);
+// Forget every item of one ID, so the next lookups probe the hardware again
+void susiCapsInvalidate(SusiCapsClass cls, SusiId_t id);
+
+void susiCapsCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // SUSI_CAPS_H
@@ -0,0 +1,60 @@
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stddef.h>
+#include "susi_device.h"
+
+typedef SusiStatus_t (SUSI_API *SusiDeviceGetValueFn)(SusiId_t id, uint32_t *value);
+typedef SusiStatus_t (SUSI_API *SusiDeviceSetValueFn)(SusiId_t id, uint32_t value);
+
+// Shutdown hooks of one phase run concurrently, so closes can race
+static pthread_mutex_t deviceLock = PTHREAD_MUTEX_INITIALIZER;
+static void *library;
+static int references;
+static SusiDeviceGetValueFn getValue;
+static SusiDeviceSetValueFn setValue;   // Older libraries may only read
+
+bool susiDeviceOpen(void) {
+    bool ok = true;
+
+    pthread_mutex_lock(&deviceLock);
+    if (references == 0) {
+        library = dlopen(SUSI_DEVICE_LIBRARY, RTLD_NOW | RTLD_LOCAL);
+        if (library != NULL) {
+            *(void**)&getValue = dlsym(library, "SusiDeviceGetValue");
+            *(void**)&setValue = dlsym(library, "SusiDeviceSetValue");
+            if (getValue == NULL) {
+                dlclose(library);
+                library = NULL;
+            }
+        }
+        ok = library != NULL;
+    }
+    if (ok) {
+        references++;
+    }
+    pthread_mutex_unlock(&deviceLock);
+    return ok;
+}
+
+void susiDeviceClose(void) {
+    pthread_mutex_lock(&deviceLock);
+    if (references > 0 && --references == 0) {
+        getValue = NULL;
+        setValue = NULL;
+        dlclose(library);
+        library = NULL;
+    }
+    pthread_mutex_unlock(&deviceLock);
+}
+
+// Callers hold a reference, so the pointers cannot change under them
+SusiStatus_t susiDeviceGetValue(SusiId_t id, uint32_t *value) {
+    return getValue != NULL ? getValue(id, value) : SUSI_STATUS_NOT_INITIALIZED;
+}
+
+SusiStatus_t susiDeviceSetValue(SusiId_t id, uint32_t value) {
+    if (getValue == NULL) {
+        return SUSI_STATUS_NOT_INITIALIZED;
+    }
+    return setValue != NULL ? setValue(id, value) : SUSI_STATUS_UNSUPPORTED;
+}
@@ -0,0 +1,25 @@
+#ifndef SUSI_DEVICE_H
+#define SUSI_DEVICE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "Susi4.h"
+
+#define SUSI_DEVICE_LIBRARY "libSUSIDevice.so"
+
+// The SUSI device library reaches the controllers that sit beside the EC
+// (the vehicle PIC, PoE). It ships apart from the SUSI driver and only
+// for boards that have them, so it is loaded with dlopen by the modules
+// that need it and the service runs without it. Each successful
+// susiDeviceOpen() takes a reference and the library is unloaded with the
+// last susiDeviceClose(). Like every SUSI call, the getters and setters
+// run on the hardware thread.
+
+bool susiDeviceOpen(void);
+void susiDeviceClose(void);
+
+// SUSI_STATUS_NOT_INITIALIZED while the library is not loaded
+SusiStatus_t susiDeviceGetValue(SusiId_t id, uint32_t *value);
+SusiStatus_t susiDeviceSetValue(SusiId_t id, uint32_t value);
+
+#endif // SUSI_DEVICE_H
@@ -0,0 +1,650 @@
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <jansson.h>
+#include "susi_iot.h"
+#include "events.h"
+#include "histogram.h"
+#include "hw_actor.h"
+#include "metrics.h"
+#include "response_pool.h"
+#include "snapshot.h"
+#include "timeutil.h"
+
+#define IOT_STATUS_SUCCESS 0u
+#define IOT_STATUS_NOT_FOUND 0xFFFFFBFFu
+#define IOT_STATUS_UNSUPPORTED 0xFFFFFCFFu
+#define IOT_CACHE_INITIAL_SLOTS 64
+#define IOT_NO_NODE -1
+
+typedef uint32_t IotStatus;
+typedef uint32_t IotId;
+typedef void (*IotEventCallback)(IotId id, char *json);
+
+typedef IotStatus (*IotInitializeFn)(void);
+typedef IotStatus (*IotGetCapabilityFn)(json_t *capability);
+typedef const char* (*IotGetDataStringFn)(IotId id);
+typedef const char* (*IotGetDataStringByUriFn)(const char *uri);
+typedef IotStatus (*IotSetValueFn)(IotId id, json_t *value);
+typedef IotStatus (*IotSetEventHandlerFn)(IotEventCallback callback);
+typedef IotStatus (*IotMemFreeFn)(void *address);
+
+// Children of a node are a sibling list; capability levels are narrow
+typedef struct {
+    uint32_t name;               // Offset of the segment in uriNames
+    uint32_t length;
+    int32_t child;
+    int32_t sibling;
+    IotId id;
+    bool hasId;
+} UriNode;
+
+typedef struct {
+    IotId id;
+    char *text;                  // NULL: empty slot
+    size_t length;
+    uint32_t generation;
+    uint64_t fetchedNs;
+} DataEntry;
+
+typedef struct {
+    IotId id;
+    const char *uri;             // By URI when set
+    const char *text;            // Out, freed with memFree
+} DataFetch;
+
+typedef struct {
+    IotId id;
+    json_t *value;
+    IotStatus status;
+} ValueWrite;
+
+static bool enabled = false;
+static uint32_t maxAgeMs = SUSI_IOT_DEFAULT_MAX_AGE_MS;
+static bool iotActive = false;
+
+static void *library;
+static IotInitializeFn initialize;
+static IotInitializeFn uninitialize;
+static IotGetCapabilityFn getCapability;
+static IotGetDataStringFn getDataString;
+static IotGetDataStringByUriFn getDataStringByUri;
+static IotSetValueFn setValue;
+static IotSetEventHandlerFn setEventHandler;
+static IotMemFreeFn memFree;
+
+static Snapshot capabilitySnapshot;
+
+// Guards the URI trie and the data cache
+static pthread_mutex_t iotLock = PTHREAD_MUTEX_INITIALIZER;
+static UriNode *uriNodes = NULL;
+static uint32_t uriNodeCount = 0;
+static uint32_t uriNodeCapacity = 0;
+static char *uriNames = NULL;
+static uint32_t uriNamesUsed = 0;
+static uint32_t uriNamesCapacity = 0;
+static uint32_t uriIdCount = 0;
+static bool uriBuildFailed = false;
+static DataEntry *entries = NULL;
+static uint32_t slotMask = 0;
+static uint32_t slotsUsed = 0;
+
+static uint32_t dataGeneration = 1;
+static uint64_t cacheHits = 0;
+static uint64_t cacheMisses = 0;
+static uint64_t fetchErrors = 0;
+static uint64_t iotEvents = 0;
+static uint64_t writes = 0;
+static uint64_t capabilityLoads = 0;
+static Histogram fetchLatency;
+
+void susiIotEnable(uint32_t ms) {
+    enabled = true;
+    maxAgeMs = ms;
+}
+
+// URI trie
+
+static int32_t findChild(int32_t parent, const char *segment, uint32_t length) {
+    int32_t node = uriNodes[parent].child;
+
+    while (node != IOT_NO_NODE &&
+           (uriNodes[node].length != length || memcmp(uriNames + uriNodes[node].name, segment, length) != 0)) {
+        node = uriNodes[node].sibling;
+    }
+    return node;
+}
+
+static int32_t newNode(const char *segment, uint32_t length) {
+    UriNode *node;
+
+    if (uriNodeCount == uriNodeCapacity) {
+        uint32_t capacity = uriNodeCapacity ? uriNodeCapacity * 2 : 64;
+        UriNode *grown = realloc(uriNodes, capacity * sizeof(UriNode));
+        if (grown == NULL) {
+            return IOT_NO_NODE;
+        }
+        uriNodes = grown;
+        uriNodeCapacity = capacity;
+    }
+    if (uriNames == NULL || uriNamesUsed + length > uriNamesCapacity) {
+        uint32_t capacity = uriNamesCapacity ? uriNamesCapacity : 1024;
+        char *grown;
+
+        while (capacity < uriNamesUsed + length) {
+            capacity *= 2;
+        }
+        grown = realloc(uriNames, capacity);
+        if (grown == NULL) {
+            return IOT_NO_NODE;
+        }
+        uriNames = grown;
+        uriNamesCapacity = capacity;
+    }
+
+    node = &uriNodes[uriNodeCount];
+    node->name = uriNamesUsed;
+    node->length = length;
+    node->child = IOT_NO_NODE;
+    node->sibling = IOT_NO_NODE;
+    node->id = 0;
+    node->hasId = false;
+    memcpy(uriNames + uriNamesUsed, segment, length);
+    uriNamesUsed += length;
+    return (int32_t)uriNodeCount++;
+}
+
+static int32_t addChild(int32_t parent, const char *segment) {
+    uint32_t length = (uint32_t)strlen(segment);
+    int32_t node = findChild(parent, segment, length);
+
+    if (node != IOT_NO_NODE) {
+        return node;
+    }
+    node = newNode(segment, length);
+    if (node == IOT_NO_NODE) {
+        uriBuildFailed = true;
+        return IOT_NO_NODE;
+    }
+    uriNodes[node].sibling = uriNodes[parent].child;
+    uriNodes[parent].child = node;
+    return node;
+}
+
+static void setNodeId(int32_t node, json_t *object) {
+    json_t *id = json_object_get(object, "id");
+
+    if (json_is_integer(id) && !uriNodes[node].hasId) {
+        uriNodes[node].id = (IotId)json_integer_value(id);
+        uriNodes[node].hasId = true;
+        uriIdCount++;
+    }
+}
+
+static void addObject(int32_t parent, json_t *object) {
+    const char *key;
+    json_t *value;
+
+    json_object_foreach(object, key, value) {
+        if (uriBuildFailed) {
+            return;
+        }
+        if (json_is_object(value)) {
+            int32_t node = addChild(parent, key);
+            if (node != IOT_NO_NODE) {
+                setNodeId(node, value);
+                addObject(node, value);
+            }
+        } else if (json_is_array(value) && strcmp(key, "e") == 0) {
+            size_t i;
+            json_t *element;
+
+            json_array_foreach(value, i, element) {
+                json_t *name = json_object_get(element, "n");
+                int32_t node;
+
+                if (!json_is_object(element) || !json_is_string(name)) {
+                    continue;
+                }
+                node = addChild(parent, json_string_value(name));
+                if (node != IOT_NO_NODE) {
+                    setNodeId(node, element);
+                }
+            }
+        }
+    }
+}
+
+static void freeIndex(void) {
+    free(uriNodes);
+    free(uriNames);
+    uriNodes = NULL;
+    uriNames = NULL;
+    uriNodeCount = uriNodeCapacity = 0;
+    uriNamesUsed = uriNamesCapacity = 0;
+    uriIdCount = 0;
+}
+
+// Called with iotLock held
+static void buildIndex(json_t *capability) {
+    freeIndex();
+    uriBuildFailed = false;
+    if (newNode("", 0) == IOT_NO_NODE) {
+        freeIndex();
+        return;
+    }
+    addObject(0, capability);
+    if (uriBuildFailed) {
+        printf("SusiIoT: out of memory for the URI index, URIs go to SusiIoT\n");
+        freeIndex();
+    }
+}
+
+// Called with iotLock held
+static bool lookupUri(const char *uri, IotId *id) {
+    int32_t node = 0;
+
+    if (uriNodes == NULL) {
+        return false;
+    }
+    for (;;) {
+        const char *end;
+
+        while (*uri == '/') {
+            uri++;
+        }
+        if (*uri == '\0') {
+            break;
+        }
+        end = strchr(uri, '/');
+        if (end == NULL) {
+            end = uri + strlen(uri);
+        }
+        node = findChild(node, uri, (uint32_t)(end - uri));
+        if (node == IOT_NO_NODE) {
+            return false;
+        }
+        uri = end;
+    }
+    if (node == 0 || !uriNodes[node].hasId) {
+        return false;
+    }
+    *id = uriNodes[node].id;
+    return true;
+}
+
+bool susiIotResolve(const char *uri, uint32_t *id) {
+    bool found;
+
+    pthread_mutex_lock(&iotLock);
+    found = lookupUri(uri, id);
+    pthread_mutex_unlock(&iotLock);
+    return found;
+}
+
+// Data cache: open addressing on the ID, called with iotLock held
+
+static uint32_t hashId(IotId id) {
+    uint32_t h = id * 0x9E3779B1u;
+    return h ^ (h >> 16);
+}
+
+static DataEntry* findEntry(IotId id, bool create) {
+    uint32_t slot;
+
+    if (entries == NULL || (create && (slotsUsed + 1) * 2 > slotMask + 1)) {
+        uint32_t capacity = entries ? (slotMask + 1) * 2 : IOT_CACHE_INITIAL_SLOTS;
+        DataEntry *grown = calloc(capacity, sizeof(DataEntry));
+
+        if (grown == NULL) {
+            return NULL;
+        }
+        for (uint32_t i = 0; entries != NULL && i <= slotMask; i++) {
+            if (entries[i].text != NULL) {
+                slot = hashId(entries[i].id) & (capacity - 1);
+                while (grown[slot].text != NULL) {
+                    slot = (slot + 1) & (capacity - 1);
+                }
+                grown[slot] = entries[i];
+            }
+        }
+        free(entries);
+        entries = grown;
+        slotMask = capacity - 1;
+    }
+    for (slot = hashId(id) & slotMask; entries[slot].text != NULL; slot = (slot + 1) & slotMask) {
+        if (entries[slot].id == id) {
+            return &entries[slot];
+        }
+    }
+    return create ? &entries[slot] : NULL;
+}
+
+static void freeCache(void) {
+    for (uint32_t i = 0; entries != NULL && i <= slotMask; i++) {
+        free(entries[i].text);
+    }
+    free(entries);
+    entries = NULL;
+    slotMask = 0;
+    slotsUsed = 0;
+}
+
+// Hardware thread
+
+static void hwFetchCapability(void *arg) {
+    json_t **capability = arg;
+
+    *capability = json_object();
+    if (*capability != NULL && getCapability(*capability) != IOT_STATUS_SUCCESS) {
+        json_decref(*capability);
+        *capability = NULL;
+    }
+}
+
+static void hwFetchData(void *arg) {
+    DataFetch *fetch = arg;
+
+    fetch->text = fetch->uri != NULL ? getDataStringByUri(fetch->uri) : getDataString(fetch->id);
+}
+
+static void hwSetValue(void *arg) {
+    ValueWrite *write = arg;
+
+    write->status = setValue(write->id, write->value);
+}
+
+static void hwInitialize(void *arg) {
+    *(IotStatus *)arg = initialize();
+}
+
+static void hwUninitialize(void *arg) {
+    (void)arg;
+    if (setEventHandler != NULL) {
+        setEventHandler(NULL);
+    }
+    uninitialize();
+}
+
+// SusiIoT's own thread: something changed, so cached data is stale
+static void onIotEvent(IotId id, char *json) {
+    (void)json;
+    __atomic_fetch_add(&dataGeneration, 1, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&iotEvents, 1, __ATOMIC_RELAXED);
+    eventPublish(EVENT_IOT, EVENT_NO_WATCHDOG, id, 0, 0, 0);
+}
+
+// Fetch the capability, rebuild the index and publish the snapshot
+static bool loadCapability(void) {
+    json_t *capability = NULL;
+    size_t capacity;
+    size_t length;
+    char *data;
+
+    if (!hwActorCall(HW_LANE_READ, hwFetchCapability, &capability) || capability == NULL) {
+        return false;
+    }
+    pthread_mutex_lock(&iotLock);
+    buildIndex(capability);
+    pthread_mutex_unlock(&iotLock);
+    __atomic_fetch_add(&dataGeneration, 1, __ATOMIC_RELEASE);
+
+    // Dumped straight into the snapshot buffer; one trailing newline like the other bodies
+    data = snapshotBegin(&capabilitySnapshot, &capacity);
+    for (;;) {
+        if (data == NULL) {
+            json_decref(capability);
+            return false;
+        }
+        length = json_dumpb(capability, data, capacity - 1, JSON_COMPACT);
+        if (length > 0 && length < capacity - 1) {
+            break;
+        }
+        if (length == 0 || !snapshotGrow(&capabilitySnapshot, length + 2 > capacity * 2 ? length + 2 : capacity * 2)) {
+            snapshotAbort(&capabilitySnapshot);
+            json_decref(capability);
+            return false;
+        }
+        data = snapshotBegin(&capabilitySnapshot, &capacity);
+    }
+    data[length++] = '\n';
+    snapshotPublish(&capabilitySnapshot, length);
+    json_decref(capability);
+    __atomic_fetch_add(&capabilityLoads, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+static void unload(void) {
+    dlclose(library);
+    library = NULL;
+    initialize = uninitialize = NULL;
+    getCapability = NULL;
+    getDataString = NULL;
+    getDataStringByUri = NULL;
+    setValue = NULL;
+    setEventHandler = NULL;
+    memFree = NULL;
+}
+
+bool susiIotStart(void) {
+    IotStatus status = IOT_STATUS_SUCCESS;
+
+    if (!enabled || iotActive) {
+        return true;
+    }
+    library = dlopen(SUSI_IOT_LIBRARY, RTLD_NOW | RTLD_LOCAL);
+    if (library == NULL) {
+        printf("SusiIoT: %s\n", dlerror());
+        return false;
+    }
+    *(void**)&initialize = dlsym(library, "SusiIoTInitialize");
+    *(void**)&uninitialize = dlsym(library, "SusiIoTUninitialize");
+    *(void**)&getCapability = dlsym(library, "SusiIoTGetPFCapability");
+    *(void**)&getDataString = dlsym(library, "SusiIoTGetPFDataString");
+    *(void**)&getDataStringByUri = dlsym(library, "SusiIoTGetPFDataStringByUri");
+    *(void**)&setValue = dlsym(library, "SusiIoTSetValue");
+    *(void**)&setEventHandler = dlsym(library, "SusiIoTSetPFEventHandler");
+    *(void**)&memFree = dlsym(library, "SusiIoTMemFree");
+    if (initialize == NULL || uninitialize == NULL || getCapability == NULL || getDataString == NULL ||
+        getDataStringByUri == NULL || setValue == NULL || memFree == NULL) {
+        printf("SusiIoT: %s lacks part of the API\n", SUSI_IOT_LIBRARY);
+        unload();
+        return false;
+    }
+    if (!snapshotInit(&capabilitySnapshot, SUSI_IOT_SNAPSHOT_CAPACITY, "application/json", "iot")) {
+        unload();
+        return false;
+    }
+    // Module discovery happens here and can take a while; it is a one-off
+    if (!hwActorCall(HW_LANE_CONFIG, hwInitialize, &status) || status != IOT_STATUS_SUCCESS) {
+        printf("SusiIoT: initialize failed (status 0x%08x)\n", status);
+        snapshotDestroy(&capabilitySnapshot);
+        unload();
+        return false;
+    }
+    if (!loadCapability()) {
+        printf("SusiIoT: no capability document\n");
+        hwActorCall(HW_LANE_CONFIG, hwUninitialize, NULL);
+        snapshotDestroy(&capabilitySnapshot);
+        unload();
+        return false;
+    }
+    if (setEventHandler != NULL) {
+        setEventHandler(onIotEvent);
+    }
+    iotActive = true;
+    printf("SusiIoT: %u IoT IDs indexed, data cached for %u ms\n", uriIdCount, maxAgeMs);
+    return true;
+}
+
+void susiIotStop(void) {
+    if (!iotActive) {
+        return;
+    }
+    iotActive = false;
+    // The hardware thread may already be gone in this phase; then nothing else calls SUSI
+    if (!hwActorCall(HW_LANE_CONFIG, hwUninitialize, NULL)) {
+        hwUninitialize(NULL);
+    }
+    pthread_mutex_lock(&iotLock);
+    freeIndex();
+    freeCache();
+    pthread_mutex_unlock(&iotLock);
+    snapshotDestroy(&capabilitySnapshot);
+    unload();
+}
+
+enum MHD_Result susiIotQueueCapability(struct MHD_Connection *connection, bool refresh) {
+    if (!iotActive || (refresh && !loadCapability())) {
+        return MHD_NO;
+    }
+    return snapshotQueue(&capabilitySnapshot, connection);
+}
+
+static enum MHD_Result queueText(struct MHD_Connection *connection, const char *text, size_t length) {
+    ResponseBuffer body;
+
+    if (!responseBufferAcquireSize(&body, length + 1)) {
+        return MHD_NO;
+    }
+    strbufAppendN(&body.out, text, length);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+// Fetch on the hardware thread; the text goes back with memFree
+static const char* fetchData(DataFetch *fetch) {
+    uint64_t start = monotonicNowNs();
+
+    fetch->text = NULL;
+    if (!hwActorCall(HW_LANE_READ, hwFetchData, fetch) || fetch->text == NULL) {
+        __atomic_fetch_add(&fetchErrors, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    histogramRecord(&fetchLatency, monotonicNowNs() - start);
+    return fetch->text;
+}
+
+enum MHD_Result susiIotQueueData(struct MHD_Connection *connection, uint32_t id, const char *uri) {
+    DataFetch fetch = { id, NULL, NULL };
+    uint32_t generation;
+    DataEntry *entry;
+    enum MHD_Result ret;
+    size_t length;
+
+    if (!iotActive) {
+        return MHD_NO;
+    }
+    // URIs the index does not know go to SusiIoT's resolver, uncached
+    if (uri != NULL && !susiIotResolve(uri, &fetch.id)) {
+        fetch.uri = uri;
+        if (fetchData(&fetch) == NULL) {
+            return MHD_NO;
+        }
+        ret = queueText(connection, fetch.text, strlen(fetch.text));
+        memFree((void *)fetch.text);
+        return ret;
+    }
+
+    generation = __atomic_load_n(&dataGeneration, __ATOMIC_ACQUIRE);
+    pthread_mutex_lock(&iotLock);
+    entry = findEntry(fetch.id, false);
+    if (entry != NULL && entry->generation == generation &&
+        (maxAgeMs == 0 || monotonicNowNs() - entry->fetchedNs < (uint64_t)maxAgeMs * 1000000ull)) {
+        ret = queueText(connection, entry->text, entry->length);
+        pthread_mutex_unlock(&iotLock);
+        __atomic_fetch_add(&cacheHits, 1, __ATOMIC_RELAXED);
+        return ret;
+    }
+    pthread_mutex_unlock(&iotLock);
+
+    __atomic_fetch_add(&cacheMisses, 1, __ATOMIC_RELAXED);
+    if (fetchData(&fetch) == NULL) {
+        return MHD_NO;
+    }
+    length = strlen(fetch.text);
+    pthread_mutex_lock(&iotLock);
+    entry = findEntry(fetch.id, true);
+    if (entry != NULL) {
+        char *copy = malloc(length + 1);
+
+        if (copy != NULL) {
+            memcpy(copy, fetch.text, length + 1);
+            if (entry->text == NULL) {
+                slotsUsed++;
+            }
+            free(entry->text);
+            entry->id = fetch.id;
+            entry->text = copy;
+            entry->length = length;
+            // Stamped with the generation seen before the fetch, so a write
+            // that raced with it makes the entry stale
+            entry->generation = generation;
+            entry->fetchedNs = monotonicNowNs();
+        }
+    }
+    pthread_mutex_unlock(&iotLock);
+    ret = queueText(connection, fetch.text, length);
+    memFree((void *)fetch.text);
+    return ret;
+}
+
+const char* susiIotSetValue(uint32_t id, const char *value) {
+    ValueWrite write = { id, NULL, IOT_STATUS_SUCCESS };
+    json_error_t error;
+
+    if (!iotActive) {
+        return "SusiIoT is not loaded (see --iot)";
+    }
+    write.value = json_loads(value, JSON_DECODE_ANY, &error);
+    if (write.value == NULL) {
+        write.value = json_string(value);
+        if (write.value == NULL) {
+            return "Value is neither JSON nor UTF-8 text";
+        }
+    }
+    if (!hwActorCall(HW_LANE_CONFIG, hwSetValue, &write)) {
+        json_decref(write.value);
+        return "Hardware thread busy";
+    }
+    json_decref(write.value);
+    if (write.status != IOT_STATUS_SUCCESS) {
+        if (write.status == IOT_STATUS_NOT_FOUND) {
+            return "Unknown IoT ID";
+        }
+        return write.status == IOT_STATUS_UNSUPPORTED ? "IoT ID cannot be written" : "SusiIoT rejected the value";
+    }
+    __atomic_fetch_add(&dataGeneration, 1, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&writes, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+void susiIotCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (!enabled) {
+        return;
+    }
+    metricsHeader(out, "watchdog_iot_available", "gauge", "1 while SusiIoT is loaded and initialized");
+    strbufAppendf(out, "watchdog_iot_available %d\n", iotActive ? 1 : 0);
+    metricsHeader(out, "watchdog_iot_ids", "gauge", "IoT IDs in the URI index");
+    strbufAppendf(out, "watchdog_iot_ids %u\n", __atomic_load_n(&uriIdCount, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_iot_capability_loads_total", "counter", "Capability documents fetched from SusiIoT");
+    strbufAppendf(out, "watchdog_iot_capability_loads_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&capabilityLoads, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_iot_data_total", "counter", "IoT data requests by ID, served from the cache or fetched");
+    strbufAppendf(out, "watchdog_iot_data_total{result=\"hit\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&cacheHits, __ATOMIC_RELAXED));
+    strbufAppendf(out, "watchdog_iot_data_total{result=\"miss\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&cacheMisses, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_iot_fetch_errors_total", "counter", "SusiIoT data fetches that returned nothing");
+    strbufAppendf(out, "watchdog_iot_fetch_errors_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&fetchErrors, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_iot_writes_total", "counter", "Values written through PUT /api/iot/data");
+    strbufAppendf(out, "watchdog_iot_writes_total %llu\n", (unsigned long long)__atomic_load_n(&writes, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_iot_events_total", "counter", "Change events raised by SusiIoT");
+    strbufAppendf(out, "watchdog_iot_events_total %llu\n", (unsigned long long)__atomic_load_n(&iotEvents, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_iot_fetch_seconds", "summary", "Time to fetch one data string from SusiIoT");
+    histogramWriteSummary(out, "watchdog_iot_fetch_seconds", NULL, &fetchLatency);
+}
@@ -0,0 +1,47 @@
+#ifndef SUSI_IOT_H
+#define SUSI_IOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <microhttpd.h>
+#include "strbuf.h"
+
+#define SUSI_IOT_LIBRARY "libSusiIoT.so"
+#define SUSI_IOT_DEFAULT_MAX_AGE_MS 1000
+#define SUSI_IOT_SNAPSHOT_CAPACITY 16384
+
+// The SusiIoT data model for /api/iot/*, so one long-lived service answers
+// every IoT query instead of a process per query. libSusiIoT ships with
+// the SUSI driver's IoT package only, so it is loaded with dlopen and the
+// service runs without it. Every SusiIoT call runs on the hardware thread.
+//
+// The capability document is fetched once and served as a snapshot with an
+// ETag; a refresh fetches it again. While it is loaded, each path of keys
+// that leads to an "id" goes into a URI trie ("e" elements are named by
+// their "n"), so a URI resolves without JSON or allocation. Data strings
+// are cached per IoT ID and reused until they are older than the maximum
+// age or the data generation moves, which a write through susiIotSetValue()
+// or a SusiIoT event does. Events are also published as EVENT_IOT.
+
+// Before susiIotStart(): load SusiIoT, with data kept for up to maxAgeMs
+// (0 = until the next write or event)
+void susiIotEnable(uint32_t maxAgeMs);
+// Load the library, initialize it and fetch the capability (after
+// hwActorStart); true and nothing done when not enabled
+bool susiIotStart(void);
+// Uninitialize and unload, once no request can reach the module (after MHD stopped)
+void susiIotStop(void);
+
+// GET /api/iot: the capability, fetched again first with refresh
+enum MHD_Result susiIotQueueCapability(struct MHD_Connection *connection, bool refresh);
+// GET /api/iot/data: by URI when uri is set, else by id. MHD_NO when
+// SusiIoT is not loaded or has no such item.
+enum MHD_Result susiIotQueueData(struct MHD_Connection *connection, uint32_t id, const char *uri);
+// Write a JSON value (a bare word is taken as a string); an error message
+// or NULL
+const char* susiIotSetValue(uint32_t id, const char *value);
+bool susiIotResolve(const char *uri, uint32_t *id);
+
+void susiIotCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // SUSI_IOT_H
@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include "susi_iot.h"
+
+// SusiIoT API for builds without jansson (the small profile). libSusiIoT
+// hands out jansson objects, so it cannot be used; every request is
+// answered as on a board without the IoT package.
+
+void susiIotEnable(uint32_t maxAgeMs) {
+    (void)maxAgeMs;
+    printf("Warning: SusiIoT not available in this build\n");
+}
+
+bool susiIotStart(void) {
+    return true;
+}
+
+void susiIotStop(void) {
+}
+
+enum MHD_Result susiIotQueueCapability(struct MHD_Connection *connection, bool refresh) {
+    (void)connection;
+    (void)refresh;
+    return MHD_NO;
+}
+
+enum MHD_Result susiIotQueueData(struct MHD_Connection *connection, uint32_t id, const char *uri) {
+    (void)connection;
+    (void)id;
+    (void)uri;
+    return MHD_NO;
+}
+
+const char* susiIotSetValue(uint32_t id, const char *value) {
+    (void)id;
+    (void)value;
+    return "SusiIoT is not loaded (see --iot)";
+}
+
+bool susiIotResolve(const char *uri, uint32_t *id) {
+    (void)uri;
+    (void)id;
+    return false;
+}
+
+void susiIotCollectMetrics(StrBuf *out, void *ctx) {
+    (void)out;
+    (void)ctx;
+}
@@ -0,0 +1,1883 @@
+// Drop-in replacement for libSUSI-4.00.so that keeps all board state in
+// memory, so the service and the device demos can be benchmarked and tested
+// without Advantech hardware. Behaviour is configured through environment
+// variables read on the first call:
+//
+//   SUSI_MOCK_LATENCY    per-call latency, e.g.
+//                        "default=fixed:20us,SusiWDogTrigger=normal:200us:50us"
+//                        distributions: fixed:D, uniform:LO:HI, normal:MEAN:SD, exp:MEAN
+//                        durations take ns, us, ms or s suffixes
+//   SUSI_MOCK_FAIL       per-call failure probability and optional status, e.g.
+//                        "SusiWDogTrigger=0.01,SusiI2CReadTransfer=0.05:0xFFFFFBFA"
+//   SUSI_MOCK_SEED       seed for the latency and failure generators (default 1)
+//   SUSI_MOCK_WATCHDOGS  number of watchdog timers reported present (default 2)
+//   SUSI_MOCK_REPLAY     answer calls from a recording made with libsusi_trace.so
+//                        (SUSI_TRACE_RECORD), taking as long as they did on the board
+//   SUSI_MOCK_REPLAY_LOOP  set to 1 to start a call's recording over once it is used up
+
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Susi4.h"
+#include "susi_calls.h"
+#include "susi_record.h"
+
+#define MOCK_ENUM(name, params, args, inputs, outputs) MOCK_##name,
+#define MOCK_NAME(name, params, args, inputs, outputs) #name,
+
+typedef enum { SUSI_CALLS(MOCK_ENUM) MOCK_CALL_COUNT } MockCall;
+
+static const char *mockCallNames[MOCK_CALL_COUNT] = { SUSI_CALLS(MOCK_NAME) };
+
+typedef enum {
+    LATENCY_NONE,
+    LATENCY_FIXED,
+    LATENCY_UNIFORM,
+    LATENCY_NORMAL,
+    LATENCY_EXP
+} LatencyKind;
+
+typedef struct {
+    LatencyKind kind;
+    double a;            // fixed value, lower bound or mean (ns)
+    double b;            // upper bound or standard deviation (ns)
+    double failRate;
+    SusiStatus_t failStatus;
+} MockBehaviour;
+
+#define MOCK_BUSES          2
+#define MOCK_GPIO_PINS      16
+#define MOCK_STORAGE_SIZE   4096
+#define MOCK_PASSWORD_MAX   8
+#define MOCK_BACKLIGHTS     1
+#define MOCK_FANS           2
+#define MOCK_THERMALS       2
+#define MOCK_I2C_DEVICES    { 0x50, 0x68 }
+
+typedef struct {
+    int running;
+    uint32_t delayMs, eventMs, resetMs, eventType;
+    struct timespec lastFeed;
+    int sinceStart;          // No trigger yet, so the delay stage still applies
+    int eventFired;          // Event stage already signalled for this feed
+    SUSI_WDT_INT_CALLBACK callback;
+    void *callbackContext;
+} MockWatchdog;
+
+static pthread_once_t configOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t stateLock = PTHREAD_MUTEX_INITIALIZER;
+static MockBehaviour behaviours[MOCK_CALL_COUNT];
+static uint64_t seed = 1;
+static uint32_t watchdogCount = 2;
+static uint32_t gpioIrqMs;               // SUSI_MOCK_GPIO_IRQ: toggle interval, 0 = never
+static double cpuRamp;                   // SUSI_MOCK_CPU_RAMP: CPU temperature rise, C per second
+static uint32_t seedCounter;
+static __thread uint64_t rngState;
+
+#define REPLAY_WINDOW 256        // Records of one call searched ahead for matching inputs
+#define REPLAY_BEHIND 64         // Unused records this far behind a match are given up on
+
+typedef struct {
+    SusiRecord record;
+    int used;
+} ReplayRecord;
+
+typedef struct {
+    ReplayRecord *records;       // This call's records, in recorded order
+    uint32_t count;
+    uint32_t cursor;             // First record not used yet
+} ReplayQueue;
+
+static pthread_mutex_t replayLock = PTHREAD_MUTEX_INITIALIZER;
+static int replaying;
+static int replayLoop;
+static const char *replayPath;
+static uint8_t *replayData;
+static ReplayRecord *replayRecords;
+static ReplayQueue replayQueues[MOCK_CALL_COUNT];
+static uint64_t replayHits, replayMisses, replaySkipped;
+
+static void loadReplay(const char *path);
+
+static int initialized;
+static struct timespec initTime;
+static uint32_t bootCounter = 42;
+static uint32_t buzzer, buzzerFrequency = 2000, rtcWake;
+static uint32_t pwrDelay;
+static uint8_t pwrEvent;
+static MockWatchdog watchdogs[SUSI_ID_WATCHDOG_MAX];
+static uint32_t gpioDirection = 0xffff;   // all pins input
+static uint32_t gpioLevel, gpioEdge, gpioIntPin;
+static SUSI_INT_CALLBACK gpioCallback;
+static uint8_t i2cMemory[MOCK_BUSES][128][256];
+static uint8_t smbMemory[MOCK_BUSES][128][256];
+static uint8_t i2cPointer[MOCK_BUSES][128];
+static uint32_t i2cFrequency[MOCK_BUSES] = { 100, 100 };
+static uint8_t storage[MOCK_STORAGE_SIZE];
+static uint8_t storagePassword[MOCK_PASSWORD_MAX];
+static uint32_t storagePasswordLen;
+static int storageLocked;
+static uint32_t backlightEnable[MOCK_BACKLIGHTS] = { 1 };
+static uint32_t backlightBrightness[MOCK_BACKLIGHTS] = { 200 };
+static uint32_t backlightLevel[MOCK_BACKLIGHTS] = { 7 };
+static uint32_t backlightPolarity[MOCK_BACKLIGHTS];
+static uint32_t backlightFrequency[MOCK_BACKLIGHTS] = { 1000 };
+static SusiFanControl fanConfigs[MOCK_FANS];
+static SusiThermalProtect thermalConfigs[MOCK_THERMALS];
+
+// ---------------------------------------------------------------------------
+// Configuration
+// ---------------------------------------------------------------------------
+
+static int parseDuration(const char *text, double *ns) {
+    char *end;
+    double value = strtod(text, &end);
+
+    if (end == text || value < 0) {
+        return -1;
+    }
+    if (*end == '\0' || strcmp(end, "ns") == 0) {
+        *ns = value;
+    } else if (strcmp(end, "us") == 0) {
+        *ns = value * 1e3;
+    } else if (strcmp(end, "ms") == 0) {
+        *ns = value * 1e6;
+    } else if (strcmp(end, "s") == 0) {
+        *ns = value * 1e9;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+static int parseLatency(char *spec, MockBehaviour *b) {
+    char *kind = strtok(spec, ":");
+    char *first = strtok(NULL, ":");
+    char *second = strtok(NULL, ":");
+
+    if (kind == NULL || first == NULL || parseDuration(first, &b->a) != 0) {
+        return -1;
+    }
+    if (strcmp(kind, "fixed") == 0) {
+        b->kind = LATENCY_FIXED;
+    } else if (strcmp(kind, "exp") == 0) {
+        b->kind = LATENCY_EXP;
+    } else if (strcmp(kind, "uniform") == 0 || strcmp(kind, "normal") == 0) {
+        if (second == NULL || parseDuration(second, &b->b) != 0) {
+            return -1;
+        }
+        b->kind = kind[0] == 'u' ? LATENCY_UNIFORM : LATENCY_NORMAL;
+        if (b->kind == LATENCY_UNIFORM && b->b < b->a) {
+            return -1;
+        }
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+static int parseFailure(char *spec, MockBehaviour *b) {
+    char *rate = strtok(spec, ":");
+    char *status = strtok(NULL, ":");
+    char *end;
+
+    b->failRate = strtod(rate, &end);
+    if (end == rate || *end != '\0' || b->failRate < 0 || b->failRate > 1) {
+        return -1;
+    }
+    b->failStatus = SUSI_STATUS_ERROR;
+    if (status != NULL) {
+        b->failStatus = (SusiStatus_t)strtoul(status, &end, 0);
+        if (end == status || *end != '\0') {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Applies "name=spec,name=spec" from an environment variable. "default" and
+// "*" address every call; later entries override earlier ones.
+static void applySpecList(const char *var, int (*parse)(char *, MockBehaviour *)) {
+    const char *env = getenv(var);
+    char *copy, *entry, *save = NULL;
+
+    if (env == NULL || *env == '\0') {
+        return;
+    }
+    copy = strdup(env);
+    if (copy == NULL) {
+        return;
+    }
+    for (entry = strtok_r(copy, ",", &save); entry != NULL; entry = strtok_r(NULL, ",", &save)) {
+        char *spec = strchr(entry, '=');
+        MockBehaviour parsed;
+        int matched = 0;
+
+        if (spec == NULL) {
+            fprintf(stderr, "susi_mock: ignoring %s entry \"%s\"\n", var, entry);
+            continue;
+        }
+        *spec++ = '\0';
+        for (int i = 0; i < MOCK_CALL_COUNT; i++) {
+            int all = strcmp(entry, "default") == 0 || strcmp(entry, "*") == 0;
+            char buffer[64];
+
+            if (!all && strcmp(entry, mockCallNames[i]) != 0) {
+                continue;
+            }
+            matched = 1;
+            snprintf(buffer, sizeof(buffer), "%s", spec);
+            parsed = behaviours[i];
+            if (parse(buffer, &parsed) != 0) {
+                fprintf(stderr, "susi_mock: invalid %s spec \"%s\"\n", var, spec);
+                break;
+            }
+            behaviours[i] = parsed;
+        }
+        if (!matched) {
+            fprintf(stderr, "susi_mock: %s names no known call \"%s\"\n", var, entry);
+        }
+    }
+    free(copy);
+}
+
+static void loadConfig(void) {
+    const char *env;
+
+    if ((env = getenv("SUSI_MOCK_SEED")) != NULL) {
+        seed = strtoull(env, NULL, 0);
+    }
+    if ((env = getenv("SUSI_MOCK_WATCHDOGS")) != NULL) {
+        watchdogCount = (uint32_t)strtoul(env, NULL, 10);
+        if (watchdogCount > SUSI_ID_WATCHDOG_MAX) {
+            watchdogCount = SUSI_ID_WATCHDOG_MAX;
+        }
+    }
+    if ((env = getenv("SUSI_MOCK_GPIO_IRQ")) != NULL) {
+        gpioIrqMs = (uint32_t)strtoul(env, NULL, 10);
+    }
+    if ((env = getenv("SUSI_MOCK_CPU_RAMP")) != NULL) {
+        cpuRamp = strtod(env, NULL);
+    }
+    applySpecList("SUSI_MOCK_LATENCY", parseLatency);
+    applySpecList("SUSI_MOCK_FAIL", parseFailure);
+    if ((env = getenv("SUSI_MOCK_REPLAY_LOOP")) != NULL) {
+        replayLoop = atoi(env) != 0;
+    }
+    if ((env = getenv("SUSI_MOCK_REPLAY")) != NULL && *env != '\0') {
+        loadReplay(env);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Latency and failure injection
+// ---------------------------------------------------------------------------
+
+// xorshift64*; each thread gets its own stream so injection never contends.
+static double nextUniform(void) {
+    if (rngState == 0) {
+        uint32_t stream = __atomic_add_fetch(&seedCounter, 1, __ATOMIC_RELAXED);
+        rngState = (seed ^ ((uint64_t)stream * 0x9E3779B97F4A7C15ull)) | 1;
+    }
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return (double)((rngState * 0x2545F4914F6CDD1Dull) >> 11) / 9007199254740992.0;
+}
+
+static double sampleLatency(const MockBehaviour *b) {
+    double u, v;
+
+    switch (b->kind) {
+    case LATENCY_FIXED:
+        return b->a;
+    case LATENCY_UNIFORM:
+        return b->a + (b->b - b->a) * nextUniform();
+    case LATENCY_NORMAL:
+        u = nextUniform();
+        v = nextUniform();
+        u = b->a + b->b * sqrt(-2.0 * log(u > 0 ? u : 1e-300)) * cos(2.0 * M_PI * v);
+        return u > 0 ? u : 0;
+    case LATENCY_EXP:
+        u = nextUniform();
+        return -b->a * log(u > 0 ? u : 1e-300);
+    default:
+        return 0;
+    }
+}
+
+static uint64_t nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Sleeps for long delays and spins for short ones, where the scheduler's
+// wake-up slack would otherwise dominate the injected value. Long sleeps
+// stop short by that slack and spin out the rest, so replayed durations
+// are not inflated by it.
+#define DELAY_SPIN_NS 200000
+
+static void injectDelay(double ns) {
+    uint64_t until;
+
+    if (ns <= 0) {
+        return;
+    }
+    until = nowNs() + (uint64_t)ns;
+    if (ns > DELAY_SPIN_NS) {
+        double sleepNs = ns - DELAY_SPIN_NS / 2;
+        struct timespec ts = { .tv_sec = (time_t)(sleepNs / 1e9), .tv_nsec = (long)fmod(sleepNs, 1e9) };
+        while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+        }
+    }
+    while (nowNs() < until) {
+    }
+}
+
+// Common prologue for every mocked call: delay, then decide whether this call
+// fails. Returns SUSI_STATUS_SUCCESS when the call should go ahead.
+static SusiStatus_t mockEnter(MockCall call) {
+    const MockBehaviour *b;
+
+    pthread_once(&configOnce, loadConfig);
+    b = &behaviours[call];
+    injectDelay(sampleLatency(b));
+    if (call != MOCK_SusiLibInitialize && !__atomic_load_n(&initialized, __ATOMIC_ACQUIRE)) {
+        return SUSI_STATUS_NOT_INITIALIZED;
+    }
+    if (b->failRate > 0 && nextUniform() < b->failRate) {
+        return b->failStatus;
+    }
+    return SUSI_STATUS_SUCCESS;
+}
+
+#define MOCK_ENTER(name) do { \
+        SusiStatus_t injected = mockEnter(MOCK_##name); \
+        if (injected != SUSI_STATUS_SUCCESS) { \
+            return injected; \
+        } \
+    } while (0)
+
+// ---------------------------------------------------------------------------
+// Replay of a recorded workload. Each call takes the next unused record of
+// the same function whose inputs match, returns its status and outputs and
+// waits as long as it took on the board; the board state above is left
+// alone. Calls the recording has no answer for run on the simulation. The
+// calls that register callbacks or (un)initialize always run on the
+// simulation too, so the library stays usable, but take the recorded time.
+// ---------------------------------------------------------------------------
+
+static int readFile(const char *path, uint8_t **data, size_t *length) {
+    FILE *file = fopen(path, "rb");
+    long size;
+
+    if (file == NULL) {
+        return -1;
+    }
+    if (fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        return -1;
+    }
+    *data = malloc(size > 0 ? (size_t)size : 1);
+    if (*data == NULL || fread(*data, 1, (size_t)size, file) != (size_t)size) {
+        free(*data);
+        fclose(file);
+        return -1;
+    }
+    fclose(file);
+    *length = (size_t)size;
+    return 0;
+}
+
+static void loadReplay(const char *path) {
+    const char *names[256];
+    int callOf[256];
+    int nameCount = 0;
+    SusiRecordCursor cursor;
+    SusiRecord record;
+    size_t length, start, total = 0;
+    uint32_t filled[MOCK_CALL_COUNT] = { 0 };
+    ReplayRecord *next;
+    int result;
+
+    if (readFile(path, &replayData, &length) != 0) {
+        fprintf(stderr, "susi_mock: cannot read replay %s: %s\n", path, strerror(errno));
+        return;
+    }
+    cursor = (SusiRecordCursor){ replayData, length, 0 };
+    if (!susiRecordReadHeader(&cursor, names, 256, &nameCount)) {
+        fprintf(stderr, "susi_mock: %s is not a SUSI call recording\n", path);
+        return;
+    }
+    // Recordings name their calls, so they survive a reordered call list
+    for (int i = 0; i < nameCount; i++) {
+        callOf[i] = -1;
+        for (int c = 0; c < MOCK_CALL_COUNT; c++) {
+            if (strcmp(names[i], mockCallNames[c]) == 0) {
+                callOf[i] = c;
+                break;
+            }
+        }
+    }
+
+    start = cursor.offset;
+    while ((result = susiRecordRead(&cursor, &record)) > 0) {
+        if (record.call < nameCount && callOf[record.call] >= 0) {
+            replayQueues[callOf[record.call]].count++;
+            total++;
+        }
+    }
+    if (result < 0) {
+        fprintf(stderr, "susi_mock: %s is cut short, replaying the calls before the cut\n", path);
+    }
+    replayRecords = calloc(total > 0 ? total : 1, sizeof(ReplayRecord));
+    if (replayRecords == NULL) {
+        fprintf(stderr, "susi_mock: no memory for replay %s\n", path);
+        return;
+    }
+    next = replayRecords;
+    for (int c = 0; c < MOCK_CALL_COUNT; c++) {
+        replayQueues[c].records = next;
+        next += replayQueues[c].count;
+    }
+    cursor.offset = start;
+    while (susiRecordRead(&cursor, &record) > 0) {
+        if (record.call < nameCount && callOf[record.call] >= 0) {
+            int c = callOf[record.call];
+
+            replayQueues[c].records[filled[c]++].record = record;
+        }
+    }
+    replayPath = path;
+    replaying = 1;
+    fprintf(stderr, "susi_mock: replaying %zu SUSI calls from %s\n", total, path);
+}
+
+// Never replayed for their result, see above
+static int alwaysSimulated(MockCall call) {
+    return call == MOCK_SusiLibInitialize || call == MOCK_SusiLibUninitialize ||
+           call == MOCK_SusiGPIOIntRegister || call == MOCK_SusiGPIOIntUnRegister ||
+           call == MOCK_SusiWDogSetCallBack;
+}
+
+static int replayFind(MockCall call, const SusiRecordStream *inputs, SusiRecord *found) {
+    ReplayQueue *queue = &replayQueues[call];
+    uint32_t end, match = 0;
+    int hit = 0;
+
+    pthread_mutex_lock(&replayLock);
+    if (queue->cursor == queue->count && replayLoop) {
+        for (uint32_t i = 0; i < queue->count; i++) {
+            queue->records[i].used = 0;
+        }
+        queue->cursor = 0;
+    }
+    end = queue->count - queue->cursor > REPLAY_WINDOW ? queue->cursor + REPLAY_WINDOW : queue->count;
+    for (uint32_t i = queue->cursor; i < end; i++) {
+        const SusiRecord *record = &queue->records[i].record;
+
+        if (!queue->records[i].used && record->inputLength == inputs->length &&
+            memcmp(record->input, inputs->data, inputs->length) == 0) {
+            match = i;
+            hit = 1;
+            break;
+        }
+    }
+    if (hit) {
+        uint32_t floor = match > REPLAY_BEHIND ? match - REPLAY_BEHIND : 0;
+
+        queue->records[match].used = 1;
+        *found = queue->records[match].record;
+        // Calls the recorded program made and this one does not
+        for (; queue->cursor < floor; queue->cursor++) {
+            if (!queue->records[queue->cursor].used) {
+                queue->records[queue->cursor].used = 1;
+                replaySkipped++;
+            }
+        }
+        while (queue->cursor < queue->count && queue->records[queue->cursor].used) {
+            queue->cursor++;
+        }
+        replayHits++;
+    } else {
+        replayMisses++;
+    }
+    pthread_mutex_unlock(&replayLock);
+    return hit;
+}
+
+static void replayTakeBytes(SusiRecordCursor *cursor, void *out, size_t capacity) {
+    const uint8_t *bytes;
+    size_t length;
+
+    if (susiRecordGetBytes(cursor, &bytes, &length) && out != NULL) {
+        memcpy(out, bytes, length < capacity ? length : capacity);
+    }
+}
+
+static void replayTakeString(SusiRecordCursor *cursor, char *out, size_t capacity) {
+    const uint8_t *bytes;
+    size_t length;
+
+    if (susiRecordGetBytes(cursor, &bytes, &length) && out != NULL && length > 0 && capacity > 0) {
+        if (length > capacity) {
+            length = capacity;
+        }
+        memcpy(out, bytes, length);
+        out[length - 1] = '\0';
+    }
+}
+
+__attribute__((destructor))
+static void replaySummary(void) {
+    uint64_t unused = 0;
+
+    if (!replaying) {
+        return;
+    }
+    for (int c = 0; c < MOCK_CALL_COUNT; c++) {
+        for (uint32_t i = 0; i < replayQueues[c].count; i++) {
+            unused += !replayQueues[c].records[i].used;
+        }
+    }
+    fprintf(stderr, "susi_mock: %s: %llu calls replayed, %llu not in the recording simulated, "
+            "%llu recorded calls never made\n", replayPath, (unsigned long long)replayHits,
+            (unsigned long long)replayMisses, (unsigned long long)(replaySkipped + unused));
+}
+
+// ---------------------------------------------------------------------------
+// Library
+// ---------------------------------------------------------------------------
+
+static SusiStatus_t simulateSusiLibInitialize(void) {
+    MOCK_ENTER(SusiLibInitialize);
+    pthread_mutex_lock(&stateLock);
+    if (initialized) {
+        pthread_mutex_unlock(&stateLock);
+        return SUSI_STATUS_INITIALIZED;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &initTime);
+    bootCounter++;
+    for (int i = 0; i < MOCK_FANS; i++) {
+        fanConfigs[i].Mode = SUSI_FAN_CTRL_MODE_AUTO;
+        fanConfigs[i].PWM = 50;
+    }
+    for (int i = 0; i < MOCK_THERMALS; i++) {
+        thermalConfigs[i].SourceId = SUSI_ID_HWM_TEMP_CPU;
+        thermalConfigs[i].EventType = SUSI_THERMAL_EVENT_NONE;
+    }
+    __atomic_store_n(&initialized, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiLibUninitialize(void) {
+    MOCK_ENTER(SusiLibUninitialize);
+    __atomic_store_n(&initialized, 0, __ATOMIC_RELEASE);
+    return SUSI_STATUS_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+// Board information and raw access
+// ---------------------------------------------------------------------------
+
+// Adds up to +/-1% of noise so samplers see values that actually move.
+static uint32_t jitter(uint32_t value) {
+    return (uint32_t)(value * (0.99 + 0.02 * nextUniform()));
+}
+
+// 50 C, climbing by cpuRamp per second since initialization and starting
+// over from 50 C after 50 degrees
+static uint32_t cpuTemperature(void) {
+    struct timespec now;
+    double seconds;
+
+    if (cpuRamp <= 0) {
+        return jitter(3231);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    seconds = (double)(now.tv_sec - initTime.tv_sec) + (now.tv_nsec - initTime.tv_nsec) / 1e9;
+    return 3231 + (uint32_t)fmod(seconds * cpuRamp * 10.0, 500.0) + (uint32_t)(3 * nextUniform());
+}
+
+static SusiStatus_t simulateSusiBoardGetValue(SusiId_t Id, uint32_t *pValue) {
+    struct timespec now;
+
+    MOCK_ENTER(SusiBoardGetValue);
+    if (pValue == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    switch (Id) {
+    case SUSI_ID_GET_SPEC_VERSION:               *pValue = 0x04000000; break;
+    case SUSI_ID_BOARD_BOOT_COUNTER_VAL:         *pValue = bootCounter; break;
+    case SUSI_ID_BOARD_RUNNING_TIME_METER_VAL:
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        *pValue = (uint32_t)((now.tv_sec - initTime.tv_sec) / 60);
+        break;
+    case SUSI_ID_BOARD_PNPID_VAL:                *pValue = 0x0D9C; break;
+    case SUSI_ID_BOARD_PLATFORM_REV_VAL:         *pValue = 0x0100; break;
+    case SUSI_ID_BOARD_DRIVER_VERSION_VAL:       *pValue = 0x04025CBB; break;
+    case SUSI_ID_BOARD_LIB_VERSION_VAL:          *pValue = 0x04025CBB; break;
+    case SUSI_ID_BOARD_FIRMWARE_VERSION_VAL:     *pValue = 0x01000000; break;
+    case SUSI_ID_BOARD_BUZZER_ONOFF_VAL:         *pValue = buzzer; break;
+    case SUSI_ID_BOARD_BUZZER_FREQUENCY_VAL:     *pValue = buzzerFrequency; break;
+    case SUSI_ID_BOARD_RTC_S5_WAKE_VAL:          *pValue = rtcWake; break;
+    case SUSI_ID_HWM_TEMP_CPU:                   *pValue = cpuTemperature(); break;
+    case SUSI_ID_HWM_TEMP_CHIPSET:               *pValue = jitter(3181); break;
+    case SUSI_ID_HWM_TEMP_SYSTEM:                *pValue = jitter(3061); break;
+    case SUSI_ID_HWM_VOLTAGE_VCORE:              *pValue = jitter(1100); break;
+    case SUSI_ID_HWM_VOLTAGE_3V3:                *pValue = jitter(3300); break;
+    case SUSI_ID_HWM_VOLTAGE_5V:                 *pValue = jitter(5000); break;
+    case SUSI_ID_HWM_VOLTAGE_12V:                *pValue = jitter(12000); break;
+    case SUSI_ID_HWM_VOLTAGE_VBAT:               *pValue = jitter(3000); break;
+    case SUSI_ID_HWM_FAN_CPU:                    *pValue = jitter(2400); break;
+    case SUSI_ID_HWM_FAN_SYSTEM:                 *pValue = jitter(1800); break;
+    case SUSI_ID_SMBUS_SUPPORTED:                *pValue = (1u << MOCK_BUSES) - 1; break;
+    case SUSI_ID_I2C_SUPPORTED:                  *pValue = (1u << MOCK_BUSES) - 1; break;
+    default:
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiBoardSetValue(SusiId_t Id, uint32_t pValue) {
+    MOCK_ENTER(SusiBoardSetValue);
+    switch (Id) {
+    case SUSI_ID_BOARD_BUZZER_ONOFF_VAL:     buzzer = pValue; break;
+    case SUSI_ID_BOARD_BUZZER_FREQUENCY_VAL: buzzerFrequency = pValue; break;
+    case SUSI_ID_BOARD_RTC_S5_WAKE_VAL:      rtcWake = pValue; break;
+    default:
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    return SUSI_STATUS_SUCCESS;
+}
+
+// Labels the EC reports for the sensors SusiBoardGetValue answers
+static const char* hwmName(SusiId_t Id) {
+    switch (Id) {
+    case SUSI_ID_HWM_TEMP_CPU:      return "CPU";
+    case SUSI_ID_HWM_TEMP_CHIPSET:  return "Chipset";
+    case SUSI_ID_HWM_TEMP_SYSTEM:   return "System";
+    case SUSI_ID_HWM_VOLTAGE_VCORE: return "Vcore";
+    case SUSI_ID_HWM_VOLTAGE_3V3:   return "3.3V";
+    case SUSI_ID_HWM_VOLTAGE_5V:    return "5V";
+    case SUSI_ID_HWM_VOLTAGE_12V:   return "12V";
+    case SUSI_ID_HWM_VOLTAGE_VBAT:  return "VBAT";
+    case SUSI_ID_HWM_FAN_CPU:       return "CPU";
+    case SUSI_ID_HWM_FAN_SYSTEM:    return "System";
+    default:                        return NULL;
+    }
+}
+
+static SusiStatus_t simulateSusiBoardGetStringA(SusiId_t Id, char *pBuffer, uint32_t *pBufLen) {
+    static const char *strings[] = {
+        [SUSI_ID_BOARD_MANUFACTURER_STR]  = "Advantech (mock)",
+        [SUSI_ID_BOARD_NAME_STR]          = "SUSI-MOCK",
+        [SUSI_ID_BOARD_REVISION_STR]      = "A1",
+        [SUSI_ID_BOARD_SERIAL_STR]        = "MOCK0000000001",
+        [SUSI_ID_BOARD_BIOS_REVISION_STR] = "V1.00",
+        [SUSI_ID_BOARD_HW_REVISION_STR]   = "A1",
+        [SUSI_ID_BOARD_PLATFORM_TYPE_STR] = "MOCK",
+        [SUSI_ID_BOARD_EC_FW_STR]         = "EC-MOCK",
+        [SUSI_ID_BOARD_BIOS_FW_STR]       = "BIOS-MOCK",
+    };
+    const char *value;
+    uint32_t needed;
+
+    MOCK_ENTER(SusiBoardGetStringA);
+    if (pBufLen == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    if (hwmName(Id) != NULL) {
+        value = hwmName(Id);
+    } else if (Id < sizeof(strings) / sizeof(strings[0])) {
+        value = strings[Id];
+    } else {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    needed = (uint32_t)strlen(value) + 1;
+    if (pBuffer == NULL || *pBufLen < needed) {
+        *pBufLen = needed;
+        return SUSI_STATUS_MORE_DATA;
+    }
+    memcpy(pBuffer, value, needed);
+    *pBufLen = needed;
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiBoardReadIO(uint16_t Port, uint32_t *pValue, uint32_t Length) {
+    (void)Port;
+    MOCK_ENTER(SusiBoardReadIO);
+    if (pValue == NULL || (Length != 1 && Length != 2 && Length != 4)) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    *pValue = Length == 4 ? 0xffffffffu : (1u << (Length * 8)) - 1;   // floating bus
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiBoardWriteIO(uint16_t Port, uint32_t Value, uint32_t Length) {
+    (void)Port;
+    (void)Value;
+    MOCK_ENTER(SusiBoardWriteIO);
+    return Length == 1 || Length == 2 || Length == 4 ? SUSI_STATUS_SUCCESS : SUSI_STATUS_INVALID_PARAMETER;
+}
+
+static SusiStatus_t simulateSusiBoardSetPWRCycle(uint32_t Delaytime, uint8_t Eventype) {
+    MOCK_ENTER(SusiBoardSetPWRCycle);
+    pwrDelay = Delaytime;
+    pwrEvent = Eventype;
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiBoardGetPWRCycle(uint32_t *Delaytime, uint8_t *Eventype) {
+    MOCK_ENTER(SusiBoardGetPWRCycle);
+    if (Delaytime == NULL || Eventype == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    *Delaytime = pwrDelay;
+    *Eventype = pwrEvent;
+    return SUSI_STATUS_SUCCESS;
+}
+
+// A small PCI tree: host bridge, graphics, a root port with an Ethernet
+// controller behind it, and a multi-function LPC/SMBus device
+typedef struct {
+    uint8_t bus, device, function;
+    uint16_t vendor, deviceId;
+    uint32_t classCode;      // class << 16 | subclass << 8 | programming interface
+    uint8_t headerType;      // Bit 7: multi-function
+    uint8_t secondaryBus;    // Bridges only
+    int express;
+} MockPciFunction;
+
+static const MockPciFunction mockPci[] = {
+    { 0, 0x00, 0, 0x8086, 0x3e0f, 0x060000, 0x00, 0, 0 },
+    { 0, 0x02, 0, 0x8086, 0x3e92, 0x030000, 0x00, 0, 1 },
+    { 0, 0x1c, 0, 0x8086, 0xa338, 0x060400, 0x01, 1, 1 },
+    { 0, 0x1f, 0, 0x8086, 0xa30e, 0x060100, 0x80, 0, 0 },
+    { 0, 0x1f, 4, 0x8086, 0xa323, 0x0c0500, 0x00, 0, 0 },
+    { 1, 0x00, 0, 0x8086, 0x1533, 0x020000, 0x00, 0, 1 },
+};
+
+// One capability at 0x40 (PCI Express or power management) and, past 0x100,
+// an empty extended capability header on PCI Express functions
+static void mockPciConfig(const MockPciFunction *f, uint8_t *config) {
+    memset(config, 0, 4096);
+    config[0x00] = (uint8_t)f->vendor;
+    config[0x01] = (uint8_t)(f->vendor >> 8);
+    config[0x02] = (uint8_t)f->deviceId;
+    config[0x03] = (uint8_t)(f->deviceId >> 8);
+    config[0x04] = 0x07;                 // I/O, memory, bus master
+    config[0x06] = 0x10;                 // Capability list
+    config[0x08] = 0x10;
+    config[0x09] = (uint8_t)f->classCode;
+    config[0x0a] = (uint8_t)(f->classCode >> 8);
+    config[0x0b] = (uint8_t)(f->classCode >> 16);
+    config[0x0e] = f->headerType;
+    if ((f->headerType & 0x7f) == 1) {
+        config[0x18] = f->bus;
+        config[0x19] = f->secondaryBus;
+        config[0x1a] = f->secondaryBus;
+    } else {
+        config[0x2c] = (uint8_t)f->vendor;
+        config[0x2d] = (uint8_t)(f->vendor >> 8);
+        config[0x2e] = 0x01;
+    }
+    config[0x34] = 0x40;
+    config[0x40] = f->express ? 0x10 : 0x01;
+    if (!f->express) {
+        memset(config + 0x100, 0xff, 4096 - 0x100);
+    }
+}
+
+static SusiStatus_t simulateSusiBoardReadPCI(uint8_t Bus, uint8_t Device, uint8_t Function, uint32_t Offset,
+                                             uint8_t *pData, uint32_t Length) {
+    uint8_t config[4096];
+    MOCK_ENTER(SusiBoardReadPCI);
+    if (pData == NULL || Offset + (uint64_t)Length > sizeof(config)) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    for (size_t i = 0; i < sizeof(mockPci) / sizeof(mockPci[0]); i++) {
+        const MockPciFunction *f = &mockPci[i];
+
+        if (f->bus == Bus && f->device == Device && f->function == Function) {
+            mockPciConfig(f, config);
+            memcpy(pData, config + Offset, Length);
+            return SUSI_STATUS_SUCCESS;
+        }
+    }
+    memset(pData, 0xff, Length);   // no device present
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiBoardWritePCI(uint8_t Bus, uint8_t Device, uint8_t Function, uint32_t Offset,
+                                              uint8_t *pData, uint32_t Length) {
+    (void)Bus; (void)Device; (void)Function; (void)Offset; (void)Length;
+    MOCK_ENTER(SusiBoardWritePCI);
+    return pData == NULL ? SUSI_STATUS_INVALID_PARAMETER : SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiBoardReadMemory(uint32_t Address, uint8_t *pData, uint32_t Length) {
+    (void)Address;
+    MOCK_ENTER(SusiBoardReadMemory);
+    if (pData == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    memset(pData, 0, Length);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiBoardWriteMemory(uint32_t Address, uint8_t *pData, uint32_t Length) {
+    (void)Address; (void)Length;
+    MOCK_ENTER(SusiBoardWriteMemory);
+    return pData == NULL ? SUSI_STATUS_INVALID_PARAMETER : SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiBoardReadMSR(uint32_t index, uint32_t *EAX_reg, uint32_t *EDX_reg) {
+    (void)index;
+    MOCK_ENTER(SusiBoardReadMSR);
+    if (EAX_reg == NULL || EDX_reg == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    *EAX_reg = 0;
+    *EDX_reg = 0;
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiBoardWriteMSR(uint32_t index, uint32_t EAX_reg, uint32_t EDX_reg) {
+    (void)index; (void)EAX_reg; (void)EDX_reg;
+    MOCK_ENTER(SusiBoardWriteMSR);
+    return SUSI_STATUS_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+// SMBus and I2C: each bus has a fixed set of responding 7-bit addresses
+// backed by 256 bytes of register memory.
+// ---------------------------------------------------------------------------
+
+static int devicePresent(SusiId_t bus, uint32_t encoded) {
+    static const uint8_t present[] = MOCK_I2C_DEVICES;
+    uint8_t address = (uint8_t)((encoded >> 1) & 0x7f);
+
+    if (bus >= MOCK_BUSES) {
+        return 0;
+    }
+    for (size_t i = 0; i < sizeof(present); i++) {
+        if (present[i] == address) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#define CHECK_DEVICE(bus, addr) do { \
+        if ((bus) >= MOCK_BUSES) { \
+            return SUSI_STATUS_UNSUPPORTED; \
+        } \
+        if (!devicePresent((bus), (addr))) { \
+            return SUSI_STATUS_NOACK; \
+        } \
+    } while (0)
+
+static uint8_t *smbRegisters(SusiId_t bus, uint8_t addr) {
+    return smbMemory[bus][(addr >> 1) & 0x7f];
+}
+
+static uint8_t *i2cRegisters(SusiId_t bus, uint32_t addr) {
+    return i2cMemory[bus][(addr >> 1) & 0x7f];
+}
+
+// Register accesses that wrap past 0xff continue from 0, like a small EEPROM.
+static void copyIn(uint8_t *regs, uint32_t offset, const uint8_t *data, uint32_t length) {
+    for (uint32_t i = 0; i < length; i++) {
+        regs[(offset + i) & 0xff] = data[i];
+    }
+}
+
+static void copyOut(const uint8_t *regs, uint32_t offset, uint8_t *data, uint32_t length) {
+    for (uint32_t i = 0; i < length; i++) {
+        data[i] = regs[(offset + i) & 0xff];
+    }
+}
+
+static SusiStatus_t simulateSusiSMBReadByte(SusiId_t Id, uint8_t Addr, uint8_t Cmd, uint8_t *pBuffer) {
+    MOCK_ENTER(SusiSMBReadByte);
+    if (pBuffer == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    CHECK_DEVICE(Id, Addr);
+    pthread_mutex_lock(&stateLock);
+    *pBuffer = smbRegisters(Id, Addr)[Cmd];
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiSMBWriteByte(SusiId_t Id, uint8_t Addr, uint8_t Cmd, uint8_t Data) {
+    MOCK_ENTER(SusiSMBWriteByte);
+    CHECK_DEVICE(Id, Addr);
+    pthread_mutex_lock(&stateLock);
+    smbRegisters(Id, Addr)[Cmd] = Data;
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiSMBReadWord(SusiId_t Id, uint8_t Addr, uint8_t Cmd, uint16_t *pBuffer) {
+    uint8_t bytes[2];
+
+    MOCK_ENTER(SusiSMBReadWord);
+    if (pBuffer == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    CHECK_DEVICE(Id, Addr);
+    pthread_mutex_lock(&stateLock);
+    copyOut(smbRegisters(Id, Addr), Cmd, bytes, 2);
+    pthread_mutex_unlock(&stateLock);
+    *pBuffer = (uint16_t)(bytes[0] | (bytes[1] << 8));
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiSMBWriteWord(SusiId_t Id, uint8_t Addr, uint8_t Cmd, uint16_t Data) {
+    uint8_t bytes[2] = { (uint8_t)(Data & 0xff), (uint8_t)(Data >> 8) };
+
+    MOCK_ENTER(SusiSMBWriteWord);
+    CHECK_DEVICE(Id, Addr);
+    pthread_mutex_lock(&stateLock);
+    copyIn(smbRegisters(Id, Addr), Cmd, bytes, 2);
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiSMBReceiveByte(SusiId_t Id, uint8_t Addr, uint8_t *pData) {
+    MOCK_ENTER(SusiSMBReceiveByte);
+    if (pData == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    CHECK_DEVICE(Id, Addr);
+    pthread_mutex_lock(&stateLock);
+    *pData = smbRegisters(Id, Addr)[0];
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiSMBSendByte(SusiId_t Id, uint8_t Addr, uint8_t Data) {
+    MOCK_ENTER(SusiSMBSendByte);
+    CHECK_DEVICE(Id, Addr);
+    pthread_mutex_lock(&stateLock);
+    smbRegisters(Id, Addr)[0] = Data;
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiSMBReadQuick(SusiId_t Id, uint8_t Addr) {
+    MOCK_ENTER(SusiSMBReadQuick);
+    CHECK_DEVICE(Id, Addr);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiSMBWriteQuick(SusiId_t Id, uint8_t Addr) {
+    MOCK_ENTER(SusiSMBWriteQuick);
+    CHECK_DEVICE(Id, Addr);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiSMBReadBlock(SusiId_t Id, uint8_t Addr, uint8_t Cmd, uint8_t *pBuffer, uint32_t *pLength) {
+    MOCK_ENTER(SusiSMBReadBlock);
+    if (pBuffer == NULL || pLength == NULL || *pLength > 32) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    CHECK_DEVICE(Id, Addr);
+    pthread_mutex_lock(&stateLock);
+    copyOut(smbRegisters(Id, Addr), Cmd, pBuffer, *pLength);
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiSMBWriteBlock(SusiId_t Id, uint8_t Addr, uint8_t Cmd, uint8_t *pBuffer, uint32_t Length) {
+    MOCK_ENTER(SusiSMBWriteBlock);
+    if (pBuffer == NULL || Length > 32) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    CHECK_DEVICE(Id, Addr);
+    pthread_mutex_lock(&stateLock);
+    copyIn(smbRegisters(Id, Addr), Cmd, pBuffer, Length);
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiSMBI2CReadBlock(SusiId_t Id, uint8_t Addr, uint8_t Cmd, uint8_t *pBuffer, uint32_t Length) {
+    MOCK_ENTER(SusiSMBI2CReadBlock);
+    if (pBuffer == NULL || Length > 32) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    CHECK_DEVICE(Id, Addr);
+    pthread_mutex_lock(&stateLock);
+    copyOut(smbRegisters(Id, Addr), Cmd, pBuffer, Length);
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiSMBI2CWriteBlock(SusiId_t Id, uint8_t Addr, uint8_t Cmd, uint8_t *pBuffer, uint32_t Length) {
+    MOCK_ENTER(SusiSMBI2CWriteBlock);
+    if (pBuffer == NULL || Length > 32) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    CHECK_DEVICE(Id, Addr);
+    pthread_mutex_lock(&stateLock);
+    copyIn(smbRegisters(Id, Addr), Cmd, pBuffer, Length);
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+// A combined transfer treats the first written byte as the register pointer,
+// which is how EEPROM-style devices behave.
+static SusiStatus_t simulateSusiI2CWriteReadCombine(SusiId_t Id, uint8_t Addr, uint8_t *pWBuffer, uint32_t WriteLen,
+                                                    uint8_t *pRBuffer, uint32_t ReadLen) {
+    uint8_t *regs, *pointer;
+
+    MOCK_ENTER(SusiI2CWriteReadCombine);
+    if ((WriteLen > 0 && pWBuffer == NULL) || (ReadLen > 0 && pRBuffer == NULL)) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    CHECK_DEVICE(Id, Addr);
+    pthread_mutex_lock(&stateLock);
+    regs = i2cRegisters(Id, Addr);
+    pointer = &i2cPointer[Id][(Addr >> 1) & 0x7f];
+    if (WriteLen > 0) {
+        *pointer = pWBuffer[0];
+        copyIn(regs, *pointer, pWBuffer + 1, WriteLen - 1);
+        *pointer = (uint8_t)(*pointer + WriteLen - 1);
+        if (ReadLen > 0) {
+            *pointer = pWBuffer[0];
+        }
+    }
+    copyOut(regs, *pointer, pRBuffer, ReadLen);
+    *pointer = (uint8_t)(*pointer + ReadLen);
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiI2CReadTransfer(SusiId_t Id, uint32_t Addr, uint32_t Cmd, uint8_t *pBuffer, uint32_t ReadLen) {
+    MOCK_ENTER(SusiI2CReadTransfer);
+    if (pBuffer == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    CHECK_DEVICE(Id, Addr);
+    pthread_mutex_lock(&stateLock);
+    copyOut(i2cRegisters(Id, Addr), Cmd & 0xff, pBuffer, ReadLen);
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiI2CWriteTransfer(SusiId_t Id, uint32_t Addr, uint32_t Cmd, uint8_t *pBuffer, uint32_t ByteCnt) {
+    MOCK_ENTER(SusiI2CWriteTransfer);
+    if (pBuffer == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    CHECK_DEVICE(Id, Addr);
+    pthread_mutex_lock(&stateLock);
+    copyIn(i2cRegisters(Id, Addr), Cmd & 0xff, pBuffer, ByteCnt);
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiI2CProbeDevice(SusiId_t Id, uint32_t Addr) {
+    MOCK_ENTER(SusiI2CProbeDevice);
+    CHECK_DEVICE(Id, Addr);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiI2CGetFrequency(SusiId_t Id, uint32_t *pFreq) {
+    MOCK_ENTER(SusiI2CGetFrequency);
+    if (pFreq == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    if (Id >= MOCK_BUSES) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    *pFreq = i2cFrequency[Id];
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiI2CSetFrequency(SusiId_t Id, uint32_t Freq) {
+    MOCK_ENTER(SusiI2CSetFrequency);
+    if (Id >= MOCK_BUSES) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    if (Freq == 0 || Freq > 400) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    i2cFrequency[Id] = Freq;
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiI2CGetCaps(SusiId_t Id, uint32_t ItemId, uint32_t *pValue) {
+    MOCK_ENTER(SusiI2CGetCaps);
+    if (pValue == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    if (Id >= MOCK_BUSES || ItemId != SUSI_ID_I2C_MAXIMUM_BLOCK_LENGTH) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    *pValue = 256;
+    return SUSI_STATUS_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+// GPIO: one bank of MOCK_GPIO_PINS pins. Output pins read back what was
+// written; input pins read low unless SUSI_MOCK_GPIO_IRQ toggles them.
+// ---------------------------------------------------------------------------
+
+static SusiStatus_t gpioMask(SusiId_t Id, uint32_t Bitmask, uint32_t *mask) {
+    uint32_t all = (1u << MOCK_GPIO_PINS) - 1;
+
+    if (Id == SUSI_ID_GPIO_BANK(0)) {
+        if (Bitmask == 0 || (Bitmask & ~all) != 0) {
+            return SUSI_STATUS_INVALID_BITMASK;
+        }
+        *mask = Bitmask;
+        return SUSI_STATUS_SUCCESS;
+    }
+    if (Id < MOCK_GPIO_PINS) {
+        *mask = 1u << Id;
+        return SUSI_STATUS_SUCCESS;
+    }
+    return SUSI_STATUS_UNSUPPORTED;
+}
+
+// Converts between the bank-wide register value and the per-call value: bank
+// IDs use bit positions, single pin IDs use 0/1.
+static uint32_t gpioExtract(SusiId_t Id, uint32_t reg, uint32_t mask) {
+    return Id == SUSI_ID_GPIO_BANK(0) ? (reg & mask) : ((reg & mask) != 0);
+}
+
+static uint32_t gpioMerge(SusiId_t Id, uint32_t reg, uint32_t mask, uint32_t value) {
+    if (Id != SUSI_ID_GPIO_BANK(0)) {
+        value = value ? mask : 0;
+    }
+    return (reg & ~mask) | (value & mask);
+}
+
+static SusiStatus_t simulateSusiGPIOGetCaps(SusiId_t Id, uint32_t ItemId, uint32_t *pValue) {
+    uint32_t mask;
+    SusiStatus_t status;
+
+    MOCK_ENTER(SusiGPIOGetCaps);
+    if (pValue == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    if ((status = gpioMask(Id, (1u << MOCK_GPIO_PINS) - 1, &mask)) != SUSI_STATUS_SUCCESS) {
+        return status;
+    }
+    switch (ItemId) {
+    case SUSI_ID_GPIO_INPUT_SUPPORT:
+    case SUSI_ID_GPIO_OUTPUT_SUPPORT:
+    case SUSI_ID_GPIO_INTERRUPT_SUPPORT:
+        *pValue = gpioExtract(Id, mask, mask);
+        return SUSI_STATUS_SUCCESS;
+    default:
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+}
+
+#define GPIO_GET(name, reg, out) do { \
+        uint32_t mask; \
+        SusiStatus_t status; \
+        MOCK_ENTER(name); \
+        if ((out) == NULL) { \
+            return SUSI_STATUS_INVALID_PARAMETER; \
+        } \
+        if ((status = gpioMask(Id, Bitmask, &mask)) != SUSI_STATUS_SUCCESS) { \
+            return status; \
+        } \
+        pthread_mutex_lock(&stateLock); \
+        *(out) = gpioExtract(Id, (reg), mask); \
+        pthread_mutex_unlock(&stateLock); \
+        return SUSI_STATUS_SUCCESS; \
+    } while (0)
+
+#define GPIO_SET(name, reg, value) do { \
+        uint32_t mask; \
+        SusiStatus_t status; \
+        MOCK_ENTER(name); \
+        if ((status = gpioMask(Id, Bitmask, &mask)) != SUSI_STATUS_SUCCESS) { \
+            return status; \
+        } \
+        pthread_mutex_lock(&stateLock); \
+        (reg) = gpioMerge(Id, (reg), mask, (value)); \
+        pthread_mutex_unlock(&stateLock); \
+        return SUSI_STATUS_SUCCESS; \
+    } while (0)
+
+static SusiStatus_t simulateSusiGPIOGetDirection(SusiId_t Id, uint32_t Bitmask, uint32_t *pDirection) {
+    GPIO_GET(SusiGPIOGetDirection, gpioDirection, pDirection);
+}
+
+static SusiStatus_t simulateSusiGPIOSetDirection(SusiId_t Id, uint32_t Bitmask, uint32_t Direction) {
+    GPIO_SET(SusiGPIOSetDirection, gpioDirection, Direction);
+}
+
+static SusiStatus_t simulateSusiGPIOGetLevel(SusiId_t Id, uint32_t Bitmask, uint32_t *pLevel) {
+    GPIO_GET(SusiGPIOGetLevel, gpioLevel & ~gpioDirection, pLevel);
+}
+
+static SusiStatus_t simulateSusiGPIOSetLevel(SusiId_t Id, uint32_t Bitmask, uint32_t Level) {
+    uint32_t mask;
+    SusiStatus_t status;
+
+    MOCK_ENTER(SusiGPIOSetLevel);
+    if ((status = gpioMask(Id, Bitmask, &mask)) != SUSI_STATUS_SUCCESS) {
+        return status;
+    }
+    pthread_mutex_lock(&stateLock);
+    if ((gpioDirection & mask) != 0) {
+        pthread_mutex_unlock(&stateLock);
+        return SUSI_STATUS_INVALID_DIRECTION;
+    }
+    gpioLevel = gpioMerge(Id, gpioLevel, mask, Level);
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiGPIOIntGetEdge(SusiId_t Id, uint32_t Bitmask, uint32_t *pEdge) {
+    GPIO_GET(SusiGPIOIntGetEdge, gpioEdge, pEdge);
+}
+
+static SusiStatus_t simulateSusiGPIOIntSetEdge(SusiId_t Id, uint32_t Bitmask, uint32_t edge) {
+    GPIO_SET(SusiGPIOIntSetEdge, gpioEdge, edge);
+}
+
+static SusiStatus_t simulateSusiGPIOIntGetPin(SusiId_t Id, uint32_t Bitmask, uint32_t *pPin) {
+    GPIO_GET(SusiGPIOIntGetPin, gpioIntPin, pPin);
+}
+
+static SusiStatus_t simulateSusiGPIOIntSetPin(SusiId_t Id, uint32_t Bitmask, uint32_t pin) {
+    GPIO_SET(SusiGPIOIntSetPin, gpioIntPin, pin);
+}
+
+// With SUSI_MOCK_GPIO_IRQ set, input pins with interrupts enabled toggle
+// every that many ms, and each edge matching the pin's configured edge
+// (1 = rising) calls the callback with the pin number, from one thread like
+// the driver's interrupt thread.
+static void* gpioIrqThreadMain(void *arg);
+
+static void gpioIrqStart(void) {
+    pthread_t thread;
+
+    if (pthread_create(&thread, NULL, gpioIrqThreadMain, NULL) == 0) {
+        pthread_detach(thread);
+    }
+}
+
+static void* gpioIrqThreadMain(void *arg) {
+    struct timespec delay = { gpioIrqMs / 1000, (long)(gpioIrqMs % 1000) * 1000000L };
+    (void)arg;
+
+    for (;;) {
+        SUSI_INT_CALLBACK callback;
+        uint32_t fired = 0;
+
+        nanosleep(&delay, NULL);
+        pthread_mutex_lock(&stateLock);
+        callback = gpioCallback;
+        for (uint32_t pin = 0; callback && pin < MOCK_GPIO_PINS; pin++) {
+            uint32_t bit = 1u << pin;
+
+            if ((gpioIntPin & gpioDirection & bit) == 0) {
+                continue;
+            }
+            gpioLevel ^= bit;
+            if (((gpioLevel & bit) != 0) == ((gpioEdge & bit) != 0)) {
+                fired |= bit;
+            }
+        }
+        pthread_mutex_unlock(&stateLock);
+        for (uint32_t pin = 0; fired && pin < MOCK_GPIO_PINS; pin++) {
+            if (fired & (1u << pin)) {
+                callback((void *)(uintptr_t)pin);
+            }
+        }
+    }
+    return NULL;
+}
+
+static SusiStatus_t simulateSusiGPIOIntRegister(SUSI_INT_CALLBACK pfnCallback) {
+    static pthread_once_t irqOnce = PTHREAD_ONCE_INIT;
+
+    MOCK_ENTER(SusiGPIOIntRegister);
+    if (pfnCallback == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    pthread_mutex_lock(&stateLock);
+    gpioCallback = pfnCallback;
+    pthread_mutex_unlock(&stateLock);
+    if (gpioIrqMs > 0) {
+        pthread_once(&irqOnce, gpioIrqStart);
+    }
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiGPIOIntUnRegister(void) {
+    MOCK_ENTER(SusiGPIOIntUnRegister);
+    pthread_mutex_lock(&stateLock);
+    gpioCallback = NULL;
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+// Backlight
+// ---------------------------------------------------------------------------
+
+#define BACKLIGHT_GET(name, table, out) do { \
+        MOCK_ENTER(name); \
+        if ((out) == NULL) { \
+            return SUSI_STATUS_INVALID_PARAMETER; \
+        } \
+        if (Id >= MOCK_BACKLIGHTS) { \
+            return SUSI_STATUS_UNSUPPORTED; \
+        } \
+        *(out) = (table)[Id]; \
+        return SUSI_STATUS_SUCCESS; \
+    } while (0)
+
+#define BACKLIGHT_SET(name, table, value, max) do { \
+        MOCK_ENTER(name); \
+        if (Id >= MOCK_BACKLIGHTS) { \
+            return SUSI_STATUS_UNSUPPORTED; \
+        } \
+        if ((value) > (max)) { \
+            return SUSI_STATUS_INVALID_PARAMETER; \
+        } \
+        (table)[Id] = (value); \
+        return SUSI_STATUS_SUCCESS; \
+    } while (0)
+
+static SusiStatus_t simulateSusiVgaGetBacklightEnable(SusiId_t Id, uint32_t *pEnable) {
+    BACKLIGHT_GET(SusiVgaGetBacklightEnable, backlightEnable, pEnable);
+}
+
+static SusiStatus_t simulateSusiVgaSetBacklightEnable(SusiId_t Id, uint32_t Enable) {
+    BACKLIGHT_SET(SusiVgaSetBacklightEnable, backlightEnable, Enable ? 1u : 0u, 1u);
+}
+
+static SusiStatus_t simulateSusiVgaGetBacklightBrightness(SusiId_t Id, uint32_t *pBright) {
+    BACKLIGHT_GET(SusiVgaGetBacklightBrightness, backlightBrightness, pBright);
+}
+
+static SusiStatus_t simulateSusiVgaSetBacklightBrightness(SusiId_t Id, uint32_t Bright) {
+    BACKLIGHT_SET(SusiVgaSetBacklightBrightness, backlightBrightness, Bright, 255u);
+}
+
+static SusiStatus_t simulateSusiVgaGetBacklightLevel(SusiId_t Id, uint32_t *pLevel) {
+    BACKLIGHT_GET(SusiVgaGetBacklightLevel, backlightLevel, pLevel);
+}
+
+static SusiStatus_t simulateSusiVgaSetBacklightLevel(SusiId_t Id, uint32_t Level) {
+    BACKLIGHT_SET(SusiVgaSetBacklightLevel, backlightLevel, Level, (uint32_t)SUSI_BACKLIGHT_LEVEL_MAXIMUM);
+}
+
+static SusiStatus_t simulateSusiVgaGetPolarity(SusiId_t Id, uint32_t *pPolarity) {
+    BACKLIGHT_GET(SusiVgaGetPolarity, backlightPolarity, pPolarity);
+}
+
+static SusiStatus_t simulateSusiVgaSetPolarity(SusiId_t Id, uint32_t Polarity) {
+    BACKLIGHT_SET(SusiVgaSetPolarity, backlightPolarity, Polarity, 1u);
+}
+
+static SusiStatus_t simulateSusiVgaGetFrequency(SusiId_t Id, uint32_t *pFrequency) {
+    BACKLIGHT_GET(SusiVgaGetFrequency, backlightFrequency, pFrequency);
+}
+
+static SusiStatus_t simulateSusiVgaSetFrequency(SusiId_t Id, uint32_t Frequency) {
+    BACKLIGHT_SET(SusiVgaSetFrequency, backlightFrequency, Frequency, 50000u);
+}
+
+static SusiStatus_t simulateSusiVgaGetCaps(SusiId_t Id, uint32_t ItemId, uint32_t *pValue) {
+    MOCK_ENTER(SusiVgaGetCaps);
+    if (pValue == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    if (Id >= MOCK_BACKLIGHTS) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    switch (ItemId) {
+    case SUSI_ID_VGA_BRIGHTNESS_MAXIMUM: *pValue = 255; return SUSI_STATUS_SUCCESS;
+    case SUSI_ID_VGA_BRIGHTNESS_MINIMUM: *pValue = 0; return SUSI_STATUS_SUCCESS;
+    default: return SUSI_STATUS_UNSUPPORTED;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Storage: a single user area, lockable with a password.
+// ---------------------------------------------------------------------------
+
+static SusiStatus_t simulateSusiStorageGetCaps(SusiId_t Id, uint32_t ItemId, uint32_t *pValue) {
+    MOCK_ENTER(SusiStorageGetCaps);
+    if (pValue == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    if (Id != SUSI_ID_STORAGE_STD) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    switch (ItemId) {
+    case SUSI_ID_STORAGE_TOTAL_SIZE:  *pValue = MOCK_STORAGE_SIZE; break;
+    case SUSI_ID_STORAGE_BLOCK_SIZE:  *pValue = 1; break;
+    case SUSI_ID_STORAGE_LOCK_STATUS: *pValue = (uint32_t)storageLocked; break;
+    case SUSI_ID_STORAGE_PSW_MAX_LEN: *pValue = MOCK_PASSWORD_MAX; break;
+    default:
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t checkStorageRange(SusiId_t Id, uint32_t Offset, const uint8_t *pBuffer, uint32_t BufLen) {
+    if (Id != SUSI_ID_STORAGE_STD) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    if (pBuffer == NULL || BufLen == 0 || Offset >= MOCK_STORAGE_SIZE || BufLen > MOCK_STORAGE_SIZE - Offset) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiStorageAreaRead(SusiId_t Id, uint32_t Offset, uint8_t *pBuffer, uint32_t BufLen) {
+    SusiStatus_t status;
+
+    MOCK_ENTER(SusiStorageAreaRead);
+    if ((status = checkStorageRange(Id, Offset, pBuffer, BufLen)) != SUSI_STATUS_SUCCESS) {
+        return status;
+    }
+    pthread_mutex_lock(&stateLock);
+    memcpy(pBuffer, storage + Offset, BufLen);
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiStorageAreaWrite(SusiId_t Id, uint32_t Offset, uint8_t *pBuffer, uint32_t BufLen) {
+    SusiStatus_t status;
+
+    MOCK_ENTER(SusiStorageAreaWrite);
+    if ((status = checkStorageRange(Id, Offset, pBuffer, BufLen)) != SUSI_STATUS_SUCCESS) {
+        return status;
+    }
+    pthread_mutex_lock(&stateLock);
+    if (storageLocked) {
+        pthread_mutex_unlock(&stateLock);
+        return SUSI_STATUS_LOCKFAIL;
+    }
+    memcpy(storage + Offset, pBuffer, BufLen);
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiStorageAreaSetUnlock(SusiId_t Id, uint8_t *pBuffer, uint32_t BufLen) {
+    SusiStatus_t status = SUSI_STATUS_SUCCESS;
+
+    MOCK_ENTER(SusiStorageAreaSetUnlock);
+    if (Id != SUSI_ID_STORAGE_STD) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    if (pBuffer == NULL || BufLen > MOCK_PASSWORD_MAX) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    pthread_mutex_lock(&stateLock);
+    if (storageLocked) {
+        if (BufLen != storagePasswordLen || memcmp(pBuffer, storagePassword, BufLen) != 0) {
+            status = SUSI_STATUS_LOCKFAIL;
+        } else {
+            storageLocked = 0;
+        }
+    }
+    pthread_mutex_unlock(&stateLock);
+    return status;
+}
+
+static SusiStatus_t simulateSusiStorageAreaSetLock(SusiId_t Id, uint8_t *pBuffer, uint32_t BufLen) {
+    MOCK_ENTER(SusiStorageAreaSetLock);
+    if (Id != SUSI_ID_STORAGE_STD) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    if (pBuffer == NULL || BufLen == 0 || BufLen > MOCK_PASSWORD_MAX) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    pthread_mutex_lock(&stateLock);
+    memcpy(storagePassword, pBuffer, BufLen);
+    storagePasswordLen = BufLen;
+    storageLocked = 1;
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+// Fan control and thermal protection
+// ---------------------------------------------------------------------------
+
+// Fans are addressed like the HWM fan items (SUSI_ID_HWM_FAN_BASE + n), as
+// the real driver does; bare indices are accepted too
+static SusiId_t mockFanIndex(SusiId_t Id) {
+    return Id >= SUSI_ID_HWM_FAN_BASE ? Id - SUSI_ID_HWM_FAN_BASE : Id;
+}
+
+static SusiStatus_t simulateSusiFanControlGetCaps(SusiId_t Id, uint32_t ItemId, uint32_t *pValue) {
+    MOCK_ENTER(SusiFanControlGetCaps);
+    if (pValue == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    Id = mockFanIndex(Id);
+    if (Id >= MOCK_FANS) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    switch (ItemId) {
+    case SUSI_ID_FC_CONTROL_SUPPORT_FLAGS:
+        *pValue = SUSI_FC_FLAG_SUPPORT_OFF_MODE | SUSI_FC_FLAG_SUPPORT_FULL_MODE |
+                  SUSI_FC_FLAG_SUPPORT_MANUAL_MODE | SUSI_FC_FLAG_SUPPORT_AUTO_MODE;
+        return SUSI_STATUS_SUCCESS;
+    case SUSI_ID_FC_AUTO_SUPPORT_FLAGS:
+        *pValue = SUSI_FC_FLAG_SUPPORT_AUTO_LOW_STOP | SUSI_FC_FLAG_SUPPORT_AUTO_LOW_LIMIT |
+                  SUSI_FC_FLAG_SUPPORT_AUTO_HIGH_LIMIT | SUSI_FC_FLAG_SUPPORT_AUTO_PWM;
+        return SUSI_STATUS_SUCCESS;
+    default:
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+}
+
+static SusiStatus_t simulateSusiFanControlGetConfig(SusiId_t Id, SusiFanControl *pConfig) {
+    MOCK_ENTER(SusiFanControlGetConfig);
+    if (pConfig == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    Id = mockFanIndex(Id);
+    if (Id >= MOCK_FANS) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    pthread_mutex_lock(&stateLock);
+    *pConfig = fanConfigs[Id];
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiFanControlSetConfig(SusiId_t Id, SusiFanControl *pConfig) {
+    MOCK_ENTER(SusiFanControlSetConfig);
+    if (pConfig == NULL || pConfig->Mode > SUSI_FAN_CTRL_MODE_AUTO || pConfig->PWM > 100) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    Id = mockFanIndex(Id);
+    if (Id >= MOCK_FANS) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    pthread_mutex_lock(&stateLock);
+    fanConfigs[Id] = *pConfig;
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiThermalProtectionGetCaps(SusiId_t Id, uint32_t ItemId, uint32_t *pValue) {
+    MOCK_ENTER(SusiThermalProtectionGetCaps);
+    if (pValue == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    if (Id >= MOCK_THERMALS) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    switch (ItemId) {
+    case SUSI_ID_TP_EVENT_SUPPORT_FLAGS:
+        *pValue = SUSI_THERMAL_FLAG_SUPPORT_SHUTDOWN | SUSI_THERMAL_FLAG_SUPPORT_THROTTLE;
+        return SUSI_STATUS_SUCCESS;
+    case SUSI_ID_TP_EVENT_TRIGGER_MAXIMUM: *pValue = 3731; return SUSI_STATUS_SUCCESS;   // 100 C
+    case SUSI_ID_TP_EVENT_TRIGGER_MINIMUM: *pValue = 2731; return SUSI_STATUS_SUCCESS;
+    case SUSI_ID_TP_EVENT_CLEAR_MAXIMUM:   *pValue = 3631; return SUSI_STATUS_SUCCESS;
+    case SUSI_ID_TP_EVENT_CLEAR_MINIMUM:   *pValue = 2731; return SUSI_STATUS_SUCCESS;
+    default:
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+}
+
+static SusiStatus_t simulateSusiThermalProtectionSetConfig(SusiId_t Id, SusiThermalProtect *pConfig) {
+    MOCK_ENTER(SusiThermalProtectionSetConfig);
+    if (pConfig == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    if (Id >= MOCK_THERMALS) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    if (pConfig->EventType != SUSI_THERMAL_EVENT_NONE &&
+        pConfig->ClearEventTemperature >= pConfig->SendEventTemperature) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    pthread_mutex_lock(&stateLock);
+    thermalConfigs[Id] = *pConfig;
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiThermalProtectionGetConfig(SusiId_t Id, SusiThermalProtect *pConfig) {
+    MOCK_ENTER(SusiThermalProtectionGetConfig);
+    if (pConfig == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    if (Id >= MOCK_THERMALS) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    pthread_mutex_lock(&stateLock);
+    *pConfig = thermalConfigs[Id];
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+// Watchdog. The mock never resets the machine; a trigger or stop that arrives
+// after the deadline is reported on stderr so CI can catch feeding gaps.
+// ---------------------------------------------------------------------------
+
+static void checkMissedDeadline(SusiId_t Id, MockWatchdog *wd) {
+    struct timespec now;
+    uint64_t elapsedMs, limitMs;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsedMs = (uint64_t)(now.tv_sec - wd->lastFeed.tv_sec) * 1000 +
+                (uint64_t)((now.tv_nsec - wd->lastFeed.tv_nsec) / 1000000);
+    limitMs = (uint64_t)wd->delayMs + wd->eventMs + wd->resetMs;
+    if (elapsedMs > limitMs) {
+        fprintf(stderr, "susi_mock: watchdog %u would have reset the board (%llu ms since last feed, limit %llu ms)\n",
+                Id, (unsigned long long)elapsedMs, (unsigned long long)limitMs);
+    }
+    wd->lastFeed = now;
+}
+
+// The EC thread delivers the event stage of timers started with an IRQ or
+// SCI event type to the registered callback, like the driver's interrupt
+// thread would. It is only started once a callback is registered.
+static pthread_cond_t ecWake;
+static pthread_once_t ecOnce = PTHREAD_ONCE_INIT;
+
+static uint64_t timespecMs(const struct timespec *ts) {
+    return (uint64_t)ts->tv_sec * 1000 + (uint64_t)(ts->tv_nsec / 1000000);
+}
+
+static void* ecThreadMain(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&stateLock);
+    for (;;) {
+        struct timespec now, deadline;
+        uint64_t nextMs = UINT64_MAX;
+        int due = -1;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        for (uint32_t i = 0; i < watchdogCount; i++) {
+            MockWatchdog *wd = &watchdogs[i];
+            uint64_t eventMs;
+
+            if (!wd->running || wd->eventFired || wd->callback == NULL ||
+                (wd->eventType != SUSI_WDT_EVENT_TYPE_IRQ && wd->eventType != SUSI_WDT_EVENT_TYPE_SCI)) {
+                continue;
+            }
+            eventMs = timespecMs(&wd->lastFeed) + (wd->sinceStart ? wd->delayMs : 0) + wd->eventMs;
+            if (eventMs <= timespecMs(&now)) {
+                due = (int)i;
+                break;
+            }
+            if (eventMs < nextMs) {
+                nextMs = eventMs;
+            }
+        }
+        if (due >= 0) {
+            SUSI_WDT_INT_CALLBACK callback = watchdogs[due].callback;
+            void *context = watchdogs[due].callbackContext;
+
+            watchdogs[due].eventFired = 1;
+            pthread_mutex_unlock(&stateLock);
+            callback(context);
+            pthread_mutex_lock(&stateLock);
+        } else if (nextMs == UINT64_MAX) {
+            pthread_cond_wait(&ecWake, &stateLock);
+        } else {
+            deadline.tv_sec = (time_t)(nextMs / 1000);
+            deadline.tv_nsec = (long)(nextMs % 1000) * 1000000L;
+            pthread_cond_timedwait(&ecWake, &stateLock, &deadline);
+        }
+    }
+    return NULL;
+}
+
+static void ecStart(void) {
+    pthread_condattr_t attr;
+    pthread_t thread;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&ecWake, &attr);
+    pthread_condattr_destroy(&attr);
+    if (pthread_create(&thread, NULL, ecThreadMain, NULL) == 0) {
+        pthread_detach(thread);
+    }
+}
+
+static SusiStatus_t simulateSusiWDogGetCaps(SusiId_t Id, uint32_t ItemId, uint32_t *pValue) {
+    MOCK_ENTER(SusiWDogGetCaps);
+    if (pValue == NULL) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    if (Id >= watchdogCount) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    switch (ItemId) {
+    case SUSI_ID_WDT_SUPPORT_FLAGS: *pValue = SUSI_WDT_FLAG_SUPPORT_IRQ | SUSI_WDT_FLAG_SUPPORT_PWRBTN; break;
+    case SUSI_ID_WDT_UNIT_MINIMUM:  *pValue = 1000; break;
+    case SUSI_ID_WDT_DELAY_MINIMUM: *pValue = 0; break;
+    case SUSI_ID_WDT_DELAY_MAXIMUM: *pValue = 255000; break;
+    case SUSI_ID_WDT_EVENT_MINIMUM: *pValue = 0; break;
+    case SUSI_ID_WDT_EVENT_MAXIMUM: *pValue = 255000; break;
+    case SUSI_ID_WDT_RESET_MINIMUM: *pValue = 1000; break;
+    case SUSI_ID_WDT_RESET_MAXIMUM: *pValue = 255000; break;
+    case SUSI_ID_WDT_DELAY_TIME:    *pValue = watchdogs[Id].delayMs; break;
+    case SUSI_ID_WDT_EVENT_TIME:    *pValue = watchdogs[Id].eventMs; break;
+    case SUSI_ID_WDT_RESET_TIME:    *pValue = watchdogs[Id].resetMs; break;
+    case SUSI_ID_WDT_EVENT_TYPE:    *pValue = watchdogs[Id].eventType; break;
+    default:
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiWDogStart(SusiId_t Id, uint32_t DelayTime, uint32_t EventTime, uint32_t ResetTime,
+                                          uint32_t EventType) {
+    MockWatchdog *wd;
+
+    MOCK_ENTER(SusiWDogStart);
+    if (Id >= watchdogCount) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    if (DelayTime > 255000 || EventTime > 255000 || ResetTime < 1000 || ResetTime > 255000 ||
+        EventType > SUSI_WDT_EVENT_TYPE_PIN) {
+        return SUSI_STATUS_INVALID_PARAMETER;
+    }
+    pthread_mutex_lock(&stateLock);
+    wd = &watchdogs[Id];
+    wd->running = 1;
+    wd->delayMs = DelayTime;
+    wd->eventMs = EventTime;
+    wd->resetMs = ResetTime;
+    wd->eventType = EventType;
+    wd->sinceStart = 1;
+    wd->eventFired = 0;
+    clock_gettime(CLOCK_MONOTONIC, &wd->lastFeed);
+    if (wd->callback != NULL) {
+        pthread_cond_signal(&ecWake);
+    }
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiWDogStop(SusiId_t Id) {
+    MOCK_ENTER(SusiWDogStop);
+    if (Id >= watchdogCount) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    pthread_mutex_lock(&stateLock);
+    if (watchdogs[Id].running) {
+        checkMissedDeadline(Id, &watchdogs[Id]);
+    }
+    watchdogs[Id].running = 0;
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+static SusiStatus_t simulateSusiWDogTrigger(SusiId_t Id) {
+    SusiStatus_t status = SUSI_STATUS_SUCCESS;
+
+    MOCK_ENTER(SusiWDogTrigger);
+    if (Id >= watchdogCount) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    pthread_mutex_lock(&stateLock);
+    if (watchdogs[Id].running) {
+        checkMissedDeadline(Id, &watchdogs[Id]);
+        watchdogs[Id].sinceStart = 0;
+        watchdogs[Id].eventFired = 0;
+        if (watchdogs[Id].callback != NULL) {
+            pthread_cond_signal(&ecWake);
+        }
+    } else {
+        status = SUSI_STATUS_ERROR;
+    }
+    pthread_mutex_unlock(&stateLock);
+    return status;
+}
+
+static SusiStatus_t simulateSusiWDogSetCallBack(SusiId_t Id, SUSI_WDT_INT_CALLBACK pfnCallback, void *Context) {
+    MOCK_ENTER(SusiWDogSetCallBack);
+    if (Id >= watchdogCount) {
+        return SUSI_STATUS_UNSUPPORTED;
+    }
+    if (pfnCallback != NULL) {
+        pthread_once(&ecOnce, ecStart);
+    }
+    pthread_mutex_lock(&stateLock);
+    watchdogs[Id].callback = pfnCallback;
+    watchdogs[Id].callbackContext = Context;
+    if (pfnCallback != NULL) {
+        pthread_cond_signal(&ecWake);
+    }
+    pthread_mutex_unlock(&stateLock);
+    return SUSI_STATUS_SUCCESS;
+}
+
+// ---------------------------------------------------------------------------
+// Exported entry points: the recording's answer when replaying, else the
+// simulation above
+// ---------------------------------------------------------------------------
+
+#undef REC_OUT_P8
+#undef REC_OUT_P16
+#undef REC_OUT_P32
+#undef REC_OUT_BYTES
+#undef REC_OUT_STR
+#undef REC_OUT_OBJ
+#define REPLAY_VALUE(p, type) { \
+        uint64_t value; \
+        if (susiRecordGetVarint(recordCursor, &value) && (p) != NULL) { \
+            *(p) = (type)value; \
+        } \
+    }
+#define REC_OUT_P8(p)           REPLAY_VALUE(p, uint8_t)
+#define REC_OUT_P16(p)          REPLAY_VALUE(p, uint16_t)
+#define REC_OUT_P32(p)          REPLAY_VALUE(p, uint32_t)
+#define REC_OUT_BYTES(p, n)     replayTakeBytes(recordCursor, (p), (p) != NULL ? (size_t)(n) : 0);
+#define REC_OUT_STR(p, cap)     replayTakeString(recordCursor, (p), (p) != NULL ? (size_t)(cap) : 0);
+#define REC_OUT_OBJ(p)          replayTakeBytes(recordCursor, (p), (p) != NULL ? sizeof(*(p)) : 0);
+
+#define MOCK_EXPORT(name, params, args, inputs, outputs) \
+    SusiStatus_t SUSI_API name params { \
+        pthread_once(&configOnce, loadConfig); \
+        if (replaying) { \
+            uint8_t inputBytes[SUSI_RECORD_STREAM_BYTES]; \
+            SusiRecordStream key = { inputBytes, 0, sizeof(inputBytes), 0 }; \
+            SusiRecordStream *recordStream = &key; \
+            SusiRecord record; \
+            (void)recordStream; \
+            SUSI_RECORD_EXPAND inputs \
+            if (replayFind(MOCK_##name, &key, &record)) { \
+                SusiRecordCursor output = { record.output, record.outputLength, 0 }; \
+                SusiRecordCursor *recordCursor = &output; \
+                SusiStatus_t status = (SusiStatus_t)record.status; \
+                (void)recordCursor; \
+                if (alwaysSimulated(MOCK_##name)) { \
+                    status = simulate##name args; \
+                } else if (record.outputLength > 0) { \
+                    SUSI_RECORD_EXPAND outputs \
+                } \
+                injectDelay((double)record.durationNs); \
+                return status; \
+            } \
+        } \
+        return simulate##name args; \
+    }
+
+SUSI_CALLS(MOCK_EXPORT)
@@ -0,0 +1,161 @@
+#include <string.h>
+#include "susi_record.h"
+
+#define VARINT_MAX_BYTES 10
+
+static size_t encodeVarint(uint8_t *out, uint64_t value) {
+    size_t length = 0;
+
+    while (value >= 0x80) {
+        out[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (uint8_t)value;
+    return length;
+}
+
+static void encodeU32(uint8_t *out, uint32_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+void susiRecordPutVarint(SusiRecordStream *stream, uint64_t value) {
+    uint8_t encoded[VARINT_MAX_BYTES];
+    size_t length = encodeVarint(encoded, value);
+
+    if (stream->length + length > stream->capacity) {
+        stream->overflow = true;
+        return;
+    }
+    memcpy(stream->data + stream->length, encoded, length);
+    stream->length += length;
+}
+
+void susiRecordPutBytes(SusiRecordStream *stream, const void *bytes, size_t length) {
+    uint8_t encoded[VARINT_MAX_BYTES];
+    size_t prefix = encodeVarint(encoded, length);
+
+    if (stream->length + prefix + length > stream->capacity) {
+        stream->overflow = true;
+        susiRecordPutVarint(stream, 0);
+        return;
+    }
+    memcpy(stream->data + stream->length, encoded, prefix);
+    if (length > 0) {
+        memcpy(stream->data + stream->length + prefix, bytes, length);
+    }
+    stream->length += prefix + length;
+}
+
+bool susiRecordGetVarint(SusiRecordCursor *cursor, uint64_t *value) {
+    uint64_t result = 0;
+
+    for (int shift = 0; shift < 64 && cursor->offset < cursor->length; shift += 7) {
+        uint8_t byte = cursor->data[cursor->offset++];
+
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool susiRecordGetBytes(SusiRecordCursor *cursor, const uint8_t **bytes, size_t *length) {
+    uint64_t size;
+
+    if (!susiRecordGetVarint(cursor, &size) || size > cursor->length - cursor->offset) {
+        return false;
+    }
+    *bytes = cursor->data + cursor->offset;
+    *length = (size_t)size;
+    cursor->offset += (size_t)size;
+    return true;
+}
+
+bool susiRecordWriteHeader(FILE *file, const char *const *names, int count) {
+    uint8_t header[12];
+
+    encodeU32(header, SUSI_RECORD_MAGIC);
+    encodeU32(header + 4, SUSI_RECORD_VERSION);
+    encodeU32(header + 8, (uint32_t)count);
+    if (fwrite(header, sizeof(header), 1, file) != 1) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (fwrite(names[i], strlen(names[i]) + 1, 1, file) != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool susiRecordWrite(FILE *file, const SusiRecord *record) {
+    uint8_t header[6 + 4 * VARINT_MAX_BYTES];
+    size_t length = 6;
+
+    header[0] = record->call;
+    header[1] = record->thread;
+    encodeU32(header + 2, record->status);
+    length += encodeVarint(header + length, record->startNs);
+    length += encodeVarint(header + length, record->durationNs);
+    length += encodeVarint(header + length, record->inputLength);
+    if (fwrite(header, length, 1, file) != 1 ||
+        (record->inputLength > 0 && fwrite(record->input, record->inputLength, 1, file) != 1)) {
+        return false;
+    }
+    length = encodeVarint(header, record->outputLength);
+    return fwrite(header, length, 1, file) == 1 &&
+           (record->outputLength == 0 || fwrite(record->output, record->outputLength, 1, file) == 1);
+}
+
+static uint32_t decodeU32(const uint8_t *in) {
+    return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+}
+
+bool susiRecordReadHeader(SusiRecordCursor *cursor, const char **names, int maxNames, int *count) {
+    const uint8_t *data = cursor->data;
+    uint32_t declared;
+
+    if (cursor->length < 12 || decodeU32(data) != SUSI_RECORD_MAGIC || decodeU32(data + 4) != SUSI_RECORD_VERSION) {
+        return false;
+    }
+    declared = decodeU32(data + 8);
+    if (declared > (uint32_t)maxNames) {
+        return false;
+    }
+    cursor->offset = 12;
+    for (uint32_t i = 0; i < declared; i++) {
+        const uint8_t *end = memchr(data + cursor->offset, '\0', cursor->length - cursor->offset);
+
+        if (end == NULL) {
+            return false;
+        }
+        names[i] = (const char *)data + cursor->offset;
+        cursor->offset = (size_t)(end - data) + 1;
+    }
+    *count = (int)declared;
+    return true;
+}
+
+int susiRecordRead(SusiRecordCursor *cursor, SusiRecord *record) {
+    if (cursor->offset == cursor->length) {
+        return 0;
+    }
+    if (cursor->length - cursor->offset < 6) {
+        return -1;
+    }
+    record->call = cursor->data[cursor->offset];
+    record->thread = cursor->data[cursor->offset + 1];
+    record->status = decodeU32(cursor->data + cursor->offset + 2);
+    cursor->offset += 6;
+    if (!susiRecordGetVarint(cursor, &record->startNs) || !susiRecordGetVarint(cursor, &record->durationNs) ||
+        !susiRecordGetBytes(cursor, &record->input, &record->inputLength) ||
+        !susiRecordGetBytes(cursor, &record->output, &record->outputLength)) {
+        return -1;
+    }
+    return 1;
+}
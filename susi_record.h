@@ -0,0 +1,90 @@
+#ifndef SUSI_RECORD_H
+#define SUSI_RECORD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Binary SUSI call recording, written by libsusi_trace.so when
+// SUSI_TRACE_RECORD names a file and replayed by the mock library when
+// SUSI_MOCK_REPLAY names one. The file is a header followed by one record
+// per call, in the order the calls returned:
+//
+//   header  "SURC", version (u32 LE), call count (u32 LE), then that many
+//           NUL-terminated call names; records refer to calls by index
+//   record  call (u8), thread (u8), status (u32 LE),
+//           start ns since recording began (varint), duration ns (varint),
+//           input bytes (varint length + bytes), output bytes (likewise)
+//
+// Varints are LEB128. Inputs are the arguments the driver reads and are
+// what replay matches on; outputs are what it wrote back, kept only for
+// calls that returned SUSI_STATUS_SUCCESS or SUSI_STATUS_MORE_DATA. The
+// per-call layout of both is the REC_IN_* / REC_OUT_* list in susi_calls.h.
+
+#define SUSI_RECORD_MAGIC 0x43525553u     // "SURC"
+#define SUSI_RECORD_VERSION 1
+#define SUSI_RECORD_STREAM_BYTES 8192     // Per direction; larger buffers are recorded as empty
+
+typedef struct {
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+    bool overflow;
+} SusiRecordStream;
+
+typedef struct {
+    const uint8_t *data;
+    size_t length;
+    size_t offset;
+} SusiRecordCursor;
+
+typedef struct {
+    uint8_t call;
+    uint8_t thread;
+    uint32_t status;
+    uint64_t startNs;
+    uint64_t durationNs;
+    const uint8_t *input;
+    size_t inputLength;
+    const uint8_t *output;
+    size_t outputLength;
+} SusiRecord;
+
+void susiRecordPutVarint(SusiRecordStream *stream, uint64_t value);
+// Length-prefixed; a buffer that does not fit is recorded as zero bytes
+void susiRecordPutBytes(SusiRecordStream *stream, const void *bytes, size_t length);
+
+bool susiRecordGetVarint(SusiRecordCursor *cursor, uint64_t *value);
+bool susiRecordGetBytes(SusiRecordCursor *cursor, const uint8_t **bytes, size_t *length);
+
+bool susiRecordWriteHeader(FILE *file, const char *const *names, int count);
+bool susiRecordWrite(FILE *file, const SusiRecord *record);
+
+// Names point into the cursor's data. False when it is not a recording.
+bool susiRecordReadHeader(SusiRecordCursor *cursor, const char **names, int maxNames, int *count);
+// 1 with the next record, 0 at the end, -1 when the file is truncated or corrupt
+int susiRecordRead(SusiRecordCursor *cursor, SusiRecord *record);
+
+// Encoders for the lists in susi_calls.h, expanded where a
+// SusiRecordStream *recordStream and the call's SusiStatus_t status are in
+// scope. Pointers read as 0 or as no bytes when NULL.
+#define REC_IN_U8(v)            susiRecordPutVarint(recordStream, (uint8_t)(v));
+#define REC_IN_U16(v)           susiRecordPutVarint(recordStream, (uint16_t)(v));
+#define REC_IN_U32(v)           susiRecordPutVarint(recordStream, (uint32_t)(v));
+#define REC_IN_P32(p)           susiRecordPutVarint(recordStream, (p) != NULL ? *(p) : 0);
+#define REC_IN_BYTES(p, n)      susiRecordPutBytes(recordStream, (p), (p) != NULL ? (size_t)(n) : 0);
+#define REC_IN_OBJ(p)           susiRecordPutBytes(recordStream, (p), (p) != NULL ? sizeof(*(p)) : 0);
+#define REC_OUT_P8(p)           susiRecordPutVarint(recordStream, (p) != NULL ? *(p) : 0);
+#define REC_OUT_P16(p)          susiRecordPutVarint(recordStream, (p) != NULL ? *(p) : 0);
+#define REC_OUT_P32(p)          susiRecordPutVarint(recordStream, (p) != NULL ? *(p) : 0);
+#define REC_OUT_BYTES(p, n)     susiRecordPutBytes(recordStream, (p), (p) != NULL ? (size_t)(n) : 0);
+// cap is only used by replay; the driver NUL-terminates what it returns with success
+#define REC_OUT_STR(p, cap)     susiRecordPutBytes(recordStream, (p), \
+                                    (p) != NULL && status == SUSI_STATUS_SUCCESS ? strlen(p) + 1 : 0);
+#define REC_OUT_OBJ(p)          susiRecordPutBytes(recordStream, (p), (p) != NULL ? sizeof(*(p)) : 0);
+
+#define SUSI_RECORD_EXPAND(...) __VA_ARGS__
+
+#endif // SUSI_RECORD_H
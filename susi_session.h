@@ -0,0 +1,101 @@
+#ifndef SUSI_SESSION_H
+#define SUSI_SESSION_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+// One SUSI session per board. The driver does not coordinate processes that
+// each call SusiLibInitialize, so whoever talks to it directly (the HTTP
+// service, watchdog_test, susibench) first takes a write lock on a lock
+// file and keeps it for as long as the library is initialized. The lock is
+// a POSIX record lock: the kernel drops it when the owner exits, and
+// F_GETLK reports the owner's pid to everyone else, who then knows to use
+// the service's control socket or HTTP API instead. The file holds
+// "pid name" for people looking at it.
+//
+// This header is self-contained so tools can include it directly.
+
+#define SUSI_SESSION_DEFAULT_LOCK "/run/lock/susi-session.lock"
+
+// Take the session. Returns the lock descriptor, which must stay open for
+// as long as SUSI is initialized (closing any descriptor of the file drops
+// the lock). -1 when another process owns the session, with *holder set to
+// its pid; -2 when the lock file cannot be opened, with errno set.
+static inline int susiSessionAcquire(const char *path, const char *name, pid_t *holder) {
+    struct flock lock;
+    char line[96];
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    int length;
+
+    *holder = 0;
+    if (fd < 0) {
+        return -2;
+    }
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    if (fcntl(fd, F_SETLK, &lock) != 0) {
+        int error = errno;
+
+        if (error == EACCES || error == EAGAIN) {
+            memset(&lock, 0, sizeof(lock));
+            lock.l_type = F_WRLCK;
+            lock.l_whence = SEEK_SET;
+            if (fcntl(fd, F_GETLK, &lock) == 0 && lock.l_type != F_UNLCK) {
+                *holder = lock.l_pid;
+            }
+            close(fd);
+            return -1;
+        }
+        close(fd);
+        errno = error;
+        return -2;
+    }
+    length = snprintf(line, sizeof(line), "%ld %s\n", (long)getpid(), name);
+    if (ftruncate(fd, 0) == 0 && length > 0) {
+        ssize_t written = pwrite(fd, line, (size_t)length, 0);
+        (void)written;
+    }
+    return fd;
+}
+
+// Pid of the session owner, 0 when nobody holds it (or the file is missing).
+// name, if not NULL, receives what the owner wrote into the file.
+static inline pid_t susiSessionOwner(const char *path, char *name, size_t size) {
+    struct flock lock;
+    pid_t owner = 0;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (name != NULL && size > 0) {
+        name[0] = '\0';
+    }
+    if (fd < 0) {
+        return 0;
+    }
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    if (fcntl(fd, F_GETLK, &lock) == 0 && lock.l_type != F_UNLCK) {
+        owner = lock.l_pid;
+        if (name != NULL && size > 0) {
+            char line[96];
+            ssize_t length = pread(fd, line, sizeof(line) - 1, 0);
+            char *space;
+
+            if (length > 0) {
+                line[length] = '\0';
+                line[strcspn(line, "\n")] = '\0';
+                space = strchr(line, ' ');
+                snprintf(name, size, "%s", space != NULL ? space + 1 : "");
+            }
+        }
+    }
+    close(fd);
+    return owner;
+}
+
+#endif // SUSI_SESSION_H
@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include "susi_timing.h"
+#include "histogram.h"
+#include "metrics.h"
+#include "span_trace.h"
+
+static const char *susiCallNames[SUSI_CALL_COUNT] = {
+    [SUSI_CALL_LIB_INITIALIZE] = "SusiLibInitialize",
+    [SUSI_CALL_WDOG_GET_CAPS]  = "SusiWDogGetCaps",
+    [SUSI_CALL_WDOG_START]     = "SusiWDogStart",
+    [SUSI_CALL_WDOG_TRIGGER]   = "SusiWDogTrigger",
+    [SUSI_CALL_WDOG_STOP]      = "SusiWDogStop",
+    [SUSI_CALL_WDOG_SET_CALLBACK] = "SusiWDogSetCallBack",
+    [SUSI_CALL_BOARD_GET_VALUE] = "SusiBoardGetValue",
+    [SUSI_CALL_BOARD_GET_STRING] = "SusiBoardGetStringA",
+    [SUSI_CALL_GPIO_INT_SET_EDGE] = "SusiGPIOIntSetEdge",
+    [SUSI_CALL_GPIO_INT_SET_PIN] = "SusiGPIOIntSetPin",
+    [SUSI_CALL_GPIO_INT_REGISTER] = "SusiGPIOIntRegister",
+    [SUSI_CALL_GPIO_INT_UNREGISTER] = "SusiGPIOIntUnRegister",
+    [SUSI_CALL_GPIO_GET_CAPS] = "SusiGPIOGetCaps",
+    [SUSI_CALL_GPIO_GET_DIRECTION] = "SusiGPIOGetDirection",
+    [SUSI_CALL_GPIO_SET_DIRECTION] = "SusiGPIOSetDirection",
+    [SUSI_CALL_GPIO_GET_LEVEL] = "SusiGPIOGetLevel",
+    [SUSI_CALL_GPIO_SET_LEVEL] = "SusiGPIOSetLevel",
+    [SUSI_CALL_SMB_WRITE_QUICK] = "SusiSMBWriteQuick",
+    [SUSI_CALL_SMB_RECEIVE_BYTE] = "SusiSMBReceiveByte",
+    [SUSI_CALL_I2C_PROBE_DEVICE] = "SusiI2CProbeDevice",
+    [SUSI_CALL_I2C_WRITE_READ] = "SusiI2CWriteReadCombine",
+    [SUSI_CALL_SMB_READ_BYTE] = "SusiSMBReadByte",
+    [SUSI_CALL_SMB_WRITE_BYTE] = "SusiSMBWriteByte",
+    [SUSI_CALL_SMB_READ_WORD] = "SusiSMBReadWord",
+    [SUSI_CALL_SMB_WRITE_WORD] = "SusiSMBWriteWord",
+    [SUSI_CALL_SMB_READ_BLOCK] = "SusiSMBReadBlock",
+    [SUSI_CALL_SMB_I2C_READ_BLOCK] = "SusiSMBI2CReadBlock",
+    [SUSI_CALL_SMB_I2C_WRITE_BLOCK] = "SusiSMBI2CWriteBlock",
+    [SUSI_CALL_I2C_READ_TRANSFER] = "SusiI2CReadTransfer",
+    [SUSI_CALL_I2C_WRITE_TRANSFER] = "SusiI2CWriteTransfer",
+    [SUSI_CALL_STORAGE_GET_CAPS] = "SusiStorageGetCaps",
+    [SUSI_CALL_STORAGE_READ] = "SusiStorageAreaRead",
+    [SUSI_CALL_STORAGE_WRITE] = "SusiStorageAreaWrite",
+    [SUSI_CALL_FAN_GET_CAPS] = "SusiFanControlGetCaps",
+    [SUSI_CALL_FAN_GET_CONFIG] = "SusiFanControlGetConfig",
+    [SUSI_CALL_FAN_SET_CONFIG] = "SusiFanControlSetConfig",
+    [SUSI_CALL_THERMAL_GET_CONFIG] = "SusiThermalProtectionGetConfig",
+    [SUSI_CALL_THERMAL_SET_CONFIG] = "SusiThermalProtectionSetConfig",
+    [SUSI_CALL_VGA_GET_CAPS] = "SusiVgaGetCaps",
+    [SUSI_CALL_VGA_GET_BACKLIGHT_ENABLE] = "SusiVgaGetBacklightEnable",
+    [SUSI_CALL_VGA_SET_BACKLIGHT_ENABLE] = "SusiVgaSetBacklightEnable",
+    [SUSI_CALL_VGA_GET_BACKLIGHT_BRIGHTNESS] = "SusiVgaGetBacklightBrightness",
+    [SUSI_CALL_VGA_SET_BACKLIGHT_BRIGHTNESS] = "SusiVgaSetBacklightBrightness",
+    [SUSI_CALL_BOARD_READ_PCI] = "SusiBoardReadPCI",
+    [SUSI_CALL_BOARD_READ_MSR] = "SusiBoardReadMSR",
+    [SUSI_CALL_BOARD_SET_VALUE] = "SusiBoardSetValue",
+};
+
+static Histogram susiHistograms[SUSI_CALL_COUNT];
+static uint64_t susiErrors[SUSI_CALL_COUNT];
+
+void susiTimingRecord(SusiCall call, uint64_t startNs, SusiStatus_t status) {
+    uint64_t end = monotonicNowNs();
+    
+    histogramRecord(&susiHistograms[call], end - startNs);
+    spanTraceRecord(SPAN_SUSI, susiTimingCallName(call), startNs, end);
+    if (status != SUSI_STATUS_SUCCESS) {
+        __atomic_fetch_add(&susiErrors[call], 1, __ATOMIC_RELAXED);
+    }
+}
+
+const char* susiTimingCallName(SusiCall call) {
+    return call < SUSI_CALL_COUNT ? susiCallNames[call] : "unknown";
+}
+
+void susiTimingCollectMetrics(StrBuf *out, void *ctx) {
+    char labels[64];
+    (void)ctx;
+    
+    metricsHeader(out, "watchdog_susi_call_seconds", "summary", "SUSI driver call latency");
+    for (int i = 0; i < SUSI_CALL_COUNT; i++) {
+        if (__atomic_load_n(&susiHistograms[i].count, __ATOMIC_RELAXED) == 0) {
+            continue;
+        }
+        snprintf(labels, sizeof(labels), "function=\"%s\"", susiCallNames[i]);
+        histogramWriteSummary(out, "watchdog_susi_call_seconds", labels, &susiHistograms[i]);
+    }
+    metricsHeader(out, "watchdog_susi_call_errors_total", "counter", "SUSI calls that did not return SUSI_STATUS_SUCCESS");
+    for (int i = 0; i < SUSI_CALL_COUNT; i++) {
+        strbufAppendf(out, "watchdog_susi_call_errors_total{function=\"%s\"} %llu\n", susiCallNames[i],
+                      (unsigned long long)__atomic_load_n(&susiErrors[i], __ATOMIC_RELAXED));
+    }
+}
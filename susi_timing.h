@@ -0,0 +1,70 @@
+#ifndef SUSI_TIMING_H
+#define SUSI_TIMING_H
+
+#include <stdint.h>
+#include "Susi4.h"
+#include "strbuf.h"
+#include "timeutil.h"
+
+// Every SUSI entry point the service calls
+typedef enum {
+    SUSI_CALL_LIB_INITIALIZE,
+    SUSI_CALL_WDOG_GET_CAPS,
+    SUSI_CALL_WDOG_START,
+    SUSI_CALL_WDOG_TRIGGER,
+    SUSI_CALL_WDOG_STOP,
+    SUSI_CALL_WDOG_SET_CALLBACK,
+    SUSI_CALL_BOARD_GET_VALUE,
+    SUSI_CALL_BOARD_GET_STRING,
+    SUSI_CALL_GPIO_INT_SET_EDGE,
+    SUSI_CALL_GPIO_INT_SET_PIN,
+    SUSI_CALL_GPIO_INT_REGISTER,
+    SUSI_CALL_GPIO_INT_UNREGISTER,
+    SUSI_CALL_GPIO_GET_CAPS,
+    SUSI_CALL_GPIO_GET_DIRECTION,
+    SUSI_CALL_GPIO_SET_DIRECTION,
+    SUSI_CALL_GPIO_GET_LEVEL,
+    SUSI_CALL_GPIO_SET_LEVEL,
+    SUSI_CALL_SMB_WRITE_QUICK,
+    SUSI_CALL_SMB_RECEIVE_BYTE,
+    SUSI_CALL_I2C_PROBE_DEVICE,
+    SUSI_CALL_I2C_WRITE_READ,
+    SUSI_CALL_SMB_READ_BYTE,
+    SUSI_CALL_SMB_WRITE_BYTE,
+    SUSI_CALL_SMB_READ_WORD,
+    SUSI_CALL_SMB_WRITE_WORD,
+    SUSI_CALL_SMB_READ_BLOCK,
+    SUSI_CALL_SMB_I2C_READ_BLOCK,
+    SUSI_CALL_SMB_I2C_WRITE_BLOCK,
+    SUSI_CALL_I2C_READ_TRANSFER,
+    SUSI_CALL_I2C_WRITE_TRANSFER,
+    SUSI_CALL_STORAGE_GET_CAPS,
+    SUSI_CALL_STORAGE_READ,
+    SUSI_CALL_STORAGE_WRITE,
+    SUSI_CALL_FAN_GET_CAPS,
+    SUSI_CALL_FAN_GET_CONFIG,
+    SUSI_CALL_FAN_SET_CONFIG,
+    SUSI_CALL_THERMAL_GET_CONFIG,
+    SUSI_CALL_THERMAL_SET_CONFIG,
+    SUSI_CALL_VGA_GET_CAPS,
+    SUSI_CALL_VGA_GET_BACKLIGHT_ENABLE,
+    SUSI_CALL_VGA_SET_BACKLIGHT_ENABLE,
+    SUSI_CALL_VGA_GET_BACKLIGHT_BRIGHTNESS,
+    SUSI_CALL_VGA_SET_BACKLIGHT_BRIGHTNESS,
+    SUSI_CALL_BOARD_READ_PCI,
+    SUSI_CALL_BOARD_READ_MSR,
+    SUSI_CALL_BOARD_SET_VALUE,
+    SUSI_CALL_COUNT
+} SusiCall;
+
+// Usage:
+//     uint64_t start = monotonicNowNs();
+//     status = SusiWDogTrigger(id);
+//     susiTimingRecord(SUSI_CALL_WDOG_TRIGGER, start, status);
+void susiTimingRecord(SusiCall call, uint64_t startNs, SusiStatus_t status);
+// Driver function name, e.g. "SusiBoardGetValue"
+const char* susiTimingCallName(SusiCall call);
+
+void susiTimingCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // SUSI_TIMING_H
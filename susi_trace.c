@@ -0,0 +1,281 @@
+// Tracing shim for libSUSI-4.00.so. Preload it in front of the real (or
+// mock) library and every Susi* call is timed into a shared-memory segment
+// that susi_trace reads while the process keeps running:
+//
+//   LD_PRELOAD=./libsusi_trace.so ./watchdog_http_service
+//   ./susi_trace $(pidof watchdog_http_service)
+//
+//   SUSI_TRACE_NAME    shared-memory name (default /susi_trace.<pid>)
+//   SUSI_TRACE_RECORD  also write every call, with its arguments, results and
+//                      timing, to this file for SUSI_MOCK_REPLAY (susi_record.h)
+//
+// Each call gets a latency histogram, an in-flight gauge and counts of the
+// statuses it returned. The segment outlives the process so a crash can be
+// read afterwards; susi_trace -u removes it. Built with -fvisibility=hidden
+// so only the Susi* entry points are exported and the service's own
+// histogram code is not interposed.
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "Susi4.h"
+#include "susi_calls.h"
+#include "susi_record.h"
+#include "susi_trace.h"
+#include "timeutil.h"
+
+#define TRACE_EXPORT __attribute__((visibility("default")))
+#define RECORD_BUFFER_BYTES (1 << 20)
+#define RECORD_FLUSH_NS 1000000000ull
+
+typedef struct {
+    uint8_t input[SUSI_RECORD_STREAM_BYTES];
+    uint8_t output[SUSI_RECORD_STREAM_BYTES];
+    SusiRecordStream inputStream;
+    SusiRecordStream outputStream;
+} RecordBuffers;
+
+#define TRACE_ENUM(name, params, args, inputs, outputs) TRACE_##name,
+#define TRACE_NAME(name, params, args, inputs, outputs) #name,
+#define TRACE_POINTER(name, params, args, inputs, outputs) static SusiStatus_t (*real##name) params;
+#define TRACE_RESOLVE(name, params, args, inputs, outputs) *(void**)&real##name = dlsym(RTLD_NEXT, #name);
+
+typedef enum { SUSI_CALLS(TRACE_ENUM) TRACE_CALL_COUNT } TraceCall;
+
+_Static_assert(TRACE_CALL_COUNT <= SUSI_TRACE_FUNCTIONS, "SusiTraceShm has no room for every call");
+
+static const char *traceCallNames[TRACE_CALL_COUNT] = { SUSI_CALLS(TRACE_NAME) };
+
+SUSI_CALLS(TRACE_POINTER)
+
+static SusiTraceShm *shm = NULL;
+
+static pthread_mutex_t recordLock = PTHREAD_MUTEX_INITIALIZER;
+static FILE *recordFile = NULL;
+static const char *recordPath;
+static uint64_t recordStartNs;
+static uint64_t recordFlushedNs;
+static uint64_t recordCount;
+static uint64_t recordOverflows;          // Calls whose buffers did not fit and were recorded empty
+static uint8_t recordThreads;
+static __thread uint8_t recordThread;
+
+static void countStatus(SusiTraceFunction *function, SusiStatus_t status) {
+    for (int i = 0; i < SUSI_TRACE_STATUS_SLOTS; i++) {
+        SusiTraceStatus *slot = &function->statuses[i];
+        uint64_t key = (uint64_t)status + 1;
+        uint64_t seen = __atomic_load_n(&slot->statusPlusOne, __ATOMIC_ACQUIRE);
+
+        if (seen == 0) {
+            uint64_t expected = 0;
+
+            // Claim the slot, or find that another thread claimed it first
+            if (__atomic_compare_exchange_n(&slot->statusPlusOne, &expected, key, false,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                seen = key;
+            } else {
+                seen = expected;
+            }
+        }
+        if (seen == key) {
+            __atomic_fetch_add(&slot->count, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+    __atomic_fetch_add(&function->otherStatuses, 1, __ATOMIC_RELAXED);
+}
+
+static uint64_t traceEnter(TraceCall call) {
+    if (shm != NULL) {
+        __atomic_fetch_add(&shm->functions[call].inFlight, 1, __ATOMIC_RELAXED);
+    }
+    return monotonicNowNs();
+}
+
+// Returns how long the call took
+static uint64_t traceLeave(TraceCall call, uint64_t startNs, SusiStatus_t status) {
+    uint64_t elapsed = monotonicNowNs() - startNs;
+    SusiTraceFunction *function;
+
+    if (shm == NULL) {
+        return elapsed;
+    }
+    function = &shm->functions[call];
+    histogramRecord(&function->latency, elapsed);
+    countStatus(function, status);
+    __atomic_fetch_sub(&function->inFlight, 1, __ATOMIC_RELAXED);
+    return elapsed;
+}
+
+static SusiRecordStream* recordInputs(RecordBuffers *buffers) {
+    buffers->inputStream = (SusiRecordStream){ buffers->input, 0, sizeof(buffers->input), false };
+    buffers->outputStream = (SusiRecordStream){ buffers->output, 0, sizeof(buffers->output), false };
+    return &buffers->inputStream;
+}
+
+// Outputs of failed calls are whatever the caller passed in; not kept
+static SusiRecordStream* recordOutputs(RecordBuffers *buffers, SusiStatus_t status) {
+    if (status != SUSI_STATUS_SUCCESS && status != SUSI_STATUS_MORE_DATA) {
+        return NULL;
+    }
+    return &buffers->outputStream;
+}
+
+static void recordCall(TraceCall call, const RecordBuffers *buffers, uint64_t startNs, uint64_t durationNs,
+                       SusiStatus_t status) {
+    SusiRecord record;
+
+    if (recordThread == 0) {
+        recordThread = __atomic_add_fetch(&recordThreads, 1, __ATOMIC_RELAXED);
+    }
+    record.call = (uint8_t)call;
+    record.thread = recordThread;
+    record.status = status;
+    record.startNs = startNs - recordStartNs;
+    record.durationNs = durationNs;
+    record.input = buffers->input;
+    record.inputLength = buffers->inputStream.length;
+    record.output = buffers->output;
+    record.outputLength = buffers->outputStream.length;
+
+    pthread_mutex_lock(&recordLock);
+    if (recordFile != NULL) {
+        if (!susiRecordWrite(recordFile, &record)) {
+            fprintf(stderr, "susi_trace: cannot write %s, recording stopped\n", recordPath);
+            fclose(recordFile);
+            recordFile = NULL;
+        } else {
+            recordCount++;
+            recordOverflows += buffers->inputStream.overflow || buffers->outputStream.overflow;
+            // A crash loses at most the last second
+            if (startNs - recordFlushedNs > RECORD_FLUSH_NS) {
+                fflush(recordFile);
+                recordFlushedNs = startNs;
+            }
+        }
+    }
+    pthread_mutex_unlock(&recordLock);
+}
+
+#define TRACE_WRAPPER(name, params, args, inputs, outputs) \
+    TRACE_EXPORT SusiStatus_t SUSI_API name params { \
+        SusiStatus_t status; \
+        uint64_t start, elapsed; \
+        if (real##name == NULL) { \
+            return SUSI_STATUS_NOT_INITIALIZED; \
+        } \
+        if (__atomic_load_n(&recordFile, __ATOMIC_RELAXED) != NULL) { \
+            RecordBuffers buffers; \
+            SusiRecordStream *recordStream = recordInputs(&buffers); \
+            SUSI_RECORD_EXPAND inputs \
+            start = traceEnter(TRACE_##name); \
+            status = real##name args; \
+            elapsed = traceLeave(TRACE_##name, start, status); \
+            recordStream = recordOutputs(&buffers, status); \
+            if (recordStream != NULL) { \
+                SUSI_RECORD_EXPAND outputs \
+            } \
+            (void)recordStream; \
+            recordCall(TRACE_##name, &buffers, start, elapsed, status); \
+            return status; \
+        } \
+        start = traceEnter(TRACE_##name); \
+        status = real##name args; \
+        (void)traceLeave(TRACE_##name, start, status); \
+        return status; \
+    }
+
+SUSI_CALLS(TRACE_WRAPPER)
+
+static SusiTraceShm* createShm(void) {
+    const char *name = getenv("SUSI_TRACE_NAME");
+    char defaultName[32];
+    SusiTraceShm *mapped;
+    int fd;
+
+    if (name == NULL || *name == '\0') {
+        snprintf(defaultName, sizeof(defaultName), "/susi_trace.%d", (int)getpid());
+        name = defaultName;
+    }
+    fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "susi_trace: shm_open %s failed, calls are not traced\n", name);
+        return NULL;
+    }
+    if (ftruncate(fd, sizeof(SusiTraceShm)) != 0) {
+        fprintf(stderr, "susi_trace: cannot size %s, calls are not traced\n", name);
+        close(fd);
+        return NULL;
+    }
+    mapped = mmap(NULL, sizeof(SusiTraceShm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        fprintf(stderr, "susi_trace: cannot map %s, calls are not traced\n", name);
+        return NULL;
+    }
+    for (int i = 0; i < TRACE_CALL_COUNT; i++) {
+        snprintf(mapped->functions[i].name, sizeof(mapped->functions[i].name), "%s", traceCallNames[i]);
+    }
+    mapped->functionCount = TRACE_CALL_COUNT;
+    mapped->pid = (uint32_t)getpid();
+    mapped->startedNs = monotonicNowNs();
+    mapped->version = SUSI_TRACE_VERSION;
+    // Published last: a reader that sees the magic sees the names
+    __atomic_store_n(&mapped->magic, SUSI_TRACE_MAGIC, __ATOMIC_RELEASE);
+    fprintf(stderr, "susi_trace: tracing %d SUSI calls into %s\n", TRACE_CALL_COUNT, name);
+    return mapped;
+}
+
+static FILE* openRecording(const char *path) {
+    FILE *file = fopen(path, "wb");
+
+    if (file == NULL) {
+        fprintf(stderr, "susi_trace: cannot create %s, calls are not recorded\n", path);
+        return NULL;
+    }
+    setvbuf(file, NULL, _IOFBF, RECORD_BUFFER_BYTES);
+    if (!susiRecordWriteHeader(file, traceCallNames, TRACE_CALL_COUNT)) {
+        fprintf(stderr, "susi_trace: cannot write %s, calls are not recorded\n", path);
+        fclose(file);
+        return NULL;
+    }
+    recordStartNs = recordFlushedNs = monotonicNowNs();
+    fprintf(stderr, "susi_trace: recording SUSI calls into %s\n", path);
+    return file;
+}
+
+__attribute__((constructor))
+static void traceLoad(void) {
+    const char *path = getenv("SUSI_TRACE_RECORD");
+
+    SUSI_CALLS(TRACE_RESOLVE)
+    if (realSusiLibInitialize == NULL) {
+        fprintf(stderr, "susi_trace: no libSUSI-4.00.so behind the shim, every call will fail\n");
+    }
+    shm = createShm();
+    if (path != NULL && *path != '\0') {
+        recordPath = path;
+        recordFile = openRecording(path);
+    }
+}
+
+__attribute__((destructor))
+static void traceUnload(void) {
+    pthread_mutex_lock(&recordLock);
+    if (recordFile != NULL) {
+        fclose(recordFile);
+        recordFile = NULL;
+        fprintf(stderr, "susi_trace: recorded %llu SUSI calls into %s", (unsigned long long)recordCount, recordPath);
+        if (recordOverflows > 0) {
+            fprintf(stderr, ", %llu with buffers too large to keep", (unsigned long long)recordOverflows);
+        }
+        fputc('\n', stderr);
+    }
+    pthread_mutex_unlock(&recordLock);
+}
@@ -0,0 +1,44 @@
+#ifndef SUSI_TRACE_H
+#define SUSI_TRACE_H
+
+#include <stdint.h>
+#include "histogram.h"
+
+// Shared-memory layout written by libsusi_trace.so and read by susi_trace.
+//
+// The shim is preloaded in front of libSUSI-4.00.so:
+//     LD_PRELOAD=./libsusi_trace.so ./watchdog_http_service
+// and times every Susi* call into /dev/shm/susi_trace.<pid> (or the name
+// in SUSI_TRACE_NAME). Every counter is bumped with relaxed atomics, so
+// the reader maps the segment read-only while the process runs and sees
+// a slightly inconsistent but monotonic view, as with /metrics.
+
+#define SUSI_TRACE_MAGIC 0x52545553u      // "SUTR"
+#define SUSI_TRACE_VERSION 1
+#define SUSI_TRACE_FUNCTIONS 80           // Room for every Susi4.h entry point
+#define SUSI_TRACE_STATUS_SLOTS 6         // Distinct statuses counted per function; the rest are "other"
+#define SUSI_TRACE_NAME_MAX 40
+
+typedef struct {
+    uint64_t statusPlusOne;               // 0: slot free; 64 bits so 0xFFFFFFFF does not wrap
+    uint64_t count;
+} SusiTraceStatus;
+
+typedef struct {
+    char name[SUSI_TRACE_NAME_MAX];
+    uint64_t inFlight;                    // Calls started and not yet returned
+    uint64_t otherStatuses;
+    SusiTraceStatus statuses[SUSI_TRACE_STATUS_SLOTS];
+    Histogram latency;
+} SusiTraceFunction;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t functionCount;
+    uint32_t pid;
+    uint64_t startedNs;                   // CLOCK_MONOTONIC at load
+    SusiTraceFunction functions[SUSI_TRACE_FUNCTIONS];
+} SusiTraceShm;
+
+#endif // SUSI_TRACE_H
@@ -0,0 +1,327 @@
+// Reader for the shared-memory segment of libsusi_trace.so. Prints, per
+// Susi* function, the calls, the calls in flight, latency percentiles and
+// the statuses returned, busiest functions first. The traced process keeps
+// running; the segment is mapped read-only.
+//
+//   susi_trace PID|NAME            totals since the process loaded the shim
+//   susi_trace -i 5 PID|NAME       every 5 s, what happened in the last 5 s
+//   susi_trace -a PID|NAME         include functions never called
+//   susi_trace -u PID|NAME         remove the segment (after the process exited)
+//   susi_trace -r FILE             list the calls in a SUSI_TRACE_RECORD recording
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "Susi4.h"
+#include "susi_record.h"
+#include "susi_trace.h"
+
+#define DUMP_BYTES 24             // Argument bytes shown per record
+
+typedef struct {
+    int index;
+    uint64_t totalNs;
+} Row;
+
+// Values only, so a delta can be taken between two copies
+typedef struct {
+    SusiTraceFunction functions[SUSI_TRACE_FUNCTIONS];
+} TraceCopy;
+
+static const char* statusName(SusiStatus_t status) {
+    switch (status) {
+    case SUSI_STATUS_SUCCESS:           return "ok";
+    case SUSI_STATUS_NOT_INITIALIZED:   return "not_initialized";
+    case SUSI_STATUS_INVALID_PARAMETER: return "invalid_parameter";
+    case SUSI_STATUS_UNSUPPORTED:       return "unsupported";
+    case SUSI_STATUS_NOT_FOUND:         return "not_found";
+    case SUSI_STATUS_TIMEOUT:           return "timeout";
+    case SUSI_STATUS_NOACK:             return "noack";
+    case SUSI_STATUS_NORESPONSE:        return "noresponse";
+    case SUSI_STATUS_LOCKFAIL:          return "lockfail";
+    case SUSI_STATUS_DEVICE_ERROR:      return "device_error";
+    case SUSI_STATUS_READ_ERROR:        return "read_error";
+    case SUSI_STATUS_WRITE_ERROR:       return "write_error";
+    case SUSI_STATUS_MORE_DATA:         return "more_data";
+    case SUSI_STATUS_ERROR:             return "error";
+    default:                            return NULL;
+    }
+}
+
+static void formatNs(char *buffer, size_t size, uint64_t ns) {
+    if (ns < 1000000) {
+        snprintf(buffer, size, "%.1fus", ns / 1e3);
+    } else {
+        snprintf(buffer, size, "%.2fms", ns / 1e6);
+    }
+}
+
+static void copyShm(const SusiTraceShm *shm, TraceCopy *copy) {
+    for (uint32_t i = 0; i < shm->functionCount; i++) {
+        const SusiTraceFunction *src = &shm->functions[i];
+        SusiTraceFunction *dst = &copy->functions[i];
+
+        memcpy(dst->name, src->name, sizeof(dst->name));
+        dst->inFlight = __atomic_load_n(&src->inFlight, __ATOMIC_RELAXED);
+        dst->otherStatuses = __atomic_load_n(&src->otherStatuses, __ATOMIC_RELAXED);
+        for (int s = 0; s < SUSI_TRACE_STATUS_SLOTS; s++) {
+            dst->statuses[s].statusPlusOne = __atomic_load_n(&src->statuses[s].statusPlusOne, __ATOMIC_ACQUIRE);
+            dst->statuses[s].count = __atomic_load_n(&src->statuses[s].count, __ATOMIC_RELAXED);
+        }
+        dst->latency.count = __atomic_load_n(&src->latency.count, __ATOMIC_RELAXED);
+        dst->latency.sumNs = __atomic_load_n(&src->latency.sumNs, __ATOMIC_RELAXED);
+        dst->latency.maxNs = __atomic_load_n(&src->latency.maxNs, __ATOMIC_RELAXED);
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+            dst->latency.buckets[b] = __atomic_load_n(&src->latency.buckets[b], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// now -= before; the maximum stays the running one, it cannot be windowed
+static void subtractCopy(TraceCopy *now, const TraceCopy *before, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        SusiTraceFunction *f = &now->functions[i];
+        const SusiTraceFunction *p = &before->functions[i];
+
+        f->otherStatuses -= p->otherStatuses;
+        // Slots are claimed once and never move, so the same index is the same status
+        for (int s = 0; s < SUSI_TRACE_STATUS_SLOTS; s++) {
+            f->statuses[s].count -= p->statuses[s].count;
+        }
+        f->latency.count -= p->latency.count;
+        f->latency.sumNs -= p->latency.sumNs;
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++) {
+            f->latency.buckets[b] -= p->latency.buckets[b];
+        }
+    }
+}
+
+static int compareRows(const void *a, const void *b) {
+    const Row *x = a;
+    const Row *y = b;
+
+    if (x->totalNs != y->totalNs) {
+        return x->totalNs < y->totalNs ? 1 : -1;
+    }
+    return x->index - y->index;
+}
+
+static void printTable(const TraceCopy *copy, uint32_t count, bool all) {
+    Row rows[SUSI_TRACE_FUNCTIONS];
+    int rowCount = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        const Histogram *latency = &copy->functions[i].latency;
+
+        if (!all && latency->count == 0 && copy->functions[i].inFlight == 0) {
+            continue;
+        }
+        rows[rowCount].index = (int)i;
+        rows[rowCount].totalNs = latency->sumNs;
+        rowCount++;
+    }
+    qsort(rows, rowCount, sizeof(Row), compareRows);
+
+    printf("%-32s %10s %5s %10s %10s %10s %10s %10s  %s\n",
+           "function", "calls", "busy", "total", "p50", "p99", "p999", "max", "statuses");
+    for (int r = 0; r < rowCount; r++) {
+        const SusiTraceFunction *f = &copy->functions[rows[r].index];
+        char total[16], p50[16], p99[16], p999[16], max[16];
+
+        formatNs(total, sizeof(total), f->latency.sumNs);
+        formatNs(p50, sizeof(p50), histogramQuantile(&f->latency, 0.5));
+        formatNs(p99, sizeof(p99), histogramQuantile(&f->latency, 0.99));
+        formatNs(p999, sizeof(p999), histogramQuantile(&f->latency, 0.999));
+        formatNs(max, sizeof(max), f->latency.maxNs);
+        printf("%-32s %10llu %5llu %10s %10s %10s %10s %10s ", f->name, (unsigned long long)f->latency.count,
+               (unsigned long long)f->inFlight, total, p50, p99, p999, max);
+        for (int s = 0; s < SUSI_TRACE_STATUS_SLOTS; s++) {
+            SusiStatus_t status;
+            const char *name;
+
+            if (f->statuses[s].statusPlusOne == 0 || f->statuses[s].count == 0) {
+                continue;
+            }
+            status = (SusiStatus_t)(f->statuses[s].statusPlusOne - 1);
+            name = statusName(status);
+            if (name != NULL) {
+                printf(" %s=%llu", name, (unsigned long long)f->statuses[s].count);
+            } else {
+                printf(" 0x%08x=%llu", (unsigned int)status, (unsigned long long)f->statuses[s].count);
+            }
+        }
+        if (f->otherStatuses != 0) {
+            printf(" other=%llu", (unsigned long long)f->otherStatuses);
+        }
+        putchar('\n');
+    }
+}
+
+static void printHex(const char *label, const uint8_t *bytes, size_t length) {
+    printf(" %s=", label);
+    for (size_t i = 0; i < length && i < DUMP_BYTES; i++) {
+        printf("%02x", bytes[i]);
+    }
+    if (length > DUMP_BYTES) {
+        printf("...(%zu)", length);
+    }
+}
+
+// One line per recorded call: start, thread, call, duration, status, and the
+// encoded inputs and outputs
+static int printRecording(const char *path) {
+    const char *names[256];
+    int nameCount, result;
+    SusiRecordCursor cursor;
+    SusiRecord record;
+    uint8_t *data;
+    long size;
+    FILE *file = fopen(path, "rb");
+
+    if (file == NULL) {
+        perror(path);
+        return 1;
+    }
+    if (fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0 ||
+        (data = malloc(size > 0 ? (size_t)size : 1)) == NULL) {
+        perror(path);
+        fclose(file);
+        return 1;
+    }
+    if (fread(data, 1, (size_t)size, file) != (size_t)size) {
+        perror(path);
+        fclose(file);
+        free(data);
+        return 1;
+    }
+    fclose(file);
+    cursor = (SusiRecordCursor){ data, (size_t)size, 0 };
+    if (!susiRecordReadHeader(&cursor, names, 256, &nameCount)) {
+        fprintf(stderr, "%s is not a SUSI call recording of version %d\n", path, SUSI_RECORD_VERSION);
+        free(data);
+        return 1;
+    }
+    while ((result = susiRecordRead(&cursor, &record)) > 0) {
+        const char *status = statusName((SusiStatus_t)record.status);
+        char duration[16];
+
+        formatNs(duration, sizeof(duration), record.durationNs);
+        printf("%12.6f %3u %-32s %10s ", record.startNs / 1e9, record.thread,
+               record.call < nameCount ? names[record.call] : "?", duration);
+        if (status != NULL) {
+            printf("%-17s", status);
+        } else {
+            printf("0x%08x       ", (unsigned int)record.status);
+        }
+        printHex("in", record.input, record.inputLength);
+        if (record.outputLength > 0) {
+            printHex("out", record.output, record.outputLength);
+        }
+        putchar('\n');
+    }
+    free(data);
+    if (result < 0) {
+        fprintf(stderr, "%s is cut short after the calls above\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [-a] [-i SECONDS] [-u] PID|NAME\n", program);
+    fprintf(stderr, "       %s -r FILE\n", program);
+    fprintf(stderr, "  PID reads /susi_trace.PID; NAME is the shim's SUSI_TRACE_NAME\n");
+    fprintf(stderr, "  -a          List functions that were never called\n");
+    fprintf(stderr, "  -i SECONDS  Print what happened in each interval, until interrupted\n");
+    fprintf(stderr, "  -u          Remove the segment\n");
+    fprintf(stderr, "  -r FILE     List the calls in a recording made with SUSI_TRACE_RECORD\n");
+}
+
+int main(int argc, char *argv[]) {
+    const SusiTraceShm *shm;
+    static TraceCopy before, now, delta;
+    char name[64];
+    bool all = false, unlinkSegment = false;
+    int interval = 0;
+    int option;
+    int fd;
+
+    while ((option = getopt(argc, argv, "ai:ur:h")) != -1) {
+        switch (option) {
+        case 'r':
+            return printRecording(optarg);
+        case 'a':
+            all = true;
+            break;
+        case 'i':
+            interval = atoi(optarg);
+            if (interval <= 0) {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'u':
+            unlinkSegment = true;
+            break;
+        default:
+            usage(argv[0]);
+            return option == 'h' ? 0 : 2;
+        }
+    }
+    if (optind + 1 != argc) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (strspn(argv[optind], "0123456789") == strlen(argv[optind])) {
+        snprintf(name, sizeof(name), "/susi_trace.%s", argv[optind]);
+    } else {
+        snprintf(name, sizeof(name), "%s%s", argv[optind][0] == '/' ? "" : "/", argv[optind]);
+    }
+    if (unlinkSegment) {
+        if (shm_unlink(name) != 0) {
+            perror(name);
+            return 1;
+        }
+        return 0;
+    }
+
+    fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        perror(name);
+        return 1;
+    }
+    shm = mmap(NULL, sizeof(SusiTraceShm), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shm == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+    if (__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) != SUSI_TRACE_MAGIC ||
+        shm->version != SUSI_TRACE_VERSION || shm->functionCount > SUSI_TRACE_FUNCTIONS) {
+        fprintf(stderr, "%s is not a susi_trace segment of version %d\n", name, SUSI_TRACE_VERSION);
+        return 1;
+    }
+
+    copyShm(shm, &now);
+    if (interval == 0) {
+        printf("pid %u\n", shm->pid);
+        printTable(&now, shm->functionCount, all);
+        return 0;
+    }
+    for (;;) {
+        before = now;
+        sleep((unsigned int)interval);
+        copyShm(shm, &now);
+        delta = now;
+        subtractCopy(&delta, &before, shm->functionCount);
+        printf("pid %u, last %d s\n", shm->pid, interval);
+        printTable(&delta, shm->functionCount, all);
+        putchar('\n');
+        fflush(stdout);
+    }
+}
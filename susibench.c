@@ -0,0 +1,433 @@
+// Microbenchmark of the SUSI driver, one API at a time, for qualifying new
+// driver and BIOS releases on each board model. Every API runs a warmup and
+// then N timed calls back to back on one thread; the report gives min,
+// median, p99, max and calls per second as JSON on stdout. With --baseline
+// the medians are compared to an earlier report and the exit status is 3
+// when any API got slower by more than the tolerance.
+//
+// Calls that could change the board are opt-in: --wdog starts watchdog 1
+// with a 60 s reset for the trigger benchmark and stops it afterwards, and
+// the bus benchmarks need the device address to talk to.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <jansson.h>
+#include "Susi4.h"
+#include "json_writer.h"
+#include "strbuf.h"
+#include "susi_session.h"
+#include "timeutil.h"
+
+#define DEFAULT_ITERATIONS 1000
+#define DEFAULT_WARMUP 100
+#define DEFAULT_TOLERANCE_PCT 25.0
+#define STORAGE_READ_BYTES 16
+#define WDOG_BENCH_RESET_MS 60000
+#define OUTPUT_CAPACITY 32768
+
+typedef struct {
+    bool wdog;
+    int i2cAddress;           // 7-bit, -1 when not given
+    int smbusAddress;
+    uint32_t gpioMask;        // Input pins of bank 0, from its caps
+    uint8_t buffer[STORAGE_READ_BYTES];
+    char text[64];
+} BenchContext;
+
+typedef struct {
+    const char *name;
+    // NULL when the API can run, else why it was skipped
+    const char* (*setup)(BenchContext *context);
+    SusiStatus_t (*run)(BenchContext *context);
+    void (*teardown)(BenchContext *context);
+} BenchCase;
+
+typedef struct {
+    const char *skipped;
+    SusiStatus_t setupStatus;
+    uint64_t errors;
+    uint64_t minNs, medianNs, p99Ns, maxNs;
+    double opsPerSecond;
+} BenchResult;
+
+static SusiStatus_t lastSetupStatus;
+
+// Setup probes: one call that must succeed before timing starts
+
+static const char* probe(SusiStatus_t status) {
+    lastSetupStatus = status;
+    return status == SUSI_STATUS_SUCCESS ? NULL : "call failed";
+}
+
+static const char* setupBoardValue(BenchContext *context) {
+    uint32_t value;
+    (void)context;
+    return probe(SusiBoardGetValue(SUSI_ID_HWM_TEMP_CPU, &value));
+}
+
+static SusiStatus_t runBoardValue(BenchContext *context) {
+    uint32_t value;
+    (void)context;
+    return SusiBoardGetValue(SUSI_ID_HWM_TEMP_CPU, &value);
+}
+
+static SusiStatus_t runBoardString(BenchContext *context) {
+    uint32_t length = sizeof(context->text);
+    return SusiBoardGetStringA(SUSI_ID_BOARD_NAME_STR, context->text, &length);
+}
+
+static const char* setupBoardString(BenchContext *context) {
+    return probe(runBoardString(context));
+}
+
+static const char* setupWdog(BenchContext *context) {
+    if (!context->wdog) {
+        return "needs --wdog";
+    }
+    return probe(SusiWDogStart(SUSI_ID_WATCHDOG_1, 0, 0, WDOG_BENCH_RESET_MS, SUSI_WDT_EVENT_TYPE_NONE));
+}
+
+static SusiStatus_t runWdog(BenchContext *context) {
+    (void)context;
+    return SusiWDogTrigger(SUSI_ID_WATCHDOG_1);
+}
+
+static void teardownWdog(BenchContext *context) {
+    (void)context;
+    SusiWDogStop(SUSI_ID_WATCHDOG_1);
+}
+
+static const char* setupGpioLevel(BenchContext *context) {
+    const char *skipped = probe(SusiGPIOGetCaps(SUSI_ID_GPIO_BANK(0), SUSI_ID_GPIO_INPUT_SUPPORT, &context->gpioMask));
+
+    if (skipped == NULL && context->gpioMask == 0) {
+        return "bank 0 has no input pins";
+    }
+    return skipped;
+}
+
+static SusiStatus_t runGpioLevel(BenchContext *context) {
+    uint32_t level;
+    return SusiGPIOGetLevel(SUSI_ID_GPIO_BANK(0), context->gpioMask, &level);
+}
+
+static SusiStatus_t runI2cCombine(BenchContext *context) {
+    uint8_t reg = 0;
+    return SusiI2CWriteReadCombine(SUSI_ID_I2C_EXTERNAL, (uint8_t)SUSI_I2C_ENC_7BIT_ADDR(context->i2cAddress),
+                                   &reg, 1, context->buffer, 1);
+}
+
+static const char* setupI2cCombine(BenchContext *context) {
+    if (context->i2cAddress < 0) {
+        return "needs --i2c ADDR";
+    }
+    return probe(runI2cCombine(context));
+}
+
+static SusiStatus_t runSmbusByte(BenchContext *context) {
+    return SusiSMBReadByte(SUSI_ID_SMBUS_EXTERNAL, (uint8_t)(context->smbusAddress << 1), 0, context->buffer);
+}
+
+static const char* setupSmbusByte(BenchContext *context) {
+    if (context->smbusAddress < 0) {
+        return "needs --smbus ADDR";
+    }
+    return probe(runSmbusByte(context));
+}
+
+static SusiStatus_t runStorageRead(BenchContext *context) {
+    return SusiStorageAreaRead(SUSI_ID_STORAGE_STD, 0, context->buffer, STORAGE_READ_BYTES);
+}
+
+static const char* setupStorageRead(BenchContext *context) {
+    return probe(runStorageRead(context));
+}
+
+static SusiStatus_t runBacklight(BenchContext *context) {
+    uint32_t brightness;
+    (void)context;
+    return SusiVgaGetBacklightBrightness(SUSI_ID_BACKLIGHT_1, &brightness);
+}
+
+static const char* setupBacklight(BenchContext *context) {
+    return probe(runBacklight(context));
+}
+
+static const BenchCase benchCases[] = {
+    { "SusiBoardGetValue",             setupBoardValue,  runBoardValue,  NULL },
+    { "SusiBoardGetStringA",           setupBoardString, runBoardString, NULL },
+    { "SusiWDogTrigger",               setupWdog,        runWdog,        teardownWdog },
+    { "SusiGPIOGetLevel",              setupGpioLevel,   runGpioLevel,   NULL },
+    { "SusiI2CWriteReadCombine",       setupI2cCombine,  runI2cCombine,  NULL },
+    { "SusiSMBReadByte",               setupSmbusByte,   runSmbusByte,   NULL },
+    { "SusiStorageAreaRead",           setupStorageRead, runStorageRead, NULL },
+    { "SusiVgaGetBacklightBrightness", setupBacklight,   runBacklight,   NULL },
+};
+
+#define BENCH_CASE_COUNT ((int)(sizeof(benchCases) / sizeof(benchCases[0])))
+
+static int compareNs(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// Nearest-rank percentile of sorted samples
+static uint64_t percentile(const uint64_t *sorted, int count, double q) {
+    int rank = (int)(q * count + 0.999999);
+
+    if (rank < 1) {
+        rank = 1;
+    }
+    return sorted[rank > count ? count - 1 : rank - 1];
+}
+
+static void runCase(const BenchCase *bench, BenchContext *context, int iterations, int warmup,
+                    uint64_t *samples, BenchResult *result) {
+    uint64_t startNs, elapsedNs;
+
+    memset(result, 0, sizeof(*result));
+    lastSetupStatus = SUSI_STATUS_SUCCESS;
+    result->skipped = bench->setup(context);
+    result->setupStatus = lastSetupStatus;
+    if (result->skipped != NULL) {
+        return;
+    }
+    for (int i = 0; i < warmup; i++) {
+        bench->run(context);
+    }
+    startNs = monotonicNowNs();
+    for (int i = 0; i < iterations; i++) {
+        uint64_t callNs = monotonicNowNs();
+
+        if (bench->run(context) != SUSI_STATUS_SUCCESS) {
+            result->errors++;
+        }
+        samples[i] = monotonicNowNs() - callNs;
+    }
+    elapsedNs = monotonicNowNs() - startNs;
+    if (bench->teardown != NULL) {
+        bench->teardown(context);
+    }
+
+    qsort(samples, (size_t)iterations, sizeof(uint64_t), compareNs);
+    result->minNs = samples[0];
+    result->medianNs = percentile(samples, iterations, 0.5);
+    result->p99Ns = percentile(samples, iterations, 0.99);
+    result->maxNs = samples[iterations - 1];
+    result->opsPerSecond = elapsedNs ? iterations * 1e9 / (double)elapsedNs : 0;
+}
+
+// Median of the same API in an earlier report, or a negative value
+static double baselineMedianUs(json_t *baseline, const char *name) {
+    json_t *results = json_object_get(baseline, "results");
+    size_t index;
+    json_t *entry;
+
+    json_array_foreach(results, index, entry) {
+        json_t *api = json_object_get(entry, "api");
+        json_t *median = json_object_get(entry, "median_us");
+
+        if (json_is_string(api) && strcmp(json_string_value(api), name) == 0 && json_is_number(median)) {
+            return json_number_value(median);
+        }
+    }
+    return -1;
+}
+
+static bool selected(const char *only, const char *name) {
+    size_t length = strlen(name);
+    const char *at = only;
+
+    if (only == NULL) {
+        return true;
+    }
+    while ((at = strstr(at, name)) != NULL) {
+        if ((at == only || at[-1] == ',') && (at[length] == '\0' || at[length] == ',')) {
+            return true;
+        }
+        at += length;
+    }
+    return false;
+}
+
+static void usage(const char *program) {
+    printf("SUSI driver microbenchmark\n");
+    printf("Usage: %s [options]\n", program);
+    printf("Options:\n");
+    printf("  --iterations N       Timed calls per API (default: %d)\n", DEFAULT_ITERATIONS);
+    printf("  --warmup N           Untimed calls first (default: %d)\n", DEFAULT_WARMUP);
+    printf("  --only API[,API]     Run only these APIs\n");
+    printf("  --wdog               Benchmark SusiWDogTrigger (starts watchdog 1 with a %d s reset)\n",
+           WDOG_BENCH_RESET_MS / 1000);
+    printf("  --i2c ADDR           Benchmark SusiI2CWriteReadCombine against a 7-bit address\n");
+    printf("  --smbus ADDR         Benchmark SusiSMBReadByte against a 7-bit address\n");
+    printf("  --baseline FILE      Compare medians with an earlier report\n");
+    printf("  --tolerance PCT      Slowdown allowed before an API counts as regressed (default: %.0f)\n",
+           DEFAULT_TOLERANCE_PCT);
+    printf("  --help, -h           Show this help message\n");
+}
+
+int main(int argc, char *argv[]) {
+    BenchContext context = { .wdog = false, .i2cAddress = -1, .smbusAddress = -1 };
+    BenchResult result;
+    int iterations = DEFAULT_ITERATIONS;
+    int warmup = DEFAULT_WARMUP;
+    double tolerance = DEFAULT_TOLERANCE_PCT;
+    const char *only = NULL;
+    const char *baselinePath = NULL;
+    json_t *baseline = NULL;
+    json_error_t error;
+    uint64_t *samples;
+    uint32_t value, length;
+    char text[64];
+    char *output;
+    StrBuf out;
+    JsonWriter writer;
+    int regressions = 0;
+    SusiStatus_t status;
+    pid_t owner;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            warmup = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+            only = argv[++i];
+        } else if (strcmp(argv[i], "--wdog") == 0) {
+            context.wdog = true;
+        } else if (strcmp(argv[i], "--i2c") == 0 && i + 1 < argc) {
+            context.i2cAddress = (int)strtol(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--smbus") == 0 && i + 1 < argc) {
+            context.smbusAddress = (int)strtol(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            usage(argv[0]);
+            return 0;
+        } else {
+            fprintf(stderr, "Unknown option '%s'\n", argv[i]);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (iterations <= 0 || warmup < 0 || tolerance < 0) {
+        fprintf(stderr, "Iterations must be positive, warmup and tolerance not negative\n");
+        return 1;
+    }
+    if (context.i2cAddress > 0x7f || context.smbusAddress > 0x7f) {
+        fprintf(stderr, "Bus addresses are 7-bit (0x00-0x7f)\n");
+        return 1;
+    }
+    if (baselinePath != NULL) {
+        baseline = json_load_file(baselinePath, 0, &error);
+        if (baseline == NULL) {
+            fprintf(stderr, "Cannot read baseline %s: %s (line %d)\n", baselinePath, error.text, error.line);
+            return 1;
+        }
+    }
+
+    samples = malloc((size_t)iterations * sizeof(uint64_t));
+    output = malloc(OUTPUT_CAPACITY);
+    if (samples == NULL || output == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    // Another SUSI user would be measured along with the driver
+    if (susiSessionAcquire(SUSI_SESSION_DEFAULT_LOCK, "susibench", &owner) == -1) {
+        susiSessionOwner(SUSI_SESSION_DEFAULT_LOCK, text, sizeof(text));
+        fprintf(stderr, "SUSI is in use by pid %ld (%s); stop it before benchmarking\n",
+                (long)owner, text[0] ? text : "unknown");
+        return 1;
+    }
+    status = SusiLibInitialize();
+    if (status != SUSI_STATUS_SUCCESS && status != SUSI_STATUS_INITIALIZED) {
+        fprintf(stderr, "SusiLibInitialize failed (status 0x%08x)\n", (unsigned int)status);
+        return 1;
+    }
+
+    strbufInit(&out, output, OUTPUT_CAPACITY);
+    jsonWriterInit(&writer, &out);
+    jsonBeginObject(&writer);
+    // Which board, BIOS and driver the numbers belong to
+    length = sizeof(text);
+    if (SusiBoardGetStringA(SUSI_ID_BOARD_NAME_STR, text, &length) == SUSI_STATUS_SUCCESS) {
+        jsonFieldString(&writer, "board", text);
+    }
+    length = sizeof(text);
+    if (SusiBoardGetStringA(SUSI_ID_BOARD_BIOS_REVISION_STR, text, &length) == SUSI_STATUS_SUCCESS) {
+        jsonFieldString(&writer, "bios", text);
+    }
+    if (SusiBoardGetValue(SUSI_ID_BOARD_DRIVER_VERSION_VAL, &value) == SUSI_STATUS_SUCCESS) {
+        snprintf(text, sizeof(text), "0x%08x", value);
+        jsonFieldString(&writer, "driver_version", text);
+    }
+    if (SusiBoardGetValue(SUSI_ID_BOARD_FIRMWARE_VERSION_VAL, &value) == SUSI_STATUS_SUCCESS) {
+        snprintf(text, sizeof(text), "0x%08x", value);
+        jsonFieldString(&writer, "firmware_version", text);
+    }
+    jsonFieldInt(&writer, "iterations", iterations);
+    jsonFieldInt(&writer, "warmup", warmup);
+    if (baseline != NULL) {
+        jsonFieldString(&writer, "baseline", baselinePath);
+        jsonFieldDouble(&writer, "tolerance_pct", tolerance, 1);
+    }
+    jsonKey(&writer, "results");
+    jsonBeginArray(&writer);
+    for (int c = 0; c < BENCH_CASE_COUNT; c++) {
+        const BenchCase *bench = &benchCases[c];
+        double baselineUs;
+
+        if (!selected(only, bench->name)) {
+            continue;
+        }
+        fprintf(stderr, "%s...\n", bench->name);
+        runCase(bench, &context, iterations, warmup, samples, &result);
+
+        jsonBeginObject(&writer);
+        jsonFieldString(&writer, "api", bench->name);
+        if (result.skipped != NULL) {
+            jsonFieldString(&writer, "skipped", result.skipped);
+            if (result.setupStatus != SUSI_STATUS_SUCCESS) {
+                snprintf(text, sizeof(text), "0x%08x", (unsigned int)result.setupStatus);
+                jsonFieldString(&writer, "status", text);
+            }
+            jsonEndObject(&writer);
+            continue;
+        }
+        jsonFieldUint(&writer, "errors", result.errors);
+        jsonFieldDouble(&writer, "min_us", result.minNs / 1e3, 3);
+        jsonFieldDouble(&writer, "median_us", result.medianNs / 1e3, 3);
+        jsonFieldDouble(&writer, "p99_us", result.p99Ns / 1e3, 3);
+        jsonFieldDouble(&writer, "max_us", result.maxNs / 1e3, 3);
+        jsonFieldDouble(&writer, "ops_per_sec", result.opsPerSecond, 0);
+        baselineUs = baseline != NULL ? baselineMedianUs(baseline, bench->name) : -1;
+        if (baselineUs > 0) {
+            double change = (result.medianNs / 1e3 - baselineUs) * 100.0 / baselineUs;
+            bool regressed = change > tolerance;
+
+            jsonFieldDouble(&writer, "baseline_median_us", baselineUs, 3);
+            jsonFieldDouble(&writer, "change_pct", change, 1);
+            jsonFieldBool(&writer, "regressed", regressed);
+            regressions += regressed;
+        }
+        jsonEndObject(&writer);
+    }
+    jsonEndArray(&writer);
+    if (baseline != NULL) {
+        jsonFieldInt(&writer, "regressions", regressions);
+    }
+    jsonEndObject(&writer);
+    printf("%s\n", output);
+
+    SusiLibUninitialize();
+    json_decref(baseline);
+    free(output);
+    free(samples);
+    return regressions > 0 ? 3 : 0;
+}
@@ -0,0 +1,869 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "systemd_bridge.h"
+#include "hw_actor.h"
+#include "metrics.h"
+#include "timeutil.h"
+
+#define SYSTEMD_RETRY_MS 1000
+#define SYSTEMD_IO_TIMEOUT_MS 2000       // Handshake and sends on the bus socket
+#define SYSTEMD_RX_BYTES 65536           // Largest bus message kept
+#define SYSTEMD_TX_BYTES 1024
+
+#define DBUS_CALL 1
+#define DBUS_RETURN 2
+#define DBUS_ERROR 3
+#define DBUS_SIGNAL 4
+#define DBUS_NO_REPLY 0x1
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define DBUS_NATIVE_ENDIAN 'B'
+#else
+#define DBUS_NATIVE_ENDIAN 'l'
+#endif
+
+#define DBUS_FIELD_PATH 1
+#define DBUS_FIELD_INTERFACE 2
+#define DBUS_FIELD_MEMBER 3
+#define DBUS_FIELD_DESTINATION 6
+#define DBUS_FIELD_REPLY_SERIAL 5
+#define DBUS_FIELD_SIGNATURE 8
+
+#define SYSTEMD_SERVICE "org.freedesktop.systemd1"
+#define SYSTEMD_UNIT_INTERFACE "org.freedesktop.systemd1.Unit"
+#define DBUS_PROPERTIES "org.freedesktop.DBus.Properties"
+
+typedef struct {
+    char name[SYSTEMD_UNIT_NAME_MAX];
+    char path[SYSTEMD_UNIT_NAME_MAX * 3 + 32];   // Escaped object path
+    char state[32];             // ActiveState, "" until known
+    bool healthy;
+    uint32_t getSerial;         // Outstanding Properties.Get
+    uint64_t changes;           // ActiveState transitions seen
+} SystemdUnit;
+
+typedef struct {
+    const unsigned char *data;
+    size_t length;
+    size_t pos;
+    bool big;                   // Sender's byte order
+} BusCursor;
+
+static SystemdUnit units[SYSTEMD_MAX_UNITS];
+static int unitCount = 0;
+static pthread_mutex_t unitLock = PTHREAD_MUTEX_INITIALIZER;
+
+static int notifyFd = -1;
+static struct sockaddr_un notifyAddr;
+static socklen_t notifyLength = 0;
+static uint64_t pingIntervalNs = 0;     // Half of WATCHDOG_USEC, 0 without WatchdogSec=
+static uint64_t hwPosted = 0;           // No-ops posted to the hardware thread
+static uint64_t hwRan = 0;              // Latest of them that ran
+
+static char busPath[108] = SYSTEMD_DEFAULT_BUS;
+static int busFd = -1;
+static uint32_t busSerial = 0;
+static uint64_t retryAtNs = 0;
+static unsigned char rx[SYSTEMD_RX_BYTES];
+static size_t rxLength = 0;
+
+static pthread_t bridgeThread;
+static bool bridgeActive = false;
+static bool stopping = false;
+static int stopFd = -1;
+
+static bool busConnected = false;
+static uint64_t pingsSent = 0;
+static uint64_t pingsSkipped = 0;       // The hardware thread had not run the previous no-op
+static uint64_t connectsOk = 0;
+static uint64_t connectsFailed = 0;
+static uint64_t signalsSeen = 0;
+
+// systemd's bus label escaping: everything but [A-Za-z0-9] (and a leading
+// digit) becomes _xx
+static void unitObjectPath(const char *name, char *path, size_t size) {
+    size_t length = (size_t)snprintf(path, size, "/org/freedesktop/systemd1/unit/");
+
+    for (const char *p = name; *p != '\0' && length + 4 < size; p++) {
+        if (isalnum((unsigned char)*p) && !(p == name && isdigit((unsigned char)*p))) {
+            path[length++] = *p;
+        } else {
+            length += (size_t)snprintf(path + length, size - length, "_%02x", (unsigned char)*p);
+        }
+    }
+    path[length] = '\0';
+}
+
+bool systemdBridgeAddUnit(const char *unit) {
+    SystemdUnit *entry;
+    size_t length = strlen(unit);
+
+    if (unitCount >= SYSTEMD_MAX_UNITS || bridgeActive || length == 0 || length + 8 >= SYSTEMD_UNIT_NAME_MAX) {
+        return false;
+    }
+    // The name ends up inside a match rule
+    for (const char *p = unit; *p != '\0'; p++) {
+        if (*p == '/' || *p == '\'' || *p == '\\' || *p == ',' || isspace((unsigned char)*p)) {
+            return false;
+        }
+    }
+    entry = &units[unitCount];
+    memset(entry, 0, sizeof(*entry));
+    // As systemctl does, a bare name is a service
+    snprintf(entry->name, sizeof(entry->name), strchr(unit, '.') ? "%s" : "%s.service", unit);
+    unitObjectPath(entry->name, entry->path, sizeof(entry->path));
+    unitCount++;
+    return true;
+}
+
+int systemdBridgeUnitCount(void) {
+    return unitCount;
+}
+
+static void notifySend(const char *text) {
+    if (notifyFd < 0) {
+        return;
+    }
+    if (sendto(notifyFd, text, strlen(text), MSG_NOSIGNAL, (struct sockaddr *)&notifyAddr, notifyLength) < 0) {
+        printf("systemd: notify failed: %s\n", strerror(errno));
+    }
+}
+
+// NOTIFY_SOCKET is a path, or an abstract socket when it starts with @
+static bool notifyOpen(void) {
+    const char *socketPath = getenv("NOTIFY_SOCKET");
+    const char *usec = getenv("WATCHDOG_USEC");
+    const char *pid = getenv("WATCHDOG_PID");
+    size_t length;
+
+    if (socketPath == NULL || (socketPath[0] != '/' && socketPath[0] != '@')) {
+        return false;
+    }
+    length = strlen(socketPath);
+    if (length >= sizeof(notifyAddr.sun_path)) {
+        return false;
+    }
+    memset(&notifyAddr, 0, sizeof(notifyAddr));
+    notifyAddr.sun_family = AF_UNIX;
+    memcpy(notifyAddr.sun_path, socketPath, length);
+    if (socketPath[0] == '@') {
+        notifyAddr.sun_path[0] = '\0';
+    }
+    notifyLength = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + length + (socketPath[0] == '/' ? 1 : 0));
+    notifyFd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (notifyFd < 0) {
+        return false;
+    }
+    // WATCHDOG_PID names the process systemd expects pings from
+    if (usec != NULL && (pid == NULL || strtol(pid, NULL, 10) == (long)getpid())) {
+        unsigned long long value = strtoull(usec, NULL, 10);
+
+        pingIntervalNs = value * 1000ull / 2;
+    }
+    return true;
+}
+
+static void hwPong(void *arg) {
+    __atomic_store_n(&hwRan, (uint64_t)(uintptr_t)arg, __ATOMIC_RELEASE);
+}
+
+// Ping only if the no-op posted with the previous ping got through the
+// hardware thread; post the next one
+static void pingWatchdog(void) {
+    uint64_t posted = __atomic_load_n(&hwPosted, __ATOMIC_RELAXED);
+
+    if (__atomic_load_n(&hwRan, __ATOMIC_ACQUIRE) != posted) {
+        __atomic_fetch_add(&pingsSkipped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    notifySend("WATCHDOG=1");
+    __atomic_fetch_add(&pingsSent, 1, __ATOMIC_RELAXED);
+    if (hwActorPost(HW_LANE_FEED, hwPong, (void *)(uintptr_t)(posted + 1))) {
+        __atomic_store_n(&hwPosted, posted + 1, __ATOMIC_RELAXED);
+    }
+}
+
+// Message building. Alignment is relative to the message start, and the
+// body starts 8-aligned, so one buffer serves header and body.
+typedef struct {
+    unsigned char data[SYSTEMD_TX_BYTES];
+    size_t length;
+    bool overflow;
+} BusMessage;
+
+static void putAlign(BusMessage *message, size_t alignment) {
+    while (message->length % alignment != 0 && message->length < sizeof(message->data)) {
+        message->data[message->length++] = 0;
+    }
+}
+
+static void putBytes(BusMessage *message, const void *bytes, size_t length) {
+    if (message->length + length > sizeof(message->data)) {
+        message->overflow = true;
+        return;
+    }
+    memcpy(message->data + message->length, bytes, length);
+    message->length += length;
+}
+
+static void putU32(BusMessage *message, uint32_t value) {
+    putAlign(message, 4);
+    putBytes(message, &value, 4);
+}
+
+static void putString(BusMessage *message, const char *text) {
+    putU32(message, (uint32_t)strlen(text));
+    putBytes(message, text, strlen(text) + 1);
+}
+
+static void putSignature(BusMessage *message, const char *signature) {
+    unsigned char length = (unsigned char)strlen(signature);
+
+    putBytes(message, &length, 1);
+    putBytes(message, signature, (size_t)length + 1);
+}
+
+static void putField(BusMessage *message, unsigned char code, const char *type, const char *value) {
+    putAlign(message, 8);
+    putBytes(message, &code, 1);
+    putSignature(message, type);
+    if (type[0] == 'g') {
+        putSignature(message, value);
+    } else {
+        putString(message, value);
+    }
+}
+
+static void busDown(const char *reason);
+
+// Method call with up to two string arguments; the serial, or 0 if it
+// could not be sent
+static uint32_t busCall(unsigned char flags, const char *destination, const char *path, const char *interface,
+                        const char *member, const char *arg1, const char *arg2) {
+    BusMessage message;
+    uint32_t serial = ++busSerial;
+    uint32_t fieldsLength;
+    uint32_t bodyLength;
+    size_t bodyStart;
+    unsigned char fixed[4] = { DBUS_NATIVE_ENDIAN, DBUS_CALL, flags, 1 };
+
+    if (busFd < 0) {
+        return 0;
+    }
+    memset(&message, 0, sizeof(message));
+    putBytes(&message, fixed, 4);
+    putU32(&message, 0);                          // Body length, patched below
+    putU32(&message, serial);
+    putU32(&message, 0);                          // Header fields length
+    putField(&message, DBUS_FIELD_PATH, "o", path);
+    putField(&message, DBUS_FIELD_INTERFACE, "s", interface);
+    putField(&message, DBUS_FIELD_MEMBER, "s", member);
+    putField(&message, DBUS_FIELD_DESTINATION, "s", destination);
+    if (arg1 != NULL) {
+        putField(&message, DBUS_FIELD_SIGNATURE, "g", arg2 != NULL ? "ss" : "s");
+    }
+    fieldsLength = (uint32_t)(message.length - 16);
+    putAlign(&message, 8);
+    bodyStart = message.length;
+    if (arg1 != NULL) {
+        putString(&message, arg1);
+    }
+    if (arg2 != NULL) {
+        putString(&message, arg2);
+    }
+    if (message.overflow) {
+        return 0;
+    }
+    bodyLength = (uint32_t)(message.length - bodyStart);
+    memcpy(message.data + 4, &bodyLength, 4);
+    memcpy(message.data + 12, &fieldsLength, 4);
+    if (send(busFd, message.data, message.length, MSG_NOSIGNAL) != (ssize_t)message.length) {
+        busDown("send");
+        return 0;
+    }
+    return serial;
+}
+
+// Message parsing
+static bool cursorAlign(BusCursor *cursor, size_t alignment) {
+    cursor->pos = (cursor->pos + alignment - 1) & ~(alignment - 1);
+    return cursor->pos <= cursor->length;
+}
+
+static bool cursorU32(BusCursor *cursor, uint32_t *value) {
+    const unsigned char *p;
+
+    if (!cursorAlign(cursor, 4) || cursor->pos + 4 > cursor->length) {
+        return false;
+    }
+    p = cursor->data + cursor->pos;
+    *value = cursor->big ? ((uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3])
+                         : ((uint32_t)p[3] << 24 | (uint32_t)p[2] << 16 | (uint32_t)p[1] << 8 | p[0]);
+    cursor->pos += 4;
+    return true;
+}
+
+static bool cursorString(BusCursor *cursor, const char **text, uint32_t *length) {
+    if (!cursorU32(cursor, length) || cursor->pos + *length + 1 > cursor->length) {
+        return false;
+    }
+    *text = (const char *)cursor->data + cursor->pos;
+    cursor->pos += *length + 1;
+    return true;
+}
+
+static bool cursorSignature(BusCursor *cursor, const char **signature) {
+    uint32_t length;
+
+    if (cursor->pos >= cursor->length) {
+        return false;
+    }
+    length = cursor->data[cursor->pos];
+    if (cursor->pos + 1 + length + 1 > cursor->length) {
+        return false;
+    }
+    *signature = (const char *)cursor->data + cursor->pos + 1;
+    cursor->pos += 1 + length + 1;
+    return true;
+}
+
+static size_t typeAlignment(char type) {
+    switch (type) {
+    case 'n': case 'q': return 2;
+    case 'b': case 'i': case 'u': case 'h': case 'a': case 's': case 'o': return 4;
+    case 'x': case 't': case 'd': case '(': case '{': return 8;
+    default: return 1;
+    }
+}
+
+// Step over one complete type in a signature
+static bool skipType(const char *signature, size_t *i) {
+    char type = signature[(*i)++];
+    char close = type == '(' ? ')' : '}';
+
+    if (type == '\0') {
+        return false;
+    }
+    if (type == 'a') {
+        return skipType(signature, i);
+    }
+    if (type == '(' || type == '{') {
+        while (signature[*i] != close) {
+            if (!skipType(signature, i)) {
+                return false;
+            }
+        }
+        (*i)++;
+    }
+    return true;
+}
+
+// Step over one value of the type at signature[*i]
+static bool skipValue(BusCursor *cursor, const char *signature, size_t *i, int depth) {
+    char type = signature[*i];
+    const char *text;
+    uint32_t length;
+
+    if (depth > 32) {
+        return false;
+    }
+    switch (type) {
+    case 'a': {
+        size_t element = *i + 1;
+
+        if (!cursorU32(cursor, &length) || !cursorAlign(cursor, typeAlignment(signature[element])) ||
+            cursor->pos + length > cursor->length) {
+            return false;
+        }
+        cursor->pos += length;
+        return skipType(signature, i);
+    }
+    case '(':
+    case '{': {
+        char close = type == '(' ? ')' : '}';
+
+        (*i)++;
+        if (!cursorAlign(cursor, 8)) {
+            return false;
+        }
+        while (signature[*i] != close) {
+            if (!skipValue(cursor, signature, i, depth + 1)) {
+                return false;
+            }
+        }
+        (*i)++;
+        return true;
+    }
+    case 'v': {
+        size_t inner = 0;
+
+        (*i)++;
+        return cursorSignature(cursor, &text) && skipValue(cursor, text, &inner, depth + 1);
+    }
+    case 's':
+    case 'o':
+        (*i)++;
+        return cursorString(cursor, &text, &length);
+    case 'g':
+        (*i)++;
+        return cursorSignature(cursor, &text);
+    case '\0':
+        return false;
+    default: {
+        size_t size = typeAlignment(type);
+
+        (*i)++;
+        if (!cursorAlign(cursor, size) || cursor->pos + size > cursor->length) {
+            return false;
+        }
+        cursor->pos += size;
+        return true;
+    }
+    }
+}
+
+static void setUnitState(SystemdUnit *unit, const char *state, uint32_t length) {
+    char value[sizeof(unit->state)];
+    bool wasKnown;
+
+    snprintf(value, sizeof(value), "%.*s", (int)length, state);
+    pthread_mutex_lock(&unitLock);
+    wasKnown = unit->state[0] != '\0';
+    if (strcmp(unit->state, value) != 0) {
+        if (wasKnown) {
+            unit->changes++;
+        }
+        snprintf(unit->state, sizeof(unit->state), "%s", value);
+        unit->healthy = strcmp(value, "active") == 0 || strcmp(value, "reloading") == 0;
+        printf("systemd: %s is %s\n", unit->name, value);
+    }
+    pthread_mutex_unlock(&unitLock);
+}
+
+// Body of a Properties.Get reply: v
+static void handleGetReply(SystemdUnit *unit, BusCursor *body) {
+    const char *signature;
+    const char *state;
+    uint32_t length;
+
+    if (cursorSignature(body, &signature) && strcmp(signature, "s") == 0 && cursorString(body, &state, &length)) {
+        setUnitState(unit, state, length);
+    }
+}
+
+// Body of PropertiesChanged: s interface, a{sv} changed, as invalidated
+static void handlePropertiesChanged(SystemdUnit *unit, BusCursor *body) {
+    const char *interface;
+    const char *key;
+    const char *signature;
+    uint32_t length;
+    size_t end;
+
+    if (!cursorString(body, &interface, &length) || strcmp(interface, SYSTEMD_UNIT_INTERFACE) != 0 ||
+        !cursorU32(body, &length) || !cursorAlign(body, 8) || body->pos + length > body->length) {
+        return;
+    }
+    end = body->pos + length;
+    while (body->pos < end) {
+        size_t i = 0;
+
+        if (!cursorAlign(body, 8) || !cursorString(body, &key, &length) || !cursorSignature(body, &signature)) {
+            return;
+        }
+        if (strcmp(key, "ActiveState") == 0 && strcmp(signature, "s") == 0) {
+            const char *state;
+
+            if (cursorString(body, &state, &length)) {
+                setUnitState(unit, state, length);
+            }
+            return;
+        }
+        if (!skipValue(body, signature, &i, 0)) {
+            return;
+        }
+    }
+}
+
+static void handleMessage(const unsigned char *data, size_t length) {
+    BusCursor cursor = { data, length, 16, data[0] == 'B' };
+    uint32_t fieldsLength;
+    uint32_t replySerial = 0;
+    const char *path = "";
+    const char *interface = "";
+    const char *member = "";
+    size_t end;
+
+    cursor.pos = 12;
+    if (!cursorU32(&cursor, &fieldsLength)) {
+        return;
+    }
+    end = 16 + (size_t)fieldsLength;
+    while (cursor.pos < end) {
+        const char *type;
+        const char *text;
+        uint32_t textLength;
+        uint32_t value;
+        unsigned char code;
+        size_t i = 0;
+
+        if (!cursorAlign(&cursor, 8) || cursor.pos >= end) {
+            break;
+        }
+        code = data[cursor.pos++];
+        if (!cursorSignature(&cursor, &type)) {
+            return;
+        }
+        if ((code == DBUS_FIELD_PATH || code == DBUS_FIELD_INTERFACE || code == DBUS_FIELD_MEMBER) &&
+            (type[0] == 's' || type[0] == 'o')) {
+            if (!cursorString(&cursor, &text, &textLength)) {
+                return;
+            }
+            if (code == DBUS_FIELD_PATH) {
+                path = text;
+            } else if (code == DBUS_FIELD_INTERFACE) {
+                interface = text;
+            } else {
+                member = text;
+            }
+        } else if (code == DBUS_FIELD_REPLY_SERIAL && type[0] == 'u') {
+            if (!cursorU32(&cursor, &value)) {
+                return;
+            }
+            replySerial = value;
+        } else if (!skipValue(&cursor, type, &i, 0)) {
+            return;
+        }
+    }
+    cursor.pos = end;
+    if (!cursorAlign(&cursor, 8)) {
+        return;
+    }
+
+    for (int u = 0; u < unitCount; u++) {
+        SystemdUnit *unit = &units[u];
+
+        if ((data[1] == DBUS_RETURN || data[1] == DBUS_ERROR) && replySerial != 0 && replySerial == unit->getSerial) {
+            unit->getSerial = 0;
+            if (data[1] == DBUS_RETURN) {
+                handleGetReply(unit, &cursor);
+            } else {
+                printf("systemd: cannot read the state of %s\n", unit->name);
+            }
+            return;
+        }
+        if (data[1] == DBUS_SIGNAL && strcmp(path, unit->path) == 0 && strcmp(interface, DBUS_PROPERTIES) == 0 &&
+            strcmp(member, "PropertiesChanged") == 0) {
+            __atomic_fetch_add(&signalsSeen, 1, __ATOMIC_RELAXED);
+            handlePropertiesChanged(unit, &cursor);
+            return;
+        }
+    }
+}
+
+static void busDown(const char *reason) {
+    if (busFd >= 0) {
+        printf("systemd: lost the system bus (%s), units count as down\n", reason);
+        close(busFd);
+        busFd = -1;
+    }
+    rxLength = 0;
+    retryAtNs = monotonicNowNs() + SYSTEMD_RETRY_MS * 1000000ull;
+    __atomic_store_n(&busConnected, false, __ATOMIC_RELAXED);
+    pthread_mutex_lock(&unitLock);
+    for (int i = 0; i < unitCount; i++) {
+        units[i].state[0] = '\0';
+        units[i].healthy = false;
+        units[i].getSerial = 0;
+    }
+    pthread_mutex_unlock(&unitLock);
+}
+
+// SASL EXTERNAL with our uid, then Hello, Subscribe and one match plus
+// one Get per unit. The match is in place before the Get, so no change
+// falls between them.
+static bool busConnect(void) {
+    struct sockaddr_un address;
+    struct timeval timeout = { SYSTEMD_IO_TIMEOUT_MS / 1000, (SYSTEMD_IO_TIMEOUT_MS % 1000) * 1000 };
+    char uid[16];
+    char line[128];
+    size_t length = 0;
+    int written;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", busPath);
+    busFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (busFd < 0) {
+        return false;
+    }
+    setsockopt(busFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(busFd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    if (connect(busFd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        goto fail;
+    }
+
+    snprintf(uid, sizeof(uid), "%u", (unsigned)getuid());
+    written = snprintf(line, sizeof(line), "%cAUTH EXTERNAL ", '\0');
+    for (const char *p = uid; *p != '\0'; p++) {
+        written += snprintf(line + written, sizeof(line) - (size_t)written, "%02x", (unsigned char)*p);
+    }
+    written += snprintf(line + written, sizeof(line) - (size_t)written, "\r\n");
+    if (send(busFd, line, (size_t)written, MSG_NOSIGNAL) != written) {
+        goto fail;
+    }
+    while (length < sizeof(line) - 1 && (length < 2 || memcmp(line + length - 2, "\r\n", 2) != 0)) {
+        ssize_t got = recv(busFd, line + length, 1, 0);
+
+        if (got <= 0) {
+            goto fail;
+        }
+        length++;
+    }
+    if (length < 3 || memcmp(line, "OK ", 3) != 0 || send(busFd, "BEGIN\r\n", 7, MSG_NOSIGNAL) != 7) {
+        goto fail;
+    }
+
+    if (busCall(0, "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus", "Hello", NULL, NULL) == 0 ||
+        busCall(DBUS_NO_REPLY, SYSTEMD_SERVICE, "/org/freedesktop/systemd1", "org.freedesktop.systemd1.Manager",
+                "Subscribe", NULL, NULL) == 0) {
+        goto fail;
+    }
+    for (int i = 0; i < unitCount; i++) {
+        char rule[sizeof(units[i].path) + 256];
+        uint32_t serial;
+
+        snprintf(rule, sizeof(rule),
+                 "type='signal',sender='" SYSTEMD_SERVICE "',path='%s',interface='" DBUS_PROPERTIES "',"
+                 "member='PropertiesChanged',arg0='" SYSTEMD_UNIT_INTERFACE "'", units[i].path);
+        if (busCall(DBUS_NO_REPLY, "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus",
+                    "AddMatch", rule, NULL) == 0) {
+            goto fail;
+        }
+        serial = busCall(0, SYSTEMD_SERVICE, units[i].path, DBUS_PROPERTIES, "Get", SYSTEMD_UNIT_INTERFACE, "ActiveState");
+        if (serial == 0) {
+            goto fail;
+        }
+        pthread_mutex_lock(&unitLock);
+        units[i].getSerial = serial;
+        pthread_mutex_unlock(&unitLock);
+    }
+    __atomic_fetch_add(&connectsOk, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&busConnected, true, __ATOMIC_RELAXED);
+    printf("systemd: following %d unit(s) on %s\n", unitCount, busPath);
+    return true;
+
+fail:
+    if (busFd >= 0) {
+        close(busFd);
+        busFd = -1;
+    }
+    __atomic_fetch_add(&connectsFailed, 1, __ATOMIC_RELAXED);
+    retryAtNs = monotonicNowNs() + SYSTEMD_RETRY_MS * 1000000ull;
+    return false;
+}
+
+static void busRead(void) {
+    ssize_t got = recv(busFd, rx + rxLength, sizeof(rx) - rxLength, MSG_DONTWAIT);
+    size_t offset = 0;
+
+    if (got == 0 || (got < 0 && errno != EAGAIN && errno != EINTR)) {
+        busDown(got == 0 ? "closed" : "read");
+        return;
+    }
+    if (got < 0) {
+        return;
+    }
+    rxLength += (size_t)got;
+    while (rxLength - offset >= 16) {
+        BusCursor cursor = { rx + offset, rxLength - offset, 4, rx[offset] == 'B' };
+        uint32_t bodyLength;
+        uint32_t fieldsLength;
+        size_t total;
+
+        cursorU32(&cursor, &bodyLength);
+        cursor.pos = 12;
+        cursorU32(&cursor, &fieldsLength);
+        total = ((16 + (size_t)fieldsLength + 7) & ~(size_t)7) + bodyLength;
+        if (total > sizeof(rx)) {
+            busDown("message too large");
+            return;
+        }
+        if (rxLength - offset < total) {
+            break;
+        }
+        handleMessage(rx + offset, total);
+        offset += total;
+    }
+    memmove(rx, rx + offset, rxLength - offset);
+    rxLength -= offset;
+}
+
+static void* bridgeThreadMain(void *arg) {
+    uint64_t nextPingNs = monotonicNowNs();
+    (void)arg;
+
+    pthread_setname_np(pthread_self(), "systemd");
+    while (!__atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) {
+        uint64_t now = monotonicNowNs();
+        uint64_t wakeNs = now + 1000000000ull;
+        struct pollfd fds[2];
+        int timeoutMs;
+
+        if (pingIntervalNs > 0) {
+            if (now >= nextPingNs) {
+                pingWatchdog();
+                nextPingNs = (now - nextPingNs > pingIntervalNs ? now : nextPingNs) + pingIntervalNs;
+            }
+            if (nextPingNs < wakeNs) {
+                wakeNs = nextPingNs;
+            }
+        }
+        if (unitCount > 0 && busFd < 0) {
+            if (now >= retryAtNs) {
+                busConnect();
+            }
+            if (busFd < 0 && retryAtNs < wakeNs) {
+                wakeNs = retryAtNs;
+            }
+        }
+
+        fds[0].fd = stopFd;
+        fds[0].events = POLLIN;
+        fds[1].fd = busFd;
+        fds[1].events = POLLIN;
+        now = monotonicNowNs();
+        timeoutMs = wakeNs > now ? (int)((wakeNs - now + 999999) / 1000000) : 0;
+        if (poll(fds, busFd >= 0 ? 2 : 1, timeoutMs) <= 0) {
+            continue;
+        }
+        if (busFd >= 0 && (fds[1].revents & (POLLIN | POLLHUP | POLLERR))) {
+            busRead();
+        }
+    }
+    if (busFd >= 0) {
+        close(busFd);
+        busFd = -1;
+    }
+    return NULL;
+}
+
+bool systemdBridgeStart(void) {
+    const char *address = getenv("DBUS_SYSTEM_BUS_ADDRESS");
+
+    if (bridgeActive) {
+        return true;
+    }
+    notifyOpen();
+    // Only unix:path= addresses are understood
+    if (address != NULL && strncmp(address, "unix:path=", 10) == 0) {
+        snprintf(busPath, sizeof(busPath), "%.*s", (int)strcspn(address + 10, ","), address + 10);
+    }
+    if (pingIntervalNs == 0 && unitCount == 0) {
+        return true;
+    }
+
+    stopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (stopFd < 0) {
+        return false;
+    }
+    // Units count as down until the first answer
+    busDown("start");
+    retryAtNs = 0;
+    stopping = false;
+    if (pthread_create(&bridgeThread, NULL, bridgeThreadMain, NULL) != 0) {
+        close(stopFd);
+        stopFd = -1;
+        return false;
+    }
+    bridgeActive = true;
+    if (pingIntervalNs > 0) {
+        printf("systemd: watchdog pings every %llu ms\n", (unsigned long long)(pingIntervalNs / 1000000));
+    }
+    return true;
+}
+
+void systemdBridgeReady(const char *status) {
+    char text[256];
+
+    snprintf(text, sizeof(text), "READY=1\nSTATUS=%s", status);
+    notifySend(text);
+}
+
+void systemdBridgeStop(void) {
+    uint64_t one = 1;
+
+    notifySend("STOPPING=1");
+    if (bridgeActive) {
+        __atomic_store_n(&stopping, true, __ATOMIC_RELEASE);
+        if (write(stopFd, &one, sizeof(one)) < 0) {
+            // The thread still sees stopping within a second
+        }
+        pthread_join(bridgeThread, NULL);
+        bridgeActive = false;
+        close(stopFd);
+        stopFd = -1;
+    }
+    if (notifyFd >= 0) {
+        close(notifyFd);
+        notifyFd = -1;
+    }
+}
+
+bool systemdUnitsHealthy(void *ctx) {
+    bool healthy = true;
+    (void)ctx;
+
+    pthread_mutex_lock(&unitLock);
+    for (int i = 0; i < unitCount; i++) {
+        healthy = healthy && units[i].healthy;
+    }
+    pthread_mutex_unlock(&unitLock);
+    return healthy;
+}
+
+void systemdBridgeCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (pingIntervalNs > 0) {
+        metricsHeader(out, "watchdog_systemd_pings_total", "counter",
+                      "systemd watchdog pings sent, or skipped while the hardware thread was stuck");
+        strbufAppendf(out, "watchdog_systemd_pings_total{result=\"sent\"} %llu\n",
+                      (unsigned long long)__atomic_load_n(&pingsSent, __ATOMIC_RELAXED));
+        strbufAppendf(out, "watchdog_systemd_pings_total{result=\"skipped\"} %llu\n",
+                      (unsigned long long)__atomic_load_n(&pingsSkipped, __ATOMIC_RELAXED));
+    }
+    if (unitCount == 0) {
+        return;
+    }
+    metricsHeader(out, "watchdog_systemd_bus_connected", "gauge", "1 while the system D-Bus connection is up");
+    strbufAppendf(out, "watchdog_systemd_bus_connected %d\n", __atomic_load_n(&busConnected, __ATOMIC_RELAXED) ? 1 : 0);
+    metricsHeader(out, "watchdog_systemd_bus_connects_total", "counter", "System D-Bus connection attempts by result");
+    strbufAppendf(out, "watchdog_systemd_bus_connects_total{result=\"ok\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&connectsOk, __ATOMIC_RELAXED));
+    strbufAppendf(out, "watchdog_systemd_bus_connects_total{result=\"error\"} %llu\n",
+                  (unsigned long long)__atomic_load_n(&connectsFailed, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_systemd_signals_total", "counter", "PropertiesChanged signals received for tracked units");
+    strbufAppendf(out, "watchdog_systemd_signals_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&signalsSeen, __ATOMIC_RELAXED));
+    pthread_mutex_lock(&unitLock);
+    metricsHeader(out, "watchdog_systemd_unit_active", "gauge", "1 while a tracked unit is active or reloading");
+    for (int i = 0; i < unitCount; i++) {
+        strbufAppendf(out, "watchdog_systemd_unit_active{unit=\"%s\"} %d\n", units[i].name, units[i].healthy ? 1 : 0);
+    }
+    metricsHeader(out, "watchdog_systemd_unit_changes_total", "counter", "ActiveState transitions of a tracked unit");
+    for (int i = 0; i < unitCount; i++) {
+        strbufAppendf(out, "watchdog_systemd_unit_changes_total{unit=\"%s\"} %llu\n", units[i].name,
+                      (unsigned long long)units[i].changes);
+    }
+    pthread_mutex_unlock(&unitLock);
+}
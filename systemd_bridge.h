@@ -0,0 +1,45 @@
+#ifndef SYSTEMD_BRIDGE_H
+#define SYSTEMD_BRIDGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "strbuf.h"
+
+#define SYSTEMD_MAX_UNITS 16
+#define SYSTEMD_UNIT_NAME_MAX 128
+#define SYSTEMD_DEFAULT_BUS "/run/dbus/system_bus_socket"
+
+// Bridges systemd's service watchdog and the hardware one, without
+// libsystemd:
+// - When started by systemd with Type=notify, the service reports READY=1
+//   once it serves, STOPPING=1 when it shuts down and, with WatchdogSec=,
+//   WATCHDOG=1 at half the interval systemd asks for. A ping is only sent
+//   while the hardware thread keeps running the no-op posted with the
+//   previous one, so a wedged SUSI call gets the service restarted.
+// - With --systemd-unit, the service follows the ActiveState of the named
+//   units over the system D-Bus (PropertiesChanged signals, no polling) and
+//   the auto-feeder only feeds while every one of them is active or
+//   reloading. Other services keep their own WatchdogSec=; systemd restarts
+//   or fails them, and a unit that stays down ends in a board reset.
+// While the bus is unreachable the units count as down; it is reconnected
+// every SYSTEMD_RETRY_MS.
+
+// Before systemdBridgeStart(); false when the name is malformed or the
+// table is full
+bool systemdBridgeAddUnit(const char *unit);
+int systemdBridgeUnitCount(void);
+
+// Start the bridge thread when systemd asked for notifications or units
+// are tracked; true when there is nothing to do
+bool systemdBridgeStart(void);
+// READY=1 with a STATUS= line, once startup is complete
+void systemdBridgeReady(const char *status);
+// STOPPING=1, then stop the thread
+void systemdBridgeStop(void);
+
+// Feeder condition: every tracked unit is active
+bool systemdUnitsHealthy(void *ctx);
+
+void systemdBridgeCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // SYSTEMD_BRIDGE_H
@@ -4,7 +4,7 @@
 
 # Configuration
 HOST="localhost"
-PORT="8080"
+PORT="9101"
 BASE_URL="http://$HOST:$PORT"
 
 # Colors for output
@@ -0,0 +1,316 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "thermal_monitor.h"
+#include "events.h"
+#include "hw_actor.h"
+#include "hwm_sampler.h"
+#include "json_writer.h"
+#include "metrics.h"
+#include "susi_timing.h"
+#include "timeutil.h"
+#include "webhook.h"
+
+#define THERMAL_MIN_SLOPE 0.001              // Celsius per second; flatter counts as not rising
+
+typedef struct {
+    ThermalZone zone;
+    uint64_t sampleMs[THERMAL_SLOPE_SAMPLES];
+    double sampleC[THERMAL_SLOPE_SAMPLES];
+    int samples;
+    int next;                        // Ring position of the next reading
+    uint64_t lastStoredMs;
+} ThermalTrack;
+
+static ThermalTrack tracks[SUSI_ID_THERMAL_MAX];
+static int trackCount;
+static uint32_t horizonS = THERMAL_DEFAULT_HORIZON_S;
+static pthread_mutex_t zoneLock = PTHREAD_MUTEX_INITIALIZER;
+
+void thermalMonitorSetHorizon(uint32_t seconds) {
+    horizonS = seconds;
+}
+
+static void hwReadZones(void *arg) {
+    (void)arg;
+
+    trackCount = 0;
+    for (SusiId_t id = 0; id < SUSI_ID_THERMAL_MAX; id++) {
+        SusiThermalProtect config;
+        uint64_t start = monotonicNowNs();
+        SusiStatus_t status = SusiThermalProtectionGetConfig(id, &config);
+        ThermalZone *zone = &tracks[trackCount].zone;
+
+        susiTimingRecord(SUSI_CALL_THERMAL_GET_CONFIG, start, status);
+        if (status != SUSI_STATUS_SUCCESS || config.EventType == SUSI_THERMAL_EVENT_NONE ||
+            config.SourceId < SUSI_ID_HWM_TEMP_BASE || config.SourceId >= SUSI_ID_HWM_TEMP_BASE + SUSI_ID_HWM_TEMP_MAX) {
+            continue;
+        }
+        memset(&tracks[trackCount], 0, sizeof(tracks[trackCount]));
+        zone->id = id;
+        zone->sensorSlot = (int)(config.SourceId - SUSI_ID_HWM_TEMP_BASE);
+        zone->eventType = config.EventType;
+        zone->tripRaw = (int32_t)config.SendEventTemperature;
+        zone->clearRaw = (int32_t)config.ClearEventTemperature;
+        zone->temperature = NAN;
+        zone->secondsToTrip = THERMAL_NO_FORECAST;
+        trackCount++;
+    }
+}
+
+const char* thermalStateName(ThermalState state) {
+    static const char *names[] = { "normal", "warning", "tripped" };
+
+    return state <= THERMAL_STATE_TRIPPED ? names[state] : "unknown";
+}
+
+const char* thermalActionName(uint32_t eventType) {
+    switch (eventType) {
+    case SUSI_THERMAL_EVENT_SHUTDOWN: return "shutdown";
+    case SUSI_THERMAL_EVENT_THROTTLE: return "throttle";
+    case SUSI_THERMAL_EVENT_POWEROFF: return "poweroff";
+    default:                          return "none";
+    }
+}
+
+// Least-squares slope through the readings of the last
+// THERMAL_SLOPE_WINDOW_MS, 0 while they cover less than THERMAL_MIN_SPAN_MS
+static double fitSlope(const ThermalTrack *track, uint64_t nowMs) {
+    double meanT = 0, meanC = 0, covariance = 0, variance = 0;
+    uint64_t oldest = nowMs;
+    int used = 0;
+
+    for (int i = 0; i < track->samples; i++) {
+        if (nowMs - track->sampleMs[i] > THERMAL_SLOPE_WINDOW_MS) {
+            continue;
+        }
+        // Relative to now, so the doubles keep millisecond precision
+        meanT += -(double)(nowMs - track->sampleMs[i]) / 1000.0;
+        meanC += track->sampleC[i];
+        if (track->sampleMs[i] < oldest) {
+            oldest = track->sampleMs[i];
+        }
+        used++;
+    }
+    if (used < 3 || nowMs - oldest < THERMAL_MIN_SPAN_MS) {
+        return 0;
+    }
+    meanT /= used;
+    meanC /= used;
+    for (int i = 0; i < track->samples; i++) {
+        double t;
+
+        if (nowMs - track->sampleMs[i] > THERMAL_SLOPE_WINDOW_MS) {
+            continue;
+        }
+        t = -(double)(nowMs - track->sampleMs[i]) / 1000.0 - meanT;
+        covariance += t * (track->sampleC[i] - meanC);
+        variance += t * t;
+    }
+    return variance > 0 ? covariance / variance : 0;
+}
+
+static void announce(const ThermalZone *zone, int32_t raw) {
+    char body[WEBHOOK_BODY_MAX];
+    StrBuf out;
+    JsonWriter writer;
+
+    eventPublish(EVENT_THERMAL, EVENT_NO_WATCHDOG, zone->id, (uint32_t)raw, zone->secondsToTrip, zone->state);
+
+    strbufInit(&out, body, sizeof(body));
+    jsonWriterInit(&writer, &out);
+    jsonBeginObject(&writer);
+    jsonFieldString(&writer, "event", "thermal");
+    jsonFieldUint(&writer, "zone", zone->id);
+    jsonFieldString(&writer, "state", thermalStateName(zone->state));
+    jsonFieldString(&writer, "action", thermalActionName(zone->eventType));
+    jsonFieldDouble(&writer, "temperature", zone->temperature, 1);
+    jsonFieldDouble(&writer, "trip", hwmScale(HWM_KIND_TEMPERATURE, zone->tripRaw), 1);
+    jsonFieldDouble(&writer, "slope", zone->slope, 4);
+    jsonKey(&writer, "seconds_to_trip");
+    if (zone->secondsToTrip == THERMAL_NO_FORECAST) {
+        jsonNull(&writer);
+    } else {
+        jsonUint(&writer, zone->secondsToTrip);
+    }
+    jsonFieldUint(&writer, "timestamp_ms", zone->updatedMs);
+    jsonEndObject(&writer);
+    if (!out.overflow) {
+        webhookPost(out.data, out.length);
+    }
+}
+
+static void onSweep(const HwmReading *reading, void *ctx) {
+    (void)ctx;
+
+    pthread_mutex_lock(&zoneLock);
+    for (int i = 0; i < trackCount; i++) {
+        ThermalTrack *track = &tracks[i];
+        ThermalZone *zone = &track->zone;
+        int slot = zone->sensorSlot;
+        uint64_t nowMs = reading->sampledMs[slot];
+        double trip = hwmScale(HWM_KIND_TEMPERATURE, zone->tripRaw);
+        double eta = INFINITY;
+        ThermalState next;
+
+        if (!(reading->validMask & (1ull << slot))) {
+            continue;
+        }
+        if (track->samples == 0 || nowMs - track->lastStoredMs >= THERMAL_SAMPLE_SPACING_MS) {
+            track->sampleMs[track->next] = nowMs;
+            track->sampleC[track->next] = hwmScale(HWM_KIND_TEMPERATURE, reading->values[slot]);
+            track->next = (track->next + 1) % THERMAL_SLOPE_SAMPLES;
+            track->lastStoredMs = nowMs;
+            if (track->samples < THERMAL_SLOPE_SAMPLES) {
+                track->samples++;
+            }
+        }
+
+        zone->temperature = hwmScale(HWM_KIND_TEMPERATURE, reading->values[slot]);
+        zone->slope = fitSlope(track, nowMs);
+        zone->updatedMs = nowMs;
+        if (zone->temperature < trip && zone->slope > THERMAL_MIN_SLOPE) {
+            eta = (trip - zone->temperature) / zone->slope;
+        }
+        zone->secondsToTrip = eta < (double)THERMAL_NO_FORECAST ? (uint32_t)eta : THERMAL_NO_FORECAST;
+
+        if (reading->values[slot] >= zone->tripRaw) {
+            next = THERMAL_STATE_TRIPPED;
+        } else if (zone->state == THERMAL_STATE_TRIPPED && reading->values[slot] > zone->clearRaw) {
+            // The EC keeps its action until the clear temperature
+            next = THERMAL_STATE_TRIPPED;
+        } else if (eta <= horizonS || (zone->state != THERMAL_STATE_NORMAL && eta <= 2.0 * horizonS)) {
+            next = THERMAL_STATE_WARNING;
+        } else {
+            next = THERMAL_STATE_NORMAL;
+        }
+        if (next == zone->state) {
+            continue;
+        }
+        zone->state = next;
+        if (next == THERMAL_STATE_WARNING) {
+            zone->warnings++;
+        } else if (next == THERMAL_STATE_TRIPPED) {
+            zone->trips++;
+        }
+        announce(zone, reading->values[slot]);
+    }
+    pthread_mutex_unlock(&zoneLock);
+}
+
+bool thermalMonitorStart(void) {
+    const HwmCapabilities *caps = hwmCapabilities();
+    int kept = 0;
+
+    if (horizonS == 0 || caps == NULL || !hwActorCall(HW_LANE_READ, hwReadZones, NULL)) {
+        return false;
+    }
+    // Only zones whose source the sampler reads can be forecast
+    for (int i = 0; i < trackCount; i++) {
+        const ThermalZone *zone = &tracks[i].zone;
+
+        if (!(caps->mask & (1ull << zone->sensorSlot))) {
+            printf("Thermal zone %u: source temperature %d is not sampled\n", zone->id, zone->sensorSlot);
+            continue;
+        }
+        printf("Thermal zone %u: %s at %.1f C from %s, warning %u s ahead\n", zone->id,
+               thermalActionName(zone->eventType), hwmScale(HWM_KIND_TEMPERATURE, zone->tripRaw),
+               hwmSensor(zone->sensorSlot)->name, horizonS);
+        tracks[kept++] = tracks[i];
+    }
+    trackCount = kept;
+    if (trackCount == 0) {
+        printf("Thermal protection: no zone with an action and a sampled source, nothing to forecast\n");
+        return false;
+    }
+    return hwmAddListener(onSweep, NULL);
+}
+
+void thermalMonitorConfigChanged(SusiId_t id, const SusiThermalProtect *config) {
+    const HwmCapabilities *caps = hwmCapabilities();
+
+    pthread_mutex_lock(&zoneLock);
+    for (int i = 0; i < trackCount; i++) {
+        ThermalZone *zone = &tracks[i].zone;
+        int slot = (int)(config->SourceId - SUSI_ID_HWM_TEMP_BASE);
+
+        if (zone->id != id) {
+            continue;
+        }
+        if (config->EventType == SUSI_THERMAL_EVENT_NONE || config->SourceId < SUSI_ID_HWM_TEMP_BASE ||
+            slot >= SUSI_ID_HWM_TEMP_MAX || caps == NULL || !(caps->mask & (1ull << slot))) {
+            printf("Thermal zone %u: no longer monitored\n", id);
+            memmove(&tracks[i], &tracks[i + 1], sizeof(tracks[0]) * (size_t)(trackCount - i - 1));
+            trackCount--;
+            break;
+        }
+        if (slot != zone->sensorSlot) {
+            // Readings of the old source say nothing about the new one
+            tracks[i].samples = 0;
+            tracks[i].next = 0;
+            zone->sensorSlot = slot;
+        }
+        zone->eventType = config->EventType;
+        zone->tripRaw = (int32_t)config->SendEventTemperature;
+        zone->clearRaw = (int32_t)config->ClearEventTemperature;
+        break;
+    }
+    pthread_mutex_unlock(&zoneLock);
+}
+
+int thermalMonitorZones(ThermalZone *zones, int max) {
+    int count;
+
+    pthread_mutex_lock(&zoneLock);
+    count = trackCount < max ? trackCount : max;
+    for (int i = 0; i < count; i++) {
+        zones[i] = tracks[i].zone;
+    }
+    pthread_mutex_unlock(&zoneLock);
+    return count;
+}
+
+const ThermalZone* thermalMonitorZone(SusiId_t id) {
+    for (int i = 0; i < trackCount; i++) {
+        if (tracks[i].zone.id == id) {
+            return &tracks[i].zone;
+        }
+    }
+    return NULL;
+}
+
+void thermalMonitorCollectMetrics(StrBuf *out, void *ctx) {
+    ThermalZone zones[SUSI_ID_THERMAL_MAX];
+    int count = thermalMonitorZones(zones, SUSI_ID_THERMAL_MAX);
+    (void)ctx;
+
+    if (count == 0) {
+        return;
+    }
+    metricsHeader(out, "watchdog_thermal_state", "gauge", "Thermal zone state: 0 normal, 1 warning, 2 tripped");
+    for (int i = 0; i < count; i++) {
+        strbufAppendf(out, "watchdog_thermal_state{zone=\"%u\",action=\"%s\"} %d\n", zones[i].id,
+                      thermalActionName(zones[i].eventType), (int)zones[i].state);
+    }
+    metricsHeader(out, "watchdog_thermal_slope_celsius_per_second", "gauge", "Fitted rate of change of the zone's source temperature");
+    for (int i = 0; i < count; i++) {
+        strbufAppendf(out, "watchdog_thermal_slope_celsius_per_second{zone=\"%u\"} %.4f\n", zones[i].id, zones[i].slope);
+    }
+    metricsHeader(out, "watchdog_thermal_seconds_to_trip", "gauge", "Forecast time until the trip temperature, absent when not rising");
+    for (int i = 0; i < count; i++) {
+        if (zones[i].secondsToTrip != THERMAL_NO_FORECAST) {
+            strbufAppendf(out, "watchdog_thermal_seconds_to_trip{zone=\"%u\"} %u\n", zones[i].id, zones[i].secondsToTrip);
+        }
+    }
+    metricsHeader(out, "watchdog_thermal_warnings_total", "counter", "Early warnings raised ahead of a forecast trip");
+    for (int i = 0; i < count; i++) {
+        strbufAppendf(out, "watchdog_thermal_warnings_total{zone=\"%u\"} %llu\n", zones[i].id,
+                      (unsigned long long)zones[i].warnings);
+    }
+    metricsHeader(out, "watchdog_thermal_trips_total", "counter", "Times the source temperature reached the trip temperature");
+    for (int i = 0; i < count; i++) {
+        strbufAppendf(out, "watchdog_thermal_trips_total{zone=\"%u\"} %llu\n", zones[i].id,
+                      (unsigned long long)zones[i].trips);
+    }
+}
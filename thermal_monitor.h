@@ -0,0 +1,72 @@
+#ifndef THERMAL_MONITOR_H
+#define THERMAL_MONITOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "Susi4.h"
+#include "strbuf.h"
+
+#define THERMAL_DEFAULT_HORIZON_S 120        // Warn when a trip is forecast this close
+#define THERMAL_SLOPE_SAMPLES 16             // Readings in the slope fit
+#define THERMAL_SAMPLE_SPACING_MS 1000       // Closest two fit readings may be; the sampler speeds up on a rising sensor
+#define THERMAL_SLOPE_WINDOW_MS 120000       // Oldest reading the fit may use
+#define THERMAL_MIN_SPAN_MS 5000             // Time the fit must cover before forecasting
+#define THERMAL_NO_FORECAST 0xffffffffu      // secondsToTrip when no trip is coming
+
+// Early warning ahead of the EC's thermal protection. The trip (send
+// event) and clear temperatures of every SUSI_ID_THERMAL_PROTECT_* zone
+// that has an action configured are read once at startup. After each
+// sweep that read a zone's source temperature, a least-squares line
+// through its recent readings (at least THERMAL_SAMPLE_SPACING_MS apart)
+// gives the slope, and from that the time until the trip temperature is
+// reached. A zone goes to warning when that
+// forecast is within the horizon, to tripped at the trip temperature, and
+// back to normal once the forecast is more than twice the horizon away
+// (or, after a trip, once the clear temperature is reached). Every state
+// change is published as EVENT_THERMAL and posted to the webhooks, so a
+// scheduler can shed load before the EC throttles or powers off.
+
+typedef enum {
+    THERMAL_STATE_NORMAL,
+    THERMAL_STATE_WARNING,           // Trip forecast within the horizon
+    THERMAL_STATE_TRIPPED            // At or above the trip temperature
+} ThermalState;
+
+typedef struct {
+    SusiId_t id;                     // SUSI_ID_THERMAL_PROTECT_*
+    int sensorSlot;                  // HWM slot of the source temperature
+    uint32_t eventType;              // SUSI_THERMAL_EVENT_*
+    int32_t tripRaw;                 // 0.1 K, as configured in the EC
+    int32_t clearRaw;
+    ThermalState state;
+    double temperature;              // Celsius, NAN before the first reading
+    double slope;                    // Celsius per second, 0 until the fit covers THERMAL_MIN_SPAN_MS
+    uint32_t secondsToTrip;          // THERMAL_NO_FORECAST when cooling, flat or too far away to say
+    uint64_t updatedMs;
+    uint64_t warnings;               // Transitions to warning
+    uint64_t trips;                  // Transitions to tripped
+} ThermalZone;
+
+// Before thermalMonitorStart(); 0 disables the monitor
+void thermalMonitorSetHorizon(uint32_t seconds);
+// Read the zones through the hardware thread and listen to the sampler
+// (after hwmInit). False without a zone whose source is sampled.
+bool thermalMonitorStart(void);
+
+// A zone was reconfigured through the API (hardware thread). A monitored
+// zone takes the new thresholds, and stops being monitored when its action
+// is removed or its source is no longer a sampled temperature; zones that
+// were not monitored at startup are not picked up.
+void thermalMonitorConfigChanged(SusiId_t id, const SusiThermalProtect *config);
+
+// Copy the state of up to max zones; returns how many were copied
+int thermalMonitorZones(ThermalZone *zones, int max);
+// Static description of one zone (id, source, thresholds) for event
+// formatting; NULL for an unknown id
+const ThermalZone* thermalMonitorZone(SusiId_t id);
+const char* thermalStateName(ThermalState state);
+const char* thermalActionName(uint32_t eventType);
+
+void thermalMonitorCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // THERMAL_MONITOR_H
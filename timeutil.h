@@ -0,0 +1,22 @@
+#ifndef TIMEUTIL_H
+#define TIMEUTIL_H
+
+#include <stdint.h>
+#include <time.h>
+
+// CLOCK_MONOTONIC in nanoseconds
+static inline uint64_t monotonicNowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// CLOCK_MONOTONIC_RAW in nanoseconds: not slewed by NTP, for comparing
+// timestamps that are nanoseconds apart
+static inline uint64_t monotonicRawNowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+#endif // TIMEUTIL_H
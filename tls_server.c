@@ -0,0 +1,184 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef WATCHDOG_TLS
+#include <gnutls/gnutls.h>
+#endif
+#include "tls_server.h"
+#include "metrics.h"
+
+typedef enum {
+    TLS_HANDSHAKE_FULL,
+    TLS_HANDSHAKE_RESUMED,
+    TLS_HANDSHAKE_FAILED,            // Closed before the handshake finished
+    TLS_HANDSHAKE_COUNT
+} TlsHandshake;
+
+static const char *handshakeNames[TLS_HANDSHAKE_COUNT] = { "full", "resumed", "failed" };
+static uint64_t handshakes[TLS_HANDSHAKE_COUNT];
+
+static bool tlsEnabled = false;
+static char *certPem = NULL;
+static char *keyPem = NULL;
+static struct MHD_OptionItem options[4] = { { MHD_OPTION_END, 0, NULL } };
+
+#ifdef WATCHDOG_TLS
+static gnutls_datum_t ticketKey = { NULL, 0 };
+
+// The whole file, NUL-terminated as MHD expects
+static char* readPem(const char *path) {
+    FILE *file = fopen(path, "r");
+    size_t length = 0;
+    char *pem;
+
+    if (file == NULL) {
+        printf("TLS: cannot open %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+    pem = malloc(TLS_PEM_MAX + 1);
+    if (pem != NULL) {
+        length = fread(pem, 1, TLS_PEM_MAX + 1, file);
+    }
+    fclose(file);
+    if (pem == NULL || length == 0 || length > TLS_PEM_MAX) {
+        printf("TLS: %s is empty or larger than %d bytes\n", path, TLS_PEM_MAX);
+        free(pem);
+        return NULL;
+    }
+    pem[length] = '\0';
+    return pem;
+}
+#endif
+
+bool tlsServerConfigure(const char *certPath, const char *keyPath, const char *priorities) {
+#ifdef WATCHDOG_TLS
+    int count = 0;
+
+    if (tlsEnabled) {
+        return false;
+    }
+    if (certPath == NULL || keyPath == NULL) {
+        printf("TLS needs both --tls-cert and --tls-key\n");
+        return false;
+    }
+    if (MHD_is_feature_supported(MHD_FEATURE_TLS) != MHD_YES) {
+        printf("TLS: this libmicrohttpd build has no HTTPS support\n");
+        return false;
+    }
+    certPem = readPem(certPath);
+    keyPem = readPem(keyPath);
+    if (certPem == NULL || keyPem == NULL) {
+        tlsServerDestroy();
+        return false;
+    }
+    if (gnutls_session_ticket_key_generate(&ticketKey) < 0) {
+        printf("TLS: cannot generate a session ticket key\n");
+        tlsServerDestroy();
+        return false;
+    }
+    options[count++] = (struct MHD_OptionItem){ MHD_OPTION_HTTPS_MEM_CERT, 0, certPem };
+    options[count++] = (struct MHD_OptionItem){ MHD_OPTION_HTTPS_MEM_KEY, 0, keyPem };
+    options[count++] = (struct MHD_OptionItem){ MHD_OPTION_HTTPS_PRIORITIES, 0,
+                                                (void *)(priorities != NULL ? priorities : TLS_DEFAULT_PRIORITIES) };
+    options[count] = (struct MHD_OptionItem){ MHD_OPTION_END, 0, NULL };
+    tlsEnabled = true;
+    return true;
+#else
+    (void)certPath;
+    (void)keyPath;
+    (void)priorities;
+    printf("TLS support is not built in (make TLS=1, needs libgnutls28-dev)\n");
+    return false;
+#endif
+}
+
+bool tlsServerEnabled(void) {
+    return tlsEnabled;
+}
+
+unsigned int tlsServerDaemonFlags(void) {
+    return tlsEnabled ? MHD_USE_TLS : 0;
+}
+
+struct MHD_OptionItem* tlsServerDaemonOptions(void) {
+    return options;
+}
+
+void tlsServerConnectionNotify(void *cls, struct MHD_Connection *connection, void **socketContext,
+                               enum MHD_ConnectionNotificationCode code) {
+#ifdef WATCHDOG_TLS
+    const union MHD_ConnectionInfo *info;
+    gnutls_session_t session;
+    gnutls_handshake_description_t last;
+#endif
+    (void)cls;
+    (void)socketContext;
+
+#ifdef WATCHDOG_TLS
+    if (!tlsEnabled) {
+        return;
+    }
+    info = MHD_get_connection_info(connection, MHD_CONNECTION_INFO_GNUTLS_SESSION);
+    if (info == NULL || info->tls_session == NULL) {
+        return;
+    }
+    session = (gnutls_session_t)info->tls_session;
+    if (code == MHD_CONNECTION_NOTIFY_STARTED) {
+        // MHD has set the session up but not read the ClientHello yet
+        if (gnutls_session_ticket_enable_server(session, &ticketKey) == GNUTLS_E_SUCCESS) {
+            gnutls_db_set_cache_expiration(session, TLS_TICKET_LIFETIME_S);
+        }
+    } else if (code == MHD_CONNECTION_NOTIFY_CLOSED) {
+        TlsHandshake result;
+
+        // The client's Finished is the last message a server receives,
+        // unless a TLS 1.3 key update came after it
+        last = gnutls_handshake_get_last_in(session);
+        if (last != GNUTLS_HANDSHAKE_FINISHED && last != GNUTLS_HANDSHAKE_KEY_UPDATE) {
+            result = TLS_HANDSHAKE_FAILED;
+        } else {
+            result = gnutls_session_is_resumed(session) ? TLS_HANDSHAKE_RESUMED : TLS_HANDSHAKE_FULL;
+        }
+        __atomic_fetch_add(&handshakes[result], 1, __ATOMIC_RELAXED);
+    }
+#else
+    (void)connection;
+    (void)code;
+#endif
+}
+
+void tlsServerDestroy(void) {
+    tlsEnabled = false;
+    options[0] = (struct MHD_OptionItem){ MHD_OPTION_END, 0, NULL };
+#ifdef WATCHDOG_TLS
+    if (ticketKey.data != NULL) {
+        gnutls_memset(ticketKey.data, 0, ticketKey.size);
+        gnutls_free(ticketKey.data);
+        ticketKey.data = NULL;
+        ticketKey.size = 0;
+    }
+#endif
+    if (keyPem != NULL) {
+        explicit_bzero(keyPem, strlen(keyPem));
+        free(keyPem);
+        keyPem = NULL;
+    }
+    free(certPem);
+    certPem = NULL;
+}
+
+void tlsServerCollectMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+
+    if (!tlsEnabled) {
+        return;
+    }
+    metricsHeader(out, "watchdog_tls_handshakes_total", "counter",
+                  "TLS connections closed, by whether their handshake was full, resumed from a ticket or failed");
+    for (int i = 0; i < TLS_HANDSHAKE_COUNT; i++) {
+        strbufAppendf(out, "watchdog_tls_handshakes_total{result=\"%s\"} %llu\n", handshakeNames[i],
+                      (unsigned long long)__atomic_load_n(&handshakes[i], __ATOMIC_RELAXED));
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef TLS_SERVER_H
+#define TLS_SERVER_H
+
+#include <stdbool.h>
+#include <microhttpd.h>
+#include "strbuf.h"
+
+#define TLS_DEFAULT_PRIORITIES "NORMAL:-VERS-TLS1.0:-VERS-TLS1.1"
+#define TLS_TICKET_LIFETIME_S 21600          // How long a client may resume without a full handshake
+#define TLS_PEM_MAX (64 * 1024)
+
+// Native HTTPS through MHD's GnuTLS backend (make TLS=1). The certificate
+// chain and key are read once at startup. Session tickets (RFC 5077, and
+// TLS 1.3 resumption) are enabled on every connection with one ticket key
+// generated at startup; GnuTLS derives the rotating keys from it. A
+// poller that reconnects then resumes with a ticket and skips the
+// certificate exchange and signature, the expensive part of a handshake
+// on a low-power CPU. Together with keep-alive (--connection-timeout),
+// most requests need no handshake at all. Tickets do not survive a
+// restart: the first connection after one is a full handshake again.
+
+// Read the PEM files and prepare the ticket key; before startHttpDaemon().
+// priorities is a GnuTLS priority string, NULL for TLS_DEFAULT_PRIORITIES.
+// False, with a message, when a file cannot be read or TLS is not built in.
+bool tlsServerConfigure(const char *certPath, const char *keyPath, const char *priorities);
+bool tlsServerEnabled(void);
+
+// What MHD_start_daemon() needs: MHD_USE_TLS, or 0, and the options for
+// MHD_OPTION_ARRAY (only MHD_OPTION_END without TLS)
+unsigned int tlsServerDaemonFlags(void);
+struct MHD_OptionItem* tlsServerDaemonOptions(void);
+
+// From the MHD_OPTION_NOTIFY_CONNECTION callback. A new session is set up
+// for tickets before its handshake starts; a closing one is counted as a
+// full, resumed or failed handshake.
+void tlsServerConnectionNotify(void *cls, struct MHD_Connection *connection, void **socketContext,
+                               enum MHD_ConnectionNotificationCode code);
+
+// Once MHD has stopped
+void tlsServerDestroy(void);
+
+void tlsServerCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // TLS_SERVER_H
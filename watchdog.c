@@ -0,0 +1,763 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "watchdog.h"
+#include "metrics.h"
+#include "timeutil.h"
+#include "susi_caps.h"
+#include "susi_timing.h"
+#include "events.h"
+
+static const struct {
+    uint32_t itemId;
+    const char *key;
+} wdtCapItems[WDT_CAP_COUNT] = {
+    [WDT_CAP_UNIT]      = { SUSI_ID_WDT_UNIT_MINIMUM,  "time_unit_ms" },
+    [WDT_CAP_DELAY_MIN] = { SUSI_ID_WDT_DELAY_MINIMUM, "min_delay_time_ms" },
+    [WDT_CAP_DELAY_MAX] = { SUSI_ID_WDT_DELAY_MAXIMUM, "max_delay_time_ms" },
+    [WDT_CAP_EVENT_MIN] = { SUSI_ID_WDT_EVENT_MINIMUM, "min_event_time_ms" },
+    [WDT_CAP_EVENT_MAX] = { SUSI_ID_WDT_EVENT_MAXIMUM, "max_event_time_ms" },
+    [WDT_CAP_RESET_MIN] = { SUSI_ID_WDT_RESET_MINIMUM, "min_reset_time_ms" },
+    [WDT_CAP_RESET_MAX] = { SUSI_ID_WDT_RESET_MAXIMUM, "max_reset_time_ms" },
+};
+
+static WatchdogDevice devices[WATCHDOG_MAX_DEVICES];
+static SusiId_t defaultId = SUSI_ID_WATCHDOG_1;
+static SusiId_t firstPresentId = SUSI_ID_WATCHDOG_1;
+static int presentCount = 0;
+static pthread_mutex_t capsRefreshLock = PTHREAD_MUTEX_INITIALIZER;
+static double nearMissFraction = WATCHDOG_DEFAULT_NEAR_MISS_FRACTION;
+static uint64_t jitterWindowNs = WATCHDOG_DEFAULT_JITTER_WINDOW_S * 1000000000ull;
+
+// Start the watchdog
+static bool startWatchdog(SusiId_t id, uint32_t delayTime, uint32_t eventTime, uint32_t resetTime, uint32_t eventType) {
+    uint64_t start = monotonicNowNs();
+    SusiStatus_t status = SusiWDogStart(id, delayTime, eventTime, resetTime, eventType);
+    susiTimingRecord(SUSI_CALL_WDOG_START, start, status);
+    return (status == SUSI_STATUS_SUCCESS);
+}
+
+// Trigger (feed) the watchdog
+static bool triggerWatchdog(SusiId_t id) {
+    uint64_t start = monotonicNowNs();
+    SusiStatus_t status = SusiWDogTrigger(id);
+    susiTimingRecord(SUSI_CALL_WDOG_TRIGGER, start, status);
+    return (status == SUSI_STATUS_SUCCESS);
+}
+
+// Stop the watchdog
+static bool stopWatchdog(SusiId_t id) {
+    uint64_t start = monotonicNowNs();
+    SusiStatus_t status = SusiWDogStop(id);
+    susiTimingRecord(SUSI_CALL_WDOG_STOP, start, status);
+    return (status == SUSI_STATUS_SUCCESS);
+}
+
+static SusiStatus_t getWatchdogCap(SusiId_t id, SusiId_t item, uint32_t *value) {
+    return susiCapsGet(SUSI_CAPS_WDOG, id, item, value);
+}
+
+// Read every capability item of a watchdog from the EC
+static void probeWatchdogCaps(SusiId_t id, WatchdogCaps *caps) {
+    uint32_t value;
+    
+    memset(caps, 0, sizeof(*caps));
+    caps->id = id;
+    
+    // Check if watchdog is supported
+    if (getWatchdogCap(id, SUSI_ID_WDT_SUPPORT_FLAGS, &value) != SUSI_STATUS_SUCCESS) {
+        return;
+    }
+    caps->supported = true;
+    caps->supportFlags = value;
+    
+    for (int i = 0; i < WDT_CAP_COUNT; i++) {
+        if (getWatchdogCap(id, wdtCapItems[i].itemId, &value) == SUSI_STATUS_SUCCESS) {
+            caps->values[i] = value;
+            caps->validMask |= 1u << i;
+        }
+    }
+}
+
+static void hwProbeWatchdogCaps(void *arg) {
+    WatchdogCaps *caps = (WatchdogCaps *)arg;
+    probeWatchdogCaps(caps->id, caps);
+}
+
+static void recordWatchdogStart(FeedTracker *tracker, const WatchdogCommand *cmd) {
+    uint64_t now = monotonicNowNs();
+    
+    __atomic_store_n(&tracker->delayTime, cmd->delayTime, __ATOMIC_RELAXED);
+    __atomic_store_n(&tracker->eventTime, cmd->eventTime, __ATOMIC_RELAXED);
+    __atomic_store_n(&tracker->resetTime, cmd->resetTime, __ATOMIC_RELAXED);
+    __atomic_store_n(&tracker->eventType, cmd->eventType, __ATOMIC_RELAXED);
+    __atomic_store_n(&tracker->feedCount, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&tracker->minSlackMs, INT64_MAX, __ATOMIC_RELAXED);
+    // The delay before the first trigger is not a feed interval
+    tracker->lastTriggerNs = 0;
+    tracker->lastIntervalNs = 0;
+    __atomic_store_n(&tracker->lastFeedNs, now, __ATOMIC_RELAXED);
+    __atomic_store_n(&tracker->armedNs, now, __ATOMIC_RELEASE);
+}
+
+bool watchdogSetNearMissFraction(double fraction) {
+    if (!(fraction >= 0.0 && fraction <= 1.0)) {
+        return false;
+    }
+    nearMissFraction = fraction;
+    return true;
+}
+
+bool watchdogSetJitterWindow(uint32_t seconds) {
+    if (seconds == 0) {
+        return false;
+    }
+    jitterWindowNs = seconds * 1000000000ull;
+    return true;
+}
+
+// Interval, jitter and near-miss bookkeeping for one trigger; slackMs is
+// the time that was left before the reset
+static void recordFeedCadence(FeedTracker *tracker, uint64_t now, int64_t slackMs) {
+    uint32_t eventTime = __atomic_load_n(&tracker->eventTime, __ATOMIC_RELAXED);
+    uint64_t intervalNs;
+    uint64_t jitterNs;
+
+    // With an event stage the miss is measured against the event, which
+    // comes resetTime before the reset
+    if (__atomic_load_n(&tracker->eventType, __ATOMIC_RELAXED) != SUSI_WDT_EVENT_TYPE_NONE) {
+        slackMs -= __atomic_load_n(&tracker->resetTime, __ATOMIC_RELAXED);
+    }
+    if (slackMs < (int64_t)(nearMissFraction * eventTime)) {
+        __atomic_fetch_add(&tracker->nearMisses, 1, __ATOMIC_RELAXED);
+    }
+    if (now - tracker->windowStartNs >= jitterWindowNs) {
+        __atomic_store_n(&tracker->lastJitterNs, tracker->windowJitterNs, __ATOMIC_RELAXED);
+        __atomic_store_n(&tracker->lastIntervalMaxNs, tracker->windowIntervalNs, __ATOMIC_RELAXED);
+        __atomic_store_n(&tracker->windowJitterNs, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&tracker->windowIntervalNs, 0, __ATOMIC_RELAXED);
+        tracker->windowStartNs = now;
+    }
+    if (tracker->lastTriggerNs != 0) {
+        intervalNs = now - tracker->lastTriggerNs;
+        histogramRecord(&tracker->intervals, intervalNs);
+        if (intervalNs > tracker->windowIntervalNs) {
+            __atomic_store_n(&tracker->windowIntervalNs, intervalNs, __ATOMIC_RELAXED);
+        }
+        if (tracker->lastIntervalNs != 0) {
+            jitterNs = intervalNs > tracker->lastIntervalNs ? intervalNs - tracker->lastIntervalNs
+                                                            : tracker->lastIntervalNs - intervalNs;
+            if (jitterNs > tracker->windowJitterNs) {
+                __atomic_store_n(&tracker->windowJitterNs, jitterNs, __ATOMIC_RELAXED);
+            }
+        }
+        tracker->lastIntervalNs = intervalNs;
+    }
+    tracker->lastTriggerNs = now;
+}
+
+static void recordWatchdogFeed(WatchdogDevice *device) {
+    FeedTracker *tracker = &device->tracker;
+    uint64_t now = monotonicNowNs();
+    int64_t slackMs = watchdogResetDeadlineNs(device, now, NULL) / 1000000;
+    int64_t current = __atomic_load_n(&tracker->minSlackMs, __ATOMIC_RELAXED);
+    
+    // Lock-free minimum
+    while (slackMs < current &&
+           !__atomic_compare_exchange_n(&tracker->minSlackMs, &current, slackMs, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    uint64_t count = __atomic_add_fetch(&tracker->feedCount, 1, __ATOMIC_RELAXED);
+    recordFeedCadence(tracker, now, slackMs);
+    __atomic_store_n(&tracker->lastFeedNs, now, __ATOMIC_RELEASE);
+    
+    if (slackMs < 0) {
+        eventPublish(EVENT_MISSED_DEADLINE, device->id, (uint32_t)(-slackMs), 0, 0, 0);
+    }
+    eventPublish(EVENT_TRIGGER, device->id, (uint32_t)count, (uint32_t)(int32_t)slackMs, 0, 0);
+}
+
+static void recordWatchdogStop(FeedTracker *tracker) {
+    __atomic_store_n(&tracker->armedNs, 0, __ATOMIC_RELEASE);
+}
+
+// Time left until the board would reset (negative once the deadline passed)
+int64_t watchdogResetDeadlineNs(WatchdogDevice *device, uint64_t nowNs, uint64_t *elapsedNs) {
+    FeedTracker *tracker = &device->tracker;
+    uint64_t armed = __atomic_load_n(&tracker->armedNs, __ATOMIC_ACQUIRE);
+    uint64_t lastFeed = __atomic_load_n(&tracker->lastFeedNs, __ATOMIC_ACQUIRE);
+    uint64_t windowMs = (uint64_t)__atomic_load_n(&tracker->eventTime, __ATOMIC_RELAXED) +
+                        __atomic_load_n(&tracker->resetTime, __ATOMIC_RELAXED);
+    uint64_t elapsed;
+    
+    if (armed == 0) {
+        if (elapsedNs) {
+            *elapsedNs = 0;
+        }
+        return INT64_MAX;
+    }
+    // The initial delay only applies until the first trigger
+    if (lastFeed == armed) {
+        windowMs += __atomic_load_n(&tracker->delayTime, __ATOMIC_RELAXED);
+    }
+    elapsed = nowNs > lastFeed ? nowNs - lastFeed : 0;
+    if (elapsedNs) {
+        *elapsedNs = elapsed;
+    }
+    return (int64_t)(windowMs * 1000000ull) - (int64_t)elapsed;
+}
+
+bool watchdogInit(void) {
+    const ServiceConfig *config;
+    
+    presentCount = 0;
+    
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        WatchdogDevice *device = &devices[i];
+        
+        memset(device, 0, sizeof(*device));
+        device->id = (SusiId_t)i;
+        device->tracker.minSlackMs = INT64_MAX;
+        
+        if (!snapshotInit(&device->infoSnapshot, WATCHDOG_INFO_CAPACITY, "application/json", "info")) {
+            return false;
+        }
+        // Discovery doubles as the one-time capability probe
+        watchdogRefreshCaps(device);
+        device->present = device->caps && device->caps->supported;
+        if (device->present) {
+            presentCount++;
+        }
+    }
+    
+    printf("Found %d watchdog timer(s)\n", presentCount);
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        if (devices[i].present) {
+            firstPresentId = (SusiId_t)i;
+            break;
+        }
+    }
+    config = serviceConfigAcquire();
+    watchdogApplyConfig(config);
+    serviceConfigRelease(config);
+    return true;
+}
+
+void watchdogShutdown(void) {
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        WatchdogDevice *device = &devices[i];
+        
+        if (device->running) {
+            printf("Stopping watchdog %u...\n", device->id);
+            stopWatchdog(device->id);
+            device->running = false;
+        }
+        snapshotDestroy(&device->infoSnapshot);
+    }
+}
+
+WatchdogDevice* watchdogDevice(SusiId_t id) {
+    if (id >= WATCHDOG_MAX_DEVICES) {
+        return NULL;
+    }
+    return &devices[id];
+}
+
+WatchdogDevice* watchdogDefaultDevice(void) {
+    return &devices[__atomic_load_n(&defaultId, __ATOMIC_RELAXED)];
+}
+
+// Select the timer served by the legacy /api/* routes
+bool watchdogSetDefault(SusiId_t id) {
+    if (id >= WATCHDOG_MAX_DEVICES) {
+        return false;
+    }
+    __atomic_store_n(&defaultId, id, __ATOMIC_RELAXED);
+    return true;
+}
+
+int watchdogDeviceCount(void) {
+    return presentCount;
+}
+
+// A timer without a configured id falls back to the first present one
+void watchdogApplyConfig(const ServiceConfig *config) {
+    if (config->watchdogId >= 0) {
+        watchdogSetDefault((SusiId_t)config->watchdogId);
+    } else {
+        watchdogSetDefault(firstPresentId);
+    }
+}
+
+const char* watchdogCheckConfig(const ServiceConfig *config) {
+    WatchdogCommand cmd;
+    
+    if (config->watchdogId >= 0 && !devices[config->watchdogId].present) {
+        return "watchdog_id names a timer the EC does not report";
+    }
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        const char *error;
+        
+        if (!devices[i].present) {
+            continue;
+        }
+        cmd.device = &devices[i];
+        cmd.delayTime = config->delayTime;
+        cmd.eventTime = config->eventTime;
+        cmd.resetTime = config->resetTime;
+        cmd.eventType = config->eventType;
+        if ((error = watchdogCheckTimings(&devices[i], &cmd)) != NULL) {
+            return error;
+        }
+    }
+    return NULL;
+}
+
+void watchdogCommandInit(WatchdogCommand *cmd, WatchdogDevice *device) {
+    cmd->device = device;
+    if (device->running || __atomic_load_n(&device->configured, __ATOMIC_ACQUIRE)) {
+        cmd->delayTime = device->delayTime;
+        cmd->eventTime = device->eventTime;
+        cmd->resetTime = device->resetTime;
+        cmd->eventType = device->eventType;
+    } else {
+        // All four defaults come from one published file, never a mix
+        const ServiceConfig *config = serviceConfigAcquire();
+        cmd->delayTime = config->delayTime;
+        cmd->eventTime = config->eventTime;
+        cmd->resetTime = config->resetTime;
+        cmd->eventType = config->eventType;
+        serviceConfigRelease(config);
+    }
+    cmd->ok = false;
+    cmd->error = NULL;
+}
+
+// Check requested timings against the cached capability ranges. Items the
+// EC did not report are not checked; the hardware gets the final say.
+const char* watchdogCheckTimings(WatchdogDevice *device, const WatchdogCommand *cmd) {
+    static const struct {
+        WatchdogCapItem min, max;
+        const char *error;
+    } ranges[] = {
+        { WDT_CAP_DELAY_MIN, WDT_CAP_DELAY_MAX, "Delay time outside the supported range" },
+        { WDT_CAP_EVENT_MIN, WDT_CAP_EVENT_MAX, "Event time outside the supported range" },
+        { WDT_CAP_RESET_MIN, WDT_CAP_RESET_MAX, "Reset time outside the supported range" },
+    };
+    const WatchdogCaps *caps = watchdogGetCaps(device);
+    const uint32_t values[] = { cmd->delayTime, cmd->eventTime, cmd->resetTime };
+    
+    if (caps == NULL || !caps->supported) {
+        return NULL;
+    }
+    for (size_t i = 0; i < sizeof(ranges) / sizeof(ranges[0]); i++) {
+        if (((caps->validMask >> ranges[i].min) & 1) && values[i] < caps->values[ranges[i].min]) {
+            return ranges[i].error;
+        }
+        if (((caps->validMask >> ranges[i].max) & 1) && values[i] > caps->values[ranges[i].max]) {
+            return ranges[i].error;
+        }
+    }
+    // Event types 1..4 map onto support flag bits 1..4
+    if (cmd->eventType > SUSI_WDT_EVENT_TYPE_PIN) {
+        return "Unknown event type";
+    }
+    if (cmd->eventType != SUSI_WDT_EVENT_TYPE_NONE && !(caps->supportFlags & (1u << cmd->eventType))) {
+        return "Event type not supported by this watchdog";
+    }
+    return NULL;
+}
+
+// True if the command carries the current config file defaults
+static bool usesDefaultTimings(const WatchdogCommand *cmd) {
+    const ServiceConfig *config = serviceConfigAcquire();
+    bool same = cmd->delayTime == config->delayTime && cmd->eventTime == config->eventTime &&
+                cmd->resetTime == config->resetTime && cmd->eventType == config->eventType;
+    
+    serviceConfigRelease(config);
+    return same;
+}
+
+// The hw* functions run on the hardware thread, which is the only writer of
+// the device state; request threads just read it.
+void hwWatchdogStart(void *arg) {
+    WatchdogCommand *cmd = (WatchdogCommand *)arg;
+    WatchdogDevice *device = cmd->device;
+    
+    cmd->ok = false;
+    if (device->running) {
+        cmd->error = "Watchdog is already running";
+        return;
+    }
+    if ((cmd->error = watchdogCheckTimings(device, cmd)) != NULL) {
+        return;
+    }
+    // Starting with explicit timings pins them, like a configure would
+    if (!device->configured && !usesDefaultTimings(cmd)) {
+        __atomic_store_n(&device->configured, true, __ATOMIC_RELEASE);
+    }
+    device->delayTime = cmd->delayTime;
+    device->eventTime = cmd->eventTime;
+    device->resetTime = cmd->resetTime;
+    device->eventType = cmd->eventType;
+    if (!startWatchdog(device->id, cmd->delayTime, cmd->eventTime, cmd->resetTime, cmd->eventType)) {
+        cmd->error = "Failed to start watchdog";
+        return;
+    }
+    recordWatchdogStart(&device->tracker, cmd);
+    device->running = true;
+    cmd->ok = true;
+    eventPublish(EVENT_START, device->id, cmd->delayTime, cmd->eventTime, cmd->resetTime, cmd->eventType);
+}
+
+void hwWatchdogTrigger(void *arg) {
+    WatchdogCommand *cmd = (WatchdogCommand *)arg;
+    WatchdogDevice *device = cmd->device;
+    
+    cmd->ok = false;
+    if (!device->running) {
+        cmd->error = "Watchdog is not running";
+        return;
+    }
+    if (!triggerWatchdog(device->id)) {
+        cmd->error = "Failed to trigger watchdog";
+        return;
+    }
+    recordWatchdogFeed(device);
+    cmd->ok = true;
+}
+
+void hwWatchdogStop(void *arg) {
+    WatchdogCommand *cmd = (WatchdogCommand *)arg;
+    WatchdogDevice *device = cmd->device;
+    
+    cmd->ok = false;
+    if (!device->running) {
+        cmd->error = "Watchdog is not running";
+        return;
+    }
+    if (!stopWatchdog(device->id)) {
+        cmd->error = "Failed to stop watchdog";
+        return;
+    }
+    recordWatchdogStop(&device->tracker);
+    device->running = false;
+    cmd->ok = true;
+    eventPublish(EVENT_STOP, device->id, 0, 0, 0, 0);
+}
+
+void hwWatchdogConfigure(void *arg) {
+    WatchdogCommand *cmd = (WatchdogCommand *)arg;
+    WatchdogDevice *device = cmd->device;
+    
+    cmd->ok = false;
+    if (device->running) {
+        cmd->error = "Cannot configure watchdog while running. Stop it first.";
+        return;
+    }
+    if ((cmd->error = watchdogCheckTimings(device, cmd)) != NULL) {
+        return;
+    }
+    device->delayTime = cmd->delayTime;
+    device->eventTime = cmd->eventTime;
+    device->resetTime = cmd->resetTime;
+    device->eventType = cmd->eventType;
+    __atomic_store_n(&device->configured, true, __ATOMIC_RELEASE);
+    cmd->ok = true;
+    eventPublish(EVENT_CONFIGURE, device->id, cmd->delayTime, cmd->eventTime, cmd->resetTime, cmd->eventType);
+}
+
+const char watchdogQueueFull[] = "Hardware queue is full";
+
+bool watchdogExecute(HwLane lane, HwCommandFn fn, WatchdogCommand *cmd) {
+    if (!hwActorCall(lane, fn, cmd)) {
+        cmd->ok = false;
+        cmd->error = watchdogQueueFull;
+        return false;
+    }
+    return cmd->ok;
+}
+
+const WatchdogCaps* watchdogGetCaps(WatchdogDevice *device) {
+    return __atomic_load_n(&device->caps, __ATOMIC_ACQUIRE);
+}
+
+// Probe the hardware again and republish the capabilities and /info body
+bool watchdogRefreshCaps(WatchdogDevice *device) {
+    WatchdogCaps probed;
+    WatchdogCaps *next;
+    JsonWriter writer;
+    StrBuf out;
+    char *data;
+    size_t capacity;
+    bool ok = false;
+    
+    // Refreshes of one timer that arrive together share the probe
+    probed.id = device->id;
+    susiCapsInvalidate(SUSI_CAPS_WDOG, device->id);
+    if (!hwActorCallShared(HW_LANE_READ, device->id, hwProbeWatchdogCaps, &probed, &probed, sizeof(probed))) {
+        return false;
+    }
+    
+    pthread_mutex_lock(&capsRefreshLock);
+    
+    // Fill the slot that is not currently published
+    next = (device->caps == &device->capsSlots[0]) ? &device->capsSlots[1] : &device->capsSlots[0];
+    *next = probed;
+    __atomic_store_n(&device->caps, next, __ATOMIC_RELEASE);
+    
+    data = snapshotBegin(&device->infoSnapshot, &capacity);
+    if (data) {
+        strbufInit(&out, data, capacity);
+        jsonWriterInit(&writer, &out);
+        watchdogWriteInfo(&writer, device->id, next);
+        if (!out.overflow) {
+            ok = snapshotPublish(&device->infoSnapshot, out.length);
+        } else {
+            snapshotAbort(&device->infoSnapshot);
+        }
+    }
+    
+    pthread_mutex_unlock(&capsRefreshLock);
+    return ok;
+}
+
+// Write the status fields of a device into an open JSON object
+void watchdogWriteStatus(JsonWriter *writer, WatchdogDevice *device) {
+    FeedTracker *tracker = &device->tracker;
+    WatchdogCommand timings;
+    
+    watchdogCommandInit(&timings, device);
+    jsonFieldUint(writer, "watchdog_id", device->id);
+    jsonFieldBool(writer, "running", device->running);
+    jsonFieldUint(writer, "delay_time", timings.delayTime);
+    jsonFieldUint(writer, "event_time", timings.eventTime);
+    jsonFieldUint(writer, "reset_time", timings.resetTime);
+    jsonFieldUint(writer, "event_type", timings.eventType);
+    
+    // Calculate remaining times if running
+    if (device->running) {
+        uint64_t elapsedNs = 0;
+        int64_t resetRemainingNs = watchdogResetDeadlineNs(device, monotonicNowNs(), &elapsedNs);
+        int64_t minSlack = __atomic_load_n(&tracker->minSlackMs, __ATOMIC_RELAXED);
+        uint32_t armedReset = __atomic_load_n(&tracker->resetTime, __ATOMIC_RELAXED);
+        
+        jsonFieldUint(writer, "max_total_time_ms",
+                      (uint64_t)timings.delayTime + timings.eventTime + timings.resetTime);
+        jsonFieldUint(writer, "elapsed_since_feed_ms", elapsedNs / 1000000);
+        jsonFieldInt(writer, "remaining_to_reset_ms", resetRemainingNs / 1000000);
+        if (__atomic_load_n(&tracker->eventType, __ATOMIC_RELAXED) != SUSI_WDT_EVENT_TYPE_NONE) {
+            jsonFieldInt(writer, "remaining_to_event_ms", resetRemainingNs / 1000000 - (int64_t)armedReset);
+        }
+        jsonFieldUint(writer, "feed_count", __atomic_load_n(&tracker->feedCount, __ATOMIC_RELAXED));
+        if (minSlack != INT64_MAX) {
+            jsonFieldInt(writer, "min_slack_ms", minSlack);
+        }
+    }
+    // Cadence survives a stop so the last run can still be inspected
+    jsonFieldUint(writer, "near_misses", __atomic_load_n(&tracker->nearMisses, __ATOMIC_RELAXED));
+    jsonFieldUint(writer, "max_feed_jitter_ms", __atomic_load_n(&tracker->lastJitterNs, __ATOMIC_RELAXED) / 1000000);
+}
+
+// Write watchdog capabilities and information as a JSON object
+void watchdogWriteInfo(JsonWriter *writer, SusiId_t id, const WatchdogCaps *caps) {
+    jsonBeginObject(writer);
+    jsonFieldUint(writer, "watchdog_id", id);
+    
+    if (caps && caps->supported) {
+        jsonFieldBool(writer, "supported", true);
+        jsonFieldUint(writer, "support_flags", caps->supportFlags);
+        for (int i = 0; i < WDT_CAP_COUNT; i++) {
+            if (caps->validMask & (1u << i)) {
+                jsonFieldUint(writer, wdtCapItems[i].key, caps->values[i]);
+            }
+        }
+    } else {
+        jsonFieldBool(writer, "supported", false);
+        jsonFieldString(writer, "error", "Watchdog is not supported or failed to get capabilities");
+    }
+    
+    jsonEndObject(writer);
+}
+
+// Summary of every timer for GET /api/wdt
+void watchdogWriteList(JsonWriter *writer) {
+    SusiId_t current = __atomic_load_n(&defaultId, __ATOMIC_RELAXED);
+    
+    jsonBeginObject(writer);
+    jsonFieldUint(writer, "default", current);
+    jsonKey(writer, "watchdogs");
+    jsonBeginArray(writer);
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        jsonBeginObject(writer);
+        jsonFieldUint(writer, "watchdog_id", devices[i].id);
+        jsonFieldBool(writer, "present", devices[i].present);
+        jsonFieldBool(writer, "running", devices[i].running);
+        jsonFieldBool(writer, "default", devices[i].id == current);
+        jsonEndObject(writer);
+    }
+    jsonEndArray(writer);
+    jsonEndObject(writer);
+}
+
+// Feeder callback: feed every running timer
+bool watchdogAutoFeed(void *ctx) {
+    bool fed = false;
+    bool failed = false;
+    (void)ctx;
+    
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        WatchdogCommand cmd;
+        
+        if (!devices[i].running) {
+            continue;
+        }
+        watchdogCommandInit(&cmd, &devices[i]);
+        if (watchdogExecute(HW_LANE_FEED, hwWatchdogTrigger, &cmd)) {
+            fed = true;
+        } else {
+            failed = true;
+        }
+    }
+    return fed && !failed;
+}
+
+// Feeder slack: time until the first running timer would reset
+int64_t watchdogAutoFeedSlackNs(void *ctx) {
+    uint64_t now = monotonicNowNs();
+    int64_t slack = INT64_MAX;
+    (void)ctx;
+    
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        int64_t remaining;
+        
+        if (!devices[i].running) {
+            continue;
+        }
+        remaining = watchdogResetDeadlineNs(&devices[i], now, NULL);
+        if (remaining < slack) {
+            slack = remaining;
+        }
+    }
+    return slack;
+}
+
+// Prometheus collector for the per-device state (runs on the metrics thread)
+void watchdogCollectMetrics(StrBuf *out, void *ctx) {
+    uint64_t now = monotonicNowNs();
+    WatchdogCommand timings[WATCHDOG_MAX_DEVICES];
+    (void)ctx;
+    
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        watchdogCommandInit(&timings[i], &devices[i]);
+    }
+    
+    metricsHeader(out, "watchdog_running", "gauge", "Whether the hardware watchdog is running");
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        if (devices[i].present) {
+            strbufAppendf(out, "watchdog_running{id=\"%u\"} %d\n", devices[i].id, devices[i].running ? 1 : 0);
+        }
+    }
+    metricsHeader(out, "watchdog_delay_time_ms", "gauge", "Configured initial delay time");
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        if (devices[i].present) {
+            strbufAppendf(out, "watchdog_delay_time_ms{id=\"%u\"} %u\n", devices[i].id, timings[i].delayTime);
+        }
+    }
+    metricsHeader(out, "watchdog_event_time_ms", "gauge", "Configured event timeout");
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        if (devices[i].present) {
+            strbufAppendf(out, "watchdog_event_time_ms{id=\"%u\"} %u\n", devices[i].id, timings[i].eventTime);
+        }
+    }
+    metricsHeader(out, "watchdog_reset_time_ms", "gauge", "Configured reset timeout");
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        if (devices[i].present) {
+            strbufAppendf(out, "watchdog_reset_time_ms{id=\"%u\"} %u\n", devices[i].id, timings[i].resetTime);
+        }
+    }
+    metricsHeader(out, "watchdog_event_type", "gauge", "Configured event type");
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        if (devices[i].present) {
+            strbufAppendf(out, "watchdog_event_type{id=\"%u\"} %u\n", devices[i].id, timings[i].eventType);
+        }
+    }
+    
+    metricsHeader(out, "watchdog_seconds_since_feed", "gauge", "Time since the last successful start or trigger");
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        uint64_t elapsedNs = 0;
+
+        if (devices[i].running) {
+            watchdogResetDeadlineNs(&devices[i], now, &elapsedNs);
+            strbufAppendf(out, "watchdog_seconds_since_feed{id=\"%u\"} %.3f\n", devices[i].id, (double)elapsedNs / 1e9);
+        }
+    }
+    metricsHeader(out, "watchdog_reset_remaining_seconds", "gauge", "Time left before the board resets");
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        if (devices[i].running) {
+            strbufAppendf(out, "watchdog_reset_remaining_seconds{id=\"%u\"} %.3f\n", devices[i].id,
+                          (double)watchdogResetDeadlineNs(&devices[i], now, NULL) / 1e9);
+        }
+    }
+    metricsHeader(out, "watchdog_feeds_total", "counter", "Successful triggers since the watchdog was started");
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        if (devices[i].running) {
+            strbufAppendf(out, "watchdog_feeds_total{id=\"%u\"} %llu\n", devices[i].id,
+                          (unsigned long long)__atomic_load_n(&devices[i].tracker.feedCount, __ATOMIC_RELAXED));
+        }
+    }
+    metricsHeader(out, "watchdog_min_slack_seconds", "gauge", "Smallest time-to-reset observed at a feed");
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        int64_t minSlack = __atomic_load_n(&devices[i].tracker.minSlackMs, __ATOMIC_RELAXED);
+
+        if (devices[i].running && minSlack != INT64_MAX) {
+            strbufAppendf(out, "watchdog_min_slack_seconds{id=\"%u\"} %.3f\n", devices[i].id, (double)minSlack / 1e3);
+        }
+    }
+
+    // Cadence is cumulative over the process, unlike the per-start counters above
+    metricsHeader(out, "watchdog_feed_interval_seconds", "summary", "Time between consecutive successful triggers");
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        char labels[32];
+
+        if (devices[i].present) {
+            snprintf(labels, sizeof(labels), "id=\"%u\"", devices[i].id);
+            histogramWriteSummary(out, "watchdog_feed_interval_seconds", labels, &devices[i].tracker.intervals);
+        }
+    }
+    metricsHeader(out, "watchdog_feed_near_misses_total", "counter",
+                  "Triggers that found less than the near-miss fraction of the event time left");
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        if (devices[i].present) {
+            strbufAppendf(out, "watchdog_feed_near_misses_total{id=\"%u\"} %llu\n", devices[i].id,
+                          (unsigned long long)__atomic_load_n(&devices[i].tracker.nearMisses, __ATOMIC_RELAXED));
+        }
+    }
+    metricsHeader(out, "watchdog_feed_jitter_max_seconds", "gauge",
+                  "Largest change between consecutive feed intervals, in the current and the last complete window");
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        FeedTracker *tracker = &devices[i].tracker;
+
+        if (!devices[i].present) {
+            continue;
+        }
+        strbufAppendf(out, "watchdog_feed_jitter_max_seconds{id=\"%u\",window=\"current\"} %.3f\n", devices[i].id,
+                      (double)__atomic_load_n(&tracker->windowJitterNs, __ATOMIC_RELAXED) / 1e9);
+        strbufAppendf(out, "watchdog_feed_jitter_max_seconds{id=\"%u\",window=\"last\"} %.3f\n", devices[i].id,
+                      (double)__atomic_load_n(&tracker->lastJitterNs, __ATOMIC_RELAXED) / 1e9);
+    }
+    metricsHeader(out, "watchdog_feed_interval_max_seconds", "gauge",
+                  "Longest feed interval, in the current and the last complete window");
+    for (int i = 0; i < WATCHDOG_MAX_DEVICES; i++) {
+        FeedTracker *tracker = &devices[i].tracker;
+
+        if (!devices[i].present) {
+            continue;
+        }
+        strbufAppendf(out, "watchdog_feed_interval_max_seconds{id=\"%u\",window=\"current\"} %.3f\n", devices[i].id,
+                      (double)__atomic_load_n(&tracker->windowIntervalNs, __ATOMIC_RELAXED) / 1e9);
+        strbufAppendf(out, "watchdog_feed_interval_max_seconds{id=\"%u\",window=\"last\"} %.3f\n", devices[i].id,
+                      (double)__atomic_load_n(&tracker->lastIntervalMaxNs, __ATOMIC_RELAXED) / 1e9);
+    }
+}
@@ -0,0 +1,156 @@
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "Susi4.h"
+#include "snapshot.h"
+#include "strbuf.h"
+#include "json_writer.h"
+#include "histogram.h"
+#include "hw_actor.h"
+#include "service_config.h"
+
+#define WATCHDOG_MAX_DEVICES SUSI_ID_WATCHDOG_MAX
+#define WATCHDOG_INFO_CAPACITY 1024
+#define WATCHDOG_DEFAULT_NEAR_MISS_FRACTION 0.25
+#define WATCHDOG_DEFAULT_JITTER_WINDOW_S 60
+
+// Watchdog capability items probed through SusiWDogGetCaps
+typedef enum {
+    WDT_CAP_UNIT,
+    WDT_CAP_DELAY_MIN,
+    WDT_CAP_DELAY_MAX,
+    WDT_CAP_EVENT_MIN,
+    WDT_CAP_EVENT_MAX,
+    WDT_CAP_RESET_MIN,
+    WDT_CAP_RESET_MAX,
+    WDT_CAP_COUNT
+} WatchdogCapItem;
+
+// Capabilities of one watchdog, read once from the EC and never modified
+// afterwards. A refresh fills the other slot and swaps the pointer.
+typedef struct {
+    SusiId_t id;
+    bool supported;
+    uint32_t supportFlags;
+    uint32_t validMask;              // Bit per WatchdogCapItem that was reported
+    uint32_t values[WDT_CAP_COUNT];
+} WatchdogCaps;
+
+// Feed deadline tracking. Timestamps are CLOCK_MONOTONIC nanoseconds and all
+// fields are accessed with atomics, so status readers never take a lock.
+// The model: after a start the timer runs delay + event + reset before the
+// board resets, after every trigger it runs event + reset again.
+typedef struct {
+    uint64_t armedNs;          // Last successful start, 0 if not running
+    uint64_t lastFeedNs;       // Last successful start or trigger
+    uint64_t feedCount;        // Successful triggers since start
+    uint32_t delayTime;        // Timings the watchdog was started with
+    uint32_t eventTime;
+    uint32_t resetTime;
+    uint32_t eventType;
+    int64_t minSlackMs;        // Smallest time-to-reset seen at a feed, INT64_MAX if none
+
+    // Feed cadence, from trigger to trigger whatever sent them. Written on
+    // the hardware thread only; jitter is the change between consecutive
+    // intervals, kept as a maximum per tumbling window.
+    uint64_t lastTriggerNs;    // 0 until the first trigger after a start
+    uint64_t lastIntervalNs;
+    uint64_t nearMisses;       // Feeds with less than the near-miss fraction of eventTime left before the event
+    uint64_t windowStartNs;
+    uint64_t windowJitterNs;   // Largest jitter in the current window
+    uint64_t windowIntervalNs; // Longest interval in the current window
+    uint64_t lastJitterNs;     // The same for the last complete window
+    uint64_t lastIntervalMaxNs;
+    Histogram intervals;
+} FeedTracker;
+
+// Per-timer state. Each device sits on its own cache lines so feeds of one
+// timer never contend with status reads of another. The running flag and
+// timings are only written on the hardware thread.
+typedef struct {
+    SusiId_t id;
+    bool present;                    // Reported by the EC at discovery
+    bool running;
+    bool configured;                 // Timings were set through the API; until
+                                     // then the config file defaults apply
+    uint32_t delayTime;              // Configured timings for the next start
+    uint32_t eventTime;
+    uint32_t resetTime;
+    uint32_t eventType;
+    FeedTracker tracker;
+    WatchdogCaps capsSlots[2];
+    WatchdogCaps *caps;              // Published capabilities
+    Snapshot infoSnapshot;           // Pre-serialized /info body
+} __attribute__((aligned(64))) WatchdogDevice;
+
+// Arguments and result of a command executed on the hardware thread
+typedef struct {
+    WatchdogDevice *device;
+    uint32_t delayTime;
+    uint32_t eventTime;
+    uint32_t resetTime;
+    uint32_t eventType;
+    bool ok;
+    const char *error;
+} WatchdogCommand;
+
+// Probe every SUSI watchdog ID and prepare the per-device state.
+// Must be called after hwActorStart() and serviceConfigInit().
+bool watchdogInit(void);
+// Stop every running timer; call after the hardware thread is stopped
+void watchdogShutdown(void);
+
+WatchdogDevice* watchdogDevice(SusiId_t id);
+WatchdogDevice* watchdogDefaultDevice(void);
+bool watchdogSetDefault(SusiId_t id);
+int watchdogDeviceCount(void);
+
+// Config file hooks: reject defaults that no present timer accepts, and
+// move /api/* to the configured timer after a reload
+const char* watchdogCheckConfig(const ServiceConfig *config);
+void watchdogApplyConfig(const ServiceConfig *config);
+
+// Fill a command with the device's timings: the ones it runs with or was
+// configured with, otherwise the current config file defaults
+void watchdogCommandInit(WatchdogCommand *cmd, WatchdogDevice *device);
+
+// Hardware-thread command bodies (run through hwActorCall)
+void hwWatchdogStart(void *arg);
+void hwWatchdogTrigger(void *arg);
+void hwWatchdogStop(void *arg);
+void hwWatchdogConfigure(void *arg);
+
+// Submit a command and wait; sets cmd->error to watchdogQueueFull if the
+// lane was full
+bool watchdogExecute(HwLane lane, HwCommandFn fn, WatchdogCommand *cmd);
+extern const char watchdogQueueFull[];
+
+const WatchdogCaps* watchdogGetCaps(WatchdogDevice *device);
+// NULL if the command's timings fit the device's capabilities, else an error
+const char* watchdogCheckTimings(WatchdogDevice *device, const WatchdogCommand *cmd);
+bool watchdogRefreshCaps(WatchdogDevice *device);
+
+int64_t watchdogResetDeadlineNs(WatchdogDevice *device, uint64_t nowNs, uint64_t *elapsedNs);
+
+// Before watchdogInit(): a feed that finds less than fraction * eventTime
+// left before the event stage (the reset without one) counts as a near
+// miss (0-1), and the jitter maximum is kept per window
+bool watchdogSetNearMissFraction(double fraction);
+bool watchdogSetJitterWindow(uint32_t seconds);
+
+// Status fields are written into an object the caller has opened, so it can
+// add its own fields; info and list write complete objects.
+void watchdogWriteStatus(JsonWriter *writer, WatchdogDevice *device);
+void watchdogWriteInfo(JsonWriter *writer, SusiId_t id, const WatchdogCaps *caps);
+void watchdogWriteList(JsonWriter *writer);
+
+// Feeder callback: triggers every running device
+bool watchdogAutoFeed(void *ctx);
+// Feeder slack callback: nanoseconds until the first running timer resets
+int64_t watchdogAutoFeedSlackNs(void *ctx);
+
+void watchdogCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // WATCHDOG_H
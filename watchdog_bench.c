@@ -0,0 +1,395 @@
+// Load generator for the watchdog HTTP service.
+// Drives a weighted mix of GET /api/status, POST /api/trigger and
+// GET /metrics over keep-alive connections (one thread per connection) and
+// prints throughput and latency percentiles as JSON on stdout.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "histogram.h"
+#include "json_writer.h"
+#include "timeutil.h"
+
+#define DEFAULT_HOST "127.0.0.1"
+#define DEFAULT_PORT "9101"
+#define DEFAULT_CONNECTIONS 8
+#define DEFAULT_DURATION 10
+#define RESPONSE_BUFFER 65536
+
+typedef enum {
+    BENCH_STATUS,
+    BENCH_TRIGGER,
+    BENCH_METRICS,
+    BENCH_COUNT
+} BenchRoute;
+
+static const char *benchRouteNames[BENCH_COUNT] = { "status", "trigger", "metrics" };
+
+typedef struct {
+    const char *host;
+    const char *port;
+    int connections;
+    int durationSec;
+    uint32_t weights[BENCH_COUNT];
+} BenchConfig;
+
+typedef struct {
+    int index;
+    pthread_t thread;
+    Histogram latency[BENCH_COUNT];
+    uint64_t requests[BENCH_COUNT];
+    uint64_t errors;          // Socket errors and malformed responses
+    uint64_t httpErrors;      // Status >= 400
+    uint64_t reconnects;
+    uint64_t bytes;
+} BenchWorker;
+
+static BenchConfig config;
+static char requestText[BENCH_COUNT][256];
+static size_t requestLength[BENCH_COUNT];
+static struct addrinfo *serverAddress = NULL;
+static volatile bool benchRunning = true;
+
+static int connectServer(void) {
+    int one = 1;
+    int fd = socket(serverAddress->ai_family, serverAddress->ai_socktype | SOCK_CLOEXEC,
+                    serverAddress->ai_protocol);
+    
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, serverAddress->ai_addr, serverAddress->ai_addrlen) != 0) {
+        close(fd);
+        return -1;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+static bool sendAll(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        length -= (size_t)sent;
+    }
+    return true;
+}
+
+// Read one response; returns the HTTP status or -1. *keepAlive is cleared
+// when the server announced it will close the connection.
+static int readResponse(int fd, char *buffer, size_t capacity, bool *keepAlive, uint64_t *bytes) {
+    size_t have = 0;
+    char *headerEnd = NULL;
+    long contentLength = -1;
+    int status;
+    
+    while (headerEnd == NULL) {
+        ssize_t got;
+        if (have + 1 >= capacity) {
+            return -1;
+        }
+        got = recv(fd, buffer + have, capacity - have - 1, 0);
+        if (got <= 0) {
+            return -1;
+        }
+        have += (size_t)got;
+        buffer[have] = '\0';
+        headerEnd = strstr(buffer, "\r\n\r\n");
+    }
+    if (sscanf(buffer, "HTTP/1.%*d %d", &status) != 1) {
+        return -1;
+    }
+    
+    *keepAlive = true;
+    for (char *line = strstr(buffer, "\r\n"); line && line < headerEnd; line = strstr(line + 2, "\r\n")) {
+        char *name = line + 2;
+        if (strncasecmp(name, "Content-Length:", 15) == 0) {
+            contentLength = strtol(name + 15, NULL, 10);
+        } else if (strncasecmp(name, "Connection:", 11) == 0) {
+            char *value = strcasestr(name, "close");
+            if (value && value < strstr(name, "\r\n")) {
+                *keepAlive = false;
+            }
+        }
+    }
+    if (contentLength < 0) {
+        // Without a length the body runs until the server closes
+        *keepAlive = false;
+        contentLength = 0;
+    }
+    
+    // Drain the body; it is not inspected
+    size_t headerLength = (size_t)(headerEnd + 4 - buffer);
+    size_t bodyHave = have - headerLength;
+    while (bodyHave < (size_t)contentLength) {
+        ssize_t got = recv(fd, buffer, capacity, 0);
+        if (got <= 0) {
+            return -1;
+        }
+        bodyHave += (size_t)got;
+    }
+    *bytes += headerLength + (size_t)contentLength;
+    return status;
+}
+
+static BenchRoute pickRoute(uint64_t *state) {
+    uint32_t total = config.weights[0] + config.weights[1] + config.weights[2];
+    uint32_t roll;
+    
+    // xorshift64: cheap and good enough to spread the mix
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    roll = (uint32_t)(*state % total);
+    for (int i = 0; i < BENCH_COUNT; i++) {
+        if (roll < config.weights[i]) {
+            return (BenchRoute)i;
+        }
+        roll -= config.weights[i];
+    }
+    return BENCH_STATUS;
+}
+
+static void* workerMain(void *arg) {
+    BenchWorker *worker = (BenchWorker *)arg;
+    uint64_t rng = 0x9e3779b97f4a7c15ull * (uint64_t)(worker->index + 1);
+    char *buffer = malloc(RESPONSE_BUFFER);
+    int fd = -1;
+    
+    if (buffer == NULL) {
+        return NULL;
+    }
+    while (benchRunning) {
+        BenchRoute route = pickRoute(&rng);
+        bool keepAlive = true;
+        uint64_t start;
+        int status;
+        
+        if (fd < 0) {
+            fd = connectServer();
+            if (fd < 0) {
+                worker->errors++;
+                usleep(10000);
+                continue;
+            }
+            worker->reconnects++;
+        }
+        
+        start = monotonicNowNs();
+        if (!sendAll(fd, requestText[route], requestLength[route])) {
+            status = -1;
+        } else {
+            status = readResponse(fd, buffer, RESPONSE_BUFFER, &keepAlive, &worker->bytes);
+        }
+        if (status < 0) {
+            worker->errors++;
+            close(fd);
+            fd = -1;
+            continue;
+        }
+        histogramRecord(&worker->latency[route], monotonicNowNs() - start);
+        worker->requests[route]++;
+        if (status >= 400) {
+            worker->httpErrors++;
+        }
+        if (!keepAlive) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    free(buffer);
+    return NULL;
+}
+
+static void writeLatency(JsonWriter *writer, const Histogram *histogram) {
+    uint64_t count = histogram->count;
+    
+    jsonBeginObject(writer);
+    jsonFieldUint(writer, "count", count);
+    jsonFieldUint(writer, "mean_us", count ? histogram->sumNs / count / 1000 : 0);
+    jsonFieldUint(writer, "p50_us", histogramQuantile(histogram, 0.5) / 1000);
+    jsonFieldUint(writer, "p90_us", histogramQuantile(histogram, 0.9) / 1000);
+    jsonFieldUint(writer, "p99_us", histogramQuantile(histogram, 0.99) / 1000);
+    jsonFieldUint(writer, "p999_us", histogramQuantile(histogram, 0.999) / 1000);
+    jsonFieldUint(writer, "max_us", histogram->maxNs / 1000);
+    jsonEndObject(writer);
+}
+
+// "70:20:10" -> status, trigger, metrics weights
+static bool parseMix(const char *text, uint32_t weights[BENCH_COUNT]) {
+    unsigned int a, b, c;
+    
+    if (sscanf(text, "%u:%u:%u", &a, &b, &c) != 3 || a + b + c == 0) {
+        return false;
+    }
+    weights[BENCH_STATUS] = a;
+    weights[BENCH_TRIGGER] = b;
+    weights[BENCH_METRICS] = c;
+    return true;
+}
+
+static void usage(const char *program) {
+    printf("Watchdog HTTP service load generator\n");
+    printf("Usage: %s [options]\n", program);
+    printf("Options:\n");
+    printf("  --host HOST          Service address (default: %s)\n", DEFAULT_HOST);
+    printf("  --port PORT          Service port (default: %s)\n", DEFAULT_PORT);
+    printf("  --connections N      Concurrent keep-alive connections (default: %d)\n", DEFAULT_CONNECTIONS);
+    printf("  --duration SEC       Test duration (default: %d)\n", DEFAULT_DURATION);
+    printf("  --mix S:T:M          Weights of status, trigger and metrics requests (default: 70:20:10)\n");
+    printf("  --help, -h           Show this help message\n");
+}
+
+int main(int argc, char *argv[]) {
+    static const char *paths[BENCH_COUNT] = { "GET /api/status", "POST /api/trigger", "GET /metrics" };
+    struct addrinfo hints;
+    BenchWorker *workers;
+    Histogram *total;
+    Histogram *perRoute;
+    uint64_t requests = 0, errors = 0, httpErrors = 0, reconnects = 0, bytes = 0;
+    uint64_t startNs, elapsedNs;
+    char *output;
+    StrBuf out;
+    JsonWriter writer;
+    int rc;
+    
+    config.host = DEFAULT_HOST;
+    config.port = DEFAULT_PORT;
+    config.connections = DEFAULT_CONNECTIONS;
+    config.durationSec = DEFAULT_DURATION;
+    parseMix("70:20:10", config.weights);
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+            config.host = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            config.port = argv[++i];
+        } else if (strcmp(argv[i], "--connections") == 0 && i + 1 < argc) {
+            config.connections = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+            config.durationSec = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--mix") == 0 && i + 1 < argc) {
+            if (!parseMix(argv[++i], config.weights)) {
+                fprintf(stderr, "Invalid mix '%s' (expected S:T:M)\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            usage(argv[0]);
+            return 0;
+        } else {
+            fprintf(stderr, "Unknown option '%s'\n", argv[i]);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (config.connections <= 0 || config.durationSec <= 0) {
+        fprintf(stderr, "Connections and duration must be positive\n");
+        return 1;
+    }
+    
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    rc = getaddrinfo(config.host, config.port, &hints, &serverAddress);
+    if (rc != 0) {
+        fprintf(stderr, "Cannot resolve %s:%s: %s\n", config.host, config.port, gai_strerror(rc));
+        return 1;
+    }
+    for (int i = 0; i < BENCH_COUNT; i++) {
+        int length = snprintf(requestText[i], sizeof(requestText[i]),
+                              "%s HTTP/1.1\r\nHost: %s:%s\r\nContent-Length: 0\r\n\r\n",
+                              paths[i], config.host, config.port);
+        requestLength[i] = (size_t)length;
+    }
+    
+    workers = calloc((size_t)config.connections, sizeof(*workers));
+    total = calloc(1, sizeof(*total));
+    perRoute = calloc(BENCH_COUNT, sizeof(*perRoute));
+    output = malloc(16384);
+    if (workers == NULL || total == NULL || perRoute == NULL || output == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    
+    fprintf(stderr, "Benchmarking %s:%s with %d connections for %d s (mix %u:%u:%u)\n",
+            config.host, config.port, config.connections, config.durationSec,
+            config.weights[0], config.weights[1], config.weights[2]);
+    
+    startNs = monotonicNowNs();
+    for (int i = 0; i < config.connections; i++) {
+        workers[i].index = i;
+        if (pthread_create(&workers[i].thread, NULL, workerMain, &workers[i]) != 0) {
+            fprintf(stderr, "Failed to start worker %d\n", i);
+            config.connections = i;
+            break;
+        }
+    }
+    sleep((unsigned int)config.durationSec);
+    benchRunning = false;
+    for (int i = 0; i < config.connections; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    elapsedNs = monotonicNowNs() - startNs;
+    
+    for (int i = 0; i < config.connections; i++) {
+        for (int r = 0; r < BENCH_COUNT; r++) {
+            histogramMerge(&perRoute[r], &workers[i].latency[r]);
+            histogramMerge(total, &workers[i].latency[r]);
+            requests += workers[i].requests[r];
+        }
+        errors += workers[i].errors;
+        httpErrors += workers[i].httpErrors;
+        reconnects += workers[i].reconnects;
+        bytes += workers[i].bytes;
+    }
+    
+    strbufInit(&out, output, 16384);
+    jsonWriterInit(&writer, &out);
+    jsonBeginObject(&writer);
+    jsonFieldString(&writer, "host", config.host);
+    jsonFieldString(&writer, "port", config.port);
+    jsonFieldInt(&writer, "connections", config.connections);
+    jsonFieldUint(&writer, "duration_ms", elapsedNs / 1000000);
+    jsonFieldUint(&writer, "requests", requests);
+    jsonFieldUint(&writer, "requests_per_second", elapsedNs ? requests * 1000000000ull / elapsedNs : 0);
+    jsonFieldUint(&writer, "bytes_received", bytes);
+    jsonFieldUint(&writer, "errors", errors);
+    jsonFieldUint(&writer, "http_errors", httpErrors);
+    jsonFieldUint(&writer, "connects", reconnects);
+    jsonKey(&writer, "latency");
+    writeLatency(&writer, total);
+    jsonKey(&writer, "routes");
+    jsonBeginObject(&writer);
+    for (int r = 0; r < BENCH_COUNT; r++) {
+        jsonKey(&writer, benchRouteNames[r]);
+        writeLatency(&writer, &perRoute[r]);
+    }
+    jsonEndObject(&writer);
+    jsonEndObject(&writer);
+    printf("%s\n", output);
+    
+    freeaddrinfo(serverAddress);
+    free(output);
+    free(perRoute);
+    free(total);
+    free(workers);
+    return (errors > 0 && requests == 0) ? 1 : 0;
+}
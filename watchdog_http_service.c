@@ -3,12 +3,80 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include <errno.h>
+#include <math.h>
 #include <unistd.h>
 #include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <malloc.h>
 #include <sys/types.h>
 #include <microhttpd.h>
-#include <jansson.h>
 #include "Susi4.h"
+#include "memory_inventory.h"
+#include "metrics.h"
+#include "snapshot.h"
+#include "access_log.h"
+#include "feeder.h"
+#include "health_checks.h"
+#include "hw_actor.h"
+#include "watchdog.h"
+#include "lifecycle.h"
+#include "json_writer.h"
+#include "response_pool.h"
+#include "control_socket.h"
+#include "lease.h"
+#include "route_stats.h"
+#include "susi_timing.h"
+#include "config_body.h"
+#include "events.h"
+#include "service_config.h"
+#include "pretimeout.h"
+#include "hwm_sampler.h"
+#include "hwm_history.h"
+#include "hwm_export.h"
+#include "hwm_store.h"
+#include "gpio_events.h"
+#include "gpio_bank.h"
+#include "bus_scan.h"
+#include "i2c_txn.h"
+#include "smb_bulk.h"
+#include "i2c_cache.h"
+#include "storage_area.h"
+#include "storage_kv.h"
+#include "fan_control.h"
+#include "thermal_monitor.h"
+#include "alert_rules.h"
+#include "config_txn.h"
+#include "backlight.h"
+#include "battery_monitor.h"
+#include "board_info.h"
+#include "pic_telemetry.h"
+#include "poe_energy.h"
+#include "poe_monitor.h"
+#include "sab2000_alerts.h"
+#include "webhook.h"
+#include "mqtt_bridge.h"
+#include "shm_telemetry.h"
+#include "susi_iot.h"
+#include "susi_caps.h"
+#include "susi_breaker.h"
+#include "rate_limit.h"
+#include "fleet.h"
+#include "susi_session.h"
+#include "systemd_bridge.h"
+#include "cuse_watchdog.h"
+#include "realtime.h"
+#include "content_encoding.h"
+#include "batch.h"
+#include "diag_dump.h"
+#include "rtc_wake.h"
+#include "scheduler.h"
+#include "self_stats.h"
+#include "tls_server.h"
+#include "span_trace.h"
+#include "build_profile.h"
+#include "mem_pool.h"
 
 // Configuration
 #define DEFAULT_PORT 9101  // Aligned with Prometheus exporter port range
@@ -17,489 +85,3773 @@
 #define DEFAULT_RESET_TIME 1000    // 1 second reset time
 #define DEFAULT_EVENT_TYPE SUSI_WDT_EVENT_TYPE_NONE
 
+// Server mode defaults
+#ifndef DEFAULT_SERVER_THREADS
+#define DEFAULT_SERVER_THREADS 0         // 0 = one thread per CPU core
+#endif
+#ifndef DEFAULT_MAX_CONNECTIONS
+#define DEFAULT_MAX_CONNECTIONS 256      // Total concurrent connections
+#endif
+#define DEFAULT_PER_IP_CONNECTIONS 0     // 0 = unlimited per client address
+#ifndef DEFAULT_CONNECTION_MEMORY
+#define DEFAULT_CONNECTION_MEMORY 16384  // Per-connection memory cap in bytes
+#endif
+#define DEFAULT_CONNECTION_TIMEOUT 30    // Idle keep-alive timeout in seconds
+#define DEFAULT_CONTROL_SOCKET_MODE 0660 // Owner and group may feed
+
+// Limits of one POST /api/i2c batch
+#define I2C_HTTP_MAX_OPS 16
+#define I2C_HTTP_MAX_BYTES 32            // Per direction and operation
+
+// How libmicrohttpd dispatches connections
+typedef enum {
+    SERVER_MODE_THREAD,   // One thread per connection (legacy behaviour)
+    SERVER_MODE_SELECT,   // Internal select() polling thread(s)
+    SERVER_MODE_POLL,     // Internal poll() polling thread(s)
+    SERVER_MODE_EPOLL     // Internal epoll thread pool (Linux)
+} ServerMode;
+
+#ifndef DEFAULT_SERVER_MODE
+#define DEFAULT_SERVER_MODE SERVER_MODE_THREAD
+#endif
+#ifdef WATCHDOG_THREAD_STACK
+#define SERVER_THREAD_STACK WATCHDOG_THREAD_STACK
+#else
+#define SERVER_THREAD_STACK 0            // The system default
+#endif
+
 // Global variables
 static struct MHD_Daemon *http_daemon = NULL;
-static SusiId_t watchdogId = SUSI_ID_WATCHDOG_1;
-static uint32_t delayTime = DEFAULT_DELAY_TIME;
-static uint32_t eventTime = DEFAULT_EVENT_TIME;
-static uint32_t resetTime = DEFAULT_RESET_TIME;
-static uint32_t eventType = DEFAULT_EVENT_TYPE;
-static bool watchdogRunning = false;
 static bool susiInitialized = false;
+// Only /api/fleet and /metrics are served; nothing touches SUSI
+static bool gatewayMode = false;
 
 // Function prototypes
+bool parseServerMode(const char *name, ServerMode *mode);
+const char* serverModeName(ServerMode mode);
+struct MHD_Daemon* startHttpDaemon(ServerMode mode, int port, unsigned int threads,
+                                   unsigned int maxConnections, unsigned int perIpConnections,
+                                   size_t connectionMemory, unsigned int connectionTimeout);
 bool initializeSUSI(void);
 void cleanupSUSI(void);
-bool startWatchdog(SusiId_t id, uint32_t delayTime, uint32_t eventTime, uint32_t resetTime, uint32_t eventType);
-bool triggerWatchdog(SusiId_t id);
-bool stopWatchdog(SusiId_t id);
-json_t* getWatchdogInfo(SusiId_t id);
-json_t* getWatchdogStatus(void);
+bool buildIndexPages(void);
+void destroyIndexPages(void);
+void collectServiceMetrics(StrBuf *out, void *ctx);
 
-// Signal handling for graceful shutdown
-static volatile int keepRunning = 1;
+// Shutdown hook wrapper: MHD_stop_daemon waits for in-flight requests, so
+// open event streams are ended first
+static void stopHttpServer(void) {
+    eventsStop();
+    MHD_stop_daemon(http_daemon);
+    http_daemon = NULL;
+}
 
-void sigHandler(int sig) {
-    if (sig == SIGINT || sig == SIGTERM) {
-        printf("Shutdown signal received. Cleaning up...\n");
-        keepRunning = 0;
+// Config file reload hook, runs on the watcher thread. Timer defaults need
+// no action: requests read them from the published configuration.
+static void applyServiceConfig(const ServiceConfig *previous, const ServiceConfig *current) {
+    if (current->watchdogId != previous->watchdogId) {
+        watchdogApplyConfig(current);
+    }
+    if (current->logLevel != previous->logLevel || current->logSample != previous->logSample) {
+        accessLogSetLevel(current->logLevel, current->logSample);
     }
 }
 
-// HTTP request handler
-static enum MHD_Result requestHandler(void *cls, struct MHD_Connection *connection,
-                         const char *url, const char *method,
-                         const char *version, const char *upload_data,
-                         size_t *upload_data_size, void **con_cls) {
-    
+// The index page only differs in the status badge, so both variants are
+// rendered once at startup and served as persistent shared responses
+static const char indexPageTemplate[] =
+    "<!DOCTYPE html>"
+    "<html>"
+    "<head>"
+    "    <title>Watchdog HTTP Service</title>"
+    "    <style>"
+    "        body { font-family: Arial, sans-serif; margin: 40px; line-height: 1.6; }"
+    "        h1 { color: #333; }"
+    "        .status { display: inline-block; padding: 5px 10px; border-radius: 4px; }"
+    "        .running { background-color: #d4edda; color: #155724; }"
+    "        .stopped { background-color: #f8d7da; color: #721c24; }"
+    "        .endpoints { background-color: #f8f9fa; padding: 15px; border-radius: 4px; }"
+    "        pre { background-color: #f1f1f1; padding: 10px; border-radius: 4px; }"
+    "    </style>"
+    "</head>"
+    "<body>"
+    "    <h1>Watchdog HTTP Service</h1>"
+    "    <p>Status: <span class='status %s'>%s</span></p>"
+    "    <h2>Available Endpoints</h2>"
+    "    <div class='endpoints'>"
+    "        <h3>Status</h3>"
+    "        <p>GET /api/status - Current watchdog status (JSON)</p>"
+    "        <p>GET /api/info - Watchdog capabilities (JSON)</p>"
+    "        <p>GET /api/board - Board names, serial, versions and counters (cached, see --board-refresh)</p>"
+    "        <p>GET /api/self - The service's own memory, threads, queue and pool fill, connections and uptime</p>"
+    "        <p>GET /api/trace?seconds=N - Request, hardware queue, SUSI and rendering spans as Chrome trace JSON</p>"
+    "        <p>GET /api/memory - Memory modules decoded from SPD once at startup (see --memory-cache)</p>"
+    "        <p>GET /api/iot, GET|PUT /api/iot/data?id=N - SusiIoT capability and data (see --iot)</p>"
+    "        <p>GET /metrics - Prometheus metrics</p>"
+    ""
+    "        <h3>Control</h3>"
+    "        <p>POST /api/start - Start the watchdog</p>"
+    "        <p>POST /api/trigger - Feed/trigger the watchdog</p>"
+    "        <p>POST /api/stop - Stop the watchdog</p>"
+    "        <p>POST /api/configure - Configure watchdog parameters</p>"
+    ""
+    "        <h3>Multiple timers</h3>"
+    "        <p>GET /api/wdt - List watchdog timers</p>"
+    "        <p>/api/wdt/{n}/status, info, start, trigger, stop, configure - Per-timer endpoints</p>"
+    ""
+    "        <h3>Events</h3>"
+    "        <p>GET /api/events - Server-sent events for start, stop, trigger, configure and missed deadlines</p>"
+    ""
+    "        <h3>Hardware monitor</h3>"
+    "        <p>GET /api/hwm - Latest voltage, temperature, fan and current readings</p>"
+    "        <p>GET /api/hwm/history?res=10s, 1m or 15m - Min/max/avg/count per bucket</p>"
+    "        <p>GET /api/hwm/export?res=raw, 10s, 1m or 15m - Samples or rollups, compressed for hwm_decode</p>"
+    "        <p>GET /api/hwm/previous - Samples from before the last restart (with --hwm-store)</p>"
+    "        <p>GET /api/fan - Software fan loops: temperature, duty and writes (with --fan-loop)</p>"
+    "        <p>GET /api/thermal - Thermal protection zones, temperature slope and forecast time to trip</p>"
+    "        <p>GET /api/alerts - Alert rules over the sensors and their state (with --alert-rule)</p>"
+    ""
+    "        <h3>Backlight</h3>"
+    "        <p>GET /api/backlight - Panels: brightness, target and writes</p>"
+    "        <p>PUT /api/backlight?id=N&amp;brightness=B[&amp;ramp_ms=T] - Ramp a panel, returns at once</p>"
+    ""
+    "        <p>GET /api/poe - PoE ports: power, detection, class, voltage, current and the budget</p>"
+    "        <p>PUT /api/poe?port=N&amp;power=on|off - Switch a PoE port</p>"
+    "        <p>GET /api/battery - Smart Battery registers, read in static, slow and fast tiers</p>"
+    "        <h3>Board configuration</h3>"
+    "        <p>GET /api/config[?refresh=1] - Thermal protection, fan, backlight and watchdog settings as flat keys</p>"
+    "        <p>PUT /api/config - Change any of those keys in one transaction, rolled back if a write fails</p>"
+    "        <p>GET /api/wake - RTC wake from S5 and this board's offset (see --wake-window)</p>"
+    "        <p>PUT /api/wake?time=HH:MM[:SS][&amp;day=D][&amp;window=SEC] - Wake at time plus a per-board offset within window</p>"
+    ""
+    "        <h3>GPIO</h3>"
+    "        <p>GET /api/gpio - Direction and level of every bank</p>"
+    "        <p>PUT /api/gpio?bank=N&amp;mask=M&amp;direction=D&amp;level=L - Write the pins of one bank</p>"
+    ""
+    "        <h3>SMBus and I2C</h3>"
+    "        <p>GET /api/bus - Devices found on every bus (cached, see --bus-scan-ttl)</p>"
+    "        <p>POST /api/bus/scan - Rescan now</p>"
+    "        <p>POST /api/i2c?bus=N&amp;ops=ADDR:WRITE_HEX:READ_LENGTH,... - Run I2C transfers as one batch</p>"
+    "        <p>POST /api/batch?ops=value:ID,gpio:PIN,board,wdt:N:ACTION,... - Many reads and watchdog actions in one request</p>"
+    "        <p>GET /api/i2c/register?bus=N&amp;addr=A&amp;reg=R&amp;length=L - Register read, served from the cache when possible</p>"
+    "        <p>PUT /api/i2c/register?bus=N&amp;addr=A&amp;reg=R&amp;data=HEX - Register write-through</p>"
+    "        <p>POST /api/i2c/invalidate?bus=N&amp;addr=A - Drop cached registers</p>"
+    "        <p>GET /api/smbus?bus=N&amp;addr=A&amp;offset=O&amp;length=L - Bulk read in the largest transfers the device takes</p>"
+    "        <p>PUT /api/smbus?bus=N&amp;addr=A&amp;offset=O&amp;data=HEX[&amp;page=P] - Bulk write</p>"
+    ""
+    "        <h3>Storage</h3>"
+    "        <p>GET /api/storage - Storage areas and their block sizes</p>"
+    "        <p>GET /api/storage/ID?offset=O&amp;length=L - Stream a region as raw bytes</p>"
+    "        <p>GET /api/kv, GET /api/kv/KEY - Persistent keys, served from memory</p>"
+    "        <p>PUT /api/kv/KEY?value=TEXT, DELETE /api/kv/KEY - Update a key with one small write</p>"
+    "        <p>GET /api/storage/ID?offset=O&amp;length=L&amp;crc=1 - CRC32C of a region</p>"
+    "        <p>PUT /api/storage/ID?offset=O[&amp;diff=1][&amp;verify=1] - Write the raw request body from O (diff=1: changed blocks only, verify=1: read back and check)</p>"
+    ""
+    "        <h3>Diagnostics</h3>"
+    "        <p>GET /api/diag - PCI functions found at startup (see --pci-diag)</p>"
+    "        <p>GET /api/diag/pci[?device=BB:DD.F][&amp;extended=1] - Stream config space, one function per line</p>"
+    "        <p>GET /api/diag/msr[?index=I,...] - Stream MSRs, one per line</p>"
+    "    </div>"
+    ""
+    "    <h2>Example Usage</h2>"
+    "    <pre>curl http://localhost:9101/api/status</pre>"
+    "    <pre>curl -X POST http://localhost:9101/api/start</pre>"
+    "    <pre>curl -X POST \"http://localhost:9101/api/configure?delay=15000&event=5000&reset=1000&type=0\"</pre>"
+    "</body>"
+    "</html>";
+
+typedef struct {
+    char html[8192];
+    const char *etag;
     struct MHD_Response *response;
-    int ret;
-    json_t *json_response = NULL;
-    char *json_str = NULL;
-    
-    // For parsing form data
-    static int dummy;
-    const char *param_value;
+    struct MHD_Response *notModified;
+} IndexPage;
+
+static IndexPage indexPages[2];  // [0] = stopped, [1] = running
+
+bool buildIndexPages(void) {
+    for (int running = 0; running < 2; running++) {
+        IndexPage *page = &indexPages[running];
+        int length = snprintf(page->html, sizeof(page->html), indexPageTemplate,
+                              running ? "running" : "stopped",
+                              running ? "Running" : "Stopped");
+        if (length < 0 || (size_t)length >= sizeof(page->html)) {
+            return false;
+        }
+        page->etag = running ? "\"index-running\"" : "\"index-stopped\"";
+        
+        page->response = MHD_create_response_from_buffer((size_t)length, page->html,
+                                                         MHD_RESPMEM_PERSISTENT);
+        page->notModified = MHD_create_response_from_buffer(0, NULL, MHD_RESPMEM_PERSISTENT);
+        if (page->response == NULL || page->notModified == NULL) {
+            return false;
+        }
+        MHD_add_response_header(page->response, "Content-Type", "text/html");
+        MHD_add_response_header(page->response, "ETag", page->etag);
+        MHD_add_response_header(page->response, "Cache-Control", "no-cache");
+        MHD_add_response_header(page->notModified, "ETag", page->etag);
+    }
+    return true;
+}
+
+void destroyIndexPages(void) {
+    for (int i = 0; i < 2; i++) {
+        if (indexPages[i].response) {
+            MHD_destroy_response(indexPages[i].response);
+            indexPages[i].response = NULL;
+        }
+        if (indexPages[i].notModified) {
+            MHD_destroy_response(indexPages[i].notModified);
+            indexPages[i].notModified = NULL;
+        }
+    }
+}
+
+static enum MHD_Result queueIndexPage(struct MHD_Connection *connection, bool running) {
+    IndexPage *page = &indexPages[running ? 1 : 0];
     
-    // Prevent unused parameter warnings
-    (void)cls;
-    (void)version;
-    (void)upload_data;
+    if (page->response == NULL) {
+        return MHD_NO;
+    }
+    if (httpEtagMatches(connection, page->etag)) {
+        return MHD_queue_response(connection, MHD_HTTP_NOT_MODIFIED, page->notModified);
+    }
+    return MHD_queue_response(connection, MHD_HTTP_OK, page->response);
+}
+
+// Apply the query and body timings parsed for a start/configure request
+static const char* applyConfigBody(const ConfigBody *config, WatchdogCommand *cmd) {
+    if (config == NULL) {
+        return NULL;
+    }
+    if (config->error != NULL) {
+        return config->error;
+    }
+    configApply(config, cmd);
+    return NULL;
+}
+
+// Queue a {"<key>": "<message>"} body, used for status and error replies
+static enum MHD_Result queueMessage(struct MHD_Connection *connection, const char *key, const char *message) {
+    ResponseBuffer body;
+    JsonWriter writer;
     
-    // Return a dummy value on first call (MHD requires this pattern)
-    if (*con_cls == NULL) {
-        *con_cls = &dummy;
-        return MHD_YES;
+    if (!responseBufferAcquire(&body)) {
+        return MHD_NO;
     }
+    responseWriterInit(&writer, &body, connection);
+    jsonBeginObject(&writer);
+    jsonFieldString(&writer, key, message);
+    jsonEndObject(&writer);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+static enum MHD_Result queueError(struct MHD_Connection *connection, const char *message) {
+    return queueMessage(connection, "error", message);
+}
+
+// Reply to a start/configure with the timings that were applied
+static enum MHD_Result queueTimings(struct MHD_Connection *connection, const char *status,
+                                    const WatchdogCommand *cmd) {
+    ResponseBuffer body;
+    JsonWriter writer;
     
-    // We don't accept upload data right now
-    if (*upload_data_size != 0) {
-        *upload_data_size = 0;
-        return MHD_YES;
+    if (!responseBufferAcquire(&body)) {
+        return MHD_NO;
     }
+    responseWriterInit(&writer, &body, connection);
+    jsonBeginObject(&writer);
+    jsonFieldString(&writer, "status", status);
+    jsonFieldUint(&writer, "watchdog_id", cmd->device->id);
+    jsonFieldUint(&writer, "delay", cmd->delayTime);
+    jsonFieldUint(&writer, "event", cmd->eventTime);
+    jsonFieldUint(&writer, "reset", cmd->resetTime);
+    jsonFieldUint(&writer, "type", cmd->eventType);
+    jsonEndObject(&writer);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+// Handle one per-device endpoint, shared by /api/<action> (default device)
+// and /api/wdt/<n>/<action>
+static enum MHD_Result handleWatchdogAction(struct MHD_Connection *connection, const char *method,
+                                            WatchdogDevice *device, const char *action,
+                                            const ConfigBody *config) {
+    ResponseBuffer body;
+    JsonWriter writer;
+    WatchdogCommand cmd;
+    const char *param_value;
     
-    // Route requests based on URL and method
-    printf("Received request: %s %s\n", method, url);
+    watchdogCommandInit(&cmd, device);
     
-    // API endpoints
     if (strcmp(method, "GET") == 0) {
-        // GET /api/status - Get current watchdog status
-        if (strcmp(url, "/api/status") == 0) {
-            json_response = getWatchdogStatus();
-        }
-        // GET /api/info - Get watchdog capabilities
-        else if (strcmp(url, "/api/info") == 0) {
-            json_response = getWatchdogInfo(watchdogId);
-        }
-        // GET / - Root endpoint (simple status page)
-        else if (strcmp(url, "/") == 0 || strcmp(url, "/index.html") == 0) {
-            // Return a simple HTML status page
-            char html_buffer[2048]; // Use fixed buffer with known size instead of const char* to avoid strcat issues
-            
-            // Build the HTML in parts to avoid buffer overflow
-            snprintf(html_buffer, sizeof(html_buffer),
-                "<!DOCTYPE html>"
-                "<html>"
-                "<head>"
-                "    <title>Watchdog HTTP Service</title>"
-                "    <style>"
-                "        body { font-family: Arial, sans-serif; margin: 40px; line-height: 1.6; }"
-                "        h1 { color: #333; }"
-                "        .status { display: inline-block; padding: 5px 10px; border-radius: 4px; }"
-                "        .running { background-color: #d4edda; color: #155724; }"
-                "        .stopped { background-color: #f8d7da; color: #721c24; }"
-                "        .endpoints { background-color: #f8f9fa; padding: 15px; border-radius: 4px; }"
-                "        pre { background-color: #f1f1f1; padding: 10px; border-radius: 4px; }"
-                "    </style>"
-                "</head>"
-                "<body>"
-                "    <h1>Watchdog HTTP Service</h1>"
-                "    <p>Status: <span class='status %s'>%s</span></p>"
-                "    <h2>Available Endpoints</h2>"
-                "    <div class='endpoints'>"
-                "        <h3>Status</h3>"
-                "        <p>GET /api/status - Current watchdog status (JSON)</p>"
-                "        <p>GET /api/info - Watchdog capabilities (JSON)</p>"
-                ""
-                "        <h3>Control</h3>"
-                "        <p>POST /api/start - Start the watchdog</p>"
-                "        <p>POST /api/trigger - Feed/trigger the watchdog</p>"
-                "        <p>POST /api/stop - Stop the watchdog</p>"
-                "        <p>POST /api/configure - Configure watchdog parameters</p>"
-                "    </div>"
-                ""
-                "    <h2>Example Usage</h2>"
-                "    <pre>curl http://localhost:9101/api/status</pre>"
-                "    <pre>curl -X POST http://localhost:9101/api/start</pre>"
-                "    <pre>curl -X POST \"http://localhost:9101/api/configure?delay=15000&event=5000&reset=1000&type=0\"</pre>"
-                "</body>"
-                "</html>",
-                watchdogRunning ? "running" : "stopped",
-                watchdogRunning ? "Running" : "Stopped"
-            );
-            
-            // Create response from the HTML buffer
-            response = MHD_create_response_from_buffer(strlen(html_buffer),
-                                                     (void *)html_buffer,
-                                                     MHD_RESPMEM_MUST_COPY);
-            if (response == NULL) {
+        // GET status - Get current watchdog status
+        if (strcmp(action, "status") == 0) {
+            if (!responseBufferAcquire(&body)) {
                 return MHD_NO;
             }
-            
-            MHD_add_response_header(response, "Content-Type", "text/html");
-            ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
-            MHD_destroy_response(response);
-            return ret;
+            responseWriterInit(&writer, &body, connection);
+            jsonBeginObject(&writer);
+            watchdogWriteStatus(&writer, device);
+            jsonFieldBool(&writer, "susi_initialized", susiInitialized);
+            jsonEndObject(&writer);
+            return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
         }
-        else {
-            // Unknown GET endpoint
-            json_response = json_pack("{ss}", "error", "Unknown endpoint");
-            ret = MHD_HTTP_NOT_FOUND;
+        // GET info - Get watchdog capabilities (cached; ?refresh=1 re-reads the hardware)
+        if (strcmp(action, "info") == 0) {
+            param_value = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "refresh");
+            if (param_value && strcmp(param_value, "1") == 0 && !watchdogRefreshCaps(device)) {
+                return queueError(connection, "Failed to refresh watchdog capabilities");
+            }
+            // The cached snapshot is JSON; CBOR clients get a fresh render
+            if (!responseWantsCbor(connection) && snapshotQueue(&device->infoSnapshot, connection) == MHD_YES) {
+                return MHD_YES;
+            }
+            if (!responseBufferAcquire(&body)) {
+                return MHD_NO;
+            }
+            responseWriterInit(&writer, &body, connection);
+            watchdogWriteInfo(&writer, device->id, watchdogGetCaps(device));
+            return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
         }
+        return queueError(connection, "Unknown endpoint");
     }
-    else if (strcmp(method, "POST") == 0) {
-        // POST /api/start - Start the watchdog
-        if (strcmp(url, "/api/start") == 0) {
-            if (watchdogRunning) {
-                json_response = json_pack("{ss}", "error", "Watchdog is already running");
-            } else {
-                // Check for custom parameters
-                param_value = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "delay");
-                if (param_value) delayTime = atoi(param_value);
-                
-                param_value = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "event");
-                if (param_value) eventTime = atoi(param_value);
-                
-                param_value = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "reset");
-                if (param_value) resetTime = atoi(param_value);
-                
-                param_value = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "type");
-                if (param_value) eventType = atoi(param_value);
-                
-                if (startWatchdog(watchdogId, delayTime, eventTime, resetTime, eventType)) {
-                    watchdogRunning = true;
-                    json_response = json_pack("{sssisisisi}",
-                                            "status", "Watchdog started",
-                                            "delay", delayTime,
-                                            "event", eventTime,
-                                            "reset", resetTime,
-                                            "type", eventType);
-                } else {
-                    json_response = json_pack("{ss}", "error", "Failed to start watchdog");
-                }
-            }
-        }
-        // POST /api/trigger - Feed/trigger the watchdog
-        else if (strcmp(url, "/api/trigger") == 0) {
-            if (!watchdogRunning) {
-                json_response = json_pack("{ss}", "error", "Watchdog is not running");
-            } else {
-                if (triggerWatchdog(watchdogId)) {
-                    json_response = json_pack("{ss}", "status", "Watchdog triggered (reset timer)");
-                } else {
-                    json_response = json_pack("{ss}", "error", "Failed to trigger watchdog");
-                }
+    
+    if (strcmp(method, "POST") == 0) {
+        // POST start - Start the watchdog
+        if (strcmp(action, "start") == 0) {
+            if ((cmd.error = applyConfigBody(config, &cmd)) != NULL) {
+                return queueError(connection, cmd.error);
+            }
+            if (watchdogExecute(HW_LANE_CONFIG, hwWatchdogStart, &cmd)) {
+                return queueTimings(connection, "Watchdog started", &cmd);
             }
         }
-        // POST /api/stop - Stop the watchdog
-        else if (strcmp(url, "/api/stop") == 0) {
-            if (!watchdogRunning) {
-                json_response = json_pack("{ss}", "error", "Watchdog is not running");
-            } else {
-                if (stopWatchdog(watchdogId)) {
-                    watchdogRunning = false;
-                    json_response = json_pack("{ss}", "status", "Watchdog stopped");
-                } else {
-                    json_response = json_pack("{ss}", "error", "Failed to stop watchdog");
-                }
+        // POST trigger - Feed/trigger the watchdog
+        else if (strcmp(action, "trigger") == 0) {
+            if (watchdogExecute(HW_LANE_FEED, hwWatchdogTrigger, &cmd)) {
+                return queueMessage(connection, "status", "Watchdog triggered (reset timer)");
             }
         }
-        // POST /api/configure - Configure watchdog parameters (when stopped)
-        else if (strcmp(url, "/api/configure") == 0) {
-            if (watchdogRunning) {
-                json_response = json_pack("{ss}", "error", "Cannot configure watchdog while running. Stop it first.");
-            } else {
-                // Get parameters from URL query
-                param_value = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "delay");
-                if (param_value) delayTime = atoi(param_value);
-                
-                param_value = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "event");
-                if (param_value) eventTime = atoi(param_value);
-                
-                param_value = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "reset");
-                if (param_value) resetTime = atoi(param_value);
-                
-                param_value = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "type");
-                if (param_value) eventType = atoi(param_value);
-                
-                json_response = json_pack("{sssisisisi}",
-                                        "status", "Watchdog configured",
-                                        "delay", delayTime,
-                                        "event", eventTime,
-                                        "reset", resetTime,
-                                        "type", eventType);
-            }
-        }
-        else {
-            // Unknown POST endpoint
-            json_response = json_pack("{ss}", "error", "Unknown endpoint");
-            ret = MHD_HTTP_NOT_FOUND;
-        }
-    }
-    else {
-        // Method not allowed
-        json_response = json_pack("{ss}", "error", "Method not allowed");
-        ret = MHD_HTTP_METHOD_NOT_ALLOWED;
-    }
-    
-    // If we have a JSON response, send it
-    if (json_response) {
-        json_str = json_dumps(json_response, JSON_COMPACT);
-        if (json_str) {
-            response = MHD_create_response_from_buffer(strlen(json_str),
-                                                     (void*)json_str,
-                                                     MHD_RESPMEM_MUST_FREE);
-            MHD_add_response_header(response, "Content-Type", "application/json");
-            ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
-            MHD_destroy_response(response);
-            json_decref(json_response);
-            return ret;
+        // POST stop - Stop the watchdog
+        else if (strcmp(action, "stop") == 0) {
+            if (watchdogExecute(HW_LANE_CONFIG, hwWatchdogStop, &cmd)) {
+                return queueMessage(connection, "status", "Watchdog stopped");
+            }
+        }
+        // POST configure - Configure watchdog parameters (when stopped)
+        else if (strcmp(action, "configure") == 0) {
+            if ((cmd.error = applyConfigBody(config, &cmd)) != NULL) {
+                return queueError(connection, cmd.error);
+            }
+            if (watchdogExecute(HW_LANE_CONFIG, hwWatchdogConfigure, &cmd)) {
+                return queueTimings(connection, "Watchdog configured", &cmd);
+            }
         }
-        json_decref(json_response);
+        return queueError(connection, cmd.error ? cmd.error : "Unknown endpoint");
     }
     
-    // If we get here, something went wrong with the JSON processing
-    const char *error_msg = "Internal server error";
-    response = MHD_create_response_from_buffer(strlen(error_msg),
-                                             (void*)error_msg,
-                                             MHD_RESPMEM_MUST_COPY);
-    ret = MHD_queue_response(connection, MHD_HTTP_INTERNAL_SERVER_ERROR, response);
-    MHD_destroy_response(response);
-    return ret;
+    return queueError(connection, "Method not allowed");
 }
 
-// Get current watchdog status as JSON
-json_t* getWatchdogStatus(void) {
-    json_t *json_status = json_object();
+// Route /api/wdt/<n>/<action>; a bare /api/wdt lists every timer
+static enum MHD_Result handleWatchdogRoute(struct MHD_Connection *connection, const char *method,
+                                           const char *path, const ConfigBody *config) {
+    ResponseBuffer body;
+    JsonWriter writer;
+    WatchdogDevice *device;
+    unsigned long id;
+    char *end;
     
-    json_object_set_new(json_status, "running", json_boolean(watchdogRunning));
-    json_object_set_new(json_status, "susi_initialized", json_boolean(susiInitialized));
-    json_object_set_new(json_status, "delay_time", json_integer(delayTime));
-    json_object_set_new(json_status, "event_time", json_integer(eventTime));
-    json_object_set_new(json_status, "reset_time", json_integer(resetTime));
-    json_object_set_new(json_status, "event_type", json_integer(eventType));
-    
-    // Calculate remaining times if running
-    if (watchdogRunning) {
-        // Note: In a real implementation, we'd track the time since last trigger
-        // For now, we just show the configured times
-        json_object_set_new(json_status, "max_total_time_ms", json_integer(delayTime + eventTime + resetTime));
+    if (*path == '\0' || strcmp(path, "/") == 0) {
+        if (strcmp(method, "GET") != 0) {
+            return queueError(connection, "Method not allowed");
+        }
+        if (!responseBufferAcquire(&body)) {
+            return MHD_NO;
+        }
+        responseWriterInit(&writer, &body, connection);
+        watchdogWriteList(&writer);
+        return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
     }
     
-    return json_status;
+    id = strtoul(path + 1, &end, 10);
+    device = (end != path + 1) ? watchdogDevice((SusiId_t)id) : NULL;
+    if (device == NULL || !device->present) {
+        return queueError(connection, "Unknown watchdog");
+    }
+    // /api/wdt/<n> alone is the status of that timer
+    if (*end == '\0') {
+        return handleWatchdogAction(connection, method, device, "status", NULL);
+    }
+    if (*end != '/') {
+        return queueError(connection, "Unknown endpoint");
+    }
+    return handleWatchdogAction(connection, method, device, end + 1, config);
 }
 
-// Get watchdog capabilities and information as JSON
-json_t* getWatchdogInfo(SusiId_t id) {
-    SusiStatus_t status;
-    uint32_t value;
-    json_t *json_info = json_object();
-    
-    json_object_set_new(json_info, "watchdog_id", json_integer(id));
+// Route /api/lease, /api/lease/<id>/renew and /api/lease/<id>/release
+static enum MHD_Result handleLeaseRoute(struct MHD_Connection *connection, const char *method,
+                                        const char *path) {
+    static const char *leaseErrors[] = {
+        [LEASE_UNKNOWN] = "Unknown lease",
+        [LEASE_FULL] = "Too many leases",
+        [LEASE_BAD_TIMEOUT] = "Lease timeout out of range",
+    };
+    ResponseBuffer body;
+    JsonWriter writer;
+    LeaseResult result;
+    const char *param_value;
+    unsigned long id;
+    char *end;
     
-    // Check if watchdog is supported
-    status = SusiWDogGetCaps(id, SUSI_ID_WDT_SUPPORT_FLAGS, &value);
-    if (status == SUSI_STATUS_SUCCESS) {
-        json_object_set_new(json_info, "supported", json_true());
-        
-        // Get time unit
-        status = SusiWDogGetCaps(id, SUSI_ID_WDT_UNIT_MINIMUM, &value);
-        if (status == SUSI_STATUS_SUCCESS) {
-            json_object_set_new(json_info, "time_unit_ms", json_integer(value));
+    if (*path == '\0' || strcmp(path, "/") == 0) {
+        // GET /api/lease - List leases
+        if (strcmp(method, "GET") == 0) {
+            if (!responseBufferAcquireSize(&body, leaseListSize())) {
+                return MHD_NO;
+            }
+            responseWriterInit(&writer, &body, connection);
+            leaseWriteList(&writer);
+            return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
         }
-        
-        // Get delay time range
-        status = SusiWDogGetCaps(id, SUSI_ID_WDT_DELAY_MINIMUM, &value);
-        if (status == SUSI_STATUS_SUCCESS) {
-            json_object_set_new(json_info, "min_delay_time_ms", json_integer(value));
+        // POST /api/lease?name=N&timeout=MS - Create a lease
+        if (strcmp(method, "POST") == 0) {
+            uint32_t timeoutMs = 0;
+            uint32_t leaseIdValue;
+            
+            // Without the feeder nothing would act on an expired lease
+            if (!feederRunning()) {
+                return queueError(connection, "Leases require --auto-feed");
+            }
+            param_value = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "timeout");
+            if (param_value) timeoutMs = (uint32_t)strtoul(param_value, NULL, 10);
+            param_value = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "name");
+            
+            result = leaseCreate(param_value, timeoutMs, &leaseIdValue);
+            if (result != LEASE_OK) {
+                return queueError(connection, leaseErrors[result]);
+            }
+            if (!responseBufferAcquire(&body)) {
+                return MHD_NO;
+            }
+            responseWriterInit(&writer, &body, connection);
+            jsonBeginObject(&writer);
+            jsonFieldString(&writer, "status", "Lease created");
+            jsonFieldUint(&writer, "id", leaseIdValue);
+            jsonFieldUint(&writer, "timeout_ms", timeoutMs);
+            jsonEndObject(&writer);
+            return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
         }
+        return queueError(connection, "Method not allowed");
+    }
+    
+    id = strtoul(path + 1, &end, 10);
+    if (end == path + 1 || *end != '/') {
+        return queueError(connection, "Unknown endpoint");
+    }
+    if (strcmp(method, "POST") != 0) {
+        return queueError(connection, "Method not allowed");
+    }
+    
+    // POST /api/lease/<id>/renew - Push the lease deadline out by its timeout
+    if (strcmp(end, "/renew") == 0) {
+        int64_t remainingMs = 0;
         
-        status = SusiWDogGetCaps(id, SUSI_ID_WDT_DELAY_MAXIMUM, &value);
-        if (status == SUSI_STATUS_SUCCESS) {
-            json_object_set_new(json_info, "max_delay_time_ms", json_integer(value));
+        result = leaseRenew((uint32_t)id, &remainingMs);
+        if (result != LEASE_OK) {
+            return queueError(connection, leaseErrors[result]);
         }
-        
-        // Get reset time range
-        status = SusiWDogGetCaps(id, SUSI_ID_WDT_RESET_MINIMUM, &value);
-        if (status == SUSI_STATUS_SUCCESS) {
-            json_object_set_new(json_info, "min_reset_time_ms", json_integer(value));
+        if (!responseBufferAcquire(&body)) {
+            return MHD_NO;
         }
-        
-        status = SusiWDogGetCaps(id, SUSI_ID_WDT_RESET_MAXIMUM, &value);
-        if (status == SUSI_STATUS_SUCCESS) {
-            json_object_set_new(json_info, "max_reset_time_ms", json_integer(value));
+        responseWriterInit(&writer, &body, connection);
+        jsonBeginObject(&writer);
+        jsonFieldString(&writer, "status", "Lease renewed");
+        jsonFieldUint(&writer, "id", id);
+        jsonFieldInt(&writer, "remaining_ms", remainingMs);
+        jsonEndObject(&writer);
+        return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+    }
+    // POST /api/lease/<id>/release - Drop the lease (clean client exit)
+    if (strcmp(end, "/release") == 0) {
+        result = leaseRelease((uint32_t)id);
+        if (result != LEASE_OK) {
+            return queueError(connection, leaseErrors[result]);
         }
-        
+        return queueMessage(connection, "status", "Lease released");
+    }
+    return queueError(connection, "Unknown endpoint");
+}
+
+static void writeGpioBank(JsonWriter *writer, const GpioBankState *state) {
+    jsonBeginObject(writer);
+    jsonFieldUint(writer, "bank", state->bank);
+    jsonFieldUint(writer, "inputs", state->inputs);
+    jsonFieldUint(writer, "outputs", state->outputs);
+    jsonFieldUint(writer, "interrupts", state->interrupts);
+    jsonFieldUint(writer, "direction", state->direction);
+    if (state->status == SUSI_STATUS_SUCCESS) {
+        jsonFieldUint(writer, "level", state->level);
     } else {
-        json_object_set_new(json_info, "supported", json_false());
-        json_object_set_new(json_info, "error", json_string("Watchdog is not supported or failed to get capabilities"));
+        jsonKey(writer, "level");
+        jsonNull(writer);
     }
+    jsonEndObject(writer);
+}
+
+// Optional on/off query argument, on only for "1"
+static bool flagArgument(struct MHD_Connection *connection, const char *name) {
+    const char *text = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, name);
     
-    return json_info;
+    return text != NULL && strcmp(text, "1") == 0;
 }
 
-// Initialize the SUSI API
-bool initializeSUSI(void) {
-    SusiStatus_t status = SusiLibInitialize();
+// Optional unsigned query argument; decimal or 0x hex
+static bool uintArgument(struct MHD_Connection *connection, const char *name, bool *present, uint32_t *value) {
+    const char *text = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, name);
+    unsigned long long parsed;
+    char *end;
     
-    if (status != SUSI_STATUS_SUCCESS) {
-        printf("SUSI API initialization failed with status: 0x%08X\n", status);
-        
-        switch (status) {
-            case SUSI_STATUS_ERROR:
-                printf("Error: General SUSI error\n");
-                break;
-            case SUSI_STATUS_NOT_FOUND:
-                printf("Error: SUSI device or resource not found\n");
-                break;
-            case SUSI_STATUS_UNSUPPORTED:
-                printf("Error: SUSI not supported on this platform\n");
-                break;
-            case SUSI_STATUS_INVALID_PARAMETER:
-                printf("Error: Invalid parameter passed to SUSI\n");
-                break;
-            case SUSI_STATUS_INVALID_BLOCK_ALIGNMENT:
-                printf("Error: Invalid block alignment\n");
-                break;
-            case SUSI_STATUS_INVALID_BLOCK_LENGTH:
-                printf("Error: Invalid block length\n");
-                break;
-            case SUSI_STATUS_INVALID_DIRECTION:
-                printf("Error: Invalid direction\n");
-                break;
-            case SUSI_STATUS_TIMEOUT:
-                printf("Error: SUSI operation timeout\n");
-                break;
-            case SUSI_STATUS_RUNNING:
-                printf("Error: SUSI already running\n");
-                break;
-            default:
-                printf("Error: Unknown SUSI error code\n");
-                break;
-        }
-        
-        printf("\nPossible solutions:\n");
-        printf("1. Run with sudo privileges: sudo LD_LIBRARY_PATH=./SUSI4.2.23739/Driver:$LD_LIBRARY_PATH ./watchdog_http_service\n");
-        printf("2. Check if SUSI drivers are installed and loaded\n");
-        printf("3. Verify hardware compatibility with SUSI API\n");
-        printf("4. Check if this is an embedded system with SUSI support\n");
-        
+    *present = text != NULL;
+    if (text == NULL) {
+        return true;
+    }
+    parsed = strtoull(text, &end, 0);
+    if (end == text || *end != '\0' || parsed > UINT32_MAX) {
         return false;
     }
-    
-    printf("SUSI API initialized successfully!\n");
-    susiInitialized = true;
+    *value = (uint32_t)parsed;
     return true;
 }
 
-// Start the watchdog
-bool startWatchdog(SusiId_t id, uint32_t delayTime, uint32_t eventTime, uint32_t resetTime, uint32_t eventType) {
-    SusiStatus_t status = SusiWDogStart(id, delayTime, eventTime, resetTime, eventType);
-    return (status == SUSI_STATUS_SUCCESS);
+// Bank-wide GPIO access; one driver call per bank per read
+static enum MHD_Result handleGpioRoute(struct MHD_Connection *connection, const char *method) {
+    GpioBankState states[GPIO_BANK_MAX];
+    ResponseBuffer body;
+    JsonWriter writer;
+    int count;
+    
+    if (gpioBankCount() == 0) {
+        return queueError(connection, "No GPIO banks reported by the EC");
+    }
+    // GET /api/gpio - Direction and level of every bank
+    if (strcmp(method, "GET") == 0) {
+        count = gpioBankRead(states);
+        if (count == 0) {
+            return queueError(connection, "Failed to read GPIO levels");
+        }
+        if (!responseBufferAcquireSize(&body, (size_t)count * 256)) {
+            return MHD_NO;
+        }
+        responseWriterInit(&writer, &body, connection);
+        jsonBeginObject(&writer);
+        jsonKey(&writer, "banks");
+        jsonBeginArray(&writer);
+        for (int i = 0; i < count; i++) {
+            writeGpioBank(&writer, &states[i]);
+        }
+        jsonEndArray(&writer);
+        jsonEndObject(&writer);
+        return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+    }
+    // PUT /api/gpio?bank=N&mask=M[&direction=D][&level=L] - Write the pins of mask
+    if (strcmp(method, "PUT") == 0) {
+        bool hasBank, hasMask, hasDirection, hasLevel;
+        uint32_t bank = 0, mask = 0, direction = 0, level = 0;
+        GpioBankResult result;
+        
+        if (!uintArgument(connection, "bank", &hasBank, &bank) || !uintArgument(connection, "mask", &hasMask, &mask) ||
+            !uintArgument(connection, "direction", &hasDirection, &direction) ||
+            !uintArgument(connection, "level", &hasLevel, &level)) {
+            return queueError(connection, "bank, mask, direction and level must be numbers");
+        }
+        if (!hasBank || !hasMask || (!hasDirection && !hasLevel)) {
+            return queueError(connection, "PUT needs bank, mask and a direction or level");
+        }
+        result = gpioBankWrite(bank, mask, hasDirection, direction, hasLevel, level, &states[0]);
+        if (result != GPIO_BANK_OK) {
+            return queueError(connection, gpioBankResultText(result));
+        }
+        if (!responseBufferAcquire(&body)) {
+            return MHD_NO;
+        }
+        responseWriterInit(&writer, &body, connection);
+        writeGpioBank(&writer, &states[0]);
+        return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+    }
+    return queueError(connection, "Method not allowed");
 }
 
-// Trigger (feed) the watchdog
-bool triggerWatchdog(SusiId_t id) {
-    SusiStatus_t status = SusiWDogTrigger(id);
-    return (status == SUSI_STATUS_SUCCESS);
-}
+typedef struct {
+    I2cOp ops[I2C_HTTP_MAX_OPS];
+    uint8_t write[I2C_HTTP_MAX_OPS][I2C_HTTP_MAX_BYTES];
+    uint8_t read[I2C_HTTP_MAX_OPS][I2C_HTTP_MAX_BYTES];
+} I2cHttpBatch;
 
-// Stop the watchdog
-bool stopWatchdog(SusiId_t id) {
-    SusiStatus_t status = SusiWDogStop(id);
-    return (status == SUSI_STATUS_SUCCESS);
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
 }
 
-// Clean up SUSI API
-void cleanupSUSI(void) {
-    SusiLibUninitialize();
-    printf("SUSI API cleaned up.\n");
+static void hexEncode(char *out, const uint8_t *data, uint32_t length) {
+    static const char hex[] = "0123456789abcdef";
+
+    for (uint32_t i = 0; i < length; i++) {
+        out[2 * i] = hex[data[i] >> 4];
+        out[2 * i + 1] = hex[data[i] & 0x0f];
+    }
+    out[2 * length] = '\0';
 }
 
-int main(int argc, char* argv[]) {
-    int port = DEFAULT_PORT;
-    
-    // Parse command line arguments
-    for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "--port") == 0 || strcmp(argv[i], "-p") == 0) {
-            if (i + 1 < argc) {
-                port = atoi(argv[i + 1]);
-                if (port <= 0 || port > 65535) {
-                    port = DEFAULT_PORT;
-                }
-                i++; // Skip the port number in the next iteration
+// ADDR:WRITE_HEX:READ_LENGTH[,...], e.g. "0x50:00:16,0x68:3b:6"; the write
+// bytes may be empty ("0x50::4")
+static int parseI2cOps(const char *spec, I2cHttpBatch *http) {
+    int count = 0;
+
+    while (*spec != '\0') {
+        I2cOp *op = &http->ops[count];
+        unsigned long value;
+        char *end;
+
+        if (count == I2C_HTTP_MAX_OPS) {
+            return -1;
+        }
+        memset(op, 0, sizeof(*op));
+        value = strtoul(spec, &end, 0);
+        if (end == spec || *end != ':' || value > 0x7f) {
+            return -1;
+        }
+        op->address = (uint8_t)value;
+        spec = end + 1;
+        while (*spec != ':') {
+            int high = hexDigit(spec[0]);
+            int low = high < 0 ? -1 : hexDigit(spec[1]);
+
+            if (low < 0 || op->writeLength == I2C_HTTP_MAX_BYTES) {
+                return -1;
             }
+            http->write[count][op->writeLength++] = (uint8_t)(high << 4 | low);
+            spec += 2;
         }
-        else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
-            printf("Watchdog HTTP Service\n");
-            printf("Usage: %s [options]\n", argv[0]);
-            printf("Options:\n");
-            printf("  --port, -p PORT    Specify the HTTP server port (default: %d)\n", DEFAULT_PORT);
-            printf("  --help, -h         Show this help message\n");
-            return 0;
+        spec++;
+        value = strtoul(spec, &end, 10);
+        if (end == spec || value > I2C_HTTP_MAX_BYTES || (value == 0 && op->writeLength == 0) ||
+            (*end != ',' && *end != '\0')) {
+            return -1;
         }
+        op->readLength = (uint32_t)value;
+        op->write = op->writeLength ? http->write[count] : NULL;
+        op->read = op->readLength ? http->read[count] : NULL;
+        count++;
+        spec = *end == ',' ? end + 1 : end;
     }
+    return count;
+}
+
+// POST /api/i2c?bus=N&ops=SPEC - Run a vector of write/read operations as one batch
+static enum MHD_Result handleI2cRoute(struct MHD_Connection *connection, const char *method) {
+    I2cHttpBatch http;
+    I2cBatch batch;
+    ResponseBuffer body;
+    JsonWriter writer;
+    const char *busText = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "bus");
+    const char *opsText = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "ops");
+    const char *stopText = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "stop_on_error");
+    char *end;
     
-    // Set up signal handling for graceful shutdown
-    signal(SIGINT, sigHandler);
-    signal(SIGTERM, sigHandler);
-    
-    printf("Starting Watchdog HTTP Service...\n");
-    
-    // Initialize SUSI API
-    susiInitialized = initializeSUSI();
-    if (!susiInitialized) {
-        printf("Failed to initialize SUSI API. Exiting.\n");
-        return -1;
+    if (strcmp(method, "POST") != 0) {
+        return queueError(connection, "Method not allowed");
     }
-    
-    // Start HTTP server
-    http_daemon = MHD_start_daemon(MHD_USE_THREAD_PER_CONNECTION,
-                                   port,
-                                   NULL, NULL,
-                                   &requestHandler, NULL,
-                                   MHD_OPTION_END);
-    
-    if (http_daemon == NULL) {
-        printf("Failed to start HTTP server on port %d\n", port);
-        cleanupSUSI();
-        return -1;
+    memset(&batch, 0, sizeof(batch));
+    batch.bus = busText ? (SusiId_t)strtoul(busText, &end, 10) : I2C_TXN_MAX_BUSES;
+    if (busText == NULL || end == busText || *end != '\0' || batch.bus >= I2C_TXN_MAX_BUSES) {
+        return queueError(connection, "Unknown I2C bus");
     }
-    
-    printf("Watchdog HTTP Service running on port %d\n", port);
-    printf("API endpoints available at:\n");
-    printf("  GET  /api/status    - Get current watchdog status\n");
-    printf("  GET  /api/info      - Get watchdog capabilities\n");
-    printf("  POST /api/start     - Start the watchdog\n");
-    printf("  POST /api/trigger   - Feed/trigger the watchdog\n");
-    printf("  POST /api/stop      - Stop the watchdog\n");
-    printf("  POST /api/configure - Configure watchdog parameters\n");
-    printf("Press Ctrl+C to stop the server\n");
-    
-    // Main loop
-    while (keepRunning) {
-        sleep(1);
+    batch.count = opsText ? parseI2cOps(opsText, &http) : -1;
+    if (batch.count <= 0) {
+        return queueError(connection, "Invalid ops (expected ADDR:WRITE_HEX:READ_LENGTH,... with at most 16 "
+                                      "operations of 32 bytes)");
+    }
+    batch.ops = http.ops;
+    batch.stopOnError = stopText != NULL && strcmp(stopText, "1") == 0;
+    if (!i2cTransact(&batch)) {
+        return queueError(connection, "I2C batch could not be queued");
     }
     
-    // Clean up
-    printf("Stopping HTTP server...\n");
-    MHD_stop_daemon(http_daemon);
-    
-    // Stop watchdog if running
-    if (watchdogRunning) {
-        printf("Stopping watchdog...\n");
-        stopWatchdog(watchdogId);
+    if (!responseBufferAcquireSize(&body, 512 + (size_t)batch.count * (64 + 2 * I2C_HTTP_MAX_BYTES))) {
+        return MHD_NO;
     }
+    responseWriterInit(&writer, &body, connection);
+    jsonBeginObject(&writer);
+    jsonFieldUint(&writer, "bus", batch.bus);
+    jsonFieldUint(&writer, "completed", (uint64_t)batch.completed);
+    jsonFieldUint(&writer, "failed", (uint64_t)batch.failed);
+    jsonFieldUint(&writer, "duration_us", batch.durationNs / 1000);
+    jsonKey(&writer, "ops");
+    jsonBeginArray(&writer);
+    for (int i = 0; i < batch.completed; i++) {
+        const I2cOp *op = &http.ops[i];
+        
+        jsonBeginObject(&writer);
+        jsonFieldUint(&writer, "address", op->address);
+        jsonFieldUint(&writer, "status", op->status);
+        if (op->status == SUSI_STATUS_SUCCESS && op->readLength > 0) {
+            char data[2 * I2C_HTTP_MAX_BYTES + 1];
+            
+            hexEncode(data, op->read, op->readLength);
+            jsonFieldString(&writer, "read", data);
+        }
+        jsonEndObject(&writer);
+    }
+    jsonEndArray(&writer);
+    jsonEndObject(&writer);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+// GET /api/wake - The programmed RTC wake time
+// PUT /api/wake?time=HH:MM[:SS][&day=D][&window=SEC] - Wake at time plus this
+//                                                board's offset within window
+static enum MHD_Result handleWakeRoute(struct MHD_Connection *connection, const char *method) {
+    const char *timeText = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "time");
+    RtcWakeSchedule schedule;
+    RtcWakeTime current;
+    SusiStatus_t status;
+    uint32_t day = 0;
+    bool hasDay, hasWindow;
+    ResponseBuffer body;
+    JsonWriter writer;
+    const char *error;
+    
+    if (strcmp(method, "GET") == 0) {
+        status = rtcWakeRead(&current);
+        if (status == SUSI_STATUS_UNSUPPORTED) {
+            return queueError(connection, "RTC wake not available");
+        }
+        if (!responseBufferAcquire(&body)) {
+            return MHD_NO;
+        }
+        responseWriterInit(&writer, &body, connection);
+        rtcWakeWrite(&writer, status, &current);
+        return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+    }
+    if (strcmp(method, "PUT") != 0) {
+        return queueError(connection, "Method not allowed");
+    }
+    memset(&schedule, 0, sizeof(schedule));
+    schedule.windowSeconds = rtcWakeDefaultWindow();
+    if (timeText == NULL || !rtcWakeParseTime(timeText, &schedule.requested)) {
+        return queueError(connection, "Invalid time (expected HH:MM or HH:MM:SS)");
+    }
+    if (!uintArgument(connection, "day", &hasDay, &day) || day > 31) {
+        return queueError(connection, "Invalid day (expected 0-31, 0 = every day)");
+    }
+    if (!uintArgument(connection, "window", &hasWindow, &schedule.windowSeconds)) {
+        return queueError(connection, "Invalid window (expected seconds)");
+    }
+    schedule.requested.day = (uint8_t)day;
+    if ((error = rtcWakeSchedule(&schedule)) != NULL) {
+        return queueError(connection, error);
+    }
+    if (!responseBufferAcquire(&body)) {
+        return MHD_NO;
+    }
+    responseWriterInit(&writer, &body, connection);
+    rtcWakeWriteSchedule(&writer, &schedule);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+// POST /api/batch?ops=SPEC - Values, GPIO pins, board info and watchdog actions in one request
+static enum MHD_Result handleBatchRoute(struct MHD_Connection *connection, const char *method) {
+    Batch batch;
+    ResponseBuffer body;
+    JsonWriter writer;
+    const char *opsText = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "ops");
+    const char *error;
+    
+    if (strcmp(method, "POST") != 0) {
+        return queueError(connection, "Method not allowed");
+    }
+    if (opsText == NULL) {
+        return queueError(connection, "Missing ops (value:ID, gpio:PIN, board, wdt:N:ACTION, ...)");
+    }
+    if ((error = batchParse(opsText, &batch)) != NULL) {
+        return queueError(connection, error);
+    }
+    if (!batchRun(&batch)) {
+        return queueError(connection, watchdogQueueFull);
+    }
+    if (!responseBufferAcquireSize(&body, batchResponseSize(&batch))) {
+        return MHD_NO;
+    }
+    responseWriterInit(&writer, &body, connection);
+    batchWrite(&writer, &batch);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+// GET  /api/i2c/register?bus=N&addr=A&reg=R[&length=L] - Read through the register cache
+// PUT  /api/i2c/register?bus=N&addr=A&reg=R&data=HEX - Write-through
+// POST /api/i2c/invalidate?bus=N&addr=A[&reg=R&length=L] - Drop cached registers
+static enum MHD_Result handleI2cRegisterRoute(struct MHD_Connection *connection, const char *method,
+                                              bool invalidate) {
+    const char *dataText = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "data");
+    uint8_t data[I2C_CACHE_REGISTERS];
+    char hexData[2 * I2C_CACHE_REGISTERS + 1];
+    uint32_t bus = 0, address = 0, reg = 0, length = 1;
+    bool hasBus, hasAddress, hasRegister, hasLength;
+    bool write = strcmp(method, "PUT") == 0;
+    bool hit = false;
+    SusiStatus_t status;
+    ResponseBuffer body;
+    JsonWriter writer;
+
+    if (invalidate ? strcmp(method, "POST") != 0 : !write && strcmp(method, "GET") != 0) {
+        return queueError(connection, "Method not allowed");
+    }
+    if (!uintArgument(connection, "bus", &hasBus, &bus) || !uintArgument(connection, "addr", &hasAddress, &address) ||
+        !uintArgument(connection, "reg", &hasRegister, &reg) ||
+        !uintArgument(connection, "length", &hasLength, &length) || !hasBus || !hasAddress ||
+        (!hasRegister && !invalidate) || bus >= SUSI_I2C_MAX_DEVICE || address > 0x7f ||
+        reg >= I2C_CACHE_REGISTERS) {
+        return queueError(connection, "Expected bus, addr (7-bit) and reg below 256");
+    }
+    if (invalidate) {
+        if (!i2cCacheInvalidate((SusiId_t)bus, (uint8_t)address, (uint8_t)reg, hasLength ? length : 0)) {
+            return queueError(connection, "Device has no register cache (see --i2c-cache)");
+        }
+        return queueMessage(connection, "status", "Invalidated");
+    }
+    if (write) {
+        for (length = 0; dataText != NULL && dataText[2 * length] != '\0'; length++) {
+            int high = hexDigit(dataText[2 * length]);
+            int low = high < 0 ? -1 : hexDigit(dataText[2 * length + 1]);
+
+            if (low < 0 || length == I2C_CACHE_REGISTERS) {
+                return queueError(connection, "Invalid data (expected hex bytes)");
+            }
+            data[length] = (uint8_t)(high << 4 | low);
+        }
+    }
+    if (length == 0 || reg + length > I2C_CACHE_REGISTERS) {
+        return queueError(connection, "Transfer must be 1 byte or more and end within 256 registers");
+    }
+
+    if (write) {
+        status = i2cCacheWrite((SusiId_t)bus, (uint8_t)address, (uint8_t)reg, data, length);
+    } else {
+        status = i2cCacheRead((SusiId_t)bus, (uint8_t)address, (uint8_t)reg, data, length, &hit);
+    }
+    if (!responseBufferAcquireSize(&body, 256 + sizeof(hexData))) {
+        return MHD_NO;
+    }
+    responseWriterInit(&writer, &body, connection);
+    jsonBeginObject(&writer);
+    jsonFieldUint(&writer, "bus", bus);
+    jsonFieldUint(&writer, "address", address);
+    jsonFieldUint(&writer, "register", reg);
+    jsonFieldUint(&writer, "status", status);
+    if (!write) {
+        jsonFieldBool(&writer, "cached", hit);
+        if (status == SUSI_STATUS_SUCCESS) {
+            hexEncode(hexData, data, length);
+            jsonFieldString(&writer, "data", hexData);
+        }
+    }
+    jsonEndObject(&writer);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+// GET  /api/smbus?bus=N&addr=A&offset=O&length=L - Bulk read of an EEPROM-like device
+// PUT  /api/smbus?bus=N&addr=A&offset=O&data=HEX[&page=P] - Bulk write, P-byte pages
+static enum MHD_Result handleSmbusRoute(struct MHD_Connection *connection, const char *method) {
+    const char *dataText = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "data");
+    uint8_t data[SMB_BULK_SPACE];
+    char hexData[2 * SMB_BULK_SPACE + 1];
+    uint32_t bus = 0, address = 0, offset = 0, length = 0, pageSize = 0;
+    bool hasBus, hasAddress, hasOffset, hasLength, hasPage;
+    bool write = strcmp(method, "PUT") == 0;
+    SmbBulkResult result;
+    ResponseBuffer body;
+    JsonWriter writer;
+
+    if (!write && strcmp(method, "GET") != 0) {
+        return queueError(connection, "Method not allowed");
+    }
+    if (!uintArgument(connection, "bus", &hasBus, &bus) || !uintArgument(connection, "addr", &hasAddress, &address) ||
+        !uintArgument(connection, "offset", &hasOffset, &offset) ||
+        !uintArgument(connection, "length", &hasLength, &length) ||
+        !uintArgument(connection, "page", &hasPage, &pageSize) || !hasBus || !hasAddress ||
+        bus >= SUSI_SMBUS_MAX_DEVICE || address > 0x7f || offset >= SMB_BULK_SPACE) {
+        return queueError(connection, "Expected bus, addr (7-bit) and offset below 256");
+    }
+    if (write) {
+        for (length = 0; dataText != NULL && dataText[2 * length] != '\0'; length++) {
+            int high = hexDigit(dataText[2 * length]);
+            int low = high < 0 ? -1 : hexDigit(dataText[2 * length + 1]);
+
+            if (low < 0 || length == SMB_BULK_SPACE) {
+                return queueError(connection, "Invalid data (expected hex bytes)");
+            }
+            data[length] = (uint8_t)(high << 4 | low);
+        }
+    } else if (!hasLength) {
+        length = SMB_BULK_SPACE - offset;
+    }
+    if (length == 0 || offset + length > SMB_BULK_SPACE) {
+        return queueError(connection, "Transfer must be 1 byte or more and end within 256 bytes");
+    }
+
+    if (write) {
+        smbBulkWrite((SusiId_t)bus, (uint8_t)address, offset, data, length, pageSize, &result);
+    } else {
+        smbBulkRead((SusiId_t)bus, (uint8_t)address, offset, data, length, &result);
+    }
+    if (!responseBufferAcquireSize(&body, 512 + sizeof(hexData))) {
+        return MHD_NO;
+    }
+    responseWriterInit(&writer, &body, connection);
+    jsonBeginObject(&writer);
+    jsonFieldUint(&writer, "bus", bus);
+    jsonFieldUint(&writer, "address", address);
+    jsonFieldUint(&writer, "offset", offset);
+    jsonFieldUint(&writer, "status", result.status);
+    jsonFieldUint(&writer, "bytes", result.bytes);
+    jsonFieldUint(&writer, "transactions", result.transactions);
+    jsonFieldString(&writer, "mode", result.transactions ? smbModeName(result.mode) : "none");
+    jsonFieldUint(&writer, "duration_us", result.durationNs / 1000);
+    jsonFieldDouble(&writer, "bytes_per_second", result.bytesPerSecond, 1);
+    if (!write) {
+        hexEncode(hexData, data, result.bytes);
+        jsonFieldString(&writer, "data", hexData);
+    }
+    jsonEndObject(&writer);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+// A PUT /api/storage/<id> body, written to the area as it streams in
+typedef struct {
+    StorageStream stream;
+    const char *error;               // Problem with the request itself, NULL if none
+} StorageUpload;
+
+// Area id from the rest of /api/storage/<id>; false if it is not a number
+static bool storageAreaId(const char *rest, SusiId_t *id) {
+    unsigned long parsed;
+    char *end;
+
+    if (rest[0] != '/' || rest[1] == '\0') {
+        return false;
+    }
+    parsed = strtoul(rest + 1, &end, 10);
+    if (*end != '\0' || parsed >= STORAGE_AREA_MAX) {
+        return false;
+    }
+    *id = (SusiId_t)parsed;
+    return true;
+}
+
+static void storageUploadOpen(StorageUpload *upload, struct MHD_Connection *connection, const char *url) {
+    StorageMode mode = flagArgument(connection, "diff") ? STORAGE_WRITE_CHANGED : STORAGE_WRITE;
+    uint32_t offset = 0, length = 0;
+    bool hasOffset, hasLength;
+    SusiId_t id;
+
+    upload->error = NULL;
+    memset(&upload->stream, 0, sizeof(upload->stream));
+    if (!storageAreaId(url + 12, &id) || storageAreaFind(id) == NULL) {
+        upload->error = "Unknown storage area";
+    } else if (!uintArgument(connection, "offset", &hasOffset, &offset) ||
+               !uintArgument(connection, "length", &hasLength, &length) ||
+               !storageStreamOpen(&upload->stream, id, offset, length, mode, flagArgument(connection, "verify"))) {
+        upload->error = "Range outside the storage area";
+    }
+}
+
+// Streams of the downloads in flight, released by MHD with the response
+MEM_POOL_DEFINE(storageStreamPool, "storage_stream", sizeof(StorageStream), STORAGE_STREAM_POOL);
+
+static ssize_t storageReader(void *cls, uint64_t pos, char *buf, size_t max) {
+    StorageStream *stream = cls;
+    uint32_t length;
+    (void)pos;
+
+    if (stream->offset >= stream->end) {
+        return MHD_CONTENT_READER_END_OF_STREAM;
+    }
+    length = storageStreamRead(stream, (uint8_t *)buf, max < UINT32_MAX ? (uint32_t)max : UINT32_MAX);
+    // Headers are already out; a failed chunk can only cut the stream short
+    return length > 0 ? (ssize_t)length : MHD_CONTENT_READER_END_WITH_ERROR;
+}
+
+static void storageReaderFree(void *cls) {
+    storageStreamClose(cls);
+    memPoolFree(&storageStreamPool, cls);
+}
+
+static enum MHD_Result queueStorageAreas(struct MHD_Connection *connection) {
+    ResponseBuffer body;
+    JsonWriter writer;
+
+    if (!responseBufferAcquireSize(&body, 256 + (size_t)storageAreaCount() * 96)) {
+        return MHD_NO;
+    }
+    responseWriterInit(&writer, &body, connection);
+    jsonBeginObject(&writer);
+    jsonKey(&writer, "areas");
+    jsonBeginArray(&writer);
+    for (int i = 0; i < storageAreaCount(); i++) {
+        const StorageAreaInfo *area = storageAreaAt(i);
+
+        jsonBeginObject(&writer);
+        jsonFieldUint(&writer, "id", area->id);
+        jsonFieldUint(&writer, "total_size", area->totalSize);
+        jsonFieldUint(&writer, "block_size", area->blockSize);
+        jsonFieldUint(&writer, "chunk_size", area->chunkSize);
+        jsonEndObject(&writer);
+    }
+    jsonEndArray(&writer);
+    jsonEndObject(&writer);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+// Reply with the CRC32C of an opened read stream instead of its bytes
+static enum MHD_Result queueStorageChecksum(struct MHD_Connection *connection, StorageStream *stream) {
+    StorageProgress progress;
+    ResponseBuffer body;
+    JsonWriter writer;
+    char crcText[9];
+    uint8_t *chunk = storageChunkAlloc(stream->area);
+    
+    if (chunk == NULL) {
+        return MHD_NO;
+    }
+    while (storageStreamRead(stream, chunk, stream->area->chunkSize) > 0) {
+        // The stream keeps the running checksum
+    }
+    storageChunkFree(chunk);
+    storageStreamProgress(stream, &progress);
+    if (!responseBufferAcquire(&body)) {
+        return MHD_NO;
+    }
+    snprintf(crcText, sizeof(crcText), "%08x", stream->crc);
+    responseWriterInit(&writer, &body, connection);
+    jsonBeginObject(&writer);
+    jsonFieldUint(&writer, "id", stream->area->id);
+    jsonFieldUint(&writer, "offset", stream->start);
+    jsonFieldUint(&writer, "bytes", progress.bytes);
+    jsonFieldUint(&writer, "status", stream->status);
+    if (stream->status == SUSI_STATUS_SUCCESS) {
+        jsonFieldString(&writer, "crc32c", crcText);
+    }
+    jsonFieldUint(&writer, "duration_us", progress.elapsedNs / 1000);
+    jsonFieldDouble(&writer, "bytes_per_second", progress.bytesPerSecond, 1);
+    jsonEndObject(&writer);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+// GET /api/storage - Areas and their geometry
+// GET /api/storage/<id>[?offset=O&length=L][&crc=1] - Stream the bytes, chunked,
+//                                                     or only their CRC32C with crc=1
+// PUT /api/storage/<id>[?offset=O][&diff=1][&verify=1] - Write the raw request body from O,
+//                                               only the blocks that differ with diff=1,
+//                                               reading each chunk back with verify=1
+static enum MHD_Result handleStorageRoute(struct MHD_Connection *connection, const char *method, const char *rest,
+                                          StorageUpload *upload) {
+    uint32_t offset = 0, length = 0;
+    bool hasOffset, hasLength;
+    struct MHD_Response *response;
+    StorageStream *stream;
+    StorageProgress progress;
+    ResponseBuffer body;
+    JsonWriter writer;
+    enum MHD_Result ret;
+    char crcText[9];
+    SusiId_t id;
+
+    if (storageAreaCount() == 0) {
+        return queueError(connection, "No storage areas");
+    }
+    if (strcmp(method, "PUT") == 0 && upload != NULL) {
+        if (upload->error != NULL) {
+            return queueError(connection, upload->error);
+        }
+        storageStreamFinish(&upload->stream);
+        storageStreamProgress(&upload->stream, &progress);
+        if (!responseBufferAcquire(&body)) {
+            return MHD_NO;
+        }
+        responseWriterInit(&writer, &body, connection);
+        jsonBeginObject(&writer);
+        jsonFieldUint(&writer, "id", upload->stream.area->id);
+        jsonFieldUint(&writer, "offset", upload->stream.start);
+        jsonFieldUint(&writer, "bytes", progress.bytes);
+        jsonFieldUint(&writer, "status", upload->stream.status);
+        if (upload->stream.mode == STORAGE_WRITE_CHANGED) {
+            jsonFieldUint(&writer, "blocks_compared", upload->stream.blocksCompared);
+            jsonFieldUint(&writer, "blocks_changed", upload->stream.blocksChanged);
+        }
+        // Of the bytes that reached the area
+        snprintf(crcText, sizeof(crcText), "%08x", upload->stream.crc);
+        jsonFieldString(&writer, "crc32c", crcText);
+        jsonFieldBool(&writer, "verified", upload->stream.verify);
+        jsonFieldUint(&writer, "duration_us", progress.elapsedNs / 1000);
+        jsonFieldDouble(&writer, "bytes_per_second", progress.bytesPerSecond, 1);
+        jsonEndObject(&writer);
+        return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+    }
+    if (strcmp(method, "GET") != 0) {
+        return queueError(connection, "Method not allowed");
+    }
+    if (rest[0] == '\0') {
+        return queueStorageAreas(connection);
+    }
+    if (!storageAreaId(rest, &id) || storageAreaFind(id) == NULL) {
+        return queueError(connection, "Unknown storage area");
+    }
+
+    stream = memPoolAlloc(&storageStreamPool, sizeof(*stream));
+    if (stream == NULL) {
+        return MHD_NO;
+    }
+    if (!uintArgument(connection, "offset", &hasOffset, &offset) ||
+        !uintArgument(connection, "length", &hasLength, &length) ||
+        !storageStreamOpen(stream, id, offset, length, STORAGE_READ, false)) {
+        memPoolFree(&storageStreamPool, stream);
+        return queueError(connection, "Range outside the storage area");
+    }
+    if (flagArgument(connection, "crc")) {
+        ret = queueStorageChecksum(connection, stream);
+        storageReaderFree(stream);
+        return ret;
+    }
+    response = MHD_create_response_from_callback(MHD_SIZE_UNKNOWN, STORAGE_HTTP_BLOCK, storageReader, stream,
+                                                 storageReaderFree);
+    if (response == NULL) {
+        storageReaderFree(stream);
+        return MHD_NO;
+    }
+    MHD_add_response_header(response, "Content-Type", "application/octet-stream");
+    ret = MHD_queue_response(connection, MHD_HTTP_OK, response);
+    MHD_destroy_response(response);
+    return ret;
+}
+
+static void writeKvEntry(const char *key, const uint8_t *value, uint32_t length, void *ctx) {
+    JsonWriter *writer = ctx;
+    char text[STORAGE_KV_VALUE_MAX + 1];
+    char hexData[2 * STORAGE_KV_VALUE_MAX + 1];
+    bool printable = true;
+
+    for (uint32_t i = 0; i < length; i++) {
+        printable = printable && value[i] >= 0x20 && value[i] < 0x7f;
+    }
+    jsonBeginObject(writer);
+    jsonFieldString(writer, "key", key);
+    hexEncode(hexData, value, length);
+    jsonFieldString(writer, "data", hexData);
+    if (printable) {
+        memcpy(text, value, length);
+        text[length] = '\0';
+        jsonFieldString(writer, "value", text);
+    }
+    jsonEndObject(writer);
+}
+
+// GET    /api/kv - Every key of the store
+// GET    /api/kv/<key> - One key, answered from memory
+// PUT    /api/kv/<key>?value=TEXT | ?data=HEX - Set a key, one small append
+// DELETE /api/kv/<key> - Remove a key
+static enum MHD_Result handleKvRoute(struct MHD_Connection *connection, const char *method, const char *rest) {
+    const char *valueText = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "value");
+    const char *dataText = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "data");
+    uint8_t value[STORAGE_KV_VALUE_MAX];
+    uint32_t length = 0;
+    SusiStatus_t status;
+    ResponseBuffer body;
+    JsonWriter writer;
+    const char *key;
+
+    if (!storageKvEnabled()) {
+        return queueError(connection, "Key-value store is not enabled (see --kv-store)");
+    }
+    if (rest[0] == '\0') {
+        if (strcmp(method, "GET") != 0) {
+            return queueError(connection, "Method not allowed");
+        }
+        if (!responseBufferAcquireSize(&body, 256 + STORAGE_KV_MAX_KEYS * (96 + 3 * STORAGE_KV_VALUE_MAX))) {
+            return MHD_NO;
+        }
+        responseWriterInit(&writer, &body, connection);
+        jsonBeginObject(&writer);
+        jsonKey(&writer, "keys");
+        jsonBeginArray(&writer);
+        storageKvForEach(writeKvEntry, &writer);
+        jsonEndArray(&writer);
+        jsonEndObject(&writer);
+        return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+    }
+    if (rest[0] != '/' || rest[1] == '\0') {
+        return queueError(connection, "Unknown endpoint");
+    }
+    key = rest + 1;
+
+    if (strcmp(method, "GET") == 0) {
+        if (!storageKvGet(key, value, &length)) {
+            return queueError(connection, "Key not set");
+        }
+        if (!responseBufferAcquireSize(&body, 256 + 3 * STORAGE_KV_VALUE_MAX)) {
+            return MHD_NO;
+        }
+        responseWriterInit(&writer, &body, connection);
+        writeKvEntry(key, value, length, &writer);
+        return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+    }
+    if (strcmp(method, "PUT") == 0) {
+        if (valueText != NULL) {
+            length = (uint32_t)strlen(valueText);
+            if (length > STORAGE_KV_VALUE_MAX) {
+                return queueError(connection, "Value longer than 64 bytes");
+            }
+            memcpy(value, valueText, length);
+        } else if (dataText != NULL) {
+            for (length = 0; dataText[2 * length] != '\0'; length++) {
+                int high = hexDigit(dataText[2 * length]);
+                int low = high < 0 ? -1 : hexDigit(dataText[2 * length + 1]);
+
+                if (low < 0 || length == STORAGE_KV_VALUE_MAX) {
+                    return queueError(connection, "Invalid data (expected up to 64 hex bytes)");
+                }
+                value[length] = (uint8_t)(high << 4 | low);
+            }
+        } else {
+            return queueError(connection, "Expected value=TEXT or data=HEX");
+        }
+        status = storageKvSet(key, value, length);
+    } else if (strcmp(method, "DELETE") == 0) {
+        status = storageKvDelete(key);
+    } else {
+        return queueError(connection, "Method not allowed");
+    }
+    if (status == SUSI_STATUS_INVALID_PARAMETER) {
+        return queueError(connection, "Invalid key (1 to 31 characters of A-Z, a-z, 0-9, '_', '.', '-')");
+    }
+    if (status == SUSI_STATUS_NOT_FOUND) {
+        return queueError(connection, "Key not set");
+    }
+
+    if (!responseBufferAcquire(&body)) {
+        return MHD_NO;
+    }
+    responseWriterInit(&writer, &body, connection);
+    jsonBeginObject(&writer);
+    jsonFieldString(&writer, "key", key);
+    jsonFieldUint(&writer, "status", status);
+    if (status == SUSI_STATUS_MORE_DATA) {
+        jsonFieldString(&writer, "error", "Store is full");
+    }
+    jsonEndObject(&writer);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+// GET /api/fan - Software fan loops, their inputs and the duty last set
+static enum MHD_Result handleFanRoute(struct MHD_Connection *connection, const char *method) {
+    FanLoopStatus loops[FAN_CONTROL_MAX_LOOPS];
+    int count;
+    ResponseBuffer body;
+    JsonWriter writer;
+
+    if (strcmp(method, "GET") != 0) {
+        return queueError(connection, "Method not allowed");
+    }
+    count = fanControlStatus(loops, FAN_CONTROL_MAX_LOOPS);
+    if (count == 0) {
+        return queueError(connection, "No fan loops configured (see --fan-loop)");
+    }
+    if (!responseBufferAcquire(&body)) {
+        return MHD_NO;
+    }
+    responseWriterInit(&writer, &body, connection);
+    jsonBeginObject(&writer);
+    jsonKey(&writer, "loops");
+    jsonBeginArray(&writer);
+    for (int i = 0; i < count; i++) {
+        const FanLoopStatus *loop = &loops[i];
+        const FanLoopConfig *config = &loop->config;
+
+        jsonBeginObject(&writer);
+        jsonFieldUint(&writer, "fan", config->fan - SUSI_ID_HWM_FAN_BASE);
+        jsonFieldUint(&writer, "sensor", config->sensorSlot);
+        jsonFieldBool(&writer, "running", loop->running);
+        if (config->kind == FAN_LOOP_PID) {
+            jsonFieldString(&writer, "mode", "pid");
+            jsonFieldDouble(&writer, "setpoint", config->setpoint, 1);
+            jsonFieldDouble(&writer, "kp", config->kp, 3);
+            jsonFieldDouble(&writer, "ki", config->ki, 3);
+            jsonFieldDouble(&writer, "kd", config->kd, 3);
+            jsonFieldUint(&writer, "min_duty", config->minDuty);
+            jsonFieldUint(&writer, "max_duty", config->maxDuty);
+            jsonFieldDouble(&writer, "integral", loop->integral, 2);
+        } else if (config->kind == FAN_LOOP_CURVE) {
+            jsonFieldString(&writer, "mode", "curve");
+            jsonKey(&writer, "points");
+            jsonBeginArray(&writer);
+            for (int p = 0; p < config->points; p++) {
+                jsonBeginArray(&writer);
+                jsonInt(&writer, config->pointTemperature[p]);
+                jsonUint(&writer, config->pointDuty[p]);
+                jsonEndArray(&writer);
+            }
+            jsonEndArray(&writer);
+        } else {
+            jsonFieldString(&writer, "mode", "hyst");
+            jsonFieldDouble(&writer, "low", config->low, 1);
+            jsonFieldDouble(&writer, "high", config->high, 1);
+            jsonFieldUint(&writer, "low_duty", config->lowDuty);
+            jsonFieldUint(&writer, "high_duty", config->highDuty);
+        }
+        jsonKey(&writer, "temperature");
+        if (isnan(loop->temperature)) {
+            jsonNull(&writer);
+        } else {
+            jsonDouble(&writer, loop->temperature, 1);
+        }
+        jsonKey(&writer, "duty");
+        if (loop->duty < 0) {
+            jsonNull(&writer);
+        } else {
+            jsonUint(&writer, (uint64_t)loop->duty);
+        }
+        jsonFieldUint(&writer, "updated_ms", loop->updatedMs);
+        jsonFieldUint(&writer, "updates", loop->updates);
+        jsonFieldUint(&writer, "writes", loop->writes);
+        jsonFieldUint(&writer, "skipped", loop->skipped);
+        jsonFieldUint(&writer, "errors", loop->errors);
+        jsonFieldUint(&writer, "last_status", loop->lastStatus);
+        jsonEndObject(&writer);
+    }
+    jsonEndArray(&writer);
+    jsonEndObject(&writer);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+// GET /api/thermal - Thermal protection zones and the forecast time to trip
+static enum MHD_Result handleThermalRoute(struct MHD_Connection *connection, const char *method) {
+    ThermalZone zones[SUSI_ID_THERMAL_MAX];
+    int count;
+    ResponseBuffer body;
+    JsonWriter writer;
+
+    if (strcmp(method, "GET") != 0) {
+        return queueError(connection, "Method not allowed");
+    }
+    count = thermalMonitorZones(zones, SUSI_ID_THERMAL_MAX);
+    if (count == 0) {
+        return queueError(connection, "No thermal protection zones are monitored");
+    }
+    if (!responseBufferAcquire(&body)) {
+        return MHD_NO;
+    }
+    responseWriterInit(&writer, &body, connection);
+    jsonBeginObject(&writer);
+    jsonKey(&writer, "zones");
+    jsonBeginArray(&writer);
+    for (int i = 0; i < count; i++) {
+        const ThermalZone *zone = &zones[i];
+
+        jsonBeginObject(&writer);
+        jsonFieldUint(&writer, "zone", zone->id);
+        jsonFieldUint(&writer, "sensor", zone->sensorSlot);
+        jsonFieldString(&writer, "action", thermalActionName(zone->eventType));
+        jsonFieldDouble(&writer, "trip", hwmScale(HWM_KIND_TEMPERATURE, zone->tripRaw), 1);
+        jsonFieldDouble(&writer, "clear", hwmScale(HWM_KIND_TEMPERATURE, zone->clearRaw), 1);
+        jsonFieldString(&writer, "state", thermalStateName(zone->state));
+        jsonKey(&writer, "temperature");
+        if (isnan(zone->temperature)) {
+            jsonNull(&writer);
+        } else {
+            jsonDouble(&writer, zone->temperature, 1);
+        }
+        jsonFieldDouble(&writer, "slope", zone->slope, 4);
+        jsonKey(&writer, "seconds_to_trip");
+        if (zone->secondsToTrip == THERMAL_NO_FORECAST) {
+            jsonNull(&writer);
+        } else {
+            jsonUint(&writer, zone->secondsToTrip);
+        }
+        jsonFieldUint(&writer, "updated_ms", zone->updatedMs);
+        jsonFieldUint(&writer, "warnings", zone->warnings);
+        jsonFieldUint(&writer, "trips", zone->trips);
+        jsonEndObject(&writer);
+    }
+    jsonEndArray(&writer);
+    jsonEndObject(&writer);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+// GET /api/backlight - Panels and their ramps
+// PUT /api/backlight?id=N&brightness=B[&ramp_ms=T] - Set a panel's target
+static enum MHD_Result handleBacklightRoute(struct MHD_Connection *connection, const char *method) {
+    BacklightStatus panels[SUSI_ID_BACKLIGHT_MAX];
+    int count;
+    ResponseBuffer body;
+    JsonWriter writer;
+    
+    if (strcmp(method, "PUT") == 0) {
+        bool hasId, hasBrightness, hasRamp;
+        uint32_t id = 0, brightness = 0, rampMs = 0;
+        const char *error;
+        
+        if (!uintArgument(connection, "id", &hasId, &id) ||
+            !uintArgument(connection, "brightness", &hasBrightness, &brightness) ||
+            !uintArgument(connection, "ramp_ms", &hasRamp, &rampMs)) {
+            return queueError(connection, "id, brightness and ramp_ms must be numbers");
+        }
+        if (!hasId || !hasBrightness) {
+            return queueError(connection, "PUT needs id and brightness");
+        }
+        if ((error = backlightRequest((SusiId_t)id, brightness, rampMs)) != NULL) {
+            return queueError(connection, error);
+        }
+        return queueMessage(connection, "status", "Accepted");
+    }
+    if (strcmp(method, "GET") != 0) {
+        return queueError(connection, "Method not allowed");
+    }
+    count = backlightStatus(panels, SUSI_ID_BACKLIGHT_MAX);
+    if (count == 0) {
+        return queueError(connection, "Backlight control is not running");
+    }
+    if (!responseBufferAcquire(&body)) {
+        return MHD_NO;
+    }
+    responseWriterInit(&writer, &body, connection);
+    jsonBeginObject(&writer);
+    jsonKey(&writer, "panels");
+    jsonBeginArray(&writer);
+    for (int i = 0; i < count; i++) {
+        const BacklightStatus *panel = &panels[i];
+        
+        jsonBeginObject(&writer);
+        jsonFieldUint(&writer, "id", panel->id);
+        jsonFieldUint(&writer, "minimum", panel->minimum);
+        jsonFieldUint(&writer, "maximum", panel->maximum);
+        jsonFieldUint(&writer, "brightness", panel->brightness);
+        jsonFieldUint(&writer, "target", panel->target);
+        jsonFieldUint(&writer, "ramp_remaining_ms", panel->rampRemainingMs);
+        jsonFieldUint(&writer, "requests", panel->requests);
+        jsonFieldUint(&writer, "coalesced", panel->coalesced);
+        jsonFieldUint(&writer, "writes", panel->writes);
+        jsonFieldUint(&writer, "errors", panel->errors);
+        jsonFieldUint(&writer, "last_status", panel->lastStatus);
+        jsonEndObject(&writer);
+    }
+    jsonEndArray(&writer);
+    jsonEndObject(&writer);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+// GET /api/poe - Latest snapshot of every PoE port and the power budget
+// PUT /api/poe?port=N&power=on|off - Switch a port's power
+static enum MHD_Result handlePoeRoute(struct MHD_Connection *connection, const char *method) {
+    PoeSnapshot snapshot;
+    uint64_t energyUj;
+    ResponseBuffer body;
+    JsonWriter writer;
+    
+    if (strcmp(method, "PUT") == 0) {
+        bool hasPort;
+        uint32_t port = 0;
+        const char *power = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "power");
+        const char *error;
+        
+        if (!uintArgument(connection, "port", &hasPort, &port)) {
+            return queueError(connection, "port must be a number");
+        }
+        if (!hasPort || power == NULL || (strcmp(power, "on") != 0 && strcmp(power, "off") != 0)) {
+            return queueError(connection, "PUT needs port and power=on|off");
+        }
+        if ((error = poeMonitorSetPower(port, strcmp(power, "on") == 0)) != NULL) {
+            return queueError(connection, error);
+        }
+        return queueMessage(connection, "status", "Port power changed");
+    }
+    if (strcmp(method, "GET") != 0) {
+        return queueError(connection, "Method not allowed");
+    }
+    if (!poeMonitorSnapshot(&snapshot)) {
+        return queueError(connection, "PoE monitor is not running");
+    }
+    if (!responseBufferAcquire(&body)) {
+        return MHD_NO;
+    }
+    responseWriterInit(&writer, &body, connection);
+    jsonBeginObject(&writer);
+    jsonFieldUint(&writer, "updated_ms", snapshot.updatedMs);
+    jsonFieldDouble(&writer, "total_watts", (double)snapshot.totalMw / 1000.0, 3);
+    jsonKey(&writer, "budget_watts");
+    if (snapshot.budgetMw != 0) {
+        jsonDouble(&writer, (double)snapshot.budgetMw / 1000.0, 3);
+    } else {
+        jsonNull(&writer);
+    }
+    jsonFieldBool(&writer, "over_budget", snapshot.overBudget);
+    jsonKey(&writer, "ports");
+    jsonBeginArray(&writer);
+    for (int i = 0; i < snapshot.portCount; i++) {
+        const PoePort *port = &snapshot.ports[i];
+        
+        jsonBeginObject(&writer);
+        jsonFieldUint(&writer, "port", port->port);
+        jsonFieldBool(&writer, "powered", port->powered);
+        jsonFieldString(&writer, "detection", poeDetectionName(port->detection));
+        jsonFieldString(&writer, "class", poeClassName(port->classification));
+        jsonFieldDouble(&writer, "volts", (double)port->voltageMv / 1000.0, 3);
+        jsonFieldDouble(&writer, "milliamps", (double)port->currentUa / 1000.0, 3);
+        jsonFieldDouble(&writer, "watts", (double)port->powerMw / 1000.0, 3);
+        jsonFieldUint(&writer, "failed_reads", port->failedReads);
+        if (poeEnergyGet(port->port, &energyUj)) {
+            jsonFieldDouble(&writer, "energy_wh", (double)energyUj / 3600e6, 3);
+        }
+        jsonEndObject(&writer);
+    }
+    jsonEndArray(&writer);
+    jsonEndObject(&writer);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+// GET /api/battery - Smart Battery registers merged from the static, slow
+// and fast tiers, with the tier each was last read in
+static enum MHD_Result handleBatteryRoute(struct MHD_Connection *connection, const char *method) {
+    BatterySnapshot snapshot;
+    ResponseBuffer body;
+    JsonWriter writer;
+    char name[24];
+    
+    if (strcmp(method, "GET") != 0) {
+        return queueError(connection, "Method not allowed");
+    }
+    if (!batteryMonitorSnapshot(&snapshot)) {
+        return queueError(connection, "Battery monitor is not running");
+    }
+    if (!responseBufferAcquire(&body)) {
+        return MHD_NO;
+    }
+    responseWriterInit(&writer, &body, connection);
+    jsonBeginObject(&writer);
+    batteryManufacturer(&snapshot, name, sizeof(name));
+    jsonFieldString(&writer, "manufacturer", name);
+    if (batteryRegisterValid(&snapshot, BATTERY_REG_MANUFACTURE_DATE)) {
+        uint32_t date = (uint32_t)batteryRegisterValue(&snapshot, BATTERY_REG_MANUFACTURE_DATE);
+        
+        snprintf(name, sizeof(name), "%04u-%02u-%02u", (date >> 9) + 1980, (date >> 5) & 0xf, date & 0x1f);
+        jsonFieldString(&writer, "manufacture_date", name);
+    }
+    if (batteryRegisterValid(&snapshot, BATTERY_REG_UNIT)) {
+        jsonFieldString(&writer, "capacity_unit", batteryRegisterValue(&snapshot, BATTERY_REG_UNIT) ? "10mWh" : "mAh");
+    }
+    if (batteryRegisterValid(&snapshot, BATTERY_REG_CURRENT) && batteryRegisterValid(&snapshot, BATTERY_REG_BATTERY_STATUS)) {
+        const char *state = "ac";
+        
+        // As SmartBatteryDEMO: no current is mains power, else status bit 6
+        if (batteryRegisterValue(&snapshot, BATTERY_REG_CURRENT) != 0) {
+            state = batteryRegisterValue(&snapshot, BATTERY_REG_BATTERY_STATUS) & 0x40 ? "discharging" : "charging";
+        }
+        jsonFieldString(&writer, "state", state);
+    }
+    if (batteryRegisterValid(&snapshot, BATTERY_REG_TEMPERATURE)) {
+        jsonFieldDouble(&writer, "temperature_c", batteryRegisterValue(&snapshot, BATTERY_REG_TEMPERATURE) / 10.0 - 273.15, 1);
+    }
+    if (snapshot.smoothed) {
+        jsonKey(&writer, "estimate");
+        jsonBeginObject(&writer);
+        jsonFieldDouble(&writer, "current_ma", snapshot.currentMa, 1);
+        jsonFieldDouble(&writer, "charge_percent", snapshot.chargePercent, 1);
+        jsonKey(&writer, "seconds_to_empty");
+        if (snapshot.secondsToEmpty == BATTERY_NO_ESTIMATE) {
+            jsonNull(&writer);
+        } else {
+            jsonUint(&writer, snapshot.secondsToEmpty);
+        }
+        jsonFieldString(&writer, "alarm", batteryAlarmName(snapshot.alarm));
+        jsonEndObject(&writer);
+    }
+    jsonKey(&writer, "registers");
+    jsonBeginObject(&writer);
+    for (int i = 0; i < BATTERY_REG_COUNT; i++) {
+        jsonKey(&writer, batteryRegisterName((BatteryRegister)i));
+        if (batteryRegisterValid(&snapshot, (BatteryRegister)i)) {
+            jsonInt(&writer, batteryRegisterValue(&snapshot, (BatteryRegister)i));
+        } else {
+            jsonNull(&writer);
+        }
+    }
+    jsonEndObject(&writer);
+    jsonKey(&writer, "tiers");
+    jsonBeginObject(&writer);
+    for (int tier = 0; tier < BATTERY_TIER_COUNT; tier++) {
+        jsonKey(&writer, batteryTierName((BatteryTier)tier));
+        jsonBeginObject(&writer);
+        if (snapshot.tiers[tier].intervalMs != 0) {
+            jsonFieldUint(&writer, "interval_ms", snapshot.tiers[tier].intervalMs);
+        }
+        jsonFieldUint(&writer, "reads", snapshot.tiers[tier].reads);
+        jsonFieldUint(&writer, "updated_ms", snapshot.tiers[tier].updatedMs);
+        jsonEndObject(&writer);
+    }
+    jsonEndObject(&writer);
+    jsonEndObject(&writer);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+// GET /api/iot[?refresh=1] - The SusiIoT capability document
+// GET /api/iot/data?id=N | ?uri=PATH - One item's data, cached per ID
+// PUT /api/iot/data?id=N&value=JSON - Write a value
+static enum MHD_Result handleIotRoute(struct MHD_Connection *connection, const char *method, const char *path) {
+    const char *uri = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "uri");
+    const char *value;
+    const char *error;
+    enum MHD_Result ret;
+    bool hasId;
+    uint32_t id = 0;
+    
+    if (path[0] == '\0') {
+        const char *refresh = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "refresh");
+        
+        if (strcmp(method, "GET") != 0) {
+            return queueError(connection, "Method not allowed");
+        }
+        ret = susiIotQueueCapability(connection, refresh != NULL && strcmp(refresh, "0") != 0);
+        if (ret == MHD_YES) {
+            return ret;
+        }
+        return queueError(connection, "SusiIoT is not available (see --iot)");
+    }
+    if (strcmp(path, "/data") != 0) {
+        return queueError(connection, "Unknown endpoint");
+    }
+    if (!uintArgument(connection, "id", &hasId, &id)) {
+        return queueError(connection, "id must be a number");
+    }
+    if (strcmp(method, "PUT") == 0) {
+        value = MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "value");
+        if (!hasId && uri != NULL && !susiIotResolve(uri, &id)) {
+            return queueError(connection, "Unknown IoT URI");
+        }
+        if ((!hasId && uri == NULL) || value == NULL) {
+            return queueError(connection, "PUT needs id (or uri) and value");
+        }
+        if ((error = susiIotSetValue(id, value)) != NULL) {
+            return queueError(connection, error);
+        }
+        return queueMessage(connection, "status", "Written");
+    }
+    if (strcmp(method, "GET") != 0) {
+        return queueError(connection, "Method not allowed");
+    }
+    if (!hasId && uri == NULL) {
+        return queueError(connection, "GET needs id or uri");
+    }
+    ret = susiIotQueueData(connection, id, hasId ? NULL : uri);
+    if (ret == MHD_YES) {
+        return ret;
+    }
+    return queueError(connection, "IoT item not available");
+}
+
+// GET /api/config - Current settings; PUT /api/config - Apply a body of
+// changed settings as one transaction
+static enum MHD_Result handleConfigRoute(struct MHD_Connection *connection, const char *method,
+                                         const ConfigBody *config) {
+    ResponseBuffer body;
+    JsonWriter writer;
+    const char *error;
+    ConfigTxn *txn;
+    
+    if (strcmp(method, "GET") == 0) {
+        ConfigClassState state[CONFIG_CLASS_COUNT];
+        char key[CONFIG_KEY_MAX];
+        
+        if (!configTxnCurrent(state, flagArgument(connection, "refresh"))) {
+            return queueError(connection, watchdogQueueFull);
+        }
+        if (!responseBufferAcquire(&body)) {
+            return MHD_NO;
+        }
+        responseWriterInit(&writer, &body, connection);
+        jsonBeginObject(&writer);
+        for (int c = 0; c < CONFIG_CLASS_COUNT; c++) {
+            for (int i = 0; i < CONFIG_TXN_MAX_ITEMS; i++) {
+                if (!((state[c].present >> i) & 1)) {
+                    continue;
+                }
+                for (int f = 0; f < configClassFields((ConfigClass)c); f++) {
+                    snprintf(key, sizeof(key), "%s%d.%s", configClassName((ConfigClass)c), i,
+                             configFieldName((ConfigClass)c, f));
+                    jsonFieldUint(&writer, key, state[c].items[i].values[f]);
+                }
+            }
+        }
+        jsonEndObject(&writer);
+        return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+    }
+    if (strcmp(method, "PUT") != 0 || config == NULL) {
+        return queueError(connection, "Method not allowed");
+    }
+    if (config->error != NULL) {
+        return queueError(connection, config->error);
+    }
+    txn = config->sinkCtx;
+    if ((error = configTxnValidate(txn)) != NULL) {
+        return queueError(connection, error);
+    }
+    txn->refresh = flagArgument(connection, "refresh");
+    if (!configTxnApply(txn)) {
+        return queueError(connection, watchdogQueueFull);
+    }
+    if (txn->error != NULL) {
+        return queueError(connection, txn->error);
+    }
+    if (!responseBufferAcquire(&body)) {
+        return MHD_NO;
+    }
+    responseWriterInit(&writer, &body, connection);
+    jsonBeginObject(&writer);
+    jsonFieldString(&writer, "result", configTxnResultName(txn->result));
+    jsonKey(&writer, "changed");
+    jsonBeginArray(&writer);
+    for (int n = 0; n < txn->changes; n++) {
+        char device[16];
+        
+        snprintf(device, sizeof(device), "%s%u", configClassName((ConfigClass)txn->changed[n].deviceClass),
+                 txn->changed[n].item);
+        jsonString(&writer, device);
+    }
+    jsonEndArray(&writer);
+    jsonFieldInt(&writer, "unchanged", txn->unchanged);
+    if (txn->failed >= 0) {
+        char device[16];
+        
+        snprintf(device, sizeof(device), "%s%u", configClassName((ConfigClass)txn->changed[txn->failed].deviceClass),
+                 txn->changed[txn->failed].item);
+        jsonFieldString(&writer, "failed", device);
+        jsonFieldString(&writer, "error", txn->failure);
+        jsonFieldUint(&writer, "susi_status", txn->failedStatus);
+        jsonFieldInt(&writer, "rollback_errors", txn->rollbackErrors);
+    }
+    jsonEndObject(&writer);
+    return responseBufferQueue(connection, MHD_HTTP_OK, "application/json", &body);
+}
+
+// Dispatch a request to its endpoint handler
+static enum MHD_Result routeRequest(struct MHD_Connection *connection, const char *url, const char *method,
+                                    const ConfigBody *config, StorageUpload *upload) {
+    enum MHD_Result ret;
+    
+    // GET /api/fleet - Merged status and telemetry of the scraped boards
+    if (strcmp(url, "/api/fleet") == 0) {
+        if (strcmp(method, "GET") != 0) {
+            return queueError(connection, "Method not allowed");
+        }
+        return fleetQueueResponse(connection);
+    }
+    // A gateway has no hardware behind the other routes
+    if (gatewayMode && strcmp(url, "/metrics") != 0) {
+        return queueError(connection, "Not available in gateway mode");
+    }
+    // Per-device API: /api/wdt and /api/wdt/<n>/...
+    if (strncmp(url, "/api/wdt", 8) == 0 && (url[8] == '\0' || url[8] == '/')) {
+        return handleWatchdogRoute(connection, method, url + 8, config);
+    }
+    // Liveness leases: /api/lease and /api/lease/<id>/...
+    if (strncmp(url, "/api/lease", 10) == 0 && (url[10] == '\0' || url[10] == '/')) {
+        return handleLeaseRoute(connection, method, url + 10);
+    }
+    // GPIO banks: /api/gpio
+    if (strcmp(url, "/api/gpio") == 0) {
+        return handleGpioRoute(connection, method);
+    }
+    // Batched I2C transfers: /api/i2c
+    if (strcmp(url, "/api/i2c") == 0) {
+        return handleI2cRoute(connection, method);
+    }
+    // Staggered RTC wake from S5: /api/wake
+    if (strcmp(url, "/api/wake") == 0) {
+        return handleWakeRoute(connection, method);
+    }
+    // Mixed reads and watchdog actions in one round trip: /api/batch
+    if (strcmp(url, "/api/batch") == 0) {
+        return handleBatchRoute(connection, method);
+    }
+    // Cached register access: /api/i2c/register, /api/i2c/invalidate
+    if (strcmp(url, "/api/i2c/register") == 0 || strcmp(url, "/api/i2c/invalidate") == 0) {
+        return handleI2cRegisterRoute(connection, method, strcmp(url + 9, "invalidate") == 0);
+    }
+    // Bulk SMBus transfers: /api/smbus
+    if (strcmp(url, "/api/smbus") == 0) {
+        return handleSmbusRoute(connection, method);
+    }
+    // Storage areas: /api/storage and /api/storage/<id>
+    if (strncmp(url, "/api/storage", 12) == 0 && (url[12] == '\0' || url[12] == '/')) {
+        return handleStorageRoute(connection, method, url + 12, upload);
+    }
+    // Persistent key-value store: /api/kv and /api/kv/<key>
+    if (strncmp(url, "/api/kv", 7) == 0 && (url[7] == '\0' || url[7] == '/')) {
+        return handleKvRoute(connection, method, url + 7);
+    }
+    // Software fan loops: /api/fan
+    if (strcmp(url, "/api/fan") == 0) {
+        return handleFanRoute(connection, method);
+    }
+    // Thermal protection forecast: /api/thermal
+    if (strcmp(url, "/api/thermal") == 0) {
+        return handleThermalRoute(connection, method);
+    }
+    // Backlight ramps: /api/backlight
+    if (strcmp(url, "/api/backlight") == 0) {
+        return handleBacklightRoute(connection, method);
+    }
+    // PoE ports and power budget: /api/poe
+    if (strcmp(url, "/api/poe") == 0) {
+        return handlePoeRoute(connection, method);
+    }
+    // Smart Battery registers: /api/battery
+    if (strcmp(url, "/api/battery") == 0) {
+        return handleBatteryRoute(connection, method);
+    }
+    // SusiIoT data model: /api/iot and /api/iot/data
+    if (strncmp(url, "/api/iot", 8) == 0 && (url[8] == '\0' || url[8] == '/')) {
+        return handleIotRoute(connection, method, url + 8);
+    }
+    // Board configuration transactions: /api/config
+    if (strcmp(url, "/api/config") == 0) {
+        return handleConfigRoute(connection, method, config);
+    }
+    // POST /api/bus/scan - Rescan the SMBus and I2C hosts in the background
+    if (strcmp(url, "/api/bus/scan") == 0) {
+        if (strcmp(method, "POST") != 0) {
+            return queueError(connection, "Method not allowed");
+        }
+        if (!busScanRequest()) {
+            return queueError(connection, "Bus scanning is not enabled");
+        }
+        return queueMessage(connection, "status", "Scan requested");
+    }
+    
+    if (strcmp(method, "GET") == 0) {
+        // GET /metrics - Prometheus text exposition from the pre-rendered snapshot
+        if (strcmp(url, "/metrics") == 0) {
+            ret = metricsQueueResponse(connection);
+            if (ret == MHD_YES) {
+                return ret;
+            }
+            return queueError(connection, "Metrics not available yet");
+        }
+        // GET /api/events - Server-sent state changes
+        if (strcmp(url, "/api/events") == 0) {
+            return eventsQueueStream(connection);
+        }
+        // GET /api/hwm - Latest hardware monitor sweep
+        if (strcmp(url, "/api/hwm") == 0) {
+            ret = hwmQueueResponse(connection);
+            if (ret == MHD_YES) {
+                return ret;
+            }
+            return queueError(connection, "Hardware monitor not available");
+        }
+        // GET /api/hwm/previous - Raw sweeps resumed from --hwm-store
+        if (strcmp(url, "/api/hwm/previous") == 0) {
+            ret = hwmQueuePrevious(connection);
+            if (ret == MHD_YES) {
+                return ret;
+            }
+            return queueError(connection, "No samples from a previous run");
+        }
+        // GET /api/hwm/history?res=10s|1m|15m - Pre-computed rollups
+        if (strcmp(url, "/api/hwm/history") == 0) {
+            ret = hwmHistoryQueueResponse(connection,
+                                          MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "res"));
+            if (ret == MHD_YES) {
+                return ret;
+            }
+            return queueError(connection, "History not available (res must be 10s, 1m or 15m)");
+        }
+        // GET /api/hwm/export?res=raw|10s|1m|15m - Delta-of-delta/XOR compressed columns
+        if (strcmp(url, "/api/hwm/export") == 0) {
+            ret = hwmExportQueueResponse(connection,
+                                         MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "res"));
+            if (ret == MHD_YES) {
+                return ret;
+            }
+            return queueError(connection, "Export not available (res must be raw, 10s, 1m or 15m)");
+        }
+        // GET /api/alerts - Compiled alert rules and whether they hold
+        if (strcmp(url, "/api/alerts") == 0) {
+            ret = alertRulesQueueResponse(connection);
+            if (ret == MHD_YES) {
+                return ret;
+            }
+            return queueError(connection, "No alert rules are evaluated (see --alert-rule)");
+        }
+        // GET /api/board - Board inventory, re-rendered only when a counter moves
+        if (strcmp(url, "/api/board") == 0) {
+            ret = boardInfoQueueResponse(connection);
+            if (ret == MHD_YES) {
+                return ret;
+            }
+            return queueError(connection, "Board information not available");
+        }
+        // GET /api/self - What the service itself uses, from counters kept anyway
+        if (strcmp(url, "/api/self") == 0) {
+            return selfStatsQueueResponse(connection);
+        }
+        // GET /api/trace?seconds=N - Recent spans, Chrome trace format
+        if (strcmp(url, "/api/trace") == 0) {
+            const char *error;
+
+            ret = spanTraceQueueResponse(connection,
+                                     MHD_lookup_connection_value(connection, MHD_GET_ARGUMENT_KIND, "seconds"), &error);
+            if (ret == MHD_YES || error == NULL) {
+                return ret;
+            }
+            return queueError(connection, error);
+        }
+        // GET /api/memory - SPD inventory, rendered once
+        if (strcmp(url, "/api/memory") == 0) {
+            ret = memoryInventoryQueueResponse(connection);
+            if (ret == MHD_YES) {
+                return ret;
+            }
+            return queueError(connection, "Memory inventory not available");
+        }
+        // GET /api/diag - PCI functions from the startup enumeration
+        if (strcmp(url, "/api/diag") == 0) {
+            ret = diagDumpQueueDevices(connection);
+            if (ret == MHD_YES) {
+                return ret;
+            }
+            return queueError(connection, "PCI diagnostics not available");
+        }
+        // GET /api/diag/pci, GET /api/diag/msr - Streamed config-space and MSR dumps
+        if (strcmp(url, "/api/diag/pci") == 0 || strcmp(url, "/api/diag/msr") == 0) {
+            const char *error;
+
+            ret = url[10] == 'p' ? diagDumpQueuePci(connection, &error) : diagDumpQueueMsr(connection, &error);
+            if (ret == MHD_YES || error == NULL) {
+                return ret;
+            }
+            return queueError(connection, error);
+        }
+        // GET /api/bus - Cached address map of every SMBus and I2C host
+        if (strcmp(url, "/api/bus") == 0) {
+            ret = busScanQueueResponse(connection);
+            if (ret == MHD_YES) {
+                return ret;
+            }
+            return queueError(connection, "Bus scanning is not enabled");
+        }
+        // GET / - Root endpoint (simple status page)
+        if (strcmp(url, "/") == 0 || strcmp(url, "/index.html") == 0) {
+            return queueIndexPage(connection, watchdogDefaultDevice()->running);
+        }
+    }
+    
+    // Legacy single-timer API: /api/<action> acts on the default device
+    if (strncmp(url, "/api/", 5) == 0 && strchr(url + 5, '/') == NULL) {
+        return handleWatchdogAction(connection, method, watchdogDefaultDevice(), url + 5, config);
+    }
+    
+    if (strcmp(method, "GET") != 0 && strcmp(method, "POST") != 0) {
+        return queueError(connection, "Method not allowed");
+    }
+    return queueError(connection, "Unknown endpoint");
+}
+
+// Only start/configure, configuration transactions and storage uploads read
+// a body; every other request shares this marker as its per-request state
+// and has its upload data discarded
+static int noBodyState;
+// Marks a write refused for want of a token; its body is discarded too
+static int rateLimitedState;
+
+typedef enum {
+    REQUEST_BODY_CONFIG,
+    REQUEST_BODY_UPLOAD,
+    REQUEST_BODY_TXN
+} RequestBody;
+
+typedef struct {
+    RequestBody kind;                // Which member of body is in use
+    union {
+        ConfigBody config;
+        StorageUpload upload;
+        struct {
+            ConfigBody config;       // Hands every field to txn
+            ConfigTxn txn;
+        } change;
+    } body;
+} RequestState;
+
+MEM_POOL_DEFINE(requestStatePool, "request_state", sizeof(RequestState), REQUEST_STATE_POOL);
+
+// Start/configure requests carry a parser that consumes the body as it
+// streams in. Query timings are read first so that body fields win.
+// Storage uploads open their stream here and write the body chunk by chunk.
+// Configuration transactions collect the body into the desired state.
+static void* createRequestState(struct MHD_Connection *connection, const char *url, const char *method) {
+    HttpRoute route = httpRouteClassify(url);
+    RequestState *state;
+    
+    if (strcmp(method, "PUT") == 0 && route == ROUTE_STORAGE && url[12] == '/') {
+        state = memPoolAlloc(&requestStatePool, sizeof(*state));
+        if (state == NULL) {
+            return NULL;
+        }
+        state->kind = REQUEST_BODY_UPLOAD;
+        storageUploadOpen(&state->body.upload, connection, url);
+        return state;
+    }
+    if (strcmp(method, "PUT") == 0 && route == ROUTE_CONFIG) {
+        state = memPoolAlloc(&requestStatePool, sizeof(*state));
+        if (state == NULL) {
+            return NULL;
+        }
+        state->kind = REQUEST_BODY_TXN;
+        configTxnInit(&state->body.change.txn);
+        if (!configBodyInitSink(&state->body.change.config, connection, configTxnSetField, &state->body.change.txn)) {
+            state->body.change.config.error = "Unsupported Content-Type (use application/json or form data)";
+        }
+        return state;
+    }
+    if (strcmp(method, "POST") != 0 || (route != ROUTE_START && route != ROUTE_CONFIGURE)) {
+        return &noBodyState;
+    }
+    state = memPoolAlloc(&requestStatePool, sizeof(*state));
+    if (state == NULL) {
+        return NULL;
+    }
+    state->kind = REQUEST_BODY_CONFIG;
+    if (!configBodyInit(&state->body.config, connection)) {
+        state->body.config.error = "Unsupported Content-Type (use application/json or form data)";
+    }
+    configReadQuery(&state->body.config, connection);
+    return state;
+}
+
+static void requestCompleted(void *cls, struct MHD_Connection *connection,
+                             void **con_cls, enum MHD_RequestTerminationCode toe) {
+    RequestState *state = *con_cls;
+    (void)cls;
+    (void)connection;
+    (void)toe;
+    
+    if (state != NULL && *con_cls != &noBodyState && *con_cls != &rateLimitedState) {
+        if (state->kind == REQUEST_BODY_UPLOAD) {
+            storageStreamClose(&state->body.upload.stream);
+        } else if (state->kind == REQUEST_BODY_TXN) {
+            configBodyDestroy(&state->body.change.config);
+        } else {
+            configBodyDestroy(&state->body.config);
+        }
+        memPoolFree(&requestStatePool, state);
+    }
+    *con_cls = NULL;
+}
+
+// Reads never reach a rate limiter; everything else changes hardware state
+static bool isWriteRequest(const char *method) {
+    return strcmp(method, "GET") != 0 && strcmp(method, "HEAD") != 0;
+}
+
+static enum MHD_Result queueRateLimited(struct MHD_Connection *connection, uint32_t retryAfter) {
+    static const char body[] = "{\"error\":\"Too many requests\"}";
+    struct MHD_Response *response;
+    enum MHD_Result ret;
+    char seconds[16];
+
+    response = MHD_create_response_from_buffer(sizeof(body) - 1, (void *)body, MHD_RESPMEM_PERSISTENT);
+    if (response == NULL) {
+        return MHD_NO;
+    }
+    snprintf(seconds, sizeof(seconds), "%u", retryAfter);
+    MHD_add_response_header(response, "Content-Type", "application/json");
+    MHD_add_response_header(response, "Retry-After", seconds);
+    ret = MHD_queue_response(connection, MHD_HTTP_TOO_MANY_REQUESTS, response);
+    MHD_destroy_response(response);
+    return ret;
+}
+
+// HTTP request handler
+static enum MHD_Result requestHandler(void *cls, struct MHD_Connection *connection,
+                         const char *url, const char *method,
+                         const char *version, const char *upload_data,
+                         size_t *upload_data_size, void **con_cls) {
+    
+    enum MHD_Result ret;
+    HttpRoute route;
+    uint64_t start, end;
+    RequestState *state = NULL;
+    ConfigBody *config = NULL;
+    StorageUpload *upload = NULL;
+    const union MHD_ConnectionInfo *client_info =
+        MHD_get_connection_info(connection, MHD_CONNECTION_INFO_CLIENT_ADDRESS);
+    const struct sockaddr *client = client_info ? client_info->client_addr : NULL;
+    
+    // Prevent unused parameter warnings
+    (void)cls;
+    (void)version;
+    
+    // The first call only carries the headers (MHD requires this pattern).
+    // Writes take their token here, before any body parser or storage
+    // stream is set up for them.
+    if (*con_cls == NULL) {
+        if (isWriteRequest(method) && !rateLimitAcquire(client)) {
+            *con_cls = &rateLimitedState;
+            return MHD_YES;
+        }
+        *con_cls = createRequestState(connection, url, method);
+        return *con_cls != NULL ? MHD_YES : MHD_NO;
+    }
+    if (*con_cls != &noBodyState && *con_cls != &rateLimitedState) {
+        state = *con_cls;
+        if (state->kind == REQUEST_BODY_UPLOAD) {
+            upload = &state->body.upload;
+        } else if (state->kind == REQUEST_BODY_TXN) {
+            config = &state->body.change.config;
+        } else {
+            config = &state->body.config;
+        }
+    }
+    
+    // Body chunks: feed the parser or the storage stream (or drop them)
+    // until the upload is done
+    if (*upload_data_size != 0) {
+        if (config != NULL) {
+            configBodyFeed(config, upload_data, *upload_data_size);
+        } else if (upload != NULL && upload->error == NULL) {
+            // A failed chunk shows in the reply's status; later chunks are dropped
+            if (*upload_data_size > upload->stream.end - upload->stream.offset - upload->stream.pendingLength) {
+                upload->error = "Body runs past the end of the range";
+            } else {
+                storageStreamWrite(&upload->stream, (const uint8_t *)upload_data, (uint32_t)*upload_data_size);
+            }
+        }
+        *upload_data_size = 0;
+        return MHD_YES;
+    }
+    if (config != NULL) {
+        configBodyFinish(config);
+    }
+    
+    // Route requests based on URL and method
+    start = monotonicNowNs();
+    spanTraceRequestBegin();
+    accessLogRequest(method, url, client);
+    
+    if (*con_cls == &rateLimitedState) {
+        ret = queueRateLimited(connection, rateLimitRetryAfter(client));
+    } else {
+        ret = routeRequest(connection, url, method, config, upload);
+    }
+    end = monotonicNowNs();
+    route = httpRouteClassify(url);
+    httpRouteRecord(route, end - start);
+    spanTraceRecord(SPAN_HTTP, httpRouteName(route), start, end);
+    spanTraceRequestEnd();
+    return ret;
+}
+
+// Prometheus collector for the service-level state (runs on the metrics thread)
+void collectServiceMetrics(StrBuf *out, void *ctx) {
+    (void)ctx;
+    
+    metricsHeader(out, "watchdog_susi_initialized", "gauge", "Whether the SUSI library is initialized");
+    strbufAppendf(out, "watchdog_susi_initialized %d\n", susiInitialized ? 1 : 0);
+    metricsHeader(out, "watchdog_devices", "gauge", "Watchdog timers reported by the EC");
+    strbufAppendf(out, "watchdog_devices %d\n", watchdogDeviceCount());
+}
+
+// Initialize the SUSI API
+bool initializeSUSI(void) {
+    uint64_t start = monotonicNowNs();
+    SusiStatus_t status = SusiLibInitialize();
+    susiTimingRecord(SUSI_CALL_LIB_INITIALIZE, start, status);
+    
+    if (status != SUSI_STATUS_SUCCESS) {
+        printf("SUSI API initialization failed with status: 0x%08X\n", status);
+        
+        switch (status) {
+            case SUSI_STATUS_ERROR:
+                printf("Error: General SUSI error\n");
+                break;
+            case SUSI_STATUS_NOT_FOUND:
+                printf("Error: SUSI device or resource not found\n");
+                break;
+            case SUSI_STATUS_UNSUPPORTED:
+                printf("Error: SUSI not supported on this platform\n");
+                break;
+            case SUSI_STATUS_INVALID_PARAMETER:
+                printf("Error: Invalid parameter passed to SUSI\n");
+                break;
+            case SUSI_STATUS_INVALID_BLOCK_ALIGNMENT:
+                printf("Error: Invalid block alignment\n");
+                break;
+            case SUSI_STATUS_INVALID_BLOCK_LENGTH:
+                printf("Error: Invalid block length\n");
+                break;
+            case SUSI_STATUS_INVALID_DIRECTION:
+                printf("Error: Invalid direction\n");
+                break;
+            case SUSI_STATUS_TIMEOUT:
+                printf("Error: SUSI operation timeout\n");
+                break;
+            case SUSI_STATUS_RUNNING:
+                printf("Error: SUSI already running\n");
+                break;
+            default:
+                printf("Error: Unknown SUSI error code\n");
+                break;
+        }
+        
+        printf("\nPossible solutions:\n");
+        printf("1. Run with sudo privileges: sudo LD_LIBRARY_PATH=./SUSI4.2.23739/Driver:$LD_LIBRARY_PATH ./watchdog_http_service\n");
+        printf("2. Check if SUSI drivers are installed and loaded\n");
+        printf("3. Verify hardware compatibility with SUSI API\n");
+        printf("4. Check if this is an embedded system with SUSI support\n");
+        
+        return false;
+    }
+    
+    printf("SUSI API initialized successfully!\n");
+    susiInitialized = true;
+    return true;
+}
+
+// Clean up SUSI API
+void cleanupSUSI(void) {
+    SusiLibUninitialize();
+    printf("SUSI API cleaned up.\n");
+}
+
+// Map a --mode argument to a server mode
+bool parseServerMode(const char *name, ServerMode *mode) {
+    if (strcmp(name, "thread") == 0) {
+        *mode = SERVER_MODE_THREAD;
+    } else if (strcmp(name, "select") == 0) {
+        *mode = SERVER_MODE_SELECT;
+    } else if (strcmp(name, "poll") == 0) {
+        *mode = SERVER_MODE_POLL;
+    } else if (strcmp(name, "epoll") == 0) {
+        *mode = SERVER_MODE_EPOLL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* serverModeName(ServerMode mode) {
+    switch (mode) {
+        case SERVER_MODE_THREAD: return "thread";
+        case SERVER_MODE_SELECT: return "select";
+        case SERVER_MODE_POLL:   return "poll";
+        case SERVER_MODE_EPOLL:  return "epoll";
+    }
+    return "unknown";
+}
+
+// MHD takes one connection callback: the counters behind /api/self, then
+// the TLS session setup and handshake counts
+static void connectionNotify(void *cls, struct MHD_Connection *connection, void **socketContext,
+                             enum MHD_ConnectionNotificationCode code) {
+    selfStatsConnectionNotify(cls, connection, socketContext, code);
+    tlsServerConnectionNotify(cls, connection, socketContext, code);
+}
+
+// Start the MHD daemon in the requested mode.
+// In the polling modes MHD runs a fixed pool of internal threads, each with its
+// own event loop, so a burst of short-lived scraper connections costs no thread
+// creation at all. Thread-per-connection is kept for compatibility.
+struct MHD_Daemon* startHttpDaemon(ServerMode mode, int port, unsigned int threads,
+                                   unsigned int maxConnections, unsigned int perIpConnections,
+                                   size_t connectionMemory, unsigned int connectionTimeout) {
+    unsigned int flags = MHD_USE_ERROR_LOG | tlsServerDaemonFlags();
+    
+    if (mode == SERVER_MODE_EPOLL && MHD_is_feature_supported(MHD_FEATURE_EPOLL) != MHD_YES) {
+        printf("epoll is not supported by this libmicrohttpd build, falling back to poll\n");
+        mode = SERVER_MODE_POLL;
+    }
+    if (mode == SERVER_MODE_POLL && MHD_is_feature_supported(MHD_FEATURE_POLL) != MHD_YES) {
+        printf("poll is not supported by this libmicrohttpd build, falling back to select\n");
+        mode = SERVER_MODE_SELECT;
+    }
+    
+    switch (mode) {
+        case SERVER_MODE_THREAD:
+            flags |= MHD_USE_THREAD_PER_CONNECTION | MHD_USE_INTERNAL_POLLING_THREAD;
+            threads = 1; // Thread pools cannot be combined with thread-per-connection
+            break;
+        case SERVER_MODE_SELECT:
+            flags |= MHD_USE_INTERNAL_POLLING_THREAD | MHD_ALLOW_SUSPEND_RESUME;
+            break;
+        case SERVER_MODE_POLL:
+            flags |= MHD_USE_POLL | MHD_USE_INTERNAL_POLLING_THREAD | MHD_ALLOW_SUSPEND_RESUME;
+            break;
+        case SERVER_MODE_EPOLL:
+            flags |= MHD_USE_EPOLL | MHD_USE_INTERNAL_POLLING_THREAD | MHD_USE_TURBO | MHD_ALLOW_SUSPEND_RESUME;
+            break;
+    }
+    
+    if (threads == 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cores > 0) ? (unsigned int)cores : 1;
+    }
+    
+    printf("Server mode: %s, %u thread(s), max %u connections, %zu bytes per connection%s\n",
+           serverModeName(mode), threads, maxConnections, connectionMemory, tlsServerEnabled() ? ", HTTPS" : "");
+    selfStatsSetConnectionLimit(maxConnections);
+    
+    return MHD_start_daemon(flags,
+                            (uint16_t)port,
+                            NULL, NULL,
+                            &requestHandler, NULL,
+                            MHD_OPTION_THREAD_POOL_SIZE, (unsigned int)(threads > 1 ? threads : 0),
+                            MHD_OPTION_CONNECTION_LIMIT, maxConnections,
+                            MHD_OPTION_PER_IP_CONNECTION_LIMIT, perIpConnections,
+                            MHD_OPTION_CONNECTION_MEMORY_LIMIT, connectionMemory,
+                            MHD_OPTION_CONNECTION_TIMEOUT, connectionTimeout,
+                            MHD_OPTION_THREAD_STACK_SIZE, (size_t)SERVER_THREAD_STACK,
+                            MHD_OPTION_NOTIFY_COMPLETED, &requestCompleted, NULL,
+                            MHD_OPTION_NOTIFY_CONNECTION, &connectionNotify, NULL,
+                            MHD_OPTION_ARRAY, tlsServerDaemonOptions(),
+                            MHD_OPTION_END);
+}
+
+// Discover the sensors, attach the store if one is configured, then start
+// the rollups and the sampler in that order so no sweep is missed
+static bool startHardwareMonitor(uint32_t intervalMs, uint32_t budget, const char *storePath) {
+    HwmStoreRegion regions[2];
+    void *historyStorage = NULL;
+    bool restored = false;
+    
+    if (!hwmInit()) {
+        return false;
+    }
+    if (storePath) {
+        regions[0].name = "samples";
+        regions[0].bytes = sizeof(HwmRingStore);
+        regions[1].name = "rollups";
+        regions[1].bytes = hwmHistoryStorageBytes();
+        if (hwmStoreOpen(storePath, hwmCapabilities()->mask, regions, 2, &restored)) {
+            hwmAttachStore(regions[0].base, restored);
+            historyStorage = regions[1].base;
+        } else {
+            printf("Warning: HWM history will not survive a restart\n");
+        }
+    }
+    if (!hwmHistoryStart(historyStorage)) {
+        printf("Warning: hardware monitor history not available\n");
+    }
+    if (!hwmExportStart()) {
+        printf("Warning: compressed hardware monitor export not available\n");
+    }
+    return hwmStart(intervalMs, budget);
+}
+
+int main(int argc, char* argv[]) {
+    int port = DEFAULT_PORT;
+    ServerMode serverMode = DEFAULT_SERVER_MODE;
+    unsigned int serverThreads = DEFAULT_SERVER_THREADS;
+    unsigned int maxConnections = DEFAULT_MAX_CONNECTIONS;
+    unsigned int perIpConnections = DEFAULT_PER_IP_CONNECTIONS;
+    size_t connectionMemory = DEFAULT_CONNECTION_MEMORY;
+    unsigned int connectionTimeout = DEFAULT_CONNECTION_TIMEOUT;
+    uint32_t metricsInterval = DEFAULT_METRICS_INTERVAL_MS;
+    AccessLogConfig logConfig = { LOG_LEVEL_INFO, LOG_FORMAT_TEXT, 1 };
+    uint32_t autoFeedInterval = 0;
+    int watchdogIdArg = -1;
+    const char *controlSocketPath = NULL;
+    const char *sessionLockPath = SUSI_SESSION_DEFAULT_LOCK;
+    int sessionLock;
+    pid_t sessionOwner;
+    unsigned int controlSocketMode = DEFAULT_CONTROL_SOCKET_MODE;
+    const char *configPath = NULL;
+    const char *tlsCertPath = NULL;
+    const char *tlsKeyPath = NULL;
+    const char *tlsPriorities = NULL;
+    const char *pretimeoutDumpPath = NULL;
+    uint32_t hwmInterval = HWM_DEFAULT_INTERVAL_MS;
+    uint32_t hwmBudget = HWM_DEFAULT_BUDGET;
+    const char *hwmStorePath = NULL;
+    uint32_t busScanTtl = BUS_SCAN_DEFAULT_TTL_S;
+    bool pciDiag = false;
+    uint32_t boardRefresh = BOARD_INFO_DEFAULT_REFRESH_S;
+    uint32_t wakeWindow = RTC_WAKE_DEFAULT_WINDOW_S;
+    uint32_t fleetInterval = FLEET_DEFAULT_INTERVAL_MS;
+    int kvArea = -1, kvOffset = 0, kvLength = 0;
+    ServiceConfig baseConfig;
+    const ServiceConfig *config;
+    
+    // Parse command line arguments
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0 || strcmp(argv[i], "-p") == 0) {
+            if (i + 1 < argc) {
+                port = atoi(argv[i + 1]);
+                if (port <= 0 || port > 65535) {
+                    port = DEFAULT_PORT;
+                }
+                i++; // Skip the port number in the next iteration
+            }
+        }
+        else if (strcmp(argv[i], "--mode") == 0 || strcmp(argv[i], "-m") == 0) {
+            if (i + 1 < argc) {
+                if (!parseServerMode(argv[i + 1], &serverMode)) {
+                    printf("Unknown server mode '%s' (expected thread, select, poll or epoll)\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--threads") == 0 || strcmp(argv[i], "-t") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                serverThreads = (value > 0) ? (unsigned int)value : DEFAULT_SERVER_THREADS;
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--max-connections") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                maxConnections = (value > 0) ? (unsigned int)value : DEFAULT_MAX_CONNECTIONS;
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--per-ip-connections") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                perIpConnections = (value > 0) ? (unsigned int)value : DEFAULT_PER_IP_CONNECTIONS;
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--connection-memory") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                // MHD needs room for the request headers and its own bookkeeping
+                connectionMemory = (value >= 4096) ? (size_t)value : DEFAULT_CONNECTION_MEMORY;
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--tls-cert") == 0) {
+            if (i + 1 < argc) {
+                tlsCertPath = argv[i + 1];
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--tls-key") == 0) {
+            if (i + 1 < argc) {
+                tlsKeyPath = argv[i + 1];
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--tls-priorities") == 0) {
+            if (i + 1 < argc) {
+                tlsPriorities = argv[i + 1];
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--connection-timeout") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                connectionTimeout = (value >= 0) ? (unsigned int)value : DEFAULT_CONNECTION_TIMEOUT;
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--metrics-interval") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                metricsInterval = (value > 0) ? (uint32_t)value : DEFAULT_METRICS_INTERVAL_MS;
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--log-level") == 0) {
+            if (i + 1 < argc) {
+                if (!parseLogLevel(argv[i + 1], &logConfig.level)) {
+                    printf("Unknown log level '%s' (expected off, error, warn, info or debug)\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--log-format") == 0) {
+            if (i + 1 < argc) {
+                if (!parseLogFormat(argv[i + 1], &logConfig.format)) {
+                    printf("Unknown log format '%s' (expected text or json)\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--log-sample") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                logConfig.sampleRate = (value > 0) ? (uint32_t)value : 1;
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--auto-feed") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                autoFeedInterval = (value > 0) ? (uint32_t)value : 0;
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--auto-feed-heartbeat") == 0) {
+            if (i + 1 < argc) {
+                // PATH:MAX_AGE_MS - feed only while PATH was touched recently
+                char *spec = argv[i + 1];
+                char *colon = strrchr(spec, ':');
+                int maxAge = colon ? atoi(colon + 1) : 0;
+                if (colon == NULL || maxAge <= 0) {
+                    printf("Invalid heartbeat '%s' (expected PATH:MAX_AGE_MS)\n", spec);
+                    return 1;
+                }
+                *colon = '\0';
+                if (!feederAddHeartbeatFile(spec, (uint32_t)maxAge)) {
+                    printf("Too many heartbeat files\n");
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--auto-feed-process") == 0) {
+            if (i + 1 < argc) {
+                if (!healthCheckAddProcess(argv[i + 1])) {
+                    printf("Invalid process check '%s' (expected NAME[:MS] or /PIDFILE[:MS])\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--auto-feed-disk") == 0) {
+            if (i + 1 < argc) {
+                if (!healthCheckAddDisk(argv[i + 1])) {
+                    printf("Invalid disk check '%s' (expected DIR[:MS])\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--auto-feed-tcp") == 0) {
+            if (i + 1 < argc) {
+                if (!healthCheckAddTcp(argv[i + 1])) {
+                    printf("Invalid TCP check '%s' (expected HOST:PORT[:MS])\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--cuse-watchdog") == 0) {
+            if (i + 1 < argc) {
+                if (!cuseWatchdogSetName(argv[i + 1])) {
+                    printf("Invalid device name '%s'\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--systemd-unit") == 0) {
+            if (i + 1 < argc) {
+                if (!systemdBridgeAddUnit(argv[i + 1])) {
+                    printf("Invalid systemd unit '%s'\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--control-socket") == 0) {
+            if (i + 1 < argc) {
+                controlSocketPath = argv[i + 1];
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--session-lock") == 0) {
+            if (i + 1 < argc) {
+                sessionLockPath = strcmp(argv[i + 1], "off") == 0 ? NULL : argv[i + 1];
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--control-socket-mode") == 0) {
+            if (i + 1 < argc) {
+                controlSocketMode = (unsigned int)strtoul(argv[i + 1], NULL, 8);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--watchdog-id") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                if (value < 0 || value >= WATCHDOG_MAX_DEVICES) {
+                    printf("Invalid watchdog id '%s' (expected 0-%d)\n", argv[i + 1], WATCHDOG_MAX_DEVICES - 1);
+                    return 1;
+                }
+                watchdogIdArg = value;
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--pretimeout-dump") == 0) {
+            if (i + 1 < argc) {
+                pretimeoutDumpPath = argv[i + 1];
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--hwm-interval") == 0) {
+            if (i + 1 < argc) {
+                hwmInterval = (uint32_t)atoi(argv[i + 1]);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--hwm-budget") == 0) {
+            if (i + 1 < argc) {
+                hwmBudget = (uint32_t)atoi(argv[i + 1]);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--hwm-deadband") == 0) {
+            if (i + 1 < argc) {
+                // KIND:ABSOLUTE:RELATIVE:MAX_SILENCE_MS, values in the kind's unit
+                char kindName[16];
+                HwmDeadband deadband;
+                HwmKind kind;
+                if (sscanf(argv[i + 1], "%15[^:]:%lf:%lf:%u", kindName, &deadband.absolute,
+                           &deadband.relative, &deadband.maxSilenceMs) != 4 ||
+                    !hwmKindFromName(kindName, &kind) || deadband.absolute < 0 || deadband.relative < 0) {
+                    printf("Invalid deadband '%s' (expected KIND:ABSOLUTE:RELATIVE:MAX_SILENCE_MS)\n", argv[i + 1]);
+                    return 1;
+                }
+                hwmSetDeadband(kind, &deadband);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--gateway") == 0) {
+            gatewayMode = true;
+        }
+        else if (strcmp(argv[i], "--fleet-board") == 0) {
+            if (i + 1 < argc) {
+                if (!fleetAddBoard(argv[i + 1])) {
+                    printf("Invalid fleet board '%s' (expected [NAME=]HOST[:PORT], names unique)\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--fleet-boards") == 0) {
+            if (i + 1 < argc) {
+                if (!fleetLoadBoards(argv[i + 1])) {
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--fleet-interval") == 0) {
+            if (i + 1 < argc) {
+                fleetInterval = (uint32_t)atoi(argv[i + 1]);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--rate-limit") == 0 || strcmp(argv[i], "--rate-limit-global") == 0) {
+            if (i + 1 < argc) {
+                // RATE[:BURST] write requests per second, 0 turns the limit off
+                RateLimitScope scope = argv[i][12] == '\0' ? RATE_LIMIT_CLIENT : RATE_LIMIT_GLOBAL;
+                unsigned int rate;
+                unsigned int burst = 0;
+                if (sscanf(argv[i + 1], "%u:%u", &rate, &burst) < 1 || !rateLimitConfigure(scope, rate, burst)) {
+                    printf("Invalid rate limit '%s' (expected RATE[:BURST])\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--compression-level") == 0) {
+            if (i + 1 < argc) {
+                char *end;
+                long level = strtol(argv[i + 1], &end, 10);
+                if (*end != '\0' || !contentEncodingConfigure((int)level)) {
+                    printf("Invalid compression level '%s' (expected 0-9)\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--susi-breaker") == 0) {
+            if (i + 1 < argc) {
+                // FAILURES[:BACKOFF_MS], 0 turns the breakers off
+                unsigned int failures;
+                unsigned int backoffMs = SUSI_BREAKER_DEFAULT_BACKOFF_MS;
+                int fields = sscanf(argv[i + 1], "%u:%u", &failures, &backoffMs);
+                if (fields < 1 || !susiBreakerConfigure(failures, backoffMs)) {
+                    printf("Invalid breaker '%s' (expected FAILURES[:BACKOFF_MS], backoff 1-%d ms)\n", argv[i + 1],
+                           SUSI_BREAKER_MAX_BACKOFF_MS);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--realtime") == 0) {
+            if (i + 1 < argc) {
+                // PRIORITY[:CPU] for the feeder and hardware threads
+                int priority;
+                int cpu = REALTIME_NO_CPU;
+                int fields = sscanf(argv[i + 1], "%d:%d", &priority, &cpu);
+                if (fields < 1 || !realtimeConfigure(priority, cpu)) {
+                    printf("Invalid real-time profile '%s' (expected PRIORITY[:CPU], priority 1-99)\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--near-miss-fraction") == 0) {
+            if (i + 1 < argc) {
+                char *end;
+                double fraction = strtod(argv[i + 1], &end);
+                if (end == argv[i + 1] || *end != '\0' || !watchdogSetNearMissFraction(fraction)) {
+                    printf("Invalid near-miss fraction '%s' (expected 0-1)\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--feed-jitter-window") == 0) {
+            if (i + 1 < argc) {
+                char *end;
+                unsigned long seconds = strtoul(argv[i + 1], &end, 10);
+                if (end == argv[i + 1] || *end != '\0' || seconds > 86400 || !watchdogSetJitterWindow((uint32_t)seconds)) {
+                    printf("Invalid jitter window '%s' (expected 1-86400 seconds)\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--gpio-irq") == 0) {
+            if (i + 1 < argc) {
+                // PIN[:rising|falling][:DEBOUNCE_MS], rising and no debounce by default
+                char *spec = argv[i + 1];
+                GpioEdge edge = GPIO_EDGE_RISING;
+                double debounceMs = 0;
+                char *end;
+                unsigned long pin = strtoul(spec, &end, 10);
+                bool valid = end != spec;
+                if (valid && *end == ':') {
+                    char *field = end + 1;
+                    size_t length = strcspn(field, ":");
+                    if (length == 6 && strncmp(field, "rising", 6) == 0) {
+                        end = field + length;
+                    } else if (length == 7 && strncmp(field, "falling", 7) == 0) {
+                        edge = GPIO_EDGE_FALLING;
+                        end = field + length;
+                    }
+                    if (*end == ':') {
+                        field = end + 1;
+                        debounceMs = strtod(field, &end);
+                        valid = end != field && debounceMs >= 0 && debounceMs <= 10000;
+                    }
+                }
+                if (!valid || *end != '\0') {
+                    printf("Invalid GPIO interrupt '%s' (expected PIN[:rising|falling][:DEBOUNCE_MS])\n", spec);
+                    return 1;
+                }
+                if (!gpioEventsAddPin((uint32_t)pin, edge, (uint32_t)(debounceMs * 1000.0 + 0.5))) {
+                    printf("Too many GPIO interrupts\n");
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--webhook") == 0) {
+            if (i + 1 < argc) {
+                if (!webhookAdd(argv[i + 1])) {
+                    printf("Invalid or too many webhooks '%s' (expected http://host[:port][/path])\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--mqtt") == 0) {
+            if (i + 1 < argc) {
+                if (!mqttBridgeSetBroker(argv[i + 1])) {
+                    printf("Invalid MQTT broker '%s' (expected HOST[:PORT])\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--mqtt-topic") == 0) {
+            if (i + 1 < argc) {
+                if (!mqttBridgeSetTopic(argv[i + 1])) {
+                    printf("Invalid MQTT topic '%s' (no wildcards)\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--mqtt-batch") == 0) {
+            if (i + 1 < argc) {
+                unsigned int ms, bytes = MQTT_DEFAULT_BATCH_BYTES;
+                char extra;
+                int fields = sscanf(argv[i + 1], "%u:%u%c", &ms, &bytes, &extra);
+                if ((fields != 1 && fields != 2) || !mqttBridgeSetBatch(ms, bytes)) {
+                    printf("Invalid MQTT batch '%s' (expected MS[:BYTES], BYTES 1024-%d)\n", argv[i + 1], MQTT_MAX_BATCH_BYTES);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--mqtt-window") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                if (value <= 0 || !mqttBridgeSetWindow((uint32_t)value)) {
+                    printf("Invalid MQTT window '%s' (1-%d)\n", argv[i + 1], MQTT_MAX_WINDOW);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--mqtt-cbor") == 0) {
+            mqttBridgeSetCbor(true);
+        }
+        else if (strcmp(argv[i], "--mqtt-spool") == 0) {
+            if (i + 1 < argc) {
+                mqttBridgeSetSpool(argv[i + 1]);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--shm") == 0) {
+            if (i + 1 < argc) {
+                if (!shmTelemetrySetName(argv[i + 1])) {
+                    printf("Invalid shared-memory name '%s' (expected /NAME)\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--shm-interval") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                if (value <= 0 || !shmTelemetrySetInterval((uint32_t)value)) {
+                    printf("Invalid shared-memory interval '%s'\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--hw-weights") == 0) {
+            if (i + 1 < argc) {
+                // READ:USER share of the hardware thread between telemetry and client bus traffic
+                unsigned int readWeight, userWeight;
+                char extra;
+                if (sscanf(argv[i + 1], "%u:%u%c", &readWeight, &userWeight, &extra) != 2 ||
+                    !hwActorSetWeight(HW_LANE_READ, readWeight) || !hwActorSetWeight(HW_LANE_USER, userWeight)) {
+                    printf("Invalid hardware lane weights '%s' (expected READ:USER, both at least 1)\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--scheduler-workers") == 0) {
+            if (i + 1 < argc) {
+                char *end;
+                long value = strtol(argv[i + 1], &end, 10);
+
+                if (end == argv[i + 1] || *end != '\0' || !schedulerSetWorkers((int)value)) {
+                    printf("Invalid scheduler workers '%s' (expected 1-%d)\n", argv[i + 1], SCHEDULER_MAX_WORKERS);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--trace") == 0) {
+            if (i + 1 < argc) {
+                if (strcmp(argv[i + 1], "on") != 0 && strcmp(argv[i + 1], "off") != 0) {
+                    printf("Invalid trace '%s' (expected on or off)\n", argv[i + 1]);
+                    return 1;
+                }
+                spanTraceSetEnabled(strcmp(argv[i + 1], "on") == 0);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--kv-store") == 0) {
+            if (i + 1 < argc) {
+                // ID:OFFSET:LENGTH region of a storage area, split into two log segments
+                char extra;
+                if (sscanf(argv[i + 1], "%i:%i:%i%c", &kvArea, &kvOffset, &kvLength, &extra) != 3 ||
+                    kvArea < 0 || kvArea >= STORAGE_AREA_MAX || kvOffset < 0 || kvLength <= 0) {
+                    printf("Invalid key-value store region '%s' (expected ID:OFFSET:LENGTH)\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--fan-loop") == 0) {
+            if (i + 1 < argc) {
+                if (!fanControlAddSpec(argv[i + 1])) {
+                    printf("Invalid or duplicate fan loop '%s' (expected FAN:TEMP:pid:SETPOINT[:KP:KI:KD[:MIN:MAX]],\n"
+                           "FAN:TEMP:hyst:LOW:HIGH:LOW_DUTY:HIGH_DUTY or FAN:TEMP:curve:DEG=DUTY,DEG=DUTY[,...])\n",
+                           argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--alert-rule") == 0) {
+            if (i + 1 < argc) {
+                if (!alertRulesAdd(argv[i + 1])) {
+                    printf("Invalid or duplicate alert rule '%s' (expected NAME: SENSOR OP VALUE [for DURATION] [and|or ...],\n"
+                           "up to %d rules and %d comparisons)\n", argv[i + 1], ALERT_MAX_RULES, ALERT_MAX_COMPARISONS);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--alert-rules") == 0) {
+            if (i + 1 < argc) {
+                if (!alertRulesLoad(argv[i + 1])) {
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--thermal-horizon") == 0) {
+            if (i + 1 < argc) {
+                thermalMonitorSetHorizon((uint32_t)atoi(argv[i + 1]));
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--backlight-rate") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                backlightSetRate(value > 0 ? (uint32_t)value : 0);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--i2c-cache") == 0) {
+            if (i + 1 < argc) {
+                if (!i2cCacheAddSpec(argv[i + 1])) {
+                    printf("Invalid or too many I2C caches '%s' (expected BUS:ADDR:FIRST[-LAST][,...])\n", argv[i + 1]);
+                    return 1;
+                }
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--pic-interval") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                picTelemetrySetInterval(value > 0 ? (uint32_t)value : 0);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--battery-interval") == 0) {
+            if (i + 1 < argc) {
+                int fast = 0, slow = BATTERY_DEFAULT_SLOW_MS;
+                
+                sscanf(argv[i + 1], "%d:%d", &fast, &slow);
+                batteryMonitorSetIntervals(fast > 0 ? (uint32_t)fast : 0, slow > 0 ? (uint32_t)slow : 0);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--battery-smoothing") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                batteryMonitorSetSmoothing(value > 0 ? (uint32_t)value : 0);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--battery-alarm") == 0) {
+            if (i + 1 < argc) {
+                int low = 0, critical = BATTERY_DEFAULT_CRITICAL_MIN;
+                
+                sscanf(argv[i + 1], "%d:%d", &low, &critical);
+                batteryMonitorSetAlarm(low > 0 ? (uint32_t)low : 0, critical > 0 ? (uint32_t)critical : 0);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--sab2000-interval") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                sab2000AlertsSetInterval(value > 0 ? (uint32_t)value : 0);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--poe-interval") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                poeMonitorSetInterval(value > 0 ? (uint32_t)value : 0);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--poe-budget") == 0) {
+            if (i + 1 < argc) {
+                double watts = atof(argv[i + 1]);
+                poeMonitorSetBudget(watts > 0 ? (uint32_t)(watts * 1000.0 + 0.5) : 0);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--poe-energy-rate") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                poeEnergySetRate(value > 0 ? (uint32_t)value : 0);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--poe-energy-persist") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                poeEnergySetPersist(value > 0 ? (uint32_t)value : 0);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--ignition-watch") == 0) {
+            if (i + 1 < argc) {
+                // POLL_MS[:DEBOUNCE_MS][:shutdown]
+                char *spec = argv[i + 1];
+                unsigned long debounceMs = PIC_IGNITION_DEFAULT_DEBOUNCE_MS;
+                bool shutdown = false;
+                char *end;
+                unsigned long pollMs = strtoul(spec, &end, 10);
+                bool valid = end != spec && pollMs <= 10000;
+                if (valid && *end == ':' && end[1] >= '0' && end[1] <= '9') {
+                    char *field = end + 1;
+                    debounceMs = strtoul(field, &end, 10);
+                    valid = debounceMs <= 60000;
+                }
+                if (valid && strcmp(end, ":shutdown") == 0) {
+                    shutdown = true;
+                    end += strlen(end);
+                }
+                if (!valid || *end != '\0') {
+                    printf("Invalid ignition watch '%s' (expected POLL_MS[:DEBOUNCE_MS][:shutdown])\n", spec);
+                    return 1;
+                }
+                picIgnitionWatch((uint32_t)pollMs, (uint32_t)debounceMs, shutdown);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--memory-cache") == 0) {
+            if (i + 1 < argc) {
+                memoryInventorySetCache(argv[i + 1]);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--iot") == 0) {
+            susiIotEnable(SUSI_IOT_DEFAULT_MAX_AGE_MS);
+        }
+        else if (strcmp(argv[i], "--iot-max-age") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                susiIotEnable(value >= 0 ? (uint32_t)value : SUSI_IOT_DEFAULT_MAX_AGE_MS);
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--board-refresh") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                boardRefresh = (value > 0) ? (uint32_t)value : 0;
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--wake-window") == 0) {
+            if (i + 1 < argc) {
+                char *end;
+                unsigned long value = strtoul(argv[i + 1], &end, 10);
+
+                if (end == argv[i + 1] || *end != '\0' || value > RTC_WAKE_MAX_WINDOW_S) {
+                    printf("Invalid wake window '%s' (expected 0-%d seconds)\n", argv[i + 1], RTC_WAKE_MAX_WINDOW_S);
+                    return 1;
+                }
+                wakeWindow = (uint32_t)value;
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--bus-scan-ttl") == 0) {
+            if (i + 1 < argc) {
+                int value = atoi(argv[i + 1]);
+                busScanTtl = (value > 0) ? (uint32_t)value : 0;
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--pci-diag") == 0) {
+            pciDiag = true;
+        }
+        else if (strcmp(argv[i], "--hwm-store") == 0) {
+            if (i + 1 < argc) {
+                hwmStorePath = argv[i + 1];
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--config") == 0 || strcmp(argv[i], "-c") == 0) {
+            if (i + 1 < argc) {
+                configPath = argv[i + 1];
+                i++;
+            }
+        }
+        else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            printf("Watchdog HTTP Service\n");
+            printf("Usage: %s [options]\n", argv[0]);
+            printf("Options:\n");
+            printf("  --port, -p PORT            Specify the HTTP server port (default: %d)\n", DEFAULT_PORT);
+            printf("  --mode, -m MODE            Server mode: thread, select, poll or epoll (default: %s)\n",
+                   serverModeName(DEFAULT_SERVER_MODE));
+            printf("  --threads, -t N            Polling threads for select/poll/epoll (default: %s)\n",
+                   DEFAULT_SERVER_THREADS == 0 ? "one per core" : "one");
+            printf("  --max-connections N        Maximum concurrent connections (default: %d)\n", DEFAULT_MAX_CONNECTIONS);
+            printf("  --per-ip-connections N     Maximum connections per client address (default: unlimited)\n");
+            printf("  --connection-memory BYTES  Memory cap per connection (default: %d)\n", DEFAULT_CONNECTION_MEMORY);
+            printf("  --connection-timeout SEC   Idle connection timeout, 0 = never (default: %d)\n", DEFAULT_CONNECTION_TIMEOUT);
+            printf("  --tls-cert PATH            Serve HTTPS with this PEM certificate chain (needs --tls-key, make TLS=1)\n");
+            printf("  --tls-key PATH             PEM private key for --tls-cert\n");
+            printf("  --tls-priorities STRING    GnuTLS priority string (default: %s)\n", TLS_DEFAULT_PRIORITIES);
+            printf("  --metrics-interval MS      /metrics snapshot refresh interval (default: %d)\n", DEFAULT_METRICS_INTERVAL_MS);
+            printf("  --log-level LEVEL          Access log level: off, error, warn, info, debug (default: info)\n");
+            printf("  --log-format FORMAT        Access log format: text or json (default: text)\n");
+            printf("  --log-sample N             Log 1 in N requests (default: 1)\n");
+            printf("  --auto-feed MS             Feed the watchdog internally every MS milliseconds\n");
+            printf("  --auto-feed-heartbeat P:MS Only auto-feed while file P was modified within MS\n");
+            printf("  --auto-feed-process SPEC   Only auto-feed while process NAME or /PIDFILE is alive ([:MS] timeout)\n");
+            printf("  --auto-feed-disk DIR[:MS]  Only auto-feed while DIR accepts a synced write\n");
+            printf("  --auto-feed-tcp H:P[:MS]   Only auto-feed while H:P accepts TCP connections\n");
+            printf("  --realtime PRIO[:CPU]      Run the feeder and hardware threads SCHED_FIFO PRIO (pinned to CPU), memory locked\n");
+            printf("  --near-miss-fraction F     Count feeds with less than F of the event time left as near misses (default %.2f)\n",
+                   WATCHDOG_DEFAULT_NEAR_MISS_FRACTION);
+            printf("  --feed-jitter-window SEC   Window for the maximum feed jitter (default %d)\n", WATCHDOG_DEFAULT_JITTER_WINDOW_S);
+            printf("  --cuse-watchdog NAME       Serve the Linux watchdog API as /dev/NAME through CUSE\n");
+            printf("  --systemd-unit UNIT        Only auto-feed while systemd reports UNIT active (repeatable)\n");
+            printf("  --control-socket PATH      Binary feed/status socket (AF_UNIX, SOCK_SEQPACKET)\n");
+            printf("  --control-socket-mode MODE Permissions of the control socket (default: %o)\n", DEFAULT_CONTROL_SOCKET_MODE);
+            printf("  --session-lock PATH|off    Lock that makes this the only SUSI user on the board (default: %s)\n", SUSI_SESSION_DEFAULT_LOCK);
+            printf("  --watchdog-id N            Timer served by the /api/* routes (default: first present)\n");
+            printf("  --pretimeout-dump PATH     Write a state dump to PATH when a timer reaches its event stage\n");
+            printf("  --hwm-interval MS          Hardware monitor sampling interval, 0 = off (default: %d)\n", HWM_DEFAULT_INTERVAL_MS);
+            printf("  --hwm-budget N             Sensor reads per second the monitor may issue, 0 = unlimited (default: %d)\n", HWM_DEFAULT_BUDGET);
+            printf("  --hwm-deadband SPEC        KIND:ABSOLUTE:RELATIVE:MAX_SILENCE_MS change filter for /api/events\n");
+            printf("  --gateway                  Only scrape the fleet boards and serve /api/fleet, without SUSI\n");
+            printf("  --fleet-board [NAME=]HOST[:PORT] Scrape another board's service (up to %d, default port %d)\n",
+                   FLEET_MAX_BOARDS, FLEET_DEFAULT_PORT);
+            printf("  --fleet-boards PATH        Read fleet boards from PATH, one per line\n");
+            printf("  --fleet-interval MS        Time between fleet scrape rounds (default: %d)\n", FLEET_DEFAULT_INTERVAL_MS);
+            printf("  --rate-limit RATE[:BURST]  Write requests per second per client address, 0 = off (default: %d:%d)\n",
+                   RATE_LIMIT_DEFAULT_CLIENT_RATE, RATE_LIMIT_DEFAULT_CLIENT_BURST);
+            printf("  --rate-limit-global RATE[:BURST] Write requests per second across all clients (default: %d:%d)\n",
+                   RATE_LIMIT_DEFAULT_GLOBAL_RATE, RATE_LIMIT_DEFAULT_GLOBAL_BURST);
+            printf("  --compression-level N      Compress large cached responses for clients that accept it, 1-9,\n");
+            printf("                             0 = off (default: %d)\n", CONTENT_ENCODING_DEFAULT_LEVEL);
+            printf("  --susi-breaker N[:MS]      Serve last good values after N failed reads of an ID, probing after MS\n");
+            printf("                             (doubling up to %d), 0 = off (default: %d:%d)\n", SUSI_BREAKER_MAX_BACKOFF_MS,
+                   SUSI_BREAKER_DEFAULT_THRESHOLD, SUSI_BREAKER_DEFAULT_BACKOFF_MS);
+            printf("  --gpio-irq PIN[:EDGE][:MS] Publish interrupts of GPIO PIN, EDGE rising (default) or falling,\n");
+            printf("                             ignoring edges less than MS after the last one\n");
+            printf("  --webhook URL              POST GPIO events as JSON to an http:// URL (up to %d)\n", WEBHOOK_MAX_TARGETS);
+            printf("  --mqtt HOST[:PORT]         Publish /api/events batches to an MQTT broker at QoS 1 (default port %d)\n", MQTT_DEFAULT_PORT);
+            printf("  --mqtt-topic TOPIC         MQTT topic (default: watchdog/<hostname>/events)\n");
+            printf("  --mqtt-batch MS[:BYTES]    Close a batch after MS or at BYTES (default: %d:%d)\n", MQTT_DEFAULT_INTERVAL_MS, MQTT_DEFAULT_BATCH_BYTES);
+            printf("  --mqtt-window N            Batches awaiting PUBACK at a time (default: %d)\n", MQTT_DEFAULT_WINDOW);
+            printf("  --mqtt-cbor                Encode MQTT batches as CBOR instead of JSON\n");
+            printf("  --mqtt-spool FILE          Keep batches the broker has not taken in FILE, replayed on reconnect\n");
+            printf("  --shm /NAME                Publish HWM, GPIO and watchdog state in /dev/shm/NAME (layout: watchdog_shm.h)\n");
+            printf("  --shm-interval MS          GPIO and watchdog refresh of the --shm segment (default: %d)\n", SHM_TELEMETRY_DEFAULT_INTERVAL_MS);
+            printf("  --hwm-store PATH           Keep HWM samples and rollups in PATH across restarts\n");
+            printf("  --bus-scan-ttl SEC         Rescan SMBus/I2C hosts when the map is this old, 0 = off (default: %d)\n", BUS_SCAN_DEFAULT_TTL_S);
+            printf("  --pci-diag                 Enumerate PCI at startup and serve /api/diag config-space and MSR dumps\n");
+            printf("  --hw-weights READ:USER     Hardware thread share of telemetry vs. client SMBus/I2C traffic (default: %d:%d)\n",
+                   HW_ACTOR_DEFAULT_READ_WEIGHT, HW_ACTOR_DEFAULT_USER_WEIGHT);
+            printf("  --scheduler-workers N      Threads running the periodic pollers, one kept for high priority (default: %d)\n",
+                   SCHEDULER_DEFAULT_WORKERS);
+            printf("  --trace on|off             Record request, hardware and SUSI spans for /api/trace (default: on)\n");
+            printf("  --i2c-cache BUS:ADDR:REGS  Cache the non-volatile registers REGS (e.g. 0x01-0x03,0x10) of an I2C device\n");
+            printf("  --kv-store ID:OFFSET:LEN   Keep the /api/kv store in LEN bytes from OFFSET of storage area ID\n");
+            printf("  --fan-loop SPEC            Drive fan FAN from temperature TEMP in software (repeatable):\n");
+            printf("                             FAN:TEMP:pid:SETPOINT[:KP:KI:KD[:MIN:MAX]] (default gains %.1f:%.1f:%.1f, duty %d-%d%%)\n",
+                   FAN_CONTROL_DEFAULT_KP, FAN_CONTROL_DEFAULT_KI, FAN_CONTROL_DEFAULT_KD,
+                   FAN_CONTROL_DEFAULT_MIN_DUTY, FAN_CONTROL_DEFAULT_MAX_DUTY);
+            printf("                             FAN:TEMP:hyst:LOW:HIGH:LOW_DUTY:HIGH_DUTY\n");
+            printf("                             FAN:TEMP:curve:DEG=DUTY,DEG=DUTY[,...] (up to %d points, whole degrees)\n",
+                   FAN_CURVE_MAX_POINTS);
+            printf("  --thermal-horizon SEC      Warn this long before a thermal protection trip is forecast, 0 = off (default: %d)\n",
+                   THERMAL_DEFAULT_HORIZON_S);
+            printf("  --alert-rule 'NAME: EXPR'  Raise an alert event while EXPR holds (repeatable, up to %d), e.g.\n"
+                   "                             'hot: temperature0 > 90 for 30s and fan0 < 1000'\n", ALERT_MAX_RULES);
+            printf("  --alert-rules PATH         Read alert rules from PATH, one per line\n");
+            printf("  --backlight-rate HZ        Most brightness writes per panel per second, 0 = off (default: %d, max %d)\n",
+                   BACKLIGHT_DEFAULT_RATE_HZ, BACKLIGHT_MAX_RATE_HZ);
+            printf("  --board-refresh SEC        Re-read the boot counter and running time meter, 0 = once (default: %d)\n",
+                   BOARD_INFO_DEFAULT_REFRESH_S);
+            printf("  --wake-window SEC          Spread PUT /api/wake boots over SEC, at a per-board offset from the serial (default: %d)\n",
+                   RTC_WAKE_DEFAULT_WINDOW_S);
+            printf("  --memory-cache FILE        Keep the decoded SPD inventory across reboots (default: none)\n");
+            printf("  --iot                      Load SusiIoT and serve its data model under /api/iot\n");
+            printf("  --iot-max-age MS           Reuse IoT data for up to MS, 0 = until it changes (implies --iot, default: %d)\n",
+                   SUSI_IOT_DEFAULT_MAX_AGE_MS);
+            printf("  --pic-interval MS          Read the vehicle power controller (PIC), 0 = off (default: %d)\n",
+                   PIC_DEFAULT_INTERVAL_MS);
+            printf("  --ignition-watch SPEC      POLL_MS[:DEBOUNCE_MS][:shutdown]: follow the PIC ignition level, shut down\n");
+            printf("                             on ignition off with :shutdown (default debounce: %d)\n",
+                   PIC_IGNITION_DEFAULT_DEBOUNCE_MS);
+            printf("  --sab2000-interval MS      Poll the SAB2000 alert and LED status, 0 = off (default: %d)\n", SAB2000_DEFAULT_INTERVAL_MS);
+            printf("  --poe-interval MS          Snapshot the PoE ports, 0 = off (default: %d)\n", POE_DEFAULT_INTERVAL_MS);
+            printf("  --poe-budget W             Power the PoE ports may draw together, 0 = no budget (default: 0)\n");
+            printf("  --poe-energy-rate HZ       Integrate PoE port energy from V*I samples, 0 = off (default: %d, max %d)\n",
+                   POE_ENERGY_DEFAULT_RATE_HZ, POE_ENERGY_MAX_RATE_HZ);
+            printf("  --poe-energy-persist SEC   Save the energy counters to the key-value store, 0 = at shutdown only (default: %d)\n",
+                   POE_ENERGY_DEFAULT_PERSIST_S);
+            printf("  --config, -c PATH          Settings file, reloaded when it changes\n");
+            printf("  --help, -h                 Show this help message\n");
+            return 0;
+        }
+    }
+    
+    // The command line is the base; keys in the config file override it
+    baseConfig.port = port;
+    baseConfig.watchdogId = watchdogIdArg;
+    baseConfig.delayTime = DEFAULT_DELAY_TIME;
+    baseConfig.eventTime = DEFAULT_EVENT_TIME;
+    baseConfig.resetTime = DEFAULT_RESET_TIME;
+    baseConfig.eventType = DEFAULT_EVENT_TYPE;
+    baseConfig.logLevel = logConfig.level;
+    baseConfig.logSample = logConfig.sampleRate;
+    baseConfig.generation = 0;
+    if (!serviceConfigInit(&baseConfig, configPath)) {
+        return 1;
+    }
+    config = serviceConfigAcquire();
+    port = config->port;
+    logConfig.level = config->logLevel;
+    logConfig.sampleRate = config->logSample;
+    serviceConfigRelease(config);
+    
+    // Certificate and key are read before anything starts, so a bad path fails fast
+    if ((tlsCertPath != NULL || tlsKeyPath != NULL || tlsPriorities != NULL) &&
+        !tlsServerConfigure(tlsCertPath, tlsKeyPath, tlsPriorities)) {
+        return 1;
+    }
+    
+#ifdef WATCHDOG_THREAD_STACK
+    // Small profile: bounded stacks and one malloc arena for every thread to come
+    {
+        pthread_attr_t attr;
+        
+        if (pthread_attr_init(&attr) == 0) {
+            if (pthread_attr_setstacksize(&attr, WATCHDOG_THREAD_STACK) != 0 || pthread_setattr_default_np(&attr) != 0) {
+                printf("Warning: default thread stack size not applied\n");
+            }
+            pthread_attr_destroy(&attr);
+        }
+        mallopt(M_ARENA_MAX, WATCHDOG_MALLOC_ARENAS);
+    }
+#endif
+    
+    selfStatsInit();
+    // Termination signals are read from a signalfd by the main loop; this
+    // has to happen before any thread is created
+    if (!lifecycleInit()) {
+        printf("Failed to set up signal handling. Exiting.\n");
+        return -1;
+    }
+    
+    printf("Starting Watchdog HTTP Service...\n");
+    
+    // A gateway aggregates other boards and never opens SUSI, so it can run
+    // on any host, including a board whose own service owns the driver
+    if (gatewayMode) {
+        if (fleetBoardCount() == 0) {
+            printf("--gateway needs --fleet-board or --fleet-boards. Exiting.\n");
+            return -1;
+        }
+        if (!accessLogStart(&logConfig)) {
+            printf("Warning: failed to start access logger\n");
+        }
+        lifecycleStartupStep("access_log");
+        metricsRegisterCollector(accessLogCollectMetrics, NULL);
+        metricsRegisterCollector(httpRouteCollectMetrics, NULL);
+        metricsRegisterCollector(rateLimitCollectMetrics, NULL);
+        metricsRegisterCollector(contentEncodingCollectMetrics, NULL);
+        metricsRegisterCollector(lifecycleCollectMetrics, NULL);
+        metricsRegisterCollector(responsePoolCollectMetrics, NULL);
+        metricsRegisterCollector(selfStatsCollectMetrics, NULL);
+        metricsRegisterCollector(tlsServerCollectMetrics, NULL);
+        metricsRegisterCollector(fleetCollectMetrics, NULL);
+        if (!metricsStart(metricsInterval)) {
+            printf("Failed to start metrics updater. Exiting.\n");
+            return -1;
+        }
+        lifecycleStartupStep("metrics");
+        if (!fleetStart(fleetInterval)) {
+            printf("Failed to start the fleet scraper. Exiting.\n");
+            metricsStop();
+            return -1;
+        }
+        lifecycleStartupStep("fleet");
+        http_daemon = startHttpDaemon(serverMode, port, serverThreads,
+                                      maxConnections, perIpConnections,
+                                      connectionMemory, connectionTimeout);
+        if (http_daemon == NULL) {
+            printf("Failed to start HTTP server on port %d\n", port);
+            fleetStop();
+            metricsStop();
+            return -1;
+        }
+        lifecycleStartupStep("http");
+        printf("Fleet gateway running on port %d\n", port);
+        printf("  GET  /api/fleet     - Merged view of %d boards, ?state=&running=&slack_below_ms=&sensor=&above=&below=\n",
+               fleetBoardCount());
+        printf("  GET  /metrics       - Prometheus metrics\n");
+        lifecycleStartupDone();
+        
+        lifecycleAddShutdownHook(0, "http", stopHttpServer);
+        lifecycleAddShutdownHook(0, "fleet", fleetStop);
+        lifecycleAddShutdownHook(1, "metrics", metricsStop);
+        lifecycleAddShutdownHook(1, "tls", tlsServerDestroy);
+        lifecycleAddShutdownHook(2, "access_log", accessLogStop);
+        int sig = lifecycleWait();
+        printf("Shutdown %s received. Cleaning up...\n", sig ? strsignal(sig) : "request");
+        lifecycleShutdown();
+        printf("Fleet gateway stopped.\n");
+        return 0;
+    }
+    
+    // The driver does not arbitrate between processes, so only the session
+    // owner initializes it; other tools use the control socket or the API
+    if (sessionLockPath) {
+        sessionLock = susiSessionAcquire(sessionLockPath, "watchdog_http_service", &sessionOwner);
+        if (sessionLock == -1) {
+            char owner[64];
+            susiSessionOwner(sessionLockPath, owner, sizeof(owner));
+            printf("SUSI is already in use by pid %ld (%s, %s). Exiting.\n",
+                   (long)sessionOwner, owner[0] ? owner : "unknown", sessionLockPath);
+            return -1;
+        }
+        if (sessionLock == -2) {
+            printf("Warning: session lock %s not available (%s), other SUSI users are not kept out\n",
+                   sessionLockPath, strerror(errno));
+        }
+    }
+    
+    // Initialize SUSI API
+    susiInitialized = initializeSUSI();
+    if (!susiInitialized) {
+        printf("Failed to initialize SUSI API. Exiting.\n");
+        return -1;
+    }
+    lifecycleStartupStep("susi");
+    
+    // Before the threads a feed passes through exist
+    realtimeLockMemory();
+    
+    // All hardware access from here on is serialized through one thread
+    if (!hwActorStart()) {
+        printf("Failed to start hardware thread. Exiting.\n");
+        cleanupSUSI();
+        return -1;
+    }
+    lifecycleStartupStep("hw_actor");
+    
+    if (!buildIndexPages()) {
+        printf("Failed to build index page. Exiting.\n");
+        hwActorStop();
+        cleanupSUSI();
+        return -1;
+    }
+    lifecycleStartupStep("index_page");
+    
+    // Discover every timer; capabilities never change at runtime, so each
+    // device is probed once and its /info body served from a cached snapshot
+    if (!watchdogInit()) {
+        printf("Warning: failed to cache watchdog capabilities\n");
+    }
+    if (!watchdogDefaultDevice()->present) {
+        printf("Warning: watchdog %u is not reported by the EC\n", watchdogDefaultDevice()->id);
+    }
+    lifecycleStartupStep("watchdogs");
+    
+    // GPIO bank capabilities and directions are probed once for /api/gpio
+    if (!gpioBankInit()) {
+        printf("Warning: failed to probe GPIO banks\n");
+    }
+    lifecycleStartupStep("gpio_banks");
+    
+    // Requests are logged through a ring buffer drained off the request path
+    if (!accessLogStart(&logConfig)) {
+        printf("Warning: failed to start access logger\n");
+    }
+    lifecycleStartupStep("access_log");
+    
+    // Render /metrics in the background so scrapes only copy a pointer
+    metricsRegisterCollector(collectServiceMetrics, NULL);
+    metricsRegisterCollector(watchdogCollectMetrics, NULL);
+    metricsRegisterCollector(accessLogCollectMetrics, NULL);
+    metricsRegisterCollector(feederCollectMetrics, NULL);
+    metricsRegisterCollector(realtimeCollectMetrics, NULL);
+    metricsRegisterCollector(memPoolCollectMetrics, NULL);
+    metricsRegisterCollector(systemdBridgeCollectMetrics, NULL);
+    metricsRegisterCollector(cuseWatchdogCollectMetrics, NULL);
+    metricsRegisterCollector(controlSocketCollectMetrics, NULL);
+    metricsRegisterCollector(leaseCollectMetrics, NULL);
+    metricsRegisterCollector(httpRouteCollectMetrics, NULL);
+    metricsRegisterCollector(susiTimingCollectMetrics, NULL);
+    metricsRegisterCollector(susiCapsCollectMetrics, NULL);
+    metricsRegisterCollector(susiBreakerCollectMetrics, NULL);
+    metricsRegisterCollector(rateLimitCollectMetrics, NULL);
+    metricsRegisterCollector(contentEncodingCollectMetrics, NULL);
+    metricsRegisterCollector(batchCollectMetrics, NULL);
+    metricsRegisterCollector(fleetCollectMetrics, NULL);
+    metricsRegisterCollector(hwActorCollectMetrics, NULL);
+    metricsRegisterCollector(schedulerCollectMetrics, NULL);
+    metricsRegisterCollector(selfStatsCollectMetrics, NULL);
+    metricsRegisterCollector(spanTraceCollectMetrics, NULL);
+    metricsRegisterCollector(lifecycleCollectMetrics, NULL);
+    metricsRegisterCollector(responsePoolCollectMetrics, NULL);
+    metricsRegisterCollector(eventsCollectMetrics, NULL);
+    metricsRegisterCollector(serviceConfigCollectMetrics, NULL);
+    metricsRegisterCollector(pretimeoutCollectMetrics, NULL);
+    metricsRegisterCollector(hwmCollectMetrics, NULL);
+    metricsRegisterCollector(hwmHistoryCollectMetrics, NULL);
+    metricsRegisterCollector(hwmExportCollectMetrics, NULL);
+    metricsRegisterCollector(hwmStoreCollectMetrics, NULL);
+    metricsRegisterCollector(gpioEventsCollectMetrics, NULL);
+    metricsRegisterCollector(webhookCollectMetrics, NULL);
+    metricsRegisterCollector(mqttBridgeCollectMetrics, NULL);
+    metricsRegisterCollector(shmTelemetryCollectMetrics, NULL);
+    metricsRegisterCollector(busScanCollectMetrics, NULL);
+    metricsRegisterCollector(diagDumpCollectMetrics, NULL);
+    metricsRegisterCollector(i2cTxnCollectMetrics, NULL);
+    metricsRegisterCollector(smbBulkCollectMetrics, NULL);
+    metricsRegisterCollector(i2cCacheCollectMetrics, NULL);
+    metricsRegisterCollector(storageAreaCollectMetrics, NULL);
+    metricsRegisterCollector(storageKvCollectMetrics, NULL);
+    metricsRegisterCollector(fanControlCollectMetrics, NULL);
+    metricsRegisterCollector(thermalMonitorCollectMetrics, NULL);
+    metricsRegisterCollector(alertRulesCollectMetrics, NULL);
+    metricsRegisterCollector(configTxnCollectMetrics, NULL);
+    metricsRegisterCollector(backlightCollectMetrics, NULL);
+    metricsRegisterCollector(boardInfoCollectMetrics, NULL);
+    metricsRegisterCollector(rtcWakeCollectMetrics, NULL);
+    metricsRegisterCollector(memoryInventoryCollectMetrics, NULL);
+    metricsRegisterCollector(susiIotCollectMetrics, NULL);
+    metricsRegisterCollector(picTelemetryCollectMetrics, NULL);
+    metricsRegisterCollector(sab2000AlertsCollectMetrics, NULL);
+    metricsRegisterCollector(batteryMonitorCollectMetrics, NULL);
+    metricsRegisterCollector(poeMonitorCollectMetrics, NULL);
+    metricsRegisterCollector(poeEnergyCollectMetrics, NULL);
+    if (!metricsStart(metricsInterval)) {
+        printf("Failed to start metrics updater. Exiting.\n");
+        hwActorStop();
+        watchdogShutdown();
+        cleanupSUSI();
+        return -1;
+    }
+    
+    lifecycleStartupStep("metrics");
+    
+    // Event streams block their connection thread in thread mode and are
+    // suspended in the polling modes
+    if (!eventsStart(serverMode == SERVER_MODE_THREAD)) {
+        printf("Warning: event stream heartbeat not available\n");
+    }
+    
+    // Start HTTP server
+    http_daemon = startHttpDaemon(serverMode, port, serverThreads,
+                                  maxConnections, perIpConnections,
+                                  connectionMemory, connectionTimeout);
+    
+    if (http_daemon == NULL) {
+        printf("Failed to start HTTP server on port %d\n", port);
+        metricsStop();
+        hwActorStop();
+        watchdogShutdown();
+        cleanupSUSI();
+        return -1;
+    }
+    lifecycleStartupStep("http");
+    
+    printf("Watchdog HTTP Service running on port %d\n", port);
+    printf("API endpoints available at:\n");
+    printf("  GET  /api/status    - Get current watchdog status\n");
+    printf("  GET  /api/info      - Get watchdog capabilities\n");
+    printf("  GET  /api/board     - Board inventory and counters\n");
+    printf("  GET  /api/self      - Service memory, threads, queues, pools and connections\n");
+    printf("  GET  /api/trace     - Recent spans as Chrome trace JSON, ?seconds=N\n");
+    printf("  GET  /api/memory    - Memory modules from SPD\n");
+    printf("  GET  /api/iot       - SusiIoT capability (with --iot)\n");
+    printf("  GET  /metrics       - Prometheus metrics\n");
+    printf("  POST /api/start     - Start the watchdog\n");
+    printf("  POST /api/trigger   - Feed/trigger the watchdog\n");
+    printf("  POST /api/stop      - Stop the watchdog\n");
+    printf("  POST /api/configure - Configure watchdog parameters\n");
+    printf("  GET  /api/wdt       - List watchdog timers\n");
+    printf("       /api/wdt/N/... - Per-timer status, info, start, trigger, stop, configure\n");
+    printf("  GET  /api/events    - Server-sent events for state changes\n");
+    printf("  GET  /api/hwm       - Latest voltage, temperature, fan and current readings\n");
+    printf("  GET  /api/hwm/history?res=10s|1m|15m - Min/max/avg rollups\n");
+    printf("  GET  /api/hwm/export?res=raw|10s|1m|15m - Compressed samples or rollups\n");
+    printf("  GET  /api/alerts    - Alert rules and their state (--alert-rule)\n");
+    printf("  GET  /api/hwm/previous - Samples kept in --hwm-store from the previous run\n");
+    printf("  POST /api/lease     - Create a liveness lease (?name=&timeout=)\n");
+    printf("  POST /api/lease/ID/renew|release\n");
+    printf("  GET  /api/gpio      - Direction and level of every GPIO bank\n");
+    printf("  PUT  /api/gpio?bank=N&mask=M&direction=D&level=L - Write the pins of one bank\n");
+    printf("  GET  /api/bus       - Cached SMBus/I2C address map\n");
+    printf("  POST /api/bus/scan  - Rescan the buses\n");
+    printf("  POST /api/i2c?bus=N&ops=ADDR:WRITE_HEX:READ_LENGTH,... - Batched I2C transfers\n");
+    printf("  POST /api/batch?ops=value:ID,gpio:PIN,board,wdt:N:ACTION,... - Batched reads and watchdog actions\n");
+    printf("  GET  /api/i2c/register?bus=N&addr=A&reg=R&length=L - Register read, cached per --i2c-cache\n");
+    printf("  PUT  /api/i2c/register?bus=N&addr=A&reg=R&data=HEX - Register write-through\n");
+    printf("  POST /api/i2c/invalidate?bus=N&addr=A[&reg=R&length=L] - Drop cached registers\n");
+    printf("  GET  /api/smbus?bus=N&addr=A&offset=O&length=L - Bulk SMBus read\n");
+    printf("  PUT  /api/smbus?bus=N&addr=A&offset=O&data=HEX[&page=P] - Bulk SMBus write\n");
+    printf("  GET  /api/storage   - Storage areas\n");
+    printf("  GET  /api/storage/ID?offset=O&length=L - Stream a storage region\n");
+    printf("  GET  /api/storage/ID?offset=O&length=L&crc=1 - CRC32C of a storage region\n");
+    printf("  PUT  /api/storage/ID?offset=O[&diff=1][&verify=1] - Write the request body to a storage area\n");
+    printf("  GET  /api/kv[/KEY]  - Persistent key-value store (--kv-store)\n");
+    printf("  GET  /api/diag      - PCI functions enumerated at startup (--pci-diag)\n");
+    printf("  GET  /api/diag/pci[?device=BB:DD.F][&extended=1] - Streamed config-space dump\n");
+    printf("  GET  /api/diag/msr[?index=I,...] - Streamed MSR dump\n");
+    printf("  PUT  /api/kv/KEY?value=TEXT|data=HEX, DELETE /api/kv/KEY - Update a key\n");
+    printf("  GET  /api/fan       - Software fan loops (--fan-loop)\n");
+    printf("  GET  /api/thermal   - Thermal protection zones and time to trip\n");
+    printf("  GET  /api/backlight - Backlight panels and ramps\n");
+    printf("  PUT  /api/backlight?id=N&brightness=B[&ramp_ms=T] - Ramp a panel without waiting\n");
+    printf("  GET  /api/poe       - PoE ports and power budget\n");
+    printf("  PUT  /api/poe?port=N&power=on|off - Switch a PoE port\n");
+    printf("  GET  /api/battery   - Smart Battery registers\n");
+    printf("  GET  /api/wake      - RTC wake from S5 and this board's offset\n");
+    printf("  PUT  /api/wake?time=HH:MM[:SS][&day=D][&window=SEC] - Staggered wake time\n");
+    printf("  GET  /api/config    - Thermal, fan, backlight and watchdog settings\n");
+    printf("  PUT  /api/config    - Change settings in one transaction, rolled back on failure\n");
+    printf("  GET  /api/fleet     - Merged view of the --fleet-board boards\n");
+    printf("Press Ctrl+C to stop the server\n");
+    
+    // The internal feeder keeps HTTP off the critical liveness path; it stops
+    // feeding as soon as any client lease expires
+    feederAddCondition("leases", leasesHealthy, NULL);
+    if (systemdBridgeUnitCount() > 0) {
+        if (autoFeedInterval == 0) {
+            printf("Warning: --systemd-unit has no effect without --auto-feed\n");
+        }
+        feederAddCondition("systemd", systemdUnitsHealthy, NULL);
+    }
+    feederSetSlack(watchdogAutoFeedSlackNs, NULL);
+    if (autoFeedInterval > 0 && !feederStart(autoFeedInterval, watchdogAutoFeed, NULL)) {
+        printf("Warning: failed to start the auto-feeder\n");
+    }
+    lifecycleStartupStep("feeder");
+    
+    // Type=notify and WatchdogSec= for this service, unit health for the feeder
+    if (!systemdBridgeStart()) {
+        printf("Warning: failed to start the systemd bridge\n");
+    }
+    lifecycleStartupStep("systemd");
+    
+    // /dev/watchdog clients feed at ioctl cost
+    if (!cuseWatchdogStart()) {
+        printf("Warning: the CUSE watchdog device is not available\n");
+    }
+    lifecycleStartupStep("cuse");
+    
+    // Local feeders can skip TCP, HTTP and JSON entirely
+    if (controlSocketPath && !controlSocketStart(controlSocketPath, controlSocketMode)) {
+        printf("Warning: failed to open control socket %s\n", controlSocketPath);
+    }
+    lifecycleStartupStep("control");
+    
+    // Timers started with an IRQ or SCI event type announce their reset;
+    // listeners get one last chance to capture diagnostics
+    // The HWM store is flushed right after the dump; a no-op without --hwm-store
+    pretimeoutAddHook(hwmStoreSync);
+    if (!pretimeoutStart(pretimeoutDumpPath)) {
+        printf("Warning: pre-timeout notifications not available\n");
+    }
+    lifecycleStartupStep("pretimeout");
+    
+    // GPIO edges go to /api/events, control socket subscribers and webhooks
+    if (!webhookStart()) {
+        printf("Warning: webhooks not available\n");
+    }
+    if (!gpioEventsStart()) {
+        printf("Warning: GPIO interrupts not available\n");
+    }
+    lifecycleStartupStep("gpio");
+    if (!mqttBridgeStart()) {
+        printf("Warning: MQTT bridge not available\n");
+    }
+    lifecycleStartupStep("mqtt");
+    
+    // The periodic pollers from here on share one timer wheel and a few
+    // workers instead of a sleeping thread each
+    if (!schedulerStart()) {
+        printf("Warning: scheduler not available, periodic pollers are off\n");
+    }
+    lifecycleStartupStep("scheduler");
+    
+    // Sensors are read in the background; /api/hwm and /metrics only copy
+    // the newest value of each
+    if (hwmInterval > 0 && !startHardwareMonitor(hwmInterval, hwmBudget, hwmStorePath)) {
+        printf("Warning: hardware monitor sampling not available\n");
+    }
+    lifecycleStartupStep("hwm");
+    
+    // Local agents map the newest snapshots instead of polling HTTP
+    if (!shmTelemetryStart()) {
+        printf("Warning: telemetry segment not available\n");
+    }
+    lifecycleStartupStep("shm");
+    
+    // Fan duties follow the sampled temperatures; the EC only hears about changes
+    if (fanControlLoopCount() > 0 && !fanControlStart()) {
+        printf("Warning: fan loops not available\n");
+    }
+    lifecycleStartupStep("fan_control");
+    
+    // Trips of the EC's thermal protection are forecast from the same sweeps
+    if (hwmInterval > 0) {
+        thermalMonitorStart();
+    }
+    lifecycleStartupStep("thermal");
+    
+    // Alert rules are compiled against the sensors found and run on every sweep
+    if (alertRulesCount() > 0 && (hwmInterval == 0 || !alertRulesStart())) {
+        printf("Warning: alert rules not available\n");
+    }
+    lifecycleStartupStep("alert_rules");
+    
+    // Brightness requests are merged and ramped by their own thread
+    if (!backlightStart()) {
+        printf("Backlight control not available\n");
+    }
+    lifecycleStartupStep("backlight");
+    
+    // Board inventory is read once; only the counters are polled
+    if (!boardInfoInit()) {
+        printf("Warning: board information not available\n");
+    } else if (boardRefresh > 0 && !boardInfoStart(boardRefresh)) {
+        printf("Warning: board counters will not be refreshed\n");
+    }
+    lifecycleStartupStep("board");
+    
+    // The wake offset is fixed by the serial, so it is worked out once
+    if (!rtcWakeInit(wakeWindow)) {
+        printf("RTC wake not available\n");
+    }
+    lifecycleStartupStep("rtc_wake");
+    
+    // SPD cannot change while the machine is up: decoded once, or from the cache
+    memoryInventoryInit();
+    lifecycleStartupStep("memory");
+    
+    // SusiIoT discovers its modules once here; the service runs on without it
+    if (!susiIotStart()) {
+        printf("Warning: SusiIoT not available, /api/iot is off\n");
+    }
+    lifecycleStartupStep("iot");
+    
+    // The power controller is only there with the SUSI device library
+    picTelemetryStart();
+    lifecycleStartupStep("pic");
+    
+    poeMonitorStart();
+    lifecycleStartupStep("poe");
+    
+    sab2000AlertsStart();
+    lifecycleStartupStep("sab2000");
+    
+    batteryMonitorStart();
+    lifecycleStartupStep("battery");
+    
+    // Bus inventories are scanned in the background and served from a cache
+    if (busScanTtl > 0 && (!busScanInit() || !busScanStart(busScanTtl))) {
+        printf("Warning: SMBus/I2C scanning not available\n");
+    }
+    lifecycleStartupStep("bus_scan");
+    
+    // PCI is enumerated once; dumps only read what can change
+    if (pciDiag && !diagDumpInit()) {
+        printf("Warning: PCI diagnostics not available\n");
+    }
+    lifecycleStartupStep("pci_diag");
+    
+    // Storage areas are sized once; transfers are chunked per request
+    if (!storageAreaInit()) {
+        printf("Warning: no storage areas found\n");
+    }
+    if (kvArea >= 0 && !storageKvInit((SusiId_t)kvArea, (uint32_t)kvOffset, (uint32_t)kvLength)) {
+        printf("Warning: key-value store not available in storage %d\n", kvArea);
+    }
+    lifecycleStartupStep("storage");
+    
+    // Energy counters continue from the key-value store
+    poeEnergyStart();
+    lifecycleStartupStep("poe_energy");
+    
+    // A board can also aggregate its neighbours
+    if (!fleetStart(fleetInterval)) {
+        printf("Warning: fleet scraping not available\n");
+    }
+    lifecycleStartupStep("fleet");
+    
+    // Settings changes are applied without a restart
+    if (configPath && !serviceConfigStartWatcher(watchdogCheckConfig, applyServiceConfig)) {
+        printf("Warning: %s will not be reloaded\n", configPath);
+    }
+    lifecycleStartupStep("config");
+    lifecycleStartupDone();
+    
+    // Independent subsystems stop concurrently; a phase only starts once
+    // everything it depends on is down. The metrics and info snapshots may
+    // still be referenced by in-flight responses until MHD has stopped, the
+    // scheduler waits for the pollers to take their tasks off it, and the
+    // watchdogs are stopped directly once the hardware thread is gone.
+    lifecycleAddShutdownHook(0, "feeder", feederStop);
+    lifecycleAddShutdownHook(0, "systemd", systemdBridgeStop);
+    lifecycleAddShutdownHook(0, "cuse", cuseWatchdogStop);
+    lifecycleAddShutdownHook(0, "fleet", fleetStop);
+    lifecycleAddShutdownHook(0, "http", stopHttpServer);
+    lifecycleAddShutdownHook(0, "control", controlSocketStop);
+    lifecycleAddShutdownHook(0, "config", serviceConfigStopWatcher);
+    lifecycleAddShutdownHook(0, "pretimeout", pretimeoutStop);
+    lifecycleAddShutdownHook(0, "hwm", hwmStop);
+    lifecycleAddShutdownHook(0, "shm", shmTelemetryStop);
+    lifecycleAddShutdownHook(0, "fan_control", fanControlStop);
+    lifecycleAddShutdownHook(0, "backlight", backlightStop);
+    lifecycleAddShutdownHook(0, "board", boardInfoStop);
+    lifecycleAddShutdownHook(0, "pic", picTelemetryStop);
+    lifecycleAddShutdownHook(0, "poe", poeMonitorStop);
+    lifecycleAddShutdownHook(0, "sab2000", sab2000AlertsStop);
+    lifecycleAddShutdownHook(0, "battery", batteryMonitorStop);
+    lifecycleAddShutdownHook(0, "poe_energy", poeEnergyStop);
+    lifecycleAddShutdownHook(0, "gpio", gpioEventsStop);
+    lifecycleAddShutdownHook(0, "bus_scan", busScanStop);
+    lifecycleAddShutdownHook(1, "metrics", metricsStop);
+    lifecycleAddShutdownHook(1, "scheduler", schedulerStop);
+    lifecycleAddShutdownHook(1, "index_page", destroyIndexPages);
+    lifecycleAddShutdownHook(1, "hwm_snapshot", hwmDestroy);
+    lifecycleAddShutdownHook(1, "hwm_history", hwmHistoryDestroy);
+    lifecycleAddShutdownHook(1, "hwm_export", hwmExportDestroy);
+    lifecycleAddShutdownHook(1, "tls", tlsServerDestroy);
+    lifecycleAddShutdownHook(1, "bus_snapshot", busScanDestroy);
+    lifecycleAddShutdownHook(1, "diag_snapshot", diagDumpDestroy);
+    lifecycleAddShutdownHook(1, "board_snapshot", boardInfoDestroy);
+    lifecycleAddShutdownHook(1, "memory_snapshot", memoryInventoryDestroy);
+    lifecycleAddShutdownHook(1, "webhook", webhookStop);
+    lifecycleAddShutdownHook(1, "mqtt", mqttBridgeStop);
+    lifecycleAddShutdownHook(1, "iot", susiIotStop);
+    lifecycleAddShutdownHook(1, "hw_actor", hwActorStop);
+    lifecycleAddShutdownHook(2, "watchdogs", watchdogShutdown);
+    lifecycleAddShutdownHook(2, "hwm_store", hwmStoreClose);
+    lifecycleAddShutdownHook(2, "access_log", accessLogStop);
+    
+    char readyStatus[64];
+    snprintf(readyStatus, sizeof(readyStatus), "Serving on port %d", port);
+    systemdBridgeReady(readyStatus);
+    
+    // Main loop: sleeps until a signal or shutdown request arrives
+    int sig = lifecycleWait();
+    printf("Shutdown %s received. Cleaning up...\n", sig ? strsignal(sig) : "request");
+    
+    lifecycleShutdown();
     
     // Clean up SUSI API
     cleanupSUSI();
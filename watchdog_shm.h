@@ -0,0 +1,140 @@
+#ifndef WATCHDOG_SHM_H
+#define WATCHDOG_SHM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Layout of the telemetry segment the service publishes with --shm NAME
+// (/dev/shm/NAME), for local agents that want the newest HWM, GPIO and
+// watchdog state without HTTP. This header is all a reader needs:
+//
+//   int fd = shm_open("/watchdog_telemetry", O_RDONLY, 0);
+//   const WatchdogShm *shm = mmap(NULL, sizeof(WatchdogShm), PROT_READ, MAP_SHARED, fd, 0);
+//   WatchdogShmHwm hwm;
+//   if (watchdogShmCheck(shm) && watchdogShmRead(&shm->hwm.seq, &shm->hwm, &hwm, sizeof(hwm))) ...
+//
+// Each section has its own seqlock, so a reader copies one section without
+// a system call and without ever blocking the service: the sequence is odd
+// while the section is written, and a copy taken while it was odd or while
+// it changed is retried. Values are fixed-width, timestamps are wall-clock
+// milliseconds (*Ms) or CLOCK_MONOTONIC nanoseconds (*Ns), so remaining
+// times can be computed against the reader's own clock_gettime().
+//
+// The version changes whenever a field moves; readers reject other versions.
+
+#define WATCHDOG_SHM_MAGIC 0x4d485357u    // "WSHM"
+#define WATCHDOG_SHM_VERSION 1
+#define WATCHDOG_SHM_SENSORS 64
+#define WATCHDOG_SHM_GPIO_BANKS 8
+#define WATCHDOG_SHM_TIMERS 8
+#define WATCHDOG_SHM_NAME_MAX 32
+#define WATCHDOG_SHM_READ_ATTEMPTS 1000   // Give up when a writer died mid-update
+
+typedef struct {
+    uint64_t sequence;                    // Odd while the section is written
+    uint64_t updates;                     // Times the section was published
+    uint64_t updatedMs;                   // Wall clock of the last publication
+    uint64_t updatedNs;                   // CLOCK_MONOTONIC of the last publication
+} WatchdogShmSeq;
+
+typedef struct {
+    uint32_t id;                          // SUSI_ID_HWM_*
+    uint32_t kind;                        // 0 temperature, 1 voltage, 2 fan, 3 current, 4 case open
+    int32_t raw;                          // As SusiBoardGetValue reports it
+    uint32_t valid;                       // 1 once the sensor was read successfully
+    double value;                         // Celsius, volts, RPM, amperes or 0/1
+    uint64_t sampledMs;                   // Wall clock of the reading
+    char name[WATCHDOG_SHM_NAME_MAX];     // Label reported by the EC
+} WatchdogShmSensor;
+
+typedef struct {
+    WatchdogShmSeq seq;
+    uint64_t sweep;                       // Sampler sweep the values are current as of
+    uint32_t count;                       // Sensors in use
+    uint32_t reserved;
+    WatchdogShmSensor sensors[WATCHDOG_SHM_SENSORS];
+} __attribute__((aligned(64))) WatchdogShmHwm;
+
+typedef struct {
+    uint32_t bank;                        // SUSI_ID_GPIO_BANK index
+    uint32_t inputs;                      // Pins that support input
+    uint32_t outputs;                     // Pins that support output
+    uint32_t interrupts;
+    uint32_t direction;                   // Bit set = input
+    uint32_t level;                       // Bit set = high
+    uint32_t status;                      // SusiStatus_t of the read
+    uint32_t reserved;
+} WatchdogShmGpioBank;
+
+typedef struct {
+    WatchdogShmSeq seq;
+    uint32_t count;
+    uint32_t reserved;
+    WatchdogShmGpioBank banks[WATCHDOG_SHM_GPIO_BANKS];
+} __attribute__((aligned(64))) WatchdogShmGpio;
+
+typedef struct {
+    uint32_t id;                          // SUSI_ID_WATCHDOG_*
+    uint32_t present;
+    uint32_t running;
+    uint32_t delayTime;                   // Milliseconds, as started (or configured while stopped)
+    uint32_t eventTime;
+    uint32_t resetTime;
+    uint32_t eventType;
+    uint32_t reserved;
+    uint64_t armedNs;                     // Last start, 0 while stopped
+    uint64_t lastFeedNs;                  // Last start or trigger
+    uint64_t resetAtNs;                   // When the board resets without another feed, 0 while stopped
+    uint64_t feedCount;
+} WatchdogShmTimer;
+
+typedef struct {
+    WatchdogShmSeq seq;
+    uint32_t count;
+    uint32_t defaultId;                   // Timer behind the /api/* routes
+    WatchdogShmTimer timers[WATCHDOG_SHM_TIMERS];
+} __attribute__((aligned(64))) WatchdogShmWatchdog;
+
+typedef struct {
+    uint32_t magic;                       // Written last when the segment is created
+    uint32_t version;
+    uint32_t size;                        // sizeof(WatchdogShm)
+    uint32_t pid;
+    uint64_t startedMs;
+    uint64_t heartbeatMs;                 // Refreshed every publish interval while running
+    uint32_t running;                     // 0 once the service has stopped
+    uint32_t intervalMs;                  // Publish interval of the GPIO and watchdog sections
+} __attribute__((aligned(64))) WatchdogShmHeader;
+
+typedef struct {
+    WatchdogShmHeader header;
+    WatchdogShmHwm hwm;
+    WatchdogShmGpio gpio;
+    WatchdogShmWatchdog watchdog;
+} WatchdogShm;
+
+static inline bool watchdogShmCheck(const WatchdogShm *shm) {
+    return __atomic_load_n(&shm->header.magic, __ATOMIC_ACQUIRE) == WATCHDOG_SHM_MAGIC &&
+           shm->header.version == WATCHDOG_SHM_VERSION && shm->header.size == sizeof(WatchdogShm);
+}
+
+// Copy a consistent section (seq is its first member) into out; false when
+// no consistent copy could be taken
+static inline bool watchdogShmRead(const WatchdogShmSeq *seq, const void *section, void *out, size_t size) {
+    for (int attempt = 0; attempt < WATCHDOG_SHM_READ_ATTEMPTS; attempt++) {
+        uint64_t before = __atomic_load_n(&seq->sequence, __ATOMIC_ACQUIRE);
+
+        if (before & 1) {
+            continue;
+        }
+        memcpy(out, section, size);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&seq->sequence, __ATOMIC_RELAXED) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif // WATCHDOG_SHM_H
@@ -3,12 +3,53 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
 #include <unistd.h>
 #include <termios.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include "Susi4.h"
+#include "control_socket.h"
+#include "susi_session.h"
+#include "histogram.h"
+#include "json_writer.h"
+#include "timeutil.h"
+
+#define REPORT_CAPACITY 4096
+
+// Set with --socket: every operation goes to a running watchdog_http_service
+// through its control socket instead of the driver
+static int controlFd = -1;
+static uint32_t controlSequence;
+static int sessionLock = -1;
+// Set by --cycles and --soak: no menu, and stdout carries only the report
+static bool batchMode = false;
+static volatile sig_atomic_t interrupted = 0;
+
+typedef enum {
+    CALL_START,
+    CALL_TRIGGER,
+    CALL_STOP,
+    CALL_COUNT
+} TimedCall;
+
+typedef struct {
+    Histogram latency;
+    uint64_t minNs;
+    uint64_t failures;
+} CallStats;
+
+static const char *callNames[CALL_COUNT] = { "SusiWDogStart", "SusiWDogTrigger", "SusiWDogStop" };
+static CallStats callStats[CALL_COUNT];
+static Histogram feedLateness;      // --soak: how far each feed ran behind its schedule
 
 // Function prototypes
 bool initializeSUSI(void);
+bool connectService(const char *path);
+bool controlRequest(uint8_t op, SusiId_t id, uint32_t delayTime, uint32_t eventTime, uint32_t resetTime,
+                    uint32_t eventType, ControlResponse *response);
 void displayWatchdogInfo(SusiId_t id);
 bool startWatchdog(SusiId_t id, uint32_t delayTime, uint32_t eventTime, uint32_t resetTime, uint32_t eventType);
 bool triggerWatchdog(SusiId_t id);
@@ -17,6 +58,8 @@ void displayMenu(void);
 int getch(void);
 void clearScreen(void);
 void cleanupSUSI(void);
+int runBatch(SusiId_t id, uint32_t delayTime, uint32_t eventTime, uint32_t resetTime, uint32_t eventType,
+             uint32_t cycles, uint32_t feedInterval, uint32_t duration);
 
 int main(int argc, char* argv[]) {
     int choice;
@@ -26,18 +69,87 @@ int main(int argc, char* argv[]) {
     uint32_t resetTime = 1000;   // 1 second reset time
     uint32_t eventType = SUSI_WDT_EVENT_TYPE_NONE; // Default event type
     bool watchdogRunning = false;
+    const char *socketPath = NULL;
+    uint32_t cycles = 0;
+    uint32_t feedInterval = 0;
+    uint32_t duration = 0;
+    char *end;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (strcmp(argv[i], "--id") == 0 && i + 1 < argc) {
+            unsigned long id = strtoul(argv[++i], &end, 10);
+            
+            if (*end != '\0' || id < 1 || id > SUSI_ID_WATCHDOG_MAX) {
+                printf("Invalid watchdog '%s' (expected 1-%d)\n", argv[i], SUSI_ID_WATCHDOG_MAX);
+                return -1;
+            }
+            watchdogId = (SusiId_t)(id - 1);
+        } else if (strcmp(argv[i], "--timings") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%u:%u:%u", &delayTime, &eventTime, &resetTime) != 3) {
+                printf("Invalid timings '%s' (expected DELAY:EVENT:RESET in ms)\n", argv[i]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--cycles") == 0 && i + 1 < argc) {
+            cycles = (uint32_t)strtoul(argv[++i], &end, 10);
+            if (*end != '\0' || cycles == 0) {
+                printf("Invalid cycle count '%s' (expected a positive number)\n", argv[i]);
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--soak") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%u:%u", &feedInterval, &duration) != 2 || feedInterval == 0 || duration == 0) {
+                printf("Invalid soak '%s' (expected INTERVAL_MS:SECONDS)\n", argv[i]);
+                return -1;
+            }
+        } else {
+            printf("Usage: %s [--socket PATH] [--id N] [--timings D:E:R] [--cycles N | --soak MS:SEC]\n", argv[0]);
+            printf("  --socket PATH     Drive the watchdog through a running watchdog_http_service\n");
+            printf("                    (its --control-socket) instead of the SUSI driver\n");
+            printf("  --id N            Watchdog timer 1-%d (default 1)\n", SUSI_ID_WATCHDOG_MAX);
+            printf("  --timings D:E:R   Delay, event and reset time in ms (default 10000:5000:1000)\n");
+            printf("  --cycles N        Run N start/trigger/stop cycles without the menu\n");
+            printf("  --soak MS:SEC     Start, feed every MS ms for SEC seconds, then stop\n");
+            printf("                    Both print a JSON latency report on stdout\n");
+            return -1;
+        }
+    }
+    if (cycles > 0 && feedInterval > 0) {
+        printf("--cycles and --soak are exclusive\n");
+        return -1;
+    }
+    // A feed interval the timer does not cover would reset the board mid-run.
+    // A trigger buys event + reset time; the delay only adds to the first.
+    if (feedInterval > 0 && (uint64_t)feedInterval >= (uint64_t)eventTime + resetTime) {
+        printf("Feed interval %u ms must be shorter than the event plus reset time (%u + %u ms)\n",
+               feedInterval, eventTime, resetTime);
+        return -1;
+    }
+    if (cycles > 0 || feedInterval > 0) {
+        batchMode = true;
+        if (socketPath != NULL ? !connectService(socketPath) : !initializeSUSI()) {
+            return -1;
+        }
+        int result = runBatch(watchdogId, delayTime, eventTime, resetTime, eventType, cycles, feedInterval, duration);
+        cleanupSUSI();
+        return result;
+    }
     
     printf("SUSI API Watchdog Test Application\n");
     printf("==================================\n\n");
     
-    // Initialize the SUSI API
-    if (!initializeSUSI()) {
+    // Connect to the service, or initialize the SUSI API
+    if (socketPath != NULL) {
+        if (!connectService(socketPath)) {
+            return -1;
+        }
+    } else if (!initializeSUSI()) {
         printf("Failed to initialize SUSI API. Press any key to exit...\n");
         getch();
         return -1;
     }
     
-    printf("SUSI API initialized successfully!\n\n");
+    printf("%s\n\n", controlFd >= 0 ? "Connected to the watchdog service!" : "SUSI API initialized successfully!");
     
     // Display information about the watchdog
     displayWatchdogInfo(watchdogId);
@@ -174,7 +286,22 @@ int main(int argc, char* argv[]) {
 
 // Initialize the SUSI API
 bool initializeSUSI(void) {
-    SusiStatus_t status = SusiLibInitialize();
+    SusiStatus_t status;
+    pid_t owner;
+    
+    // Only one process may drive the SUSI library at a time
+    sessionLock = susiSessionAcquire(SUSI_SESSION_DEFAULT_LOCK, "watchdog_test", &owner);
+    if (sessionLock == -1) {
+        char name[64];
+        
+        susiSessionOwner(SUSI_SESSION_DEFAULT_LOCK, name, sizeof(name));
+        printf("SUSI is in use by pid %ld (%s).\n", (long)owner, name[0] ? name : "unknown");
+        printf("If that is watchdog_http_service, run this test through its control socket:\n");
+        printf("  ./watchdog_test --socket /run/watchdog.sock\n");
+        return false;
+    }
+    
+    status = SusiLibInitialize();
     
     if (status != SUSI_STATUS_SUCCESS) {
         printf("SUSI API initialization failed with status: 0x%08X\n", status);
@@ -221,7 +348,67 @@ bool initializeSUSI(void) {
         return false;
     }
     
-    printf("SUSI API initialized successfully!\n");
+    if (!batchMode) {
+        printf("SUSI API initialized successfully!\n");
+    }
+    return true;
+}
+
+// Connect to the control socket of watchdog_http_service
+bool connectService(const char *path) {
+    struct sockaddr_un address;
+    ControlResponse response;
+    
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        printf("Socket path too long: %s\n", path);
+        return false;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    controlFd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (controlFd < 0 || connect(controlFd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        printf("Cannot connect to %s: %s\n", path, strerror(errno));
+        printf("Is watchdog_http_service running with --control-socket %s?\n", path);
+        return false;
+    }
+    if (!controlRequest(CONTROL_OP_STATUS, SUSI_ID_WATCHDOG_1, 0, 0, 0, 0, &response)) {
+        printf("The service did not answer a status request\n");
+        return false;
+    }
+    return true;
+}
+
+// One request/response round trip; false if the service did not answer or
+// reported an error
+bool controlRequest(uint8_t op, SusiId_t id, uint32_t delayTime, uint32_t eventTime, uint32_t resetTime,
+                    uint32_t eventType, ControlResponse *response) {
+    ControlRequest request;
+    
+    memset(&request, 0, sizeof(request));
+    request.magic = CONTROL_MAGIC;
+    request.version = CONTROL_VERSION;
+    request.op = op;
+    request.watchdog = (uint8_t)id;
+    request.sequence = ++controlSequence;
+    request.delayTime = delayTime;
+    request.eventTime = eventTime;
+    request.resetTime = resetTime;
+    request.eventType = eventType;
+    if (send(controlFd, &request, sizeof(request), 0) != (ssize_t)sizeof(request)) {
+        return false;
+    }
+    // Skip unsolicited notifications; this client never subscribes, but
+    // another op may share the sequence space
+    do {
+        if (recv(controlFd, response, sizeof(*response), 0) != (ssize_t)sizeof(*response)) {
+            return false;
+        }
+    } while (response->sequence != request.sequence || response->op != op);
+    if (response->status != CONTROL_STATUS_OK) {
+        fprintf(stderr, "Service answered with status %u\n", response->status);
+        return false;
+    }
     return true;
 }
 
@@ -234,6 +421,21 @@ void displayWatchdogInfo(SusiId_t id) {
     printf("Watchdog Information (ID: %d)\n", id);
     printf("---------------------------\n");
     
+    if (controlFd >= 0) {
+        ControlResponse response;
+        
+        if (controlRequest(CONTROL_OP_STATUS, id, 0, 0, 0, 0, &response)) {
+            printf("Served by watchdog_http_service, timer %u is %s.\n", response.watchdog,
+                   response.running ? "running" : "stopped");
+            printf("Timings: delay %u ms, event %u ms, reset %u ms\n",
+                   response.delayTime, response.eventTime, response.resetTime);
+        } else {
+            printf("Failed to get the watchdog status from the service.\n");
+        }
+        printf("\n");
+        return;
+    }
+    
     // Check if watchdog is supported
     status = SusiWDogGetCaps(id, SUSI_ID_WDT_SUPPORT_FLAGS, &value);
     if (status == SUSI_STATUS_SUCCESS) {
@@ -277,22 +479,169 @@ void displayWatchdogInfo(SusiId_t id) {
 
 // Start the watchdog
 bool startWatchdog(SusiId_t id, uint32_t delayTime, uint32_t eventTime, uint32_t resetTime, uint32_t eventType) {
+    ControlResponse response;
+    
+    if (controlFd >= 0) {
+        return controlRequest(CONTROL_OP_START, id, delayTime, eventTime, resetTime, eventType, &response);
+    }
     SusiStatus_t status = SusiWDogStart(id, delayTime, eventTime, resetTime, eventType);
     return (status == SUSI_STATUS_SUCCESS);
 }
 
 // Trigger (feed) the watchdog
 bool triggerWatchdog(SusiId_t id) {
+    ControlResponse response;
+    
+    if (controlFd >= 0) {
+        return controlRequest(CONTROL_OP_FEED, id, 0, 0, 0, 0, &response);
+    }
     SusiStatus_t status = SusiWDogTrigger(id);
     return (status == SUSI_STATUS_SUCCESS);
 }
 
 // Stop the watchdog
 bool stopWatchdog(SusiId_t id) {
+    ControlResponse response;
+    
+    if (controlFd >= 0) {
+        return controlRequest(CONTROL_OP_STOP, id, 0, 0, 0, 0, &response);
+    }
     SusiStatus_t status = SusiWDogStop(id);
     return (status == SUSI_STATUS_SUCCESS);
 }
 
+// Time one call into callStats; in service mode the latency includes the
+// control socket round trip
+static bool timedCall(TimedCall call, SusiId_t id, uint32_t delayTime, uint32_t eventTime, uint32_t resetTime,
+                      uint32_t eventType) {
+    CallStats *stats = &callStats[call];
+    uint64_t start = monotonicNowNs();
+    uint64_t elapsed;
+    bool ok;
+    
+    switch (call) {
+        case CALL_START: ok = startWatchdog(id, delayTime, eventTime, resetTime, eventType); break;
+        case CALL_TRIGGER: ok = triggerWatchdog(id); break;
+        default: ok = stopWatchdog(id); break;
+    }
+    elapsed = monotonicNowNs() - start;
+    histogramRecord(&stats->latency, elapsed);
+    if (stats->latency.count == 1 || elapsed < stats->minNs) {
+        stats->minNs = elapsed;
+    }
+    if (!ok) {
+        stats->failures++;
+    }
+    return ok;
+}
+
+static void onInterrupt(int signal) {
+    (void)signal;
+    interrupted = 1;
+}
+
+static void writeLatency(JsonWriter *writer, const Histogram *histogram, uint64_t minNs) {
+    jsonFieldUint(writer, "count", histogram->count);
+    if (histogram->count == 0) {
+        return;
+    }
+    jsonFieldDouble(writer, "min_us", minNs / 1e3, 3);
+    jsonFieldDouble(writer, "mean_us", (double)histogram->sumNs / histogram->count / 1e3, 3);
+    jsonFieldDouble(writer, "p50_us", histogramQuantile(histogram, 0.5) / 1e3, 3);
+    jsonFieldDouble(writer, "p99_us", histogramQuantile(histogram, 0.99) / 1e3, 3);
+    jsonFieldDouble(writer, "p999_us", histogramQuantile(histogram, 0.999) / 1e3, 3);
+    jsonFieldDouble(writer, "max_us", histogram->maxNs / 1e3, 3);
+}
+
+// --cycles and --soak. Progress and errors go to stderr, the report to
+// stdout; the exit status is 2 when any call failed. Ctrl-C ends the run
+// early but still stops the timer, so an aborted soak does not reset the board.
+int runBatch(SusiId_t id, uint32_t delayTime, uint32_t eventTime, uint32_t resetTime, uint32_t eventType,
+             uint32_t cycles, uint32_t feedInterval, uint32_t duration) {
+    struct sigaction action;
+    char report[REPORT_CAPACITY];
+    StrBuf out;
+    JsonWriter writer;
+    uint64_t started = monotonicNowNs();
+    uint64_t failures = 0;
+    uint32_t completed = 0;
+    
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onInterrupt;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    
+    if (cycles > 0) {
+        fprintf(stderr, "Running %u start/trigger/stop cycles on watchdog %d\n", cycles, id + 1);
+        for (; completed < cycles && !interrupted; completed++) {
+            if (timedCall(CALL_START, id, delayTime, eventTime, resetTime, eventType)) {
+                timedCall(CALL_TRIGGER, id, 0, 0, 0, 0);
+                timedCall(CALL_STOP, id, 0, 0, 0, 0);
+            }
+        }
+    } else if (timedCall(CALL_START, id, delayTime, eventTime, resetTime, eventType)) {
+        uint64_t intervalNs = feedInterval * 1000000ull;
+        uint64_t deadline = monotonicNowNs();
+        uint64_t endNs = deadline + duration * 1000000000ull;
+        struct timespec wake;
+        
+        fprintf(stderr, "Feeding watchdog %d every %u ms for %u s\n", id + 1, feedInterval, duration);
+        // Absolute deadlines, so a slow call delays one feed and not the rest
+        for (deadline += intervalNs; deadline <= endNs && !interrupted; deadline += intervalNs) {
+            wake.tv_sec = (time_t)(deadline / 1000000000ull);
+            wake.tv_nsec = (long)(deadline % 1000000000ull);
+            if (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) != 0) {
+                continue;
+            }
+            histogramRecord(&feedLateness, monotonicNowNs() - deadline);
+            timedCall(CALL_TRIGGER, id, 0, 0, 0, 0);
+            completed++;
+        }
+        timedCall(CALL_STOP, id, 0, 0, 0, 0);
+    }
+    
+    strbufInit(&out, report, sizeof(report));
+    jsonWriterInit(&writer, &out);
+    jsonBeginObject(&writer);
+    jsonFieldString(&writer, "mode", cycles > 0 ? "cycles" : "soak");
+    jsonFieldString(&writer, "path", controlFd >= 0 ? "service" : "driver");
+    jsonFieldInt(&writer, "watchdog", id + 1);
+    jsonFieldUint(&writer, "delay_ms", delayTime);
+    jsonFieldUint(&writer, "event_ms", eventTime);
+    jsonFieldUint(&writer, "reset_ms", resetTime);
+    if (cycles > 0) {
+        jsonFieldUint(&writer, "cycles", completed);
+    } else {
+        jsonFieldUint(&writer, "interval_ms", feedInterval);
+        jsonFieldUint(&writer, "feeds", completed);
+    }
+    jsonFieldDouble(&writer, "elapsed_s", (monotonicNowNs() - started) / 1e9, 3);
+    jsonFieldBool(&writer, "interrupted", interrupted != 0);
+    jsonKey(&writer, "calls");
+    jsonBeginArray(&writer);
+    for (int call = 0; call < CALL_COUNT; call++) {
+        jsonBeginObject(&writer);
+        jsonFieldString(&writer, "api", callNames[call]);
+        jsonFieldUint(&writer, "failures", callStats[call].failures);
+        writeLatency(&writer, &callStats[call].latency, callStats[call].minNs);
+        jsonEndObject(&writer);
+        failures += callStats[call].failures;
+    }
+    jsonEndArray(&writer);
+    if (feedInterval > 0) {
+        jsonKey(&writer, "feed_lateness");
+        jsonBeginObject(&writer);
+        jsonFieldDouble(&writer, "p50_us", histogramQuantile(&feedLateness, 0.5) / 1e3, 3);
+        jsonFieldDouble(&writer, "p99_us", histogramQuantile(&feedLateness, 0.99) / 1e3, 3);
+        jsonFieldDouble(&writer, "max_us", feedLateness.maxNs / 1e3, 3);
+        jsonEndObject(&writer);
+    }
+    jsonFieldUint(&writer, "failures", failures);
+    jsonEndObject(&writer);
+    printf("%s\n", report);
+    return failures > 0 ? 2 : 0;
+}
+
 // Display the application menu
 void displayMenu(void) {
     clearScreen();
@@ -309,8 +658,20 @@ void displayMenu(void) {
 
 // Clean up SUSI API
 void cleanupSUSI(void) {
+    if (controlFd >= 0) {
+        close(controlFd);
+        if (!batchMode) {
+            printf("Disconnected from the watchdog service.\n");
+        }
+        return;
+    }
     SusiLibUninitialize();
-    printf("SUSI API cleaned up.\n");
+    if (sessionLock >= 0) {
+        close(sessionLock);
+    }
+    if (!batchMode) {
+        printf("SUSI API cleaned up.\n");
+    }
 }
 
 // Linux replacement for getch() function
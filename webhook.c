@@ -0,0 +1,287 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include "webhook.h"
+#include "histogram.h"
+#include "metrics.h"
+#include "timeutil.h"
+
+typedef struct {
+    char url[256];
+    char host[128];
+    char port[8];
+    char path[128];
+    uint64_t delivered;
+    uint64_t failed;
+} WebhookTarget;
+
+typedef struct {
+    size_t length;
+    char body[WEBHOOK_BODY_MAX];
+} WebhookSlot;
+
+static WebhookTarget targets[WEBHOOK_MAX_TARGETS];
+static int targetCount = 0;
+
+// Posters append at tail under the lock; the sender delivers the slot at
+// head outside it and only then advances head, so the slot stays untouched
+static WebhookSlot queue[WEBHOOK_QUEUE];
+static uint64_t queueHead = 0;
+static uint64_t queueTail = 0;
+static pthread_mutex_t queueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queueWake = PTHREAD_COND_INITIALIZER;
+static bool stopping = false;
+
+static pthread_t senderThread;
+static bool webhookActive = false;
+static Histogram postLatency;
+static uint64_t dropped = 0;
+
+// http://host[:port][/path]; anything that would break the request line or
+// a metric label is refused
+static bool parseUrl(const char *url, WebhookTarget *target) {
+    const char *host = url + strlen("http://");
+    size_t hostLength = strcspn(host, ":/");
+    const char *rest = host + hostLength;
+    const char *path = strchr(rest, '/');
+    size_t portLength = *rest == ':' ? strcspn(rest + 1, "/") : 0;
+
+    if (strncmp(url, "http://", strlen("http://")) != 0 || hostLength == 0 || hostLength >= sizeof(target->host) ||
+        strlen(url) >= sizeof(target->url) || strpbrk(url, " \"\\\r\n") != NULL) {
+        return false;
+    }
+    if (path == NULL) {
+        path = "/";
+    }
+    if (strlen(path) >= sizeof(target->path)) {
+        return false;
+    }
+    if (*rest == ':') {
+        if (portLength == 0 || portLength >= sizeof(target->port) || strspn(rest + 1, "0123456789") != portLength) {
+            return false;
+        }
+        memcpy(target->port, rest + 1, portLength);
+        target->port[portLength] = '\0';
+    } else {
+        strcpy(target->port, "80");
+    }
+    memcpy(target->host, host, hostLength);
+    target->host[hostLength] = '\0';
+    strcpy(target->path, path);
+    strcpy(target->url, url);
+    return true;
+}
+
+bool webhookAdd(const char *url) {
+    if (webhookActive || targetCount >= WEBHOOK_MAX_TARGETS) {
+        return false;
+    }
+    memset(&targets[targetCount], 0, sizeof(targets[0]));
+    if (!parseUrl(url, &targets[targetCount])) {
+        return false;
+    }
+    targetCount++;
+    return true;
+}
+
+// Non-blocking connect bounded by WEBHOOK_TIMEOUT_MS, then blocking I/O
+// with the same timeout per call
+static int connectTarget(const WebhookTarget *target) {
+    struct addrinfo hints;
+    struct addrinfo *addresses;
+    struct timeval timeout = { WEBHOOK_TIMEOUT_MS / 1000, (WEBHOOK_TIMEOUT_MS % 1000) * 1000 };
+    int fd = -1;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(target->host, target->port, &hints, &addresses) != 0) {
+        return -1;
+    }
+    for (struct addrinfo *address = addresses; address != NULL; address = address->ai_next) {
+        struct pollfd pfd;
+        int error = 0;
+        socklen_t length = sizeof(error);
+
+        fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK, address->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (connect(fd, address->ai_addr, address->ai_addrlen) != 0) {
+            pfd.fd = fd;
+            pfd.events = POLLOUT;
+            if (errno != EINPROGRESS || poll(&pfd, 1, WEBHOOK_TIMEOUT_MS) != 1 ||
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+                close(fd);
+                fd = -1;
+                continue;
+            }
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        break;
+    }
+    freeaddrinfo(addresses);
+    return fd;
+}
+
+static bool sendAll(int fd, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        length -= (size_t)sent;
+    }
+    return true;
+}
+
+// One POST on its own connection; true for a 2xx status line
+static bool deliver(const WebhookTarget *target, const WebhookSlot *slot) {
+    char head[512];
+    char status[32];
+    int headLength;
+    ssize_t received;
+    bool ok;
+    int fd;
+
+    headLength = snprintf(head, sizeof(head),
+                          "POST %s HTTP/1.1\r\nHost: %s\r\nContent-Type: application/json\r\n"
+                          "Content-Length: %zu\r\nConnection: close\r\nUser-Agent: watchdog-http\r\n\r\n",
+                          target->path, target->host, slot->length);
+    fd = connectTarget(target);
+    if (fd < 0) {
+        return false;
+    }
+    ok = sendAll(fd, head, (size_t)headLength) && sendAll(fd, slot->body, slot->length);
+    if (ok) {
+        received = recv(fd, status, sizeof(status) - 1, 0);
+        status[received > 0 ? received : 0] = '\0';
+        // "HTTP/1.1 204 ..."
+        ok = received >= 12 && strncmp(status, "HTTP/1.", 7) == 0 && status[9] == '2';
+    }
+    close(fd);
+    return ok;
+}
+
+static void* senderThreadMain(void *arg) {
+    (void)arg;
+
+    pthread_setname_np(pthread_self(), "webhook");
+    pthread_mutex_lock(&queueLock);
+    for (;;) {
+        WebhookSlot *slot;
+
+        while (!stopping && queueHead == queueTail) {
+            pthread_cond_wait(&queueWake, &queueLock);
+        }
+        if (stopping) {
+            break;
+        }
+        slot = &queue[queueHead & (WEBHOOK_QUEUE - 1)];
+        pthread_mutex_unlock(&queueLock);
+
+        for (int i = 0; i < targetCount; i++) {
+            uint64_t start = monotonicNowNs();
+
+            if (deliver(&targets[i], slot)) {
+                __atomic_fetch_add(&targets[i].delivered, 1, __ATOMIC_RELAXED);
+            } else {
+                __atomic_fetch_add(&targets[i].failed, 1, __ATOMIC_RELAXED);
+            }
+            histogramRecord(&postLatency, monotonicNowNs() - start);
+        }
+
+        pthread_mutex_lock(&queueLock);
+        queueHead++;
+    }
+    pthread_mutex_unlock(&queueLock);
+    return NULL;
+}
+
+bool webhookStart(void) {
+    if (webhookActive || targetCount == 0) {
+        return true;
+    }
+    stopping = false;
+    if (pthread_create(&senderThread, NULL, senderThreadMain, NULL) != 0) {
+        return false;
+    }
+    __atomic_store_n(&webhookActive, true, __ATOMIC_RELEASE);
+    for (int i = 0; i < targetCount; i++) {
+        printf("Webhook: %s\n", targets[i].url);
+    }
+    return true;
+}
+
+void webhookStop(void) {
+    if (!webhookActive) {
+        return;
+    }
+    __atomic_store_n(&webhookActive, false, __ATOMIC_RELEASE);
+    pthread_mutex_lock(&queueLock);
+    stopping = true;
+    pthread_cond_signal(&queueWake);
+    pthread_mutex_unlock(&queueLock);
+    pthread_join(senderThread, NULL);
+}
+
+bool webhookPost(const char *body, size_t length) {
+    bool queued = false;
+
+    if (!__atomic_load_n(&webhookActive, __ATOMIC_ACQUIRE) || length > WEBHOOK_BODY_MAX) {
+        return false;
+    }
+    pthread_mutex_lock(&queueLock);
+    if (queueTail - queueHead < WEBHOOK_QUEUE) {
+        WebhookSlot *slot = &queue[queueTail & (WEBHOOK_QUEUE - 1)];
+
+        memcpy(slot->body, body, length);
+        slot->length = length;
+        queueTail++;
+        pthread_cond_signal(&queueWake);
+        queued = true;
+    }
+    pthread_mutex_unlock(&queueLock);
+    if (!queued) {
+        __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+    }
+    return queued;
+}
+
+void webhookCollectMetrics(StrBuf *out, void *ctx) {
+    uint64_t depth;
+    (void)ctx;
+
+    if (targetCount == 0) {
+        return;
+    }
+    metricsHeader(out, "watchdog_webhook_posts_total", "counter", "Webhook deliveries by target and result");
+    for (int i = 0; i < targetCount; i++) {
+        strbufAppendf(out, "watchdog_webhook_posts_total{target=\"%s\",result=\"ok\"} %llu\n", targets[i].url,
+                      (unsigned long long)__atomic_load_n(&targets[i].delivered, __ATOMIC_RELAXED));
+        strbufAppendf(out, "watchdog_webhook_posts_total{target=\"%s\",result=\"error\"} %llu\n", targets[i].url,
+                      (unsigned long long)__atomic_load_n(&targets[i].failed, __ATOMIC_RELAXED));
+    }
+    pthread_mutex_lock(&queueLock);
+    depth = queueTail - queueHead;
+    pthread_mutex_unlock(&queueLock);
+    metricsHeader(out, "watchdog_webhook_queue_depth", "gauge", "Bodies waiting for the webhook sender");
+    strbufAppendf(out, "watchdog_webhook_queue_depth %llu\n", (unsigned long long)depth);
+    metricsHeader(out, "watchdog_webhook_dropped_total", "counter", "Bodies not queued because the queue was full");
+    strbufAppendf(out, "watchdog_webhook_dropped_total %llu\n",
+                  (unsigned long long)__atomic_load_n(&dropped, __ATOMIC_RELAXED));
+    metricsHeader(out, "watchdog_webhook_post_seconds", "summary", "Time to connect, post and read the status line");
+    histogramWriteSummary(out, "watchdog_webhook_post_seconds", NULL, &postLatency);
+}
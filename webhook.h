@@ -0,0 +1,34 @@
+#ifndef WEBHOOK_H
+#define WEBHOOK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "strbuf.h"
+#include "build_profile.h"
+
+#define WEBHOOK_MAX_TARGETS 4
+#ifndef WEBHOOK_QUEUE
+#define WEBHOOK_QUEUE 256            // Pending bodies, must be a power of two
+#endif
+#define WEBHOOK_BODY_MAX 512
+#define WEBHOOK_TIMEOUT_MS 2000      // Connect, send and response each
+
+// Outbound JSON POSTs to plain http:// URLs. webhookPost() copies the body
+// into a preallocated queue and returns; one sender thread delivers every
+// body to every target, one short-lived connection each, so a slow or dead
+// receiver only delays other webhooks and never the caller.
+
+// Add a target before webhookStart(); false for a URL that is not
+// http://host[:port][/path] or when the table is full
+bool webhookAdd(const char *url);
+// Start the sender; does nothing and returns true without targets
+bool webhookStart(void);
+// Drop whatever is still queued and stop the sender
+void webhookStop(void);
+
+// Queue body for every target; false if it is too long or the queue is full
+bool webhookPost(const char *body, size_t length);
+
+void webhookCollectMetrics(StrBuf *out, void *ctx);
+
+#endif // WEBHOOK_H